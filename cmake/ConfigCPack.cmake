@@ -169,6 +169,15 @@ endif()
 if(OMNITRACE_USE_ROCPROFILER)
     list(APPEND _DEBIAN_PACKAGE_DEPENDS "rocprofiler-dev${_ROCPROFILER_SUFFIX}")
 endif()
+if(OMNITRACE_USE_ROCPROFILER_SDK)
+    list(APPEND _DEBIAN_PACKAGE_DEPENDS "rocprofiler-sdk")
+endif()
+if(OMNITRACE_USE_ZLIB)
+    list(APPEND _DEBIAN_PACKAGE_DEPENDS "zlib1g")
+endif()
+if(OMNITRACE_USE_ZSTD)
+    list(APPEND _DEBIAN_PACKAGE_DEPENDS "libzstd1")
+endif()
 if(OMNITRACE_USE_MPI)
     if("${OMNITRACE_MPI_IMPL}" STREQUAL "openmpi")
         list(APPEND _DEBIAN_PACKAGE_DEPENDS "libopenmpi-dev")
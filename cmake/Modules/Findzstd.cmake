@@ -0,0 +1,43 @@
+# Distributed under the OSI-approved BSD 3-Clause License.  See accompanying file
+# Copyright.txt or https://cmake.org/licensing for details.
+
+include(FindPackageHandleStandardArgs)
+
+# ----------------------------------------------------------------------------------------#
+
+find_path(
+    zstd_INCLUDE_DIR
+    NAMES zstd.h
+    HINTS ${zstd_ROOT_DIR}
+    PATHS ${zstd_ROOT_DIR}
+    PATH_SUFFIXES include)
+
+mark_as_advanced(zstd_INCLUDE_DIR)
+
+# ----------------------------------------------------------------------------------------#
+
+find_library(
+    zstd_LIBRARY
+    NAMES zstd
+    HINTS ${zstd_ROOT_DIR}
+    PATHS ${zstd_ROOT_DIR}
+    PATH_SUFFIXES lib lib64)
+
+mark_as_advanced(zstd_LIBRARY)
+
+# ----------------------------------------------------------------------------------------#
+
+find_package_handle_standard_args(zstd DEFAULT_MSG zstd_INCLUDE_DIR zstd_LIBRARY)
+
+# ------------------------------------------------------------------------------#
+
+if(zstd_FOUND AND NOT TARGET zstd::zstd)
+    add_library(zstd::zstd INTERFACE IMPORTED)
+    set(zstd_INCLUDE_DIRS ${zstd_INCLUDE_DIR})
+    set(zstd_LIBRARIES ${zstd_LIBRARY})
+
+    target_include_directories(zstd::zstd INTERFACE ${zstd_INCLUDE_DIR})
+    target_link_libraries(zstd::zstd INTERFACE ${zstd_LIBRARY})
+endif()
+
+# ------------------------------------------------------------------------------#
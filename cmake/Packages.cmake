@@ -18,6 +18,8 @@ omnitrace_add_interface_library(omnitrace-roctracer
                                 "Provides flags and libraries for roctracer")
 omnitrace_add_interface_library(omnitrace-rocprofiler
                                 "Provides flags and libraries for rocprofiler")
+omnitrace_add_interface_library(
+    omnitrace-rocprofiler-sdk "Provides flags and libraries for rocprofiler-sdk")
 omnitrace_add_interface_library(omnitrace-rocm-smi
                                 "Provides flags and libraries for rocm-smi")
 omnitrace_add_interface_library(
@@ -28,6 +30,10 @@ omnitrace_add_interface_library(omnitrace-ptl "Enables PTL support (tasking)")
 omnitrace_add_interface_library(omnitrace-papi "Enable PAPI support")
 omnitrace_add_interface_library(omnitrace-ompt "Enable OMPT support")
 omnitrace_add_interface_library(omnitrace-python "Enables Python support")
+omnitrace_add_interface_library(omnitrace-arrow
+                                "Provides Apache Arrow and Parquet (columnar output)")
+omnitrace_add_interface_library(omnitrace-compression
+                                "Provides zlib and zstd (compressed trace output)")
 omnitrace_add_interface_library(omnitrace-elfutils "Provides ElfUtils")
 omnitrace_add_interface_library(omnitrace-perfetto "Enables Perfetto support")
 omnitrace_add_interface_library(omnitrace-timemory "Provides timemory libraries")
@@ -40,6 +46,7 @@ set(OMNITRACE_EXTENSION_LIBRARIES
     omnitrace::omnitrace-hip
     omnitrace::omnitrace-roctracer
     omnitrace::omnitrace-rocprofiler
+    omnitrace::omnitrace-rocprofiler-sdk
     omnitrace::omnitrace-rocm-smi
     omnitrace::omnitrace-rccl
     omnitrace::omnitrace-bfd
@@ -47,6 +54,8 @@ set(OMNITRACE_EXTENSION_LIBRARIES
     omnitrace::omnitrace-ptl
     omnitrace::omnitrace-ompt
     omnitrace::omnitrace-papi
+    omnitrace::omnitrace-arrow
+    omnitrace::omnitrace-compression
     omnitrace::omnitrace-perfetto)
 
 target_include_directories(
@@ -208,6 +217,20 @@ if(OMNITRACE_USE_ROCPROFILER)
     target_link_libraries(omnitrace-rocprofiler INTERFACE rocprofiler::rocprofiler)
 endif()
 
+# ----------------------------------------------------------------------------------------#
+#
+# rocprofiler-sdk
+#
+# ----------------------------------------------------------------------------------------#
+if(OMNITRACE_USE_ROCPROFILER_SDK)
+    find_package(rocprofiler-sdk ${omnitrace_FIND_QUIETLY} REQUIRED HINTS ${ROCM_PATH}
+                 PATHS ${ROCM_PATH})
+    omnitrace_target_compile_definitions(omnitrace-rocprofiler-sdk
+                                         INTERFACE OMNITRACE_USE_ROCPROFILER_SDK)
+    target_link_libraries(omnitrace-rocprofiler-sdk
+                          INTERFACE rocprofiler-sdk::rocprofiler-sdk)
+endif()
+
 # ----------------------------------------------------------------------------------------#
 #
 # rocm-smi
@@ -233,6 +256,40 @@ if(OMNITRACE_USE_RCCL)
     omnitrace_target_compile_definitions(omnitrace-rccl INTERFACE OMNITRACE_USE_RCCL)
 endif()
 
+# ----------------------------------------------------------------------------------------#
+#
+# Apache Arrow / Parquet
+#
+# ----------------------------------------------------------------------------------------#
+
+if(OMNITRACE_USE_ARROW)
+    find_package(Arrow ${omnitrace_FIND_QUIETLY} REQUIRED)
+    find_package(Parquet ${omnitrace_FIND_QUIETLY} REQUIRED)
+    target_link_libraries(omnitrace-arrow INTERFACE Arrow::arrow_shared
+                                                    Parquet::parquet_shared)
+    omnitrace_target_compile_definitions(omnitrace-arrow INTERFACE OMNITRACE_USE_ARROW)
+endif()
+
+# ----------------------------------------------------------------------------------------#
+#
+# zlib / zstd
+#
+# ----------------------------------------------------------------------------------------#
+
+if(OMNITRACE_USE_ZLIB)
+    find_package(ZLIB ${omnitrace_FIND_QUIETLY} REQUIRED)
+    target_link_libraries(omnitrace-compression INTERFACE ZLIB::ZLIB)
+    omnitrace_target_compile_definitions(omnitrace-compression
+                                         INTERFACE OMNITRACE_USE_ZLIB)
+endif()
+
+if(OMNITRACE_USE_ZSTD)
+    find_package(zstd ${omnitrace_FIND_QUIETLY} REQUIRED)
+    target_link_libraries(omnitrace-compression INTERFACE zstd::zstd)
+    omnitrace_target_compile_definitions(omnitrace-compression
+                                         INTERFACE OMNITRACE_USE_ZSTD)
+endif()
+
 # ----------------------------------------------------------------------------------------#
 #
 # MPI
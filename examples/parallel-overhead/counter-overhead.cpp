@@ -0,0 +1,124 @@
+// Microbenchmark of the scaling of the counters which are incremented by every thread
+// for every instrumented region. The "shared" counter mirrors the previous push/pop
+// counts (a single atomic), the "packed" counter gives each thread its own slot in a
+// plain array so that the slots of neighboring threads share a cache line, and the
+// "padded" counter mirrors the current omnitrace::thread_counter (one cache-line
+// aligned slot per thread).
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+constexpr size_t max_threads    = 256;
+constexpr size_t cacheline_size = 64;
+
+struct shared_counter
+{
+    void increment(size_t) { value.fetch_add(1, std::memory_order_relaxed); }
+
+    std::atomic<uint64_t> value = { 0 };
+};
+
+struct packed_counter
+{
+    void increment(size_t _idx)
+    {
+        slots[_idx % max_threads].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, max_threads> slots = {};
+};
+
+struct padded_counter
+{
+    struct slot
+    {
+        alignas(cacheline_size) std::atomic<uint64_t> value = { 0 };
+    };
+
+    void increment(size_t _idx)
+    {
+        slots[_idx % max_threads].value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::array<slot, max_threads> slots = {};
+};
+
+template <typename CounterT>
+double
+run(CounterT& _counter, size_t _idx, size_t nitr) __attribute__((noinline));
+
+template <typename CounterT>
+double
+run(CounterT& _counter, size_t _idx, size_t nitr)
+{
+    auto _beg = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < nitr; ++i)
+        _counter.increment(_idx);
+    auto _end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(_end - _beg).count();
+}
+
+template <typename CounterT>
+double
+run_threads(size_t nthread, size_t nitr)
+{
+    auto* _counter = new CounterT{};
+    auto  _results = std::vector<double>(nthread, 0.0);
+    auto  _threads = std::vector<std::thread>{};
+    for(size_t i = 0; i < nthread; ++i)
+        _threads.emplace_back([i, nitr, _counter, &_results]() {
+            // warm-up
+            run(*_counter, i, nitr / 10);
+            _results.at(i) = run(*_counter, i, nitr);
+        });
+    for(auto& itr : _threads)
+        itr.join();
+    delete _counter;
+
+    double _sum = 0.0;
+    for(auto itr : _results)
+        _sum += itr;
+    // nanoseconds per increment
+    return _sum / static_cast<double>(nthread * nitr);
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t nthread = std::min<size_t>(16, std::thread::hardware_concurrency());
+    size_t nitr    = 10000000;
+
+    if(argc > 1) nthread = std::stoul(argv[1]);
+    if(argc > 2) nitr = std::stoul(argv[2]);
+
+    printf("\n[%s] Threads: %zu\n[%s] Iterations: %zu\n", argv[0], nthread, argv[0],
+           nitr);
+    printf("[%s] %8s %12s %12s %12s   (nsec per increment)\n", argv[0], "threads",
+           "shared", "packed", "padded");
+
+    auto _counts = std::vector<size_t>{};
+    for(size_t n = 1; n < nthread; n *= 2)
+        _counts.emplace_back(n);
+    _counts.emplace_back(nthread);
+
+    for(auto n : _counts)
+    {
+        auto _shared = run_threads<shared_counter>(n, nitr);
+        auto _packed = run_threads<packed_counter>(n, nitr);
+        auto _padded = run_threads<padded_counter>(n, nitr);
+        printf("[%s] %8zu %12.3f %12.3f %12.3f\n", argv[0], n, _shared, _packed,
+               _padded);
+    }
+
+    return EXIT_SUCCESS;
+}
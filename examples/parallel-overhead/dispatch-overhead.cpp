@@ -0,0 +1,172 @@
+// Microbenchmark of the cost of the omnitrace-dl push/pop dispatch of an instrumented
+// function call when the instrumentation is a no-op. The "branching" dispatch mirrors
+// the previous implementation of omnitrace_push_trace/omnitrace_pop_trace (check
+// whether omnitrace is active and the thread is enabled, then call through the
+// function pointer table) and the "table" dispatch mirrors the current implementation
+// (a single call through the per-thread dispatch table).
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using trace_func_t = void (*)(const char*);
+
+void
+noop_trace(const char*) __attribute__((noinline));
+
+void
+noop_trace(const char*)
+{
+    asm volatile("" ::: "memory");
+}
+
+// branching dispatch
+struct indirect
+{
+    trace_func_t push_trace = &noop_trace;
+    trace_func_t pop_trace  = &noop_trace;
+};
+
+indirect*          indirect_table = new indirect{};
+bool*              active         = new bool{ true };
+std::atomic<bool>* enabled        = new std::atomic<bool>{ true };
+
+bool&
+get_thread_enabled()
+{
+    static thread_local bool _v = *enabled;
+    return _v;
+}
+
+int64_t&
+get_thread_count()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
+void
+branching_push_trace(const char*) __attribute__((noinline));
+void
+branching_pop_trace(const char*) __attribute__((noinline));
+
+void
+branching_push_trace(const char* name)
+{
+    if(!*active) return;
+    if(get_thread_enabled())
+        indirect_table->push_trace(name);
+    else
+        ++get_thread_count();
+}
+
+void
+branching_pop_trace(const char* name)
+{
+    if(!*active) return;
+    if(get_thread_enabled())
+        indirect_table->pop_trace(name);
+    else
+        --get_thread_count();
+}
+
+// table dispatch
+struct trace_dispatch
+{
+    trace_func_t push_trace = nullptr;
+    trace_func_t pop_trace  = nullptr;
+};
+
+constexpr trace_dispatch enabled_dispatch = { &noop_trace, &noop_trace };
+
+auto&
+get_thread_dispatch()
+{
+    static thread_local std::atomic<const trace_dispatch*> _v{ &enabled_dispatch };
+    return _v;
+}
+
+void
+table_push_trace(const char*) __attribute__((noinline));
+void
+table_pop_trace(const char*) __attribute__((noinline));
+
+void
+table_push_trace(const char* name)
+{
+    get_thread_dispatch().load(std::memory_order_relaxed)->push_trace(name);
+}
+
+void
+table_pop_trace(const char* name)
+{
+    get_thread_dispatch().load(std::memory_order_relaxed)->pop_trace(name);
+}
+
+template <trace_func_t PushT, trace_func_t PopT>
+double
+run(size_t nitr)
+{
+    auto _beg = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < nitr; ++i)
+    {
+        PushT(__FUNCTION__);
+        PopT(__FUNCTION__);
+    }
+    auto _end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(_end - _beg).count();
+}
+
+template <trace_func_t PushT, trace_func_t PopT>
+double
+run_threads(size_t nthread, size_t nitr)
+{
+    auto _results = std::vector<double>(nthread, 0.0);
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 0; i < nthread; ++i)
+        _threads.emplace_back([i, nitr, &_results]() {
+            // warm-up
+            run<PushT, PopT>(nitr / 10);
+            _results.at(i) = run<PushT, PopT>(nitr);
+        });
+    for(auto& itr : _threads)
+        itr.join();
+
+    double _sum = 0.0;
+    for(auto itr : _results)
+        _sum += itr;
+    // nanoseconds per push + pop
+    return _sum / static_cast<double>(nthread * nitr);
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t nthread = std::min<size_t>(16, std::thread::hardware_concurrency());
+    size_t nitr    = 50000000;
+
+    if(argc > 1) nthread = std::stoul(argv[1]);
+    if(argc > 2) nitr = std::stoul(argv[2]);
+
+    printf("\n[%s] Threads: %zu\n[%s] Iterations: %zu\n", argv[0], nthread, argv[0],
+           nitr);
+
+    auto _branching =
+        run_threads<&branching_push_trace, &branching_pop_trace>(nthread, nitr);
+    auto _table = run_threads<&table_push_trace, &table_pop_trace>(nthread, nitr);
+
+    printf("[%s] branching dispatch : %8.3f nsec per push + pop\n", argv[0], _branching);
+    printf("[%s] table dispatch     : %8.3f nsec per push + pop\n", argv[0], _table);
+    printf("[%s] speed-up           : %8.3fx\n", argv[0],
+           (_table > 0.0) ? (_branching / _table) : 0.0);
+
+    return EXIT_SUCCESS;
+}
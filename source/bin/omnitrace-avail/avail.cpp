@@ -26,6 +26,7 @@
 #include "component_categories.hpp"
 #include "defines.hpp"
 #include "enumerated_list.hpp"
+#include "estimate_overhead.hpp"
 #include "generate_config.hpp"
 #include "get_availability.hpp"
 #include "info_type.hpp"
@@ -139,6 +140,7 @@ main(int argc, char** argv)
     tim::unwind::set_bfd_verbose(3);
     tim::set_env("OMNITRACE_INIT_TOOLING", "OFF", 1);
     omnitrace_init_library();
+    omnitrace::config::configure_setting_choices();
 
     std::set<std::string> _category_options = component_categories{}();
     {
@@ -489,6 +491,24 @@ main(int argc, char** argv)
         .max_count(1)
         .action([](parser_t& p) { force_config = p.get<bool>("force"); });
 
+    parser.start_group("OVERHEAD");
+
+    parser
+        .add_argument({ "--estimate-overhead" },
+                      "Run microbenchmarks of the sampling, hardware counter, "
+                      "timemory, perfetto, and rocm-smi costs on this host and predict "
+                      "the overhead of each enabled feature at the rates of the "
+                      "configuration (the environment or the given configuration file)")
+        .max_count(1)
+        .dtype("filename");
+    parser
+        .add_argument({ "--estimate-call-rate" },
+                      "Number of instrumented function calls per second per thread used "
+                      "to predict the overhead of the timemory and perfetto regions")
+        .count(1)
+        .dtype("double")
+        .set_default(1.0e4);
+
     parser.end_group();
 
     parser.add_positional_argument("REGEX_FILTER").set_default(std::string{});
@@ -562,6 +582,28 @@ main(int argc, char** argv)
         return EXIT_SUCCESS;
     }
 
+    if(parser.exists("estimate-overhead"))
+    {
+        auto _config    = std::string{};
+        auto _call_rate = 1.0e4;
+        if(parser.get_count("estimate-overhead") > 0)
+            _config = parser.get<std::string>("estimate-overhead");
+        _parser_set_if_exists(_call_rate, "estimate-call-rate");
+
+        std::ofstream _ofs{};
+        if(!file.empty()) _ofs.open(file.c_str());
+        try
+        {
+            estimate_overhead((_ofs) ? static_cast<std::ostream&>(_ofs) : std::cout,
+                              _config, _call_rate);
+        } catch(std::runtime_error& _e)
+        {
+            std::cerr << "[omnitrace-avail] " << _e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
     if(parser.exists("markdown") && parser.exists("csv"))
     {
         std::cerr << "Error! both '--markdown' and '--csv' options cannot be specified\n";
@@ -0,0 +1,447 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "estimate_overhead.hpp"
+#include "common.hpp"
+#include "common/defines.h"
+#include "defines.hpp"
+
+#include "core/config.hpp"
+#include "core/gpu.hpp"
+#include "core/perfetto.hpp"
+#include "library/perf.hpp"
+
+#include <timemory/components/timing/wall_clock.hpp>
+#include <timemory/settings.hpp>
+#include <timemory/units.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/variadic/auto_tuple.hpp>
+
+#if OMNITRACE_USE_ROCM_SMI > 0
+#    include <rocm_smi/rocm_smi.h>
+#endif
+
+#include <libunwind.h>
+#include <linux/perf_event.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace config = ::omnitrace::config;
+namespace units  = ::tim::units;
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+constexpr size_t num_repeats = 5;
+constexpr size_t max_depth   = OMNITRACE_MAX_UNWIND_DEPTH;
+constexpr auto   depths      = std::array<size_t, 5>{ 8, 16, 32, 64, 128 };
+// call-stack depth of the timer samples when OMNITRACE_SAMPLING_MAX_DEPTH is zero
+constexpr size_t default_depth = 32;
+
+// the median of the cost per call in nanoseconds
+template <typename FuncT>
+double
+measure(size_t _n, FuncT&& _func)
+{
+    auto _v = std::array<double, num_repeats>{};
+    for(auto& itr : _v)
+    {
+        auto _beg = clock_type::now();
+        for(size_t i = 0; i < _n; ++i)
+            _func();
+        auto _end = clock_type::now();
+        itr = std::chrono::duration<double, std::nano>(_end - _beg).count() / _n;
+    }
+    std::nth_element(_v.begin(), _v.begin() + num_repeats / 2, _v.end());
+    return _v.at(num_repeats / 2);
+}
+
+bool            use_libunwind  = false;
+volatile size_t unwound_frames = 0;
+
+// unwinds the interrupted call-stack like the handler of the timer samples. The
+// frame-pointer unwinder is estimated with the cached unwinder
+void
+sample_handler(int)
+{
+    size_t _n = 0;
+    if(use_libunwind)
+    {
+        for(auto itr : tim::get_unw_stack<max_depth, 0, false>())
+        {
+            if(itr) ++_n;
+        }
+    }
+    else
+    {
+        auto _buffer = std::array<void*, max_depth>{};
+        _n           = unw_backtrace(_buffer.data(), max_depth);
+    }
+    unwound_frames = _n;
+}
+
+// the signals are raised at the given depth of the call-stack
+__attribute__((noinline)) double
+sample_at_depth(size_t _depth, int _sig, size_t _n)
+{
+    if(_depth > 0)
+    {
+        auto _v = sample_at_depth(_depth - 1, _sig, _n);
+        // prevents the tail call
+        asm volatile("" ::: "memory");
+        return _v;
+    }
+    return measure(_n, [_sig]() { raise(_sig); });
+}
+
+struct benchmarks
+{
+    using sample_costs_t = std::vector<std::pair<size_t, double>>;
+
+    double                sample_base      = 0.0;
+    double                sample_per_frame = 0.0;
+    sample_costs_t        sample_costs     = {};
+    std::optional<double> counter_read     = {};
+    std::string           counter_error    = {};
+    double                timemory         = 0.0;
+    double                perfetto         = 0.0;
+    std::optional<double> rocm_smi         = {};
+    size_t                gpus             = 0;
+
+    double sample(size_t _depth) const
+    {
+        return sample_base + sample_per_frame * static_cast<double>(_depth);
+    }
+};
+
+// least squares fit of the cost of the timer samples vs. the depth of the call-stack
+void
+measure_samples(benchmarks& _v)
+{
+    int              _sig = SIGRTMAX;
+    struct sigaction _act = {};
+    struct sigaction _old = {};
+    _act.sa_handler       = &sample_handler;
+    _act.sa_flags         = SA_RESTART;
+    sigemptyset(&_act.sa_mask);
+    sigaction(_sig, &_act, &_old);
+
+    for(auto itr : depths)
+    {
+        if(itr > max_depth) continue;
+        _v.sample_costs.emplace_back(itr, sample_at_depth(itr, _sig, 1000));
+    }
+
+    sigaction(_sig, &_old, nullptr);
+
+    auto _n   = static_cast<double>(_v.sample_costs.size());
+    auto _sx  = 0.0;
+    auto _sy  = 0.0;
+    auto _sxx = 0.0;
+    auto _sxy = 0.0;
+    for(const auto& itr : _v.sample_costs)
+    {
+        auto _x = static_cast<double>(itr.first);
+        _sx += _x;
+        _sy += itr.second;
+        _sxx += _x * _x;
+        _sxy += _x * itr.second;
+    }
+    auto _den           = (_n * _sxx) - (_sx * _sx);
+    _v.sample_per_frame = (_den > 0.0) ? (((_n * _sxy) - (_sx * _sy)) / _den) : 0.0;
+    _v.sample_per_frame = std::max(_v.sample_per_frame, 0.0);
+    _v.sample_base      = std::max((_sy - _v.sample_per_frame * _sx) / _n, 0.0);
+}
+
+// PAPI reads the counters of the event set with a single read of the perf event group
+// so the read of one hardware counter approximates the cost per sample
+void
+measure_counter_read(benchmarks& _v)
+{
+    auto _pe           = perf_event_attr{};
+    _pe.type           = PERF_TYPE_HARDWARE;
+    _pe.config         = PERF_COUNT_HW_INSTRUCTIONS;
+    _pe.exclude_kernel = 1;
+    _pe.exclude_hv     = 1;
+
+    auto _event = omnitrace::perf::perf_event{};
+    if(auto _err = _event.open(_pe); _err)
+    {
+        _v.counter_error = *_err;
+        return;
+    }
+
+    volatile uint64_t _count = 0;
+    _event.start();
+    _v.counter_read =
+        measure(10000, [&_event, &_count]() { _count = _event.get_count(); });
+    _event.stop();
+    _event.close();
+}
+
+// a region with the wall-clock in the call-graph storage of timemory. The results are
+// never written
+void
+measure_timemory(benchmarks& _v)
+{
+    auto _enabled     = tim::settings::enabled();
+    auto _file_output = tim::settings::file_output();
+    auto _cout_output = tim::settings::cout_output();
+
+    tim::settings::enabled()     = true;
+    tim::settings::file_output() = false;
+    tim::settings::cout_output() = false;
+
+    _v.timemory = measure(10000, []() {
+        tim::auto_tuple<comp::wall_clock> _region{ "omnitrace-avail-estimate" };
+    });
+
+    tim::settings::enabled()     = _enabled;
+    tim::settings::file_output() = _file_output;
+    tim::settings::cout_output() = _cout_output;
+}
+
+// a begin and end event in an in-process session with a ring buffer
+void
+measure_perfetto(benchmarks& _v)
+{
+    if(!::perfetto::Tracing::IsInitialized())
+    {
+        auto _args = ::perfetto::TracingInitArgs{};
+        _args.backends |= ::perfetto::kInProcessBackend;
+        ::perfetto::Tracing::Initialize(_args);
+        ::perfetto::TrackEvent::Register();
+    }
+
+    auto  _cfg    = ::perfetto::TraceConfig{};
+    auto* _buffer = _cfg.add_buffers();
+    _buffer->set_size_kb(16 * 1024);
+    _buffer->set_fill_policy(
+        ::perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_RING_BUFFER);
+    _cfg.add_data_sources()->mutable_config()->set_name("track_event");
+
+    auto _session = ::perfetto::Tracing::NewTrace(::perfetto::kInProcessBackend);
+    _session->Setup(_cfg);
+    _session->StartBlocking();
+
+    _v.perfetto = measure(100000, []() {
+        TRACE_EVENT_BEGIN("host", "omnitrace-avail-estimate");
+        TRACE_EVENT_END("host");
+    });
+
+    _session->StopBlocking();
+}
+
+// the queries of one device by the process sampler
+void
+measure_rocm_smi(benchmarks& _v)
+{
+    _v.gpus = omnitrace::gpu::rsmi_device_count();
+#if OMNITRACE_USE_ROCM_SMI > 0
+    if(_v.gpus == 0) return;
+
+    _v.rocm_smi = measure(100, []() {
+        uint32_t _busy  = 0;
+        int64_t  _temp  = 0;
+        uint64_t _power = 0;
+        uint64_t _mem   = 0;
+        rsmi_dev_busy_percent_get(0, &_busy);
+        rsmi_dev_temp_metric_get(0, RSMI_TEMP_TYPE_EDGE, RSMI_TEMP_CURRENT, &_temp);
+        rsmi_dev_power_ave_get(0, 0, &_power);
+        rsmi_dev_memory_usage_get(0, RSMI_MEM_TYPE_VRAM, &_mem);
+    });
+#endif
+}
+
+struct estimate
+{
+    std::string feature    = {};
+    std::string setting    = {};
+    double      cost       = 0.0;  // nsec per event
+    double      rate       = 0.0;  // events per second
+    bool        background = false;
+
+    // percent of the time of each thread, or of one core for the background threads
+    double overhead() const { return 100.0 * cost * rate / units::sec; }
+};
+
+bool
+get_bool(const char* _name)
+{
+    return config::get_setting_value<bool>(_name).value_or(false);
+}
+}  // namespace
+
+void
+estimate_overhead(std::ostream& _os, const std::string& _config_file, double _call_rate)
+{
+    if(!_config_file.empty() && !settings::shared_instance()->read(_config_file))
+        throw std::runtime_error(TIMEMORY_JOIN(
+            "", "Error! Failed to read the configuration file '", _config_file, "'"));
+
+    auto _depth = config::get_sampling_max_depth();
+    if(_depth == 0) _depth = default_depth;
+    _depth = std::min(_depth, max_depth);
+
+    auto _unwinder = config::get_sampling_unwinder();
+    use_libunwind  = (_unwinder == "libunwind");
+
+    verbprintf(1, "Measuring the cost of the timer samples...\n");
+    auto _bench = benchmarks{};
+    measure_samples(_bench);
+    verbprintf(1, "Measuring the cost of the hardware counter reads...\n");
+    measure_counter_read(_bench);
+    verbprintf(1, "Measuring the cost of the timemory regions...\n");
+    measure_timemory(_bench);
+    verbprintf(1, "Measuring the cost of the perfetto events...\n");
+    measure_perfetto(_bench);
+    verbprintf(1, "Measuring the latency of rocm-smi...\n");
+    measure_rocm_smi(_bench);
+
+    auto _usec = [](double _v) { return _v / units::usec; };
+
+    _os << std::fixed << std::setprecision(3);
+    _os << "\nMicrobenchmarks (" << _unwinder << " unwinder):\n";
+    for(const auto& itr : _bench.sample_costs)
+    {
+        _os << "    " << std::setw(36) << std::left
+            << TIMEMORY_JOIN("", "timer sample at depth ", itr.first) << std::right
+            << std::setw(12) << _usec(itr.second) << " usec\n";
+    }
+    _os << "    " << std::setw(36) << std::left << "timer sample per frame (fit)"
+        << std::right << std::setw(12) << _usec(_bench.sample_per_frame) << " usec\n";
+    _os << "    " << std::setw(36) << std::left << "hardware counter read" << std::right;
+    if(_bench.counter_read)
+        _os << std::setw(12) << _usec(*_bench.counter_read) << " usec\n";
+    else
+        _os << "  unavailable: " << _bench.counter_error << "\n";
+    _os << "    " << std::setw(36) << std::left << "timemory region (wall-clock)"
+        << std::right << std::setw(12) << _usec(_bench.timemory) << " usec\n";
+    _os << "    " << std::setw(36) << std::left << "perfetto region" << std::right
+        << std::setw(12) << _usec(_bench.perfetto) << " usec\n";
+    _os << "    " << std::setw(36) << std::left << "rocm-smi sample per device"
+        << std::right;
+    if(_bench.rocm_smi)
+        _os << std::setw(12) << _usec(*_bench.rocm_smi) << " usec\n";
+    else
+        _os << "  unavailable: no devices\n";
+
+    // the predictions at the rates of the configuration
+    auto _estimates = std::vector<estimate>{};
+    bool _sampling  = config::get_use_sampling();
+    bool _cputime   = _sampling && get_bool("OMNITRACE_SAMPLING_CPUTIME");
+    bool _realtime  = _sampling && get_bool("OMNITRACE_SAMPLING_REALTIME");
+    bool _overflow  = _sampling && get_bool("OMNITRACE_SAMPLING_OVERFLOW");
+    if(_sampling && !_cputime && !_realtime && !_overflow) _cputime = true;
+
+    auto _sample_rate = 0.0;
+    if(_cputime)
+    {
+        _estimates.emplace_back(estimate{ "timer samples (cputime)",
+                                          "OMNITRACE_SAMPLING_CPUTIME_FREQ",
+                                          _bench.sample(_depth),
+                                          config::get_sampling_cputime_freq(), false });
+        _sample_rate += _estimates.back().rate;
+    }
+    if(_realtime)
+    {
+        _estimates.emplace_back(estimate{ "timer samples (realtime)",
+                                          "OMNITRACE_SAMPLING_REALTIME_FREQ",
+                                          _bench.sample(_depth),
+                                          config::get_sampling_realtime_freq(), false });
+        _sample_rate += _estimates.back().rate;
+    }
+
+    auto _events = tim::delimit(
+        config::get_setting_value<std::string>("OMNITRACE_PAPI_EVENTS").value_or(""),
+        " ,;\t");
+    if(!_events.empty() && _sample_rate > 0.0 && _bench.counter_read)
+    {
+        _estimates.emplace_back(estimate{ "hardware counters per sample",
+                                          "OMNITRACE_PAPI_EVENTS", *_bench.counter_read,
+                                          _sample_rate, false });
+    }
+
+    if(config::get_use_timemory())
+    {
+        _estimates.emplace_back(estimate{ "timemory regions", "OMNITRACE_PROFILE",
+                                          _bench.timemory, _call_rate, false });
+    }
+
+    if(config::get_use_perfetto())
+    {
+        _estimates.emplace_back(estimate{ "perfetto regions", "OMNITRACE_TRACE",
+                                          _bench.perfetto, _call_rate, false });
+    }
+
+    if(config::get_use_process_sampling() && config::get_use_rocm_smi() &&
+       _bench.rocm_smi)
+    {
+        _estimates.emplace_back(estimate{
+            "rocm-smi polling", "OMNITRACE_PROCESS_SAMPLING_FREQ",
+            *_bench.rocm_smi * _bench.gpus, config::get_process_sampling_freq(), true });
+    }
+
+    std::sort(_estimates.begin(), _estimates.end(),
+              [](const estimate& _lhs, const estimate& _rhs) {
+                  return _lhs.overhead() > _rhs.overhead();
+              });
+
+    _os << "\nPredicted overhead (call-stack depth " << _depth << ", " << _call_rate
+        << " instrumented calls per second per thread):\n";
+    _os << "    " << std::setw(30) << std::left << "FEATURE" << std::setw(34)
+        << "SETTING" << std::right << std::setw(12) << "COST [usec]" << std::setw(12)
+        << "RATE [Hz]" << std::setw(14) << "OVERHEAD [%]" << "\n";
+    for(const auto& itr : _estimates)
+    {
+        _os << "    " << std::setw(30) << std::left << itr.feature << std::setw(34)
+            << itr.setting << std::right << std::setw(12) << _usec(itr.cost)
+            << std::setw(12) << itr.rate << std::setw(14) << itr.overhead()
+            << ((itr.background) ? "  (of one core)" : "") << "\n";
+    }
+
+    if(_estimates.empty())
+        _os << "    no feature with a predictable overhead is enabled\n";
+    else
+        _os << "\nThe overhead is dominated by the " << _estimates.front().feature
+            << " (" << _estimates.front().setting << ")\n";
+
+    if(_overflow)
+        _os << "The rate of the overflow samples depends on "
+               "OMNITRACE_SAMPLING_OVERFLOW_EVENT and is not estimated\n";
+    if(!_events.empty() && !_bench.counter_read)
+        _os << "The hardware counters could not be read and are not estimated\n";
+    _os << std::flush;
+}
@@ -82,6 +82,7 @@ auto updated_envs  = std::set<std::string_view>{};
 auto original_envs = std::set<std::string>{};
 auto child_pids    = std::set<pid_t>{};
 auto launcher      = std::string{};
+auto num_jobs      = size_t{ 1 };
 
 inline signal_handler&
 get_signal_handler(int _sig)
@@ -249,6 +250,71 @@ prepare_environment_for_run(std::vector<char*>& _env)
     }
 }
 
+size_t
+get_num_jobs()
+{
+    return num_jobs;
+}
+
+std::vector<cpu_set_t>
+get_cpu_partitions(size_t _n)
+{
+    // the CPUs available to omnitrace-causal, e.g. restricted by taskset or the
+    // workload manager
+    auto _cpus  = std::vector<int>{};
+    auto _avail = cpu_set_t{};
+    CPU_ZERO(&_avail);
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &_avail) == 0)
+    {
+        for(int i = 0; i < CPU_SETSIZE; ++i)
+            if(CPU_ISSET(i, &_avail)) _cpus.emplace_back(i);
+    }
+
+    if(_cpus.empty())
+    {
+        for(unsigned i = 0; i < std::max(std::thread::hardware_concurrency(), 1U); ++i)
+            _cpus.emplace_back(i);
+    }
+
+    if(_n > _cpus.size())
+    {
+        TIMEMORY_PRINTF_WARNING(stderr,
+                                "Number of concurrent runs (%zu) exceeds the number of "
+                                "available CPUs (%zu). Executing %zu runs concurrently\n",
+                                _n, _cpus.size(), _cpus.size());
+        _n = _cpus.size();
+    }
+
+    if(get_env<bool>("OMNITRACE_CPU_AFFINITY", false, false))
+    {
+        TIMEMORY_PRINTF_WARNING(stderr,
+                                "OMNITRACE_CPU_AFFINITY pins threads to CPUs outside of "
+                                "the CPU partition of each concurrent run and will be "
+                                "disabled\n");
+    }
+
+    // contiguous blocks of CPUs so that a run does not span more sockets than necessary
+    auto _v = std::vector<cpu_set_t>(_n);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        CPU_ZERO(&_v.at(i));
+        auto _beg = (i * _cpus.size()) / _n;
+        auto _end = ((i + 1) * _cpus.size()) / _n;
+        for(auto j = _beg; j < _end; ++j)
+            CPU_SET(_cpus.at(j), &_v.at(i));
+    }
+
+    return _v;
+}
+
+void
+prepare_environment_for_job(std::vector<char*>& _env, const cpu_set_t& _cpus)
+{
+    add_default_env(_env, "OMP_NUM_THREADS", CPU_COUNT(&_cpus));
+    if(get_env<bool>("OMNITRACE_CPU_AFFINITY", false, false))
+        update_env(_env, "OMNITRACE_CPU_AFFINITY", false);
+}
+
 std::string
 get_internal_libpath(const std::string& _lib)
 {
@@ -429,6 +495,9 @@ parse_args(int argc, char** argv, std::vector<char*>& _env,
                                                         #   1. func_A
                                                         #   2. func_B
                                                         #   3. func_A or func_B
+
+        omnitrace-causal -j 4 -n 16 -- <exe>            # runs <exe> 16x, 4 runs at a time on 1/4 of the CPUs each
+
     General tips:
     - Insert progress points at hotspots in your code or use omnitrace's runtime instrumentation
         - Note: binary rewrite will produce a incompatible new binary
@@ -624,6 +693,18 @@ parse_args(int argc, char** argv, std::vector<char*>& _env,
         .dtype("int")
         .action([&](parser_t& p) { _niterations = p.get<int64_t>("iterations"); });
 
+    parser
+        .add_argument({ "-j", "--jobs" },
+                      "Number of runs to execute concurrently. The CPUs available to "
+                      "omnitrace-causal are partitioned evenly between the concurrent "
+                      "runs and the results of all the runs are appended to the same "
+                      "output files")
+        .count(1)
+        .dtype("int")
+        .action([&](parser_t& p) {
+            num_jobs = std::max<int64_t>(p.get<int64_t>("jobs"), 1);
+        });
+
     parser.start_group(
         "CAUSAL PROFILING OPTIONS (Combinatorial)",
         "Each individual argument to these options will multiply the number runs by the "
@@ -25,13 +25,19 @@
 #include <timemory/log/macros.hpp>
 
 #include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <sched.h>
+#include <set>
 #include <sstream>
 #include <string_view>
+#include <sys/wait.h>
 #include <unistd.h>
+#include <vector>
 
 int
 main(int argc, char** argv)
@@ -93,44 +99,106 @@ main(int argc, char** argv)
         }
 
         forward_signals({ SIGINT, SIGTERM, SIGQUIT });
-        size_t _ncount = 0;
-        size_t _width  = std::log10(_causal_env.size()) + 1;
-        for(auto& citr : _causal_env)
+
+        auto _njobs    = std::min<size_t>(get_num_jobs(), _causal_env.size());
+        auto _cpusets  = std::vector<cpu_set_t>{};
+        auto _running  = std::map<pid_t, size_t>{};  // pid -> cpu partition
+        auto _free     = std::set<size_t>{};         // unused cpu partitions
+        auto _main_pid = getpid();
+        auto _width    = static_cast<size_t>(std::log10(_causal_env.size()) + 1);
+        auto _next     = size_t{ 0 };
+        auto _ret      = 0;
+
+        // the run which resets the existing results must finish before the other
+        // runs append their results
+        auto _exclusive = pid_t{ -1 };
+
+        if(_njobs > 1)
         {
-            auto _n        = _ncount++;
-            auto _main_pid = getpid();
-            auto _pid      = fork();
+            _cpusets = get_cpu_partitions(_njobs);
+            _njobs   = _cpusets.size();
+            for(size_t i = 0; i < _cpusets.size(); ++i)
+                _free.emplace(i);
+        }
 
-            if(get_verbose() >= 3)
+        while((_ret == 0 && _next < _causal_env.size()) || !_running.empty())
+        {
+            while(_ret == 0 && _exclusive < 0 && _next < _causal_env.size() &&
+                  _running.size() < _njobs)
             {
-                TIMEMORY_PRINTF_INFO(stderr, "process %i returned %i from fork...\n",
-                                     getpid(), _pid);
-            }
+                auto  _n    = _next++;
+                auto& citr  = _causal_env.at(_n);
+                auto  _slot = (_free.empty()) ? size_t{ 0 } : *_free.begin();
+                auto  _pid  = fork();
 
-            if(_pid == 0)
-            {
-                auto _prefix = std::stringstream{};
-                _prefix << std::setw(_width) << std::right << _n << "/"
-                        << std::setw(_width) << std::left << _causal_env.size() << ": ["
-                        << _main_pid << " -> " << getpid() << "] ";
-
-                auto _env = _base_env;
-                for(const auto& eitr : citr)
-                    update_env(_env, eitr.first, eitr.second);
-                print_updated_environment(_env, _prefix.str());
-                print_command(_argv, _prefix.str());
-                _argv.emplace_back(nullptr);
-                _env.emplace_back(nullptr);
-                return execvpe(_argv.front(), _argv.data(), _env.data());
+                if(get_verbose() >= 3)
+                {
+                    TIMEMORY_PRINTF_INFO(stderr, "process %i returned %i from fork...\n",
+                                         getpid(), _pid);
+                }
+
+                if(_pid == 0)
+                {
+                    auto _prefix = std::stringstream{};
+                    _prefix << std::setw(_width) << std::right << _n << "/"
+                            << std::setw(_width) << std::left << _causal_env.size()
+                            << ": [" << _main_pid << " -> " << getpid() << "] ";
+
+                    auto _env = _base_env;
+                    for(const auto& eitr : citr)
+                        update_env(_env, eitr.first, eitr.second);
+                    if(!_cpusets.empty())
+                    {
+                        const auto& _cpus = _cpusets.at(_slot);
+                        prepare_environment_for_job(_env, _cpus);
+                        if(sched_setaffinity(0, sizeof(cpu_set_t), &_cpus) != 0)
+                            TIMEMORY_PRINTF_WARNING(stderr,
+                                                    "%sfailed to set the CPU affinity\n",
+                                                    _prefix.str().c_str());
+                    }
+                    print_updated_environment(_env, _prefix.str());
+                    print_command(_argv, _prefix.str());
+                    _argv.emplace_back(nullptr);
+                    _env.emplace_back(nullptr);
+                    return execvpe(_argv.front(), _argv.data(), _env.data());
+                }
+                else if(_pid < 0)
+                {
+                    TIMEMORY_PRINTF_FATAL(stderr, "fork failed: %s\n", strerror(errno));
+                    _ret = EXIT_FAILURE;
+                }
+                else
+                {
+                    add_child_pid(_pid);
+                    _running.emplace(_pid, _slot);
+                    _free.erase(_slot);
+                    if(citr.count("OMNITRACE_CAUSAL_FILE_RESET") > 0 && _njobs > 1)
+                        _exclusive = _pid;
+                }
             }
-            else
+
+            if(_running.empty()) break;
+
+            // wait for any of the runs to finish
+            int   _status = 0;
+            pid_t _pid    = waitpid(-1, &_status, 0);
+            if(_pid < 0)
             {
-                add_child_pid(_pid);
-                auto _status = wait_pid(_pid);
-                auto _ret    = diagnose_status(_pid, _status);
-                remove_child_pid(_pid);
-                if(_ret != 0) return _ret;
+                if(errno == EINTR) continue;
+                break;
             }
+
+            auto ritr = _running.find(_pid);
+            if(ritr == _running.end()) continue;
+
+            auto _retv = diagnose_status(_pid, _status);
+            if(_ret == 0) _ret = _retv;
+            if(_pid == _exclusive) _exclusive = -1;
+            _free.emplace(ritr->second);
+            _running.erase(ritr);
+            remove_child_pid(_pid);
         }
+
+        return _ret;
     }
 }
@@ -52,6 +52,17 @@ prepare_command_for_run(char*, std::vector<char*>&);
 void
 prepare_environment_for_run(std::vector<char*>&);
 
+// number of runs to execute concurrently
+size_t
+get_num_jobs();
+
+// partitions the CPUs available to the process between the concurrent runs
+std::vector<cpu_set_t>
+get_cpu_partitions(size_t);
+
+void
+prepare_environment_for_job(std::vector<char*>&, const cpu_set_t&);
+
 std::string
 get_internal_libpath(const std::string& _lib);
 
@@ -0,0 +1,392 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-ctl.hpp"
+#include "common/defines.h"
+
+#include <timemory/environment.hpp>
+#include <timemory/log/color.hpp>
+#include <timemory/log/macros.hpp>
+#include <timemory/utility/argparse.hpp>
+#include <timemory/utility/console.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace color    = ::tim::log::color;
+namespace console  = ::tim::utility::console;
+namespace argparse = ::tim::argparse;
+using ::tim::get_env;
+using ::tim::log::monochrome;
+using ::tim::log::stream;
+
+namespace
+{
+int verbose = 0;
+
+std::string
+get_basename(std::string _v)
+{
+    auto _pos = _v.find_last_of('/');
+    if(_pos != std::string::npos) _v = _v.substr(_pos + 1);
+    return _v;
+}
+
+const char*
+get_category_state_name(uint8_t _v)
+{
+    switch(_v)
+    {
+        case control_block::category_on: return "on";
+        case control_block::category_off: return "off";
+        default: break;
+    }
+    return "default";
+}
+
+const char*
+get_function_mode_name(uint8_t _v)
+{
+    switch(_v)
+    {
+        case control_block::function_include: return "include";
+        case control_block::function_exclude: return "exclude";
+        default: break;
+    }
+    return "all";
+}
+
+// indexes of the categories with the name, "all" matches every category
+std::vector<size_t>
+find_categories(const control_block* _block, const std::string& _name)
+{
+    auto _v = std::vector<size_t>{};
+    for(size_t i = 1; i < _block->num_categories; ++i)
+    {
+        if(_name == "all" || _name == _block->names[i]) _v.emplace_back(i);
+    }
+
+    if(_v.empty())
+        throw std::runtime_error("unknown category '" + _name +
+                                 "'. Use --list for the categories of the process");
+    return _v;
+}
+
+bool
+set_categories(control_block* _block, const std::vector<std::string>& _names,
+               uint8_t _state)
+{
+    auto _changed = false;
+    for(const auto& itr : _names)
+    {
+        for(auto idx : find_categories(_block, itr))
+        {
+            if(_block->categories[idx].exchange(_state) == _state) continue;
+            _changed = true;
+            if(verbose >= 1)
+                fprintf(stderr, "[omnitrace-ctl] category %s :: %s\n",
+                        _block->names[idx], get_category_state_name(_state));
+        }
+    }
+    return _changed;
+}
+
+void
+clear_functions(control_block* _block)
+{
+    // the filter is removed before the bits are cleared so that the process never
+    // filters with a partially cleared set
+    _block->mode.store(control_block::function_all);
+    for(auto& itr : _block->functions)
+        itr.store(0);
+}
+
+void
+set_functions(control_block* _block, const std::vector<std::string>& _names,
+              uint8_t _mode)
+{
+    // switching between --include and --exclude starts from an empty set, otherwise
+    // the functions are added to the current set
+    if(_block->mode.load() != _mode) clear_functions(_block);
+
+    for(const auto& itr : _names)
+    {
+        auto _bit = omnitrace::get_control_function_bit(itr);
+        _block->functions[_bit / 64].fetch_or(uint64_t{ 1 } << (_bit % 64));
+        if(verbose >= 1)
+            fprintf(stderr, "[omnitrace-ctl] function %s :: %s\n", itr.c_str(),
+                    get_function_mode_name(_mode));
+    }
+
+    // the mode is set after the bits so that the process does not briefly skip the
+    // functions which are being included
+    _block->mode.store(_mode);
+}
+}  // namespace
+
+int
+get_verbose()
+{
+    verbose = get_env("OMNITRACE_CTL_VERBOSE",
+                      get_env<int>("OMNITRACE_VERBOSE", verbose, false));
+    return verbose;
+}
+
+control_block*
+open_control(const ctl_options& _opts)
+{
+    auto _fname = _opts.filename;
+    if(_fname.empty())
+    {
+        auto _tmpdir = get_env<std::string>(
+            "OMNITRACE_TMPDIR", get_env<std::string>("TMPDIR", "/tmp", false), false);
+        _fname = omnitrace::get_control_filename(_tmpdir, _opts.pid);
+    }
+
+    auto _fd = ::open(_fname.c_str(), O_RDWR);
+    if(_fd < 0)
+        throw std::runtime_error("unable to open '" + _fname + "': " + strerror(errno) +
+                                 ". Was the process run with OMNITRACE_CONTROL_FILE=ON?");
+
+    struct stat _stat  = {};
+    void*       _addr  = MAP_FAILED;
+    auto        _bytes = sizeof(control_block);
+    if(::fstat(_fd, &_stat) == 0 && static_cast<size_t>(_stat.st_size) >= _bytes)
+        _addr = ::mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+
+    // the mapping remains valid after the file descriptor is closed
+    ::close(_fd);
+
+    if(_addr == MAP_FAILED) throw std::runtime_error("unable to map '" + _fname + "'");
+
+    auto* _block = static_cast<control_block*>(_addr);
+    if(_block->header != control_block::magic ||
+       _block->header_version != control_block::version ||
+       _block->num_categories > control_block::max_categories)
+        throw std::runtime_error("'" + _fname +
+                                 "' is not a control file of this version of omnitrace");
+
+    // the process removes the file during finalization so the file is stale when the
+    // process was killed
+    if(::kill(static_cast<pid_t>(_block->pid), 0) != 0 && errno == ESRCH)
+        throw std::runtime_error("process " + std::to_string(_block->pid) + " of '" +
+                                 _fname + "' is no longer running");
+
+    return _block;
+}
+
+void
+apply(control_block* _block, const ctl_options& _opts)
+{
+    if(!_opts.include.empty() && !_opts.exclude.empty())
+        throw std::runtime_error("--include and --exclude are mutually exclusive");
+
+    auto _changed = false;
+    _changed |= set_categories(_block, _opts.reset, control_block::category_default);
+    _changed |= set_categories(_block, _opts.enable, control_block::category_on);
+    _changed |= set_categories(_block, _opts.disable, control_block::category_off);
+
+    if(_opts.clear)
+    {
+        clear_functions(_block);
+        _changed = true;
+    }
+
+    if(!_opts.include.empty())
+    {
+        set_functions(_block, _opts.include, control_block::function_include);
+        _changed = true;
+    }
+    else if(!_opts.exclude.empty())
+    {
+        set_functions(_block, _opts.exclude, control_block::function_exclude);
+        _changed = true;
+    }
+
+    if(_changed) ++_block->generation;
+}
+
+void
+print(const control_block* _block, std::ostream& _os)
+{
+    size_t _nbits = 0;
+    for(const auto& itr : _block->functions)
+        _nbits += __builtin_popcountll(itr.load());
+
+    _os << "pid       : " << _block->pid << "\n"
+        << "changes   : " << _block->generation.load() << "\n"
+        << "functions : " << get_function_mode_name(_block->mode.load()) << " ("
+        << _nbits << " function bit(s) set)\n"
+        << "categories:\n";
+
+    for(size_t i = 1; i < _block->num_categories; ++i)
+        _os << "    " << std::setw(control_block::name_length) << std::left
+            << _block->names[i] << " "
+            << get_category_state_name(_block->categories[i].load()) << "\n";
+}
+
+ctl_options
+parse_args(int argc, char** argv)
+{
+    using parser_t     = argparse::argument_parser;
+    using parser_err_t = typename parser_t::result_type;
+
+    const auto* _desc = R"desc(
+    Turns categories and instrumented functions/regions on and off in a running process
+    which was started with OMNITRACE_CONTROL_FILE=ON. The category overrides take
+    precedence over OMNITRACE_ENABLE_CATEGORIES and OMNITRACE_DISABLE_CATEGORIES. The
+    functions are matched by the name which is recorded in the trace. For example:
+
+        omnitrace-ctl -p 1234 --list
+        omnitrace-ctl -p 1234 --enable host --include solver::step solver::update
+        omnitrace-ctl -p 1234 --reset host --clear
+
+    Without any changes, the state of the process is listed.
+    )desc";
+
+    auto _opts  = ctl_options{};
+    auto parser = parser_t{ get_basename(argv[0]), _desc };
+
+    parser.on_error([](parser_t&, const parser_err_t& _err) {
+        stream(std::cerr, color::fatal()) << _err << "\n";
+        exit(EXIT_FAILURE);
+    });
+
+    parser.enable_help();
+    parser.enable_version("omnitrace-ctl", OMNITRACE_ARGPARSE_VERSION_INFO);
+
+    auto _cols = std::get<0>(console::get_columns());
+    if(_cols > parser.get_help_width() + 8)
+        parser.set_description_width(
+            std::min<int>(_cols - parser.get_help_width() - 8, 120));
+
+    parser.start_group("DEBUG OPTIONS", "");
+    parser.add_argument({ "--monochrome" }, "Disable colorized output")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) {
+            auto _monochrome = p.get<bool>("monochrome");
+            monochrome()     = _monochrome;
+            p.set_use_color(!_monochrome);
+        });
+    parser.add_argument({ "-v", "--verbose" }, "Verbose output")
+        .count(1)
+        .action([&](parser_t& p) { verbose = p.get<int>("verbose"); });
+
+    parser.start_group("TARGET OPTIONS", "");
+    parser.add_argument({ "-p", "--pid" }, "Process ID of the controlled process")
+        .count(1)
+        .dtype("integer")
+        .action([&](parser_t& p) { _opts.pid = p.get<int64_t>("pid"); });
+    parser
+        .add_argument({ "-f", "--file" },
+                      "Control file, when it is not in OMNITRACE_TMPDIR of this shell")
+        .count(1)
+        .dtype("filepath")
+        .action([&](parser_t& p) { _opts.filename = p.get<std::string>("file"); });
+
+    parser.start_group("CATEGORY OPTIONS", "");
+    parser.add_argument({ "-e", "--enable" }, "Turn these categories on ('all' for all)")
+        .min_count(1)
+        .dtype("string")
+        .action([&](parser_t& p) {
+            _opts.enable = p.get<std::vector<std::string>>("enable");
+        });
+    parser
+        .add_argument({ "-d", "--disable" }, "Turn these categories off ('all' for all)")
+        .min_count(1)
+        .dtype("string")
+        .action([&](parser_t& p) {
+            _opts.disable = p.get<std::vector<std::string>>("disable");
+        });
+    parser
+        .add_argument({ "-r", "--reset" },
+                      "Remove the overrides of these categories ('all' for all)")
+        .min_count(1)
+        .dtype("string")
+        .action(
+            [&](parser_t& p) { _opts.reset = p.get<std::vector<std::string>>("reset"); });
+
+    parser.start_group("FUNCTION OPTIONS", "");
+    parser
+        .add_argument({ "-i", "--include" },
+                      "Only record these functions and regions (added to the current "
+                      "set)")
+        .min_count(1)
+        .dtype("string")
+        .action([&](parser_t& p) {
+            _opts.include = p.get<std::vector<std::string>>("include");
+        });
+    parser
+        .add_argument({ "-x", "--exclude" },
+                      "Do not record these functions and regions (added to the current "
+                      "set)")
+        .min_count(1)
+        .dtype("string")
+        .action([&](parser_t& p) {
+            _opts.exclude = p.get<std::vector<std::string>>("exclude");
+        });
+    parser
+        .add_argument({ "-c", "--clear" },
+                      "Remove the function filter (applied before --include/--exclude)")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) { _opts.clear = p.get<bool>("clear"); });
+
+    parser.start_group("OUTPUT OPTIONS", "");
+    parser.add_argument({ "-l", "--list" }, "List the overrides after the changes")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) { _opts.list = p.get<bool>("list"); });
+
+    get_verbose();
+
+    auto _err = parser.parse_args(argc, argv);
+    if(_err) throw std::runtime_error(_err.what());
+
+    if(parser.exists("help") || (_opts.pid <= 0 && _opts.filename.empty()))
+    {
+        parser.print_help();
+        exit((parser.exists("help")) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if(_opts.enable.empty() && _opts.disable.empty() && _opts.reset.empty() &&
+       _opts.include.empty() && _opts.exclude.empty() && !_opts.clear)
+        _opts.list = true;
+
+    return _opts;
+}
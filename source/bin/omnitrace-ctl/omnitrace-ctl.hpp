@@ -0,0 +1,66 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#define TIMEMORY_PROJECT_NAME "omnitrace-ctl"
+
+#include "common/control.hpp"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+using omnitrace::control_block;
+
+struct ctl_options
+{
+    bool                     list     = false;
+    bool                     clear    = false;
+    int64_t                  pid      = 0;
+    std::string              filename = {};
+    std::vector<std::string> enable   = {};  // categories which are forced on
+    std::vector<std::string> disable  = {};  // categories which are forced off
+    std::vector<std::string> reset    = {};  // categories which follow the config again
+    std::vector<std::string> include  = {};  // only these functions are recorded
+    std::vector<std::string> exclude  = {};  // these functions are not recorded
+};
+
+int
+get_verbose();
+
+ctl_options
+parse_args(int argc, char** argv);
+
+// maps the control file of the process (OMNITRACE_CONTROL_FILE). Throws on failure
+control_block*
+open_control(const ctl_options& _opts);
+
+// applies the category overrides and the function filter. Throws when a category is
+// unknown
+void
+apply(control_block* _block, const ctl_options& _opts);
+
+// prints the overrides of every category and the function filter
+void
+print(const control_block* _block, std::ostream& _os);
@@ -0,0 +1,708 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-diff.hpp"
+
+#include <timemory/environment.hpp>
+#include <timemory/log/color.hpp>
+#include <timemory/log/macros.hpp>
+#include <timemory/tpls/cereal/archives.hpp>
+#include <timemory/utility/argparse.hpp>
+#include <timemory/utility/console.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace color    = ::tim::log::color;
+namespace console  = ::tim::utility::console;
+namespace argparse = ::tim::argparse;
+using ::tim::get_env;
+using ::tim::log::monochrome;
+using ::tim::log::stream;
+
+namespace
+{
+int verbose = 0;
+
+std::string
+get_basename(std::string _v)
+{
+    auto _pos = _v.find_last_of('/');
+    if(_pos != std::string::npos) _v = _v.substr(_pos + 1);
+    return _v;
+}
+
+std::string
+read_file(const std::string& _fname)
+{
+    auto _ifs = std::ifstream{ _fname, std::ios::binary };
+    if(!_ifs) throw std::runtime_error("unable to open '" + _fname + "'");
+    return std::string{ std::istreambuf_iterator<char>{ _ifs },
+                        std::istreambuf_iterator<char>{} };
+}
+
+// FNV-1a of the name combined with the hash of the parent so that the key of a region
+// is the same in every repetition (and every build) as long as the call-path is
+uint64_t
+get_hash(uint64_t _parent, std::string_view _name)
+{
+    uint64_t _v = (_parent == 0) ? 0xcbf29ce484222325ULL : _parent;
+    for(auto itr : _name)
+    {
+        _v ^= static_cast<unsigned char>(itr);
+        _v *= 0x100000001b3ULL;
+    }
+    // separator so that "ab" -> "c" is not "a" -> "bc"
+    _v ^= 0xff;
+    _v *= 0x100000001b3ULL;
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//      extraction of the regions
+//
+//--------------------------------------------------------------------------------------//
+
+// the timemory output is read with the rapidjson bundled with cereal
+namespace json = CEREAL_RAPIDJSON_NAMESPACE;
+using json_value = json::Value;
+
+const json_value*
+find_member(const json_value& _v, const char* _key)
+{
+    if(!_v.IsObject()) return nullptr;
+    auto itr = _v.FindMember(_key);
+    return (itr != _v.MemberEnd()) ? &itr->value : nullptr;
+}
+
+// ">>> |_foo" or "|0>>> |_foo" -> "foo"
+std::string
+get_region_name(std::string_view _prefix)
+{
+    if(auto _pos = _prefix.find(">>>"); _pos != std::string_view::npos)
+        _prefix = _prefix.substr(_pos + 3);
+    while(!_prefix.empty() && (_prefix.front() == ' ' || _prefix.front() == '|' ||
+                               _prefix.front() == '_'))
+        _prefix.remove_prefix(1);
+    while(!_prefix.empty() && _prefix.back() == ' ')
+        _prefix.remove_suffix(1);
+    return std::string{ _prefix };
+}
+
+// the scalar value of an entry: the value in the display units when available. The
+// values of array-like components (e.g. hardware counters) are summed
+bool
+get_region_value(const json_value& _entry, double& _value)
+{
+    for(const auto* itr : { "repr_data", "accum", "value" })
+    {
+        const auto* _v = find_member(_entry, itr);
+        if(!_v) continue;
+        if(_v->IsNumber())
+        {
+            _value = _v->GetDouble();
+            return std::isfinite(_value);
+        }
+        if(_v->IsArray() && !_v->Empty())
+        {
+            _value = 0.0;
+            for(const auto& aitr : _v->GetArray())
+                if(aitr.IsNumber()) _value += aitr.GetDouble();
+            return std::isfinite(_value);
+        }
+    }
+    return false;
+}
+
+bool
+is_region(const json_value& _v)
+{
+    const auto* _prefix = find_member(_v, "prefix");
+    const auto* _entry  = find_member(_v, "entry");
+    return _prefix && _prefix->IsString() && _entry && _entry->IsObject();
+}
+
+// the graph of every rank is an array of the regions in depth-first order so the
+// call-path of a region is tracked with a stack of the hashes of its parents. The
+// values of the same call-path in different ranks are summed
+void
+extract_regions(const json_value& _v, region_values& _data)
+{
+    if(_v.IsObject())
+    {
+        for(const auto& itr : _v.GetObject())
+            extract_regions(itr.value, _data);
+        return;
+    }
+
+    if(!_v.IsArray()) return;
+
+    auto _parents = std::vector<std::pair<uint64_t, std::string>>{};
+    for(const auto& itr : _v.GetArray())
+    {
+        if(!is_region(itr))
+        {
+            extract_regions(itr, _data);
+            continue;
+        }
+
+        const auto* _depth_v = find_member(itr, "depth");
+        auto        _depth   = size_t{ 0 };
+        if(_depth_v && _depth_v->IsNumber())
+            _depth = static_cast<size_t>(std::max(_depth_v->GetDouble(), 0.0));
+        _parents.resize(std::min(_depth, _parents.size()));
+
+        auto _name = get_region_name(find_member(itr, "prefix")->GetString());
+        auto _hash = get_hash((_parents.empty()) ? 0 : _parents.back().first, _name);
+        auto _path = (_parents.empty()) ? _name : _parents.back().second + "/" + _name;
+
+        auto _value = 0.0;
+        if(get_region_value(*find_member(itr, "entry"), _value))
+        {
+            _data.values[_hash] += _value;
+            if(_data.names.count(_hash) == 0) _data.names.emplace(_hash, _path);
+        }
+        _parents.emplace_back(_hash, std::move(_path));
+    }
+}
+
+region_values
+read_timemory_json(const std::string& _input, const std::string& _contents,
+                   const diff_options& _opts)
+{
+    // rapidjson writes NaN and Infinity when the value is not finite
+    auto _root = json::Document{};
+    _root.Parse<json::kParseNanAndInfFlag>(_contents.c_str());
+    if(_root.HasParseError())
+        throw std::runtime_error("invalid JSON in '" + _input + "' at offset " +
+                                 std::to_string(_root.GetErrorOffset()));
+
+    const json_value* _data = &_root;
+
+    // {"timemory": {"wall_clock": {...}, "cpu_clock": {...}}}
+    if(const auto* _tim = find_member(_root, "timemory"); _tim && _tim->IsObject())
+    {
+        _data = find_member(*_tim, _opts.metric.c_str());
+        if(!_data && _tim->MemberCount() == 1) _data = &_tim->MemberBegin()->value;
+        if(!_data)
+        {
+            auto _avail = std::string{};
+            for(const auto& itr : _tim->GetObject())
+            {
+                if(!_avail.empty()) _avail += ", ";
+                _avail += itr.name.GetString();
+            }
+            throw std::runtime_error("no '" + _opts.metric + "' data in '" + _input +
+                                     "' (available: " + _avail + ")");
+        }
+    }
+
+    auto _v = region_values{};
+    extract_regions(*_data, _v);
+    return _v;
+}
+
+// "main;foo;bar 42": the folded stacks only have the samples of the leaf so every
+// frame of the stack is credited with the weight, i.e. the regions are the inclusive
+// values of the call-paths
+region_values
+read_folded_stacks(const std::string& _contents)
+{
+    auto _v   = region_values{};
+    auto _iss = std::istringstream{ _contents };
+    for(std::string _line; std::getline(_iss, _line);)
+    {
+        auto _pos = _line.find_last_of(' ');
+        if(_line.empty() || _pos == std::string::npos) continue;
+
+        auto _weight = std::strtod(_line.c_str() + _pos + 1, nullptr);
+        auto _stack  = std::string_view{ _line }.substr(0, _pos);
+        auto _hash   = uint64_t{ 0 };
+        while(!_stack.empty())
+        {
+            auto _end = std::min(_stack.find(';'), _stack.size());
+            _hash     = get_hash(_hash, _stack.substr(0, _end));
+            _v.values[_hash] += _weight;
+            if(_v.names.count(_hash) == 0)
+            {
+                auto _path = std::string_view{ _line }.substr(
+                    0, static_cast<size_t>(_stack.data() - _line.data()) + _end);
+                auto _name = std::string{ _path };
+                std::replace(_name.begin(), _name.end(), ';', '/');
+                _v.names.emplace(_hash, std::move(_name));
+            }
+            _stack.remove_prefix(std::min(_end + 1, _stack.size()));
+        }
+    }
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//      statistics
+//
+//--------------------------------------------------------------------------------------//
+
+// quantile of the standard normal distribution (Acklam's rational approximation,
+// relative error < 1.2e-9)
+double
+normal_quantile(double _p)
+{
+    constexpr double a[] = { -3.969683028665376e+01, 2.209460984245205e+02,
+                             -2.759285104469687e+02, 1.383577518672690e+02,
+                             -3.066479806614716e+01, 2.506628277459239e+00 };
+    constexpr double b[] = { -5.447609879822406e+01, 1.615858368580409e+02,
+                             -1.556989798598866e+02, 6.680131188771972e+01,
+                             -1.328068155288572e+01 };
+    constexpr double c[] = { -7.784894002430293e-03, -3.223964580411365e-01,
+                             -2.400758277161838e+00, -2.549732539343734e+00,
+                             4.374664141464968e+00,  2.938163982698783e+00 };
+    constexpr double d[] = { 7.784695709041462e-03, 3.224671290700398e-01,
+                             2.445134137142996e+00, 3.754408661907416e+00 };
+
+    if(_p < 0.02425)
+    {
+        auto q = std::sqrt(-2.0 * std::log(_p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    if(_p > 1.0 - 0.02425) return -normal_quantile(1.0 - _p);
+
+    auto q = _p - 0.5;
+    auto r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+}
+
+// quantile of the Student's t-distribution. Exact for one and two degrees of freedom
+// (which are rounded down, i.e. the interval is conservative) and the Cornish-Fisher
+// expansion otherwise (Abramowitz and Stegun 26.7.5)
+double
+t_quantile(double _p, double _df)
+{
+    constexpr double pi = 3.14159265358979323846;
+
+    if(_df < 2.0) return std::tan(pi * (_p - 0.5));
+    if(_df < 3.0) return (2.0 * _p - 1.0) / std::sqrt(2.0 * _p * (1.0 - _p));
+
+    auto z  = normal_quantile(_p);
+    auto z2 = z * z;
+    auto g1 = (z2 + 1.0) * z / 4.0;
+    auto g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+    auto g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+    auto g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z /
+              92160.0;
+    return z + g1 / _df + g2 / (_df * _df) + g3 / (_df * _df * _df) +
+           g4 / (_df * _df * _df * _df);
+}
+
+struct sample_stats
+{
+    size_t count    = 0;
+    double mean     = 0.0;
+    double variance = 0.0;  // sample (n - 1) variance
+};
+
+// values of the region in every repetition. A region which is missing from a
+// repetition was not executed so it contributes a zero
+sample_stats
+get_stats(const std::vector<region_values>& _data, uint64_t _hash)
+{
+    auto _v = sample_stats{};
+    auto _m = 0.0;
+    for(const auto& itr : _data)
+    {
+        auto _iitr = itr.values.find(_hash);
+        auto _x    = (_iitr == itr.values.end()) ? 0.0 : _iitr->second;
+        // Welford's algorithm
+        auto _delta = _x - _v.mean;
+        _v.mean += _delta / static_cast<double>(++_v.count);
+        _m += _delta * (_x - _v.mean);
+    }
+    if(_v.count > 1) _v.variance = _m / static_cast<double>(_v.count - 1);
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//      output
+//
+//--------------------------------------------------------------------------------------//
+
+enum class change_type
+{
+    none = 0,
+    regression,
+    improvement
+};
+
+change_type
+get_change(const region_diff& _v)
+{
+    if(!_v.significant) return change_type::none;
+    return (_v.delta > 0.0) ? change_type::regression : change_type::improvement;
+}
+
+std::string
+get_display_name(const std::string& _name, size_t _width)
+{
+    if(_name.length() <= _width) return _name;
+    return "..." + _name.substr(_name.length() - _width + 3);
+}
+
+std::string
+get_csv_string(const std::string& _v)
+{
+    auto _s = std::string{ "\"" };
+    for(auto itr : _v)
+    {
+        if(itr == '"') _s += '"';
+        _s += itr;
+    }
+    return _s + "\"";
+}
+
+void
+print_table(std::ostream& _os, const std::string& _label,
+            const std::vector<const region_diff*>& _data, size_t _top)
+{
+    if(_data.empty()) return;
+
+    constexpr size_t name_width = 60;
+
+    _os << "\n" << _label << " (" << _data.size() << "):\n\n";
+    _os << std::left << std::setw(name_width) << "REGION" << std::right
+        << std::setw(14) << "BASELINE" << std::setw(14) << "CANDIDATE"
+        << std::setw(10) << "CHANGE" << std::setw(30) << "CONFIDENCE INTERVAL"
+        << "\n";
+
+    auto _n = std::min(_top, _data.size());
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto* itr = _data.at(i);
+        auto _ci  = std::stringstream{};
+        _ci << std::setprecision(4) << "[" << itr->ci_lower << ", " << itr->ci_upper
+            << "]";
+        auto _pct = std::stringstream{};
+        _pct << std::showpos << std::fixed << std::setprecision(1)
+             << (100.0 * itr->relative) << "%";
+        _os << std::left << std::setw(name_width)
+            << get_display_name(itr->name, name_width - 2) << std::right
+            << std::setprecision(6) << std::setw(14) << itr->baseline << std::setw(14)
+            << itr->candidate << std::setw(10) << _pct.str() << std::setw(30)
+            << _ci.str() << "\n";
+    }
+    if(_n < _data.size()) _os << "... " << (_data.size() - _n) << " more\n";
+}
+}  // namespace
+
+int
+get_verbose()
+{
+    verbose = get_env("OMNITRACE_DIFF_VERBOSE",
+                      get_env<int>("OMNITRACE_VERBOSE", verbose, false));
+    return verbose;
+}
+
+region_values
+read_input(const std::string& _input, const diff_options& _opts)
+{
+    auto _contents = read_file(_input);
+    auto _pos      = _contents.find_first_not_of(" \t\r\n");
+
+    auto _v = (_pos != std::string::npos && _contents.at(_pos) == '{')
+                  ? read_timemory_json(_input, _contents, _opts)
+                  : read_folded_stacks(_contents);
+
+    if(_v.values.empty())
+        throw std::runtime_error("no regions found in '" + _input + "'");
+
+    if(verbose >= 1)
+        TIMEMORY_PRINTF_INFO(stderr, "%s: %zu regions\n", _input.c_str(),
+                             _v.values.size());
+    return _v;
+}
+
+std::vector<region_diff>
+compare(const std::vector<region_values>& _baseline,
+        const std::vector<region_values>& _candidate, const diff_options& _opts)
+{
+    // the union of the regions of every repetition
+    auto _names = std::unordered_map<uint64_t, const std::string*>{};
+    for(const auto* ditr : { &_baseline, &_candidate })
+        for(const auto& itr : *ditr)
+            for(const auto& nitr : itr.names)
+                _names.emplace(nitr.first, &nitr.second);
+
+    auto _alpha = 1.0 - std::min(std::max(_opts.confidence, 0.5), 0.9999);
+    auto _data  = std::vector<region_diff>{};
+    _data.reserve(_names.size());
+    for(const auto& itr : _names)
+    {
+        auto _x = get_stats(_baseline, itr.first);
+        auto _y = get_stats(_candidate, itr.first);
+        if(std::max(std::abs(_x.mean), std::abs(_y.mean)) < _opts.min_value) continue;
+
+        auto _v        = region_diff{};
+        _v.name        = *itr.second;
+        _v.baseline_n  = _x.count;
+        _v.candidate_n = _y.count;
+        _v.baseline    = _x.mean;
+        _v.candidate   = _y.mean;
+        _v.delta       = _y.mean - _x.mean;
+        _v.relative    = (_x.mean != 0.0) ? (_v.delta / std::abs(_x.mean))
+                         : (_v.delta == 0.0)
+                             ? 0.0
+                             : std::copysign(std::numeric_limits<double>::infinity(),
+                                             _v.delta);
+        _v.ci_lower = _v.ci_upper = _v.delta;
+
+        // Welch's t-test: the variances of the baseline and the candidate are not
+        // assumed to be equal. A single repetition has no variance so it is never
+        // significant
+        if(_x.count > 1 && _y.count > 1)
+        {
+            auto _vx = _x.variance / static_cast<double>(_x.count);
+            auto _vy = _y.variance / static_cast<double>(_y.count);
+            auto _se = std::sqrt(_vx + _vy);
+            if(_se > 0.0)
+            {
+                // Welch-Satterthwaite degrees of freedom
+                auto _df = (_vx + _vy) * (_vx + _vy) /
+                           (_vx * _vx / static_cast<double>(_x.count - 1) +
+                            _vy * _vy / static_cast<double>(_y.count - 1));
+                auto _t  = t_quantile(1.0 - _alpha / 2.0, _df);
+                _v.ci_lower = _v.delta - _t * _se;
+                _v.ci_upper = _v.delta + _t * _se;
+            }
+            _v.significant = (_v.ci_lower > 0.0 || _v.ci_upper < 0.0) &&
+                             std::abs(_v.relative) >= _opts.threshold;
+        }
+        _data.emplace_back(std::move(_v));
+    }
+
+    // largest relative changes first
+    std::sort(_data.begin(), _data.end(), [](const auto& _lhs, const auto& _rhs) {
+        if(_lhs.relative != _rhs.relative) return _lhs.relative > _rhs.relative;
+        return _lhs.name < _rhs.name;
+    });
+    return _data;
+}
+
+size_t
+report(const std::vector<region_diff>& _data, const diff_options& _opts)
+{
+    auto _regressions  = std::vector<const region_diff*>{};
+    auto _improvements = std::vector<const region_diff*>{};
+    for(const auto& itr : _data)
+    {
+        switch(get_change(itr))
+        {
+            case change_type::regression: _regressions.emplace_back(&itr); break;
+            case change_type::improvement: _improvements.emplace_back(&itr); break;
+            case change_type::none: break;
+        }
+    }
+    std::reverse(_improvements.begin(), _improvements.end());
+
+    if(!_opts.output.empty())
+    {
+        auto _ofs = std::ofstream{ _opts.output };
+        if(!_ofs) throw std::runtime_error("unable to open '" + _opts.output + "'");
+        _ofs << "region,baseline_n,candidate_n,baseline,candidate,delta,ci_lower,"
+                "ci_upper,relative,change\n";
+        _ofs << std::setprecision(std::numeric_limits<double>::max_digits10);
+        for(const auto& itr : _data)
+        {
+            auto _change = get_change(itr);
+            _ofs << get_csv_string(itr.name) << "," << itr.baseline_n << ","
+                 << itr.candidate_n << "," << itr.baseline << "," << itr.candidate
+                 << "," << itr.delta << "," << itr.ci_lower << "," << itr.ci_upper
+                 << "," << itr.relative << ","
+                 << ((_change == change_type::regression)    ? "regression"
+                     : (_change == change_type::improvement) ? "improvement"
+                                                             : "none")
+                 << "\n";
+        }
+        if(verbose >= 0)
+            TIMEMORY_PRINTF_INFO(stderr, "wrote %zu regions to '%s'\n", _data.size(),
+                                 _opts.output.c_str());
+    }
+
+    print_table(std::cout, "REGRESSIONS", _regressions, _opts.top);
+    print_table(std::cout, "IMPROVEMENTS", _improvements, _opts.top);
+
+    std::cout << "\n";
+    stream(std::cout, (_regressions.empty()) ? color::info() : color::warning())
+        << _data.size() << " regions compared (" << _opts.baseline.size()
+        << " baseline and " << _opts.candidate.size() << " candidate repetitions): "
+        << _regressions.size() << " regressions, " << _improvements.size()
+        << " improvements at " << (100.0 * _opts.confidence) << "% confidence and a "
+        << (100.0 * _opts.threshold) << "% threshold\n";
+
+    return _regressions.size();
+}
+
+diff_options
+parse_args(int argc, char** argv)
+{
+    using parser_t     = argparse::argument_parser;
+    using parser_err_t = typename parser_t::result_type;
+
+    const auto* _desc = R"desc(
+    Compares the profiles of a baseline and a candidate over several repetitions of each
+    and reports the regions whose change is statistically significant (Welch's t-test)
+    and larger than the threshold. The inputs are the timemory JSON output of a metric
+    (e.g. wall_clock.json) or the folded-stack sampling output (sampling-folded.txt).
+    The regions are aligned by their call-path. For example:
+
+        omnitrace-diff -b base-*/wall_clock.json -c new-*/wall_clock.json
+        omnitrace-diff -o diff.csv -b base-*/sampling-folded.txt \
+            -c new-*/sampling-folded.txt
+
+    With --fail-on-regression, the exit code is 2 when a regression was found.
+    )desc";
+
+    auto _opts  = diff_options{};
+    auto parser = parser_t{ get_basename(argv[0]), _desc };
+
+    parser.on_error([](parser_t&, const parser_err_t& _err) {
+        stream(std::cerr, color::fatal()) << _err << "\n";
+        exit(EXIT_FAILURE);
+    });
+
+    parser.enable_help();
+    parser.enable_version("omnitrace-diff", OMNITRACE_ARGPARSE_VERSION_INFO);
+
+    auto _cols = std::get<0>(console::get_columns());
+    if(_cols > parser.get_help_width() + 8)
+        parser.set_description_width(
+            std::min<int>(_cols - parser.get_help_width() - 8, 120));
+
+    parser.start_group("DEBUG OPTIONS", "");
+    parser.add_argument({ "--monochrome" }, "Disable colorized output")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) {
+            auto _monochrome = p.get<bool>("monochrome");
+            monochrome()     = _monochrome;
+            p.set_use_color(!_monochrome);
+        });
+    parser.add_argument({ "-v", "--verbose" }, "Verbose output")
+        .count(1)
+        .action([&](parser_t& p) { verbose = p.get<int>("verbose"); });
+
+    parser.start_group("INPUT OPTIONS", "");
+    parser.add_argument({ "-b", "--baseline" }, "Repetitions of the baseline")
+        .min_count(1)
+        .dtype("filepath")
+        .action([&](parser_t& p) {
+            _opts.baseline = p.get<std::vector<std::string>>("baseline");
+        });
+    parser.add_argument({ "-c", "--candidate" }, "Repetitions of the candidate")
+        .min_count(1)
+        .dtype("filepath")
+        .action([&](parser_t& p) {
+            _opts.candidate = p.get<std::vector<std::string>>("candidate");
+        });
+    parser
+        .add_argument({ "-m", "--metric" },
+                      "Component compared when a timemory JSON file has several")
+        .count(1)
+        .dtype("string")
+        .action([&](parser_t& p) { _opts.metric = p.get<std::string>("metric"); });
+    parser
+        .add_argument({ "-j", "--jobs" }, "Number of input files read concurrently")
+        .count(1)
+        .dtype("integer")
+        .action([&](parser_t& p) { _opts.jobs = p.get<size_t>("jobs"); });
+
+    parser.start_group("ANALYSIS OPTIONS", "");
+    parser
+        .add_argument({ "--confidence" },
+                      "Confidence level of the interval of the change of a region")
+        .count(1)
+        .dtype("double")
+        .action([&](parser_t& p) { _opts.confidence = p.get<double>("confidence"); });
+    parser
+        .add_argument({ "--threshold" },
+                      "Minimum relative change of a significant region, e.g. 0.05 "
+                      "ignores changes smaller than 5%")
+        .count(1)
+        .dtype("double")
+        .action([&](parser_t& p) { _opts.threshold = p.get<double>("threshold"); });
+    parser
+        .add_argument({ "--min-value" },
+                      "Ignore the regions whose mean value is smaller than this in "
+                      "both the baseline and the candidate")
+        .count(1)
+        .dtype("double")
+        .action([&](parser_t& p) { _opts.min_value = p.get<double>("min-value"); });
+
+    parser.start_group("OUTPUT OPTIONS", "");
+    parser.add_argument({ "-n", "--top" }, "Number of regions printed per table")
+        .count(1)
+        .dtype("integer")
+        .action([&](parser_t& p) { _opts.top = p.get<size_t>("top"); });
+    parser.add_argument({ "-o", "--output" }, "Write every region to this CSV file")
+        .count(1)
+        .dtype("filepath")
+        .action([&](parser_t& p) { _opts.output = p.get<std::string>("output"); });
+    parser
+        .add_argument({ "--fail-on-regression" },
+                      "Exit with 2 when a significant regression was found")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) {
+            _opts.fail_on_regression = p.get<bool>("fail-on-regression");
+        });
+
+    get_verbose();
+
+    auto _err = parser.parse_args(argc, argv);
+    if(_err) throw std::runtime_error(_err.what());
+
+    if(parser.exists("help") || _opts.baseline.empty() || _opts.candidate.empty())
+    {
+        parser.print_help();
+        exit((parser.exists("help")) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    return _opts;
+}
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-diff.hpp"
+
+#include <timemory/log/macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+int
+main(int argc, char** argv)
+{
+    auto _opts   = parse_args(argc, argv);
+    auto _inputs = _opts.baseline;
+    _inputs.insert(_inputs.end(), _opts.candidate.begin(), _opts.candidate.end());
+
+    auto _data = std::vector<region_values>(_inputs.size());
+    auto _next = std::atomic<size_t>{ 0 };
+    auto _fail = std::atomic<int>{ 0 };
+
+    // the repetitions are independent so they are read concurrently
+    auto _worker = [&]() {
+        for(size_t i = _next++; i < _inputs.size(); i = _next++)
+        {
+            try
+            {
+                _data.at(i) = read_input(_inputs.at(i), _opts);
+            } catch(std::exception& _e)
+            {
+                TIMEMORY_PRINTF_FATAL(stderr, "failed to read '%s': %s\n",
+                                      _inputs.at(i).c_str(), _e.what());
+                ++_fail;
+            }
+        }
+    };
+
+    auto _njobs = std::min<size_t>(std::max<size_t>(_opts.jobs, 1), _inputs.size());
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 1; i < _njobs; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+    for(auto& itr : _threads)
+        itr.join();
+
+    if(_fail.load() > 0) return EXIT_FAILURE;
+
+    auto _nbase     = _opts.baseline.size();
+    auto _baseline  = std::vector<region_values>{};
+    auto _candidate = std::vector<region_values>{};
+    for(size_t i = 0; i < _data.size(); ++i)
+        ((i < _nbase) ? _baseline : _candidate).emplace_back(std::move(_data.at(i)));
+
+    auto _nregress = report(compare(_baseline, _candidate, _opts), _opts);
+
+    // a distinct exit code so that a CI job can tell a regression from an error
+    return (_opts.fail_on_regression && _nregress > 0) ? 2 : EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#define TIMEMORY_PROJECT_NAME "omnitrace-diff"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct diff_options
+{
+    bool                     fail_on_regression = false;
+    size_t                   jobs               = 1;
+    size_t                   top                = 25;
+    double                   confidence         = 0.95;
+    double                   threshold          = 0.05;
+    double                   min_value          = 0.0;
+    std::string              metric             = "wall_clock";
+    std::string              output             = {};
+    std::vector<std::string> baseline           = {};
+    std::vector<std::string> candidate          = {};
+};
+
+// the value of every region in one repetition (i.e. one input file). The regions are
+// keyed by the call-path hash written by timemory or, for the folded-stack output, by
+// the hash of the stack
+struct region_values
+{
+    std::unordered_map<uint64_t, double>      values = {};
+    std::unordered_map<uint64_t, std::string> names  = {};
+};
+
+struct region_diff
+{
+    bool        significant = false;
+    size_t      baseline_n  = 0;
+    size_t      candidate_n = 0;
+    double      baseline    = 0.0;  // mean of the baseline repetitions
+    double      candidate   = 0.0;  // mean of the candidate repetitions
+    double      delta       = 0.0;  // candidate - baseline
+    double      ci_lower    = 0.0;  // confidence interval of the delta
+    double      ci_upper    = 0.0;
+    double      relative    = 0.0;  // delta / baseline
+    std::string name        = {};
+};
+
+int
+get_verbose();
+
+diff_options
+parse_args(int argc, char** argv);
+
+// reads the timemory JSON output (the metric is the component in the file, e.g.
+// wall_clock.json) or the folded-stack sampling output (sampling-folded.txt) of one
+// repetition. Throws on failure
+region_values
+read_input(const std::string& _input, const diff_options& _opts);
+
+// aligns the regions of the repetitions of the baseline and the candidate and computes
+// the difference of every region with a Welch's t-test
+std::vector<region_diff>
+compare(const std::vector<region_values>& _baseline,
+        const std::vector<region_values>& _candidate, const diff_options& _opts);
+
+// prints the largest changes and writes every region to the CSV output (if any).
+// Returns the number of significant regressions
+size_t
+report(const std::vector<region_diff>& _data, const diff_options& _opts);
@@ -32,6 +32,7 @@
 #include <algorithm>
 #include <link.h>
 #include <linux/limits.h>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -86,8 +87,11 @@ get_whole_function_names()
 std::string_view
 get_name(procedure_t* _func)
 {
-    static auto _v = std::unordered_map<procedure_t*, std::string>{};
+    static auto _v     = std::unordered_map<procedure_t*, std::string>{};
+    static auto _mutex = std::mutex{};
 
+    // the module functions may be analyzed concurrently
+    auto _lk = std::unique_lock<std::mutex>{ _mutex };
     auto itr = _v.find(_func);
     if(itr == _v.end())
     {
@@ -100,8 +104,10 @@ get_name(procedure_t* _func)
 std::string_view
 get_name(module_t* _module)
 {
-    static auto _v = std::unordered_map<module_t*, std::string>{};
+    static auto _v     = std::unordered_map<module_t*, std::string>{};
+    static auto _mutex = std::mutex{};
 
+    auto _lk = std::unique_lock<std::mutex>{ _mutex };
     auto itr = _v.find(_module);
     if(itr == _v.end())
     {
@@ -125,8 +131,10 @@ get_name(module_t* _module)
 symtab_func_t*
 get_symtab_function(procedure_t* _func)
 {
-    static auto _v = std::unordered_map<procedure_t*, symtab_func_t*>{};
+    static auto _v     = std::unordered_map<procedure_t*, symtab_func_t*>{};
+    static auto _mutex = std::mutex{};
 
+    auto _lk = std::unique_lock<std::mutex>{ _mutex };
     auto itr = _v.find(_func);
     if(itr == _v.end())
     {
@@ -23,6 +23,7 @@
 #pragma once
 
 #include "log.hpp"
+#include "regex_set.hpp"
 
 #include <timemory/backends/process.hpp>
 #include <timemory/environment.hpp>
@@ -96,7 +97,7 @@ using string_view_t          = std::string_view;
 using stringstream_t         = std::stringstream;
 using strvec_t               = std::vector<string_t>;
 using strset_t               = std::set<string_t>;
-using regexvec_t             = std::vector<std::regex>;
+using regexvec_t             = regex_set;
 using fmodset_t              = std::set<module_function>;
 using fixed_modset_t         = std::map<fmodset_t*, bool>;
 using exec_callback_t        = BPatchExecCallback;
@@ -188,6 +189,7 @@ extern bool use_line_info;
 //
 extern bool   allow_overlapping;
 extern bool   loop_level_instr;
+extern bool   loop_count_instr;
 extern bool   instr_dynamic_callsites;
 extern bool   instr_traps;
 extern bool   instr_loop_traps;
@@ -196,6 +198,8 @@ extern size_t min_address_range;
 extern size_t min_loop_address_range;
 extern size_t min_instructions;
 extern size_t min_loop_instructions;
+extern double profile_budget;
+extern double profile_probe_cost;
 //
 //  debug settings
 //
@@ -210,6 +214,7 @@ extern int  num_log_entries;
 extern bool simulate;
 extern bool include_uninstr;
 extern bool include_internal_linked_libs;
+extern bool instr_call_counts;
 //
 //  string settings
 //
@@ -227,6 +232,7 @@ extern snippet_vec_t    init_names;
 extern snippet_vec_t    fini_names;
 extern fmodset_t        available_module_functions;
 extern fmodset_t        instrumented_module_functions;
+extern fmodset_t        counted_module_functions;
 extern fmodset_t        overlapping_module_functions;
 extern fmodset_t        excluded_module_functions;
 extern fixed_modset_t   fixed_module_functions;
@@ -272,7 +278,7 @@ extern std::unique_ptr<std::ofstream> log_ofs;
         if(werror || LEVEL < 0)                                                          \
         {                                                                                \
             if(debug_print || verbose_level >= LEVEL)                                    \
-                fprintf(stderr, "[omnitrace][exe] Error! " __VA_ARGS__);                 \
+                log_printf(stderr, "[omnitrace][exe] Error! " __VA_ARGS__);              \
             char _buff[FUNCNAMELEN];                                                     \
             sprintf(_buff, "[omnitrace][exe] Error! " __VA_ARGS__);                      \
             throw std::runtime_error(std::string{ _buff });                              \
@@ -280,7 +286,7 @@ extern std::unique_ptr<std::ofstream> log_ofs;
         else                                                                             \
         {                                                                                \
             if(debug_print || verbose_level >= LEVEL)                                    \
-                fprintf(stderr, "[omnitrace][exe] Warning! " __VA_ARGS__);               \
+                log_printf(stderr, "[omnitrace][exe] Warning! " __VA_ARGS__);            \
         }                                                                                \
         fflush(stderr);                                                                  \
     }
@@ -292,7 +298,7 @@ extern std::unique_ptr<std::ofstream> log_ofs;
         snprintf(_logmsgbuff, FUNCNAMELEN, __VA_ARGS__);                                 \
         OMNITRACE_ADD_LOG_ENTRY(_logmsgbuff);                                            \
         if(debug_print || verbose_level >= LEVEL)                                        \
-            fprintf(stdout, "[omnitrace][exe] " __VA_ARGS__);                            \
+            log_printf(stdout, "[omnitrace][exe] " __VA_ARGS__);                         \
         fflush(stdout);                                                                  \
     }
 
@@ -301,7 +307,7 @@ extern std::unique_ptr<std::ofstream> log_ofs;
         char _logmsgbuff[FUNCNAMELEN];                                                   \
         snprintf(_logmsgbuff, FUNCNAMELEN, __VA_ARGS__);                                 \
         OMNITRACE_ADD_LOG_ENTRY(_logmsgbuff);                                            \
-        if(debug_print || verbose_level >= LEVEL) fprintf(stdout, __VA_ARGS__);          \
+        if(debug_print || verbose_level >= LEVEL) log_printf(stdout, __VA_ARGS__);       \
         fflush(stdout);                                                                  \
     }
 
@@ -0,0 +1,282 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "instrumentation_plan.hpp"
+#include "common/defines.h"
+#include "fwd.hpp"
+#include "log.hpp"
+
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <utility>
+
+extern "C" char** environ;
+
+namespace
+{
+constexpr std::string_view plan_magic   = "omnitrace-instrument-plan";
+constexpr int              plan_version = 2;
+
+// FNV-1a is used (instead of std::hash) since the hashes must be stable across
+// builds of omnitrace-instrument
+struct fnv1a
+{
+    fnv1a& operator()(const void* _data, size_t _len)
+    {
+        const auto* _bytes = static_cast<const unsigned char*>(_data);
+        for(size_t i = 0; i < _len; ++i)
+        {
+            value ^= _bytes[i];
+            value *= 0x100000001b3UL;
+        }
+        return *this;
+    }
+
+    fnv1a& operator()(std::string_view _v)
+    {
+        (*this)(_v.data(), _v.length());
+        // separator so that the concatenation of strings is unambiguous
+        return (*this)("\0", 1);
+    }
+
+    uint64_t value = 0xcbf29ce484222325UL;
+};
+
+std::string
+sanitize(std::string _v)
+{
+    for(auto& itr : _v)
+        if(itr == '\t' || itr == '\n' || itr == '\r') itr = ' ';
+    return _v;
+}
+}  // namespace
+
+instrumentation_plan&
+instrumentation_plan::get()
+{
+    static auto _v = instrumentation_plan{};
+    return _v;
+}
+
+uint64_t
+instrumentation_plan::get_function_hash(module_t* _module, procedure_t* _func)
+{
+    if(!_module || !_func || !_func->isInstrumentable()) return 0;
+
+    auto* _symtab_func = get_symtab_function(_func);
+    auto* _region      = (_symtab_func) ? _symtab_func->getRegion() : nullptr;
+    if(!_region || !_region->getPtrToRawData()) return 0;
+
+    auto _offset = _symtab_func->getOffset();
+    auto _size   = _symtab_func->getSize();
+    auto _beg    = _region->getMemOffset();
+    auto _end    = _region->getMemOffset() + _region->getDiskSize();
+    if(_size == 0 || _offset < _beg || _offset + _size > _end) return 0;
+
+    const auto* _data = static_cast<const char*>(_region->getPtrToRawData());
+
+    auto _hash = fnv1a{};
+    _hash(_data + (_offset - _beg), _size);
+    _hash(_func->getMangledName());
+    _hash(tim::filepath::basename(get_name(_module)));
+    return _hash.value;
+}
+
+uint64_t
+instrumentation_plan::get_options_hash(int _argc, char** _argv)
+{
+    // options which do not affect the heuristics. The address space options are
+    // ignored so that the plan of a binary rewrite is reused when attaching
+    static const auto _ignored = std::set<std::string_view>{
+        "-o", "--output", "--plan", "-j", "--jobs", "-p", "--pid", "--attach-mode"
+    };
+
+    auto _hash = fnv1a{};
+    _hash(OMNITRACE_VERSION_STRING);
+    for(int i = 1; i < _argc; ++i)
+    {
+        auto _arg = std::string_view{ _argv[i] };
+        auto _key = _arg.substr(0, _arg.find('='));
+        if(_ignored.count(_key) > 0)
+        {
+            // skip the value of the option when it was not provided via '='
+            if(_key == _arg && i + 1 < _argc && _argv[i + 1][0] != '-') ++i;
+            continue;
+        }
+        _hash(_arg);
+
+        // the selection also depends on the contents of the profile
+        if(_key == "--profile")
+        {
+            auto _file = std::string{};
+            if(_key != _arg)
+                _file = _arg.substr(_key.length() + 1);
+            else if(i + 1 < _argc)
+                _file = _argv[i + 1];
+            auto _ifs  = std::ifstream{ _file, std::ios::binary };
+            auto _data = std::string{ std::istreambuf_iterator<char>{ _ifs },
+                                      std::istreambuf_iterator<char>{} };
+            _hash(_data);
+        }
+    }
+
+    // the regex options may also be provided via the environment
+    auto _env = std::set<std::string_view>{};
+    for(char** itr = environ; itr && *itr; ++itr)
+    {
+        auto _v = std::string_view{ *itr };
+        if(_v.find("OMNITRACE_REGEX_") == 0) _env.emplace(_v);
+    }
+    for(auto itr : _env)
+        _hash(itr);
+
+    return _hash.value;
+}
+
+bool
+instrumentation_plan::load(const std::string& _filename, uint64_t _options_hash)
+{
+    auto _lk   = std::unique_lock<std::mutex>{ m_mutex };
+    m_filename = _filename;
+    m_options  = _options_hash;
+    m_previous.clear();
+    m_next.clear();
+
+    auto _ifs = std::ifstream{ _filename };
+    if(!_ifs) return false;
+
+    auto _line = std::string{};
+    if(!std::getline(_ifs, _line)) return false;
+
+    {
+        auto _iss     = std::istringstream{ _line };
+        auto _magic   = std::string{};
+        int  _version = 0;
+        auto _options = uint64_t{ 0 };
+        _iss >> _magic >> _version >> std::hex >> _options;
+        if(_magic != plan_magic || _version != plan_version || _options != m_options)
+        {
+            verbprintf(0, "Ignoring instrumentation plan '%s' (%s)...\n",
+                       _filename.c_str(),
+                       (_options != m_options) ? "options changed" : "incompatible");
+            return false;
+        }
+    }
+
+    auto* _last = static_cast<decision*>(nullptr);
+    while(std::getline(_ifs, _line))
+    {
+        if(_line.length() < 2) continue;
+        if(_line.front() == 'F')
+        {
+            auto _iss = std::istringstream{ _line.substr(2) };
+            auto _key = uint64_t{ 0 };
+            auto _v   = decision{};
+            _iss >> std::hex >> _key >> std::dec >> _v.instrument >> _v.coverage >>
+                _v.overlap >> _v.count >> _v.num_instructions;
+            _last = (_iss && _key != 0) ? &m_previous[_key] : nullptr;
+            if(_last) *_last = std::move(_v);
+        }
+        else if(_line.front() == 'M' && _last)
+        {
+            auto _iss    = std::istringstream{ _line.substr(2) };
+            auto _fields = std::vector<std::string>{};
+            for(auto _field = std::string{}; std::getline(_iss, _field, '\t');)
+                _fields.emplace_back(_field);
+            if(_fields.size() != 5) continue;
+            _last->messages.emplace_back(std::stoi(_fields.at(0)), _fields.at(1),
+                                         _fields.at(2), _fields.at(3), _fields.at(4));
+        }
+    }
+
+    verbprintf(0, "Loaded %zu function decisions from instrumentation plan '%s'...\n",
+               m_previous.size(), _filename.c_str());
+    return true;
+}
+
+bool
+instrumentation_plan::save() const
+{
+    if(!enabled()) return false;
+
+    auto _lk  = std::unique_lock<std::mutex>{ m_mutex };
+    auto _ofs = std::ofstream{};
+    if(!tim::filepath::open(_ofs, m_filename))
+    {
+        errprintf(0, "Error opening instrumentation plan '%s' for output\n",
+                  m_filename.c_str());
+        return false;
+    }
+
+    // sorted by key so that identical plans are written identically
+    auto _keys = std::vector<uint64_t>{};
+    _keys.reserve(m_next.size());
+    for(const auto& itr : m_next)
+        _keys.emplace_back(itr.first);
+    std::sort(_keys.begin(), _keys.end());
+
+    _ofs << plan_magic << " " << plan_version << " " << std::hex << m_options << std::dec
+         << "\n";
+    for(auto itr : _keys)
+    {
+        const auto& _v = m_next.at(itr);
+        _ofs << "F " << std::hex << itr << std::dec << " " << _v.instrument << " "
+             << _v.coverage << " " << _v.overlap << " " << _v.count << " "
+             << _v.num_instructions << "\n";
+        for(const auto& mitr : _v.messages)
+        {
+            _ofs << "M " << std::get<0>(mitr) << "\t" << sanitize(std::get<1>(mitr))
+                 << "\t" << sanitize(std::get<2>(mitr)) << "\t"
+                 << sanitize(std::get<3>(mitr)) << "\t" << sanitize(std::get<4>(mitr))
+                 << "\n";
+        }
+    }
+
+    verbprintf(0, "Saved %zu function decisions to instrumentation plan '%s'...\n",
+               m_next.size(), m_filename.c_str());
+    return true;
+}
+
+const instrumentation_plan::decision*
+instrumentation_plan::find(uint64_t _key) const
+{
+    if(_key == 0) return nullptr;
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    auto itr = m_previous.find(_key);
+    return (itr == m_previous.end()) ? nullptr : &itr->second;
+}
+
+void
+instrumentation_plan::record(uint64_t _key, decision _v)
+{
+    if(_key == 0 || !enabled()) return;
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    m_next[_key] = std::move(_v);
+}
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "fwd.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// decisions of the instrumentation heuristics for each function of a previous binary
+// rewrite. The functions are keyed by a hash of their bytes, mangled name, and module
+// basename and the plan is only reused when the options affecting the heuristics
+// are identical. The functions with a recorded decision skip the heuristics and,
+// when neither instrumented nor coverage instrumented, the CFG and instruction
+// analysis. Loop and call-site selection is evaluated when the snippets are inserted
+// and is therefore always repeated for the instrumented functions.
+struct instrumentation_plan
+{
+    using message_t = std::tuple<int, string_t, string_t, string_t, string_t>;
+
+    struct decision
+    {
+        bool                   instrument       = false;
+        bool                   coverage         = false;
+        bool                   overlap          = false;
+        bool                   count            = false;
+        uint64_t               num_instructions = 0;
+        std::vector<message_t> messages         = {};
+
+        bool requires_analysis() const { return instrument || coverage; }
+    };
+
+    static instrumentation_plan& get();
+
+    // hash of the bytes, mangled name, and module of the function (zero if unknown)
+    static uint64_t get_function_hash(module_t*, procedure_t*);
+
+    // hash of the options which affect the instrumentation heuristics
+    static uint64_t get_options_hash(int _argc, char** _argv);
+
+    bool enabled() const { return !m_filename.empty(); }
+    bool load(const std::string& _filename, uint64_t _options_hash);
+    bool save() const;
+
+    // decision of a previous rewrite (nullptr if none). Thread-safe
+    const decision* find(uint64_t _key) const;
+
+    // records the decision for the next plan. Thread-safe
+    void record(uint64_t _key, decision _v);
+
+    size_t size() const { return m_previous.size(); }
+
+private:
+    using map_t = std::unordered_map<uint64_t, decision>;
+
+    std::string        m_filename = {};
+    uint64_t           m_options  = 0;
+    map_t              m_previous = {};
+    map_t              m_next     = {};
+    mutable std::mutex m_mutex    = {};
+};
@@ -0,0 +1,299 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "instrumentation_profile.hpp"
+#include "fwd.hpp"
+#include "log.hpp"
+
+#include <timemory/tpls/cereal/archives.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// approximate runtime of an instruction, used when sampling data does not provide
+// the number of calls
+constexpr double instruction_cost = 0.5e-9;
+
+// the timemory output is read with the rapidjson bundled with cereal
+namespace json = CEREAL_RAPIDJSON_NAMESPACE;
+using json_value = json::Value;
+
+const json_value*
+find_member(const json_value& _v, const char* _key)
+{
+    if(!_v.IsObject()) return nullptr;
+    auto itr = _v.FindMember(_key);
+    return (itr != _v.MemberEnd()) ? &itr->value : nullptr;
+}
+
+// conversion of the timemory display unit to seconds (zero if not a time unit)
+double
+get_time_units(std::string_view _unit)
+{
+    if(_unit == "sec" || _unit == "s") return 1.0;
+    if(_unit == "msec" || _unit == "ms") return 1.0e-3;
+    if(_unit == "usec" || _unit == "us") return 1.0e-6;
+    if(_unit == "nsec" || _unit == "ns") return 1.0e-9;
+    if(_unit == "psec" || _unit == "ps") return 1.0e-12;
+    if(_unit == "min") return 60.0;
+    if(_unit == "hr") return 3600.0;
+    return 0.0;
+}
+
+// removes the thread/rank tag and the tree decoration, e.g. "|0>>>   |_foo" -> "foo"
+std::string
+get_function_name(std::string _prefix)
+{
+    auto _pos = _prefix.find(">>>");
+    if(_pos != std::string::npos) _prefix = _prefix.substr(_pos + 3);
+    _pos = _prefix.find_first_not_of(" \t");
+    if(_pos == std::string::npos) return std::string{};
+    _prefix = _prefix.substr(_pos);
+    if(_prefix.find("|_") == 0) _prefix = _prefix.substr(2);
+    return _prefix;
+}
+
+double
+get_number(const json_value& _v, const char* _key)
+{
+    const auto* _field = find_member(_v, _key);
+    return (_field && _field->IsNumber()) ? _field->GetDouble() : 0.0;
+}
+
+std::string
+get_percent(double _v)
+{
+    auto _ss = std::stringstream{};
+    _ss.precision(3);
+    _ss << (100.0 * _v) << "%";
+    return _ss.str();
+}
+}  // namespace
+
+instrumentation_profile&
+instrumentation_profile::get()
+{
+    static auto _v = instrumentation_profile{};
+    return _v;
+}
+
+bool
+instrumentation_profile::load(const std::string& _filename)
+{
+    m_total = 0.0;
+    m_entries.clear();
+
+    auto _ifs = std::ifstream{ _filename, std::ios::binary };
+    if(!_ifs)
+    {
+        errprintf(-1, "unable to open profile '%s'\n", _filename.c_str());
+        return false;
+    }
+
+    auto _data = std::string{ std::istreambuf_iterator<char>{ _ifs },
+                              std::istreambuf_iterator<char>{} };
+    auto _doc  = json::Document{};
+    _doc.Parse<json::kParseNanAndInfFlag>(_data.c_str());
+    if(_doc.HasParseError())
+    {
+        errprintf(-1, "unable to read profile '%s': invalid JSON at offset %zu\n",
+                  _filename.c_str(), static_cast<size_t>(_doc.GetErrorOffset()));
+        return false;
+    }
+
+    const auto* _timemory = find_member(_doc, "timemory");
+    if(!_timemory || !_timemory->IsObject())
+    {
+        errprintf(-1, "profile '%s' is not a timemory JSON output\n", _filename.c_str());
+        return false;
+    }
+
+    for(const auto& citr : _timemory->GetObject())
+    {
+        const auto& _component = citr.value;
+        const auto* _unit      = find_member(_component, "unit_repr");
+        const auto* _ranks     = find_member(_component, "ranks");
+        auto        _units     = (_unit && _unit->IsString())
+                                     ? get_time_units(_unit->GetString())
+                                     : 0.0;
+        // only the flat layout of the timers is used
+        if(_units <= 0.0 || !_ranks || !_ranks->IsArray()) continue;
+
+        // for the sampling components, "laps" is the number of samples
+        auto _sampled = (std::string_view{ citr.name.GetString() }.find("sampling") !=
+                         std::string_view::npos);
+
+        for(const auto& ritr : _ranks->GetArray())
+        {
+            const auto* _graph = find_member(ritr, "graph");
+            if(!_graph || !_graph->IsArray()) continue;
+
+            auto _size = _graph->Size();
+            for(json::SizeType i = 0; i < _size; ++i)
+            {
+                const auto& _node   = (*_graph)[i];
+                const auto* _prefix = find_member(_node, "prefix");
+                const auto* _entry  = find_member(_node, "entry");
+                if(!_prefix || !_prefix->IsString() || !_entry) continue;
+
+                auto _name = get_function_name(_prefix->GetString());
+                if(_name.empty()) continue;
+
+                auto& _v    = m_entries[_name];
+                auto  _laps = static_cast<uint64_t>(get_number(*_entry, "laps"));
+                auto  _time = get_number(*_entry, "repr_data") * _units;
+                if(_sampled)
+                    _v.samples += _laps;
+                else
+                    _v.calls += _laps;
+                _v.inclusive += _time;
+                m_total = std::max(m_total, _v.inclusive);
+
+                auto _depth = get_number(_node, "depth");
+                if(i + 1 < _size && get_number((*_graph)[i + 1], "depth") > _depth)
+                    _v.has_children = true;
+            }
+        }
+    }
+
+    if(m_entries.empty())
+    {
+        errprintf(0, "profile '%s' does not contain any timing data\n",
+                  _filename.c_str());
+        return false;
+    }
+
+    select_entries();
+
+    size_t _nselected = 0;
+    size_t _nrejected = 0;
+    for(const auto& itr : m_entries)
+    {
+        if(itr.second.selection == PROFILE_SELECTED) ++_nselected;
+        if(itr.second.selection == PROFILE_REJECTED) ++_nrejected;
+    }
+
+    verbprintf(0,
+               "Loaded %zu functions from profile '%s' (runtime: %.3f sec, selected: "
+               "%zu, rejected: %zu, overhead budget: %.2f%%, probe cost: %.1f nsec)...\n",
+               m_entries.size(), _filename.c_str(), m_total, _nselected, _nrejected,
+               profile_budget, profile_probe_cost);
+
+    return true;
+}
+
+void
+instrumentation_profile::select_entries()
+{
+    const auto _budget = profile_budget / 100.0;
+    const auto _probe  = profile_probe_cost * 1.0e-9;
+
+    // predicted probe cost relative to the runtime of the function
+    auto _candidates = std::vector<std::pair<double, entry*>>{};
+    for(auto& itr : m_entries)
+    {
+        auto& _v = itr.second;
+        if(_v.calls == 0 || _v.inclusive <= 0.0) continue;
+
+        auto _cost     = _probe * _v.calls;
+        auto _overhead = _cost / _v.inclusive;
+        if(_overhead > _budget)
+        {
+            _v.selection = PROFILE_REJECTED;
+            _v.reason    = "profile-overhead";
+        }
+        else
+        {
+            _candidates.emplace_back(_cost, &_v);
+        }
+
+        verbprintf(2,
+                   "[profile] %-60s :: calls = %zu, inclusive = %.3e sec, predicted "
+                   "overhead = %s\n",
+                   itr.first.c_str(), static_cast<size_t>(_v.calls), _v.inclusive,
+                   get_percent(_overhead).c_str());
+    }
+
+    // select the functions with the lowest predicted cost first to maximize the number
+    // of instrumented functions within the budget of the total runtime
+    std::sort(_candidates.begin(), _candidates.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.first < _rhs.first; });
+
+    auto _accum = 0.0;
+    for(auto& itr : _candidates)
+    {
+        _accum += itr.first;
+        if(_accum > _budget * m_total)
+        {
+            itr.second->selection = PROFILE_REJECTED;
+            itr.second->reason    = "profile-budget";
+        }
+        else
+        {
+            itr.second->selection = PROFILE_SELECTED;
+            itr.second->reason    = "profile-selected";
+        }
+    }
+}
+
+instrumentation_profile::selection_t
+instrumentation_profile::select(const std::string& _name, size_t _num_instructions,
+                                bool _has_loops, std::string& _reason) const
+{
+    auto itr = m_entries.find(_name);
+    if(itr == m_entries.end()) return PROFILE_NONE;
+
+    const auto& _v = itr->second;
+    if(_v.selection != PROFILE_NONE)
+    {
+        _reason = _v.reason;
+        return _v.selection;
+    }
+
+    if(_v.samples == 0) return PROFILE_NONE;
+
+    // sampled only: the runtime of a call is not known but a function with loops or
+    // callees is not expected to be a short, frequently called function
+    if(_has_loops || _v.has_children)
+    {
+        _reason = "profile-sampled";
+        return PROFILE_SELECTED;
+    }
+
+    auto _runtime  = instruction_cost * std::max<size_t>(_num_instructions, 1);
+    auto _overhead = (profile_probe_cost * 1.0e-9) / _runtime;
+    if(_overhead > profile_budget / 100.0)
+    {
+        _reason = "profile-sampled-overhead";
+        return PROFILE_REJECTED;
+    }
+
+    _reason = "profile-sampled";
+    return PROFILE_SELECTED;
+}
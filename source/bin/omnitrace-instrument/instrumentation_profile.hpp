@@ -0,0 +1,71 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "fwd.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// per-function call frequency and inclusive time from the timemory JSON output of a
+// previous run (instrumented or sampling). Functions with call counts are selected
+// greedily (lowest predicted probe cost first) until the predicted probe cost exceeds
+// the overhead budget of the total runtime and any function whose predicted probe
+// cost exceeds the budget of its own runtime is rejected. Sampling data does not
+// provide call counts so, for the sampled leaf functions without loops, the runtime
+// of a call is estimated from the number of instructions.
+struct instrumentation_profile
+{
+    enum selection_t : uint8_t
+    {
+        PROFILE_NONE = 0,  // not in the profile
+        PROFILE_SELECTED,
+        PROFILE_REJECTED,
+    };
+
+    struct entry
+    {
+        uint64_t    calls        = 0;  // zero when only sampled
+        uint64_t    samples      = 0;
+        double      inclusive    = 0.0;  // seconds
+        bool        has_children = false;
+        selection_t selection    = PROFILE_NONE;
+        std::string reason       = {};
+    };
+
+    static instrumentation_profile& get();
+
+    bool enabled() const { return !m_entries.empty(); }
+    bool load(const std::string& _filename);
+
+    // selection of the function by name (or signature). Thread-safe after load
+    selection_t select(const std::string& _name, size_t _num_instructions,
+                       bool _has_loops, std::string& _reason) const;
+
+private:
+    void select_entries();
+
+    double                                 m_total   = 0.0;
+    std::unordered_map<std::string, entry> m_entries = {};
+};
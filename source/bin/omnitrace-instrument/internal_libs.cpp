@@ -112,8 +112,7 @@ check_regex_restrictions(const ContainerT<std::string, TailT...>& _names,
                          const regexvec_t&                        _regexes)
 {
     for(const auto& nitr : _names)
-        for(const auto& ritr : _regexes)
-            if(std::regex_search(nitr, ritr)) return true;
+        if(_regexes.search(nitr)) return true;
     return false;
 }
 
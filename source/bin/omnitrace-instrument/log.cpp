@@ -24,6 +24,7 @@
 #include "fwd.hpp"
 
 #include <cmath>
+#include <cstdarg>
 #include <iomanip>
 #include <regex>
 #include <vector>
@@ -32,7 +33,14 @@ namespace color = tim::log::color;
 
 namespace
 {
-std::vector<log_entry> log_entries = {};
+std::vector<log_entry>   log_entries    = {};
+thread_local log_buffer* log_buffer_ptr = nullptr;
+
+void
+write_log_entry(const log_entry& _v)
+{
+    if(log_ofs) *log_ofs << _v.as_string("", "", "") << "\n";
+}
 
 auto
 get_color_regex(std::string _v)
@@ -53,17 +61,13 @@ auto _color_regex = std::regex{ JOIN("", "(", get_color_regex(tim::log::color::i
 log_entry::log_entry(std::string _msg)
 : m_message{ std::move(_msg) }
 , m_backtrace{ tim::get_unw_stack<4, 1>() }
-{
-    if(log_ofs) *log_ofs << as_string("", "", "") << "\n";
-}
+{}
 
 log_entry::log_entry(source_location _loc, std::string _msg)
 : m_location{ _loc }
 , m_message{ std::move(_msg) }
 , m_backtrace{ tim::get_unw_stack<4, 1>() }
-{
-    if(log_ofs) *log_ofs << as_string("", "", "") << "\n";
-}
+{}
 
 std::string
 log_entry::as_string(const char* _color, const char* _src, const char* _end) const
@@ -86,9 +90,71 @@ log_entry::as_string(const char* _color, const char* _src, const char* _end) con
 log_entry&
 log_entry::add_log_entry(log_entry&& _v)
 {
+    if(log_buffer_ptr) return log_buffer_ptr->entries.emplace_back(std::move(_v));
+
+    write_log_entry(_v);
     return log_entries.emplace_back(std::move(_v));
 }
 
+void
+log_buffer::commit()
+{
+    for(auto& itr : entries)
+    {
+        write_log_entry(itr);
+        log_entries.emplace_back(std::move(itr));
+    }
+
+    for(const auto& itr : output)
+    {
+        fputs(itr.second.c_str(), itr.first);
+        fflush(itr.first);
+    }
+
+    entries.clear();
+    output.clear();
+}
+
+scoped_log_buffer::scoped_log_buffer(log_buffer& _v)
+: m_prev{ log_buffer_ptr }
+{
+    log_buffer_ptr = &_v;
+}
+
+scoped_log_buffer::~scoped_log_buffer() { log_buffer_ptr = m_prev; }
+
+log_buffer*
+scoped_log_buffer::get()
+{
+    return log_buffer_ptr;
+}
+
+void
+log_printf(FILE* _os, const char* _fmt, ...)
+{
+    va_list _args;
+    va_start(_args, _fmt);
+    if(log_buffer_ptr)
+    {
+        va_list _args_n;
+        va_copy(_args_n, _args);
+        auto _n = vsnprintf(nullptr, 0, _fmt, _args_n);
+        va_end(_args_n);
+        if(_n > 0)
+        {
+            auto _msg = std::string(_n + 1, '\0');
+            vsnprintf(_msg.data(), _msg.size(), _fmt, _args);
+            _msg.resize(_n);
+            log_buffer_ptr->output.emplace_back(_os, std::move(_msg));
+        }
+    }
+    else
+    {
+        vfprintf(_os, _fmt, _args);
+    }
+    va_end(_args);
+}
+
 void
 print_log_entries(std::ostream& _os, int64_t _count,
                   const std::function<bool(const log_entry&)>& _condition,
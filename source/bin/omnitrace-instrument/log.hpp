@@ -26,10 +26,14 @@
 #include <timemory/utility/backtrace.hpp>
 #include <timemory/utility/join.hpp>
 
+#include <cstdio>
+#include <deque>
 #include <iosfwd>
 #include <ostream>
 #include <string>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #if !defined(JOIN)
 #    define JOIN(...) ::timemory::join::join(__VA_ARGS__)
@@ -81,6 +85,37 @@ private:
                                   bool);
 };
 
+// holds the log entries and the console output generated by a thread while a
+// scoped_log_buffer is alive. Used by the concurrent analysis of the module functions
+// so that the log is committed in the same order as a serial analysis
+struct log_buffer
+{
+    void commit();
+
+    std::deque<log_entry>                      entries = {};
+    std::vector<std::pair<FILE*, std::string>> output  = {};
+};
+
+struct scoped_log_buffer
+{
+    explicit scoped_log_buffer(log_buffer&);
+    ~scoped_log_buffer();
+
+    scoped_log_buffer(const scoped_log_buffer&) = delete;
+    scoped_log_buffer(scoped_log_buffer&&)      = delete;
+    scoped_log_buffer& operator=(const scoped_log_buffer&) = delete;
+    scoped_log_buffer& operator=(scoped_log_buffer&&) = delete;
+
+    static log_buffer* get();
+
+private:
+    log_buffer* m_prev = nullptr;
+};
+
+// prints to the stream or, when the thread has a log buffer, appends to the buffer
+void
+log_printf(FILE*, const char*, ...) __attribute__((format(printf, 2, 3)));
+
 #define OMNITRACE_ADD_LOG_ENTRY(...)                                                     \
     log_entry::add_log_entry(                                                            \
         { log_entry::source_location{ __FUNCTION__, __FILE__, __LINE__ },                \
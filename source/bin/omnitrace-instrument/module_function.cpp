@@ -23,6 +23,7 @@
 #include "module_function.hpp"
 #include "InstructionCategories.h"
 #include "fwd.hpp"
+#include "instrumentation_profile.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
 #include "omnitrace-instrument.hpp"
@@ -56,11 +57,11 @@ module_function::update_width(const module_function& rhs)
     get_width()[2] = std::max<size_t>(get_width()[2], rhs.signature.get().length());
 }
 
-module_function::module_function(module_t* mod, procedure_t* proc)
+module_function::module_function(module_t* mod, procedure_t* proc, bool analyze)
 : module{ mod }
 , function{ proc }
 , symtab_function{ proc->isInstrumentable() ? get_symtab_function(proc) : nullptr }
-, flow_graph{ proc->getCFG() }
+, flow_graph{ (analyze) ? proc->getCFG() : nullptr }
 , module_name{ get_name(module) }
 , function_name{ get_name(function) }
 {
@@ -87,7 +88,7 @@ module_function::module_function(module_t* mod, procedure_t* proc)
     for(int i = 0; i <= instruction_category_t::c_NoCategory; ++i)
         instruction_types[static_cast<instruction_category_t>(i)] = 0;
 
-    if(function->isInstrumentable())
+    if(function->isInstrumentable() && analyze)
     {
         // this information is potentially not available and
         // appears to be the cause of a segfault in testing
@@ -202,6 +203,32 @@ module_function::should_coverage_instrument() const
     return true;
 }
 
+bool
+module_function::should_count_instrument() const
+{
+    // hard constraints
+    if(!is_instrumentable()) return false;
+    if(!can_instrument_entry()) return false;
+    if(is_internal_constrained()) return false;
+    if(is_module_constrained()) return false;
+    if(is_routine_constrained()) return false;
+
+    // user selection
+    if(is_user_excluded()) return false;
+
+    if(is_overlapping_constrained()) return false;
+    if(is_entry_trap_constrained()) return false;
+
+    // only the functions which are considered too small for instrumentation
+    if(is_address_range_constrained() || is_num_instructions_constrained())
+    {
+        messages.emplace_back(2, "Counting", "function", "call-counter", function_name);
+        return true;
+    }
+
+    return false;
+}
+
 bool
 module_function::should_instrument(bool coverage) const
 {
@@ -244,6 +271,7 @@ module_function::should_instrument(bool coverage) const
     {
         if(is_linkage_constrained()) return false;
         if(is_visibility_constrained()) return false;
+        if(auto _profiled = get_profile_selection()) return *_profiled;
     }
 
     if(is_address_range_constrained()) return false;
@@ -270,10 +298,7 @@ namespace
 bool
 check_regex_restrictions(const std::string& _name, const regexvec_t& _regexes)
 {
-    // NOLINTNEXTLINE
-    for(auto& itr : _regexes)
-        if(std::regex_search(_name, itr)) return true;
-    return false;
+    return _regexes.search(_name);
 }
 }  // namespace
 
@@ -781,6 +806,36 @@ module_function::is_linkage_constrained() const
             enabled_linkage.find(_linkage) == enabled_linkage.end());
 }
 
+std::optional<bool>
+module_function::get_profile_selection() const
+{
+    const auto& _profile = instrumentation_profile::get();
+    if(!_profile.enabled()) return std::nullopt;
+
+    auto _reason    = std::string{};
+    auto _name      = function_name;
+    auto _has_loops = !loop_blocks.empty();
+    auto _v         = _profile.select(_name, num_instructions, _has_loops, _reason);
+    if(_v == instrumentation_profile::PROFILE_NONE)
+    {
+        _name = signature.get();
+        _v    = _profile.select(_name, num_instructions, _has_loops, _reason);
+    }
+
+    if(_v == instrumentation_profile::PROFILE_SELECTED)
+    {
+        messages.emplace_back(2, "Forcing", "function", _reason, _name);
+        return true;
+    }
+    else if(_v == instrumentation_profile::PROFILE_REJECTED)
+    {
+        messages.emplace_back(2, "Skipping", "function", _reason, _name);
+        return false;
+    }
+
+    return std::nullopt;
+}
+
 bool
 module_function::can_instrument_entry() const
 {
@@ -882,6 +937,7 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     for(size_t i = 0; i < loop_blocks.size(); ++i)
     {
         if(!loop_level_instr) continue;
+        if(loop_count_instr) continue;  // see register_loop_counters
         if(!flow_graph) continue;
 
         auto* itr             = loop_blocks.at(i);
@@ -936,37 +992,41 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     return _count;
 }
 
-void
+size_t
 module_function::register_source(address_space_t* _addr_space, procedure_t* _entr_trace,
-                                 const std::vector<point_t*>& _entr_points) const
+                                 const std::vector<point_t*>& _entr_points,
+                                 size_t                       _index) const
 {
+    size_t _count = 0;
     switch(coverage_mode)
     {
         case CODECOV_FUNCTION:
         {
-            auto _name = signature.get_coverage(false);
-            auto _trace_entr =
-                omnitrace_call_expr(signature.m_file, signature.m_name,
-                                    signature.m_row.first, start_address, _name);
-            auto _entr = _trace_entr.get(_entr_trace);
+            auto _name       = signature.get_coverage(false);
+            auto _trace_entr = omnitrace_call_expr(signature.m_file, signature.m_name,
+                                                   signature.m_row.first, start_address,
+                                                   _name, _index);
+            auto _entr       = _trace_entr.get(_entr_trace);
 
             if(insert_instr(_addr_space, _entr_points, _entr, BPatch_entry))
             {
                 messages.emplace_back(1, "Code Coverage", "function", "no-constraint",
                                       _name);
             }
+            _count = 1;
             break;
         }
         case CODECOV_BASIC_BLOCK:
         {
+            // the order of the basic blocks is the same in register_coverage
             for(auto&& itr : get_basic_block_file_line_info(module, function))
             {
                 auto  _start_addr = itr.second.start_address;
                 auto& _signature  = itr.second.signature;
                 auto  _name       = _signature.get_coverage(true);
-                auto  _trace_entr =
-                    omnitrace_call_expr(_signature.m_file, _signature.m_name,
-                                        _signature.m_row.first, _start_addr, _name);
+                auto  _trace_entr = omnitrace_call_expr(
+                    _signature.m_file, _signature.m_name, _signature.m_row.first,
+                    _start_addr, _name, _index + _count);
                 auto _entr = _trace_entr.get(_entr_trace);
 
                 if(insert_instr(_addr_space, _entr_points, _entr, BPatch_entry))
@@ -974,25 +1034,132 @@ module_function::register_source(address_space_t* _addr_space, procedure_t* _ent
                     messages.emplace_back(1, "Code Coverage", "basic_block",
                                           "no-constraint", _name);
                 }
+                ++_count;
             }
             break;
         }
         case CODECOV_NONE: break;
     }
+    return _count;
+}
+
+bool
+module_function::register_call_counter(
+    address_space_t* _addr_space, procedure_t* _reg_func,
+    const std::vector<point_t*>& _main_entr_points) const
+{
+    if(!_addr_space || !_reg_func) return false;
+
+    auto* _type = _addr_space->getImage()->findType("unsigned long");
+    if(!_type) return false;
+
+    // one counter per function in the address space of the mutatee
+    auto* _counter = _addr_space->malloc(
+        *_type, TIMEMORY_JOIN("", "omnitrace_call_counter_0x", std::hex, start_address));
+    if(!_counter) return false;
+
+    // counter = counter + 1 (not atomic: concurrent calls may be undercounted)
+    auto _incr = std::make_shared<snippet_t>(BPatch_arithExpr{
+        BPatch_assign, *_counter,
+        BPatch_arithExpr{ BPatch_plus, *_counter, const_expr_t{ 1 } } });
+
+    if(!insert_instr(_addr_space, function, _incr, BPatch_entry)) return false;
+
+    auto _file = const_expr_t{ signature.m_file.c_str() };
+    auto _func = const_expr_t{ signature.m_name.c_str() };
+    auto _addr = BPatch_addressOfExpr{ *_counter };
+    auto _reg  = std::make_shared<snippet_t>(
+        call_expr_t{ *_reg_func, snippet_vec_t{ &_file, &_func, &_addr } });
+
+    if(!insert_instr(_addr_space, _main_entr_points, _reg, BPatch_entry)) return false;
+
+    messages.emplace_back(1, "Counting", "function", "no-constraint",
+                          signature.get_coverage(false));
+    return true;
+}
+
+size_t
+module_function::register_loop_counters(
+    address_space_t* _addr_space, procedure_t* _reg_func,
+    const std::vector<point_t*>& _main_entr_points) const
+{
+    if(!_addr_space || !_reg_func || !flow_graph || loop_blocks.empty()) return 0;
+
+    auto* _type = _addr_space->getImage()->findType("unsigned long");
+    if(!_type) return 0;
+
+    size_t _count = 0;
+    for(size_t i = 0; i < loop_blocks.size(); ++i)
+    {
+        auto* itr = loop_blocks.at(i);
+        auto  _lname =
+            get_loop_file_line_info(module, function, flow_graph, itr).set_loop_number(i);
+        auto _name = _lname.get();
+
+        // the loop entry is visited once per execution of the loop and the start of
+        // an iteration once per trip
+        auto* _entr_points = flow_graph->findLoopInstPoints(BPatch_locLoopEntry, itr);
+        auto* _iter_points = flow_graph->findLoopInstPoints(BPatch_locLoopStartIter, itr);
+        if(!_entr_points || _entr_points->empty() || !_iter_points ||
+           _iter_points->empty())
+        {
+            messages.emplace_back(3, "Skipping", "function-loop",
+                                  "no-instrumentable-loop-counter-point", _name);
+            continue;
+        }
+
+        // one pair of counters per loop in the address space of the mutatee
+        auto  _suffix  = TIMEMORY_JOIN("", std::hex, start_address, "_", std::dec, i);
+        auto* _entries = _addr_space->malloc(
+            *_type, TIMEMORY_JOIN("", "omnitrace_loop_entries_0x", _suffix));
+        auto* _trips = _addr_space->malloc(
+            *_type, TIMEMORY_JOIN("", "omnitrace_loop_trips_0x", _suffix));
+        if(!_entries || !_trips) continue;
+
+        // counter = counter + 1 (not atomic: concurrent loops may be undercounted)
+        auto _incr = [](BPatch_variableExpr* _counter) {
+            return std::make_shared<snippet_t>(BPatch_arithExpr{
+                BPatch_assign, *_counter,
+                BPatch_arithExpr{ BPatch_plus, *_counter, const_expr_t{ 1 } } });
+        };
+
+        if(!insert_instr(_addr_space, *_entr_points, _incr(_entries), BPatch_entry,
+                         instr_loop_traps) ||
+           !insert_instr(_addr_space, *_iter_points, _incr(_trips), BPatch_entry,
+                         instr_loop_traps))
+        {
+            messages.emplace_back(3, "Skipping", "function-loop",
+                                  "loop-counter-trap-instrumentation", _name);
+            continue;
+        }
+
+        auto _file  = const_expr_t{ signature.m_file.c_str() };
+        auto _loop  = const_expr_t{ _name.c_str() };
+        auto _eaddr = BPatch_addressOfExpr{ *_entries };
+        auto _taddr = BPatch_addressOfExpr{ *_trips };
+        auto _reg   = std::make_shared<snippet_t>(call_expr_t{
+            *_reg_func, snippet_vec_t{ &_file, &_loop, &_eaddr, &_taddr } });
+
+        if(!insert_instr(_addr_space, _main_entr_points, _reg, BPatch_entry)) continue;
+
+        messages.emplace_back(1, "Counting", "function-loop", "no-constraint", _name);
+        ++_count;
+    }
+
+    return _count;
 }
 
 std::pair<size_t, size_t>
 module_function::register_coverage(address_space_t* _addr_space,
-                                   procedure_t*     _entr_trace) const
+                                   procedure_t* _entr_trace, size_t _index) const
 {
     std::pair<size_t, size_t> _count = { 0, 0 };
     switch(coverage_mode)
     {
         case CODECOV_FUNCTION:
         {
-            auto _trace_entr =
-                omnitrace_call_expr(signature.m_file, signature.m_name, start_address);
-            auto _entr = _trace_entr.get(_entr_trace);
+            auto _trace_entr = omnitrace_call_expr(_index);
+            auto _entr       = _trace_entr.get(_entr_trace);
 
             if(insert_instr(_addr_space, function, _entr, BPatch_entry))
             {
@@ -1006,10 +1173,8 @@ module_function::register_coverage(address_space_t* _addr_space,
         {
             for(auto&& itr : get_basic_block_file_line_info(module, function))
             {
-                auto  _start_addr = itr.second.start_address;
                 auto& _signature  = itr.second.signature;
-                auto  _trace_entr = omnitrace_call_expr(_signature.m_file,
-                                                       _signature.m_name, _start_addr);
+                auto  _trace_entr = omnitrace_call_expr(_index++);
                 auto  _entr       = _trace_entr.get(_entr_trace);
 
                 if(insert_instr(_addr_space, _entr, BPatch_entry, itr.first))
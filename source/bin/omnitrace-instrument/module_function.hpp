@@ -28,6 +28,7 @@
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/tpls/cereal/cereal/cereal.hpp>
 
+#include <optional>
 #include <sstream>
 #include <string>
 #include <tuple>
@@ -48,13 +49,26 @@ struct module_function
 
     TIMEMORY_DEFAULT_OBJECT(module_function)
 
-    module_function(module_t* mod, procedure_t* proc);
+    // when analyze is false, the CFG, loops, and instructions are not extracted
+    module_function(module_t* mod, procedure_t* proc, bool analyze = true);
 
-    // code coverage
-    void register_source(address_space_t* _addr_space, procedure_t* _entr_trace,
-                         const std::vector<point_t*>&) const;
+    // code coverage. Each function or basic block is identified at runtime by a dense
+    // index starting at _index. register_source returns the number of indices used
+    size_t register_source(address_space_t* _addr_space, procedure_t* _entr_trace,
+                           const std::vector<point_t*>&, size_t _index) const;
     std::pair<size_t, size_t> register_coverage(address_space_t* _addr_space,
-                                                procedure_t*     _entr_trace) const;
+                                                procedure_t*     _entr_trace,
+                                                size_t           _index) const;
+
+    // call counter (inline increment, registered at the main entry points)
+    bool register_call_counter(address_space_t* _addr_space, procedure_t* _reg_func,
+                               const std::vector<point_t*>& _main_entr_points) const;
+
+    // loop counters (--loop-mode count): inline increments at the entry of each outer
+    // loop and at the start of each iteration, registered at the main entry points.
+    // Returns the number of counted loops
+    size_t register_loop_counters(address_space_t* _addr_space, procedure_t* _reg_func,
+                                  const std::vector<point_t*>& _main_entr_points) const;
 
     // instrumentation
     std::pair<size_t, size_t> operator()(address_space_t* _addr_space,
@@ -64,6 +78,7 @@ struct module_function
     // applies logic for all "is_*" and "can_*" checks below
     bool should_instrument() const;
     bool should_coverage_instrument() const;
+    bool should_count_instrument() const;  // excluded by size heuristics only
 
     // hard constraints
     bool is_instrumentable() const;        // checks whether can instrument
@@ -96,9 +111,14 @@ struct module_function
     bool is_visibility_constrained() const;
     bool is_linkage_constrained() const;
 
+    // profile-guided selection (when the function is in the profile), applied in lieu
+    // of the address range and # instruction constraints
+    std::optional<bool> get_profile_selection() const;
+
     size_t                                      start_address     = 0;
     uint64_t                                    address_range     = 0;
     uint64_t                                    num_instructions  = 0;
+    uint64_t                                    plan_key          = 0;
     module_t*                                   module            = nullptr;
     procedure_t*                                function          = nullptr;
     symtab_func_t*                              symtab_function   = nullptr;
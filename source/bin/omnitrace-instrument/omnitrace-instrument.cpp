@@ -25,6 +25,8 @@
 #include "common/join.hpp"
 #include "dl/dl.hpp"
 #include "fwd.hpp"
+#include "instrumentation_plan.hpp"
+#include "instrumentation_profile.hpp"
 #include "internal_libs.hpp"
 #include "log.hpp"
 
@@ -43,6 +45,7 @@
 #include <timemory/utility/signals.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <csignal>
 #include <cstddef>
@@ -50,9 +53,11 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <iomanip>
 #include <iterator>
 #include <map>
+#include <random>
 #include <regex>
 #include <stdexcept>
 #include <string>
@@ -97,6 +102,7 @@ bool   use_file_info                = false;
 bool   use_line_info                = false;
 bool   allow_overlapping            = false;
 bool   loop_level_instr             = false;
+bool   loop_count_instr             = false;
 bool   instr_dynamic_callsites      = false;
 bool   instr_traps                  = false;
 bool   instr_loop_traps             = false;
@@ -105,12 +111,15 @@ size_t min_address_range            = get_default_min_address_range();  // 4096
 size_t min_loop_address_range       = get_default_min_address_range();  // 4096
 size_t min_instructions             = get_default_min_instructions();   // 1024
 size_t min_loop_instructions        = get_default_min_instructions();   // 1024
+double profile_budget               = 5.0;                              // percent
+double profile_probe_cost           = 250.0;                            // nsec
 bool   werror                       = false;
 bool   debug_print                  = false;
 bool   instr_print                  = false;
 bool   simulate                     = false;
 bool   include_uninstr              = false;
 bool   include_internal_linked_libs = false;
+bool   instr_call_counts            = false;
 int    verbose_level   = tim::get_env<int>("OMNITRACE_VERBOSE_INSTRUMENT", 0);
 int    num_log_entries = tim::get_env<int>(
     "OMNITRACE_LOG_COUNT", tim::get_env<bool>("OMNITRACE_CI", false) ? 20 : 50);
@@ -128,6 +137,7 @@ snippet_vec_t    fini_names                    = {};
 fmodset_t        available_module_functions    = {};
 fmodset_t        instrumented_module_functions = {};
 fmodset_t        coverage_module_functions     = {};
+fmodset_t        counted_module_functions      = {};
 fmodset_t        overlapping_module_functions  = {};
 fmodset_t        excluded_module_functions     = {};
 fixed_modset_t   fixed_module_functions        = {};
@@ -165,6 +175,10 @@ bool                                       use_mpi              = false;
 bool                                       is_static_exe        = false;
 bool                                       force_config         = false;
 size_t                                     batch_size           = 50;
+size_t                                     analysis_jobs        = 1;
+std::string                                plan_file            = {};
+std::string                                attach_mode          = "full";
+std::string                                profile_file         = {};
 strset_t                                   extra_libs           = {};
 std::vector<std::pair<uint64_t, string_t>> hash_ids             = {};
 std::map<string_t, bool>                   use_stubs            = {};
@@ -297,6 +311,54 @@ find(const std::string& itr, const strvec_t& _data)
     return std::any_of(_data.begin(), _data.end(),
                        [itr](const auto& _v) { return (itr == _v); });
 }
+
+// invokes the functor for every index in [0, N) using up to analysis_jobs threads.
+// The log entries and console output of each index are buffered and committed in
+// index order and the exception of the lowest index is rethrown so that the analysis
+// is deterministic regardless of the number of threads
+template <typename FuncT>
+void
+parallel_analysis(size_t _n, FuncT&& _func)
+{
+    auto _nthreads = std::min<size_t>(std::max<size_t>(analysis_jobs, 1), _n);
+    if(_nthreads <= 1)
+    {
+        for(size_t i = 0; i < _n; ++i)
+            _func(i);
+        return;
+    }
+
+    auto _logs   = std::vector<log_buffer>(_n);
+    auto _errors = std::vector<std::exception_ptr>(_n);
+    auto _next   = std::atomic<size_t>{ 0 };
+    auto _worker = [&]() {
+        for(size_t i = _next++; i < _n; i = _next++)
+        {
+            auto _scoped = scoped_log_buffer{ _logs.at(i) };
+            try
+            {
+                _func(i);
+            } catch(...)
+            {
+                _errors.at(i) = std::current_exception();
+            }
+        }
+    };
+
+    auto _threads = std::vector<std::thread>{};
+    _threads.reserve(_nthreads - 1);
+    for(size_t i = 1; i < _nthreads; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+    for(auto& itr : _threads)
+        itr.join();
+
+    for(size_t i = 0; i < _n; ++i)
+    {
+        _logs.at(i).commit();
+        if(_errors.at(i)) std::rethrow_exception(_errors.at(i));
+    }
+}
 }  // namespace
 
 //======================================================================================//
@@ -386,6 +448,7 @@ main(int argc, char** argv)
         { &available_module_functions, false },
         { &instrumented_module_functions, false },
         { &coverage_module_functions, false },
+        { &counted_module_functions, false },
         { &excluded_module_functions, false },
         { &overlapping_module_functions, false },
     };
@@ -608,10 +671,34 @@ main(int argc, char** argv)
             binary_rewrite = true;
             outfile        = p.get<string_t>("output");
         });
+    parser
+        .add_argument({ "--plan" },
+                      "Instrumentation plan file. The decisions recorded in the plan are "
+                      "reused for the unchanged functions (same bytes, symbol, and "
+                      "module) when the options are identical and the plan is updated "
+                      "with the decisions of this invocation. Intended for repeated "
+                      "binary rewrites of the same application")
+        .count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) { plan_file = p.get<string_t>("plan"); });
     parser.add_argument({ "-p", "--pid" }, "Connect to running process")
         .dtype("int")
         .count(1)
         .action([&_pid](parser_t& p) { _pid = p.get<int>("pid"); });
+    parser
+        .add_argument(
+            { "--attach-mode" },
+            "How long the process is stopped when connecting to a running process. "
+            "'full' stops the process for the whole analysis and insertion. 'staged' "
+            "resumes the process while the binary is analyzed and only stops it to "
+            "load the instrumentation libraries and insert the snippets (combine with "
+            "--plan, e.g. from a prior binary rewrite of the same executable, to skip "
+            "the heuristics). 'sampling' does not patch any code: the instrumentation "
+            "library is loaded and the sampler is started")
+        .choices({ "full", "staged", "sampling" })
+        .count(1)
+        .dtype("string")
+        .action([](parser_t& p) { attach_mode = p.get<string_t>("attach-mode"); });
     parser
         .add_argument({ "-M", "--mode" },
                       "Instrumentation mode. 'trace' mode instruments the selected "
@@ -696,6 +783,7 @@ main(int argc, char** argv)
                 { "available_module_functions", &available_module_functions },
                 { "instrumented_module_functions", &instrumented_module_functions },
                 { "coverage_module_functions", &coverage_module_functions },
+                { "counted_module_functions", &counted_module_functions },
                 { "excluded_module_functions", &excluded_module_functions },
                 { "overlapping_module_functions", &overlapping_module_functions },
             };
@@ -909,6 +997,20 @@ main(int argc, char** argv)
         .dtype("boolean")
         .max_count(1)
         .action([](parser_t& p) { loop_level_instr = p.get<bool>("instrument-loops"); });
+    parser
+        .add_argument({ "--loop-mode" },
+                      "Instrumentation of the loops (implies --instrument-loops). "
+                      "\"region\" == a region is pushed and popped at the entry and exit "
+                      "of each loop, \"count\" == inline snippets (no function calls) "
+                      "increment counters at the entry of each loop and at the start of "
+                      "each iteration. The average trip counts of the counted loops are "
+                      "reported during finalization")
+        .max_count(1)
+        .choices({ "region", "count" })
+        .action([](parser_t& p) {
+            loop_level_instr = true;
+            loop_count_instr = (p.get<std::string>("loop-mode") == "count");
+        });
     parser
         .add_argument({ "-i", "--min-instructions" },
                       "If the number of instructions in a function is less than this "
@@ -943,6 +1045,34 @@ main(int argc, char** argv)
         .action([](parser_t& p) {
             min_loop_address_range = p.get<size_t>("min-address-range-loop");
         });
+    parser
+        .add_argument({ "--profile" },
+                      "Timemory JSON output (e.g. wall_clock.json or "
+                      "sampling_wall_clock.json) of a previous run. The call frequency "
+                      "and inclusive time of the functions in the profile are used to "
+                      "select the functions which maximize coverage within the overhead "
+                      "budget (in lieu of the address range and instruction count "
+                      "heuristics). Functions which are not in the profile are subject "
+                      "to the usual heuristics")
+        .count(1)
+        .dtype("filepath")
+        .action([](parser_t& p) { profile_file = p.get<string_t>("profile"); });
+    parser
+        .add_argument({ "--profile-budget" },
+                      "Maximum predicted instrumentation overhead (in percent) of both "
+                      "the total runtime and the runtime of any function in the profile")
+        .count(1)
+        .dtype("double")
+        .action([](parser_t& p) { profile_budget = p.get<double>("profile-budget"); });
+    parser
+        .add_argument({ "--profile-probe-cost" },
+                      "Predicted cost (in nanoseconds) of the instrumentation of one "
+                      "call of a function (entry and exit)")
+        .count(1)
+        .dtype("double")
+        .action([](parser_t& p) {
+            profile_probe_cost = p.get<double>("profile-probe-cost");
+        });
     parser
         .add_argument(
             { "--coverage" },
@@ -970,6 +1100,15 @@ main(int argc, char** argv)
         .action([](parser_t& p) {
             instr_dynamic_callsites = p.get<bool>("dynamic-callsites");
         });
+    parser
+        .add_argument({ "--call-counts" },
+                      "Insert an inline snippet which increments a call counter (no "
+                      "function call) into the functions which are excluded from "
+                      "instrumentation by the instruction count and address range "
+                      "heuristics. The call counts are reported during finalization")
+        .max_count(1)
+        .dtype("boolean")
+        .action([](parser_t& p) { instr_call_counts = p.get<bool>("call-counts"); });
     parser
         .add_argument(
             { "--traps" },
@@ -1026,6 +1165,17 @@ main(int argc, char** argv)
         .count(1)
         .dtype("int")
         .action([](parser_t& p) { batch_size = p.get<size_t>("batch-size"); });
+    parser
+        .add_argument({ "-j", "--jobs" },
+                      "Number of threads for the analysis of the module functions (CFG, "
+                      "loops, instructions, line info, and the instrumentation "
+                      "heuristics) after Dyninst has parsed the binary. Snippet "
+                      "insertion is always serial")
+        .count(1)
+        .dtype("int")
+        .action([](parser_t& p) {
+            analysis_jobs = std::max<size_t>(p.get<size_t>("jobs"), 1);
+        });
     parser.add_argument({ "--dyninst-rt" }, "Path(s) to the dyninstAPI_RT library")
         .dtype("filepath")
         .min_count(1)
@@ -1112,6 +1262,21 @@ main(int argc, char** argv)
         }
     };
 
+    if(attach_mode != "full" && _pid < 0)
+    {
+        verbprintf(0, "Warning! --attach-mode=%s is ignored without --pid\n",
+                   attach_mode.c_str());
+        attach_mode = "full";
+    }
+    else if(attach_mode == "sampling")
+    {
+        // nothing is patched so there is nothing to analyze
+        instr_mode        = "sampling";
+        coverage_mode     = CODECOV_NONE;
+        instr_call_counts = false;
+        parse_all_modules = false;
+    }
+
     // if instructions was specified and address range was not
     _handle_heuristics("min-instructions", "min-address-range", min_address_range, 0,
                        "minimum address range", true);
@@ -1257,7 +1422,7 @@ main(int argc, char** argv)
                                              regex_expr, "\" to regex_array@",
                                              &regex_array);
             if(!regex_expr.empty())
-                regex_array.emplace_back(std::regex(regex_expr, regex_opts));
+                regex_array.emplace_back(regex_expr, regex_opts);
         };
 
         add_regex(func_include, tim::get_env<string_t>("OMNITRACE_REGEX_INCLUDE", ""));
@@ -1411,9 +1576,31 @@ main(int argc, char** argv)
     env_vars.emplace_back(TIMEMORY_JOIN('=', "OMNITRACE_USE_CODE_COVERAGE",
                                         (coverage_mode != CODECOV_NONE) ? "ON" : "OFF"));
 
+    // in the staged attach modes, the process only stops to load the libraries and to
+    // insert the snippets and the total duration it was stopped is reported
+    using attach_clock_t = std::chrono::steady_clock;
+    auto _staged_attach  = (_pid >= 0 && attach_mode != "full");
+    auto _attach_paused  = attach_clock_t::duration{};
+    auto _attach_stopped = attach_clock_t::now();
+
     addr_space = omnitrace_get_address_space(bpatch, _cmdc, _cmdv, env_vars,
                                              binary_rewrite, _pid, mutname);
 
+    auto* _attached_proc =
+        (_staged_attach) ? dynamic_cast<process_t*>(addr_space) : nullptr;
+    auto _stop_attached = [&]() {
+        if(!_attached_proc || _attached_proc->isStopped()) return;
+        verbprintf(2, "Stopping process %i...\n", _pid);
+        _attached_proc->stopExecution();
+        _attach_stopped = attach_clock_t::now();
+    };
+    auto _resume_attached = [&]() {
+        if(!_attached_proc || !_attached_proc->isStopped()) return;
+        _attach_paused += (attach_clock_t::now() - _attach_stopped);
+        verbprintf(2, "Resuming process %i...\n", _pid);
+        _attached_proc->continueExecution();
+    };
+
     // addr_space->allowTraps(instr_traps);
 
     if(!addr_space)
@@ -1440,16 +1627,26 @@ main(int argc, char** argv)
     process_t*     app_thread = nullptr;
     binary_edit_t* app_binary = nullptr;
 
+    // the image is parsed from the files on disk so the process can run meanwhile
+    _resume_attached();
+
     // get image
     verbprintf(1, "Getting the address space image, modules, and procedures...\n");
     image_t*                   app_image     = addr_space->getImage();
     std::vector<module_t*>*    app_modules   = app_image->getModules();
-    std::vector<procedure_t*>* app_functions = app_image->getProcedures(include_uninstr);
+    std::vector<procedure_t*>* app_functions =
+        (attach_mode == "sampling") ? nullptr : app_image->getProcedures(include_uninstr);
     std::set<module_t*>        modules       = {};
     std::set<procedure_t*>     functions     = {};
 
     if(app_modules) process_modules(*app_modules);
 
+    if(!profile_file.empty()) instrumentation_profile::get().load(profile_file);
+
+    if(!plan_file.empty())
+        instrumentation_plan::get().load(
+            plan_file, instrumentation_plan::get_options_hash(_argc, _argv));
+
     //----------------------------------------------------------------------------------//
     //
     //  Generate a log of all the available procedures and modules
@@ -1461,6 +1658,20 @@ main(int argc, char** argv)
         if(!fixed_module_functions.at(&_module_funcs)) _module_funcs.emplace(_v);
     };
 
+    // the analysis of the functions which the instrumentation plan recorded as neither
+    // instrumented nor coverage instrumented is skipped
+    auto _make_module_function = [](module_t* _mod, procedure_t* _proc) {
+        auto& _plan = instrumentation_plan::get();
+        auto  _key =
+            (_plan.enabled()) ? instrumentation_plan::get_function_hash(_mod, _proc) : 0;
+        const auto* _planned = _plan.find(_key);
+        auto        _analyze = (!_planned || _planned->requires_analysis());
+        auto        _v       = module_function{ _mod, _proc, _analyze };
+        _v.plan_key          = _key;
+        if(!_analyze) _v.num_instructions = _planned->num_instructions;
+        return _v;
+    };
+
     auto _add_overlapping = [](module_t* mitr, procedure_t* pitr) {
         OMNITRACE_ADD_LOG_ENTRY("Checking if procedure", get_name(pitr), "in module",
                                 get_name(mitr), "is overlapping");
@@ -1493,19 +1704,27 @@ main(int argc, char** argv)
         }
         verbprintf(2, "Adding %zu procedures found in the app image...\n",
                    functions.size());
+        auto _procs = std::vector<procedure_t*>{};
         for(auto* itr : functions)
         {
             if(itr->isInstrumentable() || (simulate && include_uninstr))
-            {
-                module_t* mod    = itr->getModule();
-                auto      _modfn = module_function{ mod, itr };
-                module_names.insert(_modfn.module_name);
-                _insert_module_function(available_module_functions, _modfn);
-                _add_overlapping(mod, itr);
-            }
+                _procs.emplace_back(itr);
+        }
+
+        auto _modfns = std::vector<module_function>(_procs.size());
+        parallel_analysis(_procs.size(), [&](size_t i) {
+            _modfns.at(i) =
+                _make_module_function(_procs.at(i)->getModule(), _procs.at(i));
+        });
+
+        for(size_t i = 0; i < _procs.size(); ++i)
+        {
+            module_names.insert(_modfns.at(i).module_name);
+            _insert_module_function(available_module_functions, _modfns.at(i));
+            _add_overlapping(_procs.at(i)->getModule(), _procs.at(i));
         }
     }
-    else
+    else if(attach_mode != "sampling")
     {
         verbprintf(
             0, "Warning! No functions in application. Enabling parsing all modules...\n");
@@ -1520,6 +1739,7 @@ main(int argc, char** argv)
         verbprintf(2,
                    "Adding the procedures from %zu modules found in the app image...\n",
                    modules.size());
+        auto _procs = std::vector<std::pair<module_t*, procedure_t*>>{};
         for(auto* itr : modules)
         {
             auto* procedures = itr->getProcedures(include_uninstr);
@@ -1532,13 +1752,23 @@ main(int argc, char** argv)
                     if(!pitr->isInstrumentable() && !simulate && !include_uninstr)
                         continue;
                     functions.emplace(pitr);
-                    auto _modfn = module_function{ itr, pitr };
-                    module_names.insert(_modfn.module_name);
-                    _insert_module_function(available_module_functions, _modfn);
-                    _add_overlapping(itr, pitr);
+                    _procs.emplace_back(itr, pitr);
                 }
             }
         }
+
+        auto _modfns = std::vector<module_function>(_procs.size());
+        parallel_analysis(_procs.size(), [&](size_t i) {
+            _modfns.at(i) =
+                _make_module_function(_procs.at(i).first, _procs.at(i).second);
+        });
+
+        for(size_t i = 0; i < _procs.size(); ++i)
+        {
+            module_names.insert(_modfns.at(i).module_name);
+            _insert_module_function(available_module_functions, _modfns.at(i));
+            _add_overlapping(_procs.at(i).first, _procs.at(i).second);
+        }
     }
     else if(parse_all_modules)
     {
@@ -1692,11 +1922,15 @@ main(int argc, char** argv)
     //
     //----------------------------------------------------------------------------------//
 
+    _stop_attached();
+
     load_library(get_library_ext(libname));
 
     for(const auto& itr : extra_libs)
         load_library(get_library_ext({ itr }));
 
+    _resume_attached();
+
     //----------------------------------------------------------------------------------//
     //
     //  Find the primary functions that will be used for instrumentation
@@ -1714,6 +1948,14 @@ main(int argc, char** argv)
     auto* reg_src_func   = find_function(app_image, "omnitrace_register_source");
     auto* reg_cov_func   = find_function(app_image, "omnitrace_register_coverage");
     auto* set_instr_func = find_function(app_image, "omnitrace_set_instrumented");
+    auto* reg_cnt_func   = static_cast<procedure_t*>(nullptr);
+    auto* reg_loop_func  = static_cast<procedure_t*>(nullptr);
+
+    if(instr_call_counts)
+        reg_cnt_func = find_function(app_image, "omnitrace_register_call_counter");
+
+    if(loop_level_instr && loop_count_instr)
+        reg_loop_func = find_function(app_image, "omnitrace_register_loop_counter");
 
     if(!main_func && main_fname == "main") main_func = find_function(app_image, "_main");
 
@@ -1846,6 +2088,14 @@ main(int argc, char** argv)
         }
     }
 
+    if(instr_call_counts && !reg_cnt_func)
+        errprintf(-1, "could not find required function :: '%s'\n",
+                  "omnitrace_register_call_counter");
+
+    if(loop_level_instr && loop_count_instr && !reg_loop_func)
+        errprintf(-1, "could not find required function :: '%s'\n",
+                  "omnitrace_register_loop_counter");
+
     //----------------------------------------------------------------------------------//
     //
     //  Find the entry/exit point of either the main (if executable) or the _init
@@ -1998,44 +2248,78 @@ main(int argc, char** argv)
     //
     //----------------------------------------------------------------------------------//
 
-    if(instr_mode != "sampling")
     {
-        for(const auto& itr : available_module_functions)
+        // the heuristics are evaluated concurrently and the results are sorted serially
+        struct modfn_checks
         {
-            if(itr.should_instrument())
-            {
-                _insert_module_function(instrumented_module_functions, itr);
-            }
-            else
-            {
-                _insert_module_function(excluded_module_functions, itr);
-            }
-            if(coverage_mode != CODECOV_NONE)
+            bool instrument = false;
+            bool coverage   = false;
+            bool overlap    = false;
+            bool count      = false;
+        };
+
+        auto _use_instr = (instr_mode != "sampling");
+        auto _modfns    = std::vector<const module_function*>{};
+        _modfns.reserve(available_module_functions.size());
+        for(const auto& itr : available_module_functions)
+            _modfns.emplace_back(&itr);
+
+        auto& _plan   = instrumentation_plan::get();
+        auto  _reused = std::atomic<size_t>{ 0 };
+        auto  _checks = std::vector<modfn_checks>(_modfns.size());
+        parallel_analysis(_modfns.size(), [&](size_t i) {
+            const auto& itr = *_modfns.at(i);
+            auto&       _v  = _checks.at(i);
+            if(const auto* _planned = _plan.find(itr.plan_key))
             {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
+                _v.instrument = _planned->instrument;
+                _v.coverage   = _planned->coverage;
+                _v.overlap    = _planned->overlap;
+                _v.count      = _planned->count;
+                itr.messages  = _planned->messages;
+                _plan.record(itr.plan_key, *_planned);
+                ++_reused;
+                return;
             }
-            if(itr.is_overlapping())
-                _insert_module_function(overlapping_module_functions, itr);
+
+            _v.instrument = _use_instr && itr.should_instrument();
+            _v.coverage =
+                (coverage_mode != CODECOV_NONE) && itr.should_coverage_instrument();
+            _v.overlap = itr.is_overlapping();
+            _v.count   = (instr_call_counts && !_v.instrument) &&
+                       itr.should_count_instrument();
+            _plan.record(itr.plan_key,
+                         instrumentation_plan::decision{ _v.instrument, _v.coverage,
+                                                         _v.overlap, _v.count,
+                                                         itr.num_instructions,
+                                                         itr.messages });
+        });
+
+        if(_plan.enabled())
+        {
+            verbprintf(0, "Reused the instrumentation plan for %zu of %zu functions...\n",
+                       _reused.load(), _modfns.size());
+            _plan.save();
         }
-    }
-    else
-    {
+
         // in sampling mode, we instrument either main or add init and fini callbacks
-        if(main_func)
+        if(!_use_instr && main_func)
             _insert_module_function(instrumented_module_functions,
                                     module_function{ main_func->getModule(), main_func });
 
-        for(const auto& itr : available_module_functions)
+        for(size_t i = 0; i < _modfns.size(); ++i)
         {
-            _insert_module_function(excluded_module_functions, itr);
-            if(coverage_mode != CODECOV_NONE)
-            {
-                if(itr.should_coverage_instrument())
-                    _insert_module_function(coverage_module_functions, itr);
-            }
-            if(itr.is_overlapping())
+            const auto& itr = *_modfns.at(i);
+            if(_checks.at(i).instrument)
+                _insert_module_function(instrumented_module_functions, itr);
+            else
+                _insert_module_function(excluded_module_functions, itr);
+            if(_checks.at(i).coverage)
+                _insert_module_function(coverage_module_functions, itr);
+            if(_checks.at(i).overlap)
                 _insert_module_function(overlapping_module_functions, itr);
+            if(_checks.at(i).count)
+                _insert_module_function(counted_module_functions, itr);
         }
     }
 
@@ -2046,6 +2330,8 @@ main(int argc, char** argv)
     //
     //----------------------------------------------------------------------------------//
 
+    _stop_attached();
+
     auto _objs = std::vector<object_t*>{};
     addr_space->getImage()->getObjects(_objs);
     auto _init_sequence = sequence_t{ init_names };
@@ -2104,7 +2390,11 @@ main(int argc, char** argv)
         }
     }
 
-    if(main_exit_points)
+    if(attach_mode == "sampling")
+    {
+        // the instrumentation library finalizes at exit
+    }
+    else if(main_exit_points)
     {
         verbprintf(1, "Adding main exit snippets...\n");
         // insert_instr(addr_space, *main_exit_points, _fini_sequence, BPatch_exit);
@@ -2175,7 +2465,7 @@ main(int argc, char** argv)
             if(!_valid) continue;
             verbprintf(_pass_verbose_lvl, "%4zu instrumented funcs in %s\n",
                        itr.second.first, itr.first.c_str());
-            _valid = (loop_level_instr &&
+            _valid = (loop_level_instr && !loop_count_instr &&
                       (verbose_level >= _pass_verbose_lvl || itr.second.second > 0));
             if(_valid)
             {
@@ -2189,11 +2479,17 @@ main(int argc, char** argv)
     {
         std::map<std::string, std::pair<size_t, size_t>> _covr_info        = {};
         const int                                        _covr_verbose_lvl = 1;
+        // every run numbers the indices from zero so the upper 32 bits hold a random id
+        // which keeps the indices of separately instrumented binaries (e.g. an
+        // executable and the shared libraries it loads) apart in the runtime
+        size_t _covr_index = static_cast<size_t>(std::random_device{}()) << 32;
         for(const auto& itr : coverage_module_functions)
         {
             if(itr.function == main_func) continue;
-            itr.register_source(addr_space, reg_src_func, *main_entr_points);
-            auto _count = itr.register_coverage(addr_space, reg_cov_func);
+            auto _nidx  = itr.register_source(addr_space, reg_src_func,
+                                              *main_entr_points, _covr_index);
+            auto _count = itr.register_coverage(addr_space, reg_cov_func, _covr_index);
+            _covr_index += _nidx;
             _covr_info[itr.module_name].first += _count.first;
             _covr_info[itr.module_name].second += _count.second;
 
@@ -2229,6 +2525,56 @@ main(int argc, char** argv)
             }
         }
     }
+
+    if(instr_call_counts && !main_entr_points)
+    {
+        errprintf(0, "call counters could not be registered: no main entry points\n");
+    }
+    else if(instr_call_counts)
+    {
+        std::map<std::string, size_t> _cnt_info        = {};
+        const int                     _cnt_verbose_lvl = 1;
+        for(const auto& itr : counted_module_functions)
+        {
+            if(itr.function == main_func) continue;
+            if(itr.register_call_counter(addr_space, reg_cnt_func, *main_entr_points))
+                ++_cnt_info[itr.module_name];
+
+            for(const auto& mitr : itr.messages)
+                _report_info(std::get<0>(mitr), std::get<1>(mitr), std::get<2>(mitr),
+                             std::get<3>(mitr), std::get<4>(mitr));
+        }
+
+        // report the call-counted functions
+        for(auto& itr : _cnt_info)
+            verbprintf(_cnt_verbose_lvl, "%4zu call-counted funcs in %s\n", itr.second,
+                       itr.first.c_str());
+    }
+
+    if(loop_level_instr && loop_count_instr && !main_entr_points)
+    {
+        errprintf(0, "loop counters could not be registered: no main entry points\n");
+    }
+    else if(loop_level_instr && loop_count_instr && instr_mode != "coverage")
+    {
+        std::map<std::string, size_t> _loop_info        = {};
+        const int                     _loop_verbose_lvl = 0;
+        for(const auto& itr : instrumented_module_functions)
+        {
+            if(itr.function == main_func) continue;
+            _loop_info[itr.module_name] +=
+                itr.register_loop_counters(addr_space, reg_loop_func, *main_entr_points);
+
+            for(const auto& mitr : itr.messages)
+                _report_info(std::get<0>(mitr), std::get<1>(mitr), std::get<2>(mitr),
+                             std::get<3>(mitr), std::get<4>(mitr));
+        }
+
+        // report the counted loops
+        for(auto& itr : _loop_info)
+            verbprintf(_loop_verbose_lvl, "%4zu counted loops in %s\n", itr.second,
+                       itr.first.c_str());
+    }
     verbprintf(1, "\n");
 
     if(app_thread)
@@ -2282,6 +2628,18 @@ main(int argc, char** argv)
         }
     }
 
+    // execute the initial snippets and resume the process before the potentially slow
+    // output of the module function info
+    if(_staged_attach && _attached_proc)
+    {
+        verbprintf(1, "Executing initial snippets...\n");
+        for(auto* itr : init_names)
+            _attached_proc->oneTimeCode(*itr);
+        _resume_attached();
+        verbprintf(0, "Process %i was stopped for %.3f sec while attaching\n", _pid,
+                   std::chrono::duration<double>(_attach_paused).count());
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //  Dump the available instrumented modules/functions (re-dump available)
@@ -2299,6 +2657,9 @@ main(int argc, char** argv)
                   "coverage_module_functions", print_formats);
     dump_info("overlapping", overlapping_module_functions, 0, werror,
               "overlapping_module_functions", print_formats);
+    if(instr_call_counts)
+        dump_info("counted", counted_module_functions, 0, werror,
+                  "counted_module_functions", print_formats);
 
     auto _dump_info = [](const std::string& _label, const string_t& _mode,
                          const fmodset_t& _modset) {
@@ -2497,11 +2858,14 @@ main(int argc, char** argv)
         {
             bpatch->setDebugParsing(false);
             bpatch->setDelayedParsing(true);
-            verbprintf(1, "Executing initial snippets...\n");
-            for(auto* itr : init_names)
-                app_thread->oneTimeCode(*itr);
+            if(!_staged_attach)
+            {
+                verbprintf(1, "Executing initial snippets...\n");
+                for(auto* itr : init_names)
+                    app_thread->oneTimeCode(*itr);
 
-            app_thread->continueExecution();
+                app_thread->continueExecution();
+            }
             while(!app_thread->isTerminated())
             {
                 while(bpatch->waitForStatusChange())
@@ -0,0 +1,188 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "regex_set.hpp"
+
+#include <utility>
+
+namespace
+{
+// characters which make an expression more than a literal
+constexpr std::string_view regex_metachars = ".[]{}()\\*+?|^$";
+}  // namespace
+
+// the compiled state and the memoized results are not copied. They are rebuilt on
+// the first search
+regex_set::regex_set(const regex_set& _rhs)
+: m_opts{ _rhs.m_opts }
+, m_exprs{ _rhs.m_exprs }
+{}
+
+regex_set::regex_set(regex_set&& _rhs) noexcept
+: m_opts{ _rhs.m_opts }
+, m_exprs{ std::move(_rhs.m_exprs) }
+{}
+
+regex_set&
+regex_set::operator=(const regex_set& _rhs)
+{
+    if(this == &_rhs) return *this;
+    m_opts     = _rhs.m_opts;
+    m_exprs    = _rhs.m_exprs;
+    m_compiled = false;
+    return *this;
+}
+
+regex_set&
+regex_set::operator=(regex_set&& _rhs) noexcept
+{
+    if(this == &_rhs) return *this;
+    m_opts     = _rhs.m_opts;
+    m_exprs    = std::move(_rhs.m_exprs);
+    m_compiled = false;
+    return *this;
+}
+
+void
+regex_set::emplace_back(const std::string& _expr, flag_type _opts)
+{
+    // validates the expression (throws std::regex_error like std::regex would)
+    auto _regex = std::regex{ _expr, _opts };
+    (void) _regex;
+
+    m_opts = _opts;
+    m_exprs.emplace_back(_expr);
+    m_compiled = false;
+}
+
+// requires the mutex to be locked
+void
+regex_set::compile() const
+{
+    if(m_compiled) return;
+
+    m_literals.clear();
+    m_groups.clear();
+    m_combined.reset();
+    m_cache.clear();
+
+    // case-insensitive expressions cannot be lowered to string comparisons
+    bool _allow_literals = (m_opts & std::regex_constants::icase) == 0;
+
+    auto _combined = std::string{};
+    for(size_t i = 0; i < m_exprs.size(); ++i)
+    {
+        auto _expr = std::string_view{ m_exprs.at(i) };
+        auto _kind = MATCH_SUBSTR;
+        if(_expr.length() > 1 && _expr.front() == '^' && _expr.back() == '$')
+        {
+            _kind = MATCH_EXACT;
+            _expr = _expr.substr(1, _expr.length() - 2);
+        }
+        else if(!_expr.empty() && _expr.front() == '^')
+        {
+            _kind = MATCH_PREFIX;
+            _expr = _expr.substr(1);
+        }
+        else if(!_expr.empty() && _expr.back() == '$')
+        {
+            _kind = MATCH_SUFFIX;
+            _expr = _expr.substr(0, _expr.length() - 1);
+        }
+
+        if(_allow_literals && _expr.find_first_of(regex_metachars) == std::string::npos)
+        {
+            m_literals.emplace_back(literal{ _kind, i, std::string{ _expr } });
+            continue;
+        }
+
+        // each expression is wrapped in a marked sub-expression. The marked
+        // sub-expressions within the expression are mapped to the same expression
+        auto _nmarks = std::regex{ m_exprs.at(i), m_opts }.mark_count();
+        if(!_combined.empty()) _combined += "|";
+        _combined += "(" + m_exprs.at(i) + ")";
+        m_groups.resize(m_groups.size() + _nmarks + 1, i);
+    }
+
+    if(!_combined.empty()) m_combined = std::regex{ _combined, m_opts };
+    m_compiled = true;
+}
+
+std::optional<size_t>
+regex_set::find_impl(const std::string& _name) const
+{
+    // the string comparisons are much cheaper than the combined regex so a matching
+    // literal avoids evaluating the regex entirely
+    auto _name_v = std::string_view{ _name };
+    for(const auto& itr : m_literals)
+    {
+        const auto& _v = itr.value;
+        switch(itr.kind)
+        {
+            case MATCH_SUBSTR:
+                if(_name_v.find(_v) != std::string_view::npos) return itr.index;
+                break;
+            case MATCH_PREFIX:
+                if(_name_v.substr(0, _v.length()) == _v) return itr.index;
+                break;
+            case MATCH_SUFFIX:
+                if(_name_v.length() >= _v.length() &&
+                   _name_v.substr(_name_v.length() - _v.length()) == _v)
+                    return itr.index;
+                break;
+            case MATCH_EXACT:
+                if(_name_v == _v) return itr.index;
+                break;
+        }
+    }
+
+    auto _match = std::smatch{};
+    if(m_combined && std::regex_search(_name, _match, *m_combined))
+    {
+        for(size_t i = 1; i < _match.size() && i <= m_groups.size(); ++i)
+        {
+            if(_match[i].matched) return m_groups.at(i - 1);
+        }
+    }
+
+    return std::optional<size_t>{};
+}
+
+std::optional<size_t>
+regex_set::find(const std::string& _name) const
+{
+    if(m_exprs.empty()) return std::optional<size_t>{};
+
+    {
+        auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+        compile();
+        auto itr = m_cache.find(_name);
+        if(itr != m_cache.end()) return itr->second;
+    }
+
+    auto _result = find_impl(_name);
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    if(m_cache.size() < max_cache_size) m_cache.emplace(_name, _result);
+
+    return _result;
+}
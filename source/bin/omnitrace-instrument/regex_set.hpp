@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// set of regular expressions which is searched in a single pass: the expressions
+// without regex metacharacters (optionally anchored with ^ and/or $) are evaluated
+// as plain string comparisons and the remaining expressions are compiled into one
+// alternation whose marked sub-expressions identify the matching expression. The
+// result for each name is memoized since the same module and function names are
+// checked by many of the heuristics. The expressions are compiled on the first search
+// and searching is thread-safe.
+struct regex_set
+{
+    using flag_type = std::regex_constants::syntax_option_type;
+
+    regex_set()  = default;
+    ~regex_set() = default;
+
+    regex_set(const regex_set&);
+    regex_set(regex_set&&) noexcept;
+    regex_set& operator=(const regex_set&);
+    regex_set& operator=(regex_set&&) noexcept;
+
+    void emplace_back(const std::string& _expr, flag_type _opts);
+
+    bool   empty() const { return m_exprs.empty(); }
+    size_t size() const { return m_exprs.size(); }
+
+    const std::string& at(size_t _idx) const { return m_exprs.at(_idx); }
+
+    // index (in insertion order) of an expression which matches the name, if any
+    std::optional<size_t> find(const std::string&) const;
+
+    bool search(const std::string& _name) const { return find(_name).has_value(); }
+
+private:
+    enum match_kind : uint8_t
+    {
+        MATCH_SUBSTR = 0,
+        MATCH_PREFIX,
+        MATCH_SUFFIX,
+        MATCH_EXACT,
+    };
+
+    struct literal
+    {
+        match_kind  kind  = MATCH_SUBSTR;
+        size_t      index = 0;
+        std::string value = {};
+    };
+
+    using cache_t = std::unordered_map<std::string, std::optional<size_t>>;
+
+    void                  compile() const;
+    std::optional<size_t> find_impl(const std::string&) const;
+
+    // the memoized results are bounded since instruction strings are also searched
+    static constexpr size_t max_cache_size = (1 << 20);
+
+    flag_type                         m_opts     = std::regex_constants::ECMAScript;
+    std::vector<std::string>          m_exprs    = {};
+    mutable bool                      m_compiled = false;
+    mutable std::vector<literal>      m_literals = {};
+    mutable std::vector<size_t>       m_groups   = {};  // marked sub-expr -> expression
+    mutable std::optional<std::regex> m_combined = {};
+    mutable std::mutex                m_mutex    = {};
+    mutable cache_t                   m_cache    = {};
+};
@@ -0,0 +1,618 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-post.hpp"
+#include "binary/analysis.hpp"
+#include "binary/binary_info.hpp"
+#include "core/raw_data.hpp"
+#include "core/utility.hpp"
+
+#include <timemory/environment.hpp>
+#include <timemory/log/color.hpp>
+#include <timemory/log/macros.hpp>
+#include <timemory/utility/argparse.hpp>
+#include <timemory/utility/console.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace color    = ::tim::log::color;
+namespace filepath = ::tim::filepath;
+namespace console  = ::tim::utility::console;
+namespace argparse = ::tim::argparse;
+namespace raw_data = ::omnitrace::raw_data;
+namespace binary   = ::omnitrace::binary;
+using ::omnitrace::utility::json_escape;
+using ::tim::get_env;
+using ::tim::log::monochrome;
+using ::tim::log::stream;
+
+namespace
+{
+int verbose = 0;
+
+std::string
+get_basename(std::string _v)
+{
+    auto _pos = _v.find_last_of('/');
+    if(_pos != std::string::npos) _v = _v.substr(_pos + 1);
+    return _v;
+}
+
+std::string
+get_dirname(const std::string& _v)
+{
+    auto _pos = _v.find_last_of('/');
+    return (_pos == std::string::npos) ? std::string{ "." } : _v.substr(0, _pos);
+}
+
+// e.g. raw-samples-flush-0003-<pid>.bin -> raw-samples-<pid>.bin
+std::string
+strip_flush_index(const std::string& _v)
+{
+    static const auto _flush_idx = std::regex{ "-flush-[0-9]+" };
+    return std::regex_replace(_v, _flush_idx, "");
+}
+
+// resolves the addresses of the samples to function names using the symbols of the
+// objects on disk. The objects are only parsed when an address within them is
+// looked up and each address is only resolved once
+struct symbolizer
+{
+    explicit symbolizer(const std::vector<raw_data::object>& _objs)
+    : m_objects{ _objs }
+    , m_binaries(_objs.size())
+    , m_loaded(_objs.size(), false)
+    {}
+
+    const std::string& operator()(uintptr_t _addr);
+
+private:
+    binary::binary_info* get_binary(size_t _idx);
+
+    const std::vector<raw_data::object>&              m_objects;
+    std::vector<std::unique_ptr<binary::binary_info>> m_binaries = {};
+    std::vector<bool>                                 m_loaded   = {};
+    std::unordered_map<uintptr_t, std::string>        m_names    = {};
+};
+
+binary::binary_info*
+symbolizer::get_binary(size_t _idx)
+{
+    if(m_loaded.at(_idx)) return m_binaries.at(_idx).get();
+    m_loaded.at(_idx) = true;
+
+    const auto& _obj = m_objects.at(_idx);
+    if(!filepath::exists(_obj.path))
+    {
+        TIMEMORY_PRINTF_WARNING(stderr, "'%s' no longer exists. Its samples will not be "
+                                        "symbolized\n",
+                                _obj.path.c_str());
+        return nullptr;
+    }
+
+    // the addresses of a rebuilt binary do not correspond to the recorded samples
+    if(!_obj.build_id.empty())
+    {
+        auto _build_id = raw_data::read_build_id(_obj.path);
+        if(_build_id != _obj.build_id)
+        {
+            TIMEMORY_PRINTF_WARNING(
+                stderr,
+                "the build-id of '%s' (%s) does not match the build-id recorded "
+                "during the run (%s). Its samples will not be symbolized\n",
+                _obj.path.c_str(), _build_id.c_str(), _obj.build_id.c_str());
+            return nullptr;
+        }
+    }
+
+    auto _info = binary::get_binary_info({ _obj.path }, {}, false, true);
+    if(_info.empty()) return nullptr;
+
+    // the symbols are looked up by their address in the file: the mappings found
+    // in this process (e.g. for libc) are unrelated to the recorded process
+    auto& _bin = _info.front();
+    _bin.mappings.clear();
+    for(auto& itr : _bin.symbols)
+        itr.load_address = 0;
+    _bin.build_index();
+
+    if(verbose >= 2)
+        TIMEMORY_PRINTF_INFO(stderr, "loaded %zu symbols from '%s'\n",
+                             _bin.symbols.size(), _obj.path.c_str());
+
+    m_binaries.at(_idx) = std::make_unique<binary::binary_info>(std::move(_bin));
+    return m_binaries.at(_idx).get();
+}
+
+const std::string&
+symbolizer::operator()(uintptr_t _addr)
+{
+    auto itr = m_names.find(_addr);
+    if(itr != m_names.end()) return itr->second;
+
+    auto _name = std::string{};
+    for(size_t i = 0; i < m_objects.size(); ++i)
+    {
+        const auto& _obj = m_objects.at(i);
+        if(!_obj.contains(_addr)) continue;
+
+        auto _offset = _addr - _obj.load_bias;
+        if(auto* _bin = get_binary(i); _bin)
+        {
+            _bin->find_symbols(_offset, [&_name](const auto& _sym, const auto&) {
+                if(_name.empty() && !_sym.func.empty())
+                    _name = tim::demangle(_sym.func);
+            });
+        }
+
+        if(_name.empty())
+        {
+            auto _ss = std::stringstream{};
+            _ss << get_basename(_obj.path) << "+0x" << std::hex << _offset;
+            _name = _ss.str();
+        }
+        break;
+    }
+
+    if(_name.empty())
+    {
+        auto _ss = std::stringstream{};
+        _ss << "0x" << std::hex << _addr;
+        _name = _ss.str();
+    }
+
+    return m_names.emplace(_addr, std::move(_name)).first->second;
+}
+
+using frames_t = std::vector<const std::string*>;
+
+// the call-stacks of each thread as function names, outermost first. Consecutive
+// frames in the same function (e.g. recursion through an unresolved address) are
+// kept since they are distinct calls
+std::vector<frames_t>
+symbolize_stacks(symbolizer& _symbolize, const raw_data::thread& _thread)
+{
+    auto _data = std::vector<frames_t>{};
+    _data.reserve(_thread.stacks.size());
+    for(const auto& sitr : _thread.stacks)
+    {
+        auto& _frames = _data.emplace_back();
+        _frames.reserve(sitr.size());
+        for(auto aitr : sitr)
+            _frames.emplace_back(&_symbolize(aitr));
+    }
+    return _data;
+}
+
+// writes the samples as the JSON trace-event format which is opened by the perfetto
+// UI (ui.perfetto.dev). The samples are merged into slices: a frame which is in
+// consecutive samples at the same depth (and below the same parent frames) is one slice
+void
+write_trace(std::ostream& _os, const raw_data::container& _data,
+            const std::vector<std::vector<frames_t>>& _stacks)
+{
+    auto _first = true;
+    auto _emit  = [&_os, &_first](const std::string& _v) {
+        _os << ((_first) ? "\n" : ",\n") << _v;
+        _first = false;
+    };
+
+    auto _to_usec = [](uint64_t _v) {
+        auto _ss = std::stringstream{};
+        _ss << std::fixed << std::setprecision(3) << (_v / 1000.0);
+        return _ss.str();
+    };
+
+    _os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    {
+        auto _ss = std::stringstream{};
+        _ss << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << _data.pid
+            << ",\"args\":{\"name\":\"" << json_escape(_data.command) << " [rank "
+            << _data.rank << "]\"}}";
+        _emit(_ss.str());
+    }
+
+    for(size_t t = 0; t < _data.threads.size(); ++t)
+    {
+        const auto& _thread = _data.threads.at(t);
+        const auto& _frames = _stacks.at(t);
+        {
+            auto _ss = std::stringstream{};
+            _ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << _data.pid
+                << ",\"tid\":" << _thread.index << ",\"args\":{\"name\":\"Thread "
+                << _thread.index << " [" << _thread.system_tid << "]\"}}";
+            _emit(_ss.str());
+        }
+
+        // the frames of the open slices and the time they were opened
+        auto _open  = std::vector<std::pair<const std::string*, uint64_t>>{};
+        auto _close = [&](size_t _depth, uint64_t _end) {
+            while(_open.size() > _depth)
+            {
+                auto _beg = _open.back().second;
+                auto _ss  = std::stringstream{};
+                _ss << "{\"name\":\"" << json_escape(*_open.back().first)
+                    << "\",\"cat\":\"sampling\",\"ph\":\"X\",\"pid\":" << _data.pid
+                    << ",\"tid\":" << _thread.index << ",\"ts\":" << _to_usec(_beg)
+                    << ",\"dur\":" << _to_usec((_end > _beg) ? _end - _beg : 0) << "}";
+                _emit(_ss.str());
+                _open.pop_back();
+            }
+        };
+
+        uint64_t _last_end = 0;
+        for(const auto& sitr : _thread.samples)
+        {
+            // a gap between samples (e.g. the sampler was stopped) closes every slice
+            if(sitr.begin > _last_end) _close(0, _last_end);
+
+            const auto& _stack = _frames.at(sitr.stack);
+            size_t      _depth = 0;
+            while(_depth < _open.size() && _depth < _stack.size() &&
+                  _open.at(_depth).first == _stack.at(_depth))
+                ++_depth;
+
+            _close(_depth, sitr.begin);
+            for(size_t i = _depth; i < _stack.size(); ++i)
+                _open.emplace_back(_stack.at(i), sitr.begin);
+            _last_end = std::max(_last_end, sitr.end);
+        }
+        _close(0, _last_end);
+    }
+
+    _os << "\n]}\n";
+}
+
+// writes the number of samples and the sampled time in each function. The inclusive
+// values count a sample once per function, regardless of the recursion depth
+void
+write_flat_profile(std::ostream& _os, const raw_data::container& _data,
+                   const std::vector<std::vector<frames_t>>& _stacks)
+{
+    struct entry
+    {
+        uint64_t inclusive_count = 0;
+        uint64_t exclusive_count = 0;
+        uint64_t inclusive_time  = 0;
+        uint64_t exclusive_time  = 0;
+    };
+
+    auto     _entries = std::unordered_map<const std::string*, entry>{};
+    uint64_t _total   = 0;
+    for(size_t t = 0; t < _data.threads.size(); ++t)
+    {
+        for(const auto& sitr : _data.threads.at(t).samples)
+        {
+            const auto& _stack = _stacks.at(t).at(sitr.stack);
+            if(_stack.empty()) continue;
+
+            auto _elapsed = (sitr.end > sitr.begin) ? sitr.end - sitr.begin : 0;
+            auto _seen    = std::set<const std::string*>{};
+            _total += _elapsed;
+            for(const auto* itr : _stack)
+            {
+                if(!_seen.emplace(itr).second) continue;
+                auto& _entry = _entries[itr];
+                _entry.inclusive_count += 1;
+                _entry.inclusive_time += _elapsed;
+            }
+            auto& _entry = _entries[_stack.back()];
+            _entry.exclusive_count += 1;
+            _entry.exclusive_time += _elapsed;
+        }
+    }
+
+    auto _sorted = std::vector<std::pair<const std::string*, entry>>{ _entries.begin(),
+                                                                       _entries.end() };
+    std::sort(_sorted.begin(), _sorted.end(), [](const auto& _lhs, const auto& _rhs) {
+        if(_lhs.second.exclusive_time != _rhs.second.exclusive_time)
+            return _lhs.second.exclusive_time > _rhs.second.exclusive_time;
+        return _lhs.second.inclusive_time > _rhs.second.inclusive_time;
+    });
+
+    auto _percent = [_total](uint64_t _v) {
+        return (_total > 0) ? (100.0 * _v) / _total : 0.0;
+    };
+
+    _os << "# " << _data.command << " (pid " << _data.pid << ", rank " << _data.rank
+        << "): " << _data.threads.size() << " threads, " << std::fixed
+        << std::setprecision(6) << (_total / 1.0e9) << " sec sampled\n";
+    _os << std::setw(12) << "EXCL [sec]" << std::setw(9) << "EXCL %" << std::setw(12)
+        << "INCL [sec]" << std::setw(9) << "INCL %" << std::setw(10) << "SAMPLES"
+        << "  FUNCTION\n";
+    for(const auto& itr : _sorted)
+    {
+        const auto& _v = itr.second;
+        _os << std::setw(12) << std::setprecision(6) << (_v.exclusive_time / 1.0e9)
+            << std::setw(9) << std::setprecision(2) << _percent(_v.exclusive_time)
+            << std::setw(12) << std::setprecision(6) << (_v.inclusive_time / 1.0e9)
+            << std::setw(9) << std::setprecision(2) << _percent(_v.inclusive_time)
+            << std::setw(10) << _v.inclusive_count << "  " << *itr.first << "\n";
+    }
+}
+
+// appends the samples of a file flushed by the same process. The call-stacks of the
+// threads are re-indexed and the objects loaded after the previous flushes are added
+void
+merge(raw_data::container& _dst, raw_data::container&& _src, const std::string& _fname)
+{
+    if(_src.pid != _dst.pid || _src.rank != _dst.rank)
+    {
+        TIMEMORY_PRINTF_WARNING(stderr,
+                                "'%s' was written by process %li (rank %li) instead of "
+                                "process %li (rank %li)\n",
+                                _fname.c_str(), static_cast<long>(_src.pid),
+                                static_cast<long>(_src.rank), static_cast<long>(_dst.pid),
+                                static_cast<long>(_dst.rank));
+    }
+
+    for(auto& itr : _src.objects)
+    {
+        auto _exists = std::any_of(_dst.objects.begin(), _dst.objects.end(),
+                                   [&itr](const auto& _v) {
+                                       return (_v.path == itr.path &&
+                                               _v.load_bias == itr.load_bias);
+                                   });
+        if(!_exists) _dst.objects.emplace_back(std::move(itr));
+    }
+
+    for(auto& itr : _src.threads)
+    {
+        auto titr =
+            std::find_if(_dst.threads.begin(), _dst.threads.end(),
+                         [&itr](const auto& _v) { return (_v.index == itr.index); });
+        if(titr == _dst.threads.end())
+        {
+            _dst.threads.emplace_back(std::move(itr));
+            continue;
+        }
+
+        auto _offset = titr->stacks.size();
+        for(auto& sitr : itr.stacks)
+            titr->stacks.emplace_back(std::move(sitr));
+        for(auto sitr : itr.samples)
+        {
+            sitr.stack += _offset;
+            titr->samples.emplace_back(sitr);
+        }
+        titr->start = std::min(titr->start, itr.start);
+        titr->stop  = std::max(titr->stop, itr.stop);
+        std::stable_sort(
+            titr->samples.begin(), titr->samples.end(),
+            [](const auto& _lhs, const auto& _rhs) { return _lhs.begin < _rhs.begin; });
+    }
+
+    std::sort(_dst.threads.begin(), _dst.threads.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.index < _rhs.index; });
+}
+
+template <typename FuncT>
+std::string
+write_output(const std::string& _fname, FuncT&& _func)
+{
+    auto _ofs = std::ofstream{ _fname };
+    if(!_ofs) throw std::runtime_error("unable to open '" + _fname + "'");
+    std::forward<FuncT>(_func)(_ofs);
+    if(!_ofs) throw std::runtime_error("failed to write '" + _fname + "'");
+    return _fname;
+}
+}  // namespace
+
+int
+get_verbose()
+{
+    verbose = get_env("OMNITRACE_POST_VERBOSE",
+                      get_env<int>("OMNITRACE_VERBOSE", verbose, false));
+    return verbose;
+}
+
+std::vector<std::vector<std::string>>
+group_inputs(const std::vector<std::string>& _inputs)
+{
+    auto _groups = std::map<std::string, std::vector<std::string>>{};
+    for(const auto& itr : _inputs)
+        _groups[strip_flush_index(itr)].emplace_back(itr);
+
+    auto _data = std::vector<std::vector<std::string>>{};
+    _data.reserve(_groups.size());
+    for(auto& itr : _groups)
+    {
+        std::sort(itr.second.begin(), itr.second.end());
+        _data.emplace_back(std::move(itr.second));
+    }
+    return _data;
+}
+
+void
+process_files(const std::vector<std::string>& _inputs, const std::string& _output_dir)
+{
+    if(_inputs.empty()) return;
+
+    auto _data = raw_data::container{};
+    for(const auto& itr : _inputs)
+    {
+        auto _ifs = std::ifstream{ itr, std::ios::binary };
+        if(!_ifs) throw std::runtime_error("unable to open '" + itr + "'");
+
+        auto _v = raw_data::read(_ifs);
+        if(&itr == &_inputs.front())
+            _data = std::move(_v);
+        else
+            merge(_data, std::move(_v), itr);
+    }
+
+    auto _symbolize = symbolizer{ _data.objects };
+    auto _stacks    = std::vector<std::vector<frames_t>>{};
+    _stacks.reserve(_data.threads.size());
+    for(const auto& itr : _data.threads)
+        _stacks.emplace_back(symbolize_stacks(_symbolize, itr));
+
+    const auto& _input = _inputs.front();
+    auto        _dir   = (_output_dir.empty()) ? get_dirname(_input) : _output_dir;
+    if(!filepath::exists(_dir)) filepath::makedir(_dir);
+
+    auto _stem = strip_flush_index(get_basename(_input));
+    if(auto _pos = _stem.find_last_of('.'); _pos != std::string::npos)
+        _stem = _stem.substr(0, _pos);
+    auto _prefix = _dir + "/" + _stem;
+
+    auto _trace = write_output(_prefix + "-perfetto-trace.json", [&](std::ostream& _os) {
+        write_trace(_os, _data, _stacks);
+    });
+    auto _flat  = write_output(_prefix + "-flat-profile.txt", [&](std::ostream& _os) {
+        write_flat_profile(_os, _data, _stacks);
+    });
+
+    if(verbose >= 0)
+    {
+        auto _name = _input;
+        if(_inputs.size() > 1)
+            _name += " (+ " + std::to_string(_inputs.size() - 1) + " files)";
+        TIMEMORY_PRINTF_INFO(stderr, "%s -> %s, %s\n", _name.c_str(), _trace.c_str(),
+                             _flat.c_str());
+    }
+}
+
+post_options
+parse_args(int argc, char** argv)
+{
+    using parser_t     = argparse::argument_parser;
+    using parser_err_t = typename parser_t::result_type;
+
+    const auto* _desc = R"desc(
+    Converts the raw sampling data written by omnitrace when OMNITRACE_DEFER_POST_PROCESSING=ON
+    into a trace for the perfetto UI and a flat profile. The addresses of the samples are
+    symbolized from the executable and libraries on disk so this should be run on a system
+    with the same files as the run (the build-ids of the files are checked).
+    For example:
+
+        omnitrace-post omnitrace-output/raw-samples-*.bin       # output next to each input file
+        omnitrace-post -j 8 -o results raw-samples-*.bin        # 8 files at a time, output in results/
+
+    The raw-samples-flush files written by a process with OMNITRACE_FLUSH_INTERVAL are merged into
+    a single output for the process.
+    )desc";
+
+    auto _opts  = post_options{};
+    auto parser = parser_t{ get_basename(argv[0]), _desc };
+
+    parser.on_error([](parser_t&, const parser_err_t& _err) {
+        stream(std::cerr, color::fatal()) << _err << "\n";
+        exit(EXIT_FAILURE);
+    });
+
+    parser.enable_help();
+    parser.enable_version("omnitrace-post", OMNITRACE_ARGPARSE_VERSION_INFO);
+
+    auto _cols = std::get<0>(console::get_columns());
+    if(_cols > parser.get_help_width() + 8)
+        parser.set_description_width(
+            std::min<int>(_cols - parser.get_help_width() - 8, 120));
+
+    parser.start_group("DEBUG OPTIONS", "");
+    parser.add_argument({ "--monochrome" }, "Disable colorized output")
+        .max_count(1)
+        .dtype("bool")
+        .action([&](parser_t& p) {
+            auto _monochrome = p.get<bool>("monochrome");
+            monochrome()     = _monochrome;
+            p.set_use_color(!_monochrome);
+        });
+    parser.add_argument({ "-v", "--verbose" }, "Verbose output")
+        .count(1)
+        .action([&](parser_t& p) { verbose = p.get<int>("verbose"); });
+
+    parser.start_group("GENERAL OPTIONS", "");
+    parser
+        .add_argument({ "-i", "--input" },
+                      "Raw sampling data files (the positional arguments are also "
+                      "treated as input files)")
+        .min_count(1)
+        .dtype("filepath")
+        .action([&](parser_t& p) {
+            for(auto& itr : p.get<std::vector<std::string>>("input"))
+                _opts.inputs.emplace_back(std::move(itr));
+        });
+    parser
+        .add_argument({ "-o", "--output" },
+                      "Output folder. Defaults to the folder of each input file")
+        .count(1)
+        .dtype("folder")
+        .action([&](parser_t& p) { _opts.output_dir = p.get<std::string>("output"); });
+    parser
+        .add_argument({ "-j", "--jobs" },
+                      "Number of input files processed concurrently, e.g. the files "
+                      "of different MPI ranks")
+        .count(1)
+        .dtype("integer")
+        .action([&](parser_t& p) { _opts.jobs = p.get<size_t>("jobs"); });
+
+    get_verbose();
+
+    auto _args = std::vector<char*>{};
+    for(int i = 0; i < argc; ++i)
+    {
+        // positional arguments are input files
+        if(i > 0 && argv[i][0] != '-' && std::string_view{ argv[i - 1] } != "-o" &&
+           std::string_view{ argv[i - 1] } != "--output" &&
+           std::string_view{ argv[i - 1] } != "-j" &&
+           std::string_view{ argv[i - 1] } != "--jobs" &&
+           std::string_view{ argv[i - 1] } != "-v" &&
+           std::string_view{ argv[i - 1] } != "--verbose" && filepath::exists(argv[i]))
+        {
+            _opts.inputs.emplace_back(argv[i]);
+            continue;
+        }
+        _args.emplace_back(argv[i]);
+    }
+
+    auto _err = parser.parse_args(_args.size(), _args.data());
+    if(_err) throw std::runtime_error(_err.what());
+
+    if(parser.exists("help") || _opts.inputs.empty())
+    {
+        parser.print_help();
+        exit((_opts.inputs.empty() && !parser.exists("help")) ? EXIT_FAILURE
+                                                              : EXIT_SUCCESS);
+    }
+
+    return _opts;
+}
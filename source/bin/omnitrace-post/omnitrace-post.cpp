@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "omnitrace-post.hpp"
+
+#include <timemory/log/macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+
+int
+main(int argc, char** argv)
+{
+    auto _opts   = parse_args(argc, argv);
+    auto _groups = group_inputs(_opts.inputs);
+    auto _next = std::atomic<size_t>{ 0 };
+    auto _fail = std::atomic<int>{ 0 };
+
+    // the files of the different ranks/processes are independent so they are
+    // converted concurrently
+    auto _worker = [&]() {
+        for(size_t i = _next++; i < _groups.size(); i = _next++)
+        {
+            const auto& _inputs = _groups.at(i);
+            try
+            {
+                process_files(_inputs, _opts.output_dir);
+            } catch(std::exception& _e)
+            {
+                TIMEMORY_PRINTF_FATAL(stderr, "failed to process '%s': %s\n",
+                                      _inputs.front().c_str(), _e.what());
+                ++_fail;
+            }
+        }
+    };
+
+    auto _njobs = std::min<size_t>(std::max<size_t>(_opts.jobs, 1), _groups.size());
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 1; i < _njobs; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+    for(auto& itr : _threads)
+        itr.join();
+
+    return (_fail.load() == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,53 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#define TIMEMORY_PROJECT_NAME "omnitrace-post"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct post_options
+{
+    size_t                   jobs       = 1;
+    std::string              output_dir = {};
+    std::vector<std::string> inputs     = {};
+};
+
+int
+get_verbose();
+
+post_options
+parse_args(int argc, char** argv);
+
+// groups the input files by process: the files periodically flushed by a process
+// (OMNITRACE_FLUSH_INTERVAL) only differ by their flush index
+std::vector<std::vector<std::string>>
+group_inputs(const std::vector<std::string>& _inputs);
+
+// converts the raw sampling data files of one process (written with
+// OMNITRACE_DEFER_POST_PROCESSING or OMNITRACE_FLUSH_INTERVAL) into a
+// perfetto-compatible trace and a flat profile. Throws on failure
+void
+process_files(const std::vector<std::string>& _inputs, const std::string& _output_dir);
@@ -271,6 +271,7 @@ parse_args(int argc, char** argv, parser_data_t& _parser_data, bool& _fork_exec)
 
     toggle_suppression(initial_suppression);
     omnitrace::argparse::init_parser(_parser_data);
+    omnitrace::config::configure_setting_choices();
 
     // no need for backtraces
     signals::disable_signal_detection(signals::signal_settings::get_enabled());
@@ -140,6 +140,16 @@ get_initial_environment()
 
     update_env(_env, "OMNITRACE_USE_SAMPLING", (_mode != "causal"));
 
+    // the application is not instrumented so the deferred initialization would only be
+    // triggered by the user API and the sampling would silently never start
+    if(get_env<bool>("OMNITRACE_LAZY_INIT", false, false))
+    {
+        stream(std::cerr, color::warning())
+            << "[omnitrace-sample] OMNITRACE_LAZY_INIT is not supported by "
+               "omnitrace-sample and is disabled\n";
+        update_env(_env, "OMNITRACE_LAZY_INIT", false);
+    }
+
 #if defined(OMNITRACE_USE_ROCTRACER) || defined(OMNITRACE_USE_ROCPROFILER)
     update_env(_env, "HSA_TOOLS_LIB", _dl_libpath);
     if(!getenv("HSA_TOOLS_REPORT_LOAD_FAILURE"))
@@ -878,6 +888,14 @@ parse_args(int argc, char** argv, std::vector<char*>& _env)
             update_env(_env, "HSA_ENABLE_INTERRUPT", p.get<int>("hsa-interrupt"));
         });
 
+    parser
+        .add_argument({ "--init-timing" },
+                      "Print the time spent loading and initializing omnitrace")
+        .max_count(1)
+        .action([&](parser_t& p) {
+            update_env(_env, "OMNITRACE_DL_INIT_TIMING", p.get<bool>("init-timing"));
+        });
+
     parser.end_group();
 
     auto _inpv = std::vector<char*>{};
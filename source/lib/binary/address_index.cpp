@@ -0,0 +1,60 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "address_index.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace omnitrace
+{
+namespace binary
+{
+void
+address_index::build()
+{
+    std::stable_sort(m_entries.begin(), m_entries.end(),
+                     [](const entry& _lhs, const entry& _rhs) {
+                         return (_lhs.low < _rhs.low);
+                     });
+
+    m_max_high.clear();
+    m_max_high.reserve(m_entries.size());
+    uintptr_t _max = 0;
+    for(const auto& itr : m_entries)
+    {
+        _max = std::max(_max, itr.high);
+        m_max_high.emplace_back(_max);
+    }
+}
+
+std::vector<size_t>
+address_index::find(uintptr_t _addr) const
+{
+    auto _data = std::vector<size_t>{};
+    find(_addr, [&_data](size_t _idx) { _data.emplace_back(_idx); });
+    return _data;
+}
+}  // namespace binary
+}  // namespace omnitrace
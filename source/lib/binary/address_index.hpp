@@ -0,0 +1,115 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/binary/address_range.hpp"
+#include "core/binary/fwd.hpp"
+
+#include <timemory/utility/macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace binary
+{
+// sorted index over a container of (possibly overlapping) address ranges.
+// Entries are ordered by the low address and accompanied by a running maximum
+// of the high addresses so that finding every range containing an address is a
+// binary search followed by a short backward walk.
+struct address_index
+{
+    OMNITRACE_DEFAULT_OBJECT(address_index)
+
+    template <typename ContainerT, typename FuncT>
+    address_index(const ContainerT& _data, FuncT&& _get_range);
+
+    // invokes the functor with the position (in the original container) of each
+    // range containing the address. Positions are provided in ascending order
+    template <typename FuncT>
+    size_t find(uintptr_t _addr, FuncT&& _func) const;
+
+    std::vector<size_t> find(uintptr_t _addr) const;
+
+    auto size() const { return m_entries.size(); }
+    auto empty() const { return m_entries.empty(); }
+
+private:
+    struct entry
+    {
+        uintptr_t low   = 0;  // inclusive
+        uintptr_t high  = 0;  // exclusive
+        size_t    index = 0;
+    };
+
+    void build();
+
+    std::vector<entry>     m_entries  = {};
+    std::vector<uintptr_t> m_max_high = {};
+};
+
+template <typename ContainerT, typename FuncT>
+address_index::address_index(const ContainerT& _data, FuncT&& _get_range)
+{
+    m_entries.reserve(_data.size());
+    size_t _idx = 0;
+    for(const auto& itr : _data)
+    {
+        address_range _range = _get_range(itr);
+        if(_range.is_valid())
+            m_entries.emplace_back(entry{
+                _range.low, (_range.is_range()) ? _range.high : (_range.low + 1), _idx });
+        ++_idx;
+    }
+    build();
+}
+
+template <typename FuncT>
+size_t
+address_index::find(uintptr_t _addr, FuncT&& _func) const
+{
+    auto _idx = std::vector<size_t>{};
+    // first entry with low > _addr. Everything before it is a candidate but the
+    // running maximum of the high addresses allows terminating the walk early
+    auto itr = std::upper_bound(
+        m_entries.begin(), m_entries.end(), _addr,
+        [](uintptr_t _lhs, const entry& _rhs) { return _lhs < _rhs.low; });
+
+    for(auto n = std::distance(m_entries.begin(), itr); n > 0; --n)
+    {
+        if(m_max_high[n - 1] <= _addr) break;
+        if(m_entries[n - 1].high > _addr) _idx.emplace_back(m_entries[n - 1].index);
+    }
+
+    std::sort(_idx.begin(), _idx.end());
+    for(auto iitr : _idx)
+        _func(iitr);
+
+    return _idx.size();
+}
+}  // namespace binary
+}  // namespace omnitrace
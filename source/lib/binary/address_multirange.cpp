@@ -57,6 +57,7 @@ address_multirange::operator+=(uintptr_t _v)
     //    if(itr.contains(_v)) return *this;
 
     m_fine_ranges.emplace(address_range{ _v });
+    m_frozen = false;
     return *this;
 }
 
@@ -69,7 +70,48 @@ address_multirange::operator+=(address_range _v)
     //    if(itr.contains(_v)) return *this;
 
     m_fine_ranges.emplace(_v);
+    m_frozen = false;
     return *this;
 }
+
+void
+address_multirange::freeze()
+{
+    m_merged_ranges.clear();
+    m_merged_ranges.reserve(m_fine_ranges.size());
+
+    for(const auto& itr : m_fine_ranges)
+    {
+        if(!itr.is_valid()) continue;
+        // address_range of a single address contains only low, otherwise [low, high)
+        auto _v = interval{ itr.low, (itr.is_range()) ? itr.high : (itr.low + 1) };
+        m_merged_ranges.emplace_back(_v);
+    }
+
+    std::sort(m_merged_ranges.begin(), m_merged_ranges.end(),
+              [](const interval& _lhs, const interval& _rhs) {
+                  return (_lhs.low == _rhs.low) ? (_lhs.high < _rhs.high)
+                                                : (_lhs.low < _rhs.low);
+              });
+
+    // merge overlapping and adjacent intervals
+    size_t _n = 0;
+    for(size_t i = 0; i < m_merged_ranges.size(); ++i)
+    {
+        if(_n > 0 && m_merged_ranges.at(i).low <= m_merged_ranges.at(_n - 1).high)
+        {
+            m_merged_ranges.at(_n - 1).high =
+                std::max(m_merged_ranges.at(_n - 1).high, m_merged_ranges.at(i).high);
+        }
+        else
+        {
+            m_merged_ranges.at(_n++) = m_merged_ranges.at(i);
+        }
+    }
+
+    m_merged_ranges.resize(_n);
+    m_merged_ranges.shrink_to_fit();
+    m_frozen = true;
+}
 }  // namespace binary
 }  // namespace omnitrace
@@ -27,8 +27,11 @@
 
 #include <timemory/utility/macros.hpp>
 
+#include <algorithm>
 #include <cstdint>
+#include <set>
 #include <utility>
+#include <vector>
 
 namespace omnitrace
 {
@@ -49,17 +52,47 @@ struct address_multirange
     template <typename Tp>
     bool contains(Tp&& _v) const;
 
+    // merges the fine ranges into a sorted array of disjoint half-open intervals
+    // so that contains(...) is a binary search. Adding ranges after freezing
+    // reverts to the (slower) unfrozen lookup until freeze() is called again
+    void freeze();
+
     auto size() const { return m_fine_ranges.size(); }
     auto empty() const { return m_fine_ranges.empty(); }
+    auto frozen() const { return m_frozen; }
     auto range_size() const { return m_coarse_range.size(); }
+    auto merged_size() const { return m_merged_ranges.size(); }
     auto get_coarse_range() const { return m_coarse_range; }
     auto get_ranges() const { return m_fine_ranges; }
 
 private:
-    address_range           m_coarse_range = {};
-    std::set<address_range> m_fine_ranges  = {};
+    struct interval
+    {
+        uintptr_t low  = 0;  // inclusive
+        uintptr_t high = 0;  // exclusive
+    };
+
+    const interval* find(uintptr_t _v) const;
+
+    bool                    m_frozen        = false;
+    address_range           m_coarse_range  = {};
+    std::set<address_range> m_fine_ranges   = {};
+    std::vector<interval>   m_merged_ranges = {};
 };
 
+OMNITRACE_INLINE const address_multirange::interval*
+address_multirange::find(uintptr_t _v) const
+{
+    // first interval with low > _v, the candidate is the one immediately before
+    auto itr = std::upper_bound(m_merged_ranges.begin(), m_merged_ranges.end(), _v,
+                                [](uintptr_t _lhs, const interval& _rhs) {
+                                    return _lhs < _rhs.low;
+                                });
+    if(itr == m_merged_ranges.begin()) return nullptr;
+    --itr;
+    return (_v < itr->high) ? &(*itr) : nullptr;
+}
+
 template <typename Tp>
 OMNITRACE_INLINE bool
 address_multirange::contains(Tp&& _v) const
@@ -70,6 +103,21 @@ address_multirange::contains(Tp&& _v) const
                   "Error! operator+= supports only integrals or address_ranges");
 
     if(!m_coarse_range.contains(_v)) return false;
+
+    if(OMNITRACE_LIKELY(m_frozen))
+    {
+        if constexpr(std::is_integral<type>::value)
+        {
+            return (find(_v) != nullptr);
+        }
+        else
+        {
+            const auto* _interval = find(_v.low);
+            if(!_interval) return false;
+            return (!_v.is_range() || _v.high <= _interval->high);
+        }
+    }
+
     return std::any_of(m_fine_ranges.begin(), m_fine_ranges.end(),
                        [_v](auto&& itr) { return itr.contains(_v); });
 }
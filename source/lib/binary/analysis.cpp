@@ -31,6 +31,7 @@
 #include <bfd.h>
 
 #include "analysis.hpp"
+#include "binary_cache.hpp"
 #include "binary_info.hpp"
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
@@ -41,6 +42,7 @@
 #include "core/state.hpp"
 #include "core/utility.hpp"
 #include "dwarf_entry.hpp"
+#include "jit_symbols.hpp"
 #include "link_map.hpp"
 #include "scope_filter.hpp"
 #include "symbol.hpp"
@@ -56,6 +58,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <dlfcn.h>
+#include <mutex>
 #include <regex>
 #include <set>
 #include <stdexcept>
@@ -66,11 +69,21 @@ namespace binary
 {
 namespace
 {
+// BFD (notably its cache of open files) is not thread-safe so the files are
+// read through BFD one at a time while the DWARF processing runs concurrently
+auto&
+get_bfd_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
 binary_info
 parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd,
-                bool _include_all)
+                bool _include_all, size_t _dwarf_threads)
 {
     auto _info = binary_info{};
+    auto _lk   = std::unique_lock<std::mutex>{ get_bfd_mutex() };
 
     auto& _bfd = _info.bfd;
     _bfd       = std::make_shared<bfd_file>(_name);
@@ -79,16 +92,36 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
 
     if(_bfd && _bfd->is_good())
     {
+        auto _cache_opts = ((_process_dwarf) ? binary_cache::process_dwarf : 0) |
+                           ((_process_bfd) ? binary_cache::process_bfd : 0) |
+                           ((_include_all) ? binary_cache::include_all : 0);
+        // the line info is decoded on demand in lazy mode so there is nothing to cache
+        auto _lazy   = _process_dwarf && config::get_binary_lazy_dwarf();
+        auto _cached = !_lazy && binary_cache::enabled() &&
+                       binary_cache::load(_bfd->name, _cache_opts, _info);
+
+        // when the cache is shared by the processes on a node, the first process to
+        // miss the cache builds the entry while the others wait for the lock and
+        // then load the entry which was just saved
+        auto _cache_lock = std::unique_ptr<binary_cache::scoped_lock>{};
+        if(!_cached && !_lazy && binary_cache::node_shared())
+        {
+            _cache_lock =
+                std::make_unique<binary_cache::scoped_lock>(_bfd->name, _cache_opts);
+            _cached = binary_cache::load(_bfd->name, _cache_opts, _info);
+        }
+
         auto& _section_map = _info.sections;
         auto  _section_set = std::set<asection*>{};
         auto  _processed   = std::set<uintptr_t>{};
         for(auto&& itr : _bfd->get_symbols())
         {
             if(!_include_all && itr.symsize == 0) continue;
-            auto& _sym = _info.symbols.emplace_back(symbol{ itr });
-            // if(itr.symsize == 0) continue;
             auto* _section = static_cast<asection*>(itr.section);
             _section_set.emplace(_section);
+            if(_cached) continue;
+            auto& _sym = _info.symbols.emplace_back(symbol{ itr });
+            // if(itr.symsize == 0) continue;
             _processed.emplace(itr.address);
             _info.ranges.emplace_back(
                 address_range{ itr.address, itr.address + itr.symsize });
@@ -109,19 +142,36 @@ parse_line_info(const std::string& _name, bool _process_dwarf, bool _process_bfd
             << "section set size (" << _section_set.size() << ") != section map size ("
             << _section_map.size() << ")\n";
 
+        _lk.unlock();
+
+        if(_cached) return _info;
+
+        if(_lazy)
+        {
+            _info.dwarf_units = std::make_shared<dwarf_unit_index>(_bfd->fd);
+            _info.ranges      = _info.dwarf_units->get_ranges();
+            _info.sort();
+
+            OMNITRACE_BASIC_VERBOSE(
+                1, "[binary] Indexed %zu compilation units of '%s'... %zu entries\n",
+                _info.dwarf_units->size(), _bfd->name.c_str(), _info.symbols.size());
+
+            return _info;
+        }
+
         if(_process_dwarf)
         {
             std::tie(_info.debug_info, _info.ranges, _info.breakpoints) =
-                dwarf_entry::process_dwarf(_bfd->fd);
+                dwarf_entry::process_dwarf(_bfd->fd, _dwarf_threads);
         }
 
+        symbol::read_dwarf_entries(_info.symbols, _info.debug_info);
         for(auto& itr : _info.symbols)
-        {
-            itr.read_dwarf_entries(_info.debug_info);
             itr.read_dwarf_breakpoints(_info.breakpoints);
-        }
 
         _info.sort();
+
+        if(binary_cache::enabled()) binary_cache::save(_bfd->name, _cache_opts, _info);
     }
 
     OMNITRACE_BASIC_VERBOSE(1, "[binary] Reading line info for '%s'... %zu entries\n",
@@ -159,8 +209,8 @@ get_binary_info(const std::vector<std::string>&  _files,
         return (filepath::exists(_path) && _satisfies_binary_filter(_path));
     };
 
-    auto _data = std::vector<binary_info>{};
-    _data.reserve(_files.size());
+    auto _filenames = std::vector<std::string>{};
+    _filenames.reserve(_files.size());
     {
         auto _exists = std::set<std::string>{};
         for(const auto& itr : _files)
@@ -169,13 +219,24 @@ get_binary_info(const std::vector<std::string>&  _files,
             if(filepath::exists(_filename) && _satisfies_binary_filter(_filename) &&
                _exists.find(_filename) == _exists.end())
             {
-                _data.emplace_back(parse_line_info(_filename, _process_dwarf,
-                                                   _process_bfd, _include_all));
+                _filenames.emplace_back(_filename);
                 _exists.emplace(_filename);
             }
         }
     }
 
+    // the files are parsed concurrently and, when there are fewer files than threads,
+    // the remaining threads process the compilation units within each file
+    auto _nthreads      = std::max<size_t>(config::get_thread_pool_size(), 1);
+    auto _nfiles        = std::max<size_t>(_filenames.size(), 1);
+    auto _dwarf_threads = std::max<size_t>(_nthreads / _nfiles, 1);
+    auto _data          = std::vector<binary_info>(_filenames.size());
+    utility::parallel_for(_filenames.size(), _nthreads, [&](size_t _idx) {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        _data.at(_idx) = parse_line_info(_filenames.at(_idx), _process_dwarf,
+                                         _process_bfd, _include_all, _dwarf_threads);
+    });
+
     // get the memory maps
     auto _maps = procfs::get_contiguous_maps(process::get_id(), _filter, false);
 
@@ -204,65 +265,70 @@ get_binary_info(const std::vector<std::string>&  _files,
     return _data;
 }
 
-template <bool ExcludeInternal>
-std::optional<tim::unwind::processed_entry>
-lookup_ipaddr_entry(uintptr_t _addr, unw_context_t* _context_p,
-                    tim::unwind::cache* _cache_p)
+namespace
+{
+auto&
+get_ipaddr_mutex()
 {
-    static auto _mutex     = locking::atomic_mutex{};
-    static auto _cache_v   = tim::unwind::cache{ true };
-    static auto _context_v = []() {
-        auto _v = unw_context_t{};
-        unw_getcontext(&_v);
-        return _v;
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+auto&
+get_ipaddr_cache()
+{
+    static auto _v = tim::unwind::cache{ true };
+    return _v;
+}
+
+auto&
+get_ipaddr_context()
+{
+    static auto _v = []() {
+        auto _ctx = unw_context_t{};
+        unw_getcontext(&_ctx);
+        return _ctx;
     }();
+    return _v;
+}
 
-    if constexpr(ExcludeInternal)
-    {
-        static auto _exclude_range = []() {
-            auto _maps                 = ::tim::procfs::maps::iterate_program_headers();
-            auto _exclude_range_v      = std::set<address_range_t>{};
-            auto _insert_exclude_range = [&_maps,
-                                          &_exclude_range_v](const std::string& _v) {
-                auto _base_v = std::string_view{ filepath::basename(_v) };
-                auto _real_v = filepath::realpath(_v);
-                for(const auto& mitr : _maps)
+// address ranges of libomnitrace and libomnitrace-dl (sorted)
+const std::set<address_range_t>&
+get_internal_address_ranges()
+{
+    static auto _v = []() {
+        auto _maps                 = ::tim::procfs::maps::iterate_program_headers();
+        auto _exclude_range_v      = std::set<address_range_t>{};
+        auto _insert_exclude_range = [&_maps, &_exclude_range_v](const std::string& _v) {
+            auto _base_v = std::string_view{ filepath::basename(_v) };
+            auto _real_v = filepath::realpath(_v);
+            for(const auto& mitr : _maps)
+            {
+                if(std::string_view{ filepath::basename(mitr.pathname) } == _base_v ||
+                   _real_v == _v)
                 {
-                    if(std::string_view{ filepath::basename(mitr.pathname) } == _base_v ||
-                       _real_v == _v)
-                    {
-                        _exclude_range_v.emplace(
-                            address_range_t{ mitr.load_address, mitr.last_address });
-                    }
+                    _exclude_range_v.emplace(
+                        address_range_t{ mitr.load_address, mitr.last_address });
                 }
-            };
-
-            for(const auto& itr : binary::get_link_map("libomnitrace.so", "", ""))
-                _insert_exclude_range(itr.real());
-
-            for(const auto& itr : binary::get_link_map("libomnitrace-dl.so", "", ""))
-                _insert_exclude_range(itr.real());
-
-            return _exclude_range_v;
-        }();
-
-        for(auto itr : _exclude_range)
-            if(itr.contains(_addr)) return std::optional<tim::unwind::processed_entry>{};
-    }
+            }
+        };
 
-    // NOLINTNEXTLINE(readability-misleading-indentation)
-    if(_addr == 0) return std::optional<tim::unwind::processed_entry>{};
+        for(const auto& itr : binary::get_link_map("libomnitrace.so", "", ""))
+            _insert_exclude_range(itr.real());
 
-    auto _lk = locking::atomic_lock{ _mutex, std::defer_lock };
+        for(const auto& itr : binary::get_link_map("libomnitrace-dl.so", "", ""))
+            _insert_exclude_range(itr.real());
 
-    if(!_context_p) _context_p = &_context_v;
-    if(!_cache_p)
-    {
-        _cache_p = &_cache_v;
-        // prevent concurrent access to cache
-        _lk.lock();
-    }
+        return _exclude_range_v;
+    }();
+    return _v;
+}
 
+// resolves the address via the cache. The caller is responsible for locking the cache
+std::optional<tim::unwind::processed_entry>
+resolve_ipaddr_entry(uintptr_t _addr, unw_context_t* _context_p,
+                     tim::unwind::cache* _cache_p)
+{
     auto _entry = tim::unwind::entry{ _addr };
 
     auto citr = _cache_p->entries.find(_entry);
@@ -293,16 +359,103 @@ lookup_ipaddr_entry(uintptr_t _addr, unw_context_t* _context_p,
         _v.error = 0;
     }
 
+    // JIT-compiled code is not in any of the ELF files
+    if(_v.error != 0 && config::get_jit_symbols())
+    {
+        if(auto _jit = lookup_jit_symbol(_addr))
+        {
+            _v.name     = _jit->name;
+            _v.location = _jit->location;
+            _v.lineno   = _jit->line;
+            _v.error    = 0;
+        }
+    }
+
     _cache_p->entries.emplace(_entry, _v);
 
     return (_v.error == 0) ? std::optional<tim::unwind::processed_entry>{ _v }
                            : std::optional<tim::unwind::processed_entry>{};
 }
+}  // namespace
+
+template <bool ExcludeInternal>
+std::optional<tim::unwind::processed_entry>
+lookup_ipaddr_entry(uintptr_t _addr, unw_context_t* _context_p,
+                    tim::unwind::cache* _cache_p)
+{
+    if constexpr(ExcludeInternal)
+    {
+        for(auto itr : get_internal_address_ranges())
+            if(itr.contains(_addr)) return std::optional<tim::unwind::processed_entry>{};
+    }
+
+    // NOLINTNEXTLINE(readability-misleading-indentation)
+    if(_addr == 0) return std::optional<tim::unwind::processed_entry>{};
+
+    auto _lk = locking::atomic_lock{ get_ipaddr_mutex(), std::defer_lock };
+
+    if(!_context_p) _context_p = &get_ipaddr_context();
+    if(!_cache_p)
+    {
+        _cache_p = &get_ipaddr_cache();
+        // prevent concurrent access to cache
+        _lk.lock();
+    }
+
+    return resolve_ipaddr_entry(_addr, _context_p, _cache_p);
+}
+
+template <bool ExcludeInternal>
+std::vector<std::optional<tim::unwind::processed_entry>>
+lookup_ipaddr_entries(const std::vector<uintptr_t>& _addrs, unw_context_t* _context_p,
+                      tim::unwind::cache* _cache_p)
+{
+    auto _data = std::vector<std::optional<tim::unwind::processed_entry>>(_addrs.size());
+    if(_addrs.empty()) return _data;
+
+    auto _lk = locking::atomic_lock{ get_ipaddr_mutex(), std::defer_lock };
+
+    if(!_context_p) _context_p = &get_ipaddr_context();
+    if(!_cache_p)
+    {
+        _cache_p = &get_ipaddr_cache();
+        // prevent concurrent access to cache
+        _lk.lock();
+    }
+
+    static const auto _none = std::set<address_range_t>{};
+
+    // both the addresses and the internal address ranges are sorted so the range
+    // which may contain the address only moves forward
+    const auto& _exclude = (ExcludeInternal) ? get_internal_address_ranges() : _none;
+    auto        ritr     = _exclude.begin();
+    for(size_t i = 0; i < _addrs.size(); ++i)
+    {
+        auto _addr = _addrs[i];
+        if(_addr == 0) continue;
+
+        while(ritr != _exclude.end() && ritr->high <= _addr)
+            ++ritr;
+        if(ritr != _exclude.end() && ritr->contains(_addr)) continue;
+
+        _data[i] = resolve_ipaddr_entry(_addr, _context_p, _cache_p);
+    }
+
+    return _data;
+}
 
 template std::optional<tim::unwind::processed_entry>
 lookup_ipaddr_entry<true>(uintptr_t, unw_context_t*, tim::unwind::cache*);
 
 template std::optional<tim::unwind::processed_entry>
 lookup_ipaddr_entry<false>(uintptr_t, unw_context_t*, tim::unwind::cache*);
+
+template std::vector<std::optional<tim::unwind::processed_entry>>
+lookup_ipaddr_entries<true>(const std::vector<uintptr_t>&, unw_context_t*,
+                            tim::unwind::cache*);
+
+template std::vector<std::optional<tim::unwind::processed_entry>>
+lookup_ipaddr_entries<false>(const std::vector<uintptr_t>&, unw_context_t*,
+                             tim::unwind::cache*);
 }  // namespace binary
 }  // namespace omnitrace
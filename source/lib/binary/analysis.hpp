@@ -61,5 +61,14 @@ get_binary_info(const std::vector<std::string>&, const std::vector<scope_filter>
 template <bool ExcludeInternal>
 std::optional<tim::unwind::processed_entry>
 lookup_ipaddr_entry(uintptr_t, unw_context_t* = nullptr, tim::unwind::cache* = nullptr);
+
+// resolves a sorted set of unique addresses in a single sweep and returns a dense
+// table with the entry of each address at the same index. The cache is locked once
+// for the batch and the internal libraries are excluded by merging the addresses with
+// their (sorted) address ranges
+template <bool ExcludeInternal>
+std::vector<std::optional<tim::unwind::processed_entry>>
+lookup_ipaddr_entries(const std::vector<uintptr_t>&, unw_context_t* = nullptr,
+                      tim::unwind::cache* = nullptr);
 }  // namespace binary
 }  // namespace omnitrace
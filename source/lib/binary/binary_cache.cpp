@@ -0,0 +1,496 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "binary_cache.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "dwarf_entry.hpp"
+#include "symbol.hpp"
+
+#include <timemory/utility/filepath.hpp>
+
+#include <elfutils/libdwelf.h>
+#include <libelf.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace binary
+{
+namespace
+{
+constexpr uint64_t cache_magic   = 0x4e49424e4d4f;  // "OMNBIN"
+constexpr uint32_t cache_version = 1;
+
+struct cache_writer
+{
+    template <typename Tp>
+    void put_value(Tp _v)
+    {
+        static_assert(std::is_trivially_copyable<Tp>::value, "requires trivial type");
+        data.append(reinterpret_cast<const char*>(&_v), sizeof(Tp));
+    }
+
+    void put_string(std::string_view _v)
+    {
+        put_value<uint64_t>(_v.size());
+        data.append(_v.data(), _v.size());
+        data.push_back('\0');
+    }
+
+    void put_range(address_range _v)
+    {
+        put_value(_v.low);
+        put_value(_v.high);
+    }
+
+    std::string data = {};
+};
+
+// reads the entries in-place from the mapped cache file. The strings are null
+// terminated in the file so they can be referenced directly
+struct cache_reader
+{
+    template <typename Tp>
+    Tp get_value()
+    {
+        auto _v = Tp{};
+        if(static_cast<size_t>(end - pos) < sizeof(Tp))
+        {
+            good = false;
+            return _v;
+        }
+        memcpy(&_v, pos, sizeof(Tp));
+        pos += sizeof(Tp);
+        return _v;
+    }
+
+    const char* get_string()
+    {
+        auto _len = get_value<uint64_t>();
+        if(!good || static_cast<uint64_t>(end - pos) < _len + 1 || pos[_len] != '\0')
+        {
+            good = false;
+            return "";
+        }
+        const auto* _v = pos;
+        pos += _len + 1;
+        return _v;
+    }
+
+    address_range get_range()
+    {
+        auto _v = address_range{};
+        _v.low  = get_value<uintptr_t>();
+        _v.high = get_value<uintptr_t>();
+        return _v;
+    }
+
+    // guards against reserving storage for a corrupted count
+    size_t get_count(size_t _min_size)
+    {
+        auto _n     = get_value<uint64_t>();
+        auto _avail = static_cast<uint64_t>(end - pos);
+        if(!good || _n > _avail / std::max<size_t>(_min_size, 1))
+        {
+            good = false;
+            return 0;
+        }
+        return _n;
+    }
+
+    const char* pos  = nullptr;
+    const char* end  = nullptr;
+    bool        good = true;
+};
+
+void
+write_entry(cache_writer& _w, const dwarf_entry& _v)
+{
+    auto _flags = uint8_t{ 0 };
+    _flags |= (_v.begin_statement) ? 0x01 : 0;
+    _flags |= (_v.end_sequence) ? 0x02 : 0;
+    _flags |= (_v.line_block) ? 0x04 : 0;
+    _flags |= (_v.prologue_end) ? 0x08 : 0;
+    _flags |= (_v.epilogue_begin) ? 0x10 : 0;
+    _w.put_value(_flags);
+    _w.put_value(_v.line);
+    _w.put_value(_v.col);
+    _w.put_value(_v.vliw_op_index);
+    _w.put_value(_v.isa);
+    _w.put_value(_v.discriminator);
+    _w.put_range(_v.address);
+    _w.put_string(_v.file);
+}
+
+dwarf_entry
+read_entry(cache_reader& _r)
+{
+    auto _v   = dwarf_entry{};
+    auto _flg = _r.get_value<uint8_t>();
+
+    _v.begin_statement = (_flg & 0x01) != 0;
+    _v.end_sequence    = (_flg & 0x02) != 0;
+    _v.line_block      = (_flg & 0x04) != 0;
+    _v.prologue_end    = (_flg & 0x08) != 0;
+    _v.epilogue_begin  = (_flg & 0x10) != 0;
+    _v.line            = _r.get_value<decltype(_v.line)>();
+    _v.col             = _r.get_value<decltype(_v.col)>();
+    _v.vliw_op_index   = _r.get_value<decltype(_v.vliw_op_index)>();
+    _v.isa             = _r.get_value<decltype(_v.isa)>();
+    _v.discriminator   = _r.get_value<decltype(_v.discriminator)>();
+    _v.address         = _r.get_range();
+    _v.file            = _r.get_string();
+    return _v;
+}
+
+template <typename ContainerT>
+void
+write_entries(cache_writer& _w, const ContainerT& _v)
+{
+    _w.put_value<uint64_t>(_v.size());
+    for(const auto& itr : _v)
+        write_entry(_w, itr);
+}
+
+template <typename ContainerT>
+void
+read_entries(cache_reader& _r, ContainerT& _v)
+{
+    auto _n = _r.get_count(sizeof(uint8_t));
+    for(size_t i = 0; i < _n && _r.good; ++i)
+        _v.emplace_back(read_entry(_r));
+}
+
+template <typename ContainerT>
+void
+write_values(cache_writer& _w, const ContainerT& _v)
+{
+    _w.put_value<uint64_t>(_v.size());
+    for(const auto& itr : _v)
+        _w.put_value(itr);
+}
+
+template <typename Tp, typename ContainerT>
+void
+read_values(cache_reader& _r, ContainerT& _v)
+{
+    auto _n = _r.get_count(sizeof(Tp));
+    for(size_t i = 0; i < _n && _r.good; ++i)
+        _v.emplace_back(_r.get_value<Tp>());
+}
+
+std::string
+get_build_id(const std::string& _filename)
+{
+    auto _id = std::string{};
+    auto _fd = ::open(_filename.c_str(), O_RDONLY);
+    if(_fd < 0) return _id;
+
+    elf_version(EV_CURRENT);
+    if(auto* _elf = elf_begin(_fd, ELF_C_READ_MMAP, nullptr); _elf)
+    {
+        const void* _data = nullptr;
+        auto        _len  = dwelf_elf_gnu_build_id(_elf, &_data);
+        if(_len > 0 && _data)
+        {
+            auto        _ss    = std::stringstream{};
+            const auto* _bytes = static_cast<const unsigned char*>(_data);
+            for(ssize_t i = 0; i < _len; ++i)
+                _ss << std::hex << std::setw(2) << std::setfill('0')
+                    << static_cast<int>(_bytes[i]);
+            _id = _ss.str();
+        }
+        elf_end(_elf);
+    }
+    ::close(_fd);
+
+    return _id;
+}
+
+std::string
+get_cache_dir()
+{
+    auto _dir = config::get_binary_cache_dir();
+    if(_dir.empty() && config::get_binary_cache_node_shared())
+        return JOIN('/', config::get_tmpdir(), "omnitrace-binary-cache");
+    return _dir;
+}
+
+std::string
+get_cache_filename(const std::string& _filename, int _options)
+{
+    auto _dir = get_cache_dir();
+    auto _st  = (struct stat){};
+    if(_dir.empty() || ::stat(_filename.c_str(), &_st) != 0) return std::string{};
+
+    auto _id = get_build_id(_filename);
+    auto _ss = std::stringstream{};
+    if(_id.empty()) _ss << "path-" << std::hex << std::hash<std::string>{}(_filename);
+    else
+        _ss << _id;
+
+    auto _mtime = (static_cast<uint64_t>(_st.st_mtim.tv_sec) * 1000000000UL) +
+                  static_cast<uint64_t>(_st.st_mtim.tv_nsec);
+    _ss << std::hex << '-' << _mtime << '-' << _st.st_size << '-' << _options << ".bin";
+
+    return JOIN('/', _dir, _ss.str());
+}
+
+bool
+make_directory(const std::string& _dir)
+{
+    for(size_t _pos = _dir.find('/', 1); true; _pos = _dir.find('/', _pos + 1))
+    {
+        auto _path = _dir.substr(0, _pos);
+        if(::mkdir(_path.c_str(), 0755) != 0 && errno != EEXIST) return false;
+        if(_pos == std::string::npos) break;
+    }
+    return true;
+}
+}  // namespace
+
+binary_cache::scoped_lock::scoped_lock(const std::string& _filename, int _options)
+{
+    auto _cache_file = get_cache_filename(_filename, _options);
+    if(_cache_file.empty()) return;
+
+    // the lock files are left behind since removing them would race with the
+    // processes which opened them but have not acquired the lock yet
+    auto _lock_name =
+        JOIN('-', "omnitrace-binary-cache", filepath::basename(_cache_file));
+    auto _lock_file = JOIN('/', config::get_tmpdir(), _lock_name + ".lock");
+
+    m_fd = ::open(_lock_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(m_fd >= 0 && ::flock(m_fd, LOCK_EX) != 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    if(m_fd < 0)
+    {
+        OMNITRACE_BASIC_VERBOSE(1, "[binary] failed to lock '%s': %s\n",
+                                _lock_file.c_str(), strerror(errno));
+    }
+}
+
+binary_cache::scoped_lock::~scoped_lock()
+{
+    if(m_fd < 0) return;
+    ::flock(m_fd, LOCK_UN);
+    ::close(m_fd);
+}
+
+bool
+binary_cache::enabled()
+{
+    return !get_cache_dir().empty();
+}
+
+bool
+binary_cache::node_shared()
+{
+    return config::get_binary_cache_node_shared();
+}
+
+bool
+binary_cache::load(const std::string& _filename, int _options, binary_info& _info)
+{
+    auto _cache_file = get_cache_filename(_filename, _options);
+    if(_cache_file.empty()) return false;
+
+    auto _fd = ::open(_cache_file.c_str(), O_RDONLY);
+    if(_fd < 0) return false;
+
+    auto _st = (struct stat){};
+    if(::fstat(_fd, &_st) != 0 || _st.st_size <= 0)
+    {
+        ::close(_fd);
+        return false;
+    }
+
+    auto  _size = static_cast<size_t>(_st.st_size);
+    // a shared read-only mapping so the processes on a node which load the same
+    // entry share the pages of the file
+    void* _addr = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    ::close(_fd);
+    if(_addr == MAP_FAILED) return false;
+
+    auto _r = cache_reader{ static_cast<const char*>(_addr),
+                            static_cast<const char*>(_addr) + _size };
+
+    auto _symbols     = std::deque<symbol>{};
+    auto _debug_info  = std::deque<dwarf_entry>{};
+    auto _ranges      = std::vector<address_range>{};
+    auto _breakpoints = std::vector<uintptr_t>{};
+
+    if(_r.get_value<uint64_t>() == cache_magic &&
+       _r.get_value<uint32_t>() == cache_version &&
+       _r.get_value<int32_t>() == _options && _r.get_string() == _filename)
+    {
+        auto _nsym = _r.get_count(sizeof(uint64_t));
+        for(size_t i = 0; i < _nsym && _r.good; ++i)
+        {
+            auto& _sym = _symbols.emplace_back();
+
+            auto _binding    = _r.get_value<int64_t>();
+            auto _visibility = _r.get_value<int64_t>();
+
+            _sym.binding            = static_cast<decltype(_sym.binding)>(_binding);
+            _sym.visibility         = static_cast<decltype(_sym.visibility)>(_visibility);
+            _sym.base_type::address = _r.get_value<uintptr_t>();
+            _sym.base_type::symsize = _r.get_value<uintptr_t>();
+            _sym.base_type::name    = _r.get_string();
+            _sym.base_type::section = nullptr;
+            _sym.line               = _r.get_value<unsigned int>();
+            _sym.load_address       = _r.get_value<uintptr_t>();
+            _sym.address            = _r.get_range();
+            _sym.func               = _r.get_string();
+            _sym.file               = _r.get_string();
+            read_values<uintptr_t>(_r, _sym.breakpoints);
+
+            auto _ninl = _r.get_count(sizeof(uint64_t));
+            for(size_t j = 0; j < _ninl && _r.good; ++j)
+            {
+                auto& _inl = _sym.inlines.emplace_back();
+                _inl.line  = _r.get_value<unsigned int>();
+                _inl.file  = _r.get_string();
+                _inl.func  = _r.get_string();
+            }
+
+            read_entries(_r, _sym.dwarf_info);
+        }
+
+        read_entries(_r, _debug_info);
+        read_values<address_range>(_r, _ranges);
+        read_values<uintptr_t>(_r, _breakpoints);
+    }
+    else
+    {
+        _r.good = false;
+    }
+
+    // the symbol names reference the mapped file so it remains mapped
+    if(!_r.good || _r.pos != _r.end)
+    {
+        ::munmap(_addr, _size);
+        OMNITRACE_BASIC_VERBOSE(1, "[binary] ignoring invalid cache file '%s'...\n",
+                                _cache_file.c_str());
+        return false;
+    }
+
+    _info.symbols     = std::move(_symbols);
+    _info.debug_info  = std::move(_debug_info);
+    _info.ranges      = std::move(_ranges);
+    _info.breakpoints = std::move(_breakpoints);
+
+    OMNITRACE_BASIC_VERBOSE(1, "[binary] Loaded line info for '%s' from '%s'...\n",
+                            _filename.c_str(), _cache_file.c_str());
+    return true;
+}
+
+bool
+binary_cache::save(const std::string& _filename, int _options, const binary_info& _info)
+{
+    auto _cache_file = get_cache_filename(_filename, _options);
+    if(_cache_file.empty()) return false;
+
+    if(!make_directory(get_cache_dir()))
+    {
+        OMNITRACE_BASIC_WARNING(1, "[binary] failed to create cache directory '%s': %s\n",
+                                get_cache_dir().c_str(), strerror(errno));
+        return false;
+    }
+
+    auto _w = cache_writer{};
+    _w.put_value<uint64_t>(cache_magic);
+    _w.put_value<uint32_t>(cache_version);
+    _w.put_value<int32_t>(_options);
+    _w.put_string(_filename);
+
+    _w.put_value<uint64_t>(_info.symbols.size());
+    for(const auto& itr : _info.symbols)
+    {
+        _w.put_value(static_cast<int64_t>(itr.binding));
+        _w.put_value(static_cast<int64_t>(itr.visibility));
+        _w.put_value<uintptr_t>(itr.base_type::address);
+        _w.put_value<uintptr_t>(itr.base_type::symsize);
+        _w.put_string(itr.base_type::name);
+        _w.put_value<unsigned int>(itr.line);
+        _w.put_value<uintptr_t>(itr.load_address);
+        _w.put_range(itr.address);
+        _w.put_string(itr.func);
+        _w.put_string(itr.file);
+        write_values(_w, itr.breakpoints);
+
+        _w.put_value<uint64_t>(itr.inlines.size());
+        for(const auto& iitr : itr.inlines)
+        {
+            _w.put_value<unsigned int>(iitr.line);
+            _w.put_string(iitr.file);
+            _w.put_string(iitr.func);
+        }
+
+        write_entries(_w, itr.dwarf_info);
+    }
+
+    write_entries(_w, _info.debug_info);
+    write_values(_w, _info.ranges);
+    write_values(_w, _info.breakpoints);
+
+    // write to a unique file and rename it so that concurrent processes writing the
+    // same entry never expose a partially written file
+    auto  _tmp_file = JOIN('.', _cache_file, getpid(), "tmp");
+    auto* _fp       = fopen(_tmp_file.c_str(), "wb");
+    if(!_fp) return false;
+
+    auto _ok = (fwrite(_w.data.data(), 1, _w.data.size(), _fp) == _w.data.size());
+    _ok      = (fclose(_fp) == 0) && _ok;
+    if(!_ok || rename(_tmp_file.c_str(), _cache_file.c_str()) != 0)
+    {
+        unlink(_tmp_file.c_str());
+        return false;
+    }
+
+    OMNITRACE_BASIC_VERBOSE(2, "[binary] Saved line info for '%s' to '%s'...\n",
+                            _filename.c_str(), _cache_file.c_str());
+    return true;
+}
+}  // namespace binary
+}  // namespace omnitrace
@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "binary_info.hpp"
+
+#include <string>
+
+namespace omnitrace
+{
+namespace binary
+{
+// persistent cache of the processed symbols, inlined functions, DWARF line entries,
+// and breakpoints of a binary. The entries are stored in OMNITRACE_BINARY_CACHE_DIR
+// and are keyed by the ELF build-id (or the path if there is no build-id), the
+// modification time and size of the file, and the options used to process it so
+// that subsequent runs and sibling processes skip the BFD and DWARF processing.
+// The BFD handle, the sections, and the memory mappings are not cached.
+//
+// With OMNITRACE_BINARY_CACHE_NODE_SHARED, the entries are shared by the processes
+// on a node: the first process which misses the cache builds the entry while
+// holding a lock and the other processes wait on the lock and map the entry.
+struct binary_cache
+{
+    enum option : int
+    {
+        process_dwarf = 0x1,
+        process_bfd   = 0x2,
+        include_all   = 0x4,
+    };
+
+    // exclusive lock on the cache entry of a binary in OMNITRACE_TMPDIR
+    struct scoped_lock
+    {
+        scoped_lock(const std::string& _filename, int _options);
+        ~scoped_lock();
+
+        scoped_lock(const scoped_lock&) = delete;
+        scoped_lock(scoped_lock&&)      = delete;
+        scoped_lock& operator=(const scoped_lock&) = delete;
+        scoped_lock& operator=(scoped_lock&&) = delete;
+
+    private:
+        int m_fd = -1;
+    };
+
+    static bool enabled();
+    static bool node_shared();
+    static bool load(const std::string& _filename, int _options, binary_info&);
+    static bool save(const std::string& _filename, int _options, const binary_info&);
+};
+}  // namespace binary
+}  // namespace omnitrace
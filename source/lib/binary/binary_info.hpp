@@ -25,7 +25,9 @@
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
 #include "core/utility.hpp"
+#include "address_index.hpp"
 #include "dwarf_entry.hpp"
+#include "scope_filter.hpp"
 #include "symbol.hpp"
 
 #include <timemory/utility/procfs/maps.hpp>
@@ -33,7 +35,10 @@
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace omnitrace
@@ -50,11 +55,50 @@ struct binary_info
     std::vector<uintptr_t>                   breakpoints = {};
     std::unordered_map<address_range, void*> sections    = {};
 
+    // index over the symbols (by ipaddr) and over the dwarf info of each symbol.
+    // Must be rebuilt via build_index() if symbols are modified
+    address_index              symbol_index = {};
+    std::vector<address_index> line_index   = {};
+
+    // when set, the DWARF line info of a symbol is decoded on the first lookup of an
+    // address within the symbol (via find_symbols) instead of in the analysis. The
+    // entries are restricted to the line filters, if any
+    std::shared_ptr<dwarf_unit_index> dwarf_units  = {};
+    std::vector<scope_filter>         line_filters = {};
+
     void        sort();
+    void        build_index();
+    bool        is_indexed() const { return symbol_index.size() > 0; }
+    bool        is_lazy() const { return dwarf_units != nullptr; }
     std::string filename() const;
 
     template <typename RetT = void>
     RetT* find_section(uintptr_t) const;
+
+    // invokes the functor with each symbol (in symbols order) whose ipaddr contains
+    // the address and the index of its line info. If the functor accepts a third
+    // argument, it is the index of the symbol. Requires build_index(). The non-const
+    // overload decodes the line info of the symbols when lazy
+    template <typename FuncT>
+    size_t find_symbols(uintptr_t, FuncT&&);
+
+    template <typename FuncT>
+    size_t find_symbols(uintptr_t, FuncT&&) const;
+
+    // invokes the functor with each symbol (and, if the functor accepts a second
+    // argument, the index of the symbol). When lazy, the line info which has been
+    // decoded so far is visited and no line info is decoded concurrently
+    template <typename FuncT>
+    void for_each_symbol(FuncT&&) const;
+
+private:
+    void load_line_info(size_t);
+
+    template <typename FuncT>
+    void invoke_symbol(FuncT&&, size_t) const;
+
+    std::shared_ptr<std::mutex> m_line_mutex  = {};
+    std::vector<char>           m_line_loaded = {};
 };
 
 inline void
@@ -67,6 +111,85 @@ binary_info::sort()
     utility::filter_sort_unique(breakpoints);
 }
 
+inline void
+binary_info::build_index()
+{
+    symbol_index =
+        address_index{ symbols, [](const symbol& _v) { return _v.ipaddr(); } };
+
+    line_index.clear();
+    line_index.reserve(symbols.size());
+    for(const auto& itr : symbols)
+        line_index.emplace_back(address_index{
+            itr.dwarf_info, [](const dwarf_entry& _v) { return _v.address; } });
+
+    m_line_mutex = std::make_shared<std::mutex>();
+    m_line_loaded.assign(symbols.size(), (is_lazy()) ? 0 : 1);
+}
+
+inline void
+binary_info::load_line_info(size_t _idx)
+{
+    if(m_line_loaded.at(_idx) != 0) return;
+
+    auto& _sym = symbols.at(_idx);
+    _sym.read_dwarf_entries(dwarf_units->get_entries(_sym.address));
+    if(!line_filters.empty())
+        _sym.dwarf_info =
+            _sym.get_debug_line_info<std::vector<dwarf_entry>>(line_filters);
+
+    line_index.at(_idx) = address_index{
+        _sym.dwarf_info, [](const dwarf_entry& _v) { return _v.address; } };
+    m_line_loaded.at(_idx) = 1;
+}
+
+template <typename FuncT>
+inline size_t
+binary_info::find_symbols(uintptr_t _addr, FuncT&& _func)
+{
+    if(!is_lazy() || !m_line_mutex)
+        return std::as_const(*this).find_symbols(_addr, std::forward<FuncT>(_func));
+
+    auto _lk = std::unique_lock<std::mutex>{ *m_line_mutex };
+    return symbol_index.find(_addr, [&](size_t _idx) {
+        load_line_info(_idx);
+        invoke_symbol(_func, _idx);
+    });
+}
+
+template <typename FuncT>
+inline size_t
+binary_info::find_symbols(uintptr_t _addr, FuncT&& _func) const
+{
+    return symbol_index.find(_addr, [&](size_t _idx) { invoke_symbol(_func, _idx); });
+}
+
+template <typename FuncT>
+inline void
+binary_info::invoke_symbol(FuncT&& _func, size_t _idx) const
+{
+    if constexpr(std::is_invocable<FuncT, const symbol&, const address_index&,
+                                   size_t>::value)
+        _func(symbols.at(_idx), line_index.at(_idx), _idx);
+    else
+        _func(symbols.at(_idx), line_index.at(_idx));
+}
+
+template <typename FuncT>
+inline void
+binary_info::for_each_symbol(FuncT&& _func) const
+{
+    auto _lk = (is_lazy() && m_line_mutex) ? std::unique_lock<std::mutex>{ *m_line_mutex }
+                                           : std::unique_lock<std::mutex>{};
+    for(size_t i = 0; i < symbols.size(); ++i)
+    {
+        if constexpr(std::is_invocable<FuncT, const symbol&, size_t>::value)
+            _func(symbols.at(i), i);
+        else
+            _func(symbols.at(i));
+    }
+}
+
 template <typename RetT>
 inline RetT*
 binary_info::find_section(uintptr_t _addr) const
@@ -22,12 +22,18 @@
 
 #include "dwarf_entry.hpp"
 #include "core/binary/fwd.hpp"
+#include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "core/utility.hpp"
 
 #include <dwarf.h>
 #include <elfutils/libdw.h>
 
+#include <algorithm>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
 namespace omnitrace
 {
 namespace binary
@@ -93,6 +99,10 @@ get_dwarf_entry(Dwarf_Die* _die)
 
     if(dwarf_tag(_die) != DW_TAG_compile_unit) return _line_info;
 
+    // the file names returned by dwarf_linesrc are owned by the file table of the
+    // unit so the resolved paths are cached by their address
+    auto _files = std::unordered_map<const char*, interned_string>{};
+
     Dwarf_Lines* _lines     = nullptr;
     size_t       _num_lines = 0;
     if(dwarf_getsrclines(_die, &_lines, &_num_lines) == 0)
@@ -120,7 +130,13 @@ get_dwarf_entry(Dwarf_Die* _die)
                 if(_lineno > 0) itr.line = _lineno;
                 const auto* _file = dwarf_linesrc(_line, nullptr, nullptr);
                 if(!_file) _file = dwarf_diename(_die);
-                itr.file = filepath::realpath(_file, nullptr, false);
+                auto fitr = _files.find(_file);
+                if(fitr == _files.end())
+                    fitr = _files
+                               .emplace(_file, interned_string{ filepath::realpath(
+                                                   _file, nullptr, false) })
+                               .first;
+                itr.file = fitr->second;
             }
         }
     }
@@ -157,49 +173,216 @@ dwarf_entry::is_valid() const
 }
 
 dwarf_entry::dwarf_tuple_t
-dwarf_entry::process_dwarf(int _fd)
+dwarf_entry::process_dwarf(int _fd, size_t _nthreads)
 {
     auto* _dwarf_v = dwarf_begin(_fd, DWARF_C_READ);
     auto  _data_v  = dwarf_tuple_t{};
 
     if(_dwarf_v)
     {
+        // offsets of the DIE of every compilation unit
+        auto _cu_die_offs = std::vector<Dwarf_Off>{};
+        {
+            size_t    cu_header_size = 0;
+            Dwarf_Off cu_off         = 0;
+            Dwarf_Off next_cu_off    = 0;
+            for(; dwarf_nextcu(_dwarf_v, cu_off, &next_cu_off, &cu_header_size, nullptr,
+                               nullptr, nullptr) == 0;
+                cu_off = next_cu_off)
+                _cu_die_offs.emplace_back(cu_off + cu_header_size);
+        }
+
+        // a Dwarf handle cannot be shared between threads so each thread opens its
+        // own handle and processes a contiguous block of the compilation units
+        constexpr size_t min_units_per_thread = 16;
+
+        auto _nblocks = std::clamp<size_t>(_cu_die_offs.size() / min_units_per_thread, 1,
+                                           std::max<size_t>(_nthreads, 1));
+        auto _block_size = (_cu_die_offs.size() + _nblocks - 1) / _nblocks;
+        auto _blocks     = std::vector<dwarf_tuple_t>(_nblocks);
+        auto _done       = std::vector<char>(_nblocks, 0);
+
+        auto _process_block = [&](Dwarf* _dwarf, size_t _idx) {
+            auto& _entries = std::get<0>(_blocks.at(_idx));
+            auto& _ranges  = std::get<1>(_blocks.at(_idx));
+            auto& _bkpts   = std::get<2>(_blocks.at(_idx));
+            auto  _beg     = std::min(_idx * _block_size, _cu_die_offs.size());
+            auto  _end     = std::min(_beg + _block_size, _cu_die_offs.size());
+            for(size_t i = _beg; i < _end; ++i)
+            {
+                auto cu_die = Dwarf_Die{};
+                if(dwarf_offdie(_dwarf, _cu_die_offs.at(i), &cu_die) != nullptr)
+                {
+                    Dwarf_Die* _die = &cu_die;
+                    if(dwarf_tag(_die) == DW_TAG_compile_unit)
+                    {
+                        combine(_entries, get_dwarf_entry(_die));
+                        combine(_ranges, get_dwarf_address_ranges(_die));
+                    }
+                    else if(dwarf_tag(_die) == DW_TAG_subprogram)
+                    {
+                        combine(_bkpts, get_dwarf_breakpoints(_die));
+                        combine(_ranges, get_dwarf_address_ranges(_die));
+                    }
+                }
+            }
+            _done.at(_idx) = 1;
+        };
+
+        utility::parallel_for(_nblocks, _nblocks, [&](size_t _idx) {
+            OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+            auto* _dwarf = (_idx == 0) ? _dwarf_v : dwarf_begin(_fd, DWARF_C_READ);
+            if(!_dwarf) return;
+            _process_block(_dwarf, _idx);
+            if(_dwarf != _dwarf_v) dwarf_end(_dwarf);
+        });
+
+        // blocks whose thread could not open a handle
+        for(size_t i = 0; i < _nblocks; ++i)
+            if(_done.at(i) == 0) _process_block(_dwarf_v, i);
+
+        dwarf_end(_dwarf_v);
+
         auto& _entries = std::get<0>(_data_v);
         auto& _ranges  = std::get<1>(_data_v);
         auto& _bkpts   = std::get<2>(_data_v);
+        for(auto& itr : _blocks)
+        {
+            combine(_entries, std::get<0>(itr));
+            combine(_ranges, std::get<1>(itr));
+            combine(_bkpts, std::get<2>(itr));
+        }
 
+        utility::filter_sort_unique(_entries);
+        utility::filter_sort_unique(_ranges);
+        utility::filter_sort_unique(_bkpts);
+    }
+
+    return _data_v;
+}
+
+dwarf_unit_index::dwarf_unit_index(int _fd)
+: m_fd{ ::dup(_fd) }
+{
+    if(m_fd >= 0) m_dwarf = dwarf_begin(m_fd, DWARF_C_READ);
+    if(!m_dwarf) return;
+
+    // offsets of the DIE of every compilation unit
+    auto _unit_idx = std::unordered_map<uint64_t, size_t>{};
+    {
         size_t    cu_header_size = 0;
         Dwarf_Off cu_off         = 0;
         Dwarf_Off next_cu_off    = 0;
-        for(; dwarf_nextcu(_dwarf_v, cu_off, &next_cu_off, &cu_header_size, nullptr,
+        for(; dwarf_nextcu(m_dwarf, cu_off, &next_cu_off, &cu_header_size, nullptr,
                            nullptr, nullptr) == 0;
             cu_off = next_cu_off)
         {
-            auto cu_die_off = cu_off + cu_header_size;
-            auto cu_die     = Dwarf_Die{};
-            if(dwarf_offdie(_dwarf_v, cu_die_off, &cu_die) != nullptr)
-            {
-                Dwarf_Die* _die = &cu_die;
-                if(dwarf_tag(_die) == DW_TAG_compile_unit)
-                {
-                    combine(_entries, get_dwarf_entry(_die));
-                    combine(_ranges, get_dwarf_address_ranges(_die));
-                }
-                else if(dwarf_tag(_die) == DW_TAG_subprogram)
-                {
-                    combine(_bkpts, get_dwarf_breakpoints(_die));
-                    combine(_ranges, get_dwarf_address_ranges(_die));
-                }
-            }
+            _unit_idx.emplace(cu_off + cu_header_size, m_units.size());
+            m_units.emplace_back(cu_off + cu_header_size);
         }
+    }
 
-        dwarf_end(_dwarf_v);
-        utility::filter_sort_unique(_entries);
-        utility::filter_sort_unique(_ranges);
-        utility::filter_sort_unique(_bkpts);
+    auto _covered = std::vector<char>(m_units.size(), 0);
+
+    Dwarf_Aranges* _aranges  = nullptr;
+    size_t         _naranges = 0;
+    if(dwarf_getaranges(m_dwarf, &_aranges, &_naranges) == 0)
+    {
+        for(size_t i = 0; i < _naranges; ++i)
+        {
+            Dwarf_Addr _addr = 0;
+            Dwarf_Word _len  = 0;
+            Dwarf_Off  _off  = 0;
+            auto*      _ar   = dwarf_onearange(_aranges, i);
+            if(!_ar || dwarf_getarangeinfo(_ar, &_addr, &_len, &_off) != 0 || _len == 0)
+                continue;
+            auto itr = _unit_idx.find(_off);
+            if(itr == _unit_idx.end()) continue;
+            m_ranges.emplace_back(unit_range{ { _addr, _addr + _len }, itr->second });
+            _covered.at(itr->second) = 1;
+        }
     }
 
-    return _data_v;
+    // units missing from .debug_aranges (or binaries without the section)
+    for(size_t i = 0; i < m_units.size(); ++i)
+    {
+        auto cu_die = Dwarf_Die{};
+        if(_covered.at(i) != 0) continue;
+        if(dwarf_offdie(m_dwarf, m_units.at(i), &cu_die) == nullptr) continue;
+        for(auto itr : get_dwarf_address_ranges(&cu_die))
+            m_ranges.emplace_back(unit_range{ itr, i });
+    }
+
+    std::sort(m_ranges.begin(), m_ranges.end(),
+              [](const unit_range& _lhs, const unit_range& _rhs) {
+                  return _lhs.range.low < _rhs.range.low;
+              });
+
+    m_decoded.resize(m_units.size());
+}
+
+dwarf_unit_index::~dwarf_unit_index()
+{
+    if(m_dwarf) dwarf_end(m_dwarf);
+    if(m_fd >= 0) ::close(m_fd);
+}
+
+std::deque<dwarf_entry>
+dwarf_unit_index::get_entries(address_range _range)
+{
+    auto _data = std::deque<dwarf_entry>{};
+    if(!m_dwarf) return _data;
+
+    auto _low  = _range.low;
+    auto _high = (_range.is_range()) ? _range.high : (_range.low + 1);
+
+    auto _units = std::vector<size_t>{};
+    for(const auto& itr : m_ranges)
+    {
+        if(itr.range.low >= _high) break;
+        if(itr.range.high > _low) _units.emplace_back(itr.unit);
+    }
+
+    std::sort(_units.begin(), _units.end());
+    _units.erase(std::unique(_units.begin(), _units.end()), _units.end());
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    for(auto itr : _units)
+    {
+        auto& _entries = m_decoded.at(itr);
+        if(!_entries)
+        {
+            auto cu_die = Dwarf_Die{};
+            _entries    = std::make_unique<entries_t>();
+            if(dwarf_offdie(m_dwarf, m_units.at(itr), &cu_die) != nullptr)
+                *_entries = get_dwarf_entry(&cu_die);
+            utility::filter_sort_unique(*_entries);
+        }
+        combine(_data, *_entries);
+    }
+
+    return _data;
+}
+
+std::vector<address_range>
+dwarf_unit_index::get_ranges() const
+{
+    auto _data = std::vector<address_range>{};
+    _data.reserve(m_ranges.size());
+    for(const auto& itr : m_ranges)
+        _data.emplace_back(itr.range);
+    utility::filter_sort_unique(_data);
+    return _data;
+}
+
+size_t
+dwarf_unit_index::decoded() const
+{
+    auto   _lk = std::unique_lock<std::mutex>{ m_mutex };
+    size_t _n  = 0;
+    for(const auto& itr : m_decoded)
+        _n += (itr) ? 1 : 0;
+    return _n;
 }
 
 template <typename ArchiveT>
@@ -24,6 +24,15 @@
 
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
+#include "interned_string.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Dwarf;
 
 namespace omnitrace
 {
@@ -37,18 +46,18 @@ struct dwarf_entry
 
     OMNITRACE_DEFAULT_OBJECT(dwarf_entry)
 
-    bool          begin_statement = false;
-    bool          end_sequence    = false;
-    bool          line_block      = false;
-    bool          prologue_end    = false;
-    bool          epilogue_begin  = false;
-    unsigned int  line            = 0;
-    int           col             = 0;
-    unsigned int  vliw_op_index   = 0;
-    unsigned int  isa             = 0;
-    unsigned int  discriminator   = 0;
-    address_range address         = { 0, 0 };
-    std::string   file            = {};
+    bool            begin_statement = false;
+    bool            end_sequence    = false;
+    bool            line_block      = false;
+    bool            prologue_end    = false;
+    bool            epilogue_begin  = false;
+    unsigned int    line            = 0;
+    int             col             = 0;
+    unsigned int    vliw_op_index   = 0;
+    unsigned int    isa             = 0;
+    unsigned int    discriminator   = 0;
+    address_range   address         = { 0, 0 };
+    interned_string file            = {};
 
     bool is_valid() const;
 
@@ -57,10 +66,51 @@ struct dwarf_entry
     bool     operator!=(const dwarf_entry&) const;
     explicit operator bool() const { return is_valid(); }
 
-    static dwarf_tuple_t process_dwarf(int _fd);
+    // the compilation units are distributed across up to the given number of threads
+    static dwarf_tuple_t process_dwarf(int _fd, size_t _nthreads = 1);
 
     template <typename ArchiveT>
     void serialize(ArchiveT&, const unsigned int);
 };
+
+// maps addresses to the compilation units of a binary (via .debug_aranges or, for
+// the units not listed there, the address ranges of the unit DIE). The line table
+// of a compilation unit is only decoded on the first request for an address inside
+// of it and the decoded entries are retained. Thread-safe.
+struct dwarf_unit_index
+{
+    explicit dwarf_unit_index(int _fd);
+    ~dwarf_unit_index();
+
+    dwarf_unit_index(const dwarf_unit_index&) = delete;
+    dwarf_unit_index(dwarf_unit_index&&)      = delete;
+    dwarf_unit_index& operator=(const dwarf_unit_index&) = delete;
+    dwarf_unit_index& operator=(dwarf_unit_index&&) = delete;
+
+    // line entries of every compilation unit which overlaps the address range
+    std::deque<dwarf_entry> get_entries(address_range);
+
+    // address ranges of the compilation units
+    std::vector<address_range> get_ranges() const;
+
+    size_t size() const { return m_units.size(); }
+    size_t decoded() const;
+
+private:
+    struct unit_range
+    {
+        address_range range = {};
+        size_t        unit  = 0;
+    };
+
+    using entries_t = std::deque<dwarf_entry>;
+
+    int                                     m_fd      = -1;
+    Dwarf*                                  m_dwarf   = nullptr;
+    mutable std::mutex                      m_mutex   = {};
+    std::vector<uint64_t>                   m_units   = {};
+    std::vector<unit_range>                 m_ranges  = {};
+    std::vector<std::unique_ptr<entries_t>> m_decoded = {};
+};
 }  // namespace binary
 }  // namespace omnitrace
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "interned_string.hpp"
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace binary
+{
+namespace
+{
+struct string_table
+{
+    std::mutex                                                mutex   = {};
+    std::deque<std::string>                                   storage = {};
+    std::unordered_map<std::string_view, const std::string*> index   = {};
+};
+
+auto&
+get_string_table()
+{
+    // intentionally leaked since the handles may be used during the static
+    // destruction of the binary info
+    static auto* _v = new string_table{};
+    return *_v;
+}
+}  // namespace
+
+interned_string::interned_string(std::string_view _v)
+{
+    if(_v.empty()) return;
+
+    auto&                        _table = get_string_table();
+    std::unique_lock<std::mutex> _lk{ _table.mutex };
+
+    auto itr = _table.index.find(_v);
+    if(itr == _table.index.end())
+    {
+        // the key is a view of the stored string so it remains valid
+        const auto& _str = _table.storage.emplace_back(_v);
+        itr              = _table.index.emplace(std::string_view{ _str }, &_str).first;
+    }
+    m_value = itr->second;
+}
+
+const std::string*
+interned_string::get_empty()
+{
+    static const auto* _v = new std::string{};
+    return _v;
+}
+}  // namespace binary
+}  // namespace omnitrace
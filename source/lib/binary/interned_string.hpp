@@ -0,0 +1,117 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+namespace binary
+{
+// handle to a string in the process-wide table of the file paths and function names
+// of the binary analysis. Every distinct string is stored once so the line entries and
+// the inlined symbols hold a pointer-sized handle instead of a copy of the path: the
+// copies are trivial and the equality of two handles is a pointer comparison. The
+// table is append-only so the handles (and the views) remain valid until exit
+struct interned_string
+{
+    interned_string() = default;
+    interned_string(std::string_view);
+    interned_string(const std::string& _v)
+    : interned_string{ std::string_view{ _v } }
+    {}
+    interned_string(const char* _v)
+    : interned_string{ (_v) ? std::string_view{ _v } : std::string_view{} }
+    {}
+
+    bool               empty() const { return m_value->empty(); }
+    size_t             size() const { return m_value->size(); }
+    const char*        c_str() const { return m_value->c_str(); }
+    const std::string& str() const { return *m_value; }
+    std::string_view   view() const { return *m_value; }
+
+    operator std::string_view() const { return *m_value; }
+
+    template <typename ArchiveT>
+    std::string save_minimal(const ArchiveT&) const
+    {
+        return *m_value;
+    }
+
+    template <typename ArchiveT>
+    void load_minimal(const ArchiveT&, const std::string& _v)
+    {
+        *this = interned_string{ _v };
+    }
+
+    friend bool operator==(const interned_string& _lhs, const interned_string& _rhs)
+    {
+        return _lhs.m_value == _rhs.m_value;
+    }
+
+    friend bool operator!=(const interned_string& _lhs, const interned_string& _rhs)
+    {
+        return _lhs.m_value != _rhs.m_value;
+    }
+
+    // ordered by the value so that sorting is independent of the order of interning
+    friend bool operator<(const interned_string& _lhs, const interned_string& _rhs)
+    {
+        return _lhs.m_value != _rhs.m_value && *_lhs.m_value < *_rhs.m_value;
+    }
+
+    friend bool operator==(const interned_string& _lhs, const std::string& _rhs)
+    {
+        return *_lhs.m_value == _rhs;
+    }
+
+    friend bool operator==(const std::string& _lhs, const interned_string& _rhs)
+    {
+        return _lhs == *_rhs.m_value;
+    }
+
+    friend bool operator!=(const interned_string& _lhs, const std::string& _rhs)
+    {
+        return *_lhs.m_value != _rhs;
+    }
+
+    friend bool operator!=(const std::string& _lhs, const interned_string& _rhs)
+    {
+        return _lhs != *_rhs.m_value;
+    }
+
+    friend std::ostream& operator<<(std::ostream& _os, const interned_string& _v)
+    {
+        return (_os << *_v.m_value);
+    }
+
+private:
+    static const std::string* get_empty();
+
+    const std::string* m_value = get_empty();
+};
+}  // namespace binary
+}  // namespace omnitrace
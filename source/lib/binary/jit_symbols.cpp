@@ -0,0 +1,370 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "jit_symbols.hpp"
+#include "core/common.hpp"
+#include "core/debug.hpp"
+
+#include <timemory/utility/join.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+namespace omnitrace
+{
+namespace binary
+{
+namespace
+{
+// reads the bytes appended to a file since the previous read. Incomplete lines and
+// records remain in the buffer until the rest of them is appended
+struct tail_reader
+{
+    tail_reader() = default;
+    ~tail_reader()
+    {
+        if(fd >= 0) ::close(fd);
+    }
+
+    tail_reader(const tail_reader&) = delete;
+    tail_reader(tail_reader&&)      = delete;
+    tail_reader& operator=(const tail_reader&) = delete;
+    tail_reader& operator=(tail_reader&&) = delete;
+
+    bool open(const std::string& _path)
+    {
+        fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd >= 0) path = _path;
+        return (fd >= 0);
+    }
+
+    bool read()
+    {
+        if(fd < 0) return false;
+
+        auto _n = buffer.size();
+        char _data[16384];
+        while(true)
+        {
+            auto _ret = ::pread(fd, _data, sizeof(_data), offset);
+            if(_ret <= 0) break;
+            buffer.append(_data, _ret);
+            offset += _ret;
+        }
+        return (buffer.size() > _n);
+    }
+
+    int         fd     = -1;
+    off_t       offset = 0;
+    std::string path   = {};
+    std::string buffer = {};
+};
+
+// the JIT code does not overlap: code which is compiled into the memory of
+// previously freed code replaces the symbols of the freed code
+struct jit_index
+{
+    const jit_symbol* find(uintptr_t _addr) const
+    {
+        auto itr = symbols.upper_bound(_addr);
+        if(itr == symbols.begin()) return nullptr;
+        --itr;
+        return (itr->second.range.contains(_addr)) ? &itr->second : nullptr;
+    }
+
+    void insert(jit_symbol&& _v)
+    {
+        auto _low  = _v.range.low;
+        auto _high = _v.range.high;
+        auto itr   = symbols.lower_bound(_low);
+        if(itr != symbols.begin() && std::prev(itr)->second.range.high > _low)
+            symbols.erase(std::prev(itr));
+        while(itr != symbols.end() && itr->first < _high)
+            itr = symbols.erase(itr);
+        symbols.emplace(_low, std::move(_v));
+    }
+
+    std::map<uintptr_t, jit_symbol> symbols = {};
+};
+
+// "START SIZE name" per line with the start and size in hexadecimal
+void
+parse_perf_map(tail_reader& _reader, jit_index& _index)
+{
+    auto& _buffer = _reader.buffer;
+    auto  _pos    = size_t{ 0 };
+    auto  _eol    = size_t{ 0 };
+    while((_eol = _buffer.find('\n', _pos)) != std::string::npos)
+    {
+        auto      _line  = _buffer.substr(_pos, _eol - _pos);
+        char*     _end   = nullptr;
+        uintptr_t _start = strtoull(_line.c_str(), &_end, 16);
+        uintptr_t _size  = strtoull(_end, &_end, 16);
+        _pos             = _eol + 1;
+
+        while(*_end == ' ' || *_end == '\t')
+            ++_end;
+        if(_size == 0 || *_end == '\0') continue;
+
+        auto _v     = jit_symbol{};
+        _v.range    = address_range{ _start, _start + _size };
+        _v.name     = std::string{ _end };
+        _v.location = _reader.path;
+        _index.insert(std::move(_v));
+    }
+    _buffer.erase(0, _pos);
+}
+
+// see tools/perf/Documentation/jitdump-specification.txt of the linux kernel
+constexpr uint32_t jitdump_magic = 0x4A695444;
+
+enum jitdump_record_id : uint32_t
+{
+    JIT_CODE_LOAD       = 0,
+    JIT_CODE_MOVE       = 1,
+    JIT_CODE_DEBUG_INFO = 2,
+    JIT_CODE_CLOSE      = 3,
+};
+
+struct jitdump_state
+{
+    bool header = false;
+    bool closed = false;
+    // the debug info record of the code precedes the load record
+    std::unordered_map<uintptr_t, std::pair<std::string, unsigned int>> debug_info = {};
+};
+
+template <typename Tp>
+Tp
+read_value(const char*& _data)
+{
+    auto _v = Tp{};
+    memcpy(&_v, _data, sizeof(Tp));
+    _data += sizeof(Tp);
+    return _v;
+}
+
+void
+parse_jitdump(tail_reader& _reader, jitdump_state& _state, jit_index& _index)
+{
+    constexpr size_t header_size = 40;
+    constexpr size_t prefix_size = 16;
+
+    auto&       _buffer = _reader.buffer;
+    const auto* _beg    = _buffer.data();
+    const auto* _end    = _buffer.data() + _buffer.size();
+    const auto* _pos    = _beg;
+
+    if(!_state.header)
+    {
+        if(static_cast<size_t>(_end - _pos) < header_size) return;
+
+        auto _data  = _pos;
+        auto _magic = read_value<uint32_t>(_data);
+        read_value<uint32_t>(_data);  // version
+        auto _size = read_value<uint32_t>(_data);
+        if(_magic != jitdump_magic || _size < header_size)
+        {
+            OMNITRACE_BASIC_VERBOSE(1, "[binary] ignoring invalid jitdump '%s'...\n",
+                                    _reader.path.c_str());
+            _state.closed = true;
+            return;
+        }
+        if(static_cast<size_t>(_end - _pos) < _size) return;
+        _pos += _size;
+        _state.header = true;
+    }
+
+    while(!_state.closed && static_cast<size_t>(_end - _pos) >= prefix_size)
+    {
+        auto _data = _pos;
+        auto _id   = read_value<uint32_t>(_data);
+        auto _size = read_value<uint32_t>(_data);
+        read_value<uint64_t>(_data);  // timestamp
+
+        if(_size < prefix_size) break;
+        if(static_cast<size_t>(_end - _pos) < _size) break;
+
+        const auto* _rec_end = _pos + _size;
+        auto        _avail   = static_cast<size_t>(_rec_end - _data);
+        _pos                 = _rec_end;
+
+        if(_id == JIT_CODE_LOAD && _avail >= 40)
+        {
+            read_value<uint32_t>(_data);  // pid
+            read_value<uint32_t>(_data);  // tid
+            read_value<uint64_t>(_data);  // vma
+            auto _code_addr = read_value<uint64_t>(_data);
+            auto _code_size = read_value<uint64_t>(_data);
+            read_value<uint64_t>(_data);  // code index
+            auto _name = std::string{ _data, strnlen(_data, _rec_end - _data) };
+
+            auto _v  = jit_symbol{};
+            _v.range = address_range{ _code_addr, _code_addr + _code_size };
+            _v.name  = std::move(_name);
+            if(auto itr = _state.debug_info.find(_code_addr);
+               itr != _state.debug_info.end())
+            {
+                _v.location = std::move(itr->second.first);
+                _v.line     = itr->second.second;
+                _state.debug_info.erase(itr);
+            }
+            else
+            {
+                _v.location = _reader.path;
+            }
+            if(_code_size > 0) _index.insert(std::move(_v));
+        }
+        else if(_id == JIT_CODE_MOVE && _avail >= 40)
+        {
+            read_value<uint32_t>(_data);  // pid
+            read_value<uint32_t>(_data);  // tid
+            read_value<uint64_t>(_data);  // vma
+            auto _old_addr = read_value<uint64_t>(_data);
+            auto _new_addr = read_value<uint64_t>(_data);
+            auto _size_v   = read_value<uint64_t>(_data);
+
+            auto itr = _index.symbols.find(_old_addr);
+            if(itr != _index.symbols.end())
+            {
+                auto _v  = std::move(itr->second);
+                _v.range = address_range{ _new_addr, _new_addr + _size_v };
+                _index.symbols.erase(itr);
+                _index.insert(std::move(_v));
+            }
+        }
+        else if(_id == JIT_CODE_DEBUG_INFO && _avail >= 16)
+        {
+            // only the first entry, i.e. the start of the code, is used
+            auto _code_addr = read_value<uint64_t>(_data);
+            auto _nentries  = read_value<uint64_t>(_data);
+            if(_nentries > 0 && _rec_end - _data > 16)
+            {
+                read_value<uint64_t>(_data);  // addr
+                auto _line = read_value<uint32_t>(_data);
+                read_value<uint32_t>(_data);  // discriminator
+                auto _file = std::string{ _data, strnlen(_data, _rec_end - _data) };
+                _state.debug_info[_code_addr] = { std::move(_file), _line };
+            }
+        }
+        else if(_id == JIT_CODE_CLOSE)
+        {
+            _state.closed = true;
+        }
+    }
+
+    _buffer.erase(0, _pos - _beg);
+}
+
+// the JIT maps the jitdump so that perf records the mapping
+std::string
+find_jitdump()
+{
+    auto _suffix = JOIN("", "/jit-", process::get_id(), ".dump");
+    auto _ifs    = std::ifstream{ "/proc/self/maps" };
+    auto _line   = std::string{};
+    while(std::getline(_ifs, _line))
+    {
+        if(_line.length() > _suffix.length() &&
+           _line.compare(_line.length() - _suffix.length(), _suffix.length(),
+                         _suffix) == 0)
+        {
+            auto _path = _line.find('/');
+            if(_path != std::string::npos) return _line.substr(_path);
+        }
+    }
+    return std::string{};
+}
+
+struct jit_symbols
+{
+    std::mutex    mutex   = {};
+    jit_index     index   = {};
+    tail_reader   perfmap = {};
+    tail_reader   jitdump = {};
+    jitdump_state state   = {};
+
+    std::chrono::steady_clock::time_point last_search = {};
+
+    void update();
+};
+
+void
+jit_symbols::update()
+{
+    // the files are searched for at most once per second until they are found
+    constexpr auto search_interval = std::chrono::seconds{ 1 };
+
+    auto _now = std::chrono::steady_clock::now();
+    if((perfmap.fd < 0 || jitdump.fd < 0) && _now - last_search >= search_interval)
+    {
+        last_search = _now;
+        if(perfmap.fd < 0)
+            perfmap.open(JOIN("", "/tmp/perf-", process::get_id(), ".map"));
+        if(jitdump.fd < 0)
+        {
+            auto _path = find_jitdump();
+            if(!_path.empty()) jitdump.open(_path);
+        }
+    }
+
+    if(perfmap.read()) parse_perf_map(perfmap, index);
+    if(!state.closed && jitdump.read()) parse_jitdump(jitdump, state, index);
+}
+
+auto&
+get_jit_symbols()
+{
+    // intentionally leaked since the samples may be resolved during static destruction
+    static auto* _v = new jit_symbols{};
+    return *_v;
+}
+}  // namespace
+
+std::optional<jit_symbol>
+lookup_jit_symbol(uintptr_t _addr)
+{
+    auto& _syms = get_jit_symbols();
+    auto  _lk   = std::unique_lock<std::mutex>{ _syms.mutex };
+
+    const auto* _v = _syms.index.find(_addr);
+    if(!_v)
+    {
+        _syms.update();
+        _v = _syms.index.find(_addr);
+    }
+
+    return (_v) ? std::optional<jit_symbol>{ *_v } : std::optional<jit_symbol>{};
+}
+}  // namespace binary
+}  // namespace omnitrace
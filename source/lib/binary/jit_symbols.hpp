@@ -0,0 +1,52 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/binary/address_range.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace omnitrace
+{
+namespace binary
+{
+// symbol of JIT-compiled code. The location is the source file from the debug info
+// of the jitdump or, when there is none, the file which provided the symbol
+struct jit_symbol
+{
+    address_range range    = {};
+    std::string   name     = {};
+    std::string   location = {};
+    unsigned int  line     = 0;
+};
+
+// finds the JIT-compiled code containing the address in the perf map
+// (/tmp/perf-<pid>.map) and the jitdump (jit-<pid>.dump, found via the mapping the
+// JIT creates for perf) of the process. Both files are followed as the JIT appends
+// to them: a lookup which misses reads the symbols appended since the previous one
+std::optional<jit_symbol>
+lookup_jit_symbol(uintptr_t);
+}  // namespace binary
+}  // namespace omnitrace
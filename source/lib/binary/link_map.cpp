@@ -28,9 +28,12 @@
 
 #include <timemory/utility/filepath.hpp>
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <dlfcn.h>
 #include <link.h>
+#include <mutex>
 #include <set>
 #include <string>
 #include <string_view>
@@ -151,6 +154,53 @@ get_link_map(const char* _lib, const std::string& _exclude_linked_by,
     return _fini_chain;
 }
 
+std::optional<std::set<std::string>>
+get_loaded_objects_if_changed()
+{
+    struct counters
+    {
+        unsigned long long adds = 0;
+        unsigned long long subs = 0;
+        bool               good = false;
+    };
+
+    static auto _mutex = std::mutex{};
+    static auto _last  = counters{};
+
+    auto _lk = std::unique_lock<std::mutex>{ _mutex };
+
+    // the counters are identical for every object so only the first is visited
+    auto _curr = counters{};
+    dl_iterate_phdr(
+        [](dl_phdr_info* _info, size_t _size, void* _data) {
+            auto* _v = static_cast<counters*>(_data);
+            if(_size >= offsetof(dl_phdr_info, dlpi_subs) + sizeof(_info->dlpi_subs))
+            {
+                _v->adds = _info->dlpi_adds;
+                _v->subs = _info->dlpi_subs;
+                _v->good = true;
+            }
+            return 1;
+        },
+        &_curr);
+
+    if(_curr.good && _last.good && _curr.adds == _last.adds && _curr.subs == _last.subs)
+        return std::optional<std::set<std::string>>{};
+    _last = _curr;
+
+    auto _v = std::set<std::string>{};
+    dl_iterate_phdr(
+        [](dl_phdr_info* _info, size_t, void* _data) {
+            if(_info->dlpi_name && strlen(_info->dlpi_name) > 0)
+                static_cast<std::set<std::string>*>(_data)->emplace(
+                    filepath::realpath(_info->dlpi_name, nullptr, false));
+            return 0;
+        },
+        &_v);
+
+    return _v;
+}
+
 bool
 link_file::operator<(const link_file& _rhs) const
 {
@@ -60,5 +60,11 @@ get_link_map(const char*        _lib               = nullptr,
              const std::string& _exclude_linked_by = "libomnitrace.so",
              const std::string& _exclude_re        = "libomnitrace-([a-zA-Z]+)\\.so",
              open_modes_vec_t&& _open_modes        = {});
+
+// returns the real paths of the loaded shared objects when objects were loaded or
+// unloaded (e.g. via dlopen/dlclose) since the previous call. The change is detected
+// via the load and unload counters of dl_iterate_phdr so an unchanged set is cheap
+std::optional<std::set<std::string>>
+get_loaded_objects_if_changed();
 }  // namespace binary
 }  // namespace omnitrace
@@ -24,22 +24,124 @@
 #include "core/exception.hpp"
 
 #include <regex>
+#include <string>
+#include <string_view>
 
 namespace omnitrace
 {
 namespace binary
 {
+namespace
+{
+// characters which have special meaning in an ECMAScript regular expression
+constexpr auto regex_metachars = std::string_view{ ".^$|()[]{}*+?\\" };
+
+// attempts to lower the expression to a literal string with optional anchors.
+// Returns false if the expression requires a full regex engine
+bool
+get_literal(std::string_view _expr, std::string& _literal, bool& _prefix, bool& _suffix)
+{
+    _literal.clear();
+    _prefix = false;
+    _suffix = false;
+
+    if(!_expr.empty() && _expr.front() == '^')
+    {
+        _prefix = true;
+        _expr.remove_prefix(1);
+    }
+
+    for(size_t i = 0; i < _expr.length(); ++i)
+    {
+        auto _c = _expr.at(i);
+        if(_c == '\\')
+        {
+            // escaped metacharacters are literals, other escapes (\d, \w, ...) are not
+            if(i + 1 < _expr.length() &&
+               regex_metachars.find(_expr.at(i + 1)) != std::string_view::npos)
+            {
+                _literal += _expr.at(++i);
+                continue;
+            }
+            return false;
+        }
+        else if(_c == '$' && i + 1 == _expr.length())
+        {
+            _suffix = true;
+        }
+        else if(regex_metachars.find(_c) != std::string_view::npos)
+        {
+            return false;
+        }
+        else
+        {
+            _literal += _c;
+        }
+    }
+
+    return true;
+}
+}  // namespace
+
+scope_filter::scope_filter(filter_mode _mode, filter_scope _scope, std::string _expr)
+: mode{ _mode }
+, scope{ _scope }
+, expression{ std::move(_expr) }
+{
+    if(expression.empty())
+    {
+        m_kind = MATCH_EMPTY;
+        return;
+    }
+
+    bool _prefix = false;
+    bool _suffix = false;
+    if(get_literal(expression, m_literal, _prefix, _suffix))
+    {
+        if(_prefix && _suffix)
+            m_kind = MATCH_EXACT;
+        else if(_prefix)
+            m_kind = MATCH_PREFIX;
+        else if(_suffix)
+            m_kind = MATCH_SUFFIX;
+        else
+            m_kind = MATCH_SUBSTR;
+    }
+    else
+    {
+        m_literal.clear();
+        m_kind  = MATCH_REGEX;
+        m_regex = std::make_shared<const std::regex>(
+            expression,
+            std::regex_constants::ECMAScript | std::regex_constants::optimize);
+    }
+}
+
+bool
+scope_filter::matches(std::string_view _value) const
+{
+    switch(m_kind)
+    {
+        case MATCH_EMPTY: return true;
+        case MATCH_SUBSTR: return (_value.find(m_literal) != std::string_view::npos);
+        case MATCH_PREFIX: return (_value.substr(0, m_literal.length()) == m_literal);
+        case MATCH_SUFFIX:
+            return (_value.length() >= m_literal.length() &&
+                    _value.substr(_value.length() - m_literal.length()) == m_literal);
+        case MATCH_EXACT: return (_value == m_literal);
+        case MATCH_REGEX:
+            return std::regex_search(_value.begin(), _value.end(), *m_regex);
+    }
+    throw exception<std::runtime_error>{ "invalid scope filter match kind" };
+}
+
 bool
 scope_filter::operator()(std::string_view _value) const
 {
     if(mode == FILTER_INCLUDE)
-        return (expression.empty())
-                   ? true
-                   : std::regex_search(_value.data(), std::regex{ expression });
+        return (m_kind == MATCH_EMPTY) ? true : matches(_value);
     else if(mode == FILTER_EXCLUDE)
-        return (expression.empty())
-                   ? false
-                   : !std::regex_search(_value.data(), std::regex{ expression });
+        return (m_kind == MATCH_EMPTY) ? false : !matches(_value);
     throw exception<std::runtime_error>{ "invalid scope filter mode" };
 }
 }  // namespace binary
@@ -25,7 +25,10 @@
 #include "core/defines.hpp"
 
 #include <cstdint>
+#include <memory>
+#include <regex>
 #include <string>
+#include <string_view>
 
 namespace omnitrace
 {
@@ -47,15 +50,41 @@ struct scope_filter
         FUNCTION_FILTER  = (1 << 3)
     };
 
+    // how the expression is evaluated. Expressions without regex metacharacters
+    // (optionally anchored with ^ and/or $) are lowered to plain string comparisons
+    enum match_kind : uint8_t
+    {
+        MATCH_EMPTY = 0,
+        MATCH_SUBSTR,
+        MATCH_PREFIX,
+        MATCH_SUFFIX,
+        MATCH_EXACT,
+        MATCH_REGEX
+    };
+
+    scope_filter() = default;
+    scope_filter(filter_mode, filter_scope, std::string);
+
     filter_mode  mode       = FILTER_INCLUDE;
     filter_scope scope      = UNIVERSAL_FILTER;
     std::string  expression = {};
 
     bool operator()(std::string_view _value) const;
 
+    // returns true if the expression matches the value (independent of mode)
+    bool       matches(std::string_view _value) const;
+    match_kind get_match_kind() const { return m_kind; }
+
     template <typename ContainerT>
     static bool satisfies_filter(const ContainerT&, filter_scope,
                                  std::string_view) OMNITRACE_PURE;
+
+private:
+    // the compiled matcher is computed once at construction and shared between
+    // copies so that filter evaluation never constructs a std::regex
+    match_kind                        m_kind    = MATCH_EMPTY;
+    std::string                       m_literal = {};
+    std::shared_ptr<const std::regex> m_regex   = {};
 };
 
 template <typename ContainerT>
@@ -43,6 +43,7 @@
 #include "core/binary/fwd.hpp"
 #include "core/timemory.hpp"
 #include "core/utility.hpp"
+#include "address_index.hpp"
 #include "dwarf_entry.hpp"
 #include "scope_filter.hpp"
 #include "symbol.hpp"
@@ -78,6 +79,16 @@ read_inliner_info(bfd* _inp)
 
     return _data;
 }
+
+template <typename Tp>
+bool
+satisfies_source_filter(const std::vector<scope_filter>& _filters, const Tp& _file,
+                        unsigned int _line)
+{
+    using sf = scope_filter;
+    return (sf::satisfies_filter(_filters, sf::SOURCE_FILTER, _file) ||
+            sf::satisfies_filter(_filters, sf::SOURCE_FILTER, join(':', _file, _line)));
+}
 }  // namespace
 
 symbol::symbol(const base_type& _v)
@@ -157,31 +168,76 @@ symbol::read_dwarf_entries(const std::deque<dwarf_entry>& _info)
         if(address.contains(itr.address)) dwarf_info.emplace_back(itr);
     }
 
+    return finalize_dwarf_entries();
+}
+
+size_t
+symbol::read_dwarf_entries(std::deque<symbol>&            _syms,
+                           const std::deque<dwarf_entry>& _info)
+{
+    // the entries and the symbols are sorted by their low address once and the
+    // entries are assigned in a single sweep instead of scanning every entry for
+    // every symbol. An entry is only contained in a symbol if its low address is
+    // within the symbol so the scan of each symbol starts at the first entry at or
+    // after the low address of the symbol
+    auto _by_low = [](const auto* _lhs, const auto* _rhs) {
+        return _lhs->address.low < _rhs->address.low;
+    };
+
+    auto _entries = std::vector<const dwarf_entry*>{};
+    _entries.reserve(_info.size());
+    for(const auto& itr : _info)
+        _entries.emplace_back(&itr);
+    std::stable_sort(_entries.begin(), _entries.end(), _by_low);
+
+    auto _order = std::vector<symbol*>{};
+    _order.reserve(_syms.size());
+    for(auto& itr : _syms)
+        _order.emplace_back(&itr);
+    std::stable_sort(_order.begin(), _order.end(), _by_low);
+
+    size_t _n   = 0;
+    auto   _beg = _entries.begin();
+    for(auto* sitr : _order)
+    {
+        auto _low  = sitr->address.low;
+        auto _high = std::max(sitr->address.high, _low + 1);
+        while(_beg != _entries.end() && (*_beg)->address.low < _low)
+            ++_beg;
+
+        for(auto eitr = _beg; eitr != _entries.end() && (*eitr)->address.low < _high;
+            ++eitr)
+        {
+            if(sitr->address.contains((*eitr)->address))
+                sitr->dwarf_info.emplace_back(**eitr);
+        }
+        _n += sitr->finalize_dwarf_entries();
+    }
+
+    return _n;
+}
+
+size_t
+symbol::finalize_dwarf_entries()
+{
     // make sure the dwarf info is sorted by address (low to high)
     std::sort(dwarf_info.begin(), dwarf_info.end(),
               [](const dwarf_entry& _lhs, const dwarf_entry& _rhs) {
                   return _lhs.address < _rhs.address;
               });
 
-    // helper for getting the end address
-    auto _get_next_address = [&](auto nitr, uintptr_t _low) {
-        while(++nitr != dwarf_info.end())
+    // convert the single addresses into ranges which end at the next higher low
+    // address (or the end address of the symbol) in one backward pass. If the
+    // address is already a range, it is not updated
+    auto _next = address.high;
+    for(auto itr = dwarf_info.rbegin(); itr != dwarf_info.rend();)
+    {
+        auto _low = itr->address.low;
+        for(; itr != dwarf_info.rend() && itr->address.low == _low; ++itr)
         {
-            if(nitr->address.low > _low)
-            {
-                return nitr->address.low;
-            }
+            if(!itr->address.is_range()) itr->address = address_range{ _low, _next };
         }
-        // return the end address of the symbol
-        return address.high;
-    };
-    // convert the single addresses into ranges
-    for(auto itr = dwarf_info.begin(); itr != dwarf_info.end(); ++itr)
-    {
-        // if address is already a range, do not update it
-        if(!itr->address.is_range())
-            itr->address = address_range{ itr->address.low,
-                                          _get_next_address(itr, itr->address.low) };
+        _next = _low;
     }
 
     std::sort(dwarf_info.begin(), dwarf_info.end(),
@@ -283,10 +339,9 @@ symbol::get_inline_symbols(const std::vector<scope_filter>& _filters) const
 
     for(const auto& itr : inlines)
     {
-        if(sf::satisfies_filter(_filters, sf::FUNCTION_FILTER, demangle(itr.func)) &&
-           (sf::satisfies_filter(_filters, sf::SOURCE_FILTER, itr.file) ||
-            sf::satisfies_filter(_filters, sf::SOURCE_FILTER,
-                                 join(':', itr.file, itr.line))))
+        if(sf::satisfies_filter(_filters, sf::FUNCTION_FILTER,
+                                demangle(itr.func.str())) &&
+           satisfies_source_filter(_filters, itr.file, itr.line))
         {
             if constexpr(concepts::is_unqualified_same<value_type, symbol>::value)
             {
@@ -307,43 +362,93 @@ symbol::get_inline_symbols(const std::vector<scope_filter>& _filters) const
     return _data;
 }
 
+template <typename Tp>
+void
+symbol::append_debug_line_info(Tp& _data, const std::vector<scope_filter>& _filters,
+                               const dwarf_entry& _entry) const
+{
+    using value_type = typename Tp::value_type;
+
+    if(satisfies_source_filter(_filters, _entry.file, _entry.line))
+    {
+        if constexpr(concepts::is_unqualified_same<value_type, symbol>::value)
+        {
+            auto _sym    = clone();
+            _sym.address = _entry.address;
+            _sym.file    = _entry.file;
+            _sym.line    = _entry.line;
+            _data.emplace_back(_sym);
+        }
+        else if constexpr(concepts::is_unqualified_same<value_type, dwarf_entry>::value)
+        {
+            _data.emplace_back(_entry);
+        }
+    }
+}
+
 template <typename Tp>
 Tp
 symbol::get_debug_line_info(const std::vector<scope_filter>& _filters) const
 {
-    using sf         = scope_filter;
-    using value_type = typename Tp::value_type;
+    using sf = scope_filter;
 
     auto _data = Tp{};
 
     if(sf::satisfies_filter(_filters, sf::FUNCTION_FILTER, demangle(func)))
     {
         for(const auto& itr : dwarf_info)
-        {
-            if(sf::satisfies_filter(_filters, sf::SOURCE_FILTER, itr.file) ||
-               sf::satisfies_filter(_filters, sf::SOURCE_FILTER,
-                                    join(':', itr.file, itr.line)))
-            {
-                if constexpr(concepts::is_unqualified_same<value_type, symbol>::value)
-                {
-                    auto _sym    = clone();
-                    _sym.address = itr.address;
-                    _sym.file    = itr.file;
-                    _sym.line    = itr.line;
-                    _data.emplace_back(_sym);
-                }
-                else if constexpr(concepts::is_unqualified_same<value_type,
-                                                                dwarf_entry>::value)
-                {
-                    _data.emplace_back(itr);
-                }
-            }
-        }
+            append_debug_line_info(_data, _filters, itr);
     }
 
     return _data;
 }
 
+template <typename Tp>
+Tp
+symbol::get_debug_line_info(const std::vector<scope_filter>& _filters,
+                            const address_index& _index, uintptr_t _addr) const
+{
+    using sf = scope_filter;
+
+    auto _data = Tp{};
+
+    if(_index.empty()) return _data;
+
+    if(sf::satisfies_filter(_filters, sf::FUNCTION_FILTER, demangle(func)))
+    {
+        _index.find(_addr, [&](size_t _idx) {
+            append_debug_line_info(_data, _filters, dwarf_info.at(_idx));
+        });
+    }
+
+    return _data;
+}
+
+bool
+symbol::has_inline_symbols(const std::vector<scope_filter>& _filters) const
+{
+    using sf = scope_filter;
+
+    return std::any_of(inlines.begin(), inlines.end(), [&_filters](const auto& itr) {
+        return sf::satisfies_filter(_filters, sf::FUNCTION_FILTER,
+                                    demangle(itr.func.str())) &&
+               satisfies_source_filter(_filters, itr.file, itr.line);
+    });
+}
+
+bool
+symbol::has_debug_line_info(const std::vector<scope_filter>& _filters) const
+{
+    using sf = scope_filter;
+
+    auto _satisfies = [&_filters](const dwarf_entry& itr) {
+        return satisfies_source_filter(_filters, itr.file, itr.line);
+    };
+
+    return sf::satisfies_filter(_filters, sf::FUNCTION_FILTER, demangle(func)) &&
+           std::any_of(dwarf_info.begin(), dwarf_info.end(), _satisfies);
+}
+
 template <typename ArchiveT>
 void
 inlined_symbol::serialize(ArchiveT& ar, const unsigned int)
@@ -403,5 +508,9 @@ symbol::get_debug_line_info<std::deque<symbol>>(
 template std::vector<dwarf_entry>
 symbol::get_debug_line_info<std::vector<dwarf_entry>>(
     const std::vector<scope_filter>& _filters) const;
+
+template std::deque<symbol>
+symbol::get_debug_line_info<std::deque<symbol>>(const std::vector<scope_filter>&,
+                                                const address_index&, uintptr_t) const;
 }  // namespace binary
 }  // namespace omnitrace
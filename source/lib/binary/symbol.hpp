@@ -24,6 +24,7 @@
 
 #include "core/binary/address_range.hpp"
 #include "core/binary/fwd.hpp"
+#include "interned_string.hpp"
 
 #include <timemory/unwind/bfd.hpp>
 
@@ -38,9 +39,9 @@ namespace binary
 {
 struct inlined_symbol
 {
-    unsigned int line = 0;
-    std::string  file = {};
-    std::string  func = {};
+    unsigned int    line = 0;
+    interned_string file = {};
+    interned_string func = {};
 
     template <typename ArchiveT>
     void serialize(ArchiveT&, const unsigned int);
@@ -72,12 +73,26 @@ struct symbol : private tim::unwind::bfd_file::symbol
     address_range ipaddr() const { return address + load_address; }
     symbol        clone() const;
 
+    // equivalent to read_dwarf_entries on every symbol but the entries are assigned in
+    // a single sweep over the symbols and the entries sorted by address
+    static size_t read_dwarf_entries(std::deque<symbol>&, const std::deque<dwarf_entry>&);
+
     template <typename Tp = std::deque<symbol>>
     Tp get_inline_symbols(const std::vector<scope_filter>&) const;
 
+    // whether get_inline_symbols / get_debug_line_info would return any entries
+    bool has_inline_symbols(const std::vector<scope_filter>&) const;
+    bool has_debug_line_info(const std::vector<scope_filter>&) const;
+
     template <typename Tp = std::deque<symbol>>
     Tp get_debug_line_info(const std::vector<scope_filter>&) const;
 
+    // same as above but restricted to the entries of the (index over dwarf_info)
+    // which contain the given address
+    template <typename Tp = std::deque<symbol>>
+    Tp get_debug_line_info(const std::vector<scope_filter>&, const address_index&,
+                           uintptr_t) const;
+
     template <typename ArchiveT>
     void serialize(ArchiveT&, const unsigned int);
 
@@ -93,6 +108,15 @@ struct symbol : private tim::unwind::bfd_file::symbol
     std::vector<uintptr_t>      breakpoints  = {};
     std::vector<inlined_symbol> inlines      = {};
     std::vector<dwarf_entry>    dwarf_info   = {};
+
+private:
+    friend struct binary_cache;
+
+    size_t finalize_dwarf_entries();
+
+    template <typename Tp>
+    void append_debug_line_info(Tp&, const std::vector<scope_filter>&,
+                                const dwarf_entry&) const;
 };
 }  // namespace binary
 }  // namespace omnitrace
@@ -0,0 +1,99 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+inline namespace common
+{
+// layout of the control file (OMNITRACE_CONTROL_FILE) which is mapped by the process
+// and by omnitrace-ctl. The process writes the header and the category names once and
+// the overrides are written by omnitrace-ctl. The overrides are read on the hot path
+// with relaxed loads so the atomics must be lock-free (and thus address-free)
+struct control_block
+{
+    static constexpr uint64_t magic          = 0x6c7274632d6f6d6fULL;
+    static constexpr uint32_t version        = 1;
+    static constexpr size_t   max_categories = 64;
+    static constexpr size_t   name_length    = 32;
+    static constexpr size_t   function_bits  = (1UL << 16);
+
+    enum category_state : uint8_t
+    {
+        category_default = 0,  // follow OMNITRACE_ENABLE_CATEGORIES, triggers, etc.
+        category_on,
+        category_off,
+    };
+
+    enum function_mode : uint8_t
+    {
+        function_all = 0,  // the function bits are ignored
+        function_include,  // only the functions whose bit is set are recorded
+        function_exclude,  // the functions whose bit is set are not recorded
+    };
+
+    // no default member initializers so that a static instance is zero-initialized
+    // without a dynamic initializer. The file is zero-filled when it is created
+    uint64_t              header;  // magic, written last by the process
+    uint32_t              header_version;
+    uint32_t              num_categories;
+    int64_t               pid;
+    std::atomic<uint64_t> generation;  // incremented by omnitrace-ctl on every change
+    std::atomic<uint8_t>  mode;
+    std::atomic<uint8_t>  categories[max_categories];
+    char                  names[max_categories][name_length];
+    std::atomic<uint64_t> functions[function_bits / 64];
+};
+
+static_assert(std::atomic<uint8_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "control_block requires lock-free atomics");
+
+// FNV-1a of the function or region name so that omnitrace-ctl computes the same bit as
+// the process. Distinct names may share a bit
+inline size_t
+get_control_function_bit(std::string_view _name)
+{
+    uint64_t _v = 0xcbf29ce484222325ULL;
+    for(auto itr : _name)
+    {
+        _v ^= static_cast<unsigned char>(itr);
+        _v *= 0x100000001b3ULL;
+    }
+    return static_cast<size_t>(_v & (control_block::function_bits - 1));
+}
+
+inline std::string
+get_control_filename(std::string_view _tmpdir, int64_t _pid)
+{
+    return std::string{ _tmpdir } + "/omnitrace-control-" + std::to_string(_pid) +
+           ".dat";
+}
+}  // namespace common
+}  // namespace omnitrace
@@ -1265,6 +1265,35 @@ add_core_arguments(parser_t& _parser, parser_data& _data)
         _data.processed_environs.emplace("hsa_interrupt");
     }
 
+    if(_data.environ_filter("lazy_init", _data))
+    {
+        _parser
+            .add_argument({ "--lazy-init" },
+                          "Defer loading omnitrace until the first enabled event (e.g. a "
+                          "user region or omnitrace_user_start_trace) and look up its "
+                          "symbols on their first use. Reduces the startup cost of "
+                          "processes which are never profiled")
+            .max_count(1)
+            .action([&](parser_t& p) {
+                update_env(_data, "OMNITRACE_LAZY_INIT", p.get<bool>("lazy-init"));
+            });
+
+        _data.processed_environs.emplace("lazy_init");
+    }
+
+    if(_data.environ_filter("dl_init_timing", _data))
+    {
+        _parser
+            .add_argument({ "--init-timing" },
+                          "Print the time spent loading and initializing omnitrace")
+            .max_count(1)
+            .action([&](parser_t& p) {
+                update_env(_data, "OMNITRACE_DL_INIT_TIMING", p.get<bool>("init-timing"));
+            });
+
+        _data.processed_environs.emplace("dl_init_timing");
+    }
+
     _parser.end_group();
 
     return _data;
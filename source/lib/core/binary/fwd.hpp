@@ -54,6 +54,7 @@ using hash_value_t = ::tim::hash_value_t;
 
 struct address_range;
 struct address_multirange;
+struct address_index;
 struct scope_filter;
 struct symbol;
 struct dwarf_entry;
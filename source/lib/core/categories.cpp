@@ -28,8 +28,11 @@
 #include "core/timemory.hpp"
 #include "core/utility.hpp"
 
+#include <atomic>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace omnitrace
 {
@@ -41,6 +44,13 @@ template <typename Tp>
 void
 configure_categories(bool _enable, const std::set<std::string>& _categories)
 {
+    // categories which were compiled out stay disabled
+    if constexpr(!is_compiled<Tp>())
+    {
+        trait::runtime_enabled<Tp>::set(false);
+        return;
+    }
+
     auto _name = trait::name<Tp>::value;
     if(_categories.count(_name) > 0)
     {
@@ -67,8 +77,34 @@ configure_categories(bool _enable, const std::set<std::string>& _categories)
         _enable, _categories,
         utility::make_index_sequence_range<1, OMNITRACE_CATEGORY_LAST>{});
 }
+
+struct window_state
+{
+    std::mutex                     mutex     = {};
+    std::atomic<bool>              open      = { true };
+    std::vector<window_callback_t> callbacks = {};
+};
+
+auto&
+get_window_state()
+{
+    static auto* _v = new window_state{};
+    return *_v;
+}
 }  // namespace
 
+void
+set_window(bool _open)
+{
+    auto& _state = get_window_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+    if(_state.open.exchange(_open) == _open) return;
+
+    OMNITRACE_VERBOSE_F(2, "%s trace window...\n", (_open) ? "Entering" : "Leaving");
+    for(auto& itr : _state.callbacks)
+        itr(_open);
+}
+
 void
 enable_categories(const std::set<std::string>& _categories)
 {
@@ -98,12 +134,17 @@ setup()
         auto _trace_stages = constraint::get_trace_stages();
 
         _trace_stages.init = [](const constraint::spec& _spec) {
-            if(_spec.delay > 1.0e-3) disable_categories(config::get_enabled_categories());
+            if(_spec.delay > 1.0e-3)
+            {
+                disable_categories(config::get_enabled_categories());
+                set_window(false);
+            }
             return get_state() < State::Finalized;
         };
 
         _trace_stages.start = [](const constraint::spec&) {
             enable_categories(config::get_enabled_categories());
+            if(get_state() < State::Finalized) set_window(true);
             return get_state() < State::Finalized;
         };
 
@@ -111,7 +152,10 @@ setup()
             // only disable categories if not finalized since this might run in background
             // during finalization and disable output of data in those categories
             if(get_state() < State::Finalized)
+            {
                 disable_categories(config::get_enabled_categories());
+                set_window(false);
+            }
             return get_state() < State::Finalized;
         };
 
@@ -120,7 +164,10 @@ setup()
                         // ensure all categories are disabled before proceeding
                         // if a delay is requested
                         if(_trace_specs.front().delay > 1.0e-3)
+                        {
                             disable_categories(config::get_enabled_categories());
+                            set_window(false);
+                        }
                         _prom->set_value();
                         for(const auto& itr : _trace_specs)
                             itr(_trace_stages);
@@ -137,5 +184,20 @@ shutdown()
 {
     disable_categories(config::get_enabled_categories());
 }
+
+void
+add_window_callback(window_callback_t&& _func)
+{
+    auto& _state = get_window_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+    if(!_state.open) _func(false);
+    _state.callbacks.emplace_back(std::move(_func));
+}
+
+bool
+in_window()
+{
+    return get_window_state().open.load();
+}
 }  // namespace categories
 }  // namespace omnitrace
@@ -129,6 +129,17 @@ OMNITRACE_DEFINE_CATEGORY(category, kernel_hardware_counter, OMNITRACE_CATEGORY_
 OMNITRACE_DEFINE_CATEGORY(category, numa, OMNITRACE_CATEGORY_NUMA, "numa", "Non-unified memory architecture")
 OMNITRACE_DEFINE_CATEGORY(category, timer_sampling, OMNITRACE_CATEGORY_TIMER_SAMPLING, "timer_sampling", "Sampling based on a timer")
 OMNITRACE_DEFINE_CATEGORY(category, overflow_sampling, OMNITRACE_CATEGORY_OVERFLOW_SAMPLING, "overflow_sampling", "Sampling based on a counter overflow")
+OMNITRACE_DEFINE_CATEGORY(category, device_ompt, OMNITRACE_CATEGORY_DEVICE_OMPT, "device_ompt", "Device-side OpenMP target kernels and data transfers")
+OMNITRACE_DEFINE_CATEGORY(category, cpu_sampling, OMNITRACE_CATEGORY_CPU_SAMPLING, "cpu_sampling", "System-wide sampling of the processes running on each CPU")
+OMNITRACE_DEFINE_CATEGORY(category, off_cpu, OMNITRACE_CATEGORY_OFF_CPU, "off_cpu", "Intervals in which the threads were blocked or preempted")
+OMNITRACE_DEFINE_CATEGORY(category, self_overhead, OMNITRACE_CATEGORY_SELF_OVERHEAD, "self_overhead", "Time spent inside omnitrace")
+OMNITRACE_DEFINE_CATEGORY(category, heap, OMNITRACE_CATEGORY_HEAP, "heap", "Sampled heap allocations")
+OMNITRACE_DEFINE_CATEGORY(category, io, OMNITRACE_CATEGORY_IO, "io", "POSIX and MPI-IO file operations")
+OMNITRACE_DEFINE_CATEGORY(category, network, OMNITRACE_CATEGORY_NETWORK, "network_bandwidth", "Network interface receive and transmit bandwidth (collected in background thread)")
+OMNITRACE_DEFINE_CATEGORY(category, cpu_energy, OMNITRACE_CATEGORY_CPU_ENERGY, "cpu_energy", "CPU package and DRAM power from the RAPL energy counters (collected in background thread)")
+OMNITRACE_DEFINE_CATEGORY(category, cgroup, OMNITRACE_CATEGORY_CGROUP, "cgroup", "CPU usage, CPU throttling, and memory of the cgroup of the process (collected in background thread)")
+OMNITRACE_DEFINE_CATEGORY(category, python_gil, OMNITRACE_CATEGORY_PYTHON_GIL, "python_gil", "Intervals in which the Python threads waited for and held the GIL")
+OMNITRACE_DEFINE_CATEGORY(category, memory_bandwidth, OMNITRACE_CATEGORY_MEMORY_BANDWIDTH, "memory_bandwidth", "DRAM read and write bandwidth of each socket from the uncore or data fabric PMUs (collected in background thread)")
 
 OMNITRACE_DECLARE_CATEGORY(category, sampling, OMNITRACE_CATEGORY_SAMPLING, "sampling", "Host-side call-stack sampling")
 // clang-format on
@@ -190,14 +201,27 @@ using name = perfetto_category<Tp...>;
         OMNITRACE_PERFETTO_CATEGORY(category::numa),                                     \
         OMNITRACE_PERFETTO_CATEGORY(category::timer_sampling),                           \
         OMNITRACE_PERFETTO_CATEGORY(category::overflow_sampling),                        \
+        OMNITRACE_PERFETTO_CATEGORY(category::device_ompt),                              \
+        OMNITRACE_PERFETTO_CATEGORY(category::cpu_sampling),                             \
+        OMNITRACE_PERFETTO_CATEGORY(category::off_cpu),                                  \
+        OMNITRACE_PERFETTO_CATEGORY(category::self_overhead),                            \
+        OMNITRACE_PERFETTO_CATEGORY(category::heap),                                     \
+        OMNITRACE_PERFETTO_CATEGORY(category::io),                                       \
+        OMNITRACE_PERFETTO_CATEGORY(category::network),                                  \
+        OMNITRACE_PERFETTO_CATEGORY(category::cpu_energy),                               \
+        OMNITRACE_PERFETTO_CATEGORY(category::cgroup),                                   \
+        OMNITRACE_PERFETTO_CATEGORY(category::python_gil),                               \
+        OMNITRACE_PERFETTO_CATEGORY(category::memory_bandwidth),                         \
         ::perfetto::Category("timemory").SetDescription("Events from the timemory API")
 
 #if defined(TIMEMORY_USE_PERFETTO)
 #    define TIMEMORY_PERFETTO_CATEGORIES OMNITRACE_PERFETTO_CATEGORIES
 #endif
 
+#include <functional>
 #include <set>
 #include <string>
+#include <string_view>
 
 namespace omnitrace
 {
@@ -223,5 +247,49 @@ setup();
 
 void
 shutdown();
+
+// the callbacks are invoked by the background thread of the trace windows
+// (OMNITRACE_TRACE_DELAY, OMNITRACE_TRACE_DURATION, OMNITRACE_TRACE_PERIODS) with
+// false when the enabled categories are disabled at the end of (or the delay before)
+// a window and with true when a window starts. Callbacks added while outside a
+// window are invoked immediately
+using window_callback_t = std::function<void(bool)>;
+
+void
+add_window_callback(window_callback_t&&);
+
+// opens or closes the trace window outside of the trace periods, e.g. from the
+// triggers in OMNITRACE_TRIGGERS. Only invokes the callbacks when the state changes
+void
+set_window(bool _open);
+
+// false while outside of the trace windows
+bool
+in_window();
+
+// OMNITRACE_COMPILED_CATEGORIES: the categories which are not in the (non-empty) list
+// are compiled out, i.e. the region helpers in the library reduce to no-ops
+inline constexpr std::string_view compiled = OMNITRACE_COMPILED_CATEGORIES;
+
+constexpr bool
+is_compiled(std::string_view _name, std::string_view _list = compiled)
+{
+    if(_list.empty()) return true;
+    while(!_list.empty())
+    {
+        auto _pos = _list.find(',');
+        if(_list.substr(0, _pos) == _name) return true;
+        if(_pos == std::string_view::npos) break;
+        _list = _list.substr(_pos + 1);
+    }
+    return false;
+}
+
+template <typename Tp>
+constexpr bool
+is_compiled()
+{
+    return is_compiled(tim::trait::perfetto_category<Tp>::value);
+}
 }  // namespace categories
 }  // namespace omnitrace
@@ -0,0 +1,181 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "clock_sync.hpp"
+#include "config.hpp"
+#include "debug.hpp"
+#include "timemory.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+#    include <mpi.h>
+#endif
+
+namespace omnitrace
+{
+namespace clock_sync
+{
+namespace
+{
+// number of ping-pongs per rank, the one with the smallest round-trip is used
+constexpr int num_rounds = 16;
+
+auto&
+get_samples_impl()
+{
+    static auto _v = std::vector<sample>{};
+    return _v;
+}
+
+auto
+now()
+{
+    return tim::get_clock_real_now<uint64_t, std::nano>();
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::get_use_perfetto() && config::get_perfetto_combined_traces() &&
+           config::get_perfetto_clock_sync();
+}
+
+bool
+synchronize()
+{
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    int _init = 0;
+    int _fini = 0;
+    MPI_Initialized(&_init);
+    MPI_Finalized(&_fini);
+    if(_init == 0 || _fini != 0) return false;
+
+    // a private communicator so the ping-pongs never match the messages of the
+    // application
+    auto _comm = MPI_Comm{};
+    PMPI_Comm_dup(MPI_COMM_WORLD, &_comm);
+
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(_comm, &_rank);
+    PMPI_Comm_size(_comm, &_size);
+
+    // timestamp, offset, and round-trip time of the best estimate
+    int64_t _result[3] = { static_cast<int64_t>(now()), 0, 0 };
+
+    if(_rank == 0)
+    {
+        for(int _peer = 1; _peer < _size; ++_peer)
+        {
+            int64_t _best[3] = { 0, 0, std::numeric_limits<int64_t>::max() };
+            for(int i = 0; i < num_rounds; ++i)
+            {
+                uint64_t _remote = 0;
+                auto     _t0     = now();
+                PMPI_Send(nullptr, 0, MPI_BYTE, _peer, 0, _comm);
+                PMPI_Recv(&_remote, 1, MPI_UINT64_T, _peer, 0, _comm, MPI_STATUS_IGNORE);
+                auto _t1  = now();
+                auto _rtt = static_cast<int64_t>(_t1 - _t0);
+                if(_rtt < _best[2])
+                {
+                    _best[0] = static_cast<int64_t>(_remote);
+                    _best[1] = static_cast<int64_t>(_remote) -
+                               static_cast<int64_t>(_t0 + (_t1 - _t0) / 2);
+                    _best[2] = _rtt;
+                }
+            }
+            PMPI_Send(_best, 3, MPI_INT64_T, _peer, 0, _comm);
+        }
+    }
+    else
+    {
+        for(int i = 0; i < num_rounds; ++i)
+        {
+            PMPI_Recv(nullptr, 0, MPI_BYTE, 0, 0, _comm, MPI_STATUS_IGNORE);
+            auto _t = now();
+            PMPI_Send(&_t, 1, MPI_UINT64_T, 0, 0, _comm);
+        }
+        PMPI_Recv(_result, 3, MPI_INT64_T, 0, 0, _comm, MPI_STATUS_IGNORE);
+    }
+
+    PMPI_Comm_free(&_comm);
+
+    auto _sample      = sample{};
+    _sample.timestamp = static_cast<uint64_t>(_result[0]);
+    _sample.offset    = _result[1];
+    _sample.rtt       = static_cast<uint64_t>(_result[2]);
+    get_samples_impl().emplace_back(_sample);
+
+    OMNITRACE_VERBOSE(1,
+                      "[clock_sync] rank %i clock offset is %li nsec (round-trip %lu "
+                      "nsec)\n",
+                      _rank, static_cast<long>(_sample.offset),
+                      static_cast<unsigned long>(_sample.rtt));
+    return true;
+#else
+    return false;
+#endif
+}
+
+const std::vector<sample>&
+get_samples()
+{
+    return get_samples_impl();
+}
+
+bool
+has_correction()
+{
+    const auto& _samples = get_samples_impl();
+    return std::any_of(_samples.begin(), _samples.end(),
+                       [](const auto& itr) { return itr.offset != 0; });
+}
+
+uint64_t
+correct(uint64_t _ts)
+{
+    const auto& _samples = get_samples_impl();
+    if(_samples.empty()) return _ts;
+
+    const auto& _first = _samples.front();
+    const auto& _last  = _samples.back();
+
+    auto _offset = static_cast<double>(_first.offset);
+    if(_last.timestamp > _first.timestamp)
+    {
+        auto _slope = static_cast<double>(_last.offset - _first.offset) /
+                      static_cast<double>(_last.timestamp - _first.timestamp);
+        _offset += _slope * (static_cast<double>(_ts) -
+                             static_cast<double>(_first.timestamp));
+    }
+
+    auto _v = static_cast<int64_t>(_ts) - std::llround(_offset);
+    return (_v > 0) ? static_cast<uint64_t>(_v) : 0;
+}
+}  // namespace clock_sync
+}  // namespace omnitrace
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace omnitrace
+{
+namespace clock_sync
+{
+// offset of the CLOCK_REALTIME of this rank relative to rank 0 of MPI_COMM_WORLD,
+// estimated from the ping-pong with the smallest round-trip time (Cristian's
+// algorithm). The timestamp is the local time of the estimate
+struct sample
+{
+    uint64_t timestamp = 0;
+    int64_t  offset    = 0;  // local - rank 0 (nanoseconds)
+    uint64_t rtt       = 0;  // round-trip time of the estimate (nanoseconds)
+};
+
+// OMNITRACE_PERFETTO_CLOCK_SYNC with OMNITRACE_PERFETTO_COMBINE_TRACES
+bool
+is_enabled();
+
+// collective over MPI_COMM_WORLD. Appends a sample and returns true unless MPI is not
+// initialized (or already finalized)
+bool
+synchronize();
+
+const std::vector<sample>&
+get_samples();
+
+// whether any sample has a non-zero offset, i.e. the timestamps need to be converted
+bool
+has_correction();
+
+// converts a local timestamp to the clock of rank 0. With two or more samples, the
+// offset is interpolated linearly between the first and the last sample (drift)
+uint64_t
+correct(uint64_t _ts);
+}  // namespace clock_sync
+}  // namespace omnitrace
@@ -72,6 +72,8 @@ struct backtrace_wall_clock
 {};
 struct backtrace_cpu_clock
 {};
+struct backtrace_off_cpu_clock
+{};
 struct backtrace_fraction
 {};
 struct backtrace_gpu_busy
@@ -82,14 +84,25 @@ struct backtrace_gpu_power
 {};
 struct backtrace_gpu_memory
 {};
+struct annotation_schema_field
+{};
+struct self_overhead_time
+{};
+struct gpu_kernel_occupancy
+{};
 using sampling_wall_clock = data_tracker<double, backtrace_wall_clock>;
 using sampling_cpu_clock  = data_tracker<double, backtrace_cpu_clock>;
+using sampling_off_cpu    = data_tracker<double, backtrace_off_cpu_clock>;
 using sampling_percent    = data_tracker<double, backtrace_fraction>;
 using sampling_gpu_busy   = data_tracker<double, backtrace_gpu_busy>;
 using sampling_gpu_temp   = data_tracker<double, backtrace_gpu_temp>;
 using sampling_gpu_power  = data_tracker<double, backtrace_gpu_power>;
 using sampling_gpu_memory = data_tracker<double, backtrace_gpu_memory>;
 
+using annotation_data_tracker = data_tracker<double, annotation_schema_field>;
+using self_overhead_tracker   = data_tracker<double, self_overhead_time>;
+using kernel_occupancy        = data_tracker<double, gpu_kernel_occupancy>;
+
 template <typename ApiT, typename StartFuncT = default_functor_t,
           typename StopFuncT = default_functor_t>
 struct functors;
@@ -98,6 +111,7 @@ struct functors;
 
 #if !defined(OMNITRACE_USE_ROCTRACER)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::roctracer, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::kernel_occupancy, false_type)
 #endif
 
 #if !defined(OMNITRACE_USE_ROCPROFILER)
@@ -121,6 +135,7 @@ OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::backtrace_metrics, fals
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::backtrace_timestamp, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_wall_clock, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_cpu_clock, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_off_cpu, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::sampling_percent, false_type)
 #endif
 
@@ -143,6 +158,8 @@ TIMEMORY_SET_COMPONENT_API(omnitrace::component::sampling_wall_clock, project::o
 TIMEMORY_SET_COMPONENT_API(omnitrace::component::sampling_cpu_clock, project::omnitrace,
                            category::timing, os::supports_unix, category::sampling,
                            category::interrupt_sampling)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::sampling_off_cpu, project::omnitrace,
+                           category::timing, os::supports_unix, category::sampling)
 TIMEMORY_SET_COMPONENT_API(omnitrace::component::sampling_percent, project::omnitrace,
                            category::timing, os::supports_unix, category::sampling,
                            category::interrupt_sampling)
@@ -160,6 +177,15 @@ TIMEMORY_SET_COMPONENT_API(omnitrace::component::sampling_gpu_temp, project::omn
                            category::temperature, category::sampling,
                            category::process_sampling)
 
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::annotation_data_tracker,
+                           project::omnitrace, os::supports_unix)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::self_overhead_tracker,
+                           project::omnitrace, category::timing, os::supports_unix)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::kernel_occupancy, project::omnitrace,
+                           tpls::rocm, device::gpu, os::supports_linux)
+
 TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::roctracer, "roctracer",
                                  "High-precision ROCm API and kernel tracing", "")
 TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::rocprofiler, "rocprofiler",
@@ -170,6 +196,10 @@ TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_wall_clock,
 TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_cpu_clock,
                                  "sampling_cpu_clock", "CPU-clock timing",
                                  "Derived from statistical sampling")
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_off_cpu,
+                                 "sampling_off_cpu",
+                                 "Time the thread was blocked or preempted",
+                                 "Derived from the context switches")
 TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_percent,
                                  "sampling_percent",
                                  "Fraction of wall-clock time spent in functions",
@@ -188,32 +218,60 @@ TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::sampling_gpu_temp,
                                  "sampling_gpu_temp", "GPU Temperature via ROCm-SMI",
                                  "Derived from sampling")
 
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::annotation_data_tracker,
+                                 "annotation_data",
+                                 "Numeric fields of the annotation schema regions",
+                                 "Recorded by omnitrace_user_push_schema_region")
+
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::self_overhead_tracker,
+                                 "self_overhead", "Time spent inside omnitrace",
+                                 "Enabled by OMNITRACE_SELF_OVERHEAD")
+
+TIMEMORY_METADATA_SPECIALIZATION(omnitrace::component::kernel_occupancy,
+                                 "kernel_occupancy",
+                                 "Theoretical occupancy of the GPU kernels",
+                                 "Enabled by OMNITRACE_ROCTRACER_KERNEL_OCCUPANCY")
+
 // statistics type
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_wall_clock, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_cpu_clock, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_off_cpu, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_busy, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_temp, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_power, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::sampling_gpu_memory, double)
 TIMEMORY_STATISTICS_TYPE(omnitrace::component::comm_data_tracker_t, float)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::annotation_data_tracker, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::self_overhead_tracker, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::kernel_occupancy, double)
 
 // enable timing units
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_wall_clock,
                                 true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_cpu_clock,
                                 true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_off_cpu,
+                                true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::sampling_percent,
                                 true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_wall_clock,
                                 true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_cpu_clock,
                                 true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::sampling_off_cpu,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::self_overhead_tracker,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::self_overhead_tracker,
+                                true_type)
 
 // enable percent units
 OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_percent_units, component::sampling_gpu_busy,
                                 true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_percent_units, component::sampling_percent,
                                 true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_percent_units, component::kernel_occupancy,
+                                true_type)
 
 // enable memory units
 OMNITRACE_DEFINE_CONCRETE_TRAIT(is_memory_category, component::sampling_gpu_memory,
@@ -226,6 +284,7 @@ OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::sampling_gpu_busy, false_
 OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::sampling_gpu_temp, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::sampling_gpu_power, false_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::sampling_gpu_memory, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::kernel_occupancy, false_type)
 
 // reporting categories (mean)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(report_mean, component::sampling_percent, false_type)
@@ -236,6 +295,7 @@ OMNITRACE_DEFINE_CONCRETE_TRAIT(report_statistics, component::sampling_percent,
 
 // reporting categories (self)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(report_self, component::sampling_percent, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_self, component::kernel_occupancy, false_type)
 
 #define OMNITRACE_DECLARE_EXTERN_COMPONENT(NAME, HAS_DATA, ...)                          \
     TIMEMORY_DECLARE_EXTERN_TEMPLATE(                                                    \
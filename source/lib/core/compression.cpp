@@ -0,0 +1,299 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(OMNITRACE_USE_ZLIB) && OMNITRACE_USE_ZLIB > 0
+#    include <zlib.h>
+#endif
+
+#if defined(OMNITRACE_USE_ZSTD) && OMNITRACE_USE_ZSTD > 0
+#    include <zstd.h>
+#endif
+
+namespace omnitrace
+{
+namespace compression
+{
+codec
+get_codec(std::string_view _v)
+{
+    if(_v == "gzip") return codec::gzip;
+    if(_v == "zstd") return codec::zstd;
+    return codec::none;
+}
+
+bool
+is_available(codec _v)
+{
+    switch(_v)
+    {
+        case codec::none: return true;
+        case codec::gzip:
+#if defined(OMNITRACE_USE_ZLIB) && OMNITRACE_USE_ZLIB > 0
+            return true;
+#else
+            return false;
+#endif
+        case codec::zstd:
+#if defined(OMNITRACE_USE_ZSTD) && OMNITRACE_USE_ZSTD > 0
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char*
+get_extension(codec _v)
+{
+    switch(_v)
+    {
+        case codec::none: return "";
+        case codec::gzip: return ".gz";
+        case codec::zstd: return ".zst";
+    }
+    return "";
+}
+
+const char*
+get_name(codec _v)
+{
+    switch(_v)
+    {
+        case codec::none: return "none";
+        case codec::gzip: return "gzip";
+        case codec::zstd: return "zstd";
+    }
+    return "none";
+}
+
+stream::stream(codec _codec, int _level)
+: m_codec{ (is_available(_codec)) ? _codec : codec::none }
+, m_level{ _level }
+{}
+
+stream::~stream() { close(); }
+
+std::optional<std::string>
+stream::open(const std::string& _filename)
+{
+    if(m_file) return std::string{ "stream is already open" };
+
+    m_file = fopen(_filename.c_str(), "wb");
+    if(!m_file) return "fopen of '" + _filename + "' failed: " + strerror(errno);
+
+    m_bytes_in  = 0;
+    m_bytes_out = 0;
+    m_input.clear();
+    m_input.reserve(chunk_size);
+    m_output.resize((m_codec == codec::none) ? 0 : chunk_size);
+
+    switch(m_codec)
+    {
+        case codec::none: break;
+        case codec::gzip:
+        {
+#if defined(OMNITRACE_USE_ZLIB) && OMNITRACE_USE_ZLIB > 0
+            auto* _zs    = new z_stream{};
+            auto  _level = (m_level > 0) ? std::min(m_level, 9) : Z_DEFAULT_COMPRESSION;
+            // a window of 15 bits plus 16 writes a gzip header and trailer
+            if(deflateInit2(_zs, _level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) !=
+               Z_OK)
+            {
+                delete _zs;
+                return std::string{ "deflateInit2 failed" };
+            }
+            m_context = _zs;
+#endif
+            break;
+        }
+        case codec::zstd:
+        {
+#if defined(OMNITRACE_USE_ZSTD) && OMNITRACE_USE_ZSTD > 0
+            auto* _cctx = ZSTD_createCCtx();
+            if(!_cctx) return std::string{ "ZSTD_createCCtx failed" };
+            if(m_level > 0)
+                ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel,
+                                       std::min(m_level, ZSTD_maxCLevel()));
+            m_context = _cctx;
+#endif
+            break;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<std::string>
+stream::write(const char* _data, size_t _size)
+{
+    if(!m_file) return std::string{ "stream is not open" };
+
+    while(_size > 0)
+    {
+        auto _n = std::min(_size, chunk_size - m_input.size());
+        m_input.insert(m_input.end(), _data, _data + _n);
+        _data += _n;
+        _size -= _n;
+        m_bytes_in += _n;
+        if(m_input.size() == chunk_size)
+        {
+            if(auto _err = flush(false); _err) return _err;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<std::string>
+stream::write_file(const std::string& _filename)
+{
+    FILE* _fdata = fopen(_filename.c_str(), "rb");
+    if(!_fdata) return "fopen of '" + _filename + "' failed: " + strerror(errno);
+
+    auto _err    = std::optional<std::string>{};
+    auto _buffer = std::vector<char>(chunk_size);
+    while(!_err)
+    {
+        auto _nread = fread(_buffer.data(), sizeof(char), _buffer.size(), _fdata);
+        if(_nread == 0) break;
+        _err = write(_buffer.data(), _nread);
+    }
+
+    if(!_err && ferror(_fdata) != 0) _err = "error reading '" + _filename + "'";
+    fclose(_fdata);
+    return _err;
+}
+
+std::optional<std::string>
+stream::close()
+{
+    if(!m_file) return std::nullopt;
+
+    auto _err = flush(true);
+
+    switch(m_codec)
+    {
+        case codec::none: break;
+        case codec::gzip:
+        {
+#if defined(OMNITRACE_USE_ZLIB) && OMNITRACE_USE_ZLIB > 0
+            auto* _zs = static_cast<z_stream*>(m_context);
+            if(_zs) deflateEnd(_zs);
+            delete _zs;
+#endif
+            break;
+        }
+        case codec::zstd:
+        {
+#if defined(OMNITRACE_USE_ZSTD) && OMNITRACE_USE_ZSTD > 0
+            ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(m_context));
+#endif
+            break;
+        }
+    }
+
+    if(fclose(m_file) != 0 && !_err) _err = std::string{ "fclose failed" };
+
+    m_file    = nullptr;
+    m_context = nullptr;
+    m_input   = std::vector<char>{};
+    m_output  = std::vector<char>{};
+    return _err;
+}
+
+// compresses the buffered input. When finishing, the compressor is also flushed and
+// the end of the gzip member or zstd frame is written
+std::optional<std::string>
+stream::flush(bool _finish)
+{
+    auto _fwrite = [this](const char* _data, size_t _n) -> std::optional<std::string> {
+        if(_n > 0 && fwrite(_data, sizeof(char), _n, m_file) != _n)
+            return std::string{ "fwrite failed: " } + strerror(errno);
+        m_bytes_out += _n;
+        return std::nullopt;
+    };
+
+    (void) _finish;
+
+    auto _err = std::optional<std::string>{};
+    switch(m_codec)
+    {
+        case codec::none:
+        {
+            _err = _fwrite(m_input.data(), m_input.size());
+            break;
+        }
+        case codec::gzip:
+        {
+#if defined(OMNITRACE_USE_ZLIB) && OMNITRACE_USE_ZLIB > 0
+            auto* _zs     = static_cast<z_stream*>(m_context);
+            _zs->next_in  = reinterpret_cast<Bytef*>(m_input.data());
+            _zs->avail_in = static_cast<uInt>(m_input.size());
+            do
+            {
+                _zs->next_out  = reinterpret_cast<Bytef*>(m_output.data());
+                _zs->avail_out = static_cast<uInt>(m_output.size());
+                if(deflate(_zs, (_finish) ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR)
+                    _err = std::string{ "deflate failed" };
+                else
+                    _err = _fwrite(m_output.data(), m_output.size() - _zs->avail_out);
+            } while(!_err && _zs->avail_out == 0);
+#endif
+            break;
+        }
+        case codec::zstd:
+        {
+#if defined(OMNITRACE_USE_ZSTD) && OMNITRACE_USE_ZSTD > 0
+            auto* _cctx = static_cast<ZSTD_CCtx*>(m_context);
+            auto  _mode = (_finish) ? ZSTD_e_end : ZSTD_e_continue;
+            auto  _in   = ZSTD_inBuffer{ m_input.data(), m_input.size(), 0 };
+            bool  _done = false;
+            while(!_err && !_done)
+            {
+                auto _out       = ZSTD_outBuffer{ m_output.data(), m_output.size(), 0 };
+                auto _remaining = ZSTD_compressStream2(_cctx, &_out, &_in, _mode);
+                if(ZSTD_isError(_remaining))
+                {
+                    _err = std::string{ "ZSTD_compressStream2 failed: " } +
+                           ZSTD_getErrorName(_remaining);
+                    break;
+                }
+                _err  = _fwrite(static_cast<const char*>(_out.dst), _out.pos);
+                _done = (_finish) ? (_remaining == 0) : (_in.pos == _in.size);
+            }
+#endif
+            break;
+        }
+    }
+
+    m_input.clear();
+    return _err;
+}
+}  // namespace compression
+}  // namespace omnitrace
@@ -0,0 +1,96 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+namespace compression
+{
+enum class codec
+{
+    none = 0,
+    gzip,
+    zstd,
+};
+
+// "none", "gzip", or "zstd". Unknown names are treated as "none"
+codec
+get_codec(std::string_view);
+
+// whether omnitrace was built with the library for the codec
+bool
+is_available(codec);
+
+// the file extension appended to the output filename, e.g. ".gz"
+const char*
+get_extension(codec);
+
+const char*
+get_name(codec);
+
+// streaming compression into a file: the data passed to write() is compressed in
+// bounded chunks so that neither the uncompressed nor the compressed output is ever
+// held in memory. Concatenated gzip members and zstd frames decompress into the
+// concatenation of their data so separately compressed files can be combined
+struct stream
+{
+    static constexpr size_t chunk_size = 1 << 20;
+
+    stream(codec, int _level = 0);
+    ~stream();
+
+    stream(const stream&) = delete;
+    stream(stream&&)      = delete;
+    stream& operator=(const stream&) = delete;
+    stream& operator=(stream&&) = delete;
+
+    // all return an error message on failure
+    std::optional<std::string> open(const std::string& _filename);
+    std::optional<std::string> write(const char* _data, size_t _size);
+    std::optional<std::string> write_file(const std::string& _filename);
+    std::optional<std::string> close();
+
+    size_t bytes_in() const { return m_bytes_in; }
+    size_t bytes_out() const { return m_bytes_out; }
+
+private:
+    std::optional<std::string> flush(bool _finish);
+
+    codec             m_codec     = codec::none;
+    int               m_level     = 0;
+    FILE*             m_file      = nullptr;
+    void*             m_context   = nullptr;
+    size_t            m_bytes_in  = 0;
+    size_t            m_bytes_out = 0;
+    std::vector<char> m_input     = {};
+    std::vector<char> m_output    = {};
+};
+}  // namespace compression
+}  // namespace omnitrace
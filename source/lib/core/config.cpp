@@ -257,6 +257,20 @@ configure_settings(bool _init)
                                  "Verbosity within the omnitrace-dl library", 0,
                                  "debugging", "libomnitrace-dl", "advanced");
 
+    OMNITRACE_CONFIG_EXT_SETTING(
+        bool, "OMNITRACE_LAZY_INIT",
+        "Defer loading and initializing libomnitrace until the first enabled event (an "
+        "instrumented function, a user region, omnitrace_user_start_trace, etc.) instead "
+        "of before main and look up the symbols of libomnitrace on their first use. "
+        "Processes which never have an enabled event are not profiled. Not supported by "
+        "omnitrace-sample since the sampling has no such event",
+        false, "libomnitrace-dl", "performance", "advanced");
+
+    OMNITRACE_CONFIG_EXT_SETTING(bool, "OMNITRACE_DL_INIT_TIMING",
+                                 "Print the time spent loading and initializing "
+                                 "libomnitrace",
+                                 false, "libomnitrace-dl", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         size_t, "OMNITRACE_NUM_THREADS_HINT",
         "This is hint for how many threads are expected to be created in the "
@@ -328,6 +342,18 @@ configure_settings(bool _init)
         "Enable tagging filenames with process identifier (either MPI rank or pid)", true,
         "io", "filename");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_FORK_MODE",
+        "Handling of the processes created by fork(). 'disable' turns off the tooling "
+        "in the child. 'inherit' keeps the analyzed state of the parent (config, "
+        "binary and symbol info, interned strings) copy-on-write and continues "
+        "profiling in the child with a process-specific output suffix. Perfetto, "
+        "sampling, and the background process sampling are disabled in the child "
+        "because their threads are not duplicated by fork(). The profile of the child "
+        "includes the data the parent recorded before the fork",
+        "disable", "io", "advanced")
+        ->set_choices({ "disable", "inherit" });
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_USE_KOKKOSP",
                              "Enable support for Kokkos Tools", false, "kokkos",
                              "backend");
@@ -357,13 +383,34 @@ configure_settings(bool _init)
 
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_KOKKOSP_DEEP_COPY",
-        "Enable tracking deep copies (warning: may corrupt flamegraph in perfetto)",
+        "Enable tracking deep copies and their bandwidth per pair of memory spaces "
+        "(warning: may corrupt flamegraph in perfetto)",
         false, "kokkos", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(int64_t, "OMNITRACE_KOKKOSP_MEMORY_TOP",
+                             "Number of labels with the most bytes allocated reported "
+                             "for each Kokkos memory space",
+                             10, "kokkos", "memory", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_USE_OMPT",
                              "Enable support for OpenMP-Tools", false, "openmp", "ompt",
                              "backend");
 
+    OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_OMPT_DEVICE_TRACING",
+                             "Trace the OpenMP target kernels and data transfers on the "
+                             "devices with the OMPT device tracing interface",
+                             true, "openmp", "ompt", "gpu");
+
+    OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_OMPT_DEVICE_BUFFER_SIZE_KB",
+                             "Size of the buffers provided to the OpenMP runtime for "
+                             "the device trace records",
+                             1024, "openmp", "ompt", "gpu", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_OMPT_IMBALANCE",
+                             "Compute the load imbalance and the wait fraction of the "
+                             "threads in each OpenMP parallel region instance",
+                             true, "openmp", "ompt");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_USE_CODE_COVERAGE",
                              "Enable support for code coverage", false, "coverage",
                              "backend", "advanced");
@@ -393,6 +440,77 @@ configure_settings(bool _init)
                              "and/or <DELAY>:<DURATION>:<REPEAT>:<CLOCK_ID>",
                              std::string{}, "trace", "profile", "perfetto", "timemory");
 
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_THROTTLE_CALLS",
+        "Number of calls to an instrumented function on a thread within "
+        "OMNITRACE_THROTTLE_INTERVAL seconds after which the function is no longer "
+        "traced or profiled on that thread. The throttling is recorded in the trace and "
+        "the number of dropped calls is reported during finalization. A value of zero "
+        "disables throttling",
+        size_t{ 0 }, "trace", "profile", "overhead", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(double, "OMNITRACE_THROTTLE_INTERVAL",
+                             "Interval (in seconds) for OMNITRACE_THROTTLE_CALLS", 1.0,
+                             "trace", "profile", "overhead", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_THROTTLE_MODE",
+        "Behavior of a throttled function. \"disable\" == the function remains "
+        "throttled for the rest of the run, \"count\" == the calls to the function "
+        "are only counted and the function is traced and profiled again once its call "
+        "rate drops below OMNITRACE_THROTTLE_CALLS per OMNITRACE_THROTTLE_INTERVAL",
+        std::string{ "disable" }, "trace", "profile", "overhead", "advanced")
+        ->set_choices({ "disable", "count" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CONTROL_FILE",
+        "Create a control file in OMNITRACE_TMPDIR through which omnitrace-ctl turns "
+        "categories and instrumented functions/regions on and off while the process is "
+        "running, e.g. 'omnitrace-ctl -p <PID> --enable host --include foo'. The "
+        "overrides take precedence over OMNITRACE_ENABLE_CATEGORIES",
+        false, "trace", "profile", "overhead", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_REGION_SAMPLE_RATES",
+        "Comma-separated list of <NAME>=<N> where only one in N instances of the user "
+        "region <NAME> is traced and profiled on each thread. N may be \"auto\" to "
+        "choose N such that the region is recorded at approximately "
+        "OMNITRACE_REGION_SAMPLE_TARGET times per second per thread. Every instance is "
+        "still counted and the statistics of the recorded instances are scaled during "
+        "finalization",
+        std::string{}, "trace", "profile", "overhead", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_REGION_SAMPLE_TARGET",
+        "Target number of recorded instances per second per thread of the sampled user "
+        "regions whose rate is \"auto\" in OMNITRACE_REGION_SAMPLE_RATES or zero in "
+        "omnitrace_user_push_sampled_region. A value of zero records every instance",
+        1000.0, "trace", "profile", "overhead", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_TRIGGERS",
+        "Semi-colon separated list of <ACTION>:<REGION>[:<KEY>=<VALUE>]... where ACTION "
+        "is \"enable\" or \"disable\" (the data collection after the N-th instance of "
+        "the region) or \"within\" (the data collection is only enabled while the "
+        "region is active on any thread). KEY is \"count\" (N, default: 1), \"on\" "
+        "(\"entry\" or \"exit\" of the region, default: entry), \"after\" (instances "
+        "in the first given number of seconds are ignored), \"categories\" "
+        "(comma-separated, default: OMNITRACE_ENABLED_CATEGORIES) or \"sampling\" "
+        "(whether the samplers are paused and resumed as well, default: true). The data "
+        "collection starts disabled when the first trigger is not \"disable\". E.g. "
+        "\"enable:MPI_Init:on=exit;enable:timestep:count=10;disable:timestep:count=20\"",
+        std::string{}, "trace", "profile", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CRITICAL_PATH",
+        "Record the regions of each thread and the synchronization between the threads "
+        "(thread creation and join, OMNITRACE_TRACE_THREAD_LOCKS, "
+        "OMNITRACE_TRACE_THREAD_BARRIERS), the MPI ranks (matching messages and "
+        "collectives) and the GPUs (kernel launch, completion and device "
+        "synchronization) and write the time of each region and kernel on the critical "
+        "path of the application to critical-path.txt",
+        false, "trace", "profile", "analysis", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_TRACE_PERIOD_CLOCK_ID",
         "Set the default clock ID for OMNITRACE_TRACE_DELAY, OMNITRACE_TRACE_DURATION, "
@@ -458,13 +576,76 @@ configure_settings(bool _init)
                              "less than zero, uses OMNITRACE_SAMPLING_DURATION",
                              -1.0, "sampling", "process_sampling");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROCESS_SAMPLING_FIXED_RATE",
+        "Schedule the background process samples at absolute deadlines so that the "
+        "sampling period does not include the cost of sampling. Deadlines which are "
+        "missed are skipped and annotated in the trace. If disabled, each sample is "
+        "delayed by the sampling interval after the previous sample completes",
+        true, "process_sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROCESS_SAMPLING_PER_NODE",
+        "Only one process per node samples the system-wide metrics (rocm-smi, the "
+        "network links and the CPU frequencies) in the background. The process is "
+        "elected through a lock file in OMNITRACE_TMPDIR which is shared by the "
+        "processes with the same parent process (e.g. the MPI launcher daemon of the "
+        "node). The memory usage of every process is still sampled",
+        false, "process_sampling", "rocm_smi", "mpi", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROCESS_SAMPLING_NETWORK",
+        "Sample the receive and transmit byte counters of the network interfaces in "
+        "/sys/class/net and of the InfiniBand ports in /sys/class/infiniband in the "
+        "background and report the bandwidth of each link. The links are restricted "
+        "to OMNITRACE_NETWORK_INTERFACE when it is set",
+        false, "process_sampling", "network", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROCESS_SAMPLING_CPU_ENERGY",
+        "Sample the RAPL energy counters of the CPU packages and DRAM of each socket in "
+        "/sys/class/powercap in the background, report the power of each domain and "
+        "attribute the energy to the instrumented regions. Reading the counters "
+        "usually requires root privileges",
+        false, "process_sampling", "energy", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROCESS_SAMPLING_CGROUP",
+        "Sample the CPU usage and CFS throttling (cpu.stat), the memory usage "
+        "(memory.current) and the memory pressure stall info (memory.pressure) of the "
+        "cgroup v2 of the process in the background so that the throttling by the CPU "
+        "quota of a container is visible in the trace",
+        false, "process_sampling", "cgroup", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PROCESS_SAMPLING_MEMORY_BANDWIDTH",
+        "Sample the DRAM traffic of each socket from the system-wide memory controller "
+        "(Intel uncore IMC) or data fabric (AMD) perf PMUs in the background, report "
+        "the bandwidth of each socket and the average bandwidth of the instrumented "
+        "regions. Opening the system-wide PMUs usually requires perf_event_paranoid "
+        "of 0 or less, or CAP_PERFMON",
+        false, "process_sampling", "memory", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_SAMPLING_CPUS",
-        "CPUs to collect frequency information for. Values should be separated by commas "
-        "and can be explicit or ranges, e.g. 0,1,5-8. An empty value implies 'all' and "
-        "'none' suppresses all CPU frequency sampling",
+        "CPUs to collect frequency information for and, with "
+        "OMNITRACE_SAMPLING_SYSTEM_WIDE, to sample every process on. Values should be "
+        "separated by commas and can be explicit or ranges, e.g. 0,1,5-8. An empty value "
+        "implies 'all' and 'none' suppresses all CPU frequency sampling",
         std::string{}, "process_sampling");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CPU_FREQ_BACKEND",
+        "Source of the CPU frequencies. 'sysfs' reads the current scaling frequency "
+        "from /sys/devices/system/cpu/cpu<N>/cpufreq/scaling_cur_freq with file "
+        "descriptors opened once. 'cpuinfo' parses /proc/cpuinfo. 'aperf-mperf' "
+        "reports the effective frequency while busy over each sampling interval from "
+        "the APERF, MPERF and TSC counters of the perf msr PMU (x86 only, requires "
+        "/proc/sys/kernel/perf_event_paranoid <= 0), which reflects throttling. "
+        "Falls back to 'sysfs' and then 'cpuinfo' when unavailable",
+        std::string{ "sysfs" }, "process_sampling", "advanced")
+        ->set_choices({ "sysfs", "cpuinfo", "aperf-mperf" });
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_ROCM_SMI_DEVICES",
                              "[DEPRECATED] Renamed to OMNITRACE_SAMPLING_GPUS",
                              std::string{ "all" }, "rocm_smi", "rocm", "process_sampling",
@@ -539,6 +720,37 @@ configure_settings(bool _init)
                              "Enable tracing calls to pthread_barrier functions.", true,
                              "backend", "parallelism", "gotcha", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_ONLY",
+        "When tracing the mutex, rwlock, and spin locks, only record the acquisitions "
+        "which were contended, i.e. a trylock failed. Uncontended acquisitions are only "
+        "counted per lock and the unlock and trylock functions are not wrapped",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_THREAD_LOCKS_PROFILE",
+        "When tracing the mutex, rwlock, and spin locks, accumulate the wait time, hold "
+        "time, acquisitions, and contended acquisitions per lock address and report the "
+        "hottest locks (OMNITRACE_TRACE_THREAD_LOCKS_TOP) with the call site of their "
+        "first acquisition",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_TRACE_THREAD_LOCKS_TOP",
+        "Number of locks with the most wait time reported by "
+        "OMNITRACE_TRACE_THREAD_LOCKS_PROFILE. Only the call sites of these locks are "
+        "resolved",
+        size_t{ 10 }, "backend", "parallelism", "gotcha", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_THREAD_LAZY_SETUP",
+        "Defer naming the child threads, initializing their timemory manager and "
+        "thread bundle, and starting the start_thread region until the thread first "
+        "records data. Threads which never record data (e.g. short-lived worker threads "
+        "of a runtime) only pay for the thread info. Threads which are sampled or used "
+        "by causal profiling are always set up when they start",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_TRACE_THREAD_JOIN",
                              "Enable tracing calls to pthread_join functions.", true,
                              "backend", "parallelism", "gotcha", "advanced");
@@ -548,13 +760,141 @@ configure_settings(bool _init)
         "Configure whether the statistical samples should include call-stack entries "
         "from internal routines in omnitrace. E.g. when ON, the call-stack will show "
         "functions like omnitrace_push_trace. If disabled, omnitrace will attempt to "
-        "filter out internal routines from the sampling call-stacks",
+        "filter out internal routines from the sampling call-stacks. The frames in the "
+        "code of the omnitrace, timemory, gotcha, and libunwind libraries are removed "
+        "when the call-stack is captured so they are not stored",
         true, "sampling", "data", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_MAX_DEPTH",
+        "Maximum number of frames unwound for each sampled call-stack. The innermost "
+        "frames are kept. Deep call-stacks are captured faster and stored in less "
+        "memory with a lower limit. Zero selects the limit of the build "
+        "(OMNITRACE_MAX_UNWIND_DEPTH)",
+        0, "sampling", "data", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_SAMPLING_INCLUDE_INLINES",
                              "Create entries for inlined functions when available", false,
                              "sampling", "data", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_MERGE_STACKS",
+        "In the perfetto trace, merge the frames which consecutive timer samples have "
+        "in common (starting from the outermost frame) into a single slice instead of "
+        "one slice per sample. The merged slices are annotated with the number of "
+        "samples instead of the HW counters of each sample",
+        true, "sampling", "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_REGION_CONTEXT",
+        "Nest the call-stacks of the timer samples under the innermost user, python, "
+        "kokkos, MPI or roctx region which was active when the sample was taken and "
+        "write the hot-spots of each region to sampling-region-hotspots.txt",
+        false, "sampling", "data");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_CPU_RESIDENCY",
+        "Track the CPU which each timer sample ran on. Adds a counter track of the CPU "
+        "of each thread and writes the CPU residency histogram and the number of "
+        "migrations of each thread to cpu-residency.txt",
+        false, "sampling", "data");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_CALLCHAIN_ONLY",
+        "Samples only record the timestamp and the call-stack (as raw addresses). The "
+        "per-sample thread metrics (CPU clock, peak memory, context switches, page "
+        "faults, hardware counters) are not read, which makes high sampling frequencies "
+        "cheaper. The addresses are symbolized once per unique address at finalization",
+        false, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_RDPMC",
+        "When every event in OMNITRACE_PAPI_EVENTS has an equivalent generic perf "
+        "hardware event (e.g. PAPI_TOT_CYC, perf::PERF_COUNT_HW_INSTRUCTIONS) and the "
+        "kernel permits it, the samplers read the hardware counters in userspace with "
+        "the rdpmc instruction instead of a PAPI read (a system call)",
+        true, "sampling", "hardware_counters", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_RUSAGE_INTERVAL",
+        "Read the resource usage (peak memory, context switches, page faults) of the "
+        "sampled thread every N samples. The values of the samples in between are "
+        "extrapolated from the rate of change per CPU-time of the previous reads. Values "
+        "<= 1 read the resource usage at every sample",
+        1, "sampling", "performance", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_CCT_CAPACITY",
+        "Maximum number of unique call-stack frames (calling-context tree nodes) "
+        "recorded per sampled thread. Each sample only stores the node of its innermost "
+        "frame so this bounds the memory used for call-stacks. When the tree is full, "
+        "new call-stacks are truncated to the frames which were already recorded",
+        32768, "sampling", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_UNWINDER",
+        "Method used to unwind the call-stack of timer-based samples. 'cached' uses the "
+        "libunwind fast-trace which caches the frame recipes (CFA and return address "
+        "rules from the unwind tables) per instruction address and per thread so "
+        "repeated call-stacks do not re-evaluate the unwind info or take the global "
+        "unwind cache lock. 'frame-pointer' follows the frame-pointer chain within the "
+        "bounds of the thread's stack: it is the cheapest but requires all code to be "
+        "compiled with -fno-omit-frame-pointer and does not report the interrupted "
+        "function. 'libunwind' steps through every frame with the unwind info",
+        std::string{ "cached" }, "sampling", "data", "advanced")
+        ->set_choices({ "cached", "frame-pointer", "libunwind" });
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_BACKEND",
+        "Mechanism used for the CPU-time samples. 'timer' uses a POSIX CPU-time timer "
+        "per thread whose signal handler unwinds the call-stack of the thread. 'perf' "
+        "uses a perf_event task-clock per thread: the kernel records the user-space "
+        "callchain of each sample into a ring buffer which is drained by a background "
+        "thread so the sampled threads do not handle a signal. Requires "
+        "/proc/sys/kernel/perf_event_paranoid <= 2 and falls back to 'timer' if the "
+        "perf_event cannot be opened. Wall-clock samples always use a timer",
+        std::string{ "timer" }, "sampling", "advanced")
+        ->set_choices({ "timer", "perf" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_SYSTEM_WIDE",
+        "Sample every process and the kernel on the CPUs selected by "
+        "OMNITRACE_SAMPLING_CPUS with a perf_event per CPU. The process and thread which "
+        "ran on each CPU are shown in a track per CPU to identify the interference from "
+        "other processes and the OS. Requires /proc/sys/kernel/perf_event_paranoid <= 0 "
+        "or CAP_PERFMON",
+        false, "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_OFF_CPU",
+        "Trace the intervals in which the sampled threads are blocked or preempted with "
+        "a context-switch perf_event per thread. The call-stack where the thread was "
+        "switched out is recorded if /proc/sys/kernel/perf_event_paranoid <= 1. No code "
+        "is executed by the threads when they block",
+        false, "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(double, "OMNITRACE_SAMPLING_SYSTEM_WIDE_FREQ",
+                             "Number of samples per second of each CPU when "
+                             "OMNITRACE_SAMPLING_SYSTEM_WIDE is enabled",
+                             500.0, "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_SAMPLING_OVERHEAD_BUDGET",
+        "Fraction of the time of a sampled thread which may be spent unwinding "
+        "call-stacks for timer-based samples, e.g. 0.02 for 2%. When greater than zero, "
+        "the cost of each sample and the interval between samples are measured per "
+        "thread and only every N-th timer interrupt records a call-stack, where N is "
+        "adjusted at runtime to stay within the budget. The effective rate never drops "
+        "below OMNITRACE_SAMPLING_MIN_FREQ and is recorded in the trace. Zero disables "
+        "the adaptive rate",
+        0.0, "sampling", "overhead", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_SAMPLING_MIN_FREQ",
+        "Lowest effective number of timer-based samples per second per thread when the "
+        "sampling rate is reduced to honor OMNITRACE_SAMPLING_OVERHEAD_BUDGET",
+        1.0, "sampling", "overhead", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         size_t, "OMNITRACE_SAMPLING_ALLOCATOR_SIZE",
         "The number of sampled threads handled by an allocator running in a background "
@@ -567,6 +907,67 @@ configure_settings(bool _init)
         "thread started by the application.",
         8, "sampling", "debugging", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_OFFLOAD_MODE",
+        "Strategy for offloading full sample buffers to temporary files (requires "
+        "OMNITRACE_USE_TEMPORARY_FILES). 'thread' appends the samples of each thread to "
+        "its own memory-mapped segment file which requires no locking and is mapped "
+        "directly during post-processing. 'shared' serializes the buffers of every "
+        "thread into a single file guarded by a lock",
+        std::string{ "thread" }, "sampling", "io", "data", "advanced")
+        ->set_choices({ "thread", "shared" });
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_IDLE",
+        "Handling of the wall-clock and CPU-clock samplers of a thread while it is "
+        "parked in a known wait point (OpenMP barrier waits and the blocking "
+        "acquisitions observed by the pthread wrappers). 'sample' keeps sampling, "
+        "'suspend' blocks the sampling signals until the thread wakes and discards the "
+        "pending samples, and 'downsample' blocks the signals but keeps the single "
+        "pending sample of each timer so that every wait is sampled at most once",
+        std::string{ "sample" }, "sampling", "advanced")
+        ->set_choices({ "sample", "suspend", "downsample" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_PYTHON",
+        "When the Python bindings are loaded, the timer samples also record the Python "
+        "call-stack of the interrupted thread. The Python frames replace the frames of "
+        "the interpreter loop in the native call-stack so the samples contain a mixed "
+        "Python/native call-stack without tracing every Python function call",
+        false, "sampling", "python", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_OFFLOAD_QUEUE_DEPTH",
+        "Maximum number of full sample buffers which can be queued for the background "
+        "offload writer thread. The sampler allocators hand off full buffers to this "
+        "thread so they never wait on file I/O unless the queue is full. Setting this "
+        "value to zero writes the buffers from the allocator threads",
+        8, "sampling", "io", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_PARQUET_OUTPUT",
+        "Write the decoded samples (timestamps, thread, call-stack id, and metrics) and "
+        "a dictionary of the call-stacks to Apache Parquet files for analysis in "
+        "columnar engines such as DuckDB or Spark. The samples of each thread are "
+        "written as a row-group. Requires omnitrace built with OMNITRACE_USE_ARROW=ON",
+        false, "sampling", "io", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_FOLDED_OUTPUT",
+        "Write the call-stacks of the sampling data as folded stacks (one line per "
+        "unique call-stack with its weight) for flame graph tools such as flamegraph.pl "
+        "and speedscope. A file is written per thread and the call-stacks of all the "
+        "threads are merged into a file per rank",
+        false, "sampling", "io", "data");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_FOLDED_OUTPUT_WEIGHT",
+        "Weight of each sample in the folded stacks: the number of samples, the "
+        "wall-clock time (nsec) or the thread CPU-time (nsec, wall-clock time when the "
+        "CPU-time of the sample was not measured)",
+        std::string{ "samples" }, "sampling", "io", "data", "advanced")
+        ->set_choices({ "samples", "wall_clock", "cpu_clock" });
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_SAMPLING_OVERFLOW",
                              "Enable sampling via an overflow of a HW counter. This "
                              "requires Linux perf (/proc/sys/kernel/perf_event_paranoid "
@@ -601,11 +1002,121 @@ configure_settings(bool _init)
                              "the same signal (SIGRTMIN + 1)",
                              SIGRTMIN + 1, "sampling", "advanced");
 
-    OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_SAMPLING_OVERFLOW_EVENT",
-                             "Metric for overflow sampling",
-                             std::string{ "perf::PERF_COUNT_HW_CACHE_REFERENCES" },
-                             "sampling", "hardware_counters")
-        ->set_choices(perf::get_config_choices());
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_OVERFLOW_EVENT",
+        "Metric(s) for overflow sampling. Multiple events (up to 4) are sampled "
+        "concurrently as a perf event group and each event can set its own frequency "
+        "via an '@' suffix, e.g. 'PERF_COUNT_HW_CPU_CYCLES "
+        "PERF_COUNT_HW_CACHE_MISSES@1000'. Events without a suffix use "
+        "OMNITRACE_SAMPLING_OVERFLOW_FREQ",
+        std::string{ "perf::PERF_COUNT_HW_CACHE_REFERENCES" }, "sampling",
+        "hardware_counters");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_NUMA_LOCALITY",
+        "Record the page placement requests of the NUMA functions and sample the data "
+        "addresses of the memory loads to report the ratio of remote NUMA accesses per "
+        "thread and per call-site. This replaces the overflow event with "
+        "OMNITRACE_NUMA_LOCALITY_EVENT and requires OMNITRACE_SAMPLING_OVERFLOW",
+        false, "sampling", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_NUMA_LOCALITY_EVENT",
+        "Raw PMU event with precise data addresses for OMNITRACE_NUMA_LOCALITY in the "
+        "form [<pmu>/]<config>[:<config1>]. The default is the load latency event of "
+        "the Intel cores with a threshold of 3 cycles. On AMD, use the IBS op PMU, "
+        "e.g. ibs_op/0x0",
+        std::string{ "cpu/0x1cd:0x3" }, "sampling", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_NUMA_LOCALITY_TOP",
+        "Number of call-sites with the most remote NUMA accesses reported by "
+        "OMNITRACE_NUMA_LOCALITY. Only these call-sites are resolved",
+        size_t{ 20 }, "sampling", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SAMPLING_MEMORY",
+        "Sample the data addresses, latencies and data sources of the memory accesses "
+        "and report the hottest (call-site, data object) pairs. The data objects are "
+        "the heap allocations of at least OMNITRACE_SAMPLING_MEMORY_MIN_ALLOC bytes and "
+        "the global variables. This replaces the overflow event with "
+        "OMNITRACE_SAMPLING_MEMORY_EVENT and requires OMNITRACE_SAMPLING_OVERFLOW",
+        false, "sampling", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_SAMPLING_MEMORY_EVENT",
+        "Raw PMU event for OMNITRACE_SAMPLING_MEMORY in the form "
+        "[<pmu>/]<config>[:<config1>]. When empty, the IBS op PMU (ibs_op/0x0) is used "
+        "if available and the Intel load latency event (cpu/0x1cd:0x3) otherwise",
+        std::string{}, "sampling", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_MEMORY_MIN_ALLOC",
+        "Minimum size in bytes of the heap allocations which are tracked as data "
+        "objects by OMNITRACE_SAMPLING_MEMORY",
+        size_t{ 65536 }, "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_SAMPLING_MEMORY_TOP",
+        "Number of (call-site, data object) pairs with the most access latency reported "
+        "by OMNITRACE_SAMPLING_MEMORY",
+        size_t{ 20 }, "sampling", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_HEAP_PROFILE",
+        "Sample the heap allocations of malloc, calloc, realloc, posix_memalign, "
+        "aligned_alloc and the C++ operator new by bytes and report the allocated and "
+        "live bytes per call-site and the allocation rate",
+        false, "sampling", "memory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_HEAP_PROFILE_RATE",
+        "Mean number of bytes allocated between two samples of OMNITRACE_HEAP_PROFILE. "
+        "The interval is drawn from an exponential distribution so every byte has the "
+        "same probability to be sampled",
+        size_t{ 512 * 1024 }, "sampling", "memory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_HEAP_PROFILE_TOP",
+        "Number of call-sites with the most allocated bytes reported by "
+        "OMNITRACE_HEAP_PROFILE. Only the call-stacks of these call-sites are resolved",
+        size_t{ 20 }, "sampling", "memory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_IO_TRACE",
+        "Trace the POSIX file I/O (read, write, pread, pwrite, readv, writev, open, "
+        "close, fsync, fdatasync) and the MPI-IO functions and report the operations, "
+        "bytes, time, bandwidth and latency percentiles per file",
+        false, "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_IO_CALLSITE_INTERVAL",
+        "Attribute every N-th I/O operation of a thread to its call-site with "
+        "OMNITRACE_IO_TRACE. Zero disables the call-site attribution",
+        size_t{ 64 }, "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_IO_TRACE_TOP",
+        "Number of files with the most I/O time reported by OMNITRACE_IO_TRACE. Only the "
+        "call-sites of these files are resolved",
+        size_t{ 20 }, "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_PYTHON_GIL",
+        "Trace the acquisitions and releases of the Python GIL by the threads which "
+        "explicitly release it (PyEval_SaveThread, PyEval_RestoreThread, "
+        "PyGILState_Ensure, ...) and report the time each thread waited for and held "
+        "the GIL",
+        false, "python", "parallelism", "gotcha", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TOPDOWN",
+        "Report the level 1 top-down microarchitecture analysis of the host, user and "
+        "python regions: the percentage of the pipeline slots which retired, were "
+        "wasted by bad speculation, or were stalled in the frontend or the backend. "
+        "Supported on the Intel cores and on AMD Zen 4 and newer, requires "
+        "/proc/sys/kernel/perf_event_paranoid <= 2",
+        false, "profile", "trace", "hardware_counters", "advanced");
 
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_ROCTRACER_HIP_API",
                              "Enable HIP API tracing support", true, "roctracer", "rocm",
@@ -616,6 +1127,27 @@ configure_settings(bool _init)
         "Enable annotating the perfetto debug annotation with backtraces", false,
         "roctracer", "rocm", "perfetto", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCTRACER_HIP_API_AGGREGATE",
+        "Instead of a perfetto slice for every HIP API call, emit one summary slice "
+        "(count, total/min/max duration) per thread and per HIP API function for each "
+        "OMNITRACE_ROCTRACER_HIP_API_AGGREGATE_WINDOW. Calls which take at least "
+        "OMNITRACE_ROCTRACER_HIP_API_AGGREGATE_THRESHOLD are still traced individually",
+        false, "roctracer", "rocm", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_ROCTRACER_HIP_API_AGGREGATE_WINDOW",
+        "Length of the window (in milliseconds) summarized by one HIP API summary slice "
+        "when OMNITRACE_ROCTRACER_HIP_API_AGGREGATE is enabled",
+        10.0, "roctracer", "rocm", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_ROCTRACER_HIP_API_AGGREGATE_THRESHOLD",
+        "HIP API calls which take at least this long (in microseconds) are traced "
+        "individually when OMNITRACE_ROCTRACER_HIP_API_AGGREGATE is enabled. A value "
+        "less than or equal to zero disables the individual slices",
+        100.0, "roctracer", "rocm", "perfetto", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_ROCTRACER_HIP_ACTIVITY",
                              "Enable HIP activity tracing support", true, "roctracer",
                              "rocm", "advanced");
@@ -643,11 +1175,117 @@ configure_settings(bool _init)
         "is collected on every available device",
         "", "rocprofiler", "rocm", "hardware_counters");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_ROCM_EVENTS_KERNEL_INCLUDE",
+        "Regular expression for the kernel names which OMNITRACE_ROCM_EVENTS are "
+        "collected for. If empty, every kernel is eligible",
+        "", "rocprofiler", "rocm", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_ROCM_EVENTS_KERNEL_EXCLUDE",
+        "Regular expression for the kernel names which OMNITRACE_ROCM_EVENTS are never "
+        "collected for. Applied after OMNITRACE_ROCM_EVENTS_KERNEL_INCLUDE",
+        "", "rocprofiler", "rocm", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCM_EVENTS_DISPATCH_INTERVAL",
+        "Collect OMNITRACE_ROCM_EVENTS for every Nth dispatch of each kernel. Values "
+        "are extrapolated by the ratio of total to collected dispatches",
+        1, "rocprofiler", "rocm", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCM_EVENTS_DISPATCH_LIMIT",
+        "Stop collecting OMNITRACE_ROCM_EVENTS for a kernel after this many collected "
+        "dispatches (0 == no limit). Values are extrapolated by the ratio of total to "
+        "collected dispatches",
+        0, "rocprofiler", "rocm", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCM_EVENTS_ROOFLINE",
+        "Derive the FLOPs, bytes, arithmetic intensity, achieved GFLOP/s and GB/s and "
+        "the fraction of the device peak of each kernel from OMNITRACE_ROCM_EVENTS. The "
+        "FLOPs are derived from the SQ_INSTS_VALU_{ADD,MUL,FMA,TRANS}_F{16,32,64} and "
+        "SQ_INSTS_VALU_MFMA_MOPS_* counters and the bytes from the FETCH_SIZE + "
+        "WRITE_SIZE or TCC_EA_RDREQ + TCC_EA_WRREQ counters",
+        true, "rocprofiler", "rocm", "hardware_counters", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_ROCM_EVENTS_PEAK_GFLOPS",
+        "Peak GFLOP/s of the devices for OMNITRACE_ROCM_EVENTS_ROOFLINE. If zero, the "
+        "vector FP32 peak is computed from the device properties",
+        0.0, "rocprofiler", "rocm", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_ROCM_EVENTS_PEAK_GBPS",
+        "Peak memory bandwidth (GB/s) of the devices for OMNITRACE_ROCM_EVENTS_ROOFLINE. "
+        "If zero, it is computed from the memory clock and bus width of the device",
+        0.0, "rocprofiler", "rocm", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PC_SAMPLING",
+        "Sample the program counters of the GPU waves via rocprofiler-sdk (MI200 and "
+        "newer) and report the hottest instructions of each kernel with the source line "
+        "from the DWARF of the code object. Requires omnitrace built with "
+        "OMNITRACE_USE_ROCPROFILER_SDK=ON",
+        false, "pc_sampling", "rocm", "sampling", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_PC_SAMPLING_METHOD",
+        "GPU PC sampling method. The host-trap method is supported by MI200 and MI300, "
+        "the stochastic method (MI300) additionally provides the wave state, i.e. "
+        "whether the instruction was issued and, if not, why",
+        std::string{ "host_trap" }, "pc_sampling", "rocm", "sampling", "advanced")
+        ->set_choices({ "host_trap", "stochastic" });
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PC_SAMPLING_INTERVAL",
+        "Interval of the GPU PC sampling: microseconds for the host-trap method and "
+        "cycles (a power of two) for the stochastic method. The value is clamped to the "
+        "range supported by the device",
+        size_t{ 1000 }, "pc_sampling", "rocm", "sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PC_SAMPLING_TOP",
+        "Number of instructions reported for each kernel in pc-sampling.txt. Zero "
+        "reports every sampled instruction",
+        size_t{ 20 }, "pc_sampling", "rocm", "sampling", "advanced");
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_ROCM_SMI_METRICS",
                              "rocm-smi metrics to collect: busy, temp, power, mem_usage",
                              "busy,temp,power,mem_usage", "backend", "rocm_smi", "rocm",
                              "process_sampling", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCM_SMI_PER_DEVICE_POLLING",
+        "Sample each GPU from a dedicated rocm-smi polling thread instead of the "
+        "background process sampler thread. Prevents slow rocm-smi queries on multi-GPU "
+        "nodes from delaying the CPU frequency/memory samples",
+        true, "rocm_smi", "rocm", "process_sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCM_SMI_BUFFER_SIZE",
+        "Maximum number of rocm-smi samples retained per GPU. When non-zero, the "
+        "samples are stored in a ring buffer which is allocated up front and overwrites "
+        "the oldest samples once it is full. When zero, the samples are retained in "
+        "blocks which are allocated as needed",
+        size_t{ 0 }, "rocm_smi", "rocm", "process_sampling", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCM_SMI_MAX_OUTPUT_SAMPLES",
+        "When non-zero and more rocm-smi samples than this were collected for a GPU, the "
+        "samples are split into this many intervals and only the minimum and maximum "
+        "of each metric within each interval are written to the perfetto trace. This "
+        "keeps the peaks of high-frequency sampling without bloating the trace",
+        size_t{ 0 }, "rocm_smi", "rocm", "process_sampling", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCM_SMI_ENERGY",
+        "Integrate the rocm-smi power samples of each GPU over the execution of each "
+        "kernel (concurrent kernels share the energy equally) and over the user regions "
+        "and report the joules per kernel and per region in gpu-energy.txt. Requires "
+        "'power' in OMNITRACE_ROCM_SMI_METRICS",
+        false, "rocm_smi", "rocm", "energy", "analysis");
+
     OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_PERFETTO_SHMEM_SIZE_HINT_KB",
                              "Hint for shared-memory buffer size in perfetto (in KB)",
                              size_t{ 4096 }, "perfetto", "data", "advanced");
@@ -656,23 +1294,295 @@ configure_settings(bool _init)
                              "Size of perfetto buffer (in KB)", size_t{ 1024000 },
                              "perfetto", "data");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_BUFFER_ADAPTIVE",
+        "Size the perfetto buffer from the event rate measured during the first "
+        "OMNITRACE_PERFETTO_BUFFER_ADAPTIVE_WINDOW seconds, within "
+        "OMNITRACE_PERFETTO_MEMORY_BUDGET_KB. The fill level of the buffer is monitored "
+        "and, when it crosses OMNITRACE_PERFETTO_BUFFER_HIGH_WATERMARK, the buffer grows "
+        "or is written into the temporary file more frequently. Resizing requires "
+        "OMNITRACE_USE_TEMPORARY_FILES and the inprocess backend",
+        false, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_MEMORY_BUDGET_KB",
+        "Maximum size of the perfetto buffer (in KB) when "
+        "OMNITRACE_PERFETTO_BUFFER_ADAPTIVE is enabled. Zero uses the value of "
+        "OMNITRACE_PERFETTO_BUFFER_SIZE_KB",
+        size_t{ 0 }, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_BUFFER_ADAPTIVE_WINDOW",
+        "Number of seconds after perfetto starts during which the event rate is measured "
+        "when OMNITRACE_PERFETTO_BUFFER_ADAPTIVE is enabled",
+        2.0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_BUFFER_HIGH_WATERMARK",
+        "Fraction of the perfetto buffer which may hold unwritten data before the "
+        "buffer is considered at risk of dropping events when "
+        "OMNITRACE_PERFETTO_BUFFER_ADAPTIVE is enabled",
+        0.5, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_TRACE_RANKS",
+        "Comma-separated list of the ranks which produce perfetto traces and sampling "
+        "call-chains, e.g. '0,4-7,16-64:16' (ranges are inclusive, ':N' is a stride). "
+        "'auto' selects the first rank on each node. All other ranks only collect a "
+        "flat timemory profile (incl. the comm_data counters). Empty selects every "
+        "rank. Perfetto traces are not combined when this is set",
+        "", "perfetto", "data", "mpi", "advanced");
+
     OMNITRACE_CONFIG_SETTING(bool, "OMNITRACE_PERFETTO_COMBINE_TRACES",
                              "Combine Perfetto traces. If not explicitly set, it will "
                              "default to the value of OMNITRACE_COLLAPSE_PROCESSES",
                              false, "perfetto", "data", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_CLOCK_SYNC",
+        "When the perfetto traces are combined, estimate the offset of the clock of "
+        "each rank relative to rank 0 via MPI ping-pongs after MPI_Init and before "
+        "MPI_Finalize and convert the timestamps of the trace of each rank to the "
+        "clock of rank 0 (linear drift between the two estimates) when it is written",
+        true, "perfetto", "data", "mpi", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_COLLAPSE_NODES",
+        "Reduce the wall-clock call-graph of the ranks hierarchically instead of "
+        "gathering the per-rank data on rank 0: the ranks are first merged per node "
+        "via a shared-memory communicator and the node leaders are then reduced in a "
+        "tree. Rank 0 writes the min, max, mean, and standard deviation of each "
+        "call-path across the ranks of each node. Overrides OMNITRACE_COLLAPSE_PROCESSES",
+        false, "timemory", "mpi", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_DEFER_POST_PROCESSING",
+        "Skip the symbolization and the perfetto and timemory output of the sampled "
+        "call-stacks during finalization. The raw samples, the thread info, and the "
+        "loaded objects (with build-ids) are written to a compact raw-samples file "
+        "which is converted by the omnitrace-post executable, possibly on another "
+        "machine",
+        false, "sampling", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_FLUSH_INTERVAL",
+        "Interval (in seconds) at which the sampled call-stacks are written to rolling "
+        "raw-samples-flush files and released from memory. This bounds the memory of "
+        "long-running processes and preserves the samples up to the last flush if the "
+        "process is killed. Implies OMNITRACE_DEFER_POST_PROCESSING for the samples: "
+        "omnitrace-post merges the files of each process. A value of zero disables the "
+        "periodic flush",
+        0.0, "sampling", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PREEMPTION_FLUSH",
+        "When the process receives OMNITRACE_PREEMPTION_SIGNAL (e.g. a batch scheduler "
+        "preempting the job), skip the finalization: stop the samplers, write the "
+        "perfetto trace and the raw samples (as with OMNITRACE_DEFER_POST_PROCESSING) "
+        "for omnitrace-post, and re-raise the signal",
+        false, "sampling", "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(int, "OMNITRACE_PREEMPTION_SIGNAL",
+                             "Signal which triggers the OMNITRACE_PREEMPTION_FLUSH",
+                             SIGTERM, "sampling", "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PREEMPTION_DEADLINE",
+        "Time (in seconds) after OMNITRACE_PREEMPTION_SIGNAL is received after which the "
+        "signal is re-raised even if the OMNITRACE_PREEMPTION_FLUSH has not completed. "
+        "Should be less than the grace period of the scheduler",
+        10.0, "sampling", "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_EXPORT_ENDPOINT",
+        "Collector which receives live region statistics and sampling hot-spots from a "
+        "background thread, as 'host:port' (TCP) or 'unix:<path>'. Each message is a "
+        "4-byte big-endian length followed by a JSON document. An empty value disables "
+        "the exporter",
+        std::string{}, "timemory", "sampling", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(double, "OMNITRACE_EXPORT_INTERVAL",
+                             "Interval (in seconds) between the messages sent to "
+                             "OMNITRACE_EXPORT_ENDPOINT",
+                             1.0, "timemory", "sampling", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_EXPORT_BUFFER_SIZE_KB",
+        "Maximum number of kilobytes buffered for OMNITRACE_EXPORT_ENDPOINT while the "
+        "collector is not connected or not keeping up. Messages which do not fit are "
+        "dropped and counted",
+        4096, "timemory", "sampling", "io", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_PERFETTO_ROCTRACER_PER_STREAM",
         "Separate roctracer GPU side traces (copies, kernels) into separate "
         "tracks based on the stream they're enqueued into",
         true, "perfetto", "roctracer", "rocm", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCTRACER_MEMORY_TRACKING",
+        "Track the allocations and releases of the HIP memory API (hipMalloc, "
+        "hipMallocManaged, hipHostMalloc, hipFree, etc.): per-device live bytes as "
+        "perfetto counter tracks and a hip-memory summary of the peak and live bytes, "
+        "allocation size histogram, and allocating call sites",
+        false, "roctracer", "rocm", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_ROCTRACER_MEMORY_TOP",
+        "Number of call sites with the most allocations reported for each memory pool by "
+        "OMNITRACE_ROCTRACER_MEMORY_TRACKING",
+        size_t{ 10 }, "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCTRACER_TIMELINE_ANALYSIS",
+        "Analyze the roctracer GPU activity at finalization: per-device busy fraction, "
+        "kernel overlap, launch latency (HIP API call to kernel begin), and idle gaps. "
+        "Emits perfetto counter tracks and a roctracer-timeline summary",
+        false, "roctracer", "rocm", "perfetto", "timemory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCTRACER_GRAPH_TRACING",
+        "Record the HIP graphs created by hipStreamEndCapture and instantiated via "
+        "hipGraphInstantiate, attribute the kernels of every hipGraphLaunch to the "
+        "kernel nodes of the graph, and emit a roctracer-graphs summary of the launch "
+        "timing per graph",
+        false, "roctracer", "rocm", "perfetto", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_ROCTRACER_KERNEL_OCCUPANCY",
+        "Record the launch configuration (grid, block, dynamic shared memory) of the "
+        "HIP kernel launches and the register and LDS usage of the kernels in the "
+        "loaded code objects. Annotates the kernel slices with the theoretical "
+        "occupancy and its limiting resource and aggregates it in timemory",
+        false, "roctracer", "rocm", "perfetto", "timemory", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MPI_MATCHING",
+        "Number the MPI collectives per communicator and the point-to-point messages "
+        "per (source, destination, tag, communicator) so that matching calls on "
+        "different ranks are connected by perfetto flow events. The arrival skew "
+        "(last arrival - first arrival) of every collective is computed across the "
+        "ranks during finalization",
+        false, "perfetto", "mpi", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MPI_COLLECTIVE_WAIT",
+        "Insert a zero-byte barrier on the communicator before MPI_Allreduce and "
+        "MPI_Alltoall to split the collectives into the time spent waiting for the "
+        "slowest rank and the time spent transferring data. MPI_Barrier is treated as "
+        "entirely waiting. Changes the synchronization of the application",
+        false, "perfetto", "timemory", "mpi", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_COMM_DATA_PER_PEER",
+        "In addition to the total MPI/RCCL communication volume, write a separate "
+        "counter track for each peer (destination/source rank) of point-to-point "
+        "communication",
+        false, "perfetto", "mpi", "rccl", "data", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_PERFETTO_FILL_POLICY",
         "Behavior when perfetto buffer is full. 'discard' will ignore new entries, "
         "'ring_buffer' will overwrite old entries",
         "discard", "perfetto", "data")
-        ->set_choices({ "fill", "discard" });
+        ->set_choices({ "fill", "discard", "ring_buffer" });
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_PERFETTO_COMPRESSION",
+        "Compress the perfetto trace while it is written to the output file. The "
+        "perfetto UI and trace_processor open gzip-compressed traces directly, zstd "
+        "traces must be decompressed first (e.g. 'zstd -d'). The '.gz' or '.zst' "
+        "extension is appended to the filename. Requires omnitrace to be built with "
+        "OMNITRACE_USE_ZLIB or OMNITRACE_USE_ZSTD",
+        "none", "perfetto", "data", "io")
+        ->set_choices({ "none", "gzip", "zstd" });
+
+    OMNITRACE_CONFIG_SETTING(int, "OMNITRACE_PERFETTO_COMPRESSION_LEVEL",
+                             "Level of OMNITRACE_PERFETTO_COMPRESSION (1-9 for gzip, "
+                             "1-19 for zstd). Zero uses the default of the codec",
+                             0, "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_COMPRESS_PACKETS",
+        "Have perfetto deflate the packets of the trace buffer when the trace is read. "
+        "Only effective when the perfetto SDK was built with zlib support",
+        false, "perfetto", "data", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_SNAPSHOT",
+        "Flight-recorder mode: the perfetto trace is kept in an in-memory ring buffer "
+        "(OMNITRACE_PERFETTO_BUFFER_SIZE_KB determines how much history is retained) and "
+        "a snapshot of the buffer is written to a separate file whenever one is "
+        "triggered via omnitrace_user_trigger_snapshot(), "
+        "OMNITRACE_PERFETTO_SNAPSHOT_SIGNAL, or OMNITRACE_PERFETTO_SNAPSHOT_THRESHOLD. "
+        "Tracing continues after every snapshot. Requires the inprocess backend and "
+        "implies the ring_buffer fill policy and no temporary files for perfetto",
+        false, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        int, "OMNITRACE_PERFETTO_SNAPSHOT_SIGNAL",
+        "When OMNITRACE_PERFETTO_SNAPSHOT is enabled and this value is non-zero, "
+        "delivering this signal to the process (e.g. 'kill -USR2 <pid>') triggers a "
+        "snapshot. The signal must not be used by the application",
+        0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_SNAPSHOT_THRESHOLD",
+        "When OMNITRACE_PERFETTO_SNAPSHOT is enabled and this value is greater than "
+        "zero, any region (host, user, python, kokkos, mpi, ...) which takes longer "
+        "than this many seconds triggers a snapshot",
+        0.0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_SNAPSHOT_LIMIT",
+        "Maximum number of snapshots written in OMNITRACE_PERFETTO_SNAPSHOT mode. "
+        "Triggers beyond this limit are ignored and triggers which arrive while a "
+        "snapshot is being written are coalesced",
+        16, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_PERFETTO_ITERATION_REGION",
+        "Name of the region (host, user, or python) which delimits an iteration of the "
+        "application, e.g. the name passed to omnitrace_user_push_region. The perfetto "
+        "events of all the threads within each iteration are buffered and only written "
+        "if the iteration is slow (see OMNITRACE_PERFETTO_ITERATION_THRESHOLD and "
+        "OMNITRACE_PERFETTO_ITERATION_PERCENTILE). The slice of the iteration region "
+        "itself is always written",
+        "", "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_ITERATION_THRESHOLD",
+        "When OMNITRACE_PERFETTO_ITERATION_REGION is set and this value is greater than "
+        "zero, only the iterations which take longer than this many seconds are "
+        "written to the perfetto trace",
+        0.0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_PERFETTO_ITERATION_PERCENTILE",
+        "When OMNITRACE_PERFETTO_ITERATION_REGION is set and "
+        "OMNITRACE_PERFETTO_ITERATION_THRESHOLD is zero, only the iterations which "
+        "take longer than this percentile of the durations of the previous iterations "
+        "(estimated online) are written to the perfetto trace",
+        99.0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_BATCH_SIZE",
+        "When greater than zero, the begin and end events of the slices on the thread "
+        "tracks which carry no annotations are buffered per thread (up to this many "
+        "events) and written to perfetto by a background thread. This reduces the "
+        "overhead of instrumented regions which are entered at a very high rate but "
+        "the debug annotations of these slices (see OMNITRACE_PERFETTO_ANNOTATIONS) are "
+        "not written",
+        0, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_EVENT_LOG",
+        "Record the entry and exit of the instrumented functions (omnitrace_push_trace "
+        "and omnitrace_pop_trace) as 16-byte records in per-thread memory-mapped logs "
+        "which are converted to perfetto at finalization. This reduces the cost of "
+        "tracing every function to a few nanoseconds per call but these functions are "
+        "not included in the timemory profile",
+        false, "perfetto", "trace", "overhead", "advanced");
 
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_ENABLE_CATEGORIES",
                              "Enable collecting profiling and trace data for these "
@@ -694,6 +1604,13 @@ configure_settings(bool _init)
                              "feature may dramatically reduce the size of the trace",
                              true, "perfetto", "data", "debugging", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TIMEMORY_ANNOTATIONS",
+        "Record the numeric fields of the values passed to the regions of the "
+        "registered annotation schemas (omnitrace_user_push_schema_region) as timemory "
+        "data trackers named <REGION>/<FIELD>",
+        false, "timemory", "data", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_PERFETTO_COMPACT_ROCTRACER_ANNOTATIONS",
         "When PERFETTO_ANNOTATIONS, USE_ROCTRACER, and ROCTRACER_HIP_API are all "
@@ -713,11 +1630,58 @@ configure_settings(bool _init)
                            1),
         "parallelism", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_THREAD_POOL_AFFINITY",
+        "CPUs for the threads processing background tasks. 'none' does not restrict the "
+        "threads, 'auto' places them on the CPUs of the process cpuset which are not "
+        "claimed by the pinned threads of the application, otherwise a list/range of "
+        "CPUs, e.g. '0-3,8' (restricted to the process cpuset). When empty, 'auto' is "
+        "used if OMNITRACE_CPU_AFFINITY is enabled and 'none' otherwise",
+        std::string{}, "parallelism", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_TIMEMORY_COMPONENTS",
         "List of components to collect via timemory (see `omnitrace-avail -C`)",
         "wall_clock", "timemory", "component");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_STREAM_OUTPUT",
+        "Write the call-graph of each timing and resource-usage component (wall_clock, "
+        "cpu_clock, peak_rss, ...) by streaming the nodes directly to the file instead "
+        "of building the full JSON document in memory. The components are serialized "
+        "in parallel and replace the JSON and tree output of timemory "
+        "(OMNITRACE_JSON_OUTPUT and OMNITRACE_TREE_OUTPUT are disabled). The text "
+        "output is unaffected",
+        false, "timemory", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_STREAM_OUTPUT_FORMAT",
+                             "Format of the OMNITRACE_STREAM_OUTPUT files: 'json' "
+                             "or 'msgpack' (compact binary MessagePack)",
+                             "json", "timemory", "io", "advanced")
+        ->set_choices({ "json", "msgpack" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SELF_OVERHEAD",
+        "Measure the time each thread spends inside omnitrace (sampler handlers, "
+        "region push/pop, gotcha wrappers, callback threads) via the time-stamp counter "
+        "and report it as the self_overhead component, a perfetto counter track and "
+        "metadata",
+        false, "timemory", "perfetto", "debugging", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_SELF_OVERHEAD_CORRECTION",
+        "Subtract the time spent inside omnitrace by the nested instrumentation (plus "
+        "the mean cost of the measurement) from the wall-clock time of each region. "
+        "Requires OMNITRACE_SELF_OVERHEAD",
+        false, "timemory", "debugging", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_FINALIZE_TIMINGS_FILE",
+        "Append the wall-clock time and the peak resident set size of each phase of "
+        "the finalization (shutdown, post-processing stages, perfetto and timemory "
+        "output) to this CSV file. Every process appends its own rows",
+        std::string{}, "io", "filename", "debugging", "advanced");
+
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_OUTPUT_FILE",
                              "[DEPRECATED] See OMNITRACE_PERFETTO_FILE", std::string{},
                              "perfetto", "io", "filename", "deprecated", "advanced");
@@ -736,6 +1700,53 @@ configure_settings(bool _init)
         std::string, "OMNITRACE_TMPDIR", "Base directory for temporary files",
         get_env<std::string>("TMPDIR", "/tmp"), "io", "data", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_BINARY_CACHE_DIR",
+        "Directory for caching the processed symbols and DWARF line info of binaries. "
+        "Entries are keyed by the build-id, modification time, and size of the binary "
+        "and are reused by subsequent runs. An empty value disables the cache",
+        std::string{}, "io", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_BINARY_CACHE_NODE_SHARED",
+        "Share the processed symbols and DWARF line info of binaries between the "
+        "processes on a node. The first process to analyze a binary builds the cache "
+        "entry while holding a lock file in OMNITRACE_TMPDIR and the other processes "
+        "wait for it and map the entry read-only. The entries are stored in "
+        "OMNITRACE_BINARY_CACHE_DIR or, if it is empty, in OMNITRACE_TMPDIR",
+        false, "io", "analysis", "mpi", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_HIP_DEVICE_METADATA_CACHE",
+        "Share the HIP device properties recorded in the metadata between the "
+        "processes on a node which see the same devices. The first process writes them "
+        "to OMNITRACE_TMPDIR and the other processes read them instead of selecting "
+        "and querying every device",
+        true, "io", "rocm", "mpi", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_BINARY_LAZY_DWARF",
+        "Only read the symbol tables and the address ranges of the compilation units "
+        "when analyzing binaries and decode the DWARF line info of a compilation unit "
+        "on the first lookup of an address inside of it",
+        false, "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_BINARY_INCREMENTAL",
+        "Analyze the libraries which are loaded via dlopen after the initial binary "
+        "analysis (e.g. Python extension modules and plugins) in the background and "
+        "add them to the eligible addresses of causal profiling. Libraries which are "
+        "unloaded via dlclose are removed",
+        false, "analysis", "causal", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_JIT_SYMBOLS",
+        "Resolve the sampled addresses in JIT-compiled code (e.g. LuaJIT, PyPy, Julia, "
+        "V8) via the perf map (/tmp/perf-<pid>.map) and the perf jitdump "
+        "(jit-<pid>.dump) written by the JIT. The files are read as the JIT appends "
+        "to them",
+        true, "sampling", "analysis", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         std::string, "OMNITRACE_CAUSAL_BACKEND",
         "Backend for call-stack sampling. See "
@@ -783,20 +1794,83 @@ configure_settings(bool _init)
         "causal", "analysis", "advanced", "io");
 
     OMNITRACE_CONFIG_SETTING(
-        uint64_t, "OMNITRACE_CAUSAL_RANDOM_SEED",
-        "Seed for random number generator which selects speedups and experiments -- "
-        "please note that the lines selected for experimentation are not reproducible "
-        "but the speedup selection is. If set to zero, std::random_device{}() will be "
-        "used.",
-        0, "causal", "analysis");
+        bool, "OMNITRACE_CAUSAL_LOG",
+        "Append each causal experiment to a line-delimited JSON log ('<output>.jsonl') as "
+        "soon as it completes so that the results survive a crash. The log is never "
+        "re-read: the JSON output only contains the experiments of the current run and "
+        "omnitrace-causal-plot reads (and merges) the logs of all the runs",
+        false, "causal", "analysis", "advanced", "io");
 
-    OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_CAUSAL_FIXED_SPEEDUP",
-                             "List of virtual speedups between 0 and 100 (inclusive) to "
-                             "sample from for causal profiling",
-                             std::string{}, "causal", "analysis", "advanced");
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CAUSAL_COORDINATE",
+        "Path to a file which is accessible by all the processes of a job (e.g. the MPI "
+        "ranks). When set, the process with rank zero selects the line/function and "
+        "virtual speedup of each causal experiment and the other processes perform the "
+        "same experiment at the same time. The progress points of every process are "
+        "combined into '<path>.coz'",
+        std::string{}, "causal", "analysis", "mpi", "advanced");
 
     OMNITRACE_CONFIG_SETTING(
-        std::string, "OMNITRACE_CAUSAL_BINARY_SCOPE",
+        bool, "OMNITRACE_CAUSAL_ADAPTIVE",
+        "Instead of sampling the virtual speedups uniformly, select the virtual speedup "
+        "whose effect on the program speedup is the least certain for the selected "
+        "line/function, skip the lines/functions whose effects are already known within "
+        "OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE and stop experimenting once every "
+        "line/function which is selected is known within the tolerance",
+        false, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE",
+        "Half-width of the 95% confidence interval of the predicted program speedup "
+        "(as a fraction, e.g. 0.05 == +/- 5%) below which the effect of a virtual "
+        "speedup of a line/function is considered known. Only used when "
+        "OMNITRACE_CAUSAL_ADAPTIVE is enabled",
+        0.05, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_CAUSAL_GPU",
+        "Include the GPU kernels and HIP API calls traced by roctracer in the causal "
+        "experiments: every other experiment selects a kernel or HIP API call (weighted "
+        "by its total runtime) and the virtual speedup delays the other host threads "
+        "each time the selected kernel or HIP API call completes. Requires "
+        "OMNITRACE_USE_ROCTRACER",
+        false, "causal", "analysis", "roctracer", "rocm", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        double, "OMNITRACE_CAUSAL_BLOCKING_THRESHOLD",
+        "When greater than zero, the mutex, condition variable, join, and signal waits "
+        "intercepted in causal mode which block for longer than this many seconds are "
+        "attributed to the call stack of the caller and the call sites where the "
+        "threads spent the most time blocked are written to causal/blocking.txt. Helps "
+        "explain why lines executed by threads which mostly wait show no predicted "
+        "speedup",
+        0.0, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CAUSAL_PROGRESS_COUNTERS",
+        "List of counters which are added to the progress points of every causal "
+        "experiment so that the causal profile predicts the impact of a speedup on "
+        "the rate of the counter instead of (only) the rate of the progress points in "
+        "the code. Accepts perf events (e.g. PERF_COUNT_HW_INSTRUCTIONS) and the "
+        "communication data trackers: comm_data (bytes sent and received), "
+        "comm_data::send, and comm_data::recv",
+        std::string{}, "causal", "analysis", "hardware_counters", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        uint64_t, "OMNITRACE_CAUSAL_RANDOM_SEED",
+        "Seed for random number generator which selects speedups and experiments -- "
+        "please note that the lines selected for experimentation are not reproducible "
+        "but the speedup selection is. If set to zero, std::random_device{}() will be "
+        "used.",
+        0, "causal", "analysis");
+
+    OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_CAUSAL_FIXED_SPEEDUP",
+                             "List of virtual speedups between 0 and 100 (inclusive) to "
+                             "sample from for causal profiling",
+                             std::string{}, "causal", "analysis", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CAUSAL_BINARY_SCOPE",
         "Limits causal experiments to the binaries matching the provided list of regular "
         "expressions (separated by tab, semi-colon, and/or quotes (single or double))",
         std::string{ "%MAIN%" }, "causal", "analysis");
@@ -966,14 +2040,7 @@ configure_settings(bool _init)
     }
     else
     {
-        auto _papi_events = _config->find("OMNITRACE_PAPI_EVENTS");
-        _add_omnitrace_category(_papi_events);
-        std::vector<std::string> _papi_choices = {};
-        for(auto itr : tim::papi::available_events_info())
-        {
-            if(itr.available()) _papi_choices.emplace_back(itr.symbol());
-        }
-        _papi_events->second->set_choices(_papi_choices);
+        _add_omnitrace_category(_config->find("OMNITRACE_PAPI_EVENTS"));
     }
 #else
     _config->find("OMNITRACE_PAPI_EVENTS")->second->set_hidden(true);
@@ -998,10 +2065,13 @@ configure_settings(bool _init)
     }
     if(!_found_sep && _cmd.size() > 1) _cmd.insert(_cmd.begin() + 1, "--");
 
-    auto _pid       = getpid();
-    auto _ppid      = getppid();
-    auto _proc      = mproc::get_concurrent_processes(_ppid);
-    bool _main_proc = (_proc.size() < 2 || *_proc.begin() == _pid);
+    // scanning /proc for the sibling processes is only necessary when the contents of
+    // the config files are printed
+    auto _is_main_proc = []() {
+        auto _pid  = getpid();
+        auto _proc = mproc::get_concurrent_processes(getppid());
+        return (_proc.size() < 2 || *_proc.begin() == _pid);
+    };
 
     for(auto&& itr :
         tim::delimit(_config->get<std::string>("OMNITRACE_CONFIG_FILE"), ";:"))
@@ -1009,9 +2079,10 @@ configure_settings(bool _init)
         if(_config->get_suppress_config()) continue;
 
         OMNITRACE_BASIC_VERBOSE(1, "Reading config file %s\n", itr.c_str());
-        if(_config->read(itr) && _main_proc &&
+        if(_config->read(itr) &&
            ((_config->get<bool>("OMNITRACE_CI") && settings::verbose() >= 0) ||
-            settings::verbose() >= 1 || settings::debug()))
+            settings::verbose() >= 1 || settings::debug()) &&
+           _is_main_proc())
         {
             auto              fitr = settings::format(itr, _config->get_tag());
             std::ifstream     _in{ fitr };
@@ -1056,6 +2127,30 @@ configure_settings(bool _init)
         _combine_perfetto_traces->second->set(_config->get<bool>("collapse_processes"));
     }
 
+    // the per-rank data is not gathered when it is summarized per node
+    if(_config->get<bool>("OMNITRACE_COLLAPSE_NODES") &&
+       _config->get<bool>("collapse_processes"))
+    {
+        OMNITRACE_BASIC_VERBOSE(1, "OMNITRACE_COLLAPSE_NODES disables "
+                                   "OMNITRACE_COLLAPSE_PROCESSES\n");
+        _config->get_collapse_processes() = false;
+    }
+
+    // the data addresses are only delivered by the overflow sampler
+    if(_config->get<bool>("OMNITRACE_NUMA_LOCALITY") &&
+       !_config->get<bool>("OMNITRACE_SAMPLING_OVERFLOW"))
+    {
+        OMNITRACE_BASIC_VERBOSE(0, "OMNITRACE_NUMA_LOCALITY only records the page "
+                                   "placement without OMNITRACE_SAMPLING_OVERFLOW\n");
+    }
+
+    if(_config->get<bool>("OMNITRACE_SAMPLING_MEMORY") &&
+       !_config->get<bool>("OMNITRACE_SAMPLING_OVERFLOW"))
+    {
+        OMNITRACE_BASIC_VERBOSE(0, "OMNITRACE_SAMPLING_MEMORY requires "
+                                   "OMNITRACE_SAMPLING_OVERFLOW\n");
+    }
+
     handle_deprecated_setting("OMNITRACE_ROCM_SMI_DEVICES", "OMNITRACE_SAMPLING_GPUS");
     handle_deprecated_setting("OMNITRACE_USE_THREAD_SAMPLING",
                               "OMNITRACE_USE_PROCESS_SAMPLING");
@@ -1063,6 +2158,8 @@ configure_settings(bool _init)
     handle_deprecated_setting("OMNITRACE_USE_PERFETTO", "OMNITRACE_TRACE");
     handle_deprecated_setting("OMNITRACE_USE_TIMEMORY", "OMNITRACE_PROFILE");
 
+    configure_trace_ranks(_config);
+
     scope::get_fields()[scope::flat::value]     = _config->get_flat_profile();
     scope::get_fields()[scope::timeline::value] = _config->get_timeline_profile();
 
@@ -1090,12 +2187,47 @@ configure_settings(bool _init)
     configure_mode_settings(_config);
     configure_signal_handler(_config);
     configure_disabled_settings(_config);
+    refresh_snapshot();
 
     OMNITRACE_BASIC_VERBOSE(2, "configuration complete\n");
 
     _settings_are_configured() = true;
 }
 
+void
+configure_setting_choices()
+{
+    static bool _once = false;
+    if(_once) return;
+    _once = true;
+
+    auto _config      = get_config();
+    auto _set_choices = [&_config](const char* _name, std::vector<std::string> _v) {
+        auto itr = _config->find(_name);
+        if(itr != _config->end()) itr->second->set_choices(std::move(_v));
+    };
+
+    auto _perf_choices = perf::get_config_choices();
+    _set_choices("OMNITRACE_SAMPLING_OVERFLOW_EVENT", _perf_choices);
+
+    auto _progress_choices = _perf_choices;
+    for(const auto* itr : { "comm_data", "comm_data::send", "comm_data::recv" })
+        _progress_choices.emplace_back(itr);
+    _set_choices("OMNITRACE_CAUSAL_PROGRESS_COUNTERS", std::move(_progress_choices));
+
+#if defined(TIMEMORY_USE_PAPI)
+    if(trait::runtime_enabled<comp::papi_vector>::get())
+    {
+        auto _papi_choices = std::vector<std::string>{};
+        for(auto itr : tim::papi::available_events_info())
+        {
+            if(itr.available()) _papi_choices.emplace_back(itr.symbol());
+        }
+        _set_choices("OMNITRACE_PAPI_EVENTS", std::move(_papi_choices));
+    }
+#endif
+}
+
 void
 configure_mode_settings(const std::shared_ptr<settings>& _config)
 {
@@ -1265,6 +2397,72 @@ set_signal_handler(signal_handler_t _func)
     return get_signal_handler().load();
 }
 
+void
+configure_trace_ranks(const std::shared_ptr<settings>& _config)
+{
+    auto _spec = _config->get<std::string>("OMNITRACE_TRACE_RANKS");
+    if(_spec.empty()) return;
+
+    // the combined trace and the clock synchronization are collective over all the
+    // ranks and the unselected ranks do not have a trace to contribute
+    set_setting_value("OMNITRACE_PERFETTO_COMBINE_TRACES", false);
+
+    auto _rank = mproc::get_launcher_rank();
+    if(_rank < 0)
+    {
+        OMNITRACE_BASIC_VERBOSE(1, "OMNITRACE_TRACE_RANKS is ignored because the rank "
+                                   "is not known before MPI_Init...\n");
+        return;
+    }
+
+    auto _to_rank = [&_spec](const std::string& _v) {
+        auto _pos = size_t{ 0 };
+        auto _val = std::stoi(_v, &_pos);
+        if(_pos != _v.length() || _val < 0)
+            OMNITRACE_THROW("invalid rank '%s' in OMNITRACE_TRACE_RANKS=%s\n",
+                            _v.c_str(), _spec.c_str());
+        return _val;
+    };
+
+    bool _selected = false;
+    for(const auto& itr : tim::delimit(_spec, ", "))
+    {
+        if(itr == "auto")
+        {
+            _selected = _selected || mproc::get_launcher_local_rank() == 0;
+            continue;
+        }
+
+        auto _range  = tim::delimit(itr, ":");
+        auto _bounds = tim::delimit(_range.front(), "-");
+        if(_range.size() > 2 || _bounds.empty() || _bounds.size() > 2)
+            OMNITRACE_THROW("invalid entry '%s' in OMNITRACE_TRACE_RANKS=%s\n",
+                            itr.c_str(), _spec.c_str());
+
+        auto _beg    = _to_rank(_bounds.front());
+        auto _end    = _to_rank(_bounds.back());
+        auto _stride = (_range.size() == 2) ? _to_rank(_range.back()) : 1;
+        if(_stride == 0) _stride = 1;
+
+        if(_rank >= _beg && _rank <= _end && (_rank - _beg) % _stride == 0)
+            _selected = true;
+    }
+
+    if(_selected) return;
+
+    OMNITRACE_BASIC_VERBOSE(1,
+                            "[configure_trace_ranks] rank %i is not in "
+                            "OMNITRACE_TRACE_RANKS=%s. Only collecting a flat "
+                            "profile...\n",
+                            _rank, _spec.c_str());
+
+    set_setting_value("OMNITRACE_TRACE", false);
+    set_setting_value("OMNITRACE_USE_SAMPLING", false);
+    set_setting_value("OMNITRACE_USE_PROCESS_SAMPLING", false);
+    set_setting_value("OMNITRACE_PROFILE", true);
+    _config->get_flat_profile() = true;
+}
+
 void
 configure_signal_handler(const std::shared_ptr<settings>& _config)
 {
@@ -1391,6 +2589,11 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
         _config->find(itr)->second->set_hidden(true);
 #endif
 
+#if !defined(OMNITRACE_USE_ROCPROFILER_SDK) || OMNITRACE_USE_ROCPROFILER_SDK == 0
+    for(const auto& itr : _config->disable_category("pc_sampling"))
+        _config->find(itr)->second->set_hidden(true);
+#endif
+
 #if !defined(OMNITRACE_USE_ROCM_SMI) || OMNITRACE_USE_ROCM_SMI == 0
     _config->find("OMNITRACE_USE_ROCM_SMI")->second->set_hidden(true);
     for(const auto& itr : _config->disable_category("rocm_smi"))
@@ -1405,9 +2608,13 @@ configure_disabled_settings(const std::shared_ptr<settings>& _config)
 
 #if !defined(TIMEMORY_USE_MPI) || TIMEMORY_USE_MPI == 0
     _config->disable("OMNITRACE_PERFETTO_COMBINE_TRACES");
+    _config->disable("OMNITRACE_PERFETTO_CLOCK_SYNC");
     _config->disable("OMNITRACE_COLLAPSE_PROCESSES");
+    _config->disable("OMNITRACE_COLLAPSE_NODES");
     _config->find("OMNITRACE_PERFETTO_COMBINE_TRACES")->second->set_hidden(true);
+    _config->find("OMNITRACE_PERFETTO_CLOCK_SYNC")->second->set_hidden(true);
     _config->find("OMNITRACE_COLLAPSE_PROCESSES")->second->set_hidden(true);
+    _config->find("OMNITRACE_COLLAPSE_NODES")->second->set_hidden(true);
 #endif
 
     _config->disable_category("throttle");
@@ -1877,495 +3084,1314 @@ get_perfetto_roctracer_per_stream()
 }
 
 bool
-get_use_rocprofiler()
+get_roctracer_hip_api_aggregate()
 {
-#if defined(OMNITRACE_USE_ROCPROFILER) && OMNITRACE_USE_ROCPROFILER > 0
-    static auto _v = get_config()->find("OMNITRACE_USE_ROCPROFILER");
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HIP_API_AGGREGATE");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 #else
     return false;
 #endif
 }
 
+double
+get_roctracer_hip_api_aggregate_window()
+{
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HIP_API_AGGREGATE_WINDOW");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+#else
+    return 0.0;
+#endif
+}
+
+double
+get_roctracer_hip_api_aggregate_threshold()
+{
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v =
+        get_config()->find("OMNITRACE_ROCTRACER_HIP_API_AGGREGATE_THRESHOLD");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+#else
+    return 0.0;
+#endif
+}
+
 bool
-get_use_rocm_smi()
+get_roctracer_memory_tracking()
 {
-#if defined(OMNITRACE_USE_ROCM_SMI) && OMNITRACE_USE_ROCM_SMI > 0
-    static auto _v = get_config()->find("OMNITRACE_USE_ROCM_SMI");
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_MEMORY_TRACKING");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 #else
     return false;
 #endif
 }
 
+size_t
+get_roctracer_memory_top()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_MEMORY_TOP");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 bool
-get_use_roctx()
+get_roctracer_timeline_analysis()
 {
 #if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
-    static auto _v = get_config()->find("OMNITRACE_USE_ROCTX");
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_TIMELINE_ANALYSIS");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 #else
     return false;
 #endif
 }
 
-bool&
-get_use_sampling()
+bool
+get_roctracer_graph_tracing()
 {
-#if defined(TIMEMORY_USE_LIBUNWIND)
-    static auto _v = get_config()->find("OMNITRACE_USE_SAMPLING");
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_GRAPH_TRACING");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 #else
-    OMNITRACE_THROW(
-        "Error! sampling was enabled but omnitrace was not built with libunwind support");
-    static bool _v = false;
-    return _v;
+    return false;
 #endif
 }
 
-bool&
-get_use_process_sampling()
+bool
+get_roctracer_kernel_occupancy()
 {
-    static auto _v = get_config()->find("OMNITRACE_USE_PROCESS_SAMPLING");
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_KERNEL_OCCUPANCY");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
 }
 
-bool&
-get_use_pid()
+bool
+get_perfetto_comm_data_per_peer()
 {
-    static auto _v = get_config()->find("OMNITRACE_USE_PID");
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_COMM_DATA_PER_PEER");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-bool&
-get_use_mpip()
+bool
+get_mpi_matching()
 {
-    static auto _v = get_config()->find("OMNITRACE_USE_MPIP");
+    static auto _v = get_config()->find("OMNITRACE_MPI_MATCHING");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 bool
-get_use_kokkosp()
+get_collapse_nodes()
 {
-    static auto _v = get_config()->find("OMNITRACE_USE_KOKKOSP");
+    static auto _v = get_config()->find("OMNITRACE_COLLAPSE_NODES");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 bool
-get_use_kokkosp_kernel_logger()
+get_defer_post_processing()
 {
-    static auto _v = get_config()->find("OMNITRACE_KOKKOSP_KERNEL_LOGGER");
+    static auto _v = get_config()->find("OMNITRACE_DEFER_POST_PROCESSING");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-bool
-get_use_ompt()
+double
+get_flush_interval()
 {
-#if defined(TIMEMORY_USE_OMPT)
-    static auto _v = get_config()->find("OMNITRACE_USE_OMPT");
-    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
-#else
-    return false;
-#endif
+    static auto _v = get_config()->find("OMNITRACE_FLUSH_INTERVAL");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
 bool
-get_use_code_coverage()
+get_preemption_flush()
 {
-    static auto _v = get_config()->find("OMNITRACE_USE_CODE_COVERAGE");
+    static auto _v = get_config()->find("OMNITRACE_PREEMPTION_FLUSH");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-bool
-get_use_rcclp()
+int
+get_preemption_signal()
 {
-    static auto _v = get_config()->find("OMNITRACE_USE_RCCLP");
-    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_PREEMPTION_SIGNAL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+double
+get_preemption_deadline()
+{
+    static auto _v = get_config()->find("OMNITRACE_PREEMPTION_DEADLINE");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+std::string
+get_export_endpoint()
+{
+    static auto _v = get_config()->find("OMNITRACE_EXPORT_ENDPOINT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+double
+get_export_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_EXPORT_INTERVAL");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
 size_t
-get_num_threads_hint()
+get_export_buffer_size_kb()
 {
-    static auto _v = get_config()->find("OMNITRACE_NUM_THREADS_HINT");
+    static auto _v = get_config()->find("OMNITRACE_EXPORT_BUFFER_SIZE_KB");
     return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 bool
-get_sampling_keep_internal()
+get_perfetto_snapshot()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_KEEP_INTERNAL");
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_SNAPSHOT");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 int
-get_sampling_overflow_signal()
+get_perfetto_snapshot_signal()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OVERFLOW_SIGNAL");
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_SNAPSHOT_SIGNAL");
     return static_cast<tim::tsettings<int>&>(*_v->second).get();
 }
 
-int
-get_sampling_realtime_signal()
+double
+get_perfetto_snapshot_threshold()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_REALTIME_SIGNAL");
-    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_SNAPSHOT_THRESHOLD");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
-int
-get_sampling_cputime_signal()
+size_t
+get_perfetto_snapshot_limit()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_SIGNAL");
-    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_SNAPSHOT_LIMIT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 bool
-get_trace_hip_api()
+get_stream_output()
 {
-    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HIP_API");
+    static auto _v = get_config()->find("OMNITRACE_STREAM_OUTPUT");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+std::string
+get_stream_output_format()
+{
+    static auto _v = get_config()->find("OMNITRACE_STREAM_OUTPUT_FORMAT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
 bool
-get_trace_hip_activity()
+get_self_overhead()
 {
-    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HIP_ACTIVITY");
+    static auto _v = get_config()->find("OMNITRACE_SELF_OVERHEAD");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 bool
-get_trace_hsa_api()
+get_self_overhead_correction()
 {
-    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HSA_API");
+    static auto _v = get_config()->find("OMNITRACE_SELF_OVERHEAD_CORRECTION");
+    return get_self_overhead() && static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_finalize_timings_file()
+{
+    static auto _v = get_config()->find("OMNITRACE_FINALIZE_TIMINGS_FILE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_perfetto_iteration_region()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_ITERATION_REGION");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+double
+get_perfetto_iteration_threshold()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_ITERATION_THRESHOLD");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_perfetto_iteration_percentile()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_ITERATION_PERCENTILE");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_batch_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BATCH_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_trace_event_log()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_EVENT_LOG");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 bool
-get_trace_hsa_activity()
+get_numa_locality()
 {
-    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HSA_ACTIVITY");
+    static auto _v = get_config()->find("OMNITRACE_NUMA_LOCALITY");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-size_t
-get_perfetto_shmem_size_hint()
+std::string
+get_numa_locality_event()
 {
-    static auto _v = get_config()->find("OMNITRACE_PERFETTO_SHMEM_SIZE_HINT_KB");
-    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_NUMA_LOCALITY_EVENT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
 size_t
-get_perfetto_buffer_size()
+get_numa_locality_top()
 {
-    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BUFFER_SIZE_KB");
+    static auto _v = get_config()->find("OMNITRACE_NUMA_LOCALITY_TOP");
     return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 bool
-get_perfetto_combined_traces()
+get_sampling_memory()
 {
-#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
-    static auto _v = get_config()->find("OMNITRACE_PERFETTO_COMBINE_TRACES");
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MEMORY");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
-#else
-    return false;
-#endif
 }
 
 std::string
-get_perfetto_fill_policy()
+get_sampling_memory_event()
 {
-    static auto _v = get_config()->find("OMNITRACE_PERFETTO_FILL_POLICY");
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MEMORY_EVENT");
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
-namespace
+size_t
+get_sampling_memory_min_alloc()
 {
-auto
-get_category_config()
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MEMORY_MIN_ALLOC");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_memory_top()
 {
-    using strset_t = std::set<std::string>;
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MEMORY_TOP");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
 
-    static auto _v = []() {
-        auto _avail = get_available_categories<strset_t>();
-        auto _parse = [&_avail](const auto& _setting) {
-            auto _ret = strset_t{};
-            for(auto itr : tim::delimit(
-                    static_cast<tim::tsettings<std::string>&>(*_setting->second).get(),
-                    " ,;:\n\t"))
-            {
-                if(_avail.count(itr) > 0) _ret.emplace(itr);
-            }
-            return _ret;
-        };
+bool
+get_heap_profile()
+{
+    static auto _v = get_config()->find("OMNITRACE_HEAP_PROFILE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
 
-        auto _enabled  = _parse(get_config()->find("OMNITRACE_ENABLE_CATEGORIES"));
-        auto _disabled = _parse(get_config()->find("OMNITRACE_DISABLE_CATEGORIES"));
+size_t
+get_heap_profile_rate()
+{
+    static auto _v = get_config()->find("OMNITRACE_HEAP_PROFILE_RATE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
 
-        if(_enabled.empty() && _disabled.empty())
-        {
-            _enabled = _avail;
-        }
-        else if(_enabled.empty() && !_disabled.empty())
-        {
-            for(auto itr : _avail)
-            {
-                if(_disabled.count(itr) == 0) _enabled.emplace(itr);
-            }
-        }
-        else if(!_enabled.empty() && _disabled.empty())
-        {
-            for(auto itr : _avail)
-            {
-                if(_enabled.count(itr) == 0) _disabled.emplace(itr);
-            }
-        }
-        else
-        {
-            OMNITRACE_ABORT("Error! Conflicting options OMNITRACE_ENABLE_CATEGORIES and "
-                            "OMNITRACE_DISABLE_CATEGORIES were both provided.");
-        }
+size_t
+get_heap_profile_top()
+{
+    static auto _v = get_config()->find("OMNITRACE_HEAP_PROFILE_TOP");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
 
-        OMNITRACE_CI_THROW(_enabled.size() + _disabled.size() != _avail.size(),
-                           "Error! Internal error for categories: %zu (enabled) + %zu "
-                           "(disabled) != %zu (total)\n",
-                           _enabled.size(), _disabled.size(), _avail.size());
+bool
+get_process_sampling_network()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_NETWORK");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
 
-        return std::make_pair(_enabled, _disabled);
-    }();
+bool
+get_process_sampling_cpu_energy()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_CPU_ENERGY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
 
-    return _v;
+bool
+get_process_sampling_cgroup()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_CGROUP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
-}  // namespace
-std::set<std::string>
-get_enabled_categories()
+
+bool
+get_process_sampling_memory_bandwidth()
 {
-    return get_category_config().first;
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_MEMORY_BANDWIDTH");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-std::set<std::string>
-get_disabled_categories()
+bool
+get_io_trace()
 {
-    return get_category_config().second;
+    static auto _v = get_config()->find("OMNITRACE_IO_TRACE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_io_callsite_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_IO_CALLSITE_INTERVAL");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_io_trace_top()
+{
+    static auto _v = get_config()->find("OMNITRACE_IO_TRACE_TOP");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 bool
-get_perfetto_annotations()
+get_trace_python_gil()
 {
-    static auto _v = get_config()->find("OMNITRACE_PERFETTO_ANNOTATIONS");
+    static auto _v = get_config()->find("OMNITRACE_TRACE_PYTHON_GIL");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-uint64_t
-get_thread_pool_size()
+bool
+get_mpi_collective_wait()
 {
-    static uint64_t _v = get_config()->get<uint64_t>("OMNITRACE_THREAD_POOL_SIZE");
+    static auto _v = get_config()->find("OMNITRACE_MPI_COLLECTIVE_WAIT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_rocprofiler()
+{
+#if defined(OMNITRACE_USE_ROCPROFILER) && OMNITRACE_USE_ROCPROFILER > 0
+    static auto _v = get_config()->find("OMNITRACE_USE_ROCPROFILER");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+bool
+get_use_rocm_smi()
+{
+#if defined(OMNITRACE_USE_ROCM_SMI) && OMNITRACE_USE_ROCM_SMI > 0
+    static auto _v = get_config()->find("OMNITRACE_USE_ROCM_SMI");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+bool
+get_use_roctx()
+{
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    static auto _v = get_config()->find("OMNITRACE_USE_ROCTX");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+bool&
+get_use_sampling()
+{
+#if defined(TIMEMORY_USE_LIBUNWIND)
+    static auto _v = get_config()->find("OMNITRACE_USE_SAMPLING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    OMNITRACE_THROW(
+        "Error! sampling was enabled but omnitrace was not built with libunwind support");
+    static bool _v = false;
     return _v;
+#endif
+}
+
+bool&
+get_use_process_sampling()
+{
+    static auto _v = get_config()->find("OMNITRACE_USE_PROCESS_SAMPLING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool&
+get_use_pid()
+{
+    static auto _v = get_config()->find("OMNITRACE_USE_PID");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 std::string
-get_trace_hsa_api_types()
+get_fork_mode()
 {
-    static std::string _v =
-        get_config()->get<std::string>("OMNITRACE_ROCTRACER_HSA_API_TYPES");
-    return _v;
+    static auto _v = get_config()->find("OMNITRACE_FORK_MODE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool&
+get_use_mpip()
+{
+    static auto _v = get_config()->find("OMNITRACE_USE_MPIP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_kokkosp()
+{
+    static auto _v = get_config()->find("OMNITRACE_USE_KOKKOSP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_kokkosp_kernel_logger()
+{
+    static auto _v = get_config()->find("OMNITRACE_KOKKOSP_KERNEL_LOGGER");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_ompt()
+{
+#if defined(TIMEMORY_USE_OMPT)
+    static auto _v = get_config()->find("OMNITRACE_USE_OMPT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+bool
+get_use_code_coverage()
+{
+    static auto _v = get_config()->find("OMNITRACE_USE_CODE_COVERAGE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_topdown()
+{
+    static auto _v = get_config()->find("OMNITRACE_TOPDOWN");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_use_rcclp()
+{
+    static auto _v = get_config()->find("OMNITRACE_USE_RCCLP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_num_threads_hint()
+{
+    static auto _v = get_config()->find("OMNITRACE_NUM_THREADS_HINT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_sampling_keep_internal()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_KEEP_INTERNAL");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_max_depth()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MAX_DEPTH");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+int
+get_sampling_overflow_signal()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OVERFLOW_SIGNAL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+int
+get_sampling_realtime_signal()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_REALTIME_SIGNAL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+int
+get_sampling_cputime_signal()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_SIGNAL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+bool
+get_trace_hip_api()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HIP_API");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_trace_hip_activity()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HIP_ACTIVITY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_trace_hsa_api()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HSA_API");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_trace_hsa_activity()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCTRACER_HSA_ACTIVITY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_shmem_size_hint()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_SHMEM_SIZE_HINT_KB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_buffer_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BUFFER_SIZE_KB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_perfetto_buffer_adaptive()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BUFFER_ADAPTIVE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_memory_budget()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_MEMORY_BUDGET_KB");
+    auto        _b = static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+    return (_b > 0) ? _b : get_perfetto_buffer_size();
+}
+
+double
+get_perfetto_buffer_adaptive_window()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BUFFER_ADAPTIVE_WINDOW");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_perfetto_buffer_high_watermark()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BUFFER_HIGH_WATERMARK");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_perfetto_combined_traces()
+{
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_COMBINE_TRACES");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+bool
+get_perfetto_clock_sync()
+{
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_CLOCK_SYNC");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
+}
+
+std::string
+get_perfetto_fill_policy()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_FILL_POLICY");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_perfetto_compression()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_COMPRESSION");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+int
+get_perfetto_compression_level()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_COMPRESSION_LEVEL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+bool
+get_perfetto_compress_packets()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_COMPRESS_PACKETS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+namespace
+{
+auto
+get_category_config()
+{
+    using strset_t = std::set<std::string>;
+
+    static auto _v = []() {
+        auto _avail = get_available_categories<strset_t>();
+        auto _parse = [&_avail](const auto& _setting) {
+            auto _ret = strset_t{};
+            for(auto itr : tim::delimit(
+                    static_cast<tim::tsettings<std::string>&>(*_setting->second).get(),
+                    " ,;:\n\t"))
+            {
+                if(_avail.count(itr) > 0) _ret.emplace(itr);
+            }
+            return _ret;
+        };
+
+        auto _enabled  = _parse(get_config()->find("OMNITRACE_ENABLE_CATEGORIES"));
+        auto _disabled = _parse(get_config()->find("OMNITRACE_DISABLE_CATEGORIES"));
+
+        if(_enabled.empty() && _disabled.empty())
+        {
+            _enabled = _avail;
+        }
+        else if(_enabled.empty() && !_disabled.empty())
+        {
+            for(auto itr : _avail)
+            {
+                if(_disabled.count(itr) == 0) _enabled.emplace(itr);
+            }
+        }
+        else if(!_enabled.empty() && _disabled.empty())
+        {
+            for(auto itr : _avail)
+            {
+                if(_enabled.count(itr) == 0) _disabled.emplace(itr);
+            }
+        }
+        else
+        {
+            OMNITRACE_ABORT("Error! Conflicting options OMNITRACE_ENABLE_CATEGORIES and "
+                            "OMNITRACE_DISABLE_CATEGORIES were both provided.");
+        }
+
+        OMNITRACE_CI_THROW(_enabled.size() + _disabled.size() != _avail.size(),
+                           "Error! Internal error for categories: %zu (enabled) + %zu "
+                           "(disabled) != %zu (total)\n",
+                           _enabled.size(), _disabled.size(), _avail.size());
+
+        return std::make_pair(_enabled, _disabled);
+    }();
+
+    return _v;
+}
+}  // namespace
+std::set<std::string>
+get_enabled_categories()
+{
+    return get_category_config().first;
+}
+
+std::set<std::string>
+get_disabled_categories()
+{
+    return get_category_config().second;
+}
+
+bool
+get_perfetto_annotations()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_ANNOTATIONS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_timemory_annotations()
+{
+    static auto _v = get_config()->find("OMNITRACE_TIMEMORY_ANNOTATIONS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+uint64_t
+get_thread_pool_size()
+{
+    static uint64_t _v = get_config()->get<uint64_t>("OMNITRACE_THREAD_POOL_SIZE");
+    return _v;
+}
+
+std::string
+get_thread_pool_affinity()
+{
+    static auto _v = get_config()->find("OMNITRACE_THREAD_POOL_AFFINITY");
+    auto        _r = static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    if(_r.empty())
+        _r = (get_setting_value<bool>("OMNITRACE_CPU_AFFINITY").value_or(false)) ? "auto"
+                                                                                 : "none";
+    return _r;
+}
+
+std::string
+get_trace_hsa_api_types()
+{
+    static std::string _v =
+        get_config()->get<std::string>("OMNITRACE_ROCTRACER_HSA_API_TYPES");
+    return _v;
+}
+
+std::string&
+get_perfetto_backend()
+{
+    // select inprocess, system, or both (i.e. all)
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BACKEND");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_perfetto_output_filename()
+{
+    static auto _v       = get_config()->find("OMNITRACE_PERFETTO_FILE");
+    auto        _val     = static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    auto        _pos_dir = _val.find_last_of('/');
+    auto        _dir     = std::string{};
+    auto        _ext     = std::string{ "proto" };
+    if(_pos_dir != std::string::npos)
+    {
+        _dir = _val.substr(0, _pos_dir + 1);
+        _val = _val.substr(_pos_dir + 1);
+    }
+    auto _pos_ext = _val.find_last_of('.');
+    if(_pos_ext + 1 < _val.length())
+    {
+        _ext = _val.substr(_pos_ext + 1);
+        _val = _val.substr(0, _pos_ext);
+    }
+
+    auto _cfg = settings::compose_filename_config{ settings::use_output_suffix(),
+                                                   settings::default_process_suffix(),
+                                                   false, _dir };
+    _val      = settings::compose_output_filename(_val, _ext, _cfg);
+    if(!_val.empty() && _val.at(0) != '/')
+        return settings::format(JOIN('/', "%env{PWD}%", _val), get_config()->get_tag());
+    return _val;
+}
+
+double
+get_sampling_freq()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_FREQ");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_sampling_cputime_freq()
+{
+    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_FREQ");
+    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
+    if(_val <= 0.0) _val = get_sampling_freq();
+    return _val;
+}
+
+double
+get_sampling_realtime_freq()
+{
+    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_REALTIME_FREQ");
+    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
+    if(_val <= 0.0) _val = get_sampling_freq();
+    return _val;
+}
+
+double
+get_sampling_overflow_freq()
+{
+    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_OVERFLOW_FREQ");
+    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
+    if(_val <= 0.0) _val = get_sampling_freq();
+    return _val;
+}
+
+double
+get_sampling_delay()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_DELAY");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_sampling_cputime_delay()
+{
+    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_DELAY");
+    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
+    if(_val <= 0.0) _val = get_sampling_delay();
+    return _val;
+}
+
+double
+get_sampling_realtime_delay()
+{
+    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_REALTIME_DELAY");
+    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
+    if(_val <= 0.0) _val = get_sampling_delay();
+    return _val;
+}
+
+double
+get_sampling_duration()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_DURATION");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_cpus()
+{
+    auto _v = get_config()->find("OMNITRACE_SAMPLING_CPUS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::set<int64_t>
+get_sampling_tids()
+{
+    auto _v = get_config()->find("OMNITRACE_SAMPLING_TIDS");
+    return parse_numeric_range<>(
+        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+}
+
+std::set<int64_t>
+get_sampling_cputime_tids()
+{
+    auto _v = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_TIDS");
+    return parse_numeric_range<>(
+        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+}
+
+std::set<int64_t>
+get_sampling_realtime_tids()
+{
+    auto _v = get_config()->find("OMNITRACE_SAMPLING_REALTIME_TIDS");
+    return parse_numeric_range<>(
+        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+}
+
+std::set<int64_t>
+get_sampling_overflow_tids()
+{
+    auto _v = get_config()->find("OMNITRACE_SAMPLING_OVERFLOW_TIDS");
+    return parse_numeric_range<>(
+        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+}
+
+bool
+get_sampling_include_inlines()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_INCLUDE_INLINES");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_merge_stacks()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MERGE_STACKS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_region_context()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_REGION_CONTEXT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_cpu_residency()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_CPU_RESIDENCY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_callchain_only()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_CALLCHAIN_ONLY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_rdpmc()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_RDPMC");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_rusage_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_RUSAGE_INTERVAL");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_cct_capacity()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_CCT_CAPACITY");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_unwinder()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_UNWINDER");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_backend()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_BACKEND");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_sampling_system_wide()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_SYSTEM_WIDE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_sampling_system_wide_freq()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_SYSTEM_WIDE_FREQ");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_sampling_off_cpu()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OFF_CPU");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_sampling_overhead_budget()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OVERHEAD_BUDGET");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+double
+get_sampling_min_freq()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_MIN_FREQ");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_allocator_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_ALLOCATOR_SIZE");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+}
+
+std::string
+get_sampling_offload_mode()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OFFLOAD_MODE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_idle()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_IDLE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_sampling_python()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PYTHON");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_sampling_parquet_output()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_PARQUET_OUTPUT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_folded_output()
+{
+    static auto _v = get_config()->find("OMNITRACE_FOLDED_OUTPUT");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_folded_output_weight()
+{
+    static auto _v = get_config()->find("OMNITRACE_FOLDED_OUTPUT_WEIGHT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+size_t
+get_sampling_offload_queue_depth()
+{
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_OFFLOAD_QUEUE_DEPTH");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+double
+get_process_sampling_freq()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_FREQ");
+    auto        _val =
+        std::min<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(), 1000.0);
+    if(_val < 1.0e-9) return std::min<double>(get_sampling_freq(), 100.0);
+    return _val;
+}
+
+double
+get_process_sampling_duration()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_DURATION");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_process_sampling_fixed_rate()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_FIXED_RATE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_process_sampling_per_node()
+{
+    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_PER_NODE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+std::string
+get_sampling_gpus()
+{
+#if defined(OMNITRACE_USE_ROCM_SMI) && OMNITRACE_USE_ROCM_SMI > 0
+    static auto _v = get_config()->find("OMNITRACE_SAMPLING_GPUS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+#else
+    return std::string{};
+#endif
+}
+
+bool
+get_rocm_smi_per_device_polling()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCM_SMI_PER_DEVICE_POLLING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_rocm_smi_buffer_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCM_SMI_BUFFER_SIZE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_rocm_smi_max_output_samples()
+{
+    static auto _v = get_config()->find("OMNITRACE_ROCM_SMI_MAX_OUTPUT_SAMPLES");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
-std::string&
-get_perfetto_backend()
+bool
+get_rocm_smi_energy()
 {
-    // select inprocess, system, or both (i.e. all)
-    static auto _v = get_config()->find("OMNITRACE_PERFETTO_BACKEND");
-    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_ROCM_SMI_ENERGY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-std::string
-get_perfetto_output_filename()
+size_t
+get_throttle_calls()
 {
-    static auto _v       = get_config()->find("OMNITRACE_PERFETTO_FILE");
-    auto        _val     = static_cast<tim::tsettings<std::string>&>(*_v->second).get();
-    auto        _pos_dir = _val.find_last_of('/');
-    auto        _dir     = std::string{};
-    auto        _ext     = std::string{ "proto" };
-    if(_pos_dir != std::string::npos)
-    {
-        _dir = _val.substr(0, _pos_dir + 1);
-        _val = _val.substr(_pos_dir + 1);
-    }
-    auto _pos_ext = _val.find_last_of('.');
-    if(_pos_ext + 1 < _val.length())
-    {
-        _ext = _val.substr(_pos_ext + 1);
-        _val = _val.substr(0, _pos_ext);
-    }
-
-    auto _cfg = settings::compose_filename_config{ settings::use_output_suffix(),
-                                                   settings::default_process_suffix(),
-                                                   false, _dir };
-    _val      = settings::compose_output_filename(_val, _ext, _cfg);
-    if(!_val.empty() && _val.at(0) != '/')
-        return settings::format(JOIN('/', "%env{PWD}%", _val), get_config()->get_tag());
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_CALLS");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 double
-get_sampling_freq()
+get_throttle_interval()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_FREQ");
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_INTERVAL");
     return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
-double
-get_sampling_cputime_freq()
+std::string
+get_throttle_mode()
 {
-    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_FREQ");
-    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
-    if(_val <= 0.0) _val = get_sampling_freq();
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_MODE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
-double
-get_sampling_realtime_freq()
+bool
+get_control_file()
 {
-    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_REALTIME_FREQ");
-    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
-    if(_val <= 0.0) _val = get_sampling_freq();
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_CONTROL_FILE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-double
-get_sampling_overflow_freq()
+std::string
+get_region_sample_rates()
 {
-    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_OVERFLOW_FREQ");
-    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
-    if(_val <= 0.0) _val = get_sampling_freq();
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_REGION_SAMPLE_RATES");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
 double
-get_sampling_delay()
+get_region_sample_target()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_DELAY");
+    static auto _v = get_config()->find("OMNITRACE_REGION_SAMPLE_TARGET");
     return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
-double
-get_sampling_cputime_delay()
+std::string
+get_triggers()
 {
-    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_DELAY");
-    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
-    if(_val <= 0.0) _val = get_sampling_delay();
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_TRIGGERS");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
-double
-get_sampling_realtime_delay()
+bool
+get_critical_path()
 {
-    static auto _v   = get_config()->find("OMNITRACE_SAMPLING_REALTIME_DELAY");
-    auto&       _val = static_cast<tim::tsettings<double>&>(*_v->second).get();
-    if(_val <= 0.0) _val = get_sampling_delay();
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_CRITICAL_PATH");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-double
-get_sampling_duration()
+bool
+get_trace_thread_locks()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_DURATION");
-    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
 std::string
-get_sampling_cpus()
+get_rocm_events()
 {
-    auto _v = get_config()->find("OMNITRACE_SAMPLING_CPUS");
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS");
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
-std::set<int64_t>
-get_sampling_tids()
+std::string
+get_rocm_events_kernel_include()
 {
-    auto _v = get_config()->find("OMNITRACE_SAMPLING_TIDS");
-    return parse_numeric_range<>(
-        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_KERNEL_INCLUDE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
-std::set<int64_t>
-get_sampling_cputime_tids()
+std::string
+get_rocm_events_kernel_exclude()
 {
-    auto _v = get_config()->find("OMNITRACE_SAMPLING_CPUTIME_TIDS");
-    return parse_numeric_range<>(
-        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_KERNEL_EXCLUDE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
-std::set<int64_t>
-get_sampling_realtime_tids()
+size_t
+get_rocm_events_dispatch_interval()
 {
-    auto _v = get_config()->find("OMNITRACE_SAMPLING_REALTIME_TIDS");
-    return parse_numeric_range<>(
-        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_DISPATCH_INTERVAL");
+    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
 }
 
-std::set<int64_t>
-get_sampling_overflow_tids()
+size_t
+get_rocm_events_dispatch_limit()
 {
-    auto _v = get_config()->find("OMNITRACE_SAMPLING_OVERFLOW_TIDS");
-    return parse_numeric_range<>(
-        static_cast<tim::tsettings<std::string>&>(*_v->second).get(), "thread IDs", 1L);
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_DISPATCH_LIMIT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 bool
-get_sampling_include_inlines()
+get_rocm_events_roofline()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_INCLUDE_INLINES");
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_ROOFLINE");
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
-size_t
-get_sampling_allocator_size()
+double
+get_rocm_events_peak_gflops()
 {
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_ALLOCATOR_SIZE");
-    return std::max<size_t>(static_cast<tim::tsettings<size_t>&>(*_v->second).get(), 1);
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_PEAK_GFLOPS");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
 double
-get_process_sampling_freq()
+get_rocm_events_peak_gbps()
 {
-    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_FREQ");
-    auto        _val =
-        std::min<double>(static_cast<tim::tsettings<double>&>(*_v->second).get(), 1000.0);
-    if(_val < 1.0e-9) return std::min<double>(get_sampling_freq(), 100.0);
-    return _val;
+    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS_PEAK_GBPS");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
 }
 
-double
-get_process_sampling_duration()
+bool
+get_pc_sampling()
 {
-    static auto _v = get_config()->find("OMNITRACE_PROCESS_SAMPLING_DURATION");
-    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+#if defined(OMNITRACE_USE_ROCPROFILER_SDK) && OMNITRACE_USE_ROCPROFILER_SDK > 0
+    static auto _v = get_config()->find("OMNITRACE_PC_SAMPLING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+#else
+    return false;
+#endif
 }
 
 std::string
-get_sampling_gpus()
+get_pc_sampling_method()
 {
-#if defined(OMNITRACE_USE_ROCM_SMI) && OMNITRACE_USE_ROCM_SMI > 0
-    static auto _v = get_config()->find("OMNITRACE_SAMPLING_GPUS");
+    static auto _v = get_config()->find("OMNITRACE_PC_SAMPLING_METHOD");
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
-#else
-    return std::string{};
-#endif
 }
 
-bool
-get_trace_thread_locks()
+size_t
+get_pc_sampling_interval()
 {
-    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS");
-    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_PC_SAMPLING_INTERVAL");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
-std::string
-get_rocm_events()
+size_t
+get_pc_sampling_top()
 {
-    static auto _v = get_config()->find("OMNITRACE_ROCM_EVENTS");
-    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+    static auto _v = get_config()->find("OMNITRACE_PC_SAMPLING_TOP");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
 bool
@@ -2396,6 +4422,34 @@ get_trace_thread_join()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_trace_thread_locks_contention_only()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS_CONTENTION_ONLY");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_trace_thread_locks_profile()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS_PROFILE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_trace_thread_locks_top()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCKS_TOP");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_thread_lazy_setup()
+{
+    static auto _v = get_config()->find("OMNITRACE_THREAD_LAZY_SETUP");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_debug_tid()
 {
@@ -2430,6 +4484,48 @@ get_tmpdir()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+std::string
+get_binary_cache_dir()
+{
+    static auto _v = get_config()->find("OMNITRACE_BINARY_CACHE_DIR");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_binary_cache_node_shared()
+{
+    static auto _v = get_config()->find("OMNITRACE_BINARY_CACHE_NODE_SHARED");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_hip_device_metadata_cache()
+{
+    static auto _v = get_config()->find("OMNITRACE_HIP_DEVICE_METADATA_CACHE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_binary_lazy_dwarf()
+{
+    static auto _v = get_config()->find("OMNITRACE_BINARY_LAZY_DWARF");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_binary_incremental()
+{
+    static auto _v = get_config()->find("OMNITRACE_BINARY_INCREMENTAL");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_jit_symbols()
+{
+    static auto _v = get_config()->find("OMNITRACE_JIT_SYMBOLS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 tmp_file::tmp_file(std::string _v)
 : filename{ std::move(_v) }
 {}
@@ -2652,6 +4748,56 @@ get_causal_end_to_end()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+std::string
+get_causal_coordinate_file()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_COORDINATE");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
+bool
+get_causal_adaptive()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_ADAPTIVE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_causal_adaptive_tolerance()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+bool
+get_causal_log()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_LOG");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_causal_gpu()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_GPU");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+double
+get_causal_blocking_threshold()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_BLOCKING_THRESHOLD");
+    return static_cast<tim::tsettings<double>&>(*_v->second).get();
+}
+
+std::vector<std::string>
+get_causal_progress_counters()
+{
+    static auto _v = get_config()->find("OMNITRACE_CAUSAL_PROGRESS_COUNTERS");
+    return tim::delimit(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
+                        " ,;\t");
+}
+
 std::vector<int64_t>
 get_causal_fixed_speedup()
 {
@@ -2756,5 +4902,44 @@ get_causal_function_exclude()
     return tim::delimit(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
                         "\t\"';");
 }
+
+snapshot_data snapshot_v = {};
+
+void
+refresh_snapshot()
+{
+    // the snapshot only holds a pointer so the string must outlive every refresh
+    static auto _overflow_event = std::string{};
+
+    // queried by name instead of via the getters since this is invoked by
+    // configure_settings, i.e. get_config() may still be initializing
+    auto _get = [](const char* _name) {
+        return get_setting_value<bool>(_name).value_or(false);
+    };
+
+    _overflow_event =
+        get_setting_value<std::string>("OMNITRACE_SAMPLING_OVERFLOW_EVENT").value_or("");
+
+    auto _rusage_interval =
+        get_setting_value<size_t>("OMNITRACE_SAMPLING_RUSAGE_INTERVAL").value_or(1);
+
+    auto _v                          = snapshot_data{};
+    _v.use_perfetto                  = _get("OMNITRACE_TRACE");
+    _v.use_timemory                  = _get("OMNITRACE_PROFILE");
+    _v.use_causal                    = _get("OMNITRACE_USE_CAUSAL");
+    _v.use_sampling                  = _get("OMNITRACE_USE_SAMPLING");
+    _v.perfetto_annotations          = _get("OMNITRACE_PERFETTO_ANNOTATIONS");
+    _v.timemory_annotations          = _get("OMNITRACE_TIMEMORY_ANNOTATIONS");
+    _v.sampling_include_inlines      = _get("OMNITRACE_SAMPLING_INCLUDE_INLINES");
+    _v.sampling_callchain_only       = _get("OMNITRACE_SAMPLING_CALLCHAIN_ONLY");
+    _v.sampling_rusage_interval      = _rusage_interval;
+    _v.sampling_overflow_event       = _overflow_event.c_str();
+#if defined(OMNITRACE_USE_ROCTRACER) && OMNITRACE_USE_ROCTRACER > 0
+    _v.use_roctracer                 = _get("OMNITRACE_USE_ROCTRACER");
+    _v.perfetto_roctracer_per_stream = _get("OMNITRACE_PERFETTO_ROCTRACER_PER_STREAM");
+    _v.roctracer_timeline_analysis   = _get("OMNITRACE_ROCTRACER_TIMELINE_ANALYSIS");
+#endif
+    snapshot_v                       = _v;
+}
 }  // namespace config
 }  // namespace omnitrace
@@ -33,6 +33,7 @@
 #include <fstream>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_set>
 
 namespace omnitrace
@@ -54,9 +55,18 @@ settings_are_configured() OMNITRACE_HOT;
 void
 configure_settings(bool _init = true);
 
+// populates the choices of the settings which require querying the system (e.g. the
+// available PAPI events). Only needed when the settings are presented to the user
+void
+configure_setting_choices();
+
 void
 configure_mode_settings(const std::shared_ptr<settings>&);
 
+// only the ranks selected by OMNITRACE_TRACE_RANKS keep tracing and sampling
+void
+configure_trace_ranks(const std::shared_ptr<settings>&);
+
 void
 configure_signal_handler(const std::shared_ptr<settings>&);
 
@@ -215,6 +225,9 @@ get_use_process_sampling() OMNITRACE_HOT;
 bool&
 get_use_pid();
 
+std::string
+get_fork_mode();
+
 bool&
 get_use_mpip();
 
@@ -230,9 +243,15 @@ get_use_ompt();
 bool
 get_use_code_coverage();
 
+bool
+get_use_topdown();
+
 bool
 get_sampling_keep_internal();
 
+size_t
+get_sampling_max_depth();
+
 bool
 get_use_rcclp();
 
@@ -254,12 +273,38 @@ get_perfetto_shmem_size_hint();
 size_t
 get_perfetto_buffer_size();
 
+bool
+get_perfetto_buffer_adaptive();
+
+// in KB, defaults to get_perfetto_buffer_size()
+size_t
+get_perfetto_memory_budget();
+
+double
+get_perfetto_buffer_adaptive_window();
+
+double
+get_perfetto_buffer_high_watermark();
+
 bool
 get_perfetto_combined_traces();
 
+bool
+get_perfetto_clock_sync();
+
 std::string
 get_perfetto_fill_policy();
 
+// "none", "gzip", or "zstd"
+std::string
+get_perfetto_compression();
+
+int
+get_perfetto_compression_level();
+
+bool
+get_perfetto_compress_packets();
+
 std::set<std::string>
 get_enabled_categories();
 
@@ -269,9 +314,16 @@ get_disabled_categories();
 bool
 get_perfetto_annotations() OMNITRACE_HOT;
 
+bool
+get_timemory_annotations();
+
 uint64_t
 get_thread_pool_size();
 
+// 'none', 'auto', or a list/range of CPUs
+std::string
+get_thread_pool_affinity();
+
 std::string
 get_trace_hsa_api_types();
 
@@ -285,6 +337,162 @@ get_perfetto_output_filename();
 bool
 get_perfetto_roctracer_per_stream() OMNITRACE_HOT;
 
+bool
+get_roctracer_hip_api_aggregate();
+
+double
+get_roctracer_hip_api_aggregate_window();
+
+double
+get_roctracer_hip_api_aggregate_threshold();
+
+bool
+get_roctracer_memory_tracking();
+
+size_t
+get_roctracer_memory_top();
+
+bool
+get_roctracer_timeline_analysis();
+
+bool
+get_roctracer_graph_tracing();
+
+bool
+get_roctracer_kernel_occupancy();
+
+bool
+get_perfetto_comm_data_per_peer() OMNITRACE_HOT;
+
+bool
+get_mpi_matching() OMNITRACE_HOT;
+
+bool
+get_mpi_collective_wait();
+
+bool
+get_collapse_nodes();
+
+bool
+get_defer_post_processing();
+
+double
+get_flush_interval();
+
+bool
+get_preemption_flush();
+
+int
+get_preemption_signal();
+
+double
+get_preemption_deadline();
+
+std::string
+get_export_endpoint();
+
+double
+get_export_interval();
+
+size_t
+get_export_buffer_size_kb();
+
+bool
+get_perfetto_snapshot();
+
+int
+get_perfetto_snapshot_signal();
+
+double
+get_perfetto_snapshot_threshold();
+
+size_t
+get_perfetto_snapshot_limit();
+
+std::string
+get_perfetto_iteration_region();
+
+bool
+get_stream_output();
+
+std::string
+get_stream_output_format();
+
+std::string
+get_finalize_timings_file();
+
+bool
+get_self_overhead();
+
+bool
+get_self_overhead_correction();
+
+double
+get_perfetto_iteration_threshold();
+
+double
+get_perfetto_iteration_percentile();
+
+size_t
+get_perfetto_batch_size();
+
+bool
+get_trace_event_log();
+
+bool
+get_numa_locality();
+
+std::string
+get_numa_locality_event();
+
+size_t
+get_numa_locality_top();
+
+bool
+get_sampling_memory();
+
+std::string
+get_sampling_memory_event();
+
+size_t
+get_sampling_memory_min_alloc();
+
+size_t
+get_sampling_memory_top();
+
+bool
+get_heap_profile();
+
+size_t
+get_heap_profile_rate();
+
+size_t
+get_heap_profile_top();
+
+bool
+get_process_sampling_network();
+
+bool
+get_process_sampling_cpu_energy();
+
+bool
+get_process_sampling_cgroup();
+
+bool
+get_process_sampling_memory_bandwidth();
+
+bool
+get_io_trace();
+
+size_t
+get_io_callsite_interval();
+
+size_t
+get_io_trace_top();
+
+bool
+get_trace_python_gil();
+
 double
 get_trace_delay();
 
@@ -330,21 +538,126 @@ get_sampling_overflow_tids();
 bool
 get_sampling_include_inlines();
 
+bool
+get_sampling_merge_stacks();
+
+bool
+get_sampling_region_context();
+
+bool
+get_sampling_cpu_residency();
+
+bool
+get_sampling_callchain_only();
+
+bool
+get_sampling_rdpmc();
+
+size_t
+get_sampling_rusage_interval();
+
+size_t
+get_sampling_cct_capacity();
+
+std::string
+get_sampling_unwinder();
+
+std::string
+get_sampling_backend();
+
+bool
+get_sampling_system_wide();
+
+double
+get_sampling_system_wide_freq();
+
+bool
+get_sampling_off_cpu();
+
+double
+get_sampling_overhead_budget();
+
+double
+get_sampling_min_freq();
+
 size_t
 get_num_threads_hint();
 
 size_t
 get_sampling_allocator_size();
 
+std::string
+get_sampling_offload_mode();
+
+std::string
+get_sampling_idle();
+
+bool
+get_sampling_python();
+
+bool
+get_sampling_parquet_output();
+
+bool
+get_folded_output();
+
+std::string
+get_folded_output_weight();
+
+size_t
+get_sampling_offload_queue_depth();
+
 double
 get_process_sampling_freq();
 
 double
 get_process_sampling_duration();
 
+bool
+get_process_sampling_fixed_rate();
+
+bool
+get_process_sampling_per_node();
+
 std::string
 get_sampling_gpus();
 
+bool
+get_rocm_smi_per_device_polling();
+
+size_t
+get_rocm_smi_buffer_size();
+
+size_t
+get_rocm_smi_max_output_samples();
+
+bool
+get_rocm_smi_energy();
+
+size_t
+get_throttle_calls();
+
+double
+get_throttle_interval();
+
+std::string
+get_throttle_mode();
+
+bool
+get_control_file();
+
+std::string
+get_region_sample_rates();
+
+double
+get_region_sample_target();
+
+std::string
+get_triggers();
+
+bool
+get_critical_path();
+
 bool
 get_trace_thread_locks();
 
@@ -360,15 +673,78 @@ get_trace_thread_barriers();
 bool
 get_trace_thread_join();
 
+bool
+get_trace_thread_locks_contention_only();
+
+bool
+get_trace_thread_locks_profile();
+
+size_t
+get_trace_thread_locks_top();
+
+bool
+get_thread_lazy_setup();
+
 std::string
 get_rocm_events();
 
+std::string
+get_rocm_events_kernel_include();
+
+std::string
+get_rocm_events_kernel_exclude();
+
+size_t
+get_rocm_events_dispatch_interval();
+
+size_t
+get_rocm_events_dispatch_limit();
+
+bool
+get_rocm_events_roofline();
+
+double
+get_rocm_events_peak_gflops();
+
+double
+get_rocm_events_peak_gbps();
+
+bool
+get_pc_sampling();
+
+std::string
+get_pc_sampling_method();
+
+size_t
+get_pc_sampling_interval();
+
+size_t
+get_pc_sampling_top();
+
 bool
 get_use_tmp_files();
 
 std::string
 get_tmpdir();
 
+std::string
+get_binary_cache_dir();
+
+bool
+get_binary_cache_node_shared();
+
+bool
+get_hip_device_metadata_cache();
+
+bool
+get_binary_lazy_dwarf();
+
+bool
+get_binary_incremental();
+
+bool
+get_jit_symbols();
+
 struct tmp_file
 {
     tmp_file(std::string);
@@ -400,6 +776,27 @@ get_causal_mode();
 bool
 get_causal_end_to_end();
 
+std::string
+get_causal_coordinate_file();
+
+bool
+get_causal_adaptive();
+
+double
+get_causal_adaptive_tolerance();
+
+bool
+get_causal_log();
+
+bool
+get_causal_gpu();
+
+double
+get_causal_blocking_threshold();
+
+std::vector<std::string>
+get_causal_progress_counters();
+
 std::vector<int64_t>
 get_causal_fixed_speedup();
 
@@ -423,5 +820,40 @@ get_causal_source_exclude();
 
 std::vector<std::string>
 get_causal_function_exclude();
+
+// frozen copy of the settings which are queried in the hot paths (tracing, sampling,
+// roctracer callbacks). It is populated at the end of configure_settings and must be
+// refreshed via refresh_snapshot() after any of these settings are changed at runtime.
+// Reading a field is a plain load instead of a lookup in the settings
+struct alignas(64) snapshot_data
+{
+    bool        use_perfetto                  = false;
+    bool        use_timemory                  = false;
+    bool        use_causal                    = false;
+    bool        use_sampling                  = false;
+    bool        use_roctracer                 = false;
+    bool        perfetto_annotations          = false;
+    bool        timemory_annotations          = false;
+    bool        perfetto_roctracer_per_stream = false;
+    bool        roctracer_timeline_analysis   = false;
+    bool        sampling_include_inlines      = false;
+    bool        sampling_callchain_only       = false;
+    size_t      sampling_rusage_interval      = 1;
+    const char* sampling_overflow_event       = "";  // never null
+};
+
+static_assert(std::is_trivially_copyable<snapshot_data>::value,
+              "config::snapshot_data must remain a POD");
+
+extern OMNITRACE_HIDDEN_API snapshot_data snapshot_v;
+
+void
+refresh_snapshot();
+
+inline const snapshot_data&
+get_snapshot()
+{
+    return snapshot_v;
+}
 }  // namespace config
 }  // namespace omnitrace
@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace container
+{
+// compact open-addressing table (linear probing with backward-shift deletion) keyed by
+// address. The table starts with InitSizeV slots (a power of 2) and doubles when it is
+// half full. The address zero marks an empty slot so it cannot be inserted
+template <typename Tp, size_t InitSizeV = 1024>
+class address_table
+{
+    static_assert(InitSizeV >= 2 && (InitSizeV & (InitSizeV - 1)) == 0,
+                  "InitSize needs to be a power of 2");
+
+    static constexpr uint32_t log2(size_t _v)
+    {
+        return (_v <= 1) ? 0 : 1 + log2(_v >> 1);
+    }
+
+public:
+    using value_type = Tp;
+
+    size_t size() const { return m_size; }
+    bool   empty() const { return m_size == 0; }
+
+    // returns the previous value at the address when the address was not erased
+    std::optional<value_type> insert(uintptr_t _addr, const value_type& _v)
+    {
+        if(2 * (m_size + 1) > m_data.size()) grow();
+
+        auto  _idx = find(_addr);
+        auto  _ret = std::optional<value_type>{};
+        auto& _val = m_data.at(_idx);
+        if(_val.first == _addr)
+            _ret = _val.second;
+        else
+            ++m_size;
+        _val = { _addr, _v };
+        return _ret;
+    }
+
+    std::optional<value_type> erase(uintptr_t _addr)
+    {
+        auto _idx = find(_addr);
+        if(m_data.at(_idx).first != _addr) return std::nullopt;
+
+        auto _ret  = std::optional<value_type>{ m_data.at(_idx).second };
+        auto _mask = m_data.size() - 1;
+        // shift the following entries of the cluster back so lookups never need a
+        // tombstone
+        for(size_t j = _idx;;)
+        {
+            j = (j + 1) & _mask;
+            if(m_data.at(j).first == 0) break;
+            auto _home = home(m_data.at(j).first);
+            bool _keep = (_idx <= j) ? (_idx < _home && _home <= j)
+                                     : (_idx < _home || _home <= j);
+            if(_keep) continue;
+            m_data.at(_idx) = m_data.at(j);
+            _idx            = j;
+        }
+        m_data.at(_idx) = entry_type{};
+        --m_size;
+        return _ret;
+    }
+
+    template <typename FuncT>
+    void for_each(FuncT&& _func) const
+    {
+        for(const auto& itr : m_data)
+            if(itr.first != 0) std::forward<FuncT>(_func)(itr.first, itr.second);
+    }
+
+private:
+    using entry_type = std::pair<uintptr_t, value_type>;
+
+    size_t home(uintptr_t _addr) const
+    {
+        // fibonacci hashing of the address without the alignment bits
+        constexpr uint64_t _golden = 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(((_addr >> 4) * _golden) >> m_shift);
+    }
+
+    // slot holding the address or the empty slot where it would be inserted
+    size_t find(uintptr_t _addr) const
+    {
+        auto _mask = m_data.size() - 1;
+        auto _idx  = home(_addr);
+        while(m_data.at(_idx).first != 0 && m_data.at(_idx).first != _addr)
+            _idx = (_idx + 1) & _mask;
+        return _idx;
+    }
+
+    void grow()
+    {
+        auto _data = std::vector<entry_type>(2 * m_data.size());
+        std::swap(_data, m_data);
+        --m_shift;
+        m_size = 0;
+        for(const auto& itr : _data)
+            if(itr.first != 0) insert(itr.first, itr.second);
+    }
+
+    size_t                  m_size  = 0;
+    uint32_t                m_shift = 64 - log2(InitSizeV);
+    std::vector<entry_type> m_data  = std::vector<entry_type>(InitSizeV);
+};
+}  // namespace container
+}  // namespace omnitrace
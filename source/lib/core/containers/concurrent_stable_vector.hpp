@@ -0,0 +1,309 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/containers/aligned_static_vector.hpp"
+#include "core/defines.hpp"
+#include "core/exception.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace omnitrace
+{
+namespace container
+{
+// append-only vector with stable addresses which many threads can append to
+// concurrently. The segments have the layout of stable_vector: the first segment holds
+// ChunkSizeV elements and each subsequent segment doubles the capacity. An append
+// reserves its index with an atomic increment, allocates the segment of the index if
+// no other thread has published it yet, assigns the element and marks the slot as
+// ready. The size is advanced over the consecutive ready slots by whichever thread
+// finds them so the readers only see assigned elements and reading is wait-free.
+// Elements are never removed
+template <typename Tp, size_t ChunkSizeV = OMNITRACE_MAX_THREADS,
+          size_t AlignN = alignof(Tp)>
+class concurrent_stable_vector
+{
+public:
+    using value_type      = Tp;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+    using size_type       = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr const size_t chunk_size = ChunkSizeV;
+
+private:
+    static_assert(ChunkSizeV > 0 && (ChunkSizeV & (ChunkSizeV - 1)) == 0,
+                  "ChunkSize needs to be a power of 2");
+
+    static constexpr size_t log2(size_t _v) { return (_v <= 1) ? 0 : 1 + log2(_v >> 1); }
+
+    // segment N holds (ChunkSizeV << N) elements
+    static constexpr size_t max_segments =
+        std::numeric_limits<size_type>::digits - log2(ChunkSizeV) - 1;
+
+    using this_type = concurrent_stable_vector<Tp, ChunkSizeV, AlignN>;
+
+    template <typename ContainerT, typename ValueT>
+    struct iterator_impl
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = Tp;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = ValueT*;
+        using reference         = ValueT&;
+
+        iterator_impl(ContainerT* c = nullptr, size_type i = 0)
+        : m_container{ c }
+        , m_index{ i }
+        {}
+
+        reference      operator*() const { return (*m_container)[m_index]; }
+        pointer        operator->() const { return &(*m_container)[m_index]; }
+        iterator_impl& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        iterator_impl operator++(int)
+        {
+            auto _v = *this;
+            ++m_index;
+            return _v;
+        }
+
+        bool operator==(const iterator_impl& it) const
+        {
+            return m_container == it.m_container && m_index == it.m_index;
+        }
+        bool operator!=(const iterator_impl& it) const { return !(*this == it); }
+
+    private:
+        ContainerT* m_container = nullptr;
+        size_type   m_index     = 0;
+    };
+
+public:
+    using iterator       = iterator_impl<this_type, value_type>;
+    using const_iterator = iterator_impl<const this_type, const value_type>;
+
+    concurrent_stable_vector() = default;
+    ~concurrent_stable_vector();
+
+    concurrent_stable_vector(const concurrent_stable_vector&) = delete;
+    concurrent_stable_vector(concurrent_stable_vector&&)      = delete;
+    concurrent_stable_vector& operator=(const concurrent_stable_vector&) = delete;
+    concurrent_stable_vector& operator=(concurrent_stable_vector&&) = delete;
+
+    // the iteration ends at the size when end() is invoked
+    iterator       begin() noexcept { return { this, 0 }; }
+    const_iterator begin() const noexcept { return { this, 0 }; }
+    const_iterator cbegin() const noexcept { return begin(); }
+
+    iterator       end() noexcept { return { this, size() }; }
+    const_iterator end() const noexcept { return { this, size() }; }
+    const_iterator cend() const noexcept { return end(); }
+
+    // number of elements which are visible to the readers. The appends which are
+    // in progress are not included
+    size_type size() const noexcept { return m_size.load(std::memory_order_acquire); }
+    bool      empty() const noexcept { return size() == 0; }
+
+    // allocates the segments ahead of the appends
+    void reserve(size_type new_capacity);
+
+    // returns the index of the element
+    template <typename... Args>
+    size_type emplace_back(Args&&... args);
+
+    size_type push_back(const Tp& t) { return emplace_back(t); }
+    size_type push_back(Tp&& t) { return emplace_back(std::move(t)); }
+
+    reference       operator[](size_type i);
+    const_reference operator[](size_type i) const;
+
+    reference       at(size_type i);
+    const_reference at(size_type i) const;
+
+private:
+    struct slot_type
+    {
+        alignas(AlignN) Tp value = {};
+        std::atomic<bool> ready  = { false };
+    };
+
+    using segment_type = slot_type*;
+    using storage_type = std::array<std::atomic<segment_type>, max_segments>;
+
+    // index of the first element in segment N
+    static constexpr size_type segment_begin(size_type n)
+    {
+        return ChunkSizeV * ((size_type{ 1 } << n) - 1);
+    }
+
+    static constexpr size_type segment_capacity(size_type n) { return ChunkSizeV << n; }
+
+    static size_type segment_index(size_type i)
+    {
+        auto _v = (i / ChunkSizeV) + 1;
+        return (std::numeric_limits<unsigned long long>::digits - 1) -
+               __builtin_clzll(_v);
+    }
+
+    segment_type get_segment(size_type n);
+    slot_type&   get_slot(size_type i);
+    void         publish();
+
+    storage_type        m_segments = {};
+    std::atomic<size_t> m_reserved = { 0 };
+    std::atomic<size_t> m_size     = { 0 };
+};
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::~concurrent_stable_vector()
+{
+    for(auto& itr : m_segments)
+    {
+        delete[] itr.exchange(nullptr);
+    }
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::segment_type
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::get_segment(size_type n)
+{
+    auto* _data = m_segments[n].load(std::memory_order_acquire);
+    if(OMNITRACE_LIKELY(_data != nullptr)) return _data;
+
+    // the threads which lose the race to publish the segment free their allocation
+    auto* _new = new slot_type[segment_capacity(n)];
+    if(m_segments[n].compare_exchange_strong(_data, _new, std::memory_order_acq_rel,
+                                             std::memory_order_acquire))
+        return _new;
+
+    delete[] _new;
+    return _data;
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::slot_type&
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::get_slot(size_type i)
+{
+    auto _seg = segment_index(i);
+    if(OMNITRACE_UNLIKELY(_seg >= max_segments))
+    {
+        throw ::omnitrace::exception<std::length_error>(
+            "concurrent_stable_vector exceeded the maximum number of segments");
+    }
+
+    return get_segment(_seg)[i - segment_begin(_seg)];
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::publish()
+{
+    // the ready flags are sequentially consistent: a thread which marks its slot ready
+    // and then finds the previous slot not ready is guaranteed that the thread of the
+    // previous slot will find its slot ready
+    auto _n = m_size.load(std::memory_order_acquire);
+    while(_n < m_reserved.load(std::memory_order_acquire))
+    {
+        auto  _seg  = segment_index(_n);
+        auto* _data = m_segments[_seg].load(std::memory_order_acquire);
+        if(!_data || !_data[_n - segment_begin(_seg)].ready.load()) break;
+
+        // on failure, _n is updated to the size published by another thread
+        if(m_size.compare_exchange_weak(_n, _n + 1, std::memory_order_acq_rel,
+                                        std::memory_order_acquire))
+            ++_n;
+    }
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::reserve(size_type new_capacity)
+{
+    for(size_type n = 0; n < max_segments && segment_begin(n) < new_capacity; ++n)
+        get_segment(n);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+template <typename... Args>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::size_type
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::emplace_back(Args&&... args)
+{
+    auto  _idx  = m_reserved.fetch_add(1, std::memory_order_acq_rel);
+    auto& _slot = get_slot(_idx);
+    _slot.value = Tp{ std::forward<Args>(args)... };
+    _slot.ready.store(true);
+    publish();
+    return _idx;
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::reference
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::operator[](size_type i)
+{
+    auto  _seg  = segment_index(i);
+    auto* _data = m_segments[_seg].load(std::memory_order_acquire);
+    return _data[i - segment_begin(_seg)].value;
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::const_reference
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::operator[](size_type i) const
+{
+    return const_cast<this_type&>(*this)[i];
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::reference
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::at(size_type i)
+{
+    if(OMNITRACE_UNLIKELY(i >= size()))
+    {
+        throw ::omnitrace::exception<std::out_of_range>(
+            "concurrent_stable_vector::at(" + std::to_string(i) + "). size is " +
+            std::to_string(size()));
+    }
+
+    return operator[](i);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+typename concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::const_reference
+concurrent_stable_vector<Tp, ChunkSizeV, AlignN>::at(size_type i) const
+{
+    return const_cast<this_type&>(*this).at(i);
+}
+}  // namespace container
+}  // namespace omnitrace
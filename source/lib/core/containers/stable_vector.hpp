@@ -27,9 +27,14 @@
 #include "core/defines.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <initializer_list>
 #include <iterator>
+#include <limits>
 #include <memory>
+#include <new>
 #include <numeric>
 #include <type_traits>
 #include <vector>
@@ -38,6 +43,12 @@ namespace omnitrace
 {
 namespace container
 {
+// vector with stable addresses which grows in segments. The first segment holds
+// ChunkSizeV elements and each subsequent segment doubles the capacity. The segment
+// directory is a fixed-size array of atomic pointers which is never reallocated so
+// the elements can be accessed in O(1) without locking while another thread grows the
+// container. Growth (push_back, emplace_back, reserve) must be externally serialized,
+// see concurrent_stable_vector for the append-only variant with concurrent growth.
 template <typename Tp, size_t ChunkSizeV = OMNITRACE_MAX_THREADS,
           size_t AlignN = alignof(Tp)>
 class stable_vector
@@ -63,6 +74,12 @@ private:
     static_assert(ChunkSizeV > 0, "ChunkSize needs to be greater than zero");
     static_assert(is_pow2<ChunkSizeV>::value, "ChunkSize needs to be a power of 2");
 
+    static constexpr size_t log2(size_t _v) { return (_v <= 1) ? 0 : 1 + log2(_v >> 1); }
+
+    // segment N holds (ChunkSizeV << N) elements
+    static constexpr size_t max_segments =
+        std::numeric_limits<size_type>::digits - log2(ChunkSizeV) - 1;
+
     using this_type       = stable_vector<Tp, ChunkSizeV, AlignN>;
     using const_this_type = const stable_vector<Tp, ChunkSizeV, AlignN>;
 
@@ -167,6 +184,8 @@ public:
     stable_vector(const stable_vector& other);
     stable_vector(stable_vector&& other) noexcept;
 
+    ~stable_vector();
+
     stable_vector& operator=(stable_vector v);
 
     iterator       begin() noexcept { return { this, 0 }; }
@@ -177,14 +196,14 @@ public:
     const_iterator end() const noexcept { return { this, size() }; }
     const_iterator cend() const noexcept { return end(); }
 
-    size_type size() const noexcept
+    size_type size() const noexcept { return m_size.load(std::memory_order_acquire); }
+    size_type max_size() const noexcept { return std::numeric_limits<size_type>::max(); }
+    size_type capacity() const noexcept
     {
-        return empty() ? 0 : (m_chunks.size() - 1) * ChunkSizeV + m_chunks.back()->size();
+        return segment_begin(m_num_segments.load(std::memory_order_acquire));
     }
-    size_type max_size() const noexcept { return std::numeric_limits<size_type>::max(); }
-    size_type capacity() const noexcept { return m_chunks.size() * ChunkSizeV; }
 
-    bool empty() const noexcept { return m_chunks.size() == 0; }
+    bool empty() const noexcept { return size() == 0; }
 
     void reserve(size_type new_capacity);
     void shrink_to_fit() noexcept {}
@@ -195,15 +214,15 @@ public:
     }
     bool operator!=(const this_type& c) const { return !operator==(c); }
 
-    void swap(this_type& v) { std::swap(m_chunks, v.m_chunks); }
+    void swap(this_type& v);
 
     friend void swap(this_type& l, this_type& r) { l.swap(r); }
 
-    reference       front() { return m_chunks.front()->front(); }
-    const_reference front() const { return front(); }
+    reference       front() { return operator[](0); }
+    const_reference front() const { return operator[](0); }
 
-    reference       back() { return m_chunks.back()->back(); }
-    const_reference back() const { return back(); }
+    reference       back() { return operator[](size() - 1); }
+    const_reference back() const { return operator[](size() - 1); }
 
     void push_back(const Tp& t);
     void push_back(Tp&& t);
@@ -220,18 +239,44 @@ public:
     const_reference at(size_type i) const;
 
 private:
-    using chunk_type   = container::aligned_static_vector<Tp, ChunkSizeV, AlignN, true>;
-    using storage_type = std::vector<std::unique_ptr<chunk_type>>;
+    // raw storage: the elements are constructed in place by emplace_back and only the
+    // first size() elements are destroyed
+    struct aligned_storage_type
+    {
+        alignas(AlignN) alignas(Tp) unsigned char data[sizeof(Tp)];
+    };
+
+    using segment_type = aligned_storage_type*;
+    using storage_type = std::array<std::atomic<segment_type>, max_segments>;
+
+    // index of the first element in segment N
+    static constexpr size_type segment_begin(size_type n)
+    {
+        return ChunkSizeV * ((size_type{ 1 } << n) - 1);
+    }
 
-    void        add_chunk();
-    chunk_type& last_chunk();
+    static constexpr size_type segment_capacity(size_type n) { return ChunkSizeV << n; }
 
-    storage_type m_chunks;
+    static size_type segment_index(size_type i)
+    {
+        auto _v = (i / ChunkSizeV) + 1;
+        return (std::numeric_limits<unsigned long long>::digits - 1) -
+               __builtin_clzll(_v);
+    }
+
+    void  add_segment();
+    void* next_slot();
+    void  clear_segments() noexcept;
+
+    storage_type        m_segments     = {};
+    std::atomic<size_t> m_num_segments = { 0 };
+    std::atomic<size_t> m_size         = { 0 };
 };
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(size_type count, const Tp& value)
 {
+    reserve(count);
     for(size_type i = 0; i < count; ++i)
     {
         emplace_back(value);
@@ -241,6 +286,7 @@ stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(size_type count, const Tp&
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(size_type count)
 {
+    reserve(count);
     for(size_type i = 0; i < count; ++i)
     {
         emplace_back();
@@ -260,26 +306,35 @@ stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(InputItrT first, InputItrT
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(const stable_vector& other)
 {
-    for(const auto& chunk : other.m_chunks)
+    reserve(other.size());
+    for(const auto& itr : other)
     {
-        m_chunks.emplace_back(std::make_unique<chunk_type>(*chunk));
+        emplace_back(itr);
     }
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(stable_vector&& other) noexcept
-: m_chunks(std::move(other.m_chunks))
-{}
+{
+    swap(other);
+}
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>::stable_vector(std::initializer_list<Tp> ilist)
 {
+    reserve(ilist.size());
     for(const auto& t : ilist)
     {
         emplace_back(t);
     }
 }
 
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+stable_vector<Tp, ChunkSizeV, AlignN>::~stable_vector()
+{
+    clear_segments();
+}
+
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 stable_vector<Tp, ChunkSizeV, AlignN>&
 stable_vector<Tp, ChunkSizeV, AlignN>::operator=(stable_vector v)
@@ -290,31 +345,83 @@ stable_vector<Tp, ChunkSizeV, AlignN>::operator=(stable_vector v)
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 void
-stable_vector<Tp, ChunkSizeV, AlignN>::add_chunk()
+stable_vector<Tp, ChunkSizeV, AlignN>::swap(this_type& v)
 {
-    m_chunks.emplace_back(std::make_unique<chunk_type>());
+    if(this == &v) return;
+
+    for(size_t i = 0; i < max_segments; ++i)
+    {
+        auto* _seg = m_segments[i].load();
+        m_segments[i].store(v.m_segments[i].load());
+        v.m_segments[i].store(_seg);
+    }
+
+    auto _num_segments = m_num_segments.load();
+    auto _size         = m_size.load();
+    m_num_segments.store(v.m_num_segments.load());
+    m_size.store(v.m_size.load());
+    v.m_num_segments.store(_num_segments);
+    v.m_size.store(_size);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+stable_vector<Tp, ChunkSizeV, AlignN>::clear_segments() noexcept
+{
+    if constexpr(!std::is_trivially_destructible<Tp>::value)
+    {
+        auto _size = m_size.load();
+        for(size_type i = 0; i < _size; ++i)
+            operator[](i).~Tp();
+    }
+
+    for(auto& itr : m_segments)
+    {
+        delete[] itr.exchange(nullptr);
+    }
+    m_num_segments.store(0);
+    m_size.store(0);
+}
+
+template <typename Tp, size_t ChunkSizeV, size_t AlignN>
+void
+stable_vector<Tp, ChunkSizeV, AlignN>::add_segment()
+{
+    auto _idx = m_num_segments.load(std::memory_order_relaxed);
+    if(OMNITRACE_UNLIKELY(_idx >= max_segments))
+    {
+        throw ::omnitrace::exception<std::length_error>(
+            "stable_vector::add_segment() exceeded the maximum number of segments");
+    }
+
+    // publish the segment before the segment count so readers never see a null segment
+    m_segments[_idx].store(new aligned_storage_type[segment_capacity(_idx)],
+                           std::memory_order_release);
+    m_num_segments.store(_idx + 1, std::memory_order_release);
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
-typename stable_vector<Tp, ChunkSizeV, AlignN>::chunk_type&
-stable_vector<Tp, ChunkSizeV, AlignN>::last_chunk()
+void*
+stable_vector<Tp, ChunkSizeV, AlignN>::next_slot()
 {
-    if(OMNITRACE_UNLIKELY(m_chunks.empty() || m_chunks.back()->size() == ChunkSizeV))
+    auto _idx = m_size.load(std::memory_order_relaxed);
+    if(OMNITRACE_UNLIKELY(_idx >= capacity()))
     {
-        add_chunk();
+        add_segment();
     }
 
-    return *m_chunks.back();
+    auto  _seg  = segment_index(_idx);
+    auto* _data = m_segments[_seg].load(std::memory_order_relaxed);
+    return _data[_idx - segment_begin(_seg)].data;
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 void
 stable_vector<Tp, ChunkSizeV, AlignN>::reserve(size_type new_capacity)
 {
-    const size_t initial_capacity = capacity();
-    for(difference_type i = new_capacity - initial_capacity; i > 0; i -= ChunkSizeV)
+    while(capacity() < new_capacity)
     {
-        add_chunk();
+        add_segment();
     }
 }
 
@@ -322,14 +429,14 @@ template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 void
 stable_vector<Tp, ChunkSizeV, AlignN>::push_back(const Tp& t)
 {
-    last_chunk().push_back(t);
+    emplace_back(t);
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 void
 stable_vector<Tp, ChunkSizeV, AlignN>::push_back(Tp&& t)
 {
-    last_chunk().push_back(std::move(t));
+    emplace_back(std::move(t));
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
@@ -337,14 +444,18 @@ template <typename... Args>
 void
 stable_vector<Tp, ChunkSizeV, AlignN>::emplace_back(Args&&... args)
 {
-    last_chunk().emplace_back(std::forward<Args>(args)...);
+    ::new(next_slot()) Tp{ std::forward<Args>(args)... };
+    // publish the element after it has been constructed
+    m_size.fetch_add(1, std::memory_order_release);
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
 typename stable_vector<Tp, ChunkSizeV, AlignN>::reference
 stable_vector<Tp, ChunkSizeV, AlignN>::operator[](size_type i)
 {
-    return (*m_chunks[i / ChunkSizeV])[i % ChunkSizeV];
+    auto  _seg  = segment_index(i);
+    auto* _data = m_segments[_seg].load(std::memory_order_acquire);
+    return *std::launder(reinterpret_cast<pointer>(_data[i - segment_begin(_seg)].data));
 }
 
 template <typename Tp, size_t ChunkSizeV, size_t AlignN>
@@ -29,9 +29,17 @@
 #include <timemory/process/threading.hpp>
 #include <timemory/utility/filepath.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
 
 namespace omnitrace
 {
@@ -77,8 +85,200 @@ get_source_location_history()
 
 auto _protect_lock   = std::atomic<bool>{ false };
 auto _protect_unlock = std::atomic<bool>{ false };
+
+// single-producer (the owning thread), single-consumer (the writer thread or drain)
+// ring buffer of formatted messages. The buffers are never deleted because the writer
+// may still need to drain the buffer of a thread which has exited
+struct async_buffer
+{
+    static constexpr size_t size = 64;
+
+    using slot_type = std::pair<size_t, std::array<char, message::capacity>>;
+
+    int64_t                     tid     = get_tid();
+    std::atomic<size_t>         head    = { 0 };
+    std::atomic<size_t>         tail    = { 0 };
+    std::atomic<size_t>         dropped = { 0 };
+    size_t                      total   = 0;  // dropped messages already reported
+    std::array<slot_type, size> slots   = {};
+};
+
+struct async_state
+{
+    std::mutex                 mutex   = {};  // guards buffers
+    std::mutex                 drain   = {};  // serializes the consumers
+    std::atomic<bool>          started = { false };
+    std::vector<async_buffer*> buffers = {};
+};
+
+auto&
+get_async_state()
+{
+    static auto* _v = new async_state{};
+    return *_v;
+}
+
+void
+start_async_writer()
+{
+    auto& _state = get_async_state();
+    if(_state.started.exchange(true)) return;
+
+    // the writer thread does not survive a fork so the child restarts it
+    static auto _atfork = pthread_atfork(
+        []() {
+            get_async_state().drain.lock();
+            get_async_state().mutex.lock();
+        },
+        []() {
+            get_async_state().mutex.unlock();
+            get_async_state().drain.unlock();
+        },
+        []() {
+            get_async_state().mutex.unlock();
+            get_async_state().drain.unlock();
+            get_async_state().started.store(false);
+        });
+    (void) _atfork;
+
+    std::thread{ []() {
+        set_thread_state(ThreadState::Disabled);
+        while(true)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+            drain();
+        }
+    } }.detach();
+}
+
+// writes the queued messages of every thread. Requires the drain mutex, which the
+// writer thread also holds while it uses the file pointer
+void
+drain_buffers()
+{
+    auto& _state   = get_async_state();
+    auto  _buffers = std::vector<async_buffer*>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+        _buffers = _state.buffers;
+    }
+
+    auto* _file  = get_file();
+    bool  _wrote = false;
+    for(auto* itr : _buffers)
+    {
+        auto _tail = itr->tail.load(std::memory_order_relaxed);
+        auto _head = itr->head.load(std::memory_order_acquire);
+        for(; _tail < _head; ++_tail)
+        {
+            const auto& _slot = itr->slots.at(_tail % async_buffer::size);
+            fwrite(_slot.second.data(), sizeof(char), _slot.first, _file);
+            fprintf(_file, "%s", ::tim::log::color::end());
+            _wrote = true;
+        }
+        itr->tail.store(_tail, std::memory_order_release);
+
+        auto _dropped = itr->dropped.load(std::memory_order_relaxed);
+        if(_dropped > itr->total)
+        {
+            fprintf(_file, "[omnitrace][%li] %zu log messages were dropped\n", itr->tid,
+                    _dropped - itr->total);
+            itr->total = _dropped;
+            _wrote     = true;
+        }
+    }
+
+    if(_wrote) fflush(_file);
+}
+
+async_buffer*
+get_async_buffer()
+{
+    static thread_local auto* _v = []() {
+        auto* _buffer = new async_buffer{};
+        auto& _state  = get_async_state();
+        auto  _lk     = std::unique_lock<std::mutex>{ _state.mutex };
+        _state.buffers.emplace_back(_buffer);
+        return _buffer;
+    }();
+    start_async_writer();
+    return _v;
+}
 }  // namespace
 
+bool
+is_async()
+{
+    static auto _v = tim::get_env<bool>("OMNITRACE_LOG_ASYNC", false);
+    return _v;
+}
+
+void
+drain()
+{
+    if(!is_async()) return;
+
+    // blocks while the writer thread is draining so that every message queued before
+    // the call has been written when this returns (e.g. before a fatal message)
+    auto _dlk = std::unique_lock<std::mutex>{ get_async_state().drain };
+    drain_buffers();
+}
+
+message::message(const char* _color)
+{
+    if(m_async)
+    {
+        (*this)("%s", _color);
+    }
+    else
+    {
+        flush();
+        m_lk.emplace();
+        fprintf(get_file(), "%s", _color);
+    }
+}
+
+message::~message()
+{
+    if(!m_async)
+    {
+        flush();
+        return;
+    }
+
+    auto* _buffer = get_async_buffer();
+    auto  _head   = _buffer->head.load(std::memory_order_relaxed);
+    if(_head - _buffer->tail.load(std::memory_order_acquire) >= async_buffer::size)
+    {
+        _buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& _slot = _buffer->slots.at(_head % async_buffer::size);
+    std::memcpy(_slot.second.data(), m_buffer.data(), m_size);
+    _slot.first = m_size;
+    _buffer->head.store(_head + 1, std::memory_order_release);
+}
+
+void
+message::operator()(const char* _fmt, ...)
+{
+    va_list _args;
+    va_start(_args, _fmt);
+    if(!m_async)
+    {
+        vfprintf(get_file(), _fmt, _args);
+    }
+    else if(m_size < capacity)
+    {
+        auto _n = vsnprintf(m_buffer.data() + m_size, capacity - m_size, _fmt, _args);
+        // truncated messages keep the trailing newline
+        if(_n > 0) m_size = std::min<size_t>(m_size + _n, capacity - 1);
+        if(m_size == capacity - 1) m_buffer.at(m_size - 1) = '\n';
+    }
+    va_end(_args);
+}
+
 void
 set_source_location(source_location&& _v)
 {
@@ -120,16 +320,21 @@ get_file()
 void
 close_file()
 {
-    if(get_file() != stderr)
-    {
-        auto* _file = get_file_pointer().load();
-        get_file_pointer().store(stderr);
-        fclose(_file);
-        // Write the trace into a file.
-        if(get_verbose() >= 0)
-            operation::file_output_message<tim::project::omnitrace>{}(
-                get_file_name(), std::string{ "debug" });
-    }
+    // the writer thread uses the file pointer while holding the drain mutex so the
+    // pointer is swapped and the file is closed while holding it
+    auto _dlk = std::unique_lock<std::mutex>{ get_async_state().drain };
+    if(is_async()) drain_buffers();
+    if(get_file() == stderr) return;
+
+    auto* _file = get_file_pointer().load();
+    get_file_pointer().store(stderr);
+    fclose(_file);
+    _dlk.unlock();
+
+    // Write the trace into a file.
+    if(get_verbose() >= 0)
+        operation::file_output_message<tim::project::omnitrace>{}(get_file_name(),
+                                                                  std::string{ "debug" });
 }
 
 int64_t
@@ -40,6 +40,7 @@
 #include <array>
 #include <cstdio>
 #include <cstring>
+#include <optional>
 #include <string_view>
 #include <utility>
 
@@ -90,9 +91,13 @@ close_file();
 int64_t
 get_tid();
 //
+void
+drain();
+//
 inline void
 flush()
 {
+    drain();
     fprintf(stdout, "%s", ::tim::log::color::end());
     fflush(stdout);
     std::cout << ::tim::log::color::end() << std::flush;
@@ -110,6 +115,32 @@ private:
     locking::atomic_lock m_lk;
 };
 //
+// OMNITRACE_LOG_ASYNC: when enabled, the messages are formatted into a per-thread ring
+// buffer and written out by a background thread instead of serializing the threads on
+// the lock. Messages which do not fit into a full ring buffer are dropped and the number
+// of dropped messages is reported by the background thread
+bool
+is_async();
+//
+struct message
+{
+    static constexpr size_t capacity = 1024;
+
+    explicit message(const char* _color);
+    ~message();
+
+    message(const message&) = delete;
+    message& operator=(const message&) = delete;
+
+    void operator()(const char* _fmt, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    bool                       m_async  = is_async();
+    size_t                     m_size   = 0;
+    std::optional<lock>        m_lk     = {};
+    std::array<char, capacity> m_buffer;
+};
+//
 template <typename Arg, typename... Args>
 bool
 is_bracket(Arg&& _arg, Args&&...)
@@ -222,29 +253,22 @@ as_hex<void*>(void*, size_t);
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(COLOR);                                           \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%li]%s",                \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_DEBUG_THREAD_IDENTIFIER,   \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::COLOR() };            \
+        _debug_msg("[omnitrace][%i][%li]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,         \
+                   OMNITRACE_DEBUG_THREAD_IDENTIFIER,                                    \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_PRINT_COLOR_F(COLOR, COND, ...)                            \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(COLOR);                                           \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%li][%s]%s",            \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_DEBUG_THREAD_IDENTIFIER,   \
-                OMNITRACE_FUNCTION,                                                      \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::COLOR() };            \
+        _debug_msg("[omnitrace][%i][%li][%s]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,     \
+                   OMNITRACE_DEBUG_THREAD_IDENTIFIER, OMNITRACE_FUNCTION,                \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_PRINT_COLOR(COLOR, ...)                                                \
@@ -259,57 +283,43 @@ as_hex<void*>(void*, size_t);
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(info);                                            \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%li]%s",                \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_DEBUG_THREAD_IDENTIFIER,   \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::info() };             \
+        _debug_msg("[omnitrace][%i][%li]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,         \
+                   OMNITRACE_DEBUG_THREAD_IDENTIFIER,                                    \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_BASIC_PRINT(COND, ...)                                     \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(info);                                            \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i]%s",                     \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER,                                      \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::info() };             \
+        _debug_msg("[omnitrace][%i]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,              \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_PRINT_F(COND, ...)                                         \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(info);                                            \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%li][%s]%s",            \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_DEBUG_THREAD_IDENTIFIER,   \
-                OMNITRACE_FUNCTION,                                                      \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::info() };             \
+        _debug_msg("[omnitrace][%i][%li][%s]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,     \
+                   OMNITRACE_DEBUG_THREAD_IDENTIFIER, OMNITRACE_FUNCTION,                \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_BASIC_PRINT_F(COND, ...)                                   \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(info);                                            \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%s]%s",                 \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_FUNCTION,                  \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::info() };             \
+        _debug_msg("[omnitrace][%i][%s]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,          \
+                   OMNITRACE_FUNCTION,                                                   \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 //--------------------------------------------------------------------------------------//
@@ -318,57 +328,43 @@ as_hex<void*>(void*, size_t);
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(warning);                                         \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%li]%s",                \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_DEBUG_THREAD_IDENTIFIER,   \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::warning() };          \
+        _debug_msg("[omnitrace][%i][%li]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,         \
+                   OMNITRACE_DEBUG_THREAD_IDENTIFIER,                                    \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_BASIC_WARN(COND, ...)                                      \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(warning);                                         \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i]%s",                     \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER,                                      \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::warning() };          \
+        _debug_msg("[omnitrace][%i]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,              \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_WARN_F(COND, ...)                                          \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(warning);                                         \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%li][%s]%s",            \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_DEBUG_THREAD_IDENTIFIER,   \
-                OMNITRACE_FUNCTION,                                                      \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::warning() };          \
+        _debug_msg("[omnitrace][%i][%li][%s]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,     \
+                   OMNITRACE_DEBUG_THREAD_IDENTIFIER, OMNITRACE_FUNCTION,                \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 #define OMNITRACE_CONDITIONAL_BASIC_WARN_F(COND, ...)                                    \
     if(OMNITRACE_UNLIKELY((COND) && ::omnitrace::config::get_debug_tid() &&              \
                           ::omnitrace::config::get_debug_pid()))                         \
     {                                                                                    \
-        ::omnitrace::debug::flush();                                                     \
-        ::omnitrace::debug::lock _debug_lk{};                                            \
-        OMNITRACE_FPRINTF_STDERR_COLOR(warning);                                         \
-        fprintf(::omnitrace::debug::get_file(), "[omnitrace][%i][%s]%s",                 \
-                OMNITRACE_DEBUG_PROCESS_IDENTIFIER, OMNITRACE_FUNCTION,                  \
-                ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");                 \
-        fprintf(::omnitrace::debug::get_file(), __VA_ARGS__);                            \
-        ::omnitrace::debug::flush();                                                     \
+        ::omnitrace::debug::message _debug_msg{ ::tim::log::color::warning() };          \
+        _debug_msg("[omnitrace][%i][%s]%s", OMNITRACE_DEBUG_PROCESS_IDENTIFIER,          \
+                   OMNITRACE_FUNCTION,                                                   \
+                   ::omnitrace::debug::is_bracket(__VA_ARGS__) ? "" : " ");              \
+        _debug_msg(__VA_ARGS__);                                                         \
     }
 
 //--------------------------------------------------------------------------------------//
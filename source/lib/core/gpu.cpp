@@ -38,12 +38,22 @@
 #    endif
 #endif
 
+#include "config.hpp"
 #include "debug.hpp"
 #include "defines.hpp"
 #include "gpu.hpp"
 
 #include <timemory/manager.hpp>
 
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
 #if OMNITRACE_USE_ROCM_SMI > 0
 #    include <rocm_smi/rocm_smi.h>
 #endif
@@ -194,6 +204,139 @@ device_prop_serialize(ArchiveT& archive, const char* name, hipDeviceArch_t arg)
 #    undef OMNITRACE_SERIALIZE_HIP_DEVICE_ARCH
 }
 #endif
+
+#if OMNITRACE_USE_HIP > 0
+struct hip_device_info
+{
+    hipDeviceProp_t prop            = {};
+    int             driver_version  = 0;
+    int             runtime_version = 0;
+};
+
+constexpr uint64_t hip_device_cache_magic = 0x6f6d6e6968697064;  // "omnihipd"
+
+// the processes on a node which see the same devices through the same driver share
+// the cached device properties. The boot id invalidates the caches of a previous boot
+std::string
+get_hip_device_cache_filename()
+{
+    if(!config::get_hip_device_metadata_cache()) return std::string{};
+
+    int _driver_version  = 0;
+    int _runtime_version = 0;
+    if(hipDriverGetVersion(&_driver_version) != hipSuccess ||
+       hipRuntimeGetVersion(&_runtime_version) != hipSuccess)
+        return std::string{};
+
+    auto _boot_id = std::string{};
+    std::ifstream{ "/proc/sys/kernel/random/boot_id" } >> _boot_id;
+
+    auto _key = std::stringstream{};
+    _key << _boot_id << '-' << getuid() << '-' << _driver_version << '-'
+         << _runtime_version << '-' << sizeof(hipDeviceProp_t);
+    for(const char* itr : { "ROCR_VISIBLE_DEVICES", "HIP_VISIBLE_DEVICES",
+                            "CUDA_VISIBLE_DEVICES", "GPU_DEVICE_ORDINAL" })
+        _key << '-' << tim::get_env<std::string>(itr, "", false);
+
+    auto _name = JOIN("", "omnitrace-hip-devices-", std::hex,
+                      std::hash<std::string>{}(_key.str()), ".bin");
+    return JOIN('/', config::get_tmpdir(), _name);
+}
+
+std::vector<hip_device_info>
+read_hip_device_cache(const std::string& _fname)
+{
+    auto _v = std::vector<hip_device_info>{};
+    if(_fname.empty()) return _v;
+
+    auto _ifs = std::ifstream{ _fname, std::ios::binary };
+    if(!_ifs) return _v;
+
+    uint64_t _magic = 0;
+    uint64_t _count = 0;
+    _ifs.read(reinterpret_cast<char*>(&_magic), sizeof(_magic));
+    _ifs.read(reinterpret_cast<char*>(&_count), sizeof(_count));
+    if(!_ifs || _magic != hip_device_cache_magic || _count > 1024) return _v;
+
+    _v.resize(_count);
+    _ifs.read(reinterpret_cast<char*>(_v.data()), _count * sizeof(hip_device_info));
+    if(!_ifs) _v.clear();
+    return _v;
+}
+
+// written to a temporary file which is renamed so the readers never see a partial file
+void
+write_hip_device_cache(const std::string& _fname, const std::vector<hip_device_info>& _v)
+{
+    if(_fname.empty() || _v.empty()) return;
+
+    auto _tmp = JOIN('.', _fname, getpid());
+    {
+        auto     _ofs   = std::ofstream{ _tmp, std::ios::binary };
+        uint64_t _magic = hip_device_cache_magic;
+        uint64_t _count = _v.size();
+        _ofs.write(reinterpret_cast<const char*>(&_magic), sizeof(_magic));
+        _ofs.write(reinterpret_cast<const char*>(&_count), sizeof(_count));
+        _ofs.write(reinterpret_cast<const char*>(_v.data()),
+                   _v.size() * sizeof(hip_device_info));
+        if(!_ofs)
+        {
+            std::remove(_tmp.c_str());
+            return;
+        }
+    }
+
+    if(std::rename(_tmp.c_str(), _fname.c_str()) != 0) std::remove(_tmp.c_str());
+}
+
+// selecting every device to query its properties creates a context on it so the
+// properties are queried once per process and, with the node cache, once per node
+const std::vector<hip_device_info>&
+get_hip_device_info()
+{
+    static auto _v = []() {
+        auto _fname = get_hip_device_cache_filename();
+        auto _data  = read_hip_device_cache(_fname);
+        if(!_data.empty())
+        {
+            OMNITRACE_BASIC_VERBOSE(2, "Read the HIP device properties from %s\n",
+                                    _fname.c_str());
+            return _data;
+        }
+
+        int        _device_count     = 0;
+        int        _current_device   = 0;
+        hipError_t _device_count_err = hipGetDeviceCount(&_device_count);
+
+        if(_device_count_err != hipSuccess) return _data;
+
+        hipError_t _current_device_err = hipGetDevice(&_current_device);
+
+        scope::destructor _dtor{ [_current_device, _current_device_err]() {
+            if(_current_device_err == hipSuccess)
+            {
+                OMNITRACE_HIP_RUNTIME_CALL(hipSetDevice(_current_device));
+            }
+        } };
+
+        if(_current_device_err != hipSuccess || _device_count == 0) return _data;
+
+        for(int dev = 0; dev < _device_count; ++dev)
+        {
+            auto _info = hip_device_info{};
+            OMNITRACE_HIP_RUNTIME_CALL(hipSetDevice(dev));
+            OMNITRACE_HIP_RUNTIME_CALL(hipGetDeviceProperties(&_info.prop, dev));
+            OMNITRACE_HIP_RUNTIME_CALL(hipDriverGetVersion(&_info.driver_version));
+            OMNITRACE_HIP_RUNTIME_CALL(hipRuntimeGetVersion(&_info.runtime_version));
+            _data.emplace_back(_info);
+        }
+
+        write_hip_device_cache(_fname, _data);
+        return _data;
+    }();
+    return _v;
+}
+#endif
 }  // namespace
 
 int
@@ -231,6 +374,27 @@ rsmi_device_count()
 #endif
 }
 
+device_peak
+get_device_peak(int _device)
+{
+    auto _v = device_peak{};
+#if OMNITRACE_USE_HIP > 0
+    const auto& _devices = get_hip_device_info();
+    if(_device < 0 || static_cast<size_t>(_device) >= _devices.size()) return _v;
+
+    // the clock rates are in kHz. Every compute unit retires 64 FMAs (2 FLOPs each) per
+    // cycle and the memory transfers on both edges of the clock. The matrix cores are
+    // not described by the device properties
+    const auto& _prop = _devices.at(_device).prop;
+
+    _v.flops = 128.0 * _prop.multiProcessorCount * (_prop.clockRate * 1.0e3);
+    _v.bytes = 2.0 * (_prop.memoryClockRate * 1.0e3) * (_prop.memoryBusWidth / 8.0);
+#else
+    (void) _device;
+#endif
+    return _v;
+}
+
 int
 device_count()
 {
@@ -252,37 +416,19 @@ add_hip_device_metadata(ArchiveT& ar)
     using cereal::make_nvp;
 
 #if OMNITRACE_USE_HIP > 0
-    int        _device_count     = 0;
-    int        _current_device   = 0;
-    hipError_t _device_count_err = hipGetDeviceCount(&_device_count);
-
-    if(_device_count_err != hipSuccess) return;
-
-    hipError_t _current_device_err = hipGetDevice(&_current_device);
-
-    scope::destructor _dtor{ [_current_device, _current_device_err]() {
-        if(_current_device_err == hipSuccess)
-        {
-            OMNITRACE_HIP_RUNTIME_CALL(hipSetDevice(_current_device));
-        }
-    } };
-
-    if(_current_device_err != hipSuccess || _device_count == 0) return;
+    const auto& _devices = get_hip_device_info();
+    if(_devices.empty()) return;
 
     ar.setNextName("hip_device_properties");
     ar.startNode();
     ar.makeArray();
 
     scope::destructor _prop_dtor{ [&ar]() { ar.finishNode(); } };
-    for(int dev = 0; dev < _device_count; ++dev)
+    for(const auto& itr : _devices)
     {
-        auto _device_prop     = hipDeviceProp_t{};
-        int  _driver_version  = 0;
-        int  _runtime_version = 0;
-        OMNITRACE_HIP_RUNTIME_CALL(hipSetDevice(dev));
-        OMNITRACE_HIP_RUNTIME_CALL(hipGetDeviceProperties(&_device_prop, dev));
-        OMNITRACE_HIP_RUNTIME_CALL(hipDriverGetVersion(&_driver_version));
-        OMNITRACE_HIP_RUNTIME_CALL(hipRuntimeGetVersion(&_runtime_version));
+        auto _device_prop     = itr.prop;
+        auto _driver_version  = itr.driver_version;
+        auto _runtime_version = itr.runtime_version;
 
         ar.startNode();
 
@@ -485,11 +631,12 @@ add_hip_device_metadata(ArchiveT& ar)
 void
 add_hip_device_metadata()
 {
-    if(device_count() == 0) return;
-
+    // the devices are counted and queried when the metadata is written so runs which
+    // never write it do not pay for initializing the devices
     OMNITRACE_METADATA([](auto& ar) {
         try
         {
+            if(device_count() == 0) return;
             add_hip_device_metadata(ar);
         } catch(std::runtime_error& _e)
         {
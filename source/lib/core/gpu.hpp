@@ -35,6 +35,16 @@ hip_device_count();
 int
 rsmi_device_count();
 
+// theoretical peak throughput of a HIP device from its properties (zero if unknown)
+struct device_peak
+{
+    double flops = 0.0;  // vector FP32 FMA throughput [FLOP/s]
+    double bytes = 0.0;  // DRAM bandwidth [bytes/s]
+};
+
+device_peak
+get_device_peak(int _device);
+
 void
 add_hip_device_metadata();
 }  // namespace gpu
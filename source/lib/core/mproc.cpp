@@ -73,6 +73,31 @@ get_process_index(int _pid, int _ppid)
     return -1;
 }
 
+int
+get_launcher_rank()
+{
+    for(const char* itr : { "OMPI_COMM_WORLD_RANK", "PMI_RANK", "PMIX_RANK",
+                            "MV2_COMM_WORLD_RANK", "SLURM_PROCID" })
+    {
+        auto _rank = get_env<int>(itr, -1, false);
+        if(_rank >= 0) return _rank;
+    }
+    return -1;
+}
+
+int
+get_launcher_local_rank()
+{
+    for(const char* itr : { "OMPI_COMM_WORLD_LOCAL_RANK", "MPI_LOCALRANKID",
+                            "MV2_COMM_WORLD_LOCAL_RANK", "PALS_LOCAL_RANKID",
+                            "SLURM_LOCALID" })
+    {
+        auto _rank = get_env<int>(itr, -1, false);
+        if(_rank >= 0) return _rank;
+    }
+    return -1;
+}
+
 int
 wait_pid(pid_t _pid, int _opts)
 {
@@ -36,6 +36,14 @@ get_concurrent_processes(int _ppid = getppid());
 int
 get_process_index(int _pid = getpid(), int _ppid = getppid());
 
+// the rank and the node-local rank set by the MPI launcher (or slurm) in the
+// environment, which are available before MPI_Init. Returns -1 if not set
+int
+get_launcher_rank();
+
+int
+get_launcher_local_rank();
+
 int
 wait_pid(pid_t _pid, int _opts = 0);
 
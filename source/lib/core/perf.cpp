@@ -22,9 +22,12 @@
 
 #include "perf.hpp"
 #include "debug.hpp"
+#include "utility.hpp"
 
 #include <timemory/units.hpp>
 
+#include <string>
+
 namespace omnitrace
 {
 namespace perf
@@ -197,11 +200,8 @@ get_hw_cache_config(std::string_view _v)
 }
 
 void
-config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
-                         double _freq)
+config_event(struct perf_event_attr& _pe, std::string_view _event)
 {
-    auto _period = (1.0 / _freq) * units::sec;
-
     _pe.type = static_cast<int>(perf::get_event_type(_event));
     switch(_pe.type)
     {
@@ -229,6 +229,15 @@ config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
             OMNITRACE_THROW("unsupported perf type");
         }
     };
+}
+
+void
+config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
+                         double _freq)
+{
+    auto _period = (1.0 / _freq) * units::sec;
+
+    config_event(_pe, _event);
 
     if(_pe.type == PERF_TYPE_SOFTWARE &&
        (_pe.config == PERF_COUNT_SW_CPU_CLOCK || _pe.config == PERF_COUNT_SW_TASK_CLOCK))
@@ -240,5 +249,45 @@ config_overflow_sampling(struct perf_event_attr& _pe, std::string_view _event,
         _pe.sample_period = static_cast<uint64_t>(_freq);
     }
 }
+
+int
+get_pmu_type(std::string_view _pmu)
+{
+    auto _path = std::string{ "/sys/bus/event_source/devices/" };
+    auto _v    = utility::read_string(_path.append(_pmu).append("/type"));
+    if(_v.empty() || _v.find_first_not_of("0123456789") != std::string::npos) return -1;
+    return std::stoi(_v);
+}
+
+void
+config_raw_event(struct perf_event_attr& _pe, std::string_view _event)
+{
+    auto _pmu  = std::string{ "cpu" };
+    auto _spec = std::string{ _event };
+    if(auto _pos = _spec.find('/'); _pos != std::string::npos)
+    {
+        _pmu  = _spec.substr(0, _pos);
+        _spec = _spec.substr(_pos + 1);
+    }
+
+    auto _type = get_pmu_type(_pmu);
+    if(_pmu == "cpu" && _type < 0) _type = PERF_TYPE_RAW;
+
+    OMNITRACE_REQUIRE(_type >= 0)
+        << "Unknown perf PMU '" << _pmu << "' in the raw event '" << _event << "'";
+
+    auto _config1 = std::string{};
+    if(auto _pos = _spec.find(':'); _pos != std::string::npos)
+    {
+        _config1 = _spec.substr(_pos + 1);
+        _spec    = _spec.substr(0, _pos);
+    }
+
+    _pe.type    = static_cast<uint32_t>(_type);
+    _pe.config  = std::stoull(_spec, nullptr, 0);
+    _pe.config1 = (_config1.empty()) ? 0 : std::stoull(_config1, nullptr, 0);
+    // the data addresses of the core PMUs are only valid for the precise events
+    _pe.precise_ip = (_pmu == "cpu") ? 2 : 0;
+}
 }  // namespace perf
 }  // namespace omnitrace
@@ -285,7 +285,21 @@ hw_config  get_hw_config(std::string_view);
 sw_config  get_sw_config(std::string_view);
 int        get_hw_cache_config(std::string_view);
 
+/// the perf event type of a PMU from /sys/bus/event_source/devices/<pmu>/type, e.g.
+/// "msr" or "ibs_op". Returns -1 when the PMU is not available
+int get_pmu_type(std::string_view);
+
+/// set the type and config of the event (e.g. PERF_COUNT_HW_INSTRUCTIONS)
+void
+config_event(struct perf_event_attr&, std::string_view);
+
 void
 config_overflow_sampling(struct perf_event_attr&, std::string_view, double);
+
+/// set the type and config of a raw event of a PMU. The format is
+/// "[<pmu>/]<config>[:<config1>]" with hexadecimal or decimal values, e.g.
+/// "cpu/0x1cd:0x3". The PMU defaults to "cpu"
+void
+config_raw_event(struct perf_event_attr&, std::string_view);
 }  // namespace perf
 }  // namespace omnitrace
@@ -21,11 +21,43 @@
 // SOFTWARE.
 
 #include "perfetto.hpp"
+#include "clock_sync.hpp"
+#include "compression.hpp"
 #include "config.hpp"
 #include "library/runtime.hpp"
 #include "perfetto_fwd.hpp"
+#include "state.hpp"
 #include "utility.hpp"
 
+#include <timemory/backends/threading.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+#    include <mpi.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace omnitrace
 {
 namespace perfetto
@@ -54,6 +86,72 @@ get_config()
     return _v;
 }
 
+size_t
+get_file_size(const std::string& _filename)
+{
+    struct stat _stat = {};
+    if(::stat(_filename.c_str(), &_stat) != 0) return 0;
+    return static_cast<size_t>(_stat.st_size);
+}
+
+// moves the source file to the destination (rename when on the same filesystem)
+// or copies it with a bounded amount of memory
+bool
+move_file(const std::string& _src, const std::string& _dst)
+{
+    if(::rename(_src.c_str(), _dst.c_str()) == 0) return true;
+
+    auto _src_fd = ::open(_src.c_str(), O_RDONLY);
+    if(_src_fd < 0) return false;
+
+    auto _dst_fd = ::open(_dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(_dst_fd < 0)
+    {
+        ::close(_src_fd);
+        return false;
+    }
+
+    constexpr size_t chunk_size = 8 * units::MB;
+    size_t           _remaining = get_file_size(_src);
+    bool             _success   = true;
+
+    // in-kernel copy first, if not supported then fallback to read + write
+    while(_remaining > 0)
+    {
+        auto _n = ::sendfile(_dst_fd, _src_fd, nullptr, std::min(_remaining, chunk_size));
+        if(_n <= 0) break;
+        _remaining -= _n;
+    }
+
+    if(_remaining > 0)
+    {
+        auto _buffer = std::vector<char>(chunk_size);
+        while(_remaining > 0)
+        {
+            auto _nread = ::read(_src_fd, _buffer.data(), _buffer.size());
+            if(_nread < 0 && errno == EINTR) continue;
+            if(_nread <= 0) break;
+
+            ssize_t _nwrite = 0;
+            while(_nwrite < _nread)
+            {
+                auto _n = ::write(_dst_fd, _buffer.data() + _nwrite, _nread - _nwrite);
+                if(_n < 0 && errno == EINTR) continue;
+                if(_n <= 0) break;
+                _nwrite += _n;
+            }
+
+            if(_nwrite < _nread) break;
+            _remaining -= _nread;
+        }
+    }
+
+    _success = (_remaining == 0);
+    ::close(_src_fd);
+    ::close(_dst_fd);
+    return _success;
+}
+
 auto&
 get_session(pid_t _pid = process::get_id())
 {
@@ -63,6 +161,500 @@ get_session(pid_t _pid = process::get_id())
         _v.emplace(_pid, std::unique_ptr<::perfetto::TracingSession>{});
     return _v.at(_pid);
 }
+
+// buffer statistics of the tracing sessions of this process. The adaptive mode
+// restarts the session to resize the buffer so the statistics of every stopped session
+// are accumulated
+struct buffer_stats
+{
+    uint64_t buffer_size        = 0;
+    uint64_t bytes_written      = 0;
+    uint64_t bytes_read         = 0;
+    uint64_t bytes_overwritten  = 0;
+    uint64_t chunks_discarded   = 0;
+    uint64_t chunks_overwritten = 0;
+    uint64_t patches_failed     = 0;
+    uint64_t abi_violations     = 0;
+
+    // data in the buffer which has not been read (i.e. written into the file) yet
+    uint64_t pending() const
+    {
+        auto _consumed = bytes_read + bytes_overwritten;
+        return (bytes_written > _consumed) ? (bytes_written - _consumed) : 0;
+    }
+
+    buffer_stats& operator+=(const buffer_stats& _rhs)
+    {
+        buffer_size = std::max(buffer_size, _rhs.buffer_size);
+        bytes_written += _rhs.bytes_written;
+        bytes_read += _rhs.bytes_read;
+        bytes_overwritten += _rhs.bytes_overwritten;
+        chunks_discarded += _rhs.chunks_discarded;
+        chunks_overwritten += _rhs.chunks_overwritten;
+        patches_failed += _rhs.patches_failed;
+        abi_violations += _rhs.abi_violations;
+        return *this;
+    }
+};
+
+std::optional<buffer_stats>
+get_buffer_stats(::perfetto::TracingSession& _session)
+{
+    auto _args = _session.GetTraceStatsBlocking();
+    if(!_args.success) return std::nullopt;
+
+    auto _stats = ::perfetto::protos::gen::TraceStats{};
+    if(!_stats.ParseFromArray(_args.trace_stats_data.data(),
+                              _args.trace_stats_data.size()))
+        return std::nullopt;
+
+    auto _v = buffer_stats{};
+    for(const auto& itr : _stats.buffer_stats())
+    {
+        auto _buffer               = buffer_stats{};
+        _buffer.buffer_size        = itr.buffer_size();
+        _buffer.bytes_written      = itr.bytes_written();
+        _buffer.bytes_read         = itr.bytes_read();
+        _buffer.bytes_overwritten  = itr.bytes_overwritten();
+        _buffer.chunks_discarded   = itr.chunks_discarded();
+        _buffer.chunks_overwritten = itr.chunks_overwritten();
+        _buffer.patches_failed     = itr.patches_failed();
+        _buffer.abi_violations     = itr.abi_violations();
+        _v += _buffer;
+    }
+    return _v;
+}
+
+auto&
+get_total_buffer_stats()
+{
+    static auto _v = buffer_stats{};
+    return _v;
+}
+
+// OMNITRACE_PERFETTO_BUFFER_ADAPTIVE: a background thread monitors the buffer of the
+// session. After the calibration window, the buffer is sized to hold the data written
+// between two drains into the temporary file below the high watermark (within the
+// memory budget). When the unread data crosses the high watermark, the buffer grows
+// or, once it reaches the budget, is drained more frequently. The buffer of a running
+// session cannot be resized so the session is restarted, which writes the data of
+// the stopped session into the temporary file
+struct adaptive_state
+{
+    static constexpr size_t   min_buffer_kb = 4 * 1024;
+    static constexpr uint32_t min_period_ms = 100;
+
+    std::mutex                   mutex     = {};
+    std::condition_variable      cv        = {};
+    std::unique_ptr<std::thread> thread    = {};
+    bool                         enabled   = false;
+    bool                         resizable = false;
+    bool                         running   = false;
+    size_t                       buffer_kb = 0;
+    uint32_t                     period_ms = 1000;
+    size_t                       restarts  = 0;
+    size_t                       crossings = 0;
+};
+
+auto&
+get_adaptive_state()
+{
+    static auto _v = adaptive_state{};
+    return _v;
+}
+
+size_t
+get_adaptive_buffer_size(double _kb)
+{
+    // perfetto requires a multiple of the page size, round to MB to limit churn
+    auto _v      = static_cast<size_t>(std::ceil(std::max(_kb, 0.0) / 1024.0)) * 1024;
+    auto _budget = std::max(config::get_perfetto_memory_budget(),
+                            adaptive_state::min_buffer_kb);
+    return std::clamp<size_t>(_v, adaptive_state::min_buffer_kb, _budget);
+}
+
+void
+set_buffer_config(size_t _buffer_kb, uint32_t _period_ms)
+{
+    auto& _cfg = get_config();
+    for(auto& itr : *_cfg.mutable_buffers())
+        itr.set_size_kb(static_cast<uint32_t>(_buffer_kb));
+    _cfg.set_file_write_period_ms(_period_ms);
+}
+
+// OMNITRACE_PERFETTO_COMPRESSION. Codecs which omnitrace was not built with fall back
+// to an uncompressed trace
+compression::codec
+get_compression()
+{
+    static auto _v = []() {
+        auto _name  = config::get_perfetto_compression();
+        auto _codec = compression::get_codec(_name);
+        if(!compression::is_available(_codec))
+        {
+            OMNITRACE_VERBOSE_F(0,
+                                "OMNITRACE_PERFETTO_COMPRESSION=%s is not supported by "
+                                "this build of omnitrace and will be ignored\n",
+                                _name.c_str());
+            return compression::codec::none;
+        }
+        return _codec;
+    }();
+    return _v;
+}
+
+// appends the extension of the codec unless the filename already ends with it
+std::string
+get_compressed_filename(std::string _filename, compression::codec _codec)
+{
+    auto _ext = std::string_view{ compression::get_extension(_codec) };
+    if(_ext.empty()) return _filename;
+    if(_filename.length() < _ext.length() ||
+       _filename.compare(_filename.length() - _ext.length(), _ext.length(), _ext) != 0)
+        _filename += _ext;
+    return _filename;
+}
+
+// streams the temporary file (if any) followed by the data remaining in the session
+// through the compressor into the output file. Sets the size of the output file
+std::optional<std::string>
+write_compressed_trace(const std::string& _filename, const std::string& _tmp_name,
+                       const std::vector<char>& _session_data, size_t& _size)
+{
+    auto _level  = config::get_perfetto_compression_level();
+    auto _stream = compression::stream{ get_compression(), _level };
+
+    auto _err = _stream.open(_filename);
+    if(!_err && !_tmp_name.empty()) _err = _stream.write_file(_tmp_name);
+    if(!_err && !_session_data.empty())
+        _err = _stream.write(_session_data.data(), _session_data.size());
+
+    auto _close_err = _stream.close();
+    _size           = _stream.bytes_out();
+    return (_err) ? _err : _close_err;
+}
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+bool
+mpi_is_active()
+{
+    int _init = 0;
+    int _fini = 0;
+    MPI_Initialized(&_init);
+    MPI_Finalized(&_fini);
+    return (_init != 0 && _fini == 0);
+}
+
+// minimal protobuf decoding of the trace packets for the clock conversion
+bool
+read_varint(FILE* _file, uint64_t& _v)
+{
+    _v = 0;
+    for(int _shift = 0; _shift < 64; _shift += 7)
+    {
+        auto _c = fgetc(_file);
+        if(_c == EOF) return false;
+        _v |= static_cast<uint64_t>(_c & 0x7f) << _shift;
+        if((_c & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+// returns the number of bytes consumed or zero if the varint is truncated
+size_t
+read_varint(const uint8_t* _beg, const uint8_t* _end, uint64_t& _v)
+{
+    _v = 0;
+    for(const auto* itr = _beg; itr < _end && (itr - _beg) < 10; ++itr)
+    {
+        _v |= static_cast<uint64_t>(*itr & 0x7f) << (7 * (itr - _beg));
+        if((*itr & 0x80) == 0) return (itr - _beg) + 1;
+    }
+    return 0;
+}
+
+void
+write_varint(std::vector<uint8_t>& _out, uint64_t _v)
+{
+    while(_v >= 0x80)
+    {
+        _out.emplace_back(static_cast<uint8_t>(_v | 0x80));
+        _v >>= 7;
+    }
+    _out.emplace_back(static_cast<uint8_t>(_v));
+}
+
+// replaces the timestamp (field 8) of a TracePacket with the converted timestamp.
+// Returns false when the packet has no timestamp, a timestamp relative to an
+// incremental clock (timestamp_clock_id, field 58), or cannot be decoded, i.e. when
+// the packet must be copied unchanged
+bool
+convert_packet(const std::vector<uint8_t>& _packet, std::vector<uint8_t>& _out)
+{
+    constexpr uint64_t timestamp_field          = 8;
+    constexpr uint64_t timestamp_clock_id_field = 58;
+
+    const auto* _beg    = _packet.data();
+    const auto* _end    = _beg + _packet.size();
+    const auto* _ts_beg = _end;
+    const auto* _ts_end = _end;
+    uint64_t    _ts     = 0;
+
+    for(const auto* itr = _beg; itr < _end;)
+    {
+        const auto* _field = itr;
+        uint64_t    _tag   = 0;
+        auto        _n     = read_varint(itr, _end, _tag);
+        if(_n == 0) return false;
+        itr += _n;
+
+        uint64_t _v = 0;
+        switch(_tag & 0x7)
+        {
+            case 0:
+                if((_n = read_varint(itr, _end, _v)) == 0) return false;
+                if((_tag >> 3) == timestamp_clock_id_field) return false;
+                if((_tag >> 3) == timestamp_field)
+                {
+                    _ts     = _v;
+                    _ts_beg = _field;
+                    _ts_end = itr + _n;
+                }
+                itr += _n;
+                break;
+            case 2:
+                if((_n = read_varint(itr, _end, _v)) == 0) return false;
+                if(_v > static_cast<uint64_t>(_end - itr) - _n) return false;
+                itr += _n + _v;
+                break;
+            case 1:
+            case 5:
+                _v = ((_tag & 0x7) == 1) ? 8 : 4;
+                if(_v > static_cast<uint64_t>(_end - itr)) return false;
+                itr += _v;
+                break;
+            default: return false;
+        }
+    }
+
+    if(_ts_beg == _end) return false;
+
+    _out.clear();
+    _out.insert(_out.end(), _beg, _ts_beg);
+    write_varint(_out, timestamp_field << 3);
+    write_varint(_out, clock_sync::correct(_ts));
+    _out.insert(_out.end(), _ts_end, _end);
+    return true;
+}
+
+// copies the trace packets of the input into the output and converts their
+// timestamps to the clock of rank 0
+std::optional<std::string>
+convert_trace(FILE* _in, FILE* _out)
+{
+    auto _packet    = std::vector<uint8_t>{};
+    auto _converted = std::vector<uint8_t>{};
+    auto _header    = std::vector<uint8_t>{};
+    auto _tag       = uint64_t{ 0 };
+    while(read_varint(_in, _tag))
+    {
+        // every entry of a trace is a length-delimited packet (field 1)
+        auto _len = uint64_t{ 0 };
+        if((_tag & 0x7) != 2 || !read_varint(_in, _len))
+            return std::string{ "unexpected trace entry" };
+
+        _packet.resize(_len);
+        if(_len > 0 && fread(_packet.data(), 1, _len, _in) != _len)
+            return std::string{ "truncated trace packet" };
+
+        const auto& _data = ((_tag >> 3) == 1 && convert_packet(_packet, _converted))
+                                ? _converted
+                                : _packet;
+
+        _header.clear();
+        write_varint(_header, _tag);
+        write_varint(_header, _data.size());
+        if(fwrite(_header.data(), 1, _header.size(), _out) != _header.size() ||
+           fwrite(_data.data(), 1, _data.size(), _out) != _data.size())
+            return std::string{ "fwrite failed: " } + strerror(errno);
+    }
+    return std::optional<std::string>{};
+}
+
+// writes the temporary file (if any) followed by the data remaining in the session
+// into the given file with the timestamps converted to the clock of rank 0. Sets the
+// size of the output file
+std::optional<std::string>
+write_converted_trace(const std::string& _filename, const std::string& _tmp_name,
+                      std::vector<char>& _session_data, size_t& _size)
+{
+    FILE* _out = fopen(_filename.c_str(), "wb");
+    if(!_out) return JOIN("", "could not open '", _filename, "'");
+
+    auto _err = std::optional<std::string>{};
+    if(!_tmp_name.empty())
+    {
+        FILE* _in = fopen(_tmp_name.c_str(), "rb");
+        if(!_in) _err = JOIN("", "could not read temp trace file '", _tmp_name, "'");
+        if(_in) _err = convert_trace(_in, _out);
+        if(_in) fclose(_in);
+    }
+
+    if(!_err && !_session_data.empty())
+    {
+        FILE* _in = fmemopen(_session_data.data(), _session_data.size(), "rb");
+        if(!_in) _err = std::string{ "fmemopen failed" };
+        if(_in) _err = convert_trace(_in, _out);
+        if(_in) fclose(_in);
+    }
+
+    if(fclose(_out) != 0 && !_err) _err = std::string{ "fclose failed" };
+    _size = get_file_size(_filename);
+    return _err;
+}
+
+// the clock offsets of this rank are stored in the metadata
+void
+add_clock_sync_metadata(tim::manager* _manager)
+{
+    if(!_manager) return;
+
+    auto _timestamps = std::vector<uint64_t>{};
+    auto _offsets    = std::vector<int64_t>{};
+    auto _rtts       = std::vector<uint64_t>{};
+    for(const auto& itr : clock_sync::get_samples())
+    {
+        _timestamps.emplace_back(itr.timestamp);
+        _offsets.emplace_back(itr.offset);
+        _rtts.emplace_back(itr.rtt);
+    }
+
+    _manager->add_metadata([_timestamps, _offsets, _rtts](auto& ar) {
+        ar(tim::cereal::make_nvp("clock_sync_timestamps", _timestamps),
+           tim::cereal::make_nvp("clock_sync_offsets", _offsets),
+           tim::cereal::make_nvp("clock_sync_round_trips", _rtts));
+    });
+}
+
+// writes the trace of every rank in the communicator into a single file via MPI-IO.
+// Each rank obtains its byte offset from an exclusive prefix sum of the per-rank
+// sizes and writes its data with bounded, independent writes. Concatenated perfetto
+// traces are valid traces since a trace is simply a sequence of packets. When
+// OMNITRACE_NODE_COUNT is set, the ranks on each node write a combined file for
+// the node. The filename is set to the name of the file written (if any)
+template <typename FuncT>
+std::optional<std::string>
+write_combined_trace(std::string& _filename, const std::string& _tmp_name,
+                     size_t _tmp_size, const std::vector<char>& _session_data,
+                     FuncT&& _report_size)
+{
+    auto _comm = MPI_Comm{ MPI_COMM_WORLD };
+    if(settings::node_count() > 0)
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL,
+                            &_comm);
+
+    auto _free_comm = [&_comm]() {
+        if(_comm != MPI_COMM_WORLD) MPI_Comm_free(&_comm);
+    };
+
+    int _rank = 0;
+    MPI_Comm_rank(_comm, &_rank);
+
+    unsigned long long _local_size = _tmp_size + _session_data.size();
+    unsigned long long _offset     = 0;
+    unsigned long long _total_size = 0;
+    MPI_Exscan(&_local_size, &_offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, _comm);
+    MPI_Allreduce(&_local_size, &_total_size, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                  _comm);
+    if(_rank == 0) _offset = 0;  // MPI_Exscan leaves rank zero undefined
+
+    if(_total_size == 0)
+    {
+        _free_comm();
+        if(_rank == 0)
+        {
+            OMNITRACE_VERBOSE(
+                0, "perfetto trace data is empty. File '%s' will not be written...\n",
+                _filename.c_str());
+        }
+        _filename.clear();
+        return std::optional<std::string>{};
+    }
+
+    // the root rank creates any missing directories and provides the filename
+    auto _name_len = static_cast<int>(_filename.length());
+    if(_rank == 0)
+    {
+        std::ofstream ofs{};
+        if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+            _name_len = -1;
+        ofs.close();
+        _report_size(_total_size);
+    }
+
+    MPI_Bcast(&_name_len, 1, MPI_INT, 0, _comm);
+    if(_name_len < 0)
+    {
+        _free_comm();
+        return std::optional<std::string>{ "root rank could not create " + _filename };
+    }
+
+    auto _root_filename = std::string(_name_len, '\0');
+    if(_rank == 0) _root_filename = _filename;
+    MPI_Bcast(_root_filename.data(), _name_len, MPI_CHAR, 0, _comm);
+
+    auto _fh = MPI_File{};
+    if(MPI_File_open(_comm, _root_filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                     MPI_INFO_NULL, &_fh) != MPI_SUCCESS)
+    {
+        _free_comm();
+        return std::optional<std::string>{ "MPI_File_open failed" };
+    }
+
+    // remove any stale data beyond the combined size
+    MPI_File_set_size(_fh, static_cast<MPI_Offset>(_total_size));
+
+    constexpr size_t chunk_size = 8 * units::MB;
+    auto             _err       = std::optional<std::string>{};
+    auto             _write     = [&](const char* _data, size_t _n) {
+        while(_n > 0 && !_err)
+        {
+            auto _count  = static_cast<int>(std::min(_n, chunk_size));
+            auto _status = MPI_Status{};
+            if(MPI_File_write_at(_fh, static_cast<MPI_Offset>(_offset), _data, _count,
+                                 MPI_BYTE, &_status) != MPI_SUCCESS)
+                _err = "MPI_File_write_at failed";
+            _offset += _count;
+            _data += _count;
+            _n -= _count;
+        }
+    };
+
+    if(_tmp_size > 0)
+    {
+        auto  _buffer = std::vector<char>(std::min(_tmp_size, chunk_size));
+        FILE* _fdata  = fopen(_tmp_name.c_str(), "rb");
+        if(!_fdata) _err = JOIN("", "could not read temp trace file '", _tmp_name, "'");
+        while(_fdata && !_err)
+        {
+            auto _nread = fread(_buffer.data(), sizeof(char), _buffer.size(), _fdata);
+            if(_nread == 0) break;
+            _write(_buffer.data(), _nread);
+        }
+        if(_fdata) fclose(_fdata);
+    }
+
+    if(!_session_data.empty()) _write(_session_data.data(), _session_data.size());
+
+    MPI_File_close(&_fh);
+
+    // only the root rank reports the output file
+    if(_rank != 0) _filename.clear();
+
+    _free_comm();
+    return _err;
+}
+#endif
 }  // namespace
 
 void
@@ -80,10 +672,47 @@ setup()
         config::get_perfetto_fill_policy() == "discard"
             ? ::perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_DISCARD
             : ::perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_RING_BUFFER;
+
+    // the snapshots are clones of the session found via its unique name and the
+    // buffer must retain the most recent history, not the oldest
+    if(config::get_perfetto_snapshot())
+    {
+        if(is_system_backend())
+        {
+            OMNITRACE_VERBOSE_F(0, "OMNITRACE_PERFETTO_SNAPSHOT requires the inprocess "
+                                   "perfetto backend and will be ignored\n");
+        }
+        else
+        {
+            _policy =
+                ::perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_RING_BUFFER;
+            cfg.set_unique_session_name(JOIN('-', "omnitrace", process::get_id()));
+        }
+    }
+
+    // the adaptive mode starts with the whole memory budget for the calibration (the
+    // pages of the buffer are only resident once they are written)
+    auto& _adaptive   = get_adaptive_state();
+    _adaptive.enabled = config::get_perfetto_buffer_adaptive() && !is_system_backend() &&
+                        !config::get_perfetto_snapshot();
+    if(_adaptive.enabled)
+    {
+        _adaptive.resizable = config::get_use_tmp_files();
+        _adaptive.buffer_kb =
+            get_adaptive_buffer_size(config::get_perfetto_memory_budget());
+        buffer_size = _adaptive.buffer_kb;
+        if(_adaptive.resizable) cfg.set_file_write_period_ms(_adaptive.period_ms);
+    }
+
     auto* buffer_config = cfg.add_buffers();
     buffer_config->set_size_kb(buffer_size);
     buffer_config->set_fill_policy(_policy);
 
+    // the packets are deflated by the service when the trace is read, which is a
+    // no-op unless the perfetto SDK was built with zlib
+    if(config::get_perfetto_compress_packets())
+        cfg.set_compression_type(::perfetto::TraceConfig::COMPRESSION_TYPE_DEFLATE);
+
     for(const auto& itr : config::get_disabled_categories())
     {
         OMNITRACE_VERBOSE_F(1, "Disabling perfetto track event category: %s\n",
@@ -104,18 +733,18 @@ setup()
     ::perfetto::TrackEvent::Register();
 }
 
+namespace
+{
 void
-start()
+start_session()
 {
-    if(is_system_backend()) return;
-
     auto& tracing_session = get_session();
 
-    if(!tracing_session) tracing_session = ::perfetto::Tracing::NewTrace();
-
     tracing_session = ::perfetto::Tracing::NewTrace();
+    // in snapshot mode the data must stay in the ring buffer instead of being
+    // periodically drained into the temporary file
     auto& _tmp_file = get_perfetto_tmp_file();
-    if(config::get_use_tmp_files())
+    if(config::get_use_tmp_files() && !config::get_perfetto_snapshot())
     {
         if(!_tmp_file)
         {
@@ -136,24 +765,197 @@ start()
     tracing_session->StartBlocking();
 }
 
+// commits the pending events, accumulates the buffer statistics, and stops the session
+void
+stop_session()
+{
+    auto& tracing_session = get_session();
+    if(!tracing_session) return;
+
+    // Make sure the last event is closed
+    OMNITRACE_VERBOSE(2, "Flushing the perfetto trace data...\n");
+    ::perfetto::TrackEvent::Flush();
+    tracing_session->FlushBlocking();
+
+    if(auto _stats = get_buffer_stats(*tracing_session); _stats)
+        get_total_buffer_stats() += *_stats;
+
+    OMNITRACE_VERBOSE(2, "Stopping the perfetto trace session (blocking)...\n");
+    tracing_session->StopBlocking();
+}
+
+void
+run_adaptive()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.perfetto");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    using clock_type = std::chrono::steady_clock;
+
+    auto& _state  = get_adaptive_state();
+    auto  _budget = get_adaptive_buffer_size(config::get_perfetto_memory_budget());
+    auto  _window = std::max(config::get_perfetto_buffer_adaptive_window(), 0.1);
+    auto  _high   = std::clamp(config::get_perfetto_buffer_high_watermark(), 0.05, 0.95);
+    auto  _beg    = clock_type::now();
+
+    bool _calibrated = false;
+    bool _warned     = false;
+
+    auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+    while(_state.running)
+    {
+        _state.cv.wait_for(_lk, std::chrono::milliseconds{ 100 });
+        if(!_state.running) break;
+
+        auto& _session = get_session();
+        auto  _stats   = (_session) ? get_buffer_stats(*_session) : std::nullopt;
+        if(!_stats || _stats->buffer_size == 0) continue;
+
+        auto _elapsed   = std::chrono::duration<double>{ clock_type::now() - _beg };
+        auto _buffer_kb = _state.buffer_kb;
+        auto _period_ms = _state.period_ms;
+
+        if(!_calibrated && _elapsed.count() >= _window)
+        {
+            _calibrated = true;
+            auto _rate  = _stats->bytes_written / _elapsed.count();
+            OMNITRACE_VERBOSE(1, "[perfetto] measured a trace rate of %.3f MB/sec...\n",
+                              _rate / units::MB);
+
+            // only shrink when the difference is significant
+            auto _need = _rate * (_period_ms / 1000.0) / _high / units::KB;
+            auto _kb   = get_adaptive_buffer_size(_need);
+            if(_state.resizable && 2 * _kb <= _buffer_kb) _buffer_kb = _kb;
+        }
+        else if(_stats->pending() > _high * _stats->buffer_size)
+        {
+            ++_state.crossings;
+            if(_state.resizable)
+            {
+                if(_buffer_kb < _budget)
+                    _buffer_kb = get_adaptive_buffer_size(2.0 * _buffer_kb);
+                else
+                    _period_ms = std::max(_period_ms / 2, adaptive_state::min_period_ms);
+            }
+            else if(!_warned)
+            {
+                _warned = true;
+                OMNITRACE_VERBOSE(0,
+                                  "[perfetto] %.0f%% of the buffer is in use and events "
+                                  "will be dropped when it is full. Enable "
+                                  "OMNITRACE_USE_TEMPORARY_FILES so the buffer can be "
+                                  "drained or increase "
+                                  "OMNITRACE_PERFETTO_BUFFER_SIZE_KB\n",
+                                  100.0 * _stats->pending() / _stats->buffer_size);
+            }
+        }
+
+        if(_buffer_kb != _state.buffer_kb || _period_ms != _state.period_ms)
+        {
+            OMNITRACE_VERBOSE(1,
+                              "[perfetto] resizing the buffer from %zu KB to %zu KB "
+                              "(drained every %u msec)...\n",
+                              _state.buffer_kb, _buffer_kb, _period_ms);
+            _state.buffer_kb = _buffer_kb;
+            _state.period_ms = _period_ms;
+            ++_state.restarts;
+            set_buffer_config(_buffer_kb, _period_ms);
+            stop_session();
+            start_session();
+        }
+    }
+}
+
+void
+start_adaptive()
+{
+    auto& _state = get_adaptive_state();
+    if(!_state.enabled || _state.thread) return;
+
+    _state.running = true;
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    _state.thread = std::make_unique<std::thread>(&run_adaptive);
+}
+
+void
+stop_adaptive()
+{
+    auto& _state = get_adaptive_state();
+    if(!_state.thread) return;
+
+    {
+        auto _lk       = std::unique_lock<std::mutex>{ _state.mutex };
+        _state.running = false;
+    }
+    _state.cv.notify_all();
+    _state.thread->join();
+    _state.thread.reset();
+}
+
+void
+report_buffer_stats()
+{
+    const auto& _v     = get_total_buffer_stats();
+    const auto& _state = get_adaptive_state();
+
+    // overwriting the oldest data is the intent of the flight-recorder mode
+    auto _overwritten = (config::get_perfetto_snapshot()) ? 0 : _v.chunks_overwritten;
+    auto _lost =
+        (_v.chunks_discarded + _overwritten + _v.patches_failed + _v.abi_violations) > 0;
+
+    OMNITRACE_VERBOSE((_lost) ? 0 : 1,
+                      "[perfetto] %.3f MB written into the buffer, %lu chunks discarded, "
+                      "%lu chunks overwritten (%.3f MB), %lu failed patches, %lu ABI "
+                      "violations%s\n",
+                      static_cast<double>(_v.bytes_written) / units::MB,
+                      static_cast<unsigned long>(_v.chunks_discarded),
+                      static_cast<unsigned long>(_v.chunks_overwritten),
+                      static_cast<double>(_v.bytes_overwritten) / units::MB,
+                      static_cast<unsigned long>(_v.patches_failed),
+                      static_cast<unsigned long>(_v.abi_violations),
+                      (_lost) ? ". Trace events were dropped, increase "
+                                "OMNITRACE_PERFETTO_BUFFER_SIZE_KB or enable "
+                                "OMNITRACE_PERFETTO_BUFFER_ADAPTIVE"
+                              : "");
+
+    if(_state.enabled)
+    {
+        OMNITRACE_VERBOSE(1,
+                          "[perfetto] adaptive buffer: %zu KB (drained every %u msec), "
+                          "%zu resizes, %zu high watermark crossings\n",
+                          _state.buffer_kb, _state.period_ms, _state.restarts,
+                          _state.crossings);
+    }
+}
+}  // namespace
+
+void
+start()
+{
+    if(is_system_backend()) return;
+
+    start_session();
+    start_adaptive();
+}
+
 void
 stop()
 {
     if(is_system_backend()) return;
 
+    stop_adaptive();
+
     auto& tracing_session = get_perfetto_session();
 
     OMNITRACE_CI_THROW(tracing_session == nullptr, "Null pointer to the tracing session");
 
     if(tracing_session)
     {
-        // Make sure the last event is closed
-        OMNITRACE_VERBOSE(2, "Flushing the perfetto trace data...\n");
-        ::perfetto::TrackEvent::Flush();
-        tracing_session->FlushBlocking();
-
-        OMNITRACE_VERBOSE(2, "Stopping the perfetto trace session (blocking)...\n");
-        tracing_session->StopBlocking();
+        stop_session();
+        report_buffer_stats();
     }
 }
 
@@ -167,112 +969,310 @@ post_process(tim::manager* _timemory_manager, bool& _perfetto_output_error)
     auto& tracing_session = get_perfetto_session();
     if(!tracing_session) return;
 
-    auto _get_session_data = [&tracing_session]() {
-        auto _data     = char_vec_t{};
-        auto _tmp_file = get_perfetto_tmp_file();
-        if(_tmp_file && *_tmp_file)
+    auto _codec = get_compression();
+    auto _filename =
+        get_compressed_filename(config::get_perfetto_output_filename(), _codec);
+    auto _fom      = operation::file_output_message<tim::project::omnitrace>{};
+
+    auto _report_size = [&_fom, &_filename](size_t _size) {
+        if(config::get_verbose() >= 0)
+            _fom(_filename, std::string{ "perfetto" },
+                 " (%.2f KB / %.2f MB / %.2f GB)... ",
+                 static_cast<double>(_size) / units::KB,
+                 static_cast<double>(_size) / units::MB,
+                 static_cast<double>(_size) / units::GB);
+    };
+
+    auto _report_empty = [&_filename]() {
+        if(dmp::rank() == 0)
         {
-            _tmp_file->close();
-            FILE* _fdata = fopen(_tmp_file->filename.c_str(), "rb");
+            OMNITRACE_VERBOSE(
+                0, "perfetto trace data is empty. File '%s' will not be written...\n",
+                _filename.c_str());
+        }
+    };
 
-            if(!_fdata)
-            {
-                OMNITRACE_VERBOSE(
-                    -1, "Error! perfetto temp trace file '%s' could not be read",
-                    _tmp_file->filename.c_str());
-                return char_vec_t{ tracing_session->ReadTraceBlocking() };
-            }
+    auto _report_compressed = [&_fom, _codec](size_t _in, size_t _out) {
+        if(config::get_verbose() >= 0 && _out > 0)
+            _fom.append("%s compressed to %.2f MB (%.1fx)... ",
+                        compression::get_name(_codec),
+                        static_cast<double>(_out) / units::MB,
+                        static_cast<double>(_in) / _out);
+    };
 
-            fseek(_fdata, 0, SEEK_END);
-            size_t _fnum_elem = ftell(_fdata);
-            fseek(_fdata, 0, SEEK_SET);  // same as rewind(f);
+    auto _report_done = [&_fom, &_filename, _timemory_manager]() {
+        if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+        if(_timemory_manager)
+            _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
+    };
 
-            _data.resize(_fnum_elem + 1);
-            auto _fnum_read = fread(_data.data(), sizeof(char), _fnum_elem, _fdata);
-            fclose(_fdata);
+    auto _report_error = [&_fom, &_filename, &_perfetto_output_error]() {
+        _fom.append("Error opening '%s'...", _filename.c_str());
+        _perfetto_output_error = true;
+    };
 
-            OMNITRACE_CI_THROW(
-                _fnum_read != _fnum_elem,
-                "Error! read %zu elements from perfetto trace file '%s'. Expected %zu\n",
-                _fnum_read, _tmp_file->filename.c_str(), _fnum_elem);
+    auto _remove_tmp_file = []() {
+        auto& _tmp_file = get_perfetto_tmp_file();
+        if(_tmp_file)
+        {
+            _tmp_file->close();
+            _tmp_file->remove();
+            _tmp_file.reset();
         }
-
-        return utility::combine(_data,
-                                char_vec_t{ tracing_session->ReadTraceBlocking() });
     };
 
-    auto trace_data = char_vec_t{};
+    // the bulk of the trace is in the temporary file (when enabled) and is moved or
+    // copied into place in bounded chunks. Only the data remaining in the tracing
+    // session is held in memory
+    auto _tmp_file = get_perfetto_tmp_file();
+    auto _tmp_size = size_t{ 0 };
+    if(_tmp_file && *_tmp_file)
+    {
+        _tmp_file->close();
+        _tmp_size = get_file_size(_tmp_file->filename);
+    }
+
+    auto _session_data = char_vec_t{ tracing_session->ReadTraceBlocking() };
+    auto _total_size   = _tmp_size + _session_data.size();
+
 #if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
-    if(get_perfetto_combined_traces())
+    if(get_perfetto_combined_traces() && mpi_is_active())
     {
-        using perfetto_mpi_get_t = tim::operation::finalize::mpi_get<char_vec_t, true>;
+        // every rank writes its own packets directly into the shared output file
+        // at an offset computed from the preceding ranks so no rank ever holds
+        // more than its own trace
+        auto _tmp_name = (_tmp_size > 0) ? _tmp_file->filename : std::string{};
+
+        // the final estimate of the clock offsets. The timestamps of the trace are
+        // converted to the clock of rank 0 in a scratch file. If the conversion
+        // fails, the trace is written unconverted
+        auto _converted = std::string{};
+        if(clock_sync::is_enabled() && clock_sync::synchronize())
+        {
+            add_clock_sync_metadata(_timemory_manager);
+            if(clock_sync::has_correction() && _total_size > 0)
+            {
+                auto _size = size_t{ 0 };
+                _converted = JOIN("", _filename, '.', process::get_id(), ".clock");
+                if(auto _err = write_converted_trace(_converted, _tmp_name,
+                                                     _session_data, _size);
+                   _err)
+                {
+                    OMNITRACE_VERBOSE(-1,
+                                      "Warning! converting the timestamps of the "
+                                      "perfetto trace failed: %s\n",
+                                      _err->c_str());
+                    ::remove(_converted.c_str());
+                    _converted.clear();
+                }
+                else
+                {
+                    _tmp_name = _converted;
+                    _tmp_size = _size;
+                    _session_data.clear();
+                }
+            }
+        }
 
-        auto _trace_data = _get_session_data();
-        auto _rank_data  = std::vector<char_vec_t>{};
-        auto _combine    = [](char_vec_t& _dst, const char_vec_t& _src) -> char_vec_t& {
-            _dst.reserve(_dst.size() + _src.size());
-            for(auto&& itr : _src)
-                _dst.emplace_back(itr);
-            return _dst;
-        };
+        // each rank compresses its own trace into a scratch file first so that the
+        // offsets are computed from the compressed sizes. The gzip members or zstd
+        // frames of the ranks are concatenated into a valid compressed trace. A rank
+        // which fails to compress its trace contributes no data
+        auto _scratch = std::string{};
+        if(_codec != compression::codec::none && _total_size > 0)
+        {
+            _scratch = JOIN("", _filename, '.', process::get_id(), ".part");
+            if(auto _err = write_compressed_trace(_scratch, _tmp_name, _session_data,
+                                                  _tmp_size);
+               _err)
+            {
+                OMNITRACE_VERBOSE(-1,
+                                  "Error! compressing perfetto trace '%s' failed: %s\n",
+                                  _scratch.c_str(), _err->c_str());
+                _perfetto_output_error = true;
+                _tmp_size              = 0;
+            }
+            _tmp_name = (_tmp_size > 0) ? _scratch : std::string{};
+            _session_data.clear();
+        }
 
-        perfetto_mpi_get_t{ get_perfetto_combined_traces(),
-                            settings::node_count() }(_rank_data, _trace_data, _combine);
-        for(auto& itr : _rank_data)
-            trace_data =
-                (trace_data.empty()) ? std::move(itr) : _combine(trace_data, itr);
+        auto _combined_err = write_combined_trace(_filename, _tmp_name, _tmp_size,
+                                                  _session_data, _report_size);
+        if(!_scratch.empty()) ::remove(_scratch.c_str());
+        if(!_converted.empty()) ::remove(_converted.c_str());
+        if(_combined_err)
+        {
+            OMNITRACE_VERBOSE(-1,
+                              "Error! writing combined perfetto trace '%s' failed: %s\n",
+                              _filename.c_str(), _combined_err->c_str());
+            _perfetto_output_error = true;
+        }
+        else if(!_filename.empty())
+        {
+            _report_done();
+        }
+        _remove_tmp_file();
+        return;
     }
-    else
+#endif
+
+    if(_total_size == 0)
     {
-        trace_data = _get_session_data();
+        _report_empty();
+        _remove_tmp_file();
+        return;
     }
-#else
-    trace_data = _get_session_data();
-#endif
 
-    auto _filename = config::get_perfetto_output_filename();
-    if(!trace_data.empty())
+    _report_size(_total_size);
+
+    // opening the output file creates any missing directories
+    std::ofstream ofs{};
+    if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
     {
-        operation::file_output_message<tim::project::omnitrace> _fom{};
-        // Write the trace into a file.
-        if(config::get_verbose() >= 0)
-            _fom(_filename, std::string{ "perfetto" },
-                 " (%.2f KB / %.2f MB / %.2f GB)... ",
-                 static_cast<double>(trace_data.size()) / units::KB,
-                 static_cast<double>(trace_data.size()) / units::MB,
-                 static_cast<double>(trace_data.size()) / units::GB);
-        std::ofstream ofs{};
-        if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+        _report_error();
+        _remove_tmp_file();
+        return;
+    }
+    ofs.close();
+
+    if(_codec != compression::codec::none)
+    {
+        auto _tmp_name  = (_tmp_size > 0) ? _tmp_file->filename : std::string{};
+        auto _comp_size = size_t{ 0 };
+        if(auto _err =
+               write_compressed_trace(_filename, _tmp_name, _session_data, _comp_size);
+           _err)
         {
-            _fom.append("Error opening '%s'...", _filename.c_str());
+            OMNITRACE_VERBOSE(-1, "Error! compressing perfetto trace '%s' failed: %s\n",
+                              _filename.c_str(), _err->c_str());
             _perfetto_output_error = true;
         }
         else
         {
-            // Write the trace into a file.
-            ofs.write(&trace_data[0], trace_data.size());
-            if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
-            if(_timemory_manager)
-                _timemory_manager->add_file_output("protobuf", "perfetto", _filename);
+            _report_compressed(_total_size, _comp_size);
+            _report_done();
         }
-        ofs.close();
+        _remove_tmp_file();
+        return;
     }
-    else if(dmp::rank() == 0)
+
+    if(_tmp_size > 0 && !move_file(_tmp_file->filename, _filename))
     {
-        OMNITRACE_VERBOSE(
-            0, "perfetto trace data is empty. File '%s' will not be written...\n",
-            _filename.c_str());
+        OMNITRACE_VERBOSE(-1,
+                          "Error! perfetto temp trace file '%s' could not be moved or "
+                          "copied to '%s'",
+                          _tmp_file->filename.c_str(), _filename.c_str());
+        _perfetto_output_error = true;
+        _remove_tmp_file();
+        return;
     }
 
-    auto& _tmp_file = get_perfetto_tmp_file();
-    if(_tmp_file)
+    if(!_session_data.empty())
     {
-        _tmp_file->close();
-        _tmp_file->remove();
-        _tmp_file.reset();
+        auto _mode = std::ios::out | std::ios::binary |
+                     ((_tmp_size > 0) ? std::ios::app : std::ios::trunc);
+        if(!filepath::open(ofs, _filename, _mode))
+        {
+            _report_error();
+            _remove_tmp_file();
+            return;
+        }
+        ofs.write(_session_data.data(), _session_data.size());
+        ofs.close();
     }
+
+    _report_done();
+    _remove_tmp_file();
 }
 
+size_t
+snapshot(size_t _index)
+{
+    if(is_system_backend()) return 0;
+
+    auto& tracing_session = get_perfetto_session();
+    if(!tracing_session) return 0;
+
+    auto _filename = config::get_perfetto_output_filename();
+    auto _pos_ext  = _filename.find_last_of('.');
+    auto _pos_dir  = _filename.find_last_of('/');
+    auto _suffix   = JOIN("", "-snapshot-", _index);
+    if(_pos_ext != std::string::npos &&
+       (_pos_dir == std::string::npos || _pos_ext > _pos_dir))
+        _filename.insert(_pos_ext, _suffix);
+    else
+        _filename += _suffix;
+    _filename = get_compressed_filename(_filename, get_compression());
+
+    // commit the chunks of the instrumented threads to the buffer before cloning
+    ::perfetto::TrackEvent::Flush();
+    tracing_session->FlushBlocking();
+
+    // the callback may run after a timeout so the promise is shared with it
+    using result_t = std::optional<std::string>;
+    auto _promise  = std::make_shared<std::promise<result_t>>();
+    auto _future   = _promise->get_future();
+    auto _clone    = ::perfetto::Tracing::NewTrace(::perfetto::kInProcessBackend);
+    auto _args     = ::perfetto::TracingSession::CloneTraceArgs{};
+
+    _args.unique_session_name = get_config().unique_session_name();
+    _clone->CloneTrace(
+        _args, [_promise](::perfetto::TracingSession::CloneTraceCallbackArgs _v) {
+            _promise->set_value((_v.success) ? result_t{} : result_t{ _v.error });
+        });
+
+    if(_future.wait_for(std::chrono::seconds{ 30 }) != std::future_status::ready)
+    {
+        OMNITRACE_VERBOSE(0, "[perfetto] snapshot %zu timed out cloning the session\n",
+                          _index);
+        return 0;
+    }
+
+    if(auto _err = _future.get(); _err)
+    {
+        OMNITRACE_VERBOSE(0, "[perfetto] snapshot %zu failed: %s\n", _index,
+                          _err->c_str());
+        return 0;
+    }
+
+    auto _data = _clone->ReadTraceBlocking();
+    _clone.reset();
+    if(_data.empty()) return 0;
+
+    auto _fom = operation::file_output_message<tim::project::omnitrace>{};
+    if(config::get_verbose() >= 0)
+        _fom(_filename, std::string{ "perfetto snapshot" }, " (%.2f KB / %.2f MB)... ",
+             static_cast<double>(_data.size()) / units::KB,
+             static_cast<double>(_data.size()) / units::MB);
+
+    std::ofstream ofs{};
+    if(!filepath::open(ofs, _filename, std::ios::out | std::ios::binary))
+    {
+        _fom.append("Error opening '%s'...", _filename.c_str());
+        return 0;
+    }
+
+    if(get_compression() == compression::codec::none)
+    {
+        ofs.write(_data.data(), _data.size());
+        ofs.close();
+    }
+    else
+    {
+        ofs.close();
+        auto _size = size_t{ 0 };
+        if(auto _err = write_compressed_trace(_filename, std::string{}, _data, _size);
+           _err)
+        {
+            _fom.append("Error compressing '%s': %s...", _filename.c_str(),
+                        _err->c_str());
+            return 0;
+        }
+    }
+    if(config::get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+
+    return _data.size();
+}
 }  // namespace perfetto
 
 std::unique_ptr<::perfetto::TracingSession>&
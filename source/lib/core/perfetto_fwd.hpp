@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <cstddef>
+
 namespace tim
 {
 class manager;
@@ -42,5 +44,12 @@ stop();
 
 void
 post_process(tim::manager*, bool&);
+
+// clones the in-process session and writes the contents of the ring buffer to
+// <perfetto-file>-snapshot-<index>.<ext> while tracing continues. Returns the number
+// of bytes written. Blocks until the clone is read so it must not be invoked by an
+// instrumented thread
+size_t
+snapshot(size_t _index);
 }  // namespace perfetto
 }  // namespace omnitrace
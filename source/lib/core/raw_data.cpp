@@ -0,0 +1,382 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "raw_data.hpp"
+#include "exception.hpp"
+
+#include <climits>
+#include <cstring>
+#include <elf.h>
+#include <fstream>
+#include <istream>
+#include <link.h>
+#include <ostream>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace raw_data
+{
+namespace
+{
+// layout of the container. Every integer is a varint, the addresses and timestamps
+// are zigzag-encoded deltas against the previous value of the same kind:
+//
+//      magic, version, pid, rank, command
+//      objects: count, { path, build-id, load bias, segments: count, { begin, end } }
+//      threads: count, { index, system tid, start, stop,
+//                        stacks:  count, { frames: count, { address } },
+//                        samples: count, { begin, end - begin, stack } }
+constexpr uint64_t magic   = 0x4f4d5257;  // "OMRW"
+constexpr uint64_t version = 1;
+
+uint64_t
+zigzag(int64_t _v)
+{
+    return (static_cast<uint64_t>(_v) << 1) ^ static_cast<uint64_t>(_v >> 63);
+}
+
+int64_t
+unzigzag(uint64_t _v)
+{
+    return static_cast<int64_t>((_v >> 1) ^ (~(_v & 1) + 1));
+}
+
+struct writer
+{
+    void put(uint64_t _v)
+    {
+        while(_v >= 0x80)
+        {
+            os.put(static_cast<char>((_v & 0x7f) | 0x80));
+            _v >>= 7;
+        }
+        os.put(static_cast<char>(_v));
+    }
+
+    void put_delta(uint64_t _v, uint64_t& _last)
+    {
+        put(zigzag(static_cast<int64_t>(_v - _last)));
+        _last = _v;
+    }
+
+    void put(const std::string& _v)
+    {
+        put(_v.length());
+        os.write(_v.data(), static_cast<std::streamsize>(_v.length()));
+    }
+
+    std::ostream& os;
+};
+
+struct reader
+{
+    uint64_t get()
+    {
+        uint64_t _v = 0;
+        for(int _shift = 0; _shift < 64; _shift += 7)
+        {
+            auto _byte = is.get();
+            if(_byte == std::istream::traits_type::eof()) break;
+            _v |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+            if((_byte & 0x80) == 0) return _v;
+        }
+        throw exception<std::runtime_error>("truncated raw data");
+    }
+
+    uint64_t get_delta(uint64_t& _last)
+    {
+        _last += static_cast<uint64_t>(unzigzag(get()));
+        return _last;
+    }
+
+    // the counts are bounded by the remaining data to reject corrupted containers
+    // before allocating
+    size_t get_count()
+    {
+        auto _v = get();
+        if(_v > remaining())
+            throw exception<std::runtime_error>("invalid count in raw data");
+        return _v;
+    }
+
+    std::string get_string()
+    {
+        auto _v = std::string(get_count(), '\0');
+        is.read(_v.data(), static_cast<std::streamsize>(_v.length()));
+        if(!is) throw exception<std::runtime_error>("truncated raw data");
+        return _v;
+    }
+
+    size_t remaining()
+    {
+        if(end < 0)
+        {
+            auto _pos = is.tellg();
+            is.seekg(0, std::ios::end);
+            end = is.tellg();
+            is.seekg(_pos);
+        }
+        return static_cast<size_t>(end - is.tellg());
+    }
+
+    std::istream&  is;
+    std::streamoff end = -1;
+};
+
+std::string
+to_hex(const unsigned char* _data, size_t _n)
+{
+    constexpr const char* _digits = "0123456789abcdef";
+
+    auto _v = std::string{};
+    _v.reserve(2 * _n);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        _v += _digits[_data[i] >> 4];
+        _v += _digits[_data[i] & 0xf];
+    }
+    return _v;
+}
+
+// scans the notes of a PT_NOTE segment for the GNU build-id
+std::string
+find_build_id(const char* _beg, const char* _end)
+{
+    auto _align = [](size_t _v) { return (_v + 3) & ~size_t{ 3 }; };
+    while(_beg + sizeof(ElfW(Nhdr)) <= _end)
+    {
+        const auto* _hdr  = reinterpret_cast<const ElfW(Nhdr)*>(_beg);
+        const auto* _name = _beg + sizeof(ElfW(Nhdr));
+        const auto* _desc = _name + _align(_hdr->n_namesz);
+        if(_desc + _hdr->n_descsz > _end) break;
+
+        if(_hdr->n_type == NT_GNU_BUILD_ID && _hdr->n_namesz == 4 &&
+           std::memcmp(_name, "GNU", 4) == 0)
+            return to_hex(reinterpret_cast<const unsigned char*>(_desc), _hdr->n_descsz);
+
+        _beg = _desc + _align(_hdr->n_descsz);
+    }
+    return std::string{};
+}
+
+std::string
+get_exe_path()
+{
+    char _buf[PATH_MAX];
+    auto _n = readlink("/proc/self/exe", _buf, sizeof(_buf) - 1);
+    return (_n > 0) ? std::string{ _buf, static_cast<size_t>(_n) } : std::string{};
+}
+}  // namespace
+
+bool
+object::contains(uintptr_t _addr) const
+{
+    for(const auto& itr : segments)
+        if(_addr >= itr.first && _addr < itr.second) return true;
+    return false;
+}
+
+std::vector<object>
+get_loaded_objects()
+{
+    auto _v = std::vector<object>{};
+    dl_iterate_phdr(
+        [](dl_phdr_info* _info, size_t, void* _data) {
+            auto* _objs = static_cast<std::vector<object>*>(_data);
+            auto  _obj  = object{};
+
+            // the executable is the first object and has no name
+            if(_info->dlpi_name && strlen(_info->dlpi_name) > 0)
+                _obj.path = _info->dlpi_name;
+            else if(_objs->empty())
+                _obj.path = get_exe_path();
+
+            if(_obj.path.empty()) return 0;
+
+            _obj.load_bias = _info->dlpi_addr;
+            for(ElfW(Half) i = 0; i < _info->dlpi_phnum; ++i)
+            {
+                const auto& _phdr = _info->dlpi_phdr[i];
+                auto        _beg  = _info->dlpi_addr + _phdr.p_vaddr;
+                if(_phdr.p_type == PT_LOAD)
+                    _obj.segments.emplace_back(_beg, _beg + _phdr.p_memsz);
+                else if(_phdr.p_type == PT_NOTE && _obj.build_id.empty())
+                    _obj.build_id =
+                        find_build_id(reinterpret_cast<const char*>(_beg),
+                                      reinterpret_cast<const char*>(_beg) +
+                                          _phdr.p_memsz);
+            }
+
+            _objs->emplace_back(std::move(_obj));
+            return 0;
+        },
+        &_v);
+    return _v;
+}
+
+std::string
+read_build_id(const std::string& _path)
+{
+    auto _ifs = std::ifstream{ _path, std::ios::binary };
+    if(!_ifs) return std::string{};
+
+    auto _ehdr = ElfW(Ehdr){};
+    if(!_ifs.read(reinterpret_cast<char*>(&_ehdr), sizeof(_ehdr)) ||
+       std::memcmp(_ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+       _ehdr.e_phentsize != sizeof(ElfW(Phdr)))
+        return std::string{};
+
+    for(ElfW(Half) i = 0; i < _ehdr.e_phnum; ++i)
+    {
+        auto _phdr = ElfW(Phdr){};
+        _ifs.seekg(static_cast<std::streamoff>(_ehdr.e_phoff + i * sizeof(_phdr)));
+        if(!_ifs.read(reinterpret_cast<char*>(&_phdr), sizeof(_phdr))) break;
+        if(_phdr.p_type != PT_NOTE) continue;
+
+        auto _notes = std::string(_phdr.p_filesz, '\0');
+        _ifs.seekg(static_cast<std::streamoff>(_phdr.p_offset));
+        if(!_ifs.read(_notes.data(), static_cast<std::streamsize>(_notes.length())))
+            break;
+
+        auto _id = find_build_id(_notes.data(), _notes.data() + _notes.length());
+        if(!_id.empty()) return _id;
+    }
+    return std::string{};
+}
+
+void
+write(std::ostream& _os, const container& _data)
+{
+    auto _w = writer{ _os };
+
+    _w.put(magic);
+    _w.put(version);
+    _w.put(zigzag(_data.pid));
+    _w.put(zigzag(_data.rank));
+    _w.put(_data.command);
+
+    _w.put(_data.objects.size());
+    for(const auto& itr : _data.objects)
+    {
+        uint64_t _last = 0;
+        _w.put(itr.path);
+        _w.put(itr.build_id);
+        _w.put(itr.load_bias);
+        _w.put(itr.segments.size());
+        for(const auto& sitr : itr.segments)
+        {
+            _w.put_delta(sitr.first, _last);
+            _w.put_delta(sitr.second, _last);
+        }
+    }
+
+    _w.put(_data.threads.size());
+    for(const auto& itr : _data.threads)
+    {
+        _w.put(zigzag(itr.index));
+        _w.put(zigzag(itr.system_tid));
+        _w.put(itr.start);
+        _w.put(itr.stop);
+
+        uint64_t _last_addr = 0;
+        _w.put(itr.stacks.size());
+        for(const auto& sitr : itr.stacks)
+        {
+            _w.put(sitr.size());
+            for(auto aitr : sitr)
+                _w.put_delta(aitr, _last_addr);
+        }
+
+        uint64_t _last_time = itr.start;
+        _w.put(itr.samples.size());
+        for(const auto& sitr : itr.samples)
+        {
+            _w.put_delta(sitr.begin, _last_time);
+            _w.put(sitr.end - sitr.begin);
+            _w.put(sitr.stack);
+        }
+    }
+}
+
+container
+read(std::istream& _is)
+{
+    auto _r = reader{ _is };
+    if(_r.get() != magic) throw exception<std::runtime_error>("not a raw data file");
+    if(auto _version = _r.get(); _version != version)
+        throw exception<std::runtime_error>("unsupported raw data version " +
+                                            std::to_string(_version));
+
+    auto _data    = container{};
+    _data.pid     = unzigzag(_r.get());
+    _data.rank    = unzigzag(_r.get());
+    _data.command = _r.get_string();
+
+    _data.objects.resize(_r.get_count());
+    for(auto& itr : _data.objects)
+    {
+        uint64_t _last = 0;
+        itr.path       = _r.get_string();
+        itr.build_id   = _r.get_string();
+        itr.load_bias  = _r.get();
+        itr.segments.resize(_r.get_count());
+        for(auto& sitr : itr.segments)
+        {
+            sitr.first  = _r.get_delta(_last);
+            sitr.second = _r.get_delta(_last);
+        }
+    }
+
+    _data.threads.resize(_r.get_count());
+    for(auto& itr : _data.threads)
+    {
+        itr.index      = unzigzag(_r.get());
+        itr.system_tid = unzigzag(_r.get());
+        itr.start      = _r.get();
+        itr.stop       = _r.get();
+
+        uint64_t _last_addr = 0;
+        itr.stacks.resize(_r.get_count());
+        for(auto& sitr : itr.stacks)
+        {
+            sitr.resize(_r.get_count());
+            for(auto& aitr : sitr)
+                aitr = _r.get_delta(_last_addr);
+        }
+
+        uint64_t _last_time = itr.start;
+        itr.samples.resize(_r.get_count());
+        for(auto& sitr : itr.samples)
+        {
+            sitr.begin = _r.get_delta(_last_time);
+            sitr.end   = sitr.begin + _r.get();
+            sitr.stack = static_cast<uint32_t>(_r.get());
+            if(sitr.stack >= itr.stacks.size())
+                throw exception<std::runtime_error>("invalid call-stack in raw data");
+        }
+    }
+
+    return _data;
+}
+}  // namespace raw_data
+}  // namespace omnitrace
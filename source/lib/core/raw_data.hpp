@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+// container of the raw sampling data written by the finalization when the
+// post-processing is deferred (OMNITRACE_DEFER_POST_PROCESSING) and converted into
+// perfetto and text output by omnitrace-post. The samples only record the addresses
+// of the call-stacks so the loaded objects (with their build-ids) are recorded for
+// symbolizing the addresses from the files on disk.
+namespace raw_data
+{
+// an executable or shared library loaded in the process
+struct object
+{
+    using segment_t = std::pair<uintptr_t, uintptr_t>;
+
+    std::string            path      = {};
+    std::string            build_id  = {};  // hex-encoded GNU build-id, if any
+    uintptr_t              load_bias = 0;   // runtime address - address in the file
+    std::vector<segment_t> segments  = {};  // runtime [begin, end) of PT_LOAD segments
+
+    bool contains(uintptr_t) const;
+};
+
+struct sample
+{
+    uint64_t begin = 0;
+    uint64_t end   = 0;
+    uint32_t stack = 0;  // index into the call-stacks of the thread
+};
+
+struct thread
+{
+    int64_t                             index      = 0;
+    int64_t                             system_tid = 0;
+    uint64_t                            start      = 0;
+    uint64_t                            stop       = 0;
+    std::vector<std::vector<uintptr_t>> stacks     = {};  // outermost frame first
+    std::vector<sample>                 samples    = {};
+};
+
+struct container
+{
+    int64_t             pid     = 0;
+    int64_t             rank    = 0;
+    std::string         command = {};
+    std::vector<object> objects = {};
+    std::vector<thread> threads = {};
+};
+
+// the objects currently loaded in the process
+std::vector<object>
+get_loaded_objects();
+
+// reads the GNU build-id from the notes of the ELF file. Returns an empty string
+// if the file cannot be read or has no build-id
+std::string
+read_build_id(const std::string& _path);
+
+void
+write(std::ostream&, const container&);
+
+// throws if the stream does not hold a valid container
+container
+read(std::istream&);
+}  // namespace raw_data
+}  // namespace omnitrace
@@ -0,0 +1,196 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "self_overhead.hpp"
+#include "debug.hpp"
+#include "utility.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace omnitrace
+{
+namespace self_overhead
+{
+namespace
+{
+struct alignas(64) thread_entry
+{
+    std::atomic<int64_t>  tid   = { -1 };
+    std::atomic<uint64_t> ticks = { 0 };
+    std::atomic<uint64_t> count = { 0 };
+    uint64_t              beg   = 0;  // only accessed by the owning thread
+};
+
+double nsec_per_tick = 1.0;
+double probe_nsec    = 0.0;
+
+auto&
+get_entries()
+{
+    static auto* _v = new std::array<thread_entry, OMNITRACE_MAX_THREADS>{};
+    return *_v;
+}
+
+thread_entry&
+get_entry()
+{
+    // the threads beyond the max number of threads are not reported
+    static thread_local thread_entry  _overflow = {};
+    static thread_local thread_entry* _v        = []() {
+        auto _idx = utility::get_thread_index();
+        if(_idx >= OMNITRACE_MAX_THREADS) return &_overflow;
+        auto& _entry = get_entries().at(_idx);
+        _entry.tid.store(tim::threading::get_id(), std::memory_order_relaxed);
+        return &_entry;
+    }();
+    return *_v;
+}
+
+OMNITRACE_INLINE void
+begin(thread_entry& _entry)
+{
+    _entry.beg = read_ticks();
+}
+
+OMNITRACE_INLINE void
+end(thread_entry& _entry)
+{
+    if(_entry.beg == 0) return;
+    auto _elapsed = read_ticks() - _entry.beg;
+    _entry.beg    = 0;
+    // only the owning thread writes the values
+    _entry.ticks.store(_entry.ticks.load(std::memory_order_relaxed) + _elapsed,
+                       std::memory_order_relaxed);
+    _entry.count.store(_entry.count.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+}
+}  // namespace
+
+void
+setup(bool _correction)
+{
+    if(is_enabled()) return;
+
+#if defined(__x86_64__) || defined(__i386__)
+    {
+        using clock_type = std::chrono::steady_clock;
+        auto _beg_ticks  = read_ticks();
+        auto _beg_time   = clock_type::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 5 });
+        auto _end_ticks = read_ticks();
+        auto _end_time  = clock_type::now();
+        auto _nsec      = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         _end_time - _beg_time)
+                         .count();
+        if(_end_ticks > _beg_ticks)
+            nsec_per_tick = static_cast<double>(_nsec) / (_end_ticks - _beg_ticks);
+    }
+#endif
+
+    // the cost of the accounting which is outside of the measured interval
+    {
+        constexpr uint64_t _n     = 10000;
+        auto               _entry = thread_entry{};
+        auto               _beg   = read_ticks();
+        for(uint64_t i = 0; i < _n; ++i)
+        {
+            begin(_entry);
+            end(_entry);
+        }
+        auto _elapsed = read_ticks() - _beg;
+        auto _inside  = _entry.ticks.load();
+        if(_elapsed > _inside) probe_nsec = nsec_per_tick * (_elapsed - _inside) / _n;
+    }
+
+    OMNITRACE_VERBOSE_F(1,
+                        "[self_overhead] %.4f nsec per tick, probe cost of %.1f nsec\n",
+                        nsec_per_tick, probe_nsec);
+
+    get_enabled_value()    = true;
+    get_correction_value() = _correction;
+}
+
+void
+begin()
+{
+    begin(get_entry());
+}
+
+void
+end()
+{
+    end(get_entry());
+}
+
+snapshot
+get_snapshot()
+{
+    auto& _entry = get_entry();
+    return snapshot{ _entry.ticks.load(std::memory_order_relaxed),
+                     _entry.count.load(std::memory_order_relaxed) };
+}
+
+uint64_t
+get_elapsed_nsec(const snapshot& _snap)
+{
+    auto _now = get_snapshot();
+    return (nsec_per_tick * (_now.ticks - _snap.ticks)) +
+           (probe_nsec * (_now.count - _snap.count));
+}
+
+double
+get_nsec_per_tick()
+{
+    return nsec_per_tick;
+}
+
+double
+get_probe_nsec()
+{
+    return probe_nsec;
+}
+
+std::vector<thread_overhead>
+get_thread_overheads()
+{
+    auto _v = std::vector<thread_overhead>{};
+    for(const auto& itr : get_entries())
+    {
+        auto _tid = itr.tid.load(std::memory_order_relaxed);
+        if(_tid < 0) continue;
+        auto _count = itr.count.load(std::memory_order_relaxed);
+        auto _ticks = itr.ticks.load(std::memory_order_relaxed);
+        _v.emplace_back(thread_overhead{
+            _tid,
+            static_cast<uint64_t>((nsec_per_tick * _ticks) + (probe_nsec * _count)),
+            _count });
+    }
+    return _v;
+}
+}  // namespace self_overhead
+}  // namespace omnitrace
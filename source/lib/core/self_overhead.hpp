@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "common/defines.h"
+#include "defines.hpp"
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+namespace omnitrace
+{
+// OMNITRACE_SELF_OVERHEAD: per-thread accounting of the time spent inside omnitrace,
+// i.e. in the regions where the thread state is ThreadState::Internal (the sampler
+// handlers, the push/pop of the regions, the gotcha wrappers and the callback and
+// background threads). The entry and exit of the outermost internal region read the
+// time-stamp counter so the accounting adds a few cycles per transition.
+namespace self_overhead
+{
+struct snapshot
+{
+    uint64_t ticks = 0;  // ticks spent in the internal regions
+    uint64_t count = 0;  // number of internal regions
+};
+
+struct thread_overhead
+{
+    int64_t  tid   = -1;  // timemory thread id
+    uint64_t nsec  = 0;
+    uint64_t count = 0;
+};
+
+OMNITRACE_INLINE uint64_t
+read_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec _ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &_ts);
+    return (_ts.tv_sec * 1000000000UL) + _ts.tv_nsec;
+#endif
+}
+
+inline bool&
+get_enabled_value()
+{
+    static bool _v = false;
+    return _v;
+}
+
+inline bool&
+get_correction_value()
+{
+    static bool _v = false;
+    return _v;
+}
+
+OMNITRACE_INLINE bool
+is_enabled()
+{
+    return get_enabled_value();
+}
+
+// OMNITRACE_SELF_OVERHEAD_CORRECTION
+OMNITRACE_INLINE bool
+is_correction_enabled()
+{
+    return get_correction_value();
+}
+
+// enables the accounting and calibrates the ticks per nanosecond and the cost of the
+// accounting itself (the probe cost)
+void
+setup(bool _correction);
+
+void
+begin() OMNITRACE_HOT;
+
+void
+end() OMNITRACE_HOT;
+
+// the accounting of the calling thread
+snapshot
+get_snapshot();
+
+// nanoseconds spent in the internal regions of the calling thread since the snapshot
+// including the probe cost of each region
+uint64_t
+get_elapsed_nsec(const snapshot&);
+
+// nanoseconds per tick and the probe cost in nanoseconds
+double
+get_nsec_per_tick();
+
+double
+get_probe_nsec();
+
+// the accounting of every thread
+std::vector<thread_overhead>
+get_thread_overheads();
+}  // namespace self_overhead
+}  // namespace omnitrace
@@ -23,6 +23,7 @@
 #include "state.hpp"
 #include "config.hpp"
 #include "debug.hpp"
+#include "self_overhead.hpp"
 #include "utility.hpp"
 
 #include <atomic>
@@ -102,7 +103,11 @@ push_thread_state(ThreadState _v)
 {
     if(get_thread_state() >= ThreadState::Completed) return get_thread_state();
 
-    return get_thread_state_history().emplace_back(set_thread_state(_v));
+    auto _prev = set_thread_state(_v);
+    if(OMNITRACE_UNLIKELY(self_overhead::is_enabled()) && _v == ThreadState::Internal &&
+       _prev != ThreadState::Internal)
+        self_overhead::begin();
+    return get_thread_state_history().emplace_back(_prev);
 }
 
 ThreadState
@@ -113,7 +118,10 @@ pop_thread_state()
     auto& _hist = get_thread_state_history();
     if(!_hist.empty())
     {
-        set_thread_state(_hist.back());
+        auto _prev = set_thread_state(_hist.back());
+        if(OMNITRACE_UNLIKELY(self_overhead::is_enabled()) &&
+           _prev == ThreadState::Internal && _hist.back() != ThreadState::Internal)
+            self_overhead::end();
         _hist.pop_back();
     }
     return get_thread_state();
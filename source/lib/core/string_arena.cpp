@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "string_arena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace omnitrace
+{
+string_arena&
+string_arena::instance()
+{
+    // intentionally leaked: perfetto may reference these strings until it is flushed
+    static auto* _v = new string_arena{};
+    return *_v;
+}
+
+const char*
+string_arena::intern(std::string_view _v)
+{
+    // the keys of the cache reference the strings in the arena so they remain valid
+    // after the cache is cleared
+    static thread_local auto _cache = std::unordered_map<std::string_view, const char*>{};
+
+    if(auto itr = _cache.find(_v); itr != _cache.end()) return itr->second;
+
+    if(_cache.size() >= cache_size) _cache.clear();
+
+    const auto* _p = insert(_v);
+    _cache.emplace(std::string_view{ _p, _v.length() }, _p);
+    return _p;
+}
+
+const char*
+string_arena::insert(std::string_view _v)
+{
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+
+    if(auto itr = m_lookup.find(_v); itr != m_lookup.end()) return itr->second;
+
+    auto _len = _v.length() + 1;
+    if(m_blocks.empty() || m_offset + _len > m_capacity)
+    {
+        m_offset   = 0;
+        m_capacity = std::max<size_t>(block_size, _len);
+        m_bytes += m_capacity;
+        m_blocks.emplace_back(std::make_unique<char[]>(m_capacity));
+    }
+
+    char* _p = m_blocks.back().get() + m_offset;
+    std::memcpy(_p, _v.data(), _v.length());
+    _p[_v.length()] = '\0';
+    m_offset += _len;
+
+    return m_lookup.emplace(std::string_view{ _p, _v.length() }, _p).first->second;
+}
+
+size_t
+string_arena::size() const
+{
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+    return m_lookup.size();
+}
+
+size_t
+string_arena::bytes() const
+{
+    std::unique_lock<std::mutex> _lk{ m_mutex };
+    return m_bytes;
+}
+}  // namespace omnitrace
@@ -0,0 +1,74 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "timemory.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+// process-wide, append-only storage of the labels passed to perfetto and timemory.
+// Strings are packed into large blocks instead of one allocation per label and the
+// returned pointers remain valid for the life of the process, i.e. they satisfy the
+// perfetto requirements for a StaticString and equal labels always map to the same
+// pointer so perfetto emits a single interned name for them. Lookups check a small
+// thread-local cache before acquiring the lock on the shared table.
+struct string_arena
+{
+    static constexpr size_t block_size = 64 * units::KiB;
+    static constexpr size_t cache_size = 4096;
+
+    static string_arena& instance();
+
+    const char* intern(std::string_view);
+    const char* intern(const char* _v)
+    {
+        return (_v) ? intern(std::string_view{ _v }) : nullptr;
+    }
+
+    size_t size() const;   // number of unique strings
+    size_t bytes() const;  // bytes allocated for the blocks
+
+private:
+    const char* insert(std::string_view);
+
+    mutable std::mutex                                m_mutex    = {};
+    size_t                                            m_offset   = 0;
+    size_t                                            m_capacity = 0;
+    size_t                                            m_bytes    = 0;
+    std::vector<std::unique_ptr<char[]>>              m_blocks   = {};
+    std::unordered_map<std::string_view, const char*> m_lookup   = {};
+};
+
+inline const char*
+intern_string(std::string_view _v)
+{
+    return string_arena::instance().intern(_v);
+}
+}  // namespace omnitrace
@@ -23,6 +23,11 @@
 #include "utility.hpp"
 #include "debug.hpp"
 
+#include <dirent.h>
+
+#include <cstdio>
+#include <fstream>
+
 namespace omnitrace
 {
 namespace utility
@@ -119,5 +124,58 @@ parse_numeric_range<int64_t, std::vector<int64_t>>(std::string, const std::strin
 template std::unordered_set<int64_t>
 parse_numeric_range<int64_t, std::unordered_set<int64_t>>(std::string, const std::string&,
                                                           long);
+
+std::string
+read_string(const std::string& _path)
+{
+    auto _v = std::string{};
+    std::ifstream{ _path } >> _v;
+    return _v;
+}
+
+std::vector<std::string>
+list_directory(const std::string& _path)
+{
+    auto  _v   = std::vector<std::string>{};
+    auto* _dir = opendir(_path.c_str());
+    if(!_dir) return _v;
+    while(auto* _entry = readdir(_dir))
+    {
+        auto _name = std::string{ _entry->d_name };
+        if(_name != "." && _name != "..") _v.emplace_back(std::move(_name));
+    }
+    closedir(_dir);
+    std::sort(_v.begin(), _v.end());
+    return _v;
+}
+
+std::string
+json_escape(std::string_view _v)
+{
+    auto _ss = std::string{};
+    _ss.reserve(_v.length());
+    for(auto itr : _v)
+    {
+        switch(itr)
+        {
+            case '"': _ss += "\\\""; break;
+            case '\\': _ss += "\\\\"; break;
+            case '\n': _ss += "\\n"; break;
+            case '\t': _ss += "\\t"; break;
+            default:
+                if(static_cast<unsigned char>(itr) < 0x20)
+                {
+                    char _buf[8];
+                    snprintf(_buf, sizeof(_buf), "\\u%04x", static_cast<unsigned>(itr));
+                    _ss += _buf;
+                }
+                else
+                {
+                    _ss += itr;
+                }
+        }
+    }
+    return _ss;
+}
 }  // namespace utility
 }  // namespace omnitrace
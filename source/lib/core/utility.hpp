@@ -33,9 +33,14 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 namespace omnitrace
@@ -197,6 +202,50 @@ combine(LhsT& _lhs, RhsT&& _rhs)
     return _lhs;
 }
 
+/// invokes the functor for every index in [0, N) using up to the given number of
+/// threads (including the calling thread). The first exception thrown by the functor
+/// is rethrown after every thread has been joined
+template <typename FuncT>
+inline void
+parallel_for(size_t _n, size_t _nthreads, FuncT&& _func)
+{
+    _nthreads = std::min(_nthreads, _n);
+    if(_nthreads <= 1)
+    {
+        for(size_t i = 0; i < _n; ++i)
+            _func(i);
+        return;
+    }
+
+    auto _next   = std::atomic<size_t>{ 0 };
+    auto _mutex  = std::mutex{};
+    auto _error  = std::exception_ptr{};
+    auto _worker = [&]() {
+        for(size_t i = _next++; i < _n; i = _next++)
+        {
+            try
+            {
+                _func(i);
+            } catch(...)
+            {
+                auto _lk = std::unique_lock<std::mutex>{ _mutex };
+                if(!_error) _error = std::current_exception();
+                _next.store(_n);
+            }
+        }
+    };
+
+    auto _threads = std::vector<std::thread>{};
+    _threads.reserve(_nthreads - 1);
+    for(size_t i = 1; i < _nthreads; ++i)
+        _threads.emplace_back(_worker);
+    _worker();
+    for(auto& itr : _threads)
+        itr.join();
+
+    if(_error) std::rethrow_exception(_error);
+}
+
 template <template <typename, typename...> class ContainerT, typename Tp,
           typename... TailT>
 std::string
@@ -252,5 +301,18 @@ parse_numeric_range<int64_t, std::vector<int64_t>>(std::string, const std::strin
 extern template std::unordered_set<int64_t>
 parse_numeric_range<int64_t, std::unordered_set<int64_t>>(std::string, const std::string&,
                                                           long);
+
+/// reads the first whitespace-delimited token of a file, e.g. a sysfs attribute.
+/// Returns an empty string when the file cannot be read
+std::string
+read_string(const std::string& _path);
+
+/// returns the sorted names of the entries of a directory, excluding "." and ".."
+std::vector<std::string>
+list_directory(const std::string& _path);
+
+/// escapes the quotes, backslashes and control characters of a JSON string value
+std::string
+json_escape(std::string_view _v);
 }  // namespace utility
 }  // namespace omnitrace
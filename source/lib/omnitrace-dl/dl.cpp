@@ -44,37 +44,27 @@
 
 #include <timemory/utility/filepath.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <gnu/libc-version.h>
 #include <link.h>
 #include <linux/limits.h>
+#include <mutex>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 //--------------------------------------------------------------------------------------//
 
+// binds the function pointer to the symbol in the library. The symbol is looked up
+// immediately unless OMNITRACE_LAZY_INIT is enabled, in which case it is looked up on
+// the first call through the function pointer
 #define OMNITRACE_DLSYM(VARNAME, HANDLE, FUNCNAME)                                       \
-    if(HANDLE)                                                                           \
-    {                                                                                    \
-        *(void**) (&VARNAME) = dlsym(HANDLE, FUNCNAME);                                  \
-        if(VARNAME == nullptr && _omnitrace_dl_verbose >= _warn_verbose)                 \
-        {                                                                                \
-            OMNITRACE_COMMON_LIBRARY_LOG_START                                           \
-            fprintf(stderr, "[omnitrace][dl][pid=%i]> %s :: %s\n", getpid(), FUNCNAME,   \
-                    dlerror());                                                          \
-            OMNITRACE_COMMON_LIBRARY_LOG_END                                             \
-        }                                                                                \
-        else if(_omnitrace_dl_verbose > _info_verbose)                                   \
-        {                                                                                \
-            OMNITRACE_COMMON_LIBRARY_LOG_START                                           \
-            fprintf(stderr, "[omnitrace][dl][pid=%i]> %s :: success\n", getpid(),        \
-                    FUNCNAME);                                                           \
-            OMNITRACE_COMMON_LIBRARY_LOG_END                                             \
-        }                                                                                \
-    }
+    if(HANDLE) VARNAME.bind(HANDLE, FUNCNAME, _warn_verbose, _info_verbose);
 
 //--------------------------------------------------------------------------------------//
 
@@ -174,6 +164,116 @@ pid_t _omnitrace_root_pid = get_omnitrace_root_pid();
 //  - OMNITRACE_VERBOSE
 int _omnitrace_dl_verbose = get_omnitrace_dl_env();
 
+// OMNITRACE_LAZY_INIT=ON defers loading libomnitrace until the first enabled event
+// (instead of before main) and looks up the symbols of libomnitrace on their first use
+inline bool
+get_lazy_init()
+{
+    static bool _v = get_env("OMNITRACE_LAZY_INIT", false);
+    return _v;
+}
+
+// startup costs which are reported when OMNITRACE_DL_INIT_TIMING=ON
+struct init_timing
+{
+    using clock_type = std::chrono::steady_clock;
+
+    static double elapsed_msec(clock_type::time_point _beg,
+                               clock_type::time_point _end = clock_type::now())
+    {
+        return std::chrono::duration<double, std::milli>(_end - _beg).count();
+    }
+
+    clock_type::time_point load         = clock_type::now();
+    double                 dlopen_msec  = 0.0;
+    double                 init_msec    = 0.0;
+    std::atomic<int64_t>   dlsym_nsec   = { 0 };
+    std::atomic<size_t>    num_symbols  = { 0 };
+    bool                   lazy_trigger = false;
+};
+
+inline init_timing&
+get_init_timing()
+{
+    static auto* _v = new init_timing{};
+    return *_v;
+}
+
+// records the time when libomnitrace-dl was loaded
+init_timing& _omnitrace_dl_init_timing = get_init_timing();
+
+/// a function pointer in libomnitrace (or libomnitrace-user) which is looked up via
+/// dlsym when bound or, with OMNITRACE_LAZY_INIT, on the first call
+template <typename FuncT>
+struct lazy_symbol;
+
+template <typename RetT, typename... Args>
+struct lazy_symbol<RetT(Args...)>
+{
+    using pointer_type = RetT (*)(Args...);
+
+    explicit operator bool() { return get() != nullptr; }
+
+    RetT operator()(Args... _args) { return (*get())(_args...); }
+
+    void bind(void* _handle, const char* _name, int _warn_verbose, int _info_verbose)
+    {
+        m_handle       = _handle;
+        m_name         = _name;
+        m_warn_verbose = _warn_verbose;
+        m_info_verbose = _info_verbose;
+        m_resolved.store(false, std::memory_order_release);
+        if(!get_lazy_init()) resolve();
+    }
+
+    pointer_type get()
+    {
+        if(OMNITRACE_UNLIKELY(!m_resolved.load(std::memory_order_acquire))) resolve();
+        return m_func.load(std::memory_order_relaxed);
+    }
+
+private:
+    void resolve()
+    {
+        if(!m_handle) return;
+
+        // concurrent lookups are harmless since they produce the same value
+        auto  _beg = init_timing::clock_type::now();
+        void* _sym = dlsym(m_handle, m_name);
+        auto  _end = init_timing::clock_type::now();
+        get_init_timing().dlsym_nsec +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(_end - _beg).count();
+        ++get_init_timing().num_symbols;
+
+        if(_sym == nullptr && _omnitrace_dl_verbose >= m_warn_verbose)
+        {
+            OMNITRACE_COMMON_LIBRARY_LOG_START
+            fprintf(stderr, "[omnitrace][dl][pid=%i]> %s :: %s\n", getpid(), m_name,
+                    dlerror());
+            OMNITRACE_COMMON_LIBRARY_LOG_END
+        }
+        else if(_omnitrace_dl_verbose > m_info_verbose)
+        {
+            OMNITRACE_COMMON_LIBRARY_LOG_START
+            fprintf(stderr, "[omnitrace][dl][pid=%i]> %s :: success\n", getpid(),
+                    m_name);
+            OMNITRACE_COMMON_LIBRARY_LOG_END
+        }
+
+        pointer_type _func = nullptr;
+        *(void**) (&_func) = _sym;
+        m_func.store(_func, std::memory_order_relaxed);
+        m_resolved.store(true, std::memory_order_release);
+    }
+
+    void*                     m_handle       = nullptr;
+    const char*               m_name         = nullptr;
+    int                       m_warn_verbose = 0;
+    int                       m_info_verbose = 2;
+    std::atomic<bool>         m_resolved     = { true };
+    std::atomic<pointer_type> m_func         = { nullptr };
+};
+
 // The docs for dlopen suggest that the combination of RTLD_LOCAL + RTLD_DEEPBIND
 // (when available) helps ensure that the symbols in the instrumentation library
 // libomnitrace.so will use it's own symbols... not symbols that are potentially
@@ -242,8 +342,10 @@ struct OMNITRACE_INTERNAL_API indirect
                                           common::path::dirname(_dllib));
         common::setup_environ(_omnitrace_dl_verbose, _search_paths, _omnilib, _dllib);
 
+        auto _beg    = init_timing::clock_type::now();
         m_omnihandle = open(m_omnilib);
         m_userhandle = open(m_userlib);
+        get_init_timing().dlopen_msec += init_timing::elapsed_msec(_beg);
         init();
     }
 
@@ -297,6 +399,22 @@ struct OMNITRACE_INTERNAL_API indirect
         OMNITRACE_DLSYM(omnitrace_pop_trace_f, m_omnihandle, "omnitrace_pop_trace");
         OMNITRACE_DLSYM(omnitrace_push_region_f, m_omnihandle, "omnitrace_push_region");
         OMNITRACE_DLSYM(omnitrace_pop_region_f, m_omnihandle, "omnitrace_pop_region");
+        OMNITRACE_DLSYM(omnitrace_push_sampled_region_f, m_omnihandle,
+                        "omnitrace_push_sampled_region");
+        OMNITRACE_DLSYM(omnitrace_pop_sampled_region_f, m_omnihandle,
+                        "omnitrace_pop_sampled_region");
+        OMNITRACE_DLSYM(omnitrace_register_region_f, m_omnihandle,
+                        "omnitrace_register_region");
+        OMNITRACE_DLSYM(omnitrace_push_region_handle_f, m_omnihandle,
+                        "omnitrace_push_region_handle");
+        OMNITRACE_DLSYM(omnitrace_pop_region_handle_f, m_omnihandle,
+                        "omnitrace_pop_region_handle");
+        OMNITRACE_DLSYM(omnitrace_register_annotation_schema_f, m_omnihandle,
+                        "omnitrace_register_annotation_schema");
+        OMNITRACE_DLSYM(omnitrace_push_schema_region_f, m_omnihandle,
+                        "omnitrace_push_schema_region");
+        OMNITRACE_DLSYM(omnitrace_pop_schema_region_f, m_omnihandle,
+                        "omnitrace_pop_schema_region");
         OMNITRACE_DLSYM(omnitrace_push_category_region_f, m_omnihandle,
                         "omnitrace_push_category_region");
         OMNITRACE_DLSYM(omnitrace_pop_category_region_f, m_omnihandle,
@@ -305,9 +423,19 @@ struct OMNITRACE_INTERNAL_API indirect
                         "omnitrace_register_source");
         OMNITRACE_DLSYM(omnitrace_register_coverage_f, m_omnihandle,
                         "omnitrace_register_coverage");
+        OMNITRACE_DLSYM(omnitrace_register_call_counter_f, m_omnihandle,
+                        "omnitrace_register_call_counter");
+        OMNITRACE_DLSYM(omnitrace_register_loop_counter_f, m_omnihandle,
+                        "omnitrace_register_loop_counter");
+        OMNITRACE_DLSYM(omnitrace_register_python_sampler_f, m_omnihandle,
+                        "omnitrace_register_python_sampler");
         OMNITRACE_DLSYM(omnitrace_progress_f, m_omnihandle, "omnitrace_progress");
         OMNITRACE_DLSYM(omnitrace_annotated_progress_f, m_omnihandle,
                         "omnitrace_annotated_progress");
+        OMNITRACE_DLSYM(omnitrace_trigger_snapshot_f, m_omnihandle,
+                        "omnitrace_trigger_snapshot");
+        OMNITRACE_DLSYM(omnitrace_register_trace_window_f, m_omnihandle,
+                        "omnitrace_register_trace_window");
 
         OMNITRACE_DLSYM(kokkosp_print_help_f, m_omnihandle, "kokkosp_print_help");
         OMNITRACE_DLSYM(kokkosp_parse_args_f, m_omnihandle, "kokkosp_parse_args");
@@ -372,8 +500,22 @@ struct OMNITRACE_INTERNAL_API indirect
 #endif
 
         if(!m_userhandle) m_userhandle = open(m_userlib);
-        _warn_verbose = 0;
-        OMNITRACE_DLSYM(omnitrace_user_configure_f, m_userhandle,
+        configure_user(m_userhandle);
+
+        if(omnitrace_register_trace_window_f)
+            omnitrace_register_trace_window_f(&omnitrace_trace_window_dl);
+    }
+
+    // installs the callbacks of libomnitrace-user which forward to omnitrace-dl. This
+    // does not require libomnitrace so it is also invoked before a deferred init
+    static OMNITRACE_INLINE void configure_user(void* _userhandle)
+    {
+        using user_cb_t = omnitrace_user_callbacks_t;
+
+        int  _warn_verbose              = 0;
+        int  _info_verbose              = 2;
+        auto omnitrace_user_configure_f = lazy_symbol<int(int, user_cb_t, user_cb_t*)>{};
+        OMNITRACE_DLSYM(omnitrace_user_configure_f, _userhandle,
                         "omnitrace_user_configure");
 
         if(omnitrace_user_configure_f)
@@ -389,87 +531,120 @@ struct OMNITRACE_INTERNAL_API indirect
             _cb.push_annotated_region      = &omnitrace_user_push_annotated_region_dl;
             _cb.pop_annotated_region       = &omnitrace_user_pop_annotated_region_dl;
             _cb.annotated_progress         = &omnitrace_user_annotated_progress_dl;
-            (*omnitrace_user_configure_f)(OMNITRACE_USER_REPLACE_CONFIG, _cb, nullptr);
+            _cb.trigger_snapshot           = &omnitrace_user_trigger_snapshot_dl;
+            _cb.register_region            = &omnitrace_user_register_region_dl;
+            _cb.push_region_handle         = &omnitrace_user_push_region_handle_dl;
+            _cb.pop_region_handle          = &omnitrace_user_pop_region_handle_dl;
+            _cb.push_sampled_region        = &omnitrace_user_push_sampled_region_dl;
+            _cb.pop_sampled_region         = &omnitrace_user_pop_sampled_region_dl;
+            _cb.register_annotation_schema =
+                &omnitrace_user_register_annotation_schema_dl;
+            _cb.push_schema_region         = &omnitrace_user_push_schema_region_dl;
+            _cb.pop_schema_region          = &omnitrace_user_pop_schema_region_dl;
+            omnitrace_user_configure_f(OMNITRACE_USER_REPLACE_CONFIG, _cb, nullptr);
         }
     }
 
 public:
-    using user_cb_t = omnitrace_user_callbacks_t;
+    template <typename FuncT>
+    using symbol_t = lazy_symbol<FuncT>;
 
     // libomnitrace functions
-    void (*omnitrace_init_library_f)(void)                                   = nullptr;
-    void (*omnitrace_init_tooling_f)(void)                                   = nullptr;
-    void (*omnitrace_init_f)(const char*, bool, const char*)                 = nullptr;
-    void (*omnitrace_finalize_f)(void)                                       = nullptr;
-    void (*omnitrace_set_env_f)(const char*, const char*)                    = nullptr;
-    void (*omnitrace_set_mpi_f)(bool, bool)                                  = nullptr;
-    void (*omnitrace_register_source_f)(const char*, const char*, size_t, size_t,
-                                        const char*)                         = nullptr;
-    void (*omnitrace_register_coverage_f)(const char*, const char*, size_t)  = nullptr;
-    void (*omnitrace_push_trace_f)(const char*)                              = nullptr;
-    void (*omnitrace_pop_trace_f)(const char*)                               = nullptr;
-    int (*omnitrace_push_region_f)(const char*)                              = nullptr;
-    int (*omnitrace_pop_region_f)(const char*)                               = nullptr;
-    int (*omnitrace_push_category_region_f)(omnitrace_category_t, const char*,
-                                            omnitrace_annotation_t*, size_t) = nullptr;
-    int (*omnitrace_pop_category_region_f)(omnitrace_category_t, const char*,
-                                           omnitrace_annotation_t*, size_t)  = nullptr;
-    void (*omnitrace_progress_f)(const char*)                                = nullptr;
-    void (*omnitrace_annotated_progress_f)(const char*, omnitrace_annotation_t*,
-                                           size_t)                           = nullptr;
-
-    // libomnitrace-user functions
-    int (*omnitrace_user_configure_f)(int, user_cb_t, user_cb_t*) = nullptr;
+    symbol_t<void(void)>                           omnitrace_init_library_f          = {};
+    symbol_t<void(void)>                           omnitrace_init_tooling_f          = {};
+    symbol_t<void(const char*, bool, const char*)> omnitrace_init_f                  = {};
+    symbol_t<void(void)>                           omnitrace_finalize_f              = {};
+    symbol_t<void(const char*, const char*)>       omnitrace_set_env_f               = {};
+    symbol_t<void(bool, bool)>                     omnitrace_set_mpi_f               = {};
+    symbol_t<void(size_t)>                         omnitrace_register_coverage_f     = {};
+    symbol_t<void(void (*)(bool))>                 omnitrace_register_trace_window_f = {};
+    symbol_t<void(const char*)>                    omnitrace_push_trace_f            = {};
+    symbol_t<void(const char*)>                    omnitrace_pop_trace_f             = {};
+    symbol_t<int(const char*)>                     omnitrace_push_region_f           = {};
+    symbol_t<int(const char*)>                     omnitrace_pop_region_f            = {};
+    symbol_t<int(const char*, size_t)>             omnitrace_push_sampled_region_f   = {};
+    symbol_t<int(const char*)>                     omnitrace_pop_sampled_region_f    = {};
+    symbol_t<int(omnitrace_region_handle_t)>       omnitrace_push_region_handle_f    = {};
+    symbol_t<int(omnitrace_region_handle_t)>       omnitrace_pop_region_handle_f     = {};
+    symbol_t<void(const char*)>                    omnitrace_progress_f              = {};
+    symbol_t<int(void)>                            omnitrace_trigger_snapshot_f      = {};
+
+    symbol_t<void(const char*, const char*, size_t, size_t, const char*, size_t)>
+        omnitrace_register_source_f = {};
+    symbol_t<void(const char*, const char*, uint64_t*)>
+        omnitrace_register_call_counter_f = {};
+    symbol_t<void(const char*, const char*, uint64_t*, uint64_t*)>
+        omnitrace_register_loop_counter_f = {};
+    symbol_t<void(size_t (*)(uintptr_t*, size_t),
+                  int (*)(uintptr_t, const char**, const char**, int*))>
+        omnitrace_register_python_sampler_f = {};
+    symbol_t<omnitrace_region_handle_t(const char*)>
+        omnitrace_register_region_f = {};
+    symbol_t<omnitrace_annotation_schema_t(const omnitrace_annotation_field_t*, size_t)>
+        omnitrace_register_annotation_schema_f = {};
+    symbol_t<int(const char*, omnitrace_annotation_schema_t, const void*)>
+        omnitrace_push_schema_region_f = {};
+    symbol_t<int(const char*, omnitrace_annotation_schema_t, const void*)>
+        omnitrace_pop_schema_region_f = {};
+    symbol_t<int(omnitrace_category_t, const char*, omnitrace_annotation_t*, size_t)>
+        omnitrace_push_category_region_f = {};
+    symbol_t<int(omnitrace_category_t, const char*, omnitrace_annotation_t*, size_t)>
+        omnitrace_pop_category_region_f = {};
+    symbol_t<void(const char*, omnitrace_annotation_t*, size_t)>
+        omnitrace_annotated_progress_f = {};
 
     // KokkosP functions
-    void (*kokkosp_print_help_f)(char*)                                       = nullptr;
-    void (*kokkosp_parse_args_f)(int, char**)                                 = nullptr;
-    void (*kokkosp_declare_metadata_f)(const char*, const char*)              = nullptr;
-    void (*kokkosp_request_tool_settings_f)(const uint32_t,
-                                            Kokkos_Tools_ToolSettings*)       = nullptr;
-    void (*kokkosp_init_library_f)(const int, const uint64_t, const uint32_t,
-                                   void*)                                     = nullptr;
-    void (*kokkosp_finalize_library_f)()                                      = nullptr;
-    void (*kokkosp_begin_parallel_for_f)(const char*, uint32_t, uint64_t*)    = nullptr;
-    void (*kokkosp_end_parallel_for_f)(uint64_t)                              = nullptr;
-    void (*kokkosp_begin_parallel_reduce_f)(const char*, uint32_t, uint64_t*) = nullptr;
-    void (*kokkosp_end_parallel_reduce_f)(uint64_t)                           = nullptr;
-    void (*kokkosp_begin_parallel_scan_f)(const char*, uint32_t, uint64_t*)   = nullptr;
-    void (*kokkosp_end_parallel_scan_f)(uint64_t)                             = nullptr;
-    void (*kokkosp_begin_fence_f)(const char*, uint32_t, uint64_t*)           = nullptr;
-    void (*kokkosp_end_fence_f)(uint64_t)                                     = nullptr;
-    void (*kokkosp_push_profile_region_f)(const char*)                        = nullptr;
-    void (*kokkosp_pop_profile_region_f)()                                    = nullptr;
-    void (*kokkosp_create_profile_section_f)(const char*, uint32_t*)          = nullptr;
-    void (*kokkosp_destroy_profile_section_f)(uint32_t)                       = nullptr;
-    void (*kokkosp_start_profile_section_f)(uint32_t)                         = nullptr;
-    void (*kokkosp_stop_profile_section_f)(uint32_t)                          = nullptr;
-    void (*kokkosp_allocate_data_f)(const SpaceHandle, const char*, const void* const,
-                                    const uint64_t)                           = nullptr;
-    void (*kokkosp_deallocate_data_f)(const SpaceHandle, const char*, const void* const,
-                                      const uint64_t)                         = nullptr;
-    void (*kokkosp_begin_deep_copy_f)(SpaceHandle, const char*, const void*, SpaceHandle,
-                                      const char*, const void*, uint64_t)     = nullptr;
-    void (*kokkosp_end_deep_copy_f)()                                         = nullptr;
-    void (*kokkosp_profile_event_f)(const char*)                              = nullptr;
-    void (*kokkosp_dual_view_sync_f)(const char*, const void* const, bool)    = nullptr;
-    void (*kokkosp_dual_view_modify_f)(const char*, const void* const, bool)  = nullptr;
+    symbol_t<void(char*)>                    kokkosp_print_help_f              = {};
+    symbol_t<void(int, char**)>              kokkosp_parse_args_f              = {};
+    symbol_t<void(const char*, const char*)> kokkosp_declare_metadata_f        = {};
+    symbol_t<void()>                         kokkosp_finalize_library_f        = {};
+    symbol_t<void(uint64_t)>                 kokkosp_end_parallel_for_f        = {};
+    symbol_t<void(uint64_t)>                 kokkosp_end_parallel_reduce_f     = {};
+    symbol_t<void(uint64_t)>                 kokkosp_end_parallel_scan_f       = {};
+    symbol_t<void(uint64_t)>                 kokkosp_end_fence_f               = {};
+    symbol_t<void(const char*)>              kokkosp_push_profile_region_f     = {};
+    symbol_t<void()>                         kokkosp_pop_profile_region_f      = {};
+    symbol_t<void(const char*, uint32_t*)>   kokkosp_create_profile_section_f  = {};
+    symbol_t<void(uint32_t)>                 kokkosp_destroy_profile_section_f = {};
+    symbol_t<void(uint32_t)>                 kokkosp_start_profile_section_f   = {};
+    symbol_t<void(uint32_t)>                 kokkosp_stop_profile_section_f    = {};
+    symbol_t<void()>                         kokkosp_end_deep_copy_f           = {};
+    symbol_t<void(const char*)>              kokkosp_profile_event_f           = {};
+
+    symbol_t<void(const uint32_t, Kokkos_Tools_ToolSettings*)>
+        kokkosp_request_tool_settings_f = {};
+    symbol_t<void(const int, const uint64_t, const uint32_t, void*)>
+        kokkosp_init_library_f = {};
+    symbol_t<void(const char*, uint32_t, uint64_t*)> kokkosp_begin_parallel_for_f    = {};
+    symbol_t<void(const char*, uint32_t, uint64_t*)> kokkosp_begin_parallel_reduce_f = {};
+    symbol_t<void(const char*, uint32_t, uint64_t*)> kokkosp_begin_parallel_scan_f   = {};
+    symbol_t<void(const char*, uint32_t, uint64_t*)> kokkosp_begin_fence_f           = {};
+    symbol_t<void(const SpaceHandle, const char*, const void* const, const uint64_t)>
+        kokkosp_allocate_data_f = {};
+    symbol_t<void(const SpaceHandle, const char*, const void* const, const uint64_t)>
+        kokkosp_deallocate_data_f = {};
+    symbol_t<void(SpaceHandle, const char*, const void*, SpaceHandle, const char*,
+                  const void*, uint64_t)>
+        kokkosp_begin_deep_copy_f = {};
+    symbol_t<void(const char*, const void* const, bool)> kokkosp_dual_view_sync_f   = {};
+    symbol_t<void(const char*, const void* const, bool)> kokkosp_dual_view_modify_f = {};
 
     // HSA functions
 #if OMNITRACE_USE_ROCTRACER > 0
-    bool (*hsa_on_load_f)(HsaApiTable*, uint64_t, uint64_t, const char* const*) = nullptr;
-    void (*hsa_on_unload_f)()                                                   = nullptr;
+    symbol_t<bool(HsaApiTable*, uint64_t, uint64_t, const char* const*)>
+                     hsa_on_load_f   = {};
+    symbol_t<void()> hsa_on_unload_f = {};
 #endif
 
     // ROCP functions
 #if OMNITRACE_USE_ROCPROFILER > 0
-    void (*rocp_on_load_tool_prop_f)(void* settings) = nullptr;
-    void (*rocp_on_unload_tool_f)()                  = nullptr;
+    symbol_t<void(void* settings)> rocp_on_load_tool_prop_f = {};
+    symbol_t<void()>               rocp_on_unload_tool_f    = {};
 #endif
 
     // OpenMP functions
 #if defined(OMNITRACE_USE_OMPT) && OMNITRACE_USE_OMPT > 0
-    ompt_start_tool_result_t* (*ompt_start_tool_f)(unsigned int, const char*);
+    symbol_t<ompt_start_tool_result_t*(unsigned int, const char*)> ompt_start_tool_f = {};
 #endif
 
     auto get_omni_library() const { return m_omnilib; }
@@ -499,6 +674,15 @@ get_indirect()
     return *_v;
 }
 
+// configures libomnitrace-user without loading libomnitrace
+void
+configure_user_library()
+{
+    static auto _libuser = get_env("OMNITRACE_USER_LIBRARY", "libomnitrace-user.so");
+    indirect::configure_user(
+        indirect::open(common::path::find_path(_libuser, _omnitrace_dl_verbose)));
+}
+
 auto&
 get_inited()
 {
@@ -541,6 +725,32 @@ get_thread_count()
     return _v;
 }
 
+// false while outside of the trace windows (OMNITRACE_TRACE_DELAY,
+// OMNITRACE_TRACE_DURATION, OMNITRACE_TRACE_PERIODS)
+auto&
+get_window_open()
+{
+    static auto* _v = new std::atomic<bool>{ true };
+    return *_v;
+}
+
+// depth of the instrumented functions entered while outside of the trace windows
+auto&
+get_window_count()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
+// depth of the instrumented functions entered after the trace window opened while
+// the functions entered before it opened have not returned
+auto&
+get_window_depth()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
 auto&
 get_thread_status()
 {
@@ -555,6 +765,23 @@ get_instrumented()
     return _v;
 }
 
+// the arguments to omnitrace_init when OMNITRACE_LAZY_INIT deferred it until the first
+// enabled event
+struct deferred_init
+{
+    std::atomic<bool> pending = { false };
+    std::string       mode    = {};
+    bool              rewrite = false;
+    std::string       exe     = {};
+};
+
+auto&
+get_deferred_init()
+{
+    static auto* _v = new deferred_init{};
+    return *_v;
+}
+
 // ensure finalization is called
 bool _omnitrace_dl_fini = (std::atexit([]() {
                                if(get_active()) omnitrace_finalize();
@@ -591,6 +818,265 @@ bool _omnitrace_dl_fini = (std::atexit([]() {
         fflush(stderr);                                                                  \
     }
 
+namespace omnitrace
+{
+namespace dl
+{
+namespace
+{
+// omnitrace_push_trace and omnitrace_pop_trace are invoked by every instrumented
+// function so, instead of checking get_active() and get_thread_enabled() on every
+// call, each thread calls through a dispatch table which is swapped whenever
+// omnitrace is activated/deactivated, the thread is paused/resumed, or a trace window
+// opens/closes. The table of every thread is reset to the resolve table when the
+// process-wide state changes and the resolve table selects the appropriate table on
+// the next call.
+struct trace_dispatch
+{
+    void (*push_trace)(const char*) = nullptr;
+    void (*pop_trace)(const char*)  = nullptr;
+};
+
+void
+resolve_push_trace(const char*);
+void
+resolve_pop_trace(const char*);
+
+void
+lazy_init();
+
+void
+inactive_trace(const char*)
+{}
+
+const trace_dispatch*
+update_thread_dispatch();
+
+void
+paused_push_trace(const char*)
+{
+    ++get_thread_count();
+}
+
+void
+paused_pop_trace(const char*)
+{
+    if(get_thread_count()-- == 0) omnitrace_user_start_thread_trace_dl();
+}
+
+void
+enabled_push_trace(const char* name)
+{
+    ::omnitrace::common::invoke("omnitrace_push_trace", _omnitrace_dl_verbose,
+                                (get_thread_status() = false),
+                                get_indirect().omnitrace_push_trace_f, name);
+}
+
+void
+enabled_pop_trace(const char* name)
+{
+    ::omnitrace::common::invoke("omnitrace_pop_trace", _omnitrace_dl_verbose,
+                                (get_thread_status() = false),
+                                get_indirect().omnitrace_pop_trace_f, name);
+}
+
+// outside of the trace windows the functions entered are not forwarded to libomnitrace
+// but the functions which were entered inside the window are still exited
+void
+closed_push_trace(const char*)
+{
+    ++get_window_count();
+}
+
+void
+closed_pop_trace(const char* name)
+{
+    if(get_window_count() == 0)
+        enabled_pop_trace(name);
+    else
+        --get_window_count();
+}
+
+// the trace window opened while functions entered outside of it have not returned.
+// Once they have all returned, the thread switches to the enabled table
+void
+opened_push_trace(const char* name)
+{
+    ++get_window_depth();
+    enabled_push_trace(name);
+}
+
+void
+opened_pop_trace(const char* name)
+{
+    if(get_window_depth() > 0)
+    {
+        --get_window_depth();
+        enabled_pop_trace(name);
+    }
+    else if(--get_window_count() == 0)
+    {
+        update_thread_dispatch();
+    }
+}
+
+constexpr trace_dispatch resolve_dispatch  = { &resolve_push_trace, &resolve_pop_trace };
+constexpr trace_dispatch inactive_dispatch = { &inactive_trace, &inactive_trace };
+constexpr trace_dispatch paused_dispatch   = { &paused_push_trace, &paused_pop_trace };
+constexpr trace_dispatch enabled_dispatch  = { &enabled_push_trace, &enabled_pop_trace };
+constexpr trace_dispatch closed_dispatch   = { &closed_push_trace, &closed_pop_trace };
+constexpr trace_dispatch opened_dispatch   = { &opened_push_trace, &opened_pop_trace };
+
+using dispatch_pointer_t = std::atomic<const trace_dispatch*>;
+
+// constant-initialized so that accessing it does not require a TLS init guard
+auto&
+get_thread_dispatch()
+{
+    static thread_local dispatch_pointer_t _v{ &resolve_dispatch };
+    return _v;
+}
+
+struct dispatch_registry
+{
+    std::mutex                       mutex   = {};
+    std::vector<dispatch_pointer_t*> threads = {};
+};
+
+auto&
+get_dispatch_registry()
+{
+    static auto* _v = new dispatch_registry{};
+    return *_v;
+}
+
+struct dispatch_registration
+{
+    dispatch_registration()
+    {
+        auto& _registry = get_dispatch_registry();
+        auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+        _registry.threads.emplace_back(&get_thread_dispatch());
+    }
+
+    ~dispatch_registration()
+    {
+        auto& _registry = get_dispatch_registry();
+        auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+        auto& _threads  = _registry.threads;
+        auto* _dispatch = &get_thread_dispatch();
+        _threads.erase(std::remove(_threads.begin(), _threads.end(), _dispatch),
+                       _threads.end());
+        // any calls during the remainder of the thread exit are ignored
+        get_thread_dispatch().store(&inactive_dispatch, std::memory_order_relaxed);
+    }
+
+    dispatch_registration(const dispatch_registration&)     = delete;
+    dispatch_registration(dispatch_registration&&) noexcept = delete;
+    dispatch_registration& operator=(const dispatch_registration&) = delete;
+    dispatch_registration& operator=(dispatch_registration&&) noexcept = delete;
+};
+
+// selects the dispatch table of the calling thread. The selection is performed while
+// holding the registry lock so that it cannot overwrite a concurrent reset.
+const trace_dispatch*
+update_thread_dispatch()
+{
+    static thread_local dispatch_registration _registration{};
+    (void) _registration;
+
+    auto  _lk = std::unique_lock<std::mutex>{ get_dispatch_registry().mutex };
+    auto* _v  = (!get_active())              ? &inactive_dispatch
+                : (!get_thread_enabled())    ? &paused_dispatch
+                : (!get_window_open())       ? &closed_dispatch
+                : (get_window_count() > 0)   ? &opened_dispatch
+                                             : &enabled_dispatch;
+    // if the window closes again before the functions entered outside of the previous
+    // window have returned, the exits of those functions are forwarded
+    if(_v == &closed_dispatch && get_window_depth() > 0) get_window_count() = 0;
+    if(_v != &opened_dispatch) get_window_depth() = 0;
+    get_thread_dispatch().store(_v, std::memory_order_relaxed);
+    return _v;
+}
+
+// invoked after the process-wide state changes
+void
+reset_dispatch()
+{
+    auto& _registry = get_dispatch_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+    for(auto* itr : _registry.threads)
+        itr->store(&resolve_dispatch, std::memory_order_relaxed);
+}
+
+void
+resolve_push_trace(const char* name)
+{
+    lazy_init();
+    update_thread_dispatch()->push_trace(name);
+}
+
+void
+resolve_pop_trace(const char* name)
+{
+    update_thread_dispatch()->pop_trace(name);
+}
+
+// invoked by the entry points which begin an event. Performs the omnitrace_init
+// deferred by OMNITRACE_LAZY_INIT once the calling thread is enabled
+void
+lazy_init()
+{
+    auto& _deferred = get_deferred_init();
+    if(OMNITRACE_LIKELY(!_deferred.pending.load(std::memory_order_relaxed))) return;
+    if(!get_thread_enabled()) return;
+    // events on other threads and the re-entrant events of the initialization are
+    // dropped until omnitrace is active
+    if(!_deferred.pending.exchange(false)) return;
+
+    OMNITRACE_DL_LOG(1, "%s :: performing the deferred initialization\n", __FUNCTION__);
+    get_init_timing().lazy_trigger = true;
+    omnitrace_init(_deferred.mode.c_str(), _deferred.rewrite, _deferred.exe.c_str());
+}
+
+void
+defer_init(const std::string& _mode, bool _rewrite, const char* _exe)
+{
+    auto& _deferred   = get_deferred_init();
+    _deferred.mode    = _mode;
+    _deferred.rewrite = _rewrite;
+    _deferred.exe     = (_exe) ? std::string{ _exe } : std::string{};
+
+    // the user API forwards to omnitrace-dl so it has to be configured up front
+    configure_user_library();
+    _deferred.pending.store(true);
+
+    OMNITRACE_DL_LOG(1, "%s :: omnitrace_init is deferred until the first event\n",
+                     __FUNCTION__);
+}
+
+// reports the time spent loading and initializing libomnitrace
+void
+report_init_timing(init_timing::clock_type::time_point _beg)
+{
+    auto& _timing     = get_init_timing();
+    _timing.init_msec = init_timing::elapsed_msec(_beg);
+
+    if(!get_env("OMNITRACE_DL_INIT_TIMING", false) && _omnitrace_dl_verbose < 1) return;
+
+    OMNITRACE_DL_LOG(
+        std::min(_omnitrace_dl_verbose, 0),
+        "init timing :: dlopen = %.3f msec, dlsym = %.3f msec (%zu symbols), "
+        "omnitrace_init = %.3f msec, %.3f msec after libomnitrace-dl was loaded%s\n",
+        _timing.dlopen_msec, 1.0e-6 * _timing.dlsym_nsec.load(),
+        _timing.num_symbols.load(), _timing.init_msec,
+        init_timing::elapsed_msec(_timing.load),
+        (_timing.lazy_trigger) ? " (deferred)" : "");
+}
+}  // namespace
+}  // namespace dl
+}  // namespace omnitrace
+
 using omnitrace::dl::get_indirect;
 namespace dl = omnitrace::dl;
 
@@ -634,6 +1120,7 @@ extern "C"
             return;
         }
 
+        auto _beg = dl::init_timing::clock_type::now();
         if(dl::get_instrumented() < dl::InstrumentMode::PythonProfile)
             dl::omnitrace_preinit();
 
@@ -644,8 +1131,10 @@ extern "C"
             dl::get_active()          = true;
             dl::get_inited()          = true;
             dl::_omnitrace_dl_verbose = dl::get_omnitrace_dl_env();
+            dl::reset_dispatch();
             if(dl::get_instrumented() < dl::InstrumentMode::PythonProfile)
                 dl::omnitrace_postinit((c) ? std::string{ c } : std::string{});
+            dl::report_init_timing(_beg);
         }
     }
 
@@ -663,6 +1152,12 @@ extern "C"
                              __FUNCTION__);
             return;
         }
+        else if(dl::get_deferred_init().pending.exchange(false))
+        {
+            OMNITRACE_DL_LOG(1, "%s() ignored :: the deferred init was never triggered\n",
+                             __FUNCTION__);
+            return;
+        }
 
         bool _invoked = false;
         OMNITRACE_DL_INVOKE_STATUS(_invoked, get_indirect().omnitrace_finalize_f);
@@ -670,41 +1165,57 @@ extern "C"
         {
             dl::get_active() = false;
             dl::get_finied() = true;
+            dl::reset_dispatch();
         }
     }
 
     void omnitrace_push_trace(const char* name)
     {
-        if(!dl::get_active()) return;
+        dl::get_thread_dispatch().load(std::memory_order_relaxed)->push_trace(name);
+    }
+
+    void omnitrace_pop_trace(const char* name)
+    {
+        dl::get_thread_dispatch().load(std::memory_order_relaxed)->pop_trace(name);
+    }
+
+    int omnitrace_push_region(const char* name)
+    {
+        dl::lazy_init();
+        if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
-            OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_trace_f, name);
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_f, name);
         }
         else
         {
             ++dl::get_thread_count();
         }
+        return 0;
     }
 
-    void omnitrace_pop_trace(const char* name)
+    int omnitrace_pop_region(const char* name)
     {
-        if(!dl::get_active()) return;
+        if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
-            OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_trace_f, name);
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_f, name);
         }
         else
         {
             if(dl::get_thread_count()-- == 0) omnitrace_user_start_thread_trace_dl();
         }
+        return 0;
     }
 
-    int omnitrace_push_region(const char* name)
+    int omnitrace_push_sampled_region(const char* name, size_t rate)
     {
+        dl::lazy_init();
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
-            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_f, name);
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_sampled_region_f,
+                                       name, rate);
         }
         else
         {
@@ -713,12 +1224,91 @@ extern "C"
         return 0;
     }
 
-    int omnitrace_pop_region(const char* name)
+    int omnitrace_pop_sampled_region(const char* name)
     {
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
-            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_f, name);
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_sampled_region_f,
+                                       name);
+        }
+        else
+        {
+            if(dl::get_thread_count()-- == 0) omnitrace_user_start_thread_trace_dl();
+        }
+        return 0;
+    }
+
+    omnitrace_region_handle_t omnitrace_register_region(const char* name)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_region_f, name);
+    }
+
+    int omnitrace_push_region_handle(omnitrace_region_handle_t _region)
+    {
+        dl::lazy_init();
+        if(!dl::get_active()) return 0;
+        if(dl::get_thread_enabled())
+        {
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_handle_f,
+                                       _region);
+        }
+        else
+        {
+            ++dl::get_thread_count();
+        }
+        return 0;
+    }
+
+    int omnitrace_pop_region_handle(omnitrace_region_handle_t _region)
+    {
+        if(!dl::get_active()) return 0;
+        if(dl::get_thread_enabled())
+        {
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_handle_f,
+                                       _region);
+        }
+        else
+        {
+            if(dl::get_thread_count()-- == 0) omnitrace_user_start_thread_trace_dl();
+        }
+        return 0;
+    }
+
+    omnitrace_annotation_schema_t omnitrace_register_annotation_schema(
+        const omnitrace_annotation_field_t* _fields, size_t _num_fields)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_annotation_schema_f,
+                                   _fields, _num_fields);
+    }
+
+    int omnitrace_push_schema_region(const char*                   name,
+                                     omnitrace_annotation_schema_t _schema,
+                                     const void*                   _values)
+    {
+        dl::lazy_init();
+        if(!dl::get_active()) return 0;
+        if(dl::get_thread_enabled())
+        {
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_schema_region_f,
+                                       name, _schema, _values);
+        }
+        else
+        {
+            ++dl::get_thread_count();
+        }
+        return 0;
+    }
+
+    int omnitrace_pop_schema_region(const char*                   name,
+                                    omnitrace_annotation_schema_t _schema,
+                                    const void*                   _values)
+    {
+        if(!dl::get_active()) return 0;
+        if(dl::get_thread_enabled())
+        {
+            return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_schema_region_f, name,
+                                       _schema, _values);
         }
         else
         {
@@ -731,6 +1321,7 @@ extern "C"
                                        omnitrace_annotation_t* _annotations,
                                        size_t                  _annotation_count)
     {
+        dl::lazy_init();
         if(!dl::get_active()) return 0;
         if(dl::get_thread_enabled())
         {
@@ -784,18 +1375,53 @@ extern "C"
     }
 
     void omnitrace_register_source(const char* file, const char* func, size_t line,
-                                   size_t address, const char* source)
+                                   size_t address, const char* source, size_t index)
     {
-        OMNITRACE_DL_LOG(3, "%s(\"%s\", \"%s\", %zu, %zu, \"%s\")\n", __FUNCTION__, file,
-                         func, line, address, source);
+        OMNITRACE_DL_LOG(3, "%s(\"%s\", \"%s\", %zu, %zu, \"%s\", %zu)\n", __FUNCTION__,
+                         file, func, line, address, source, index);
         OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_source_f, file, func, line,
-                            address, source);
+                            address, source, index);
+    }
+
+    void omnitrace_register_coverage(size_t index)
+    {
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_coverage_f, index);
+    }
+
+    void omnitrace_register_call_counter(const char* file, const char* func,
+                                         uint64_t* counter)
+    {
+        OMNITRACE_DL_LOG(3, "%s(\"%s\", \"%s\", %p)\n", __FUNCTION__, file, func,
+                         (void*) counter);
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_call_counter_f, file, func,
+                            counter);
     }
 
-    void omnitrace_register_coverage(const char* file, const char* func, size_t address)
+    void omnitrace_register_loop_counter(const char* file, const char* loop,
+                                         uint64_t* entries, uint64_t* trips)
     {
-        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_coverage_f, file, func,
-                            address);
+        OMNITRACE_DL_LOG(3, "%s(\"%s\", \"%s\", %p, %p)\n", __FUNCTION__, file, loop,
+                         (void*) entries, (void*) trips);
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_loop_counter_f, file, loop,
+                            entries, trips);
+    }
+
+    void omnitrace_register_python_sampler(
+        size_t (*stack_func)(uintptr_t*, size_t),
+        int (*frame_func)(uintptr_t, const char**, const char**, int*))
+    {
+        OMNITRACE_DL_LOG(3, "%s(%p, %p)\n", __FUNCTION__,
+                         reinterpret_cast<void*>(stack_func),
+                         reinterpret_cast<void*>(frame_func));
+        OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_python_sampler_f,
+                            stack_func, frame_func);
+    }
+
+    void omnitrace_trace_window_dl(bool _open)
+    {
+        OMNITRACE_DL_LOG(2, "%s(%s)\n", __FUNCTION__, (_open) ? "true" : "false");
+        dl::get_window_open().store(_open);
+        dl::reset_dispatch();
     }
 
     int omnitrace_user_start_trace_dl(void)
@@ -813,17 +1439,21 @@ extern "C"
     int omnitrace_user_start_thread_trace_dl(void)
     {
         dl::get_thread_enabled() = true;
+        dl::lazy_init();
+        dl::update_thread_dispatch();
         return 0;
     }
 
     int omnitrace_user_stop_thread_trace_dl(void)
     {
         dl::get_thread_enabled() = false;
+        dl::update_thread_dispatch();
         return 0;
     }
 
     int omnitrace_user_push_region_dl(const char* name)
     {
+        dl::lazy_init();
         if(!dl::get_active()) return 0;
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_f, name);
     }
@@ -834,16 +1464,77 @@ extern "C"
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_f, name);
     }
 
+    int omnitrace_user_push_sampled_region_dl(const char* name, size_t rate)
+    {
+        dl::lazy_init();
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_sampled_region_f, name,
+                                   rate);
+    }
+
+    int omnitrace_user_pop_sampled_region_dl(const char* name)
+    {
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_sampled_region_f, name);
+    }
+
+    omnitrace_region_handle_t omnitrace_user_register_region_dl(const char* name)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_region_f, name);
+    }
+
+    int omnitrace_user_push_region_handle_dl(omnitrace_region_handle_t _region)
+    {
+        dl::lazy_init();
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_handle_f,
+                                   _region);
+    }
+
+    int omnitrace_user_pop_region_handle_dl(omnitrace_region_handle_t _region)
+    {
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_handle_f,
+                                   _region);
+    }
+
     int omnitrace_user_progress_dl(const char* name)
     {
         OMNITRACE_DL_INVOKE(get_indirect().omnitrace_progress_f, name);
         return 0;
     }
 
+    omnitrace_annotation_schema_t omnitrace_user_register_annotation_schema_dl(
+        const omnitrace_annotation_field_t* _fields, size_t _num_fields)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_annotation_schema_f,
+                                   _fields, _num_fields);
+    }
+
+    int omnitrace_user_push_schema_region_dl(const char*                   name,
+                                             omnitrace_annotation_schema_t _schema,
+                                             const void*                   _values)
+    {
+        dl::lazy_init();
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_schema_region_f, name,
+                                   _schema, _values);
+    }
+
+    int omnitrace_user_pop_schema_region_dl(const char*                   name,
+                                            omnitrace_annotation_schema_t _schema,
+                                            const void*                   _values)
+    {
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_schema_region_f, name,
+                                   _schema, _values);
+    }
+
     int omnitrace_user_push_annotated_region_dl(const char*             name,
                                                 omnitrace_annotation_t* _annotations,
                                                 size_t                  _annotation_count)
     {
+        dl::lazy_init();
         if(!dl::get_active()) return 0;
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_category_region_f,
                                    OMNITRACE_CATEGORY_USER, name, _annotations,
@@ -869,6 +1560,12 @@ extern "C"
         return 0;
     }
 
+    int omnitrace_user_trigger_snapshot_dl(void)
+    {
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_trigger_snapshot_f);
+    }
+
     void omnitrace_progress(const char* _name)
     {
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_progress_f, _name);
@@ -882,6 +1579,11 @@ extern "C"
                                    _annotations, _annotation_count);
     }
 
+    int omnitrace_trigger_snapshot(void)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_trigger_snapshot_f);
+    }
+
     void omnitrace_set_instrumented(int _mode)
     {
         OMNITRACE_DL_LOG(2, "%s(%i)\n", __FUNCTION__, _mode);
@@ -1433,10 +2135,12 @@ extern "C"
             }
         }
 
-        auto _mode = get_env("OMNITRACE_MODE", get_default_mode());
-        omnitrace_init(_mode.c_str(),
-                       dl::get_instrumented() == dl::InstrumentMode::BinaryRewrite,
-                       argv[0]);
+        auto _mode    = get_env("OMNITRACE_MODE", get_default_mode());
+        auto _rewrite = (dl::get_instrumented() == dl::InstrumentMode::BinaryRewrite);
+        if(dl::get_lazy_init())
+            dl::defer_init(_mode, _rewrite, argv[0]);
+        else
+            omnitrace_init(_mode.c_str(), _rewrite, argv[0]);
 
         int ret = (*::omnitrace::dl::main_real)(argc, argv, envp);
 
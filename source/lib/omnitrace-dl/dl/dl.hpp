@@ -81,6 +81,8 @@ extern "C"
     void omnitrace_pop_trace(const char* name) OMNITRACE_PUBLIC_API;
     int  omnitrace_push_region(const char*) OMNITRACE_PUBLIC_API;
     int  omnitrace_pop_region(const char*) OMNITRACE_PUBLIC_API;
+    int  omnitrace_push_sampled_region(const char*, size_t) OMNITRACE_PUBLIC_API;
+    int  omnitrace_pop_sampled_region(const char*) OMNITRACE_PUBLIC_API;
     int  omnitrace_push_category_region(omnitrace_category_t, const char*,
                                         omnitrace_annotation_t*,
                                         size_t) OMNITRACE_PUBLIC_API;
@@ -88,19 +90,41 @@ extern "C"
                                        omnitrace_annotation_t*,
                                        size_t) OMNITRACE_PUBLIC_API;
 
+    omnitrace_region_handle_t omnitrace_register_region(const char*) OMNITRACE_PUBLIC_API;
+    int omnitrace_push_region_handle(omnitrace_region_handle_t) OMNITRACE_PUBLIC_API;
+    int omnitrace_pop_region_handle(omnitrace_region_handle_t) OMNITRACE_PUBLIC_API;
+
+    omnitrace_annotation_schema_t omnitrace_register_annotation_schema(
+        const omnitrace_annotation_field_t*, size_t) OMNITRACE_PUBLIC_API;
+    int omnitrace_push_schema_region(const char*, omnitrace_annotation_schema_t,
+                                     const void*) OMNITRACE_PUBLIC_API;
+    int omnitrace_pop_schema_region(const char*, omnitrace_annotation_schema_t,
+                                    const void*) OMNITRACE_PUBLIC_API;
+
     void omnitrace_register_source(const char* file, const char* func, size_t line,
-                                   size_t      address,
-                                   const char* source) OMNITRACE_PUBLIC_API;
-    void omnitrace_register_coverage(const char* file, const char* func,
-                                     size_t address) OMNITRACE_PUBLIC_API;
+                                   size_t address, const char* source,
+                                   size_t index) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_coverage(size_t index) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_call_counter(const char* file, const char* func,
+                                         uint64_t* counter) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_loop_counter(const char* file, const char* loop,
+                                         uint64_t* entries,
+                                         uint64_t* trips) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_python_sampler(
+        size_t (*stack_func)(uintptr_t*, size_t),
+        int (*frame_func)(uintptr_t, const char**, const char**, int*))
+        OMNITRACE_PUBLIC_API;
     void omnitrace_progress(const char*) OMNITRACE_PUBLIC_API;
     void omnitrace_annotated_progress(const char*, omnitrace_annotation_t*,
                                       size_t) OMNITRACE_PUBLIC_API;
+    int  omnitrace_trigger_snapshot(void) OMNITRACE_PUBLIC_API;
 
 #if defined(OMNITRACE_DL_SOURCE) && (OMNITRACE_DL_SOURCE > 0)
     void omnitrace_preinit_library(void) OMNITRACE_HIDDEN_API;
     int  omnitrace_preload_library(void) OMNITRACE_HIDDEN_API;
 
+    void omnitrace_trace_window_dl(bool) OMNITRACE_HIDDEN_API;
+
     int omnitrace_user_start_trace_dl(void) OMNITRACE_HIDDEN_API;
     int omnitrace_user_stop_trace_dl(void) OMNITRACE_HIDDEN_API;
 
@@ -110,6 +134,23 @@ extern "C"
     int omnitrace_user_push_region_dl(const char*) OMNITRACE_HIDDEN_API;
     int omnitrace_user_pop_region_dl(const char*) OMNITRACE_HIDDEN_API;
 
+    int omnitrace_user_push_sampled_region_dl(const char*, size_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_pop_sampled_region_dl(const char*) OMNITRACE_HIDDEN_API;
+
+    omnitrace_region_handle_t omnitrace_user_register_region_dl(const char*)
+        OMNITRACE_HIDDEN_API;
+    int omnitrace_user_push_region_handle_dl(omnitrace_region_handle_t)
+        OMNITRACE_HIDDEN_API;
+    int omnitrace_user_pop_region_handle_dl(omnitrace_region_handle_t)
+        OMNITRACE_HIDDEN_API;
+
+    omnitrace_annotation_schema_t omnitrace_user_register_annotation_schema_dl(
+        const omnitrace_annotation_field_t*, size_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_push_schema_region_dl(const char*, omnitrace_annotation_schema_t,
+                                             const void*) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_pop_schema_region_dl(const char*, omnitrace_annotation_schema_t,
+                                            const void*) OMNITRACE_HIDDEN_API;
+
     int omnitrace_user_push_annotated_region_dl(const char*, omnitrace_annotation_t*,
                                                 size_t) OMNITRACE_HIDDEN_API;
     int omnitrace_user_pop_annotated_region_dl(const char*, omnitrace_annotation_t*,
@@ -118,6 +159,7 @@ extern "C"
     int omnitrace_user_progress_dl(const char* name) OMNITRACE_HIDDEN_API;
     int omnitrace_user_annotated_progress_dl(const char*, omnitrace_annotation_t*,
                                              size_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_trigger_snapshot_dl(void) OMNITRACE_HIDDEN_API;
     // KokkosP
     struct OMNITRACE_HIDDEN_API SpaceHandle
     {
@@ -82,6 +82,17 @@ extern "C"
         OMNITRACE_CATEGORY_NUMA,
         OMNITRACE_CATEGORY_TIMER_SAMPLING,
         OMNITRACE_CATEGORY_OVERFLOW_SAMPLING,
+        OMNITRACE_CATEGORY_DEVICE_OMPT,
+        OMNITRACE_CATEGORY_CPU_SAMPLING,
+        OMNITRACE_CATEGORY_OFF_CPU,
+        OMNITRACE_CATEGORY_SELF_OVERHEAD,
+        OMNITRACE_CATEGORY_HEAP,
+        OMNITRACE_CATEGORY_IO,
+        OMNITRACE_CATEGORY_NETWORK,
+        OMNITRACE_CATEGORY_CPU_ENERGY,
+        OMNITRACE_CATEGORY_CGROUP,
+        OMNITRACE_CATEGORY_PYTHON_GIL,
+        OMNITRACE_CATEGORY_MEMORY_BANDWIDTH,
         OMNITRACE_CATEGORY_LAST
         // the value of below enum is used for iterating
         // over the enum in C++ templates. It MUST
@@ -184,6 +195,39 @@ extern "C"
         void* value;
     } omnitrace_annotation_t;
 
+    /// @struct omnitrace_annotation_field
+    /// @brief A struct describing one field of a packed value struct which is passed
+    /// to the regions of a registered annotation schema.
+    ///
+    /// @code{.cpp}
+    /// struct solver_values
+    /// {
+    ///     size_t iteration;
+    ///     double residual;
+    /// };
+    ///
+    /// static omnitrace_annotation_field_t _fields[] = {
+    ///     { "iteration", OMNITRACE_VALUE_SIZE_T, offsetof(solver_values, iteration) },
+    ///     { "residual", OMNITRACE_VALUE_FLOAT64, offsetof(solver_values, residual) },
+    /// };
+    ///
+    /// static omnitrace_annotation_schema_t _schema =
+    ///     omnitrace_user_register_annotation_schema(_fields, 2);
+    ///
+    /// solver_values _values = { i, residual };
+    /// omnitrace_user_push_schema_region("compute", _schema, &_values);
+    /// @endcode
+    /// @typedef omnitrace_annotation_field omnitrace_annotation_field_t
+    typedef struct omnitrace_annotation_field
+    {
+        /// label for annotation
+        const char* name;
+        /// omnitrace_annotation_type_t
+        uintptr_t type;
+        /// offset of the value in the packed value struct
+        size_t offset;
+    } omnitrace_annotation_field_t;
+
 #if defined(__cplusplus)
 }
 #endif
@@ -32,10 +32,34 @@ extern "C"
 #endif
 
     struct omnitrace_annotation;
+    struct omnitrace_region;
+    struct omnitrace_annotation_field;
+    struct omnitrace_annotation_schema;
+
+    /// @typedef omnitrace_region_handle_t
+    /// @brief Opaque handle to a region registered via omnitrace_register_region. The
+    /// handle remains valid for the lifetime of the process.
+    typedef const struct omnitrace_region* omnitrace_region_handle_t;
+
+    /// @typedef omnitrace_annotation_schema_t
+    /// @brief Opaque handle to an annotation schema registered via
+    /// omnitrace_register_annotation_schema. The handle remains valid for the lifetime
+    /// of the process.
+    typedef const struct omnitrace_annotation_schema* omnitrace_annotation_schema_t;
+
     typedef int (*omnitrace_trace_func_t)(void);
     typedef int (*omnitrace_region_func_t)(const char*);
-    typedef int (*omnitrace_annotated_region_func_t)(const char*, omnitrace_annotation*,
+    typedef int (*omnitrace_annotated_region_func_t)(const char*,
+                                                     struct omnitrace_annotation*,
                                                      size_t);
+    typedef omnitrace_region_handle_t (*omnitrace_register_region_func_t)(const char*);
+    typedef int (*omnitrace_region_handle_func_t)(omnitrace_region_handle_t);
+    typedef int (*omnitrace_sampled_region_func_t)(const char*, size_t);
+    typedef omnitrace_annotation_schema_t (*omnitrace_register_annotation_schema_func_t)(
+        const struct omnitrace_annotation_field*, size_t);
+    typedef int (*omnitrace_schema_region_func_t)(const char*,
+                                                  omnitrace_annotation_schema_t,
+                                                  const void*);
 
     /// @struct omnitrace_user_callbacks
     /// @brief Struct containing the callbacks for the user API
@@ -43,16 +67,25 @@ extern "C"
     /// @typedef omnitrace_user_callbacks omnitrace_user_callbacks_t
     typedef struct omnitrace_user_callbacks
     {
-        omnitrace_trace_func_t            start_trace;
-        omnitrace_trace_func_t            stop_trace;
-        omnitrace_trace_func_t            start_thread_trace;
-        omnitrace_trace_func_t            stop_thread_trace;
-        omnitrace_region_func_t           push_region;
-        omnitrace_region_func_t           pop_region;
-        omnitrace_region_func_t           progress;
-        omnitrace_annotated_region_func_t push_annotated_region;
-        omnitrace_annotated_region_func_t pop_annotated_region;
-        omnitrace_annotated_region_func_t annotated_progress;
+        omnitrace_trace_func_t                      start_trace;
+        omnitrace_trace_func_t                      stop_trace;
+        omnitrace_trace_func_t                      start_thread_trace;
+        omnitrace_trace_func_t                      stop_thread_trace;
+        omnitrace_region_func_t                     push_region;
+        omnitrace_region_func_t                     pop_region;
+        omnitrace_region_func_t                     progress;
+        omnitrace_annotated_region_func_t           push_annotated_region;
+        omnitrace_annotated_region_func_t           pop_annotated_region;
+        omnitrace_annotated_region_func_t           annotated_progress;
+        omnitrace_trace_func_t                      trigger_snapshot;
+        omnitrace_register_region_func_t            register_region;
+        omnitrace_region_handle_func_t              push_region_handle;
+        omnitrace_region_handle_func_t              pop_region_handle;
+        omnitrace_sampled_region_func_t             push_sampled_region;
+        omnitrace_region_func_t                     pop_sampled_region;
+        omnitrace_register_annotation_schema_func_t register_annotation_schema;
+        omnitrace_schema_region_func_t              push_schema_region;
+        omnitrace_schema_region_func_t              pop_schema_region;
 
         /// @var start_trace
         /// @brief callback for enabling tracing globally
@@ -74,6 +107,24 @@ extern "C"
         /// @brief callback for ending a trace region + annotations
         /// @var annotated_progress
         /// @brief callback for marking an causal profiling event + annotations
+        /// @var trigger_snapshot
+        /// @brief callback for writing a snapshot of the trace ring buffer
+        /// @var register_region
+        /// @brief callback for registering a region name and returning its handle
+        /// @var push_region_handle
+        /// @brief callback for starting a trace region via a registered handle
+        /// @var pop_region_handle
+        /// @brief callback for ending a trace region via a registered handle
+        /// @var push_sampled_region
+        /// @brief callback for starting a trace region which is recorded 1-in-N times
+        /// @var pop_sampled_region
+        /// @brief callback for ending a trace region which is recorded 1-in-N times
+        /// @var register_annotation_schema
+        /// @brief callback for registering the fields of a packed annotation struct
+        /// @var push_schema_region
+        /// @brief callback for starting a trace region + packed annotation values
+        /// @var pop_schema_region
+        /// @brief callback for ending a trace region + packed annotation values
     } omnitrace_user_callbacks_t;
 
     /// @enum OMNITRACE_USER_CONFIGURE_MODE
@@ -110,7 +161,8 @@ extern "C"
 #ifndef OMNITRACE_USER_CALLBACKS_INIT
 #    define OMNITRACE_USER_CALLBACKS_INIT                                                \
         {                                                                                \
-            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL                   \
+            NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,      \
+                NULL, NULL, NULL, NULL, NULL, NULL, NULL                                 \
         }
 #endif
 
@@ -104,6 +104,97 @@ extern "C"
     extern int omnitrace_user_pop_annotated_region(const char*, omnitrace_annotation_t*,
                                                    size_t) OMNITRACE_PUBLIC_API;
 
+    /// @fn int omnitrace_user_push_sampled_region(const char* id, size_t rate)
+    /// @param id The string identifier for the region
+    /// @param rate Record one in every N instances of the region on the calling thread.
+    /// Zero selects N such that the region is recorded approximately
+    /// OMNITRACE_REGION_SAMPLE_TARGET times per second.
+    /// @return omnitrace_user_error_t value
+    /// @brief Start a user defined region of which only a subset of the instances is
+    /// traced and profiled. Every instance is counted and the statistics of the recorded
+    /// instances are scaled by the ratio of the counts when omnitrace finalizes.
+    extern int omnitrace_user_push_sampled_region(const char*,
+                                                  size_t) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_pop_sampled_region(const char* id)
+    /// @param id The string identifier for the region
+    /// @return omnitrace_user_error_t value
+    /// @brief Stop a user defined region started via
+    /// @ref omnitrace_user_push_sampled_region.
+    extern int omnitrace_user_pop_sampled_region(const char*) OMNITRACE_PUBLIC_API;
+
+    /// @fn omnitrace_annotation_schema_t omnitrace_user_register_annotation_schema(
+    ///     const omnitrace_annotation_field_t* fields, size_t num_fields)
+    /// @param fields Array of @ref omnitrace_annotation_field instances
+    /// @param num_fields Number of fields
+    /// @return Handle for the schema or NULL if omnitrace is not loaded or a field is
+    /// invalid
+    /// @brief Register the names, types, and offsets of the fields of a packed value
+    /// struct once so that the annotations of a region only require passing a pointer
+    /// to the struct. The names are copied.
+    extern omnitrace_annotation_schema_t omnitrace_user_register_annotation_schema(
+        const omnitrace_annotation_field_t*, size_t) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_push_schema_region(const char* id,
+    ///                                           omnitrace_annotation_schema_t schema,
+    ///                                           const void* values)
+    /// @param id The string identifier for the region
+    /// @param schema The handle returned by
+    /// @ref omnitrace_user_register_annotation_schema
+    /// @param values Pointer to the packed value struct described by the schema
+    /// @return omnitrace_user_error_t value
+    /// @brief Start a user defined region and adds the fields of the value struct to
+    /// the perfetto trace.
+    extern int omnitrace_user_push_schema_region(const char*,
+                                                 omnitrace_annotation_schema_t,
+                                                 const void*) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_pop_schema_region(const char* id,
+    ///                                          omnitrace_annotation_schema_t schema,
+    ///                                          const void* values)
+    /// @param id The string identifier for the region
+    /// @param schema The handle returned by
+    /// @ref omnitrace_user_register_annotation_schema
+    /// @param values Pointer to the packed value struct described by the schema or NULL
+    /// @return omnitrace_user_error_t value
+    /// @brief Stop a user defined region and adds the fields of the value struct to
+    /// the perfetto trace.
+    extern int omnitrace_user_pop_schema_region(const char*,
+                                                omnitrace_annotation_schema_t,
+                                                const void*) OMNITRACE_PUBLIC_API;
+
+    /// @fn omnitrace_region_handle_t omnitrace_user_register_region(const char* id)
+    /// @param id The string identifier for the region
+    /// @return Handle for the region or NULL if omnitrace is not loaded
+    /// @brief Register the name of a user defined region once so that the region can be
+    /// started and ended via the handle without looking up the name. Registering the
+    /// same name more than once returns the same handle.
+    extern omnitrace_region_handle_t omnitrace_user_register_region(const char*)
+        OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_push_region_handle(omnitrace_region_handle_t handle)
+    /// @param handle The handle returned by @ref omnitrace_user_register_region
+    /// @return omnitrace_user_error_t value
+    /// @brief Start a user defined region registered via
+    /// @ref omnitrace_user_register_region.
+    extern int omnitrace_user_push_region_handle(omnitrace_region_handle_t)
+        OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_pop_region_handle(omnitrace_region_handle_t handle)
+    /// @param handle The handle returned by @ref omnitrace_user_register_region
+    /// @return omnitrace_user_error_t value
+    /// @brief End a user defined region registered via
+    /// @ref omnitrace_user_register_region.
+    extern int omnitrace_user_pop_region_handle(omnitrace_region_handle_t)
+        OMNITRACE_PUBLIC_API;
+
+    /// @var omnitrace_user_region_flag
+    /// @brief Non-zero when the handle-based region callbacks are assigned, i.e. when
+    /// omnitrace is loaded and the callbacks were not removed via
+    /// @ref omnitrace_user_configure. Read by the inline functions in
+    /// omnitrace/user_fast.h and must not be written by the user.
+    extern int omnitrace_user_region_flag OMNITRACE_PUBLIC_API;
+
     /// mark causal progress
     extern int omnitrace_user_progress(const char*) OMNITRACE_PUBLIC_API;
 
@@ -111,6 +202,13 @@ extern "C"
     extern int omnitrace_user_annotated_progress(const char*, omnitrace_annotation_t*,
                                                  size_t) OMNITRACE_PUBLIC_API;
 
+    /// @fn int omnitrace_user_trigger_snapshot(void)
+    /// @return omnitrace_user_error_t value
+    /// @brief Write the current contents of the perfetto ring buffer to a snapshot
+    /// file while tracing continues. Requires OMNITRACE_PERFETTO_SNAPSHOT=ON. The
+    /// snapshot is written asynchronously by a background thread
+    extern int omnitrace_user_trigger_snapshot(void) OMNITRACE_PUBLIC_API;
+
     /// @fn int omnitrace_user_configure(omnitrace_user_configure_mode_t mode,
     ///                                  omnitrace_user_callbacks_t inp,
     ///                                  omnitrace_user_callbacks_t* out)
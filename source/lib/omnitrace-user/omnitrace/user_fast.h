@@ -0,0 +1,176 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/** @file user_fast.h */
+
+#ifndef OMNITRACE_USER_FAST_H_
+#define OMNITRACE_USER_FAST_H_
+
+/**
+ * @defgroup OMNITRACE_USER_FAST_GROUP OmniTrace Inline User Regions
+ *
+ * Header-only user regions for fine-grained regions in hot code. Each region is a
+ * static descriptor whose name is registered once, on the first push while omnitrace
+ * is active, and the push/pop then pass the registered handle instead of the name.
+ * When omnitrace is not loaded or the region callbacks were removed via
+ * omnitrace_user_configure, a push or pop only loads @ref omnitrace_user_region_flag
+ * and branches.
+ *
+ * @code{.cpp}
+ * for(int i = 0; i < n; ++i)
+ * {
+ *     OMNITRACE_USER_REGION("solve");
+ *     solve(i);
+ * }
+ * @endcode
+ *
+ * @code{.c}
+ * OMNITRACE_USER_DECLARE_REGION(solve_region, "solve");
+ * omnitrace_user_fast_push(&solve_region);
+ * solve(i);
+ * omnitrace_user_fast_pop(&solve_region);
+ * @endcode
+ *
+ * @{
+ */
+
+#include <omnitrace/user.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+    /// @struct omnitrace_user_region
+    /// @brief Static descriptor of a user region. The handle is assigned on the first
+    /// push while omnitrace is active.
+    ///
+    /// @typedef omnitrace_user_region omnitrace_user_region_t
+    typedef struct omnitrace_user_region
+    {
+        const char*               name;
+        omnitrace_region_handle_t handle;
+    } omnitrace_user_region_t;
+
+    /// @fn int omnitrace_user_fast_enabled(void)
+    /// @return Non-zero if the handle-based user regions are enabled
+    static inline int omnitrace_user_fast_enabled(void)
+    {
+        return __atomic_load_n(&omnitrace_user_region_flag, __ATOMIC_RELAXED);
+    }
+
+    /// @fn omnitrace_region_handle_t omnitrace_user_fast_handle(omnitrace_user_region_t*)
+    /// @brief Returns the handle of the region, registering the name on the first call.
+    /// Concurrent registrations of a region are benign since they return the same
+    /// handle.
+    static inline omnitrace_region_handle_t omnitrace_user_fast_handle(
+        omnitrace_user_region_t* _region)
+    {
+        omnitrace_region_handle_t _handle =
+            __atomic_load_n(&_region->handle, __ATOMIC_ACQUIRE);
+        if(__builtin_expect(_handle == NULL, 0))
+        {
+            _handle = omnitrace_user_register_region(_region->name);
+            __atomic_store_n(&_region->handle, _handle, __ATOMIC_RELEASE);
+        }
+        return _handle;
+    }
+
+    /// @fn int omnitrace_user_fast_push(omnitrace_user_region_t*)
+    /// @return Non-zero if the region was started
+    /// @brief Start the user region
+    static inline int omnitrace_user_fast_push(omnitrace_user_region_t* _region)
+    {
+        if(__builtin_expect(!omnitrace_user_fast_enabled(), 1)) return 0;
+        omnitrace_region_handle_t _handle = omnitrace_user_fast_handle(_region);
+        return (_handle != NULL &&
+                omnitrace_user_push_region_handle(_handle) == OMNITRACE_USER_SUCCESS);
+    }
+
+    /// @fn void omnitrace_user_fast_pop(omnitrace_user_region_t*)
+    /// @brief End the user region. The region is only ended if it has a handle, i.e.
+    /// it was started at least once.
+    static inline void omnitrace_user_fast_pop(omnitrace_user_region_t* _region)
+    {
+        if(__builtin_expect(!omnitrace_user_fast_enabled(), 1)) return;
+        omnitrace_region_handle_t _handle =
+            __atomic_load_n(&_region->handle, __ATOMIC_ACQUIRE);
+        if(_handle != NULL) omnitrace_user_pop_region_handle(_handle);
+    }
+
+#if defined(__cplusplus)
+}
+#endif
+
+/** @cond OMNITRACE_HIDDEN_DEFINES */
+#define OMNITRACE_USER_FAST_JOIN2(a, b) a##b
+#define OMNITRACE_USER_FAST_JOIN(a, b)  OMNITRACE_USER_FAST_JOIN2(a, b)
+#define OMNITRACE_USER_FAST_VAR(PREFIX)                                                  \
+    OMNITRACE_USER_FAST_JOIN(OMNITRACE_USER_FAST_JOIN(_omnitrace_, PREFIX), __LINE__)
+/** @endcond */
+
+/** Declares a static region descriptor named VAR for the region LABEL */
+#define OMNITRACE_USER_DECLARE_REGION(VAR, LABEL)                                        \
+    static omnitrace_user_region_t VAR = { LABEL, NULL }
+
+#if defined(__cplusplus)
+namespace omnitrace
+{
+namespace user
+{
+/// @struct scoped_region
+/// @brief Starts the user region on construction and ends it on destruction if it was
+/// started, i.e. enabling or disabling the regions within the scope is safe
+struct scoped_region
+{
+    explicit scoped_region(omnitrace_user_region_t* _region)
+    : m_region{ (omnitrace_user_fast_push(_region) != 0) ? _region : nullptr }
+    {}
+
+    ~scoped_region()
+    {
+        if(m_region) omnitrace_user_pop_region_handle(m_region->handle);
+    }
+
+    scoped_region(const scoped_region&) = delete;
+    scoped_region(scoped_region&&)      = delete;
+    scoped_region& operator=(const scoped_region&) = delete;
+    scoped_region& operator=(scoped_region&&) = delete;
+
+private:
+    omnitrace_user_region_t* m_region = nullptr;
+};
+}  // namespace user
+}  // namespace omnitrace
+
+/** Starts the user region LABEL which ends at the end of the enclosing scope */
+#    define OMNITRACE_USER_REGION(LABEL)                                                 \
+        OMNITRACE_USER_DECLARE_REGION(OMNITRACE_USER_FAST_VAR(region), LABEL);           \
+        ::omnitrace::user::scoped_region OMNITRACE_USER_FAST_VAR(scope)                  \
+        {                                                                                \
+            &OMNITRACE_USER_FAST_VAR(region)                                             \
+        }
+#endif
+
+/** @} */
+
+#endif  // OMNITRACE_USER_FAST_H_
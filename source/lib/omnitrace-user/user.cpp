@@ -52,10 +52,22 @@ invoke(int (*_func)(Args...), Args... args)
     if((*_func)(args...) != 0) return OMNITRACE_USER_ERROR_INTERNAL;
     return OMNITRACE_USER_SUCCESS;
 }
+
+// the inline regions of omnitrace/user_fast.h are enabled when every callback they
+// use is assigned
+void
+update_region_flag()
+{
+    bool _enabled = _callbacks.register_region && _callbacks.push_region_handle &&
+                    _callbacks.pop_region_handle;
+    __atomic_store_n(&omnitrace_user_region_flag, (_enabled) ? 1 : 0, __ATOMIC_RELAXED);
+}
 }  // namespace
 
 extern "C"
 {
+    int omnitrace_user_region_flag = 0;
+
     int omnitrace_user_start_trace(void) { return invoke(_callbacks.start_trace); }
 
     int omnitrace_user_stop_trace(void) { return invoke(_callbacks.stop_trace); }
@@ -80,6 +92,56 @@ extern "C"
         return invoke(_callbacks.pop_region, id);
     }
 
+    int omnitrace_user_push_sampled_region(const char* id, size_t rate)
+    {
+        return invoke(_callbacks.push_sampled_region, id, rate);
+    }
+
+    int omnitrace_user_pop_sampled_region(const char* id)
+    {
+        return invoke(_callbacks.pop_sampled_region, id);
+    }
+
+    omnitrace_annotation_schema_t omnitrace_user_register_annotation_schema(
+        const omnitrace_annotation_field_t* _fields, size_t _num_fields)
+    {
+        if(!_callbacks.register_annotation_schema || !_fields || _num_fields == 0)
+            return nullptr;
+        return (*_callbacks.register_annotation_schema)(_fields, _num_fields);
+    }
+
+    int omnitrace_user_push_schema_region(const char*                   id,
+                                          omnitrace_annotation_schema_t _schema,
+                                          const void*                   _values)
+    {
+        return invoke(_callbacks.push_schema_region, id, _schema, _values);
+    }
+
+    int omnitrace_user_pop_schema_region(const char*                   id,
+                                         omnitrace_annotation_schema_t _schema,
+                                         const void*                   _values)
+    {
+        return invoke(_callbacks.pop_schema_region, id, _schema, _values);
+    }
+
+    omnitrace_region_handle_t omnitrace_user_register_region(const char* id)
+    {
+        if(!_callbacks.register_region || !id) return nullptr;
+        return (*_callbacks.register_region)(id);
+    }
+
+    int omnitrace_user_push_region_handle(omnitrace_region_handle_t _handle)
+    {
+        if(!_handle) return OMNITRACE_USER_ERROR_BAD_VALUE;
+        return invoke(_callbacks.push_region_handle, _handle);
+    }
+
+    int omnitrace_user_pop_region_handle(omnitrace_region_handle_t _handle)
+    {
+        if(!_handle) return OMNITRACE_USER_ERROR_BAD_VALUE;
+        return invoke(_callbacks.pop_region_handle, _handle);
+    }
+
     int omnitrace_user_progress(const char* id)
     {
         return invoke(_callbacks.progress, id);
@@ -105,6 +167,11 @@ extern "C"
         return invoke(_callbacks.annotated_progress, id, _annotations, _annotation_count);
     }
 
+    int omnitrace_user_trigger_snapshot(void)
+    {
+        return invoke(_callbacks.trigger_snapshot);
+    }
+
     int omnitrace_user_configure(omnitrace_user_configure_mode_t mode,
                                  omnitrace_user_callbacks_t      inp,
                                  omnitrace_user_callbacks_t*     out)
@@ -136,6 +203,15 @@ extern "C"
                 _update(_v.push_annotated_region, inp.push_annotated_region);
                 _update(_v.pop_annotated_region, inp.pop_annotated_region);
                 _update(_v.annotated_progress, inp.annotated_progress);
+                _update(_v.trigger_snapshot, inp.trigger_snapshot);
+                _update(_v.register_region, inp.register_region);
+                _update(_v.push_region_handle, inp.push_region_handle);
+                _update(_v.pop_region_handle, inp.pop_region_handle);
+                _update(_v.push_sampled_region, inp.push_sampled_region);
+                _update(_v.pop_sampled_region, inp.pop_sampled_region);
+                _update(_v.register_annotation_schema, inp.register_annotation_schema);
+                _update(_v.push_schema_region, inp.push_schema_region);
+                _update(_v.pop_schema_region, inp.pop_schema_region);
 
                 _callbacks = _v;
                 break;
@@ -158,6 +234,15 @@ extern "C"
                 _update(_v.push_annotated_region, inp.push_annotated_region);
                 _update(_v.pop_annotated_region, inp.pop_annotated_region);
                 _update(_v.annotated_progress, inp.annotated_progress);
+                _update(_v.trigger_snapshot, inp.trigger_snapshot);
+                _update(_v.register_region, inp.register_region);
+                _update(_v.push_region_handle, inp.push_region_handle);
+                _update(_v.pop_region_handle, inp.pop_region_handle);
+                _update(_v.push_sampled_region, inp.push_sampled_region);
+                _update(_v.pop_sampled_region, inp.pop_sampled_region);
+                _update(_v.register_annotation_schema, inp.register_annotation_schema);
+                _update(_v.push_schema_region, inp.push_schema_region);
+                _update(_v.pop_schema_region, inp.pop_schema_region);
 
                 _callbacks = _v;
                 break;
@@ -171,6 +256,8 @@ extern "C"
 
         if(out) *out = _former;
 
+        update_region_flag();
+
         return OMNITRACE_USER_SUCCESS;
     }
 
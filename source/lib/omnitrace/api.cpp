@@ -66,6 +66,119 @@ omnitrace_pop_region(const char* _name)
     return 0;
 }
 
+extern "C" int
+omnitrace_push_sampled_region(const char* _name, size_t _rate)
+{
+    try
+    {
+        omnitrace_push_sampled_region_hidden(_name, _rate);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_pop_sampled_region(const char* _name)
+{
+    try
+    {
+        omnitrace_pop_sampled_region_hidden(_name);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" omnitrace_region_handle_t
+omnitrace_register_region(const char* _name)
+{
+    try
+    {
+        return omnitrace_register_region_hidden(_name);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+    }
+    return nullptr;
+}
+
+extern "C" int
+omnitrace_push_region_handle(omnitrace_region_handle_t _region)
+{
+    try
+    {
+        omnitrace_push_region_handle_hidden(_region);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_pop_region_handle(omnitrace_region_handle_t _region)
+{
+    try
+    {
+        omnitrace_pop_region_handle_hidden(_region);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" omnitrace_annotation_schema_t
+omnitrace_register_annotation_schema(const omnitrace_annotation_field_t* _fields,
+                                     size_t                              _num_fields)
+{
+    try
+    {
+        return omnitrace_register_annotation_schema_hidden(_fields, _num_fields);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+    }
+    return nullptr;
+}
+
+extern "C" int
+omnitrace_push_schema_region(const char* _name, omnitrace_annotation_schema_t _schema,
+                             const void* _values)
+{
+    try
+    {
+        omnitrace_push_schema_region_hidden(_name, _schema, _values);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_pop_schema_region(const char* _name, omnitrace_annotation_schema_t _schema,
+                            const void* _values)
+{
+    try
+    {
+        omnitrace_pop_schema_region_hidden(_name, _schema, _values);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
 extern "C" int
 omnitrace_push_category_region(omnitrace_category_t _category, const char* _name,
                                omnitrace_annotation_t* _annotations,
@@ -113,6 +226,20 @@ omnitrace_annotated_progress(const char* _name, omnitrace_annotation_t* _annotat
     omnitrace_annotated_progress_hidden(_name, _annotations, _annotation_count);
 }
 
+extern "C" int
+omnitrace_trigger_snapshot(void)
+{
+    try
+    {
+        omnitrace_trigger_snapshot_hidden();
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
 extern "C" void
 omnitrace_init_library(void)
 {
@@ -157,13 +284,40 @@ omnitrace_set_mpi(bool use, bool attached)
 
 extern "C" void
 omnitrace_register_source(const char* file, const char* func, size_t line, size_t address,
-                          const char* source)
+                          const char* source, size_t index)
+{
+    omnitrace_register_source_hidden(file, func, line, address, source, index);
+}
+
+extern "C" void
+omnitrace_register_coverage(size_t index)
+{
+    omnitrace_register_coverage_hidden(index);
+}
+
+extern "C" void
+omnitrace_register_call_counter(const char* file, const char* func, uint64_t* counter)
+{
+    omnitrace_register_call_counter_hidden(file, func, counter);
+}
+
+extern "C" void
+omnitrace_register_loop_counter(const char* file, const char* loop, uint64_t* entries,
+                                uint64_t* trips)
+{
+    omnitrace_register_loop_counter_hidden(file, loop, entries, trips);
+}
+
+extern "C" void
+omnitrace_register_python_sampler(
+    size_t (*stack_func)(uintptr_t*, size_t),
+    int (*frame_func)(uintptr_t, const char**, const char**, int*))
 {
-    omnitrace_register_source_hidden(file, func, line, address, source);
+    omnitrace_register_python_sampler_hidden(stack_func, frame_func);
 }
 
 extern "C" void
-omnitrace_register_coverage(const char* file, const char* func, size_t address)
+omnitrace_register_trace_window(void (*func)(bool))
 {
-    omnitrace_register_coverage_hidden(file, func, address);
+    omnitrace_register_trace_window_hidden(func);
 }
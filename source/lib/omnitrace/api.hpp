@@ -24,10 +24,12 @@
 
 #include "core/defines.hpp"
 #include "omnitrace/categories.h"  // in omnitrace-user
+#include "omnitrace/types.h"       // in omnitrace-user
 
 #include <timemory/compat/macros.h>
 
 #include <cstddef>
+#include <cstdint>
 
 // forward decl of the API
 extern "C"
@@ -65,6 +67,39 @@ extern "C"
     /// stops an instrumentation region (user-defined)
     int omnitrace_pop_region(const char*) OMNITRACE_PUBLIC_API;
 
+    /// starts an instrumentation region (user-defined) where only one in N instances
+    /// is traced and profiled on the calling thread. N is adapted to
+    /// OMNITRACE_REGION_SAMPLE_TARGET when zero
+    int omnitrace_push_sampled_region(const char*, size_t) OMNITRACE_PUBLIC_API;
+
+    /// stops a sampled instrumentation region (user-defined)
+    int omnitrace_pop_sampled_region(const char*) OMNITRACE_PUBLIC_API;
+
+    /// registers an instrumentation region (user-defined) once so that starting and
+    /// stopping it via the returned handle does not hash the name
+    omnitrace_region_handle_t omnitrace_register_region(const char*) OMNITRACE_PUBLIC_API;
+
+    /// starts a registered instrumentation region (user-defined)
+    int omnitrace_push_region_handle(omnitrace_region_handle_t) OMNITRACE_PUBLIC_API;
+
+    /// stops a registered instrumentation region (user-defined)
+    int omnitrace_pop_region_handle(omnitrace_region_handle_t) OMNITRACE_PUBLIC_API;
+
+    /// registers the names, types, and offsets of the fields of a packed value struct
+    /// which is passed to omnitrace_push_schema_region and omnitrace_pop_schema_region
+    omnitrace_annotation_schema_t omnitrace_register_annotation_schema(
+        const omnitrace_annotation_field_t*, size_t) OMNITRACE_PUBLIC_API;
+
+    /// starts an instrumentation region (user-defined) and adds the fields of the
+    /// packed value struct to the perfetto trace
+    int omnitrace_push_schema_region(const char*, omnitrace_annotation_schema_t,
+                                     const void*) OMNITRACE_PUBLIC_API;
+
+    /// stops an instrumentation region (user-defined) and adds the fields of the
+    /// packed value struct to the perfetto trace
+    int omnitrace_pop_schema_region(const char*, omnitrace_annotation_schema_t,
+                                    const void*) OMNITRACE_PUBLIC_API;
+
     /// starts an instrumentation region in a user-defined category and (optionally)
     /// adds annotations to the perfetto trace.
     int omnitrace_push_category_region(omnitrace_category_t, const char*,
@@ -77,14 +112,38 @@ extern "C"
                                       omnitrace_annotation_t*,
                                       size_t) OMNITRACE_PUBLIC_API;
 
-    /// stores source code information
+    /// stores source code information. The index is assigned by the instrumenter and
+    /// identifies the (file, func, address) in omnitrace_register_coverage. The upper
+    /// 32 bits of the index identify the instrumented binary
     void omnitrace_register_source(const char* file, const char* func, size_t line,
-                                   size_t      address,
-                                   const char* source) OMNITRACE_PUBLIC_API;
+                                   size_t address, const char* source,
+                                   size_t index) OMNITRACE_PUBLIC_API;
 
     /// increments coverage values
-    void omnitrace_register_coverage(const char* file, const char* func,
-                                     size_t address) OMNITRACE_PUBLIC_API;
+    void omnitrace_register_coverage(size_t index) OMNITRACE_PUBLIC_API;
+
+    /// registers a call counter which is incremented inline by the instrumentation
+    void omnitrace_register_call_counter(const char* file, const char* func,
+                                         uint64_t* counter) OMNITRACE_PUBLIC_API;
+
+    /// registers the entry and trip counters of a loop which are incremented inline
+    /// by the instrumentation
+    void omnitrace_register_loop_counter(const char* file, const char* loop,
+                                         uint64_t* entries,
+                                         uint64_t* trips) OMNITRACE_PUBLIC_API;
+
+    /// registers the callbacks which record the Python call-stack of the calling
+    /// thread within the sampling signal handler and which resolve the recorded
+    /// frames during post-processing
+    void omnitrace_register_python_sampler(
+        size_t (*stack_func)(uintptr_t*, size_t),
+        int (*frame_func)(uintptr_t, const char**, const char**, int*))
+        OMNITRACE_PUBLIC_API;
+
+    /// registers a callback which is invoked with false when the trace windows
+    /// (OMNITRACE_TRACE_DELAY, OMNITRACE_TRACE_DURATION, OMNITRACE_TRACE_PERIODS)
+    /// close and with true when they open
+    void omnitrace_register_trace_window(void (*)(bool)) OMNITRACE_PUBLIC_API;
 
     /// mark causal progress
     void omnitrace_progress(const char*) OMNITRACE_PUBLIC_API;
@@ -93,6 +152,9 @@ extern "C"
     void omnitrace_annotated_progress(const char*, omnitrace_annotation_t*,
                                       size_t) OMNITRACE_PUBLIC_API;
 
+    /// writes a snapshot of the perfetto ring buffer (OMNITRACE_PERFETTO_SNAPSHOT)
+    int omnitrace_trigger_snapshot(void) OMNITRACE_PUBLIC_API;
+
     // these are the real implementations for internal calling convention
     void omnitrace_init_library_hidden(void) OMNITRACE_HIDDEN_API;
     bool omnitrace_init_tooling_hidden(void) OMNITRACE_HIDDEN_API;
@@ -105,6 +167,20 @@ extern "C"
     void omnitrace_pop_trace_hidden(const char*) OMNITRACE_HIDDEN_API;
     void omnitrace_push_region_hidden(const char*) OMNITRACE_HIDDEN_API;
     void omnitrace_pop_region_hidden(const char*) OMNITRACE_HIDDEN_API;
+    void omnitrace_push_sampled_region_hidden(const char*, size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_pop_sampled_region_hidden(const char*) OMNITRACE_HIDDEN_API;
+    omnitrace_region_handle_t omnitrace_register_region_hidden(const char*)
+        OMNITRACE_HIDDEN_API;
+    void omnitrace_push_region_handle_hidden(omnitrace_region_handle_t)
+        OMNITRACE_HIDDEN_API;
+    void omnitrace_pop_region_handle_hidden(omnitrace_region_handle_t)
+        OMNITRACE_HIDDEN_API;
+    omnitrace_annotation_schema_t omnitrace_register_annotation_schema_hidden(
+        const omnitrace_annotation_field_t*, size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_push_schema_region_hidden(const char*, omnitrace_annotation_schema_t,
+                                             const void*) OMNITRACE_HIDDEN_API;
+    void omnitrace_pop_schema_region_hidden(const char*, omnitrace_annotation_schema_t,
+                                            const void*) OMNITRACE_HIDDEN_API;
     void omnitrace_push_category_region_hidden(omnitrace_category_t, const char*,
                                                omnitrace_annotation_t*,
                                                size_t) OMNITRACE_HIDDEN_API;
@@ -112,10 +188,18 @@ extern "C"
                                               omnitrace_annotation_t*,
                                               size_t) OMNITRACE_HIDDEN_API;
     void omnitrace_register_source_hidden(const char*, const char*, size_t, size_t,
-                                          const char*) OMNITRACE_HIDDEN_API;
-    void omnitrace_register_coverage_hidden(const char*, const char*,
-                                            size_t) OMNITRACE_HIDDEN_API;
+                                          const char*, size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_coverage_hidden(size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_call_counter_hidden(const char*, const char*,
+                                                uint64_t*) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_loop_counter_hidden(const char*, const char*, uint64_t*,
+                                                uint64_t*) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_python_sampler_hidden(
+        size_t (*)(uintptr_t*, size_t),
+        int (*)(uintptr_t, const char**, const char**, int*)) OMNITRACE_HIDDEN_API;
+    void omnitrace_register_trace_window_hidden(void (*)(bool)) OMNITRACE_HIDDEN_API;
     void omnitrace_progress_hidden(const char*) OMNITRACE_HIDDEN_API;
     void omnitrace_annotated_progress_hidden(const char*, omnitrace_annotation_t*,
                                              size_t) OMNITRACE_HIDDEN_API;
+    void omnitrace_trigger_snapshot_hidden(void) OMNITRACE_HIDDEN_API;
 }
@@ -43,21 +43,41 @@
 #include "library/causal/sampling.hpp"
 #include "library/components/exit_gotcha.hpp"
 #include "library/components/fork_gotcha.hpp"
+#include "library/components/heap_profiler.hpp"
+#include "library/components/io_gotcha.hpp"
+#include "library/components/mpi_flow.hpp"
 #include "library/components/mpi_gotcha.hpp"
+#include "library/components/memory_access.hpp"
 #include "library/components/numa_gotcha.hpp"
 #include "library/components/pthread_gotcha.hpp"
+#include "library/components/pthread_mutex_gotcha.hpp"
+#include "library/components/python_gil_gotcha.hpp"
 #include "library/components/rocprofiler.hpp"
+#include "library/components/topdown.hpp"
+#include "library/call_counter.hpp"
+#include "library/control.hpp"
 #include "library/coverage.hpp"
+#include "library/critical_path.hpp"
+#include "library/exporter.hpp"
+#include "library/node_summary.hpp"
 #include "library/ompt.hpp"
+#include "library/pc_sampling.hpp"
+#include "library/preemption.hpp"
 #include "library/process_sampler.hpp"
 #include "library/ptl.hpp"
 #include "library/rcclp.hpp"
+#include "library/region_sampling.hpp"
 #include "library/rocprofiler.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
+#include "library/self_overhead.hpp"
+#include "library/snapshot.hpp"
+#include "library/stream_output.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/throttle.hpp"
 #include "library/tracing.hpp"
+#include "library/triggers.hpp"
 #include "omnitrace/categories.h"  // in omnitrace-user
 
 #include <timemory/hash/types.hpp>
@@ -77,15 +97,27 @@
 #include <timemory/utility/procfs/maps.hpp>
 
 #include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <condition_variable>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <functional>
 #include <mutex>
 #include <pthread.h>
+#include <sstream>
 #include <stdexcept>
 #include <string_view>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <utility>
+#include <vector>
 
 using namespace omnitrace;
 
@@ -246,6 +278,189 @@ struct fini_bundle<tim::lightweight_tuple<Tp...>>
 };
 
 using fini_bundle_t = typename fini_bundle<main_bundle_t>::base_type;
+
+// a post-processing stage of the finalization. The stages which use the timemory
+// storage or hash identifiers of the finalizing thread or communicate via MPI run on
+// the finalizing thread in the order they are listed so the collectives are issued in
+// the same order on every rank. The remaining stages only generate their own output
+// and perfetto tracks and are executed on the thread-pool as soon as their
+// dependencies are complete.
+struct finalize_stage
+{
+    const char*                   name     = nullptr;
+    bool                          enabled  = false;
+    bool                          on_main  = false;
+    std::vector<std::string_view> depends  = {};
+    std::function<void()>         func     = {};
+    uint64_t                      beg_ns   = 0;
+    uint64_t                      end_ns   = 0;
+    int64_t                       peak_rss = 0;  // KB
+    bool                          started  = false;
+    bool                          finished = false;
+};
+
+// a phase of the finalization which is reported in OMNITRACE_FINALIZE_TIMINGS_FILE
+struct finalize_phase
+{
+    std::string_view name     = {};
+    const char*      executor = "main thread";
+    uint64_t         beg_ns   = 0;
+    uint64_t         end_ns   = 0;
+    int64_t          peak_rss = 0;  // KB
+};
+
+int64_t
+get_peak_rss_kb()
+{
+    struct rusage _usage = {};
+    if(getrusage(RUSAGE_SELF, &_usage) != 0) return 0;
+    return _usage.ru_maxrss;
+}
+
+void
+run_finalize_stages(std::vector<finalize_stage>& _stages)
+{
+    auto _mutex     = std::mutex{};
+    auto _cv        = std::condition_variable{};
+    auto _exception = std::exception_ptr{};
+
+    // disabled stages and unknown dependencies are treated as complete
+    auto _is_ready = [&_stages](const finalize_stage& _stage) {
+        for(const auto& ditr : _stage.depends)
+        {
+            for(const auto& itr : _stages)
+                if(itr.enabled && !itr.finished && ditr == itr.name) return false;
+        }
+        return true;
+    };
+
+    auto _execute = [&](finalize_stage& _stage) {
+        OMNITRACE_VERBOSE_F(2, "Starting finalization stage '%s'...\n", _stage.name);
+        auto _beg = tracing::now();
+        try
+        {
+            _stage.func();
+        } catch(...)
+        {
+            std::unique_lock<std::mutex> _lk{ _mutex };
+            if(!_exception) _exception = std::current_exception();
+        }
+        auto _end = tracing::now();
+        auto _rss = get_peak_rss_kb();
+
+        std::unique_lock<std::mutex> _lk{ _mutex };
+        _stage.beg_ns   = _beg;
+        _stage.end_ns   = _end;
+        _stage.peak_rss = _rss;
+        _stage.finished = true;
+        _cv.notify_all();
+    };
+
+    auto  _beg        = tracing::now();
+    auto& _task_group = tasking::finalize::get_task_group();
+    auto  _lk         = std::unique_lock<std::mutex>{ _mutex };
+    while(true)
+    {
+        finalize_stage* _main_stage = nullptr;
+        bool            _remaining  = false;
+        for(auto& itr : _stages)
+        {
+            if(!itr.enabled || itr.finished) continue;
+            _remaining = true;
+            if(itr.started || !_is_ready(itr)) continue;
+            if(itr.on_main)
+            {
+                if(!_main_stage) _main_stage = &itr;
+                continue;
+            }
+            itr.started = true;
+            _task_group.exec([&_execute, &itr]() {
+                // the threads of the thread-pool are disabled by default
+                OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+                _execute(itr);
+            });
+        }
+
+        if(!_remaining) break;
+
+        if(_main_stage)
+        {
+            _main_stage->started = true;
+            _lk.unlock();
+            _execute(*_main_stage);
+            _lk.lock();
+        }
+        else
+        {
+            _cv.wait(_lk);
+        }
+    }
+    _lk.unlock();
+    _task_group.join();
+
+    auto _end = tracing::now();
+    for(const auto& itr : _stages)
+    {
+        if(!itr.enabled) continue;
+        OMNITRACE_VERBOSE_F(1, "Finalization stage %-16s :: %10.3f sec (%s)\n",
+                            JOIN("", '\'', itr.name, '\'').c_str(),
+                            static_cast<double>(itr.end_ns - itr.beg_ns) / units::sec,
+                            (itr.on_main) ? "main thread" : "thread-pool");
+    }
+    OMNITRACE_VERBOSE_F(1, "Finalization stages completed in %.3f sec\n",
+                        static_cast<double>(_end - _beg) / units::sec);
+
+    if(_exception) std::rethrow_exception(_exception);
+}
+
+// appends one row per phase to the CSV file. The file is locked while the rows of the
+// process are written so that the ranks of an MPI job can share the file
+void
+write_finalize_timings(const std::vector<finalize_phase>& _phases, uint64_t _beg_ns)
+{
+    auto _fname = config::get_finalize_timings_file();
+    if(_fname.empty()) return;
+
+    auto _ss = std::stringstream{};
+    _ss.precision(6);
+    _ss << std::fixed;
+    for(const auto& itr : _phases)
+    {
+        _ss << process::get_id() << ',' << dmp::rank() << ','
+            << thread_info::get_peak_num_threads() << ',' << itr.name << ','
+            << itr.executor << ','
+            << static_cast<double>(itr.beg_ns - _beg_ns) / units::sec << ','
+            << static_cast<double>(itr.end_ns - itr.beg_ns) / units::sec << ','
+            << itr.peak_rss << '\n';
+    }
+
+    auto _fd = ::open(_fname.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(_fd < 0)
+    {
+        OMNITRACE_WARNING_F(0, "Error opening the finalize timings file '%s': %s\n",
+                            _fname.c_str(), strerror(errno));
+        return;
+    }
+
+    ::flock(_fd, LOCK_EX);
+    struct stat _stat = {};
+    auto        _data = _ss.str();
+    if(::fstat(_fd, &_stat) == 0 && _stat.st_size == 0)
+    {
+        _data = std::string{ "pid,rank,peak_threads,phase,executor,start_sec,"
+                             "elapsed_sec,peak_rss_kb\n" } +
+                _data;
+    }
+    if(::write(_fd, _data.data(), _data.size()) != static_cast<ssize_t>(_data.size()))
+    {
+        OMNITRACE_WARNING_F(0, "Error writing the finalize timings file '%s': %s\n",
+                            _fname.c_str(), strerror(errno));
+    }
+    ::flock(_fd, LOCK_UN);
+    ::close(_fd);
+
+    OMNITRACE_VERBOSE_F(1, "Wrote the finalize timings to '%s'\n", _fname.c_str());
+}
 }  // namespace
 
 //======================================================================================//
@@ -348,6 +563,15 @@ omnitrace_set_mpi_hidden(bool use, bool attached)
 
 //======================================================================================//
 
+extern "C" void
+omnitrace_register_trace_window_hidden(void (*_func)(bool))
+{
+    if(!_func) return;
+    categories::add_window_callback([_func](bool _open) { (*_func)(_open); });
+}
+
+//======================================================================================//
+
 extern "C" void
 omnitrace_init_library_hidden()
 {
@@ -457,6 +681,26 @@ omnitrace_init_tooling_hidden()
             OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
             process_sampler::setup();
         }
+        if(!config::get_export_endpoint().empty())
+        {
+            OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+            exporter::setup();
+        }
+        if(get_use_perfetto() && config::get_perfetto_snapshot())
+        {
+            OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+            snapshot::setup();
+        }
+        if(config::get_preemption_flush())
+        {
+            OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+            preemption::setup();
+        }
+        if(config::get_control_file())
+        {
+            OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+            control::setup();
+        }
         if(get_use_causal())
         {
             {
@@ -486,6 +730,15 @@ omnitrace_init_tooling_hidden()
     // ideally these have already been started
     omnitrace_preinit_hidden();
 
+    if(config::get_self_overhead())
+    {
+        OMNITRACE_VERBOSE_F(1, "Setting up the self-overhead accounting...\n");
+        self_overhead::setup(config::get_self_overhead_correction());
+    }
+
+    // the lock wrappers depend on whether the critical path is recorded
+    critical_path::setup();
+
     // start these gotchas once settings have been initialized
     if(get_init_bundle()) get_init_bundle()->start();
 
@@ -496,6 +749,9 @@ omnitrace_init_tooling_hidden()
     {
         OMNITRACE_VERBOSE_F(1, "Setting up Perfetto...\n");
         omnitrace::perfetto::setup();
+        tracing::iteration::setup();
+        tracing::batch::setup();
+        tracing::event_log::setup();
     }
 
     tasking::setup();
@@ -543,13 +799,38 @@ omnitrace_init_tooling_hidden()
         rcclp::setup();
     }
 
+    if(config::get_pc_sampling())
+    {
+        OMNITRACE_VERBOSE_F(1, "Setting up GPU PC sampling...\n");
+        pc_sampling::setup();
+    }
+
+    if(get_use_topdown())
+    {
+        OMNITRACE_VERBOSE_F(1, "Setting up the top-down analysis...\n");
+        component::topdown::setup();
+    }
+
     if(get_use_perfetto())
     {
         OMNITRACE_VERBOSE_F(1, "Starting Perfetto...\n");
         omnitrace::perfetto::start();
     }
 
+    // the samplers are stopped (instead of discarding the samples) while outside of
+    // the trace windows
+    if(get_use_sampling() && !get_use_causal())
+    {
+        categories::add_window_callback([](bool _open) {
+            if(_open)
+                sampling::resume();
+            else
+                sampling::pause();
+        });
+    }
+
     categories::setup();
+    triggers::setup();
 
     // if static objects are destroyed in the inverse order of when they are
     // created this should ensure that finalization is called before perfetto
@@ -686,6 +967,27 @@ omnitrace_finalize_hidden(void)
     else if(_is_child)
     {
         set_state(State::Finalized);
+        // children forked in the "inherit" mode only write their profile since the
+        // threads of the parent which are joined below do not exist in the child
+        if(config::get_fork_mode() == "inherit")
+        {
+            categories::enable_categories();
+
+            auto _tid = threading::get_id();
+            if(instrumentation_bundles::get())
+            {
+                auto& itr = instrumentation_bundles::get()->at(_tid);
+                while(itr != nullptr && !itr->empty())
+                {
+                    itr->back()->stop();
+                    itr->back()->pop();
+                    itr->pop_back();
+                }
+            }
+
+            tracing::copy_timemory_hash_ids();
+            if(_timemory_manager) tim::timemory_finalize(_timemory_manager.get());
+        }
         std::quick_exit(EXIT_SUCCESS);
         return;
     }
@@ -693,6 +995,12 @@ omnitrace_finalize_hidden(void)
     if(get_verbose() >= 0 || get_debug()) fprintf(stderr, "\n");
     OMNITRACE_VERBOSE_F(0, "finalizing...\n");
 
+    // the preemption signal no longer skips the finalization
+    preemption::shutdown();
+
+    // the overrides of omnitrace-ctl are dropped before the categories are re-enabled
+    control::shutdown();
+
     sampling::block_samples();
 
     thread_info::set_stop(comp::wall_clock::record());
@@ -772,6 +1080,15 @@ omnitrace_finalize_hidden(void)
     fini_bundle_t _finalization{};
     _finalization.start();
 
+    auto _fini_beg     = tracing::now();
+    auto _phases       = std::vector<finalize_phase>{};
+    auto _record_phase = [&_phases](std::string_view _name, uint64_t _beg) {
+        auto _end = tracing::now();
+        _phases.emplace_back(
+            finalize_phase{ _name, "main thread", _beg, _end, get_peak_rss_kb() });
+        return _end;
+    };
+
     if(get_use_rcclp())
     {
         OMNITRACE_VERBOSE_F(1, "Shutting down RCCLP...\n");
@@ -817,6 +1134,10 @@ omnitrace_finalize_hidden(void)
 
         pthread_gotcha::shutdown();
         component::numa_gotcha::shutdown();
+        component::memory_access::shutdown();
+        component::heap_profiler::shutdown();
+        component::io_gotcha::shutdown();
+        component::python_gil_gotcha::shutdown();
     }
 
     // stop the gotcha bundle
@@ -827,6 +1148,36 @@ omnitrace_finalize_hidden(void)
         component::mpi_gotcha::shutdown();
     }
 
+    if(exporter::is_active())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down exporter...\n");
+        exporter::shutdown();
+    }
+
+    if(snapshot::is_active())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down snapshots...\n");
+        snapshot::shutdown();
+    }
+
+    if(tracing::iteration::is_enabled())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down region-triggered tracing...\n");
+        tracing::iteration::shutdown();
+    }
+
+    if(tracing::batch::is_enabled())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down batched tracing...\n");
+        tracing::batch::shutdown();
+    }
+
+    if(tracing::event_log::is_enabled())
+    {
+        OMNITRACE_VERBOSE_F(1, "Converting the event logs...\n");
+        tracing::event_log::shutdown();
+    }
+
     if(get_use_process_sampling())
     {
         OMNITRACE_VERBOSE_F(1, "Shutting down background sampler...\n");
@@ -842,6 +1193,15 @@ omnitrace_finalize_hidden(void)
         // join extra thread(s) used by roctracer
         OMNITRACE_VERBOSE_F(2, "Waiting on roctracer tasks...\n");
         tasking::join();
+
+        OMNITRACE_VERBOSE_F(2, "Post-processing the roctracer timeline...\n");
+        comp::roctracer::post_process();
+    }
+
+    if(get_use_rcclp())
+    {
+        OMNITRACE_VERBOSE_F(1, "Post-processing the RCCL collectives...\n");
+        rcclp::post_process();
     }
 
     if(get_use_rocprofiler())
@@ -851,6 +1211,12 @@ omnitrace_finalize_hidden(void)
         rocprofiler::rocm_cleanup();
     }
 
+    if(pc_sampling::is_enabled())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down GPU PC sampling...\n");
+        pc_sampling::shutdown();
+    }
+
     if(get_use_causal())
     {
         OMNITRACE_VERBOSE_F(1, "Shutting down causal sampling...\n");
@@ -898,43 +1264,134 @@ omnitrace_finalize_hidden(void)
 
     OMNITRACE_VERBOSE_F(0, "\n");
 
-    // ensure that all the MT instances are flushed
-    if(get_use_sampling())
-    {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the sampling backtraces...\n");
-        sampling::post_process();
-    }
-
-    if(get_use_causal())
-    {
-        OMNITRACE_VERBOSE_F(1, "Finishing the causal experiments...\n");
-        causal::finish_experimenting();
-    }
-
-    if(get_use_process_sampling())
+    // the post-processing stages are independent unless a dependency is listed. The
+    // node summary aggregates the timemory storage so it follows the sampling.
+    auto _stages = std::vector<finalize_stage>{
+        { "sampling", get_use_sampling(), true, {}, []() { sampling::post_process(); } },
+        { "causal",
+          get_use_causal(),
+          true,
+          { "sampling" },
+          []() { causal::finish_experimenting(); } },
+        // the energy and DRAM traffic of the regions are reported by the region names
+        // which are resolved from the hash identifiers of the finalizing thread
+        // (cpu_energy, memory_bandwidth, gpu_energy via rocm_smi)
+        { "process_sampler",
+          get_use_process_sampling(),
+          true,
+          {},
+          []() { process_sampler::post_process(); } },
+        { "coverage",
+          get_use_code_coverage(),
+          false,
+          {},
+          []() { coverage::post_process(); } },
+        { "throttle",
+          config::get_throttle_calls() > 0,
+          true,
+          {},
+          []() { throttle::post_process(); } },
+        { "region_sampling",
+          true,
+          true,
+          {},
+          []() { region_sampling::post_process(); } },
+        { "self_overhead",
+          self_overhead::is_enabled(),
+          true,
+          {},
+          []() { self_overhead::post_process(); } },
+        { "call_counter",
+          call_counter::size() > 0,
+          false,
+          {},
+          []() { call_counter::post_process(); } },
+        { "lock_contention",
+          config::get_trace_thread_locks_contention_only() ||
+              config::get_trace_thread_locks_profile(),
+          false,
+          {},
+          []() { component::pthread_mutex_gotcha::post_process(); } },
+        { "numa_locality",
+          config::get_numa_locality(),
+          false,
+          {},
+          []() { component::numa_gotcha::post_process(); } },
+        { "memory_access",
+          config::get_sampling_memory(),
+          false,
+          {},
+          []() { component::memory_access::post_process(); } },
+        { "heap_profile",
+          config::get_heap_profile(),
+          false,
+          {},
+          []() { component::heap_profiler::post_process(); } },
+        { "io_trace",
+          config::get_io_trace(),
+          false,
+          {},
+          []() { component::io_gotcha::post_process(); } },
+        { "python_gil",
+          config::get_trace_python_gil(),
+          false,
+          {},
+          []() { component::python_gil_gotcha::post_process(); } },
+        { "mpi_flow",
+          get_use_mpip() && config::get_mpi_matching(),
+          true,
+          {},
+          []() { component::mpi_flow::post_process(); } },
+        { "pc_sampling",
+          pc_sampling::is_enabled(),
+          true,
+          {},
+          []() { pc_sampling::post_process(); } },
+        { "critical_path",
+          critical_path::is_enabled(),
+          true,
+          { "mpi_flow" },
+          []() { critical_path::post_process(); } },
+        { "node_summary",
+          config::get_collapse_nodes(),
+          true,
+          { "sampling", "mpi_flow" },
+          []() { node_summary::post_process(); } },
+        { "stream_output",
+          config::get_stream_output(),
+          true,
+          { "node_summary" },
+          []() { stream_output::post_process(); } },
+    };
+
+    auto _post_beg = _record_phase("shutdown", _fini_beg);
+
+    OMNITRACE_VERBOSE_F(1, "Post-processing...\n");
+    run_finalize_stages(_stages);
+
+    for(const auto& itr : _stages)
     {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the system-level samples...\n");
-        process_sampler::post_process();
+        if(!itr.enabled) continue;
+        _phases.emplace_back(
+            finalize_phase{ itr.name, (itr.on_main) ? "main thread" : "thread-pool",
+                            itr.beg_ns, itr.end_ns, itr.peak_rss });
     }
+    _record_phase("post_processing", _post_beg);
 
     // shutdown tasking before timemory is finalized, especially the roctracer thread-pool
     OMNITRACE_VERBOSE_F(1, "Shutting down thread-pools...\n");
     tasking::shutdown();
 
-    if(get_use_code_coverage())
-    {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the code coverage...\n");
-        coverage::post_process();
-    }
-
     tracing::copy_timemory_hash_ids();
 
     bool _perfetto_output_error = false;
     if(get_use_perfetto())
     {
         OMNITRACE_VERBOSE_F(0, "Finalizing perfetto...\n");
+        auto _beg = tracing::now();
         omnitrace::perfetto::post_process(_timemory_manager.get(),
                                           _perfetto_output_error);
+        _record_phase("perfetto", _beg);
     }
 
     if(_timemory_manager && _timemory_manager != nullptr)
@@ -952,7 +1409,10 @@ omnitrace_finalize_hidden(void)
                tim::cereal::make_nvp("memory_maps", _maps));
         });
 
+        if(config::get_stream_output()) stream_output::disable_timemory_output();
+
         OMNITRACE_VERBOSE_F(1, "Finalizing timemory...\n");
+        auto _beg = tracing::now();
         tim::timemory_finalize(_timemory_manager.get());
 
         auto _cfg       = settings::compose_filename_config{};
@@ -960,12 +1420,16 @@ omnitrace_finalize_hidden(void)
         _cfg.suffix     = settings::default_process_suffix();
         _timemory_manager->write_metadata(settings::get_global_output_prefix(),
                                           "omnitrace", _cfg);
+        _record_phase("timemory", _beg);
     }
 
     categories::shutdown();
 
     _finalization.stop();
 
+    _record_phase("total", _fini_beg);
+    write_finalize_timings(_phases, _fini_beg);
+
     if(_perfetto_output_error)
     {
         OMNITRACE_THROW("Error opening perfetto output file: %s",
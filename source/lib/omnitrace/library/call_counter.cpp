@@ -0,0 +1,331 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/call_counter.hpp"
+#include "api.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace call_counter
+{
+namespace
+{
+struct counter_entry
+{
+    const char* file    = nullptr;
+    const char* func    = nullptr;
+    uint64_t*   counter = nullptr;
+};
+
+struct loop_counter_entry
+{
+    const char* file    = nullptr;
+    const char* loop    = nullptr;
+    uint64_t*   entries = nullptr;
+    uint64_t*   trips   = nullptr;
+};
+
+// the counters are registered once per function at the start of main and are
+// intentionally leaked so that they remain valid during finalization
+auto&
+get_mutex()
+{
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+auto*&
+get_counters()
+{
+    static auto* _v = new std::vector<counter_entry>{};
+    return _v;
+}
+
+auto*&
+get_loop_counters()
+{
+    static auto* _v = new std::vector<loop_counter_entry>{};
+    return _v;
+}
+
+bool
+get_setting(const std::string& _v)
+{
+    auto&& _b = config::get_setting_value<bool>(_v);
+    OMNITRACE_CI_THROW(!_b, "Error! No configuration setting named '%s'", _v.c_str());
+    return _b.value_or(true);
+}
+
+template <typename Tp>
+void
+write_json(const std::string& _base, const char* _label, const std::vector<Tp>& _data)
+{
+    std::stringstream oss{};
+    {
+        namespace cereal = tim::cereal;
+        auto ar = tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+        ar->setNextName("omnitrace");
+        ar->startNode();
+        (*ar)(cereal::make_nvp(_label, _data));
+        ar->finishNode();
+    }
+    auto _fname = tim::settings::compose_output_filename(_base, ".json");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<Tp>{}(_fname, std::string{ _label });
+        ofs << oss.str() << "\n";
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening %s output file: %s", _label, _fname.c_str());
+    }
+}
+}  // namespace
+
+bool
+call_count::operator<(const call_count& rhs) const
+{
+    return std::tie(count, module, function) <
+           std::tie(rhs.count, rhs.module, rhs.function);
+}
+
+bool
+call_count::operator>(const call_count& rhs) const
+{
+    return rhs < *this;
+}
+
+template <typename ArchiveT>
+void
+call_count::serialize(ArchiveT& ar, const unsigned)
+{
+    namespace cereal = tim::cereal;
+    ar(cereal::make_nvp("count", count), cereal::make_nvp("module", module),
+       cereal::make_nvp("function", function));
+}
+
+double
+loop_count::average_trips() const
+{
+    return (entries > 0) ? (static_cast<double>(trips) / entries) : 0.0;
+}
+
+bool
+loop_count::operator<(const loop_count& rhs) const
+{
+    return std::tie(trips, entries, module, loop) <
+           std::tie(rhs.trips, rhs.entries, rhs.module, rhs.loop);
+}
+
+bool
+loop_count::operator>(const loop_count& rhs) const
+{
+    return rhs < *this;
+}
+
+template <typename ArchiveT>
+void
+loop_count::serialize(ArchiveT& ar, const unsigned)
+{
+    namespace cereal = tim::cereal;
+    ar(cereal::make_nvp("entries", entries), cereal::make_nvp("trips", trips),
+       cereal::make_nvp("average_trips", average_trips()),
+       cereal::make_nvp("module", module), cereal::make_nvp("loop", loop));
+}
+
+size_t
+size()
+{
+    auto _lk = locking::atomic_lock{ get_mutex() };
+    return get_counters()->size() + get_loop_counters()->size();
+}
+
+namespace
+{
+void
+post_process_loops()
+{
+    auto _data = std::map<std::pair<std::string, std::string>, loop_count>{};
+    {
+        auto _lk = locking::atomic_lock{ get_mutex() };
+        for(const auto& itr : *get_loop_counters())
+        {
+            auto& _v = _data[{ itr.file, itr.loop }];
+            _v.entries += __atomic_load_n(itr.entries, __ATOMIC_RELAXED);
+            _v.trips += __atomic_load_n(itr.trips, __ATOMIC_RELAXED);
+        }
+    }
+
+    if(_data.empty()) return;
+
+    auto _counts = std::vector<loop_count>{};
+    _counts.reserve(_data.size());
+    for(auto& itr : _data)
+    {
+        itr.second.module = itr.first.first;
+        itr.second.loop   = itr.first.second;
+        _counts.emplace_back(itr.second);
+    }
+
+    std::sort(_counts.begin(), _counts.end(), std::greater<loop_count>{});
+
+    size_t _nexecuted = 0;
+    for(const auto& itr : _counts)
+        if(itr.entries > 0) ++_nexecuted;
+
+    OMNITRACE_VERBOSE(0, "loop counters     :: %zu of %zu loops were executed\n",
+                      _nexecuted, _counts.size());
+
+    if(get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        auto _fname = tim::settings::compose_output_filename("loop-counts", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<loop_count>{}(
+                    _fname, std::string{ "loop_counts" });
+            ofs << std::setw(12) << "ENTRIES" << "  " << std::setw(14) << "TRIPS" << "  "
+                << std::setw(12) << "AVG TRIPS" << "  LOOP [MODULE]\n";
+            for(const auto& itr : _counts)
+                ofs << std::setw(12) << itr.entries << "  " << std::setw(14) << itr.trips
+                    << "  " << std::setw(12) << std::fixed << std::setprecision(2)
+                    << itr.average_trips() << "  " << itr.loop << " [" << itr.module
+                    << "]\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening loop counts output file: %s", _fname.c_str());
+        }
+    }
+
+    if(get_setting("OMNITRACE_JSON_OUTPUT"))
+        write_json("loop-counts", "loop_counts", _counts);
+}
+}  // namespace
+
+void
+post_process()
+{
+    post_process_loops();
+
+    auto _data = std::map<std::pair<std::string, std::string>, uint64_t>{};
+    {
+        auto _lk = locking::atomic_lock{ get_mutex() };
+        for(const auto& itr : *get_counters())
+        {
+            // the counters are incremented by the instrumentation without
+            // synchronization so the value is read atomically but relaxed
+            auto _count = __atomic_load_n(itr.counter, __ATOMIC_RELAXED);
+            _data[{ itr.file, itr.func }] += _count;
+        }
+    }
+
+    if(_data.empty()) return;
+
+    auto _counts = std::vector<call_count>{};
+    _counts.reserve(_data.size());
+    for(auto& itr : _data)
+        _counts.emplace_back(call_count{ itr.second, itr.first.first, itr.first.second });
+
+    std::sort(_counts.begin(), _counts.end(), std::greater<call_count>{});
+
+    size_t _ncalled = 0;
+    for(const auto& itr : _counts)
+        if(itr.count > 0) ++_ncalled;
+
+    OMNITRACE_VERBOSE(0, "call counters     :: %zu of %zu functions were called\n",
+                      _ncalled, _counts.size());
+
+    if(get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        auto _fname = tim::settings::compose_output_filename("call-counts", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<call_count>{}(
+                    _fname, std::string{ "call_counts" });
+            for(const auto& itr : _counts)
+                ofs << std::setw(12) << itr.count << "  " << itr.function << " ["
+                    << itr.module << "]\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening call counts output file: %s", _fname.c_str());
+        }
+    }
+
+    if(get_setting("OMNITRACE_JSON_OUTPUT"))
+        write_json("call-counts", "call_counts", _counts);
+}
+}  // namespace call_counter
+}  // namespace omnitrace
+
+//--------------------------------------------------------------------------------------//
+
+extern "C" void
+omnitrace_register_call_counter_hidden(const char* file, const char* func,
+                                       uint64_t* counter)
+{
+    if(!file || !func || !counter) return;
+
+    namespace call_counter = omnitrace::call_counter;
+
+    auto _lk = omnitrace::locking::atomic_lock{ call_counter::get_mutex() };
+    call_counter::get_counters()->emplace_back(
+        call_counter::counter_entry{ file, func, counter });
+}
+
+extern "C" void
+omnitrace_register_loop_counter_hidden(const char* file, const char* loop,
+                                       uint64_t* entries, uint64_t* trips)
+{
+    if(!file || !loop || !entries || !trips) return;
+
+    namespace call_counter = omnitrace::call_counter;
+
+    auto _lk = omnitrace::locking::atomic_lock{ call_counter::get_mutex() };
+    call_counter::get_loop_counters()->emplace_back(
+        call_counter::loop_counter_entry{ file, loop, entries, trips });
+}
@@ -0,0 +1,89 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/tpls/cereal/cereal.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace omnitrace
+{
+namespace call_counter
+{
+//--------------------------------------------------------------------------------------//
+//
+/// \struct call_count
+/// \brief Number of calls of a function which omnitrace-instrument counted via an
+/// inline increment (i.e. without a function call) instead of instrumenting it
+//
+//--------------------------------------------------------------------------------------//
+
+struct call_count
+{
+    uint64_t    count    = 0;
+    std::string module   = {};
+    std::string function = {};
+
+    bool operator<(const call_count& rhs) const;
+    bool operator>(const call_count& rhs) const;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned version);
+};
+
+//--------------------------------------------------------------------------------------//
+//
+/// \struct loop_count
+/// \brief Number of executions (entries) and iterations (trips) of a loop which
+/// omnitrace-instrument counted via inline increments instead of instrumenting it as a
+/// region (--loop-mode count)
+//
+//--------------------------------------------------------------------------------------//
+
+struct loop_count
+{
+    uint64_t    entries = 0;
+    uint64_t    trips   = 0;
+    std::string module  = {};
+    std::string loop    = {};
+
+    double average_trips() const;
+
+    bool operator<(const loop_count& rhs) const;
+    bool operator>(const loop_count& rhs) const;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned version);
+};
+
+// number of registered call and loop counters
+size_t
+size();
+
+// reads the counters and writes the call counts and the loop trip counts
+void
+post_process();
+}  // namespace call_counter
+}  // namespace omnitrace
@@ -0,0 +1,144 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/calling_context.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "library/thread_data.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace omnitrace
+{
+namespace calling_context
+{
+namespace
+{
+using tree_instances = thread_data<tree, category::sampling>;
+
+size_t
+hash(node_id_t _parent, uintptr_t _addr)
+{
+    // fibonacci hashing of the address mixed with the parent node
+    auto _v = (static_cast<uint64_t>(_addr) * 0x9e3779b97f4a7c15ULL) ^
+              (static_cast<uint64_t>(_parent) * 0xff51afd7ed558ccdULL);
+    return static_cast<size_t>(_v ^ (_v >> 29));
+}
+}  // namespace
+
+tree::tree(size_t _capacity)
+: m_capacity{ std::min<size_t>(std::max<size_t>(_capacity, 1),
+                               std::numeric_limits<node_id_t>::max() - 1) }
+{
+    // keep the load factor of the table at or below 50%
+    auto _table_size = size_t{ 2 };
+    while(_table_size < 2 * (m_capacity + 1))
+        _table_size <<= 1;
+
+    m_mask  = _table_size - 1;
+    m_nodes = std::make_unique<node[]>(m_capacity + 1);
+    m_table = std::make_unique<node_id_t[]>(_table_size);
+}
+
+node_id_t
+tree::intern(const uintptr_t* _beg, const uintptr_t* _end)
+{
+    // a sample interrupting another sample on this thread
+    if(m_busy != 0)
+    {
+        ++m_dropped;
+        return 0;
+    }
+
+    m_busy = 1;
+
+    auto _parent = node_id_t{ 0 };
+    auto _size   = m_size.load(std::memory_order_relaxed);
+    for(const auto* itr = _beg; itr != _end; ++itr)
+    {
+        auto _addr = *itr;
+        if(_addr == 0) continue;
+
+        auto _idx  = hash(_parent, _addr) & m_mask;
+        auto _node = node_id_t{ 0 };
+        while(m_table[_idx] != 0)
+        {
+            const auto& _v = m_nodes[m_table[_idx]];
+            if(_v.address == _addr && _v.parent == _parent)
+            {
+                _node = m_table[_idx];
+                break;
+            }
+            _idx = (_idx + 1) & m_mask;
+        }
+
+        if(_node == 0)
+        {
+            if(_size > m_capacity)
+            {
+                ++m_truncated;
+                break;
+            }
+            _node          = static_cast<node_id_t>(_size++);
+            m_nodes[_node] = node{ _addr, _parent };
+            m_table[_idx]  = _node;
+            m_size.store(_size, std::memory_order_release);
+        }
+
+        _parent = _node;
+    }
+
+    m_busy = 0;
+    return _parent;
+}
+
+std::vector<uintptr_t>
+tree::get_addresses(node_id_t _node) const
+{
+    auto _v = std::vector<uintptr_t>{};
+    if(_node == 0 || _node >= size()) return _v;
+
+    for(; _node != 0 && _v.size() <= m_capacity; _node = m_nodes[_node].parent)
+        _v.emplace_back(m_nodes[_node].address);
+
+    std::reverse(_v.begin(), _v.end());
+    return _v;
+}
+
+void
+configure(int64_t _tid)
+{
+    tree_instances::construct(construct_on_thread{ _tid },
+                              config::get_sampling_cct_capacity());
+}
+
+tree*
+get(int64_t _tid)
+{
+    auto* _instances = tree_instances::get();
+    if(!_instances || _tid < 0 || static_cast<size_t>(_tid) >= _instances->size())
+        return nullptr;
+    return _instances->at(_tid).get();
+}
+}  // namespace calling_context
+}  // namespace omnitrace
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace omnitrace
+{
+namespace calling_context
+{
+using node_id_t = uint32_t;
+
+// per-thread calling-context tree of the sampled call-stacks. Each node is a single
+// return address and its parent node, i.e. the call-stack (outermost frame first)
+// which lead to that address. Samples only record the id of the innermost node and
+// the full call-stack is recovered by walking the parents. Node zero is the root
+// and represents an empty call-stack.
+//
+// The tree is written exclusively by its thread from within the sampling signal
+// handlers so all of the storage is allocated up front and interning a call-stack
+// neither allocates nor locks. After sampling of the thread has stopped, the tree
+// can be read from any thread.
+struct tree
+{
+    struct node
+    {
+        uintptr_t address = 0;
+        node_id_t parent  = 0;
+    };
+
+    explicit tree(size_t _capacity);
+    ~tree()                     = default;
+    tree(const tree&)           = delete;
+    tree(tree&&)                = delete;
+    tree& operator=(const tree&) = delete;
+    tree& operator=(tree&&) = delete;
+
+    // the addresses are ordered from the outermost frame to the innermost frame.
+    // Returns the node of the innermost frame which could be recorded
+    node_id_t intern(const uintptr_t* _beg, const uintptr_t* _end);
+
+    // addresses of the call-stack ending at the given node, outermost frame first
+    std::vector<uintptr_t> get_addresses(node_id_t) const;
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+    size_t capacity() const { return m_capacity; }
+    size_t truncated() const { return m_truncated; }
+    size_t dropped() const { return m_dropped; }
+
+private:
+    size_t                       m_capacity  = 0;
+    size_t                       m_mask      = 0;
+    size_t                       m_truncated = 0;
+    size_t                       m_dropped   = 0;
+    volatile sig_atomic_t        m_busy      = 0;
+    std::atomic<size_t>          m_size      = { 1 };
+    std::unique_ptr<node[]>      m_nodes     = {};
+    std::unique_ptr<node_id_t[]> m_table     = {};
+};
+
+// allocates the tree for the thread. Must be called by the thread before any of its
+// samples are taken
+void
+configure(int64_t _tid);
+
+// returns nullptr if the thread has no tree
+tree*
+get(int64_t _tid);
+}  // namespace calling_context
+}  // namespace omnitrace
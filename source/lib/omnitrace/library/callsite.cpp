@@ -0,0 +1,75 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/callsite.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <ios>
+
+namespace omnitrace
+{
+namespace callsite
+{
+bool
+is_internal(uintptr_t _ip, library_list_t _libs)
+{
+    auto _info = Dl_info{};
+    if(dladdr(reinterpret_cast<void*>(_ip), &_info) == 0 || !_info.dli_fname)
+        return false;
+
+    auto _fname = std::string_view{ _info.dli_fname };
+    auto _base  = _fname.substr(_fname.find_last_of('/') + 1);
+    return std::any_of(_libs.begin(), _libs.end(),
+                       [_base](auto _v) { return _base.find(_v) == 0; });
+}
+
+std::string
+get_label(uintptr_t _ip)
+{
+    if(auto _entry = binary::lookup_ipaddr_entry<false>(_ip);
+       _entry && !_entry->name.empty())
+    {
+        auto _line = (_entry->lineno == 0) ? std::string{ "?" }
+                                           : std::to_string(_entry->lineno);
+        return JOIN("", demangle(_entry->name), " @ ",
+                    JOIN(':', (_entry->location.empty()) ? "??" : _entry->location,
+                         _line));
+    }
+
+    auto _info = Dl_info{};
+    if(dladdr(reinterpret_cast<void*>(_ip), &_info) != 0 && _info.dli_sname)
+        return demangle(_info.dli_sname);
+    return JOIN("", "0x", std::hex, _ip);
+}
+
+std::string
+get_label(std::string_view _prefix, const void* _codeptr)
+{
+    if(!_codeptr) return std::string{ _prefix };
+    return JOIN(" ", _prefix, get_label(reinterpret_cast<uintptr_t>(_codeptr)));
+}
+}  // namespace callsite
+}  // namespace omnitrace
@@ -0,0 +1,69 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+namespace callsite
+{
+using library_list_t = std::initializer_list<std::string_view>;
+
+// whether the instruction pointer is in one of the libraries, e.g. omnitrace or gotcha
+// in the call stack of a wrapped function. The libraries are matched by the prefix of
+// the basename
+bool
+is_internal(uintptr_t _ip, library_list_t _libs = { "libomnitrace", "libgotcha" });
+
+// "<function> @ <file>:<line>" from the debug info, the symbol name from the dynamic
+// symbol table or the address
+std::string
+get_label(uintptr_t _ip);
+
+// "<prefix> <label>" of the code pointer of a construct, e.g. the return address of an
+// OpenMP parallel region, or the prefix when the code pointer is null
+std::string
+get_label(std::string_view _prefix, const void* _codeptr);
+
+// the label of the first frame outside of the libraries, i.e. the caller of the
+// wrapped function. The frames end at the first zero
+template <size_t N>
+std::string
+get_caller_label(const std::array<uintptr_t, N>& _frames,
+                 library_list_t _libs = { "libomnitrace", "libgotcha" })
+{
+    for(auto itr : _frames)
+    {
+        if(itr == 0) break;
+        if(!is_internal(itr, _libs)) return get_label(itr);
+    }
+    return std::string{ "??" };
+}
+}  // namespace callsite
+}  // namespace omnitrace
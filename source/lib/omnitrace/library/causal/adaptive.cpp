@@ -0,0 +1,234 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/causal/adaptive.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/causal/data.hpp"
+#include "library/causal/experiment.hpp"
+
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace adaptive
+{
+namespace
+{
+// z-score of the 95% confidence interval
+constexpr double z_score = 1.96;
+// number of experiments with a virtual speedup before its variance is trusted
+constexpr size_t min_experiments = 3;
+// number of successive selections which were already known before experimenting stops
+constexpr size_t max_known_selections = 100;
+
+constexpr double unknown = std::numeric_limits<double>::infinity();
+
+// running mean and variance (Welford's algorithm) of the progress rate
+struct rate_stats
+{
+    size_t count = 0;
+    double mean  = 0.0;
+    double m2    = 0.0;
+
+    rate_stats& operator+=(double _v)
+    {
+        ++count;
+        auto _delta = _v - mean;
+        mean += _delta / count;
+        m2 += _delta * (_v - mean);
+        return *this;
+    }
+
+    // standard error of the mean relative to the mean
+    double relative_error() const
+    {
+        if(count < min_experiments || mean <= 0.0) return unknown;
+        return std::sqrt(m2 / (count - 1) / count) / mean;
+    }
+};
+
+using speedup_stats_t = std::map<uint16_t, rate_stats>;
+
+auto selection_stats  = std::unordered_map<std::string, speedup_stats_t>{};
+auto known_selections = size_t{ 0 };
+
+std::string
+get_name(const selected_entry& _selection)
+{
+    const auto& _line_info = _selection.symbol;
+    return (_selection.symbol_address > 0) ? _line_info.func
+                                           : join(":", _line_info.file, _line_info.line);
+}
+
+std::vector<uint16_t>
+get_speedups()
+{
+    auto _v = get_virtual_speedups();
+    std::sort(_v.begin(), _v.end());
+    _v.erase(std::unique(_v.begin(), _v.end()), _v.end());
+    return _v;
+}
+
+// half-width of the confidence interval of the predicted program speedup along with
+// whether the baseline contributes more to the uncertainty than the virtual speedup
+std::pair<double, bool>
+get_interval(const rate_stats& _base, const rate_stats& _v)
+{
+    auto _base_err = _base.relative_error();
+    auto _err      = _v.relative_error();
+    if(_base_err == unknown || _err == unknown) return { unknown, _base_err >= _err };
+
+    auto _ratio = _base.mean / _v.mean;
+    return { z_score * _ratio * std::sqrt((_base_err * _base_err) + (_err * _err)),
+             _base_err > _err };
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return config::get_causal_adaptive();
+}
+
+bool
+is_known(const selected_entry& _selection)
+{
+    auto _known = [&_selection]() {
+        auto itr = selection_stats.find(get_name(_selection));
+        if(itr == selection_stats.end()) return false;
+
+        auto  _tolerance = config::get_causal_adaptive_tolerance();
+        auto& _stats     = itr->second;
+        auto  _speedups  = get_speedups();
+        if(_speedups.empty()) return false;
+
+        auto _has_base = (_speedups.front() == 0);
+        for(auto sitr : _speedups)
+        {
+            if(_has_base && sitr == 0) continue;
+            // without a baseline, the rate itself has to be known within the tolerance
+            auto _width = (_has_base)
+                              ? get_interval(_stats[0], _stats[sitr]).first
+                              : z_score * _stats[sitr].relative_error();
+            if(_width > _tolerance) return false;
+        }
+        return true;
+    }();
+
+    known_selections = (_known) ? (known_selections + 1) : 0;
+    return _known;
+}
+
+bool
+is_finished()
+{
+    return (known_selections >= max_known_selections);
+}
+
+uint16_t
+sample_virtual_speedup(const selected_entry& _selection)
+{
+    auto _speedups = get_speedups();
+    if(_speedups.empty()) return 0;
+    if(_speedups.size() == 1) return _speedups.front();
+
+    auto& _stats    = selection_stats[get_name(_selection)];
+    auto  _has_base = (_speedups.front() == 0);
+
+    // until the baseline is known, the predictions of every speedup are unknown
+    if(_has_base && _stats[0].count < min_experiments) return 0;
+
+    auto _speedup = _speedups.front();
+    auto _width   = -1.0;
+    auto _count   = std::numeric_limits<size_t>::max();
+    for(auto sitr : _speedups)
+    {
+        if(_has_base && sitr == 0) continue;
+
+        auto _base_dominant = false;
+        auto _sitr_width    = z_score * _stats[sitr].relative_error();
+        if(_has_base)
+            std::tie(_sitr_width, _base_dominant) = get_interval(_stats[0], _stats[sitr]);
+
+        auto _sitr_speedup = (_base_dominant) ? uint16_t{ 0 } : sitr;
+        auto _sitr_count   = _stats[_sitr_speedup].count;
+
+        // widest interval wins. Among the unknown, the fewest experiments wins
+        if(_sitr_width > _width || (_sitr_width == unknown && _sitr_count < _count))
+        {
+            _speedup = _sitr_speedup;
+            _width   = _sitr_width;
+            _count   = _sitr_count;
+        }
+    }
+
+    return _speedup;
+}
+
+void
+record(const experiment& _experim)
+{
+    if(_experim.duration == 0) return;
+
+    int64_t _progress = 0;
+    for(const auto& fitr : _experim.fini_progress)
+    {
+        auto _init = _experim.init_progress.find(fitr.first);
+        auto _pt   = fitr.second;
+        if(_init != _experim.init_progress.end()) _pt -= _init->second;
+        _progress +=
+            std::max<int64_t>({ _pt.get_laps(), _pt.get_arrival(), _pt.get_departure() });
+    }
+
+    if(_progress <= 0) return;
+
+    auto  _name  = get_name(_experim.selection);
+    auto  _rate  = _progress / (static_cast<double>(_experim.duration) / units::sec);
+    auto& _stats = selection_stats[_name][_experim.virtual_speedup];
+    _stats += _rate;
+
+    OMNITRACE_VERBOSE(3,
+                      "[causal][adaptive] %s :: speed-up: %3u%%, experiments: %zu, "
+                      "rate: %.3e (mean: %.3e, relative error: %.3f)\n",
+                      demangle(_name).c_str(), _experim.virtual_speedup, _stats.count,
+                      _rate, _stats.mean, _stats.relative_error());
+}
+}  // namespace adaptive
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,65 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+#include "library/causal/selected_entry.hpp"
+
+#include <cstdint>
+
+namespace omnitrace
+{
+namespace causal
+{
+struct experiment;
+
+namespace adaptive
+{
+// adaptive experiment selection (OMNITRACE_CAUSAL_ADAPTIVE): the rate of the progress
+// points is recorded for each line/function and virtual speedup. The program speedup
+// predicted for a virtual speedup is 1 - (baseline rate / rate) and its confidence
+// interval is estimated from the standard errors of the two rates. Experiments are
+// allocated to the virtual speedup with the widest interval and the lines/functions
+// whose intervals are all within OMNITRACE_CAUSAL_ADAPTIVE_TOLERANCE are skipped.
+// These functions are only called by the thread performing the experiments.
+bool
+is_enabled();
+
+// returns true if the effect of every virtual speedup of the selection is known
+bool
+is_known(const selected_entry&);
+
+// returns true once a large number of successive selections were already known
+bool
+is_finished();
+
+// the virtual speedup with the most uncertain effect for the selection
+uint16_t
+sample_virtual_speedup(const selected_entry&);
+
+// records the progress rate of a completed experiment
+void
+record(const experiment&);
+}  // namespace adaptive
+}  // namespace causal
+}  // namespace omnitrace
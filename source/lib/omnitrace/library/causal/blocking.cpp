@@ -0,0 +1,262 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/causal/blocking.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/callsite.hpp"
+#include "library/causal/components/blocking_gotcha.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace blocking
+{
+namespace
+{
+constexpr size_t callsite_depth        = 16;
+constexpr size_t callsite_ignore_depth = 2;
+constexpr size_t report_size           = 20;
+
+using callsite_frames_t = std::array<uintptr_t, callsite_depth>;
+
+struct entry
+{
+    size_t            gotcha_idx = 0;
+    uint64_t          count      = 0;
+    uint64_t          total      = 0;  // nsec
+    uint64_t          max        = 0;  // nsec
+    callsite_frames_t frames     = {};
+};
+
+// the calls which block for longer than the threshold of one thread keyed by the hash
+// of the call stack and the wrapped function. The table is only locked when a call
+// exceeds the threshold so the lock is effectively uncontended
+struct blocking_table
+{
+    locking::atomic_mutex               mutex   = {};
+    std::unordered_map<uint64_t, entry> entries = {};
+};
+
+auto&
+get_blocking_table(int64_t _tid = threading::get_id())
+{
+    using thread_data_t = thread_data<blocking_table, category::causal>;
+    return thread_data_t::instance(construct_on_thread{ _tid });
+}
+
+callsite_frames_t
+get_callsite_frames()
+{
+    auto   _frames = callsite_frames_t{};
+    auto   _stack  = tim::get_unw_stack<callsite_depth, callsite_ignore_depth, false>();
+    size_t _n      = 0;
+    for(auto itr : _stack)
+    {
+        if(itr && _n < _frames.size()) _frames.at(_n++) = itr->address();
+    }
+    return _frames;
+}
+
+uint64_t
+get_callsite_hash(size_t _idx, const callsite_frames_t& _frames)
+{
+    // FNV-1a over the addresses of the frames
+    uint64_t _hash = 0xcbf29ce484222325ULL ^ _idx;
+    for(auto itr : _frames)
+    {
+        if(itr == 0) break;
+        _hash = (_hash ^ itr) * 0x100000001b3ULL;
+    }
+    return _hash;
+}
+
+std::string
+get_function_name(size_t _idx)
+{
+    const auto* _data = component::blocking_gotcha_t::at(_idx);
+    return (_data && !_data->tool_id.empty()) ? _data->tool_id : std::string{ "??" };
+}
+}  // namespace
+
+std::atomic<uint64_t>&
+get_threshold()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
+void
+setup()
+{
+    auto _threshold = config::get_causal_blocking_threshold();
+    if(_threshold <= 0.0) return;
+
+    auto _nsec = static_cast<uint64_t>(_threshold * units::sec);
+    get_threshold().store(std::max<uint64_t>(_nsec, 1));
+
+    OMNITRACE_VERBOSE(1,
+                      "[causal] attributing the blocking calls which exceed %.3e "
+                      "seconds to their call sites...\n",
+                      _threshold);
+}
+
+void
+record(size_t _idx, uint64_t _duration)
+{
+    auto& _table = get_blocking_table();
+    if(!_table) return;
+
+    auto _frames = get_callsite_frames();
+    auto _hash   = get_callsite_hash(_idx, _frames);
+
+    locking::atomic_lock _lk{ _table->mutex };
+    auto&                _entry = _table->entries[_hash];
+    if(_entry.count++ == 0)
+    {
+        _entry.gotcha_idx = _idx;
+        _entry.frames     = _frames;
+    }
+    _entry.total += _duration;
+    _entry.max = std::max(_entry.max, _duration);
+}
+
+void
+post_process()
+{
+    using thread_data_t = thread_data<blocking_table, category::causal>;
+
+    if(!is_enabled()) return;
+    get_threshold().store(0);
+
+    auto* _data = thread_data_t::get();
+    if(!_data) return;
+
+    struct report
+    {
+        entry       data     = {};
+        size_t      threads  = 0;
+        std::string function = {};
+        std::string callsite = {};
+    };
+
+    auto _merged = std::unordered_map<uint64_t, report>{};
+    for(auto& titr : *_data)
+    {
+        if(!titr) continue;
+        locking::atomic_lock _lk{ titr->mutex };
+        for(const auto& itr : titr->entries)
+        {
+            auto& _report = _merged[itr.first];
+            if(_report.threads++ == 0)
+            {
+                _report.data = itr.second;
+                continue;
+            }
+            _report.data.count += itr.second.count;
+            _report.data.total += itr.second.total;
+            _report.data.max = std::max(_report.data.max, itr.second.max);
+        }
+    }
+
+    if(_merged.empty()) return;
+
+    auto _reports = std::vector<report>{};
+    _reports.reserve(_merged.size());
+    for(auto& itr : _merged)
+        _reports.emplace_back(std::move(itr.second));
+
+    std::sort(_reports.begin(), _reports.end(),
+              [](const report& _lhs, const report& _rhs) {
+                  return _lhs.data.total > _rhs.data.total;
+              });
+
+    // resolving the call sites is expensive so only the top call sites are reported
+    if(_reports.size() > report_size) _reports.resize(report_size);
+    for(auto& itr : _reports)
+    {
+        itr.function = get_function_name(itr.data.gotcha_idx);
+        itr.callsite = callsite::get_caller_label(itr.data.frames);
+    }
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / units::msec; };
+    auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+
+    for(size_t i = 0; i < std::min<size_t>(_reports.size(), 5); ++i)
+    {
+        const auto& itr = _reports.at(i);
+        OMNITRACE_VERBOSE(1, "[causal] blocked %.3f msec in %s (%lu calls) at %s\n",
+                          _msec(itr.data.total), itr.function.c_str(), itr.data.count,
+                          itr.callsite.c_str());
+    }
+
+    auto _cfg         = settings::compose_filename_config{};
+    _cfg.subdirectory = "causal";
+    _cfg.use_suffix   = config::get_use_pid();
+
+    auto _fname = tim::settings::compose_output_filename("blocking", "txt", _cfg);
+    auto ofs    = std::ofstream{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<component::blocking_gotcha>{}(
+                _fname, std::string{ "causal_blocking" });
+
+        ofs << std::setw(14) << "blocked [msec]" << " " << std::setw(10) << "calls"
+            << " " << std::setw(8) << "threads" << " " << std::setw(16)
+            << "max [usec]" << " " << std::setw(28) << "function" << "   call site\n";
+        ofs << std::fixed << std::setprecision(3);
+        for(const auto& itr : _reports)
+        {
+            ofs << std::setw(14) << _msec(itr.data.total) << " " << std::setw(10)
+                << itr.data.count << " " << std::setw(8) << itr.threads << " "
+                << std::setw(16) << _usec(itr.data.max) << " " << std::setw(28)
+                << itr.function << "   " << itr.callsite << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening causal blocking output file: %s", _fname.c_str());
+    }
+}
+}  // namespace blocking
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,82 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ratio>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace blocking
+{
+// off-CPU attribution of the calls intercepted by the causal blocking gotcha
+// (OMNITRACE_CAUSAL_BLOCKING_THRESHOLD). The calls which block for longer than the
+// threshold are attributed to the call stack of the caller in a per-thread table and
+// the call sites where the threads spent the most time blocked are reported next to
+// the causal experiments. Lines which are executed by threads which are mostly waiting
+// on other threads tend to show no predicted speedup
+std::atomic<uint64_t>&
+get_threshold();
+
+inline bool
+is_enabled()
+{
+    return get_threshold().load(std::memory_order_relaxed) > 0;
+}
+
+void
+setup();
+
+void
+post_process();
+
+// _idx is the index of the wrapped function in the blocking gotcha
+void
+record(size_t _idx, uint64_t _duration);
+
+// returns the timestamp which is passed to end() or zero when disabled
+inline uint64_t
+begin()
+{
+    return (is_enabled()) ? tim::get_clock_real_now<uint64_t, std::nano>() : 0;
+}
+
+inline void
+end(size_t _idx, uint64_t _beg)
+{
+    if(_beg == 0) return;
+    auto _duration = tim::get_clock_real_now<uint64_t, std::nano>() - _beg;
+    if(_duration >= get_threshold().load(std::memory_order_relaxed))
+        record(_idx, _duration);
+}
+}  // namespace blocking
+}  // namespace causal
+}  // namespace omnitrace
@@ -189,10 +189,10 @@ backtrace::sample(int _sig)
     // is active and processing the delays happens only when the thread is active
     if(_sig == cputime_signal)
     {
-        if(causal::experiment::is_active())
-            causal::delay::process();
-        else
-            _set_current_selection(m_stack);
+        if(causal::experiment::is_active()) causal::delay::process();
+        // the eligible PCs are also recorded during an experiment so that the
+        // selection for the next experiment is available as soon as it ends
+        _set_current_selection(m_stack);
     }
     else if(_sig == realtime_signal)
     {
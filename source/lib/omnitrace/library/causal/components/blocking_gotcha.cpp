@@ -24,6 +24,7 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/state.hpp"
+#include "library/causal/blocking.hpp"
 #include "library/causal/components/causal_gotcha.hpp"
 #include "library/causal/delay.hpp"
 #include "library/causal/experiment.hpp"
@@ -147,7 +148,8 @@ std::enable_if_t<(Idx <= blocking_gotcha::indexes::maybe_post_block_max_idx), Re
 blocking_gotcha::operator()(gotcha_index<Idx>, Ret (*_func)(Args...),
                             Args... _args) const noexcept
 {
-    int64_t _delay_value = causal::delay::get_global().load(std::memory_order_relaxed);
+    auto _blocked = causal::delay::preblock();
+    auto _beg     = causal::blocking::begin();
 
     causal::sampling::block_backtrace_samples();
     auto _ret = (*_func)(_args...);
@@ -155,14 +157,16 @@ blocking_gotcha::operator()(gotcha_index<Idx>, Ret (*_func)(Args...),
 
     if(get_thread_state() < ::omnitrace::ThreadState::Internal)
     {
+        causal::blocking::end(Idx, _beg);
+
         if constexpr(Idx >= always_post_block_min_idx && Idx <= always_post_block_max_idx)
         {
-            causal::delay::postblock(_delay_value);
+            causal::delay::postblock(_blocked);
         }
         else if constexpr(Idx >= maybe_post_block_min_idx &&
                           Idx <= maybe_post_block_max_idx)
         {
-            if(_ret == 0) causal::delay::postblock(_delay_value);
+            if(_ret == 0) causal::delay::postblock(_blocked);
         }
         else
         {
@@ -183,7 +187,8 @@ blocking_gotcha::operator()(gotcha_index<sigwait_idx>, int (*)(const sigset_t*,
     causal_gotcha::remove_signals(&_set);
     siginfo_t _info;
 
-    int64_t _delay_value = (_active) ? causal::delay::get_global().load() : 0;
+    auto _blocked = (_active) ? causal::delay::preblock() : causal::delay::block_state{};
+    auto _beg     = (_active) ? causal::blocking::begin() : 0;
 
     auto* _data         = blocking_gotcha_t::at(16);
     auto  f_sigwaitinfo = reinterpret_cast<decltype(&sigwaitinfo)>(_data->wrappee);
@@ -192,9 +197,11 @@ blocking_gotcha::operator()(gotcha_index<sigwait_idx>, int (*)(const sigset_t*,
     auto _ret = (*f_sigwaitinfo)(&_set, &_info);
     causal::sampling::unblock_backtrace_samples();
 
+    if(_active) causal::blocking::end(sigwait_idx, _beg);
+
     // Woken up by another thread if the call did not fail and this is waking process
     if(_active && _ret != -1 && _info.si_pid == process::get_id())
-        causal::delay::postblock(_delay_value);
+        causal::delay::postblock(_blocked);
 
     if(_ret == -1)
         return errno;  // If there was an error, return the error code
@@ -215,15 +222,18 @@ blocking_gotcha::operator()(gotcha_index<sigwaitinfo_idx>,
     causal_gotcha::remove_signals(&_set);
     siginfo_t _info;
 
-    int64_t _delay_value = (_active) ? causal::delay::get_global().load() : 0;
+    auto _blocked = (_active) ? causal::delay::preblock() : causal::delay::block_state{};
+    auto _beg     = (_active) ? causal::blocking::begin() : 0;
 
     causal::sampling::block_backtrace_samples();
     auto _ret = (*_func)(&_set, &_info);
     causal::sampling::unblock_backtrace_samples();
 
+    if(_active) causal::blocking::end(sigwaitinfo_idx, _beg);
+
     // Woken up by another thread if the call did not fail and this is waking process
     if(_active && _ret > 0 && _info.si_pid == process::get_id())
-        causal::delay::postblock(_delay_value);
+        causal::delay::postblock(_blocked);
 
     if(_ret > 0 && _info_v) *_info_v = _info;
 
@@ -243,15 +253,18 @@ blocking_gotcha::operator()(gotcha_index<sigtimedwait_idx>,
     causal_gotcha::remove_signals(&_set);
     siginfo_t _info;
 
-    int64_t _delay_value = (_active) ? causal::delay::get_global().load() : 0;
+    auto _blocked = (_active) ? causal::delay::preblock() : causal::delay::block_state{};
+    auto _beg     = (_active) ? causal::blocking::begin() : 0;
 
     causal::sampling::block_backtrace_samples();
     auto _ret = (*_func)(&_set, &_info, _wait_v);
     causal::sampling::unblock_backtrace_samples();
 
+    if(_active) causal::blocking::end(sigtimedwait_idx, _beg);
+
     // Woken up by another thread if the call did not fail and this is waking process
     if(_active && _ret > 0 && _info.si_pid == process::get_id())
-        causal::delay::postblock(_delay_value);
+        causal::delay::postblock(_blocked);
 
     if(_ret > 0 && _info_v) *_info_v = _info;
 
@@ -123,6 +123,12 @@ progress_point::set_value(int64_t _v)
     m_departure = _v;
 }
 
+void
+progress_point::set_delta(int64_t _v)
+{
+    m_delta = _v;
+}
+
 progress_point&
 progress_point::operator+=(const progress_point& _v)
 {
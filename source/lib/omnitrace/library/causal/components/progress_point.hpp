@@ -58,6 +58,7 @@ struct progress_point : comp::base<progress_point, void>
     void            stop();
     void            mark();
     void            set_value(int64_t);
+    void            set_delta(int64_t);
     progress_point& operator+=(const progress_point&);
     progress_point& operator-=(const progress_point&);
 
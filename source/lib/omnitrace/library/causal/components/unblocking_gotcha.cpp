@@ -110,13 +110,13 @@ unblocking_gotcha::operator()(gotcha_index<Idx>, Ret (*_func)(Args...),
 
         if constexpr(Idx == pthread_barrier_wait_idx)
         {
-            int64_t _delay_value = (_active) ? causal::delay::get_global().load() : 0;
+            auto _blocked = causal::delay::preblock();
 
             causal::sampling::block_backtrace_samples();
             auto _ret = (*_func)(_args...);
             causal::sampling::unblock_backtrace_samples();
 
-            causal::delay::postblock(_delay_value);
+            causal::delay::postblock(_blocked);
             return _ret;
         }
     }
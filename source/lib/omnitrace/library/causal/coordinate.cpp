@@ -0,0 +1,195 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/causal/coordinate.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/mproc.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/units.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/file.h>
+#include <thread>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace coordinate
+{
+namespace
+{
+// time between scheduling a round and the start of the round. Provides the other
+// processes the time to read the schedule, e.g. from a network file system
+constexpr uint64_t schedule_lead_time = 250 * units::msec;
+// how often the other processes read the schedule
+constexpr auto schedule_poll_interval = std::chrono::milliseconds{ 10 };
+
+auto
+get_schedule_file()
+{
+    return config::get_causal_coordinate_file();
+}
+
+auto
+get_progress_file()
+{
+    return JOIN("", config::get_causal_coordinate_file(), ".coz");
+}
+
+// the first round of the process with rank zero discards the data of previous runs
+void
+reset_files()
+{
+    {
+        auto _ofs = std::ofstream{ get_schedule_file(), std::ios::out | std::ios::trunc };
+        OMNITRACE_CONDITIONAL_THROW(!_ofs, "Error opening causal schedule file: %s",
+                                    get_schedule_file().c_str());
+    }
+
+    auto _ofs = std::ofstream{ get_progress_file(), std::ios::out | std::ios::trunc };
+    OMNITRACE_CONDITIONAL_THROW(!_ofs, "Error opening causal progress file: %s",
+                                get_progress_file().c_str());
+    _ofs << "startup\ttime=" << tracing::now() << "\n";
+}
+
+std::optional<round>
+parse(const std::string& _line)
+{
+    auto _iss   = std::istringstream{ _line };
+    auto _tag   = std::string{};
+    auto _round = round{};
+    _iss >> _tag >> _round.index >> _round.virtual_speedup >> _round.start_time >>
+        _round.experiment_time >> std::hex >> _round.offset;
+    if(!_iss || _tag != "round") return std::nullopt;
+
+    // the binary is last since the path may contain spaces
+    std::getline(_iss >> std::ws, _round.binary);
+    if(_round.binary.empty()) return std::nullopt;
+    return _round;
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    static bool _v = !config::get_causal_coordinate_file().empty();
+    return _v;
+}
+
+bool
+is_leader()
+{
+    return (get_rank() == 0);
+}
+
+int64_t
+get_rank()
+{
+    // the causal experiments may start before MPI_Init so the rank is read from the
+    // environment set by the launcher, if possible
+    static auto _v = []() {
+        auto _rank = mproc::get_launcher_rank();
+        return static_cast<int64_t>((_rank >= 0) ? _rank : dmp::rank());
+    }();
+    return _v;
+}
+
+uint64_t
+get_start_time()
+{
+    return tracing::now() + schedule_lead_time;
+}
+
+void
+publish(const round& _round)
+{
+    static bool _reset = (reset_files(), true);
+    (void) _reset;
+
+    auto _ofs = std::ofstream{ get_schedule_file(), std::ios::out | std::ios::app };
+    OMNITRACE_CONDITIONAL_THROW(!_ofs, "Error opening causal schedule file: %s",
+                                get_schedule_file().c_str());
+
+    _ofs << "round " << _round.index << " " << _round.virtual_speedup << " "
+         << _round.start_time << " " << _round.experiment_time << " " << std::hex
+         << _round.offset << std::dec << " " << _round.binary << std::endl;
+
+    OMNITRACE_VERBOSE(2, "[causal] scheduled round #%u :: speed-up: %u%%, %s+0x%lx\n",
+                      _round.index, static_cast<unsigned>(_round.virtual_speedup),
+                      _round.binary.c_str(), static_cast<unsigned long>(_round.offset));
+}
+
+std::optional<round>
+wait(uint32_t _index)
+{
+    while(get_state() < State::Finalized)
+    {
+        // the file is re-opened every time to pick up the changes from the other node
+        auto _ifs = std::ifstream{ get_schedule_file() };
+        auto _now = tracing::now();
+        while(_ifs)
+        {
+            auto _line = std::string{};
+            if(!std::getline(_ifs, _line)) break;
+            auto _round = parse(_line);
+            if(_round && _round->index > _index && _round->start_time > _now)
+                return _round;
+        }
+
+        std::this_thread::yield();
+        std::this_thread::sleep_for(schedule_poll_interval);
+    }
+    return std::nullopt;
+}
+
+void
+write_progress(const std::string& _data)
+{
+    // the experiments of different processes must not be interleaved
+    auto* _fp = fopen(get_progress_file().c_str(), "a");
+    if(!_fp)
+    {
+        OMNITRACE_VERBOSE(0, "[causal] Error opening causal progress file: %s\n",
+                          get_progress_file().c_str());
+        return;
+    }
+
+    flock(fileno(_fp), LOCK_EX);
+    fwrite(_data.data(), sizeof(char), _data.length(), _fp);
+    fflush(_fp);
+    flock(fileno(_fp), LOCK_UN);
+    fclose(_fp);
+}
+}  // namespace coordinate
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace coordinate
+{
+// coordinates the causal experiments of multiple processes (e.g. the ranks of an MPI
+// job) through the file specified by OMNITRACE_CAUSAL_COORDINATE: the process with rank
+// zero appends the selection and virtual speedup of each experiment (a "round") and
+// the remaining processes perform the same experiment at the same (wall-clock) time.
+// The selection is exchanged as the path of the binary and the offset from its load
+// address since the address differs between processes.
+struct round
+{
+    uint32_t    index           = 0;   /// round number
+    uint16_t    virtual_speedup = 0;   /// 0-100
+    uint64_t    start_time      = 0;   /// wall-clock start of the experiment [nsec]
+    uint64_t    experiment_time = 0;   /// how long the experiment runs [nsec]
+    uintptr_t   offset          = 0;   /// offset of selection from load address
+    std::string binary          = {};  /// binary containing the selection
+};
+
+bool
+is_enabled();
+
+bool
+is_leader();
+
+int64_t
+get_rank();
+
+// returns the wall-clock time that the next round should start at
+uint64_t
+get_start_time();
+
+// appends the round to the schedule
+void
+publish(const round&);
+
+// waits for the first round with an index greater than the given index which has not
+// started yet. Returns nothing once omnitrace has been finalized
+std::optional<round>
+wait(uint32_t);
+
+// appends the progress point data of an experiment to the combined output
+void
+write_progress(const std::string&);
+}  // namespace coordinate
+}  // namespace causal
+}  // namespace omnitrace
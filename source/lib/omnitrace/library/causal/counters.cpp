@@ -0,0 +1,176 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/causal/counters.hpp"
+#include "common/join.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/perf.hpp"
+#include "library/causal/components/progress_point.hpp"
+#include "library/components/comm_data.hpp"
+#include "library/perf.hpp"
+
+#include <timemory/hash/types.hpp>
+
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace counters
+{
+namespace
+{
+struct counter
+{
+    std::string                       name  = {};
+    tim::hash_value_t                 hash  = 0;
+    bool                              send  = false;  /// comm_data bytes sent
+    bool                              recv  = false;  /// comm_data bytes received
+    std::unique_ptr<perf::perf_event> event = {};
+
+    uint64_t get() const
+    {
+        if(event) return (event->is_open()) ? event->get_count() : 0;
+        return component::comm_data::get_total_bytes(send, recv);
+    }
+};
+
+auto&
+get_counters_mutex()
+{
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+auto&
+get_counters()
+{
+    static auto* _v = new std::vector<counter>{};
+    return *_v;
+}
+
+std::optional<counter>
+make_perf_counter(std::string_view _event)
+{
+    constexpr auto _prefix = std::string_view{ "perf::" };
+    if(_event.find(_prefix) == 0) _event = _event.substr(_prefix.length());
+
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+
+    try
+    {
+        perf::config_event(_pe, _event);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING(0, "[causal] invalid progress counter '%s': %s\n",
+                          _event.data(), _e.what());
+        return std::nullopt;
+    }
+
+    // count the events of the current thread and all the threads it creates
+    _pe.inherit        = 1;
+    _pe.exclude_kernel = 1;
+    _pe.exclude_hv     = 1;
+
+    auto _v  = counter{};
+    _v.name  = JOIN("", _prefix, _event);
+    _v.event = std::make_unique<perf::perf_event>();
+
+    if(auto _err = _v.event->open(_pe, 0, -1))
+    {
+        OMNITRACE_WARNING(0, "[causal] progress counter '%s' is not available: %s\n",
+                          _v.name.c_str(), _err->c_str());
+        return std::nullopt;
+    }
+
+    _v.event->start();
+    return _v;
+}
+
+std::optional<counter>
+make_comm_data_counter(std::string_view _name)
+{
+    auto _v = counter{};
+    _v.name = std::string{ _name };
+    _v.send = (_name == "comm_data" || _name == "comm_data::send");
+    _v.recv = (_name == "comm_data" || _name == "comm_data::recv");
+    if(!_v.send && !_v.recv)
+    {
+        OMNITRACE_WARNING(0, "[causal] invalid progress counter '%s'\n", _name.data());
+        return std::nullopt;
+    }
+    return _v;
+}
+}  // namespace
+
+void
+setup()
+{
+    auto _names = config::get_causal_progress_counters();
+    if(_names.empty()) return;
+
+    auto _lk = locking::atomic_lock{ get_counters_mutex() };
+    if(!get_counters().empty()) return;
+
+    for(const auto& itr : _names)
+    {
+        auto _v = (itr.find("comm_data") == 0) ? make_comm_data_counter(itr)
+                                                : make_perf_counter(itr);
+        if(!_v) continue;
+
+        _v->hash = tim::add_hash_id(_v->name);
+        OMNITRACE_VERBOSE(1, "[causal] progress counter: %s\n", _v->name.c_str());
+        get_counters().emplace_back(std::move(*_v));
+    }
+}
+
+void
+shutdown()
+{
+    auto _lk = locking::atomic_lock{ get_counters_mutex() };
+    get_counters().clear();
+}
+
+void
+read(progress_points_t& _data)
+{
+    auto _lk = locking::atomic_lock{ get_counters_mutex() };
+    for(const auto& itr : get_counters())
+    {
+        auto& _pt = _data[itr.hash];
+        _pt.set_hash(itr.hash);
+        _pt.set_delta(static_cast<int64_t>(itr.get()));
+    }
+}
+}  // namespace counters
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,60 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+#include "library/causal/components/progress_point.hpp"
+
+#include <timemory/hash/types.hpp>
+
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace counters
+{
+using progress_points_t =
+    std::unordered_map<tim::hash_value_t, component::progress_point>;
+
+// progress points backed by counters (OMNITRACE_CAUSAL_PROGRESS_COUNTERS) instead of
+// marked regions of the code: perf events (counting every thread created after the
+// setup) and the bytes sent/received through the MPI and RCCL wrappers. The counters
+// are read at the experiment boundaries so the causal profile predicts the impact of
+// a speedup on e.g. the rate of retired instructions or the communication volume.
+// The setup must be called from the main thread before the child threads are created
+void
+setup();
+
+void
+shutdown();
+
+// adds the current (cumulative) value of each counter as a throughput progress point.
+// The difference between the values at the start and end of an experiment is the
+// number of events during the experiment
+void
+read(progress_points_t&);
+}  // namespace counters
+}  // namespace causal
+}  // namespace omnitrace
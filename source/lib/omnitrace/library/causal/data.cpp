@@ -21,17 +21,23 @@
 // SOFTWARE.
 
 #include "library/causal/data.hpp"
+#include "binary/address_index.hpp"
 #include "binary/address_multirange.hpp"
 #include "binary/analysis.hpp"
 #include "binary/binary_info.hpp"
 #include "binary/link_map.hpp"
 #include "binary/scope_filter.hpp"
 #include "core/binary/fwd.hpp"
+#include "core/concepts.hpp"
 #include "core/config.hpp"
+#include "core/containers/aligned_static_vector.hpp"
 #include "core/containers/c_array.hpp"
 #include "core/debug.hpp"
 #include "core/state.hpp"
 #include "core/utility.hpp"
+#include "library/causal/adaptive.hpp"
+#include "library/causal/blocking.hpp"
+#include "library/causal/counters.hpp"
 #include "library/causal/delay.hpp"
 #include "library/causal/experiment.hpp"
 #include "library/causal/fwd.hpp"
@@ -54,16 +60,21 @@
 #include <timemory/utility/types.hpp>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <initializer_list>
+#include <limits>
+#include <mutex>
 #include <random>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -256,7 +267,12 @@ get_filters(const std::set<binary::scope_filter::filter_scope>& _scopes = {
 }
 
 using binary_info_t = std::vector<binary::binary_info>;
-std::pair<binary_info_t, binary_info_t>&
+// the scoped view of each binary info: whether each symbol (by index) satisfies the
+// filters or has inlined functions or line info which do. The eligible symbols are
+// referenced instead of copied
+using scoped_info_t = std::vector<std::vector<bool>>;
+
+std::pair<binary_info_t, scoped_info_t>&
 get_cached_binary_info()
 {
     static auto _v = []() {
@@ -267,13 +283,58 @@ get_cached_binary_info()
         for(const auto& itr : _link_map)
             _files.emplace_back(itr.real());
 
-        auto _discarded = std::vector<binary::binary_info>{};
+        // the binaries are parsed by a pool of internal threads
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+
         auto _requested = binary::get_binary_info(_files, get_filters());
-        return std::make_pair(_requested, _discarded);
+        return std::make_pair(std::move(_requested), scoped_info_t{});
     }();
     return _v;
 }
 
+// a binary which was loaded via dlopen after the initial binary analysis. The entries
+// are immutable once published and are never freed because the lookups, including
+// the ones in the sampling signal handler, do not hold a reference to them. An
+// unloaded binary is only flagged since its addresses may be reused by the next one
+struct loaded_binary
+{
+    binary::binary_info        info     = {};
+    std::vector<bool>          scoped   = {};
+    binary::address_multirange eligible = {};
+    std::atomic<bool>          unloaded = { false };
+};
+
+constexpr size_t max_loaded_binaries = 1024;
+
+// only the experiment thread appends entries and the count is published after the
+// entry so the readers never observe a partially constructed entry
+auto loaded_binaries            = std::array<loaded_binary*, max_loaded_binaries>{};
+auto num_loaded_binaries        = std::atomic<size_t>{ 0 };
+auto loaded_binaries_generation = std::atomic<uint64_t>{ 0 };
+
+// invokes the function with the binary info and the scoped view of every cached and
+// loaded binary until the function returns true
+template <typename FuncT>
+void
+for_each_binary_info(FuncT&& _func)
+{
+    auto& _binary_info = get_cached_binary_info().first;
+    auto& _scoped_info = get_cached_binary_info().second;
+    for(size_t i = 0; i < _binary_info.size(); ++i)
+    {
+        auto* _scoped = (i < _scoped_info.size()) ? &_scoped_info.at(i) : nullptr;
+        if(_func(std::as_const(_binary_info.at(i)), _scoped)) return;
+    }
+
+    auto _n = num_loaded_binaries.load(std::memory_order_acquire);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto* itr = loaded_binaries[i];
+        if(itr->unloaded.load(std::memory_order_acquire)) continue;
+        if(_func(itr->info, &itr->scoped)) return;
+    }
+}
+
 bool
 satisfies_filter(const binary::scope_filter::filter_scope& _scope,
                  const std::string&                        _value)
@@ -282,68 +343,62 @@ satisfies_filter(const binary::scope_filter::filter_scope& _scope,
     return binary::scope_filter::satisfies_filter(_filters, _scope, _value);
 }
 
+auto line_info_indexed = std::atomic<bool>{ false };
+
+// whether each symbol of the binary info satisfies the filters or has inlined
+// functions or line info which do. In lazy mode the line info is decoded on the
+// first lookup so eligibility is determined by the symbols alone
+std::vector<bool>
+get_eligible_symbols(const binary::binary_info&              _info,
+                     const std::vector<binary::scope_filter>& _filters)
+{
+    auto _scoped = std::vector<bool>(_info.symbols.size(), false);
+    for(size_t i = 0; i < _info.symbols.size(); ++i)
+    {
+        const auto& ditr = _info.symbols.at(i);
+
+        _scoped.at(i) = ditr(_filters) || ditr.has_inline_symbols(_filters) ||
+                        ditr.has_debug_line_info(_filters);
+    }
+    return _scoped;
+}
+
 auto
 compute_eligible_lines_impl()
 {
-    const auto& _binary_info = get_cached_binary_info().first;
+    auto&       _binary_info = get_cached_binary_info().first;
     auto&       _scoped_info = get_cached_binary_info().second;
     auto        _filters     = get_filters();
 
     for(const auto& litr : _binary_info)
-    {
-        auto& _scoped    = _scoped_info.emplace_back();
-        _scoped.bfd      = litr.bfd;
-        _scoped.mappings = litr.mappings;
-        _scoped.sections = litr.sections;
-
-        for(const auto& ditr : litr.symbols)
-        {
-            auto _sym = ditr.clone();
-
-            _sym.inlines =
-                ditr.get_inline_symbols<std::vector<binary::inlined_symbol>>(_filters);
+        _scoped_info.emplace_back(get_eligible_symbols(litr, _filters));
 
-            _sym.dwarf_info =
-                ditr.get_debug_line_info<std::vector<binary::dwarf_entry>>(_filters);
-
-            if(ditr(_filters) || (_sym.inlines.size() + _sym.dwarf_info.size()) > 0)
-            {
-                _scoped.ranges.emplace_back(_sym.ipaddr());
-                _scoped.symbols.emplace_back(_sym);
-            }
-        }
-
-        for(const auto& ditr : litr.debug_info)
-        {
-            if(sf::satisfies_filter(_filters, sf::SOURCE_FILTER, ditr.file) ||
-               sf::satisfies_filter(_filters, sf::SOURCE_FILTER,
-                                    join(':', ditr.file, ditr.line)))
-            {
-                _scoped.debug_info.emplace_back(ditr);
-            }
-        }
+    // index the symbols and line info of the binary info. The scoped view uses the
+    // same index and skips the symbols which are not eligible
+    for(auto& litr : _binary_info)
+        litr.build_index();
 
-        _scoped.sort();
-    }
+    line_info_indexed.store(true, std::memory_order_release);
 
     auto& _eligible_ar = get_eligible_address_ranges();
-    for(const auto& litr : _scoped_info)
+    for(size_t i = 0; i < _binary_info.size(); ++i)
     {
-        for(const auto& ditr : litr.symbols)
-        {
-            _eligible_ar += ditr.ipaddr();
-        }
-
-        for(auto ditr : litr.ranges)
+        const auto& _symbols = _binary_info.at(i).symbols;
+        for(size_t j = 0; j < _symbols.size(); ++j)
         {
-            _eligible_ar += ditr;
+            if(_scoped_info.at(i).at(j)) _eligible_ar += _symbols.at(j).ipaddr();
         }
     }
 
-    OMNITRACE_VERBOSE(
-        0, "[causal] eligible address ranges: %zu, coarse address range: %zu [%s]\n",
-        _eligible_ar.size(), _eligible_ar.range_size(),
-        _eligible_ar.get_coarse_range().as_string().c_str());
+    // compact the fine ranges for the lookups in the sampling signal handler
+    _eligible_ar.freeze();
+
+    OMNITRACE_VERBOSE(0,
+                      "[causal] eligible address ranges: %zu (%zu merged), coarse "
+                      "address range: %zu [%s]\n",
+                      _eligible_ar.size(), _eligible_ar.merged_size(),
+                      _eligible_ar.range_size(),
+                      _eligible_ar.get_coarse_range().as_string().c_str());
 
     if(_eligible_ar.empty())
     {
@@ -359,6 +414,88 @@ compute_eligible_lines_impl()
         "pointer addresses for causal experimentation");
 }
 
+// analyzes the libraries which were loaded since the previous call and publishes
+// them for the lookups. Only invoked by the experiment thread
+void
+update_loaded_binaries()
+{
+    // the libraries which were analyzed (or rejected by the binary filters)
+    static auto _known = []() {
+        auto _v = std::set<std::string>{};
+        for(const auto& itr : binary::get_link_map(nullptr, "", ""))
+            _v.emplace(itr.real());
+        for(const auto& itr : get_cached_binary_info().first)
+            _v.emplace(itr.filename());
+        return _v;
+    }();
+
+    auto _loaded = binary::get_loaded_objects_if_changed();
+    if(!_loaded) return;
+
+    auto _n = num_loaded_binaries.load(std::memory_order_relaxed);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        auto* itr = loaded_binaries[i];
+        if(!itr->unloaded.load(std::memory_order_relaxed) &&
+           _loaded->count(itr->info.filename()) == 0)
+        {
+            OMNITRACE_VERBOSE(1, "[causal] removing unloaded binary '%s'...\n",
+                              itr->info.filename().c_str());
+            itr->unloaded.store(true, std::memory_order_release);
+            loaded_binaries_generation.fetch_add(1, std::memory_order_acq_rel);
+        }
+    }
+
+    for(auto itr = _known.begin(); itr != _known.end();)
+    {
+        if(_loaded->count(*itr) == 0)
+            itr = _known.erase(itr);
+        else
+            ++itr;
+    }
+
+    auto _files = std::vector<std::string>{};
+    for(const auto& itr : *_loaded)
+    {
+        if(_known.emplace(itr).second) _files.emplace_back(itr);
+    }
+
+    if(_files.empty()) return;
+
+    // the binaries are parsed by a pool of internal threads
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+
+    static auto _filters = get_filters();
+    for(auto& itr : binary::get_binary_info(_files, _filters))
+    {
+        if(_n >= max_loaded_binaries)
+        {
+            OMNITRACE_WARNING(0, "[causal] ignoring loaded binary '%s': exceeded the "
+                                 "maximum number of loaded binaries (%zu)\n",
+                              itr.filename().c_str(), max_loaded_binaries);
+            continue;
+        }
+
+        auto* _v   = new loaded_binary{};
+        _v->info   = std::move(itr);
+        _v->scoped = get_eligible_symbols(_v->info, _filters);
+        _v->info.build_index();
+        for(size_t i = 0; i < _v->info.symbols.size(); ++i)
+        {
+            if(_v->scoped.at(i)) _v->eligible += _v->info.symbols.at(i).ipaddr();
+        }
+        _v->eligible.freeze();
+
+        OMNITRACE_VERBOSE(1, "[causal] added loaded binary '%s' (%zu eligible address "
+                             "ranges)...\n",
+                          _v->info.filename().c_str(), _v->eligible.size());
+
+        loaded_binaries[_n] = _v;
+        num_loaded_binaries.store(++_n, std::memory_order_release);
+        loaded_binaries_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
 void
 save_maps_info_impl(std::ostream& _ofs)
 {
@@ -378,12 +515,18 @@ save_maps_info_impl(std::ostream& _ofs)
     _ofs << _maps.str();
 }
 
+// when the scoped view is provided, only the eligible symbols and their inlined
+// functions and line info which satisfy the filters are written
 void
 save_line_info_impl(std::ostream&                           _ofs,
                     const std::vector<binary::binary_info>& _binary_data,
-                    const std::array<bool, 3>&              _info = { true, true, true })
+                    const std::array<bool, 3>&              _info = { true, true, true },
+                    const scoped_info_t*                    _scoped = nullptr)
 {
-    auto _write_impl = [&_ofs, &_info](const binary::binary_info& _data) {
+    static auto _filters = get_filters();
+
+    auto _write_impl = [&_ofs, &_info](const binary::binary_info& _data,
+                                       const std::vector<bool>*   _eligible) {
         for(const auto& itr : _data.mappings)
         {
             _ofs << itr.pathname << " [" << as_hex(itr.load_address) << " - "
@@ -391,8 +534,24 @@ save_line_info_impl(std::ostream&                           _ofs,
         }
 
         auto _emitted_dwarf_addresses = std::set<uintptr_t>{};
-        for(const auto& itr : _data.symbols)
+        for(size_t i = 0; i < _data.symbols.size(); ++i)
         {
+            if(_eligible && !_eligible->at(i)) continue;
+
+            const auto& itr             = _data.symbols.at(i);
+            auto        _scoped_inlines = std::vector<binary::inlined_symbol>{};
+            auto        _scoped_dwarf   = std::vector<binary::dwarf_entry>{};
+            if(_eligible)
+            {
+                _scoped_inlines =
+                    itr.get_inline_symbols<std::vector<binary::inlined_symbol>>(_filters);
+                _scoped_dwarf =
+                    itr.get_debug_line_info<std::vector<binary::dwarf_entry>>(_filters);
+            }
+
+            const auto& _inlines    = (_eligible) ? _scoped_inlines : itr.inlines;
+            const auto& _dwarf_info = (_eligible) ? _scoped_dwarf : itr.dwarf_info;
+
             auto _addr     = itr.address;
             auto _addr_off = itr.address + itr.load_address;
             _ofs << "    " << as_hex(_addr_off) << " [" << as_hex(_addr)
@@ -403,18 +562,18 @@ save_line_info_impl(std::ostream&                           _ofs,
 
             if(std::get<0>(_info))
             {
-                for(const auto& ditr : itr.inlines)
+                for(const auto& ditr : _inlines)
                 {
                     _ofs << "        " << ditr.file << ":" << ditr.line;
                     if(!ditr.func.empty())
-                        _ofs << " [" << tim::demangle(ditr.func) << "]";
+                        _ofs << " [" << tim::demangle(ditr.func.str()) << "]";
                     _ofs << "\n";
                 }
             }
 
             if(std::get<1>(_info))
             {
-                for(const auto& ditr : itr.dwarf_info)
+                for(const auto& ditr : _dwarf_info)
                 {
                     _ofs << "        " << as_hex(ditr.address) << " :: " << ditr.file
                          << ":" << ditr.line;
@@ -438,8 +597,11 @@ save_line_info_impl(std::ostream&                           _ofs,
         _ofs << "\n" << std::flush;
     };
 
-    for(const auto& itr : _binary_data)
-        _write_impl(itr);
+    for(size_t i = 0; i < _binary_data.size(); ++i)
+    {
+        if(_scoped && _scoped->size() != _binary_data.size()) break;
+        _write_impl(_binary_data.at(i), (_scoped) ? &_scoped->at(i) : nullptr);
+    }
 }
 
 void
@@ -455,9 +617,96 @@ compute_eligible_lines()
     });
 }
 
-auto eligible_pc_history    = std::map<uintptr_t, size_t>{};
-auto eligible_pc_idx        = std::atomic<size_t>{ 0 };
-auto eligible_pc_candidates = std::atomic<size_t>{ 0 };
+// per-thread reservoir of the most recently sampled eligible PCs. Each thread only
+// writes to its own (cache-line aligned) reservoir from the sampling signal handler
+// and the experiment thread reads the reservoirs without a lock. A reset increments
+// the epoch and each reservoir discards its PCs the next time it is written in a new
+// epoch so the signal handler never waits on the experiment thread
+struct alignas(container::cacheline_align_v) pc_reservoir
+{
+    static constexpr size_t size = 64;
+
+    std::atomic<uint64_t>                    epoch      = { 0 };
+    std::atomic<uint64_t>                    count      = { 0 };  /// eligible PCs
+    std::atomic<uint64_t>                    candidates = { 0 };  /// all PCs
+    std::array<std::atomic<uintptr_t>, size> pcs        = {};
+};
+
+auto eligible_pc_history = std::unordered_map<uintptr_t, size_t>{};
+auto eligible_pc_epoch   = std::atomic<uint64_t>{ 1 };
+auto eligible_pc_threads = std::atomic<size_t>{ 0 };
+
+auto&
+get_pc_reservoirs()
+{
+    static auto* _v = new std::array<pc_reservoir, max_supported_threads>{};
+    return *_v;
+}
+
+// touch the reservoirs during static initialization so that they are never
+// allocated within the signal handler
+const auto& pc_reservoirs_init = get_pc_reservoirs();
+
+size_t
+get_num_pc_reservoirs()
+{
+    return std::min<size_t>(eligible_pc_threads.load(std::memory_order_relaxed),
+                            max_supported_threads);
+}
+
+size_t
+get_eligible_pc_candidates()
+{
+    const auto _epoch = eligible_pc_epoch.load(std::memory_order_acquire);
+    size_t     _v     = 0;
+    for(size_t i = 0; i < get_num_pc_reservoirs(); ++i)
+    {
+        const auto& itr = get_pc_reservoirs()[i];
+        if(itr.epoch.load(std::memory_order_acquire) == _epoch)
+            _v += itr.candidates.load(std::memory_order_relaxed);
+    }
+    return _v;
+}
+
+template <typename Tp>
+size_t
+record_eligible_pcs(const Tp& _stack)
+{
+    static thread_local auto _idx =
+        eligible_pc_threads.fetch_add(1, std::memory_order_relaxed) %
+        max_supported_threads;
+
+    auto&      _res   = get_pc_reservoirs()[_idx];
+    const auto _epoch = eligible_pc_epoch.load(std::memory_order_acquire);
+    uint64_t   _count = 0;
+    uint64_t   _cands = 0;
+
+    if(_res.epoch.load(std::memory_order_relaxed) != _epoch)
+    {
+        _res.count.store(0, std::memory_order_relaxed);
+        _res.candidates.store(0, std::memory_order_relaxed);
+        _res.epoch.store(_epoch, std::memory_order_release);
+    }
+    else
+    {
+        _count = _res.count.load(std::memory_order_relaxed);
+        _cands = _res.candidates.load(std::memory_order_relaxed);
+    }
+
+    for(auto itr : _stack)
+    {
+        if(itr == 0) continue;
+        ++_cands;
+        if(is_eligible_address(itr))
+            _res.pcs[_count++ % pc_reservoir::size].store(itr,
+                                                          std::memory_order_relaxed);
+    }
+
+    _res.candidates.store(_cands, std::memory_order_relaxed);
+    _res.count.store(_count, std::memory_order_release);
+
+    return _count;
+}
 
 void
 perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
@@ -478,6 +727,9 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
 
     compute_eligible_lines();
 
+    // analyze the libraries which were loaded after the initial binary analysis
+    if(config::get_binary_incremental()) update_loaded_binaries();
+
     // notify that thread has started
     if(_started) _started->set_value();
 
@@ -531,8 +783,21 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
         return false;
     };
 
+    auto _converged = []() {
+        if(adaptive::is_enabled() && adaptive::is_finished())
+        {
+            OMNITRACE_VERBOSE(1, "[causal] stopping experimentation after the effects "
+                                 "of the selections were determined...\n");
+            causal::sampling::post_process();
+            return true;
+        }
+        return false;
+    };
+
     while(get_state() < State::Finalized)
     {
+        if(config::get_binary_incremental()) update_loaded_binaries();
+
         auto _impl_no = _impl_count++;
         auto _experim = experiment{};
 
@@ -546,7 +811,7 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
                 OMNITRACE_VERBOSE(
                     0,
                     "[causal] experiment failed to start. Number of PC candidates: %zu\n",
-                    eligible_pc_candidates.load());
+                    get_eligible_pc_candidates());
 
                 auto _memory   = std::stringstream{};
                 auto _binary   = std::stringstream{};
@@ -556,17 +821,9 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
                 save_maps_info_impl(_memory);
                 save_line_info_impl(_binary, get_cached_binary_info().first,
                                     { true, true, false });
-                save_line_info_impl(_scoped, get_cached_binary_info().second,
-                                    { true, true, false });
-
-                auto _samples_map = std::map<uintptr_t, size_t>{};
-                for(const auto& itr : get_samples())
-                {
-                    for(const auto& iitr : itr.second)
-                    {
-                        _samples_map[iitr.address] += iitr.count;
-                    }
-                }
+                save_line_info_impl(_scoped, get_cached_binary_info().first,
+                                    { true, true, false },
+                                    &get_cached_binary_info().second);
 
                 auto _eligible_pc_hist = std::vector<std::pair<uintptr_t, size_t>>{};
                 for(const auto& itr : eligible_pc_history)
@@ -585,8 +842,8 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
                 }
 
                 auto _samples = std::vector<std::pair<uintptr_t, size_t>>{};
-                for(const auto& itr : _samples_map)
-                    _samples.emplace_back(std::make_pair(itr.first, itr.second));
+                for(const auto& itr : get_total_samples())
+                    _samples.emplace_back(std::make_pair(itr.address, itr.count));
 
                 // sort by most samples
                 std::sort(_samples.begin(), _samples.end(),
@@ -594,13 +851,24 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
                               return _lhs.second > _rhs.second;
                           });
 
+                // resolve the sampled addresses in a single sweep
+                auto _addrs = std::vector<uintptr_t>{};
+                for(const auto& itr : _samples)
+                    if(itr.second > 0) _addrs.emplace_back(itr.first);
+                std::sort(_addrs.begin(), _addrs.end());
+                _addrs.erase(std::unique(_addrs.begin(), _addrs.end()), _addrs.end());
+                auto _entries = binary::lookup_ipaddr_entries<true>(_addrs);
+
                 for(const auto& itr : _samples)
                 {
                     if(itr.second > 0)
                     {
                         auto _is_eligible = is_eligible_address(itr.first) &&
                                             !get_line_info(itr.first, false).empty();
-                        auto _linfo = binary::lookup_ipaddr_entry<true>(itr.first);
+                        const auto& _linfo =
+                            _entries.at(std::lower_bound(_addrs.begin(), _addrs.end(),
+                                                         itr.first) -
+                                        _addrs.begin());
                         if(_linfo)
                         {
                             _sample << "    " << std::setw(8) << itr.second
@@ -648,18 +916,22 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
 
                 return;
             }
+            else if(_converged())
+            {
+                return;
+            }
             else
             {
                 OMNITRACE_VERBOSE(
                     1,
                     "[causal] experiment failed to start. Number of PC candidates: %zu\n",
-                    eligible_pc_candidates.load());
+                    get_eligible_pc_candidates());
             }
         }
 
         OMNITRACE_VERBOSE(3,
                           "[causal] experiment started. Number of PC candidates: %zu\n",
-                          eligible_pc_candidates.load());
+                          get_eligible_pc_candidates());
 
         reset_sample_selection();
 
@@ -684,20 +956,10 @@ perform_experiment_impl(std::shared_ptr<std::promise<void>> _started)  // NOLINT
             if(get_state() == State::Finalized) return;
         }
 
-        if(_exceeded_duration()) return;
+        if(_exceeded_duration() || _converged()) return;
     }
 }
 
-// latest_eligible_pcs is an array of unwind_depth size -> samples will
-// use lowest indexes for most recent functions address in the call-stack
-auto latest_eligible_pc = []() {
-    using atomic_uintptr_t      = std::atomic<uintptr_t>;
-    constexpr size_t array_size = unwind_depth;
-    auto             _arr = std::array<std::unique_ptr<atomic_uintptr_t>, array_size>{};
-    for(auto& itr : _arr)
-        itr = std::make_unique<std::atomic<uintptr_t>>(0);
-    return _arr;
-}();
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -705,21 +967,31 @@ auto latest_eligible_pc = []() {
 bool
 is_eligible_address(uintptr_t _v)
 {
-    return get_eligible_address_ranges().contains(_v);
+    if(get_eligible_address_ranges().contains(_v)) return true;
+
+    auto _n = num_loaded_binaries.load(std::memory_order_acquire);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto* itr = loaded_binaries[i];
+        if(!itr->unloaded.load(std::memory_order_acquire) && itr->eligible.contains(_v))
+            return true;
+    }
+    return false;
 }
 
 void
 save_line_info(const settings::compose_filename_config& _cfg, int _verbose)
 {
     auto _write = [_verbose](const std::string& ofname, const auto& _data,
-                             const std::array<bool, 3>& _info) {
+                             const std::array<bool, 3>& _info,
+                             const scoped_info_t*       _scoped) {
         auto _ofs = std::ofstream{};
         if(tim::filepath::open(_ofs, ofname))
         {
             if(_verbose >= 0)
                 operation::file_output_message<binary::symbol>{}(
                     ofname, std::string{ "causal_symbol_info" });
-            save_line_info_impl(_ofs, _data, _info);
+            save_line_info_impl(_ofs, _data, _info, _scoped);
             save_maps_info_impl(_ofs);
         }
         else
@@ -730,155 +1002,205 @@ save_line_info(const settings::compose_filename_config& _cfg, int _verbose)
 
     _write(tim::settings::compose_output_filename(
                join('-', config::get_causal_output_filename(), "binary"), "txt", _cfg),
-           get_cached_binary_info().first, { true, true, true });
+           get_cached_binary_info().first, { true, true, true }, nullptr);
     _write(tim::settings::compose_output_filename(
                join('-', config::get_causal_output_filename(), "scoped"), "txt", _cfg),
-           get_cached_binary_info().second, { true, true, false });
+           get_cached_binary_info().first, { true, true, false },
+           &get_cached_binary_info().second);
 }
 
 size_t
 set_current_selection(unwind_addr_t _stack)
 {
-    for(auto itr : _stack)
-    {
-        if(itr == 0) continue;
-        ++eligible_pc_candidates;
-        if(is_eligible_address(itr))
-        {
-            auto _idx = eligible_pc_idx++ % latest_eligible_pc.size();
-            latest_eligible_pc.at(_idx)->store(itr);
-        }
-    }
-
-    return eligible_pc_idx.load(std::memory_order_relaxed);
+    return record_eligible_pcs(_stack);
 }
 
 size_t
 set_current_selection(container::c_array<uint64_t> _stack)
 {
-    for(auto itr : _stack)
-    {
-        if(itr == 0) continue;
-        ++eligible_pc_candidates;
-        if(is_eligible_address(itr))
-        {
-            auto _idx = eligible_pc_idx++ % latest_eligible_pc.size();
-            latest_eligible_pc.at(_idx)->store(itr);
-        }
-    }
-
-    return eligible_pc_idx.load(std::memory_order_relaxed);
+    return record_eligible_pcs(_stack);
 }
 
 void
 reset_sample_selection()
 {
-    eligible_pc_idx.store(0);
-    eligible_pc_candidates.store(0);
-    for(auto& itr : latest_eligible_pc)
-    {
-        if(itr) itr->store(0);
-    }
+    eligible_pc_epoch.fetch_add(1, std::memory_order_acq_rel);
 }
 
 selected_entry
-sample_selection(size_t _nitr, size_t _wait_ns)
+get_selection(uintptr_t _addr)
 {
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    uintptr_t _sym_addr    = 0;
+    uintptr_t _lookup_addr = _addr;
+    auto      _dl_info     = unwind::dlinfo::construct(_addr);
 
-    auto _select_address = [&](auto& _address_vec) {
-        // this isn't necessary bc of check before calling this lambda but
-        // kept because of size() - 1 in distribution range
-        if(OMNITRACE_UNLIKELY(_address_vec.empty()))
-        {
-            OMNITRACE_WARNING(0, "no addresses for sample selection...\n");
-            return selected_entry{};
-        }
+    if(get_causal_mode() == CausalMode::Function)
+        _sym_addr = (_dl_info.symbol) ? _dl_info.symbol.address() : _addr;
 
-        while(!_address_vec.empty())
-        {
-            // randomly select an address
-            auto _dist =
-                std::uniform_int_distribution<size_t>{ 0, _address_vec.size() - 1 };
-            auto _idx = _dist(get_engine<selected_entry>());
+    // lookup the PC line info at either the address or the symbol address
+    auto linfo = get_line_info(_lookup_addr, false);
 
-            uintptr_t _addr        = _address_vec.at(_idx);
-            uintptr_t _sym_addr    = 0;
-            uintptr_t _lookup_addr = _addr;
-            auto      _dl_info     = unwind::dlinfo::construct(_addr);
+    // unlikely this will be empty but just in case
+    if(linfo.empty()) return selected_entry{};
 
-            _address_vec.erase(_address_vec.begin() + _idx);
+    // debugging for continuous integration
+    if(OMNITRACE_UNLIKELY(config::get_is_continuous_integration() || config::get_debug()))
+    {
+        auto _location = (_dl_info.location)
+                             ? filepath::realpath(std::string{ _dl_info.location.name },
+                                                  nullptr, false)
+                             : std::string{};
+        for(const auto& itr : linfo)
+        {
+            if(OMNITRACE_UNLIKELY(config::get_debug()))
+            {
+                OMNITRACE_WARNING(0, "[%s][%s][%s][%s] %s [%s:%i][%s][%zu]\n",
+                                  as_hex(_lookup_addr).c_str(), as_hex(_addr).c_str(),
+                                  as_hex(_sym_addr).c_str(),
+                                  (_location.empty()) ? "" : _location.data(),
+                                  demangle(itr.func).c_str(), itr.file.c_str(), itr.line,
+                                  itr.address.as_string().c_str(), itr.address.size());
+            }
+        }
+    }
 
-            eligible_pc_history[_addr] += 1;
+    auto& _linfo_v = (config::get_causal_mode() == CausalMode::Function)
+                         ? linfo.front()
+                         : linfo.back();
+    return selected_entry{ _addr, _sym_addr, _linfo_v };
+}
 
-            if(get_causal_mode() == CausalMode::Function)
-                _sym_addr = (_dl_info.symbol) ? _dl_info.symbol.address() : _addr;
+binary::address_multirange
+get_selection_ranges(const selected_entry& _selection)
+{
+    auto _v = binary::address_multirange{};
+    if(!_selection) return _v;
 
-            // lookup the PC line info at either the address or the symbol address
-            auto linfo = get_line_info(_lookup_addr, false);
+    const auto& _sym     = _selection.symbol;
+    const bool  _is_func = (config::get_causal_mode() == CausalMode::Function);
 
-            // unlikely this will be empty but just in case
-            if(linfo.empty()) continue;
+    _v += _selection.address;
+    if(_selection.symbol_address > 0) _v += _selection.symbol_address;
+    _v += _sym.ipaddr();
 
-            // debugging for continuous integration
-            if(OMNITRACE_UNLIKELY(config::get_is_continuous_integration() ||
-                                  config::get_debug()))
+    for_each_binary_info([&](const binary::binary_info& bitr, const auto*) {
+        bitr.for_each_symbol([&](const binary::symbol& sitr) {
+            if(_is_func)
             {
-                auto _location =
-                    (_dl_info.location)
-                        ? filepath::realpath(std::string{ _dl_info.location.name },
-                                             nullptr, false)
-                        : std::string{};
-                for(const auto& itr : linfo)
-                {
-                    if(OMNITRACE_UNLIKELY(config::get_debug()))
-                    {
-                        OMNITRACE_WARNING(
-                            0, "[%s][%s][%s][%s] %s [%s:%i][%s][%zu]\n",
-                            as_hex(_lookup_addr).c_str(), as_hex(_addr).c_str(),
-                            as_hex(_sym_addr).c_str(),
-                            (_location.empty()) ? "" : _location.data(),
-                            demangle(itr.func).c_str(), itr.file.c_str(), itr.line,
-                            itr.address.as_string().c_str(), itr.address.size());
-                    }
-                }
+                if(sitr.func == _sym.func) _v += sitr.ipaddr();
+                return;
+            }
+
+            for(const auto& ditr : sitr.dwarf_info)
+            {
+                if(ditr.line == _sym.line && ditr.file == _sym.file)
+                    _v += (ditr.address + sitr.load_address);
             }
+        });
+        return false;
+    });
+
+    _v.freeze();
+    return _v;
+}
+
+std::pair<std::string, uintptr_t>
+get_relative_address(uintptr_t _addr)
+{
+    auto _v = std::make_pair(std::string{}, uintptr_t{ 0 });
+    for_each_binary_info([&](const binary::binary_info& itr, const auto*) {
+        if(itr.mappings.empty()) return false;
+
+        auto _base      = std::numeric_limits<uintptr_t>::max();
+        bool _is_mapped = false;
+        for(const auto& mitr : itr.mappings)
+        {
+            auto _range = address_range_t{ mitr.load_address, mitr.last_address };
+            _base       = std::min<uintptr_t>(_base, mitr.load_address);
+            if(_range.contains(_addr)) _is_mapped = true;
+        }
+
+        if(_is_mapped) _v = std::make_pair(itr.filename(), _addr - _base);
+        return _is_mapped;
+    });
+    return _v;
+}
+
+uintptr_t
+get_absolute_address(const std::string& _binary, uintptr_t _offset)
+{
+    auto _v = uintptr_t{ 0 };
+    for_each_binary_info([&](const binary::binary_info& itr, const auto*) {
+        if(itr.mappings.empty() || itr.filename() != _binary) return false;
+
+        auto _base = std::numeric_limits<uintptr_t>::max();
+        for(const auto& mitr : itr.mappings)
+            _base = std::min<uintptr_t>(_base, mitr.load_address);
+        _v = _base + _offset;
+        return true;
+    });
+    return _v;
+}
+
+selected_entry
+sample_selection(size_t _nitr, size_t _wait_ns)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
-            auto& _linfo_v = (config::get_causal_mode() == CausalMode::Function)
-                                 ? linfo.front()
-                                 : linfo.back();
-            return selected_entry{ _addr, _sym_addr, _linfo_v };
+    // the reservoirs of the current epoch weighted by the number of eligible PCs each
+    // thread sampled so the selection is proportional to the samples of all the
+    // threads even though each reservoir only holds the most recent PCs
+    struct candidate
+    {
+        uint64_t            offset = 0;  /// cumulative number of eligible PCs
+        uint64_t            count  = 0;
+        const pc_reservoir* data   = nullptr;
+    };
+
+    auto _candidates = std::vector<candidate>{};
+    auto _total      = uint64_t{ 0 };
+    auto _collect    = [&_candidates, &_total]() {
+        const auto _epoch = eligible_pc_epoch.load(std::memory_order_acquire);
+        _candidates.clear();
+        _total = 0;
+        for(size_t i = 0; i < get_num_pc_reservoirs(); ++i)
+        {
+            const auto& itr = get_pc_reservoirs()[i];
+            if(itr.epoch.load(std::memory_order_acquire) != _epoch) continue;
+            auto _n = itr.count.load(std::memory_order_acquire);
+            if(_n == 0) continue;
+            _total += _n;
+            _candidates.emplace_back(candidate{ _total, _n, &itr });
         }
-        return selected_entry{};
+        return (_total > 0);
     };
 
-    while(eligible_pc_idx.load(std::memory_order_relaxed) == 0)
+    while(!_collect())
     {
         if(get_state() >= State::Finalized) return selected_entry{};
         std::this_thread::yield();
         std::this_thread::sleep_for(std::chrono::nanoseconds{ _wait_ns });
     }
 
+    auto& _engine = get_engine<selected_entry>();
+    auto  _dist   = std::uniform_int_distribution<uint64_t>{ 0, _total - 1 };
     for(size_t _n = 0; _n < _nitr; ++_n)
     {
-        auto _addresses = std::deque<uintptr_t>{};
-        for(auto& aitr : latest_eligible_pc)
-        {
-            if(OMNITRACE_UNLIKELY(!aitr))
-            {
-                OMNITRACE_WARNING(0, "invalid atomic pc...\n");
-                continue;
-            }
+        auto _val  = _dist(_engine);
+        auto _citr = std::upper_bound(
+            _candidates.begin(), _candidates.end(), _val,
+            [](uint64_t _lhs, const candidate& _rhs) { return _lhs < _rhs.offset; });
+        if(_citr == _candidates.end()) continue;
 
-            uintptr_t _addr = aitr->load();
-            if(_addr > 0) _addresses.emplace_back(_addr);
-        }
+        auto _size = std::min<uint64_t>(_citr->count, pc_reservoir::size);
+        auto _idx  = std::uniform_int_distribution<uint64_t>{ 0, _size - 1 }(_engine);
+        auto _addr = _citr->data->pcs[_idx].load(std::memory_order_relaxed);
+        if(_addr == 0) continue;
 
-        if(!_addresses.empty())
-        {
-            auto _selection = _select_address(_addresses);
-            if(_selection) return _selection;
-        }
+        eligible_pc_history[_addr] += 1;
+
+        auto _selection = get_selection(_addr);
+        if(_selection) return _selection;
     }
 
     return selected_entry{};
@@ -887,17 +1209,90 @@ sample_selection(size_t _nitr, size_t _wait_ns)
 std::deque<binary::symbol>
 get_line_info(uintptr_t _addr, bool _include_discarded)
 {
+    using line_info_cache_t = std::unordered_map<uintptr_t, std::deque<binary::symbol>>;
+
     static auto _glob_filters  = get_filters({ sf::BINARY_FILTER });
     static auto _scope_filters = get_filters();
-    auto        _data          = std::deque<binary::symbol>{};
-    auto        _get_line_info = [&](const auto& _info, const auto& _filters) {
-        // search for exact matches first
-        for(const binary::binary_info& litr : _info)
+    static auto _cache_mutex   = std::mutex{};
+    static auto _cache         = std::array<line_info_cache_t, 2>{};
+    static auto _cache_gen     = uint64_t{ 0 };
+
+    // the same PCs are looked up repeatedly so memoize the result once the
+    // binary info has been indexed (i.e. the scoped info is complete). The
+    // memoized results are discarded when a library is loaded or unloaded
+    bool  _use_cache = line_info_indexed.load(std::memory_order_acquire);
+    auto  _gen       = loaded_binaries_generation.load(std::memory_order_acquire);
+    auto& _cache_v   = _cache.at((_include_discarded) ? 1 : 0);
+    if(_use_cache)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _cache_mutex };
+        if(_gen != _cache_gen)
         {
+            for(auto& itr : _cache)
+                itr.clear();
+            _cache_gen = _gen;
+        }
+        auto citr = _cache_v.find(_addr);
+        if(citr != _cache_v.end()) return citr->second;
+    }
+
+    auto _data          = std::deque<binary::symbol>{};
+    // the scoped view restricts the search to the eligible symbols
+    auto _get_line_info = [&](const auto& _filters, bool _scoped) {
+        const auto _empty_index = binary::address_index{};
+
+        auto _get_symbol_info = [&](auto& _local_data, const binary::symbol& ditr,
+                                    const binary::address_index& _line_index) {
+            // skip if load address is greater than address
+            if(_addr < ditr.load_address) return;
+            // compute the symbols ip address range
+            auto _ipaddr = ditr.ipaddr();
+
+            if(!_ipaddr.contains(_addr)) return;
+
+            if(_include_discarded || config::get_causal_mode() == CausalMode::Function)
+            {
+                // check if the primary symbol satisfy the constraints
+                if(ditr(_filters)) _local_data.emplace_back(ditr);
+
+                // the primary symbol may not satisfy the constraints but the inlined
+                // functions may
+                utility::combine(_local_data, ditr.get_inline_symbols(_filters));
+            }
+
+            if(_include_discarded || config::get_causal_mode() == CausalMode::Line)
+            {
+                // when indexed, only the dwarf entries containing the address are
+                // visited. The dwarf entry addresses do not include the load address
+                auto _debug_data = std::deque<binary::symbol>{};
+                auto _line_info =
+                    (_line_index.empty())
+                        ? ditr.get_debug_line_info(_filters)
+                        : ditr.get_debug_line_info(_filters, _line_index,
+                                                   _addr - ditr.load_address);
+                for(const auto& itr : _line_info)
+                {
+                    if(!_ipaddr.contains(itr.ipaddr()))
+                        OMNITRACE_THROW(
+                            "Error! debug line info ipaddr (%s) is not contained in "
+                            "symbol ipaddr (%s)",
+                            as_hex(itr.ipaddr()).c_str(), as_hex(_ipaddr).c_str());
+                    if(itr.ipaddr().contains(_addr)) _debug_data.emplace_back(itr);
+                }
+                utility::combine(_local_data, _debug_data);
+            }
+        };
+
+        // search for exact matches first
+        for_each_binary_info([&](const binary::binary_info& litr,
+                                 const std::vector<bool>*   _scoped_v) {
             auto _local_data = std::deque<binary::symbol>{};
+            auto _eligible   = [&](size_t _idx) {
+                return (!_scoped || !_scoped_v || _scoped_v->at(_idx));
+            };
 
             // make sure the address is in the coarse grained mapped regions
-            // before performing an exhaustive search
+            // before performing a search
             bool _is_mapped = std::find_if(litr.mappings.begin(), litr.mappings.end(),
                                            [_addr](const auto& mitr) {
                                                return address_range_t{ mitr.load_address,
@@ -905,45 +1300,22 @@ get_line_info(uintptr_t _addr, bool _include_discarded)
                                                    .contains(_addr);
                                            }) != litr.mappings.end();
 
-            if(!_is_mapped) return;
+            if(!_is_mapped) return false;
 
-            for(const auto& ditr : litr.symbols)
+            if(litr.is_indexed())
             {
-                // skip if load address is greater than address
-                if(_addr < ditr.load_address) continue;
-                // compute the symbols ip address range
-                auto _ipaddr = ditr.ipaddr();
-                // if the lower bound of the ip address range is greater than the address,
-                // all following symbols are not worth searching since they are at higher
-                // addresses than this symbol (sorted by address)
-                // if(_ipaddr.low > _addr) break;
-
-                if(!_ipaddr.contains(_addr)) continue;
-
-                if(_include_discarded ||
-                   config::get_causal_mode() == CausalMode::Function)
-                {
-                    // check if the primary symbol satisfy the constraints
-                    if(ditr(_filters)) _local_data.emplace_back(ditr);
-
-                    // the primary symbol may not satisfy the constraints but the inlined
-                    // functions may
-                    utility::combine(_local_data, ditr.get_inline_symbols(_filters));
-                }
-
-                if(_include_discarded || config::get_causal_mode() == CausalMode::Line)
+                litr.find_symbols(_addr, [&](const binary::symbol&        ditr,
+                                             const binary::address_index& _line_index,
+                                             size_t                       _idx) {
+                    if(_eligible(_idx)) _get_symbol_info(_local_data, ditr, _line_index);
+                });
+            }
+            else
+            {
+                for(size_t j = 0; j < litr.symbols.size(); ++j)
                 {
-                    auto _debug_data = std::deque<binary::symbol>{};
-                    for(const auto& itr : ditr.get_debug_line_info(_filters))
-                    {
-                        if(!_ipaddr.contains(itr.ipaddr()))
-                            OMNITRACE_THROW(
-                                "Error! debug line info ipaddr (%s) is not contained in "
-                                "symbol ipaddr (%s)",
-                                as_hex(itr.ipaddr()).c_str(), as_hex(_ipaddr).c_str());
-                        if(itr.ipaddr().contains(_addr)) _debug_data.emplace_back(itr);
-                    }
-                    utility::combine(_local_data, _debug_data);
+                    if(_eligible(j))
+                        _get_symbol_info(_local_data, litr.symbols.at(j), _empty_index);
                 }
             }
 
@@ -951,15 +1323,23 @@ get_line_info(uintptr_t _addr, bool _include_discarded)
             {
                 // combine and only allow first match
                 utility::combine(_data, _local_data);
-                if(!_include_discarded) break;
+                if(!_include_discarded) return true;
             }
-        }
+            return false;
+        });
     };
 
+    // the scoped view is complete once the binary info has been indexed
     if(_include_discarded)
-        _get_line_info(get_cached_binary_info().first, _glob_filters);
-    else
-        _get_line_info(get_cached_binary_info().second, _scope_filters);
+        _get_line_info(_glob_filters, false);
+    else if(_use_cache)
+        _get_line_info(_scope_filters, true);
+
+    if(_use_cache)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _cache_mutex };
+        if(_gen == _cache_gen) _cache_v.emplace(_addr, _data);
+    }
 
     return _data;
 }
@@ -1048,6 +1428,12 @@ sample_virtual_speedup()
     }
 }
 
+const std::vector<uint16_t>&
+get_virtual_speedups()
+{
+    return speedup_dist;
+}
+
 void
 start_experimenting()
 {
@@ -1068,6 +1454,8 @@ start_experimenting()
     }
 
     delay::setup();
+    counters::setup();
+    blocking::setup();
     compute_eligible_lines();
 
     if(get_state() < State::Finalized)
@@ -1090,6 +1478,8 @@ finish_experimenting()
     }
     sampling::post_process();
     experiment::save_experiments();
+    blocking::post_process();
+    counters::shutdown();
 }
 }  // namespace causal
 }  // namespace omnitrace
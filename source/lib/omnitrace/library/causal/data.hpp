@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "binary/address_multirange.hpp"
 #include "binary/analysis.hpp"
 #include "core/binary/fwd.hpp"
 #include "core/containers/c_array.hpp"
@@ -39,6 +40,9 @@
 #include <deque>
 #include <dlfcn.h>
 #include <map>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace omnitrace
 {
@@ -61,6 +65,26 @@ reset_sample_selection();
 selected_entry
 sample_selection(size_t _nitr = 1000, size_t _wait_ns = 100000);
 
+// the selection for the address (if it is eligible)
+selected_entry
+get_selection(uintptr_t);
+
+// the address ranges attributed to the selection: the selected range plus the other
+// ranges of the same function (function mode) or of the same file and line (line
+// mode, e.g. inlined call sites). The result is frozen, i.e. lookups are a search
+// over a sorted array of disjoint intervals
+binary::address_multirange
+get_selection_ranges(const selected_entry&);
+
+// the path to the binary containing the address and the offset from the load
+// address of the binary. Used to exchange selections between processes
+std::pair<std::string, uintptr_t>
+get_relative_address(uintptr_t);
+
+// inverse of get_relative_address. Returns zero if the binary is not loaded
+uintptr_t
+get_absolute_address(const std::string&, uintptr_t);
+
 void push_progress_point(std::string_view);
 
 void pop_progress_point(std::string_view);
@@ -71,6 +95,10 @@ mark_progress_point(std::string_view, bool force = false);
 uint16_t
 sample_virtual_speedup();
 
+// the virtual speedups which are sampled from
+const std::vector<uint16_t>&
+get_virtual_speedups();
+
 void
 start_experimenting();
 
@@ -36,8 +36,11 @@
 #include <timemory/mpl/types.hpp>
 #include <timemory/process/threading.hpp>
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <ctime>
 #include <random>
 
 namespace omnitrace
@@ -55,12 +58,46 @@ get_delay_data()
     return _v;
 }
 
+// delays shorter than this are applied by spinning on the clock since the wake-up
+// latency of sleeping is of the same order of magnitude
+constexpr int64_t spin_threshold = 50 * units::usec;
+// weight of the latest measurement in the running estimate of the wake-up latency
+constexpr double sleep_overshoot_weight = 0.125;
+// upper bound of the estimate of the wake-up latency
+constexpr int64_t max_sleep_overshoot = 1 * units::msec;
+
+auto delay_error_count     = std::atomic<uint64_t>{ 0 };
+auto delay_error_requested = std::atomic<int64_t>{ 0 };
+auto delay_error_applied   = std::atomic<int64_t>{ 0 };
+
+inline void
+cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// sleeps until the (absolute) time returned by tracing::now(), which is the realtime
+// clock. Returns immediately if the time has already passed
+void
+sleep_until(int64_t _time)
+{
+    auto _ts = timespec{ static_cast<time_t>(_time / units::sec),
+                         static_cast<long>(_time % units::sec) };
+    while(clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &_ts, nullptr) == EINTR)
+    {}
+}
+
 int64_t
-compute_sleep_for_overhead()
+compute_sleep_overhead()
 {
     using random_engine_t = std::mt19937_64;
+    using distribution_t  = std::uniform_int_distribution<int64_t>;
     auto   _engine        = random_engine_t{ std::random_device{}() };
-    auto   _dist          = std::uniform_int_distribution<int64_t>{ 0, 5 };
+    auto   _dist          = distribution_t{ spin_threshold, 2 * spin_threshold };
     size_t _ntot          = 250;
     size_t _nwarm         = 50;
     auto   _stats         = tim::statistics<double>{};
@@ -68,18 +105,19 @@ compute_sleep_for_overhead()
     {
         auto    _val = _dist(_engine);
         int64_t _beg = tracing::now();
-        std::this_thread::sleep_for(std::chrono::nanoseconds{ _val });
+        sleep_until(_beg + _val);
         int64_t _end = tracing::now();
         if(i < _nwarm) continue;
         auto _diff = (_end - _beg);
         OMNITRACE_CONDITIONAL_THROW(
-            _diff < _val, "Error! sleep_for(%zu) [nanoseconds] >= %zu", _val, _diff);
+            _diff < _val, "Error! clock_nanosleep(%zu) [nanoseconds] >= %zu", _val,
+            _diff);
         _stats += (_diff - _val);
     }
 
     OMNITRACE_BASIC_VERBOSE(2,
-                            "[causal] overhead of std::this_thread::sleep_for(...) "
-                            "invocation = %6.3f usec +/- %e\n",
+                            "[causal] wake-up latency of clock_nanosleep(...) = "
+                            "%6.3f usec +/- %e\n",
                             _stats.get_mean() / units::usec,
                             _stats.get_stddev() / units::usec);
 
@@ -92,65 +130,124 @@ compute_sleep_for_overhead()
     return _stats.get_mean();
 }
 
-int64_t sleep_for_overhead = 0;
+// the local delay of the calling thread. The entry of a thread never moves so the
+// lookup of the thread id and the thread data is only done once per thread
+int64_t&
+get_thread_local()
+{
+    static thread_local int64_t* _v = &delay::get_local();
+    return *_v;
+}
+
+int64_t sleep_overhead = 0;
+
+// running estimate of the wake-up latency of clock_nanosleep for the thread. The
+// estimate is seeded with the one-time calibration and is updated after every sleep,
+// so it follows the CPU the thread is currently scheduled on
+int64_t&
+get_sleep_overshoot()
+{
+    static thread_local int64_t _v = std::min(sleep_overhead, max_sleep_overshoot);
+    return _v;
+}
+
+// applies the delay and returns how long the delay actually was. Long delays sleep
+// until shortly before the end of the delay (by the estimated wake-up latency) and
+// the remainder of the delay and short delays spin on the clock
+int64_t
+apply_delay(int64_t _requested)
+{
+    auto _beg = tracing::now();
+    auto _end = _beg + _requested;
+
+    if(_requested >= spin_threshold)
+    {
+        auto& _overshoot = get_sleep_overshoot();
+        auto  _wake      = _end - _overshoot;
+        if(_wake > _beg)
+        {
+            sleep_until(_wake);
+            auto _latency =
+                std::clamp<int64_t>(tracing::now() - _wake, 0, max_sleep_overshoot);
+            _overshoot +=
+                static_cast<int64_t>(sleep_overshoot_weight * (_latency - _overshoot));
+        }
+    }
+
+    auto _now = tracing::now();
+    while(_now < _end)
+    {
+        cpu_relax();
+        _now = tracing::now();
+    }
+
+    auto _applied = (_now - _beg);
+    delay_error_count.fetch_add(1, std::memory_order_relaxed);
+    delay_error_requested.fetch_add(_requested, std::memory_order_relaxed);
+    delay_error_applied.fetch_add(_applied, std::memory_order_relaxed);
+    return _applied;
+}
 }  // namespace
 
 void
 delay::setup()
 {
     static std::once_flag _once{};
-    std::call_once(_once, []() { sleep_for_overhead = compute_sleep_for_overhead(); });
+    std::call_once(_once, []() { sleep_overhead = compute_sleep_overhead(); });
 }
 
+// outside of an experiment, the global delay does not change and sync() sets the
+// local delay of every thread to the global delay at the start and end of each
+// experiment so there is nothing to do
 void
 delay::process()
 {
-    if(causal::experiment::is_active())
+    if(!causal::experiment::is_active()) return;
+
+    auto& _local  = get_thread_local();
+    auto  _global = get_global().load(std::memory_order_acquire);
+    if(_global < _local)
     {
-        if(get_global() < get_local())
-        {
-            get_global() += (get_local() - get_global());
-        }
-        else if(get_global() > get_local())
-        {
-            ::omnitrace::causal::sampling::pause();
-            auto _beg = tracing::now();
-            std::this_thread::sleep_for(
-                std::chrono::nanoseconds{ get_global() - get_local() });
-            get_local() += (tracing::now() - _beg);
-            ::omnitrace::causal::sampling::resume();
-        }
+        get_global().fetch_add(_local - _global, std::memory_order_acq_rel);
     }
-    else
+    else if(_global > _local)
     {
-        get_local() = get_global();
+        ::omnitrace::causal::sampling::pause();
+        _local += apply_delay(_global - _local);
+        ::omnitrace::causal::sampling::resume();
     }
 }
 
 void
 delay::credit()
 {
-    auto _diff = get_global() - get_local();
+    auto& _local = get_thread_local();
+    auto  _diff  = get_global().load(std::memory_order_acquire) - _local;
     if(_diff > 0)
     {
-        get_local() += _diff;
+        _local += _diff;
     }
 }
 
-void
+// only the rarely-modified epoch and experiment state are read when no experiment is
+// running so that the blocking calls do not read the global delay
+delay::block_state
 delay::preblock()
 {
-    auto _diff = get_global() - get_local();
-    if(_diff > 0)
-    {
-        get_local() += _diff;
-    }
+    auto _epoch = get_epoch().load(std::memory_order_acquire);
+    if(!causal::experiment::is_active()) return block_state{ false, _epoch, 0 };
+    return block_state{ true, _epoch, get_global().load(std::memory_order_acquire) };
 }
 
+// the delays added while the thread was blocked are credited to the thread. If an
+// experiment started or ended while the thread was blocked, sync() already set the
+// local delay to the global delay
 void
-delay::postblock(int64_t _preblock_global_delay_value)
+delay::postblock(block_state _state)
 {
-    get_local() += (get_global() - _preblock_global_delay_value);
+    if(!_state.active || get_epoch().load(std::memory_order_acquire) != _state.epoch)
+        return;
+    get_thread_local() += (get_global().load(std::memory_order_acquire) - _state.global);
 }
 
 int64_t
@@ -158,6 +255,7 @@ delay::sync()
 {
     auto _v = get_global().load(std::memory_order_seq_cst);
     if(get_delay_data()) get_delay_data()->fill(_v);
+    get_epoch().fetch_add(1, std::memory_order_seq_cst);
     return _v;
 }
 
@@ -168,6 +266,13 @@ delay::get_global()
     return _v;
 }
 
+std::atomic<uint64_t>&
+delay::get_epoch()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
 int64_t&
 delay::get_local(int64_t _tid)
 {
@@ -187,5 +292,13 @@ delay::compute_total_delay(uint64_t _baseline)
 {
     return get_global().load() - _baseline;
 }
+
+delay::error_stats
+delay::get_error()
+{
+    return error_stats{ delay_error_count.load(std::memory_order_relaxed),
+                        delay_error_requested.load(std::memory_order_relaxed),
+                        delay_error_applied.load(std::memory_order_relaxed) };
+}
 }  // namespace causal
 }  // namespace omnitrace
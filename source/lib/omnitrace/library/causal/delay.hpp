@@ -42,20 +42,39 @@ struct delay : comp::empty_base
 {
     using value_type = void;
 
+    // the delays requested by process() and the delays which were actually applied
+    struct error_stats
+    {
+        uint64_t count     = 0;  /// number of delays
+        int64_t  requested = 0;  /// sum of the requested delays [nsec]
+        int64_t  applied   = 0;  /// sum of the applied delays [nsec]
+    };
+
+    // the global delay before a blocking call. Only valid (active) when an experiment
+    // was running and only applied if no experiment started or ended while blocked
+    struct block_state
+    {
+        bool     active = false;
+        uint64_t epoch  = 0;
+        int64_t  global = 0;
+    };
+
     OMNITRACE_DEFAULT_OBJECT(delay)
 
-    static void    setup();
-    static void    process();
-    static void    credit();
-    static void    preblock();
-    static void    postblock(int64_t);
-    static int64_t sync();
+    static void        setup();
+    static void        process();
+    static void        credit();
+    static block_state preblock();
+    static void        postblock(block_state);
+    static int64_t     sync();
 
-    static std::atomic<int64_t>& get_global();
-    static int64_t&              get_local(int64_t _tid = threading::get_id());
+    static std::atomic<int64_t>&  get_global();
+    static std::atomic<uint64_t>& get_epoch();
+    static int64_t&               get_local(int64_t _tid = threading::get_id());
 
-    static int64_t  get(int64_t _tid = threading::get_id());
-    static uint64_t compute_total_delay(uint64_t);
+    static int64_t     get(int64_t _tid = threading::get_id());
+    static uint64_t    compute_total_delay(uint64_t);
+    static error_stats get_error();
 };
 }  // namespace causal
 }  // namespace omnitrace
@@ -0,0 +1,128 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/causal/device.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/utility.hpp"
+#include "library/causal/delay.hpp"
+#include "library/causal/experiment.hpp"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace device
+{
+namespace
+{
+struct op_data
+{
+    uint64_t count    = 0;  /// number of completions
+    uint64_t duration = 0;  /// total runtime [nsec]
+};
+
+auto&
+get_op_mutex()
+{
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+auto&
+get_op_data()
+{
+    static auto* _v = new std::unordered_map<std::string, op_data>{};
+    return *_v;
+}
+
+auto&
+get_engine()
+{
+    static auto _v = []() {
+        auto _seed = config::get_setting_value<uint64_t>("OMNITRACE_CAUSAL_RANDOM_SEED")
+                         .value_or(0);
+        if(_seed == 0) _seed = std::random_device{}();
+        return std::mt19937_64{ _seed };
+    }();
+    return _v;
+}
+}  // namespace
+
+bool
+is_enabled()
+{
+    return (config::get_use_causal() && config::get_causal_gpu());
+}
+
+void
+record(const char* _name, int64_t _tid, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(_name == nullptr || _end_ns <= _beg_ns) return;
+
+    auto _duration = (_end_ns - _beg_ns);
+    {
+        auto  _lk    = locking::atomic_lock{ get_op_mutex() };
+        auto& _entry = get_op_data()[_name];
+        _entry.count += 1;
+        _entry.duration += _duration;
+    }
+
+    if(_tid < 0 || !experiment::is_selected(std::string_view{ _name })) return;
+
+    // delay every thread except the thread which launched the kernel
+    auto _delay = static_cast<int64_t>(experiment::get_delay_scaling() * _duration);
+    if(_delay <= 0) return;
+
+    experiment::add_selected();
+    delay::get_global() += _delay;
+    delay::get_local(_tid) += _delay;
+}
+
+std::optional<std::string>
+sample_selection()
+{
+    auto _lk      = locking::atomic_lock{ get_op_mutex() };
+    auto _names   = std::vector<const std::string*>{};
+    auto _weights = std::vector<double>{};
+    _names.reserve(get_op_data().size());
+    _weights.reserve(get_op_data().size());
+    for(const auto& itr : get_op_data())
+    {
+        _names.emplace_back(&itr.first);
+        _weights.emplace_back(static_cast<double>(itr.second.duration));
+    }
+
+    if(_names.empty()) return std::nullopt;
+
+    auto _dist = std::discrete_distribution<size_t>{ _weights.begin(), _weights.end() };
+    return *_names.at(_dist(get_engine()));
+}
+}  // namespace device
+}  // namespace causal
+}  // namespace omnitrace
@@ -0,0 +1,58 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace omnitrace
+{
+namespace causal
+{
+namespace device
+{
+// causal experiments on GPU kernels and HIP API calls (OMNITRACE_CAUSAL_GPU). The
+// roctracer callbacks record the runtime of every kernel and HIP API call. When the
+// kernel or HIP API call of the current experiment completes, the other host threads
+// are delayed by the virtual speedup of its runtime, i.e. the thread which launched
+// the kernel (or called the HIP API function) gets ahead of the other threads as if
+// the kernel had been faster.
+bool
+is_enabled();
+
+// records the completion of a kernel or HIP API call. The name is the (mangled)
+// kernel name or the name of the HIP API function and the thread is the thread which
+// launched the kernel or called the HIP API function
+void
+record(const char* _name, int64_t _tid, uint64_t _beg_ns, uint64_t _end_ns);
+
+// a kernel or HIP API call sampled in proportion to its total runtime. Returns nothing
+// if no kernels or HIP API calls have been recorded
+std::optional<std::string>
+sample_selection();
+}  // namespace device
+}  // namespace causal
+}  // namespace omnitrace
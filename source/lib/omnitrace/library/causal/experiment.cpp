@@ -28,10 +28,14 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/state.hpp"
+#include "library/causal/adaptive.hpp"
 #include "library/causal/components/backtrace.hpp"
 #include "library/causal/components/progress_point.hpp"
+#include "library/causal/coordinate.hpp"
+#include "library/causal/counters.hpp"
 #include "library/causal/data.hpp"
 #include "library/causal/delay.hpp"
+#include "library/causal/device.hpp"
 #include "library/causal/sample_data.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
@@ -47,11 +51,21 @@
 #include <timemory/units.hpp>
 #include <timemory/unwind/dlinfo.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <fcntl.h>
+#include <fstream>
+#include <ostream>
 #include <ratio>
 #include <regex>
+#include <sstream>
 #include <string>
+#include <sys/file.h>
 #include <thread>
+#include <unistd.h>
 #include <vector>
 
 namespace omnitrace
@@ -71,6 +85,232 @@ int64_t global_scaling            = 1;
 int64_t global_scaling_increments = 0;
 bool    use_exp_speedup_scaling =
     get_env<bool>("OMNITRACE_CAUSAL_SCALE_EXPERIMENT_TIME_BY_SPEEDUP", false);
+
+// most recent round of coordinated experiments (see OMNITRACE_CAUSAL_COORDINATE)
+uint32_t coordinated_round = 0;
+
+// the address ranges of the current selection which are checked by the sampler.
+// Consecutive experiments alternate between the two so that a sampler which is
+// still checking the ranges of the previous experiment is never invalidated
+auto selection_ranges         = std::array<binary::address_multirange, 2>{};
+auto current_selection_ranges = std::atomic<const binary::address_multirange*>{};
+
+// writes the experiment in the format of the coz profiler
+void
+write_coz_experiment(std::ostream& ofs, const experiment& itr)
+{
+    const auto& _selection = itr.selection;
+    const auto& _line_info = _selection.symbol;
+
+    std::string _name = (_selection.symbol_address > 0)
+                            ? _line_info.func
+                            : join(":", _line_info.file, _line_info.line);
+
+    // GPU kernel or HIP API call
+    if(!itr.device_op.empty()) _name = itr.device_op;
+
+    OMNITRACE_CONDITIONAL_THROW(
+        _name.empty(),
+        "Error! causal experiment selection has no name: address=%s, file=%s, "
+        "line=%u, func=%s",
+        as_hex(_line_info.address).c_str(), _line_info.file.c_str(), _line_info.line,
+        _line_info.func.c_str());
+
+    ofs << "experiment\tselected=" << demangle(_name) << "\tspeedup="
+        << std::setprecision(2) << static_cast<double>(itr.virtual_speedup / 100.0)
+        << "\tduration=" << itr.duration << "\tselected-samples=" << itr.selected
+        << "\n";
+
+    auto ppts = itr.fini_progress;
+    for(auto pitr : itr.init_progress)
+        ppts[pitr.first] -= pitr.second;
+
+    for(auto pitr : ppts)
+    {
+        // if(pitr.second.get_laps() == 0) continue;
+        if(get_causal_end_to_end() && pitr.second.get_laps() > 1) continue;
+        if(pitr.second.is_throughput_point() && pitr.second.get_delta() != 0)
+        {
+            ofs << "throughput-point\tname="
+                << tim::demangle(tim::get_hash_identifier(pitr.first))
+                << "\tdelta=" << pitr.second.get_delta() << "\n";
+            if(get_causal_end_to_end()) break;
+        }
+        if(pitr.second.is_latency_point())
+        {
+            if(get_causal_end_to_end()) continue;
+            auto _delta = std::max<int64_t>(pitr.second.get_latency_delta(), 1);
+            ofs << "latency-point\tname="
+                << tim::demangle(tim::get_hash_identifier(pitr.first))
+                << "\tarrivals=" << pitr.second.get_arrival()
+                << "\tdepartures=" << pitr.second.get_departure()
+                << "\tdifference=" << _delta << "\n";
+        }
+    }
+}
+
+// omnitrace-causal may run multiple processes concurrently which append their
+// experiments to the same output files
+struct scoped_file_lock
+{
+    explicit scoped_file_lock(const std::string& _fname)
+    {
+        // filepath::open creates the output directory if necessary
+        {
+            auto _ofs = std::ofstream{};
+            if(!filepath::open(_ofs, _fname, std::ios::out | std::ios::app)) return;
+        }
+        m_fd = open(_fname.c_str(), O_RDWR | O_CLOEXEC);
+        if(m_fd >= 0 && flock(m_fd, LOCK_EX) != 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    ~scoped_file_lock()
+    {
+        if(m_fd < 0) return;
+        flock(m_fd, LOCK_UN);
+        close(m_fd);
+    }
+
+    scoped_file_lock(const scoped_file_lock&) = delete;
+    scoped_file_lock(scoped_file_lock&&)      = delete;
+    scoped_file_lock& operator=(const scoped_file_lock&) = delete;
+    scoped_file_lock& operator=(scoped_file_lock&&) = delete;
+
+private:
+    int m_fd = -1;
+};
+
+// line-delimited JSON log of the experiments (OMNITRACE_CAUSAL_LOG)
+std::string
+get_log_filename()
+{
+    auto _cfg         = settings::compose_filename_config{};
+    _cfg.subdirectory = "causal";
+    _cfg.use_suffix   = config::get_use_pid();
+    return tim::settings::compose_output_filename(config::get_causal_output_filename(),
+                                                  "jsonl", _cfg);
+}
+
+// every entry in the log identifies the run (process) it belongs to
+template <typename FuncT>
+std::string
+get_log_entry(FuncT&& _func)
+{
+    const auto& _info0   = thread_info::get(0, InternalTID);
+    int64_t     _pid     = getpid();
+    int64_t     _startup = _info0->lifetime.first;
+    auto        _oss     = std::stringstream{};
+    {
+        auto ar =
+            tim::policy::output_archive<cereal::MinimalJSONOutputArchive>::get(_oss);
+        (*ar)(cereal::make_nvp("pid", _pid), cereal::make_nvp("startup", _startup));
+        std::forward<FuncT>(_func)(*ar);
+    }
+    return _oss.str();
+}
+
+// appends the entry as a single line. The log is locked while writing since multiple
+// processes (e.g. omnitrace-causal --jobs) may append to the same log
+void
+append_log(std::string _entry)
+{
+    auto _fname = get_log_filename();
+    {
+        // filepath::open creates the output directory if necessary
+        auto _ofs = std::ofstream{};
+        if(!filepath::open(_ofs, _fname, std::ios::out | std::ios::app))
+        {
+            OMNITRACE_VERBOSE(0, "[causal] Error opening causal experiment log: %s\n",
+                              _fname.c_str());
+            return;
+        }
+    }
+
+    std::replace(_entry.begin(), _entry.end(), '\n', ' ');
+    _entry += "\n";
+
+    auto _fd = ::open(_fname.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if(_fd < 0) return;
+    if(flock(_fd, LOCK_EX) == 0)
+    {
+        const char* _data = _entry.data();
+        size_t      _size = _entry.size();
+        while(_size > 0)
+        {
+            auto _ret = ::write(_fd, _data, _size);
+            if(_ret < 0 && errno == EINTR) continue;
+            if(_ret <= 0) break;
+            _data += _ret;
+            _size -= _ret;
+        }
+        flock(_fd, LOCK_UN);
+    }
+    ::close(_fd);
+}
+
+void
+wait_until(uint64_t _time)
+{
+    while(tracing::now() < _time && get_state() < State::Finalized)
+    {
+        std::this_thread::yield();
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+    }
+}
+
+// rank zero: publishes the experiment and waits for the other processes to read it
+bool
+schedule_round(experiment& _v)
+{
+    auto _addr = get_relative_address(_v.selection.address);
+    if(_addr.first.empty()) return false;
+
+    auto _round            = coordinate::round{};
+    _round.index           = ++coordinated_round;
+    _round.virtual_speedup = _v.virtual_speedup;
+    _round.start_time      = coordinate::get_start_time();
+    _round.experiment_time = _v.experiment_time;
+    _round.offset          = _addr.second;
+    _round.binary          = _addr.first;
+    coordinate::publish(_round);
+
+    wait_until(_round.start_time);
+    return (get_state() < State::Finalized);
+}
+
+// other ranks: performs the next experiment scheduled by rank zero
+bool
+join_round(experiment& _v)
+{
+    auto _round = coordinate::wait(coordinated_round);
+    if(!_round) return false;
+
+    coordinated_round = _round->index;
+
+    auto _addr   = get_absolute_address(_round->binary, _round->offset);
+    _v.selection = (_addr > 0) ? get_selection(_addr) : selected_entry{};
+    if(!_v.selection)
+    {
+        OMNITRACE_VERBOSE(1, "[causal] skipping round #%u :: %s+0x%lx is not eligible\n",
+                          _round->index, _round->binary.c_str(),
+                          static_cast<unsigned long>(_round->offset));
+        return false;
+    }
+
+    _v.sampling_period = backtrace_causal::get_period(units::nsec);
+    _v.index           = experiment_history.size() + 1;
+    _v.virtual_speedup = _round->virtual_speedup;
+    _v.delay_scaling   = _v.virtual_speedup / 100.0;
+    _v.experiment_time = _round->experiment_time;
+    _v.sample_delay    = _v.sampling_period * _v.delay_scaling;
+
+    wait_until(_round->start_time);
+    return (get_state() < State::Finalized);
+}
 }  // namespace
 
 experiment::sample::sample(const base_type& _b, uint64_t _c)
@@ -184,6 +424,36 @@ experiment::serialize(ArchiveT& ar, const unsigned)
        cereal::make_nvp("global_delay", global_delay),
        cereal::make_nvp("selection", selection));
 
+    // the applied vs. requested delays were added later and are not present in the
+    // existing output files which are appended to
+    if constexpr(concepts::is_input_archive<ArchiveT>::value)
+    {
+        try
+        {
+            ar(cereal::make_nvp("delay_count", delay_count),
+               cereal::make_nvp("delay_error", delay_error));
+        } catch(std::exception&)
+        {
+            delay_count = 0;
+            delay_error = 0;
+        }
+
+        try
+        {
+            ar(cereal::make_nvp("device_op", device_op));
+        } catch(std::exception&)
+        {
+            device_op = {};
+        }
+    }
+    else
+    {
+        auto _device_op = (device_op.empty()) ? device_op : demangle(device_op);
+        ar(cereal::make_nvp("delay_count", delay_count),
+           cereal::make_nvp("delay_error", delay_error),
+           cereal::make_nvp("device_op", _device_op));
+    }
+
     if constexpr(concepts::is_input_archive<ArchiveT>::value)
     {
         auto _ppts = std::vector<component::progress_point>{};
@@ -233,31 +503,61 @@ experiment::start()
 {
     if(running && tracing::now() < start_time + experiment_time) return false;
 
-    selection = sample_selection();
-    if(!selection) return false;
+    if(coordinate::is_enabled() && !coordinate::is_leader())
+    {
+        if(!join_round(*this)) return false;
+    }
+    else
+    {
+        // every other experiment selects a GPU kernel or HIP API call (if any)
+        device_op = {};
+        if(device::is_enabled() && !coordinate::is_enabled() &&
+           experiment_history.size() % 2 == 1)
+            device_op = device::sample_selection().value_or(std::string{});
 
-    // sampling period in nanoseconds
-    sampling_period = backtrace_causal::get_period(units::nsec);
+        if(device_op.empty())
+        {
+            selection = sample_selection();
+            if(!selection) return false;
+            // the effect of the selection is already known
+            if(adaptive::is_enabled() && adaptive::is_known(selection)) return false;
+        }
+
+        // sampling period in nanoseconds
+        sampling_period = backtrace_causal::get_period(units::nsec);
+
+        // experiment time is scaled up for longer speedups
+        index           = experiment_history.size() + 1;
+        virtual_speedup = (adaptive::is_enabled() && device_op.empty())
+                              ? adaptive::sample_virtual_speedup(selection)
+                              : sample_virtual_speedup();
+        delay_scaling   = virtual_speedup / 100.0;
+        if(use_exp_speedup_scaling) scaling_factor *= (1.0 + delay_scaling);
 
-    // experiment time is scaled up for longer speedups
-    index           = experiment_history.size() + 1;
-    virtual_speedup = sample_virtual_speedup();
-    delay_scaling   = virtual_speedup / 100.0;
-    if(use_exp_speedup_scaling) scaling_factor *= (1.0 + delay_scaling);
+        experiment_time = global_scaling * scaling_factor * sampling_period * batch_size;
+        sample_delay    = sampling_period * delay_scaling;
 
-    experiment_time = global_scaling * scaling_factor * sampling_period * batch_size;
-    sample_delay    = sampling_period * delay_scaling;
+        if(coordinate::is_enabled() && !schedule_round(*this)) return false;
+    }
+
+    auto _delay_err = delay::get_error();
     total_delay     = delay::sync();
+    delay_count     = _delay_err.count;
+    delay_error     = (_delay_err.applied - _delay_err.requested);
     init_progress   = component::progress_point::get_progress_points();
     start_time      = tracing::now();
+    counters::read(init_progress);
 
     OMNITRACE_VERBOSE(0, "Starting causal experiment #%-3u: %s\n", index,
                       as_string().c_str());
 
     if(get_state() < State::Finalized)
     {
+        auto& _ranges            = selection_ranges.at(index % selection_ranges.size());
+        _ranges                  = get_selection_ranges(selection);
         current_experiment_value = *this;
         current_selected_count.store(0);
+        current_selection_ranges.store(&_ranges, std::memory_order_release);
         current_experiment.store(this);
         return true;
     }
@@ -294,10 +594,24 @@ experiment::stop()
     total_delay     = (global_delay - total_delay);
     duration      = (experiment_time > total_delay) ? (experiment_time - total_delay) : 0;
     fini_progress = component::progress_point::get_progress_points();
+    counters::read(fini_progress);
 
     // sync data
     delay::sync();
 
+    auto _delay_err = delay::get_error();
+    delay_count     = (_delay_err.count - delay_count);
+    delay_error     = (_delay_err.applied - _delay_err.requested) - delay_error;
+
+    OMNITRACE_VERBOSE(2,
+                      "[causal] experiment #%-3u applied %zu delays with a total error "
+                      "of %.3f usec (mean: %.3f usec)\n",
+                      index, static_cast<size_t>(delay_count),
+                      static_cast<double>(delay_error) / units::usec,
+                      (delay_count > 0) ? static_cast<double>(delay_error) /
+                                              delay_count / units::usec
+                                        : 0.0);
+
     auto _prog_stats = tim::statistics<double>{};
     auto _prog_vals  = std::vector<int64_t>{};
     _prog_vals.reserve(fini_progress.size());
@@ -350,10 +664,32 @@ experiment::stop()
             global_scaling_increments);
     }
 
-    if(_high > 0) experiment_history.emplace_back(*this);
+    if(_high > 0)
+    {
+        experiment_history.emplace_back(*this);
+
+        if(adaptive::is_enabled() && device_op.empty()) adaptive::record(*this);
+
+        if(config::get_causal_log() && duration > 0 && experiment_time > 0)
+        {
+            append_log(get_log_entry(
+                [this](auto& ar) { ar(cereal::make_nvp("experiment", *this)); }));
+        }
+
+        // combine the progress points of all the processes
+        if(coordinate::is_enabled())
+        {
+            auto _oss = std::ostringstream{};
+            _oss.setf(std::ios::fixed);
+            write_coz_experiment(_oss, *this);
+            coordinate::write_progress(_oss.str());
+        }
+    }
 
-    std::this_thread::sleep_for(
-        std::chrono::nanoseconds{ 5 * sampling_period * batch_size });
+    // the other ranks wait for the next experiment from rank zero
+    if(!coordinate::is_enabled() || coordinate::is_leader())
+        std::this_thread::sleep_for(
+            std::chrono::nanoseconds{ 5 * sampling_period * batch_size });
 
     return true;
 }
@@ -369,6 +705,12 @@ experiment::as_string() const
     if(!config::get_causal_end_to_end())
         _ss << ", duration: " << std::setw(5) << std::fixed << std::setprecision(3)
             << _dur << " sec";
+    if(!device_op.empty())
+    {
+        _ss << " :: experiment: [gpu] ['" << demangle(device_op) << "']";
+        return _ss.str();
+    }
+
     _ss << " :: experiment: " << as_hex(selection.address) << " ";
     if(selection.symbol_address > 0 && selection.address != selection.symbol_address)
         _ss << "(symbol@" << as_hex(selection.symbol_address) << ") ";
@@ -427,31 +769,40 @@ experiment::is_active()
 bool
 experiment::is_selected(uint64_t _addr)
 {
-    return (is_active() && current_experiment_value.selection.contains(_addr));
+    if(!is_active()) return false;
+    const auto* _ranges = current_selection_ranges.load(std::memory_order_acquire);
+    return (_ranges && _ranges->contains(_addr));
 }
 
 bool
 experiment::is_selected(unwind_addr_t _stack)
 {
-    if(is_active())
-    {
-        for(auto itr : _stack)
-            if(itr > 0 && current_experiment_value.selection.contains(itr)) return true;
-    }
+    if(!is_active()) return false;
+    const auto* _ranges = current_selection_ranges.load(std::memory_order_acquire);
+    if(!_ranges) return false;
+    for(auto itr : _stack)
+        if(itr > 0 && _ranges->contains(itr)) return true;
     return false;
 }
 
 bool
 experiment::is_selected(container::c_array<uint64_t> _stack)
 {
-    if(is_active())
-    {
-        for(auto itr : _stack)
-            if(itr > 0 && current_experiment_value.selection.contains(itr)) return true;
-    }
+    if(!is_active()) return false;
+    const auto* _ranges = current_selection_ranges.load(std::memory_order_acquire);
+    if(!_ranges) return false;
+    for(auto itr : _stack)
+        if(itr > 0 && _ranges->contains(itr)) return true;
     return false;
 }
 
+bool
+experiment::is_selected(std::string_view _device_op)
+{
+    return (is_active() && !current_experiment_value.device_op.empty() &&
+            current_experiment_value.device_op == _device_op);
+}
+
 void
 experiment::add_selected()
 {
@@ -479,6 +830,9 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
 {
     const auto& _info0 = thread_info::get(0, InternalTID);
 
+    auto _lock = scoped_file_lock{ tim::settings::compose_output_filename(
+        _fname_base, "lock", _cfg) };
+
     auto current_record    = record{};
     current_record.startup = _info0->lifetime.first;
 
@@ -512,22 +866,15 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
             current_record.samples.emplace_back(std::move(_v));
         };
 
-        auto _total_samples = std::map<uintptr_t, size_t>{};
-        for(const auto& itr : get_samples())
-        {
-            for(const auto& sitr : itr.second)
-            {
-                _total_samples[sitr.address] += sitr.count;
-            }
-        }
+        auto _total_samples = get_total_samples();
 
         OMNITRACE_VERBOSE_F(1, "Processing line info for %zu sampled addresses...\n",
                             _total_samples.size());
 
         for(const auto& itr : _total_samples)
         {
-            auto _entry = binary::lookup_ipaddr_entry<true>(itr.first);
-            if(_entry) _add_sample(sample{ *_entry, itr.second });
+            auto _entry = binary::lookup_ipaddr_entry<true>(itr.address);
+            if(_entry) _add_sample(sample{ *_entry, itr.count });
         }
 
         auto _binfo_cfg         = settings::compose_filename_config{};
@@ -536,11 +883,21 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
         save_line_info(_binfo_cfg, config::get_verbose());
     }
 
+    // the experiments were appended to the log as they completed
+    if(config::get_causal_log())
+    {
+        append_log(get_log_entry([&current_record](auto& ar) {
+            ar(cereal::make_nvp("runtime", current_record.runtime),
+               cereal::make_nvp("samples", current_record.samples));
+        }));
+    }
+
     bool _causal_output_reset =
         config::get_setting_value<bool>("OMNITRACE_CAUSAL_FILE_RESET").value_or(false);
 
     {
-        auto _saved_experiments = (_causal_output_reset)
+        // the log holds the previous runs so the JSON output is not re-read
+        auto _saved_experiments = (_causal_output_reset || config::get_causal_log())
                                       ? std::vector<experiment::record>{}
                                       : load_experiments(_fname_base, _cfg, false);
         _saved_experiments.emplace_back(current_record);
@@ -576,82 +933,21 @@ experiment::save_experiments(std::string _fname_base, const filename_config_t& _
 
     auto _fname = tim::settings::compose_output_filename(_fname_base, "coz", _cfg);
 
-    // read in existing data
-    auto _existing = std::stringstream{};
-    if(!_causal_output_reset)
-    {
-        std::ifstream ifs{ _fname };
-        if(ifs)
-        {
-            while(ifs && ifs.good())
-            {
-                std::string _line;
-                std::getline(ifs, _line);
-                _existing << _line << "\n";
-            }
-        }
-    }
+    // append to the existing data
+    auto _mode = (_causal_output_reset) ? std::ios::out : (std::ios::out | std::ios::app);
 
     std::ofstream ofs{};
     ofs.setf(std::ios::fixed);
-    if(tim::filepath::open(ofs, _fname))
+    if(tim::filepath::open(ofs, _fname, _mode))
     {
         if(get_verbose() >= 0)
             operation::file_output_message<experiment>{}(
                 _fname, std::string{ "causal_experiments" });
 
-        ofs << _existing.str();
         ofs << "startup\ttime=" << current_record.startup << "\n";
 
-        for(auto& itr : current_record.experiments)
-        {
-            auto& _selection = itr.selection;
-            auto& _line_info = _selection.symbol;
-
-            std::string _name = (_selection.symbol_address > 0)
-                                    ? _line_info.func
-                                    : join(":", _line_info.file, _line_info.line);
-
-            OMNITRACE_CONDITIONAL_THROW(
-                _name.empty(),
-                "Error! causal experiment selection has no name: address=%s, file=%s, "
-                "line=%u, func=%s",
-                as_hex(_line_info.address).c_str(), _line_info.file.c_str(),
-                _line_info.line, _line_info.func.c_str());
-
-            ofs << "experiment\tselected=" << demangle(_name)
-                << "\tspeedup=" << std::setprecision(2)
-                << static_cast<double>(itr.virtual_speedup / 100.0)
-                << "\tduration=" << itr.duration << "\tselected-samples=" << itr.selected
-                << "\n";
-
-            auto ppts = itr.fini_progress;
-            for(auto pitr : itr.init_progress)
-                ppts[pitr.first] -= pitr.second;
-
-            for(auto pitr : ppts)
-            {
-                // if(pitr.second.get_laps() == 0) continue;
-                if(get_causal_end_to_end() && pitr.second.get_laps() > 1) continue;
-                if(pitr.second.is_throughput_point() && pitr.second.get_delta() != 0)
-                {
-                    ofs << "throughput-point\tname="
-                        << tim::demangle(tim::get_hash_identifier(pitr.first))
-                        << "\tdelta=" << pitr.second.get_delta() << "\n";
-                    if(get_causal_end_to_end()) break;
-                }
-                if(pitr.second.is_latency_point())
-                {
-                    if(get_causal_end_to_end()) continue;
-                    auto _delta = std::max<int64_t>(pitr.second.get_latency_delta(), 1);
-                    ofs << "latency-point\tname="
-                        << tim::demangle(tim::get_hash_identifier(pitr.first))
-                        << "\tarrivals=" << pitr.second.get_arrival()
-                        << "\tdepartures=" << pitr.second.get_departure()
-                        << "\tdifference=" << _delta << "\n";
-                }
-            }
-        }
+        for(const auto& itr : current_record.experiments)
+            write_coz_experiment(ofs, itr);
 
         ofs << "runtime\ttime=" << current_record.runtime << "\n";
 
@@ -41,6 +41,8 @@
 
 #include <atomic>
 #include <cstdint>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 
 namespace omnitrace
@@ -110,6 +112,7 @@ struct experiment
     static bool          is_selected(uint64_t);
     static bool          is_selected(unwind_addr_t);
     static bool          is_selected(container::c_array<uint64_t>);
+    static bool          is_selected(std::string_view);  // GPU kernel or HIP API call
     static void          add_selected();
     static experiments_t get_experiments();
 
@@ -139,8 +142,11 @@ struct experiment
     uint64_t          total_delay     = 0;    /// total delays [nsec]
     uint64_t          selected        = 0;    /// num times selected line sampled
     uint64_t          global_delay    = 0;
+    uint64_t          delay_count     = 0;    /// num delays applied by this process
+    int64_t           delay_error     = 0;    /// applied - requested delays [nsec]
     double            delay_scaling   = 0.0;  /// virtual_speedup / 100.
     selected_entry    selection       = {};   /// which line was selected
+    std::string       device_op       = {};   /// which kernel/HIP API call was selected
     progress_points_t init_progress   = {};   /// progress points at start
     progress_points_t fini_progress   = {};   /// progress points at end
 };
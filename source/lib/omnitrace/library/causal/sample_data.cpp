@@ -21,11 +21,16 @@
 // SOFTWARE.
 
 #include "library/causal/sample_data.hpp"
+#include "core/locking.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <set>
+#include <utility>
+#include <vector>
 
 namespace omnitrace
 {
@@ -33,38 +38,211 @@ namespace causal
 {
 namespace
 {
-auto samples = std::map<uint32_t, std::map<uintptr_t, uint64_t>>{};
+// open-addressing (linear probing) hash table of PC -> count. Address zero marks an
+// empty slot. Clearing the table retains the capacity so that a table which is reused
+// for every experiment stops allocating once it is large enough for the number of
+// distinct PCs
+struct pc_count_table
+{
+    using value_type = std::pair<uintptr_t, uint64_t>;
+
+    static constexpr size_t min_capacity = 64;
+
+    void add(uintptr_t _addr, uint64_t _count)
+    {
+        if(_addr == 0) return;
+        if(2 * (m_size + 1) > m_slots.size())
+            rehash(std::max(min_capacity, 2 * m_slots.size()));
+
+        auto& _slot = find(_addr);
+        if(_slot.first == 0)
+        {
+            _slot.first = _addr;
+            ++m_size;
+        }
+        _slot.second += _count;
+    }
+
+    void merge(const pc_count_table& _v)
+    {
+        _v.for_each([this](uintptr_t _addr, uint64_t _count) { add(_addr, _count); });
+    }
+
+    template <typename FuncT>
+    void for_each(FuncT&& _func) const
+    {
+        if(m_size == 0) return;
+        for(const auto& itr : m_slots)
+            if(itr.first != 0) _func(itr.first, itr.second);
+    }
+
+    void clear()
+    {
+        if(m_size == 0) return;
+        std::fill(m_slots.begin(), m_slots.end(), value_type{ 0, 0 });
+        m_size = 0;
+    }
+
+    bool   empty() const { return (m_size == 0); }
+    size_t size() const { return m_size; }
+
+private:
+    // slot containing the address or the empty slot where it belongs
+    value_type& find(uintptr_t _addr)
+    {
+        // fibonacci hashing: the low bits of PCs are poorly distributed
+        auto _mask = m_slots.size() - 1;
+        auto _idx  = static_cast<size_t>((_addr * 0x9E3779B97F4A7C15ULL) >> 32) & _mask;
+        while(m_slots[_idx].first != 0 && m_slots[_idx].first != _addr)
+            _idx = (_idx + 1) & _mask;
+        return m_slots[_idx];
+    }
+
+    void rehash(size_t _capacity)
+    {
+        auto _slots = std::vector<value_type>(_capacity, value_type{ 0, 0 });
+        std::swap(m_slots, _slots);
+        m_size = 0;
+        for(const auto& itr : _slots)
+            if(itr.first != 0) add(itr.first, itr.second);
+    }
+
+    size_t                  m_size  = 0;
+    std::vector<value_type> m_slots = {};
+};
+
+// samples of a thread for the current experiment. Only the owning thread adds to the
+// table so the lock is uncontended except while the samples are being collected
+struct thread_samples
+{
+    locking::atomic_mutex mutex = {};
+    uint32_t              index = 0;
+    pc_count_table        table = {};
+};
+
+// the samples of completed experiments and the samples of each thread
+struct sample_registry
+{
+    locking::atomic_mutex                        mutex   = {};
+    std::map<uint32_t, pc_count_table>           merged  = {};
+    std::vector<std::unique_ptr<thread_samples>> threads = {};
+};
+
+auto&
+get_registry()
+{
+    static auto* _v = new sample_registry{};
+    return *_v;
 }
 
-std::vector<sample_data>
-get_samples(uint32_t _index)
+thread_samples&
+get_thread_samples()
 {
-    auto _data = std::vector<sample_data>{};
-    _data.reserve(samples.at(_index).size());
-    for(const auto& itr : samples.at(_index))
+    static thread_local auto* _v = []() {
+        auto& _registry = get_registry();
+        auto  _lk       = locking::atomic_lock{ _registry.mutex };
+        return _registry.threads.emplace_back(std::make_unique<thread_samples>()).get();
+    }();
+    return *_v;
+}
+
+// moves the thread samples into the merged samples. Requires the lock of the thread
+// samples to be held
+void
+flush(thread_samples& _samples)
+{
+    if(_samples.table.empty()) return;
+
+    auto& _registry = get_registry();
+    auto  _lk       = locking::atomic_lock{ _registry.mutex };
+    _registry.merged[_samples.index].merge(_samples.table);
+    _samples.table.clear();
+}
+
+// moves the samples of every thread into the merged samples
+void
+flush_all()
+{
+    auto& _registry = get_registry();
+    auto  _threads  = std::vector<thread_samples*>{};
+    {
+        auto _lk = locking::atomic_lock{ _registry.mutex };
+        _threads.reserve(_registry.threads.size());
+        for(auto& itr : _registry.threads)
+            _threads.emplace_back(itr.get());
+    }
+
+    for(auto* itr : _threads)
     {
-        _data.emplace_back(sample_data{ itr.first, itr.second });
+        auto _lk = locking::atomic_lock{ itr->mutex };
+        flush(*itr);
     }
+}
+
+std::vector<sample_data>
+get_sample_data(const pc_count_table& _table)
+{
+    auto _data = std::vector<sample_data>{};
+    _data.reserve(_table.size());
+    _table.for_each([&_data](uintptr_t _addr, uint64_t _count) {
+        _data.emplace_back(sample_data{ _addr, _count });
+    });
+    std::sort(_data.begin(), _data.end());
     return _data;
 }
+}  // namespace
+
+std::vector<sample_data>
+get_samples(uint32_t _index)
+{
+    flush_all();
+
+    auto& _registry = get_registry();
+    auto  _lk       = locking::atomic_lock{ _registry.mutex };
+    return get_sample_data(_registry.merged.at(_index));
+}
 
 std::map<uint32_t, std::vector<sample_data>>
 get_samples()
 {
-    auto _data = std::map<uint32_t, std::vector<sample_data>>{};
+    flush_all();
 
-    for(const auto& itr : samples)
+    auto& _registry = get_registry();
+    auto  _lk       = locking::atomic_lock{ _registry.mutex };
+    auto  _data     = std::map<uint32_t, std::vector<sample_data>>{};
+    for(const auto& itr : _registry.merged)
     {
-        _data[itr.first] = get_samples(itr.first);
+        _data[itr.first] = get_sample_data(itr.second);
     }
 
     return _data;
 }
 
+std::vector<sample_data>
+get_total_samples()
+{
+    flush_all();
+
+    auto& _registry = get_registry();
+    auto  _lk       = locking::atomic_lock{ _registry.mutex };
+    auto  _total    = pc_count_table{};
+    for(const auto& itr : _registry.merged)
+        _total.merge(itr.second);
+
+    return get_sample_data(_total);
+}
+
 void
 add_sample(uint32_t _index, uintptr_t _addr, uint64_t _count)
 {
-    samples[_index][_addr] += _count;
+    auto& _samples = get_thread_samples();
+    auto  _lk      = locking::atomic_lock{ _samples.mutex };
+
+    // the experiment changed
+    if(_samples.index != _index) flush(_samples);
+
+    _samples.index = _index;
+    _samples.table.add(_addr, _count);
 }
 
 void
@@ -27,6 +27,8 @@
 
 #include <chrono>
 #include <cstdint>
+#include <map>
+#include <vector>
 
 namespace omnitrace
 {
@@ -59,6 +61,10 @@ add_samples(uint32_t, const std::vector<uintptr_t>&);
 
 std::vector<sample_data> get_samples(uint32_t);
 
+// samples of every experiment combined
+std::vector<sample_data>
+get_total_samples();
+
 void add_sample(uint32_t, uintptr_t, uint64_t = 1);
 
 void
@@ -0,0 +1,461 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/cgroup.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace cgroup
+{
+namespace
+{
+// file of the cgroup v2 interface opened once and re-read at each sample
+struct cgroup_file
+{
+    cgroup_file() = default;
+    ~cgroup_file();
+
+    cgroup_file(const cgroup_file&) = delete;
+    cgroup_file& operator=(const cgroup_file&) = delete;
+
+    bool        open(const std::string& _path);
+    std::string read() const;
+    explicit    operator bool() const { return (m_fd >= 0); }
+
+    int m_fd = -1;
+};
+
+cgroup_file::~cgroup_file()
+{
+    if(m_fd >= 0) ::close(m_fd);
+}
+
+bool
+cgroup_file::open(const std::string& _path)
+{
+    m_fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    return (m_fd >= 0);
+}
+
+std::string
+cgroup_file::read() const
+{
+    if(m_fd < 0) return std::string{};
+    char _buf[1024];
+    auto _n = ::pread(m_fd, _buf, sizeof(_buf) - 1, 0);
+    if(_n <= 0) return std::string{};
+    return std::string{ _buf, static_cast<size_t>(_n) };
+}
+
+struct sample_t
+{
+    uint64_t ts             = 0;
+    uint64_t usage_usec     = 0;
+    uint64_t nr_periods     = 0;
+    uint64_t nr_throttled   = 0;
+    uint64_t throttled_usec = 0;
+    uint64_t memory         = 0;  // [bytes]
+    uint64_t memory_some    = 0;  // [usec] some tasks were stalled on memory
+    uint64_t memory_full    = 0;  // [usec] all tasks were stalled on memory
+};
+
+struct cgroup_data
+{
+    std::string          path           = {};
+    double               cpu_quota      = 0.0;  // [CPUs], zero when unlimited
+    uint64_t             memory_limit   = 0;    // [bytes], zero when unlimited
+    cgroup_file          cpu_stat       = {};
+    cgroup_file          memory_current = {};
+    cgroup_file          memory_stall   = {};
+    std::deque<sample_t> data           = {};
+};
+
+std::unique_ptr<cgroup_data> state = {};
+
+std::string
+read_file(const std::string& _path)
+{
+    auto _ifs = std::ifstream{ _path };
+    auto _ss  = std::stringstream{};
+    _ss << _ifs.rdbuf();
+    return _ss.str();
+}
+
+// the path of the cgroup v2 (unified hierarchy) of the process, i.e. the "0::<path>"
+// entry of /proc/self/cgroup, relative to the mount of the hierarchy
+std::optional<std::string>
+get_cgroup_path()
+{
+    constexpr auto root = std::string_view{ "/sys/fs/cgroup" };
+    if(!tim::filepath::exists(JOIN('/', root, "cgroup.controllers"))) return std::nullopt;
+
+    for(const auto& itr : tim::delimit(read_file("/proc/self/cgroup"), "\n"))
+    {
+        if(itr.find("0::") != 0) continue;
+        auto _path = itr.substr(3);
+        return (_path == "/") ? std::string{ root } : JOIN("", root, _path);
+    }
+    return std::nullopt;
+}
+
+// the value of each key in "<key> <value>" lines, e.g. cpu.stat
+uint64_t
+get_value(std::string_view _data, std::string_view _key)
+{
+    for(size_t _pos = 0; _pos < _data.length();)
+    {
+        auto _end  = std::min(_data.find('\n', _pos), _data.length());
+        auto _line = _data.substr(_pos, _end - _pos);
+        if(_line.length() > _key.length() && _line.find(_key) == 0 &&
+           _line.at(_key.length()) == ' ')
+            return std::strtoull(_line.data() + _key.length() + 1, nullptr, 10);
+        _pos = _end + 1;
+    }
+    return 0;
+}
+
+// the total stall time [usec] of the "some" or "full" line of the pressure stall info
+uint64_t
+get_stall(std::string_view _data, std::string_view _kind)
+{
+    auto _pos = _data.find(_kind);
+    if(_pos == std::string_view::npos) return 0;
+    auto _total = _data.find("total=", _pos);
+    if(_total == std::string_view::npos) return 0;
+    return std::strtoull(_data.data() + _total + 6, nullptr, 10);
+}
+
+template <typename Tp>
+Tp
+get_delta(const sample_t& _prev, const sample_t& _curr, Tp sample_t::*_member)
+{
+    // the counters are never reset but guard against reading a partial file
+    return (_curr.*_member >= _prev.*_member) ? (_curr.*_member - _prev.*_member) : 0;
+}
+
+// the intervals with a contiguous sequence of samples in which the cgroup was throttled
+struct throttle_window
+{
+    uint64_t beg            = 0;
+    uint64_t end            = 0;
+    uint64_t nr_throttled   = 0;
+    uint64_t throttled_usec = 0;
+};
+
+std::vector<throttle_window>
+get_throttle_windows(const std::deque<sample_t>& _data)
+{
+    auto _v      = std::vector<throttle_window>{};
+    bool _active = false;
+    for(size_t n = 1; n < _data.size(); ++n)
+    {
+        const auto& _prev = _data.at(n - 1);
+        const auto& _curr = _data.at(n);
+        auto        _nr   = get_delta(_prev, _curr, &sample_t::nr_throttled);
+        if(_nr == 0)
+        {
+            _active = false;
+            continue;
+        }
+
+        if(!_active) _v.emplace_back(throttle_window{ _prev.ts, _prev.ts, 0, 0 });
+        _active = true;
+
+        auto& _window = _v.back();
+        _window.end   = _curr.ts;
+        _window.nr_throttled += _nr;
+        _window.throttled_usec += get_delta(_prev, _curr, &sample_t::throttled_usec);
+    }
+    return _v;
+}
+
+void
+post_process_perfetto(const std::deque<sample_t>& _data)
+{
+    using track = perfetto_counter_track<category::cgroup>;
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    OMNITRACE_CI_THROW(!_thread_info, "Missing thread info for thread 0");
+    if(!_thread_info) return;
+
+    if(!track::exists(0))
+    {
+        track::emplace(0, "CPU Usage [cgroup] (S)", "CPUs");
+        track::emplace(0, "CPU Throttled [cgroup] (S)", "%");
+        track::emplace(0, "Memory Usage [cgroup] (S)", "megabytes");
+        track::emplace(0, "Memory Pressure [cgroup] (S)", "%");
+    }
+
+    auto _emit = [](size_t _idx, uint64_t _ts, double _v) {
+        TRACE_COUNTER(trait::name<category::cgroup>::value, track::at(0, _idx), _ts, _v);
+    };
+
+    // the rates over each interval are reported at the end of the interval
+    for(size_t n = 1; n < _data.size(); ++n)
+    {
+        const auto& _prev = _data.at(n - 1);
+        const auto& _curr = _data.at(n);
+        if(_curr.ts <= _prev.ts || !_thread_info->is_valid_time(_curr.ts)) continue;
+
+        auto _usec = static_cast<double>(_curr.ts - _prev.ts) / units::usec;
+        auto _rate = [&](uint64_t sample_t::*_member) {
+            return static_cast<double>(get_delta(_prev, _curr, _member)) / _usec;
+        };
+
+        _emit(0, _curr.ts, _rate(&sample_t::usage_usec));
+        _emit(1, _curr.ts, 100.0 * _rate(&sample_t::throttled_usec));
+        _emit(2, _curr.ts, static_cast<double>(_curr.memory) / units::megabyte);
+        _emit(3, _curr.ts, 100.0 * _rate(&sample_t::memory_some));
+    }
+
+    for(size_t i = 0; i < 4; ++i)
+        _emit(i, _thread_info->get_stop(), 0.0);
+}
+
+void
+write_summary(std::ostream& _os, const std::deque<sample_t>& _data)
+{
+    const auto& _first = _data.front();
+    const auto& _last  = _data.back();
+
+    auto _sec = [](uint64_t _usec) {
+        return static_cast<double>(_usec) * units::usec / units::sec;
+    };
+    auto _total = [&](uint64_t sample_t::*_member) {
+        return get_delta(_first, _last, _member);
+    };
+
+    auto _duration = _sec((_last.ts - _first.ts) / units::usec);
+    auto _periods  = _total(&sample_t::nr_periods);
+    auto _nr       = _total(&sample_t::nr_throttled);
+    auto _peak     = std::max_element(_data.begin(), _data.end(),
+                                  [](const auto& _lhs, const auto& _rhs) {
+                                      return _lhs.memory < _rhs.memory;
+                                  })->memory;
+
+    auto _label = [&_os](const char* _v) -> std::ostream& {
+        return _os << "    " << std::setw(28) << std::left << _v << std::right << " ";
+    };
+
+    _os << std::fixed << std::setprecision(3);
+    _label("cgroup") << state->path << "\n";
+    if(state->cpu_quota > 0.0)
+        _label("cpu quota [CPUs]") << state->cpu_quota << "\n";
+    else
+        _label("cpu quota [CPUs]") << "max\n";
+    if(state->memory_limit > 0)
+        _label("memory limit [MB]")
+            << static_cast<double>(state->memory_limit) / units::megabyte << "\n";
+    else
+        _label("memory limit [MB]") << "max\n";
+    _label("duration [sec]") << _duration << "\n";
+    _label("cpu usage [sec]") << _sec(_total(&sample_t::usage_usec)) << " (average "
+                              << _sec(_total(&sample_t::usage_usec)) / _duration
+                              << " CPUs)\n";
+    _label("periods") << _periods << "\n";
+    _label("throttled periods")
+        << _nr << " (" << ((_periods > 0) ? (100.0 * _nr) / _periods : 0.0) << "%)\n";
+    _label("throttled time [sec]") << _sec(_total(&sample_t::throttled_usec)) << "\n";
+    _label("memory peak [MB]") << static_cast<double>(_peak) / units::megabyte << "\n";
+    _label("memory stall some [sec]") << _sec(_total(&sample_t::memory_some)) << "\n";
+    _label("memory stall full [sec]") << _sec(_total(&sample_t::memory_full)) << "\n";
+}
+}  // namespace
+
+void
+setup()
+{
+    perfetto_counter_track<category::cgroup>::init();
+}
+
+// the cgroup is resolved on the sampler thread. The throttling statistics of cpu.stat
+// are only provided when the cpu controller is enabled for the cgroup and the pressure
+// stall info requires a kernel with PSI enabled
+void
+config()
+{
+    state.reset();
+
+    auto _path = get_cgroup_path();
+    if(!_path)
+    {
+        OMNITRACE_VERBOSE(1, "[cgroup::config] the process is not in a cgroup v2\n");
+        return;
+    }
+
+    auto _cgroup = std::make_unique<cgroup_data>();
+    _state->path = *_path;
+    if(!_state->cpu_stat.open(JOIN('/', *_path, "cpu.stat")))
+    {
+        OMNITRACE_VERBOSE(1, "[cgroup::config] '%s/cpu.stat' is not readable\n",
+                          _path->c_str());
+        return;
+    }
+
+    _state->memory_current.open(JOIN('/', *_path, "memory.current"));
+    _state->memory_stall.open(JOIN('/', *_path, "memory.pressure"));
+
+    // cpu.max is "<quota> <period>" in usec where the quota is "max" when unlimited
+    auto _cpu_max = tim::delimit(read_file(JOIN('/', *_path, "cpu.max")), " \n");
+    if(_cpu_max.size() == 2 && _cpu_max.at(0) != "max")
+        _state->cpu_quota = std::stod(_cpu_max.at(0)) / std::stod(_cpu_max.at(1));
+
+    auto _memory_max = tim::delimit(read_file(JOIN('/', *_path, "memory.max")), " \n");
+    if(_memory_max.size() == 1 && _memory_max.at(0) != "max")
+        _state->memory_limit = std::stoull(_memory_max.at(0));
+
+    OMNITRACE_VERBOSE(1, "[cgroup::config] sampling cgroup '%s'...\n", _path->c_str());
+
+    state = std::move(_cgroup);
+}
+
+void
+sample()
+{
+    if(!state) return;
+
+    auto _cpu = state->cpu_stat.read();
+    auto _v   = sample_t{};
+    _v.ts     = tim::get_clock_real_now<uint64_t, std::nano>();
+
+    _v.usage_usec     = get_value(_cpu, "usage_usec");
+    _v.nr_periods     = get_value(_cpu, "nr_periods");
+    _v.nr_throttled   = get_value(_cpu, "nr_throttled");
+    _v.throttled_usec = get_value(_cpu, "throttled_usec");
+
+    if(state->memory_current)
+        _v.memory = std::strtoull(state->memory_current.read().c_str(), nullptr, 10);
+
+    if(state->memory_stall)
+    {
+        auto _stall    = state->memory_stall.read();
+        _v.memory_some = get_stall(_stall, "some");
+        _v.memory_full = get_stall(_stall, "full");
+    }
+
+    state->data.emplace_back(_v);
+}
+
+void
+shutdown()
+{}
+
+void
+post_process()
+{
+    if(!state) return;
+
+    tim::scope::destructor _dtor{ []() { state.reset(); } };
+
+    const auto& _data = state->data;
+    if(_data.size() < 2) return;
+
+    OMNITRACE_VERBOSE(1, "Post-processing %zu cgroup entries...\n", _data.size());
+
+    if(get_use_perfetto()) post_process_perfetto(_data);
+
+    auto _windows = get_throttle_windows(_data);
+    auto _nr      = get_delta(_data.front(), _data.back(), &sample_t::nr_throttled);
+    auto _usec    = get_delta(_data.front(), _data.back(), &sample_t::throttled_usec);
+
+    if(_nr > 0)
+    {
+        OMNITRACE_VERBOSE(0,
+                          "cgroup :: CPU throttled in %lu periods for %.3f sec in %zu "
+                          "windows (quota: %.2f CPUs)\n",
+                          static_cast<unsigned long>(_nr),
+                          static_cast<double>(_usec) * units::usec / units::sec,
+                          _windows.size(),
+                          state->cpu_quota);
+    }
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("cgroup", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<cgroup_data>{}(_fname,
+                                                          std::string{ "cgroup" });
+
+        ofs << "summary:\n";
+        write_summary(ofs, _data);
+
+        // the longest throttling windows relative to the first sample
+        std::sort(_windows.begin(), _windows.end(),
+                  [](const auto& _lhs, const auto& _rhs) {
+                      return (_lhs.end - _lhs.beg) > (_rhs.end - _rhs.beg);
+                  });
+
+        ofs << "\nthrottling windows: " << _windows.size() << "\n";
+        if(!_windows.empty())
+            ofs << "    " << std::setw(12) << "start [sec]" << " " << std::setw(14)
+                << "duration [sec]" << " " << std::setw(12) << "periods" << " "
+                << std::setw(16) << "throttled [sec]" << "\n";
+
+        auto _to_sec = [](uint64_t _nsec) {
+            return static_cast<double>(_nsec) / units::sec;
+        };
+        for(size_t i = 0; i < std::min<size_t>(_windows.size(), 20); ++i)
+        {
+            const auto& itr = _windows.at(i);
+            ofs << "    " << std::setw(12) << _to_sec(itr.beg - _data.front().ts) << " "
+                << std::setw(14) << _to_sec(itr.end - itr.beg) << " " << std::setw(12)
+                << itr.nr_throttled << " " << std::setw(16)
+                << _to_sec(itr.throttled_usec * units::usec) << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening cgroup output file: %s", _fname.c_str());
+    }
+}
+}  // namespace cgroup
+}  // namespace omnitrace
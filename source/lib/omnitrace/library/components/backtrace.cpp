@@ -20,16 +20,21 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include "binary/analysis.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
+#include "library/calling_context.hpp"
 #include "library/components/ensure_storage.hpp"
+#include "library/exporter.hpp"
 #include "library/ptl.hpp"
+#include "library/python_stack.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
+#include "library/thread_info.hpp"
 
 #include <timemory/backends/papi.hpp>
 #include <timemory/backends/threading.hpp>
@@ -55,18 +60,25 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cmath>
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
 #include <mutex>
+#include <optional>
 #include <regex>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include <libunwind.h>
+#include <link.h>
 #include <pthread.h>
 #include <signal.h>
 
@@ -74,26 +86,248 @@ namespace omnitrace
 {
 namespace component
 {
+namespace
+{
+enum class unwinder : short
+{
+    cached = 0,
+    frame_pointer,
+    libunwind,
+};
+
+auto&
+get_unwinder()
+{
+    static auto _v = std::atomic<unwinder>{ unwinder::cached };
+    return _v;
+}
+
+struct stack_range
+{
+    uintptr_t begin = 0;
+    uintptr_t end   = 0;
+
+    bool contains(uintptr_t _v, size_t _n) const
+    {
+        return (_v >= begin && _v + _n <= end);
+    }
+};
+
+using stack_range_instances = thread_data<stack_range, category::sampling>;
+
+// the executable segments of the libraries of omnitrace (and the libraries linked into
+// them statically), timemory, gotcha, and libunwind. The ranges are found when the
+// sampling is configured since dl_iterate_phdr is not async-signal-safe
+struct code_range
+{
+    uintptr_t begin = 0;
+    uintptr_t end   = 0;
+};
+
+constexpr size_t max_internal_ranges = 32;
+
+auto internal_ranges     = std::array<code_range, max_internal_ranges>{};
+auto num_internal_ranges = std::atomic<size_t>{ 0 };
+auto max_unwind_depth    = std::atomic<size_t>{ backtrace::stack_depth };
+
+bool
+is_internal_address(uintptr_t _addr)
+{
+    auto _n = num_internal_ranges.load(std::memory_order_acquire);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        if(_addr >= internal_ranges[i].begin && _addr < internal_ranges[i].end)
+            return true;
+    }
+    return false;
+}
+
+void
+find_internal_ranges()
+{
+    auto _callback = [](dl_phdr_info* _info, size_t, void*) {
+        auto _name = std::string_view{ (_info->dlpi_name) ? _info->dlpi_name : "" };
+        _name      = _name.substr(_name.find_last_of('/') + 1);
+
+        bool _internal = false;
+        for(const auto* itr : { "libomnitrace", "libtimemory", "libgotcha", "libunwind" })
+            _internal = _internal || (_name.find(itr) == 0);
+
+        // the object which contains this function is internal regardless of its name
+        auto _self   = reinterpret_cast<uintptr_t>(&find_internal_ranges);
+        auto _ranges = std::vector<code_range>{};
+        for(size_t i = 0; i < _info->dlpi_phnum; ++i)
+        {
+            const auto& _phdr = _info->dlpi_phdr[i];
+            if(_phdr.p_type != PT_LOAD || (_phdr.p_flags & PF_X) == 0) continue;
+            auto _beg = _info->dlpi_addr + _phdr.p_vaddr;
+            _ranges.emplace_back(code_range{ _beg, _beg + _phdr.p_memsz });
+            _internal = _internal || (_self >= _beg && _self < _beg + _phdr.p_memsz);
+        }
+
+        if(!_internal) return 0;
+
+        auto _n = num_internal_ranges.load(std::memory_order_relaxed);
+        for(const auto& itr : _ranges)
+        {
+            if(_n < max_internal_ranges) internal_ranges[_n++] = itr;
+        }
+        num_internal_ranges.store(_n, std::memory_order_release);
+        return 0;
+    };
+
+    dl_iterate_phdr(_callback, nullptr);
+
+    OMNITRACE_VERBOSE(2, "[sampling] %zu code ranges of internal libraries...\n",
+                      num_internal_ranges.load());
+}
+
+// decimates the timer samples of a thread such that the time spent unwinding stays
+// within OMNITRACE_SAMPLING_OVERHEAD_BUDGET of the time between samples. The timer
+// keeps firing at the configured frequency and only every N-th interrupt records a
+// call-stack. Interrupts without a call-stack are discarded during post-processing
+// so every recorded sample spans the time since the previous recorded sample
+struct adaptive_rate
+{
+    double   budget    = 0.0;
+    double   min_freq  = 1.0;
+    double   interval  = 0.0;  // moving average of the time between interrupts (nsec)
+    double   cost      = 0.0;  // moving average of the time spent unwinding (nsec)
+    uint64_t last      = 0;
+    uint64_t stride    = 1;
+    uint64_t countdown = 0;
+
+    bool skip(uint64_t _now);
+    void update(uint64_t _cost);
+};
+
+using adaptive_rate_instances = thread_data<adaptive_rate, category::sampling>;
+
+uint64_t
+monotonic_now()
+{
+    auto _ts = timespec{};
+    clock_gettime(CLOCK_MONOTONIC, &_ts);
+    return (static_cast<uint64_t>(_ts.tv_sec) * units::sec) + _ts.tv_nsec;
+}
+
+template <typename Tp>
+void
+update_moving_average(Tp& _avg, Tp _v)
+{
+    constexpr Tp weight = 0.125;
+    _avg                = (_avg == 0) ? _v : (_avg + weight * (_v - _avg));
+}
+
+bool
+adaptive_rate::skip(uint64_t _now)
+{
+    if(last > 0 && _now > last) update_moving_average(interval, double(_now - last));
+    last = _now;
+
+    if(countdown == 0) return false;
+    --countdown;
+    return true;
+}
+
+void
+adaptive_rate::update(uint64_t _cost)
+{
+    update_moving_average(cost, double(_cost));
+    if(interval <= 0.0) return;
+
+    auto _stride     = std::ceil(cost / (budget * interval));
+    auto _max_stride = std::max(1.0, std::floor(units::sec / (min_freq * interval)));
+    stride           = static_cast<uint64_t>(std::clamp(_stride, 1.0, _max_stride));
+    countdown        = stride - 1;
+}
+
+// follows the saved frame-pointers starting at the given frame. Every frame is
+// validated against the bounds of the stack before it is dereferenced so a frame
+// without a frame-pointer terminates the walk instead of faulting
+size_t
+walk_frame_pointers(const stack_range& _range, uintptr_t _fp, size_t _ignore,
+                    uintptr_t* _addrs, size_t _capacity)
+{
+    constexpr size_t frame_size = 2 * sizeof(uintptr_t);
+
+    size_t _n = 0;
+    while(_n < _capacity)
+    {
+        if(_fp % sizeof(uintptr_t) != 0 || !_range.contains(_fp, frame_size)) break;
+
+        const auto* _frame = reinterpret_cast<const uintptr_t*>(_fp);
+        auto        _next  = _frame[0];
+        auto        _ra    = _frame[1];
+        if(_ra == 0) break;
+
+        if(_ignore > 0)
+            --_ignore;
+        else
+            _addrs[_n++] = _ra;
+
+        // the stack grows down so the caller frame must be at a higher address
+        if(_next <= _fp) break;
+        _fp = _next;
+    }
+    return _n;
+}
+}  // namespace
+
 std::vector<backtrace::entry_type>
 backtrace::get() const
 {
     std::vector<entry_type> _v = {};
     if(size() == 0) return _v;
 
+    const auto* _tree = calling_context::get(m_tid);
+    if(!_tree) return _v;
+
     {
-        static auto _cache = cache_type{ get_sampling_include_inlines() };
+        // samples with the same call-stack share the node so the symbols of a
+        // call-stack are only resolved once and call-stacks which share frames (and
+        // the threads which share code) only resolve each unique address once
+        static auto _cache    = cache_type{ get_sampling_include_inlines() };
+        static auto _resolved = std::unordered_map<uint64_t, std::vector<entry_type>>{};
+        static auto _symbols =
+            std::unordered_map<uintptr_t, std::optional<entry_type>>{};
+
+        auto        _key = (static_cast<uint64_t>(m_tid) << 32) | m_data;
         auto_lock_t _lk{ type_mutex<backtrace>() };
-        _v = m_data.get(&_cache, false);
-    }
 
-    // put the bottom of the call-stack on top
-    std::reverse(_v.begin(), _v.end());
-    //
-    auto _known_excludes =
-        std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
-    // remove some known functions which are by-products of interrupts
-    while(!_v.empty() && _known_excludes.find(_v.back().name) != _known_excludes.end())
-        _v.pop_back();
+        auto itr = _resolved.find(_key);
+        if(itr != _resolved.end()) return itr->second;
+
+        // addresses are ordered such that the bottom of the call-stack is on top
+        auto _python = std::vector<entry_type>{};
+        for(auto aitr : _tree->get_addresses(m_data))
+        {
+            if(python_stack::is_frame(aitr))
+            {
+                auto _entry = python_stack::resolve(aitr);
+                if(_entry) _python.emplace_back(std::move(*_entry));
+                continue;
+            }
+            auto sitr = _symbols.find(aitr);
+            if(sitr == _symbols.end())
+                sitr = _symbols
+                           .emplace(aitr, binary::lookup_ipaddr_entry<false>(
+                                              aitr, nullptr, &_cache))
+                           .first;
+            if(sitr->second) _v.emplace_back(*sitr->second);
+        }
+
+        auto _known_excludes =
+            std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
+        // remove some known functions which are by-products of interrupts
+        while(!_v.empty() &&
+              _known_excludes.find(_v.back().name) != _known_excludes.end())
+            _v.pop_back();
+
+        _v = python_stack::merge(std::move(_v), std::move(_python));
+
+        _resolved.emplace(_key, _v);
+    }
 
     return _v;
 }
@@ -180,7 +414,65 @@ backtrace::empty() const
 size_t
 backtrace::size() const
 {
-    return m_data.size();
+    return (m_data == 0) ? 0 : 1;
+}
+
+void
+backtrace::configure(bool _setup, int64_t _tid)
+{
+    if(!_setup) return;
+
+    static auto _once = []() {
+        auto _v = config::get_sampling_unwinder();
+        if(_v == "frame-pointer")
+            get_unwinder().store(unwinder::frame_pointer);
+        else if(_v == "libunwind")
+            get_unwinder().store(unwinder::libunwind);
+        else
+            get_unwinder().store(unwinder::cached);
+
+        // the default global caching policy serializes the unwind info lookups
+        // of every thread with a lock
+        if(get_unwinder() != unwinder::libunwind)
+            unw_set_caching_policy(unw_local_addr_space, UNW_CACHE_PER_THREAD);
+
+        OMNITRACE_VERBOSE(2, "[sampling] call-stacks are unwound via %s\n", _v.c_str());
+
+        if(auto _depth = config::get_sampling_max_depth(); _depth > 0)
+            max_unwind_depth.store(std::min(_depth, stack_depth));
+
+        if(!get_sampling_keep_internal()) find_internal_ranges();
+
+        python_stack::configure();
+        return true;
+    }();
+    (void) _once;
+
+    if(config::get_sampling_overhead_budget() > 0.0)
+    {
+        adaptive_rate_instances::construct(
+            construct_on_thread{ _tid },
+            adaptive_rate{ config::get_sampling_overhead_budget(),
+                           std::max(config::get_sampling_min_freq(), 1.0e-3) });
+    }
+
+    if(get_unwinder() != unwinder::frame_pointer) return;
+
+    // the bounds of the stack are queried here since pthread_getattr_np is not
+    // async-signal-safe
+    auto _attr = pthread_attr_t{};
+    if(pthread_getattr_np(pthread_self(), &_attr) == 0)
+    {
+        void*  _addr = nullptr;
+        size_t _size = 0;
+        if(pthread_attr_getstack(&_attr, &_addr, &_size) == 0)
+        {
+            auto _beg = reinterpret_cast<uintptr_t>(_addr);
+            stack_range_instances::construct(construct_on_thread{ _tid },
+                                             stack_range{ _beg, _beg + _size });
+        }
+        pthread_attr_destroy(&_attr);
+    }
 }
 
 void
@@ -191,6 +483,19 @@ backtrace::sample(int signo)
     // on RedHat, the unw_step within get_unw_stack involves a mutex lock
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
+    static thread_local const auto& _tinfo = thread_info::get();
+    auto                            _tid   = _tinfo->index_data->sequent_value;
+    auto*                           _tree  = calling_context::get(_tid);
+
+    m_tid  = _tid;
+    m_data = 0;
+    if(!_tree) return;
+
+    auto* _rates = adaptive_rate_instances::get();
+    auto* _rate  = (_rates) ? _rates->at(_tid).get() : nullptr;
+    auto  _beg   = (_rate) ? monotonic_now() : uint64_t{ 0 };
+    if(_rate && _rate->skip(_beg)) return;
+
     using namespace tim::backtrace;
     constexpr bool   with_signal_frame = false;
     constexpr size_t ignore_depth      = 3;
@@ -201,7 +506,64 @@ backtrace::sample(int signo)
     // 4a. funlockfile       [common but not explicitly in call-stack]
     // 4b. __resume_rt       [common but not explicitly in call-stack]
     // 4c. killpg            [common but not explicitly in call-stack]
-    m_data = get_unw_stack<stack_depth, ignore_depth, with_signal_frame>();
+
+    // the unwound stack starts at the innermost frame. The Python frames (if any) are
+    // appended after the native frames
+    auto _addrs     = std::array<uintptr_t, 2 * stack_depth>{};
+    auto _n         = size_t{ 0 };
+    auto _max_depth = max_unwind_depth.load(std::memory_order_relaxed);
+    switch(get_unwinder().load(std::memory_order_relaxed))
+    {
+        case unwinder::cached:
+        {
+            auto _buffer = std::array<void*, stack_depth + ignore_depth>{};
+            auto _size   = static_cast<int>(_max_depth + ignore_depth);
+            auto _depth  = unw_backtrace(_buffer.data(), _size);
+            for(int i = ignore_depth; i < _depth; ++i)
+            {
+                if(_buffer[i]) _addrs[_n++] = reinterpret_cast<uintptr_t>(_buffer[i]);
+            }
+            break;
+        }
+        case unwinder::frame_pointer:
+        {
+            auto*       _ranges = stack_range_instances::get();
+            const auto* _range  = (_ranges) ? _ranges->at(_tid).get() : nullptr;
+            if(!_range) break;
+            // the first return address is in the caller of this frame
+            _n = walk_frame_pointers(
+                *_range, reinterpret_cast<uintptr_t>(__builtin_frame_address(0)),
+                ignore_depth - 1, _addrs.data(), _max_depth);
+            break;
+        }
+        case unwinder::libunwind:
+        {
+            for(auto itr : get_unw_stack<stack_depth, ignore_depth, with_signal_frame>())
+            {
+                if(itr && _n < _max_depth) _addrs[_n++] = itr->address();
+            }
+            break;
+        }
+    }
+
+    // the internal frames are removed before the call-stack is interned so they are
+    // neither stored nor offloaded. filter_and_patch still filters the frames by name
+    if(num_internal_ranges.load(std::memory_order_relaxed) > 0)
+    {
+        auto* _beg = _addrs.data();
+        auto* _end = std::remove_if(_beg, _beg + _n, &is_internal_address);
+        _n         = static_cast<size_t>(_end - _beg);
+    }
+    std::reverse(_addrs.begin(), _addrs.begin() + _n);
+
+    if(_n > 0) exporter::record_sample(_addrs[_n - 1]);
+
+    if(python_stack::enabled())
+        _n += python_stack::sample(_addrs.data() + _n, _addrs.size() - _n);
+
+    m_data = _tree->intern(_addrs.data(), _addrs.data() + _n);
+
+    if(_rate) _rate->update(monotonic_now() - _beg);
 }
 }  // namespace component
 }  // namespace omnitrace
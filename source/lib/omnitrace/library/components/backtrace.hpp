@@ -26,6 +26,7 @@
 #include "core/components/fwd.hpp"
 #include "core/defines.hpp"
 #include "core/timemory.hpp"
+#include "library/calling_context.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/components/base/declaration.hpp>
@@ -49,8 +50,8 @@ struct backtrace : comp::empty_base
 {
     static constexpr size_t stack_depth = OMNITRACE_MAX_UNWIND_DEPTH;
 
-    using data_t            = tim::unwind::stack<stack_depth>;
-    using cache_type        = typename data_t::cache_type;
+    using data_t            = calling_context::node_id_t;
+    using cache_type        = tim::unwind::cache;
     using entry_type        = tim::unwind::processed_entry;
     using clock_type        = std::chrono::steady_clock;
     using value_type        = void;
@@ -70,6 +71,7 @@ struct backtrace : comp::empty_base
 
     static std::vector<entry_type> filter_and_patch(const std::vector<entry_type>&);
 
+    static void configure(bool, int64_t _tid = threading::get_id());
     static void start();
     static void stop();
 
@@ -80,7 +82,8 @@ struct backtrace : comp::empty_base
     data_t                  get_data() const { return m_data; }
 
 private:
-    data_t m_data = {};
+    int32_t m_tid  = 0;
+    data_t  m_data = 0;  // innermost node of the call-stack in the thread's tree
 };
 }  // namespace component
 }  // namespace omnitrace
@@ -24,8 +24,10 @@
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "core/perf.hpp"
 #include "core/perfetto.hpp"
 #include "library/components/ensure_storage.hpp"
+#include "library/perf.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
@@ -52,14 +54,18 @@
 #include <timemory/storage.hpp>
 #include <timemory/units.hpp>
 #include <timemory/utility/backtrace.hpp>
+#include <timemory/utility/delimit.hpp>
 #include <timemory/utility/demangle.hpp>
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
+#include <map>
 #include <mutex>
 #include <regex>
 #include <sstream>
@@ -84,7 +90,7 @@ using hw_counters           = typename backtrace_metrics::hw_counters;
 using signal_type_instances = thread_data<std::set<int>, category::sampling>;
 using backtrace_metrics_init_instances =
     thread_data<backtrace_metrics, category::sampling>;
-using sampler_running_instances = thread_data<bool, category::sampling>;
+using sampler_running_instances = thread_data<identity<bool>, category::sampling>;
 using papi_vector_instances     = thread_data<hw_counters, category::sampling>;
 using papi_label_instances = thread_data<std::vector<std::string>, category::sampling>;
 
@@ -93,6 +99,362 @@ namespace
 struct perfetto_rusage
 {};
 
+// when the PAPI events do not fit in the counters of the CPU, they are split into
+// groups of event sets and one group counts at a time. The active group is rotated at
+// each sample and the thread CPU-time of each group is recorded so that the counts
+// can be scaled by the time enabled over the time running
+struct hw_counter_groups
+{
+    using hw_counter_data_t = backtrace_metrics::hw_counter_data_t;
+    using hw_time_data_t    = backtrace_metrics::hw_time_data_t;
+
+    struct group
+    {
+        int                 event_set = -1;  // PAPI_NULL
+        int64_t             running   = 0;
+        std::vector<size_t> events    = {};  // indexes in the labels
+    };
+
+    bool configure(const std::vector<std::string>& _events);
+    void start();
+    void stop();
+    void sample(hw_counter_data_t&, int64_t&, hw_time_data_t&);
+
+    auto is_active() const { return (groups.size() > 1); }
+
+    bool                     running = false;
+    size_t                   active  = 0;
+    int64_t                  last    = 0;
+    int64_t                  enabled = 0;
+    hw_counter_data_t        totals  = {};
+    std::vector<group>       groups  = {};
+    std::vector<std::string> labels  = {};
+};
+
+bool
+hw_counter_groups::configure(const std::vector<std::string>& _events)
+{
+    if(!groups.empty()) return is_active();
+
+    tim::papi::init();
+    tim::papi::register_thread();
+
+    auto _new_group = [this]() {
+        auto _v = group{};
+        tim::papi::create_event_set(&_v.event_set, false);
+        groups.emplace_back(_v);
+    };
+
+    _new_group();
+    for(const auto& itr : _events)
+    {
+        if(labels.size() == backtrace_metrics::num_hw_counters)
+        {
+            OMNITRACE_VERBOSE(0,
+                              "[sampling] only %zu PAPI events are supported. Ignoring "
+                              "%s...\n",
+                              labels.size(), itr.c_str());
+            continue;
+        }
+
+        // start a new group when the event does not fit in the current one
+        if(!tim::papi::add_event(groups.back().event_set, itr) &&
+           (groups.back().events.empty() ||
+            (_new_group(), !tim::papi::add_event(groups.back().event_set, itr))))
+        {
+            OMNITRACE_VERBOSE(0, "[sampling] PAPI event %s could not be added\n",
+                              itr.c_str());
+            continue;
+        }
+
+        groups.back().events.emplace_back(labels.size());
+        labels.emplace_back(itr);
+    }
+
+    if(groups.back().events.empty()) groups.pop_back();
+
+    return is_active();
+}
+
+void
+hw_counter_groups::start()
+{
+    if(!is_active() || running) return;
+
+    running = true;
+    last    = tim::get_clock_thread_now<int64_t, std::nano>();
+    tim::papi::start(groups.at(active).event_set);
+}
+
+void
+hw_counter_groups::stop()
+{
+    if(!is_active() || !running) return;
+
+    auto _totals  = hw_counter_data_t{};
+    auto _enabled = int64_t{ 0 };
+    auto _running = hw_time_data_t{};
+    sample(_totals, _enabled, _running);
+    tim::papi::stop(groups.at(active).event_set, nullptr);
+    running = false;
+}
+
+// invoked in the signal handler of the sampler. The counters are reset when the
+// event set is started so the values read when it is stopped are the counts since
+// the last rotation
+void
+hw_counter_groups::sample(hw_counter_data_t& _totals, int64_t& _enabled,
+                          hw_time_data_t& _running)
+{
+    if(!running) return;
+
+    auto  _now   = tim::get_clock_thread_now<int64_t, std::nano>();
+    auto& _group = groups.at(active);
+
+    long long _values[backtrace_metrics::num_hw_counters] = {};
+    tim::papi::stop(_group.event_set, _values);
+    for(size_t i = 0; i < _group.events.size(); ++i)
+        totals.at(_group.events.at(i)) += _values[i];
+
+    _group.running += (_now - last);
+    enabled += (_now - last);
+    last   = _now;
+    active = (active + 1) % groups.size();
+    tim::papi::start(groups.at(active).event_set);
+
+    _totals  = totals;
+    _enabled = enabled;
+    for(const auto& itr : groups)
+        for(auto eitr : itr.events)
+            _running.at(eitr) = itr.running;
+}
+
+// when every PAPI event has an equivalent generic perf hardware event and the kernel
+// permits reading the counters in userspace, the sampler reads each counter with the
+// rdpmc instruction via the mapping of a counting perf_event instead of reading the
+// PAPI event set (a system call)
+struct hw_counter_rdpmc
+{
+    using hw_counter_data_t = backtrace_metrics::hw_counter_data_t;
+
+    bool configure(const std::vector<std::string>& _events);
+    void start();
+    void stop();
+    void sample(hw_counter_data_t&) const;
+    void close();
+
+    auto is_active() const { return !labels.empty(); }
+
+    bool                                                               running = false;
+    std::array<perf::user_counter, backtrace_metrics::num_hw_counters> counters;
+    std::vector<std::string>                                           labels = {};
+};
+
+// returns the generic perf hardware event of a PAPI event or an empty string
+std::string
+get_perf_hw_event(const std::string& _event)
+{
+    static const auto _presets = std::map<std::string_view, std::string_view>{
+        { "PAPI_TOT_CYC", "PERF_COUNT_HW_CPU_CYCLES" },
+        { "PAPI_TOT_INS", "PERF_COUNT_HW_INSTRUCTIONS" },
+        { "PAPI_BR_INS", "PERF_COUNT_HW_BRANCH_INSTRUCTIONS" },
+        { "PAPI_BR_MSP", "PERF_COUNT_HW_BRANCH_MISSES" },
+        { "PAPI_REF_CYC", "PERF_COUNT_HW_REF_CPU_CYCLES" },
+    };
+
+    static const auto _generic = std::regex{
+        "^(perf::|)(PERF_COUNT_HW_(CPU_CYCLES|INSTRUCTIONS|CACHE_REFERENCES|"
+        "CACHE_MISSES|BRANCH_INSTRUCTIONS|BRANCH_MISSES|BUS_CYCLES|STALLED_CYCLES_"
+        "FRONTEND|STALLED_CYCLES_BACKEND|REF_CPU_CYCLES))$",
+        std::regex_constants::optimize
+    };
+
+    if(auto itr = _presets.find(_event); itr != _presets.end())
+        return std::string{ itr->second };
+
+    auto _match = std::smatch{};
+    if(std::regex_match(_event, _match, _generic)) return _match.str(2);
+
+    return std::string{};
+}
+
+bool
+hw_counter_rdpmc::configure(const std::vector<std::string>& _events)
+{
+    if(is_active()) return true;
+    if(_events.empty() || _events.size() > counters.size()) return false;
+
+    for(size_t i = 0; i < _events.size(); ++i)
+    {
+        auto _name = get_perf_hw_event(_events.at(i));
+        if(_name.empty())
+        {
+            OMNITRACE_VERBOSE(2, "[sampling] PAPI event %s has no generic perf event. "
+                                 "Hardware counters are not read with rdpmc...\n",
+                              _events.at(i).c_str());
+            close();
+            return false;
+        }
+
+        struct perf_event_attr _pe;
+        memset(&_pe, 0, sizeof(_pe));
+        perf::config_event(_pe, _name);
+
+        auto& _counter = counters.at(i);
+        if(auto _err = _counter.open(_pe); _err)
+        {
+            OMNITRACE_VERBOSE(2, "[sampling] %s. Hardware counters are not read with "
+                                 "rdpmc...\n",
+                              _err->c_str());
+            close();
+            return false;
+        }
+
+        // schedule the event once so that the kernel publishes whether the counter
+        // can be read in userspace
+        _counter.start();
+        _counter.stop();
+        if(!_counter.has_rdpmc())
+        {
+            OMNITRACE_VERBOSE(2, "[sampling] %s cannot be read with rdpmc...\n",
+                              _events.at(i).c_str());
+            close();
+            return false;
+        }
+    }
+
+    labels = _events;
+    return true;
+}
+
+void
+hw_counter_rdpmc::start()
+{
+    if(!is_active() || running) return;
+
+    running = true;
+    for(size_t i = 0; i < labels.size(); ++i)
+        counters.at(i).start();
+}
+
+void
+hw_counter_rdpmc::stop()
+{
+    if(!is_active() || !running) return;
+
+    for(size_t i = 0; i < labels.size(); ++i)
+        counters.at(i).stop();
+    running = false;
+}
+
+void
+hw_counter_rdpmc::close()
+{
+    stop();
+    for(auto& itr : counters)
+        itr.close();
+    labels.clear();
+}
+
+// invoked in the signal handler of the sampler
+void
+hw_counter_rdpmc::sample(hw_counter_data_t& _values) const
+{
+    using value_type = typename hw_counter_data_t::value_type;
+
+    if(!running) return;
+
+    for(size_t i = 0; i < labels.size(); ++i)
+        _values[i] = static_cast<value_type>(counters[i].read());
+}
+
+// getrusage is a system call so, when OMNITRACE_SAMPLING_RUSAGE_INTERVAL is N > 1, the
+// resource usage is only read every N samples. In between, the values are
+// extrapolated from their rate of change per CPU-time between the last two reads.
+// The reported values never decrease so that the differences between samples remain
+// non-negative when an extrapolation overshoots
+struct rusage_sampler
+{
+    static constexpr size_t num_metrics = 3;
+
+    using data_t = std::array<int64_t, num_metrics>;
+
+    data_t sample(int64_t _cpu, size_t _interval);
+
+    size_t                          count    = 0;
+    int64_t                         cpu      = 0;   // CPU-time of the last read
+    data_t                          value    = {};  // values of the last read
+    data_t                          reported = {};
+    std::array<double, num_metrics> rate     = {};  // per nanosecond of CPU-time
+};
+
+rusage_sampler::data_t
+rusage_sampler::sample(int64_t _cpu, size_t _interval)
+{
+    auto _read = [](data_t& _v) {
+        auto _cache = tim::rusage_cache{ RUSAGE_THREAD };
+        _v.at(0)    = _cache.get_peak_rss();
+        _v.at(1)    = _cache.get_num_priority_context_switch() +
+                   _cache.get_num_voluntary_context_switch();
+        _v.at(2) =
+            _cache.get_num_major_page_faults() + _cache.get_num_minor_page_faults();
+    };
+
+    if(_interval <= 1)
+    {
+        _read(reported);
+        return reported;
+    }
+
+    if(count++ % _interval == 0)
+    {
+        auto _v = data_t{};
+        _read(_v);
+        for(size_t i = 0; i < num_metrics; ++i)
+        {
+            if(count > 1 && _cpu > cpu)
+                rate.at(i) = static_cast<double>(_v.at(i) - value.at(i)) /
+                             static_cast<double>(_cpu - cpu);
+            reported.at(i) = std::max(reported.at(i), _v.at(i));
+        }
+        cpu   = _cpu;
+        value = _v;
+    }
+    else
+    {
+        auto _elapsed = static_cast<double>(std::max<int64_t>(_cpu - cpu, 0));
+        for(size_t i = 0; i < num_metrics; ++i)
+        {
+            auto _v = value.at(i) + static_cast<int64_t>(rate.at(i) * _elapsed);
+            reported.at(i) = std::max(reported.at(i), _v);
+        }
+    }
+
+    return reported;
+}
+
+using hw_counter_groups_instances = thread_data<hw_counter_groups, category::sampling>;
+using hw_counter_rdpmc_instances  = thread_data<hw_counter_rdpmc, category::sampling>;
+using rusage_sampler_instances    = thread_data<rusage_sampler, category::sampling>;
+
+unique_ptr_t<hw_counter_groups>&
+get_hw_counter_groups(int64_t _tid)
+{
+    return hw_counter_groups_instances::instance(construct_on_thread{ _tid });
+}
+
+unique_ptr_t<hw_counter_rdpmc>&
+get_hw_counter_rdpmc(int64_t _tid)
+{
+    return hw_counter_rdpmc_instances::instance(construct_on_thread{ _tid });
+}
+
+unique_ptr_t<rusage_sampler>&
+get_rusage_sampler(int64_t _tid)
+{
+    return rusage_sampler_instances::instance(construct_on_thread{ _tid });
+}
+
 unique_ptr_t<std::vector<std::string>>&
 get_papi_labels(int64_t _tid)
 {
@@ -111,7 +473,7 @@ get_backtrace_metrics_init(int64_t _tid)
     return backtrace_metrics_init_instances::instance(construct_on_thread{ _tid });
 }
 
-unique_ptr_t<bool>&
+bool&
 get_sampler_running(int64_t _tid)
 {
     return sampler_running_instances::instance(construct_on_thread{ _tid }, false);
@@ -137,6 +499,32 @@ backtrace_metrics::get_hw_counter_labels(int64_t _tid)
     return (_v) ? *_v : std::vector<std::string>{};
 }
 
+bool
+backtrace_metrics::get_hw_counter_multiplexed(int64_t _tid)
+{
+    auto& _v = get_hw_counter_groups(_tid);
+    return (_v && _v->is_active());
+}
+
+backtrace_metrics::hw_scaling_t
+backtrace_metrics::get_hw_counter_scaling(int64_t _tid)
+{
+    auto _v = hw_scaling_t{};
+    _v.fill(1.0);
+
+    auto& _groups = get_hw_counter_groups(_tid);
+    if(!_groups || !_groups->is_active()) return _v;
+
+    for(const auto& itr : _groups->groups)
+    {
+        for(auto eitr : itr.events)
+            _v.at(eitr) = (itr.running > 0) ? (static_cast<double>(_groups->enabled) /
+                                               static_cast<double>(itr.running))
+                                            : 0.0;
+    }
+    return _v;
+}
+
 void
 backtrace_metrics::start()
 {}
@@ -160,7 +548,9 @@ auto get_enabled(tim::type_list<Tp...>)
 void
 backtrace_metrics::sample(int)
 {
-    if(!get_enabled(type_list<category::process_sampling, backtrace_metrics>{}).all())
+    // OMNITRACE_SAMPLING_CALLCHAIN_ONLY: the sample is only the timestamp and call-stack
+    if(config::get_snapshot().sampling_callchain_only ||
+       !get_enabled(type_list<category::process_sampling, backtrace_metrics>{}).all())
     {
         m_valid.reset();
         return;
@@ -171,12 +561,16 @@ backtrace_metrics::sample(int)
     // return if everything is disabled
     if(!m_valid.any()) return;
 
-    auto _cache = tim::rusage_cache{ RUSAGE_THREAD };
-    m_cpu       = tim::get_clock_thread_now<int64_t, std::nano>();
-    m_mem_peak  = _cache.get_peak_rss();
-    m_ctx_swch  = _cache.get_num_priority_context_switch() +
-                 _cache.get_num_voluntary_context_switch();
-    m_page_flt = _cache.get_num_major_page_faults() + _cache.get_num_minor_page_faults();
+    auto  _tid    = threading::get_id();
+    auto& _rusage = get_rusage_sampler(_tid);
+    m_cpu         = tim::get_clock_thread_now<int64_t, std::nano>();
+    if(_rusage)
+    {
+        auto _v = _rusage->sample(m_cpu, config::get_snapshot().sampling_rusage_interval);
+        m_mem_peak = _v.at(0);
+        m_ctx_swch = _v.at(1);
+        m_page_flt = _v.at(2);
+    }
 
     if constexpr(tim::trait::is_available<hw_counters>::value)
     {
@@ -184,11 +578,23 @@ backtrace_metrics::sample(int)
         constexpr auto hw_category_idx =
             tim::index_of<category::thread_hardware_counter, categories_t>::value;
 
-        auto _tid = threading::get_id();
         if(m_valid.test(hw_category_idx) && m_valid.test(hw_counters_idx))
         {
-            assert(get_papi_vector(_tid).get() != nullptr);
-            m_hw_counter = get_papi_vector(_tid)->record();
+            auto& _rdpmc  = get_hw_counter_rdpmc(_tid);
+            auto& _groups = get_hw_counter_groups(_tid);
+            if(_rdpmc && _rdpmc->is_active())
+            {
+                _rdpmc->sample(m_hw_counter);
+            }
+            else if(_groups && _groups->is_active())
+            {
+                _groups->sample(m_hw_counter, m_hw_enabled, m_hw_running);
+            }
+            else
+            {
+                assert(get_papi_vector(_tid).get() != nullptr);
+                m_hw_counter = get_papi_vector(_tid)->record();
+            }
         }
     }
 }
@@ -197,10 +603,10 @@ void
 backtrace_metrics::configure(bool _setup, int64_t _tid)
 {
     auto& _running    = get_sampler_running(_tid);
-    bool  _is_running = (!_running) ? false : *_running;
+    bool  _is_running = _running;
 
     ensure_storage<comp::trip_count, sampling_wall_clock, sampling_cpu_clock, hw_counters,
-                   sampling_percent>{}();
+                   sampling_percent, sampling_off_cpu>{}();
 
     if(_setup && !_is_running)
     {
@@ -211,7 +617,31 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
         {
             perfetto_counter_track<hw_counters>::init();
             OMNITRACE_DEBUG("HW COUNTER: starting...\n");
-            if(get_papi_vector(_tid))
+            auto _events = tim::delimit(
+                config::get_setting_value<std::string>("OMNITRACE_PAPI_EVENTS")
+                    .value_or(std::string{}),
+                " ,;\t");
+            auto& _rdpmc  = get_hw_counter_rdpmc(_tid);
+            auto& _groups = get_hw_counter_groups(_tid);
+            if(_rdpmc && config::get_sampling_rdpmc() && _rdpmc->configure(_events))
+            {
+                OMNITRACE_VERBOSE(1,
+                                  "[sampling] reading %zu hardware counters with rdpmc "
+                                  "on thread %li\n",
+                                  _rdpmc->labels.size(), _tid);
+                _rdpmc->start();
+                *get_papi_labels(_tid) = _rdpmc->labels;
+            }
+            else if(_groups && !_events.empty() && _groups->configure(_events))
+            {
+                OMNITRACE_VERBOSE(1,
+                                  "[sampling] multiplexing %zu groups of PAPI events on "
+                                  "thread %li\n",
+                                  _groups->groups.size(), _tid);
+                _groups->start();
+                *get_papi_labels(_tid) = _groups->labels;
+            }
+            else if(get_papi_vector(_tid))
             {
                 get_papi_vector(_tid)->start();
                 *get_papi_labels(_tid) = get_papi_vector(_tid)->get_config()->labels;
@@ -221,13 +651,20 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
     else if(!_setup && _is_running)
     {
         OMNITRACE_DEBUG("Destroying sampler for thread %lu...\n", _tid);
-        *_running = false;
+        _running = false;
 
         if constexpr(tim::trait::is_available<hw_counters>::value)
         {
             if(_tid == threading::get_id())
             {
-                if(get_papi_vector(_tid)) get_papi_vector(_tid)->stop();
+                auto& _rdpmc  = get_hw_counter_rdpmc(_tid);
+                auto& _groups = get_hw_counter_groups(_tid);
+                if(_rdpmc && _rdpmc->is_active())
+                    _rdpmc->stop();
+                else if(_groups && _groups->is_active())
+                    _groups->stop();
+                else if(get_papi_vector(_tid))
+                    get_papi_vector(_tid)->stop();
                 OMNITRACE_DEBUG("HW COUNTER: stopped...\n");
             }
         }
@@ -355,11 +792,38 @@ backtrace_metrics::operator-=(const backtrace_metrics& _rhs)
     {
         for(size_t i = 0; i < _lhs.m_hw_counter.size(); ++i)
             _lhs.m_hw_counter.at(i) -= _rhs.m_hw_counter.at(i);
+
+        _lhs.m_hw_enabled -= _rhs.m_hw_enabled;
+        for(size_t i = 0; i < _lhs.m_hw_running.size(); ++i)
+            _lhs.m_hw_running.at(i) -= _rhs.m_hw_running.at(i);
     }
 
     return _lhs;
 }
 
+backtrace_metrics::hw_scaling_t
+backtrace_metrics::get_hw_counter_scaling() const
+{
+    auto _v = hw_scaling_t{};
+    _v.fill(1.0);
+    if(m_hw_enabled == 0) return _v;
+
+    for(size_t i = 0; i < _v.size(); ++i)
+        _v.at(i) = (m_hw_running.at(i) > 0) ? (static_cast<double>(m_hw_enabled) /
+                                               static_cast<double>(m_hw_running.at(i)))
+                                            : 0.0;
+    return _v;
+}
+
+backtrace_metrics::hw_counter_data_t
+backtrace_metrics::get_hw_counters(const hw_scaling_t& _scaling) const
+{
+    auto _v = m_hw_counter;
+    for(size_t i = 0; i < _v.size(); ++i)
+        _v.at(i) = std::llround(_scaling.at(i) * _v.at(i));
+    return _v;
+}
+
 void
 backtrace_metrics::post_process_perfetto(int64_t _tid, uint64_t _ts) const
 {
@@ -395,13 +859,16 @@ backtrace_metrics::post_process_perfetto(int64_t _tid, uint64_t _ts) const
 
     if((*this)(type_list<hw_counters>{}) && (*this)(category::thread_hardware_counter{}))
     {
+        // when multiplexed, the events which were not counting in this interval are
+        // skipped and the counter track keeps the last value
+        auto _scaling = get_hw_counter_scaling();
         for(size_t i = 0; i < perfetto_counter_track<hw_counters>::size(_tid); ++i)
         {
-            if(i < m_hw_counter.size())
+            if(i < m_hw_counter.size() && _scaling.at(i) > 0.0)
             {
                 TRACE_COUNTER(trait::name<category::thread_hardware_counter>::value,
                               perfetto_counter_track<hw_counters>::at(_tid, i), _ts,
-                              m_hw_counter.at(i));
+                              _scaling.at(i) * m_hw_counter.at(i));
             }
         }
     }
@@ -417,6 +884,10 @@ OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(
     TIMEMORY_ESC(data_tracker<double, omnitrace::component::backtrace_cpu_clock>), true,
     double)
 
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::backtrace_off_cpu_clock>),
+    true, double)
+
 OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(
     TIMEMORY_ESC(data_tracker<double, omnitrace::component::backtrace_fraction>), true,
     double)
@@ -59,6 +59,8 @@ struct backtrace_metrics : comp::empty_base
     using value_type        = void;
     using hw_counters       = tim::component::papi_array<num_hw_counters>;
     using hw_counter_data_t = typename hw_counters::value_type;
+    using hw_time_data_t    = std::array<int64_t, num_hw_counters>;
+    using hw_scaling_t      = std::array<double, num_hw_counters>;
     using system_clock      = std::chrono::system_clock;
     using system_time_point = typename system_clock::time_point;
 
@@ -84,6 +86,8 @@ struct backtrace_metrics : comp::empty_base
     static void                     init_perfetto(int64_t _tid, valid_array_t);
     static void                     fini_perfetto(int64_t _tid, valid_array_t);
     static std::vector<std::string> get_hw_counter_labels(int64_t);
+    static bool                     get_hw_counter_multiplexed(int64_t);
+    static hw_scaling_t             get_hw_counter_scaling(int64_t);
 
     template <typename Tp>
     static bool get_valid(Tp, valid_array_t);
@@ -111,6 +115,13 @@ struct backtrace_metrics : comp::empty_base
     auto        get_context_switches() const { return m_ctx_swch; }
     auto        get_page_faults() const { return m_page_flt; }
     const auto& get_hw_counters() const { return m_hw_counter; }
+    auto        get_hw_counter_enabled() const { return m_hw_enabled; }
+    const auto& get_hw_counter_running() const { return m_hw_running; }
+
+    // the counts of the events which were not counting the whole time are multiplied
+    // by the time enabled over the time running
+    hw_counter_data_t get_hw_counters(const hw_scaling_t&) const;
+    hw_scaling_t      get_hw_counter_scaling() const;
 
     void post_process_perfetto(int64_t _tid, uint64_t _ts) const;
 
@@ -129,6 +140,8 @@ private:
     int64_t           m_ctx_swch   = 0;
     int64_t           m_page_flt   = 0;
     hw_counter_data_t m_hw_counter = {};
+    int64_t           m_hw_enabled = 0;   // zero unless the groups are multiplexed
+    hw_time_data_t    m_hw_running = {};  // time the group of each event was counting
 };
 
 template <typename Tp>
@@ -177,6 +190,10 @@ OMNITRACE_DECLARE_EXTERN_COMPONENT(
     TIMEMORY_ESC(data_tracker<double, omnitrace::component::backtrace_cpu_clock>), true,
     double)
 
+OMNITRACE_DECLARE_EXTERN_COMPONENT(
+    TIMEMORY_ESC(data_tracker<double, omnitrace::component::backtrace_off_cpu_clock>),
+    true, double)
+
 OMNITRACE_DECLARE_EXTERN_COMPONENT(
     TIMEMORY_ESC(data_tracker<double, omnitrace::component::backtrace_fraction>), true,
     double)
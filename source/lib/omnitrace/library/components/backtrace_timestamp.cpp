@@ -21,10 +21,13 @@
 // SOFTWARE.
 
 #include "library/components/backtrace_timestamp.hpp"
+#include "library/region_context.hpp"
 #include "library/thread_info.hpp"
 
 #include <timemory/components/timing/backends.hpp>
 
+#include <sched.h>
+
 namespace omnitrace
 {
 namespace component
@@ -45,8 +48,10 @@ backtrace_timestamp::is_valid() const
 void
 backtrace_timestamp::sample(int)
 {
-    m_tid  = tim::threading::get_id();
-    m_real = tim::get_clock_real_now<uint64_t, std::nano>();
+    m_tid    = tim::threading::get_id();
+    m_real   = tim::get_clock_real_now<uint64_t, std::nano>();
+    m_region = region_context::current();
+    m_cpu    = sched_getcpu();
 }
 }  // namespace component
 }  // namespace omnitrace
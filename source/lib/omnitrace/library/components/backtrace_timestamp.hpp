@@ -62,11 +62,15 @@ struct backtrace_timestamp : comp::empty_base
 
     auto get_tid() const { return m_tid; }
     auto get_timestamp() const { return m_real; }
+    auto get_region() const { return m_region; }
+    auto get_cpu() const { return m_cpu; }
     bool is_valid() const;
 
 private:
-    int64_t  m_tid  = 0;
-    uint64_t m_real = 0;
+    int64_t           m_tid    = 0;
+    uint64_t          m_real   = 0;
+    tim::hash_value_t m_region = 0;  // innermost active region (see region_context)
+    int32_t           m_cpu    = -1;  // CPU the sample ran on (vDSO getcpu)
 };
 }  // namespace component
 }  // namespace omnitrace
@@ -28,7 +28,10 @@
 #include "core/debug.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
+#include "library/calling_context.hpp"
 #include "library/components/ensure_storage.hpp"
+#include "library/components/memory_access.hpp"
+#include "library/components/numa_gotcha.hpp"
 #include "library/perf.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
@@ -69,6 +72,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include <pthread.h>
@@ -85,7 +89,7 @@ callchain::record::operator<(const record& rhs) const
 }
 
 std::vector<callchain::ts_entry_vec_t>
-callchain::get() const
+callchain::get(int64_t _event) const
 {
     std::vector<ts_entry_vec_t> _v = {};
     if(size() == 0) return _v;
@@ -93,21 +97,32 @@ callchain::get() const
     _v.reserve(size());
     auto _data = m_data;
     std::sort(_data.begin(), _data.end());
+
+    const auto* _tree = calling_context::get(m_tid);
+    if(!_tree) return _v;
+
+    // records with the same call-stack share the node so the symbols of a
+    // call-stack are only resolved once
+    auto _resolved = std::unordered_map<calling_context::node_id_t, entry_vec_t>{};
     for(const auto& itr : _data)
     {
-        auto _v2 = ts_entry_vec_t{ itr.timestamp, {} };
-        for(auto iitr : itr.data)
-        {
-            auto _entry = binary::lookup_ipaddr_entry<true>(iitr);
-            if(_entry) _v2.second.emplace_back(*_entry);
-        }
+        if(_event >= 0 && itr.event != static_cast<uint32_t>(_event)) continue;
 
-        if(!_v2.second.empty())
+        auto ritr = _resolved.find(itr.node);
+        if(ritr == _resolved.end())
         {
-            // put the bottom of the call-stack on top
-            std::reverse(_v2.second.begin(), _v2.second.end());
-            _v.emplace_back(std::move(_v2));
+            auto _entries = entry_vec_t{};
+            // addresses are ordered such that the bottom of the call-stack is on top
+            for(auto aitr : _tree->get_addresses(itr.node))
+            {
+                auto _entry = binary::lookup_ipaddr_entry<true>(aitr);
+                if(_entry) _entries.emplace_back(*_entry);
+            }
+            ritr = _resolved.emplace(itr.node, std::move(_entries)).first;
         }
+
+        if(!ritr->second.empty())
+            _v.emplace_back(ts_entry_vec_t{ itr.timestamp, ritr->second });
     }
 
     auto _known_excludes =
@@ -180,38 +195,70 @@ callchain::sample(int signo)
     // on RedHat, the unw_step within get_unw_stack involves a mutex lock
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
-    static thread_local const auto& _tinfo      = thread_info::get();
-    auto                            _tid        = _tinfo->index_data->sequent_value;
-    auto&                           _perf_event = perf::get_instance(_tid);
+    static thread_local const auto& _tinfo = thread_info::get();
+    auto                            _tid   = _tinfo->index_data->sequent_value;
 
-    if(!_perf_event) return;
+    auto* _tree = calling_context::get(_tid);
 
-    _perf_event->stop();
+    m_tid = _tid;
+    if(!perf::get_instance(_tid) || !_tree) return;
 
-    for(auto itr : *_perf_event)
+    // the leader and the members of the group of overflow events each have their own
+    // ring buffer so the records are attributed to the event of the ring buffer
+    for(size_t i = 0; i < perf::max_group_size; ++i)
     {
-        if(itr.is_sample())
+        auto& _perf_event = perf::get_instance(_tid, i);
+        if(!_perf_event) continue;
+
+        _perf_event->stop();
+
+        bool _numa = _perf_event->is_sampling(perf::sample::addr) &&
+                     _perf_event->is_sampling(perf::sample::cpu);
+
+        bool _memory = _perf_event->is_sampling(perf::sample::addr) &&
+                       _perf_event->is_sampling(perf::sample::weight) &&
+                       _perf_event->is_sampling(perf::sample::data_src);
+
+        for(auto itr : *_perf_event)
         {
-            auto _ip        = itr.get_ip();
-            auto _data      = record{};
-            _data.timestamp = itr.get_time();
-            _data.data.emplace_back(_ip);
-            bool _skip_ip = true;
-            for(auto ditr : itr.get_callchain())
+            if(itr.is_sample())
             {
-                // skip the first instance of current IP but allow after that since this
-                // might be a recursive call
-                if(ditr == _ip && _skip_ip)
-                    _skip_ip = false;
-                else
-                    _data.data.emplace_back(ditr);
-                if(_data.data.size() == _data.data.capacity()) break;
+                // the callchain starts at the innermost frame
+                auto _ip    = itr.get_ip();
+                auto _addrs = std::array<uintptr_t, stack_depth>{};
+                auto _n     = size_t{ 0 };
+
+                if(_numa)
+                    numa_gotcha::record_sample(_tid, _ip, itr.get_addr(), itr.get_cpu());
+
+                if(_memory)
+                    memory_access::record_sample(_tid, _ip, itr.get_addr(),
+                                                 itr.get_weight(), itr.get_data_src());
+
+                _addrs[_n++]  = _ip;
+                bool _skip_ip = true;
+                for(auto ditr : itr.get_callchain())
+                {
+                    // skip the first instance of current IP but allow after that since
+                    // this might be a recursive call
+                    if(ditr == _ip && _skip_ip)
+                        _skip_ip = false;
+                    else
+                        _addrs[_n++] = ditr;
+                    if(_n == stack_depth) break;
+                }
+                std::reverse(_addrs.begin(), _addrs.begin() + _n);
+
+                auto _data      = record{};
+                _data.timestamp = itr.get_time();
+                _data.node      = _tree->intern(_addrs.data(), _addrs.data() + _n);
+                _data.event     = i;
+                if(_data.node != 0) m_data.emplace_back(_data);
             }
-            if(!_data.data.empty()) m_data.emplace_back(_data);
         }
-    }
 
-    _perf_event->start();
+        _perf_event->start();
+    }
 }
 }  // namespace component
 }  // namespace omnitrace
@@ -27,6 +27,7 @@
 #include "core/containers/static_vector.hpp"
 #include "core/defines.hpp"
 #include "core/timemory.hpp"
+#include "library/calling_context.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/components/base/declaration.hpp>
@@ -52,8 +53,9 @@ struct callchain : comp::empty_base
 
     struct record
     {
-        uint64_t                                         timestamp = 0;
-        container::static_vector<uintptr_t, stack_depth> data      = {};
+        uint64_t                   timestamp = 0;
+        calling_context::node_id_t node      = 0;  // innermost frame in the thread's tree
+        uint32_t                   event     = 0;  // index of the overflow event
 
         bool operator<(const record& rhs) const;
     };
@@ -85,11 +87,12 @@ struct callchain : comp::empty_base
     void                        sample(int = -1);
     bool                        empty() const;
     size_t                      size() const;
-    std::vector<ts_entry_vec_t> get() const;
+    std::vector<ts_entry_vec_t> get(int64_t _event = -1) const;  // -1 is all events
     data_t                      get_data() const { return m_data; }
 
 private:
-    data_t m_data = {};
+    int32_t m_tid  = 0;
+    data_t  m_data = {};
 };
 }  // namespace component
 }  // namespace omnitrace
@@ -27,9 +27,16 @@
 #include "core/state.hpp"
 #include "core/timemory.hpp"
 #include "library/causal/data.hpp"
+#include "library/components/topdown.hpp"
+#include "library/critical_path.hpp"
+#include "library/exporter.hpp"
+#include "library/region_context.hpp"
+#include "library/region_intervals.hpp"
 #include "library/runtime.hpp"
+#include "library/snapshot.hpp"
 #include "library/tracing.hpp"
 #include "library/tracing/annotation.hpp"
+#include "library/triggers.hpp"
 
 #include <timemory/components/gotcha/backends.hpp>
 #include <timemory/hash/types.hpp>
@@ -37,7 +44,9 @@
 #include <timemory/mpl/types.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <string>
 #include <string_view>
+#include <type_traits>
 
 namespace tim
 {
@@ -54,6 +63,15 @@ struct timemory : concepts::quirk_type
 }  // namespace quirk
 }  // namespace tim
 
+// definition of the opaque omnitrace_region_handle_t. Instances are created by
+// omnitrace_register_region and are never destroyed so the name can be passed to
+// perfetto as a static string
+struct omnitrace_region
+{
+    tim::hash_value_t hash = 0;
+    std::string       name = {};
+};
+
 namespace omnitrace
 {
 namespace component
@@ -72,6 +90,49 @@ using causal_throughput_categories_t =
     type_list<category::host, category::kokkos, category::ompt, category::rocm_hip,
               category::rocm_hsa, category::rocm_rccl, category::rocm_roctx>;
 
+// the top-down fractions are computed between the push and the pop of these categories
+using topdown_categories_t = type_list<category::host, category::user, category::python>;
+
+// the statistics of these categories are streamed to OMNITRACE_EXPORT_ENDPOINT
+using export_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::mpi, category::ompt, category::rocm_hip, category::rocm_hsa,
+              category::rocm_rccl, category::rocm_roctx>;
+
+// the regions of these categories which exceed OMNITRACE_PERFETTO_SNAPSHOT_THRESHOLD
+// trigger a snapshot of the perfetto ring buffer
+using snapshot_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::mpi, category::rocm_hip, category::rocm_rccl,
+              category::rocm_roctx>;
+
+// the regions of these categories can delimit the iterations of
+// OMNITRACE_PERFETTO_ITERATION_REGION
+using iteration_categories_t =
+    type_list<category::host, category::user, category::python>;
+
+// the regions of these categories are evaluated by OMNITRACE_TRIGGERS
+using trigger_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::mpi, category::rocm_roctx>;
+
+// the innermost active region of these categories tags the samples of the thread
+using region_context_categories_t = type_list<category::user, category::python,
+                                              category::kokkos, category::mpi,
+                                              category::rocm_roctx>;
+
+// the time on the critical path is attributed to the regions of these categories
+using critical_path_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::mpi, category::pthread, category::rocm_hip,
+              category::rocm_rccl, category::rocm_roctx>;
+
+// the sampled metrics (e.g. the CPU and GPU energy) are attributed to the intervals of
+// the regions of these categories
+using region_intervals_categories_t =
+    type_list<category::host, category::user, category::python, category::kokkos,
+              category::rocm_roctx>;
+
 // define this outside of category region functions so that the
 // static thread_local is global instead of per-template instantiation
 inline ThreadState
@@ -100,6 +161,13 @@ struct category_region : comp::base<category_region<CategoryT>, void>
     template <typename... OptsT, typename... Args>
     static void stop(std::string_view name, Args&&...);
 
+    // pre-registered regions skip hashing and interning the name
+    template <typename... OptsT, typename... Args>
+    static void start(const omnitrace_region&, Args&&...);
+
+    template <typename... OptsT, typename... Args>
+    static void stop(const omnitrace_region&, Args&&...);
+
     template <typename... OptsT, typename... Args>
     static void mark(std::string_view name, Args&&...);
 
@@ -117,6 +185,13 @@ struct category_region : comp::base<category_region<CategoryT>, void>
 
     template <typename... OptsT, typename... Args>
     static void audit(quirk::config<OptsT...>, Args&&...);
+
+private:
+    template <typename... OptsT, typename RegionT, typename... Args>
+    static void start_impl(const RegionT&, Args&&...);
+
+    template <typename... OptsT, typename RegionT, typename... Args>
+    static void stop_impl(const RegionT&, Args&&...);
 };
 
 template <typename CategoryT>
@@ -124,6 +199,52 @@ template <typename... OptsT, typename... Args>
 void
 category_region<CategoryT>::start(std::string_view name, Args&&... args)
 {
+    start_impl<OptsT...>(name, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+{
+    stop_impl<OptsT...>(name, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::start(const omnitrace_region& _region, Args&&... args)
+{
+    start_impl<OptsT...>(_region, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(const omnitrace_region& _region, Args&&... args)
+{
+    stop_impl<OptsT...>(_region, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename RegionT, typename... Args>
+void
+category_region<CategoryT>::start_impl(const RegionT& _region, Args&&... args)
+{
+    constexpr bool _is_registered = std::is_same<RegionT, omnitrace_region>::value;
+
+    // evaluated before the category check since the triggers may enable the category
+    if constexpr(is_one_of<CategoryT, trigger_categories_t>::value)
+    {
+        if(triggers::is_enabled())
+        {
+            if constexpr(_is_registered)
+                triggers::push(_region.hash);
+            else
+                triggers::push(tim::hash::get_hash_id(_region));
+        }
+    }
+
     // skip if category is disabled
     if(tracing::category_push_disabled<CategoryT>()) return;
 
@@ -131,6 +252,12 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
     if(get_thread_state() == ThreadState::Disabled) return;
     if(get_state() >= State::Finalized) return;
 
+    auto name = std::string_view{};
+    if constexpr(_is_registered)
+        name = _region.name;
+    else
+        name = _region;
+
     if(name.empty()) return;
 
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
@@ -162,8 +289,31 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
         ++tracing::push_count();
     }
 
-    auto _hash = tim::add_hash_id(name);
-    name       = tim::get_hash_identifier_fast(_hash);
+    auto _hash = tim::hash_value_t{ 0 };
+    if constexpr(_is_registered)
+    {
+        _hash = _region.hash;
+    }
+    else
+    {
+        _hash = tim::add_hash_id(name);
+        name  = tim::get_hash_identifier_fast(_hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, region_context_categories_t>::value)
+    {
+        region_context::push(_hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, critical_path_categories_t>::value)
+    {
+        if(critical_path::is_enabled()) critical_path::push(_hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, region_intervals_categories_t>::value)
+    {
+        if(region_intervals::is_enabled()) region_intervals::push(_hash);
+    }
 
     if constexpr(_ct_use_causal)
     {
@@ -177,7 +327,7 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
     {
         if(get_use_timemory())
         {
-            tracing::push_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+            tracing::push_timemory(CategoryT{}, _hash, std::forward<Args>(args)...);
         }
     }
 
@@ -188,18 +338,58 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
             tracing::push_perfetto(CategoryT{}, name.data(), std::forward<Args>(args)...);
         }
     }
+
+    if constexpr(is_one_of<CategoryT, topdown_categories_t>::value)
+    {
+        if(get_use_topdown()) topdown::begin();
+    }
+
+    if constexpr(is_one_of<CategoryT, export_categories_t>::value)
+    {
+        if(exporter::is_active()) exporter::begin(_hash);
+    }
+
+    if constexpr(is_one_of<CategoryT, snapshot_categories_t>::value)
+    {
+        if(snapshot::use_threshold()) snapshot::begin();
+    }
+
+    if constexpr(is_one_of<CategoryT, iteration_categories_t>::value)
+    {
+        if(tracing::iteration::is_enabled()) tracing::iteration::begin(name);
+    }
 }
 
 template <typename CategoryT>
-template <typename... OptsT, typename... Args>
+template <typename... OptsT, typename RegionT, typename... Args>
 void
-category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+category_region<CategoryT>::stop_impl(const RegionT& _region, Args&&... args)
 {
+    constexpr bool _is_registered = std::is_same<RegionT, omnitrace_region>::value;
+
+    // evaluated before the category check since the triggers may disable the category
+    if constexpr(is_one_of<CategoryT, trigger_categories_t>::value)
+    {
+        if(triggers::is_enabled())
+        {
+            if constexpr(_is_registered)
+                triggers::pop(_region.hash);
+            else
+                triggers::pop(tim::hash::get_hash_id(_region));
+        }
+    }
+
     // skip if category is disabled
     if(tracing::category_pop_disabled<CategoryT>()) return;
 
     if(get_thread_state() == ThreadState::Disabled) return;
 
+    auto name = std::string_view{};
+    if constexpr(_is_registered)
+        name = _region.name;
+    else
+        name = _region;
+
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
 
     constexpr bool _ct_use_timemory =
@@ -225,6 +415,47 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
             ++tracing::pop_count();
         }
 
+        if constexpr(is_one_of<CategoryT, region_context_categories_t>::value)
+        {
+            region_context::pop();
+        }
+
+        if constexpr(is_one_of<CategoryT, critical_path_categories_t>::value)
+        {
+            if(critical_path::is_enabled()) critical_path::pop();
+        }
+
+        if constexpr(is_one_of<CategoryT, region_intervals_categories_t>::value)
+        {
+            if(region_intervals::is_enabled()) region_intervals::pop();
+        }
+
+        if constexpr(is_one_of<CategoryT, topdown_categories_t>::value)
+        {
+            if(get_use_topdown()) topdown::end(name);
+        }
+
+        if constexpr(is_one_of<CategoryT, export_categories_t>::value)
+        {
+            if(exporter::is_active())
+            {
+                if constexpr(_is_registered)
+                    exporter::end(_region.hash, name);
+                else
+                    exporter::end(tim::hash::get_hash_id(name), name);
+            }
+        }
+
+        if constexpr(is_one_of<CategoryT, snapshot_categories_t>::value)
+        {
+            if(snapshot::use_threshold()) snapshot::end(name);
+        }
+
+        if constexpr(is_one_of<CategoryT, iteration_categories_t>::value)
+        {
+            if(tracing::iteration::is_enabled()) tracing::iteration::end(name);
+        }
+
         if constexpr(_ct_use_perfetto)
         {
             if(get_use_perfetto())
@@ -238,7 +469,13 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
         {
             if(get_use_timemory())
             {
-                tracing::pop_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+                auto _hash = tim::hash_value_t{ 0 };
+                if constexpr(_is_registered)
+                    _hash = _region.hash;
+                else
+                    _hash = tim::hash::get_hash_id(name);
+
+                tracing::pop_timemory(CategoryT{}, _hash, std::forward<Args>(args)...);
             }
         }
 
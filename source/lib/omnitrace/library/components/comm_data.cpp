@@ -23,6 +23,8 @@
 #include "library/components/comm_data.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
+#include "core/concepts.hpp"
+#include "core/containers/aligned_static_vector.hpp"
 #include "core/perfetto.hpp"
 #include "library/tracing.hpp"
 
@@ -31,18 +33,109 @@
 #include <timemory/units.hpp>
 #include <timemory/utility/locking.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
 namespace omnitrace
 {
 namespace component
 {
 namespace
 {
+// running totals for the communication volume counter tracks. Each thread adds to
+// its own cache-line aligned shard and the shards are summed when the counter is
+// emitted so the MPI/RCCL wrappers never contend on a lock or a shared cache line
+template <typename Tp>
+struct comm_data_shards
+{
+    struct shard
+    {
+        alignas(container::cacheline_align_v) std::atomic<uint64_t> value = { 0 };
+    };
+
+    static void add(uint64_t _val)
+    {
+        static thread_local auto _idx = get_count()++ % max_supported_threads;
+        get_shards().at(_idx).value.fetch_add(_val, std::memory_order_relaxed);
+    }
+
+    static uint64_t sum()
+    {
+        auto     _n = std::min<size_t>(get_count().load(), max_supported_threads);
+        uint64_t _v = 0;
+        for(size_t i = 0; i < _n; ++i)
+            _v += get_shards().at(i).value.load(std::memory_order_relaxed);
+        return _v;
+    }
+
+private:
+    static std::atomic<size_t>& get_count()
+    {
+        static auto _v = std::atomic<size_t>{ 0 };
+        return _v;
+    }
+
+    static auto& get_shards()
+    {
+        static auto* _v = new std::array<shard, max_supported_threads>{};
+        return *_v;
+    }
+};
+
+// optional per-peer breakdown of the communication volume. The tracks are created
+// the first time a peer is seen and peers beyond max_peers are only included in
+// the total
+template <typename Tp>
+struct comm_data_peers
+{
+    static constexpr int64_t max_peers = 1024;
+
+    struct peer
+    {
+        std::once_flag                          once  = {};
+        std::atomic<uint64_t>                   value = { 0 };
+        std::string                             name  = {};
+        std::optional<::perfetto::CounterTrack> track = {};
+    };
+
+    static void add(int64_t _peer, uint64_t _now, uint64_t _val)
+    {
+        if(_peer < 0 || _peer >= max_peers) return;
+
+        auto& _data = get_peers().at(_peer);
+        std::call_once(_data.once, [&_data, _peer]() {
+            _data.name        = JOIN(" ", Tp::label, JOIN("", "[peer=", _peer, ']'));
+            const auto* _name = _data.name.c_str();
+            _data.track = ::perfetto::CounterTrack{ ::perfetto::DynamicString{ _name } }
+                              .set_unit_name("bytes");
+        });
+
+        _val = _data.value.fetch_add(_val, std::memory_order_relaxed) + _val;
+        TRACE_COUNTER(Tp::value, *_data.track, _now, _val);
+    }
+
+private:
+    static auto& get_peers()
+    {
+        static auto* _v = new std::array<peer, max_peers>{};
+        return *_v;
+    }
+};
+
 template <typename Tp, typename... Args>
 void
-write_perfetto_counter_track(uint64_t _val)
+write_perfetto_counter_track(uint64_t _val, int64_t _peer = -1)
 {
     using counter_track = omnitrace::perfetto_counter_track<Tp>;
 
+    // the totals are also used by the causal progress counters
+    comm_data_shards<Tp>::add(_val);
+
     if(omnitrace::get_use_perfetto() &&
        omnitrace::get_state() == omnitrace::State::Active)
     {
@@ -60,16 +153,12 @@ write_perfetto_counter_track(uint64_t _val)
         static std::once_flag _once{};
         std::call_once(_once, _emplace, _idx);
 
-        static std::mutex _mutex{};
-        static uint64_t   value = 0;
-        uint64_t          _now  = 0;
-        {
-            std::unique_lock<std::mutex> _lk{ _mutex };
-            _now = omnitrace::tracing::now<uint64_t>();
-            _val = (value += _val);
-        }
+        uint64_t _now = omnitrace::tracing::now<uint64_t>();
+        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now,
+                      comm_data_shards<Tp>::sum());
 
-        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now, _val);
+        if(_peer >= 0 && config::get_perfetto_comm_data_per_peer())
+            comm_data_peers<Tp>::add(_peer, _now, _val);
     }
 }
 }  // namespace
@@ -86,6 +175,17 @@ comm_data::global_finalize()
     configure();
 }
 
+uint64_t
+comm_data::get_total_bytes(bool _send, bool _recv)
+{
+    uint64_t _v = 0;
+    if(_send)
+        _v += comm_data_shards<mpi_send>::sum() + comm_data_shards<rccl_send>::sum();
+    if(_recv)
+        _v += comm_data_shards<mpi_recv>::sum() + comm_data_shards<rccl_recv>::sum();
+    return _v;
+}
+
 void
 comm_data::configure()
 {
@@ -114,7 +214,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int cou
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
-    write_perfetto_counter_track<mpi_send>(count * _size);
+    write_perfetto_counter_track<mpi_send>(count * _size, dst);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -133,7 +233,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
-    write_perfetto_counter_track<mpi_recv>(count * _size);
+    write_perfetto_counter_track<mpi_recv>(count * _size, dst);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -152,7 +252,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int cou
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
-    write_perfetto_counter_track<mpi_send>(count * _size);
+    write_perfetto_counter_track<mpi_send>(count * _size, dst);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -171,7 +271,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
-    write_perfetto_counter_track<mpi_recv>(count * _size);
+    write_perfetto_counter_track<mpi_recv>(count * _size, dst);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -224,8 +324,8 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
     int _recv_size = mpi_type_size(recvtype);
     if(_send_size == 0 || _recv_size == 0) return;
 
-    write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
-    write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
+    write_perfetto_counter_track<mpi_send>(sendcount * _send_size, dst);
+    write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size, src);
 
     if(!omnitrace::get_use_timemory()) return;
     auto      _name = std::string_view{ _data.tool_id };
@@ -330,13 +430,18 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, size_t
     static auto _send_types = std::unordered_set<std::string>{ "ncclSend", "ncclBcast" };
     static auto _recv_types = std::unordered_set<std::string>{ "ncclGather", "ncclRecv" };
 
+    // only ncclSend and ncclRecv have a peer, the root of ncclBcast/ncclGather is
+    // not a per-peer origin/destination of the data
+    const bool _has_peer = (_data.tool_id == "ncclSend" || _data.tool_id == "ncclRecv");
+    const auto _peer     = (_has_peer) ? int64_t{ peer } : int64_t{ -1 };
+
     if(_send_types.count(_data.tool_id) > 0)
     {
-        write_perfetto_counter_track<rccl_send>(count * _size);
+        write_perfetto_counter_track<rccl_send>(count * _size, _peer);
     }
     else if(_recv_types.count(_data.tool_id) > 0)
     {
-        write_perfetto_counter_track<rccl_recv>(count * _size);
+        write_perfetto_counter_track<rccl_recv>(count * _size, _peer);
     }
     else
     {
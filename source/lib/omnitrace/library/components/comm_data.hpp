@@ -95,6 +95,9 @@ struct comm_data : base<comm_data, void>
     static void preinit();
     static void configure();
     static void global_finalize();
+
+    // total number of bytes sent and/or received through the MPI and RCCL wrappers
+    static uint64_t get_total_bytes(bool _send = true, bool _recv = true);
     static void start() {}
     static void stop() {}
 
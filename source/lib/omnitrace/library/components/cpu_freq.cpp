@@ -28,6 +28,7 @@
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
 #include "core/timemory.hpp"
+#include "library/perf.hpp"
 
 #include <timemory/components/macros.hpp>
 #include <timemory/components/rusage/backends.hpp>
@@ -36,12 +37,183 @@
 #include <timemory/utility/procfs/cpuinfo.hpp>
 #include <timemory/utility/type_list.hpp>
 
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <unistd.h>
+
 namespace cpuinfo = tim::procfs::cpuinfo;
 
 namespace omnitrace
 {
 namespace component
 {
+namespace
+{
+enum class freq_backend
+{
+    cpuinfo = 0,
+    sysfs,
+    aperf_mperf,
+};
+
+freq_backend&
+get_backend()
+{
+    static auto _v = freq_backend::cpuinfo;
+    return _v;
+}
+
+// file descriptors of scaling_cur_freq, which are re-read from offset zero
+struct sysfs_freq
+{
+    sysfs_freq() = default;
+    ~sysfs_freq();
+    sysfs_freq(const sysfs_freq&) = delete;
+    sysfs_freq& operator=(const sysfs_freq&) = delete;
+
+    bool   open(uint64_t _cpu);
+    double read() const;  // MHz
+
+    int m_fd = -1;
+};
+
+sysfs_freq::~sysfs_freq()
+{
+    if(m_fd >= 0) ::close(m_fd);
+}
+
+bool
+sysfs_freq::open(uint64_t _cpu)
+{
+    auto _path =
+        JOIN("", "/sys/devices/system/cpu/cpu", _cpu, "/cpufreq/scaling_cur_freq");
+    m_fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    return (m_fd >= 0);
+}
+
+double
+sysfs_freq::read() const
+{
+    char _buf[32];
+    auto _n = ::pread(m_fd, _buf, sizeof(_buf) - 1, 0);
+    if(_n <= 0) return 0.0;
+    _buf[_n] = '\0';
+    // the value is in kHz
+    return std::strtoull(_buf, nullptr, 10) / 1.0e3;
+}
+
+// APERF counts at the actual frequency and MPERF at the TSC frequency while the CPU
+// is in C0 so the effective frequency while busy is (dAPERF / dMPERF) x TSC frequency
+struct msr_freq
+{
+    bool   open(uint64_t _cpu, uint32_t _type);
+    double read();  // MHz
+
+    perf::perf_event m_aperf      = {};
+    perf::perf_event m_mperf      = {};
+    perf::perf_event m_tsc        = {};
+    uint64_t         m_last_aperf = 0;
+    uint64_t         m_last_mperf = 0;
+    uint64_t         m_last_tsc   = 0;
+    uint64_t         m_last_ns    = 0;
+};
+
+bool
+msr_freq::open(uint64_t _cpu, uint32_t _type)
+{
+    // event encodings of the msr PMU: tsc=0x00, aperf=0x01, mperf=0x02
+    auto _open = [_cpu, _type](perf::perf_event& _event, uint64_t _config) {
+        struct perf_event_attr _pe;
+        memset(&_pe, 0, sizeof(_pe));
+        _pe.type   = _type;
+        _pe.config = _config;
+        return !_event.open(_pe, -1, _cpu) && _event.start();
+    };
+
+    return _open(m_tsc, 0x00) && _open(m_aperf, 0x01) && _open(m_mperf, 0x02);
+}
+
+double
+msr_freq::read()
+{
+    auto _ns    = tim::get_clock_real_now<uint64_t, std::nano>();
+    auto _aperf = m_aperf.get_count();
+    auto _mperf = m_mperf.get_count();
+    auto _tsc   = m_tsc.get_count();
+
+    double _freq = 0.0;
+    if(m_last_ns > 0 && _ns > m_last_ns && _mperf > m_last_mperf)
+    {
+        // TSC ticks per nanosecond is the TSC frequency in GHz
+        double _tsc_mhz = (1.0e3 * (_tsc - m_last_tsc)) / (_ns - m_last_ns);
+        double _ratio   = static_cast<double>(_aperf - m_last_aperf) /
+                        static_cast<double>(_mperf - m_last_mperf);
+        _freq = _tsc_mhz * _ratio;
+    }
+
+    m_last_aperf = _aperf;
+    m_last_mperf = _mperf;
+    m_last_tsc   = _tsc;
+    m_last_ns    = _ns;
+    return _freq;
+}
+
+// indexed in the order of the enabled CPUs
+auto sysfs_freqs = std::vector<std::unique_ptr<sysfs_freq>>{};
+auto msr_freqs   = std::vector<std::unique_ptr<msr_freq>>{};
+
+bool
+configure_sysfs(const cpu_freq::cpu_id_set_t& _cpus)
+{
+    sysfs_freqs.clear();
+    for(auto itr : _cpus)
+    {
+        sysfs_freqs.emplace_back(std::make_unique<sysfs_freq>());
+        if(!sysfs_freqs.back()->open(itr))
+        {
+            OMNITRACE_VERBOSE(1,
+                              "[cpu_freq::config] scaling_cur_freq of cpu %zu is not "
+                              "available: %s\n",
+                              itr, strerror(errno));
+            sysfs_freqs.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+configure_msr(const cpu_freq::cpu_id_set_t& _cpus)
+{
+    auto _type = perf::get_pmu_type("msr");
+    if(_type < 0)
+    {
+        OMNITRACE_VERBOSE(1, "[cpu_freq::config] the perf msr PMU is not available\n");
+        return false;
+    }
+
+    msr_freqs.clear();
+    for(auto itr : _cpus)
+    {
+        msr_freqs.emplace_back(std::make_unique<msr_freq>());
+        if(!msr_freqs.back()->open(itr, static_cast<uint32_t>(_type)))
+        {
+            OMNITRACE_VERBOSE(1,
+                              "[cpu_freq::config] APERF/MPERF counters of cpu %zu could "
+                              "not be opened\n",
+                              itr);
+            msr_freqs.clear();
+            return false;
+        }
+        // the first interval starts now
+        msr_freqs.back()->read();
+    }
+    return true;
+}
+}  // namespace
+
 cpu_freq::cpu_id_set_t&
 cpu_freq::get_enabled_cpus()
 {
@@ -153,6 +325,27 @@ cpu_freq::configure()
                                         ":: unable to open /proc/cpuinfo");
 
     get_enabled_cpus() = _enabled_freqs;
+
+    auto _backend = config::get_setting_value<std::string>("OMNITRACE_CPU_FREQ_BACKEND")
+                        .value_or("sysfs");
+
+    get_backend() = freq_backend::cpuinfo;
+    if(_enabled_freqs.empty()) return;
+
+    if(_backend == "aperf-mperf")
+    {
+        if(configure_msr(_enabled_freqs))
+        {
+            get_backend() = freq_backend::aperf_mperf;
+            return;
+        }
+        OMNITRACE_VERBOSE(0, "[cpu_freq::config] Warning! Effective CPU frequencies are "
+                             "not available, using scaling_cur_freq...\n");
+        _backend = "sysfs";
+    }
+
+    if(_backend == "sysfs" && configure_sysfs(_enabled_freqs))
+        get_backend() = freq_backend::sysfs;
 }
 
 std::string
@@ -167,13 +360,29 @@ cpu_freq::record()
     auto& enabled_cpu_freqs = get_enabled_cpus();
 
     std::vector<uint64_t> _freqs{};
-    if(!enabled_cpu_freqs.empty())
+    if(enabled_cpu_freqs.empty()) return _freqs;
+
+    _freqs.reserve(enabled_cpu_freqs.size());
+    switch(get_backend())
     {
-        _freqs.reserve(enabled_cpu_freqs.size());
-        auto&& _freq = cpuinfo::freq{};
-        for(const auto& itr : enabled_cpu_freqs)
+        case freq_backend::aperf_mperf:
+        {
+            for(auto& itr : msr_freqs)
+                _freqs.emplace_back(itr->read() * tim::units::MHz);
+            break;
+        }
+        case freq_backend::sysfs:
+        {
+            for(const auto& itr : sysfs_freqs)
+                _freqs.emplace_back(itr->read() * tim::units::MHz);
+            break;
+        }
+        case freq_backend::cpuinfo:
         {
-            _freqs.emplace_back(_freq(itr) * tim::units::MHz);
+            auto&& _freq = cpuinfo::freq{};
+            for(const auto& itr : enabled_cpu_freqs)
+                _freqs.emplace_back(_freq(itr) * tim::units::MHz);
+            break;
         }
     }
 
@@ -28,6 +28,7 @@
 #include "core/perfetto_fwd.hpp"
 #include "core/state.hpp"
 #include "library/components/fork_gotcha.hpp"
+#include "library/process_sampler.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 
@@ -106,6 +107,34 @@ postfork_parent()
     prefork_lock         = false;
 }
 
+// everything the parent analyzed (config, binary and symbol info, interned strings,
+// instrumentation) is inherited copy-on-write so only the per-process state is reset.
+// The perfetto session, the sampling timers, and the background threads are not
+// duplicated by fork() and perfetto cannot be initialized a second time in a
+// process so those backends are disabled in the child. Nothing here does I/O or
+// creates a thread
+void
+postfork_child_inherit()
+{
+    omnitrace::get_perfetto_session(process::get_parent_id()).release();
+    omnitrace::sampling::shutdown();
+    process_sampler::release();
+
+    config::set_setting_value("OMNITRACE_TRACE", false);
+    config::set_setting_value("OMNITRACE_USE_SAMPLING", false);
+    config::set_setting_value("OMNITRACE_USE_PROCESS_SAMPLING", false);
+    config::set_setting_value("OMNITRACE_USE_ROCTRACER", false);
+    config::refresh_snapshot();
+
+    // the output files of the child are distinguished by its pid
+    settings::use_output_suffix() = true;
+
+    omnitrace::categories::enable_categories(config::get_enabled_categories());
+
+    OMNITRACE_BASIC_VERBOSE(1, "fork() child PID %i inherited the tooling of PID %i\n",
+                            process::get_id(), process::get_parent_id());
+}
+
 void
 postfork_child()
 {
@@ -115,18 +144,25 @@ postfork_child()
         << "Error! child process " << process::get_id()
         << " believes it is the root process " << get_root_process_id() << "\n";
 
-    settings::enabled() = false;
-    settings::verbose() = -127;
-    settings::debug()   = false;
-    omnitrace::sampling::shutdown();
-    omnitrace::categories::shutdown();
-    set_thread_state(::omnitrace::ThreadState::Disabled);
-
-    omnitrace::get_perfetto_session(process::get_parent_id()).release();
-
-    // register these exit handlers to avoid cleaning up resources
-    on_exit(&child_exit, nullptr);
-    std::atexit([]() { child_exit(EXIT_SUCCESS, nullptr); });
+    if(config::get_fork_mode() == "inherit")
+    {
+        postfork_child_inherit();
+    }
+    else
+    {
+        settings::enabled() = false;
+        settings::verbose() = -127;
+        settings::debug()   = false;
+        omnitrace::sampling::shutdown();
+        omnitrace::categories::shutdown();
+        set_thread_state(::omnitrace::ThreadState::Disabled);
+
+        omnitrace::get_perfetto_session(process::get_parent_id()).release();
+
+        // register these exit handlers to avoid cleaning up resources
+        on_exit(&child_exit, nullptr);
+        std::atexit([]() { child_exit(EXIT_SUCCESS, nullptr); });
+    }
 
     // prevent re-entry until prefork has been called
     postfork_child_lock = true;
@@ -165,7 +201,7 @@ fork_gotcha::operator()(const gotcha_data_t&, pid_t (*_real_fork)()) const
         postfork_child();
     }
 
-    if(!settings::use_output_suffix())
+    if(!settings::use_output_suffix() && config::get_fork_mode() != "inherit")
     {
         OMNITRACE_BASIC_VERBOSE(
             0, "Application which make calls to fork() should enable using an process "
@@ -0,0 +1,562 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/heap_profiler.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "core/utility.hpp"
+#include "library/callsite.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/types.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+constexpr size_t callsite_depth        = 32;
+constexpr size_t callsite_ignore_depth = 2;
+constexpr size_t filter_bits           = 16;
+
+using callsite_frames_t = std::array<uintptr_t, callsite_depth>;
+
+// set while the thread is in a wrapper or records a sample so that the nested
+// allocations (e.g. malloc in operator new) and the allocations of the bookkeeping are
+// never sampled. Static TLS since malloc is invoked before the dynamic TLS of the
+// thread is allocated
+__thread bool in_wrapper __attribute__((tls_model("initial-exec"))) = false;
+
+// the bytes left until the next sample of the thread and the state of its generator
+__thread int64_t  bytes_until_sample __attribute__((tls_model("initial-exec"))) = 0;
+__thread uint64_t sample_rng __attribute__((tls_model("initial-exec")))         = 0;
+
+struct wrapper_guard
+{
+    wrapper_guard()
+    : m_prev{ in_wrapper }
+    {
+        in_wrapper = true;
+    }
+    ~wrapper_guard() { in_wrapper = m_prev; }
+
+    wrapper_guard(const wrapper_guard&) = delete;
+    wrapper_guard& operator=(const wrapper_guard&) = delete;
+
+private:
+    bool m_prev = false;
+};
+
+// the estimates of one call-site. The bytes are the sum of the weights of the samples
+struct callsite_entry
+{
+    uint64_t          samples = 0;
+    double            count   = 0.0;
+    uint64_t          bytes   = 0;
+    int64_t           live    = 0;
+    callsite_frames_t frames  = {};
+};
+
+struct sampled_allocation
+{
+    uint64_t callsite = 0;
+    uint64_t bytes    = 0;  // weight of the sample
+};
+
+// the sampled allocations are rare (one per OMNITRACE_HEAP_PROFILE_RATE bytes) so a
+// single lock is sufficient. The counting filter of the addresses of the live samples
+// lets free skip the lock for the addresses which were never sampled
+struct heap_table
+{
+    using filter_t = std::array<std::atomic<uint32_t>, (1UL << filter_bits)>;
+
+    std::mutex                                        mutex      = {};
+    std::unordered_map<uint64_t, callsite_entry>      callsites  = {};
+    std::unordered_map<uintptr_t, sampled_allocation> live       = {};
+    filter_t                                          filter     = {};
+    std::atomic<size_t>                               nlive      = 0;
+    std::atomic<uint64_t>                             allocated  = 0;
+    std::atomic<int64_t>                              live_bytes = 0;
+
+    static size_t get_filter_index(uintptr_t _addr)
+    {
+        return ((_addr >> 4) * 0x9e3779b97f4a7c15ULL) >> (64 - filter_bits);
+    }
+
+    // lock must be held
+    void release(decltype(live)::iterator _itr)
+    {
+        auto& _site = callsites[_itr->second.callsite];
+        _site.live -= static_cast<int64_t>(_itr->second.bytes);
+        live_bytes -= static_cast<int64_t>(_itr->second.bytes);
+        --filter.at(get_filter_index(_itr->first));
+        live.erase(_itr);
+        nlive = live.size();
+    }
+};
+
+// wall-clock timestamp, estimated allocated bytes and estimated live bytes
+std::deque<std::tuple<uint64_t, uint64_t, int64_t>> samples = {};
+
+// the mean of the sampling interval in bytes
+double sample_rate = 0.0;
+
+auto&
+get_heap_table()
+{
+    // intentionally leaked since free may be invoked after the static destructors
+    static auto* _v = new heap_table{};
+    return *_v;
+}
+
+auto&
+get_heap_profiler_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<heap_profiler_gotcha_t>{};
+    return _v;
+}
+
+// exponential distribution with a mean of the sampling rate from a xorshift64*
+// generator seeded per thread, i.e. the samples are a Poisson process over the bytes
+int64_t
+get_sample_interval()
+{
+    if(OMNITRACE_UNLIKELY(sample_rng == 0))
+    {
+        sample_rng = static_cast<uint64_t>(
+                         std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                     reinterpret_cast<uintptr_t>(&sample_rng);
+        sample_rng |= 1;
+    }
+
+    sample_rng ^= sample_rng >> 12;
+    sample_rng ^= sample_rng << 25;
+    sample_rng ^= sample_rng >> 27;
+    // uniform in (0, 1]
+    auto _u = (static_cast<double>((sample_rng * 0x2545f4914f6cdd1dULL) >> 11) + 1.0) /
+              9007199254740992.0;
+    return static_cast<int64_t>(-std::log(_u) * sample_rate) + 1;
+}
+
+callsite_frames_t
+get_callsite_frames()
+{
+    auto   _frames = callsite_frames_t{};
+    auto   _stack  = tim::get_unw_stack<callsite_depth, callsite_ignore_depth, false>();
+    size_t _n      = 0;
+    for(auto itr : _stack)
+    {
+        if(itr && _n < _frames.size()) _frames.at(_n++) = itr->address();
+    }
+    return _frames;
+}
+
+uint64_t
+get_callsite_hash(const callsite_frames_t& _frames)
+{
+    uint64_t _v = 0xcbf29ce484222325ULL;
+    for(auto itr : _frames)
+    {
+        if(itr == 0) break;
+        _v = (_v ^ itr) * 0x100000001b3ULL;
+    }
+    return _v;
+}
+
+void
+sample_allocation(void* _ptr, size_t _size)
+{
+    if(get_state() != ::omnitrace::State::Active ||
+       get_thread_state() != ThreadState::Enabled)
+        return;
+
+    auto _guard  = wrapper_guard{};
+    auto _frames = get_callsite_frames();
+    auto _key    = get_callsite_hash(_frames);
+    auto _addr   = reinterpret_cast<uintptr_t>(_ptr);
+
+    // the probability that an allocation of this size was sampled
+    auto _prob  = -std::expm1(-static_cast<double>(_size) / sample_rate);
+    auto _bytes = static_cast<uint64_t>(std::llround(static_cast<double>(_size) / _prob));
+
+    auto&                        _heap = get_heap_table();
+    std::unique_lock<std::mutex> _lk{ _heap.mutex };
+    // the previous allocation at this address was released while the wrappers were
+    // not active
+    if(auto itr = _heap.live.find(_addr); itr != _heap.live.end()) _heap.release(itr);
+
+    auto& _site = _heap.callsites[_key];
+    if(_site.samples++ == 0) _site.frames = _frames;
+    _site.count += 1.0 / _prob;
+    _site.bytes += _bytes;
+    _site.live += static_cast<int64_t>(_bytes);
+
+    _heap.live.emplace(_addr, sampled_allocation{ _key, _bytes });
+    ++_heap.filter.at(heap_table::get_filter_index(_addr));
+    _heap.nlive = _heap.live.size();
+    _heap.allocated += _bytes;
+    _heap.live_bytes += static_cast<int64_t>(_bytes);
+}
+
+// the fast path of every allocation is a thread-local decrement
+void
+record_allocation(void* _ptr, size_t _size)
+{
+    if(!_ptr || in_wrapper) return;
+
+    if(OMNITRACE_UNLIKELY(sample_rng == 0)) bytes_until_sample = get_sample_interval();
+
+    bytes_until_sample -= static_cast<int64_t>(_size);
+    if(OMNITRACE_LIKELY(bytes_until_sample > 0)) return;
+
+    // the distance to the next sample is memoryless so the interval is redrawn instead
+    // of carrying over the bytes of an allocation which spans several intervals
+    bytes_until_sample = get_sample_interval();
+    sample_allocation(_ptr, _size);
+}
+
+// invoked before the memory is returned to the allocator so that the address is not
+// reused by another thread before it is removed
+void
+record_release(void* _ptr)
+{
+    auto& _heap = get_heap_table();
+    auto  _addr = reinterpret_cast<uintptr_t>(_ptr);
+    if(!_ptr || in_wrapper || _heap.nlive.load(std::memory_order_relaxed) == 0 ||
+       _heap.filter.at(heap_table::get_filter_index(_addr))
+               .load(std::memory_order_relaxed) == 0)
+        return;
+
+    auto                         _guard = wrapper_guard{};
+    std::unique_lock<std::mutex> _lk{ _heap.mutex };
+    if(auto itr = _heap.live.find(_addr); itr != _heap.live.end()) _heap.release(itr);
+}
+
+void
+write_perfetto_counter_track()
+{
+    using track = perfetto_counter_track<category::heap>;
+
+    if(samples.size() < 2) return;
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    if(!_thread_info) return;
+
+    if(!track::exists(0))
+    {
+        track::emplace(0, "Heap Allocation Rate (S)", "MB/s");
+        track::emplace(0, "Heap Live Bytes (S)", "MB");
+    }
+
+    for(size_t i = 1; i < samples.size(); ++i)
+    {
+        const auto& _prev = samples.at(i - 1);
+        const auto& _curr = samples.at(i);
+        auto        _ts   = std::get<0>(_curr);
+        if(_ts <= std::get<0>(_prev) || !_thread_info->is_valid_time(_ts)) continue;
+
+        // bytes per nanosecond == 1000 MB/s
+        auto _rate = 1.0e3 * (std::get<1>(_curr) - std::get<1>(_prev)) /
+                     (_ts - std::get<0>(_prev));
+        auto _live = static_cast<double>(std::get<2>(_curr)) / units::megabyte;
+        TRACE_COUNTER(trait::name<category::heap>::value, track::at(0, 0), _ts, _rate);
+        TRACE_COUNTER(trait::name<category::heap>::value, track::at(0, 1), _ts, _live);
+    }
+
+    TRACE_COUNTER(trait::name<category::heap>::value, track::at(0, 0),
+                  _thread_info->get_stop(), 0.0);
+}
+}  // namespace
+
+heap_profiler::heap_profiler(const gotcha_data_t& _data)
+: m_aligned{ _data.tool_id == "aligned_alloc" }
+, m_operator{ _data.tool_id.find("_Z") == 0 }
+{}
+
+void
+heap_profiler::configure()
+{
+    sample_rate = std::max<double>(config::get_heap_profile_rate(), 1.0);
+
+    heap_profiler_gotcha_t::get_initializer() = []() {
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<0, void*, size_t>{ "malloc" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<1, void*, size_t, size_t>{ "calloc" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<2, void*, void*, size_t>{ "realloc" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<3, int, void**, size_t, size_t>{ "posix_memalign" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<4, void*, size_t, size_t>{ "aligned_alloc" });
+        heap_profiler_gotcha_t::configure(comp::gotcha_config<5, void, void*>{ "free" });
+        // operator new(size_t), operator new[](size_t)
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<6, void*, size_t>{ "_Znwm" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<7, void*, size_t>{ "_Znam" });
+        // operator delete(void*), operator delete[](void*) and the sized variants
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<8, void, void*>{ "_ZdlPv" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<9, void, void*>{ "_ZdaPv" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<10, void, void*, size_t>{ "_ZdlPvm" });
+        heap_profiler_gotcha_t::configure(
+            comp::gotcha_config<11, void, void*, size_t>{ "_ZdaPvm" });
+    };
+}
+
+void
+heap_profiler::shutdown()
+{
+    heap_profiler_gotcha_t::disable();
+}
+
+void
+heap_profiler::start()
+{
+    if(!config::get_heap_profile()) return;
+
+    if(!get_heap_profiler_gotcha().get<heap_profiler_gotcha_t>()->get_is_running())
+    {
+        configure();
+        get_heap_profiler_gotcha().start();
+    }
+}
+
+void
+heap_profiler::stop()
+{
+    // the wrappers stay active until shutdown so that the releases are not missed
+}
+
+void
+heap_profiler::sample()
+{
+    auto& _heap = get_heap_table();
+    samples.emplace_back(tracing::now(), _heap.allocated.load(),
+                         _heap.live_bytes.load());
+}
+
+void
+heap_profiler::post_process()
+{
+    struct callsite_report
+    {
+        callsite_entry           entry  = {};
+        std::vector<std::string> frames = {};
+    };
+
+    if(get_use_perfetto()) write_perfetto_counter_track();
+    samples.clear();
+
+    auto& _heap    = get_heap_table();
+    auto  _reports = std::vector<callsite_report>{};
+    {
+        auto                         _guard = wrapper_guard{};
+        std::unique_lock<std::mutex> _lk{ _heap.mutex };
+        _reports.reserve(_heap.callsites.size());
+        for(const auto& itr : _heap.callsites)
+            _reports.emplace_back(callsite_report{ itr.second, {} });
+    }
+
+    if(_reports.empty()) return;
+
+    std::sort(_reports.begin(), _reports.end(),
+              [](const callsite_report& _lhs, const callsite_report& _rhs) {
+                  return std::tie(_lhs.entry.bytes, _lhs.entry.live) >
+                         std::tie(_rhs.entry.bytes, _rhs.entry.live);
+              });
+
+    OMNITRACE_VERBOSE(0,
+                      "Heap profile :: %zu call-sites, %.3f MB allocated, %.3f MB live "
+                      "at finalization (estimated with a sample every %.0f bytes)\n",
+                      _reports.size(),
+                      static_cast<double>(_heap.allocated.load()) / units::megabyte,
+                      static_cast<double>(_heap.live_bytes.load()) / units::megabyte,
+                      sample_rate);
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    // resolving the call-stacks is expensive so only the top call-sites are reported
+    auto _ntop = config::get_heap_profile_top();
+    if(_reports.size() > _ntop) _reports.resize(_ntop);
+    for(auto& itr : _reports)
+    {
+        for(auto fitr : itr.entry.frames)
+        {
+            if(fitr == 0) break;
+            // the wrappers are at the top of the stack
+            if(itr.frames.empty() && callsite::is_internal(fitr)) continue;
+            itr.frames.emplace_back(callsite::get_label(fitr));
+        }
+    }
+
+    auto _fname = tim::settings::compose_output_filename("heap-profile", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<heap_profiler>{}(
+                _fname, std::string{ "heap_profile" });
+
+        ofs << "# one sample every " << static_cast<uint64_t>(sample_rate)
+            << " bytes on average, the allocations and the bytes are estimates\n";
+        ofs << std::setw(10) << "samples" << " " << std::setw(14) << "allocations"
+            << " " << std::setw(16) << "bytes" << " " << std::setw(16) << "live bytes"
+            << "   call-stack\n";
+        for(const auto& itr : _reports)
+        {
+            const auto& _entry = itr.entry;
+            ofs << std::setw(10) << _entry.samples << " " << std::setw(14)
+                << static_cast<uint64_t>(std::llround(_entry.count)) << " "
+                << std::setw(16) << _entry.bytes << " " << std::setw(16)
+                << std::max<int64_t>(_entry.live, 0) << "   "
+                << ((itr.frames.empty()) ? std::string{ "??" } : itr.frames.front())
+                << "\n";
+            for(size_t i = 1; i < itr.frames.size(); ++i)
+                ofs << std::setw(64) << "" << "     " << itr.frames.at(i) << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening heap profile output file: %s", _fname.c_str());
+    }
+}
+
+void*
+heap_profiler::operator()(void* (*_callee)(size_t), size_t _size) const
+{
+    void* _ret = nullptr;
+    if(m_operator)
+    {
+        // operator new allocates with malloc, which is not sampled again
+        auto _guard = wrapper_guard{};
+        _ret        = (*_callee)(_size);
+    }
+    else
+    {
+        _ret = (*_callee)(_size);
+    }
+    record_allocation(_ret, _size);
+    return _ret;
+}
+
+void*
+heap_profiler::operator()(void* (*_callee)(size_t, size_t), size_t _a, size_t _b) const
+{
+    // calloc(nmemb, size) or aligned_alloc(alignment, size)
+    auto* _ret = (*_callee)(_a, _b);
+    record_allocation(_ret, (m_aligned) ? _b : _a * _b);
+    return _ret;
+}
+
+void*
+heap_profiler::operator()(void* (*_callee)(void*, size_t), void* _ptr,
+                          size_t _size) const
+{
+    // realloc(ptr, 0) frees the block. Otherwise, the block is only released once the
+    // reallocation succeeded because a failed realloc leaves the block untouched
+    if(_size == 0) record_release(_ptr);
+    auto* _ret = (*_callee)(_ptr, _size);
+    if(_ret != nullptr && _size > 0)
+    {
+        record_release(_ptr);
+        record_allocation(_ret, _size);
+    }
+    return _ret;
+}
+
+int
+heap_profiler::operator()(int (*_callee)(void**, size_t, size_t), void** _ptr,
+                          size_t _align, size_t _size) const
+{
+    auto _ret = (*_callee)(_ptr, _align, _size);
+    if(_ret == 0 && _ptr) record_allocation(*_ptr, _size);
+    return _ret;
+}
+
+void
+heap_profiler::operator()(void (*_callee)(void*), void* _ptr) const
+{
+    record_release(_ptr);
+    if(m_operator)
+    {
+        // operator delete releases with free
+        auto _guard = wrapper_guard{};
+        (*_callee)(_ptr);
+    }
+    else
+    {
+        (*_callee)(_ptr);
+    }
+}
+
+void
+heap_profiler::operator()(void (*_callee)(void*, size_t), void* _ptr,
+                          size_t _size) const
+{
+    record_release(_ptr);
+    auto _guard = wrapper_guard{};
+    (*_callee)(_ptr, _size);
+}
+}  // namespace component
+}  // namespace omnitrace
+
+namespace tim
+{
+namespace policy
+{
+template <size_t N>
+heap_profiler&
+static_data<heap_profiler, heap_profiler_gotcha_t>::operator()(
+    std::integral_constant<size_t, N>, const component::gotcha_data& _data) const
+{
+    // not thread-local since the construction of the thread-local data would allocate
+    static auto _v = heap_profiler{ _data };
+    return _v;
+}
+}  // namespace policy
+}  // namespace tim
@@ -0,0 +1,109 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/mpl/macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace omnitrace
+{
+namespace component
+{
+// samples the heap allocations by bytes: every thread counts down an interval of
+// bytes drawn from an exponential distribution with a mean of
+// OMNITRACE_HEAP_PROFILE_RATE and the allocation which crosses it is sampled with its
+// call-stack. Each sample is weighted by the inverse of its probability so the
+// allocated and live bytes per call-site are unbiased estimates
+struct heap_profiler : comp::base<heap_profiler, void>
+{
+    static constexpr size_t gotcha_capacity = 12;
+    using gotcha_data_t                     = comp::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(heap_profiler)
+
+    explicit heap_profiler(const gotcha_data_t&);
+
+    // string id for component
+    static std::string label() { return "heap_profiler"; }
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // records the estimated allocated and live bytes for the allocation rate counter.
+    // Invoked by the background process sampler
+    static void sample();
+
+    // writes the allocation rate counters and the call-sites which allocated the most
+    static void post_process();
+
+    void* operator()(void* (*)(size_t), size_t) const;
+    void* operator()(void* (*)(size_t, size_t), size_t, size_t) const;
+    void* operator()(void* (*)(void*, size_t), void*, size_t) const;
+    int   operator()(int (*)(void**, size_t, size_t), void**, size_t, size_t) const;
+    void  operator()(void (*)(void*), void*) const;
+    void  operator()(void (*)(void*, size_t), void*, size_t) const;
+
+private:
+    // aligned_alloc has the same signature as calloc and operator new has the same
+    // signature as malloc (and operator delete as free)
+    bool m_aligned  = false;
+    bool m_operator = false;
+};
+
+using heap_profiler_gotcha_t =
+    comp::gotcha<heap_profiler::gotcha_capacity, std::tuple<>, heap_profiler>;
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_DEFINE_CONCRETE_TRAIT(fast_gotcha, component::heap_profiler_gotcha_t, true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(static_data, component::heap_profiler_gotcha_t, true_type)
+
+namespace tim
+{
+namespace policy
+{
+using heap_profiler          = ::omnitrace::component::heap_profiler;
+using heap_profiler_gotcha_t = ::omnitrace::component::heap_profiler_gotcha_t;
+
+template <>
+struct static_data<heap_profiler, heap_profiler_gotcha_t> : std::true_type
+{
+    template <size_t N>
+    heap_profiler& operator()(std::integral_constant<size_t, N>,
+                              const component::gotcha_data& _data) const;
+};
+}  // namespace policy
+}  // namespace tim
@@ -0,0 +1,711 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/io_gotcha.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/utility.hpp"
+#include "library/callsite.hpp"
+#include "library/components/category_region.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/types.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+constexpr size_t histogram_bins = 48;
+
+enum io_op : uint8_t
+{
+    IO_READ = 0,
+    IO_WRITE,
+    IO_SYNC,
+    IO_OPEN,
+    IO_CLOSE,
+    IO_OP_COUNT,
+};
+
+constexpr auto op_names =
+    std::array<std::string_view, IO_OP_COUNT>{ "read", "write", "sync", "open", "close" };
+
+enum io_layer : uint8_t
+{
+    LAYER_POSIX = 0,
+    LAYER_MPI,
+    LAYER_COUNT,
+};
+
+constexpr auto layer_names = std::array<std::string_view, LAYER_COUNT>{ "posix", "mpi" };
+
+struct io_stats
+{
+    uint64_t                              ops       = 0;
+    uint64_t                              bytes     = 0;
+    uint64_t                              nsec      = 0;
+    std::array<uint64_t, histogram_bins> histogram = {};  // log2 of the latency in ns
+
+    void record(uint64_t _bytes, uint64_t _nsec)
+    {
+        ++ops;
+        bytes += _bytes;
+        nsec += _nsec;
+        auto _bin =
+            (_nsec == 0) ? size_t{ 0 } : static_cast<size_t>(63 - __builtin_clzll(_nsec));
+        ++histogram.at(std::min(_bin, histogram_bins - 1));
+    }
+
+    // the upper bound of the latency bin of the percentile in nanoseconds
+    uint64_t percentile(double _p) const
+    {
+        auto _target = static_cast<uint64_t>(std::ceil(_p * ops));
+        auto _sum    = uint64_t{ 0 };
+        for(size_t i = 0; i < histogram.size(); ++i)
+        {
+            _sum += histogram.at(i);
+            if(_sum >= _target && _sum > 0) return (2UL << i);
+        }
+        return 0;
+    }
+
+    // bytes per nanosecond == 1000 MB/s
+    double bandwidth() const
+    {
+        return (nsec == 0) ? 0.0 : 1.0e3 * static_cast<double>(bytes) / nsec;
+    }
+};
+
+struct callsite_stats
+{
+    uint64_t ops   = 0;
+    uint64_t bytes = 0;
+};
+
+struct file_stats
+{
+    io_layer                                      layer     = LAYER_POSIX;
+    uint64_t                                      opens     = 0;
+    std::string                                   path      = {};
+    std::array<io_stats, IO_OP_COUNT>             ops       = {};
+    std::unordered_map<uintptr_t, callsite_stats> callsites = {};
+
+    uint64_t nsec() const
+    {
+        uint64_t _v = 0;
+        for(const auto& itr : ops)
+            _v += itr.nsec;
+        return _v;
+    }
+};
+
+// the files are never removed so that the statistics of the closed files and the
+// paths in the perfetto annotations remain valid. The handles map the open file
+// descriptors and MPI files to their entry
+struct io_table
+{
+    using handle_map_t = std::unordered_map<uint64_t, size_t>;
+
+    std::mutex                             mutex   = {};
+    std::array<handle_map_t, LAYER_COUNT> handles = {};
+    std::deque<file_stats>                 files   = {};
+
+    // lock must be held
+    file_stats& emplace(io_layer _layer, uint64_t _handle, std::string _path)
+    {
+        handles.at(_layer)[_handle] = files.size();
+        return files.emplace_back(file_stats{ _layer, 0, std::move(_path), {}, {} });
+    }
+
+    // lock must be held. The file descriptors which were opened before the wrappers
+    // were active (or by fopen, which does not go through the wrappers) are resolved
+    // when they are first used
+    file_stats& get(io_layer _layer, uint64_t _handle)
+    {
+        auto& _handles = handles.at(_layer);
+        if(auto itr = _handles.find(_handle); itr != _handles.end())
+            return files.at(itr->second);
+
+        auto _path = (_layer == LAYER_POSIX) ? get_fd_path(static_cast<int>(_handle))
+                                             : JOIN("", "MPI_File 0x", std::hex, _handle);
+        return emplace(_layer, _handle, std::move(_path));
+    }
+
+    static std::string get_fd_path(int _fd)
+    {
+        char _buf[PATH_MAX];
+        auto _link = JOIN("", "/proc/self/fd/", _fd);
+        auto _len  = ::readlink(_link.c_str(), _buf, sizeof(_buf) - 1);
+        if(_len <= 0) return JOIN("", "fd ", _fd);
+        return std::string{ _buf, static_cast<size_t>(_len) };
+    }
+};
+
+struct io_region
+{
+    const char* name = nullptr;
+    uint64_t    beg  = 0;  // zero when the operation is not tracked
+};
+
+size_t callsite_interval = 0;
+
+auto&
+get_io_table()
+{
+    // intentionally leaked since the files may be closed after the static destructors
+    static auto* _v = new io_table{};
+    return *_v;
+}
+
+auto&
+get_io_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<io_gotcha_t>{};
+    return _v;
+}
+
+// the caller of every OMNITRACE_IO_CALLSITE_INTERVAL-th operation of the thread
+uintptr_t
+sample_callsite()
+{
+    static thread_local uint64_t _count = 0;
+    if(callsite_interval == 0 || (_count++ % callsite_interval) != 0) return 0;
+
+    for(auto itr : tim::get_unw_stack<8, 2, false>())
+    {
+        if(itr && !callsite::is_internal(itr->address())) return itr->address();
+    }
+    return 0;
+}
+
+// the I/O of omnitrace itself happens in the internal thread state or on the internal
+// threads so it is never tracked
+io_region
+begin_io(const char* _name)
+{
+    if(get_state() != ::omnitrace::State::Active ||
+       get_thread_state() != ThreadState::Enabled)
+        return io_region{};
+
+    category_region<category::io>::start(std::string_view{ _name });
+    return io_region{ _name, tracing::now() };
+}
+
+void
+end_io(const io_region& _region, io_op _op, io_layer _layer, uint64_t _handle,
+       int64_t _bytes, bool _success, const char* _open_path = nullptr)
+{
+    if(_region.beg == 0) return;
+
+    auto        _nsec = tracing::now() - _region.beg;
+    auto        _ip   = sample_callsite();
+    const char* _path = nullptr;
+    if(_success)
+    {
+        auto&                        _table = get_io_table();
+        std::unique_lock<std::mutex> _lk{ _table.mutex };
+
+        auto& _file =
+            (_op == IO_OPEN)
+                ? _table.emplace(_layer, _handle,
+                                 (_layer == LAYER_POSIX)
+                                     ? io_table::get_fd_path(static_cast<int>(_handle))
+                                     : std::string{ _open_path })
+                : _table.get(_layer, _handle);
+
+        auto _nbytes = static_cast<uint64_t>(std::max<int64_t>(_bytes, 0));
+        if(_op == IO_OPEN) ++_file.opens;
+        _file.ops.at(_op).record(_nbytes, _nsec);
+        if(_ip != 0)
+        {
+            auto& _callsite = _file.callsites[_ip];
+            ++_callsite.ops;
+            _callsite.bytes += _nbytes;
+        }
+        _path = _file.path.c_str();
+
+        if(_op == IO_CLOSE) _table.handles.at(_layer).erase(_handle);
+    }
+
+    if(_path)
+        category_region<category::io>::stop(std::string_view{ _region.name }, "path",
+                                            _path, "bytes", _bytes);
+    else
+        category_region<category::io>::stop(std::string_view{ _region.name }, "failed",
+                                            true);
+}
+
+#if defined(OMNITRACE_USE_MPI)
+uint64_t
+get_mpi_handle(MPI_File _fh)
+{
+    // MPI_File is a pointer in MPICH and OpenMPI
+    if constexpr(std::is_pointer<MPI_File>::value)
+        return reinterpret_cast<uintptr_t>(_fh);
+    else
+        return static_cast<uint64_t>(_fh);
+}
+
+int64_t
+get_mpi_bytes(int _count, MPI_Datatype _type)
+{
+    int _size = 0;
+    if(PMPI_Type_size(_type, &_size) != MPI_SUCCESS) return 0;
+    return static_cast<int64_t>(_count) * _size;
+}
+#endif
+
+std::string
+get_duration_label(uint64_t _nsec)
+{
+    return JOIN("", std::fixed, std::setprecision(1), _nsec / 1.0e3);
+}
+}  // namespace
+
+io_gotcha::io_gotcha(const gotcha_data_t& _data)
+: m_name{ _data.tool_id.c_str() }
+{
+    auto _has = [&_data](std::string_view _v) {
+        return _data.tool_id.find(_v) != std::string::npos;
+    };
+
+    if(_has("close"))
+        m_op = IO_CLOSE;
+    else if(_has("open"))
+        m_op = IO_OPEN;
+    else if(_has("sync"))
+        m_op = IO_SYNC;
+    else if(_has("read"))
+        m_op = IO_READ;
+    else
+        m_op = IO_WRITE;
+}
+
+void
+io_gotcha::configure()
+{
+    callsite_interval = config::get_io_callsite_interval();
+
+    io_gotcha_t::get_initializer() = []() {
+        io_gotcha_t::configure(
+            comp::gotcha_config<0, ssize_t, int, void*, size_t>{ "read" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<1, ssize_t, int, const void*, size_t>{ "write" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<2, ssize_t, int, void*, size_t, off_t>{ "pread" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<3, ssize_t, int, const void*, size_t, off_t>{ "pwrite" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<4, ssize_t, int, void*, size_t, off_t>{ "pread64" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<5, ssize_t, int, const void*, size_t, off_t>{
+                "pwrite64" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<6, ssize_t, int, const struct iovec*, int>{ "readv" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<7, ssize_t, int, const struct iovec*, int>{ "writev" });
+        // the mode of open is variadic but it is always passed in a register so the
+        // wrappers forward it unconditionally
+        io_gotcha_t::configure(
+            comp::gotcha_config<8, int, const char*, int, mode_t>{ "open" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<9, int, const char*, int, mode_t>{ "open64" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<10, int, int, const char*, int, mode_t>{ "openat" });
+        io_gotcha_t::configure(comp::gotcha_config<11, int, int>{ "close" });
+        io_gotcha_t::configure(comp::gotcha_config<12, int, int>{ "fsync" });
+        io_gotcha_t::configure(comp::gotcha_config<13, int, int>{ "fdatasync" });
+#if defined(OMNITRACE_USE_MPI)
+        io_gotcha_t::configure(
+            comp::gotcha_config<14, int, MPI_Comm, const char*, int, MPI_Info, MPI_File*>{
+                "MPI_File_open" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<15, int, MPI_File*>{ "MPI_File_close" });
+        io_gotcha_t::configure(comp::gotcha_config<16, int, MPI_File>{ "MPI_File_sync" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<17, int, MPI_File, void*, int, MPI_Datatype, MPI_Status*>{
+                "MPI_File_read" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<18, int, MPI_File, void*, int, MPI_Datatype, MPI_Status*>{
+                "MPI_File_read_all" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<19, int, MPI_File, const void*, int, MPI_Datatype,
+                                MPI_Status*>{ "MPI_File_write" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<20, int, MPI_File, const void*, int, MPI_Datatype,
+                                MPI_Status*>{ "MPI_File_write_all" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<21, int, MPI_File, MPI_Offset, void*, int, MPI_Datatype,
+                                MPI_Status*>{ "MPI_File_read_at" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<22, int, MPI_File, MPI_Offset, void*, int, MPI_Datatype,
+                                MPI_Status*>{ "MPI_File_read_at_all" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<23, int, MPI_File, MPI_Offset, const void*, int,
+                                MPI_Datatype, MPI_Status*>{ "MPI_File_write_at" });
+        io_gotcha_t::configure(
+            comp::gotcha_config<24, int, MPI_File, MPI_Offset, const void*, int,
+                                MPI_Datatype, MPI_Status*>{ "MPI_File_write_at_all" });
+#endif
+    };
+}
+
+void
+io_gotcha::shutdown()
+{
+    io_gotcha_t::disable();
+}
+
+void
+io_gotcha::start()
+{
+    if(!config::get_io_trace()) return;
+
+    if(!get_io_gotcha().get<io_gotcha_t>()->get_is_running())
+    {
+        configure();
+        get_io_gotcha().start();
+    }
+}
+
+void
+io_gotcha::stop()
+{
+    // the wrappers stay active until shutdown so that the closes are not missed
+}
+
+void
+io_gotcha::post_process()
+{
+    auto& _table = get_io_table();
+    auto  _files = std::vector<file_stats>{};
+    {
+        std::unique_lock<std::mutex> _lk{ _table.mutex };
+        for(const auto& itr : _table.files)
+        {
+            if(itr.nsec() > 0) _files.emplace_back(itr);
+        }
+    }
+
+    if(_files.empty()) return;
+
+    std::sort(_files.begin(), _files.end(),
+              [](const auto& _lhs, const auto& _rhs) {
+                  return _lhs.nsec() > _rhs.nsec();
+              });
+
+    auto _total = std::array<io_stats, IO_OP_COUNT>{};
+    for(const auto& fitr : _files)
+    {
+        for(size_t i = 0; i < IO_OP_COUNT; ++i)
+        {
+            _total.at(i).ops += fitr.ops.at(i).ops;
+            _total.at(i).bytes += fitr.ops.at(i).bytes;
+            _total.at(i).nsec += fitr.ops.at(i).nsec;
+        }
+    }
+
+    OMNITRACE_VERBOSE(0,
+                      "File I/O :: %zu files, %.3f MB read in %.3f sec (%.1f MB/s), %.3f "
+                      "MB written in %.3f sec (%.1f MB/s)\n",
+                      _files.size(),
+                      static_cast<double>(_total.at(IO_READ).bytes) / units::megabyte,
+                      _total.at(IO_READ).nsec / 1.0e9, _total.at(IO_READ).bandwidth(),
+                      static_cast<double>(_total.at(IO_WRITE).bytes) / units::megabyte,
+                      _total.at(IO_WRITE).nsec / 1.0e9, _total.at(IO_WRITE).bandwidth());
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    // resolving the call-sites is expensive so only the top files are reported
+    auto _ntop = config::get_io_trace_top();
+    if(_files.size() > _ntop) _files.resize(_ntop);
+
+    auto _fname = tim::settings::compose_output_filename("io-trace", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<io_gotcha>{}(_fname,
+                                                        std::string{ "io_trace" });
+
+        ofs << "# bandwidth in MB/s, latencies in microseconds (upper bound of the "
+               "log2 histogram bin)\n";
+        for(const auto& fitr : _files)
+        {
+            ofs << "\n" << fitr.path << " (" << layer_names.at(fitr.layer) << ", "
+                << fitr.opens << " opens)\n";
+            ofs << std::setw(10) << "op" << " " << std::setw(12) << "ops" << " "
+                << std::setw(16) << "bytes" << " " << std::setw(12) << "time [s]"
+                << " " << std::setw(12) << "bandwidth" << " " << std::setw(10) << "p50"
+                << " " << std::setw(10) << "p99" << "\n";
+            for(size_t i = 0; i < IO_OP_COUNT; ++i)
+            {
+                const auto& itr = fitr.ops.at(i);
+                if(itr.ops == 0) continue;
+                ofs << std::setw(10) << op_names.at(i) << " " << std::setw(12) << itr.ops
+                    << " " << std::setw(16) << itr.bytes << " " << std::setw(12)
+                    << std::fixed << std::setprecision(6) << (itr.nsec / 1.0e9) << " "
+                    << std::setw(12) << std::setprecision(1) << itr.bandwidth() << " "
+                    << std::setw(10) << get_duration_label(itr.percentile(0.5)) << " "
+                    << std::setw(10) << get_duration_label(itr.percentile(0.99)) << "\n";
+            }
+
+            auto _callsites = std::vector<std::pair<uintptr_t, callsite_stats>>{
+                fitr.callsites.begin(), fitr.callsites.end()
+            };
+            std::sort(_callsites.begin(), _callsites.end(),
+                      [](const auto& _lhs, const auto& _rhs) {
+                          return _lhs.second.ops > _rhs.second.ops;
+                      });
+            if(_callsites.size() > 5) _callsites.resize(5);
+            for(const auto& itr : _callsites)
+            {
+                ofs << std::setw(10) << "call-site" << " " << std::setw(12)
+                    << itr.second.ops << " " << std::setw(16) << itr.second.bytes
+                    << "   " << callsite::get_label(itr.first) << "\n";
+            }
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening I/O trace output file: %s", _fname.c_str());
+    }
+}
+
+// read
+ssize_t
+io_gotcha::operator()(ssize_t (*_callee)(int, void*, size_t), int _fd, void* _buf,
+                      size_t _n) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fd, _buf, _n);
+    end_io(_region, IO_READ, LAYER_POSIX, _fd, _ret, _ret >= 0);
+    return _ret;
+}
+
+// write
+ssize_t
+io_gotcha::operator()(ssize_t (*_callee)(int, const void*, size_t), int _fd,
+                      const void* _buf, size_t _n) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fd, _buf, _n);
+    end_io(_region, IO_WRITE, LAYER_POSIX, _fd, _ret, _ret >= 0);
+    return _ret;
+}
+
+// pread, pread64
+ssize_t
+io_gotcha::operator()(ssize_t (*_callee)(int, void*, size_t, off_t), int _fd,
+                      void* _buf, size_t _n, off_t _offset) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fd, _buf, _n, _offset);
+    end_io(_region, IO_READ, LAYER_POSIX, _fd, _ret, _ret >= 0);
+    return _ret;
+}
+
+// pwrite, pwrite64
+ssize_t
+io_gotcha::operator()(ssize_t (*_callee)(int, const void*, size_t, off_t), int _fd,
+                      const void* _buf, size_t _n, off_t _offset) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fd, _buf, _n, _offset);
+    end_io(_region, IO_WRITE, LAYER_POSIX, _fd, _ret, _ret >= 0);
+    return _ret;
+}
+
+// readv, writev
+ssize_t
+io_gotcha::operator()(ssize_t (*_callee)(int, const struct iovec*, int), int _fd,
+                      const struct iovec* _iov, int _iovcnt) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fd, _iov, _iovcnt);
+    end_io(_region, static_cast<io_op>(m_op), LAYER_POSIX, _fd, _ret, _ret >= 0);
+    return _ret;
+}
+
+// open, open64
+int
+io_gotcha::operator()(int (*_callee)(const char*, int, mode_t), const char* _path,
+                      int _flags, mode_t _mode) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_path, _flags, _mode);
+    end_io(_region, IO_OPEN, LAYER_POSIX, _ret, 0, _ret >= 0, _path);
+    return _ret;
+}
+
+// openat
+int
+io_gotcha::operator()(int (*_callee)(int, const char*, int, mode_t), int _dirfd,
+                      const char* _path, int _flags, mode_t _mode) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_dirfd, _path, _flags, _mode);
+    end_io(_region, IO_OPEN, LAYER_POSIX, _ret, 0, _ret >= 0, _path);
+    return _ret;
+}
+
+// close, fsync, fdatasync
+int
+io_gotcha::operator()(int (*_callee)(int), int _fd) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fd);
+    end_io(_region, static_cast<io_op>(m_op), LAYER_POSIX, _fd, 0, _ret == 0);
+    return _ret;
+}
+
+#if defined(OMNITRACE_USE_MPI)
+// MPI_File_open
+int
+io_gotcha::operator()(int (*_callee)(MPI_Comm, const char*, int, MPI_Info, MPI_File*),
+                      MPI_Comm _comm, const char* _path, int _amode, MPI_Info _info,
+                      MPI_File* _fh) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_comm, _path, _amode, _info, _fh);
+    auto _ok     = (_ret == MPI_SUCCESS && _fh);
+    end_io(_region, IO_OPEN, LAYER_MPI, (_ok) ? get_mpi_handle(*_fh) : 0, 0, _ok, _path);
+    return _ret;
+}
+
+// MPI_File_close
+int
+io_gotcha::operator()(int (*_callee)(MPI_File*), MPI_File* _fh) const
+{
+    // the handle is reset by the close
+    auto _handle = (_fh) ? get_mpi_handle(*_fh) : uint64_t{ 0 };
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fh);
+    end_io(_region, IO_CLOSE, LAYER_MPI, _handle, 0, _ret == MPI_SUCCESS && _fh);
+    return _ret;
+}
+
+// MPI_File_sync
+int
+io_gotcha::operator()(int (*_callee)(MPI_File), MPI_File _fh) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fh);
+    end_io(_region, IO_SYNC, LAYER_MPI, get_mpi_handle(_fh), 0, _ret == MPI_SUCCESS);
+    return _ret;
+}
+
+// MPI_File_read, MPI_File_read_all
+int
+io_gotcha::operator()(int (*_callee)(MPI_File, void*, int, MPI_Datatype, MPI_Status*),
+                      MPI_File _fh, void* _buf, int _count, MPI_Datatype _type,
+                      MPI_Status* _status) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fh, _buf, _count, _type, _status);
+    end_io(_region, IO_READ, LAYER_MPI, get_mpi_handle(_fh),
+           get_mpi_bytes(_count, _type), _ret == MPI_SUCCESS);
+    return _ret;
+}
+
+// MPI_File_write, MPI_File_write_all
+int
+io_gotcha::operator()(int (*_callee)(MPI_File, const void*, int, MPI_Datatype,
+                                     MPI_Status*),
+                      MPI_File _fh, const void* _buf, int _count, MPI_Datatype _type,
+                      MPI_Status* _status) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fh, _buf, _count, _type, _status);
+    end_io(_region, IO_WRITE, LAYER_MPI, get_mpi_handle(_fh),
+           get_mpi_bytes(_count, _type), _ret == MPI_SUCCESS);
+    return _ret;
+}
+
+// MPI_File_read_at, MPI_File_read_at_all
+int
+io_gotcha::operator()(int (*_callee)(MPI_File, MPI_Offset, void*, int, MPI_Datatype,
+                                     MPI_Status*),
+                      MPI_File _fh, MPI_Offset _offset, void* _buf, int _count,
+                      MPI_Datatype _type, MPI_Status* _status) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fh, _offset, _buf, _count, _type, _status);
+    end_io(_region, IO_READ, LAYER_MPI, get_mpi_handle(_fh),
+           get_mpi_bytes(_count, _type), _ret == MPI_SUCCESS);
+    return _ret;
+}
+
+// MPI_File_write_at, MPI_File_write_at_all
+int
+io_gotcha::operator()(int (*_callee)(MPI_File, MPI_Offset, const void*, int,
+                                     MPI_Datatype, MPI_Status*),
+                      MPI_File _fh, MPI_Offset _offset, const void* _buf, int _count,
+                      MPI_Datatype _type, MPI_Status* _status) const
+{
+    auto _region = begin_io(m_name);
+    auto _ret    = (*_callee)(_fh, _offset, _buf, _count, _type, _status);
+    end_io(_region, IO_WRITE, LAYER_MPI, get_mpi_handle(_fh),
+           get_mpi_bytes(_count, _type), _ret == MPI_SUCCESS);
+    return _ret;
+}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+namespace tim
+{
+namespace policy
+{
+template <size_t N>
+io_gotcha&
+static_data<io_gotcha, io_gotcha_t>::operator()(std::integral_constant<size_t, N>,
+                                                const component::gotcha_data& _data) const
+{
+    static auto _v = io_gotcha{ _data };
+    return _v;
+}
+}  // namespace policy
+}  // namespace tim
@@ -0,0 +1,151 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/mpl/macros.hpp>
+
+#if defined(OMNITRACE_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace omnitrace
+{
+namespace component
+{
+// wraps the POSIX file I/O functions and the MPI-IO functions. Every operation is a
+// region in the "io" category (perfetto slice and timemory entry) and is aggregated
+// per file: the number of operations, the bytes, the latency histogram and the
+// achieved bandwidth of the reads, writes, syncs, opens and closes, and the call-sites
+// of every OMNITRACE_IO_CALLSITE_INTERVAL-th operation of a thread
+struct io_gotcha : comp::base<io_gotcha, void>
+{
+#if defined(OMNITRACE_USE_MPI)
+    static constexpr size_t gotcha_capacity = 25;
+#else
+    static constexpr size_t gotcha_capacity = 14;
+#endif
+    using gotcha_data_t = comp::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(io_gotcha)
+
+    explicit io_gotcha(const gotcha_data_t&);
+
+    // string id for component
+    static std::string label() { return "io_gotcha"; }
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // writes the summary of every file
+    static void post_process();
+
+    // read
+    ssize_t operator()(ssize_t (*)(int, void*, size_t), int, void*, size_t) const;
+    // write
+    ssize_t operator()(ssize_t (*)(int, const void*, size_t), int, const void*,
+                       size_t) const;
+    // pread, pread64
+    ssize_t operator()(ssize_t (*)(int, void*, size_t, off_t), int, void*, size_t,
+                       off_t) const;
+    // pwrite, pwrite64
+    ssize_t operator()(ssize_t (*)(int, const void*, size_t, off_t), int, const void*,
+                       size_t, off_t) const;
+    // readv, writev
+    ssize_t operator()(ssize_t (*)(int, const struct iovec*, int), int,
+                       const struct iovec*, int) const;
+    // open, open64
+    int operator()(int (*)(const char*, int, mode_t), const char*, int, mode_t) const;
+    // openat
+    int operator()(int (*)(int, const char*, int, mode_t), int, const char*, int,
+                   mode_t) const;
+    // close, fsync, fdatasync
+    int operator()(int (*)(int), int) const;
+
+#if defined(OMNITRACE_USE_MPI)
+    // MPI_File_open
+    int operator()(int (*)(MPI_Comm, const char*, int, MPI_Info, MPI_File*), MPI_Comm,
+                   const char*, int, MPI_Info, MPI_File*) const;
+    // MPI_File_close
+    int operator()(int (*)(MPI_File*), MPI_File*) const;
+    // MPI_File_sync
+    int operator()(int (*)(MPI_File), MPI_File) const;
+    // MPI_File_read, MPI_File_read_all
+    int operator()(int (*)(MPI_File, void*, int, MPI_Datatype, MPI_Status*), MPI_File,
+                   void*, int, MPI_Datatype, MPI_Status*) const;
+    // MPI_File_write, MPI_File_write_all
+    int operator()(int (*)(MPI_File, const void*, int, MPI_Datatype, MPI_Status*),
+                   MPI_File, const void*, int, MPI_Datatype, MPI_Status*) const;
+    // MPI_File_read_at, MPI_File_read_at_all
+    int operator()(int (*)(MPI_File, MPI_Offset, void*, int, MPI_Datatype, MPI_Status*),
+                   MPI_File, MPI_Offset, void*, int, MPI_Datatype, MPI_Status*) const;
+    // MPI_File_write_at, MPI_File_write_at_all
+    int operator()(int (*)(MPI_File, MPI_Offset, const void*, int, MPI_Datatype,
+                           MPI_Status*),
+                   MPI_File, MPI_Offset, const void*, int, MPI_Datatype,
+                   MPI_Status*) const;
+#endif
+
+private:
+    const char* m_name = nullptr;
+    uint8_t     m_op   = 0;  // read, write, sync, open or close
+};
+
+using io_gotcha_t = comp::gotcha<io_gotcha::gotcha_capacity, std::tuple<>, io_gotcha>;
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_DEFINE_CONCRETE_TRAIT(static_data, component::io_gotcha_t, true_type)
+
+namespace tim
+{
+namespace policy
+{
+using io_gotcha   = ::omnitrace::component::io_gotcha;
+using io_gotcha_t = ::omnitrace::component::io_gotcha_t;
+
+template <>
+struct static_data<io_gotcha, io_gotcha_t> : std::true_type
+{
+    template <size_t N>
+    io_gotcha& operator()(std::integral_constant<size_t, N>,
+                          const component::gotcha_data& _data) const;
+};
+}  // namespace policy
+}  // namespace tim
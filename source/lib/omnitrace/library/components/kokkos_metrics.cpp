@@ -0,0 +1,598 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/kokkos_metrics.hpp"
+#include "core/config.hpp"
+#include "core/containers/address_table.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/types.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace kokkos_metrics
+{
+namespace
+{
+using space_pair_t = std::pair<std::string, std::string>;  // { src, dst }
+using exec_space_t = std::pair<uint32_t, uint32_t>;        // { type, device }
+
+struct registry
+{
+    std::mutex                     mutex       = {};
+    std::map<space_pair_t, size_t> deep_copies = {};
+    std::map<exec_space_t, size_t> fences      = {};
+    std::vector<std::string>       copy_names  = {};  // timemory entry of deep copies
+    std::vector<std::string>       fence_names = {};  // timemory entry of fences
+    std::vector<uint64_t>          fence_wait  = {};  // cumulative nanoseconds
+};
+
+auto&
+get_registry()
+{
+    static auto* _v = new registry{};
+    return *_v;
+}
+
+// deep copy started on this thread
+struct deep_copy
+{
+    size_t   index = 0;
+    uint64_t bytes = 0;
+    uint64_t beg   = 0;
+};
+
+auto&
+get_deep_copies()
+{
+    static thread_local auto _v = std::vector<deep_copy>{};
+    return _v;
+}
+
+auto
+get_timestamp()
+{
+    return tim::get_clock_real_now<uint64_t, std::nano>();
+}
+
+// the device ids provided by Kokkos >= 3.7 are the type of the execution space in
+// the upper 8 bits, the device in the next 7 bits, and the instance in the lower 17
+exec_space_t
+get_exec_space(uint32_t _devid)
+{
+    return { (_devid >> 24), ((_devid >> 17) & 0x7f) };
+}
+
+const char*
+get_exec_space_name(uint32_t _type)
+{
+    constexpr auto _names = std::array<const char*, 9>{
+        "Serial", "OpenMP", "Cuda", "HIP", "OpenMPTarget",
+        "HPX",    "Threads", "SYCL", "OpenACC"
+    };
+    return (_type < _names.size()) ? _names.at(_type) : "Unknown";
+}
+
+// lock must be held
+size_t
+get_deep_copy_index(registry& _data, const char* _src, const char* _dst)
+{
+    auto _key = space_pair_t{ _src, _dst };
+    auto itr  = _data.deep_copies.find(_key);
+    if(itr != _data.deep_copies.end()) return itr->second;
+
+    auto _idx  = _data.deep_copies.size();
+    auto _name = JOIN(" ", _src, "->", _dst);
+    _data.deep_copies.emplace(_key, _idx);
+
+    if(get_use_perfetto())
+    {
+        using counter_track = perfetto_counter_track<kokkos_deep_copy_bandwidth>;
+        auto _lbl           = JOIN("", '[', _name, ']');
+        counter_track::emplace(_idx, JOIN(" ", "Kokkos Deep Copy", _lbl), "bytes");
+        counter_track::emplace(_idx, JOIN(" ", "Kokkos Deep Copy Bandwidth", _lbl),
+                               "GB/s");
+    }
+    _data.copy_names.emplace_back(std::move(_name));
+    return _idx;
+}
+
+// lock must be held
+size_t
+get_fence_index(registry& _data, uint32_t _devid)
+{
+    auto _key = get_exec_space(_devid);
+    auto itr  = _data.fences.find(_key);
+    if(itr != _data.fences.end()) return itr->second;
+
+    auto _idx  = _data.fences.size();
+    auto _name = JOIN("", get_exec_space_name(_key.first), " [dev", _key.second, ']');
+    _data.fences.emplace(_key, _idx);
+    _data.fence_wait.emplace_back(0);
+
+    if(get_use_perfetto())
+    {
+        using counter_track = perfetto_counter_track<kokkos_fence_wait>;
+        counter_track::emplace(_idx, JOIN(" ", "Kokkos Fence Wait", _name), "sec");
+    }
+    _data.fence_names.emplace_back(std::move(_name));
+    return _idx;
+}
+
+// allocations with one label in one memory space
+struct label_stats
+{
+    std::string label      = {};
+    uint64_t    allocs     = 0;
+    uint64_t    frees      = 0;
+    uint64_t    bytes      = 0;
+    int64_t     live_bytes = 0;
+    int64_t     peak_bytes = 0;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("label", label), cereal::make_nvp("allocs", allocs),
+           cereal::make_nvp("frees", frees), cereal::make_nvp("bytes", bytes),
+           cereal::make_nvp("live_bytes", live_bytes),
+           cereal::make_nvp("peak_bytes", peak_bytes));
+    }
+};
+
+struct space_stats
+{
+    std::string name        = {};
+    int64_t     live_bytes  = 0;
+    int64_t     peak_bytes  = 0;
+    uint64_t    peak_ts     = 0;
+    uint64_t    live_count  = 0;
+    uint64_t    peak_count  = 0;
+    uint64_t    allocs      = 0;
+    uint64_t    frees       = 0;
+    uint64_t    total_bytes = 0;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("space", name), cereal::make_nvp("allocs", allocs),
+           cereal::make_nvp("frees", frees), cereal::make_nvp("total_bytes", total_bytes),
+           cereal::make_nvp("peak_bytes", peak_bytes),
+           cereal::make_nvp("peak_ts", peak_ts),
+           cereal::make_nvp("peak_count", peak_count),
+           cereal::make_nvp("live_bytes", live_bytes),
+           cereal::make_nvp("live_count", live_count));
+    }
+};
+
+// live allocation in the address table of a memory space
+struct allocation
+{
+    uint64_t bytes = 0;
+    uint32_t label = 0;
+};
+
+// each memory space has its own table of live allocations so the tables stay small
+// for the spaces with few allocations
+struct memory_space
+{
+    space_stats                               stats       = {};
+    container::address_table<allocation, 64>  live        = {};
+    std::vector<label_stats>                  labels      = {};
+    std::unordered_map<std::string, uint32_t> label_index = {};
+};
+
+struct space_report
+{
+    space_stats              data   = {};
+    std::vector<label_stats> labels = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned _version)
+    {
+        namespace cereal = tim::cereal;
+        data.serialize(ar, _version);
+        ar(cereal::make_nvp("labels", labels));
+    }
+};
+
+struct memory_tracker
+{
+    std::mutex                                   mutex       = {};
+    std::deque<memory_space>                     spaces      = {};
+    std::unordered_map<std::string_view, size_t> space_index = {};
+};
+
+auto&
+get_memory_tracker()
+{
+    static auto* _v = new memory_tracker{};
+    return *_v;
+}
+
+// lock must be held
+size_t
+get_memory_space(memory_tracker& _data, const char* _space)
+{
+    auto itr = _data.space_index.find(_space);
+    if(itr != _data.space_index.end()) return itr->second;
+
+    auto  _idx        = _data.spaces.size();
+    auto& _value      = _data.spaces.emplace_back();
+    _value.stats.name = _space;
+    // the names in the deque have stable addresses
+    _data.space_index.emplace(_value.stats.name, _idx);
+
+    if(get_use_perfetto())
+    {
+        using counter_track = perfetto_counter_track<memory_space>;
+        auto _lbl = JOIN(" ", "Kokkos Memory Allocated", JOIN("", '[', _space, ']'));
+        counter_track::emplace(_idx, _lbl, "bytes");
+        counter_track::emplace(_idx, JOIN(" ", _lbl, "(count)"), "");
+    }
+    return _idx;
+}
+
+// lock must be held
+uint32_t
+get_label(memory_space& _space, const char* _label)
+{
+    auto _name = std::string{ (_label && strlen(_label) > 0) ? _label : "<unnamed>" };
+    auto itr   = _space.label_index.find(_name);
+    if(itr != _space.label_index.end()) return itr->second;
+
+    auto _idx = static_cast<uint32_t>(_space.labels.size());
+    _space.labels.emplace_back(label_stats{ _name });
+    _space.label_index.emplace(std::move(_name), _idx);
+    return _idx;
+}
+
+// lock must be held
+void
+emit_memory_space(const space_stats& _stats, size_t _idx, uint64_t _ts)
+{
+    if(!get_use_perfetto()) return;
+
+    using counter_track = perfetto_counter_track<memory_space>;
+    TRACE_COUNTER("kokkos", counter_track::at(_idx, 0), _ts, _stats.live_bytes);
+    TRACE_COUNTER("kokkos", counter_track::at(_idx, 1), _ts, _stats.live_count);
+}
+}  // namespace
+
+void
+setup()
+{
+    kokkos_deep_copy_bytes_data::label()        = "kokkos_deep_copy_bytes";
+    kokkos_deep_copy_bytes_data::description()  = "Bytes per Kokkos deep copy";
+    kokkos_deep_copy_bytes_data::display_unit() = "bytes";
+
+    kokkos_deep_copy_bandwidth_data::label()        = "kokkos_deep_copy_bandwidth";
+    kokkos_deep_copy_bandwidth_data::description()  = "Kokkos deep copy bandwidth";
+    kokkos_deep_copy_bandwidth_data::display_unit() = "GB/s";
+
+    kokkos_fence_wait_data::label()       = "kokkos_fence_wait";
+    kokkos_fence_wait_data::description() = "Wait time in Kokkos fences";
+
+    auto _enabled = get_use_timemory();
+    trait::runtime_enabled<kokkos_deep_copy_bytes_data>::set(_enabled);
+    trait::runtime_enabled<kokkos_deep_copy_bandwidth_data>::set(_enabled);
+    trait::runtime_enabled<kokkos_fence_wait_data>::set(_enabled);
+}
+
+void
+begin_deep_copy(const char* _dst_space, const char* _src_space, uint64_t _bytes)
+{
+    auto& _data = get_registry();
+    auto  _idx  = size_t{ 0 };
+    {
+        std::unique_lock<std::mutex> _lk{ _data.mutex };
+        _idx = get_deep_copy_index(_data, _src_space, _dst_space);
+    }
+    get_deep_copies().emplace_back(deep_copy{ _idx, _bytes, get_timestamp() });
+}
+
+void
+end_deep_copy()
+{
+    auto& _copies = get_deep_copies();
+    if(_copies.empty()) return;
+
+    auto _end  = get_timestamp();
+    auto _copy = _copies.back();
+    _copies.pop_back();
+
+    if(_end <= _copy.beg) return;
+
+    auto _bytes = static_cast<double>(_copy.bytes);
+    auto _sec   = static_cast<double>(_end - _copy.beg) / units::sec;
+    auto _bw    = (_bytes / _sec) / units::gigabyte;
+
+    auto& _data = get_registry();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    if(get_use_perfetto())
+    {
+        using counter_track = perfetto_counter_track<kokkos_deep_copy_bandwidth>;
+        TRACE_COUNTER("kokkos", counter_track::at(_copy.index, 0), _copy.beg, _bytes);
+        TRACE_COUNTER("kokkos", counter_track::at(_copy.index, 1), _copy.beg, _bw);
+        TRACE_COUNTER("kokkos", counter_track::at(_copy.index, 0), _end, 0.0);
+        TRACE_COUNTER("kokkos", counter_track::at(_copy.index, 1), _end, 0.0);
+    }
+
+    if(get_use_timemory() &&
+       trait::runtime_enabled<kokkos_deep_copy_bandwidth_data>::get())
+    {
+        auto _name = _data.copy_names.at(_copy.index);
+        _lk.unlock();
+        // the deep copy region is still open so the entries are nested in it
+        tim::auto_tuple<kokkos_deep_copy_bytes_data>{ _name }.store(std::plus<double>{},
+                                                                    _bytes);
+        tim::auto_tuple<kokkos_deep_copy_bandwidth_data>{ _name }.store(
+            std::plus<double>{}, _bw);
+    }
+}
+
+void
+record_fence(uint32_t _devid, uint64_t _beg_ns, uint64_t _end_ns)
+{
+    if(_end_ns <= _beg_ns) return;
+
+    auto  _wait = _end_ns - _beg_ns;
+    auto& _data = get_registry();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    auto  _idx  = get_fence_index(_data, _devid);
+    auto  _sum  = (_data.fence_wait.at(_idx) += _wait);
+
+    if(get_use_perfetto())
+    {
+        using counter_track = perfetto_counter_track<kokkos_fence_wait>;
+        TRACE_COUNTER("kokkos", counter_track::at(_idx, 0), _end_ns,
+                      static_cast<double>(_sum) / units::sec);
+    }
+
+    if(get_use_timemory() && trait::runtime_enabled<kokkos_fence_wait_data>::get())
+    {
+        auto _name = _data.fence_names.at(_idx);
+        _lk.unlock();
+        // the fence region is still open so the entry is nested in it
+        tim::auto_tuple<kokkos_fence_wait_data>{ _name }.store(
+            std::plus<double>{}, static_cast<double>(_wait));
+    }
+}
+
+void
+allocate_data(const char* _space, const char* _label, const void* _ptr,
+              uint64_t _bytes)
+{
+    if(_ptr == nullptr) return;
+
+    auto  _ts   = get_timestamp();
+    auto& _data = get_memory_tracker();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    auto  _idx   = get_memory_space(_data, _space);
+    auto& _value = _data.spaces.at(_idx);
+    auto  _lbl   = get_label(_value, _label);
+    auto& _stats = _value.stats;
+
+    auto _prev =
+        _value.live.insert(reinterpret_cast<uintptr_t>(_ptr), allocation{ _bytes, _lbl });
+
+    // the address was handed out again without a recorded release
+    if(_prev)
+    {
+        _stats.live_bytes -= static_cast<int64_t>(_prev->bytes);
+        _stats.live_count -= 1;
+        _value.labels.at(_prev->label).live_bytes -= static_cast<int64_t>(_prev->bytes);
+    }
+
+    auto& _label_stats = _value.labels.at(_lbl);
+    _label_stats.allocs += 1;
+    _label_stats.bytes += _bytes;
+    _label_stats.live_bytes += static_cast<int64_t>(_bytes);
+    _label_stats.peak_bytes = std::max(_label_stats.peak_bytes, _label_stats.live_bytes);
+
+    _stats.allocs += 1;
+    _stats.total_bytes += _bytes;
+    _stats.live_bytes += static_cast<int64_t>(_bytes);
+    _stats.live_count += 1;
+    _stats.peak_count = std::max(_stats.peak_count, _stats.live_count);
+    if(_stats.live_bytes > _stats.peak_bytes)
+    {
+        _stats.peak_bytes = _stats.live_bytes;
+        _stats.peak_ts    = _ts;
+    }
+
+    emit_memory_space(_stats, _idx, _ts);
+}
+
+void
+deallocate_data(const char* _space, const void* _ptr)
+{
+    if(_ptr == nullptr) return;
+
+    auto  _ts   = get_timestamp();
+    auto& _data = get_memory_tracker();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+
+    auto  _idx   = get_memory_space(_data, _space);
+    auto& _value = _data.spaces.at(_idx);
+    auto  _prev  = _value.live.erase(reinterpret_cast<uintptr_t>(_ptr));
+    if(!_prev) return;
+
+    auto& _stats       = _value.stats;
+    auto& _label_stats = _value.labels.at(_prev->label);
+
+    _stats.frees += 1;
+    _stats.live_bytes -= static_cast<int64_t>(_prev->bytes);
+    _stats.live_count -= 1;
+    _label_stats.frees += 1;
+    _label_stats.live_bytes -= static_cast<int64_t>(_prev->bytes);
+
+    emit_memory_space(_stats, _idx, _ts);
+}
+
+void
+post_process()
+{
+    auto& _data    = get_memory_tracker();
+    auto  _reports = std::vector<space_report>{};
+    auto  _ntop =
+        config::get_setting_value<int64_t>("OMNITRACE_KOKKOSP_MEMORY_TOP").value_or(10);
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _data.mutex };
+        for(const auto& itr : _data.spaces)
+            _reports.emplace_back(space_report{ itr.stats, itr.labels });
+    }
+
+    if(_reports.empty()) return;
+
+    // the labels of each memory space with the most bytes allocated
+    for(auto& itr : _reports)
+    {
+        std::sort(itr.labels.begin(), itr.labels.end(),
+                  [](const label_stats& _lhs, const label_stats& _rhs) {
+                      return std::tie(_lhs.bytes, _lhs.allocs) >
+                             std::tie(_rhs.bytes, _rhs.allocs);
+                  });
+        if(_ntop >= 0 && itr.labels.size() > static_cast<size_t>(_ntop))
+            itr.labels.resize(_ntop);
+    }
+
+    auto _mib = [](auto _v) { return static_cast<double>(_v) / units::MiB; };
+
+    for(const auto& ritr : _reports)
+    {
+        const auto& itr = ritr.data;
+        OMNITRACE_VERBOSE(0,
+                          "Kokkos memory :: %s :: %lu allocations, %lu releases, peak "
+                          "%.3f MiB, %.3f MiB (%lu allocations) live at finalization\n",
+                          itr.name.c_str(), itr.allocs, itr.frees, _mib(itr.peak_bytes),
+                          _mib(itr.live_bytes), itr.live_count);
+    }
+
+    auto _get_setting = [](const std::string& _v) {
+        return config::get_setting_value<bool>(_v).value_or(true);
+    };
+
+    if(_get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        auto _fname = tim::settings::compose_output_filename("kokkos-memory", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<space_report>{}(
+                    _fname, std::string{ "kokkos_memory" });
+
+            ofs << std::fixed << std::setprecision(3);
+            for(const auto& ritr : _reports)
+            {
+                const auto& itr = ritr.data;
+                ofs << itr.name << " memory space\n"
+                    << "    allocations           : " << itr.allocs << "\n"
+                    << "    releases              : " << itr.frees << "\n"
+                    << "    allocated       [MiB] : " << _mib(itr.total_bytes) << "\n"
+                    << "    peak            [MiB] : " << _mib(itr.peak_bytes) << "\n"
+                    << "    peak allocations      : " << itr.peak_count << "\n"
+                    << "    live at end     [MiB] : " << _mib(itr.live_bytes) << "\n"
+                    << "    live allocations      : " << itr.live_count << "\n";
+                if(ritr.labels.empty()) continue;
+                ofs << "    labels                :\n";
+                for(const auto& litr : ritr.labels)
+                {
+                    ofs << "        " << std::setw(8) << litr.allocs << " allocs, "
+                        << std::setw(8) << litr.frees << " releases, " << std::setw(12)
+                        << _mib(litr.bytes) << " MiB, " << std::setw(12)
+                        << _mib(litr.peak_bytes) << " MiB peak :: " << litr.label
+                        << "\n";
+                }
+            }
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening Kokkos memory output file: %s",
+                            _fname.c_str());
+        }
+    }
+
+    if(_get_setting("OMNITRACE_JSON_OUTPUT"))
+    {
+        std::stringstream oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+            ar->setNextName("omnitrace");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("kokkos_memory", _reports));
+            ar->finishNode();
+        }
+        auto _fname = tim::settings::compose_output_filename("kokkos-memory", ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<space_report>{}(
+                    _fname, std::string{ "kokkos_memory" });
+            ofs << oss.str() << "\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening Kokkos memory output file: %s",
+                            _fname.c_str());
+        }
+    }
+}
+}  // namespace kokkos_metrics
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(kokkos_deep_copy_bytes_data, true, double)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(kokkos_deep_copy_bandwidth_data, true, double)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(kokkos_fence_wait_data, true, double)
@@ -0,0 +1,141 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/macros.hpp>
+
+#include <cstdint>
+#include <string>
+
+OMNITRACE_DECLARE_COMPONENT(kokkos_deep_copy_bytes)
+OMNITRACE_DECLARE_COMPONENT(kokkos_deep_copy_bandwidth)
+OMNITRACE_DECLARE_COMPONENT(kokkos_fence_wait)
+
+namespace omnitrace
+{
+namespace component
+{
+// derived metrics of the Kokkos Tools deep copy and fence callbacks: the bytes and the
+// achieved bandwidth of every deep copy per (source space, destination space) pair and
+// the cumulative time spent in the fences of each execution space. These are emitted
+// as perfetto counter tracks and as timemory data trackers nested in the region of
+// the deep copy or the fence. The live bytes of the allocations in each memory space
+// are tracked from the allocate and deallocate callbacks
+struct kokkos_deep_copy_bytes : base<kokkos_deep_copy_bytes, void>
+{
+    static std::string label() { return "kokkos_deep_copy_bytes"; }
+    static std::string description() { return "Bytes per Kokkos deep copy"; }
+};
+
+struct kokkos_deep_copy_bandwidth : base<kokkos_deep_copy_bandwidth, void>
+{
+    static std::string label() { return "kokkos_deep_copy_bandwidth"; }
+    static std::string description()
+    {
+        return "Achieved bandwidth of Kokkos deep copies";
+    }
+};
+
+struct kokkos_fence_wait : base<kokkos_fence_wait, void>
+{
+    static std::string label() { return "kokkos_fence_wait"; }
+    static std::string description() { return "Wait time in Kokkos fences"; }
+};
+
+namespace kokkos_metrics
+{
+// sets the labels and units of the data trackers
+void
+setup();
+
+// invoked by kokkosp_begin_deep_copy and kokkosp_end_deep_copy. Deep copies are
+// blocking so the begin and end are on the same thread
+void
+begin_deep_copy(const char* _dst_space, const char* _src_space, uint64_t _bytes);
+
+void
+end_deep_copy();
+
+// invoked by kokkosp_end_fence with the device id provided by Kokkos, which encodes
+// the type of the execution space and the device
+void
+record_fence(uint32_t _devid, uint64_t _beg_ns, uint64_t _end_ns);
+
+// invoked by kokkosp_allocate_data and kokkosp_deallocate_data. Emits the live bytes
+// of the memory space as a perfetto counter. Releases of addresses which were
+// allocated before the tracking started are ignored
+void
+allocate_data(const char* _space, const char* _label, const void* _ptr,
+              uint64_t _bytes);
+
+void
+deallocate_data(const char* _space, const void* _ptr);
+
+// reports the peak and live bytes of each memory space and the labels with the most
+// bytes allocated in each memory space
+void
+post_process();
+}  // namespace kokkos_metrics
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_COMPONENT_ALIAS(kokkos_deep_copy_bytes_data,
+                          ::tim::component::data_tracker<double, kokkos_deep_copy_bytes>)
+OMNITRACE_COMPONENT_ALIAS(
+    kokkos_deep_copy_bandwidth_data,
+    ::tim::component::data_tracker<double, kokkos_deep_copy_bandwidth>)
+OMNITRACE_COMPONENT_ALIAS(kokkos_fence_wait_data,
+                          ::tim::component::data_tracker<double, kokkos_fence_wait>)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::kokkos_deep_copy_bytes_data,
+                           project::omnitrace, os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::kokkos_deep_copy_bandwidth_data,
+                           project::omnitrace, os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::kokkos_fence_wait_data,
+                           project::omnitrace, category::timing, os::supports_unix)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::kokkos_deep_copy_bytes_data, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::kokkos_deep_copy_bandwidth_data, double)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::kokkos_deep_copy_bandwidth_data,
+                                false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::kokkos_fence_wait_data,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::kokkos_fence_wait_data,
+                                true_type)
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(kokkos_deep_copy_bytes_data, true, double)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(kokkos_deep_copy_bandwidth_data, true, double)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(kokkos_fence_wait_data, true, double)
+
+#endif
@@ -0,0 +1,696 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/memory_access.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/utility.hpp"
+#include "library/callsite.hpp"
+#include "library/thread_data.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/types.hpp>
+
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <linux/perf_event.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+constexpr size_t    callsite_depth        = 16;
+constexpr size_t    callsite_ignore_depth = 2;
+constexpr uintptr_t cache_line_size       = 64;
+
+// the object of a sample which was not resolved in the signal handler
+constexpr int64_t unresolved_object = -2;
+
+using callsite_frames_t = std::array<uintptr_t, callsite_depth>;
+
+// set while the thread is in a wrapper or records a sample so that the allocations of
+// the bookkeeping are never tracked. Static TLS since malloc is invoked before the
+// dynamic TLS of the thread is allocated
+__thread bool in_wrapper __attribute__((tls_model("initial-exec"))) = false;
+
+struct wrapper_guard
+{
+    wrapper_guard()
+    : m_prev{ in_wrapper }
+    {
+        in_wrapper = true;
+    }
+    ~wrapper_guard() { in_wrapper = m_prev; }
+
+    wrapper_guard(const wrapper_guard&) = delete;
+    wrapper_guard& operator=(const wrapper_guard&) = delete;
+
+private:
+    bool m_prev = false;
+};
+
+struct allocation
+{
+    uintptr_t         addr   = 0;
+    size_t            size   = 0;
+    bool              live   = true;
+    callsite_frames_t frames = {};  // call stack of the allocation
+};
+
+// the tracked heap allocations in the order of allocation. The live allocations are
+// indexed by address and the bounds of the live addresses let free skip the lock for
+// the small allocations, which are never tracked
+struct heap_table
+{
+    std::mutex                  mutex   = {};
+    std::map<uintptr_t, size_t> live    = {};  // address -> index in the history
+    std::vector<allocation>     history = {};
+    std::atomic<size_t>         nlive   = 0;
+    std::atomic<uintptr_t>      lo      = std::numeric_limits<uintptr_t>::max();
+    std::atomic<uintptr_t>      hi      = 0;
+
+    // lock must be held
+    int64_t find(uintptr_t _addr) const
+    {
+        auto itr = live.upper_bound(_addr);
+        if(itr == live.begin()) return -1;
+        --itr;
+        const auto& _alloc = history.at(itr->second);
+        return (_addr < _alloc.addr + _alloc.size) ? static_cast<int64_t>(itr->second)
+                                                   : -1;
+    }
+
+    // the most recent allocation which contained the address. Only used after the
+    // sampling is stopped
+    int64_t find_any(uintptr_t _addr) const
+    {
+        for(size_t i = history.size(); i > 0; --i)
+        {
+            const auto& itr = history.at(i - 1);
+            if(_addr >= itr.addr && _addr < itr.addr + itr.size)
+                return static_cast<int64_t>(i - 1);
+        }
+        return -1;
+    }
+};
+
+struct access_sample
+{
+    uintptr_t ip       = 0;
+    uintptr_t addr     = 0;
+    uint64_t  weight   = 0;
+    uint64_t  data_src = 0;
+    int64_t   object   = unresolved_object;  // index of the heap allocation
+};
+
+struct access_table
+{
+    std::vector<access_sample> samples = {};
+};
+
+using access_data_t = thread_data<access_table, category::sampling>;
+
+// the allocations below this size are not tracked
+size_t min_alloc_size = std::numeric_limits<size_t>::max();
+
+enum access_level : uint8_t
+{
+    LEVEL_L1 = 0,
+    LEVEL_LFB,
+    LEVEL_L2,
+    LEVEL_L3,
+    LEVEL_RAM,
+    LEVEL_REMOTE,
+    LEVEL_OTHER,
+    LEVEL_COUNT,
+};
+
+constexpr auto level_names = std::array<std::string_view, LEVEL_COUNT>{
+    "L1", "LFB", "L2", "L3", "RAM", "remote", "other"
+};
+
+access_level
+get_access_level(uint64_t _data_src)
+{
+    auto _src = perf_mem_data_src{};
+    _src.val  = _data_src;
+
+    auto _lvl = _src.mem_lvl;
+    if(_lvl & PERF_MEM_LVL_L1) return LEVEL_L1;
+    if(_lvl & PERF_MEM_LVL_LFB) return LEVEL_LFB;
+    if(_lvl & PERF_MEM_LVL_L2) return LEVEL_L2;
+    if(_lvl & PERF_MEM_LVL_L3) return LEVEL_L3;
+    if(_lvl & PERF_MEM_LVL_LOC_RAM) return LEVEL_RAM;
+    if(_lvl & (PERF_MEM_LVL_REM_RAM1 | PERF_MEM_LVL_REM_RAM2 | PERF_MEM_LVL_REM_CCE1 |
+               PERF_MEM_LVL_REM_CCE2))
+        return LEVEL_REMOTE;
+    return LEVEL_OTHER;
+}
+
+struct access_stats
+{
+    uint64_t                                samples    = 0;
+    uint64_t                                weight     = 0;
+    uint64_t                                max_weight = 0;
+    std::array<uint64_t, LEVEL_COUNT>       levels     = {};
+    std::unordered_map<uintptr_t, uint64_t> lines      = {};  // cache line -> samples
+
+    void record(const access_sample& _v, uintptr_t _line)
+    {
+        ++samples;
+        weight += _v.weight;
+        max_weight = std::max(max_weight, _v.weight);
+        ++levels.at(get_access_level(_v.data_src));
+        ++lines[_line];
+    }
+
+    access_stats& operator+=(const access_stats& _v)
+    {
+        samples += _v.samples;
+        weight += _v.weight;
+        max_weight = std::max(max_weight, _v.max_weight);
+        for(size_t i = 0; i < levels.size(); ++i)
+            levels.at(i) += _v.levels.at(i);
+        for(const auto& itr : _v.lines)
+            lines[itr.first] += itr.second;
+        return *this;
+    }
+
+    uintptr_t hottest_line() const
+    {
+        auto _v = std::pair<uintptr_t, uint64_t>{ 0, 0 };
+        for(const auto& itr : lines)
+            if(itr.second > _v.second) _v = itr;
+        return _v.first;
+    }
+};
+
+// a global variable in the dynamic symbol table
+struct data_symbol
+{
+    uintptr_t   addr = 0;
+    size_t      size = 0;
+    std::string name = {};
+};
+
+auto&
+get_heap_table()
+{
+    // intentionally leaked since free may be invoked after the static destructors
+    static auto* _v = new heap_table{};
+    return *_v;
+}
+
+auto&
+get_access_table(int64_t _tid)
+{
+    return access_data_t::instance(construct_on_thread{ _tid });
+}
+
+auto&
+get_memory_access_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<memory_access_gotcha_t>{};
+    return _v;
+}
+
+callsite_frames_t
+get_callsite_frames()
+{
+    auto   _frames = callsite_frames_t{};
+    auto   _stack  = tim::get_unw_stack<callsite_depth, callsite_ignore_depth, false>();
+    size_t _n      = 0;
+    for(auto itr : _stack)
+    {
+        if(itr && _n < _frames.size()) _frames.at(_n++) = itr->address();
+    }
+    return _frames;
+}
+
+// only the symbols in the dynamic symbol tables are found, i.e. the globals of the
+// executable require -rdynamic
+bool
+lookup_global(uintptr_t _addr, data_symbol& _v)
+{
+    auto             _info = Dl_info{};
+    const ElfW(Sym)* _sym  = nullptr;
+    if(dladdr1(reinterpret_cast<void*>(_addr), &_info, reinterpret_cast<void**>(&_sym),
+               RTLD_DL_SYMENT) == 0 ||
+       !_sym || !_info.dli_saddr || !_info.dli_sname)
+        return false;
+
+    if(ELFW(ST_TYPE)(_sym->st_info) != STT_OBJECT) return false;
+
+    auto _beg = reinterpret_cast<uintptr_t>(_info.dli_saddr);
+    if(_addr < _beg || _addr >= _beg + _sym->st_size) return false;
+
+    _v = data_symbol{ _beg, _sym->st_size, demangle(_info.dli_sname) };
+    return true;
+}
+
+void
+record_allocation(void* _ptr, size_t _size)
+{
+    if(!_ptr || _size < min_alloc_size || in_wrapper) return;
+    if(get_state() != ::omnitrace::State::Active ||
+       get_thread_state() != ThreadState::Enabled)
+        return;
+
+    auto _guard = wrapper_guard{};
+    auto _addr  = reinterpret_cast<uintptr_t>(_ptr);
+    auto _alloc = allocation{ _addr, _size, true, get_callsite_frames() };
+
+    auto&                        _heap = get_heap_table();
+    std::unique_lock<std::mutex> _lk{ _heap.mutex };
+    // the previous allocation at this address was released before the tracking
+    if(auto itr = _heap.live.find(_addr); itr != _heap.live.end())
+        _heap.history.at(itr->second).live = false;
+    _heap.live[_addr] = _heap.history.size();
+    _heap.history.emplace_back(_alloc);
+    _heap.nlive = _heap.live.size();
+    if(_addr < _heap.lo) _heap.lo = _addr;
+    if(_addr + _size > _heap.hi) _heap.hi = _addr + _size;
+}
+
+// invoked before the memory is returned to the allocator so that the address is not
+// reused by another thread before it is removed
+void
+record_release(void* _ptr)
+{
+    auto& _heap = get_heap_table();
+    auto  _addr = reinterpret_cast<uintptr_t>(_ptr);
+    if(!_ptr || in_wrapper || _heap.nlive.load(std::memory_order_relaxed) == 0 ||
+       _addr < _heap.lo.load(std::memory_order_relaxed) ||
+       _addr >= _heap.hi.load(std::memory_order_relaxed))
+        return;
+
+    auto                         _guard = wrapper_guard{};
+    std::unique_lock<std::mutex> _lk{ _heap.mutex };
+    auto                         itr = _heap.live.find(_addr);
+    if(itr == _heap.live.end()) return;
+    _heap.history.at(itr->second).live = false;
+    _heap.live.erase(itr);
+    _heap.nlive = _heap.live.size();
+}
+}  // namespace
+
+memory_access::memory_access(const gotcha_data_t& _data)
+: m_aligned{ _data.tool_id == "aligned_alloc" }
+{}
+
+std::string
+memory_access::get_event()
+{
+    auto _event = config::get_sampling_memory_event();
+    if(!_event.empty()) return _event;
+
+    // IBS op tags the sampled loads and stores with the data address, the latency and
+    // the data source
+    if(::access("/sys/bus/event_source/devices/ibs_op/type", R_OK) == 0)
+        return std::string{ "ibs_op/0x0" };
+
+    // MEM_TRANS_RETIRED.LOAD_LATENCY with a threshold of 3 cycles
+    return std::string{ "cpu/0x1cd:0x3" };
+}
+
+void
+memory_access::configure()
+{
+    min_alloc_size = std::max<size_t>(config::get_sampling_memory_min_alloc(), 1);
+
+    memory_access_gotcha_t::get_initializer() = []() {
+        memory_access_gotcha_t::configure(
+            comp::gotcha_config<0, void*, size_t>{ "malloc" });
+        memory_access_gotcha_t::configure(
+            comp::gotcha_config<1, void*, size_t, size_t>{ "calloc" });
+        memory_access_gotcha_t::configure(
+            comp::gotcha_config<2, void*, void*, size_t>{ "realloc" });
+        memory_access_gotcha_t::configure(
+            comp::gotcha_config<3, int, void**, size_t, size_t>{ "posix_memalign" });
+        memory_access_gotcha_t::configure(
+            comp::gotcha_config<4, void*, size_t, size_t>{ "aligned_alloc" });
+        memory_access_gotcha_t::configure(comp::gotcha_config<5, void, void*>{ "free" });
+    };
+}
+
+void
+memory_access::shutdown()
+{
+    memory_access_gotcha_t::disable();
+}
+
+void
+memory_access::start()
+{
+    if(!config::get_sampling_memory() ||
+       !config::get_setting_value<bool>("OMNITRACE_SAMPLING_OVERFLOW").value_or(false))
+        return;
+
+    if(!get_memory_access_gotcha().get<memory_access_gotcha_t>()->get_is_running())
+    {
+        configure();
+        get_memory_access_gotcha().start();
+    }
+}
+
+void
+memory_access::stop()
+{
+    // the wrappers stay active until shutdown so that the releases are not missed
+}
+
+void
+memory_access::record_sample(int64_t _tid, uintptr_t _ip, uint64_t _addr,
+                             uint64_t _weight, uint64_t _data_src)
+{
+    // IBS cannot exclude the kernel so the kernel samples are dropped here
+    if(_addr == 0 || static_cast<intptr_t>(_ip) < 0) return;
+
+    auto& _table = get_access_table(_tid);
+    if(!_table) return;
+
+    auto _sample = access_sample{ _ip, _addr, _weight, _data_src, unresolved_object };
+
+    // the object is resolved after the sampling is stopped when this thread was
+    // interrupted in a wrapper or the heap table is locked by another thread
+    if(!in_wrapper)
+    {
+        auto& _heap = get_heap_table();
+        if(_heap.nlive.load(std::memory_order_relaxed) == 0 ||
+           _addr < _heap.lo.load(std::memory_order_relaxed) ||
+           _addr >= _heap.hi.load(std::memory_order_relaxed))
+        {
+            _sample.object = -1;
+        }
+        else if(_heap.mutex.try_lock())
+        {
+            _sample.object = _heap.find(_addr);
+            _heap.mutex.unlock();
+        }
+    }
+
+    auto _guard = wrapper_guard{};
+    _table->samples.emplace_back(_sample);
+}
+
+void
+memory_access::post_process()
+{
+    enum object_kind : uint8_t
+    {
+        OBJECT_UNKNOWN = 0,
+        OBJECT_HEAP,
+        OBJECT_GLOBAL,
+    };
+
+    // call-site, kind of object and the heap index or the address of the global
+    using site_key_t = std::tuple<uintptr_t, object_kind, uintptr_t>;
+
+    struct access_report
+    {
+        site_key_t   key      = {};
+        access_stats stats    = {};
+        uintptr_t    base     = 0;
+        std::string  callsite = {};
+        std::string  object   = {};
+    };
+
+    auto* _data = access_data_t::get();
+    if(!_data) return;
+
+    auto  _guard = wrapper_guard{};
+    auto& _heap  = get_heap_table();
+
+    std::unique_lock<std::mutex> _lk{ _heap.mutex };
+
+    // the found globals by address and the cache lines without a global
+    auto _globals     = std::map<uintptr_t, data_symbol>{};
+    auto _no_global   = std::unordered_set<uintptr_t>{};
+    auto _find_global = [&](uintptr_t _addr) -> const data_symbol* {
+        if(auto itr = _globals.upper_bound(_addr); itr != _globals.begin())
+        {
+            --itr;
+            if(_addr < itr->second.addr + itr->second.size) return &itr->second;
+        }
+        auto _line = _addr & ~(cache_line_size - 1);
+        if(_no_global.count(_line) > 0) return nullptr;
+        auto _sym = data_symbol{};
+        if(!lookup_global(_addr, _sym))
+        {
+            _no_global.emplace(_line);
+            return nullptr;
+        }
+        return &_globals.emplace(_sym.addr, _sym).first->second;
+    };
+
+    // the sampling is stopped at this point so the tables can be merged on this thread
+    auto     _sites   = std::map<site_key_t, access_report>{};
+    auto     _total   = access_stats{};
+    uint64_t _nheap   = 0;
+    uint64_t _nglobal = 0;
+    for(const auto& titr : *_data)
+    {
+        if(!titr) continue;
+        for(const auto& itr : titr->samples)
+        {
+            auto _object = itr.object;
+            if(_object == unresolved_object) _object = _heap.find_any(itr.addr);
+
+            auto _key  = site_key_t{ itr.ip, OBJECT_UNKNOWN, 0 };
+            auto _base = uintptr_t{ 0 };
+            if(_object >= 0)
+            {
+                auto _idx = static_cast<uintptr_t>(_object);
+                _key      = site_key_t{ itr.ip, OBJECT_HEAP, _idx };
+                _base     = _heap.history.at(_idx).addr;
+                ++_nheap;
+            }
+            else if(const auto* _sym = _find_global(itr.addr))
+            {
+                _key  = site_key_t{ itr.ip, OBJECT_GLOBAL, _sym->addr };
+                _base = _sym->addr;
+                ++_nglobal;
+            }
+
+            auto  _line   = (itr.addr - _base) & ~(cache_line_size - 1);
+            auto& _report = _sites[_key];
+            _report.key   = _key;
+            _report.base  = _base;
+            _report.stats.record(itr, _line);
+            _total.record(itr, 0);
+        }
+    }
+
+    if(_total.samples == 0) return;
+
+    auto _order = [](const access_report& _lhs, const access_report& _rhs) {
+        return std::tie(_lhs.stats.weight, _lhs.stats.samples) >
+               std::tie(_rhs.stats.weight, _rhs.stats.samples);
+    };
+
+    auto _reports = std::vector<access_report>{};
+    _reports.reserve(_sites.size());
+    for(auto& itr : _sites)
+        _reports.emplace_back(std::move(itr.second));
+    std::sort(_reports.begin(), _reports.end(), _order);
+
+    // resolving the call sites is expensive so only the hottest instructions are
+    // resolved before the instructions of the same source line are merged
+    auto _ntop = config::get_sampling_memory_top();
+    if(_reports.size() > 8 * _ntop) _reports.resize(8 * _ntop);
+
+    auto _ip_labels    = std::unordered_map<uintptr_t, std::string>{};
+    auto _alloc_labels = std::unordered_map<uintptr_t, std::string>{};
+    auto _merged       = std::map<std::pair<std::string, std::string>, access_report>{};
+    for(auto& itr : _reports)
+    {
+        auto [_ip, _kind, _id] = itr.key;
+
+        auto& _callsite = _ip_labels[_ip];
+        if(_callsite.empty()) _callsite = callsite::get_label(_ip);
+
+        auto _object = std::string{ "[unknown]" };
+        if(_kind == OBJECT_HEAP)
+        {
+            const auto& _alloc = _heap.history.at(_id);
+            auto&       _label = _alloc_labels[_id];
+            if(_label.empty()) _label = callsite::get_caller_label(_alloc.frames);
+            _object = JOIN("", "heap[", _alloc.size, " B] @ ", _label);
+        }
+        else if(_kind == OBJECT_GLOBAL)
+        {
+            _object = _globals.at(_id).name;
+        }
+
+        auto& _report = _merged[std::make_pair(_callsite, _object)];
+        if(_report.stats.samples == 0)
+        {
+            _report.key      = itr.key;
+            _report.base     = itr.base;
+            _report.callsite = _callsite;
+            _report.object   = _object;
+        }
+        _report.stats += itr.stats;
+    }
+
+    _reports.clear();
+    for(auto& itr : _merged)
+        _reports.emplace_back(std::move(itr.second));
+    std::sort(_reports.begin(), _reports.end(), _order);
+    if(_reports.size() > _ntop) _reports.resize(_ntop);
+
+    auto _pct = [](uint64_t _v, uint64_t _n) {
+        return (_n == 0) ? 0.0 : (100.0 * static_cast<double>(_v)) / _n;
+    };
+
+    OMNITRACE_VERBOSE(0,
+                      "Memory accesses :: %lu samples (%.1f%% heap, %.1f%% globals), "
+                      "%.1f cycles average latency, %.1f%% beyond the L3 cache\n",
+                      _total.samples, _pct(_nheap, _total.samples),
+                      _pct(_nglobal, _total.samples),
+                      static_cast<double>(_total.weight) / _total.samples,
+                      _pct(_total.levels.at(LEVEL_RAM) + _total.levels.at(LEVEL_REMOTE),
+                           _total.samples));
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("memory-access", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<memory_access>{}(
+                _fname, std::string{ "memory_access" });
+
+        ofs << "# event: " << get_event() << "\n";
+        ofs << "# latencies in cycles, data sources in percent of the samples\n";
+        ofs << std::setw(10) << "samples" << " " << std::setw(14) << "total latency"
+            << " " << std::setw(10) << "average" << " " << std::setw(10) << "max";
+        for(auto itr : level_names)
+            ofs << " " << std::setw(7) << itr;
+        ofs << " " << std::setw(18) << "hottest line" << "   call site -> data object\n";
+        ofs << std::fixed << std::setprecision(1);
+        for(const auto& itr : _reports)
+        {
+            const auto& _stats = itr.stats;
+            ofs << std::setw(10) << _stats.samples << " " << std::setw(14)
+                << _stats.weight << " " << std::setw(10)
+                << (static_cast<double>(_stats.weight) / _stats.samples) << " "
+                << std::setw(10) << _stats.max_weight;
+            for(auto _n : _stats.levels)
+                ofs << " " << std::setw(7) << _pct(_n, _stats.samples);
+            // the offset of the cache line in the object or its address when unknown
+            auto _line = _stats.hottest_line();
+            ofs << " " << std::setw(18)
+                << ((itr.base == 0) ? JOIN("", "0x", std::hex, _line)
+                                    : JOIN("", "+0x", std::hex, _line))
+                << "   " << itr.callsite << " -> " << itr.object << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening memory access output file: %s", _fname.c_str());
+    }
+}
+
+void*
+memory_access::operator()(void* (*_callee)(size_t), size_t _size) const
+{
+    auto* _ret = (*_callee)(_size);
+    record_allocation(_ret, _size);
+    return _ret;
+}
+
+void*
+memory_access::operator()(void* (*_callee)(size_t, size_t), size_t _a, size_t _b) const
+{
+    // calloc(nmemb, size) or aligned_alloc(alignment, size)
+    auto* _ret = (*_callee)(_a, _b);
+    record_allocation(_ret, (m_aligned) ? _b : _a * _b);
+    return _ret;
+}
+
+void*
+memory_access::operator()(void* (*_callee)(void*, size_t), void* _ptr,
+                          size_t _size) const
+{
+    record_release(_ptr);
+    auto* _ret = (*_callee)(_ptr, _size);
+    record_allocation(_ret, _size);
+    return _ret;
+}
+
+int
+memory_access::operator()(int (*_callee)(void**, size_t, size_t), void** _ptr,
+                          size_t _align, size_t _size) const
+{
+    auto _ret = (*_callee)(_ptr, _align, _size);
+    if(_ret == 0 && _ptr) record_allocation(*_ptr, _size);
+    return _ret;
+}
+
+void
+memory_access::operator()(void (*_callee)(void*), void* _ptr) const
+{
+    record_release(_ptr);
+    (*_callee)(_ptr);
+}
+}  // namespace component
+}  // namespace omnitrace
+
+namespace tim
+{
+namespace policy
+{
+template <size_t N>
+memory_access&
+static_data<memory_access, memory_access_gotcha_t>::operator()(
+    std::integral_constant<size_t, N>, const component::gotcha_data& _data) const
+{
+    // not thread-local since the construction of the thread-local data would allocate
+    static auto _v = memory_access{ _data };
+    return _v;
+}
+}  // namespace policy
+}  // namespace tim
@@ -0,0 +1,108 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/mpl/macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace omnitrace
+{
+namespace component
+{
+// attributes the memory accesses sampled by the overflow perf event (AMD IBS op or the
+// Intel load latency event) to the (call-site, data object) pairs. The data objects
+// are the heap allocations of at least OMNITRACE_SAMPLING_MEMORY_MIN_ALLOC bytes,
+// which are recorded by the wrappers of the malloc family, and the global variables
+struct memory_access : comp::base<memory_access, void>
+{
+    static constexpr size_t gotcha_capacity = 6;
+    using gotcha_data_t                     = comp::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(memory_access)
+
+    explicit memory_access(const gotcha_data_t&);
+
+    // string id for component
+    static std::string label() { return "memory_access"; }
+
+    // the raw PMU event of OMNITRACE_SAMPLING_MEMORY_EVENT or the default of the CPU
+    static std::string get_event();
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // invoked by the callchain sampler in the signal handler
+    static void record_sample(int64_t _tid, uintptr_t _ip, uint64_t _addr,
+                              uint64_t _weight, uint64_t _data_src);
+
+    // writes the latencies and the data sources of the hottest (call-site, object)
+    static void post_process();
+
+    void* operator()(void* (*)(size_t), size_t) const;
+    void* operator()(void* (*)(size_t, size_t), size_t, size_t) const;
+    void* operator()(void* (*)(void*, size_t), void*, size_t) const;
+    int   operator()(int (*)(void**, size_t, size_t), void**, size_t, size_t) const;
+    void  operator()(void (*)(void*), void*) const;
+
+private:
+    // aligned_alloc has the same signature as calloc
+    bool m_aligned = false;
+};
+
+using memory_access_gotcha_t =
+    comp::gotcha<memory_access::gotcha_capacity, std::tuple<>, memory_access>;
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_DEFINE_CONCRETE_TRAIT(fast_gotcha, component::memory_access_gotcha_t, true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(static_data, component::memory_access_gotcha_t, true_type)
+
+namespace tim
+{
+namespace policy
+{
+using memory_access          = ::omnitrace::component::memory_access;
+using memory_access_gotcha_t = ::omnitrace::component::memory_access_gotcha_t;
+
+template <>
+struct static_data<memory_access, memory_access_gotcha_t> : std::true_type
+{
+    template <size_t N>
+    memory_access& operator()(std::integral_constant<size_t, N>,
+                              const component::gotcha_data& _data) const;
+};
+}  // namespace policy
+}  // namespace tim
@@ -0,0 +1,595 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/components/mpi_flow.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "library/critical_path.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+#if defined(OMNITRACE_USE_MPI)
+namespace
+{
+struct comm_info
+{
+    uint64_t key  = 0;  // zero if the communicator is not matched
+    int      rank = -1;
+    int      size = 0;
+    uint64_t seq  = 0;
+};
+
+// entry and exit of one collective on this rank. Trivially copyable since the
+// records are gathered as bytes
+struct collective_record
+{
+    uint64_t comm = 0;
+    uint64_t seq  = 0;
+    uint64_t name = 0;
+    uint64_t size = 0;
+    uint64_t beg  = 0;
+    uint64_t end  = 0;
+};
+
+using message_key_t = std::tuple<uint64_t, int, int, int>;
+
+struct matching_data
+{
+    std::mutex                        mutex       = {};
+    std::map<MPI_Comm, comm_info>     comms       = {};
+    std::map<message_key_t, uint64_t> sends       = {};
+    std::map<message_key_t, uint64_t> recvs       = {};
+    std::map<uint64_t, std::string>   names       = {};
+    std::vector<collective_record>    collectives = {};
+};
+
+auto&
+get_matching_data()
+{
+    static auto* _v = new matching_data{};
+    return *_v;
+}
+
+size_t
+get_max_records()
+{
+    static auto _v = tim::get_env<size_t>("OMNITRACE_MPI_MATCHING_MAX_RECORDS", 100000);
+    return _v;
+}
+
+uint64_t
+mix(uint64_t _v)
+{
+    _v += 0x9E3779B97F4A7C15ULL;
+    _v = (_v ^ (_v >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    _v = (_v ^ (_v >> 27)) * 0x94D049BB133111EBULL;
+    return _v ^ (_v >> 31);
+}
+
+template <typename... Args>
+uint64_t
+get_flow_id(uint64_t _v, Args... _args)
+{
+    ((_v = mix(_v ^ static_cast<uint64_t>(_args))), ...);
+    return (_v == 0) ? 1 : _v;
+}
+
+// the communicator handles are not comparable across ranks so the communicators
+// are identified by the world rank of their rank 0 and their size. Dup'ed
+// communicators with the same group share the identifier. Lock must be held.
+comm_info*
+get_comm_info(matching_data& _data, MPI_Comm _comm)
+{
+    if(_comm == MPI_COMM_NULL) return nullptr;
+
+    auto itr = _data.comms.find(_comm);
+    if(itr != _data.comms.end()) return (itr->second.key == 0) ? nullptr : &itr->second;
+
+    auto& _info  = _data.comms[_comm];
+    int   _inter = 0;
+    if(PMPI_Comm_test_inter(_comm, &_inter) != MPI_SUCCESS || _inter != 0)
+        return nullptr;
+
+    PMPI_Comm_rank(_comm, &_info.rank);
+    PMPI_Comm_size(_comm, &_info.size);
+    if(_info.size < 2) return nullptr;
+
+    auto _group  = MPI_Group{};
+    auto _world  = MPI_Group{};
+    int  _zero   = 0;
+    int  _leader = MPI_UNDEFINED;
+    PMPI_Comm_group(_comm, &_group);
+    PMPI_Comm_group(MPI_COMM_WORLD, &_world);
+    PMPI_Group_translate_ranks(_group, 1, &_zero, _world, &_leader);
+    PMPI_Group_free(&_group);
+    PMPI_Group_free(&_world);
+    if(_leader == MPI_UNDEFINED) return nullptr;
+
+    _info.key = get_flow_id(mix(_leader), _info.size);
+    return &_info;
+}
+
+template <typename FlowT>
+void
+emit_flow(const tim::component::gotcha_data& _data, uint64_t _ts, FlowT&& _flow,
+          uint64_t _comm, uint64_t _seq, int _peer, int _tag)
+{
+    // the flows are only emitted when the matching was requested, this component is
+    // also enabled for the critical path
+    if(!get_use_perfetto() || !config::get_mpi_matching()) return;
+
+    tracing::mark_perfetto_ts(category::mpi{}, _data.tool_id.c_str(), _ts,
+                              std::forward<FlowT>(_flow),
+                              [&](::perfetto::EventContext ctx) {
+                                  if(config::get_perfetto_annotations())
+                                  {
+                                      tracing::add_perfetto_annotation(ctx, "comm",
+                                                                       _comm);
+                                      tracing::add_perfetto_annotation(ctx, "seq", _seq);
+                                      if(_peer >= 0)
+                                      {
+                                          tracing::add_perfetto_annotation(ctx, "peer",
+                                                                           _peer);
+                                          tracing::add_perfetto_annotation(ctx, "tag",
+                                                                           _tag);
+                                      }
+                                  }
+                              });
+}
+}  // namespace
+
+void
+mpi_flow::send(const gotcha_data& _data, int _dst, int _tag, MPI_Comm _comm)
+{
+    if(get_state() != State::Active || _dst < 0) return;
+
+    auto     _ts  = tracing::now();
+    uint64_t _key = 0;
+    uint64_t _seq = 0;
+    int      _src = 0;
+    {
+        auto&                        _mdata = get_matching_data();
+        std::unique_lock<std::mutex> _lk{ _mdata.mutex };
+        auto*                        _info = get_comm_info(_mdata, _comm);
+        if(!_info) return;
+        _key = _info->key;
+        _src = _info->rank;
+        _seq = _mdata.sends[message_key_t{ _key, _src, _dst, _tag }]++;
+    }
+
+    auto _flow_id = get_flow_id(_key, _src, _dst, _tag, _seq);
+    if(critical_path::is_enabled())
+        critical_path::signal(critical_path::get_key(critical_path::SYNC_MPI, _flow_id),
+                              _ts);
+
+    emit_flow(_data, _ts, ::perfetto::Flow::Global(_flow_id), _key, _seq, _dst, _tag);
+}
+
+void
+mpi_flow::receive(const gotcha_data& _data, int _src, int _tag, MPI_Comm _comm)
+{
+    if(get_state() != State::Active || _src < 0 || _tag == MPI_ANY_TAG) return;
+
+    auto     _ts  = (m_beg > 0) ? m_beg : tracing::now();
+    uint64_t _key = 0;
+    uint64_t _seq = 0;
+    int      _dst = 0;
+    {
+        auto&                        _mdata = get_matching_data();
+        std::unique_lock<std::mutex> _lk{ _mdata.mutex };
+        auto*                        _info = get_comm_info(_mdata, _comm);
+        if(!_info) return;
+        _key = _info->key;
+        _dst = _info->rank;
+        _seq = _mdata.recvs[message_key_t{ _key, _src, _dst, _tag }]++;
+    }
+
+    // only the blocking receives wait for the message in this call
+    auto _flow_id = get_flow_id(_key, _src, _dst, _tag, _seq);
+    if(critical_path::is_enabled() && m_receive)
+        critical_path::wait(critical_path::get_key(critical_path::SYNC_MPI, _flow_id),
+                            _ts, tracing::now());
+
+    emit_flow(_data, _ts, ::perfetto::TerminatingFlow::Global(_flow_id), _key, _seq,
+              _src, _tag);
+}
+
+void
+mpi_flow::collective(const gotcha_data& _data, MPI_Comm _comm)
+{
+    if(get_state() != State::Active) return;
+
+    m_beg = tracing::now();
+    {
+        auto&                        _mdata = get_matching_data();
+        std::unique_lock<std::mutex> _lk{ _mdata.mutex };
+        auto*                        _info = get_comm_info(_mdata, _comm);
+        if(!_info) return;
+        m_comm       = _info->key;
+        m_src        = _info->size;
+        m_seq        = _info->seq++;
+        m_collective = true;
+    }
+
+    // every rank emits the same flow id so the instances are chained across the ranks
+    emit_flow(_data, m_beg, ::perfetto::Flow::Global(get_flow_id(m_comm, m_seq)), m_comm,
+              m_seq, -1, 0);
+}
+
+// MPI_Send
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                MPI_Datatype, int dst, int tag, MPI_Comm _comm)
+{
+    send(_data, dst, tag, _comm);
+}
+
+// MPI_Recv
+void
+mpi_flow::audit(const gotcha_data&, audit::incoming, void*, int, MPI_Datatype, int src,
+                int tag, MPI_Comm _comm, MPI_Status* _status)
+{
+    // the source and tag of wildcard receives are only known from the status
+    m_beg       = tracing::now();
+    m_receive   = true;
+    m_src       = src;
+    m_tag       = tag;
+    m_status    = _status;
+    m_recv_comm = _comm;
+}
+
+// MPI_Isend
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                MPI_Datatype, int dst, int tag, MPI_Comm _comm, MPI_Request*)
+{
+    send(_data, dst, tag, _comm);
+}
+
+// MPI_Irecv
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+                int src, int tag, MPI_Comm _comm, MPI_Request*)
+{
+    // wildcard receives would require the status from the completion of the request
+    if(src == MPI_ANY_SOURCE || tag == MPI_ANY_TAG) return;
+    receive(_data, src, tag, _comm);
+}
+
+// MPI_Sendrecv
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                MPI_Datatype, int dst, int sendtag, void*, int, MPI_Datatype, int src,
+                int recvtag, MPI_Comm _comm, MPI_Status* _status)
+{
+    send(_data, dst, sendtag, _comm);
+    m_beg       = tracing::now();
+    m_receive   = true;
+    m_src       = src;
+    m_tag       = recvtag;
+    m_status    = _status;
+    m_recv_comm = _comm;
+}
+
+// MPI_Barrier
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Bcast
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+                int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Allreduce
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+                MPI_Datatype, MPI_Op, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Reduce
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+                MPI_Datatype, MPI_Op, int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Gather
+// MPI_Scatter
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                MPI_Datatype, void*, int, MPI_Datatype, int, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+// MPI_Alltoall
+// MPI_Allgather
+void
+mpi_flow::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                MPI_Datatype, void*, int, MPI_Datatype, MPI_Comm _comm)
+{
+    collective(_data, _comm);
+}
+
+void
+mpi_flow::audit(const gotcha_data& _data, audit::outgoing, int _retval)
+{
+    if(m_receive && _retval == MPI_SUCCESS)
+    {
+        auto _src = m_src;
+        auto _tag = m_tag;
+        if(m_status && m_status != MPI_STATUS_IGNORE)
+        {
+            _src = m_status->MPI_SOURCE;
+            _tag = m_status->MPI_TAG;
+        }
+        receive(_data, _src, _tag, m_recv_comm);
+    }
+
+    if(m_collective && critical_path::is_enabled())
+    {
+        // every rank signals its arrival so the last arrival releases the others
+        auto _key = critical_path::get_key(critical_path::SYNC_MPI,
+                                           get_flow_id(m_comm, m_seq));
+        critical_path::signal(_key, m_beg);
+        critical_path::wait(_key, m_beg, tracing::now());
+    }
+
+    if(m_collective && config::get_mpi_matching())
+    {
+        auto                         _end   = tracing::now();
+        auto                         _name  = tim::add_hash_id(_data.tool_id);
+        auto&                        _mdata = get_matching_data();
+        std::unique_lock<std::mutex> _lk{ _mdata.mutex };
+        if(_mdata.names.count(_name) == 0) _mdata.names.emplace(_name, _data.tool_id);
+        if(_mdata.collectives.size() < get_max_records())
+        {
+            _mdata.collectives.emplace_back(collective_record{
+                m_comm, m_seq, _name, static_cast<uint64_t>(m_src), m_beg, _end });
+        }
+    }
+
+    m_receive    = false;
+    m_collective = false;
+}
+
+void
+mpi_flow::post_process()
+{
+    if(!config::get_mpi_matching()) return;
+
+    // the records can only be gathered when this is invoked from MPI_Finalize
+    int _initialized = 0;
+    int _finalized   = 0;
+    PMPI_Initialized(&_initialized);
+    PMPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0)
+    {
+        OMNITRACE_VERBOSE(1, "MPI collective skew not computed: MPI is not active\n");
+        return;
+    }
+
+    auto& _mdata = get_matching_data();
+    auto  _local = std::vector<collective_record>{};
+    auto  _names = std::map<uint64_t, std::string>{};
+    {
+        std::unique_lock<std::mutex> _lk{ _mdata.mutex };
+        std::swap(_local, _mdata.collectives);
+        _names = _mdata.names;
+    }
+
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+
+    // every rank computes the same truncation so the gathered bytes fit in an int
+    constexpr auto _record_size = sizeof(collective_record);
+    auto           _nlocal      = static_cast<int>(_local.size());
+    auto           _counts      = std::vector<int>(_size, 0);
+    PMPI_Allgather(&_nlocal, 1, MPI_INT, _counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+
+    int64_t _total = 0;
+    for(auto itr : _counts)
+        _total += itr;
+    if(_total * static_cast<int64_t>(_record_size) > INT_MAX)
+    {
+        auto _limit = static_cast<int>(INT_MAX / _record_size / _size);
+        for(auto& itr : _counts)
+            itr = std::min(itr, _limit);
+        _local.resize(std::min<size_t>(_local.size(), _limit));
+    }
+
+    auto _bytes  = std::vector<int>(_size, 0);
+    auto _displs = std::vector<int>(_size, 0);
+    for(int i = 0; i < _size; ++i)
+    {
+        _bytes.at(i) = _counts.at(i) * static_cast<int>(_record_size);
+        if(i > 0) _displs.at(i) = _displs.at(i - 1) + _bytes.at(i - 1);
+    }
+
+    auto _all = std::vector<collective_record>{};
+    if(_rank == 0)
+        _all.resize((_displs.back() + _bytes.back()) / static_cast<int>(_record_size));
+
+    PMPI_Gatherv(_local.data(), _bytes.at(_rank), MPI_BYTE, _all.data(), _bytes.data(),
+                 _displs.data(), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    if(_rank != 0 || _all.empty()) return;
+
+    // arrival of the ranks for each collective instance
+    struct instance
+    {
+        uint64_t name  = 0;
+        uint64_t size  = 0;
+        uint64_t first = 0;
+        uint64_t last  = 0;
+        int      late  = -1;  // world rank which arrived last
+        int      count = 0;
+    };
+
+    auto _instances = std::map<std::pair<uint64_t, uint64_t>, instance>{};
+    for(int i = 0; i < _size; ++i)
+    {
+        auto _beg = _displs.at(i) / static_cast<int>(_record_size);
+        for(int j = 0; j < _counts.at(i); ++j)
+        {
+            const auto& itr   = _all.at(_beg + j);
+            auto&       _inst = _instances[{ itr.comm, itr.seq }];
+            if(_inst.count++ == 0)
+            {
+                _inst.name  = itr.name;
+                _inst.size  = itr.size;
+                _inst.first = itr.beg;
+            }
+            _inst.first = std::min(_inst.first, itr.beg);
+            if(itr.beg >= _inst.last)
+            {
+                _inst.last = itr.beg;
+                _inst.late = i;
+            }
+        }
+    }
+
+    struct skew_stats
+    {
+        uint64_t           comm       = 0;
+        uint64_t           name       = 0;
+        uint64_t           size       = 0;
+        uint64_t           count      = 0;
+        uint64_t           incomplete = 0;
+        uint64_t           total      = 0;
+        uint64_t           max        = 0;
+        std::map<int, int> late       = {};
+    };
+
+    auto _stats = std::map<std::pair<uint64_t, uint64_t>, skew_stats>{};
+    for(const auto& itr : _instances)
+    {
+        const auto& _inst = itr.second;
+        auto&       _stat = _stats[{ itr.first.first, _inst.name }];
+        _stat.comm        = itr.first.first;
+        _stat.name        = _inst.name;
+        _stat.size        = _inst.size;
+        if(static_cast<uint64_t>(_inst.count) < _inst.size || _inst.count < 2)
+        {
+            ++_stat.incomplete;
+            continue;
+        }
+        auto _skew = _inst.last - _inst.first;
+        ++_stat.count;
+        _stat.total += _skew;
+        _stat.max = std::max(_stat.max, _skew);
+        _stat.late[_inst.late] += 1;
+    }
+
+    auto _get_name = [&_names](uint64_t _hash) {
+        auto itr = _names.find(_hash);
+        return (itr != _names.end()) ? itr->second : JOIN("", "0x", std::hex, _hash);
+    };
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("mpi-collective-skew", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<mpi_flow>{}(_fname,
+                                                        std::string{ "mpi_flow" });
+
+        auto _usec = [](double _v) { return _v / units::usec; };
+
+        ofs << std::setw(20) << "collective" << " " << std::setw(18) << "communicator"
+            << " " << std::setw(6) << "size" << " " << std::setw(10) << "instances"
+            << " " << std::setw(16) << "mean skew [usec]" << " " << std::setw(16)
+            << "max skew [usec]" << "   last arrival (world rank: count)\n";
+        ofs << std::fixed << std::setprecision(3);
+        for(const auto& itr : _stats)
+        {
+            const auto& _stat = itr.second;
+            if(_stat.count == 0) continue;
+
+            auto _late = std::vector<std::pair<int, int>>{ _stat.late.begin(),
+                                                           _stat.late.end() };
+            std::sort(_late.begin(), _late.end(),
+                      [](auto _lhs, auto _rhs) { return _lhs.second > _rhs.second; });
+            _late.resize(std::min<size_t>(_late.size(), 3));
+
+            ofs << std::setw(20) << _get_name(_stat.name) << " " << std::setw(18)
+                << JOIN("", "0x", std::hex, _stat.comm) << " " << std::setw(6)
+                << _stat.size << " " << std::setw(10) << _stat.count << " "
+                << std::setw(16) << _usec(static_cast<double>(_stat.total) / _stat.count)
+                << " " << std::setw(16) << _usec(_stat.max) << "  ";
+            for(const auto& litr : _late)
+                ofs << " " << litr.first << ": " << litr.second;
+            if(_stat.incomplete > 0) ofs << "  (" << _stat.incomplete << " incomplete)";
+            ofs << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening MPI collective skew output file: %s",
+                        _fname.c_str());
+    }
+
+    OMNITRACE_VERBOSE(0, "MPI collective skew of %zu collective instances computed\n",
+                      _instances.size());
+}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+#if defined(OMNITRACE_USE_MPI)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(mpi_flow, false, void)
+#endif
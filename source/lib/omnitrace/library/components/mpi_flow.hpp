@@ -0,0 +1,159 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/components/macros.hpp>
+
+#if defined(OMNITRACE_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <cstdint>
+#include <string>
+
+OMNITRACE_DECLARE_COMPONENT(mpi_flow)
+
+namespace omnitrace
+{
+namespace component
+{
+// connects the matching MPI calls of the ranks. The collectives are numbered per
+// communicator and the point-to-point messages are numbered per (source, destination,
+// tag, communicator), which is the order MPI matches them in, and the flow id is
+// derived from the number so every rank computes the same id for the same
+// message/collective without any communication. The communicators are identified by
+// the world rank of their rank 0 and their size. The entry and exit times of the
+// collectives are gathered on rank 0 during finalization to compute their skew.
+struct mpi_flow : base<mpi_flow, void>
+{
+    using value_type  = void;
+    using this_type   = mpi_flow;
+    using base_type   = base<this_type, value_type>;
+    using gotcha_data = ::tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(mpi_flow)
+
+    static std::string label() { return "mpi_flow"; }
+    static std::string description() { return "MPI message and collective matching"; }
+
+    static void start() {}
+    static void stop() {}
+
+    // gathers the collective timestamps and reports the skew on rank 0
+    static void post_process();
+
+#if defined(OMNITRACE_USE_MPI)
+    // MPI_Send
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int,
+               MPI_Datatype, int dst, int tag, MPI_Comm);
+
+    // MPI_Recv
+    void audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+               int src, int tag, MPI_Comm, MPI_Status*);
+
+    // MPI_Isend
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int,
+               MPI_Datatype, int dst, int tag, MPI_Comm, MPI_Request*);
+
+    // MPI_Irecv
+    void audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+               int src, int tag, MPI_Comm, MPI_Request*);
+
+    // MPI_Sendrecv
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int,
+               MPI_Datatype, int dst, int sendtag, void*, int, MPI_Datatype, int src,
+               int recvtag, MPI_Comm, MPI_Status*);
+
+    // MPI_Barrier
+    void audit(const gotcha_data& _data, audit::incoming, MPI_Comm);
+
+    // MPI_Bcast
+    void audit(const gotcha_data& _data, audit::incoming, void*, int, MPI_Datatype,
+               int root, MPI_Comm);
+
+    // MPI_Allreduce
+    void audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+               MPI_Datatype, MPI_Op, MPI_Comm);
+
+    // MPI_Reduce
+    void audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+               MPI_Datatype, MPI_Op, int root, MPI_Comm);
+
+    // MPI_Gather
+    // MPI_Scatter
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int,
+               MPI_Datatype, void*, int, MPI_Datatype, int root, MPI_Comm);
+
+    // MPI_Alltoall
+    // MPI_Allgather
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int,
+               MPI_Datatype, void*, int, MPI_Datatype, MPI_Comm);
+
+    void audit(const gotcha_data& _data, audit::outgoing, int);
+
+private:
+    void collective(const gotcha_data& _data, MPI_Comm);
+    void receive(const gotcha_data& _data, int src, int tag, MPI_Comm);
+    void send(const gotcha_data& _data, int dst, int tag, MPI_Comm);
+
+    bool        m_collective = false;
+    bool        m_receive    = false;
+    int         m_src        = 0;
+    int         m_tag        = 0;
+    uint64_t    m_comm       = 0;
+    uint64_t    m_seq        = 0;
+    uint64_t    m_beg        = 0;
+    MPI_Comm    m_recv_comm  = MPI_COMM_NULL;
+    MPI_Status* m_status     = nullptr;
+#endif
+};
+
+#if !defined(OMNITRACE_USE_MPI)
+inline void
+mpi_flow::post_process()
+{}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+#if !defined(OMNITRACE_USE_MPI)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::mpi_flow, false_type)
+#endif
+
+#if defined(OMNITRACE_USE_MPI)
+#    if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                         \
+        (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#        include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(mpi_flow, false, void)
+
+#    endif
+#endif
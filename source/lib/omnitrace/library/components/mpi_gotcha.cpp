@@ -22,12 +22,15 @@
 
 #include "library/components/mpi_gotcha.hpp"
 #include "api.hpp"
+#include "core/clock_sync.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/mproc.hpp"
 #include "library/components/category_region.hpp"
 #include "library/components/comm_data.hpp"
+#include "library/components/mpi_flow.hpp"
+#include "library/components/mpi_wait.hpp"
 
 #include <timemory/backends/mpi.hpp>
 #include <timemory/backends/process.hpp>
@@ -46,8 +49,10 @@ namespace component
 {
 namespace
 {
+// mpi_transfer must precede the region and mpi_wait must follow it, see mpi_wait.hpp
 using mpip_bundle_t =
-    tim::component_tuple<category_region<category::mpi>, comp::comm_data>;
+    tim::component_tuple<comp::mpi_transfer, category_region<category::mpi>,
+                         comp::comm_data, comp::mpi_flow, comp::mpi_wait>;
 
 struct comm_rank_data
 {
@@ -308,6 +313,8 @@ mpi_gotcha::audit(const gotcha_data_t& _data, audit::outgoing, int _retval)
     if(_retval == tim::mpi::success_v && _data.tool_id.find("MPI_Init") == 0)
     {
         omnitrace_mpi_set_attr();
+        // the first estimate of the clock offset of this rank for the combined trace
+        if(clock_sync::is_enabled()) clock_sync::synchronize();
         // omnitrace will set this environement variable to true in binary rewrite mode
         // when it detects MPI. Hides this env variable from the user to avoid this
         // being activated unwaringly during runtime instrumentation because that
@@ -317,6 +324,12 @@ mpi_gotcha::audit(const gotcha_data_t& _data, audit::outgoing, int _retval)
         {
             OMNITRACE_BASIC_VERBOSE_F(2, "Activating MPI wrappers...\n");
 
+            // the message and collective matching provides the MPI edges of the
+            // critical path
+            trait::runtime_enabled<comp::mpi_flow>::set(config::get_mpi_matching() ||
+                                                        config::get_critical_path());
+            comp::mpi_wait::configure();
+
             // use env vars OMNITRACE_MPIP_PERMIT_LIST and OMNITRACE_MPIP_REJECT_LIST
             // to control the gotcha bindings at runtime
             comp::configure_mpip<mpip_bundle_t, project::omnitrace>(permit_bindings,
@@ -0,0 +1,181 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/components/mpi_wait.hpp"
+#include "core/config.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "library/tracing.hpp"
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace omnitrace
+{
+namespace component
+{
+void
+mpi_wait::configure()
+{
+    auto _enabled = config::get_mpi_collective_wait();
+
+    trait::runtime_enabled<mpi_wait>::set(_enabled);
+    trait::runtime_enabled<mpi_transfer>::set(_enabled);
+
+    mpi_wait_data::label()       = "mpi_wait";
+    mpi_wait_data::description() = "Wait and transfer time of the MPI collectives";
+}
+
+#if defined(OMNITRACE_USE_MPI)
+namespace
+{
+using names_t = std::pair<std::string, std::string>;
+
+// the collective started on this thread. Collectives are blocking so there is at
+// most one per thread
+struct wait_state
+{
+    bool           pending  = false;
+    bool           transfer = false;
+    uint64_t       beg      = 0;
+    uint64_t       mid      = 0;
+    const names_t* names    = nullptr;
+};
+
+auto&
+get_wait_state()
+{
+    static thread_local auto _v = wait_state{};
+    return _v;
+}
+
+// perfetto requires the slice names to outlive the trace
+const names_t*
+get_names(const std::string& _name)
+{
+    static auto* _names = new std::unordered_map<std::string, names_t>{};
+    static auto  _mutex = std::mutex{};
+
+    std::unique_lock<std::mutex> _lk{ _mutex };
+    auto                         itr = _names->find(_name);
+    if(itr == _names->end())
+        itr = _names
+                  ->emplace(_name, names_t{ JOIN(" ", _name, "[wait]"),
+                                            JOIN(" ", _name, "[transfer]") })
+                  .first;
+    return &itr->second;
+}
+
+void
+begin_collective(const tim::component::gotcha_data& _data, MPI_Comm _comm,
+                 bool _barrier)
+{
+    auto& _state   = get_wait_state();
+    _state.pending = false;
+
+    if(get_state() != State::Active || _comm == MPI_COMM_NULL) return;
+
+    _state.names    = get_names(_data.tool_id);
+    _state.transfer = !_barrier;
+    _state.beg      = tracing::now();
+    if(_state.transfer)
+    {
+        PMPI_Barrier(_comm);
+        _state.mid = tracing::now();
+    }
+    _state.pending = true;
+}
+}  // namespace
+
+// MPI_Barrier
+void
+mpi_wait::audit(const gotcha_data& _data, audit::incoming, MPI_Comm _comm)
+{
+    begin_collective(_data, _comm, true);
+}
+
+// MPI_Allreduce
+void
+mpi_wait::audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+                MPI_Datatype, MPI_Op, MPI_Comm _comm)
+{
+    begin_collective(_data, _comm, false);
+}
+
+// MPI_Alltoall
+// MPI_Allgather
+void
+mpi_wait::audit(const gotcha_data& _data, audit::incoming, const void*, int,
+                MPI_Datatype, void*, int, MPI_Datatype, MPI_Comm _comm)
+{
+    begin_collective(_data, _comm, false);
+}
+
+void
+mpi_transfer::audit(const gotcha_data&, audit::outgoing, int)
+{
+    auto& _state = get_wait_state();
+    if(!_state.pending) return;
+    _state.pending = false;
+
+    auto _end = tracing::now();
+    auto _mid = (_state.transfer) ? _state.mid : _end;
+
+    if(get_use_perfetto())
+    {
+        tracing::push_perfetto_ts(category::mpi{}, _state.names->first.c_str(),
+                                  _state.beg);
+        tracing::pop_perfetto_ts(category::mpi{}, _state.names->first.c_str(), _mid);
+        if(_state.transfer)
+        {
+            tracing::push_perfetto_ts(category::mpi{}, _state.names->second.c_str(),
+                                      _mid);
+            tracing::pop_perfetto_ts(category::mpi{}, _state.names->second.c_str(),
+                                     _end);
+        }
+    }
+
+    if(get_use_timemory() && trait::runtime_enabled<mpi_wait_data>::get())
+    {
+        using tracker_t = tim::auto_tuple<mpi_wait_data>;
+
+        // the MPI region is still open so the entries are nested in it
+        tracker_t{ _state.names->first }.store(std::plus<double>{},
+                                               static_cast<double>(_mid - _state.beg));
+        if(_state.transfer)
+            tracker_t{ _state.names->second }.store(std::plus<double>{},
+                                                    static_cast<double>(_end - _mid));
+    }
+}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+#if defined(OMNITRACE_USE_MPI)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(mpi_wait, false, void)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(mpi_transfer, false, void)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(mpi_wait_data, true, double)
+#endif
@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/components/macros.hpp>
+
+#if defined(OMNITRACE_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <string>
+
+OMNITRACE_DECLARE_COMPONENT(mpi_wait)
+OMNITRACE_DECLARE_COMPONENT(mpi_transfer)
+
+namespace omnitrace
+{
+namespace component
+{
+// splits MPI_Barrier, MPI_Allreduce, MPI_Alltoall, and MPI_Allgather into the time
+// spent waiting for the slowest rank and the time spent transferring the data. The
+// wait is measured with a zero-byte barrier on the communicator before the collective
+// (MPI_Barrier is entirely waiting). mpi_wait follows the MPI region in the bundle so
+// the barrier is inside of the region and mpi_transfer precedes the MPI region in the
+// bundle so the wait and transfer slices are closed before the region is
+struct mpi_wait : base<mpi_wait, void>
+{
+    using value_type  = void;
+    using this_type   = mpi_wait;
+    using base_type   = base<this_type, value_type>;
+    using gotcha_data = ::tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(mpi_wait)
+
+    static std::string label() { return "mpi_wait"; }
+    static std::string description()
+    {
+        return "Wait for the slowest rank in MPI collectives";
+    }
+
+    static void start() {}
+    static void stop() {}
+
+    // enables mpi_wait and mpi_transfer when OMNITRACE_MPI_COLLECTIVE_WAIT is set
+    static void configure();
+
+#if defined(OMNITRACE_USE_MPI)
+    // MPI_Barrier
+    void audit(const gotcha_data& _data, audit::incoming, MPI_Comm);
+
+    // MPI_Allreduce
+    void audit(const gotcha_data& _data, audit::incoming, const void*, void*, int,
+               MPI_Datatype, MPI_Op, MPI_Comm);
+
+    // MPI_Alltoall
+    // MPI_Allgather
+    void audit(const gotcha_data& _data, audit::incoming, const void*, int,
+               MPI_Datatype, void*, int, MPI_Datatype, MPI_Comm);
+#endif
+};
+
+struct mpi_transfer : base<mpi_transfer, void>
+{
+    using value_type  = void;
+    using this_type   = mpi_transfer;
+    using base_type   = base<this_type, value_type>;
+    using gotcha_data = ::tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(mpi_transfer)
+
+    static std::string label() { return "mpi_transfer"; }
+    static std::string description()
+    {
+        return "Data transfer in MPI collectives after the slowest rank arrived";
+    }
+
+    static void start() {}
+    static void stop() {}
+
+#if defined(OMNITRACE_USE_MPI)
+    // emits the wait and transfer slices of the collective started in mpi_wait
+    void audit(const gotcha_data& _data, audit::outgoing, int);
+#endif
+};
+
+#if !defined(OMNITRACE_USE_MPI)
+inline void
+mpi_wait::configure()
+{}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+// wait and transfer times of the collectives in OMNITRACE_MPI_COLLECTIVE_WAIT mode
+OMNITRACE_COMPONENT_ALIAS(mpi_wait_data, ::tim::component::data_tracker<double, mpi_wait>)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::mpi_wait_data, project::omnitrace,
+                           category::timing, os::supports_unix)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::mpi_wait_data, true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::mpi_wait_data, true_type)
+
+#if !defined(OMNITRACE_USE_MPI)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::mpi_wait, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::mpi_transfer, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::mpi_wait_data, false_type)
+#endif
+
+#if defined(OMNITRACE_USE_MPI)
+#    if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                         \
+        (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#        include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(mpi_wait, false, void)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(mpi_transfer, false, void)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(mpi_wait_data, true, double)
+
+#    endif
+#endif
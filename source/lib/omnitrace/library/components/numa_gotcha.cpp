@@ -26,16 +26,34 @@
 #include "core/debug.hpp"
 #include "core/state.hpp"
 #include "core/timemory.hpp"
+#include "library/callsite.hpp"
 #include "library/components/category_region.hpp"
 #include "library/runtime.hpp"
+#include "library/thread_data.hpp"
 
 #include <timemory/backends/threading.hpp>
 #include <timemory/components/macros.hpp>
 #include <timemory/mpl/concepts.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 // int
 // numa_migrate_pages(int pid, struct bitmask* from, struct bitmask* to);
@@ -51,12 +69,176 @@ namespace component
 {
 namespace
 {
+// the node masks of the placement requests only hold the first 64 nodes
+constexpr size_t max_nodes = 64;
+
+using placement_names_t = std::array<std::string_view, numa_gotcha::gotcha_capacity>;
+
+// the function names in the order of the wrappers in numa_gotcha::configure
+constexpr auto placement_names = placement_names_t{
+    "mbind",
+    "migrate_pages",
+    "move_pages",
+    "numa_migrate_pages",
+    "numa_move_pages",
+    "numa_alloc",
+    "numa_alloc_local",
+    "numa_alloc_interleaved",
+    "numa_alloc_onnode",
+    "numa_realloc",
+    "numa_free",
+    "set_mempolicy",
+};
+
+struct placement_entry
+{
+    std::atomic<uint64_t> calls = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> nodes = 0;  // bitmask of the requested nodes
+};
+
+struct locality_counts
+{
+    uint64_t local   = 0;
+    uint64_t remote  = 0;
+    uint64_t unknown = 0;
+
+    locality_counts& operator+=(const locality_counts& _v)
+    {
+        local += _v.local;
+        remote += _v.remote;
+        unknown += _v.unknown;
+        return *this;
+    }
+
+    double remote_ratio() const
+    {
+        return (local + remote == 0)
+                   ? 0.0
+                   : static_cast<double>(remote) / static_cast<double>(local + remote);
+    }
+};
+
+// the NUMA locality of the sampled loads of one thread, in total and per instruction
+struct locality_table
+{
+    locality_counts                                total     = {};
+    std::unordered_map<uintptr_t, locality_counts> callsites = {};
+};
+
+using locality_data_t = thread_data<locality_table, category::numa>;
+
 auto&
 get_numa_gotcha()
 {
     static auto _v = tim::lightweight_tuple<numa_gotcha_t>{};
     return _v;
 }
+
+bool
+use_numa_locality()
+{
+    static bool _v = config::get_numa_locality();
+    return _v;
+}
+
+auto&
+get_placement_table()
+{
+    static auto _v = std::array<placement_entry, numa_gotcha::gotcha_capacity>{};
+    return _v;
+}
+
+auto&
+get_locality_table(int64_t _tid)
+{
+    return locality_data_t::instance(construct_on_thread{ _tid });
+}
+
+uintptr_t
+get_page_size()
+{
+    static auto _v = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    return _v;
+}
+
+// the NUMA node of each CPU from the cpulist of the nodes in sysfs. This is computed
+// when configured since the samples are recorded in the signal handler
+const std::vector<int>&
+get_cpu_nodes()
+{
+    static auto _v = []() {
+        auto _data = std::vector<int>{};
+        for(size_t i = 0; i < max_nodes; ++i)
+        {
+            auto _ifs =
+                std::ifstream{ JOIN("", "/sys/devices/system/node/node", i, "/cpulist") };
+            auto _line = std::string{};
+            if(!_ifs || !std::getline(_ifs, _line)) continue;
+            for(const auto& itr : tim::delimit(_line, ", \n"))
+            {
+                auto _range = tim::delimit(itr, "-");
+                if(_range.empty()) continue;
+                auto _beg = std::stoul(_range.front());
+                auto _end = std::stoul(_range.back());
+                if(_data.size() <= _end) _data.resize(_end + 1, -1);
+                for(auto j = _beg; j <= _end; ++j)
+                    _data.at(j) = static_cast<int>(i);
+            }
+        }
+        return _data;
+    }();
+    return _v;
+}
+
+uint64_t
+get_nodemask(const unsigned long* _mask, unsigned long _maxnode)
+{
+    if(!_mask || _maxnode == 0) return 0;
+    return (_maxnode >= max_nodes) ? _mask[0] : (_mask[0] & ((1UL << _maxnode) - 1));
+}
+
+uint64_t
+get_nodemask(const int* _nodes, unsigned long _count)
+{
+    uint64_t _mask = 0;
+    for(unsigned long i = 0; _nodes && i < _count; ++i)
+    {
+        if(_nodes[i] >= 0 && static_cast<size_t>(_nodes[i]) < max_nodes)
+            _mask |= (1UL << _nodes[i]);
+    }
+    return _mask;
+}
+
+void
+record_placement(const numa_gotcha::gotcha_data& _data, uint64_t _bytes,
+                 uint64_t _nodes)
+{
+    if(!use_numa_locality()) return;
+
+    auto _idx = std::distance(
+        placement_names.begin(),
+        std::find(placement_names.begin(), placement_names.end(), _data.tool_id));
+    if(static_cast<size_t>(_idx) >= placement_names.size()) return;
+
+    auto& _entry = get_placement_table().at(_idx);
+    ++_entry.calls;
+    _entry.bytes += _bytes;
+    _entry.nodes |= _nodes;
+}
+
+std::string
+get_nodes_label(uint64_t _nodes)
+{
+    auto _label = std::string{};
+    for(size_t i = 0; i < max_nodes; ++i)
+    {
+        if((_nodes & (1UL << i)) != 0)
+            _label += (_label.empty()) ? std::to_string(i) : JOIN("", ',', i);
+    }
+    return (_label.empty()) ? std::string{ "-" } : _label;
+}
+
 }  // namespace
 
 void
@@ -89,7 +271,11 @@ numa_gotcha::configure()
         numa_gotcha_t::configure<8, void*, size_t, int>("numa_alloc_onnode");
         numa_gotcha_t::configure<9, void*, void*, size_t, size_t>("numa_realloc");
         numa_gotcha_t::configure<10, void, void*, size_t>("numa_free");
+        numa_gotcha_t::configure<11, long, int, const unsigned long*, unsigned long>(
+            "set_mempolicy");
     };
+
+    if(use_numa_locality()) get_cpu_nodes();
 }
 
 void
@@ -114,11 +300,157 @@ numa_gotcha::stop()
     // get_numa_gotcha().stop();
 }
 
+void
+numa_gotcha::record_sample(int64_t _tid, uintptr_t _ip, uint64_t _addr, uint32_t _cpu)
+{
+    auto& _table = get_locality_table(_tid);
+    if(!_table) return;
+
+    // move_pages without the target nodes returns the current node of the page
+    auto _node = -1;
+    if(_addr != 0)
+    {
+        void* _page   = reinterpret_cast<void*>(_addr & ~(get_page_size() - 1));
+        int   _status = -1;
+        if(syscall(SYS_move_pages, 0, 1, &_page, nullptr, &_status, 0) == 0)
+            _node = _status;
+    }
+
+    const auto& _cpu_nodes = get_cpu_nodes();
+    auto        _counts    = locality_counts{};
+    if(_node < 0 || _cpu >= _cpu_nodes.size() || _cpu_nodes.at(_cpu) < 0)
+        _counts.unknown = 1;
+    else if(_cpu_nodes.at(_cpu) == _node)
+        _counts.local = 1;
+    else
+        _counts.remote = 1;
+
+    _table->total += _counts;
+    _table->callsites[_ip] += _counts;
+}
+
+void
+numa_gotcha::post_process()
+{
+    struct callsite_report
+    {
+        uintptr_t       ip       = 0;
+        locality_counts counts   = {};
+        std::string     callsite = {};
+    };
+
+    auto _threads = std::vector<std::pair<size_t, locality_counts>>{};
+    auto _sites   = std::map<uintptr_t, locality_counts>{};
+    auto _total   = locality_counts{};
+
+    // the sampling is stopped at this point so the tables can be merged on this thread
+    if(auto* _data = locality_data_t::get())
+    {
+        for(size_t i = 0; i < _data->size(); ++i)
+        {
+            const auto& titr = _data->at(i);
+            if(!titr) continue;
+            if(titr->total.local + titr->total.remote + titr->total.unknown == 0)
+                continue;
+            _threads.emplace_back(i, titr->total);
+            _total += titr->total;
+            for(const auto& itr : titr->callsites)
+                _sites[itr.first] += itr.second;
+        }
+    }
+
+    auto _placements = std::vector<size_t>{};
+    for(size_t i = 0; i < get_placement_table().size(); ++i)
+        if(get_placement_table().at(i).calls > 0) _placements.emplace_back(i);
+
+    if(_threads.empty() && _placements.empty()) return;
+
+    auto _reports = std::vector<callsite_report>{};
+    _reports.reserve(_sites.size());
+    for(const auto& itr : _sites)
+        _reports.emplace_back(callsite_report{ itr.first, itr.second, std::string{} });
+
+    std::sort(_reports.begin(), _reports.end(),
+              [](const callsite_report& _lhs, const callsite_report& _rhs) {
+                  return std::tie(_lhs.counts.remote, _lhs.counts.local) >
+                         std::tie(_rhs.counts.remote, _rhs.counts.local);
+              });
+
+    // resolving the call sites is expensive so only the most remote ones are reported
+    auto _ntop = config::get_numa_locality_top();
+    if(_reports.size() > _ntop) _reports.resize(_ntop);
+    for(auto& itr : _reports)
+        // the IP of the samples is always in the user code since the kernel is excluded
+        itr.callsite = callsite::get_label(itr.ip);
+
+    OMNITRACE_VERBOSE(0,
+                      "NUMA locality :: %zu placement functions, %lu local loads, %lu "
+                      "remote loads (%.1f%% remote)\n",
+                      _placements.size(), _total.local, _total.remote,
+                      100.0 * _total.remote_ratio());
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("numa-locality", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<numa_gotcha>{}(
+                _fname, std::string{ "numa_locality" });
+
+        auto _write_counts = [&ofs](const locality_counts& _v) {
+            ofs << std::setw(12) << _v.local << " " << std::setw(12) << _v.remote << " "
+                << std::setw(12) << _v.unknown << " " << std::setw(12)
+                << (100.0 * _v.remote_ratio());
+        };
+
+        ofs << "# page placement requests\n";
+        ofs << std::setw(24) << "function" << " " << std::setw(12) << "calls" << " "
+            << std::setw(16) << "bytes" << "   nodes\n";
+        for(auto i : _placements)
+        {
+            const auto& itr = get_placement_table().at(i);
+            ofs << std::setw(24) << placement_names.at(i) << " " << std::setw(12)
+                << itr.calls.load() << " " << std::setw(16) << itr.bytes.load() << "   "
+                << get_nodes_label(itr.nodes.load()) << "\n";
+        }
+
+        ofs << std::fixed << std::setprecision(2);
+        ofs << "\n# locality of the sampled loads per thread\n";
+        ofs << std::setw(8) << "thread" << " " << std::setw(12) << "local" << " "
+            << std::setw(12) << "remote" << " " << std::setw(12) << "unknown" << " "
+            << std::setw(12) << "remote [%]" << "\n";
+        for(const auto& itr : _threads)
+        {
+            ofs << std::setw(8) << itr.first << " ";
+            _write_counts(itr.second);
+            ofs << "\n";
+        }
+
+        ofs << "\n# call-sites with the most remote loads\n";
+        ofs << std::setw(18) << "address" << " " << std::setw(12) << "local" << " "
+            << std::setw(12) << "remote" << " " << std::setw(12) << "unknown" << " "
+            << std::setw(12) << "remote [%]" << "   call site\n";
+        for(const auto& itr : _reports)
+        {
+            ofs << std::setw(18) << JOIN("", "0x", std::hex, itr.ip) << " ";
+            _write_counts(itr.counts);
+            ofs << "   " << itr.callsite << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening NUMA locality output file: %s", _fname.c_str());
+    }
+}
+
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, void* start,
                    unsigned long len, int mode, const unsigned long* nmask,
                    unsigned long maxnode, unsigned flags)
 {
+    record_placement(_data, len, get_nodemask(nmask, maxnode));
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "start",
                                            start, "len", len, "mode", mode, "nmask",
                                            nmask, "maxnode", maxnode, "flags", flags);
@@ -129,6 +461,7 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
                    unsigned long maxnode, const unsigned long* frommask,
                    const unsigned long* tomask)
 {
+    record_placement(_data, 0, get_nodemask(tomask, maxnode));
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "pid", pid,
                                            "maxnode", maxnode, "frommask", frommask,
                                            "tomask", tomask);
@@ -139,6 +472,9 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
                    unsigned long count, void** pages, const int* nodes, int* status,
                    int flags)
 {
+    // the pages are only queried when the target nodes are not provided
+    if(nodes)
+        record_placement(_data, count * get_page_size(), get_nodemask(nodes, count));
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "pid", pid,
                                            "count", count, "pages", pages, "nodes", nodes,
                                            "status", status, "flags", flags);
@@ -148,14 +484,25 @@ void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int pid,
                    struct bitmask* from, struct bitmask* to)
 {
+    record_placement(_data, 0, 0);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "pid", pid,
                                            "from", JOIN("", from).c_str(), "to",
                                            JOIN("", to).c_str());
 }
 
+void
+numa_gotcha::audit(const gotcha_data& _data, audit::incoming, int mode,
+                   const unsigned long* nmask, unsigned long maxnode)
+{
+    record_placement(_data, 0, get_nodemask(nmask, maxnode));
+    category_region<category::numa>::start(std::string_view{ _data.tool_id }, "mode",
+                                           mode, "nmask", nmask, "maxnode", maxnode);
+}
+
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, size_t _size)
 {
+    record_placement(_data, _size, 0);
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "size",
                                            _size);
 }
@@ -163,6 +510,7 @@ numa_gotcha::audit(const gotcha_data& _data, audit::incoming, size_t _size)
 void
 numa_gotcha::audit(const gotcha_data& _data, audit::incoming, size_t _size, int _node)
 {
+    record_placement(_data, _size, get_nodemask(&_node, 1));
     category_region<category::numa>::start(std::string_view{ _data.tool_id }, "size",
                                            _size, "node", _node);
 }
@@ -38,7 +38,7 @@ namespace component
 {
 struct numa_gotcha : tim::component::base<numa_gotcha, void>
 {
-    static constexpr size_t gotcha_capacity = 11;
+    static constexpr size_t gotcha_capacity = 12;
 
     using gotcha_data  = tim::component::gotcha_data;
     using exit_func_t  = void (*)(int);
@@ -56,6 +56,13 @@ struct numa_gotcha : tim::component::base<numa_gotcha, void>
     static void start();
     static void stop();
 
+    // records the NUMA locality of a sampled load of the thread
+    static void record_sample(int64_t _tid, uintptr_t _ip, uint64_t _addr,
+                              uint32_t _cpu);
+
+    // writes the page placement requests and the remote access ratios
+    static void post_process();
+
     static void audit(const gotcha_data&, audit::incoming, void* start, unsigned long len,
                       int mode, const unsigned long* nmask, unsigned long maxnode,
                       unsigned flags);
@@ -65,6 +72,8 @@ struct numa_gotcha : tim::component::base<numa_gotcha, void>
                       void** pages, const int* nodes, int* status, int flags);
     static void audit(const gotcha_data&, audit::incoming, int pid, struct bitmask* from,
                       struct bitmask* to);
+    static void audit(const gotcha_data&, audit::incoming, int mode,
+                      const unsigned long* nmask, unsigned long maxnode);
     static void audit(const gotcha_data&, audit::incoming, size_t);
     static void audit(const gotcha_data&, audit::incoming, size_t, int);
     static void audit(const gotcha_data&, audit::incoming, void*, size_t);
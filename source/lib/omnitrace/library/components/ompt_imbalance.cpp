@@ -0,0 +1,310 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/components/ompt_imbalance.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "library/callsite.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace ompt_metrics
+{
+namespace
+{
+struct thread_work
+{
+    uint64_t beg_ns  = 0;
+    uint64_t end_ns  = 0;
+    uint64_t wait_ns = 0;
+};
+
+// one instance of a parallel region
+struct parallel_region
+{
+    const std::string*       label    = nullptr;
+    int64_t                  tid      = 0;  // encountering thread
+    uint64_t                 beg_ns   = 0;
+    uint32_t                 reported = 0;
+    std::mutex               mutex    = {};
+    std::vector<thread_work> threads  = {};  // indexed by the implicit task index
+};
+
+using region_ptr_t = std::shared_ptr<parallel_region>;
+
+struct registry
+{
+    std::mutex                                    mutex   = {};
+    std::unordered_map<const void*, region_ptr_t> regions = {};  // parallel data
+    std::unordered_map<const void*, std::string>  labels  = {};  // codeptr
+};
+
+auto&
+get_registry()
+{
+    static auto* _v = new registry{};
+    return *_v;
+}
+
+// implicit task of this thread. These are stacked for nested parallelism
+struct implicit_task
+{
+    region_ptr_t region   = {};
+    uint32_t     index    = 0;
+    uint64_t     beg_ns   = 0;
+    uint64_t     wait_ns  = 0;
+    uint64_t     wait_beg = 0;
+};
+
+auto&
+get_implicit_tasks()
+{
+    static thread_local auto _v = std::vector<implicit_task>{};
+    return _v;
+}
+
+uint64_t
+get_timestamp()
+{
+    return tracing::now();
+}
+
+// lock must be held
+const std::string*
+get_label(registry& _data, const void* _codeptr)
+{
+    auto itr = _data.labels.find(_codeptr);
+    if(itr == _data.labels.end())
+    {
+        auto _label = callsite::get_label("omp_parallel", _codeptr);
+        itr         = _data.labels.emplace(_codeptr, std::move(_label)).first;
+    }
+    return &itr->second;
+}
+
+uint64_t
+get_duration(const thread_work& _v)
+{
+    return (_v.end_ns > _v.beg_ns) ? (_v.end_ns - _v.beg_ns) : 0;
+}
+
+// invoked by the thread which finished the last implicit task of the instance
+void
+report(const parallel_region& _region, const std::vector<thread_work>& _threads)
+{
+    auto _nthreads = _threads.size();
+    if(_nthreads == 0) return;
+
+    auto _end_ns = _region.beg_ns;
+    auto _sum    = 0.0;
+    auto _max    = 0.0;
+    for(const auto& itr : _threads)
+    {
+        auto _duration = get_duration(itr);
+        auto _value = static_cast<double>(_duration - std::min(_duration, itr.wait_ns));
+        _sum += _value;
+        _max    = std::max(_max, _value);
+        _end_ns = std::max(_end_ns, itr.end_ns);
+    }
+
+    auto _mean      = _sum / static_cast<double>(_nthreads);
+    auto _imbalance = _max - _mean;
+    // percent imbalance: how much longer the slowest thread worked than the average
+    auto _imbalance_pct = (_mean > 0.0) ? (100.0 * _imbalance / _mean) : 0.0;
+
+    if(get_use_timemory() && trait::runtime_enabled<omp_imbalance_data>::get())
+    {
+        // the instance may be completed by any thread of the team so the entry is flat
+        tim::auto_tuple<omp_imbalance_data>{ *_region.label, tim::scope::flat{} }.store(
+            std::plus<double>{}, _imbalance);
+    }
+
+    if(get_use_perfetto())
+    {
+        auto _track_desc = [](int64_t _tid) {
+            return JOIN("", "OpenMP Imbalance [Thread ", _tid, "]");
+        };
+        const auto _track =
+            tracing::get_perfetto_track(category::ompt{}, _track_desc, _region.tid);
+
+        tracing::push_perfetto_track(
+            category::ompt{}, _region.label->c_str(), _track, _region.beg_ns,
+            [&](::perfetto::EventContext ctx) {
+                tracing::add_perfetto_annotation(ctx, "nthreads", _nthreads);
+                tracing::add_perfetto_annotation(ctx, "max_work_ns", _max);
+                tracing::add_perfetto_annotation(ctx, "mean_work_ns", _mean);
+                tracing::add_perfetto_annotation(ctx, "imbalance_ns", _imbalance);
+                tracing::add_perfetto_annotation(ctx, "imbalance_pct", _imbalance_pct);
+                for(size_t i = 0; i < _nthreads; ++i)
+                {
+                    auto _duration = get_duration(_threads.at(i));
+                    auto _fraction =
+                        (_duration > 0)
+                            ? (static_cast<double>(_threads.at(i).wait_ns) / _duration)
+                            : 0.0;
+                    tracing::add_perfetto_annotation(
+                        ctx, JOIN("", "thread_", i, "_wait_fraction"), _fraction);
+                }
+            });
+        tracing::pop_perfetto_track(category::ompt{}, "", _track, _end_ns);
+    }
+}
+}  // namespace
+
+void
+setup()
+{
+    omp_imbalance_data::label()       = "omp_imbalance";
+    omp_imbalance_data::description() = "Max minus mean of the thread work in OpenMP "
+                                        "parallel regions";
+
+    omp_wait_fraction_data::label()        = "omp_wait_fraction";
+    omp_wait_fraction_data::description()  = "Percent of the OpenMP implicit task spent "
+                                             "waiting";
+    omp_wait_fraction_data::display_unit() = "%";
+
+    auto _enabled = get_use_timemory();
+    trait::runtime_enabled<omp_imbalance_data>::set(_enabled);
+    trait::runtime_enabled<omp_wait_fraction_data>::set(_enabled);
+}
+
+void
+parallel_begin(const void* _parallel_data, const void* _codeptr)
+{
+    if(!_parallel_data || get_state() != State::Active) return;
+
+    auto  _region = std::make_shared<parallel_region>();
+    auto& _data   = get_registry();
+    auto  _lk     = std::unique_lock<std::mutex>{ _data.mutex };
+
+    _region->label  = get_label(_data, _codeptr);
+    _region->tid    = threading::get_id();
+    _region->beg_ns = get_timestamp();
+    _data.regions[_parallel_data] = std::move(_region);
+}
+
+void
+parallel_end(const void* _parallel_data)
+{
+    auto& _data = get_registry();
+    auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+    _data.regions.erase(_parallel_data);
+}
+
+void
+implicit_task_begin(const void* _parallel_data, uint32_t _nthreads, uint32_t _index)
+{
+    auto _region = region_ptr_t{};
+    {
+        auto& _data = get_registry();
+        auto  _lk   = std::unique_lock<std::mutex>{ _data.mutex };
+        auto  itr   = _data.regions.find(_parallel_data);
+        if(itr != _data.regions.end()) _region = itr->second;
+    }
+
+    if(_region)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _region->mutex };
+        if(_region->threads.size() < _nthreads) _region->threads.resize(_nthreads);
+    }
+
+    // an entry is always pushed so that the implicit task end is balanced
+    get_implicit_tasks().emplace_back(
+        implicit_task{ std::move(_region), _index, get_timestamp(), 0, 0 });
+}
+
+void
+implicit_task_end()
+{
+    auto& _tasks = get_implicit_tasks();
+    if(_tasks.empty()) return;
+
+    auto _task = std::move(_tasks.back());
+    _tasks.pop_back();
+
+    if(!_task.region) return;
+
+    auto  _work    = thread_work{ _task.beg_ns, get_timestamp(), _task.wait_ns };
+    auto& _region  = *_task.region;
+    auto  _threads = std::vector<thread_work>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _region.mutex };
+        if(_task.index >= _region.threads.size()) _region.threads.resize(_task.index + 1);
+        _region.threads.at(_task.index) = _work;
+        if(++_region.reported == _region.threads.size())
+            std::swap(_threads, _region.threads);
+    }
+
+    if(get_use_timemory() && trait::runtime_enabled<omp_wait_fraction_data>::get() &&
+       _work.end_ns > _work.beg_ns)
+    {
+        auto _fraction = 100.0 * static_cast<double>(_work.wait_ns) /
+                         static_cast<double>(_work.end_ns - _work.beg_ns);
+        tim::auto_tuple<omp_wait_fraction_data>{ *_region.label, tim::scope::flat{} }
+            .store(std::plus<double>{}, _fraction);
+    }
+
+    if(!_threads.empty()) report(_region, _threads);
+}
+
+void
+wait_begin()
+{
+    auto& _tasks = get_implicit_tasks();
+    if(!_tasks.empty()) _tasks.back().wait_beg = get_timestamp();
+}
+
+void
+wait_end()
+{
+    auto& _tasks = get_implicit_tasks();
+    if(_tasks.empty() || _tasks.back().wait_beg == 0) return;
+
+    auto& _task = _tasks.back();
+    auto  _now  = get_timestamp();
+    if(_now > _task.wait_beg) _task.wait_ns += (_now - _task.wait_beg);
+    _task.wait_beg = 0;
+}
+}  // namespace ompt_metrics
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(omp_imbalance_data, true, double)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(omp_wait_fraction_data, true, double)
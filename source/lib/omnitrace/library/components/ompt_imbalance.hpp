@@ -0,0 +1,125 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/macros.hpp>
+
+#include <cstdint>
+#include <string>
+
+OMNITRACE_DECLARE_COMPONENT(omp_imbalance)
+OMNITRACE_DECLARE_COMPONENT(omp_wait_fraction)
+
+namespace omnitrace
+{
+namespace component
+{
+// load imbalance of the OpenMP parallel regions derived from the OMPT implicit task and
+// sync region wait callbacks. The work of a thread is the duration of its implicit
+// task minus the time it waited in barriers, taskwaits, and taskgroups. Once every
+// thread of a parallel region instance has finished its implicit task, the imbalance
+// (max - mean of the work) is stored in timemory under the label of the parallel region
+// and the instance is emitted as a perfetto slice annotated with the per-thread metrics
+struct omp_imbalance : base<omp_imbalance, void>
+{
+    static std::string label() { return "omp_imbalance"; }
+    static std::string description()
+    {
+        return "Max minus mean of the thread work in OpenMP parallel regions";
+    }
+};
+
+struct omp_wait_fraction : base<omp_wait_fraction, void>
+{
+    static std::string label() { return "omp_wait_fraction"; }
+    static std::string description()
+    {
+        return "Percent of the OpenMP implicit task spent waiting";
+    }
+};
+
+namespace ompt_metrics
+{
+// sets the labels and units of the data trackers
+void
+setup();
+
+// the parallel data pointer identifies the parallel region instance between
+// parallel_begin and parallel_end. The implicit tasks are associated with the instance
+// when they begin since the parallel data is not provided when they end
+void
+parallel_begin(const void* _parallel_data, const void* _codeptr);
+
+void
+parallel_end(const void* _parallel_data);
+
+void
+implicit_task_begin(const void* _parallel_data, uint32_t _nthreads, uint32_t _index);
+
+void
+implicit_task_end();
+
+// invoked by the sync_region_wait callbacks of the calling thread
+void
+wait_begin();
+
+void
+wait_end();
+}  // namespace ompt_metrics
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_COMPONENT_ALIAS(omp_imbalance_data,
+                          ::tim::component::data_tracker<double, omp_imbalance>)
+OMNITRACE_COMPONENT_ALIAS(omp_wait_fraction_data,
+                          ::tim::component::data_tracker<double, omp_wait_fraction>)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::omp_imbalance_data, project::omnitrace,
+                           category::timing, os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::omp_wait_fraction_data,
+                           project::omnitrace, os::supports_unix)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::omp_wait_fraction_data, double)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::omp_imbalance_data,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::omp_imbalance_data,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::omp_wait_fraction_data,
+                                false_type)
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(omp_imbalance_data, true, double)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(omp_wait_fraction_data, true, double)
+
+#endif
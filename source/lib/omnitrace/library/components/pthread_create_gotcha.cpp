@@ -29,6 +29,7 @@
 #include "library/causal/delay.hpp"
 #include "library/components/category_region.hpp"
 #include "library/components/roctracer.hpp"
+#include "library/critical_path.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
@@ -68,12 +69,15 @@ namespace
 {
 auto* is_shutdown   = new bool{ false };  // intentional data leak
 auto* bundles       = new std::map<int64_t, std::shared_ptr<bundle_t>>{};
+auto* bundle_pool   = new std::map<int64_t, std::shared_ptr<bundle_t>>{};
 auto* bundles_mutex = new std::mutex{};
 auto  bundles_dtor  = scope::destructor{ []() {
     pthread_create_gotcha::shutdown();
     delete bundles;
+    delete bundle_pool;
     delete bundles_mutex;
     bundles         = nullptr;
+    bundle_pool     = nullptr;
     bundles_mutex   = nullptr;
 } };
 
@@ -145,6 +149,68 @@ stop_bundle(bundle_t& _bundle, int64_t _tid, Args&&... _args)
     }
 }
 
+// the setup of a child thread, which is either performed when the thread starts or,
+// in the lazy mode, deferred until the thread first records data
+struct thread_setup_data
+{
+    bool                      pending    = false;
+    int64_t                   tid        = -1;
+    int64_t                   parent_tid = 0;
+    std::shared_ptr<bundle_t> bundle     = {};
+};
+
+auto&
+get_thread_setup_data()
+{
+    static thread_local auto _v = thread_setup_data{};
+    return _v;
+}
+
+void
+setup_thread(thread_setup_data& _data)
+{
+    using thread_bundle_data_t = thread_data<thread_bundle_t>;
+
+    auto _tid     = _data.tid;
+    _data.pending = false;
+
+    threading::set_thread_name(TIMEMORY_JOIN(" ", "Thread", _tid).c_str());
+    auto _manager = tim::manager::instance();
+    if(_manager) _manager->initialize();
+    if(!thread_bundle_data_t::get()->at(_tid))
+    {
+        thread_data<thread_bundle_t>::construct(
+            TIMEMORY_JOIN('/', "omnitrace/process", process::get_id(), "thread", _tid),
+            quirk::config<quirk::auto_start>{});
+        thread_bundle_data_t::get()->at(_tid)->start();
+    }
+    if(bundles && bundles_mutex)
+    {
+        std::unique_lock<std::mutex> _lk{ *bundles_mutex };
+        // when the thread ids are recycled, the bundle of the previous thread with
+        // this id is reused instead of allocating a new one
+        auto _pooled = std::shared_ptr<bundle_t>{};
+        if(bundle_pool)
+        {
+            auto _pitr = bundle_pool->find(_tid);
+            if(_pitr != bundle_pool->end())
+            {
+                _pooled = std::move(_pitr->second);
+                bundle_pool->erase(_pitr);
+            }
+        }
+
+        if(_pooled)
+            *_pooled = bundle_t{ "start_thread" };
+        else
+            _pooled = std::make_shared<bundle_t>("start_thread");
+
+        _data.bundle = bundles->emplace(_tid, std::move(_pooled)).first->second;
+    }
+    if(_data.bundle) start_bundle(*_data.bundle, _tid);
+    get_cpu_cid_stack(_tid, _data.parent_tid);
+}
+
 using native_handle_set_t = std::set<pthread_create_gotcha::native_handle_t>;
 
 auto native_handles          = native_handle_set_t{};
@@ -166,6 +232,8 @@ pthread_create_gotcha::wrapper::operator()() const
 {
     using thread_bundle_data_t = thread_data<thread_bundle_t>;
 
+    static bool _lazy_setup = config::get_thread_lazy_setup();
+
     if(is_shutdown && *is_shutdown)
     {
         if(m_config.promise) m_config.promise->set_value();
@@ -178,7 +246,7 @@ pthread_create_gotcha::wrapper::operator()() const
     int64_t     _tid         = -1;
     void*       _ret         = nullptr;
     auto        _is_sampling = false;
-    auto        _bundle      = std::shared_ptr<bundle_t>{};
+    auto&       _setup       = get_thread_setup_data();
     auto        _signals     = std::set<int>{};
     auto        _coverage    = (get_mode() == Mode::Coverage);
     const auto& _parent_info = thread_info::get(m_config.parent_tid, InternalTID);
@@ -204,12 +272,15 @@ pthread_create_gotcha::wrapper::operator()() const
             auto _active = (get_state() == ::omnitrace::State::Active &&
                             bundles != nullptr && bundles_mutex != nullptr);
             if(!_active) return;
+            if(critical_path::is_enabled()) critical_path::thread_stop();
             thread_info::set_stop(comp::wall_clock::record());
             auto& _thr_bundle = thread_bundle_data_t::instance();
             if(_thr_bundle && _thr_bundle->get<comp::wall_clock>() &&
                _thr_bundle->get<comp::wall_clock>()->get_is_running())
                 _thr_bundle->stop();
-            if(_bundle) stop_bundle(*_bundle, _tid);
+            if(_setup.bundle) stop_bundle(*_setup.bundle, _tid);
+            _setup.bundle.reset();
+            _setup.pending = false;
             pthread_create_gotcha::shutdown(_tid);
             OMNITRACE_BASIC_VERBOSE(
                 1, "[PID=%i][rank=%i] Thread %s (parent: %s) exited\n", process::get_id(),
@@ -234,25 +305,19 @@ pthread_create_gotcha::wrapper::operator()() const
                                 process::get_id(), dmp::rank(),
                                 _info->index_data->as_string().c_str(),
                                 _parent_info->index_data->as_string().c_str());
-        threading::set_thread_name(TIMEMORY_JOIN(" ", "Thread", _tid).c_str());
-        auto _manager = tim::manager::instance();
-        if(_manager) _manager->initialize();
-        if(!thread_bundle_data_t::get()->at(_tid))
-        {
-            thread_data<thread_bundle_t>::construct(
-                TIMEMORY_JOIN('/', "omnitrace/process", process::get_id(), "thread",
-                              _tid),
-                quirk::config<quirk::auto_start>{});
-            thread_bundle_data_t::get()->at(_tid)->start();
-        }
-        if(bundles && bundles_mutex)
-        {
-            std::unique_lock<std::mutex> _lk{ *bundles_mutex };
-            _bundle = bundles->emplace(_tid, std::make_shared<bundle_t>("start_thread"))
-                          .first->second;
-        }
-        if(_bundle) start_bundle(*_bundle, _tid);
-        get_cpu_cid_stack(_tid, m_config.parent_tid);
+        _setup.tid        = _tid;
+        _setup.parent_tid = m_config.parent_tid;
+        // the sampler records data from the start of the thread so sampled threads
+        // are never set up lazily
+        if(_lazy_setup && !m_config.enable_causal && !m_config.enable_sampling)
+            _setup.pending = true;
+        else
+            setup_thread(_setup);
+
+        if(critical_path::is_enabled() && _parent_info && _parent_info->index_data)
+            critical_path::thread_start(_parent_info->index_data->sequent_value,
+                                        m_config.create_ts);
+
         if(m_config.enable_causal)
         {
             // children inherit the parent delay data
@@ -484,11 +549,25 @@ pthread_create_gotcha::shutdown(int64_t _tid)
     if(itr != bundles->end())
     {
         if(itr->second) stop_bundle(*itr->second, itr->first);
+        if(itr->second && bundle_pool && threading::recycle_ids())
+            (*bundle_pool)[_tid] = std::move(itr->second);
         itr->second.reset();
         bundles->erase(itr);
     }
 }
 
+void
+pthread_create_gotcha::lazy_setup()
+{
+    auto& _setup = get_thread_setup_data();
+    if(!_setup.pending || _setup.tid < 0) return;
+    if(get_state() != ::omnitrace::State::Active || !bundles || !bundles_mutex) return;
+
+    OMNITRACE_BASIC_VERBOSE(3, "[PID=%i][rank=%i] Deferred setup of thread %li...\n",
+                            process::get_id(), dmp::rank(), _setup.tid);
+    setup_thread(_setup);
+}
+
 void
 pthread_create_gotcha::set_data(wrappee_t _v)
 {
@@ -572,8 +651,8 @@ pthread_create_gotcha::operator()(pthread_t* thread, const pthread_attr_t* attr,
     set_thread_state(ThreadState::Disabled);
     auto _blocked = get_sampling_signals();
     auto _promise = (_active) ? std::make_shared<std::promise<void>>() : promise_t{};
-    auto _config =
-        wrapper_config{ _enable_causal, _enable_sampling, _offset, _tid, _promise };
+    auto _config = wrapper_config{ _enable_causal, _enable_sampling, _offset,
+                                  _tid,           _promise,         tracing::now() };
     auto* _wrap = new wrapper{ func, arg, _config };
     set_thread_state(ThreadState::Internal);
 
@@ -52,6 +52,7 @@ struct pthread_create_gotcha : tim::component::base<pthread_create_gotcha, void>
         bool      offset          = false;
         int64_t   parent_tid      = 0;
         promise_t promise         = {};
+        uint64_t  create_ts       = 0;
     };
 
     struct wrapper
@@ -77,6 +78,10 @@ struct pthread_create_gotcha : tim::component::base<pthread_create_gotcha, void>
     static void shutdown();
     static void shutdown(int64_t);
 
+    // performs the setup of the calling thread which was deferred in the
+    // OMNITRACE_THREAD_LAZY_SETUP mode. Invoked when the thread first records data
+    static void lazy_setup();
+
     // pthread_create
     int operator()(pthread_t* thread, const pthread_attr_t* attr,
                    void* (*start_routine)(void*), void*     arg) const;
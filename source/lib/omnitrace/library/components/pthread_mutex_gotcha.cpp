@@ -24,22 +24,178 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/utility.hpp"
+#include "library/callsite.hpp"
 #include "library/components/category_region.hpp"
+#include "library/critical_path.hpp"
 #include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/tracing.hpp"
 
 #include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/signals.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
 #include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
 #include <pthread.h>
 #include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 namespace omnitrace
 {
 namespace component
 {
+namespace
+{
+constexpr size_t callsite_depth        = 16;
+constexpr size_t callsite_ignore_depth = 2;
+
+using callsite_frames_t = std::array<uintptr_t, callsite_depth>;
+
+// acquisitions of the locks by one thread in the contention-only and profile modes.
+// Linear probing on the lock address, which is never zero, and the table is doubled
+// when half full
+struct lock_table
+{
+    struct entry
+    {
+        uintptr_t         addr        = 0;
+        uint64_t          uncontended = 0;
+        uint64_t          contended   = 0;
+        uint64_t          wait        = 0;
+        uint64_t          max_wait    = 0;
+        uint64_t          hold        = 0;
+        uint64_t          first       = 0;  // timestamp of the first acquisition
+        uint64_t          acquired    = 0;  // timestamp of the outermost acquisition
+        uint32_t          depth       = 0;  // recursive and shared acquisitions
+        callsite_frames_t frames      = {};  // call stack of the first acquisition
+    };
+
+    entry* lookup(uintptr_t _addr)
+    {
+        auto _mask = entries.size() - 1;
+        for(size_t i = hash(_addr) & _mask;; i = (i + 1) & _mask)
+        {
+            auto& itr = entries[i];
+            if(itr.addr == _addr) return &itr;
+            if(itr.addr == 0) return nullptr;
+        }
+    }
+
+    entry& find(uintptr_t _addr)
+    {
+        if(2 * (size + 1) > entries.size()) grow();
+        auto _mask = entries.size() - 1;
+        for(size_t i = hash(_addr) & _mask;; i = (i + 1) & _mask)
+        {
+            auto& itr = entries[i];
+            if(itr.addr == _addr) return itr;
+            if(itr.addr == 0)
+            {
+                ++size;
+                itr.addr = _addr;
+                return itr;
+            }
+        }
+    }
+
+    size_t             size    = 0;
+    std::vector<entry> entries = std::vector<entry>(64);
+
+private:
+    static size_t hash(uintptr_t _addr) { return (_addr >> 3) * 0x9E3779B97F4A7C15ULL; }
+
+    void grow()
+    {
+        auto _prev = std::vector<entry>(2 * entries.size());
+        std::swap(_prev, entries);
+        size = 0;
+        for(const auto& itr : _prev)
+            if(itr.addr != 0) find(itr.addr) = itr;
+    }
+};
+
+auto&
+get_lock_table(int64_t _tid = threading::get_id())
+{
+    using thread_data_t = thread_data<lock_table, category::pthread>;
+    return thread_data_t::instance(construct_on_thread{ _tid });
+}
+
+bool
+use_contention_only()
+{
+    static bool _v = config::get_trace_thread_locks_contention_only();
+    return _v;
+}
+
+bool
+use_lock_profile()
+{
+    static bool _v = config::get_trace_thread_locks_profile();
+    return _v;
+}
+
+callsite_frames_t
+get_callsite_frames()
+{
+    auto   _frames = callsite_frames_t{};
+    auto   _stack  = tim::get_unw_stack<callsite_depth, callsite_ignore_depth, false>();
+    size_t _n      = 0;
+    for(auto itr : _stack)
+    {
+        if(itr && _n < _frames.size()) _frames.at(_n++) = itr->address();
+    }
+    return _frames;
+}
+
+void
+record_acquisition(lock_table::entry& _entry, uint64_t _ts, uint64_t _wait,
+                   bool _contended)
+{
+    if(_contended)
+    {
+        ++_entry.contended;
+        _entry.wait += _wait;
+        _entry.max_wait = std::max(_entry.max_wait, _wait);
+    }
+    else
+    {
+        ++_entry.uncontended;
+    }
+
+    if(!use_lock_profile()) return;
+
+    if(_entry.first == 0)
+    {
+        _entry.first  = _ts;
+        _entry.frames = get_callsite_frames();
+    }
+    if(_entry.depth++ == 0) _entry.acquired = _ts;
+}
+
+void
+record_release(lock_table::entry* _entry, uint64_t _ts)
+{
+    if(_entry && _entry->depth > 0 && --_entry->depth == 0)
+        _entry->hold += (_ts - _entry->acquired);
+}
+}  // namespace
+
 pthread_mutex_gotcha::hash_array_t&
 pthread_mutex_gotcha::get_hashes()
 {
@@ -68,6 +224,12 @@ pthread_mutex_gotcha::get_hashes()
         }
         if(!config::get_trace_thread_barriers()) _skip.emplace(8);
         if(!config::get_trace_thread_join()) _skip.emplace(12);
+        if(config::get_trace_thread_locks_contention_only() &&
+           !config::get_trace_thread_locks_profile())
+        {
+            for(size_t i : { 1, 2, 5, 6, 7, 10, 11 })
+                _skip.emplace(i);
+        }
         for(size_t i = 0; i < gotcha_capacity; ++i)
         {
             auto&& _id = _data.at(i).tool_id;
@@ -93,14 +255,27 @@ pthread_mutex_gotcha::get_hashes()
 void
 pthread_mutex_gotcha::configure()
 {
+    lock_profile_data::label()       = "lock_profile";
+    lock_profile_data::description() = "Wait and hold time of the hottest pthread locks";
+
     pthread_mutex_gotcha_t::get_initializer() = []() {
         if(!tim::settings::enabled() || get_use_causal()) return;
 
+        // in the contention-only mode, the unlock and trylock functions are not
+        // wrapped since they never wait, unless they are needed for the hold times or
+        // the unlocks are needed for the critical path
+        bool _all = !config::get_trace_thread_locks_contention_only() ||
+                    config::get_trace_thread_locks_profile() ||
+                    critical_path::is_enabled();
+
         if(config::get_trace_thread_locks())
         {
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<0, int, pthread_mutex_t*>{ "pthread_mutex_lock" });
+        }
 
+        if(config::get_trace_thread_locks() && _all)
+        {
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<1, int, pthread_mutex_t*>{ "pthread_mutex_unlock" });
 
@@ -117,7 +292,10 @@ pthread_mutex_gotcha::configure()
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<4, int, pthread_rwlock_t*>{
                     "pthread_rwlock_wrlock" });
+        }
 
+        if(config::get_trace_thread_rwlocks() && _all)
+        {
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<5, int, pthread_rwlock_t*>{
                     "pthread_rwlock_tryrdlock" });
@@ -142,7 +320,10 @@ pthread_mutex_gotcha::configure()
         {
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<9, int, pthread_spinlock_t*>{ "pthread_spin_lock" });
+        }
 
+        if(config::get_trace_thread_spin_locks() && _all)
+        {
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<10, int, pthread_spinlock_t*>{
                     "pthread_spin_trylock" });
@@ -166,9 +347,170 @@ pthread_mutex_gotcha::shutdown()
     pthread_mutex_gotcha_t::disable();
 }
 
+void
+pthread_mutex_gotcha::post_process()
+{
+    using thread_data_t = thread_data<lock_table, category::pthread>;
+
+    struct lock_report
+    {
+        uintptr_t         addr        = 0;
+        size_t            threads     = 0;
+        uint64_t          uncontended = 0;
+        uint64_t          contended   = 0;
+        uint64_t          wait        = 0;
+        uint64_t          max_wait    = 0;
+        uint64_t          hold        = 0;
+        uint64_t          first       = 0;
+        callsite_frames_t frames      = {};
+        std::string       callsite    = {};
+    };
+
+    auto* _data = thread_data_t::get();
+    if(!_data) return;
+
+    // the gotchas are disabled at this point so the tables can be merged on this thread
+    auto _locks = std::map<uintptr_t, lock_report>{};
+    for(const auto& titr : *_data)
+    {
+        if(!titr) continue;
+        for(const auto& itr : titr->entries)
+        {
+            if(itr.addr == 0 || itr.uncontended + itr.contended == 0) continue;
+            auto& _lock = _locks[itr.addr];
+            _lock.addr  = itr.addr;
+            _lock.threads += 1;
+            _lock.uncontended += itr.uncontended;
+            _lock.contended += itr.contended;
+            _lock.wait += itr.wait;
+            _lock.hold += itr.hold;
+            _lock.max_wait = std::max(_lock.max_wait, itr.max_wait);
+            // the call site of the lock is where it was first acquired by any thread
+            if(itr.first > 0 && (_lock.first == 0 || itr.first < _lock.first))
+            {
+                _lock.first  = itr.first;
+                _lock.frames = itr.frames;
+            }
+        }
+    }
+
+    if(_locks.empty()) return;
+
+    auto _reports = std::vector<lock_report>{};
+    _reports.reserve(_locks.size());
+    for(const auto& itr : _locks)
+        _reports.emplace_back(itr.second);
+
+    std::sort(_reports.begin(), _reports.end(),
+              [](const lock_report& _lhs, const lock_report& _rhs) {
+                  return std::tie(_lhs.wait, _lhs.hold, _lhs.contended) >
+                         std::tie(_rhs.wait, _rhs.hold, _rhs.contended);
+              });
+
+    auto _ntop = config::get_trace_thread_locks_top();
+
+    // resolving the call sites is expensive so only the hottest locks are resolved
+    bool _profile = config::get_trace_thread_locks_profile();
+    if(_profile)
+    {
+        for(size_t i = 0; i < std::min(_ntop, _reports.size()); ++i)
+            _reports.at(i).callsite = callsite::get_caller_label(_reports.at(i).frames);
+    }
+
+    if(_profile && get_use_timemory() && trait::runtime_enabled<lock_profile_data>::get())
+    {
+        using tracker_t = tim::auto_tuple<lock_profile_data>;
+
+        for(size_t i = 0; i < std::min(_ntop, _reports.size()); ++i)
+        {
+            const auto& itr   = _reports.at(i);
+            auto        _name = JOIN("", "lock 0x", std::hex, itr.addr, std::dec,
+                                     " [acquisitions=", itr.uncontended + itr.contended,
+                                     ", contended=", itr.contended, "] ", itr.callsite);
+            tracker_t{ JOIN('/', _name, "wait") }.store(std::plus<double>{},
+                                                        static_cast<double>(itr.wait));
+            tracker_t{ JOIN('/', _name, "hold") }.store(std::plus<double>{},
+                                                        static_cast<double>(itr.hold));
+        }
+    }
+
+    uint64_t _uncontended = 0;
+    uint64_t _contended   = 0;
+    for(const auto& itr : _reports)
+    {
+        _uncontended += itr.uncontended;
+        _contended += itr.contended;
+    }
+
+    OMNITRACE_VERBOSE(0,
+                      "Lock contention :: %zu locks, %lu acquisitions, %lu contended\n",
+                      _reports.size(), _uncontended + _contended, _contended);
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("lock-contention", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<pthread_mutex_gotcha>{}(
+                _fname, std::string{ "lock_contention" });
+
+        auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / units::msec; };
+        auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+
+        ofs << std::setw(18) << "lock" << " " << std::setw(8) << "threads" << " "
+            << std::setw(14) << "acquisitions" << " " << std::setw(12) << "contended"
+            << " " << std::setw(14) << "wait [msec]" << " " << std::setw(16)
+            << "max wait [usec]";
+        if(_profile) ofs << " " << std::setw(14) << "hold [msec]" << "   call site";
+        ofs << "\n";
+        ofs << std::fixed << std::setprecision(3);
+        for(const auto& itr : _reports)
+        {
+            ofs << std::setw(18) << JOIN("", "0x", std::hex, itr.addr) << " "
+                << std::setw(8) << itr.threads << " " << std::setw(14)
+                << (itr.uncontended + itr.contended) << " " << std::setw(12)
+                << itr.contended << " " << std::setw(14) << _msec(itr.wait) << " "
+                << std::setw(16) << _usec(itr.max_wait);
+            if(_profile)
+                ofs << " " << std::setw(14) << _msec(itr.hold) << "   " << itr.callsite;
+            ofs << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening lock contention output file: %s", _fname.c_str());
+    }
+}
+
 pthread_mutex_gotcha::pthread_mutex_gotcha(const gotcha_data_t& _data)
 : m_data{ &_data }
-{}
+{
+    const auto& _id = _data.tool_id;
+    bool _critical_path = critical_path::is_enabled();
+    if(use_contention_only() || use_lock_profile() || _critical_path)
+    {
+        if(_id == "pthread_mutex_lock")
+            m_role = ROLE_MUTEX_LOCK;
+        else if(_id == "pthread_rwlock_rdlock")
+            m_role = ROLE_RDLOCK;
+        else if(_id == "pthread_rwlock_wrlock")
+            m_role = ROLE_WRLOCK;
+        else if(_id == "pthread_spin_lock")
+            m_role = ROLE_SPIN_LOCK;
+    }
+
+    if(use_lock_profile() || _critical_path)
+    {
+        if(_id == "pthread_mutex_trylock" || _id == "pthread_rwlock_tryrdlock" ||
+           _id == "pthread_rwlock_trywrlock" || _id == "pthread_spin_trylock")
+            m_role = ROLE_TRYLOCK;
+        else if(_id == "pthread_mutex_unlock" || _id == "pthread_rwlock_unlock" ||
+                _id == "pthread_spin_unlock")
+            m_role = ROLE_UNLOCK;
+    }
+}
 
 template <typename... Args>
 auto
@@ -206,11 +548,143 @@ pthread_mutex_gotcha::operator()(uintptr_t&&, int (*_callee)(Args...),
     return _ret;
 }
 
+template <typename LockT>
+int
+pthread_mutex_gotcha::acquire(int (*_callee)(LockT*), int (*_trylock)(LockT*),
+                              LockT* _lock) const
+{
+    using bundle_t = category_region<category::pthread>;
+
+    if(is_disabled() || !_lock) return (*_callee)(_lock);
+
+    struct local_dtor
+    {
+        explicit local_dtor(bool& _v)
+        : _protect{ _v }
+        {}
+        ~local_dtor() { _protect = false; }
+        bool& _protect;
+    } _dtor{ m_protect = true };
+
+    static thread_local auto& _table = get_lock_table();
+
+    // in the contention-only mode, the region only spans the blocking wait
+    bool _trace = !use_contention_only();
+    auto _addr  = reinterpret_cast<uintptr_t>(_lock);
+    auto _name  = std::string_view{ m_data->tool_id };
+
+    if(_trace) bundle_t::audit(_name, audit::incoming{}, _lock);
+
+    // anything other than EBUSY is either an acquisition (including EOWNERDEAD for
+    // robust mutexes) or an error which the blocking function would also return
+    auto _ret = (*_trylock)(_lock);
+    if(_ret != EBUSY)
+    {
+        if(_ret == 0 || _ret == EOWNERDEAD)
+            record_acquisition(_table->find(_addr), tracing::now(), 0, false);
+        if(_trace) bundle_t::audit(_name, audit::outgoing{}, _ret);
+        return _ret;
+    }
+
+    // the thread is parked in the blocking acquisition unless it is a spin lock
+    constexpr bool _parks = !std::is_same<LockT, pthread_spinlock_t>::value;
+
+    auto _beg = tracing::now();
+    if(!_trace) bundle_t::audit(_name, audit::incoming{}, _lock);
+    if(_parks) sampling::suspend_idle();
+    _ret = (*_callee)(_lock);
+    if(_parks) sampling::resume_idle();
+    bundle_t::audit(_name, audit::outgoing{}, _ret);
+    auto _end = tracing::now();
+
+    if(_ret == 0 || _ret == EOWNERDEAD)
+    {
+        record_acquisition(_table->find(_addr), _end, _end - _beg, true);
+        if(critical_path::is_enabled())
+            critical_path::wait(critical_path::get_key(critical_path::SYNC_LOCK, _addr),
+                                _beg, _end);
+    }
+
+    return _ret;
+}
+
+template <typename LockT>
+int
+pthread_mutex_gotcha::try_acquire(int (*_callee)(LockT*), LockT* _lock) const
+{
+    using bundle_t = category_region<category::pthread>;
+
+    if(is_disabled() || !_lock) return (*_callee)(_lock);
+
+    struct local_dtor
+    {
+        explicit local_dtor(bool& _v)
+        : _protect{ _v }
+        {}
+        ~local_dtor() { _protect = false; }
+        bool& _protect;
+    } _dtor{ m_protect = true };
+
+    static thread_local auto& _table = get_lock_table();
+
+    bool _trace = !use_contention_only();
+    auto _name  = std::string_view{ m_data->tool_id };
+
+    if(_trace) bundle_t::audit(_name, audit::incoming{}, _lock);
+    auto _ret = (*_callee)(_lock);
+    if(_ret == 0 || _ret == EOWNERDEAD)
+        record_acquisition(_table->find(reinterpret_cast<uintptr_t>(_lock)),
+                           tracing::now(), 0, false);
+    if(_trace) bundle_t::audit(_name, audit::outgoing{}, _ret);
+
+    return _ret;
+}
+
+template <typename LockT>
+int
+pthread_mutex_gotcha::release(int (*_callee)(LockT*), LockT* _lock) const
+{
+    using bundle_t = category_region<category::pthread>;
+
+    if(is_disabled() || !_lock) return (*_callee)(_lock);
+
+    struct local_dtor
+    {
+        explicit local_dtor(bool& _v)
+        : _protect{ _v }
+        {}
+        ~local_dtor() { _protect = false; }
+        bool& _protect;
+    } _dtor{ m_protect = true };
+
+    static thread_local auto& _table = get_lock_table();
+
+    bool _trace = !use_contention_only();
+    auto _name  = std::string_view{ m_data->tool_id };
+
+    auto _addr = reinterpret_cast<uintptr_t>(_lock);
+    auto _ts   = tracing::now();
+
+    if(_trace) bundle_t::audit(_name, audit::incoming{}, _lock);
+    record_release(_table->lookup(_addr), _ts);
+    if(critical_path::is_enabled())
+        critical_path::signal(critical_path::get_key(critical_path::SYNC_LOCK, _addr),
+                              _ts);
+    auto _ret = (*_callee)(_lock);
+    if(_trace) bundle_t::audit(_name, audit::outgoing{}, _ret);
+
+    return _ret;
+}
+
 int
 pthread_mutex_gotcha::operator()(int (*_callee)(pthread_mutex_t*),
                                  pthread_mutex_t* _mutex) const
 {
     if(get_state() != ::omnitrace::State::Active || m_protect) return (*_callee)(_mutex);
+    if(m_role == ROLE_MUTEX_LOCK)
+        return acquire(_callee, &::pthread_mutex_trylock, _mutex);
+    if(m_role == ROLE_TRYLOCK) return try_acquire(_callee, _mutex);
+    if(m_role == ROLE_UNLOCK) return release(_callee, _mutex);
     return (*this)(reinterpret_cast<uintptr_t>(_mutex), _callee, _mutex);
 }
 
@@ -219,6 +693,9 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_spinlock_t*),
                                  pthread_spinlock_t* _lock) const
 {
     if(get_state() != ::omnitrace::State::Active || m_protect) return (*_callee)(_lock);
+    if(m_role == ROLE_SPIN_LOCK) return acquire(_callee, &::pthread_spin_trylock, _lock);
+    if(m_role == ROLE_TRYLOCK) return try_acquire(_callee, _lock);
+    if(m_role == ROLE_UNLOCK) return release(_callee, _lock);
     return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _lock);
 }
 
@@ -227,6 +704,10 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_rwlock_t*),
                                  pthread_rwlock_t* _lock) const
 {
     if(get_state() != ::omnitrace::State::Active || m_protect) return (*_callee)(_lock);
+    if(m_role == ROLE_RDLOCK) return acquire(_callee, &::pthread_rwlock_tryrdlock, _lock);
+    if(m_role == ROLE_WRLOCK) return acquire(_callee, &::pthread_rwlock_trywrlock, _lock);
+    if(m_role == ROLE_TRYLOCK) return try_acquire(_callee, _lock);
+    if(m_role == ROLE_UNLOCK) return release(_callee, _lock);
     return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _lock);
 }
 
@@ -236,7 +717,22 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_barrier_t*),
 {
     if(get_state() != ::omnitrace::State::Active || m_protect)
         return (*_callee)(_barrier);
-    return (*this)(reinterpret_cast<uintptr_t>(_barrier), _callee, _barrier);
+
+    auto _beg = tracing::now();
+    sampling::suspend_idle();
+    auto _ret = (*this)(reinterpret_cast<uintptr_t>(_barrier), _callee, _barrier);
+    sampling::resume_idle();
+
+    // every thread arriving at the barrier signals it so the last arrival releases
+    // the waiters
+    if(critical_path::is_enabled())
+    {
+        auto _key = critical_path::get_key(critical_path::SYNC_BARRIER,
+                                           reinterpret_cast<uintptr_t>(_barrier));
+        critical_path::signal(_key, _beg);
+        critical_path::wait(_key, _beg, tracing::now());
+    }
+    return _ret;
 }
 
 int
@@ -245,7 +741,24 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_t, void**), pthread_t _t
 {
     if(get_state() != ::omnitrace::State::Active || m_protect)
         return (*_callee)(_thr, _tinfo);
-    return (*this)(static_cast<uintptr_t>(threading::get_id()), _callee, _thr, _tinfo);
+
+    // the thread info must be looked up before the thread is joined
+    int64_t _child = -1;
+    if(critical_path::is_enabled())
+    {
+        const auto& _info = thread_info::get(_thr);
+        if(_info && _info->index_data) _child = _info->index_data->sequent_value;
+    }
+
+    auto _beg = tracing::now();
+    sampling::suspend_idle();
+    auto _ret =
+        (*this)(static_cast<uintptr_t>(threading::get_id()), _callee, _thr, _tinfo);
+    sampling::resume_idle();
+
+    if(_ret == 0 && _child >= 0)
+        critical_path::thread_join(_child, _beg, tracing::now());
+    return _ret;
 }
 
 bool
@@ -275,3 +788,5 @@ static_data<pthread_mutex_gotcha, pthread_mutex_gotcha_t>::operator()(
 }
 }  // namespace policy
 }  // namespace tim
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(lock_profile_data, true, double)
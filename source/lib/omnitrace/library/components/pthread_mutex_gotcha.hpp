@@ -26,11 +26,13 @@
 #include "core/defines.hpp"
 #include "core/timemory.hpp"
 
+#include <timemory/components/data_tracker/components.hpp>
 #include <timemory/components/gotcha/backends.hpp>
 #include <timemory/mpl/macros.hpp>
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace omnitrace
@@ -55,6 +57,9 @@ struct pthread_mutex_gotcha : comp::base<pthread_mutex_gotcha, void>
     static void configure();
     static void shutdown();
 
+    // report the acquisitions per lock in the contention-only and profile modes
+    static void post_process();
+
     int operator()(int (*)(pthread_mutex_t*), pthread_mutex_t*) const;
     int operator()(int (*)(pthread_spinlock_t*), pthread_spinlock_t*) const;
     int operator()(int (*)(pthread_rwlock_t*), pthread_rwlock_t*) const;
@@ -62,13 +67,35 @@ struct pthread_mutex_gotcha : comp::base<pthread_mutex_gotcha, void>
     int operator()(int (*)(pthread_t, void**), pthread_t, void**) const;
 
 private:
+    // the wrapped functions which record the acquisitions per lock address
+    enum lock_role : uint8_t
+    {
+        ROLE_NONE = 0,
+        ROLE_MUTEX_LOCK,
+        ROLE_RDLOCK,
+        ROLE_WRLOCK,
+        ROLE_SPIN_LOCK,
+        ROLE_TRYLOCK,
+        ROLE_UNLOCK,
+    };
+
     static bool          is_disabled();
     static hash_array_t& get_hashes();
 
     template <typename... Args>
     auto operator()(uintptr_t&&, int (*)(Args...), Args...) const;
 
+    template <typename LockT>
+    int acquire(int (*)(LockT*), int (*)(LockT*), LockT*) const;
+
+    template <typename LockT>
+    int try_acquire(int (*)(LockT*), LockT*) const;
+
+    template <typename LockT>
+    int release(int (*)(LockT*), LockT*) const;
+
     mutable bool         m_protect = false;
+    lock_role            m_role    = ROLE_NONE;
     const gotcha_data_t* m_data    = nullptr;
 };
 
@@ -77,6 +104,17 @@ using pthread_mutex_gotcha_t = comp::gotcha<pthread_mutex_gotcha::gotcha_capacit
 }  // namespace component
 }  // namespace omnitrace
 
+// wait and hold times of the hottest locks in OMNITRACE_TRACE_THREAD_LOCKS_PROFILE mode
+OMNITRACE_COMPONENT_ALIAS(lock_profile_data,
+                          ::tim::component::data_tracker<double, pthread_mutex_gotcha>)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::lock_profile_data, project::omnitrace,
+                           category::timing, os::supports_unix)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::lock_profile_data,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::lock_profile_data,
+                                true_type)
+
 OMNITRACE_DEFINE_CONCRETE_TRAIT(fast_gotcha, component::pthread_mutex_gotcha_t, true_type)
 OMNITRACE_DEFINE_CONCRETE_TRAIT(static_data, component::pthread_mutex_gotcha_t, true_type)
 
@@ -96,3 +134,12 @@ struct static_data<pthread_mutex_gotcha, pthread_mutex_gotcha_t> : std::true_typ
 };
 }  // namespace policy
 }  // namespace tim
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(lock_profile_data, true, double)
+
+#endif
@@ -0,0 +1,363 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/components/python_gil_gotcha.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/utility.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/types.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+// value of PyGILState_STATE when PyGILState_Ensure acquired the GIL
+constexpr int gil_state_unlocked = 1;
+
+struct gil_stats
+{
+    int64_t  tid          = 0;
+    uint64_t acquisitions = 0;
+    uint64_t wait         = 0;
+    uint64_t max_wait     = 0;
+    uint64_t hold         = 0;
+};
+
+// the entries are only updated by their thread and are never removed so that the
+// threads which exited are reported
+struct gil_table
+{
+    std::mutex            mutex   = {};
+    std::deque<gil_stats> threads = {};
+};
+
+// timestamp of the last acquisition of the GIL by this thread, zero when the thread
+// released the GIL or when the acquisition was not tracked
+thread_local uint64_t held_since = 0;
+
+auto&
+get_gil_table()
+{
+    // intentionally leaked since the threads may release the GIL during the exit
+    static auto* _v = new gil_table{};
+    return *_v;
+}
+
+auto&
+get_python_gil_gotcha()
+{
+    static auto _v = tim::lightweight_tuple<python_gil_gotcha_t>{};
+    return _v;
+}
+
+gil_stats&
+get_gil_stats()
+{
+    static thread_local auto* _v = []() {
+        auto&                        _table = get_gil_table();
+        std::unique_lock<std::mutex> _lk{ _table.mutex };
+        auto&                        _stats = _table.threads.emplace_back();
+        _stats.tid                          = threading::get_id();
+        return &_stats;
+    }();
+    return *_v;
+}
+
+auto
+get_gil_track(const thread_info& _info)
+{
+    static thread_local auto _v = tracing::get_perfetto_track(
+        category::python_gil{},
+        [](auto _seq_id, auto _sys_id) {
+            return TIMEMORY_JOIN(" ", "Thread", _seq_id, "GIL", "(S)", _sys_id);
+        },
+        _info.index_data->sequent_value, _info.index_data->system_value);
+    return _v;
+}
+
+// the GIL is acquired and released by the internal threads of omnitrace (e.g. the
+// python bindings) in the internal thread state so they are never tracked
+uint64_t
+begin_acquire()
+{
+    static thread_local const auto& _info = thread_info::get();
+    if(!_info || _info->is_offset || get_state() != ::omnitrace::State::Active ||
+       get_thread_state() != ThreadState::Enabled)
+        return 0;
+    return tracing::now();
+}
+
+void
+end_acquire(uint64_t _beg)
+{
+    if(_beg == 0) return;
+
+    auto  _end   = tracing::now();
+    auto  _wait  = _end - _beg;
+    auto& _stats = get_gil_stats();
+    ++_stats.acquisitions;
+    _stats.wait += _wait;
+    _stats.max_wait = std::max(_stats.max_wait, _wait);
+    held_since      = _end;
+
+    if(get_use_perfetto())
+    {
+        auto _track = get_gil_track(*thread_info::get());
+        tracing::push_perfetto_track(category::python_gil{}, "GIL wait", _track, _beg);
+        tracing::pop_perfetto_track(category::python_gil{}, "GIL wait", _track, _end);
+        tracing::push_perfetto_track(category::python_gil{}, "GIL held", _track, _end);
+    }
+}
+
+// the hold interval is closed even when the state changed after the acquisition so
+// that the slices of the thread remain balanced
+void
+release()
+{
+    if(held_since == 0) return;
+
+    auto _end = tracing::now();
+    get_gil_stats().hold += _end - held_since;
+    held_since = 0;
+
+    if(get_use_perfetto() && get_state() == ::omnitrace::State::Active)
+    {
+        auto _track = get_gil_track(*thread_info::get());
+        tracing::pop_perfetto_track(category::python_gil{}, "GIL held", _track, _end);
+    }
+}
+}  // namespace
+
+python_gil_gotcha::python_gil_gotcha(const gotcha_data_t& _data)
+: m_release{ _data.tool_id == "PyEval_ReleaseThread" }
+{}
+
+void
+python_gil_gotcha::configure()
+{
+    gil_profile_data::label()       = "gil_profile";
+    gil_profile_data::description() = "Wait and hold time of the Python GIL per thread";
+
+    python_gil_gotcha_t::get_initializer() = []() {
+        python_gil_gotcha_t::configure(
+            comp::gotcha_config<0, void*>{ "PyEval_SaveThread" });
+        python_gil_gotcha_t::configure(
+            comp::gotcha_config<1, void, void*>{ "PyEval_RestoreThread" });
+        python_gil_gotcha_t::configure(
+            comp::gotcha_config<2, void, void*>{ "PyEval_AcquireThread" });
+        python_gil_gotcha_t::configure(
+            comp::gotcha_config<3, void, void*>{ "PyEval_ReleaseThread" });
+        python_gil_gotcha_t::configure(
+            comp::gotcha_config<4, int>{ "PyGILState_Ensure" });
+        python_gil_gotcha_t::configure(
+            comp::gotcha_config<5, void, int>{ "PyGILState_Release" });
+    };
+}
+
+void
+python_gil_gotcha::shutdown()
+{
+    python_gil_gotcha_t::disable();
+}
+
+void
+python_gil_gotcha::start()
+{
+    if(!config::get_trace_python_gil()) return;
+
+    if(!get_python_gil_gotcha().get<python_gil_gotcha_t>()->get_is_running())
+    {
+        configure();
+        get_python_gil_gotcha().start();
+    }
+}
+
+void
+python_gil_gotcha::stop()
+{
+    // the wrappers stay active until shutdown so that the releases are not missed
+}
+
+void
+python_gil_gotcha::post_process()
+{
+    auto& _table   = get_gil_table();
+    auto  _threads = std::vector<gil_stats>{};
+    {
+        std::unique_lock<std::mutex> _lk{ _table.mutex };
+        for(const auto& itr : _table.threads)
+        {
+            if(itr.acquisitions > 0) _threads.emplace_back(itr);
+        }
+    }
+
+    if(_threads.empty()) return;
+
+    std::sort(_threads.begin(), _threads.end(),
+              [](const gil_stats& _lhs, const gil_stats& _rhs) {
+                  return std::tie(_lhs.wait, _lhs.hold) > std::tie(_rhs.wait, _rhs.hold);
+              });
+
+    if(get_use_timemory() && trait::runtime_enabled<gil_profile_data>::get())
+    {
+        using tracker_t = tim::auto_tuple<gil_profile_data>;
+
+        for(const auto& itr : _threads)
+        {
+            auto _name = JOIN("", "GIL thread ", itr.tid,
+                              " [acquisitions=", itr.acquisitions, "]");
+            tracker_t{ JOIN('/', _name, "wait") }.store(std::plus<double>{},
+                                                        static_cast<double>(itr.wait));
+            tracker_t{ JOIN('/', _name, "hold") }.store(std::plus<double>{},
+                                                        static_cast<double>(itr.hold));
+        }
+    }
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / units::msec; };
+    auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+
+    uint64_t _acquisitions = 0;
+    uint64_t _wait         = 0;
+    uint64_t _hold         = 0;
+    for(const auto& itr : _threads)
+    {
+        _acquisitions += itr.acquisitions;
+        _wait += itr.wait;
+        _hold += itr.hold;
+    }
+
+    OMNITRACE_VERBOSE(0,
+                      "Python GIL :: %zu threads, %lu acquisitions, %.3f msec waited, "
+                      "%.3f msec held\n",
+                      _threads.size(), _acquisitions, _msec(_wait), _msec(_hold));
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("python-gil", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<python_gil_gotcha>{}(
+                _fname, std::string{ "python_gil" });
+
+        ofs << std::setw(8) << "thread" << " " << std::setw(14) << "acquisitions" << " "
+            << std::setw(14) << "wait [msec]" << " " << std::setw(16)
+            << "mean wait [usec]" << " " << std::setw(16) << "max wait [usec]" << " "
+            << std::setw(14) << "hold [msec]" << "\n";
+        ofs << std::fixed << std::setprecision(3);
+        for(const auto& itr : _threads)
+        {
+            ofs << std::setw(8) << itr.tid << " " << std::setw(14) << itr.acquisitions
+                << " " << std::setw(14) << _msec(itr.wait) << " " << std::setw(16)
+                << (_usec(itr.wait) / itr.acquisitions) << " " << std::setw(16)
+                << _usec(itr.max_wait) << " " << std::setw(14) << _msec(itr.hold)
+                << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening Python GIL output file: %s", _fname.c_str());
+    }
+}
+
+// PyEval_SaveThread
+void*
+python_gil_gotcha::operator()(void* (*_callee)()) const
+{
+    release();
+    return (*_callee)();
+}
+
+// PyEval_RestoreThread, PyEval_AcquireThread, PyEval_ReleaseThread
+void
+python_gil_gotcha::operator()(void (*_callee)(void*), void* _tstate) const
+{
+    if(m_release)
+    {
+        release();
+        (*_callee)(_tstate);
+        return;
+    }
+
+    auto _beg = begin_acquire();
+    (*_callee)(_tstate);
+    end_acquire(_beg);
+}
+
+// PyGILState_Ensure only acquires the GIL when the thread did not hold it, which is
+// reported by the returned state
+int
+python_gil_gotcha::operator()(int (*_callee)()) const
+{
+    auto _beg = begin_acquire();
+    auto _ret = (*_callee)();
+    if(_ret == gil_state_unlocked) end_acquire(_beg);
+    return _ret;
+}
+
+// PyGILState_Release only releases the GIL when the matching PyGILState_Ensure
+// acquired it
+void
+python_gil_gotcha::operator()(void (*_callee)(int), int _state) const
+{
+    if(_state == gil_state_unlocked) release();
+    (*_callee)(_state);
+}
+}  // namespace component
+}  // namespace omnitrace
+
+namespace tim
+{
+namespace policy
+{
+template <size_t N>
+python_gil_gotcha&
+static_data<python_gil_gotcha, python_gil_gotcha_t>::operator()(
+    std::integral_constant<size_t, N>, const component::gotcha_data& _data) const
+{
+    static auto _v = python_gil_gotcha{ _data };
+    return _v;
+}
+}  // namespace policy
+}  // namespace tim
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(gil_profile_data, true, double)
@@ -0,0 +1,124 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/mpl/macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace omnitrace
+{
+namespace component
+{
+// wraps the functions through which the threads explicitly release and re-acquire the
+// Python GIL. The time from the request of the GIL until it is acquired is a "GIL wait"
+// slice and the time until it is released again is a "GIL held" slice on the GIL track
+// of the thread, and both are accumulated per thread. Python.h is not included: the
+// thread states are opaque pointers and PyGILState_STATE is an int
+struct python_gil_gotcha : comp::base<python_gil_gotcha, void>
+{
+    static constexpr size_t gotcha_capacity = 6;
+    using gotcha_data_t                     = comp::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(python_gil_gotcha)
+
+    explicit python_gil_gotcha(const gotcha_data_t&);
+
+    // string id for component
+    static std::string label() { return "python_gil_gotcha"; }
+
+    // generate the gotcha wrappers
+    static void configure();
+    static void shutdown();
+
+    static void start();
+    static void stop();
+
+    // reports the wait and hold times of every thread
+    static void post_process();
+
+    // PyEval_SaveThread
+    void* operator()(void* (*)()) const;
+    // PyEval_RestoreThread, PyEval_AcquireThread, PyEval_ReleaseThread
+    void operator()(void (*)(void*), void*) const;
+    // PyGILState_Ensure
+    int operator()(int (*)()) const;
+    // PyGILState_Release
+    void operator()(void (*)(int), int) const;
+
+private:
+    bool m_release = false;  // PyEval_ReleaseThread
+};
+
+using python_gil_gotcha_t =
+    comp::gotcha<python_gil_gotcha::gotcha_capacity, std::tuple<>, python_gil_gotcha>;
+}  // namespace component
+}  // namespace omnitrace
+
+// wait and hold times of the GIL per thread in OMNITRACE_TRACE_PYTHON_GIL mode
+OMNITRACE_COMPONENT_ALIAS(gil_profile_data,
+                          ::tim::component::data_tracker<double, python_gil_gotcha>)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::gil_profile_data, project::omnitrace,
+                           category::timing, os::supports_unix)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_timing_category, component::gil_profile_data,
+                                true_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(uses_timing_units, component::gil_profile_data,
+                                true_type)
+
+OMNITRACE_DEFINE_CONCRETE_TRAIT(static_data, component::python_gil_gotcha_t, true_type)
+
+namespace tim
+{
+namespace policy
+{
+using python_gil_gotcha   = ::omnitrace::component::python_gil_gotcha;
+using python_gil_gotcha_t = ::omnitrace::component::python_gil_gotcha_t;
+
+template <>
+struct static_data<python_gil_gotcha, python_gil_gotcha_t> : std::true_type
+{
+    template <size_t N>
+    python_gil_gotcha& operator()(std::integral_constant<size_t, N>,
+                                  const component::gotcha_data& _data) const;
+};
+}  // namespace policy
+}  // namespace tim
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(gil_profile_data, true, double)
+
+#endif
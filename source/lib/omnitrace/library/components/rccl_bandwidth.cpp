@@ -0,0 +1,428 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/components/rccl_bandwidth.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "library/components/comm_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/manager.hpp>
+#include <timemory/units.hpp>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace
+{
+// one RCCL collective call
+struct collective
+{
+    std::string_view name     = {};
+    size_t           comm_idx = 0;
+    int              nranks   = 1;
+    double           bytes    = 0.0;  // algorithm size (as in nccl-tests)
+    double           factor   = 1.0;  // bus bandwidth correction factor
+    uint64_t         host_beg = 0;
+    uint64_t         host_end = 0;
+};
+
+// the collectives whose kernels are launched together: a single collective or the
+// collectives between ncclGroupStart and ncclGroupEnd
+struct launch_batch
+{
+    std::vector<collective> collectives = {};
+    uint64_t                gpu_beg     = std::numeric_limits<uint64_t>::max();
+    uint64_t                gpu_end     = 0;
+    size_t                  kernels     = 0;
+};
+
+using launch_batch_ptr_t = std::shared_ptr<launch_batch>;
+
+struct comm_info
+{
+    size_t index  = 0;
+    int    nranks = 1;
+};
+
+struct registry
+{
+    std::mutex                                       mutex    = {};
+    std::atomic<size_t>                              pending  = { 0 };
+    std::vector<launch_batch_ptr_t>                  batches  = {};
+    std::unordered_map<uint64_t, launch_batch_ptr_t> launches = {};  // corr id
+    std::unordered_map<const void*, comm_info>       comms    = {};
+};
+
+auto&
+get_registry()
+{
+    static auto* _v = new registry{};
+    return *_v;
+}
+
+// state of the RCCL calls on this thread
+struct thread_state
+{
+    bool               in_call     = false;
+    int                group_depth = 0;
+    launch_batch_ptr_t current     = {};
+};
+
+auto&
+get_thread_state()
+{
+    static thread_local auto _v = thread_state{};
+    return _v;
+}
+
+// calls the RCCL library directly since ncclCommCount is also wrapped
+int
+get_comm_size(ncclComm_t _comm)
+{
+    using comm_count_t = ncclResult_t (*)(const ncclComm_t, int*);
+
+    static auto _comm_count =
+        reinterpret_cast<comm_count_t>(dlsym(RTLD_DEFAULT, "ncclCommCount"));
+
+    int _n = 1;
+    if(!_comm_count || _comm_count(_comm, &_n) != ncclSuccess) _n = 1;
+    return std::max(_n, 1);
+}
+
+comm_info
+get_comm_info(ncclComm_t _comm)
+{
+    auto& _registry = get_registry();
+    {
+        std::unique_lock<std::mutex> _lk{ _registry.mutex };
+        auto                         itr = _registry.comms.find(_comm);
+        if(itr != _registry.comms.end()) return itr->second;
+    }
+
+    auto                         _nranks = get_comm_size(_comm);
+    std::unique_lock<std::mutex> _lk{ _registry.mutex };
+    auto                         _idx = _registry.comms.size();
+    return _registry.comms.emplace(_comm, comm_info{ _idx, _nranks }).first->second;
+}
+
+// algorithm size and bus bandwidth factor of the collectives, see PERFORMANCE.md
+// in nccl-tests
+std::optional<std::tuple<double, double>>
+get_bandwidth_model(std::string_view _name, double _bytes, int _nranks)
+{
+    auto _n = static_cast<double>(_nranks);
+    if(_name == "ncclAllReduce") return std::make_tuple(_bytes, 2.0 * (_n - 1.0) / _n);
+    if(_name == "ncclReduceScatter" || _name == "ncclAllGather" ||
+       _name == "ncclAllToAll" || _name == "ncclGather" || _name == "ncclScatter")
+        return std::make_tuple(_bytes * _n, (_n - 1.0) / _n);
+    if(_name == "ncclBroadcast" || _name == "ncclBcast" || _name == "ncclReduce" ||
+       _name == "ncclSend" || _name == "ncclRecv")
+        return std::make_tuple(_bytes, 1.0);
+    return std::nullopt;
+}
+
+void
+begin_collective(const gotcha_data& _data, size_t _count, ncclDataType_t _datatype,
+                 ncclComm_t _comm)
+{
+    if(get_state() != State::Active) return;
+
+    auto _size = comm_data::rccl_type_size(_datatype);
+    if(_size <= 0) return;
+
+    auto _comm_info = get_comm_info(_comm);
+    auto _name      = std::string_view{ _data.tool_id };
+    auto _model     = get_bandwidth_model(
+        _name, static_cast<double>(_count * _size), _comm_info.nranks);
+    if(!_model) return;
+
+    auto& _state = get_thread_state();
+    if(!_state.current)
+    {
+        _state.current = std::make_shared<launch_batch>();
+        auto&                        _registry = get_registry();
+        std::unique_lock<std::mutex> _lk{ _registry.mutex };
+        _registry.batches.emplace_back(_state.current);
+    }
+
+    auto [_bytes, _factor] = *_model;
+    _state.current->collectives.emplace_back(collective{
+        _name, _comm_info.index, _comm_info.nranks, _bytes, _factor,
+        tracing::now<uint64_t>(), 0 });
+    _state.in_call = true;
+}
+
+// the host time of the collectives in a group ends with ncclGroupEnd
+void
+end_batch(thread_state& _state)
+{
+    auto _now = tracing::now<uint64_t>();
+    if(_state.current)
+    {
+        for(auto& itr : _state.current->collectives)
+            itr.host_end = _now;
+    }
+    _state.current.reset();
+}
+
+struct bandwidth_tracks
+{
+    std::string                             algbw_name = {};
+    std::string                             busbw_name = {};
+    std::optional<::perfetto::CounterTrack> algbw      = {};
+    std::optional<::perfetto::CounterTrack> busbw      = {};
+};
+
+// the name must outlive the track
+auto
+make_counter_track(const std::string& _name)
+{
+    return ::perfetto::CounterTrack{ ::perfetto::DynamicString{ _name.c_str() } }
+        .set_unit_name("GB/s");
+}
+}  // namespace
+
+void
+rccl_bandwidth::preinit()
+{
+    rccl_bandwidth_tracker_t::label()        = "rccl_bandwidth";
+    rccl_bandwidth_tracker_t::description()  = "RCCL algorithm and bus bandwidth";
+    rccl_bandwidth_tracker_t::display_unit() = "GB/s";
+    rccl_bandwidth_tracker_t::unit()         = 1;
+}
+
+void
+rccl_bandwidth::register_kernel_launch(uint64_t _corr_id)
+{
+    auto& _state = get_thread_state();
+    if(!_state.in_call || !_state.current) return;
+
+    auto&                        _registry = get_registry();
+    std::unique_lock<std::mutex> _lk{ _registry.mutex };
+    if(_registry.launches.emplace(_corr_id, _state.current).second)
+        ++_registry.pending;
+}
+
+void
+rccl_bandwidth::record_kernel_activity(uint64_t _corr_id, uint64_t _beg_ns,
+                                       uint64_t _end_ns)
+{
+    auto& _registry = get_registry();
+    if(_registry.pending.load(std::memory_order_relaxed) == 0) return;
+
+    std::unique_lock<std::mutex> _lk{ _registry.mutex };
+    auto                         itr = _registry.launches.find(_corr_id);
+    if(itr == _registry.launches.end()) return;
+
+    auto& _batch   = *itr->second;
+    _batch.gpu_beg = std::min(_batch.gpu_beg, _beg_ns);
+    _batch.gpu_end = std::max(_batch.gpu_end, _end_ns);
+    ++_batch.kernels;
+
+    _registry.launches.erase(itr);
+    --_registry.pending;
+}
+
+void
+rccl_bandwidth::post_process()
+{
+    auto& _registry = get_registry();
+    auto  _batches  = std::vector<launch_batch_ptr_t>{};
+    {
+        std::unique_lock<std::mutex> _lk{ _registry.mutex };
+        std::swap(_batches, _registry.batches);
+        _registry.launches.clear();
+        _registry.pending.store(0);
+    }
+
+    if(_batches.empty()) return;
+
+    using track_map_t = std::map<std::pair<size_t, std::string_view>, bandwidth_tracks>;
+
+    // the tracks for each communicator and collective type
+    auto _tracks     = track_map_t{};
+    auto _get_tracks = [&_tracks](const collective& _v) -> bandwidth_tracks& {
+        auto itr = _tracks.find({ _v.comm_idx, _v.name });
+        if(itr != _tracks.end()) return itr->second;
+
+        auto  _lbl = JOIN("", "[comm=", _v.comm_idx, ", nranks=", _v.nranks, "]");
+        auto& _val = _tracks[{ _v.comm_idx, _v.name }];
+        _val.algbw_name = JOIN(" ", "RCCL", _v.name, "algbw", _lbl);
+        _val.busbw_name = JOIN(" ", "RCCL", _v.name, "busbw", _lbl);
+        _val.algbw      = make_counter_track(_val.algbw_name);
+        _val.busbw      = make_counter_track(_val.busbw_name);
+        return _val;
+    };
+
+    size_t _ngpu  = 0;
+    size_t _nhost = 0;
+    for(const auto& bitr : _batches)
+    {
+        const auto& _batch = *bitr;
+        const bool  _gpu   = (_batch.kernels > 0 && _batch.gpu_end > _batch.gpu_beg);
+        for(const auto& itr : _batch.collectives)
+        {
+            auto _beg = (_gpu) ? _batch.gpu_beg : itr.host_beg;
+            auto _end = (_gpu) ? _batch.gpu_end : itr.host_end;
+            if(_end <= _beg) continue;
+
+            auto _sec   = static_cast<double>(_end - _beg) / units::sec;
+            auto _algbw = (itr.bytes / _sec) / units::gigabyte;
+            auto _busbw = _algbw * itr.factor;
+            if(_gpu)
+                ++_ngpu;
+            else
+                ++_nhost;
+
+            if(get_use_perfetto())
+            {
+                auto& _v = _get_tracks(itr);
+                TRACE_COUNTER("comm_data", *_v.algbw, _beg, _algbw);
+                TRACE_COUNTER("comm_data", *_v.busbw, _beg, _busbw);
+                TRACE_COUNTER("comm_data", *_v.algbw, _end, 0.0);
+                TRACE_COUNTER("comm_data", *_v.busbw, _end, 0.0);
+            }
+
+            if(get_use_timemory() &&
+               trait::runtime_enabled<rccl_bandwidth_tracker_t>::get())
+            {
+                using tracker_t = tim::auto_tuple<rccl_bandwidth_tracker_t>;
+
+                auto _name = JOIN("", itr.name, " [comm=", itr.comm_idx, "]");
+                tracker_t{ JOIN('/', _name, "algbw") }.store(std::plus<double>{}, _algbw);
+                tracker_t{ JOIN('/', _name, "busbw") }.store(std::plus<double>{}, _busbw);
+            }
+        }
+    }
+
+    OMNITRACE_VERBOSE_F(1,
+                        "RCCL bandwidth of %zu collectives computed from the GPU kernel "
+                        "times and %zu from the host times\n",
+                        _ngpu, _nhost);
+}
+
+// ncclReduce
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclRedOp_t, int,
+                      ncclComm_t _comm, hipStream_t)
+{
+    begin_collective(_data, count, datatype, _comm);
+}
+
+// ncclSend
+// ncclBcast
+// ncclRecv
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::incoming, const void*,
+                      size_t count, ncclDataType_t datatype, int, ncclComm_t _comm,
+                      hipStream_t)
+{
+    begin_collective(_data, count, datatype, _comm);
+}
+
+// ncclBroadcast
+// ncclGather
+// ncclScatter
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, int, ncclComm_t _comm,
+                      hipStream_t)
+{
+    begin_collective(_data, count, datatype, _comm);
+}
+
+// ncclAllReduce
+// ncclReduceScatter
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclRedOp_t,
+                      ncclComm_t _comm, hipStream_t)
+{
+    begin_collective(_data, count, datatype, _comm);
+}
+
+// ncclAllGather
+// ncclAllToAll
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclComm_t _comm,
+                      hipStream_t)
+{
+    begin_collective(_data, count, datatype, _comm);
+}
+
+// ncclGroupStart
+// ncclGroupEnd
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::incoming)
+{
+    auto& _state = get_thread_state();
+    if(_data.tool_id == "ncclGroupStart")
+        ++_state.group_depth;
+    else if(_data.tool_id == "ncclGroupEnd")
+        _state.in_call = (_state.group_depth == 1);
+}
+
+void
+rccl_bandwidth::audit(const gotcha_data& _data, audit::outgoing, ncclResult_t)
+{
+    auto& _state = get_thread_state();
+    if(_data.tool_id == "ncclGroupStart") return;
+
+    if(_data.tool_id == "ncclGroupEnd")
+    {
+        _state.group_depth = std::max(_state.group_depth - 1, 0);
+        if(_state.group_depth == 0) end_batch(_state);
+        _state.in_call = false;
+    }
+    else if(_state.in_call)
+    {
+        _state.in_call = false;
+        if(_state.group_depth == 0) end_batch(_state);
+    }
+}
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(rccl_bandwidth, false, void)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(rccl_bandwidth_tracker_t, true, double)
@@ -0,0 +1,164 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/defines.hpp"
+#include "core/rccl.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/api/macros.hpp>
+#include <timemory/components/base.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/gotcha/backends.hpp>
+#include <timemory/components/macros.hpp>
+
+#include <cstdint>
+#include <string>
+
+OMNITRACE_DECLARE_COMPONENT(rccl_bandwidth)
+
+OMNITRACE_COMPONENT_ALIAS(rccl_bandwidth_tracker_t,
+                          ::tim::component::data_tracker<double, rccl_bandwidth>)
+
+namespace omnitrace
+{
+namespace component
+{
+// algorithm and bus bandwidth of the RCCL collectives per communicator and per
+// collective type, computed as in nccl-tests. The time of a collective is the GPU
+// execution time of the kernels launched by the RCCL call (or by the enclosing
+// ncclGroupEnd) which are joined from the roctracer activity records. The host time
+// of the call is only used when no kernel activity was recorded.
+struct rccl_bandwidth : base<rccl_bandwidth, void>
+{
+    using value_type  = void;
+    using this_type   = rccl_bandwidth;
+    using base_type   = base<this_type, value_type>;
+    using gotcha_data = ::tim::component::gotcha_data;
+
+    OMNITRACE_DEFAULT_OBJECT(rccl_bandwidth)
+
+    static std::string label() { return "rccl_bandwidth"; }
+    static std::string description() { return "RCCL algorithm and bus bandwidth"; }
+
+    static void preinit();
+    static void start() {}
+    static void stop() {}
+
+    // invoked by the HIP API callback for the kernels launched on the calling thread
+    static void register_kernel_launch(uint64_t _corr_id);
+
+    // invoked by the HIP activity callback for every kernel/copy record
+    static void record_kernel_activity(uint64_t _corr_id, uint64_t _beg_ns,
+                                       uint64_t _end_ns);
+
+    // emits the perfetto counters and timemory entries of the recorded collectives
+    static void post_process();
+
+#if defined(OMNITRACE_USE_RCCL) && OMNITRACE_USE_RCCL > 0
+    // ncclReduce
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclRedOp_t, int root,
+                      ncclComm_t, hipStream_t);
+
+    // ncclSend
+    // ncclBcast
+    // ncclRecv
+    static void audit(const gotcha_data& _data, audit::incoming, const void*,
+                      size_t count, ncclDataType_t datatype, int peer, ncclComm_t,
+                      hipStream_t);
+
+    // ncclBroadcast
+    // ncclGather
+    // ncclScatter
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, int root, ncclComm_t,
+                      hipStream_t);
+
+    // ncclAllReduce
+    // ncclReduceScatter
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t,
+                      hipStream_t);
+
+    // ncclAllGather
+    // ncclAllToAll
+    static void audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
+                      size_t count, ncclDataType_t datatype, ncclComm_t, hipStream_t);
+
+    // ncclGroupStart
+    // ncclGroupEnd
+    static void audit(const gotcha_data& _data, audit::incoming);
+
+    static void audit(const gotcha_data& _data, audit::outgoing, ncclResult_t);
+#endif
+};
+
+#if !defined(OMNITRACE_USE_RCCL) ||                                                      \
+    (defined(OMNITRACE_USE_RCCL) && OMNITRACE_USE_RCCL == 0)
+inline void
+rccl_bandwidth::preinit()
+{}
+
+inline void
+rccl_bandwidth::register_kernel_launch(uint64_t)
+{}
+
+inline void
+rccl_bandwidth::record_kernel_activity(uint64_t, uint64_t, uint64_t)
+{}
+
+inline void
+rccl_bandwidth::post_process()
+{}
+#endif
+}  // namespace component
+}  // namespace omnitrace
+
+#if !defined(OMNITRACE_USE_RCCL)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::rccl_bandwidth, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(is_available, component::rccl_bandwidth_tracker_t,
+                                false_type)
+#endif
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::rccl_bandwidth_tracker_t,
+                           project::omnitrace, tpls::rocm, device::gpu,
+                           os::supports_linux)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::rccl_bandwidth_tracker_t, double)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::rccl_bandwidth_tracker_t,
+                                false_type)
+
+#if defined(OMNITRACE_USE_RCCL) && OMNITRACE_USE_RCCL > 0
+#    if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                         \
+        (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#        include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(rccl_bandwidth, false, void)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(rccl_bandwidth_tracker_t, true, double)
+
+#    endif
+#endif
@@ -29,6 +29,7 @@
 #include "core/timemory.hpp"
 #include "library/components/category_region.hpp"
 #include "library/components/comm_data.hpp"
+#include "library/components/rccl_bandwidth.hpp"
 
 #include <timemory/api/macros.hpp>
 #include <timemory/components/macros.hpp>
@@ -48,7 +49,7 @@ OMNITRACE_COMPONENT_ALIAS(
     rccl_toolset_t,
     ::tim::component_bundle<category::rocm_rccl,
                             omnitrace::component::category_region<category::rocm_rccl>,
-                            comm_data>)
+                            comm_data, rccl_bandwidth>)
 OMNITRACE_COMPONENT_ALIAS(rcclp_gotcha_t,
                           ::tim::component::gotcha<OMNITRACE_NUM_RCCLP_WRAPPERS,
                                                    rccl_toolset_t, category::rocm_rccl>)
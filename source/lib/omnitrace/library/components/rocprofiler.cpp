@@ -40,6 +40,7 @@
 #include <rocprofiler.h>
 
 #include <cstdint>
+#include <iterator>
 #include <string_view>
 #include <type_traits>
 
@@ -66,7 +67,8 @@ rocm_data(int64_t _tid)
 
 rocm_event::rocm_event(uint32_t _dev, uint32_t _thr, uint32_t _queue,
                        std::string _event_name, rocm_metric_type _begin,
-                       rocm_metric_type _end, uint32_t _feature_count, void* _features_v)
+                       rocm_metric_type _end, uint32_t _feature_count, void** _features_v,
+                       const void* _features_base_v)
 : device_id{ _dev }
 , thread_id{ _thr }
 , queue_id{ _queue }
@@ -76,15 +78,16 @@ rocm_event::rocm_event(uint32_t _dev, uint32_t _thr, uint32_t _queue,
 {
     feature_values.reserve(_feature_count);
     feature_names.reserve(_feature_count);
-    auto* _features = static_cast<rocprofiler_feature_t*>(_features_v);
+    auto* _features      = reinterpret_cast<rocprofiler_feature_t**>(_features_v);
+    auto* _features_base = static_cast<const rocprofiler_feature_t*>(_features_base_v);
     for(uint32_t i = 0; i < _feature_count; ++i)
     {
-        const rocprofiler_feature_t* p = &_features[i];
-        feature_names.emplace_back(i);
+        const rocprofiler_feature_t* p = _features[i];
+        auto _idx = static_cast<size_t>(std::distance(_features_base, p));
         switch(p->data.kind)
         {
             // Output metrics results
-            case ROCPROFILER_DATA_KIND_UNINIT: break;
+            case ROCPROFILER_DATA_KIND_UNINIT: continue;
             case ROCPROFILER_DATA_KIND_BYTES:
                 feature_values.emplace_back(
                     rocm_feature_value{ p->data.result_bytes.size });
@@ -101,10 +104,22 @@ rocm_event::rocm_event(uint32_t _dev, uint32_t _thr, uint32_t _queue,
             case ROCPROFILER_DATA_KIND_INT64:
                 feature_values.emplace_back(rocm_feature_value{ p->data.result_int64 });
                 break;
+            default: continue;
         }
+        feature_names.emplace_back(_idx);
     }
 }
 
+const rocm_feature_value*
+rocm_event::find(size_t _feature_name) const
+{
+    for(size_t i = 0; i < feature_names.size(); ++i)
+    {
+        if(feature_names.at(i) == _feature_name) return &feature_values.at(i);
+    }
+    return nullptr;
+}
+
 std::string
 rocm_event::as_string() const
 {
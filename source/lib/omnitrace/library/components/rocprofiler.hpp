@@ -74,9 +74,16 @@ struct rocm_event
     std::vector<rocm_feature_value> feature_values = {};
 
     rocm_event() = default;
+
+    // _features are the features of the counter group which was collected for the
+    // dispatch and _features_base is the array of every feature for the device, i.e.
+    // the feature names are the indexes into _features_base
     rocm_event(uint32_t _dev, uint32_t _thr, uint32_t _queue, std::string _event_name,
                rocm_metric_type begin, rocm_metric_type end, uint32_t _feature_count,
-               void* _features);
+               void** _features, const void* _features_base);
+
+    // value of the feature at the given index into the device features (if collected)
+    const rocm_feature_value* find(size_t _feature_name) const;
 
     std::string as_string() const;
 
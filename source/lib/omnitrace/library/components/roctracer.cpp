@@ -27,6 +27,7 @@
 #include "core/defines.hpp"
 #include "core/dynamic_library.hpp"
 #include "core/redirect.hpp"
+#include "library/gpu_memory.hpp"
 #include "library/roctracer.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_data.hpp"
@@ -86,6 +87,21 @@ roctracer::is_setup()
     return roctracer_is_setup();
 }
 
+void
+roctracer::sync_clock()
+{
+    if(roctracer_is_setup()) update_clock_skew();
+}
+
+void
+roctracer::post_process()
+{
+    roctracer_hip_api_post_process();
+    gpu_memory::post_process();
+    roctracer_timeline_post_process();
+    roctracer_graph_post_process();
+}
+
 void
 roctracer::add_setup(const std::string& _lbl, std::function<void()>&& _func)
 {
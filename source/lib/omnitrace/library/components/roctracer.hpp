@@ -60,6 +60,8 @@ struct roctracer
     static void setup(void* hsa_api_table, bool on_load_trace = false);
     static void flush();
     static void shutdown();
+    static void sync_clock();
+    static void post_process();
     static void add_setup(const std::string&, std::function<void()>&&);
     static void add_shutdown(const std::string&, std::function<void()>&&);
     static void remove_setup(const std::string&);
@@ -86,6 +88,14 @@ inline void
 roctracer::shutdown()
 {}
 
+inline void
+roctracer::sync_clock()
+{}
+
+inline void
+roctracer::post_process()
+{}
+
 inline bool
 roctracer::is_setup()
 {
@@ -0,0 +1,448 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/components/topdown.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perf.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <linux/perf_event.h>
+#include <mutex>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+namespace omnitrace
+{
+namespace component
+{
+namespace topdown
+{
+namespace
+{
+namespace filepath = ::tim::filepath;
+
+constexpr size_t max_events = 5;
+
+using counters_t = std::array<uint64_t, max_events>;
+
+enum class model_kind
+{
+    none = 0,
+    intel_perf_metrics,  // Ice Lake and newer: the slots and topdown-* events
+    intel_generic,       // Skylake-era level 1 formulas with 4 slots per cycle
+    amd_zen,             // Zen 4 and newer: the pipeline utilization events
+};
+
+struct model
+{
+    model_kind            kind   = model_kind::none;
+    uint32_t              type   = PERF_TYPE_RAW;
+    double                width  = 0.0;  // dispatch slots per cycle
+    std::vector<uint64_t> events = {};
+    const char*           name   = "none";
+};
+
+struct fractions
+{
+    double retiring        = 0.0;
+    double bad_speculation = 0.0;
+    double frontend_bound  = 0.0;
+    double backend_bound   = 0.0;
+};
+
+auto&
+get_model()
+{
+    static auto _v = model{};
+    return _v;
+}
+
+struct cpu_id
+{
+    std::string vendor = {};
+    int         family = -1;
+    int         model  = -1;
+};
+
+// the fields of the first processor in /proc/cpuinfo
+cpu_id
+read_cpu_id()
+{
+    auto _v    = cpu_id{};
+    auto _ifs  = std::ifstream{ "/proc/cpuinfo" };
+    auto _line = std::string{};
+    while(_ifs && std::getline(_ifs, _line))
+    {
+        if(_line.empty()) break;
+        auto _pos = _line.find(':');
+        if(_pos == std::string::npos || _pos + 2 > _line.length()) continue;
+        auto _key = _line.substr(0, _line.find_first_of(" \t"));
+        auto _val = _line.substr(_pos + 2);
+        if(_key == "vendor_id")
+            _v.vendor = _val;
+        else if(_line.find("cpu family") == 0)
+            _v.family = std::stoi(_val);
+        else if(_key == "model")
+            _v.model = std::stoi(_val);
+    }
+    return _v;
+}
+
+model
+detect_model()
+{
+    auto _cpu = read_cpu_id();
+    if(_cpu.vendor == "GenuineIntel")
+    {
+        // the kernel exposes the PERF_METRICS of the hybrid cores on the cpu_core PMU.
+        // The topdown-* events report slots and must be in a group led by slots
+        for(const auto* itr : { "cpu", "cpu_core" })
+        {
+            auto _evt  = JOIN("", "/sys/bus/event_source/devices/", itr,
+                             "/events/topdown-retiring");
+            auto _type = (filepath::exists(_evt)) ? perf::get_pmu_type(itr) : -1;
+            if(_type >= 0)
+                return model{ model_kind::intel_perf_metrics,
+                              static_cast<uint32_t>(_type), 0.0,
+                              // slots, retiring, bad-spec, fe-bound, be-bound
+                              { 0x0400, 0x8000, 0x8100, 0x8200, 0x8300 },
+                              "intel (perf metrics)" };
+        }
+
+        if(_cpu.family == 6)
+            return model{ model_kind::intel_generic, PERF_TYPE_RAW, 4.0,
+                          // CPU_CLK_UNHALTED.THREAD, IDQ_UOPS_NOT_DELIVERED.CORE,
+                          // UOPS_ISSUED.ANY, UOPS_RETIRED.RETIRE_SLOTS,
+                          // INT_MISC.RECOVERY_CYCLES
+                          { 0x003c, 0x019c, 0x010e, 0x02c2, 0x010d },
+                          "intel" };
+    }
+    else if(_cpu.vendor == "AuthenticAMD")
+    {
+        // the upper 4 bits of the AMD event select are bits 32-35 of the config
+        constexpr uint64_t _de_no_dispatch = 0xa0 | (1ULL << 32);
+
+        auto _is_zen4 = (_cpu.family == 0x19 &&
+                         ((_cpu.model >= 0x10 && _cpu.model <= 0x1f) ||
+                          (_cpu.model >= 0x60 && _cpu.model <= 0x7f) ||
+                          (_cpu.model >= 0xa0 && _cpu.model <= 0xaf)));
+        auto _is_zen5 = (_cpu.family == 0x1a);
+
+        if(_is_zen4 || _is_zen5)
+            return model{ model_kind::amd_zen, PERF_TYPE_RAW, (_is_zen5) ? 8.0 : 6.0,
+                          // ls_not_halted_cyc, no_ops_from_frontend, backend_stalls,
+                          // ex_ret_ops, de_src_op_disp.all
+                          { 0x0076, _de_no_dispatch | (0x01 << 8),
+                            _de_no_dispatch | (0x1e << 8), 0x00c1, 0x07aa },
+                          (_is_zen5) ? "amd zen5" : "amd zen4" };
+    }
+
+    return model{};
+}
+
+bool
+compute(const model& _model, const counters_t& _delta, fractions& _v)
+{
+    auto _get = [&_delta](size_t _idx) { return static_cast<double>(_delta.at(_idx)); };
+
+    switch(_model.kind)
+    {
+        case model_kind::intel_perf_metrics:
+        {
+            auto _slots = _get(0);
+            if(_slots <= 0.0) return false;
+            _v.retiring        = _get(1) / _slots;
+            _v.bad_speculation = _get(2) / _slots;
+            _v.frontend_bound  = _get(3) / _slots;
+            _v.backend_bound   = _get(4) / _slots;
+            return true;
+        }
+        case model_kind::intel_generic:
+        {
+            auto _slots = _model.width * _get(0);
+            if(_slots <= 0.0) return false;
+            _v.frontend_bound = _get(1) / _slots;
+            _v.retiring       = _get(3) / _slots;
+            _v.bad_speculation =
+                std::max<double>(_get(2) - _get(3) + (_model.width * _get(4)), 0.0) /
+                _slots;
+            _v.backend_bound =
+                std::max<double>(1.0 - _v.frontend_bound - _v.bad_speculation -
+                                     _v.retiring,
+                                 0.0);
+            return true;
+        }
+        case model_kind::amd_zen:
+        {
+            auto _slots = _model.width * _get(0);
+            if(_slots <= 0.0) return false;
+            _v.frontend_bound  = _get(1) / _slots;
+            _v.backend_bound   = _get(2) / _slots;
+            _v.retiring        = _get(3) / _slots;
+            _v.bad_speculation = std::max<double>(_get(4) - _get(3), 0.0) / _slots;
+            return true;
+        }
+        case model_kind::none: break;
+    }
+    return false;
+}
+
+long
+perf_event_open(struct perf_event_attr* _pe, pid_t _pid, int _cpu, int _group_fd,
+                unsigned long _flags)
+{
+    return syscall(__NR_perf_event_open, _pe, _pid, _cpu, _group_fd, _flags);
+}
+
+// the perf_event group of one thread and the counters at the push of each open region
+struct thread_group
+{
+    thread_group() = default;
+    ~thread_group() { close(); }
+    thread_group(const thread_group&) = delete;
+    thread_group& operator=(const thread_group&) = delete;
+
+    bool open(const model&);
+    void close();
+    bool read(counters_t&) const;
+
+    bool                    initialized = false;
+    std::vector<int>        fds         = {};
+    std::vector<counters_t> stack       = {};
+};
+
+bool
+thread_group::open(const model& _model)
+{
+    initialized = true;
+    for(auto itr : _model.events)
+    {
+        struct perf_event_attr _pe;
+        memset(&_pe, 0, sizeof(_pe));
+        _pe.size           = sizeof(struct perf_event_attr);
+        _pe.type           = _model.type;
+        _pe.config         = itr;
+        _pe.disabled       = (fds.empty()) ? 1 : 0;
+        _pe.read_format    = PERF_FORMAT_GROUP;
+        _pe.exclude_kernel = 1;
+        _pe.exclude_hv     = 1;
+
+        auto _leader = (fds.empty()) ? -1 : fds.front();
+        auto _fd     = perf_event_open(&_pe, 0, -1, _leader, PERF_FLAG_FD_CLOEXEC);
+        if(_fd < 0)
+        {
+            OMNITRACE_VERBOSE(1,
+                              "[topdown] event 0x%lx of the %s model could not be "
+                              "opened on thread %li: %s\n",
+                              static_cast<unsigned long>(itr), _model.name,
+                              threading::get_id(), strerror(errno));
+            close();
+            return false;
+        }
+        fds.emplace_back(_fd);
+    }
+
+    return (ioctl(fds.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == 0);
+}
+
+void
+thread_group::close()
+{
+    // the members of the group are closed before the leader
+    for(auto itr = fds.rbegin(); itr != fds.rend(); ++itr)
+        ::close(*itr);
+    fds.clear();
+    stack.clear();
+}
+
+bool
+thread_group::read(counters_t& _v) const
+{
+    struct
+    {
+        uint64_t nr = 0;
+        uint64_t values[max_events];
+    } _data;
+
+    auto _n = ::read(fds.front(), &_data, sizeof(_data));
+    if(_n < static_cast<ssize_t>(sizeof(uint64_t)) || _data.nr != fds.size())
+        return false;
+
+    _v.fill(0);
+    for(size_t i = 0; i < _data.nr; ++i)
+        _v.at(i) = _data.values[i];
+    return true;
+}
+
+auto&
+get_thread_group()
+{
+    static thread_local auto _v = thread_group{};
+    return _v;
+}
+
+auto&
+get_perfetto_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+void
+emit_perfetto(int64_t _tid, uint64_t _ts, const fractions& _v)
+{
+    using counter_track = perfetto_counter_track<topdown_retiring>;
+
+    auto _lk = std::unique_lock<std::mutex>{ get_perfetto_mutex() };
+    if(!counter_track::exists(_tid))
+    {
+        auto _tid_name = JOIN("", '[', _tid, ']');
+        for(const auto* itr : { "Retiring", "Bad Speculation", "Frontend Bound",
+                                "Backend Bound" })
+            counter_track::emplace(_tid, JOIN(' ', "Thread Topdown", itr, _tid_name),
+                                   "%");
+    }
+
+    constexpr auto _category = trait::name<category::thread_hardware_counter>::value;
+    TRACE_COUNTER(_category, counter_track::at(_tid, 0), _ts, 100.0 * _v.retiring);
+    TRACE_COUNTER(_category, counter_track::at(_tid, 1), _ts,
+                  100.0 * _v.bad_speculation);
+    TRACE_COUNTER(_category, counter_track::at(_tid, 2), _ts, 100.0 * _v.frontend_bound);
+    TRACE_COUNTER(_category, counter_track::at(_tid, 3), _ts, 100.0 * _v.backend_bound);
+}
+}  // namespace
+
+bool
+setup()
+{
+    topdown_retiring_data::label()        = "topdown_retiring";
+    topdown_retiring_data::description()  = "Slots which retired";
+    topdown_retiring_data::display_unit() = "%";
+
+    topdown_bad_speculation_data::label()        = "topdown_bad_speculation";
+    topdown_bad_speculation_data::description()  = "Slots wasted by bad speculation";
+    topdown_bad_speculation_data::display_unit() = "%";
+
+    topdown_frontend_bound_data::label()        = "topdown_frontend_bound";
+    topdown_frontend_bound_data::description()  = "Slots stalled in the frontend";
+    topdown_frontend_bound_data::display_unit() = "%";
+
+    topdown_backend_bound_data::label()        = "topdown_backend_bound";
+    topdown_backend_bound_data::description()  = "Slots stalled in the backend";
+    topdown_backend_bound_data::display_unit() = "%";
+
+    get_model() = detect_model();
+
+    auto _supported = (get_model().kind != model_kind::none);
+    if(!_supported)
+    {
+        OMNITRACE_WARNING_F(0, "The top-down events of this CPU are not known. "
+                               "OMNITRACE_TOPDOWN is disabled\n");
+    }
+    else
+    {
+        OMNITRACE_VERBOSE_F(1, "Using the top-down events of the %s model\n",
+                            get_model().name);
+    }
+
+    auto _enabled = _supported && get_use_timemory();
+    trait::runtime_enabled<topdown_retiring_data>::set(_enabled);
+    trait::runtime_enabled<topdown_bad_speculation_data>::set(_enabled);
+    trait::runtime_enabled<topdown_frontend_bound_data>::set(_enabled);
+    trait::runtime_enabled<topdown_backend_bound_data>::set(_enabled);
+
+    return _supported;
+}
+
+void
+begin()
+{
+    const auto& _model = get_model();
+    if(_model.kind == model_kind::none) return;
+
+    auto& _group = get_thread_group();
+    if(!_group.initialized && !_group.open(_model)) return;
+    if(_group.fds.empty()) return;
+
+    auto _v = counters_t{};
+    if(!_group.read(_v)) _v.fill(0);
+    _group.stack.emplace_back(_v);
+}
+
+void
+end(std::string_view _name)
+{
+    auto& _group = get_thread_group();
+    if(_group.fds.empty() || _group.stack.empty()) return;
+
+    auto _beg = _group.stack.back();
+    _group.stack.pop_back();
+
+    auto _end = counters_t{};
+    if(!_group.read(_end)) return;
+
+    auto _delta = counters_t{};
+    for(size_t i = 0; i < max_events; ++i)
+        _delta.at(i) = (_end.at(i) >= _beg.at(i)) ? (_end.at(i) - _beg.at(i)) : 0;
+
+    auto _v = fractions{};
+    if(!compute(get_model(), _delta, _v)) return;
+
+    if(get_use_perfetto())
+        emit_perfetto(threading::get_id(), tim::get_clock_real_now<uint64_t, std::nano>(),
+                      _v);
+
+    if(get_use_timemory() && trait::runtime_enabled<topdown_retiring_data>::get())
+    {
+        auto _key = std::string{ _name };
+        tim::auto_tuple<topdown_retiring_data>{ _key, tim::scope::flat{} }.store(
+            std::plus<double>{}, 100.0 * _v.retiring);
+        tim::auto_tuple<topdown_bad_speculation_data>{ _key, tim::scope::flat{} }.store(
+            std::plus<double>{}, 100.0 * _v.bad_speculation);
+        tim::auto_tuple<topdown_frontend_bound_data>{ _key, tim::scope::flat{} }.store(
+            std::plus<double>{}, 100.0 * _v.frontend_bound);
+        tim::auto_tuple<topdown_backend_bound_data>{ _key, tim::scope::flat{} }.store(
+            std::plus<double>{}, 100.0 * _v.backend_bound);
+    }
+}
+}  // namespace topdown
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(topdown_retiring_data, true, double)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(topdown_bad_speculation_data, true, double)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(topdown_frontend_bound_data, true, double)
+OMNITRACE_INSTANTIATE_EXTERN_COMPONENT(topdown_backend_bound_data, true, double)
@@ -0,0 +1,147 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/common.hpp"
+#include "core/components/fwd.hpp"
+#include "core/defines.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/base.hpp>
+#include <timemory/components/data_tracker/components.hpp>
+#include <timemory/components/macros.hpp>
+
+#include <string>
+#include <string_view>
+
+OMNITRACE_DECLARE_COMPONENT(topdown_retiring)
+OMNITRACE_DECLARE_COMPONENT(topdown_bad_speculation)
+OMNITRACE_DECLARE_COMPONENT(topdown_frontend_bound)
+OMNITRACE_DECLARE_COMPONENT(topdown_backend_bound)
+
+namespace omnitrace
+{
+namespace component
+{
+// level 1 of the top-down microarchitecture analysis: the fractions of the pipeline
+// slots which retired, were wasted on bad speculation, or were stalled in the
+// frontend or the backend. The events are programmed as one perf_event group per
+// thread so they are always scheduled together and the fractions are computed from
+// the deltas between the push and the pop of the host, user and python regions
+struct topdown_retiring : base<topdown_retiring, void>
+{
+    static std::string label() { return "topdown_retiring"; }
+    static std::string description() { return "Fraction of the slots which retired"; }
+};
+
+struct topdown_bad_speculation : base<topdown_bad_speculation, void>
+{
+    static std::string label() { return "topdown_bad_speculation"; }
+    static std::string description()
+    {
+        return "Fraction of the slots wasted by bad speculation";
+    }
+};
+
+struct topdown_frontend_bound : base<topdown_frontend_bound, void>
+{
+    static std::string label() { return "topdown_frontend_bound"; }
+    static std::string description()
+    {
+        return "Fraction of the slots stalled in the frontend";
+    }
+};
+
+struct topdown_backend_bound : base<topdown_backend_bound, void>
+{
+    static std::string label() { return "topdown_backend_bound"; }
+    static std::string description()
+    {
+        return "Fraction of the slots stalled in the backend";
+    }
+};
+
+namespace topdown
+{
+// detects the events of the CPU and sets the labels and units of the data trackers.
+// Returns false if the CPU does not provide the top-down events
+bool
+setup();
+
+// invoked by the host, user and python regions. The perf_event group of the thread is
+// opened on the first call
+void
+begin();
+
+void
+end(std::string_view _name);
+}  // namespace topdown
+}  // namespace component
+}  // namespace omnitrace
+
+OMNITRACE_COMPONENT_ALIAS(topdown_retiring_data,
+                          ::tim::component::data_tracker<double, topdown_retiring>)
+OMNITRACE_COMPONENT_ALIAS(
+    topdown_bad_speculation_data,
+    ::tim::component::data_tracker<double, topdown_bad_speculation>)
+OMNITRACE_COMPONENT_ALIAS(topdown_frontend_bound_data,
+                          ::tim::component::data_tracker<double, topdown_frontend_bound>)
+OMNITRACE_COMPONENT_ALIAS(topdown_backend_bound_data,
+                          ::tim::component::data_tracker<double, topdown_backend_bound>)
+
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::topdown_retiring_data,
+                           project::omnitrace, category::hardware_counter,
+                           os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::topdown_bad_speculation_data,
+                           project::omnitrace, category::hardware_counter,
+                           os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::topdown_frontend_bound_data,
+                           project::omnitrace, category::hardware_counter,
+                           os::supports_unix)
+TIMEMORY_SET_COMPONENT_API(omnitrace::component::topdown_backend_bound_data,
+                           project::omnitrace, category::hardware_counter,
+                           os::supports_unix)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::topdown_retiring_data, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::topdown_bad_speculation_data, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::topdown_frontend_bound_data, double)
+TIMEMORY_STATISTICS_TYPE(omnitrace::component::topdown_backend_bound_data, double)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::topdown_retiring_data, false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::topdown_bad_speculation_data,
+                                false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::topdown_frontend_bound_data,
+                                false_type)
+OMNITRACE_DEFINE_CONCRETE_TRAIT(report_sum, component::topdown_backend_bound_data,
+                                false_type)
+
+#if !defined(OMNITRACE_EXTERN_COMPONENTS) ||                                             \
+    (defined(OMNITRACE_EXTERN_COMPONENTS) && OMNITRACE_EXTERN_COMPONENTS > 0)
+
+#    include <timemory/operations.hpp>
+
+OMNITRACE_DECLARE_EXTERN_COMPONENT(topdown_retiring_data, true, double)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(topdown_bad_speculation_data, true, double)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(topdown_frontend_bound_data, true, double)
+OMNITRACE_DECLARE_EXTERN_COMPONENT(topdown_backend_bound_data, true, double)
+
+#endif
@@ -0,0 +1,201 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/control.hpp"
+#include "core/categories.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/utility.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+namespace omnitrace
+{
+namespace control
+{
+namespace
+{
+static_assert(OMNITRACE_CATEGORY_LAST <= control_block::max_categories,
+              "control_block::max_categories must be increased");
+
+int         control_fd       = -1;
+std::string control_filename = {};
+
+struct filtered_entry
+{
+    int64_t depth = 0;
+    size_t  bit   = 0;
+};
+
+// depths and function bits of the outstanding filtered entries on this thread. The
+// depth of the innermost filtered entry is always at the back
+auto&
+get_filtered_stack()
+{
+    static thread_local auto _v = std::vector<filtered_entry>{};
+    return _v;
+}
+
+template <size_t... Idx>
+void
+set_category_names(control_block* _block, std::index_sequence<Idx...>)
+{
+    ((strncpy(_block->names[Idx], trait::name<category_type_id_t<Idx>>::value,
+              control_block::name_length - 1)),
+     ...);
+}
+}  // namespace
+
+namespace impl
+{
+bool
+push(const char* _name, int64_t _depth)
+{
+    if(!_name) return false;
+
+    auto* _block = get_block();
+    auto  _mode  = _block->mode.load(std::memory_order_relaxed);
+    auto  _bit   = get_control_function_bit(_name);
+    auto  _word  = _block->functions[_bit / 64].load(std::memory_order_relaxed);
+    auto  _set   = ((_word >> (_bit % 64)) & 1) == 1;
+
+    auto _skip = false;
+    if(_mode == control_block::function_include)
+        _skip = !_set;
+    else if(_mode == control_block::function_exclude)
+        _skip = _set;
+
+    if(!_skip) return false;
+
+    get_filtered_stack().emplace_back(filtered_entry{ _depth, _bit });
+    ++get_filtered_count();
+    return true;
+}
+
+bool
+pop(const char* _name, int64_t _depth, bool _by_name)
+{
+    auto& _filtered = get_filtered_stack();
+    if(!_name || _filtered.empty()) return false;
+
+    auto _bit = get_control_function_bit(_name);
+    auto itr  = _filtered.end() - 1;
+    if(itr->depth != _depth || itr->bit != _bit)
+    {
+        if(!_by_name) return false;
+        // a region which was closed out of order, e.g. push A (filtered), push B,
+        // pop A, pop B
+        auto ritr = std::find_if(_filtered.rbegin(), _filtered.rend(),
+                                 [_bit](const auto& _v) { return _v.bit == _bit; });
+        if(ritr == _filtered.rend()) return false;
+        itr = std::next(ritr).base();
+    }
+
+    _filtered.erase(itr);
+    --get_filtered_count();
+    return true;
+}
+}  // namespace impl
+
+bool
+is_active()
+{
+    return impl::get_block() != &impl::default_block;
+}
+
+void
+setup()
+{
+    if(is_active()) return;
+
+    auto _fname = get_control_filename(config::get_tmpdir(), process::get_id());
+    auto _fd    = ::open(_fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(_fd < 0)
+    {
+        OMNITRACE_VERBOSE(0, "[control] unable to create '%s': %s\n", _fname.c_str(),
+                          strerror(errno));
+        return;
+    }
+
+    // the file is zero-filled so every category and function starts without an override
+    void* _addr = MAP_FAILED;
+    if(::ftruncate(_fd, sizeof(control_block)) == 0)
+        _addr = ::mmap(nullptr, sizeof(control_block), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, _fd, 0);
+
+    if(_addr == MAP_FAILED)
+    {
+        OMNITRACE_VERBOSE(0, "[control] unable to map '%s': %s\n", _fname.c_str(),
+                          strerror(errno));
+        ::close(_fd);
+        ::unlink(_fname.c_str());
+        return;
+    }
+
+    auto* _block           = static_cast<control_block*>(_addr);
+    _block->header_version = control_block::version;
+    _block->num_categories = OMNITRACE_CATEGORY_LAST;
+    _block->pid            = process::get_id();
+    set_category_names(_block,
+                       utility::make_index_sequence_range<1, OMNITRACE_CATEGORY_LAST>{});
+
+    // omnitrace-ctl does not use the block until the magic is written
+    std::atomic_thread_fence(std::memory_order_release);
+    _block->header = control_block::magic;
+
+    control_fd       = _fd;
+    control_filename = _fname;
+    impl::active_block.store(_block, std::memory_order_release);
+
+    OMNITRACE_VERBOSE(1, "[control] categories and functions are controlled via '%s'\n",
+                      _fname.c_str());
+}
+
+void
+shutdown()
+{
+    if(!is_active()) return;
+
+    auto* _block = impl::get_block();
+    OMNITRACE_VERBOSE(1, "[control] %zu change(s) were applied via '%s'\n",
+                      static_cast<size_t>(_block->generation.load()),
+                      control_filename.c_str());
+
+    // other threads may still read the block on the hot path so it is not unmapped.
+    // The outstanding filtered entries are tracked per-thread so the exits from them
+    // are still skipped after the overrides are dropped
+    impl::active_block.store(&impl::default_block, std::memory_order_release);
+    ::unlink(control_filename.c_str());
+    ::close(control_fd);
+    control_fd = -1;
+}
+}  // namespace control
+}  // namespace omnitrace
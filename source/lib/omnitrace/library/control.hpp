@@ -0,0 +1,127 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "common/control.hpp"
+#include "common/defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// control file (OMNITRACE_CONTROL_FILE): a file in OMNITRACE_TMPDIR which is mapped by
+// the process and by omnitrace-ctl. The per-category overrides and the per-function
+// bits in the file are read on the hot path so that categories and functions can be
+// turned on and off while the process is running
+namespace control
+{
+namespace impl
+{
+// until the control file is mapped, this points to a zero-initialized block in which
+// nothing is overridden so that the hot path does not require a null check
+inline control_block               default_block;
+inline std::atomic<control_block*> active_block = { &default_block };
+
+inline control_block*
+get_block()
+{
+    return active_block.load(std::memory_order_relaxed);
+}
+
+// number of entries on this thread which went through control::push and have not
+// exited yet, i.e. the position of the entry in the call-stack
+inline int64_t&
+get_depth()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
+// number of outstanding entries on this thread which were filtered out
+inline int64_t&
+get_filtered_count()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
+bool
+push(const char*, int64_t);
+
+bool
+pop(const char*, int64_t, bool);
+}  // namespace impl
+
+// returns control_block::category_default, category_on, or category_off
+inline uint8_t
+get_category_state(size_t _idx)
+{
+    return impl::get_block()->categories[_idx].load(std::memory_order_relaxed);
+}
+
+// returns true when the entry into the function or region should be skipped. The
+// name is only hashed when omnitrace-ctl has set a function filter
+inline bool
+push(const char* _name)
+{
+    auto _depth = ++impl::get_depth();
+    if(OMNITRACE_LIKELY(impl::get_block()->mode.load(std::memory_order_relaxed) ==
+                        control_block::function_all))
+        return false;
+    return impl::push(_name, _depth);
+}
+
+// returns true when the exit from the function should be skipped, i.e. the matching
+// entry was skipped. The filter may have changed since the entry so this does not
+// depend on the current filter. The exit is matched to the entry by the depth and the
+// function bit so recursive calls of a function are matched to the correct entry
+inline bool
+pop(const char* _name)
+{
+    auto _depth = impl::get_depth()--;
+    if(OMNITRACE_LIKELY(impl::get_filtered_count() == 0)) return false;
+    return impl::pop(_name, _depth, false);
+}
+
+// same as pop but user regions may be closed out of order so when the exit does not
+// match the innermost filtered entry, it is matched to a filtered entry by the name
+inline bool
+pop_region(const char* _name)
+{
+    auto _depth = impl::get_depth()--;
+    if(OMNITRACE_LIKELY(impl::get_filtered_count() == 0)) return false;
+    return impl::pop(_name, _depth, true);
+}
+
+bool
+is_active();
+
+void
+setup();
+
+void
+shutdown();
+}  // namespace control
+}  // namespace omnitrace
@@ -38,6 +38,7 @@
 #include <string_view>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #define OMNITRACE_SERIALIZE(MEMBER_VARIABLE)                                             \
     ar(::tim::cereal::make_nvp(#MEMBER_VARIABLE, MEMBER_VARIABLE))
@@ -51,11 +52,43 @@ namespace
 template <typename... Tp>
 using uomap_t = std::unordered_map<Tp...>;
 //
-using coverage_thread_data_type =
+using coverage_nested_data_type =
     uomap_t<std::string_view, uomap_t<std::string_view, std::map<size_t, size_t>>>;
 //
+// the index assigned to each (file, func, address) by the instrumenter holds the id of
+// the instrumented binary in the upper 32 bits and a dense index within the binary in
+// the lower 32 bits. Every run of omnitrace-instrument numbers its indices from zero so
+// the binaries instrumented separately (e.g. an executable and a shared library) are
+// kept apart by the id
+constexpr uint32_t
+get_module_id(size_t _index)
+{
+    return static_cast<uint32_t>(_index >> 32);
+}
+//
+constexpr size_t
+get_module_index(size_t _index)
+{
+    return (_index & 0xffffffffUL);
+}
+//
 using coverage_data_vector = std::vector<coverage_data>;
 //
+struct module_coverage
+{
+    coverage_data_vector data       = {};
+    std::vector<bool>    registered = {};  // whether the entry at the index is registered
+};
+//
+// the hit counts of the calling thread for one instrumented binary
+struct module_counts
+{
+    uint32_t            module = 0;
+    std::vector<size_t> counts = {};
+};
+//
+using coverage_thread_data_type = std::vector<module_counts>;
+//
 using coverage_data_map =
     uomap_t<std::string_view,
             uomap_t<std::string_view, std::map<size_t, coverage_data_vector::iterator>>>;
@@ -85,6 +118,20 @@ get_coverage_data()
 }
 //
 auto&
+get_coverage_modules()
+{
+    static auto _v = std::map<uint32_t, module_coverage>{};
+    return _v;
+}
+//
+auto&
+get_coverage_modules_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+//
+auto&
 get_coverage_count(int64_t _tid = tim::threading::get_id())
 {
     return coverage_thread_data::instance(construct_on_thread{ _tid });
@@ -96,8 +143,6 @@ get_coverage_count(int64_t _tid = tim::threading::get_id())
 void
 post_process()
 {
-    using data_tuple_t = coverage_data::data_tuple_t;
-
     if(get_post_processed()) return;
     get_post_processed() = true;
 
@@ -114,53 +159,46 @@ post_process()
         return;
     }
 
-    auto _data = coverage_thread_data_type{};
+    // sum the counts of the threads into the registered entries
+    auto& _modules = get_coverage_modules();
+    for(size_t i = 0; i < coverage_thread_data::size(); ++i)
     {
-        auto _coverage_map = coverage_data_map{};
-        auto _find         = [&_coverage_data, &_coverage_map](data_tuple_t&& _v) {
-            auto& _cache = _coverage_map[std::get<0>(_v)][std::get<1>(_v)];
-            auto  mitr   = _cache.find(std::get<2>(_v));
-            if(mitr != _cache.end()) return std::make_pair(mitr->second, true);
-
-            for(auto itr = _coverage_data.begin(); itr != _coverage_data.end(); ++itr)
+        const auto& _thr_data = get_coverage_count(i);
+        if(!_thr_data) continue;
+        for(const auto& itr : *_thr_data)
+        {
+            auto  mitr        = _modules.find(itr.module);
+            auto* _module     = (mitr != _modules.end()) ? &mitr->second : nullptr;
+            auto  _num_counts = itr.counts.size();
+            for(size_t j = 0; j < _num_counts; ++j)
             {
-                if(*itr == _v)
-                {
-                    _cache[std::get<2>(_v)] = itr;
-                    return std::make_pair(itr, true);
-                }
+                auto _count = itr.counts.at(j);
+                if(_count == 0) continue;
+                if(_module && j < _module->registered.size() && _module->registered.at(j))
+                    _module->data.at(j).count += _count;
+                else
+                    OMNITRACE_VERBOSE_F(
+                        0, "Warning! No matching coverage data for index %zu of %#x\n",
+                        j, itr.module);
             }
-            return std::make_pair(_coverage_data.end(), false);
-        };
+        }
+    }
 
-        for(size_t i = 0; i < coverage_thread_data::size(); ++i)
+    // drop the indices which were never registered
+    for(auto& mitr : _modules)
+    {
+        auto& _module = mitr.second;
+        for(size_t i = 0; i < _module.data.size(); ++i)
         {
-            const auto& _thr_data = *get_coverage_count(i);
-            for(const auto& file : _thr_data)
-            {
-                for(const auto& func : file.second)
-                {
-                    for(const auto& addr : func.second)
-                    {
-                        _data[file.first][func.first][addr.first] += addr.second;
-                        auto&& _v = _find({ file.first, func.first, addr.first });
-                        if(_v.second)
-                        {
-                            _v.first->count += addr.second;
-                        }
-                        else
-                        {
-                            OMNITRACE_VERBOSE_F(0,
-                                                "Warning! No matching coverage data for "
-                                                "%s :: %s (0x%x)\n",
-                                                func.first.data(), file.first.data(),
-                                                (unsigned int) addr.first);
-                        }
-                    }
-                }
-            }
+            if(_module.registered.at(i))
+                _coverage_data.emplace_back(std::move(_module.data.at(i)));
         }
     }
+    _modules.clear();
+
+    auto _data = coverage_nested_data_type{};
+    for(const auto& itr : _coverage_data)
+        _data[itr.module][itr.function][itr.address] += itr.count;
 
     for(const auto& file : _data)
     {
@@ -301,35 +339,52 @@ namespace coverage = omnitrace::coverage;
 
 extern "C" void
 omnitrace_register_source_hidden(const char* file, const char* func, size_t line,
-                                 size_t address, const char* source)
+                                 size_t address, const char* source, size_t index)
 {
     if(coverage::get_post_processed()) return;
 
     using coverage_data = coverage::coverage_data;
 
-    OMNITRACE_BASIC_VERBOSE_F(4, "[0x%x] :: %-20s :: %20s:%zu :: %s\n",
+    OMNITRACE_BASIC_VERBOSE_F(4, "[%zu][0x%x] :: %-20s :: %20s:%zu :: %s\n", index,
                               (unsigned int) address, func, file, line, source);
 
-    coverage::get_coverage_data().emplace_back(
-        coverage_data{ size_t{ 0 }, address, line, file, func,
-                       (source && strlen(source) > 0) ? source : func });
+    auto& _mutex   = coverage::get_coverage_modules_mutex();
+    auto& _modules = coverage::get_coverage_modules();
+    auto  _lk      = std::unique_lock<std::mutex>{ _mutex };
+    auto  _idx     = coverage::get_module_index(index);
+    auto& _module  = _modules[coverage::get_module_id(index)];
+    if(_idx >= _module.data.size())
+    {
+        _module.data.resize(_idx + 1);
+        _module.registered.resize(_idx + 1, false);
+    }
+
+    if(_module.registered.at(_idx))
+    {
+        // the module ids are random so a collision is possible, albeit unlikely
+        const auto& _prev = _module.data.at(_idx);
+        if(_prev.address != address || _prev.function != func)
+            OMNITRACE_VERBOSE_F(
+                0, "Warning! coverage index %#zx of %s is already registered to %s\n",
+                index, func, _prev.function.data());
+        return;
+    }
+    const char* _source = (source && strlen(source) > 0) ? source : func;
+
+    _module.registered.at(_idx) = true;
+    _module.data.at(_idx) =
+        coverage_data{ size_t{ 0 }, address, line, file, func, _source };
 
     coverage::get_code_coverage().size += 1;
     coverage::get_code_coverage().possible.modules.emplace(file);
     coverage::get_code_coverage().possible.functions.emplace(func);
     coverage::get_code_coverage().possible.addresses.emplace(address);
-
-    // initialize
-    for(size_t i = 0; i < coverage::coverage_thread_data::size(); ++i)
-    {
-        (*coverage::get_coverage_count(i))[file][func].emplace(address, 0);
-    }
 }
 
 //--------------------------------------------------------------------------------------//
 
 extern "C" void
-omnitrace_register_coverage_hidden(const char* file, const char* func, size_t address)
+omnitrace_register_coverage_hidden(size_t index)
 {
     if(coverage::get_post_processed()) return;
     if(omnitrace::get_state() < omnitrace::State::Active &&
@@ -338,9 +393,28 @@ omnitrace_register_coverage_hidden(const char* file, const char* func, size_t ad
     else if(omnitrace::get_state() >= omnitrace::State::Finalized)
         return;
 
-    OMNITRACE_BASIC_VERBOSE_F(3, "[0x%x] %-20s :: %20s\n", (unsigned int) address, func,
-                              file);
-    (*coverage::get_coverage_count())[file][func][address] += 1;
+    OMNITRACE_BASIC_VERBOSE_F(3, "[%zu]\n", index);
+
+    // the counters are only written by the owning thread so no synchronization is
+    // needed. There are only a few instrumented binaries so the binary of the previous
+    // hit is checked first and the others are searched linearly. The array grows to the
+    // largest index hit on the thread
+    static thread_local size_t _last = 0;
+
+    auto& _modules = *coverage::get_coverage_count();
+    auto  _module  = coverage::get_module_id(index);
+    if(OMNITRACE_UNLIKELY(_last >= _modules.size() || _modules[_last].module != _module))
+    {
+        _last = 0;
+        while(_last < _modules.size() && _modules[_last].module != _module)
+            ++_last;
+        if(_last == _modules.size()) _modules.emplace_back().module = _module;
+    }
+
+    auto& _counts = _modules[_last].counts;
+    auto  _idx    = coverage::get_module_index(index);
+    if(OMNITRACE_UNLIKELY(_idx >= _counts.size())) _counts.resize(_idx + 1, 0);
+    _counts[_idx] += 1;
 }
 
 //--------------------------------------------------------------------------------------//
@@ -0,0 +1,391 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/cpu_energy.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/region_intervals.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/types.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace cpu_energy
+{
+namespace
+{
+// cumulative energy counter of a RAPL domain read from a file descriptor opened once.
+// The counter wraps around at the maximum energy range of the domain
+struct domain
+{
+    domain() = default;
+    ~domain();
+
+    domain(const domain&) = delete;
+    domain& operator=(const domain&) = delete;
+
+    bool     open(const std::string& _path);
+    uint64_t read() const;
+
+    std::string label = {};  // e.g. package-0 or dram-0
+    bool        dram  = false;
+    uint64_t    range = 0;  // [uJ]
+    int         fd    = -1;
+};
+
+using sample_t = std::pair<uint64_t, std::vector<uint64_t>>;  // [uJ] per domain
+
+std::vector<std::unique_ptr<domain>> domains = {};
+std::deque<sample_t>                 data    = {};
+
+uint64_t
+read_value(int _fd)
+{
+    char _buf[32];
+    auto _n = ::pread(_fd, _buf, sizeof(_buf) - 1, 0);
+    if(_n <= 0) return 0;
+    _buf[_n] = '\0';
+    return std::strtoull(_buf, nullptr, 10);
+}
+
+domain::~domain()
+{
+    if(fd >= 0) ::close(fd);
+}
+
+bool
+domain::open(const std::string& _path)
+{
+    fd = ::open(JOIN('/', _path, "energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+
+    // the energy counter is only readable by root on recent kernels
+    char _buf[1];
+    if(::pread(fd, _buf, sizeof(_buf), 0) <= 0) return false;
+
+    auto _range = utility::read_string(JOIN('/', _path, "max_energy_range_uj"));
+    range       = std::strtoull(_range.c_str(), nullptr, 10);
+    return true;
+}
+
+uint64_t
+domain::read() const
+{
+    return read_value(fd);
+}
+
+// the zones of the sockets are intel-rapl:<socket> (also used by the AMD driver) and
+// their sub-zones are intel-rapl:<socket>:<index>
+void
+add_domain(const std::string& _zone, const std::string& _name, std::string _label,
+           bool _dram)
+{
+    auto _domain = std::make_unique<domain>();
+    if(!_domain->open(JOIN('/', "/sys/class/powercap", _zone)))
+    {
+        OMNITRACE_VERBOSE(1, "[cpu_energy::setup] '%s' (%s) is not readable\n",
+                          _zone.c_str(), _name.c_str());
+        return;
+    }
+    _domain->label = std::move(_label);
+    _domain->dram  = _dram;
+    domains.emplace_back(std::move(_domain));
+}
+
+// the cumulative energy [J] of each domain at each sample
+struct energy_series
+{
+    std::vector<uint64_t>            ts     = {};
+    std::vector<std::vector<double>> energy = {};
+
+    // the energy of the domain at the given time interpolated between the samples
+    double operator()(size_t _idx, uint64_t _ts) const;
+};
+
+double
+energy_series::operator()(size_t _idx, uint64_t _ts) const
+{
+    const auto& _energy = energy.at(_idx);
+    if(_ts <= ts.front()) return _energy.front();
+    if(_ts >= ts.back()) return _energy.back();
+
+    auto _n    = std::distance(ts.begin(), std::upper_bound(ts.begin(), ts.end(), _ts));
+    auto _lhs  = static_cast<size_t>(_n - 1);
+    auto _rhs  = static_cast<size_t>(_n);
+    auto _frac = static_cast<double>(_ts - ts.at(_lhs)) /
+                 static_cast<double>(ts.at(_rhs) - ts.at(_lhs));
+    return _energy.at(_lhs) + _frac * (_energy.at(_rhs) - _energy.at(_lhs));
+}
+
+energy_series
+get_energy_series()
+{
+    auto _v = energy_series{};
+    _v.energy.resize(domains.size());
+
+    const sample_t* _prev = nullptr;
+    for(const auto& itr : data)
+    {
+        if(_prev && itr.first <= _prev->first) continue;
+        _v.ts.emplace_back(itr.first);
+        for(size_t i = 0; i < domains.size(); ++i)
+        {
+            auto& _energy = _v.energy.at(i);
+            if(!_prev)
+            {
+                _energy.emplace_back(0.0);
+                continue;
+            }
+            auto     _curr  = itr.second.at(i);
+            auto     _last  = _prev->second.at(i);
+            auto     _range = domains.at(i)->range;
+            uint64_t _delta = 0;
+            if(_curr >= _last)
+                _delta = _curr - _last;
+            else if(_range > _last)
+                _delta = _range - _last + _curr;
+            _energy.emplace_back(_energy.back() + static_cast<double>(_delta) * 1.0e-6);
+        }
+        _prev = &itr;
+    }
+    return _v;
+}
+
+void
+post_process_perfetto(const energy_series& _series)
+{
+    using track = perfetto_counter_track<category::cpu_energy>;
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    if(!_thread_info) return;
+
+    for(size_t i = 0; i < domains.size(); ++i)
+    {
+        if(!track::exists(i))
+            track::emplace(i, JOIN("", "CPU Power [", domains.at(i)->label, "] (S)"),
+                           "watts");
+    }
+
+    // the power over each interval is reported at the end of the interval
+    for(size_t n = 1; n < _series.ts.size(); ++n)
+    {
+        auto _ts = _series.ts.at(n);
+        if(!_thread_info->is_valid_time(_ts)) continue;
+
+        auto _sec = static_cast<double>(_ts - _series.ts.at(n - 1)) / units::sec;
+        for(size_t i = 0; i < domains.size(); ++i)
+        {
+            const auto& _energy = _series.energy.at(i);
+            auto        _watts  = (_energy.at(n) - _energy.at(n - 1)) / _sec;
+            TRACE_COUNTER(trait::name<category::cpu_energy>::value, track::at(i, 0), _ts,
+                          _watts);
+        }
+    }
+
+    auto _end_ts = _thread_info->get_stop();
+    for(size_t i = 0; i < domains.size(); ++i)
+        TRACE_COUNTER(trait::name<category::cpu_energy>::value, track::at(i, 0), _end_ts,
+                      0.0);
+}
+
+struct region_energy
+{
+    uint64_t calls   = 0;
+    uint64_t time    = 0;
+    double   package = 0.0;
+    double   dram    = 0.0;
+};
+
+// the energy of the sockets is shared by every thread so the energy of the regions
+// which execute concurrently overlaps, i.e. the energy of a region is the energy
+// consumed by the sockets while the region was executing
+void
+post_process_regions(const energy_series& _series)
+{
+    auto _regions = std::unordered_map<tim::hash_value_t, region_energy>{};
+    region_intervals::for_each([&_regions, &_series](const auto& itr) {
+        auto& _region = _regions[itr.hash];
+        _region.calls += 1;
+        _region.time += (itr.end - itr.beg);
+        for(size_t i = 0; i < domains.size(); ++i)
+        {
+            auto _energy = _series(i, itr.end) - _series(i, itr.beg);
+            if(domains.at(i)->dram)
+                _region.dram += _energy;
+            else
+                _region.package += _energy;
+        }
+    });
+
+    if(_regions.empty()) return;
+
+    using entry_t = std::pair<std::string, region_energy>;
+    auto _sorted  = std::vector<entry_t>{};
+    _sorted.reserve(_regions.size());
+    for(const auto& itr : _regions)
+        _sorted.emplace_back(std::string{ tim::get_hash_identifier_fast(itr.first) },
+                             itr.second);
+
+    std::sort(_sorted.begin(), _sorted.end(), [](const auto& _lhs, const auto& _rhs) {
+        return (_lhs.second.package + _lhs.second.dram) >
+               (_rhs.second.package + _rhs.second.dram);
+    });
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("cpu-energy", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<region_energy>{}(_fname,
+                                                            std::string{ "cpu_energy" });
+
+        ofs << std::setw(12) << "calls" << " " << std::setw(12) << "time [sec]" << " "
+            << std::setw(14) << "package [J]" << " " << std::setw(12) << "dram [J]"
+            << " " << std::setw(12) << "power [W]" << "   region\n";
+        ofs << std::fixed << std::setprecision(3);
+        for(const auto& itr : _sorted)
+        {
+            const auto& _v      = itr.second;
+            auto        _sec    = static_cast<double>(_v.time) / units::sec;
+            auto        _energy = _v.package + _v.dram;
+            ofs << std::setw(12) << _v.calls << " " << std::setw(12) << _sec << " "
+                << std::setw(14) << _v.package << " " << std::setw(12) << _v.dram << " "
+                << std::setw(12) << ((_sec > 0.0) ? (_energy / _sec) : 0.0) << "   "
+                << itr.first << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening CPU energy output file: %s", _fname.c_str());
+    }
+}
+}  // namespace
+
+void
+setup()
+{
+    domains.clear();
+    data.clear();
+
+    perfetto_counter_track<category::cpu_energy>::init();
+
+    for(const auto& itr : utility::list_directory("/sys/class/powercap"))
+    {
+        // only the zones of the sockets and their DRAM sub-zones
+        if(itr.find("intel-rapl:") != 0) continue;
+
+        auto _socket = itr.substr(std::string_view{ "intel-rapl:" }.length());
+        auto _zone   = JOIN('/', "/sys/class/powercap", itr);
+        auto _name   = utility::read_string(JOIN('/', _zone, "name"));
+        auto _pos    = _socket.find(':');
+        if(_pos == std::string::npos && _name.find("package") == 0)
+            add_domain(itr, _name, _name, false);
+        else if(_pos != std::string::npos && _name == "dram")
+            add_domain(itr, _name, JOIN('-', _name, _socket.substr(0, _pos)), true);
+    }
+
+    OMNITRACE_VERBOSE(1, "[cpu_energy::setup] sampling %zu RAPL energy domains...\n",
+                      domains.size());
+
+    if(!domains.empty()) region_intervals::enable();
+}
+
+void
+config()
+{}
+
+void
+sample()
+{
+    if(domains.empty()) return;
+
+    auto _values = std::vector<uint64_t>{};
+    _values.reserve(domains.size());
+    for(const auto& itr : domains)
+        _values.emplace_back(itr->read());
+    data.emplace_back(tim::get_clock_real_now<uint64_t, std::nano>(), std::move(_values));
+}
+
+void
+shutdown()
+{}
+
+void
+post_process()
+{
+    if(domains.empty()) return;
+
+    region_intervals::disable();
+
+    tim::scope::destructor _dtor{ []() {
+        domains.clear();
+        data.clear();
+    } };
+
+    if(data.size() < 2) return;
+
+    OMNITRACE_VERBOSE(1, "Post-processing %zu CPU energy entries...\n", data.size());
+
+    auto _series = get_energy_series();
+    if(_series.ts.size() < 2) return;
+
+    if(get_use_perfetto()) post_process_perfetto(_series);
+
+    post_process_regions(_series);
+
+    auto _sec = static_cast<double>(_series.ts.back() - _series.ts.front()) / units::sec;
+    for(size_t i = 0; i < domains.size(); ++i)
+    {
+        auto _energy = _series.energy.at(i).back();
+        OMNITRACE_VERBOSE(0, "CPU energy %-12s :: %.3f J (average %.1f W)\n",
+                          domains.at(i)->label.c_str(), _energy, _energy / _sec);
+    }
+}
+}  // namespace cpu_energy
+}  // namespace omnitrace
@@ -0,0 +1,809 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/critical_path.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#if defined(OMNITRACE_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace critical_path
+{
+namespace
+{
+struct region_event
+{
+    uint64_t          ts   = 0;
+    tim::hash_value_t hash = 0;  // zero for the exit from the innermost region
+};
+
+struct wait_event
+{
+    uint64_t key = 0;
+    uint64_t beg = 0;
+    uint64_t end = 0;
+};
+
+struct signal_event
+{
+    int64_t  tid = 0;  // thread which sent the signal
+    uint64_t key = 0;
+    uint64_t ts  = 0;
+};
+
+// only modified by the owning thread
+struct thread_timeline
+{
+    std::vector<region_event> regions = {};
+    std::vector<wait_event>   waits   = {};
+    std::vector<signal_event> signals = {};
+};
+
+struct kernel_event
+{
+    const char* name   = nullptr;
+    int64_t     tid    = -1;
+    uint64_t    launch = 0;
+    uint64_t    beg    = 0;
+    uint64_t    end    = 0;
+};
+
+using lane_key_t = std::pair<int32_t, int64_t>;  // device, queue
+
+struct device_timelines
+{
+    locking::atomic_mutex                           mutex = {};
+    std::map<lane_key_t, std::vector<kernel_event>> lanes = {};
+};
+
+// the dependency graph: the timelines (threads and device queues) of the ranks and the
+// waits and signals between them. Trivially copyable so that the graphs of the ranks
+// are gathered as bytes
+struct node
+{
+    int64_t  rank   = 0;
+    int64_t  device = -1;  // -1 for the threads
+    int64_t  id     = 0;   // sequent thread id or queue id
+    uint64_t beg    = 0;
+    uint64_t end    = 0;
+};
+
+struct wait_edge
+{
+    uint64_t node = 0;
+    uint64_t key  = 0;
+    uint64_t beg  = 0;
+    uint64_t end  = 0;
+};
+
+struct signal_edge
+{
+    uint64_t node = 0;
+    uint64_t key  = 0;
+    uint64_t ts   = 0;
+};
+
+struct segment
+{
+    uint64_t node = 0;
+    uint64_t beg  = 0;
+    uint64_t end  = 0;
+};
+
+struct graph
+{
+    std::vector<node>        nodes   = {};
+    std::vector<wait_edge>   waits   = {};
+    std::vector<signal_edge> signals = {};
+};
+
+using time_table_t = std::map<std::string, uint64_t>;
+
+auto&
+get_thread_timeline(int64_t _tid = threading::get_id())
+{
+    using thread_data_t = thread_data<thread_timeline>;
+    return thread_data_t::instance(construct_on_thread{ _tid });
+}
+
+auto&
+get_device_timelines()
+{
+    static auto* _v = new device_timelines{};
+    return *_v;
+}
+
+uint64_t
+mix(uint64_t _v)
+{
+    _v += 0x9E3779B97F4A7C15ULL;
+    _v = (_v ^ (_v >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    _v = (_v ^ (_v >> 27)) * 0x94D049BB133111EBULL;
+    return _v ^ (_v >> 31);
+}
+
+// the MPI keys are computed identically on every rank (see mpi_flow), the other keys
+// are only meaningful within the process
+uint64_t
+scope_key(uint64_t _key, int64_t _rank)
+{
+    auto _kind = static_cast<sync_kind>(_key >> 56);
+    if(_kind == SYNC_MPI) return _key;
+    return get_key(_kind, mix(_key ^ mix(static_cast<uint64_t>(_rank))));
+}
+
+// the threads are the first nodes, indexed by their sequent id, followed by the queues
+graph
+build_graph(int64_t _rank, uint64_t _end)
+{
+    auto _graph    = graph{};
+    auto _nthreads = thread_info::get_peak_num_threads();
+
+    for(size_t i = 0; i < _nthreads; ++i)
+    {
+        auto        _node = node{ _rank, -1, static_cast<int64_t>(i), 0, _end };
+        const auto& _info = thread_info::get(i, SequentTID);
+        if(_info)
+        {
+            _node.beg = _info->get_start();
+            if(_info->get_stop() > _node.beg) _node.end = _info->get_stop();
+        }
+        _graph.nodes.emplace_back(_node);
+
+        const auto& _timeline = get_thread_timeline(i);
+        if(!_timeline) continue;
+
+        for(const auto& itr : _timeline->waits)
+            _graph.waits.emplace_back(
+                wait_edge{ i, scope_key(itr.key, _rank), itr.beg, itr.end });
+        for(const auto& itr : _timeline->signals)
+        {
+            if(itr.tid < 0 || static_cast<size_t>(itr.tid) >= _nthreads) continue;
+            _graph.signals.emplace_back(signal_edge{
+                static_cast<uint64_t>(itr.tid), scope_key(itr.key, _rank), itr.ts });
+        }
+    }
+
+    // a kernel waits for its launch when the queue was idle when it was launched and
+    // the device synchronizations wait for the completion of the kernels
+    auto& _devices = get_device_timelines();
+    auto  _lk      = locking::atomic_lock{ _devices.mutex };
+    for(auto& litr : _devices.lanes)
+    {
+        auto& _kernels = litr.second;
+        if(_kernels.empty()) continue;
+
+        std::sort(_kernels.begin(), _kernels.end(),
+                  [](const kernel_event& _lhs, const kernel_event& _rhs) {
+                      return _lhs.beg < _rhs.beg;
+                  });
+
+        auto _idx  = static_cast<uint64_t>(_graph.nodes.size());
+        auto _node = node{ _rank, litr.first.first, litr.first.second,
+                           _kernels.front().beg, 0 };
+        auto _done = scope_key(get_key(SYNC_DEVICE, litr.first.first), _rank);
+        auto _prev = uint64_t{ 0 };
+        for(size_t i = 0; i < _kernels.size(); ++i)
+        {
+            const auto& itr = _kernels.at(i);
+            if(itr.tid >= 0 && static_cast<size_t>(itr.tid) < _nthreads)
+            {
+                auto _key = scope_key(get_key(SYNC_LAUNCH, mix(_idx) ^ i), _rank);
+                _graph.waits.emplace_back(wait_edge{ _idx, _key, _prev, itr.beg });
+                _graph.signals.emplace_back(
+                    signal_edge{ static_cast<uint64_t>(itr.tid), _key, itr.launch });
+            }
+            _graph.signals.emplace_back(signal_edge{ _idx, _done, itr.end });
+            _prev     = std::max(_prev, itr.end);
+            _node.end = std::max(_node.end, itr.end);
+        }
+        _graph.nodes.emplace_back(_node);
+    }
+
+    return _graph;
+}
+
+// walks the critical path backward from the end of the main thread which finished last
+std::vector<segment>
+walk(const graph& _graph)
+{
+    const auto& _nodes = _graph.nodes;
+
+    auto _signals = std::unordered_map<uint64_t, std::vector<const signal_edge*>>{};
+    for(const auto& itr : _graph.signals)
+        _signals[itr.key].emplace_back(&itr);
+    for(auto& itr : _signals)
+        std::sort(itr.second.begin(), itr.second.end(),
+                  [](const signal_edge* _lhs, const signal_edge* _rhs) {
+                      return _lhs->ts < _rhs->ts;
+                  });
+
+    // the waits which were released by another timeline after they began, in the
+    // order of their end on each timeline
+    struct release
+    {
+        uint64_t end  = 0;
+        uint64_t node = 0;  // timeline and time of the signal
+        uint64_t ts   = 0;
+    };
+
+    auto _released = std::vector<std::vector<release>>(_nodes.size());
+    for(const auto& itr : _graph.waits)
+    {
+        auto sitr = _signals.find(itr.key);
+        if(sitr == _signals.end()) continue;
+
+        const auto& _v   = sitr->second;
+        auto        _pos = std::upper_bound(
+            _v.begin(), _v.end(), itr.end,
+            [](uint64_t _ts, const signal_edge* _sig) { return _ts < _sig->ts; });
+        while(_pos != _v.begin())
+        {
+            const auto* _sig = *(--_pos);
+            if(_sig->ts < itr.beg) break;
+            if(_sig->node == itr.node) continue;
+            _released.at(itr.node).emplace_back(release{ itr.end, _sig->node, _sig->ts });
+            break;
+        }
+    }
+
+    for(auto& itr : _released)
+        std::sort(itr.begin(), itr.end(), [](const release& _lhs, const release& _rhs) {
+            return _lhs.end < _rhs.end;
+        });
+
+    auto _node = _nodes.size();
+    for(size_t i = 0; i < _nodes.size(); ++i)
+    {
+        if(_nodes.at(i).device >= 0 || _nodes.at(i).id != 0) continue;
+        if(_node == _nodes.size() || _nodes.at(i).end > _nodes.at(_node).end) _node = i;
+    }
+
+    auto _path = std::vector<segment>{};
+    if(_node == _nodes.size()) return _path;
+
+    // every transition moves to an earlier wait so the number of waits bounds the walk
+    auto _ts = _nodes.at(_node).end;
+    for(size_t n = 0; n <= _graph.waits.size(); ++n)
+    {
+        const auto& _v   = _released.at(_node);
+        auto        _pos = std::upper_bound(
+            _v.begin(), _v.end(), _ts,
+            [](uint64_t _t, const release& _rel) { return _t < _rel.end; });
+
+        if(_pos == _v.begin())
+        {
+            auto _beg = std::min(_nodes.at(_node).beg, _ts);
+            if(_beg < _ts) _path.emplace_back(segment{ _node, _beg, _ts });
+            break;
+        }
+
+        --_pos;
+        if(_pos->end < _ts) _path.emplace_back(segment{ _node, _pos->end, _ts });
+        _node = _pos->node;
+        _ts   = _pos->ts;
+    }
+
+    return _path;
+}
+
+// the time of the local segments of the path in the innermost region of the threads
+// and in the kernels of the device queues
+time_table_t
+attribute(const graph& _graph, const std::vector<segment>& _path)
+{
+    constexpr auto no_region = "[outside of any region]";
+    constexpr auto no_kernel = "[device queue idle]";
+
+    auto _names = std::unordered_map<tim::hash_value_t, std::string>{};
+    auto _table = time_table_t{};
+
+    // the innermost region from the start of each interval to the start of the next
+    using interval_t = std::pair<uint64_t, tim::hash_value_t>;
+    auto _intervals  = std::unordered_map<uint64_t, std::vector<interval_t>>{};
+
+    auto _get_intervals = [&_intervals](uint64_t _tid) -> const std::vector<interval_t>& {
+        auto itr = _intervals.find(_tid);
+        if(itr != _intervals.end()) return itr->second;
+
+        auto& _v     = _intervals[_tid];
+        auto  _stack = std::vector<tim::hash_value_t>{};
+        if(const auto& _timeline = get_thread_timeline(_tid))
+        {
+            for(const auto& eitr : _timeline->regions)
+            {
+                if(eitr.hash != 0)
+                    _stack.emplace_back(eitr.hash);
+                else if(!_stack.empty())
+                    _stack.pop_back();
+                _v.emplace_back(eitr.ts, (_stack.empty()) ? 0 : _stack.back());
+            }
+        }
+        return _v;
+    };
+
+    auto _get_name = [&_names](tim::hash_value_t _hash) -> const std::string& {
+        auto itr = _names.find(_hash);
+        if(itr == _names.end())
+            itr = _names
+                      .emplace(_hash, std::string{ tim::get_hash_identifier_fast(_hash) })
+                      .first;
+        return itr->second;
+    };
+
+    auto& _devices = get_device_timelines();
+    auto  _lk      = locking::atomic_lock{ _devices.mutex };
+    for(const auto& itr : _path)
+    {
+        const auto& _node = _graph.nodes.at(itr.node);
+        if(_node.device < 0)
+        {
+            const auto& _v = _get_intervals(_node.id);
+            // first interval which begins after the beginning of the segment
+            auto _pos = std::upper_bound(
+                _v.begin(), _v.end(), itr.beg,
+                [](uint64_t _ts, const interval_t& _interval) {
+                    return _ts < _interval.first;
+                });
+
+            auto _beg  = itr.beg;
+            auto _hash = (_pos == _v.begin()) ? tim::hash_value_t{ 0 }
+                                              : std::prev(_pos)->second;
+            for(; _beg < itr.end; ++_pos)
+            {
+                auto _next =
+                    (_pos == _v.end()) ? itr.end : std::min(_pos->first, itr.end);
+                if(_next > _beg)
+                    _table[(_hash == 0) ? no_region : _get_name(_hash)] += (_next - _beg);
+                if(_pos == _v.end()) break;
+                _beg  = std::max(_beg, _next);
+                _hash = _pos->second;
+            }
+        }
+        else
+        {
+            auto litr = _devices.lanes.find(
+                lane_key_t{ static_cast<int32_t>(_node.device), _node.id });
+            if(litr == _devices.lanes.end()) continue;
+
+            uint64_t _busy = 0;
+            for(const auto& kitr : litr->second)
+            {
+                if(kitr.beg >= itr.end) break;
+                auto _beg = std::max(kitr.beg, itr.beg);
+                auto _end = std::min(kitr.end, itr.end);
+                if(_end <= _beg) continue;
+                _table[tim::demangle(kitr.name)] += (_end - _beg);
+                _busy += (_end - _beg);
+            }
+            auto _len = itr.end - itr.beg;
+            if(_len > _busy) _table[no_kernel] += (_len - _busy);
+        }
+    }
+
+    return _table;
+}
+
+template <typename Tp>
+void
+pack(std::string& _buf, const std::vector<Tp>& _data)
+{
+    static_assert(std::is_trivially_copyable<Tp>::value,
+                  "Type must be trivially copyable");
+    auto _n = static_cast<uint64_t>(_data.size());
+    _buf.append(reinterpret_cast<const char*>(&_n), sizeof(_n));
+    _buf.append(reinterpret_cast<const char*>(_data.data()), _n * sizeof(Tp));
+}
+
+template <typename Tp>
+std::vector<Tp>
+unpack(std::string_view& _buf)
+{
+    auto _n = uint64_t{ 0 };
+    if(_buf.size() < sizeof(_n)) return std::vector<Tp>{};
+    std::memcpy(&_n, _buf.data(), sizeof(_n));
+    _buf.remove_prefix(sizeof(_n));
+
+    auto _v = std::vector<Tp>(std::min<uint64_t>(_n, _buf.size() / sizeof(Tp)));
+    std::memcpy(_v.data(), _buf.data(), _v.size() * sizeof(Tp));
+    _buf.remove_prefix(std::min<size_t>(_n * sizeof(Tp), _buf.size()));
+    return _v;
+}
+
+std::string
+serialize(const time_table_t& _table)
+{
+    auto _ss = std::stringstream{};
+    for(const auto& itr : _table)
+        _ss << itr.second << ' ' << itr.first << '\n';
+    return _ss.str();
+}
+
+void
+deserialize(const std::string& _buf, time_table_t& _table)
+{
+    auto _ss   = std::stringstream{ _buf };
+    auto _line = std::string{};
+    while(std::getline(_ss, _line))
+    {
+        auto _pos = _line.find(' ');
+        if(_pos == std::string::npos) continue;
+        _table[_line.substr(_pos + 1)] += std::stoull(_line.substr(0, _pos));
+    }
+}
+
+#if defined(OMNITRACE_USE_MPI)
+// the analysis spans the ranks when this is invoked from MPI_Finalize
+bool
+use_mpi()
+{
+    int _initialized = 0;
+    int _finalized   = 0;
+    int _size        = 1;
+    PMPI_Initialized(&_initialized);
+    PMPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0) return false;
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+    return (_size > 1);
+}
+
+// returns the buffers of every rank on rank 0. Every rank computes the same sizes so
+// the ranks agree when the buffers do not fit in an int
+std::vector<std::string>
+gather_bytes(const std::string& _local, bool& _ok)
+{
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+
+    auto _counts = std::vector<int64_t>(_size, 0);
+    auto _nlocal = static_cast<int64_t>(_local.size());
+    PMPI_Allgather(&_nlocal, 1, MPI_INT64_T, _counts.data(), 1, MPI_INT64_T,
+                   MPI_COMM_WORLD);
+
+    int64_t _total = 0;
+    for(auto itr : _counts)
+        _total += itr;
+
+    _ok = (_total <= INT_MAX);
+    if(!_ok) return std::vector<std::string>{};
+
+    auto _bytes  = std::vector<int>(_size, 0);
+    auto _displs = std::vector<int>(_size, 0);
+    for(int i = 0; i < _size; ++i)
+    {
+        _bytes.at(i) = static_cast<int>(_counts.at(i));
+        if(i > 0) _displs.at(i) = _displs.at(i - 1) + _bytes.at(i - 1);
+    }
+
+    auto _all = std::string(static_cast<size_t>((_rank == 0) ? _total : 0), '\0');
+    PMPI_Gatherv(_local.data(), _bytes.at(_rank), MPI_BYTE, _all.data(), _bytes.data(),
+                 _displs.data(), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    auto _data = std::vector<std::string>{};
+    if(_rank == 0)
+    {
+        for(int i = 0; i < _size; ++i)
+            _data.emplace_back(_all.substr(_displs.at(i), _bytes.at(i)));
+    }
+    return _data;
+}
+
+// sends each rank its buffer from rank 0
+std::string
+scatter_bytes(const std::vector<std::string>& _data)
+{
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+
+    auto _bytes  = std::vector<int>(_size, 0);
+    auto _displs = std::vector<int>(_size, 0);
+    auto _all    = std::string{};
+    if(_rank == 0)
+    {
+        for(int i = 0; i < _size; ++i)
+        {
+            _bytes.at(i)  = static_cast<int>(_data.at(i).size());
+            _displs.at(i) = static_cast<int>(_all.size());
+            _all += _data.at(i);
+        }
+    }
+
+    int _nlocal = 0;
+    PMPI_Scatter(_bytes.data(), 1, MPI_INT, &_nlocal, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    auto _local = std::string(static_cast<size_t>(_nlocal), '\0');
+    PMPI_Scatterv(_all.data(), _bytes.data(), _displs.data(), MPI_BYTE, _local.data(),
+                  _nlocal, MPI_BYTE, 0, MPI_COMM_WORLD);
+    return _local;
+}
+#endif
+
+std::string
+get_label(const node& _node, bool _ranks)
+{
+    auto _prefix = (_ranks) ? JOIN("", "rank ", _node.rank, ", ") : std::string{};
+    if(_node.device < 0) return JOIN("", _prefix, "thread ", _node.id);
+    return JOIN("", _prefix, "device ", _node.device, ", queue ", _node.id);
+}
+
+void
+write_report(const graph& _graph, const std::vector<segment>& _path,
+             const time_table_t& _table, bool _ranks)
+{
+    uint64_t _length = 0;
+    auto     _nodes  = std::map<uint64_t, uint64_t>{};
+    for(const auto& itr : _path)
+    {
+        _length += (itr.end - itr.beg);
+        _nodes[itr.node] += (itr.end - itr.beg);
+    }
+
+    if(_length == 0) return;
+
+    auto _entries = std::vector<std::pair<uint64_t, std::string>>{};
+    for(const auto& itr : _table)
+        _entries.emplace_back(itr.second, itr.first);
+    std::sort(_entries.begin(), _entries.end(), std::greater<>{});
+
+    auto _timelines = std::vector<std::pair<uint64_t, std::string>>{};
+    for(const auto& itr : _nodes)
+        _timelines.emplace_back(itr.second,
+                                get_label(_graph.nodes.at(itr.first), _ranks));
+    std::sort(_timelines.begin(), _timelines.end(), std::greater<>{});
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / units::msec; };
+    auto _pct  = [_length](uint64_t _v) { return (100.0 * _v) / _length; };
+
+    OMNITRACE_VERBOSE(0,
+                      "[critical_path] %.3f msec across %zu timelines (%zu segments)\n",
+                      _msec(_length), _nodes.size(), _path.size());
+    for(size_t i = 0; i < std::min<size_t>(_entries.size(), 5); ++i)
+    {
+        OMNITRACE_VERBOSE(1, "[critical_path] %10.3f msec (%5.1f%%) %s\n",
+                          _msec(_entries.at(i).first), _pct(_entries.at(i).first),
+                          _entries.at(i).second.c_str());
+    }
+
+    auto _fname = tim::settings::compose_output_filename("critical-path", ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening critical path output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<segment>{}(
+            _fname, std::string{ "critical_path" });
+
+    _ofs << std::fixed << std::setprecision(3);
+    _ofs << "# critical path: " << _msec(_length) << " msec across " << _nodes.size()
+         << " timelines (" << _path.size() << " segments)\n\n";
+    _ofs << std::setw(14) << "time [msec]" << std::setw(10) << "% path"
+         << "   region / kernel\n";
+    for(const auto& itr : _entries)
+        _ofs << std::setw(14) << _msec(itr.first) << std::setw(9) << _pct(itr.first)
+             << "%   " << itr.second << "\n";
+
+    _ofs << "\n" << std::setw(14) << "time [msec]" << std::setw(10) << "% path"
+         << "   timeline\n";
+    for(const auto& itr : _timelines)
+        _ofs << std::setw(14) << _msec(itr.first) << std::setw(9) << _pct(itr.first)
+             << "%   " << itr.second << "\n";
+}
+}  // namespace
+
+void
+setup()
+{
+    get_enabled().store(config::get_critical_path());
+}
+
+void
+push(tim::hash_value_t _hash)
+{
+    static thread_local auto& _timeline = get_thread_timeline();
+    _timeline->regions.emplace_back(region_event{ tracing::now(), _hash });
+}
+
+void
+pop()
+{
+    static thread_local auto& _timeline = get_thread_timeline();
+    _timeline->regions.emplace_back(region_event{ tracing::now(), 0 });
+}
+
+void
+signal(uint64_t _key, uint64_t _ts)
+{
+    static thread_local auto& _timeline = get_thread_timeline();
+    _timeline->signals.emplace_back(signal_event{ threading::get_id(), _key, _ts });
+}
+
+void
+wait(uint64_t _key, uint64_t _beg, uint64_t _end)
+{
+    static thread_local auto& _timeline = get_thread_timeline();
+    _timeline->waits.emplace_back(wait_event{ _key, _beg, _end });
+}
+
+void
+thread_start(int64_t _parent, uint64_t _create_ts)
+{
+    auto  _key      = get_key(SYNC_THREAD, threading::get_id());
+    auto& _timeline = get_thread_timeline();
+    _timeline->signals.emplace_back(signal_event{ _parent, _key, _create_ts });
+    _timeline->waits.emplace_back(wait_event{ _key, 0, tracing::now() });
+}
+
+void
+thread_stop()
+{
+    signal(get_key(SYNC_THREAD, threading::get_id()), tracing::now());
+}
+
+void
+thread_join(int64_t _tid, uint64_t _beg, uint64_t _end)
+{
+    wait(get_key(SYNC_THREAD, _tid), _beg, _end);
+}
+
+void
+kernel(int32_t _device, int64_t _queue, const char* _name, int64_t _tid,
+       uint64_t _launch, uint64_t _beg, uint64_t _end)
+{
+    if(!_name) return;
+    auto& _devices = get_device_timelines();
+    auto  _lk      = locking::atomic_lock{ _devices.mutex };
+    _devices.lanes[lane_key_t{ _device, _queue }].emplace_back(
+        kernel_event{ _name, _tid, _launch, _beg, _end });
+}
+
+void
+post_process()
+{
+    if(!is_enabled()) return;
+    get_enabled().store(false);
+
+    auto _end   = tracing::now();
+    auto _local = build_graph(dmp::rank(), _end);
+
+#if defined(OMNITRACE_USE_MPI)
+    if(use_mpi())
+    {
+        int _rank = 0;
+        int _size = 1;
+        PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+        PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+
+        auto _buf = std::string{};
+        pack(_buf, _local.nodes);
+        pack(_buf, _local.waits);
+        pack(_buf, _local.signals);
+
+        bool _ok  = false;
+        auto _all = gather_bytes(_buf, _ok);
+        if(!_ok)
+        {
+            OMNITRACE_VERBOSE(0, "[critical_path] the graphs of the ranks are too large "
+                                 "to be gathered. Computing the path of each rank\n");
+        }
+        else
+        {
+            // the path is walked on rank 0 and each rank attributes its segments
+            auto _graph = graph{};
+            auto _path  = std::vector<segment>{};
+            auto _parts = std::vector<std::string>(_size);
+            if(_rank == 0)
+            {
+                auto _offsets = std::vector<uint64_t>{};
+                for(const auto& itr : _all)
+                {
+                    auto _view    = std::string_view{ itr };
+                    auto _nodes   = unpack<node>(_view);
+                    auto _waits   = unpack<wait_edge>(_view);
+                    auto _signals = unpack<signal_edge>(_view);
+                    auto _offset  = static_cast<uint64_t>(_graph.nodes.size());
+                    _offsets.emplace_back(_offset);
+                    for(const auto& nitr : _nodes)
+                        _graph.nodes.emplace_back(nitr);
+                    for(auto witr : _waits)
+                    {
+                        witr.node += _offset;
+                        _graph.waits.emplace_back(witr);
+                    }
+                    for(auto sitr : _signals)
+                    {
+                        sitr.node += _offset;
+                        _graph.signals.emplace_back(sitr);
+                    }
+                }
+
+                _path = walk(_graph);
+
+                auto _segments = std::vector<std::vector<segment>>(_size);
+                for(const auto& itr : _path)
+                {
+                    auto _r = _graph.nodes.at(itr.node).rank;
+                    if(_r < 0 || _r >= _size) continue;
+                    _segments.at(_r).emplace_back(
+                        segment{ itr.node - _offsets.at(_r), itr.beg, itr.end });
+                }
+                for(int i = 0; i < _size; ++i)
+                    pack(_parts.at(i), _segments.at(i));
+            }
+
+            auto _mine  = scatter_bytes(_parts);
+            auto _view  = std::string_view{ _mine };
+            auto _table = attribute(_local, unpack<segment>(_view));
+
+            auto _tables = gather_bytes(serialize(_table), _ok);
+            if(_rank != 0) return;
+
+            auto _merged = time_table_t{};
+            for(const auto& itr : _tables)
+                deserialize(itr, _merged);
+            write_report(_graph, _path, _merged, true);
+            return;
+        }
+    }
+#endif
+
+    auto _path = walk(_local);
+    write_report(_local, _path, attribute(_local, _path), false);
+}
+}  // namespace critical_path
+}  // namespace omnitrace
@@ -0,0 +1,112 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/hash/types.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+namespace omnitrace
+{
+// critical-path analysis (OMNITRACE_CRITICAL_PATH): the threads record the entry into
+// and exit from their regions and how they synchronize with the other threads, the
+// other ranks and the GPUs. A wait on a key is released by the last signal on the same
+// key from another timeline before the wait returned. During finalization, the path is
+// walked backward from the end of the main thread: along a timeline, the time is spent
+// in the innermost region (or kernel) and, when the timeline was blocked in a wait
+// which was released after the wait began, the path continues on the timeline which
+// sent the signal at the time of the signal.
+namespace critical_path
+{
+enum sync_kind : uint8_t
+{
+    SYNC_THREAD = 1,  // pthread_create -> thread start, thread exit -> pthread_join
+    SYNC_LOCK,        // lock release -> contended acquisition
+    SYNC_BARRIER,     // last arrival -> pthread_barrier_wait
+    SYNC_MPI,         // MPI send -> receive, last arrival -> collective
+    SYNC_LAUNCH,      // kernel launch -> kernel start
+    SYNC_DEVICE,      // kernel completion -> device synchronization
+};
+
+inline std::atomic<bool>&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+inline bool
+is_enabled()
+{
+    return get_enabled().load(std::memory_order_relaxed);
+}
+
+inline uint64_t
+get_key(sync_kind _kind, uint64_t _value)
+{
+    return (static_cast<uint64_t>(_kind) << 56) ^ (_value & ((1ULL << 56) - 1));
+}
+
+void
+setup();
+
+// the regions of the calling thread
+void
+push(tim::hash_value_t _hash);
+
+void
+pop();
+
+// the calling thread releases the waiters on the key
+void
+signal(uint64_t _key, uint64_t _ts);
+
+// the calling thread was blocked on the key from _beg to _end
+void
+wait(uint64_t _key, uint64_t _beg, uint64_t _end);
+
+// the calling thread was created by the given thread (sequent id) at the given time
+void
+thread_start(int64_t _parent, uint64_t _create_ts);
+
+// the calling thread exits
+void
+thread_stop();
+
+// the calling thread joined the given thread (sequent id)
+void
+thread_join(int64_t _tid, uint64_t _beg, uint64_t _end);
+
+// the execution of a kernel launched by the given thread (sequent id). May be invoked
+// from any thread
+void
+kernel(int32_t _device, int64_t _queue, const char* _name, int64_t _tid,
+       uint64_t _launch, uint64_t _beg, uint64_t _end);
+
+// computes the critical path (across the ranks when invoked from MPI_Finalize) and
+// writes the time of each region and kernel on the path
+void
+post_process();
+}  // namespace critical_path
+}  // namespace omnitrace
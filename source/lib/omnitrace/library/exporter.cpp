@@ -0,0 +1,604 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/exporter.hpp"
+#include "binary/analysis.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/string_arena.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/runtime.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/utility/demangle.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <netdb.h>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace exporter
+{
+namespace
+{
+std::atomic<bool> active = { false };
+
+struct region_stats
+{
+    const char* name  = nullptr;
+    uint64_t    count = 0;
+    uint64_t    sum   = 0;
+    uint64_t    min   = std::numeric_limits<uint64_t>::max();
+    uint64_t    max   = 0;
+
+    void record(uint64_t _v)
+    {
+        count += 1;
+        sum += _v;
+        min = std::min(min, _v);
+        max = std::max(max, _v);
+    }
+
+    region_stats& operator+=(const region_stats& _rhs)
+    {
+        if(!name) name = _rhs.name;
+        count += _rhs.count;
+        sum += _rhs.sum;
+        min = std::min(min, _rhs.min);
+        max = std::max(max, _rhs.max);
+        return *this;
+    }
+};
+
+using region_map_t = std::unordered_map<tim::hash_value_t, region_stats>;
+
+// the statistics of the regions which a thread completed since the previous message.
+// The owning thread only try-locks the table so it never waits on the exporter
+struct thread_table
+{
+    bool try_lock() { return !m_busy.exchange(true, std::memory_order_acquire); }
+    void unlock() { m_busy.store(false, std::memory_order_release); }
+    void lock()
+    {
+        while(!try_lock())
+            std::this_thread::yield();
+    }
+
+    std::atomic<uint64_t> dropped = { 0 };
+    region_map_t          data    = {};
+
+    // the open regions of the thread. Only accessed by the owning thread
+    std::vector<std::pair<tim::hash_value_t, uint64_t>> stack = {};
+
+private:
+    std::atomic<bool> m_busy = { false };
+};
+
+std::mutex&
+get_tables_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_tables()
+{
+    static auto _v = std::vector<std::shared_ptr<thread_table>>{};
+    return _v;
+}
+
+thread_table&
+get_thread_table()
+{
+    // the tables are kept after the thread exits so its last regions are exported
+    static thread_local auto _v = []() {
+        auto _table = std::make_shared<thread_table>();
+        auto _lk    = std::unique_lock<std::mutex>{ get_tables_mutex() };
+        get_tables().emplace_back(_table);
+        return _table;
+    }();
+    return *_v;
+}
+
+// lock-free, fixed-size open-addressing table of the innermost addresses of the
+// samples. The signal handlers claim a slot with a CAS and increment its count. The
+// exporter takes the counts and releases the slots which were not sampled since the
+// previous message. A sample which races with the release of its slot may be
+// attributed to the next address claiming the slot, which is negligible for a
+// hot-spot summary
+struct hotspot_table
+{
+    static constexpr size_t capacity   = 16384;
+    static constexpr size_t max_probes = 16;
+
+    struct slot
+    {
+        std::atomic<uintptr_t> address = { 0 };
+        std::atomic<uint64_t>  count   = { 0 };
+    };
+
+    void record(uintptr_t _addr)
+    {
+        // fibonacci hashing: instruction addresses are not uniformly distributed
+        auto _idx = static_cast<size_t>((_addr * 0x9E3779B97F4A7C15ULL) >> 50);
+        for(size_t i = 0; i < max_probes; ++i)
+        {
+            auto& _slot = slots[(_idx + i) % capacity];
+            auto  _cur  = _slot.address.load(std::memory_order_acquire);
+            if(_cur == 0 && _slot.address.compare_exchange_strong(
+                                _cur, _addr, std::memory_order_acq_rel))
+                _cur = _addr;
+            if(_cur == _addr)
+            {
+                _slot.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t>      dropped = { 0 };
+    std::array<slot, capacity> slots   = {};
+};
+
+hotspot_table*
+get_hotspot_table()
+{
+    static auto* _v = new hotspot_table{};
+    return _v;
+}
+
+// non-blocking stream socket to the collector. The messages are queued up to the
+// buffer limit and written when the socket accepts them. A message which was
+// partially written when the connection is lost is dropped so that the collector
+// never receives a truncated message after a reconnection
+struct connection
+{
+    explicit connection(std::string _endpoint, size_t _capacity)
+    : m_capacity{ _capacity }
+    , m_endpoint{ std::move(_endpoint) }
+    {}
+
+    ~connection() { close(); }
+
+    connection(const connection&) = delete;
+    connection& operator=(const connection&) = delete;
+
+    void     push(std::string&& _msg);
+    void     flush();
+    uint64_t dropped() const { return m_dropped; }
+
+private:
+    bool open();
+    void close();
+
+    int                     m_fd        = -1;
+    bool                    m_connected = false;
+    size_t                  m_capacity  = 0;
+    size_t                  m_size      = 0;
+    size_t                  m_offset    = 0;  // bytes of the front message written
+    uint64_t                m_dropped   = 0;
+    std::string             m_endpoint  = {};
+    std::deque<std::string> m_queue     = {};
+};
+
+void
+connection::push(std::string&& _msg)
+{
+    auto _len = static_cast<uint32_t>(_msg.length());
+    if(m_size + _len + 4 > m_capacity)
+    {
+        ++m_dropped;
+        return;
+    }
+
+    auto _frame = std::string{};
+    _frame.reserve(_len + 4);
+    for(int i = 3; i >= 0; --i)
+        _frame += static_cast<char>((_len >> (8 * i)) & 0xff);
+    _frame += _msg;
+
+    m_size += _frame.length();
+    m_queue.emplace_back(std::move(_frame));
+}
+
+bool
+connection::open()
+{
+    static constexpr auto _unix_prefix = std::string_view{ "unix:" };
+
+    auto _flags = SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC;
+    auto _ret   = -1;
+    if(m_endpoint.find(_unix_prefix) == 0)
+    {
+        auto _path = m_endpoint.substr(_unix_prefix.length());
+        auto _addr = sockaddr_un{};
+        if(_path.empty() || _path.length() >= sizeof(_addr.sun_path)) return false;
+
+        _addr.sun_family = AF_UNIX;
+        strncpy(_addr.sun_path, _path.c_str(), sizeof(_addr.sun_path) - 1);
+        m_fd = socket(AF_UNIX, _flags, 0);
+        if(m_fd < 0) return false;
+        _ret = connect(m_fd, reinterpret_cast<sockaddr*>(&_addr), sizeof(_addr));
+    }
+    else
+    {
+        auto _pos = m_endpoint.find_last_of(':');
+        if(_pos == std::string::npos) return false;
+
+        auto  _host  = m_endpoint.substr(0, _pos);
+        auto  _port  = m_endpoint.substr(_pos + 1);
+        auto  _hints = addrinfo{};
+        auto* _info  = static_cast<addrinfo*>(nullptr);
+        _hints.ai_family   = AF_UNSPEC;
+        _hints.ai_socktype = SOCK_STREAM;
+        if(getaddrinfo(_host.c_str(), _port.c_str(), &_hints, &_info) != 0 || !_info)
+            return false;
+
+        m_fd = socket(_info->ai_family, _flags, _info->ai_protocol);
+        if(m_fd >= 0) _ret = connect(m_fd, _info->ai_addr, _info->ai_addrlen);
+        freeaddrinfo(_info);
+        if(m_fd < 0) return false;
+    }
+
+    if(_ret != 0 && errno != EINPROGRESS)
+    {
+        close();
+        return false;
+    }
+
+    m_connected = (_ret == 0);
+    return true;
+}
+
+void
+connection::close()
+{
+    if(m_fd >= 0) ::close(m_fd);
+    m_fd        = -1;
+    m_connected = false;
+
+    if(m_offset > 0 && !m_queue.empty())
+    {
+        m_size -= m_queue.front().length();
+        m_queue.pop_front();
+        m_offset = 0;
+        ++m_dropped;
+    }
+}
+
+void
+connection::flush()
+{
+    if(m_queue.empty()) return;
+    if(m_fd < 0 && !open()) return;
+
+    if(!m_connected)
+    {
+        auto _pfd = pollfd{ m_fd, POLLOUT, 0 };
+        if(poll(&_pfd, 1, 0) <= 0) return;  // still connecting
+
+        int  _err = 0;
+        auto _len = socklen_t{ sizeof(_err) };
+        if(getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &_err, &_len) != 0 || _err != 0)
+        {
+            close();
+            return;
+        }
+        m_connected = true;
+    }
+
+    while(!m_queue.empty())
+    {
+        const auto& _frame = m_queue.front();
+        auto _n = ::send(m_fd, _frame.data() + m_offset, _frame.length() - m_offset,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(_n < 0)
+        {
+            if(errno == EINTR) continue;
+            if(errno != EAGAIN && errno != EWOULDBLOCK) close();
+            return;
+        }
+
+        m_offset += _n;
+        if(m_offset == _frame.length())
+        {
+            m_size -= _frame.length();
+            m_offset = 0;
+            m_queue.pop_front();
+        }
+    }
+}
+
+struct exporter_thread
+{
+    exporter_thread(std::string _endpoint, double _interval, size_t _capacity);
+
+    void shutdown();
+
+private:
+    void        run();
+    void        send();
+    std::string get_hotspots();
+
+    bool                                       m_running  = true;
+    uint64_t                                   m_sequence = 0;
+    std::chrono::nanoseconds                   m_interval = {};
+    std::mutex                                 m_mutex    = {};
+    std::condition_variable                    m_cv       = {};
+    connection                                 m_conn;
+    region_map_t                               m_totals = {};  // since the start
+    std::unordered_map<uintptr_t, const char*> m_names  = {};
+    std::unique_ptr<std::thread>               m_thread = {};
+};
+
+exporter_thread::exporter_thread(std::string _endpoint, double _interval,
+                                 size_t _capacity)
+: m_interval{ static_cast<int64_t>(_interval * units::sec) }
+, m_conn{ std::move(_endpoint), _capacity }
+{
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    m_thread = std::make_unique<std::thread>([this]() { run(); });
+}
+
+void
+exporter_thread::run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.exporter");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    while(m_running)
+    {
+        m_cv.wait_for(_lk, m_interval, [this]() { return !m_running; });
+        if(!m_running) break;
+
+        _lk.unlock();
+        send();
+        _lk.lock();
+    }
+}
+
+std::string
+exporter_thread::get_hotspots()
+{
+    constexpr size_t num_hotspots = 20;
+
+    auto* _table  = get_hotspot_table();
+    auto  _counts = std::unordered_map<const char*, uint64_t>{};
+    for(auto& itr : _table->slots)
+    {
+        auto _addr = itr.address.load(std::memory_order_acquire);
+        if(_addr == 0) continue;
+
+        auto _count = itr.count.exchange(0, std::memory_order_relaxed);
+        if(_count == 0)
+        {
+            // release the slots of the addresses which are no longer sampled
+            itr.address.compare_exchange_strong(_addr, 0, std::memory_order_acq_rel);
+            continue;
+        }
+
+        auto nitr = m_names.find(_addr);
+        if(nitr == m_names.end())
+        {
+            auto _entry = binary::lookup_ipaddr_entry<false>(_addr);
+            auto _name  = std::stringstream{};
+            if(_entry && !_entry->name.empty())
+                _name << tim::demangle(_entry->name);
+            else
+                _name << "0x" << std::hex << _addr;
+            nitr = m_names.emplace(_addr, intern_string(_name.str())).first;
+        }
+        _counts[nitr->second] += _count;
+    }
+
+    auto _sorted = std::vector<std::pair<const char*, uint64_t>>{ _counts.begin(),
+                                                                   _counts.end() };
+    auto _n      = std::min<size_t>(num_hotspots, _sorted.size());
+    std::partial_sort(
+        _sorted.begin(), _sorted.begin() + _n, _sorted.end(),
+        [](const auto& _lhs, const auto& _rhs) { return _lhs.second > _rhs.second; });
+
+    auto _ss = std::stringstream{};
+    for(size_t i = 0; i < _n; ++i)
+    {
+        _ss << ((i == 0) ? "" : ",") << "{\"name\":\""
+            << utility::json_escape(_sorted.at(i).first)
+            << "\",\"samples\":" << _sorted.at(i).second << "}";
+    }
+    return _ss.str();
+}
+
+void
+exporter_thread::send()
+{
+    auto _tables = std::vector<std::shared_ptr<thread_table>>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_tables_mutex() };
+        _tables  = get_tables();
+    }
+
+    // take the statistics of each thread since the previous message
+    auto     _updated = region_map_t{};
+    uint64_t _dropped = 0;
+    for(auto& itr : _tables)
+    {
+        auto _data = region_map_t{};
+        itr->lock();
+        std::swap(_data, itr->data);
+        itr->unlock();
+
+        _dropped += itr->dropped.load(std::memory_order_relaxed);
+        for(const auto& ditr : _data)
+            _updated[ditr.first] += ditr.second;
+    }
+
+    auto _ss = std::stringstream{};
+    _ss << "{\"pid\":" << process::get_id() << ",\"rank\":" << dmp::rank()
+        << ",\"timestamp\":" << tracing::now() << ",\"sequence\":" << m_sequence++
+        << ",\"dropped\":{\"regions\":" << _dropped
+        << ",\"samples\":" << get_hotspot_table()->dropped.load()
+        << ",\"messages\":" << m_conn.dropped() << "},\"regions\":[";
+
+    size_t _n = 0;
+    for(const auto& itr : _updated)
+    {
+        auto& _total = m_totals[itr.first];
+        _total += itr.second;
+        _ss << ((_n++ == 0) ? "" : ",") << "{\"hash\":" << itr.first << ",\"name\":\""
+            << utility::json_escape((_total.name) ? _total.name : "") << "\",\"count\":"
+            << _total.count << ",\"sum\":" << _total.sum << ",\"min\":" << _total.min
+            << ",\"max\":" << _total.max << "}";
+    }
+    _ss << "],\"hotspots\":[" << get_hotspots() << "]}";
+
+    m_conn.push(_ss.str());
+    m_conn.flush();
+}
+
+void
+exporter_thread::shutdown()
+{
+    if(!m_thread) return;
+
+    {
+        auto _lk  = std::unique_lock<std::mutex>{ m_mutex };
+        m_running = false;
+    }
+    m_cv.notify_all();
+    m_thread->join();
+    m_thread.reset();
+
+    // the last message is only sent if the socket accepts it without blocking
+    send();
+
+    OMNITRACE_VERBOSE(1, "[exporter] sent %zu messages to %s (%zu dropped)\n",
+                      static_cast<size_t>(m_sequence),
+                      config::get_export_endpoint().c_str(),
+                      static_cast<size_t>(m_conn.dropped()));
+}
+
+// leaked: the instrumented threads may still reference the tables during exit
+exporter_thread* exporter_instance = nullptr;
+}  // namespace
+
+bool
+is_active()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+void
+setup()
+{
+    auto _endpoint = config::get_export_endpoint();
+    if(_endpoint.empty() || exporter_instance) return;
+
+    auto _interval = std::max(config::get_export_interval(), 1.0e-3);
+    auto _capacity = std::max<size_t>(config::get_export_buffer_size_kb(), 1) * 1024;
+
+    OMNITRACE_VERBOSE(1, "[exporter] exporting to %s every %.3f sec...\n",
+                      _endpoint.c_str(), _interval);
+
+    get_hotspot_table();
+    exporter_instance = new exporter_thread{ _endpoint, _interval, _capacity };
+    active.store(true, std::memory_order_release);
+}
+
+void
+shutdown()
+{
+    if(!exporter_instance) return;
+
+    active.store(false, std::memory_order_release);
+    exporter_instance->shutdown();
+}
+
+void
+begin(tim::hash_value_t _hash)
+{
+    get_thread_table().stack.emplace_back(_hash, tracing::now());
+}
+
+void
+end(tim::hash_value_t _hash, std::string_view _name)
+{
+    auto  _end   = tracing::now();
+    auto& _table = get_thread_table();
+    auto& _stack = _table.stack;
+
+    // tolerate regions which are popped out of order
+    auto itr = std::find_if(_stack.rbegin(), _stack.rend(),
+                            [_hash](const auto& _v) { return (_v.first == _hash); });
+    if(itr == _stack.rend()) return;
+
+    auto _beg = itr->second;
+    _stack.erase(std::next(itr).base());
+
+    if(!_table.try_lock())
+    {
+        _table.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& _stats = _table.data[_hash];
+    if(!_stats.name) _stats.name = intern_string(_name);
+    _stats.record(_end - _beg);
+    _table.unlock();
+}
+
+void
+record_sample(uintptr_t _addr)
+{
+    if(_addr == 0 || !is_active()) return;
+    get_hotspot_table()->record(_addr);
+}
+}  // namespace exporter
+}  // namespace omnitrace
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/hash/types.hpp>
+
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+// live export of the region statistics and the sampling hot-spots to the collector
+// at OMNITRACE_EXPORT_ENDPOINT. A background thread sends a message every
+// OMNITRACE_EXPORT_INTERVAL seconds over a non-blocking socket. The instrumented
+// threads only update their own tables and never wait on the exporter: an update
+// which collides with the exporter reading the table is dropped and counted, as are
+// the messages which do not fit in OMNITRACE_EXPORT_BUFFER_SIZE_KB.
+//
+// Each message is a 4-byte big-endian length followed by a JSON document:
+//
+//      { "pid": <pid>, "rank": <rank>, "timestamp": <ns>, "sequence": <N>,
+//        "dropped": { "regions": <N>, "samples": <N>, "messages": <N> },
+//        "regions": [ { "hash": <hash>, "name": <name>, "count": <N>,
+//                       "sum": <ns>, "min": <ns>, "max": <ns> }, ... ],
+//        "hotspots": [ { "name": <function>, "samples": <N> }, ... ] }
+//
+// The regions are the regions which completed since the previous message with their
+// cumulative statistics since the start of the process so a lost message does not
+// lose any data. The hot-spots are the functions with the most samples (innermost
+// frame) since the previous message.
+namespace exporter
+{
+bool
+is_active();
+
+void
+setup();
+
+// sends the last message (if the collector accepts it without blocking) and stops
+// the background thread
+void
+shutdown();
+
+// invoked by category_region when a region is pushed and popped
+void
+begin(tim::hash_value_t);
+
+void
+end(tim::hash_value_t, std::string_view);
+
+// invoked by the sampling signal handler with the innermost address of the sample.
+// Async-signal-safe
+void
+record_sample(uintptr_t);
+}  // namespace exporter
+}  // namespace omnitrace
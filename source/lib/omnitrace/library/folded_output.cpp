@@ -0,0 +1,188 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/folded_output.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace folded_output
+{
+namespace
+{
+struct folded_stacks
+{};
+
+struct stack_hash
+{
+    size_t operator()(const stack_t& _v) const
+    {
+        size_t _hash = _v.size();
+        for(const auto* itr : _v)
+            _hash ^= std::hash<const void*>{}(itr) + 0x9e3779b9 + (_hash << 6) +
+                     (_hash >> 2);
+        return _hash;
+    }
+};
+
+using stack_map_t = std::unordered_map<stack_t, uint64_t, stack_hash>;
+
+struct output_state
+{
+    bool        active = false;
+    weight_type weight = weight_type::samples;
+    stack_map_t thread = {};
+    stack_map_t merged = {};
+};
+
+auto&
+get_state()
+{
+    static auto _v = output_state{};
+    return _v;
+}
+
+// ';' separates the frames and the weight follows the last space so these characters
+// cannot appear in the names of the frames
+std::string
+sanitize(const char* _name)
+{
+    auto _v = std::string{ (_name) ? _name : "" };
+    std::replace(_v.begin(), _v.end(), ';', ':');
+    std::replace(_v.begin(), _v.end(), '\n', ' ');
+    return _v;
+}
+
+void
+write(const std::string& _name, const stack_map_t& _stacks)
+{
+    if(_stacks.empty()) return;
+
+    auto _lines = std::vector<std::pair<std::string, uint64_t>>{};
+    _lines.reserve(_stacks.size());
+    for(const auto& itr : _stacks)
+    {
+        auto _line = std::string{};
+        for(const auto* fitr : itr.first)
+        {
+            if(!_line.empty()) _line += ';';
+            _line += sanitize(fitr);
+        }
+        if(!_line.empty()) _lines.emplace_back(std::move(_line), itr.second);
+    }
+
+    // sorted so that the output does not depend on the hashing of the call-stacks
+    std::sort(_lines.begin(), _lines.end());
+
+    auto _fname = tim::settings::compose_output_filename(_name, ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        OMNITRACE_WARNING_F(0, "Error opening folded output file: %s\n", _fname.c_str());
+        return;
+    }
+
+    for(const auto& itr : _lines)
+        _ofs << itr.first << ' ' << itr.second << '\n';
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<folded_stacks>{}(_fname,
+                                                        std::string{ "folded stacks" });
+}
+}  // namespace
+
+bool
+setup()
+{
+    auto& _state = get_state();
+    if(_state.active) return true;
+
+    auto _weight = config::get_folded_output_weight();
+    if(_weight == "wall_clock")
+        _state.weight = weight_type::wall_clock;
+    else if(_weight == "cpu_clock")
+        _state.weight = weight_type::cpu_clock;
+    else
+        _state.weight = weight_type::samples;
+
+    _state.active = true;
+    return _state.active;
+}
+
+bool
+is_active()
+{
+    return get_state().active;
+}
+
+weight_type
+get_weight_type()
+{
+    return get_state().weight;
+}
+
+void
+append(const stack_t& _stack, uint64_t _weight)
+{
+    auto& _state = get_state();
+    if(_state.active && !_stack.empty() && _weight > 0)
+        _state.thread[_stack] += _weight;
+}
+
+void
+flush(int64_t _tid)
+{
+    auto& _state = get_state();
+    if(!_state.active) return;
+
+    write(JOIN('-', "sampling-folded", _tid), _state.thread);
+
+    for(auto& itr : _state.thread)
+        _state.merged[itr.first] += itr.second;
+    _state.thread.clear();
+}
+
+void
+shutdown()
+{
+    auto& _state = get_state();
+    if(!_state.active) return;
+
+    write("sampling-folded", _state.merged);
+    _state = output_state{};
+}
+}  // namespace folded_output
+}  // namespace omnitrace
@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace omnitrace
+{
+// folded call-stacks of the sampling data for flame graphs (OMNITRACE_FOLDED_OUTPUT):
+// one line per unique call-stack in the "outermost;...;innermost <weight>" format of
+// flamegraph.pl, speedscope, etc. The call-stacks of a thread are aggregated while the
+// thread is post-processed and written to sampling-folded-<tid>.txt when the thread is
+// flushed. The aggregated call-stacks of all the threads are written to
+// sampling-folded.txt (one file per rank) at shutdown. The functions are not
+// thread-safe and are invoked by the sampling post-processing in thread order.
+namespace folded_output
+{
+// the (interned) names of the frames of a call-stack, outermost frame first
+using stack_t = std::vector<const char*>;
+
+// the weight of each sample (OMNITRACE_FOLDED_OUTPUT_WEIGHT)
+enum class weight_type : short
+{
+    samples = 0,  // number of samples
+    wall_clock,   // nsec between the sample and the previous sample
+    cpu_clock,    // nsec of thread CPU-time (wall-clock when not measured)
+};
+
+bool
+setup();
+
+bool
+is_active();
+
+weight_type
+get_weight_type();
+
+void
+append(const stack_t&, uint64_t _weight);
+
+// writes the call-stacks appended since the last flush for the thread
+void
+flush(int64_t _tid);
+
+// writes the call-stacks of all the threads
+void
+shutdown();
+}  // namespace folded_output
+}  // namespace omnitrace
@@ -0,0 +1,308 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/gpu_energy.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/timemory.hpp"
+#include "library/region_intervals.hpp"
+
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace gpu_energy
+{
+namespace
+{
+struct kernel_event
+{
+    const char* name = nullptr;
+    uint64_t    beg  = 0;
+    uint64_t    end  = 0;
+};
+
+struct kernel_data
+{
+    locking::atomic_mutex                          mutex   = {};
+    std::map<uint32_t, std::vector<kernel_event>> devices = {};
+};
+
+auto&
+get_kernel_data()
+{
+    static auto _v = kernel_data{};
+    return _v;
+}
+
+struct energy_entry
+{
+    uint64_t calls  = 0;
+    uint64_t time   = 0;  // [nsec]
+    double   energy = 0.0;  // [J]
+};
+
+// the cumulative energy [J] of a device at each power sample
+struct energy_series
+{
+    explicit energy_series(const power_samples_t& _samples);
+
+    // the energy at the given time interpolated between the samples
+    double operator()(uint64_t _ts) const;
+
+    std::vector<uint64_t> ts     = {};
+    std::vector<double>   energy = {};
+};
+
+// the power of a sample is the average since the previous sample
+energy_series::energy_series(const power_samples_t& _samples)
+{
+    for(const auto& itr : _samples)
+    {
+        if(!ts.empty() && itr.first <= ts.back()) continue;
+        auto _sec = (ts.empty()) ? 0.0 : static_cast<double>(itr.first - ts.back()) /
+                                              units::sec;
+        energy.emplace_back(((energy.empty()) ? 0.0 : energy.back()) + itr.second * _sec);
+        ts.emplace_back(itr.first);
+    }
+}
+
+double
+energy_series::operator()(uint64_t _ts) const
+{
+    if(ts.empty()) return 0.0;
+    if(_ts <= ts.front()) return energy.front();
+    if(_ts >= ts.back()) return energy.back();
+
+    auto _n    = std::distance(ts.begin(), std::upper_bound(ts.begin(), ts.end(), _ts));
+    auto _lhs  = static_cast<size_t>(_n - 1);
+    auto _rhs  = static_cast<size_t>(_n);
+    auto _frac = static_cast<double>(_ts - ts.at(_lhs)) /
+                 static_cast<double>(ts.at(_rhs) - ts.at(_lhs));
+    return energy.at(_lhs) + _frac * (energy.at(_rhs) - energy.at(_lhs));
+}
+
+using kernel_table_t = std::map<std::pair<uint32_t, std::string>, energy_entry>;
+
+// the energy of each segment between the start and end of the kernels is shared equally
+// by the kernels executing in the segment. Returns the energy while no kernel executed
+double
+attribute_kernels(uint32_t _device, std::vector<kernel_event>& _kernels,
+                  const energy_series& _series, kernel_table_t& _table)
+{
+    // the ends are processed before the starts at the same time
+    using event_t = std::tuple<uint64_t, int, size_t>;
+    auto _events  = std::vector<event_t>{};
+    _events.reserve(2 * _kernels.size());
+    for(size_t i = 0; i < _kernels.size(); ++i)
+    {
+        const auto& itr = _kernels.at(i);
+        if(itr.end <= itr.beg) continue;
+        _events.emplace_back(itr.beg, 1, i);
+        _events.emplace_back(itr.end, 0, i);
+    }
+    std::sort(_events.begin(), _events.end());
+
+    auto     _energy = std::vector<double>(_kernels.size(), 0.0);
+    auto     _active = std::vector<size_t>{};
+    double   _busy   = 0.0;
+    uint64_t _prev   = 0;
+    for(const auto& [_ts, _start, _idx] : _events)
+    {
+        if(!_active.empty() && _ts > _prev)
+        {
+            auto _segment = _series(_ts) - _series(_prev);
+            for(auto itr : _active)
+                _energy.at(itr) += _segment / _active.size();
+            _busy += _segment;
+        }
+
+        if(_start)
+            _active.emplace_back(_idx);
+        else
+            _active.erase(std::find(_active.begin(), _active.end(), _idx));
+        _prev = _ts;
+    }
+
+    for(size_t i = 0; i < _kernels.size(); ++i)
+    {
+        const auto& itr    = _kernels.at(i);
+        auto&       _entry = _table[std::make_pair(_device, tim::demangle(itr.name))];
+        _entry.calls += 1;
+        _entry.time += (itr.end > itr.beg) ? (itr.end - itr.beg) : 0;
+        _entry.energy += _energy.at(i);
+    }
+
+    return (_series.energy.empty()) ? 0.0 : (_series.energy.back() - _busy);
+}
+
+template <typename Tp>
+auto
+get_sorted(const Tp& _table)
+{
+    auto _v = std::vector<typename Tp::value_type>{ _table.begin(), _table.end() };
+    std::sort(_v.begin(), _v.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.energy > _rhs.second.energy;
+    });
+    return _v;
+}
+
+void
+write_entry(std::ostream& _os, const energy_entry& _v)
+{
+    auto _sec = static_cast<double>(_v.time) / units::sec;
+    _os << std::setw(12) << _v.calls << " " << std::setw(12) << _sec << " "
+        << std::setw(14) << _v.energy << " " << std::setw(12)
+        << ((_sec > 0.0) ? (_v.energy / _sec) : 0.0) << "   ";
+}
+}  // namespace
+
+void
+setup()
+{
+    if(!config::get_rocm_smi_energy()) return;
+
+    get_enabled().store(true);
+    region_intervals::enable();
+}
+
+void
+kernel(uint32_t _device, const char* _name, uint64_t _beg, uint64_t _end)
+{
+    if(!_name) return;
+    auto& _data = get_kernel_data();
+    auto  _lk   = locking::atomic_lock{ _data.mutex };
+    _data.devices[_device].emplace_back(kernel_event{ _name, _beg, _end });
+}
+
+void
+post_process(const power_data_t& _power)
+{
+    if(!is_enabled()) return;
+    get_enabled().store(false);
+    region_intervals::disable();
+
+    // the recording is disabled so the kernels can be read without the lock
+    auto& _kernels = get_kernel_data().devices;
+    auto  _series  = std::map<uint32_t, energy_series>{};
+    for(const auto& itr : _power)
+    {
+        if(itr.second.size() < 2) continue;
+        _series.emplace(itr.first, energy_series{ itr.second });
+    }
+
+    if(_series.empty()) return;
+
+    auto _kernel_table = kernel_table_t{};
+    auto _idle         = std::map<uint32_t, double>{};
+    for(const auto& itr : _series)
+        _idle[itr.first] = attribute_kernels(itr.first, _kernels[itr.first], itr.second,
+                                             _kernel_table);
+
+    // the regions are attributed the energy of every device
+    auto _region_table = std::unordered_map<tim::hash_value_t, energy_entry>{};
+    region_intervals::for_each([&_region_table, &_series](const auto& itr) {
+        auto& _entry = _region_table[itr.hash];
+        _entry.calls += 1;
+        _entry.time += (itr.end - itr.beg);
+        for(const auto& sitr : _series)
+            _entry.energy += sitr.second(itr.end) - sitr.second(itr.beg);
+    });
+
+    for(const auto& itr : _series)
+    {
+        OMNITRACE_VERBOSE(0, "GPU energy device %u :: %.3f J (%.3f J while idle)\n",
+                          itr.first, itr.second.energy.back(), _idle.at(itr.first));
+    }
+
+    _kernels.clear();
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("gpu-energy", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<energy_entry>{}(_fname,
+                                                           std::string{ "gpu_energy" });
+
+        auto _header = [&ofs](const char* _label) {
+            ofs << std::setw(12) << "calls" << " " << std::setw(12) << "time [sec]"
+                << " " << std::setw(14) << "energy [J]" << " " << std::setw(12)
+                << "power [W]" << "   " << _label << "\n";
+        };
+
+        ofs << std::fixed << std::setprecision(3);
+
+        _header("device (idle energy)");
+        for(const auto& itr : _series)
+        {
+            auto _entry   = energy_entry{};
+            _entry.calls  = 1;
+            _entry.time   = itr.second.ts.back() - itr.second.ts.front();
+            _entry.energy = itr.second.energy.back();
+            write_entry(ofs, _entry);
+            ofs << itr.first << " (" << _idle.at(itr.first) << " J)\n";
+        }
+
+        ofs << "\n";
+        _header("device  kernel");
+        for(const auto& itr : get_sorted(_kernel_table))
+        {
+            write_entry(ofs, itr.second);
+            ofs << std::setw(6) << itr.first.first << "  "
+                << itr.first.second << "\n";
+        }
+
+        ofs << "\n";
+        _header("region");
+        for(const auto& itr : get_sorted(_region_table))
+        {
+            write_entry(ofs, itr.second);
+            ofs << tim::get_hash_identifier_fast(itr.first) << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening GPU energy output file: %s", _fname.c_str());
+    }
+}
+}  // namespace gpu_energy
+}  // namespace omnitrace
@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+// GPU energy (OMNITRACE_ROCM_SMI_ENERGY): the average power of each device sampled by
+// rocm-smi is integrated over the execution of each kernel (the time is shared equally
+// between the kernels which execute concurrently on a device) and over the intervals of
+// the regions
+namespace gpu_energy
+{
+// timestamp [nsec] and average power since the previous sample [watts]
+using power_samples_t = std::vector<std::pair<uint64_t, double>>;
+using power_data_t    = std::map<uint32_t, power_samples_t>;
+
+inline std::atomic<bool>&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+inline bool
+is_enabled()
+{
+    return get_enabled().load(std::memory_order_relaxed);
+}
+
+void
+setup();
+
+// the execution of a kernel on a device. May be invoked from any thread
+void
+kernel(uint32_t _device, const char* _name, uint64_t _beg, uint64_t _end);
+
+// the power samples of each device
+void
+post_process(const power_data_t& _power);
+}  // namespace gpu_energy
+}  // namespace omnitrace
@@ -0,0 +1,481 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/gpu_memory.hpp"
+#include "core/config.hpp"
+#include "core/containers/address_table.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "library/callsite.hpp"
+
+#include <timemory/manager.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/types.hpp>
+#include <timemory/units.hpp>
+#include <timemory/unwind/stack.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace gpu_memory
+{
+namespace
+{
+constexpr size_t callsite_depth        = 8;
+constexpr size_t callsite_ignore_depth = 3;
+constexpr size_t num_size_buckets      = 64;
+
+using callsite_frames_t = std::array<uintptr_t, callsite_depth>;
+
+const char*
+get_kind_name(allocation_kind _kind)
+{
+    switch(_kind)
+    {
+        case allocation_kind::device: return "device";
+        case allocation_kind::managed: return "managed";
+        case allocation_kind::host: return "host";
+    }
+    return "unknown";
+}
+
+// allocations of one kind on one device
+struct pool
+{
+    allocation_kind                        kind        = allocation_kind::device;
+    int32_t                                device      = 0;
+    int64_t                                live_bytes  = 0;
+    int64_t                                peak_bytes  = 0;
+    uint64_t                               peak_ts     = 0;
+    uint64_t                               live_count  = 0;
+    uint64_t                               peak_count  = 0;
+    uint64_t                               allocs      = 0;
+    uint64_t                               frees       = 0;
+    uint64_t                               total_bytes = 0;
+    std::array<uint64_t, num_size_buckets> histogram   = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+
+        // log2 of the lower bound of the allocation size -> number of allocations
+        auto _histogram = std::map<size_t, uint64_t>{};
+        for(size_t i = 0; i < histogram.size(); ++i)
+            if(histogram.at(i) > 0) _histogram.emplace(i, histogram.at(i));
+
+        ar(cereal::make_nvp("kind", std::string{ get_kind_name(kind) }),
+           cereal::make_nvp("device", device), cereal::make_nvp("allocs", allocs),
+           cereal::make_nvp("frees", frees), cereal::make_nvp("total_bytes", total_bytes),
+           cereal::make_nvp("peak_bytes", peak_bytes),
+           cereal::make_nvp("peak_ts", peak_ts),
+           cereal::make_nvp("peak_count", peak_count),
+           cereal::make_nvp("live_bytes", live_bytes),
+           cereal::make_nvp("live_count", live_count),
+           cereal::make_nvp("log2_size_histogram", _histogram));
+    }
+};
+
+// allocations from one call stack into one pool
+struct callsite
+{
+    callsite_frames_t frames     = {};
+    uint16_t          pool       = 0;
+    uint64_t          allocs     = 0;
+    uint64_t          frees      = 0;
+    uint64_t          bytes      = 0;
+    int64_t           live_bytes = 0;
+};
+
+struct callsite_report
+{
+    std::string label      = {};
+    uint64_t    allocs     = 0;
+    uint64_t    frees      = 0;
+    uint64_t    bytes      = 0;
+    int64_t     live_bytes = 0;
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("callsite", label), cereal::make_nvp("allocs", allocs),
+           cereal::make_nvp("frees", frees), cereal::make_nvp("bytes", bytes),
+           cereal::make_nvp("live_bytes", live_bytes));
+    }
+};
+
+struct pool_report
+{
+    pool                         data      = {};
+    std::vector<callsite_report> callsites = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned _version)
+    {
+        namespace cereal = tim::cereal;
+        data.serialize(ar, _version);
+        ar(cereal::make_nvp("callsites", callsites));
+    }
+};
+
+// live allocation in the address table
+struct allocation
+{
+    uint64_t bytes    = 0;
+    uint32_t callsite = 0;
+    uint16_t pool     = 0;
+};
+
+struct tracker
+{
+    using pool_key_t = std::pair<allocation_kind, int32_t>;
+
+    locking::atomic_mutex                mutex          = {};
+    container::address_table<allocation> live           = {};
+    std::vector<pool>                    pools          = {};
+    std::map<pool_key_t, uint16_t>       pool_index     = {};
+    std::vector<callsite>                callsites      = {};
+    std::unordered_map<size_t, uint32_t> callsite_index = {};
+};
+
+auto&
+get_tracker()
+{
+    static auto* _v = new tracker{};
+    return *_v;
+}
+
+bool
+use_callsites()
+{
+    static auto _v = tim::get_env<bool>("OMNITRACE_ROCTRACER_MEMORY_CALLSITES", true);
+    return _v;
+}
+
+callsite_frames_t
+get_callsite_frames()
+{
+    auto _frames = callsite_frames_t{};
+    if(!use_callsites()) return _frames;
+
+    auto   _stack = tim::get_unw_stack<callsite_depth, callsite_ignore_depth, false>();
+    size_t _n     = 0;
+    for(auto itr : _stack)
+    {
+        if(itr && _n < _frames.size()) _frames.at(_n++) = itr->address();
+    }
+    return _frames;
+}
+
+size_t
+get_size_bucket(size_t _bytes)
+{
+    return (_bytes == 0) ? 0 : (63 - __builtin_clzll(_bytes));
+}
+
+// lock must be held
+uint16_t
+get_pool(tracker& _data, allocation_kind _kind, int32_t _device)
+{
+    auto itr = _data.pool_index.find({ _kind, _device });
+    if(itr != _data.pool_index.end()) return itr->second;
+
+    auto _idx = static_cast<uint16_t>(_data.pools.size());
+    _data.pools.emplace_back(pool{ _kind, _device });
+    _data.pool_index.emplace(std::make_pair(_kind, _device), _idx);
+
+    if(get_use_perfetto())
+    {
+        using counter_track = perfetto_counter_track<pool>;
+        auto _lbl           = (_kind == allocation_kind::host)
+                                  ? std::string{ "HIP Host Memory Allocated" }
+                                  : JOIN("", "HIP ", (_kind == allocation_kind::managed)
+                                                         ? "Managed"
+                                                         : "Device",
+                                         " Memory Allocated [", _device, "]");
+        counter_track::emplace(_idx, _lbl, "bytes");
+        counter_track::emplace(_idx, JOIN(" ", _lbl, "(count)"), "");
+    }
+    return _idx;
+}
+
+// lock must be held
+uint32_t
+get_callsite(tracker& _data, const callsite_frames_t& _frames, uint16_t _pool)
+{
+    size_t _hash = std::hash<uint16_t>{}(_pool);
+    for(auto itr : _frames)
+        _hash ^= std::hash<uintptr_t>{}(itr) + 0x9e3779b9 + (_hash << 6) + (_hash >> 2);
+
+    auto itr = _data.callsite_index.find(_hash);
+    if(itr != _data.callsite_index.end()) return itr->second;
+
+    auto _idx = static_cast<uint32_t>(_data.callsites.size());
+    _data.callsites.emplace_back(callsite{ _frames, _pool });
+    _data.callsite_index.emplace(_hash, _idx);
+    return _idx;
+}
+
+// lock must be held
+void
+emit_pool(const pool& _pool, uint16_t _idx, uint64_t _ts)
+{
+    if(!get_use_perfetto()) return;
+
+    using counter_track = perfetto_counter_track<pool>;
+    TRACE_COUNTER("device_memory_usage", counter_track::at(_idx, 0), _ts,
+                  _pool.live_bytes);
+    TRACE_COUNTER("device_memory_usage", counter_track::at(_idx, 1), _ts,
+                  _pool.live_count);
+}
+
+// first frame of the call stack outside of omnitrace and the ROCm runtime libraries
+std::string
+get_callsite_label(const callsite& _site)
+{
+    return ::omnitrace::callsite::get_caller_label(
+        _site.frames,
+        { "libomnitrace", "libamdhip64", "libroctracer", "libhsa-runtime", "libroctx" });
+}
+
+std::string
+get_size_label(size_t _bucket)
+{
+    auto _bytes = [](size_t _v) -> std::string {
+        if(_v >= units::GiB) return JOIN("", _v / units::GiB, " GiB");
+        if(_v >= units::MiB) return JOIN("", _v / units::MiB, " MiB");
+        if(_v >= units::KiB) return JOIN("", _v / units::KiB, " KiB");
+        return JOIN("", _v, " B");
+    };
+    auto _lo = size_t{ 1 } << _bucket;
+    auto _hi = (_bucket + 1 < num_size_buckets) ? (size_t{ 1 } << (_bucket + 1)) : 0;
+    return JOIN("", "[", _bytes(_lo), ", ", (_hi > 0) ? _bytes(_hi) : "inf", ")");
+}
+}  // namespace
+
+void
+allocate(allocation_kind _kind, int32_t _device, const void* _ptr, size_t _bytes,
+         uint64_t _ts)
+{
+    if(_ptr == nullptr) return;
+
+    auto  _frames = get_callsite_frames();
+    auto& _data   = get_tracker();
+    auto  _lk     = locking::atomic_lock{ _data.mutex };
+
+    auto  _idx  = get_pool(_data, _kind, _device);
+    auto  _site = get_callsite(_data, _frames, _idx);
+    auto& _pool = _data.pools.at(_idx);
+
+    auto _prev = _data.live.insert(reinterpret_cast<uintptr_t>(_ptr),
+                                   allocation{ _bytes, _site, _idx });
+
+    // the address was handed out again without a recorded release
+    if(_prev)
+    {
+        auto& _prev_pool = _data.pools.at(_prev->pool);
+        _prev_pool.live_bytes -= static_cast<int64_t>(_prev->bytes);
+        _prev_pool.live_count -= 1;
+        _data.callsites.at(_prev->callsite).live_bytes -=
+            static_cast<int64_t>(_prev->bytes);
+    }
+
+    auto& _callsite = _data.callsites.at(_site);
+    _callsite.allocs += 1;
+    _callsite.bytes += _bytes;
+    _callsite.live_bytes += static_cast<int64_t>(_bytes);
+
+    _pool.allocs += 1;
+    _pool.total_bytes += _bytes;
+    _pool.live_bytes += static_cast<int64_t>(_bytes);
+    _pool.live_count += 1;
+    _pool.peak_count = std::max(_pool.peak_count, _pool.live_count);
+    _pool.histogram.at(get_size_bucket(_bytes)) += 1;
+    if(_pool.live_bytes > _pool.peak_bytes)
+    {
+        _pool.peak_bytes = _pool.live_bytes;
+        _pool.peak_ts    = _ts;
+    }
+
+    emit_pool(_pool, _idx, _ts);
+}
+
+void
+deallocate(const void* _ptr, uint64_t _ts)
+{
+    if(_ptr == nullptr) return;
+
+    auto& _data = get_tracker();
+    auto  _lk   = locking::atomic_lock{ _data.mutex };
+    auto  _prev = _data.live.erase(reinterpret_cast<uintptr_t>(_ptr));
+    if(!_prev) return;
+
+    auto& _pool     = _data.pools.at(_prev->pool);
+    auto& _callsite = _data.callsites.at(_prev->callsite);
+
+    _pool.frees += 1;
+    _pool.live_bytes -= static_cast<int64_t>(_prev->bytes);
+    _pool.live_count -= 1;
+    _callsite.frees += 1;
+    _callsite.live_bytes -= static_cast<int64_t>(_prev->bytes);
+
+    emit_pool(_pool, _prev->pool, _ts);
+}
+
+void
+post_process()
+{
+    auto& _data      = get_tracker();
+    auto  _callsites = std::vector<callsite>{};
+    auto  _reports   = std::vector<pool_report>{};
+    {
+        auto _lk = locking::atomic_lock{ _data.mutex };
+        for(const auto& itr : _data.pools)
+            _reports.emplace_back(pool_report{ itr, {} });
+        std::swap(_callsites, _data.callsites);
+        _data.callsite_index.clear();
+    }
+
+    if(_reports.empty()) return;
+
+    auto _ntop = config::get_roctracer_memory_top();
+
+    // the call sites of each pool with the most allocations
+    std::sort(_callsites.begin(), _callsites.end(),
+              [](const callsite& _lhs, const callsite& _rhs) {
+                  return std::tie(_lhs.allocs, _lhs.bytes) >
+                         std::tie(_rhs.allocs, _rhs.bytes);
+              });
+    for(const auto& itr : _callsites)
+    {
+        auto& _report = _reports.at(itr.pool);
+        if(_report.callsites.size() >= _ntop) continue;
+        _report.callsites.emplace_back(callsite_report{
+            get_callsite_label(itr), itr.allocs, itr.frees, itr.bytes, itr.live_bytes });
+    }
+
+    auto _mib = [](auto _v) { return static_cast<double>(_v) / units::MiB; };
+
+    for(const auto& ritr : _reports)
+    {
+        const auto& itr = ritr.data;
+        OMNITRACE_VERBOSE(0,
+                          "HIP memory :: %s %i :: %lu allocations, %lu releases, peak "
+                          "%.3f MiB, %.3f MiB (%lu allocations) live at finalization\n",
+                          get_kind_name(itr.kind), itr.device, itr.allocs, itr.frees,
+                          _mib(itr.peak_bytes), _mib(itr.live_bytes), itr.live_count);
+    }
+
+    auto _get_setting = [](const std::string& _v) {
+        return config::get_setting_value<bool>(_v).value_or(true);
+    };
+
+    if(_get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        auto _fname = tim::settings::compose_output_filename("hip-memory", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<pool_report>{}(
+                    _fname, std::string{ "hip_memory" });
+
+            ofs << std::fixed << std::setprecision(3);
+            for(const auto& ritr : _reports)
+            {
+                const auto& itr = ritr.data;
+                ofs << get_kind_name(itr.kind) << " memory, device " << itr.device << "\n"
+                    << "    allocations           : " << itr.allocs << "\n"
+                    << "    releases              : " << itr.frees << "\n"
+                    << "    allocated       [MiB] : " << _mib(itr.total_bytes) << "\n"
+                    << "    peak            [MiB] : " << _mib(itr.peak_bytes) << "\n"
+                    << "    peak allocations      : " << itr.peak_count << "\n"
+                    << "    live at end     [MiB] : " << _mib(itr.live_bytes) << "\n"
+                    << "    live allocations      : " << itr.live_count << "\n"
+                    << "    allocation sizes      :\n";
+                for(size_t i = 0; i < itr.histogram.size(); ++i)
+                {
+                    if(itr.histogram.at(i) == 0) continue;
+                    ofs << "        " << std::setw(24) << std::left << get_size_label(i)
+                        << std::right << " : " << itr.histogram.at(i) << "\n";
+                }
+                if(ritr.callsites.empty()) continue;
+                ofs << "    call sites            :\n";
+                for(const auto& citr : ritr.callsites)
+                {
+                    ofs << "        " << std::setw(8) << citr.allocs << " allocs, "
+                        << std::setw(8) << citr.frees << " releases, " << std::setw(12)
+                        << _mib(citr.bytes) << " MiB :: " << citr.label << "\n";
+                }
+            }
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening HIP memory output file: %s", _fname.c_str());
+        }
+    }
+
+    if(_get_setting("OMNITRACE_JSON_OUTPUT"))
+    {
+        std::stringstream oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+            ar->setNextName("omnitrace");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("hip_memory", _reports));
+            ar->finishNode();
+        }
+        auto _fname = tim::settings::compose_output_filename("hip-memory", ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<pool_report>{}(
+                    _fname, std::string{ "hip_memory" });
+            ofs << oss.str() << "\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening HIP memory output file: %s", _fname.c_str());
+        }
+    }
+}
+}  // namespace gpu_memory
+}  // namespace omnitrace
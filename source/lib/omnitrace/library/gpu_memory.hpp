@@ -0,0 +1,56 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+namespace gpu_memory
+{
+enum class allocation_kind : uint8_t
+{
+    device = 0,
+    managed,
+    host,
+};
+
+// records an allocation made through the HIP API on the calling thread. Emits the
+// live bytes of the (kind, device) pool as a perfetto counter
+void
+allocate(allocation_kind _kind, int32_t _device, const void* _ptr, size_t _bytes,
+         uint64_t _ts);
+
+// releases an allocation recorded by allocate(). Addresses which were allocated
+// before the tracking started are ignored
+void
+deallocate(const void* _ptr, uint64_t _ts);
+
+// reports the peak and live bytes, the allocation size histogram, and the call sites
+// of each pool
+void
+post_process();
+}  // namespace gpu_memory
+}  // namespace omnitrace
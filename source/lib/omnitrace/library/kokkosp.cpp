@@ -28,7 +28,9 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
+#include "core/string_arena.hpp"
 #include "library/components/category_region.hpp"
+#include "library/components/kokkos_metrics.hpp"
 #include "library/runtime.hpp"
 
 #include <timemory/api/kokkosp.hpp>
@@ -40,8 +42,13 @@
 #include <timemory/utility/types.hpp>
 
 #include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace kokkosp  = ::tim::kokkosp;
 namespace category = ::tim::category;
@@ -148,6 +155,168 @@ violates_name_rules(Arg&& _arg, Args&&... _args)
 
     return (_len >= _name_len_limit);
 }
+
+//--------------------------------------------------------------------------------------//
+//
+// kernels are launched with the same few names at a very high rate so the formatted
+// region name and the profilers are created once per thread for every combination
+// of the name, the device, and the kind of kernel. The names are keyed by the address
+// of the label provided by Kokkos and the label is compared to detect an address
+// which was reused for a different label
+//
+//--------------------------------------------------------------------------------------//
+
+enum kernel_kind : uint8_t
+{
+    KERNEL_FOR = 0,
+    KERNEL_REDUCE,
+    KERNEL_SCAN,
+    KERNEL_FENCE,
+};
+
+const char*
+get_kernel_kind_name(kernel_kind _v)
+{
+    switch(_v)
+    {
+        case KERNEL_FOR: return "for";
+        case KERNEL_REDUCE: return "reduce";
+        case KERNEL_SCAN: return "scan";
+        case KERNEL_FENCE: return "fence";
+    }
+    return "unknown";
+}
+
+using kernel_profiler_t = kokkosp::profiler_t<kokkosp_region>;
+
+struct kernel_region
+{
+    std::string                   label     = {};
+    const char*                   name      = nullptr;  // interned
+    std::deque<kernel_profiler_t> profilers = {};  // stable addresses while running
+    std::vector<size_t>           available = {};
+
+    size_t acquire();
+    void   release(size_t _idx) { available.emplace_back(_idx); }
+    bool   busy() const { return available.size() < profilers.size(); }
+};
+
+size_t
+kernel_region::acquire()
+{
+    if(!available.empty())
+    {
+        auto _idx = available.back();
+        available.pop_back();
+        return _idx;
+    }
+    profilers.emplace_back(name);
+    return profilers.size() - 1;
+}
+
+struct kernel_key
+{
+    const char* label = nullptr;
+    uint32_t    devid = 0;
+    kernel_kind kind  = KERNEL_FOR;
+
+    bool operator==(const kernel_key& _rhs) const
+    {
+        return (label == _rhs.label && devid == _rhs.devid && kind == _rhs.kind);
+    }
+};
+
+struct kernel_key_hash
+{
+    size_t operator()(const kernel_key& _v) const
+    {
+        auto _hash = std::hash<const void*>{}(_v.label);
+        return _hash ^ ((static_cast<size_t>(_v.devid) << 8) | _v.kind);
+    }
+};
+
+struct active_kernel
+{
+    uint64_t       kernid = 0;
+    size_t         index  = 0;
+    kernel_region* region = nullptr;
+    uint32_t       devid  = 0;
+    uint64_t       beg_ns = 0;  // only for fences
+};
+
+struct kernel_regions
+{
+    using region_ptr_t = std::unique_ptr<kernel_region>;
+
+    kernel_regions() { active.reserve(32); }
+
+    std::unordered_map<kernel_key, region_ptr_t, kernel_key_hash> cache   = {};
+    std::vector<region_ptr_t>                                     retired = {};
+    std::vector<active_kernel>                                    active  = {};
+};
+
+kernel_regions&
+get_kernel_regions()
+{
+    static thread_local auto _v = kernel_regions{};
+    return _v;
+}
+
+kernel_region&
+get_kernel_region(const char* _label, uint32_t _devid, kernel_kind _kind)
+{
+    auto& _regions = get_kernel_regions();
+    auto& _region  = _regions.cache[kernel_key{ _label, _devid, _kind }];
+    if(_region && _region->label == _label) return *_region;
+
+    // the regions which are running stay alive until they are stopped
+    if(_region && _region->busy()) _regions.retired.emplace_back(std::move(_region));
+
+    const auto* _kind_name = get_kernel_kind_name(_kind);
+    auto        _name      = (_devid > std::numeric_limits<uint16_t>::max())  // junk
+                                 ? JOIN(" ", _kp_prefix, _label,
+                                        JOIN("", '[', _kind_name, ']'))
+                                 : JOIN(" ", _kp_prefix, _label,
+                                        JOIN("", '[', _kind_name, "][dev", _devid, ']'));
+
+    _region        = std::make_unique<kernel_region>();
+    _region->label = _label;
+    _region->name  = intern_string(_name);
+    return *_region;
+}
+
+void
+start_kernel(const char* _label, uint32_t _devid, kernel_kind _kind, uint64_t _kernid)
+{
+    auto& _region = get_kernel_region(_label, _devid, _kind);
+    auto  _idx    = _region.acquire();
+    auto  _beg    = (_kind == KERNEL_FENCE)
+                        ? tim::get_clock_real_now<uint64_t, std::nano>()
+                        : uint64_t{ 0 };
+    get_kernel_regions().active.emplace_back(
+        active_kernel{ _kernid, _idx, &_region, _devid, _beg });
+    _region.profilers.at(_idx).start();
+}
+
+void
+stop_kernel(uint64_t _kernid, kernel_kind _kind)
+{
+    auto& _active = get_kernel_regions().active;
+    for(auto itr = _active.rbegin(); itr != _active.rend(); ++itr)
+    {
+        if(itr->kernid != _kernid) continue;
+        auto _kernel = *itr;
+        _active.erase(std::next(itr).base());
+        // the wait time is recorded before the fence region is stopped
+        if(_kind == KERNEL_FENCE)
+            comp::kokkos_metrics::record_fence(
+                _kernel.devid, _kernel.beg_ns,
+                tim::get_clock_real_now<uint64_t, std::nano>());
+        _kernel.region->profilers.at(_kernel.index).stop();
+        _kernel.region->release(_kernel.index);
+        return;
+    }
+}
 }  // namespace
 
 //--------------------------------------------------------------------------------------//
@@ -262,6 +431,8 @@ extern "C"
         tim::trait::runtime_enabled<kokkosp::memory_tracker>::set(
             omnitrace::config::get_use_timemory());
 
+        comp::kokkos_metrics::setup();
+
         if(omnitrace::get_verbose() >= 0)
         {
             fprintf(stderr, "%sDone\n%s", tim::log::color::info(),
@@ -283,6 +454,7 @@ extern "C"
     void kokkosp_finalize_library()
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        comp::kokkos_metrics::post_process();
         if(_standalone_initialized)
         {
             omnitrace_pop_trace_hidden("kokkos_main");
@@ -305,13 +477,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname = (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                         ? JOIN(" ", _kp_prefix, name, "[for]")
-                         : JOIN(" ", _kp_prefix, name, JOIN("", "[for][dev", devid, ']'));
-        *kernid    = kokkosp::get_unique_id();
+        *kernid = kokkosp::get_unique_id();
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
+        start_kernel(name, devid, KERNEL_FOR, *kernid);
     }
 
     void kokkosp_end_parallel_for(uint64_t kernid)
@@ -320,8 +488,7 @@ extern "C"
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        stop_kernel(kernid, KERNEL_FOR);
     }
 
     //----------------------------------------------------------------------------------//
@@ -331,14 +498,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname =
-            (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                ? JOIN(" ", _kp_prefix, name, "[reduce]")
-                : JOIN(" ", _kp_prefix, name, JOIN("", "[reduce][dev", devid, ']'));
         *kernid = kokkosp::get_unique_id();
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
+        start_kernel(name, devid, KERNEL_REDUCE, *kernid);
     }
 
     void kokkosp_end_parallel_reduce(uint64_t kernid)
@@ -347,8 +509,7 @@ extern "C"
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        stop_kernel(kernid, KERNEL_REDUCE);
     }
 
     //----------------------------------------------------------------------------------//
@@ -358,14 +519,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname =
-            (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                ? JOIN(" ", _kp_prefix, name, "[scan]")
-                : JOIN(" ", _kp_prefix, name, JOIN("", "[scan][dev", devid, ']'));
         *kernid = kokkosp::get_unique_id();
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
+        start_kernel(name, devid, KERNEL_SCAN, *kernid);
     }
 
     void kokkosp_end_parallel_scan(uint64_t kernid)
@@ -374,8 +530,7 @@ extern "C"
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        stop_kernel(kernid, KERNEL_SCAN);
     }
 
     //----------------------------------------------------------------------------------//
@@ -385,14 +540,9 @@ extern "C"
         if(violates_name_rules(name)) return set_invalid_id(kernid);
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto pname =
-            (devid > std::numeric_limits<uint16_t>::max())  // junk device number
-                ? JOIN(" ", _kp_prefix, name, "[fence]")
-                : JOIN(" ", _kp_prefix, name, JOIN("", "[fence][dev", devid, ']'));
         *kernid = kokkosp::get_unique_id();
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name, *kernid);
-        kokkosp::create_profiler<kokkosp_region>(pname, *kernid);
-        kokkosp::start_profiler<kokkosp_region>(*kernid);
+        start_kernel(name, devid, KERNEL_FENCE, *kernid);
     }
 
     void kokkosp_end_fence(uint64_t kernid)
@@ -401,8 +551,7 @@ extern "C"
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__, kernid);
-        kokkosp::stop_profiler<kokkosp_region>(kernid);
-        kokkosp::destroy_profiler<kokkosp_region>(kernid);
+        stop_kernel(kernid, KERNEL_FENCE);
     }
 
     //----------------------------------------------------------------------------------//
@@ -412,7 +561,7 @@ extern "C"
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         kokkosp::logger_t{}.mark(1, __FUNCTION__, name);
         kokkosp::get_profiler_stack<kokkosp_region>()
-            .emplace_back(kokkosp::profiler_t<kokkosp_region>(name))
+            .emplace_back(kokkosp::profiler_t<kokkosp_region>(intern_string(name)))
             .start();
     }
 
@@ -430,9 +579,8 @@ extern "C"
     void kokkosp_create_profile_section(const char* name, uint32_t* secid)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        *secid     = kokkosp::get_unique_id();
-        auto pname = std::string{ name };
-        kokkosp::create_profiler<kokkosp_region>(name, *secid);
+        *secid = kokkosp::get_unique_id();
+        kokkosp::create_profiler<kokkosp_region>(intern_string(name), *secid);
     }
 
     void kokkosp_destroy_profile_section(uint32_t secid)
@@ -462,10 +610,14 @@ extern "C"
     void kokkosp_allocate_data(const SpaceHandle space, const char* label,
                                const void* const ptr, const uint64_t size)
     {
-        if(violates_name_rules(label)) return;
         if(omnitrace::config::get_use_causal()) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        // the live bytes include the allocations without a valid name
+        comp::kokkos_metrics::allocate_data(space.name, label, ptr, size);
+
+        if(violates_name_rules(label)) return;
+
         kokkosp::logger_t{}.mark(0, __FUNCTION__, space.name, label,
                                  JOIN("", '[', ptr, ']'), size);
         auto pname =
@@ -477,10 +629,13 @@ extern "C"
     void kokkosp_deallocate_data(const SpaceHandle space, const char* label,
                                  const void* const ptr, const uint64_t size)
     {
-        if(violates_name_rules(label)) return;
         if(omnitrace::config::get_use_causal()) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        comp::kokkos_metrics::deallocate_data(space.name, ptr);
+
+        if(violates_name_rules(label)) return;
+
         kokkosp::logger_t{}.mark(0, __FUNCTION__, space.name, label,
                                  JOIN("", '[', ptr, ']'), size);
         auto pname =
@@ -496,9 +651,12 @@ extern "C"
                                  const char* src_name, const void* src_ptr, uint64_t size)
     {
         if(!_kp_deep_copy || omnitrace::config::get_use_causal()) return;
-        if(violates_name_rules(dst_name, src_name)) return;
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        comp::kokkos_metrics::begin_deep_copy(dst_handle.name, src_handle.name, size);
+
+        if(violates_name_rules(dst_name, src_name)) return;
+
         kokkosp::logger_t{}.mark(1, __FUNCTION__, dst_handle.name, dst_name,
                                  JOIN("", '[', dst_ptr, ']'), src_handle.name, src_name,
                                  JOIN("", '[', src_ptr, ']'), size);
@@ -521,6 +679,8 @@ extern "C"
 
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         kokkosp::logger_t{}.mark(-1, __FUNCTION__);
+        // the bandwidth is recorded before the deep copy region is stopped
+        comp::kokkos_metrics::end_deep_copy();
         auto& _data = kokkosp::get_profiler_stack<kokkosp_region>();
         if(_data.empty()) return;
         _data.back().store(tim::mpl::piecewise_select<kokkosp::memory_tracker>{},
@@ -534,7 +694,7 @@ extern "C"
     void kokkosp_profile_event(const char* name)
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-        auto _name = tim::get_hash_identifier_fast(tim::add_hash_id(name));
+        const auto* _name = intern_string(name);
         kokkosp::profiler_t<kokkosp_region>{ _name }.mark();
     }
 
@@ -547,15 +707,15 @@ extern "C"
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         if(omnitrace::config::get_use_perfetto())
         {
-            auto _name = tim::get_hash_identifier_fast(
-                tim::add_hash_id(JOIN(" ", _kp_prefix, label, "[dual_view_sync]")));
-            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name.data() },
+            const auto* _name =
+                intern_string(JOIN(" ", _kp_prefix, label, "[dual_view_sync]"));
+            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name },
                                 "target", (is_device) ? "device" : "host");
         }
         else if(omnitrace::config::get_use_causal())
         {
-            auto _name = tim::get_hash_identifier_fast(tim::add_hash_id(JOIN(
-                "", label, " [dual_view_sync][", (is_device) ? "device" : "host", "]")));
+            const auto* _name = intern_string(JOIN(
+                "", label, " [dual_view_sync][", (is_device) ? "device" : "host", "]"));
             kokkosp::profiler_t<kokkosp_region>{ _name }.mark();
         }
     }
@@ -567,16 +727,16 @@ extern "C"
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         if(omnitrace::config::get_use_perfetto())
         {
-            auto _name = tim::get_hash_identifier_fast(
-                tim::add_hash_id(JOIN(" ", _kp_prefix, label, "[dual_view_modify]")));
-            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name.data() },
+            const auto* _name =
+                intern_string(JOIN(" ", _kp_prefix, label, "[dual_view_modify]"));
+            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name },
                                 "target", (is_device) ? "device" : "host");
         }
         else if(omnitrace::config::get_use_causal())
         {
-            auto _name = tim::get_hash_identifier_fast(
-                tim::add_hash_id(JOIN(" ", _kp_prefix, label, "[dual_view_modify][",
-                                      (is_device) ? "device" : "host", "]")));
+            const auto* _name =
+                intern_string(JOIN(" ", _kp_prefix, label, "[dual_view_modify][",
+                                   (is_device) ? "device" : "host", "]"));
             kokkosp::profiler_t<kokkosp_region>{ _name }.mark();
         }
     }
@@ -0,0 +1,579 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/memory_bandwidth.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/perf.hpp"
+#include "library/region_intervals.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/hash/types.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/filepath.hpp>
+#include <timemory/utility/types.hpp>
+
+#include <linux/perf_event.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace memory_bandwidth
+{
+namespace
+{
+// the data fabric of AMD only counts the transfers of each channel in both directions
+enum traffic : uint8_t
+{
+    TRAFFIC_READ = 0,
+    TRAFFIC_WRITE,
+    TRAFFIC_TOTAL,
+    TRAFFIC_COUNT,
+};
+
+constexpr auto traffic_names =
+    std::array<std::string_view, TRAFFIC_COUNT>{ "read", "write", "total" };
+
+constexpr auto pmu_path = std::string_view{ "/sys/bus/event_source/devices" };
+
+// the DRAM channel events of the data fabric of Zen 2 and Zen 3 count the 64-byte
+// transfers of each channel. They are not exported in the sysfs of the PMU so these
+// are the encodings of the perf event lists of these processors
+constexpr auto amd_df_channels = std::array<std::string_view, 8>{
+    "event=0x07,umask=0x38",  "event=0x47,umask=0x38",  "event=0x87,umask=0x38",
+    "event=0xc7,umask=0x38",  "event=0x107,umask=0x38", "event=0x147,umask=0x38",
+    "event=0x187,umask=0x38", "event=0x1c7,umask=0x38"
+};
+
+// a system-wide counter of a PMU on one CPU of a socket. The data fabric has fewer
+// counters than channels so the counts are scaled by the fraction of the time the
+// counter was scheduled
+struct counter
+{
+    uint64_t read() const;
+
+    int              socket = 0;
+    traffic          kind   = TRAFFIC_READ;
+    double           scale  = 1.0;  // bytes per count
+    perf::perf_event event  = {};
+};
+
+// the traffic of one kind on one socket is the sum of the counters of its channels
+struct stream
+{
+    int                 socket   = 0;
+    traffic             kind     = TRAFFIC_READ;
+    std::vector<size_t> counters = {};
+
+    std::string label() const
+    {
+        return JOIN("", "socket ", socket, " ", traffic_names.at(kind));
+    }
+};
+
+using sample_t = std::pair<uint64_t, std::vector<uint64_t>>;  // counts per counter
+
+std::vector<std::unique_ptr<counter>> counters = {};
+std::vector<stream>                   streams  = {};
+std::deque<sample_t>                  data     = {};
+
+uint64_t
+counter::read() const
+{
+    uint64_t _v[3] = { 0, 0, 0 };  // value, time enabled, time running
+    auto _n = ::read(static_cast<int>(event.get_fileno()), _v, sizeof(_v));
+    if(_n != static_cast<ssize_t>(sizeof(_v))) return 0;
+    if(_v[2] == 0) return 0;
+    if(_v[2] >= _v[1]) return _v[0];
+    return static_cast<uint64_t>(static_cast<double>(_v[0]) * _v[1] / _v[2]);
+}
+
+// the cpumask of the uncore PMUs has one CPU per socket, e.g. "0,28"
+std::vector<int>
+parse_cpus(const std::string& _cpumask)
+{
+    auto _v = std::vector<int>{};
+    for(const auto& itr : tim::delimit(_cpumask, ","))
+    {
+        auto _pos = itr.find('-');
+        auto _lo  = std::atoi(itr.substr(0, _pos).c_str());
+        auto _hi  = (_pos == std::string::npos) ? _lo
+                                                : std::atoi(itr.substr(_pos + 1).c_str());
+        for(int i = _lo; i <= _hi; ++i)
+            _v.emplace_back(i);
+    }
+    return _v;
+}
+
+int
+get_socket(int _cpu)
+{
+    auto _id = utility::read_string(
+        JOIN('/', "/sys/devices/system/cpu", JOIN("", "cpu", _cpu), "topology",
+             "physical_package_id"));
+    return (_id.empty()) ? 0 : std::atoi(_id.c_str());
+}
+
+// applies the terms of an event (e.g. "event=0x04,umask=0x03") to the config fields of
+// the attributes with the bit ranges in the format of the PMU (e.g. "config:0-7,32-35")
+bool
+encode_event(const std::string& _pmu, std::string_view _terms, perf_event_attr& _pe)
+{
+    for(const auto& itr : tim::delimit(std::string{ _terms }, ","))
+    {
+        auto _pos    = itr.find('=');
+        auto _name   = itr.substr(0, _pos);
+        auto _value  = (_pos == std::string::npos)
+                           ? uint64_t{ 1 }
+                           : std::strtoull(itr.substr(_pos + 1).c_str(), nullptr, 0);
+        auto _format = utility::read_string(JOIN('/', pmu_path, _pmu, "format", _name));
+        auto _colon  = _format.find(':');
+        if(_colon == std::string::npos) return false;
+
+        auto      _field  = _format.substr(0, _colon);
+        uint64_t* _config = (_field == "config")    ? &_pe.config
+                            : (_field == "config1") ? &_pe.config1
+                            : (_field == "config2") ? &_pe.config2
+                                                    : nullptr;
+        if(!_config) return false;
+
+        for(const auto& ritr : tim::delimit(_format.substr(_colon + 1), ","))
+        {
+            auto _dash = ritr.find('-');
+            auto _lo   = std::strtoul(ritr.substr(0, _dash).c_str(), nullptr, 10);
+            auto _hi   = (_dash == std::string::npos)
+                             ? _lo
+                             : std::strtoul(ritr.substr(_dash + 1).c_str(), nullptr, 10);
+            for(auto _bit = _lo; _bit <= _hi; ++_bit)
+            {
+                *_config |= ((_value & 1) << _bit);
+                _value >>= 1;
+            }
+        }
+    }
+    return true;
+}
+
+// the bytes per count from the scale and the unit of the event in the sysfs of the
+// PMU, e.g. 6.103515625e-5 MiB for the CAS counts of the Intel memory controllers
+double
+get_event_scale(const std::string& _pmu, const std::string& _event, double _default)
+{
+    auto _path  = JOIN('/', pmu_path, _pmu, "events", _event);
+    auto _scale = utility::read_string(_path + ".scale");
+    if(_scale.empty()) return _default;
+
+    auto _unit = utility::read_string(_path + ".unit");
+    auto _mult = (_unit == "MiB") ? units::MiB : (_unit == "KiB") ? units::KiB : 1;
+    return std::strtod(_scale.c_str(), nullptr) * _mult;
+}
+
+// opens the counters of the event on the CPUs of the cpumask of the PMU
+size_t
+add_counters(const std::string& _pmu, std::string_view _terms, traffic _kind,
+             double _scale)
+{
+    auto _type = utility::read_string(JOIN('/', pmu_path, _pmu, "type"));
+    auto _cpus = parse_cpus(utility::read_string(JOIN('/', pmu_path, _pmu, "cpumask")));
+    if(_type.empty()) return 0;
+
+    size_t _n = 0;
+    for(auto _cpu : _cpus)
+    {
+        auto _pe        = perf_event_attr{};
+        _pe.type        = std::strtoul(_type.c_str(), nullptr, 10);
+        _pe.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        if(!encode_event(_pmu, _terms, _pe)) return _n;
+
+        auto _counter = std::make_unique<counter>();
+        if(auto _err = _counter->event.open(_pe, -1, _cpu); _err)
+        {
+            OMNITRACE_VERBOSE(1, "[memory_bandwidth::setup] %s (%s) on CPU %i: %s\n",
+                              _pmu.c_str(), std::string{ _terms }.c_str(), _cpu,
+                              _err->c_str());
+            continue;
+        }
+        _counter->socket = get_socket(_cpu);
+        _counter->kind   = _kind;
+        _counter->scale  = _scale;
+        counters.emplace_back(std::move(_counter));
+        ++_n;
+    }
+    return _n;
+}
+
+// the free-running counters of the memory controllers of the newer Intel server
+// processors are preferred over the CAS counts, which use the general-purpose counters
+void
+setup_intel()
+{
+    auto _pmus = std::vector<std::string>{};
+    for(const auto& itr : utility::list_directory(std::string{ pmu_path }))
+    {
+        if(itr.find("uncore_imc_free_running") == 0) _pmus.emplace_back(itr);
+    }
+
+    if(_pmus.empty())
+    {
+        for(const auto& itr : utility::list_directory(std::string{ pmu_path }))
+        {
+            if(itr.find("uncore_imc") == 0) _pmus.emplace_back(itr);
+        }
+    }
+
+    // the first event of each kind which is exported by the PMU
+    auto _add = [](const std::string& _pmu, traffic _kind, auto _names) {
+        for(const auto* itr : _names)
+        {
+            auto _terms = utility::read_string(JOIN('/', pmu_path, _pmu, "events", itr));
+            if(_terms.empty()) continue;
+            add_counters(_pmu, _terms, _kind, get_event_scale(_pmu, itr, 64.0));
+            return;
+        }
+    };
+
+    for(const auto& itr : _pmus)
+    {
+        _add(itr, TRAFFIC_READ,
+             std::array<const char*, 3>{ "data_read", "data_reads", "cas_count_read" });
+        _add(itr, TRAFFIC_WRITE,
+             std::array<const char*, 3>{ "data_write", "data_writes",
+                                         "cas_count_write" });
+    }
+}
+
+void
+setup_amd()
+{
+    constexpr auto _pmu = "amd_df";
+    if(utility::read_string(JOIN('/', pmu_path, _pmu, "type")).empty()) return;
+
+    for(auto itr : amd_df_channels)
+        add_counters(_pmu, itr, TRAFFIC_TOTAL, 64.0);
+}
+
+// the cumulative bytes of each stream at each sample
+struct traffic_series
+{
+    std::vector<uint64_t>            ts    = {};
+    std::vector<std::vector<double>> bytes = {};
+
+    // the bytes of the stream at the given time interpolated between the samples
+    double operator()(size_t _idx, uint64_t _ts) const;
+};
+
+double
+traffic_series::operator()(size_t _idx, uint64_t _ts) const
+{
+    const auto& _bytes = bytes.at(_idx);
+    if(_ts <= ts.front()) return _bytes.front();
+    if(_ts >= ts.back()) return _bytes.back();
+
+    auto _n    = std::distance(ts.begin(), std::upper_bound(ts.begin(), ts.end(), _ts));
+    auto _lhs  = static_cast<size_t>(_n - 1);
+    auto _rhs  = static_cast<size_t>(_n);
+    auto _frac = static_cast<double>(_ts - ts.at(_lhs)) /
+                 static_cast<double>(ts.at(_rhs) - ts.at(_lhs));
+    return _bytes.at(_lhs) + _frac * (_bytes.at(_rhs) - _bytes.at(_lhs));
+}
+
+traffic_series
+get_traffic_series()
+{
+    auto _v = traffic_series{};
+    _v.bytes.resize(streams.size());
+
+    const sample_t* _prev = nullptr;
+    for(const auto& itr : data)
+    {
+        if(_prev && itr.first <= _prev->first) continue;
+        _v.ts.emplace_back(itr.first);
+        for(size_t i = 0; i < streams.size(); ++i)
+        {
+            auto& _bytes = _v.bytes.at(i);
+            if(!_prev)
+            {
+                _bytes.emplace_back(0.0);
+                continue;
+            }
+            // the scaled counts of the multiplexed counters are estimates which may
+            // decrease slightly between the samples
+            auto _delta = 0.0;
+            for(auto cidx : streams.at(i).counters)
+            {
+                auto _curr = itr.second.at(cidx);
+                auto _last = _prev->second.at(cidx);
+                if(_curr > _last)
+                    _delta +=
+                        static_cast<double>(_curr - _last) * counters.at(cidx)->scale;
+            }
+            _bytes.emplace_back(_bytes.back() + _delta);
+        }
+        _prev = &itr;
+    }
+    return _v;
+}
+
+void
+post_process_perfetto(const traffic_series& _series)
+{
+    using track = perfetto_counter_track<category::memory_bandwidth>;
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    if(!_thread_info) return;
+
+    for(size_t i = 0; i < streams.size(); ++i)
+    {
+        if(!track::exists(i))
+            track::emplace(
+                i, JOIN("", "Memory Bandwidth [", streams.at(i).label(), "] (S)"),
+                "GB/s");
+    }
+
+    // the bandwidth over each interval is reported at the end of the interval
+    for(size_t n = 1; n < _series.ts.size(); ++n)
+    {
+        auto _ts = _series.ts.at(n);
+        if(!_thread_info->is_valid_time(_ts)) continue;
+
+        auto _sec = static_cast<double>(_ts - _series.ts.at(n - 1)) / units::sec;
+        for(size_t i = 0; i < streams.size(); ++i)
+        {
+            const auto& _bytes = _series.bytes.at(i);
+            auto        _gbs   = (_bytes.at(n) - _bytes.at(n - 1)) / units::GB / _sec;
+            TRACE_COUNTER(trait::name<category::memory_bandwidth>::value, track::at(i, 0),
+                          _ts, _gbs);
+        }
+    }
+
+    auto _end_ts = _thread_info->get_stop();
+    for(size_t i = 0; i < streams.size(); ++i)
+        TRACE_COUNTER(trait::name<category::memory_bandwidth>::value, track::at(i, 0),
+                      _end_ts, 0.0);
+}
+
+struct region_traffic
+{
+    uint64_t                          calls = 0;
+    uint64_t                          time  = 0;
+    std::array<double, TRAFFIC_COUNT> bytes = {};
+};
+
+// the traffic of the sockets is shared by every thread so the traffic of the regions
+// which execute concurrently overlaps, i.e. the traffic of a region is the traffic of
+// the sockets while the region was executing
+void
+post_process_regions(const traffic_series& _series)
+{
+    auto _regions = std::unordered_map<tim::hash_value_t, region_traffic>{};
+    region_intervals::for_each([&_regions, &_series](const auto& itr) {
+        auto& _region = _regions[itr.hash];
+        _region.calls += 1;
+        _region.time += (itr.end - itr.beg);
+        for(size_t i = 0; i < streams.size(); ++i)
+            _region.bytes.at(streams.at(i).kind) +=
+                _series(i, itr.end) - _series(i, itr.beg);
+    });
+
+    if(_regions.empty()) return;
+
+    auto _total = [](const region_traffic& _v) {
+        return _v.bytes.at(TRAFFIC_READ) + _v.bytes.at(TRAFFIC_WRITE) +
+               _v.bytes.at(TRAFFIC_TOTAL);
+    };
+
+    using entry_t = std::pair<std::string, region_traffic>;
+    auto _sorted  = std::vector<entry_t>{};
+    _sorted.reserve(_regions.size());
+    for(const auto& itr : _regions)
+        _sorted.emplace_back(std::string{ tim::get_hash_identifier_fast(itr.first) },
+                             itr.second);
+
+    std::sort(_sorted.begin(), _sorted.end(),
+              [&_total](const auto& _lhs, const auto& _rhs) {
+                  return _total(_lhs.second) > _total(_rhs.second);
+              });
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    auto _fname = tim::settings::compose_output_filename("memory-bandwidth", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<region_traffic>{}(
+                _fname, std::string{ "memory_bandwidth" });
+
+        ofs << std::setw(12) << "calls" << " " << std::setw(12) << "time [sec]" << " "
+            << std::setw(12) << "read [GB]" << " " << std::setw(12) << "write [GB]"
+            << " " << std::setw(12) << "total [GB]" << " " << std::setw(16)
+            << "bandwidth [GB/s]" << "   region\n";
+        ofs << std::fixed << std::setprecision(3);
+        for(const auto& itr : _sorted)
+        {
+            const auto& _v     = itr.second;
+            auto        _sec   = static_cast<double>(_v.time) / units::sec;
+            auto        _bytes = _total(_v);
+            ofs << std::setw(12) << _v.calls << " " << std::setw(12) << _sec << " "
+                << std::setw(12) << (_v.bytes.at(TRAFFIC_READ) / units::GB) << " "
+                << std::setw(12) << (_v.bytes.at(TRAFFIC_WRITE) / units::GB) << " "
+                << std::setw(12) << (_bytes / units::GB) << " " << std::setw(16)
+                << ((_sec > 0.0) ? (_bytes / units::GB / _sec) : 0.0) << "   "
+                << itr.first << "\n";
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening memory bandwidth output file: %s",
+                        _fname.c_str());
+    }
+}
+}  // namespace
+
+void
+setup()
+{
+    counters.clear();
+    streams.clear();
+    data.clear();
+
+    perfetto_counter_track<category::memory_bandwidth>::init();
+
+    setup_intel();
+    if(counters.empty()) setup_amd();
+
+    for(size_t i = 0; i < counters.size(); ++i)
+    {
+        const auto& _counter = *counters.at(i);
+        auto itr = std::find_if(streams.begin(), streams.end(), [&_counter](auto& _v) {
+            return _v.socket == _counter.socket && _v.kind == _counter.kind;
+        });
+        if(itr == streams.end())
+            itr = streams.emplace(streams.end(),
+                                  stream{ _counter.socket, _counter.kind, {} });
+        itr->counters.emplace_back(i);
+    }
+
+    std::sort(streams.begin(), streams.end(), [](const auto& _lhs, const auto& _rhs) {
+        return std::tie(_lhs.socket, _lhs.kind) < std::tie(_rhs.socket, _rhs.kind);
+    });
+
+    for(const auto& itr : counters)
+        itr->event.start();
+
+    OMNITRACE_VERBOSE(1,
+                      "[memory_bandwidth::setup] sampling %zu memory traffic counters "
+                      "of %zu sockets...\n",
+                      counters.size(), streams.size());
+
+    if(!counters.empty()) region_intervals::enable();
+}
+
+void
+config()
+{}
+
+void
+sample()
+{
+    if(counters.empty()) return;
+
+    auto _values = std::vector<uint64_t>{};
+    _values.reserve(counters.size());
+    for(const auto& itr : counters)
+        _values.emplace_back(itr->read());
+    data.emplace_back(tim::get_clock_real_now<uint64_t, std::nano>(), std::move(_values));
+}
+
+void
+shutdown()
+{
+    for(const auto& itr : counters)
+        itr->event.stop();
+}
+
+void
+post_process()
+{
+    if(counters.empty()) return;
+
+    region_intervals::disable();
+
+    tim::scope::destructor _dtor{ []() {
+        counters.clear();
+        streams.clear();
+        data.clear();
+    } };
+
+    if(data.size() < 2) return;
+
+    OMNITRACE_VERBOSE(1, "Post-processing %zu memory bandwidth entries...\n",
+                      data.size());
+
+    auto _series = get_traffic_series();
+    if(_series.ts.size() < 2) return;
+
+    if(get_use_perfetto()) post_process_perfetto(_series);
+
+    post_process_regions(_series);
+
+    auto _sec = static_cast<double>(_series.ts.back() - _series.ts.front()) / units::sec;
+    for(size_t i = 0; i < streams.size(); ++i)
+    {
+        const auto& _bytes = _series.bytes.at(i);
+        auto        _peak  = 0.0;
+        for(size_t n = 1; n < _series.ts.size(); ++n)
+        {
+            auto _dt = static_cast<double>(_series.ts.at(n) - _series.ts.at(n - 1));
+            _peak    = std::max(_peak, (_bytes.at(n) - _bytes.at(n - 1)) / _dt);
+        }
+        OMNITRACE_VERBOSE(0,
+                          "Memory bandwidth %-14s :: %.3f GB (average %.3f GB/s, peak "
+                          "%.3f GB/s)\n",
+                          streams.at(i).label().c_str(), _bytes.back() / units::GB,
+                          _bytes.back() / units::GB / _sec,
+                          _peak * units::sec / units::GB);
+    }
+}
+}  // namespace memory_bandwidth
+}  // namespace omnitrace
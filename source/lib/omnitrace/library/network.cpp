@@ -0,0 +1,265 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/network.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/units.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace network
+{
+namespace
+{
+// cumulative byte counter read from a file descriptor opened once
+struct sysfs_counter
+{
+    sysfs_counter() = default;
+    ~sysfs_counter();
+
+    sysfs_counter(const sysfs_counter&) = delete;
+    sysfs_counter& operator=(const sysfs_counter&) = delete;
+
+    bool     open(const std::string& _path, uint64_t _mult);
+    uint64_t read() const;
+
+    int      m_fd   = -1;
+    uint64_t m_mult = 1;
+};
+
+sysfs_counter::~sysfs_counter()
+{
+    if(m_fd >= 0) ::close(m_fd);
+}
+
+bool
+sysfs_counter::open(const std::string& _path, uint64_t _mult)
+{
+    m_fd   = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    m_mult = _mult;
+    return (m_fd >= 0);
+}
+
+uint64_t
+sysfs_counter::read() const
+{
+    char _buf[32];
+    auto _n = ::pread(m_fd, _buf, sizeof(_buf) - 1, 0);
+    if(_n <= 0) return 0;
+    _buf[_n] = '\0';
+    return std::strtoull(_buf, nullptr, 10) * m_mult;
+}
+
+struct link
+{
+    std::string   name = {};
+    sysfs_counter rx   = {};
+    sysfs_counter tx   = {};
+};
+
+using sample_t = std::pair<uint64_t, std::vector<uint64_t>>;  // rx0, tx0, rx1, ...
+
+std::vector<std::unique_ptr<link>> links = {};
+std::deque<sample_t>               data  = {};
+
+void
+add_link(std::string _name, const std::string& _rx, const std::string& _tx,
+         uint64_t _mult)
+{
+    auto _link = std::make_unique<link>();
+    if(!_link->rx.open(_rx, _mult) || !_link->tx.open(_tx, _mult))
+    {
+        OMNITRACE_VERBOSE(1, "[network::config] counters of '%s' are not available\n",
+                          _name.c_str());
+        return;
+    }
+    _link->name = std::move(_name);
+    links.emplace_back(std::move(_link));
+}
+}  // namespace
+
+void
+setup()
+{
+    perfetto_counter_track<category::network>::init();
+}
+
+// the links are the interfaces in OMNITRACE_NETWORK_INTERFACE (separated by spaces,
+// commas or semicolons) or, when it is empty, every interface in /sys/class/net except
+// the loopback. The InfiniBand ports are named <device>:<port> and the port counters
+// of the data are in units of four bytes
+void
+config()
+{
+    links.clear();
+    data.clear();
+
+    auto _selected = std::set<std::string>{};
+    for(auto itr : tim::delimit(
+            config::get_setting_value<std::string>("OMNITRACE_NETWORK_INTERFACE")
+                .value_or(std::string{}),
+            " ,;"))
+        _selected.emplace(itr);
+
+    auto _is_selected = [&_selected](const std::string& _v) {
+        return (_selected.empty()) ? (_v != "lo") : (_selected.count(_v) > 0);
+    };
+
+    for(const auto& itr : utility::list_directory("/sys/class/net"))
+    {
+        if(!_is_selected(itr)) continue;
+        auto _base = JOIN('/', "/sys/class/net", itr, "statistics");
+        add_link(itr, JOIN('/', _base, "rx_bytes"), JOIN('/', _base, "tx_bytes"), 1);
+    }
+
+    for(const auto& ditr : utility::list_directory("/sys/class/infiniband"))
+    {
+        auto _ports = JOIN('/', "/sys/class/infiniband", ditr, "ports");
+        for(const auto& pitr : utility::list_directory(_ports))
+        {
+            auto _name = JOIN(':', ditr, pitr);
+            if(!_selected.empty() && _selected.count(ditr) == 0 &&
+               _selected.count(_name) == 0)
+                continue;
+            auto _base = JOIN('/', _ports, pitr, "counters");
+            add_link(_name, JOIN('/', _base, "port_rcv_data"),
+                     JOIN('/', _base, "port_xmit_data"), 4);
+        }
+    }
+
+    OMNITRACE_VERBOSE(1, "[network::config] sampling %zu network links...\n",
+                      links.size());
+}
+
+void
+sample()
+{
+    if(links.empty()) return;
+
+    auto _values = std::vector<uint64_t>{};
+    _values.reserve(2 * links.size());
+    for(const auto& itr : links)
+    {
+        _values.emplace_back(itr->rx.read());
+        _values.emplace_back(itr->tx.read());
+    }
+    data.emplace_back(tim::get_clock_real_now<uint64_t, std::nano>(), std::move(_values));
+}
+
+void
+shutdown()
+{}
+
+void
+post_process()
+{
+    if(links.empty() || data.size() < 2) return;
+
+    OMNITRACE_VERBOSE(1, "Post-processing %zu network bandwidth entries...\n",
+                      data.size());
+
+    using track = perfetto_counter_track<category::network>;
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    OMNITRACE_CI_THROW(!_thread_info, "Missing thread info for thread 0");
+    if(!_thread_info) return;
+
+    for(size_t i = 0; i < links.size(); ++i)
+    {
+        if(!track::exists(i))
+        {
+            auto _label = JOIN("", '[', links.at(i)->name, ']');
+            track::emplace(i, JOIN(" ", "Network Receive", _label, "(S)"), "MB/s");
+            track::emplace(i, JOIN(" ", "Network Transmit", _label, "(S)"), "MB/s");
+        }
+    }
+
+    // the bandwidth over each interval is reported at the end of the interval
+    auto _peak = std::vector<double>(2 * links.size(), 0.0);
+    for(size_t n = 1; n < data.size(); ++n)
+    {
+        const auto& _prev = data.at(n - 1);
+        const auto& _curr = data.at(n);
+        if(_curr.first <= _prev.first || !_thread_info->is_valid_time(_curr.first))
+            continue;
+
+        auto _sec = static_cast<double>(_curr.first - _prev.first) / units::sec;
+        for(size_t i = 0; i < _curr.second.size(); ++i)
+        {
+            // the counters are reset when the link goes down
+            auto _bytes = (_curr.second.at(i) >= _prev.second.at(i))
+                              ? (_curr.second.at(i) - _prev.second.at(i))
+                              : 0;
+            auto _rate  = static_cast<double>(_bytes) / units::megabyte / _sec;
+            _peak.at(i) = std::max(_peak.at(i), _rate);
+            TRACE_COUNTER(trait::name<category::network>::value,
+                          track::at(i / 2, i % 2), _curr.first, _rate);
+        }
+    }
+
+    auto _end_ts = _thread_info->get_stop();
+    for(size_t i = 0; i < 2 * links.size(); ++i)
+        TRACE_COUNTER(trait::name<category::network>::value, track::at(i / 2, i % 2),
+                      _end_ts, 0.0);
+
+    const auto& _first = data.front().second;
+    const auto& _last  = data.back().second;
+    for(size_t i = 0; i < links.size(); ++i)
+    {
+        auto _delta = [&](size_t _idx) {
+            auto _v = (_last.at(_idx) >= _first.at(_idx))
+                          ? (_last.at(_idx) - _first.at(_idx))
+                          : 0;
+            return static_cast<double>(_v) / units::megabyte;
+        };
+        OMNITRACE_VERBOSE(1,
+                          "Network %-12s :: received %.3f MB (peak %.1f MB/s), "
+                          "transmitted %.3f MB (peak %.1f MB/s)\n",
+                          links.at(i)->name.c_str(), _delta(2 * i), _peak.at(2 * i),
+                          _delta(2 * i + 1), _peak.at(2 * i + 1));
+    }
+
+    links.clear();
+    data.clear();
+}
+}  // namespace network
+}  // namespace omnitrace
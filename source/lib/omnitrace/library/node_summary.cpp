@@ -0,0 +1,391 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/node_summary.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/storage/types.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#if defined(OMNITRACE_USE_MPI)
+#    include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace node_summary
+{
+#if defined(OMNITRACE_USE_MPI)
+namespace
+{
+// the moments are accumulated so the summaries of different nodes can be merged
+struct statistics
+{
+    uint64_t ranks = 0;
+    uint64_t calls = 0;
+    double   sum   = 0.0;
+    double   sqr   = 0.0;
+    double   min   = std::numeric_limits<double>::max();
+    double   max   = std::numeric_limits<double>::lowest();
+
+    void add(double _v, uint64_t _calls)
+    {
+        ranks += 1;
+        calls += _calls;
+        sum += _v;
+        sqr += _v * _v;
+        min = std::min(min, _v);
+        max = std::max(max, _v);
+    }
+
+    void merge(const statistics& _v)
+    {
+        ranks += _v.ranks;
+        calls += _v.calls;
+        sum += _v.sum;
+        sqr += _v.sqr;
+        min = std::min(min, _v.min);
+        max = std::max(max, _v.max);
+    }
+
+    double mean() const { return (ranks > 0) ? (sum / ranks) : 0.0; }
+
+    double stddev() const
+    {
+        if(ranks < 2) return 0.0;
+        auto _mean = mean();
+        return std::sqrt(std::max(0.0, sqr / ranks - _mean * _mean));
+    }
+};
+
+// keyed by the call-path so the entries of the ranks are merged independently of the
+// hash values and the thread decorations of the prefixes
+using table_t = std::map<std::string, statistics>;
+using nodes_t = std::vector<std::pair<std::string, table_t>>;
+
+constexpr int tree_tag = 0x6f6d6e69;  // "omni"
+
+template <typename Tp>
+void
+pack(std::vector<char>& _buf, const Tp& _v)
+{
+    auto _n = _buf.size();
+    _buf.resize(_n + sizeof(Tp));
+    std::memcpy(_buf.data() + _n, &_v, sizeof(Tp));
+}
+
+void
+pack(std::vector<char>& _buf, const std::string& _v)
+{
+    pack(_buf, static_cast<uint64_t>(_v.length()));
+    _buf.insert(_buf.end(), _v.begin(), _v.end());
+}
+
+template <typename Tp>
+Tp
+unpack(const char*& _ptr)
+{
+    Tp _v{};
+    std::memcpy(&_v, _ptr, sizeof(Tp));
+    _ptr += sizeof(Tp);
+    return _v;
+}
+
+template <>
+std::string
+unpack<std::string>(const char*& _ptr)
+{
+    auto _n = unpack<uint64_t>(_ptr);
+    auto _v = std::string{ _ptr, _n };
+    _ptr += _n;
+    return _v;
+}
+
+void
+pack(std::vector<char>& _buf, const nodes_t& _nodes)
+{
+    pack(_buf, static_cast<uint64_t>(_nodes.size()));
+    for(const auto& itr : _nodes)
+    {
+        pack(_buf, itr.first);
+        pack(_buf, static_cast<uint64_t>(itr.second.size()));
+        for(const auto& eitr : itr.second)
+        {
+            pack(_buf, eitr.first);
+            pack(_buf, eitr.second);
+        }
+    }
+}
+
+void
+unpack(const char* _ptr, nodes_t& _nodes)
+{
+    auto _n = unpack<uint64_t>(_ptr);
+    for(uint64_t i = 0; i < _n; ++i)
+    {
+        auto _node  = unpack<std::string>(_ptr);
+        auto _table = table_t{};
+        auto _m     = unpack<uint64_t>(_ptr);
+        for(uint64_t j = 0; j < _m; ++j)
+        {
+            auto _path = unpack<std::string>(_ptr);
+            _table[_path].merge(unpack<statistics>(_ptr));
+        }
+        _nodes.emplace_back(std::move(_node), std::move(_table));
+    }
+}
+
+// wall-clock time of every call-path on this rank
+table_t
+get_local_table()
+{
+    auto  _table   = table_t{};
+    auto* _storage = tim::storage<comp::wall_clock>::instance();
+    if(!_storage || _storage->empty()) return _table;
+
+    auto _values = std::map<std::string, std::pair<double, uint64_t>>{};
+    for(const auto& itr : _storage->get())
+    {
+        auto _path = std::string{};
+        for(auto hitr : itr.hierarchy())
+        {
+            auto _name = tim::get_hash_identifier_fast(hitr);
+            if(_name.empty()) continue;
+            if(!_path.empty()) _path += "/";
+            _path += _name;
+        }
+        if(_path.empty()) continue;
+        auto& _v = _values[_path];
+        _v.first += itr.data().get();
+        _v.second += itr.data().get_laps();
+    }
+
+    for(const auto& itr : _values)
+        _table[itr.first].add(itr.second.first, itr.second.second);
+    return _table;
+}
+
+// gathers the tables of the ranks of the node on the node leader
+table_t
+reduce_node(MPI_Comm _comm, const table_t& _local)
+{
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(_comm, &_rank);
+    PMPI_Comm_size(_comm, &_size);
+
+    auto _buf = std::vector<char>{};
+    pack(_buf, nodes_t{ { std::string{}, _local } });
+
+    auto _nbytes = static_cast<int>(_buf.size());
+    auto _counts = std::vector<int>(_size, 0);
+    PMPI_Gather(&_nbytes, 1, MPI_INT, _counts.data(), 1, MPI_INT, 0, _comm);
+
+    auto _displs = std::vector<int>(_size, 0);
+    for(int i = 1; i < _size; ++i)
+        _displs.at(i) = _displs.at(i - 1) + _counts.at(i - 1);
+
+    auto _all = std::vector<char>{};
+    if(_rank == 0) _all.resize(_displs.back() + _counts.back());
+
+    PMPI_Gatherv(_buf.data(), _nbytes, MPI_BYTE, _all.data(), _counts.data(),
+                 _displs.data(), MPI_BYTE, 0, _comm);
+
+    auto _node = table_t{};
+    if(_rank != 0) return _node;
+
+    for(int i = 0; i < _size; ++i)
+    {
+        auto _ranks = nodes_t{};
+        unpack(_all.data() + _displs.at(i), _ranks);
+        for(const auto& ritr : _ranks)
+            for(const auto& itr : ritr.second)
+                _node[itr.first].merge(itr.second);
+    }
+    return _node;
+}
+
+// binary tree reduction of the node summaries onto leader 0
+void
+reduce_leaders(MPI_Comm _comm, nodes_t& _nodes)
+{
+    int _rank = 0;
+    int _size = 1;
+    PMPI_Comm_rank(_comm, &_rank);
+    PMPI_Comm_size(_comm, &_size);
+
+    for(int _step = 1; _step < _size; _step *= 2)
+    {
+        if(_rank % (2 * _step) == _step)
+        {
+            auto _buf = std::vector<char>{};
+            pack(_buf, _nodes);
+            auto _nbytes = static_cast<int64_t>(_buf.size());
+            PMPI_Send(&_nbytes, 1, MPI_INT64_T, _rank - _step, tree_tag, _comm);
+            PMPI_Send(_buf.data(), static_cast<int>(_nbytes), MPI_BYTE, _rank - _step,
+                      tree_tag, _comm);
+            _nodes.clear();
+            return;
+        }
+        else if(_rank % (2 * _step) == 0 && _rank + _step < _size)
+        {
+            int64_t _nbytes = 0;
+            PMPI_Recv(&_nbytes, 1, MPI_INT64_T, _rank + _step, tree_tag, _comm,
+                      MPI_STATUS_IGNORE);
+            auto _buf = std::vector<char>(_nbytes);
+            PMPI_Recv(_buf.data(), static_cast<int>(_nbytes), MPI_BYTE, _rank + _step,
+                      tree_tag, _comm, MPI_STATUS_IGNORE);
+            unpack(_buf.data(), _nodes);
+        }
+    }
+}
+
+void
+write(const nodes_t& _nodes)
+{
+    auto _total = table_t{};
+    for(const auto& nitr : _nodes)
+        for(const auto& itr : nitr.second)
+            _total[itr.first].merge(itr.second);
+
+    // the most expensive call-paths first
+    auto _order = std::vector<std::pair<std::string, statistics>>{ _total.begin(),
+                                                                  _total.end() };
+    std::sort(_order.begin(), _order.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.sum > _rhs.second.sum;
+    });
+
+    auto _fname = tim::settings::compose_output_filename("node-summary", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<comp::wall_clock>{}(
+                _fname, std::string{ "node_summary" });
+
+        auto _unit = comp::wall_clock::get_display_unit();
+        ofs << "# wall-clock [" << _unit << "] across the ranks of each node\n";
+        ofs << std::setw(24) << "node" << " " << std::setw(6) << "ranks" << " "
+            << std::setw(12) << "calls" << " " << std::setw(14) << "min" << " "
+            << std::setw(14) << "max" << " " << std::setw(14) << "mean" << " "
+            << std::setw(14) << "stddev" << "   call-path\n";
+        ofs << std::fixed << std::setprecision(6);
+
+        auto _write = [&ofs](const std::string& _node, const std::string& _path,
+                             const statistics& _v) {
+            ofs << std::setw(24) << _node << " " << std::setw(6) << _v.ranks << " "
+                << std::setw(12) << _v.calls << " " << std::setw(14) << _v.min << " "
+                << std::setw(14) << _v.max << " " << std::setw(14) << _v.mean() << " "
+                << std::setw(14) << _v.stddev() << "   " << _path << "\n";
+        };
+
+        for(const auto& itr : _order)
+        {
+            _write("all", itr.first, itr.second);
+            if(_nodes.size() < 2) continue;
+            for(const auto& nitr : _nodes)
+            {
+                auto eitr = nitr.second.find(itr.first);
+                if(eitr != nitr.second.end()) _write(nitr.first, itr.first, eitr->second);
+            }
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening node summary output file: %s", _fname.c_str());
+    }
+}
+}  // namespace
+
+void
+post_process()
+{
+    int _initialized = 0;
+    int _finalized   = 0;
+    PMPI_Initialized(&_initialized);
+    PMPI_Finalized(&_finalized);
+    if(_initialized == 0 || _finalized != 0)
+    {
+        OMNITRACE_VERBOSE(1, "Node summary not computed: MPI is not active\n");
+        return;
+    }
+
+    int _rank = 0;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+
+    auto _node_comm = MPI_Comm{ MPI_COMM_NULL };
+    PMPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, _rank, MPI_INFO_NULL,
+                         &_node_comm);
+
+    int _node_rank = 0;
+    PMPI_Comm_rank(_node_comm, &_node_rank);
+
+    auto _node = reduce_node(_node_comm, get_local_table());
+    PMPI_Comm_free(&_node_comm);
+
+    // world rank 0 is the leader of its node since the ranks are ordered by world rank
+    auto _leader_comm = MPI_Comm{ MPI_COMM_NULL };
+    PMPI_Comm_split(MPI_COMM_WORLD, (_node_rank == 0) ? 0 : MPI_UNDEFINED, _rank,
+                    &_leader_comm);
+    if(_leader_comm == MPI_COMM_NULL) return;
+
+    char _host[MPI_MAX_PROCESSOR_NAME] = {};
+    int  _len                          = 0;
+    PMPI_Get_processor_name(_host, &_len);
+
+    auto _nodes = nodes_t{};
+    _nodes.emplace_back(std::string{ _host, static_cast<size_t>(_len) },
+                        std::move(_node));
+    reduce_leaders(_leader_comm, _nodes);
+    PMPI_Comm_free(&_leader_comm);
+
+    if(_rank != 0 || _nodes.empty()) return;
+
+    OMNITRACE_VERBOSE(0, "Node summary of %zu nodes computed\n", _nodes.size());
+
+    if(!config::get_setting_value<bool>("OMNITRACE_TEXT_OUTPUT").value_or(true)) return;
+
+    write(_nodes);
+}
+#else
+void
+post_process()
+{}
+#endif
+}  // namespace node_summary
+}  // namespace omnitrace
@@ -31,14 +31,29 @@
 #if defined(OMNITRACE_USE_OMPT) && OMNITRACE_USE_OMPT > 0
 
 #    include "core/components/fwd.hpp"
+#    include "core/perfetto.hpp"
+#    include "core/state.hpp"
+#    include "library/callsite.hpp"
 #    include "library/components/category_region.hpp"
+#    include "library/components/ompt_imbalance.hpp"
+#    include "library/sampling.hpp"
+#    include "library/tracing.hpp"
 
 #    include <timemory/components/ompt.hpp>
 #    include <timemory/components/ompt/extern.hpp>
 #    include <timemory/mpl/type_traits.hpp>
 #    include <timemory/timemory.hpp>
 
+#    include <algorithm>
+#    include <array>
+#    include <cstdlib>
+#    include <deque>
 #    include <memory>
+#    include <mutex>
+#    include <string>
+#    include <string_view>
+#    include <unordered_map>
+#    include <vector>
 
 using api_t          = TIMEMORY_API;
 using ompt_handle_t  = tim::component::ompt_handle<api_t>;
@@ -62,6 +77,572 @@ std::unique_ptr<ompt_bundle_t> f_bundle = {};
 bool _init_toolset_off = (trait::runtime_enabled<ompt_toolset_t>::set(false),
                           trait::runtime_enabled<ompt_context_t>::set(false), true);
 tim::ompt::finalize_tool_func_t f_finalize = nullptr;
+
+// the threads are parked while they wait in a barrier, taskwait, or taskgroup so the
+// samplers of the thread are suspended for the duration of the wait
+struct wait_region : comp::base<wait_region, void>
+{
+    static std::string label() { return "ompt_wait_region"; }
+
+    void set_prefix(std::string_view _v)
+    {
+        constexpr auto _keys = std::array<std::string_view, 3>{ "sync_region_wait",
+                                                               "wait_barrier",
+                                                               "ompt_wait" };
+        m_wait = std::any_of(_keys.begin(), _keys.end(), [_v](auto _key) {
+            return _v.find(_key) != std::string_view::npos;
+        });
+    }
+
+    void start()
+    {
+        if(m_wait) sampling::suspend_idle();
+    }
+
+    void stop()
+    {
+        if(m_wait) sampling::resume_idle();
+    }
+
+private:
+    bool m_wait = false;
+};
+
+// wraps the host callbacks which were already registered
+template <typename Tp>
+void
+set_callback(ompt_set_callback_t _set_callback, ompt_get_callback_t _get_callback,
+             ompt_callbacks_t _event, Tp& _prev, Tp _func)
+{
+    auto _cb = ompt_callback_t{ nullptr };
+    if(_get_callback && (*_get_callback)(_event, &_cb) == 1 && _cb)
+        _prev = reinterpret_cast<Tp>(_cb);
+    (*_set_callback)(_event, reinterpret_cast<ompt_callback_t>(_func));
+}
+
+//--------------------------------------------------------------------------------------//
+//
+// OMPT device tracing. The OpenMP runtime writes a record for every target region,
+// kernel, and data transfer on the device into the buffers provided by the tool and
+// hands the filled buffers back in batches. The kernels and data transfers are placed
+// on a perfetto track per device and connected with a flow to the host thread which
+// submitted them (via the host operation id)
+//
+//--------------------------------------------------------------------------------------//
+
+namespace device
+{
+// entry points of the device tracing interface of one device
+struct tracer
+{
+    int                          device_num      = 0;
+    bool                         active          = false;
+    ompt_device_t*               device          = nullptr;
+    ompt_start_trace_t           start_trace     = nullptr;
+    ompt_stop_trace_t            stop_trace      = nullptr;
+    ompt_advance_buffer_cursor_t advance_cursor  = nullptr;
+    ompt_get_record_ompt_t       get_record_ompt = nullptr;
+    ompt_translate_time_t        translate_time  = nullptr;
+    ompt_device_time_t           device_base     = 0;
+    double                       translate_base  = 0.0;
+    uint64_t                     host_base       = 0;
+
+    uint64_t get_host_time(ompt_device_time_t _v) const;
+};
+
+// host callbacks registered before the device tracing callbacks (i.e. by timemory)
+struct callbacks
+{
+    ompt_callback_device_initialize_t device_initialize = nullptr;
+    ompt_callback_device_finalize_t   device_finalize   = nullptr;
+    ompt_callback_target_submit_t     target_submit     = nullptr;
+    ompt_callback_target_data_op_t    target_data_op    = nullptr;
+};
+
+struct registry
+{
+    std::mutex                                        mutex   = {};
+    std::deque<tracer>                                tracers = {};
+    std::unordered_map<const void*, std::string>      labels  = {};  // codeptr
+    std::unordered_map<ompt_id_t, const std::string*> targets = {};  // target id
+};
+
+auto&
+get_registry()
+{
+    static auto* _v = new registry{};
+    return *_v;
+}
+
+auto&
+get_callbacks()
+{
+    static auto _v = callbacks{};
+    return _v;
+}
+
+size_t&
+get_buffer_size()
+{
+    static size_t _v = 0;
+    return _v;
+}
+
+// the host operation ids are tagged so they do not collide with the flow ids of the
+// roctracer correlation ids
+uint64_t
+get_flow_id(ompt_id_t _host_op_id)
+{
+    constexpr uint64_t _tag = (0x4f4d5054ULL << 32);  // "OMPT"
+    return (_tag ^ _host_op_id);
+}
+
+// lock must be held
+tracer*
+find_tracer(int _device_num)
+{
+    for(auto& itr : get_registry().tracers)
+        if(itr.device_num == _device_num) return &itr;
+    return nullptr;
+}
+
+// the device times are converted to the host clock of omnitrace with the offset
+// sampled when the trace was started. The translation function of the runtime gives
+// the time in seconds; without it the device time is assumed to be in nanoseconds
+uint64_t
+tracer::get_host_time(ompt_device_time_t _v) const
+{
+    if(translate_time)
+    {
+        auto _sec = (*translate_time)(device, _v) - translate_base;
+        return host_base + static_cast<int64_t>(_sec * units::sec);
+    }
+    return host_base + (static_cast<int64_t>(_v) - static_cast<int64_t>(device_base));
+}
+
+// lock must be held
+const std::string*
+get_target_label(const void* _codeptr)
+{
+    auto& _labels = get_registry().labels;
+    auto  itr     = _labels.find(_codeptr);
+    if(itr == _labels.end())
+    {
+        auto _label = callsite::get_label("omp_target", _codeptr);
+        itr         = _labels.emplace(_codeptr, std::move(_label)).first;
+    }
+    return &itr->second;
+}
+
+const char*
+get_data_op_name(ompt_target_data_op_t _v)
+{
+    switch(_v)
+    {
+        case ompt_target_data_alloc: return "omp_target_data_alloc";
+        case ompt_target_data_transfer_to_device: return "omp_target_data_transfer_to";
+        case ompt_target_data_transfer_from_device:
+            return "omp_target_data_transfer_from";
+        case ompt_target_data_delete: return "omp_target_data_delete";
+        case ompt_target_data_associate: return "omp_target_data_associate";
+        case ompt_target_data_disassociate: return "omp_target_data_disassociate";
+        default: break;
+    }
+    return "omp_target_data_op";
+}
+
+// one kernel or data transfer in a completed buffer
+struct activity
+{
+    const char*        name    = nullptr;
+    ompt_callbacks_t   type    = ompt_callback_target_submit;
+    uint64_t           beg_ns  = 0;
+    uint64_t           end_ns  = 0;
+    ompt_id_t          target  = 0;
+    ompt_id_t          host_op = 0;
+    ompt_record_ompt_t record  = {};
+};
+
+void
+buffer_request(int, ompt_buffer_t** _buffer, size_t* _bytes)
+{
+    *_bytes  = get_buffer_size();
+    *_buffer = malloc(*_bytes);
+    if(*_buffer == nullptr) *_bytes = 0;
+}
+
+void
+buffer_complete(int _device_num, ompt_buffer_t* _buffer, size_t _bytes,
+                ompt_buffer_cursor_t _begin, int _buffer_owned)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _activities = std::vector<activity>{};
+    {
+        auto& _registry = get_registry();
+        auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+        auto* _tracer   = find_tracer(_device_num);
+
+        // the records are decoded under the lock and emitted in one batch afterwards
+        for(auto _cursor = _begin; _tracer && _bytes > 0;)
+        {
+            auto* _record = (*_tracer->get_record_ompt)(_buffer, _cursor);
+            if(_record == nullptr) break;
+
+            switch(_record->type)
+            {
+                case ompt_callback_target:
+                {
+                    const auto& _target = _record->record.target;
+                    if(_target.endpoint == ompt_scope_begin)
+                        _registry.targets[_target.target_id] =
+                            get_target_label(_target.codeptr_ra);
+                    else
+                        _registry.targets.erase(_target.target_id);
+                    break;
+                }
+                case ompt_callback_target_submit:
+                {
+                    const auto& _kernel = _record->record.target_kernel;
+                    auto        itr     = _registry.targets.find(_record->target_id);
+                    _activities.emplace_back(activity{
+                        (itr != _registry.targets.end()) ? itr->second->c_str()
+                                                         : "omp_target",
+                        _record->type, _tracer->get_host_time(_record->time),
+                        _tracer->get_host_time(_kernel.end_time), _record->target_id,
+                        _kernel.host_op_id, *_record });
+                    break;
+                }
+                case ompt_callback_target_data_op:
+                {
+                    const auto& _data_op = _record->record.target_data_op;
+                    _activities.emplace_back(activity{
+                        get_data_op_name(_data_op.optype), _record->type,
+                        _tracer->get_host_time(_record->time),
+                        _tracer->get_host_time(_data_op.end_time), _record->target_id,
+                        _data_op.host_op_id, *_record });
+                    break;
+                }
+                default: break;
+            }
+
+            auto _next = ompt_buffer_cursor_t{};
+            if((*_tracer->advance_cursor)(_tracer->device, _buffer, _bytes, _cursor,
+                                          &_next) == 0)
+                break;
+            _cursor = _next;
+        }
+    }
+
+    if(_buffer_owned) free(_buffer);
+
+    if(!get_use_perfetto() || _activities.empty()) return;
+
+    auto _track_desc = [](int _devid) {
+        return JOIN("", "OpenMP Target Activity Device ", _devid);
+    };
+    const auto _track =
+        tracing::get_perfetto_track(category::device_ompt{}, _track_desc, _device_num);
+
+    for(auto& itr : _activities)
+    {
+        if(itr.end_ns < itr.beg_ns) std::swap(itr.beg_ns, itr.end_ns);
+
+        tracing::push_perfetto_track(
+            category::device_ompt{}, itr.name, _track, itr.beg_ns,
+            ::perfetto::TerminatingFlow::ProcessScoped(get_flow_id(itr.host_op)),
+            [&](::perfetto::EventContext ctx) {
+                if(config::get_perfetto_annotations())
+                {
+                    tracing::add_perfetto_annotation(ctx, "end_ns", itr.end_ns);
+                    tracing::add_perfetto_annotation(ctx, "device", _device_num);
+                    tracing::add_perfetto_annotation(ctx, "target_id", itr.target);
+                    tracing::add_perfetto_annotation(ctx, "host_op_id", itr.host_op);
+                    if(itr.type == ompt_callback_target_submit)
+                    {
+                        const auto& _kernel = itr.record.record.target_kernel;
+                        tracing::add_perfetto_annotation(ctx, "requested_teams",
+                                                         _kernel.requested_num_teams);
+                        tracing::add_perfetto_annotation(ctx, "granted_teams",
+                                                         _kernel.granted_num_teams);
+                    }
+                    else
+                    {
+                        const auto& _data_op = itr.record.record.target_data_op;
+                        tracing::add_perfetto_annotation(ctx, "bytes", _data_op.bytes);
+                        tracing::add_perfetto_annotation(ctx, "src_device",
+                                                         _data_op.src_device_num);
+                        tracing::add_perfetto_annotation(ctx, "dst_device",
+                                                         _data_op.dest_device_num);
+                    }
+                }
+            });
+        tracing::pop_perfetto_track(category::device_ompt{}, "", _track, itr.end_ns);
+    }
+}
+
+// host side of the flows to the device activity
+void
+target_submit(ompt_id_t _target_id, ompt_id_t _host_op_id, unsigned int _nteams)
+{
+    if(auto _func = get_callbacks().target_submit)
+        (*_func)(_target_id, _host_op_id, _nteams);
+
+    if(get_use_perfetto() && get_state() == State::Active)
+        tracing::mark_perfetto_ts(
+            category::ompt{}, "omp_target_submit", tracing::now(),
+            ::perfetto::Flow::ProcessScoped(get_flow_id(_host_op_id)));
+}
+
+void
+target_data_op(ompt_id_t _target_id, ompt_id_t _host_op_id,
+               ompt_target_data_op_t _optype, void* _src_addr, int _src_device_num,
+               void* _dest_addr, int _dest_device_num, size_t _bytes,
+               const void* _codeptr_ra)
+{
+    if(auto _func = get_callbacks().target_data_op)
+        (*_func)(_target_id, _host_op_id, _optype, _src_addr, _src_device_num,
+                 _dest_addr, _dest_device_num, _bytes, _codeptr_ra);
+
+    if(get_use_perfetto() && get_state() == State::Active)
+        tracing::mark_perfetto_ts(
+            category::ompt{}, get_data_op_name(_optype), tracing::now(),
+            ::perfetto::Flow::ProcessScoped(get_flow_id(_host_op_id)));
+}
+
+void
+device_initialize(int _device_num, const char* _type, ompt_device_t* _device,
+                  ompt_function_lookup_t _lookup, const char* _documentation)
+{
+    if(auto _func = get_callbacks().device_initialize)
+        (*_func)(_device_num, _type, _device, _lookup, _documentation);
+
+    if(!_lookup || !_device) return;
+
+    auto _get = [_lookup](const char* _name, auto& _v) {
+        _v = reinterpret_cast<std::decay_t<decltype(_v)>>((*_lookup)(_name));
+        return (_v != nullptr);
+    };
+
+    auto _set_trace_ompt  = ompt_set_trace_ompt_t{ nullptr };
+    auto _get_device_time = ompt_get_device_time_t{ nullptr };
+    auto _value           = tracer{};
+    _value.device_num     = _device_num;
+    _value.device         = _device;
+
+    if(!_get("ompt_set_trace_ompt", _set_trace_ompt) ||
+       !_get("ompt_start_trace", _value.start_trace) ||
+       !_get("ompt_advance_buffer_cursor", _value.advance_cursor) ||
+       !_get("ompt_get_record_ompt", _value.get_record_ompt))
+    {
+        OMNITRACE_VERBOSE_F(1,
+                            "OpenMP device %i (%s) does not support the OMPT device "
+                            "tracing interface\n",
+                            _device_num, (_type) ? _type : "unknown");
+        return;
+    }
+
+    _get("ompt_stop_trace", _value.stop_trace);
+    _get("ompt_translate_time", _value.translate_time);
+    _get("ompt_get_device_time", _get_device_time);
+
+    for(auto itr : { ompt_callback_target, ompt_callback_target_data_op,
+                     ompt_callback_target_submit })
+        (*_set_trace_ompt)(_device, 1, itr);
+
+    _value.host_base = tracing::now();
+    if(_get_device_time)
+    {
+        _value.device_base = (*_get_device_time)(_device);
+        if(_value.translate_time)
+            _value.translate_base =
+                (*_value.translate_time)(_device, _value.device_base);
+    }
+    else
+    {
+        _value.translate_time = nullptr;
+    }
+
+    auto& _registry = get_registry();
+    auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+    auto* _tracer   = find_tracer(_device_num);
+    if(!_tracer) _tracer = &_registry.tracers.emplace_back();
+    *_tracer        = _value;
+    _tracer->active = ((*_tracer->start_trace)(_device, &buffer_request,
+                                              &buffer_complete) != 0);
+
+    OMNITRACE_VERBOSE_F(1, "OMPT device tracing %s for OpenMP device %i (%s)\n",
+                        (_tracer->active) ? "started" : "failed to start", _device_num,
+                        (_type) ? _type : "unknown");
+}
+
+// stopping the trace flushes the buffers (possibly on the calling thread) so the lock
+// is released before the runtime is invoked
+void
+stop_trace(int _device_num)
+{
+    auto _value = tracer{};
+    {
+        auto& _registry = get_registry();
+        auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+        auto* _tracer   = find_tracer(_device_num);
+        if(!_tracer || !_tracer->active) return;
+        _tracer->active = false;
+        _value          = *_tracer;
+    }
+    if(_value.stop_trace) (*_value.stop_trace)(_value.device);
+}
+
+void
+device_finalize(int _device_num)
+{
+    stop_trace(_device_num);
+    if(auto _func = get_callbacks().device_finalize) (*_func)(_device_num);
+}
+
+void
+configure(ompt_function_lookup_t _lookup)
+{
+    auto _set_callback =
+        reinterpret_cast<ompt_set_callback_t>((*_lookup)("ompt_set_callback"));
+    auto _get_callback =
+        reinterpret_cast<ompt_get_callback_t>((*_lookup)("ompt_get_callback"));
+    if(!_set_callback) return;
+
+    get_buffer_size() =
+        config::get_setting_value<size_t>("OMNITRACE_OMPT_DEVICE_BUFFER_SIZE_KB")
+            .value_or(1024) *
+        units::KB;
+
+    auto& _callbacks = get_callbacks();
+    set_callback(_set_callback, _get_callback, ompt_callback_device_initialize,
+                 _callbacks.device_initialize, &device_initialize);
+    set_callback(_set_callback, _get_callback, ompt_callback_device_finalize,
+                 _callbacks.device_finalize, &device_finalize);
+    set_callback(_set_callback, _get_callback, ompt_callback_target_submit,
+                 _callbacks.target_submit, &target_submit);
+    set_callback(_set_callback, _get_callback, ompt_callback_target_data_op,
+                 _callbacks.target_data_op, &target_data_op);
+}
+
+// the remaining records are delivered to buffer_complete when the trace is stopped
+void
+shutdown()
+{
+    auto _devices = std::vector<int>{};
+    {
+        auto& _registry = get_registry();
+        auto  _lk       = std::unique_lock<std::mutex>{ _registry.mutex };
+        for(const auto& itr : _registry.tracers)
+            _devices.emplace_back(itr.device_num);
+    }
+    for(auto itr : _devices)
+        stop_trace(itr);
+}
+}  // namespace device
+
+//--------------------------------------------------------------------------------------//
+//
+// OpenMP load imbalance. The implicit task and sync region wait callbacks of every
+// thread are forwarded to the ompt_metrics of the omp_imbalance component, which groups
+// them by the parallel region instance
+//
+//--------------------------------------------------------------------------------------//
+
+namespace parallel
+{
+namespace ompt_metrics = component::ompt_metrics;
+
+// host callbacks registered before the imbalance callbacks (i.e. by timemory)
+struct callbacks
+{
+    ompt_callback_parallel_begin_t parallel_begin   = nullptr;
+    ompt_callback_parallel_end_t   parallel_end     = nullptr;
+    ompt_callback_implicit_task_t  implicit_task    = nullptr;
+    ompt_callback_sync_region_t    sync_region_wait = nullptr;
+};
+
+auto&
+get_callbacks()
+{
+    static auto _v = callbacks{};
+    return _v;
+}
+
+void
+parallel_begin(ompt_data_t* _task_data, const ompt_frame_t* _task_frame,
+               ompt_data_t* _parallel_data, unsigned int _requested, int _flags,
+               const void* _codeptr_ra)
+{
+    if(auto _func = get_callbacks().parallel_begin)
+        (*_func)(_task_data, _task_frame, _parallel_data, _requested, _flags,
+                 _codeptr_ra);
+
+    ompt_metrics::parallel_begin(_parallel_data, _codeptr_ra);
+}
+
+void
+parallel_end(ompt_data_t* _parallel_data, ompt_data_t* _task_data, int _flags,
+             const void* _codeptr_ra)
+{
+    ompt_metrics::parallel_end(_parallel_data);
+
+    if(auto _func = get_callbacks().parallel_end)
+        (*_func)(_parallel_data, _task_data, _flags, _codeptr_ra);
+}
+
+void
+implicit_task(ompt_scope_endpoint_t _endpoint, ompt_data_t* _parallel_data,
+              ompt_data_t* _task_data, unsigned int _nthreads, unsigned int _index,
+              int _flags)
+{
+    // the initial implicit task is not part of a parallel region
+    auto _initial = ((_flags & ompt_task_initial) != 0);
+
+    if(_endpoint == ompt_scope_end && !_initial) ompt_metrics::implicit_task_end();
+
+    if(auto _func = get_callbacks().implicit_task)
+        (*_func)(_endpoint, _parallel_data, _task_data, _nthreads, _index, _flags);
+
+    if(_endpoint == ompt_scope_begin && !_initial)
+        ompt_metrics::implicit_task_begin(_parallel_data, _nthreads, _index);
+}
+
+void
+sync_region_wait(ompt_sync_region_t _kind, ompt_scope_endpoint_t _endpoint,
+                 ompt_data_t* _parallel_data, ompt_data_t* _task_data,
+                 const void* _codeptr_ra)
+{
+    if(_endpoint == ompt_scope_end) ompt_metrics::wait_end();
+
+    if(auto _func = get_callbacks().sync_region_wait)
+        (*_func)(_kind, _endpoint, _parallel_data, _task_data, _codeptr_ra);
+
+    if(_endpoint == ompt_scope_begin) ompt_metrics::wait_begin();
+}
+
+void
+configure(ompt_function_lookup_t _lookup)
+{
+    auto _set_callback =
+        reinterpret_cast<ompt_set_callback_t>((*_lookup)("ompt_set_callback"));
+    auto _get_callback =
+        reinterpret_cast<ompt_get_callback_t>((*_lookup)("ompt_get_callback"));
+    if(!_set_callback) return;
+
+    ompt_metrics::setup();
+
+    auto& _callbacks = get_callbacks();
+    set_callback(_set_callback, _get_callback, ompt_callback_parallel_begin,
+                 _callbacks.parallel_begin, &parallel_begin);
+    set_callback(_set_callback, _get_callback, ompt_callback_parallel_end,
+                 _callbacks.parallel_end, &parallel_end);
+    set_callback(_set_callback, _get_callback, ompt_callback_implicit_task,
+                 _callbacks.implicit_task, &implicit_task);
+    set_callback(_set_callback, _get_callback, ompt_callback_sync_region_wait,
+                 _callbacks.sync_region_wait, &sync_region_wait);
+}
+}  // namespace parallel
 }  // namespace
 
 void
@@ -74,6 +655,8 @@ setup()
     comp::user_ompt_bundle::reset();
     tim::auto_lock_t lk{ tim::type_mutex<ompt_handle_t>() };
     comp::user_ompt_bundle::configure<component::local_category_region<category::ompt>>();
+    if(config::get_use_sampling() && config::get_sampling_idle() != "sample")
+        comp::user_ompt_bundle::configure<wait_region>();
     f_bundle = std::make_unique<ompt_bundle_t>("omnitrace/ompt",
                                                quirk::config<quirk::auto_start>{});
 }
@@ -86,6 +669,7 @@ shutdown()
     _protect = true;
     if(f_bundle)
     {
+        device::shutdown();
         if(tim::manager::instance()) tim::manager::instance()->cleanup("omnitrace-ompt");
         f_bundle->stop();
         ompt_context_t::cleanup();
@@ -130,6 +714,11 @@ tool_initialize(ompt_function_lookup_t lookup, int initial_device_num,
                         initial_device_num);
         f_finalize = tim::ompt::configure<TIMEMORY_OMPT_API_TAG>(
             lookup, initial_device_num, tool_data);
+        if(config::get_setting_value<bool>("OMNITRACE_OMPT_DEVICE_TRACING")
+               .value_or(true))
+            device::configure(lookup);
+        if(config::get_setting_value<bool>("OMNITRACE_OMPT_IMBALANCE").value_or(true))
+            parallel::configure(lookup);
     }
     return 1;  // success
 }
@@ -0,0 +1,334 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/parquet_output.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#if defined(OMNITRACE_USE_ARROW) && OMNITRACE_USE_ARROW > 0
+#    include <arrow/api.h>
+#    include <arrow/io/file.h>
+#    include <parquet/arrow/writer.h>
+#    include <parquet/properties.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace parquet_output
+{
+namespace
+{
+struct parquet_table
+{};
+
+struct stack_hash
+{
+    size_t operator()(const stack_t& _v) const
+    {
+        size_t _hash = _v.size();
+        for(const auto* itr : _v)
+            _hash ^= std::hash<const void*>{}(itr) + 0x9e3779b9 + (_hash << 6) +
+                     (_hash >> 2);
+        return _hash;
+    }
+};
+
+struct output_state
+{
+    bool                                              active     = false;
+    std::unordered_map<stack_t, uint64_t, stack_hash> stack_ids  = {};
+    std::vector<const stack_t*>                       new_stacks = {};
+    std::vector<sample_record>                        samples    = {};
+};
+
+auto&
+get_state()
+{
+    static auto _v = output_state{};
+    return _v;
+}
+
+#if defined(OMNITRACE_USE_ARROW) && OMNITRACE_USE_ARROW > 0
+struct table_writer
+{
+    std::string                                 filename = {};
+    std::shared_ptr<arrow::Schema>              schema   = {};
+    std::unique_ptr<parquet::arrow::FileWriter> writer   = {};
+};
+
+table_writer samples_writer = {};
+table_writer stacks_writer  = {};
+
+void
+check_status(const arrow::Status& _status, const char* _what)
+{
+    if(!_status.ok()) OMNITRACE_THROW("%s: %s\n", _what, _status.ToString().c_str());
+}
+
+template <typename Tp>
+Tp
+check_result(arrow::Result<Tp>&& _result, const char* _what)
+{
+    check_status(_result.status(), _what);
+    return std::move(_result).ValueUnsafe();
+}
+
+table_writer
+open(const std::string& _name, std::shared_ptr<arrow::Schema> _schema)
+{
+    auto _fname = tim::settings::compose_output_filename(_name, ".parquet");
+    // creates the output directory
+    {
+        auto _ofs = std::ofstream{};
+        if(!tim::filepath::open(_ofs, _fname))
+            OMNITRACE_THROW("Error opening parquet output file: %s\n", _fname.c_str());
+    }
+
+    auto _file = check_result(arrow::io::FileOutputStream::Open(_fname), _fname.c_str());
+
+    auto _props = parquet::WriterProperties::Builder{}
+                      .compression(parquet::Compression::ZSTD)
+                      ->enable_dictionary()
+                      ->build();
+
+    auto _writer = check_result(
+        parquet::arrow::FileWriter::Open(*_schema, arrow::default_memory_pool(), _file,
+                                         _props),
+        _fname.c_str());
+
+    return table_writer{ _fname, std::move(_schema), std::move(_writer) };
+}
+
+void
+close(table_writer& _table, const char* _label)
+{
+    if(!_table.writer) return;
+    check_status(_table.writer->Close(), _table.filename.c_str());
+    if(get_verbose() >= 0)
+        operation::file_output_message<parquet_table>{}(_table.filename,
+                                                        std::string{ _label });
+    _table = table_writer{};
+}
+
+template <typename BuilderT>
+std::shared_ptr<arrow::Array>
+finish(BuilderT& _builder)
+{
+    return check_result(_builder.Finish(), "Error building the parquet column");
+}
+
+void
+write(table_writer& _table, std::vector<std::shared_ptr<arrow::Array>>&& _columns)
+{
+    auto _nrows = _columns.front()->length();
+    auto _data  = arrow::Table::Make(_table.schema, std::move(_columns), _nrows);
+    // a single row-group per call
+    check_status(_table.writer->WriteTable(*_data, std::max<int64_t>(_nrows, 1)),
+                 _table.filename.c_str());
+}
+
+void
+write_samples(const std::vector<sample_record>& _samples)
+{
+    auto _tid      = arrow::Int64Builder{};
+    auto _kind     = arrow::StringBuilder{};
+    auto _start    = arrow::UInt64Builder{};
+    auto _end      = arrow::UInt64Builder{};
+    auto _stack_id = arrow::UInt64Builder{};
+    auto _metrics  = std::array<arrow::Int64Builder, 4>{};
+
+    for(const auto& itr : _samples)
+    {
+        check_status(_tid.Append(itr.tid), "tid");
+        check_status(_kind.Append(itr.kind), "kind");
+        check_status(_start.Append(itr.start), "start");
+        check_status(_end.Append(itr.end), "end");
+        check_status(_stack_id.Append(itr.stack_id), "stack_id");
+
+        size_t _idx = 0;
+        for(auto _v :
+            { itr.cpu_time, itr.peak_memory, itr.context_switches, itr.page_faults })
+        {
+            auto& _builder = _metrics.at(_idx++);
+            check_status((_v < 0) ? _builder.AppendNull() : _builder.Append(_v),
+                         "metrics");
+        }
+    }
+
+    write(samples_writer, { finish(_tid), finish(_kind), finish(_start), finish(_end),
+                            finish(_stack_id), finish(_metrics.at(0)),
+                            finish(_metrics.at(1)), finish(_metrics.at(2)),
+                            finish(_metrics.at(3)) });
+}
+
+void
+write_stacks(const std::vector<const stack_t*>& _stacks)
+{
+    auto _stack_id = arrow::UInt64Builder{};
+    auto _depth    = arrow::Int32Builder{};
+    auto _frame    = arrow::StringBuilder{};
+
+    auto& _ids = get_state().stack_ids;
+    for(const auto* itr : _stacks)
+    {
+        auto _id = _ids.at(*itr);
+        for(size_t i = 0; i < itr->size(); ++i)
+        {
+            check_status(_stack_id.Append(_id), "stack_id");
+            check_status(_depth.Append(static_cast<int32_t>(i)), "depth");
+            check_status(_frame.Append(itr->at(i)), "frame");
+        }
+    }
+
+    write(stacks_writer, { finish(_stack_id), finish(_depth), finish(_frame) });
+}
+#endif
+}  // namespace
+
+bool
+setup()
+{
+    auto& _state = get_state();
+    if(_state.active) return true;
+
+#if defined(OMNITRACE_USE_ARROW) && OMNITRACE_USE_ARROW > 0
+    try
+    {
+        samples_writer =
+            open("sampling-samples",
+                 arrow::schema({ arrow::field("tid", arrow::int64(), false),
+                                 arrow::field("kind", arrow::utf8(), false),
+                                 arrow::field("start_ns", arrow::uint64(), false),
+                                 arrow::field("end_ns", arrow::uint64(), false),
+                                 arrow::field("stack_id", arrow::uint64(), false),
+                                 arrow::field("cpu_time_ns", arrow::int64()),
+                                 arrow::field("peak_memory", arrow::int64()),
+                                 arrow::field("context_switches", arrow::int64()),
+                                 arrow::field("page_faults", arrow::int64()) }));
+        stacks_writer =
+            open("sampling-stacks",
+                 arrow::schema({ arrow::field("stack_id", arrow::uint64(), false),
+                                 arrow::field("depth", arrow::int32(), false),
+                                 arrow::field("frame", arrow::utf8(), false) }));
+        _state.active = true;
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "Parquet output of the sampling data is disabled: %s",
+                            _e.what());
+        samples_writer = table_writer{};
+        stacks_writer  = table_writer{};
+    }
+#else
+    OMNITRACE_WARNING_F(0, "OMNITRACE_SAMPLING_PARQUET_OUTPUT is ignored: omnitrace was "
+                           "built without Apache Arrow (OMNITRACE_USE_ARROW=OFF)\n");
+#endif
+
+    return _state.active;
+}
+
+bool
+is_active()
+{
+    return get_state().active;
+}
+
+uint64_t
+get_stack_id(const stack_t& _stack)
+{
+    auto& _state = get_state();
+    auto  _ret   = _state.stack_ids.emplace(_stack, _state.stack_ids.size());
+    // the keys of the map are stable
+    if(_ret.second) _state.new_stacks.emplace_back(&_ret.first->first);
+    return _ret.first->second;
+}
+
+void
+append(const sample_record& _sample)
+{
+    auto& _state = get_state();
+    if(_state.active) _state.samples.emplace_back(_sample);
+}
+
+void
+flush()
+{
+    auto& _state = get_state();
+    if(!_state.active) return;
+
+#if defined(OMNITRACE_USE_ARROW) && OMNITRACE_USE_ARROW > 0
+    try
+    {
+        if(!_state.samples.empty()) write_samples(_state.samples);
+        if(!_state.new_stacks.empty()) write_stacks(_state.new_stacks);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "Error writing the parquet output: %s", _e.what());
+        samples_writer = table_writer{};
+        stacks_writer  = table_writer{};
+        _state         = output_state{};
+        return;
+    }
+#endif
+
+    _state.samples.clear();
+    _state.new_stacks.clear();
+}
+
+void
+shutdown()
+{
+    auto& _state = get_state();
+    if(!_state.active) return;
+
+    flush();
+
+#if defined(OMNITRACE_USE_ARROW) && OMNITRACE_USE_ARROW > 0
+    try
+    {
+        close(samples_writer, "sampling_samples");
+        close(stacks_writer, "sampling_stacks");
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_WARNING_F(0, "Error writing the parquet output: %s", _e.what());
+        samples_writer = table_writer{};
+        stacks_writer  = table_writer{};
+    }
+#endif
+
+    _state = output_state{};
+}
+}  // namespace parquet_output
+}  // namespace omnitrace
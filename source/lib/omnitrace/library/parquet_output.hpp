@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace omnitrace
+{
+// columnar output of the sampling data (OMNITRACE_SAMPLING_PARQUET_OUTPUT): the
+// decoded samples are written to sampling-samples.parquet with one row per sample and
+// the call-stacks are written to sampling-stacks.parquet with one row per frame, i.e.
+// the samples reference the call-stacks by id. The rows appended for a thread are
+// written as a row-group when the thread is flushed so the memory is bounded by the
+// largest thread. The functions are not thread-safe and are invoked by the sampling
+// post-processing while it generates the output in thread order.
+namespace parquet_output
+{
+// the (interned) names of the frames of a call-stack, outermost frame first
+using stack_t = std::vector<const char*>;
+
+struct sample_record
+{
+    int64_t     tid              = 0;
+    const char* kind             = nullptr;  // timer, overflow, or off_cpu
+    uint64_t    start            = 0;        // nsec
+    uint64_t    end              = 0;        // nsec
+    uint64_t    stack_id         = 0;
+    int64_t     cpu_time         = -1;  // nsec, negative when not measured
+    int64_t     peak_memory      = -1;  // bytes, negative when not measured
+    int64_t     context_switches = -1;  // negative when not measured
+    int64_t     page_faults      = -1;  // negative when not measured
+};
+
+// returns false when the files could not be opened or omnitrace was built without
+// Apache Arrow (OMNITRACE_USE_ARROW)
+bool
+setup();
+
+bool
+is_active();
+
+// returns the id of the call-stack, adding it to the dictionary if it is new
+uint64_t
+get_stack_id(const stack_t&);
+
+void
+append(const sample_record&);
+
+// writes the samples and the call-stacks appended since the last flush as row-groups
+void
+flush();
+
+void
+shutdown();
+}  // namespace parquet_output
+}  // namespace omnitrace
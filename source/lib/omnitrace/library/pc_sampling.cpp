@@ -0,0 +1,693 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/pc_sampling.hpp"
+#include "binary/analysis.hpp"
+#include "binary/binary_info.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/process/process.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/delimit.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#if defined(OMNITRACE_USE_ROCPROFILER_SDK) && OMNITRACE_USE_ROCPROFILER_SDK > 0
+#    include <rocprofiler-sdk/registration.h>
+#    include <rocprofiler-sdk/rocprofiler.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(OMNITRACE_USE_ROCPROFILER_SDK) && OMNITRACE_USE_ROCPROFILER_SDK > 0
+
+#    define OMNITRACE_PC_SAMPLING_CALL(...)                                              \
+        ::omnitrace::pc_sampling::check_status(#__VA_ARGS__, __VA_ARGS__)
+
+namespace omnitrace
+{
+namespace pc_sampling
+{
+namespace
+{
+bool
+check_status(const char* _call, rocprofiler_status_t _status)
+{
+    if(_status == ROCPROFILER_STATUS_SUCCESS) return true;
+    OMNITRACE_WARNING_F(0, "%s failed: %s\n", _call,
+                        rocprofiler_get_status_string(_status));
+    return false;
+}
+
+struct code_object
+{
+    std::string uri        = {};
+    uint64_t    load_base  = 0;
+    uint64_t    load_delta = 0;
+    std::string image      = {};  // copy of the ELF when loaded from memory
+};
+
+// the entry of a kernel as an address of the ELF of the code object
+struct kernel_symbol
+{
+    uint64_t    code_object_id = 0;
+    uint64_t    entry          = 0;
+    std::string name           = {};
+};
+
+struct instruction_samples
+{
+    uint64_t                     count  = 0;
+    uint64_t                     issued = 0;  // stochastic method only
+    uint64_t                     lanes  = 0;  // sum of the active lanes
+    std::map<uint32_t, uint64_t> stalls = {};  // reason the wave was not issued
+};
+
+// code object id and offset of the instruction within the loaded code object
+using instruction_key_t = std::pair<uint64_t, uint64_t>;
+
+struct sampling_state
+{
+    bool                                              enabled      = false;
+    bool                                              stochastic   = false;
+    size_t                                            devices      = 0;
+    uint64_t                                          dropped      = 0;
+    uint64_t                                          invalid      = 0;
+    rocprofiler_context_id_t                          context      = { 0 };
+    rocprofiler_buffer_id_t                           buffer       = { 0 };
+    locking::atomic_mutex                             mutex        = {};
+    std::unordered_map<uint64_t, code_object>         code_objects = {};
+    std::vector<kernel_symbol>                        kernels      = {};
+    std::map<instruction_key_t, instruction_samples> samples      = {};
+};
+
+auto&
+get_state()
+{
+    static auto _v = sampling_state{};
+    return _v;
+}
+
+void
+code_object_callback(rocprofiler_callback_tracing_record_t _record,
+                     rocprofiler_user_data_t*, void*)
+{
+    if(_record.kind != ROCPROFILER_CALLBACK_TRACING_CODE_OBJECT ||
+       _record.phase != ROCPROFILER_CALLBACK_PHASE_LOAD)
+        return;
+
+    auto& _state = get_state();
+    auto  _lk    = locking::atomic_lock{ _state.mutex };
+
+    if(_record.operation == ROCPROFILER_CODE_OBJECT_LOAD)
+    {
+        using data_t = rocprofiler_callback_tracing_code_object_load_data_t;
+        const auto* _data = static_cast<const data_t*>(_record.payload);
+
+        auto& _obj      = _state.code_objects[_data->code_object_id];
+        _obj.uri        = (_data->uri) ? _data->uri : "";
+        _obj.load_base  = _data->load_base;
+        _obj.load_delta = _data->load_delta;
+        // the memory is only valid during the callback
+        if(_data->storage_type == ROCPROFILER_CODE_OBJECT_STORAGE_TYPE_MEMORY &&
+           _data->memory_base != 0 && _data->memory_size > 0)
+            _obj.image.assign(reinterpret_cast<const char*>(_data->memory_base),
+                              _data->memory_size);
+    }
+    else if(_record.operation == ROCPROFILER_CODE_OBJECT_DEVICE_KERNEL_SYMBOL_REGISTER)
+    {
+        using data_t =
+            rocprofiler_callback_tracing_code_object_kernel_symbol_register_data_t;
+        const auto* _data = static_cast<const data_t*>(_record.payload);
+        if(!_data->kernel_name) return;
+
+        auto     itr    = _state.code_objects.find(_data->code_object_id);
+        uint64_t _delta = (itr != _state.code_objects.end()) ? itr->second.load_delta : 0;
+        _state.kernels.emplace_back(kernel_symbol{
+            _data->code_object_id,
+            _data->kernel_object + _data->kernel_code_entry_byte_offset - _delta,
+            tim::demangle(_data->kernel_name) });
+    }
+}
+
+template <typename RecordT>
+instruction_samples&
+add_sample(sampling_state& _state, const RecordT& _record)
+{
+    auto& _v = _state.samples[instruction_key_t{ _record.pc.code_object_id,
+                                                 _record.pc.code_object_offset }];
+    _v.count += 1;
+    _v.lanes += __builtin_popcountll(_record.exec_mask);
+    return _v;
+}
+
+void
+buffer_callback(rocprofiler_context_id_t, rocprofiler_buffer_id_t,
+                rocprofiler_record_header_t** _headers, size_t _num_headers, void*,
+                uint64_t _drop_count)
+{
+    auto& _state = get_state();
+    auto  _lk    = locking::atomic_lock{ _state.mutex };
+
+    _state.dropped += _drop_count;
+    for(size_t i = 0; i < _num_headers; ++i)
+    {
+        const auto* _header = _headers[i];
+        if(_header->category != ROCPROFILER_BUFFER_CATEGORY_PC_SAMPLING) continue;
+
+        if(_header->kind == ROCPROFILER_PC_SAMPLING_RECORD_HOST_TRAP_V0_SAMPLE)
+        {
+            using record_t = rocprofiler_pc_sampling_record_host_trap_v0_t;
+            add_sample(_state, *static_cast<const record_t*>(_header->payload));
+        }
+        else if(_header->kind == ROCPROFILER_PC_SAMPLING_RECORD_STOCHASTIC_V0_SAMPLE)
+        {
+            using record_t     = rocprofiler_pc_sampling_record_stochastic_v0_t;
+            const auto& _data  = *static_cast<const record_t*>(_header->payload);
+            auto&       _entry = add_sample(_state, _data);
+            if(_data.wave_issued)
+                _entry.issued += 1;
+            else if(_data.flags.has_stall_reason)
+                _entry.stalls[_data.snapshot.reason_not_issued] += 1;
+        }
+        else
+        {
+            ++_state.invalid;
+        }
+    }
+}
+
+// the highest power of two which does not exceed the value
+size_t
+floor_pow2(size_t _v)
+{
+    while((_v & (_v - 1)) != 0)
+        _v &= (_v - 1);
+    return _v;
+}
+
+bool
+configure_device(sampling_state& _state, const rocprofiler_agent_v0_t& _agent)
+{
+    auto _method = (_state.stochastic) ? ROCPROFILER_PC_SAMPLING_METHOD_STOCHASTIC
+                                       : ROCPROFILER_PC_SAMPLING_METHOD_HOST_TRAP;
+    auto _unit   = (_state.stochastic) ? ROCPROFILER_PC_SAMPLING_UNIT_CYCLES
+                                       : ROCPROFILER_PC_SAMPLING_UNIT_TIME;
+
+    using config_t = rocprofiler_pc_sampling_configuration_t;
+    auto _configs  = std::vector<config_t>{};
+    auto _query    = [](const config_t* _v, size_t _n, void* _data) {
+        auto* _configs_v = static_cast<std::vector<config_t>*>(_data);
+        _configs_v->assign(_v, _v + _n);
+        return ROCPROFILER_STATUS_SUCCESS;
+    };
+
+    if(!OMNITRACE_PC_SAMPLING_CALL(rocprofiler_query_pc_sampling_agent_configurations(
+           _agent.id, _query, &_configs)))
+        return false;
+
+    auto itr = std::find_if(_configs.begin(), _configs.end(), [&](const config_t& _v) {
+        return _v.method == _method && _v.unit == _unit;
+    });
+
+    if(itr == _configs.end())
+    {
+        OMNITRACE_VERBOSE(1, "[pc_sampling] %s PC sampling is not supported by %s\n",
+                          config::get_pc_sampling_method().c_str(), _agent.name);
+        return false;
+    }
+
+    auto _interval = std::clamp<size_t>(config::get_pc_sampling_interval(),
+                                        itr->min_interval, itr->max_interval);
+    if(_state.stochastic) _interval = floor_pow2(_interval);
+
+    OMNITRACE_VERBOSE(1, "[pc_sampling] sampling the PCs of %s (node %u) every %zu %s\n",
+                      _agent.name, _agent.node_id, _interval,
+                      (_state.stochastic) ? "cycles" : "usec");
+
+    return OMNITRACE_PC_SAMPLING_CALL(rocprofiler_configure_pc_sampling_service(
+        _state.context, _agent.id, _method, _unit, _interval, _state.buffer, 0));
+}
+
+int
+tool_init(rocprofiler_client_finalize_t, void*)
+{
+    auto& _state      = get_state();
+    _state.stochastic = (config::get_pc_sampling_method() == "stochastic");
+
+    if(!OMNITRACE_PC_SAMPLING_CALL(rocprofiler_create_context(&_state.context)))
+        return -1;
+
+    OMNITRACE_PC_SAMPLING_CALL(rocprofiler_configure_callback_tracing_service(
+        _state.context, ROCPROFILER_CALLBACK_TRACING_CODE_OBJECT, nullptr, 0,
+        code_object_callback, nullptr));
+
+    constexpr size_t buffer_size = 8 * units::megabyte;
+    if(!OMNITRACE_PC_SAMPLING_CALL(rocprofiler_create_buffer(
+           _state.context, buffer_size, (buffer_size * 7) / 8,
+           ROCPROFILER_BUFFER_POLICY_LOSSLESS, buffer_callback, nullptr, &_state.buffer)))
+        return -1;
+
+    auto _agents = std::vector<rocprofiler_agent_v0_t>{};
+    auto _query  = [](rocprofiler_agent_version_t, const void** _agents_v, size_t _n,
+                     void* _data) {
+        auto* _gpus = static_cast<std::vector<rocprofiler_agent_v0_t>*>(_data);
+        for(size_t i = 0; i < _n; ++i)
+        {
+            const auto* _agent = static_cast<const rocprofiler_agent_v0_t*>(_agents_v[i]);
+            if(_agent->type == ROCPROFILER_AGENT_TYPE_GPU) _gpus->emplace_back(*_agent);
+        }
+        return ROCPROFILER_STATUS_SUCCESS;
+    };
+
+    OMNITRACE_PC_SAMPLING_CALL(rocprofiler_query_available_agents(
+        ROCPROFILER_AGENT_INFO_VERSION_0, _query, sizeof(rocprofiler_agent_v0_t),
+        &_agents));
+
+    for(const auto& itr : _agents)
+        if(configure_device(_state, itr)) ++_state.devices;
+
+    if(_state.devices == 0)
+    {
+        OMNITRACE_WARNING_F(0, "GPU PC sampling is disabled: no device supports the "
+                               "'%s' method\n",
+                            config::get_pc_sampling_method().c_str());
+        return 0;
+    }
+
+    _state.enabled =
+        OMNITRACE_PC_SAMPLING_CALL(rocprofiler_start_context(_state.context));
+    return 0;
+}
+
+void
+tool_fini(void*)
+{}
+
+rocprofiler_tool_configure_result_t*
+configure(uint32_t, const char* _runtime_version, uint32_t _priority,
+          rocprofiler_client_id_t* _id)
+{
+    _id->name = "omnitrace";
+
+    OMNITRACE_VERBOSE_F(1, "Configuring rocprofiler-sdk %s (priority %u)...\n",
+                        _runtime_version, _priority);
+
+    static auto _result = rocprofiler_tool_configure_result_t{
+        sizeof(rocprofiler_tool_configure_result_t), &tool_init, &tool_fini, nullptr
+    };
+    return &_result;
+}
+
+// the path, offset, and size of a code object from a URI of the form
+// file://<path>#offset=<N>&size=<N>. A size of zero is the remainder of the file
+struct file_uri
+{
+    std::string path   = {};
+    size_t      offset = 0;
+    size_t      size   = 0;
+};
+
+std::optional<file_uri>
+parse_file_uri(const std::string& _uri)
+{
+    constexpr auto prefix = std::string_view{ "file://" };
+    if(_uri.find(prefix) != 0) return std::nullopt;
+
+    auto _v    = file_uri{};
+    auto _hash = _uri.find('#');
+    auto _path = _uri.substr(prefix.length(), _hash - prefix.length());
+
+    // decode the percent-encoded characters
+    for(size_t i = 0; i < _path.length(); ++i)
+    {
+        if(_path.at(i) == '%' && i + 2 < _path.length())
+        {
+            _v.path += static_cast<char>(std::stoi(_path.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        }
+        else
+            _v.path += _path.at(i);
+    }
+
+    if(_hash == std::string::npos) return _v;
+
+    for(const auto& itr : tim::delimit(_uri.substr(_hash + 1), "&"))
+    {
+        auto _pos = itr.find('=');
+        if(_pos == std::string::npos) continue;
+        auto _key = itr.substr(0, _pos);
+        auto _val = std::stoull(itr.substr(_pos + 1), nullptr, 0);
+        if(_key == "offset")
+            _v.offset = _val;
+        else if(_key == "size")
+            _v.size = _val;
+    }
+
+    return _v;
+}
+
+// the binary analysis of a code object. The code objects which were loaded from memory
+// or which are embedded in another file (e.g. the fat binary of an executable) are
+// extracted to a temporary file
+struct code_object_info
+{
+    std::shared_ptr<config::tmp_file> file   = {};
+    std::vector<binary::binary_info>  binary = {};
+};
+
+code_object_info
+read_code_object(uint64_t _id, const code_object& _obj)
+{
+    auto _v     = code_object_info{};
+    auto _fname = std::string{};
+    auto _image = std::string_view{ _obj.image };
+    auto _bytes = std::string{};
+
+    if(_image.empty())
+    {
+        auto _uri = parse_file_uri(_obj.uri);
+        if(!_uri || !tim::filepath::exists(_uri->path)) return _v;
+
+        if(_uri->offset == 0 && _uri->size == 0)
+        {
+            _fname = _uri->path;
+        }
+        else
+        {
+            auto _ifs = std::ifstream{ _uri->path, std::ios::binary };
+            _ifs.seekg(_uri->offset);
+            if(_uri->size > 0)
+            {
+                _bytes.resize(_uri->size);
+                _ifs.read(_bytes.data(), _uri->size);
+                _bytes.resize(_ifs.gcount());
+            }
+            else
+            {
+                _bytes.assign(std::istreambuf_iterator<char>{ _ifs },
+                              std::istreambuf_iterator<char>{});
+            }
+            _image = _bytes;
+        }
+    }
+
+    if(!_image.empty())
+    {
+        auto _basename = JOIN('-', "omnitrace-pc-sampling", tim::process::get_id(), _id);
+        _v.file        = std::make_shared<config::tmp_file>(
+            JOIN('/', config::get_tmpdir(), _basename + ".co"));
+        if(!_v.file->open(std::ios::binary | std::ios::out)) return _v;
+        _v.file->stream.write(_image.data(), _image.size());
+        _v.file->close();
+        _fname = _v.file->filename;
+    }
+
+    _v.binary = binary::get_binary_info({ _fname }, {});
+    for(auto& itr : _v.binary)
+        if(!itr.is_indexed()) itr.build_index();
+
+    return _v;
+}
+
+struct instruction_info
+{
+    uint64_t                   address  = 0;
+    std::string                location = {};
+    const instruction_samples* samples  = nullptr;
+};
+
+struct kernel_info
+{
+    uint64_t                      count        = 0;
+    std::vector<instruction_info> instructions = {};
+};
+
+std::string
+get_stall_reason(const instruction_samples& _v)
+{
+    auto itr = std::max_element(
+        _v.stalls.begin(), _v.stalls.end(),
+        [](const auto& _lhs, const auto& _rhs) { return _lhs.second < _rhs.second; });
+    if(itr == _v.stalls.end()) return std::string{ "-" };
+
+    using reason_t = rocprofiler_pc_sampling_instruction_not_issued_reason_t;
+    const auto* _name =
+        rocprofiler_get_pc_sampling_instruction_not_issued_reason_name(
+            static_cast<reason_t>(itr->first));
+    return (_name) ? std::string{ _name } : std::to_string(itr->first);
+}
+}  // namespace
+
+void
+setup()
+{
+    // PC sampling is a beta feature of rocprofiler-sdk in ROCm 6.x
+    tim::set_env("ROCPROFILER_PC_SAMPLING_BETA_ENABLED", "1", 0);
+
+    if(!OMNITRACE_PC_SAMPLING_CALL(rocprofiler_force_configure(&configure)))
+        OMNITRACE_WARNING_F(0, "GPU PC sampling is disabled: rocprofiler-sdk was "
+                               "initialized before omnitrace\n");
+}
+
+void
+shutdown()
+{
+    auto& _state = get_state();
+    if(!_state.enabled) return;
+
+    OMNITRACE_PC_SAMPLING_CALL(rocprofiler_stop_context(_state.context));
+    OMNITRACE_PC_SAMPLING_CALL(rocprofiler_flush_buffer(_state.buffer));
+}
+
+void
+post_process()
+{
+    auto& _state = get_state();
+    if(!_state.enabled) return;
+
+    _state.enabled = false;
+
+    auto _lk = locking::atomic_lock{ _state.mutex };
+
+    uint64_t _total = 0;
+    for(const auto& itr : _state.samples)
+        _total += itr.second.count;
+
+    OMNITRACE_VERBOSE(0,
+                      "[pc_sampling] %lu GPU PC samples of %zu instructions from %zu "
+                      "devices (%lu dropped, %lu invalid)\n",
+                      static_cast<unsigned long>(_total), _state.samples.size(),
+                      _state.devices, static_cast<unsigned long>(_state.dropped),
+                      static_cast<unsigned long>(_state.invalid));
+
+    if(_total == 0) return;
+
+    // the registered kernels of each code object sorted by the entry
+    auto _kernel_symbols = std::unordered_map<uint64_t, std::vector<kernel_symbol>>{};
+    for(const auto& itr : _state.kernels)
+        _kernel_symbols[itr.code_object_id].emplace_back(itr);
+    for(auto& itr : _kernel_symbols)
+        std::sort(itr.second.begin(), itr.second.end(),
+                  [](const auto& _lhs, const auto& _rhs) {
+                      return _lhs.entry < _rhs.entry;
+                  });
+
+    auto _code_objects = std::unordered_map<uint64_t, code_object_info>{};
+    auto _kernels      = std::map<std::string, kernel_info>{};
+    for(const auto& itr : _state.samples)
+    {
+        auto _id   = itr.first.first;
+        auto _oitr = _state.code_objects.find(_id);
+
+        auto _kernel = std::string{ "<unknown code object>" };
+        auto _info   = instruction_info{ itr.first.second, std::string{}, &itr.second };
+        if(_oitr != _state.code_objects.end())
+        {
+            const auto& _obj = _oitr->second;
+            // the offset within the loaded code object as an address of the ELF
+            auto _address = itr.first.second + _obj.load_base - _obj.load_delta;
+            auto _found   = false;
+            _info.address = _address;
+
+            if(_code_objects.find(_id) == _code_objects.end())
+                _code_objects.emplace(_id, read_code_object(_id, _obj));
+
+            for(auto& bitr : _code_objects.at(_id).binary)
+            {
+                bitr.find_symbols(_address, [&](const binary::symbol&        _sym,
+                                                const binary::address_index& _lines) {
+                    _found  = true;
+                    _kernel = tim::demangle(_sym.func);
+                    _lines.find(_address - _sym.load_address, [&](size_t _idx) {
+                        const auto& _entry = _sym.dwarf_info.at(_idx);
+                        _info.location =
+                            JOIN(':', std::string_view{ _entry.file }, _entry.line);
+                    });
+                });
+            }
+
+            // without a symbol table, the kernel is the nearest registered kernel
+            if(!_found)
+            {
+                const auto& _syms = _kernel_symbols[_id];
+                auto        kitr  = std::upper_bound(
+                    _syms.begin(), _syms.end(), _address,
+                    [](uint64_t _lhs, const auto& _rhs) { return _lhs < _rhs.entry; });
+                _kernel = (kitr != _syms.begin()) ? std::prev(kitr)->name
+                                                  : std::string{ "<unknown kernel>" };
+            }
+        }
+
+        auto& _entry = _kernels[_kernel];
+        _entry.count += itr.second.count;
+        _entry.instructions.emplace_back(std::move(_info));
+    }
+
+    auto _sorted = std::vector<std::pair<std::string, kernel_info>>{ _kernels.begin(),
+                                                                      _kernels.end() };
+    std::sort(_sorted.begin(), _sorted.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.second.count > _rhs.second.count;
+    });
+
+    for(size_t i = 0; i < std::min<size_t>(_sorted.size(), 5); ++i)
+    {
+        const auto& itr = _sorted.at(i);
+        OMNITRACE_VERBOSE(1, "[pc_sampling] %6.2f%% :: %s\n",
+                          (100.0 * itr.second.count) / _total, itr.first.c_str());
+    }
+
+    auto _fname = tim::settings::compose_output_filename("pc-sampling", ".txt");
+    auto _top   = config::get_pc_sampling_top();
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<instruction_samples>{}(
+                _fname, std::string{ "pc_sampling" });
+
+        ofs << "# GPU PC sampling (" << config::get_pc_sampling_method() << "): "
+            << _total << " samples, " << _state.dropped << " dropped\n";
+        ofs << std::fixed << std::setprecision(2);
+
+        for(auto& itr : _sorted)
+        {
+            auto& _instructions = itr.second.instructions;
+            std::sort(_instructions.begin(), _instructions.end(),
+                      [](const auto& _lhs, const auto& _rhs) {
+                          return _lhs.samples->count > _rhs.samples->count;
+                      });
+
+            ofs << "\n" << itr.first << " :: " << itr.second.count << " samples ("
+                << (100.0 * itr.second.count) / _total << "% of the GPU samples)\n";
+            ofs << std::setw(18) << "address" << " " << std::setw(10) << "samples" << " "
+                << std::setw(8) << "kernel%" << " " << std::setw(8) << "lanes";
+            if(_state.stochastic)
+                ofs << " " << std::setw(8) << "issued%" << " " << std::setw(32)
+                    << "stall reason";
+            ofs << "   source\n";
+
+            auto _n = (_top > 0) ? std::min(_top, _instructions.size())
+                                 : _instructions.size();
+            for(size_t i = 0; i < _n; ++i)
+            {
+                const auto& _inst  = _instructions.at(i);
+                const auto& _count = _inst.samples->count;
+                ofs << std::setw(18) << as_hex(_inst.address) << " " << std::setw(10)
+                    << _count << " " << std::setw(8)
+                    << (100.0 * _count) / itr.second.count << " " << std::setw(8)
+                    << static_cast<double>(_inst.samples->lanes) / _count;
+                if(_state.stochastic)
+                    ofs << " " << std::setw(8)
+                        << (100.0 * _inst.samples->issued) / _count << " "
+                        << std::setw(32) << get_stall_reason(*_inst.samples);
+                ofs << "   " << ((_inst.location.empty()) ? "?" : _inst.location) << "\n";
+            }
+        }
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening GPU PC sampling output file: %s", _fname.c_str());
+    }
+
+    _state.samples.clear();
+    _state.code_objects.clear();
+    _state.kernels.clear();
+}
+
+bool
+is_enabled()
+{
+    return get_state().enabled;
+}
+}  // namespace pc_sampling
+}  // namespace omnitrace
+
+#else
+
+namespace omnitrace
+{
+namespace pc_sampling
+{
+void
+setup()
+{
+    OMNITRACE_WARNING_F(0, "OMNITRACE_PC_SAMPLING is ignored: omnitrace was built "
+                           "without rocprofiler-sdk "
+                           "(OMNITRACE_USE_ROCPROFILER_SDK=OFF)\n");
+}
+
+void
+shutdown()
+{}
+
+void
+post_process()
+{}
+
+bool
+is_enabled()
+{
+    return false;
+}
+}  // namespace pc_sampling
+}  // namespace omnitrace
+
+#endif
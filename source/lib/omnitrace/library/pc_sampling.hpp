@@ -0,0 +1,50 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace omnitrace
+{
+// GPU PC sampling (OMNITRACE_PC_SAMPLING): the program counters of the GPU waves are
+// sampled via rocprofiler-sdk and attributed to the instructions of the code objects.
+// The post-processing extracts each code object, maps the instructions to the kernel
+// and source line via the binary analysis of the code object and writes the hottest
+// instructions of each kernel to pc-sampling.txt
+namespace pc_sampling
+{
+// configures rocprofiler-sdk. Must be invoked before the HIP/HSA runtime is
+// initialized
+void
+setup();
+
+// stops the sampling and flushes the samples
+void
+shutdown();
+
+void
+post_process();
+
+// whether the sampling was configured for at least one device
+bool
+is_enabled();
+}  // namespace pc_sampling
+}  // namespace omnitrace
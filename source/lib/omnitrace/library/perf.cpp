@@ -32,6 +32,7 @@
 #include <timemory/log/macros.hpp>
 #include <timemory/units.hpp>
 
+#include <array>
 #include <asm/unistd.h>
 #include <ctime>
 #include <fcntl.h>
@@ -148,7 +149,7 @@ perf_event::operator=(perf_event&& rhs) noexcept
 
 // Open a perf_event file and map it (if sampling is enabled)
 std::optional<std::string>
-perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
+perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu, int _group_fd)
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
     m_sample_type = _pe.sample_type;
@@ -160,7 +161,7 @@ perf_event::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
     _pe.disabled = 1;
 
     // Open the file
-    m_fd = perf_event_open(&_pe, _pid, _cpu, -1, 0);
+    m_fd = perf_event_open(&_pe, _pid, _cpu, _group_fd, 0);
     if(m_fd == -1)
     {
         std::string path = "/proc/sys/kernel/perf_event_paranoid";
@@ -341,8 +342,9 @@ perf_event::iterator::iterator(perf_event& _source, struct perf_event_mmap_page*
 {
     if(_mapping != nullptr)
     {
+        // the kernel writes the records before it publishes the head
         m_index = _mapping->data_tail;
-        m_head  = _mapping->data_head;
+        m_head  = __atomic_load_n(&_mapping->data_head, __ATOMIC_ACQUIRE);
     }
     else
     {
@@ -355,7 +357,8 @@ perf_event::iterator::~iterator()
 {
     if(m_mapping != nullptr)
     {
-        m_mapping->data_tail = m_index;
+        // the records must be consumed before the kernel may overwrite them
+        __atomic_store_n(&m_mapping->data_tail, m_index, __ATOMIC_RELEASE);
     }
 }
 
@@ -477,13 +480,41 @@ perf_event::record::get_tid() const
 uint64_t
 perf_event::record::get_time() const
 {
-    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+    OMNITRACE_ASSERT((is_sample() || is_switch()) && m_source != nullptr &&
                      m_source->is_sampling(sample::time))
         << "Record does not have a 'time' field (" << is_sample() << "|" << m_source
         << ")";
+
+    // a switch record has no body, the time is in the trailing sample_id fields which
+    // are only present when the perf_event was opened with sample_id_all
+    if(is_switch())
+    {
+        uintptr_t p =
+            reinterpret_cast<uintptr_t>(m_header) + sizeof(struct perf_event_header);
+        if(m_source->is_sampling(sample::pid_tid))
+            p += sizeof(uint32_t) + sizeof(uint32_t);
+        return *reinterpret_cast<uint64_t*>(p);
+    }
+
     return *locate_field<sample::time, uint64_t*>();
 }
 
+bool
+perf_event::record::is_switch_out() const
+{
+    return is_switch() && (m_header->misc & PERF_RECORD_MISC_SWITCH_OUT) != 0;
+}
+
+bool
+perf_event::record::is_preempted() const
+{
+#if defined(PERF_RECORD_MISC_SWITCH_OUT_PREEMPT)
+    return is_switch_out() && (m_header->misc & PERF_RECORD_MISC_SWITCH_OUT_PREEMPT) != 0;
+#else
+    return false;
+#endif
+}
+
 uint64_t
 perf_event::record::get_period() const
 {
@@ -494,6 +525,16 @@ perf_event::record::get_period() const
     return *locate_field<sample::period, uint64_t*>();
 }
 
+uint64_t
+perf_event::record::get_addr() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::addr))
+        << "Record does not have an 'addr' field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::addr, uint64_t*>();
+}
+
 uint32_t
 perf_event::record::get_cpu() const
 {
@@ -504,6 +545,26 @@ perf_event::record::get_cpu() const
     return *locate_field<sample::cpu, uint32_t*>();
 }
 
+uint64_t
+perf_event::record::get_weight() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::weight))
+        << "Record does not have a 'weight' field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::weight, uint64_t*>();
+}
+
+uint64_t
+perf_event::record::get_data_src() const
+{
+    OMNITRACE_ASSERT(is_sample() && m_source != nullptr &&
+                     m_source->is_sampling(sample::data_src))
+        << "Record does not have a 'data_src' field (" << is_sample() << "|" << m_source
+        << ")";
+    return *locate_field<sample::data_src, uint64_t*>();
+}
+
 container::c_array<uint64_t>
 perf_event::record::get_callchain() const
 {
@@ -629,6 +690,16 @@ perf_event::record::locate_field() const
     if(m_source != nullptr && m_source->is_sampling(sample::stack))
         OMNITRACE_FATAL << "Stack sampling is not supported";
 
+    // weight
+    if constexpr(SampleT == sample::weight) return reinterpret_cast<Tp>(p);
+    if(m_source != nullptr && m_source->is_sampling(sample::weight))
+        p += sizeof(uint64_t);
+
+    // data_src
+    if constexpr(SampleT == sample::data_src) return reinterpret_cast<Tp>(p);
+    if(m_source != nullptr && m_source->is_sampling(sample::data_src))
+        p += sizeof(uint64_t);
+
     // end
     if constexpr(SampleT == sample::last) return reinterpret_cast<Tp>(p);
 
@@ -640,19 +711,154 @@ perf_event::record::locate_field() const
         return Tp{};
 }
 
+namespace
+{
+#if defined(__x86_64__) || defined(__i386__)
+constexpr bool rdpmc_supported = true;
+
+inline uint64_t
+rdpmc(uint32_t _idx)
+{
+    uint32_t _lo = 0;
+    uint32_t _hi = 0;
+    asm volatile("rdpmc" : "=a"(_lo), "=d"(_hi) : "c"(_idx));
+    return (static_cast<uint64_t>(_hi) << 32) | _lo;
+}
+#else
+constexpr bool rdpmc_supported = false;
+
+inline uint64_t
+rdpmc(uint32_t)
+{
+    return 0;
+}
+#endif
+}  // namespace
+
+user_counter::~user_counter() { close(); }
+
+std::optional<std::string>
+user_counter::open(struct perf_event_attr& _pe, pid_t _pid, int _cpu)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    close();
+
+    _pe.size           = sizeof(struct perf_event_attr);
+    _pe.disabled       = 1;
+    _pe.read_format    = 0;
+    _pe.sample_type    = 0;
+    _pe.sample_period  = 0;
+    _pe.exclude_kernel = 1;
+    _pe.exclude_hv     = 1;
+
+    m_fd = perf_event_open(&_pe, _pid, _cpu, -1, 0);
+    OMNITRACE_RETURN_ERROR_MSG(m_fd == -1,
+                               "Failed to open perf event: " << strerror(errno));
+
+    // only the first page is mapped since there is no ring buffer
+    void* _page = mmap(nullptr, sizes.page, PROT_READ, MAP_SHARED, m_fd, 0);
+    if(_page == MAP_FAILED)
+    {
+        auto _err = errno;
+        close();
+        OMNITRACE_RETURN_ERROR_MSG(
+            true, "Mapping the perf_event page failed: " << strerror(_err));
+    }
+
+    m_mapping = reinterpret_cast<struct perf_event_mmap_page*>(_page);
+
+    return std::optional<std::string>{};
+}
+
+bool
+user_counter::start() const
+{
+    if(m_fd == -1) return false;
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    return (ioctl(m_fd, PERF_EVENT_IOC_RESET, 0) != -1 &&
+            ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0) != -1);
+}
+
+bool
+user_counter::stop() const
+{
+    if(m_fd == -1) return false;
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    return (ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0) != -1);
+}
+
+void
+user_counter::close()
+{
+    if(m_mapping != nullptr)
+    {
+        munmap(m_mapping, sizes.page);
+        m_mapping = nullptr;
+    }
+
+    if(m_fd != -1)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+// the kernel only sets cap_user_rdpmc when the page is updated, i.e. after the event
+// has been scheduled at least once
+bool
+user_counter::has_rdpmc() const
+{
+    return (rdpmc_supported && m_mapping != nullptr && m_mapping->cap_user_rdpmc != 0);
+}
+
+// see the documentation of perf_event_mmap_page in linux/perf_event.h. The lock is
+// a sequence count which changes when the kernel updates the page, e.g. when the
+// thread is migrated or the counter is rescheduled, so the read is retried
+uint64_t
+user_counter::read() const
+{
+    if(m_fd == -1) return 0;
+
+    if(has_rdpmc())
+    {
+        uint32_t _seq   = 0;
+        uint64_t _count = 0;
+        do
+        {
+            _seq      = __atomic_load_n(&m_mapping->lock, __ATOMIC_ACQUIRE);
+            _count    = m_mapping->offset;
+            auto _idx = m_mapping->index;
+            if(m_mapping->cap_user_rdpmc != 0 && _idx != 0)
+            {
+                auto _shift = 64 - m_mapping->pmc_width;
+                auto _pmc   = static_cast<int64_t>(rdpmc(_idx - 1) << _shift) >> _shift;
+                _count += static_cast<uint64_t>(_pmc);
+            }
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while(__atomic_load_n(&m_mapping->lock, __ATOMIC_RELAXED) != _seq);
+        return _count;
+    }
+
+    uint64_t _count = 0;
+    return (::read(m_fd, &_count, sizeof(_count)) == sizeof(_count)) ? _count : 0;
+}
+
 namespace
 {
 inline auto&
 get_instances()
 {
-    using thread_data_t = thread_data<identity<std::unique_ptr<perf_event>>, perf_event>;
+    using group_t       = std::array<std::unique_ptr<perf_event>, max_group_size>;
+    using thread_data_t = thread_data<identity<group_t>, perf_event>;
     static auto& _v     = thread_data_t::instance(construct_on_init{});
     return _v;
 }
 }  // namespace
 
 std::unique_ptr<perf_event>&
-get_instance(int64_t _tid)
+get_instance(int64_t _tid, size_t _idx)
 {
     auto& _data = get_instances();
     if(static_cast<size_t>(_tid) >= _data->size())
@@ -660,7 +866,7 @@ get_instance(int64_t _tid)
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         _data->resize(_tid + 1);
     }
-    return _data->at(_tid);
+    return _data->at(_tid).at(_idx);
 }
 }  // namespace perf
 }  // namespace omnitrace
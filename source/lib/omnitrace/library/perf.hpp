@@ -64,9 +64,10 @@ struct perf_event
     perf_event(const perf_event&) = delete;
     perf_event& operator=(const perf_event&) = delete;
 
-    /// Open a perf_event file using the given options structure
+    /// Open a perf_event file using the given options structure. A valid group_fd
+    /// makes this perf_event a member of the group led by that perf_event file
     std::optional<std::string> open(struct perf_event_attr& pe, pid_t pid = 0,
-                                    int cpu = -1);
+                                    int cpu = -1, int group_fd = -1);
     std::optional<std::string> open(double, uint32_t = 0, pid_t pid = 0, int cpu = -1);
 
     /// Return file descriptor
@@ -133,13 +134,25 @@ struct perf_event
         inline bool is_read() const { return get_type() == record_type::read; }
         inline bool is_sample() const { return get_type() == record_type::sample; }
         inline bool is_mmap2() const { return get_type() == record_type::mmap2; }
+        inline bool is_switch() const
+        {
+            return get_type() == record_type::switch_record;
+        }
+
+        // the thread was switched out (otherwise in). If the thread was still runnable,
+        // it was preempted rather than blocked
+        bool is_switch_out() const;
+        bool is_preempted() const;
 
         uint64_t                     get_ip() const;
         uint64_t                     get_pid() const;
         uint64_t                     get_tid() const;
         uint64_t                     get_time() const;
         uint64_t                     get_period() const;
+        uint64_t                     get_addr() const;
         uint32_t                     get_cpu() const;
+        uint64_t                     get_weight() const;    // e.g. load latency in cycles
+        uint64_t                     get_data_src() const;  // perf_mem_data_src
         container::c_array<uint64_t> get_callchain() const;
 
     private:
@@ -205,8 +218,54 @@ private:
     uint64_t m_read_format = 0;
 };
 
-/// provides thread-local instance of perf_event
+/// A counting perf_event of the calling thread whose value is read in userspace. When
+/// the kernel allows it (cap_user_rdpmc in the first page of the mapping), the value
+/// is the offset maintained by the kernel plus the hardware counter read with the
+/// rdpmc instruction, i.e. reading it does not require a system call
+struct user_counter
+{
+    user_counter() = default;
+    ~user_counter();
+
+    user_counter(const user_counter&) = delete;
+    user_counter(user_counter&&)      = delete;
+    user_counter& operator=(const user_counter&) = delete;
+    user_counter& operator=(user_counter&&) = delete;
+
+    /// Open a counting (non-sampling) perf_event and map its first page
+    std::optional<std::string> open(struct perf_event_attr& pe, pid_t pid = 0,
+                                    int cpu = -1);
+
+    /// Reset the value and start counting events
+    bool start() const;
+
+    /// Stop counting events
+    bool stop() const;
+
+    /// Close the perf_event file and unmap the page
+    void close();
+
+    /// Check if the perf_event file is open
+    bool is_open() const { return (m_fd != -1); }
+
+    /// Check if the value can be read without a system call
+    bool has_rdpmc() const;
+
+    /// Read the value. Safe to invoke in a signal handler
+    uint64_t read() const;
+
+private:
+    long                         m_fd      = -1;
+    struct perf_event_mmap_page* m_mapping = nullptr;
+};
+
+/// maximum number of overflow events sampled concurrently by a thread
+static constexpr size_t max_group_size = 4;
+
+/// provides thread-local instance of perf_event. The instance at index zero is the
+/// leader of the group of overflow events of the thread, the other indexes are the
+/// members of the group
 std::unique_ptr<perf_event>&
-get_instance(int64_t _tid);
+get_instance(int64_t _tid, size_t _idx = 0);
 }  // namespace perf
 }  // namespace omnitrace
@@ -0,0 +1,686 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/perf_sampler.hpp"
+#include "core/common.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/state.hpp"
+#include "library/perf.hpp"
+#include "library/runtime.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace perf_sampler
+{
+namespace
+{
+struct source_state
+{
+    int64_t                                cpu             = -1;  // per-thread if < 0
+    bool                                   off_cpu         = false;
+    bool                                   enabled         = false;
+    bool                                   paused          = false;  // re-enable
+    bool                                   exited          = false;
+    bool                                   preempted       = false;
+    uint64_t                               beg_ns          = 0;  // earlier are dropped
+    uint64_t                               period          = 0;
+    uint64_t                               switch_out      = 0;
+    calling_context::node_id_t             switch_node     = 0;
+    size_t                                 lost            = 0;
+    std::unique_ptr<perf::perf_event>      event           = {};
+    std::unique_ptr<calling_context::tree> tree            = {};
+    std::vector<record>                    records         = {};
+    std::vector<cpu_record>                cpu_records     = {};
+    std::vector<off_cpu_record>            off_cpu_records = {};
+};
+
+using source_map_t = std::map<int64_t, std::unique_ptr<source_state>>;
+
+std::mutex                      registry_mutex  = {};
+source_map_t                    thread_sources  = {};
+source_map_t                    cpu_sources     = {};
+source_map_t                    off_cpu_sources = {};
+std::map<uint32_t, std::string> commands        = {};
+uint64_t                        cpu_period      = 0;
+std::once_flag                  drain_once      = {};
+std::unique_ptr<std::thread>    drain_thread    = {};
+std::atomic<bool>               drain_stop      = { false };
+bool                            sources_paused  = false;
+int                             drain_epoll     = -1;
+constexpr int                   drain_timeout   = 100;  // msec
+constexpr int                   drain_events    = 64;
+constexpr uint64_t              sample_type =
+    PERF_SAMPLE_TIME | PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
+
+// lock must be held. The perf_event is re-enabled by resume()
+void
+pause_source(source_state& _state)
+{
+    if(!_state.enabled || !_state.event || _state.exited) return;
+    _state.event->stop();
+    _state.enabled = false;
+    _state.paused  = true;
+}
+
+// lock must be held
+void
+restart_source(source_state& _state)
+{
+    if(_state.enabled) return;
+    if(sources_paused)
+        _state.paused = true;
+    else
+        _state.enabled = _state.event->start();
+}
+
+// lock must be held
+void
+cache_command(uint32_t _pid)
+{
+    if(commands.find(_pid) != commands.end()) return;
+
+    // the process may have exited by the time the record is drained
+    auto _comm = std::string{};
+    auto _ifs  = std::ifstream{ JOIN('/', "/proc", _pid, "comm") };
+    if(_ifs) std::getline(_ifs, _comm);
+    if(_comm.empty()) _comm = (_pid == 0) ? "swapper" : "unknown";
+    commands.emplace(_pid, _comm);
+}
+
+// lock must be held
+void
+drain(source_state& _state)
+{
+    constexpr size_t max_depth = OMNITRACE_MAX_UNWIND_DEPTH;
+
+    if(!_state.event || !_state.event->is_open()) return;
+
+    for(auto itr : *_state.event)
+    {
+        if(itr.is_lost())
+        {
+            ++_state.lost;
+            continue;
+        }
+
+        // an off-CPU interval ends when the thread is switched back in
+        if(_state.off_cpu && itr.is_switch())
+        {
+            auto _ts = itr.get_time();
+            if(itr.is_switch_out())
+            {
+                _state.switch_out = _ts;
+                _state.preempted  = itr.is_preempted();
+            }
+            else if(_state.switch_out > 0 && _ts > _state.switch_out)
+            {
+                _state.off_cpu_records.emplace_back(off_cpu_record{
+                    _state.switch_out, _ts, _state.preempted, _state.switch_node });
+                _state.switch_out  = 0;
+                _state.switch_node = 0;
+            }
+            continue;
+        }
+
+        if(!itr.is_sample()) continue;
+
+        auto _ts = itr.get_time();
+        if(_ts < _state.beg_ns) continue;
+
+        // the callchain starts at the innermost frame and the kernel and user-space
+        // portions are preceded by a context marker
+        auto _ip      = itr.get_ip();
+        auto _addrs   = std::array<uintptr_t, max_depth>{};
+        auto _n       = size_t{ 0 };
+        bool _skip_ip = true;
+
+        _addrs[_n++] = _ip;
+        for(auto ditr : itr.get_callchain())
+        {
+            if(_n == max_depth) break;
+            if(ditr >= PERF_CONTEXT_MAX) continue;
+            // skip the first instance of current IP but allow after that since this
+            // might be a recursive call
+            if(ditr == _ip && _skip_ip)
+                _skip_ip = false;
+            else
+                _addrs[_n++] = ditr;
+        }
+        std::reverse(_addrs.begin(), _addrs.begin() + _n);
+
+        auto _node = _state.tree->intern(_addrs.data(), _addrs.data() + _n);
+        if(_node == 0) continue;
+
+        if(_state.off_cpu)
+        {
+            // the callchain of the context-switch sample is where the thread will be
+            // (or was) switched out
+            _state.switch_node = _node;
+        }
+        else if(_state.cpu < 0)
+        {
+            _state.records.emplace_back(record{ _ts, _node, itr.get_cpu() });
+        }
+        else
+        {
+            auto _pid = static_cast<uint32_t>(itr.get_pid());
+            cache_command(_pid);
+            _state.cpu_records.emplace_back(
+                cpu_record{ _ts, _pid, static_cast<uint32_t>(itr.get_tid()), _node });
+        }
+    }
+}
+
+void
+drain_loop()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.perf.drain");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _events = std::array<struct epoll_event, drain_events>{};
+    while(!drain_stop.load(std::memory_order_acquire))
+    {
+        auto _n = epoll_wait(drain_epoll, _events.data(), _events.size(), drain_timeout);
+        if(_n < 0 && errno != EINTR)
+        {
+            OMNITRACE_VERBOSE(1, "[perf_sampler] epoll_wait failed: %s\n",
+                              strerror(errno));
+            break;
+        }
+        if(_n <= 0) continue;
+
+        std::unique_lock<std::mutex> _lk{ registry_mutex };
+        for(int i = 0; i < _n; ++i)
+        {
+            auto* _state = static_cast<source_state*>(_events.at(i).data.ptr);
+            drain(*_state);
+            // the thread of the perf_event has exited
+            if((_events.at(i).events & EPOLLHUP) != 0 && !_state->exited)
+            {
+                _state->exited = true;
+                epoll_ctl(drain_epoll, EPOLL_CTL_DEL, _state->event->get_fileno(),
+                          nullptr);
+            }
+        }
+    }
+}
+
+// lock must be held
+void
+watch(source_state& _state)
+{
+    std::call_once(drain_once, []() {
+        drain_epoll = epoll_create1(EPOLL_CLOEXEC);
+        if(drain_epoll < 0)
+        {
+            OMNITRACE_VERBOSE(0, "[perf_sampler] epoll_create1 failed: %s\n",
+                              strerror(errno));
+            return;
+        }
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        drain_thread = std::make_unique<std::thread>(&drain_loop);
+    });
+
+    // without the background thread, the records are only drained on shutdown and
+    // the ones which do not fit in the ring buffer are lost
+    if(drain_epoll < 0) return;
+
+    auto _event     = epoll_event{};
+    _event.events   = EPOLLIN;
+    _event.data.ptr = &_state;
+    epoll_ctl(drain_epoll, EPOLL_CTL_ADD, _state.event->get_fileno(), &_event);
+}
+
+std::unique_ptr<source_state>
+make_source(int64_t _cpu, double _freq, double _delay)
+{
+    auto _state    = std::make_unique<source_state>();
+    _state->cpu    = _cpu;
+    _state->period = std::max<uint64_t>((1.0 / _freq) * units::sec, 1);
+    _state->beg_ns = tracing::now() + static_cast<uint64_t>(_delay * units::sec);
+    _state->event  = std::make_unique<perf::perf_event>();
+    _state->tree   = std::make_unique<calling_context::tree>(
+        std::max<size_t>(config::get_sampling_cct_capacity(), 2));
+    return _state;
+}
+
+void
+report(int64_t _idx, const source_state& _state)
+{
+    auto _nrecords = (_state.off_cpu)  ? _state.off_cpu_records.size()
+                     : (_state.cpu < 0) ? _state.records.size()
+                                        : _state.cpu_records.size();
+    auto _label    = (_state.off_cpu)  ? "thread (off-CPU)"
+                     : (_state.cpu < 0) ? "thread"
+                                        : "CPU";
+    OMNITRACE_VERBOSE(2 || _state.lost > 0,
+                      "[perf_sampler] %s %li: %zu records, %zu lost records, %zu of %zu "
+                      "calling-context nodes...\n",
+                      _label, _idx, _nrecords, _state.lost, _state.tree->size(),
+                      _state.tree->capacity());
+}
+}  // namespace
+
+std::optional<std::string>
+start(int64_t _tid, pid_t _sys_tid, double _freq, double _delay)
+{
+    if(_freq <= 0.0) return std::string{ "sampling frequency must be positive" };
+
+    {
+        // re-enable the perf_event if sampling of the thread is restarted
+        std::unique_lock<std::mutex> _lk{ registry_mutex };
+        auto                         itr = thread_sources.find(_tid);
+        if(itr != thread_sources.end() && itr->second->event && !itr->second->exited)
+        {
+            restart_source(*itr->second);
+            return std::optional<std::string>{};
+        }
+    }
+
+    auto _state = make_source(-1, _freq, _delay);
+
+    struct perf_event_attr _pe;
+    memset(&_pe, 0, sizeof(_pe));
+
+    _pe.type                     = PERF_TYPE_SOFTWARE;
+    _pe.config                   = PERF_COUNT_SW_TASK_CLOCK;
+    _pe.sample_period            = _state->period;
+    _pe.sample_type              = sample_type | PERF_SAMPLE_CPU;
+    _pe.wakeup_events            = 4;
+    _pe.exclude_idle             = 1;
+    _pe.exclude_kernel           = 1;
+    _pe.exclude_hv               = 1;
+    _pe.exclude_callchain_kernel = 1;
+    _pe.disabled                 = 1;
+    _pe.inherit                  = 0;
+    _pe.use_clockid              = 1;
+    _pe.clockid                  = CLOCK_REALTIME;
+
+    // the kernel truncates the callchain (the innermost frames are kept)
+    if(auto _depth = config::get_sampling_max_depth(); _depth > 0)
+        _pe.sample_max_stack = std::min<size_t>(_depth, OMNITRACE_MAX_UNWIND_DEPTH);
+
+    if(auto _err = _state->event->open(_pe, _sys_tid); _err) return _err;
+    if(!_state->event->start()) return std::string{ "perf_event could not be enabled" };
+
+    _state->enabled = true;
+
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto&                        _source = thread_sources[_tid];
+    _source                              = std::move(_state);
+    if(sources_paused) pause_source(*_source);
+    watch(*_source);
+
+    return std::optional<std::string>{};
+}
+
+void
+stop(int64_t _tid)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    for(auto* _sources : { &thread_sources, &off_cpu_sources })
+    {
+        auto itr = _sources->find(_tid);
+        if(itr == _sources->end()) continue;
+        itr->second->paused = false;
+        if(!itr->second->enabled) continue;
+        if(itr->second->event && !itr->second->exited) itr->second->event->stop();
+        itr->second->enabled = false;
+    }
+}
+
+bool
+is_active(int64_t _tid)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    return (thread_sources.find(_tid) != thread_sources.end());
+}
+
+std::optional<std::string>
+start_off_cpu(int64_t _tid, pid_t _sys_tid)
+{
+    {
+        std::unique_lock<std::mutex> _lk{ registry_mutex };
+        auto                         itr = off_cpu_sources.find(_tid);
+        if(itr != off_cpu_sources.end() && itr->second->event && !itr->second->exited)
+        {
+            restart_source(*itr->second);
+            return std::optional<std::string>{};
+        }
+    }
+
+    auto _state     = make_source(-1, 1.0, 0.0);
+    _state->off_cpu = true;
+
+    // the context-switch samples are taken in the kernel so the sample (but not its
+    // callchain) must include the kernel. If that is not permitted, only the
+    // switch records are collected, i.e. the intervals have no call-stack
+    auto _open = [&_state, _sys_tid](bool _exclude_kernel) {
+        struct perf_event_attr _pe;
+        memset(&_pe, 0, sizeof(_pe));
+
+        _pe.type                     = PERF_TYPE_SOFTWARE;
+        _pe.config                   = PERF_COUNT_SW_CONTEXT_SWITCHES;
+        _pe.sample_period            = 1;
+        _pe.sample_type              = sample_type;
+        _pe.wakeup_events            = 16;
+        _pe.context_switch           = 1;
+        _pe.sample_id_all            = 1;
+        _pe.exclude_kernel           = (_exclude_kernel) ? 1 : 0;
+        _pe.exclude_hv               = 1;
+        _pe.exclude_callchain_kernel = 1;
+        _pe.disabled                 = 1;
+        _pe.inherit                  = 0;
+        _pe.use_clockid              = 1;
+        _pe.clockid                  = CLOCK_REALTIME;
+
+        _state->event = std::make_unique<perf::perf_event>();
+        return _state->event->open(_pe, _sys_tid);
+    };
+
+    if(auto _err = _open(false); _err)
+    {
+        OMNITRACE_VERBOSE(2,
+                          "[perf_sampler] off-CPU call-stacks are not available on "
+                          "thread %li: %s\n",
+                          _tid, _err->c_str());
+        if(auto _user_err = _open(true); _user_err) return _user_err;
+    }
+
+    if(!_state->event->start()) return std::string{ "perf_event could not be enabled" };
+
+    _state->enabled = true;
+
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto&                        _source = off_cpu_sources[_tid];
+    _source                              = std::move(_state);
+    if(sources_paused) pause_source(*_source);
+    watch(*_source);
+
+    return std::optional<std::string>{};
+}
+
+std::optional<std::string>
+start_cpus(const std::set<int64_t>& _cpus, double _freq)
+{
+    if(_freq <= 0.0) return std::string{ "sampling frequency must be positive" };
+    if(_cpus.empty()) return std::string{ "no CPUs were selected" };
+
+    auto _errors = std::stringstream{};
+    auto _opened = std::map<int64_t, std::unique_ptr<source_state>>{};
+    for(auto itr : _cpus)
+    {
+        auto _state = make_source(itr, _freq, 0.0);
+
+        struct perf_event_attr _pe;
+        memset(&_pe, 0, sizeof(_pe));
+
+        // the kernel portion of the callchain is kept so that the time spent in
+        // the kernel on behalf of any process is visible
+        _pe.type          = PERF_TYPE_SOFTWARE;
+        _pe.config        = PERF_COUNT_SW_CPU_CLOCK;
+        _pe.sample_period = _state->period;
+        _pe.sample_type   = sample_type | PERF_SAMPLE_TID;
+        _pe.wakeup_events = 16;
+        _pe.exclude_idle  = 1;
+        _pe.exclude_hv    = 1;
+        _pe.disabled      = 1;
+        _pe.inherit       = 0;
+        _pe.use_clockid   = 1;
+        _pe.clockid       = CLOCK_REALTIME;
+
+        if(auto _err = _state->event->open(_pe, -1, itr); _err)
+        {
+            _errors << "\n    CPU " << itr << ": " << *_err;
+            continue;
+        }
+
+        _opened.emplace(itr, std::move(_state));
+    }
+
+    if(_opened.empty())
+    {
+        return JOIN("", "no perf_event could be opened (system-wide sampling requires ",
+                    "/proc/sys/kernel/perf_event_paranoid <= 0 or CAP_PERFMON):",
+                    _errors.str());
+    }
+
+    if(!_errors.str().empty())
+        OMNITRACE_VERBOSE(0, "[perf_sampler] system-wide sampling is disabled on:%s\n",
+                          _errors.str().c_str());
+
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    cpu_period = _opened.begin()->second->period;
+    for(auto& itr : _opened)
+    {
+        auto& _source = cpu_sources[itr.first];
+        _source       = std::move(itr.second);
+        restart_source(*_source);
+        watch(*_source);
+    }
+
+    return std::optional<std::string>{};
+}
+
+void
+stop_cpus()
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    for(auto& itr : cpu_sources)
+    {
+        itr.second->paused = false;
+        if(!itr.second->enabled) continue;
+        if(itr.second->event) itr.second->event->stop();
+        itr.second->enabled = false;
+    }
+}
+
+void
+pause()
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    sources_paused = true;
+    for(auto* _sources : { &thread_sources, &cpu_sources, &off_cpu_sources })
+    {
+        for(auto& itr : *_sources)
+            pause_source(*itr.second);
+    }
+}
+
+void
+resume()
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    sources_paused = false;
+    for(auto* _sources : { &thread_sources, &cpu_sources, &off_cpu_sources })
+    {
+        for(auto& itr : *_sources)
+        {
+            auto& _state = *itr.second;
+            if(!_state.paused) continue;
+            _state.paused = false;
+            if(_state.event && !_state.exited) _state.enabled = _state.event->start();
+        }
+    }
+}
+
+void
+shutdown()
+{
+    drain_stop.store(true, std::memory_order_release);
+    if(drain_thread)
+    {
+        drain_thread->join();
+        drain_thread.reset();
+    }
+
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+
+    if(drain_epoll >= 0)
+    {
+        ::close(drain_epoll);
+        drain_epoll = -1;
+    }
+
+    for(auto* _sources : { &thread_sources, &cpu_sources, &off_cpu_sources })
+    {
+        for(auto& itr : *_sources)
+        {
+            auto& _state = *itr.second;
+            if(!_state.event) continue;
+
+            _state.event->stop();
+            drain(_state);
+            _state.event->close();
+            _state.event.reset();
+            _state.enabled = false;
+            _state.paused  = false;
+
+            std::sort(_state.records.begin(), _state.records.end(),
+                      [](const record& _lhs, const record& _rhs) {
+                          return _lhs.timestamp < _rhs.timestamp;
+                      });
+            std::sort(_state.cpu_records.begin(), _state.cpu_records.end(),
+                      [](const cpu_record& _lhs, const cpu_record& _rhs) {
+                          return _lhs.timestamp < _rhs.timestamp;
+                      });
+            std::sort(_state.off_cpu_records.begin(), _state.off_cpu_records.end(),
+                      [](const off_cpu_record& _lhs, const off_cpu_record& _rhs) {
+                          return _lhs.begin < _rhs.begin;
+                      });
+
+            report(itr.first, _state);
+        }
+    }
+}
+
+std::vector<record>
+get_records(int64_t _tid)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = thread_sources.find(_tid);
+    if(itr == thread_sources.end()) return std::vector<record>{};
+    return itr->second->records;
+}
+
+std::vector<uintptr_t>
+get_addresses(int64_t _tid, calling_context::node_id_t _node)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = thread_sources.find(_tid);
+    if(itr == thread_sources.end()) return std::vector<uintptr_t>{};
+    return itr->second->tree->get_addresses(_node);
+}
+
+uint64_t
+get_period(int64_t _tid)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = thread_sources.find(_tid);
+    return (itr == thread_sources.end()) ? 0 : itr->second->period;
+}
+
+std::set<int64_t>
+get_cpus()
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         _v = std::set<int64_t>{};
+    for(const auto& itr : cpu_sources)
+        _v.emplace(itr.first);
+    return _v;
+}
+
+std::vector<cpu_record>
+get_cpu_records(int64_t _cpu)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = cpu_sources.find(_cpu);
+    if(itr == cpu_sources.end()) return std::vector<cpu_record>{};
+    return itr->second->cpu_records;
+}
+
+std::vector<uintptr_t>
+get_cpu_addresses(int64_t _cpu, calling_context::node_id_t _node)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = cpu_sources.find(_cpu);
+    if(itr == cpu_sources.end()) return std::vector<uintptr_t>{};
+    return itr->second->tree->get_addresses(_node);
+}
+
+uint64_t
+get_cpu_period()
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    return cpu_period;
+}
+
+std::vector<off_cpu_record>
+get_off_cpu_records(int64_t _tid)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = off_cpu_sources.find(_tid);
+    if(itr == off_cpu_sources.end()) return std::vector<off_cpu_record>{};
+    return itr->second->off_cpu_records;
+}
+
+std::vector<uintptr_t>
+get_off_cpu_addresses(int64_t _tid, calling_context::node_id_t _node)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = off_cpu_sources.find(_tid);
+    if(itr == off_cpu_sources.end()) return std::vector<uintptr_t>{};
+    return itr->second->tree->get_addresses(_node);
+}
+
+std::string
+get_command(uint32_t _pid)
+{
+    std::unique_lock<std::mutex> _lk{ registry_mutex };
+    auto                         itr = commands.find(_pid);
+    return (itr == commands.end()) ? std::string{} : itr->second;
+}
+}  // namespace perf_sampler
+}  // namespace omnitrace
@@ -0,0 +1,155 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/defines.hpp"
+#include "library/calling_context.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace omnitrace
+{
+namespace perf_sampler
+{
+// CPU-time sampling with a perf_event task-clock per thread (OMNITRACE_SAMPLING_BACKEND
+// set to "perf"). The kernel records the user-space callchain of each sample into the
+// ring buffer of the perf_event and a single background thread drains the ring buffers
+// of all the threads, i.e. the sampled threads never take a signal for these samples.
+// The wall-clock sampler, if enabled, is unaffected
+struct record
+{
+    uint64_t                   timestamp = 0;
+    calling_context::node_id_t node      = 0;  // innermost frame in the thread's tree
+    uint32_t                   cpu       = 0;  // CPU the sample ran on
+};
+
+// opens and enables the perf_event of the calling thread. The samples taken within
+// the delay after the start are discarded. Returns an error message on failure
+std::optional<std::string>
+start(int64_t _tid, pid_t _sys_tid, double _freq, double _delay);
+
+// disables the perf_events of the thread. The pending records are drained on shutdown
+void
+stop(int64_t _tid);
+
+// whether the perf_event of the thread was opened
+bool
+is_active(int64_t _tid);
+
+// disables the enabled perf_events of all the threads and CPUs while outside of the
+// trace windows. The perf_events opened while paused are not enabled until resume()
+void
+pause();
+
+void
+resume();
+
+// drains the remaining records, closes the perf_events, and stops the background thread
+void
+shutdown();
+
+// the drained samples of the thread (ordered by time) and the addresses of each
+// call-stack, outermost frame first. Only valid after shutdown
+std::vector<record>
+get_records(int64_t _tid);
+
+std::vector<uintptr_t>
+get_addresses(int64_t _tid, calling_context::node_id_t);
+
+// sampling period in nanoseconds
+uint64_t
+get_period(int64_t _tid);
+
+// system-wide sampling (OMNITRACE_SAMPLING_SYSTEM_WIDE): a perf_event per CPU samples
+// every process which runs on the CPU, including the kernel, to identify the
+// interference from other processes and the OS. The ring buffers are drained by the
+// same background thread as the per-thread perf_events
+struct cpu_record
+{
+    uint64_t                   timestamp = 0;
+    uint32_t                   pid       = 0;
+    uint32_t                   tid       = 0;
+    calling_context::node_id_t node      = 0;  // innermost frame in the CPU's tree
+};
+
+// opens and enables a perf_event on each of the CPUs. Returns an error message if
+// none of the perf_events could be opened
+std::optional<std::string>
+start_cpus(const std::set<int64_t>& _cpus, double _freq);
+
+void
+stop_cpus();
+
+// the CPUs with an opened perf_event
+std::set<int64_t>
+get_cpus();
+
+// the drained samples of the CPU (ordered by time) and the addresses of each
+// call-stack, outermost frame first. Only valid after shutdown
+std::vector<cpu_record>
+get_cpu_records(int64_t _cpu);
+
+std::vector<uintptr_t>
+get_cpu_addresses(int64_t _cpu, calling_context::node_id_t);
+
+// sampling period of the CPUs in nanoseconds
+uint64_t
+get_cpu_period();
+
+// the command name of the process when it was first sampled
+std::string
+get_command(uint32_t _pid);
+
+// off-CPU tracing (OMNITRACE_SAMPLING_OFF_CPU): a context-switch perf_event per thread
+// samples the callchain where the thread is switched out and the switch records
+// provide the times at which the thread left and re-entered the CPU. No code is
+// executed by the thread when it blocks
+struct off_cpu_record
+{
+    uint64_t                   begin     = 0;
+    uint64_t                   end       = 0;
+    bool                       preempted = false;  // runnable, otherwise blocked
+    calling_context::node_id_t node      = 0;      // zero if there was no callchain
+};
+
+// opens and enables the context-switch perf_event of the calling thread. Returns
+// an error message on failure. The perf_event is disabled by stop(_tid)
+std::optional<std::string>
+start_off_cpu(int64_t _tid, pid_t _sys_tid);
+
+// the off-CPU intervals of the thread (ordered by time) and the addresses of the
+// call-stack where the thread was switched out. Only valid after shutdown
+std::vector<off_cpu_record>
+get_off_cpu_records(int64_t _tid);
+
+std::vector<uintptr_t>
+get_off_cpu_addresses(int64_t _tid, calling_context::node_id_t);
+}  // namespace perf_sampler
+}  // namespace omnitrace
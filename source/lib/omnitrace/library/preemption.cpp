@@ -0,0 +1,250 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/preemption.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto_fwd.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+#include "library/runtime.hpp"
+#include "library/sampling.hpp"
+#include "library/thread_info.hpp"
+
+#include <timemory/signals/signal_mask.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+
+namespace omnitrace
+{
+namespace preemption
+{
+namespace
+{
+constexpr char trigger_byte  = 'p';
+constexpr char shutdown_byte = 'q';
+
+std::atomic<bool> active        = { false };
+int               signal_num    = 0;
+int               pipe_fds[2]   = { -1, -1 };
+struct sigaction  former_action = {};
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+void
+write_byte(char _v)
+{
+    auto _errno = errno;  // preserve errno for the interrupted code
+    while(::write(pipe_fds[1], &_v, 1) < 0 && errno == EINTR)
+    {}
+    errno = _errno;
+}
+
+void
+signal_handler(int)
+{
+    if(active.load(std::memory_order_relaxed)) write_byte(trigger_byte);
+}
+
+// writes the data which cannot be reconstructed after the process exits. The
+// post-processing of the samples is deferred to omnitrace-post
+void
+flush()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.preempt.fl");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    sampling::block_samples();
+    tim::signals::block_signals(get_sampling_signals(),
+                                tim::signals::sigmask_scope::process);
+    thread_info::set_stop(comp::wall_clock::record());
+
+    if(get_use_sampling())
+    {
+        config::set_setting_value("OMNITRACE_DEFER_POST_PROCESSING", true);
+        sampling::post_process();
+    }
+
+    if(get_use_perfetto())
+    {
+        // the combined trace is collective over the ranks, which are not necessarily
+        // preempted at the same time
+        config::set_setting_value("OMNITRACE_PERFETTO_COMBINE_TRACES", false);
+        auto _perfetto_output_error = false;
+        perfetto::post_process(nullptr, _perfetto_output_error);
+    }
+}
+
+void
+run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.preempt");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    char _v = 0;
+    while(true)
+    {
+        auto _n = ::read(pipe_fds[0], &_v, 1);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0 || _v == shutdown_byte) return;
+        if(_v == trigger_byte) break;
+    }
+
+    // the finalization has started (and will complete) before the signal was handled
+    if(get_state() != State::Active)
+    {
+        OMNITRACE_VERBOSE(1, "[preemption] signal %i received during finalization...\n",
+                          signal_num);
+        return;
+    }
+
+    // the finalization is skipped when the main thread exits during the flush
+    set_state(State::Finalized);
+
+    auto _deadline = std::max(config::get_preemption_deadline(), 0.0);
+    OMNITRACE_VERBOSE(0,
+                      "[preemption] signal %i received. Writing the raw data "
+                      "(deadline: %.3f sec)...\n",
+                      signal_num, _deadline);
+
+    // the flush is abandoned when the deadline expires. It holds no resources
+    // which need to be released since the process is terminated
+    auto _task   = std::packaged_task<void()>{ &flush };
+    auto _future = _task.get_future();
+    {
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        std::thread{ std::move(_task) }.detach();
+    }
+
+    auto _timeout = std::chrono::duration<double>{ _deadline };
+    if(_future.wait_for(_timeout) != std::future_status::ready)
+    {
+        OMNITRACE_VERBOSE(0,
+                          "[preemption] the raw data was not written within "
+                          "%.3f sec...\n",
+                          _deadline);
+    }
+    else
+    {
+        OMNITRACE_VERBOSE(0, "[preemption] run omnitrace-post on the raw-samples "
+                             "file to generate the sampling output\n");
+    }
+
+    // terminate with the default action of the signal, e.g. the exit status expected
+    // by the scheduler
+    struct sigaction _action = {};
+    sigemptyset(&_action.sa_mask);
+    _action.sa_handler = SIG_DFL;
+    sigaction(signal_num, &_action, nullptr);
+
+    sigset_t _mask;
+    sigemptyset(&_mask);
+    sigaddset(&_mask, signal_num);
+    pthread_sigmask(SIG_UNBLOCK, &_mask, nullptr);
+    ::kill(::getpid(), signal_num);
+}
+}  // namespace
+
+bool
+is_active()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+void
+setup()
+{
+    if(!config::get_preemption_flush() || get_thread()) return;
+
+    signal_num = config::get_preemption_signal();
+    if(signal_num <= 0) return;
+
+    if(::pipe(pipe_fds) != 0)
+    {
+        OMNITRACE_VERBOSE(0, "[preemption] pipe failed: %s\n", strerror(errno));
+        return;
+    }
+
+    {
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        get_thread() = std::make_unique<std::thread>(&run);
+    }
+
+    struct sigaction _action = {};
+    sigemptyset(&_action.sa_mask);
+    _action.sa_flags   = SA_RESTART;
+    _action.sa_handler = &signal_handler;
+    if(sigaction(signal_num, &_action, &former_action) != 0)
+    {
+        OMNITRACE_VERBOSE(0, "[preemption] sigaction(%i) failed: %s\n", signal_num,
+                          strerror(errno));
+        write_byte(shutdown_byte);
+        get_thread()->join();
+        get_thread().reset();
+        ::close(pipe_fds[0]);
+        ::close(pipe_fds[1]);
+        pipe_fds[0] = pipe_fds[1] = -1;
+        return;
+    }
+
+    OMNITRACE_VERBOSE(1, "[preemption] flushing the raw data on signal %i...\n",
+                      signal_num);
+
+    active.store(true, std::memory_order_release);
+}
+
+void
+shutdown()
+{
+    if(!get_thread()) return;
+
+    active.store(false, std::memory_order_release);
+    sigaction(signal_num, &former_action, nullptr);
+
+    write_byte(shutdown_byte);
+    get_thread()->join();
+    get_thread().reset();
+
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+    pipe_fds[0] = pipe_fds[1] = -1;
+}
+}  // namespace preemption
+}  // namespace omnitrace
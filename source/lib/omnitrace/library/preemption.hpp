@@ -0,0 +1,45 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace omnitrace
+{
+// preemption mode (OMNITRACE_PREEMPTION_FLUSH): when a batch scheduler preempts the job
+// with OMNITRACE_PREEMPTION_SIGNAL and a short grace period, the full finalization
+// would not complete. The signal handler only writes a byte into a pipe
+// (async-signal-safe) and a background thread stops the samplers and writes the
+// perfetto trace and the raw samples for omnitrace-post. The signal is re-raised with
+// the default action when the data is written or OMNITRACE_PREEMPTION_DEADLINE expires,
+// whichever comes first.
+namespace preemption
+{
+bool
+is_active();
+
+void
+setup();
+
+void
+shutdown();
+}  // namespace preemption
+}  // namespace omnitrace
@@ -23,11 +23,32 @@
 #include "library/process_sampler.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
+#include "library/components/cpu_freq.hpp"
+#include "library/components/heap_profiler.hpp"
+#include "library/cgroup.hpp"
+#include "library/components/roctracer.hpp"
+#include "library/cpu_energy.hpp"
 #include "library/cpu_freq.hpp"
+#include "library/memory_bandwidth.hpp"
+#include "library/network.hpp"
 #include "library/rocm_smi.hpp"
 #include "library/runtime.hpp"
+#include "library/self_overhead.hpp"
+#include "library/tracing.hpp"
 
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <fstream>
 #include <memory>
+#include <sstream>
+#include <sys/file.h>
+#include <unistd.h>
+#include <utility>
 #include <vector>
 
 namespace omnitrace
@@ -67,8 +88,115 @@ get_sampler_is_sampling()
     static std::atomic<bool> _v{ false };
     return _v;
 }
+
+// wall-clock timestamp and number of deadlines skipped
+auto&
+get_missed_ticks()
+{
+    static auto _v = std::vector<std::pair<uint64_t, uint64_t>>{};
+    return _v;
+}
+
+constexpr int64_t nsec_per_sec = std::nano::den;
+
+int64_t
+monotonic_now()
+{
+    struct timespec _ts = {};
+    clock_gettime(CLOCK_MONOTONIC, &_ts);
+    return (_ts.tv_sec * nsec_per_sec) + _ts.tv_nsec;
+}
+
+void
+monotonic_sleep_until(int64_t _deadline)
+{
+    struct timespec _ts = {};
+    _ts.tv_sec          = _deadline / nsec_per_sec;
+    _ts.tv_nsec         = _deadline % nsec_per_sec;
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &_ts, nullptr) == EINTR)
+    {}
+}
+
+// elects the process which samples the system-wide metrics of the node. The elected
+// process holds an exclusive lock on the file until it exits (the kernel releases the
+// lock if the process crashes). The processes launched by the same daemon on a node
+// share the parent process so the lock file is keyed by it
+bool
+is_node_sampler()
+{
+    if(!config::get_process_sampling_per_node()) return true;
+
+    static int  _fd = -1;
+    static bool _v  = []() {
+        auto _key   = tim::get_env<std::string>("OMNITRACE_PROCESS_SAMPLING_NODE_KEY",
+                                              std::to_string(getppid()));
+        auto _fname = JOIN('/', config::get_tmpdir(),
+                           JOIN("", "omnitrace-node-sampler-", _key, ".lock"));
+
+        // creates the directory if necessary
+        if(!tim::filepath::exists(_fname))
+        {
+            std::ofstream _ofs{};
+            tim::filepath::open(_ofs, _fname);
+        }
+
+        _fd = ::open(_fname.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if(_fd < 0)
+        {
+            OMNITRACE_VERBOSE(1,
+                              "Unable to open the node sampling lock file '%s'. This "
+                              "process samples the system-wide metrics...\n",
+                              _fname.c_str());
+            return true;
+        }
+
+        if(flock(_fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            ::close(_fd);
+            _fd = -1;
+            OMNITRACE_VERBOSE(1, "System-wide metrics are sampled by another process on "
+                                 "this node...\n");
+            return false;
+        }
+        return true;
+    }();
+    return _v;
+}
 }  // namespace
 
+void
+cost_histogram::record(uint64_t _nsec)
+{
+    size_t _bin = 0;
+    for(auto _usec = _nsec / units::usec; _usec > 0 && _bin + 1 < num_bins; _usec >>= 1)
+        ++_bin;
+
+    ++count;
+    ++bins.at(_bin);
+    total += _nsec;
+    max = std::max(max, _nsec);
+}
+
+std::string
+cost_histogram::as_string() const
+{
+    auto _to_usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+
+    std::stringstream _ss{};
+    _ss.setf(std::ios::fixed);
+    _ss.precision(3);
+    _ss << "samples = " << count << ", mean = "
+        << _to_usec(total / std::max<uint64_t>(count, 1)) << " usec, max = "
+        << _to_usec(max) << " usec, histogram = {";
+    for(size_t i = 0; i < num_bins; ++i)
+    {
+        if(bins.at(i) == 0) continue;
+        _ss << " <" << (1UL << i) << "us:" << bins.at(i);
+    }
+    _ss << " }";
+    return _ss.str();
+}
+
 void
 sampler::poll(std::atomic<State>* _state, nsec_t _interval, promise_t* _ready)
 {
@@ -90,22 +218,48 @@ sampler::poll(std::atomic<State>* _state, nsec_t _interval, promise_t* _ready)
     auto _duration = config::get_process_sampling_duration();
     if(_duration < 0.0) _duration = config::get_sampling_duration();
     bool _has_duration = (_duration > 0.0);
-
-    auto _now = std::chrono::steady_clock::now();
-    auto _end =
-        _now + std::chrono::nanoseconds{ static_cast<uint64_t>(_duration * units::sec) };
+    bool _fixed_rate   = config::get_process_sampling_fixed_rate();
+
+    // with a fixed rate, deadlines are absolute and advanced by the period so the
+    // period is independent of the time spent sampling. Otherwise, the next deadline
+    // is computed from when the previous sample completed.
+    const int64_t _period = _interval.count();
+    auto          _now    = monotonic_now();
+    auto          _end    = _now + static_cast<int64_t>(_duration * nsec_per_sec);
     while(_state && _state->load() < State::Finalized && get_state() < State::Finalized)
     {
-        std::this_thread::sleep_until(_now);
-        if(_state->load() != State::Active) continue;
-        if(get_state() >= State::Finalized) break;
-        if(get_state() != State::Active) continue;
+        monotonic_sleep_until(_now);
+        if(_state->load() != State::Active || get_state() != State::Active)
+        {
+            if(get_state() >= State::Finalized) break;
+            _now = monotonic_now() + _period;
+            continue;
+        }
         get_sampler_is_sampling().store(true);
         for(auto& itr : instances)
+        {
+            auto _beg = monotonic_now();
             itr->sample();
+            itr->cost.record(monotonic_now() - _beg);
+        }
         get_sampler_is_sampling().store(false);
         if(_has_duration && _now >= _end) break;
-        _now = std::chrono::steady_clock::now() + _interval;
+
+        auto _done = monotonic_now();
+        if(_fixed_rate)
+        {
+            _now += _period;
+            if(_now <= _done)
+            {
+                auto _nmissed = ((_done - _now) / _period) + 1;
+                _now += _nmissed * _period;
+                get_missed_ticks().emplace_back(tracing::now(), _nmissed);
+            }
+        }
+        else
+        {
+            _now = _done + _period;
+        }
     }
 
     // ensure this is always false
@@ -140,9 +294,12 @@ sampler::setup()
     // shutdown if already running
     shutdown();
 
-    if(get_use_rocm_smi())
+    auto _node_sampler = is_node_sampler();
+
+    if(get_use_rocm_smi() && _node_sampler)
     {
         auto& _rocm_smi         = instances.emplace_back(std::make_unique<instance>());
+        _rocm_smi->name         = "rocm-smi";
         _rocm_smi->setup        = []() { rocm_smi::setup(); };
         _rocm_smi->shutdown     = []() { rocm_smi::shutdown(); };
         _rocm_smi->post_process = []() { rocm_smi::post_process(); };
@@ -150,11 +307,84 @@ sampler::setup()
         _rocm_smi->sample       = []() { rocm_smi::sample(); };
     }
 
+    if(get_use_roctracer())
+    {
+        // periodic resynchronization of the CPU and roctracer clocks
+        auto& _roctracer   = instances.emplace_back(std::make_unique<instance>());
+        _roctracer->name   = "roctracer-clock";
+        _roctracer->sample = []() { component::roctracer::sync_clock(); };
+    }
+
+    if(self_overhead::is_enabled())
+    {
+        auto& _self_overhead   = instances.emplace_back(std::make_unique<instance>());
+        _self_overhead->name   = "self-overhead";
+        _self_overhead->sample = []() { self_overhead::sample(); };
+    }
+
+    if(config::get_heap_profile())
+    {
+        auto& _heap_profile   = instances.emplace_back(std::make_unique<instance>());
+        _heap_profile->name   = "heap-profile";
+        _heap_profile->sample = []() { component::heap_profiler::sample(); };
+    }
+
+    if(config::get_process_sampling_network() && _node_sampler)
+    {
+        auto& _network         = instances.emplace_back(std::make_unique<instance>());
+        _network->name         = "network";
+        _network->setup        = []() { network::setup(); };
+        _network->shutdown     = []() { network::shutdown(); };
+        _network->post_process = []() { network::post_process(); };
+        _network->config       = []() { network::config(); };
+        _network->sample       = []() { network::sample(); };
+    }
+
+    // every process samples the energy since it is attributed to its regions
+    if(config::get_process_sampling_cpu_energy())
+    {
+        auto& _cpu_energy         = instances.emplace_back(std::make_unique<instance>());
+        _cpu_energy->name         = "cpu-energy";
+        _cpu_energy->setup        = []() { cpu_energy::setup(); };
+        _cpu_energy->shutdown     = []() { cpu_energy::shutdown(); };
+        _cpu_energy->post_process = []() { cpu_energy::post_process(); };
+        _cpu_energy->config       = []() { cpu_energy::config(); };
+        _cpu_energy->sample       = []() { cpu_energy::sample(); };
+    }
+
+    // every process samples the bandwidth since it is attributed to its regions
+    if(config::get_process_sampling_memory_bandwidth())
+    {
+        auto& _bandwidth         = instances.emplace_back(std::make_unique<instance>());
+        _bandwidth->name         = "memory-bandwidth";
+        _bandwidth->setup        = []() { memory_bandwidth::setup(); };
+        _bandwidth->shutdown     = []() { memory_bandwidth::shutdown(); };
+        _bandwidth->post_process = []() { memory_bandwidth::post_process(); };
+        _bandwidth->config       = []() { memory_bandwidth::config(); };
+        _bandwidth->sample       = []() { memory_bandwidth::sample(); };
+    }
+
+    // the processes of a job may be in different cgroups (e.g. one container per rank)
+    if(config::get_process_sampling_cgroup())
+    {
+        auto& _cgroup         = instances.emplace_back(std::make_unique<instance>());
+        _cgroup->name         = "cgroup";
+        _cgroup->setup        = []() { cgroup::setup(); };
+        _cgroup->shutdown     = []() { cgroup::shutdown(); };
+        _cgroup->post_process = []() { cgroup::post_process(); };
+        _cgroup->config       = []() { cgroup::config(); };
+        _cgroup->sample       = []() { cgroup::sample(); };
+    }
+
     auto& _cpu_freq         = instances.emplace_back(std::make_unique<instance>());
+    _cpu_freq->name         = "cpu-freq";
     _cpu_freq->setup        = []() { cpu_freq::setup(); };
     _cpu_freq->shutdown     = []() { cpu_freq::shutdown(); };
     _cpu_freq->post_process = []() { cpu_freq::post_process(); };
-    _cpu_freq->config       = []() { cpu_freq::config(); };
+    _cpu_freq->config       = [_node_sampler]() {
+        cpu_freq::config();
+        if(!_node_sampler) component::cpu_freq::get_enabled_cpus().clear();
+    };
     _cpu_freq->sample       = []() { cpu_freq::sample(); };
 
     for(auto& itr : instances)
@@ -223,12 +453,53 @@ sampler::shutdown()
     is_initialized() = false;
 }
 
+void
+sampler::release()
+{
+    // the thread does not exist in a child process so it can not be joined and the
+    // samples belong to the parent
+    set_state(State::Finalized);
+    (void) get_thread().release();
+    (void) polling_finished.release();
+    instances.clear();
+    get_missed_ticks().clear();
+    is_initialized() = false;
+}
+
 void
 sampler::post_process()
 {
     for(auto& itr : instances)
+    {
+        OMNITRACE_VERBOSE(1, "Background sampler cost for %s :: %s\n", itr->name.c_str(),
+                          itr->cost.as_string().c_str());
         itr->post_process();
+    }
+
+    auto& _missed = get_missed_ticks();
+    if(!_missed.empty())
+    {
+        uint64_t _nmissed = 0;
+        for(const auto& itr : _missed)
+            _nmissed += itr.second;
+
+        OMNITRACE_VERBOSE(1, "Background sampler missed %lu deadlines (%zu overruns)\n",
+                          _nmissed, _missed.size());
+
+        if(get_use_perfetto())
+        {
+            auto _track = tracing::get_perfetto_track(
+                category::process_sampling{},
+                []() { return std::string{ "Process Sampler (S)" }; });
+
+            for(const auto& itr : _missed)
+                tracing::mark_perfetto_track(category::process_sampling{},
+                                             "missed_deadlines", _track, itr.first,
+                                             "count", itr.second);
+        }
+    }
 
+    _missed.clear();
     instances.clear();
 }
 
@@ -28,12 +28,14 @@
 #include "core/state.hpp"
 #include "library/thread_data.hpp"
 
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
 #include <functional>
 #include <future>
 #include <memory>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -41,8 +43,25 @@ namespace omnitrace
 {
 namespace process_sampler
 {
+// log2 histogram of the time spent in an instance's sample function. Bin N holds the
+// samples which took [2^(N-1), 2^N) microseconds, bin 0 holds everything under 1 usec
+struct cost_histogram
+{
+    static constexpr size_t num_bins = 24;
+
+    void        record(uint64_t _nsec);
+    std::string as_string() const;
+
+    uint64_t                       count = 0;
+    uint64_t                       total = 0;  // nsec
+    uint64_t                       max   = 0;  // nsec
+    std::array<uint64_t, num_bins> bins  = {};
+};
+//
 struct instance
 {
+    std::string           name         = {};
+    cost_histogram        cost         = {};
     std::function<void()> setup        = []() {};
     std::function<void()> shutdown     = []() {};
     std::function<void()> config       = []() {};
@@ -67,6 +86,7 @@ struct sampler
 
     static void setup();
     static void shutdown();
+    static void release();
     static void post_process();
     static void set_state(state_t);
     static void poll(std::atomic<state_t>* _state, nsec_t _interval, promise_t*);
@@ -98,6 +118,13 @@ post_process()
 {
     sampler::post_process();
 }
+
+// forgets the sampler thread of the parent in a child created by fork()
+inline void
+release()
+{
+    sampler::release();
+}
 //
 }  // namespace process_sampler
 }  // namespace omnitrace
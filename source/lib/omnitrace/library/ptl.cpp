@@ -25,6 +25,7 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/state.hpp"
+#include "core/utility.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
@@ -35,6 +36,16 @@
 
 #include <timemory/backends/threading.hpp>
 #include <timemory/utility/declaration.hpp>
+#include <timemory/utility/join.hpp>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/types.h>
+
+#include <cstdlib>
+#include <set>
+#include <string>
 
 namespace omnitrace
 {
@@ -42,7 +53,114 @@ namespace tasking
 {
 namespace
 {
-auto _thread_pool_cfg = []() {
+// the pool of the latency-sensitive work during the execution (e.g. the roctracer
+// callbacks) and the pool of the bulk post-processing. Each pool has its own
+// work-stealing task queue so that the post-processing never delays the callbacks
+struct callback_pool
+{
+    static constexpr auto label = "ptl";
+};
+
+struct bulk_pool
+{
+    static constexpr auto label = "ptl.bulk";
+};
+
+std::set<int64_t>
+get_affinity(pid_t _tid)
+{
+    auto _v   = std::set<int64_t>{};
+    auto _set = cpu_set_t{};
+    CPU_ZERO(&_set);
+    if(sched_getaffinity(_tid, sizeof(_set), &_set) != 0) return _v;
+    for(int i = 0; i < CPU_SETSIZE; ++i)
+        if(CPU_ISSET(i, &_set)) _v.emplace(i);
+    return _v;
+}
+
+// the CPUs of the process cpuset which are not claimed by the application threads
+// pinned to a subset of the cpuset (e.g. OMP_PROC_BIND or the binding of the ranks)
+std::set<int64_t>
+get_spare_cpus(const std::set<int64_t>& _allowed)
+{
+    auto  _claimed = std::set<int64_t>{};
+    auto* _dir     = opendir("/proc/self/task");
+    if(!_dir) return _allowed;
+    while(auto* _entry = readdir(_dir))
+    {
+        auto _tid = atoi(_entry->d_name);
+        if(_tid <= 0) continue;
+        auto _cpus = get_affinity(_tid);
+        if(!_cpus.empty() && _cpus.size() < _allowed.size())
+            _claimed.insert(_cpus.begin(), _cpus.end());
+    }
+    closedir(_dir);
+
+    auto _v = std::set<int64_t>{};
+    for(auto itr : _allowed)
+        if(_claimed.count(itr) == 0) _v.emplace(itr);
+    return _v;
+}
+
+// an empty set means the threads are not restricted
+std::set<int64_t>
+get_thread_pool_cpus()
+{
+    auto _mode = (config::settings_are_configured())
+                     ? config::get_thread_pool_affinity()
+                     : get_env<std::string>("OMNITRACE_THREAD_POOL_AFFINITY", "none");
+    if(_mode.empty() || _mode == "none") return std::set<int64_t>{};
+
+    auto _allowed = get_affinity(process::get_id());
+    auto _v       = std::set<int64_t>{};
+    if(_mode == "auto")
+    {
+        _v = get_spare_cpus(_allowed);
+    }
+    else
+    {
+        for(auto itr : utility::parse_numeric_range<>(_mode, "CPUs", 1L))
+            if(_allowed.count(itr) > 0) _v.emplace(itr);
+    }
+
+    if(_v.empty())
+    {
+        OMNITRACE_VERBOSE_F(1,
+                            "No spare CPUs for the thread-pool (%s). The threads are "
+                            "not restricted\n",
+                            _mode.c_str());
+        return _v;
+    }
+    else if(_v.size() == _allowed.size())
+    {
+        return std::set<int64_t>{};
+    }
+
+    OMNITRACE_VERBOSE_F(
+        1, "Thread-pool affinity (%s): %s\n", _mode.c_str(),
+        timemory::join::join(timemory::join::array_config{ ", ", "", "" }, _v).c_str());
+    return _v;
+}
+
+void
+set_thread_pool_affinity()
+{
+    static const auto _cpus = get_thread_pool_cpus();
+    if(_cpus.empty()) return;
+
+    auto _set = cpu_set_t{};
+    CPU_ZERO(&_set);
+    for(auto itr : _cpus)
+        CPU_SET(itr, &_set);
+    if(pthread_setaffinity_np(pthread_self(), sizeof(_set), &_set) != 0)
+        OMNITRACE_VERBOSE_F(1, "Failed to set the affinity of thread-pool thread %li\n",
+                            PTL::Threading::GetThreadId());
+}
+
+template <typename Tp>
+auto
+thread_pool_cfg()
+{
     int64_t _nthreads = 0;
     if(config::settings_are_configured())
     {
@@ -69,23 +187,25 @@ auto _thread_pool_cfg = []() {
 
     PTL::ThreadPool::Config _v{};
     _v.init         = true;
-    _v.use_affinity = false;
+    _v.use_affinity = false;  // PTL pins each thread to a single CPU
     _v.use_tbb      = false;
     _v.verbose      = -1;
     _v.initializer  = []() {
         thread_info::init(true);
         threading::set_thread_name(
-            JOIN('.', "ptl", PTL::Threading::GetThreadId()).c_str());
+            JOIN('.', Tp::label, PTL::Threading::GetThreadId()).c_str());
         set_thread_state(ThreadState::Disabled);
         sampling::block_signals();
+        set_thread_pool_affinity();
     };
     _v.finalizer  = []() {};
     _v.priority   = 5;
     _v.pool_size  = _nthreads;
     _v.task_queue = _task_queue;
     return _v;
-};
+}
 
+template <typename Tp>
 auto&
 get_thread_pool_state()
 {
@@ -93,14 +213,40 @@ get_thread_pool_state()
     return _v;
 }
 
+template <typename Tp>
+PTL::ThreadPool*
+create_thread_pool()
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    static auto _cfg            = thread_pool_cfg<Tp>();
+    get_thread_pool_state<Tp>() = State::Active;
+    return new PTL::ThreadPool{ _cfg };
+}
+
+template <typename Tp>
 PTL::ThreadPool&
 get_thread_pool()
 {
-    static auto  _cfg = _thread_pool_cfg();
-    static auto* _v =
-        (get_thread_pool_state() = State::Active, new PTL::ThreadPool{ _cfg });
+    static auto* _v = create_thread_pool<Tp>();
     return *_v;
 }
+
+template <typename Tp>
+void
+destroy_thread_pool()
+{
+    if(get_thread_pool_state<Tp>() == State::Active)
+    {
+        OMNITRACE_DEBUG_F("Destroying the omnitrace %s thread pool...\n", Tp::label);
+        get_thread_pool<Tp>().destroy_threadpool();
+        get_thread_pool_state<Tp>() = State::Finalized;
+    }
+    else
+    {
+        OMNITRACE_DEBUG_F("%s thread-pool is not active...\n", Tp::label);
+    }
+}
 }  // namespace
 
 namespace general
@@ -129,12 +275,24 @@ get_thread_pool_state()
 }  // namespace
 }  // namespace roctracer
 
+namespace finalize
+{
+namespace
+{
+auto&
+get_thread_pool_state()
+{
+    static auto _v = State::PreInit;
+    return _v;
+}
+}  // namespace
+}  // namespace finalize
+
 void
 setup()
 {
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
-    (void) get_thread_pool();
+    // the bulk pool is created when the post-processing is first dispatched
+    (void) get_thread_pool<callback_pool>();
 }
 
 void
@@ -190,22 +348,23 @@ shutdown()
         general::get_thread_pool_state() = State::Finalized;
     }
 
-    if(get_thread_pool_state() == State::Active)
+    if(finalize::get_thread_pool_state() == State::Active)
     {
-        OMNITRACE_DEBUG_F("Destroying the omnitrace thread pool...\n");
-        get_thread_pool().destroy_threadpool();
-        get_thread_pool_state() = State::Finalized;
-    }
-    else
-    {
-        OMNITRACE_DEBUG_F("thread-pool is not active...\n");
+        OMNITRACE_DEBUG_F("Waiting on completion of finalization tasks...\n");
+        finalize::get_task_group().join();
+        finalize::get_task_group().clear();
+        finalize::get_task_group().set_pool(nullptr);
+        finalize::get_thread_pool_state() = State::Finalized;
     }
+
+    destroy_thread_pool<callback_pool>();
+    destroy_thread_pool<bulk_pool>();
 }
 
 size_t
 initialize_threadpool(size_t _v)
 {
-    return get_thread_pool().initialize_threadpool(_v);
+    return get_thread_pool<callback_pool>().initialize_threadpool(_v);
 }
 
 PTL::TaskGroup<void>&
@@ -213,9 +372,9 @@ general::get_task_group(int64_t _tid)
 {
     struct local
     {};
-    using thread_data_t = thread_data<PTL::TaskGroup<void>, local>;
-    static thread_local auto& _v =
-        thread_data_t::instance(construct_on_thread{ _tid }, &tasking::get_thread_pool());
+    using thread_data_t          = thread_data<PTL::TaskGroup<void>, local>;
+    static thread_local auto& _v = thread_data_t::instance(construct_on_thread{ _tid },
+                                                           &get_thread_pool<bulk_pool>());
     return *_v;
 }
 
@@ -226,8 +385,17 @@ roctracer::get_task_group(int64_t _tid)
     {};
     using thread_data_t          = thread_data<PTL::TaskGroup<void>, local>;
     static thread_local auto& _v = (roctracer::get_thread_pool_state() = State::Active,
-                                    thread_data_t::instance(construct_on_thread{ _tid },
-                                                            &tasking::get_thread_pool()));
+                                    thread_data_t::instance(
+                                        construct_on_thread{ _tid },
+                                        &get_thread_pool<callback_pool>()));
+    return *_v;
+}
+
+PTL::TaskGroup<void>&
+finalize::get_task_group()
+{
+    static auto* _v = (finalize::get_thread_pool_state() = State::Active,
+                       new PTL::TaskGroup<void>{ &get_thread_pool<bulk_pool>() });
     return *_v;
 }
 }  // namespace tasking
@@ -50,6 +50,7 @@ size_t initialize_threadpool(size_t);
 //
 //--------------------------------------------------------------------------------------//
 
+// post-processing tasks (executed by the bulk thread-pool)
 namespace general
 {
 PTL::TaskGroup<void>&
@@ -62,10 +63,25 @@ get_task_group(int64_t _tid = utility::get_thread_index());
 //
 //--------------------------------------------------------------------------------------//
 
+// latency-sensitive callback tasks (executed by the callback thread-pool)
 namespace roctracer
 {
 PTL::TaskGroup<void>&
 get_task_group(int64_t _tid = utility::get_thread_index());
 }  // namespace roctracer
+
+//--------------------------------------------------------------------------------------//
+//
+//      finalize
+//
+//--------------------------------------------------------------------------------------//
+
+namespace finalize
+{
+// shared by the post-processing stages of omnitrace_finalize which run concurrently
+// with the stages on the finalizing thread (executed by the bulk thread-pool)
+PTL::TaskGroup<void>&
+get_task_group();
+}  // namespace finalize
 }  // namespace tasking
 }  // namespace omnitrace
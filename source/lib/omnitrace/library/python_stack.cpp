@@ -0,0 +1,171 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/python_stack.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "omnitrace/api.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string_view>
+
+namespace omnitrace
+{
+namespace python_stack
+{
+namespace
+{
+auto&
+get_stack_func()
+{
+    static auto _v = std::atomic<stack_func_t>{ nullptr };
+    return _v;
+}
+
+auto&
+get_frame_func()
+{
+    static auto _v = std::atomic<frame_func_t>{ nullptr };
+    return _v;
+}
+
+auto&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+// the interpreter loop, e.g. _PyEval_EvalFrameDefault, _PyEval_EvalFrame, and
+// PyEval_EvalFrameEx
+bool
+is_eval_frame(const tim::unwind::processed_entry& _entry)
+{
+    return (std::string_view{ _entry.name }.find("PyEval_EvalFrame") !=
+            std::string_view::npos);
+}
+}  // namespace
+
+void
+register_provider(stack_func_t _stack, frame_func_t _frame)
+{
+    get_frame_func().store(_frame);
+    get_stack_func().store(_stack);
+}
+
+void
+configure()
+{
+    get_enabled().store(config::get_sampling_python());
+    if(get_enabled() && !get_stack_func())
+    {
+        OMNITRACE_VERBOSE(1, "[sampling] OMNITRACE_SAMPLING_PYTHON is enabled but the "
+                             "omnitrace Python bindings are not loaded\n");
+    }
+}
+
+bool
+enabled()
+{
+    return get_enabled().load(std::memory_order_relaxed) &&
+           get_stack_func().load(std::memory_order_relaxed) != nullptr;
+}
+
+size_t
+sample(uintptr_t* _addrs, size_t _capacity)
+{
+    if(!get_enabled().load(std::memory_order_relaxed) || _capacity == 0) return 0;
+
+    auto _func = get_stack_func().load(std::memory_order_relaxed);
+    if(!_func) return 0;
+
+    auto _n = std::min(_func(_addrs, _capacity), _capacity);
+    for(size_t i = 0; i < _n; ++i)
+        _addrs[i] |= frame_tag;
+    // the provider records the innermost frame first
+    std::reverse(_addrs, _addrs + _n);
+    return _n;
+}
+
+std::optional<tim::unwind::processed_entry>
+resolve(uintptr_t _addr)
+{
+    auto _func = get_frame_func().load();
+    if(!_func || !is_frame(_addr)) return std::nullopt;
+
+    const char* _name = nullptr;
+    const char* _file = nullptr;
+    int         _line = 0;
+    if(_func(_addr & ~frame_tag, &_name, &_file, &_line) != 0 || !_name)
+        return std::nullopt;
+
+    auto _v = tim::unwind::processed_entry{};
+    // the frames are cached by address so the address identifies the code and line
+    _v.address  = _addr;
+    _v.lineno   = static_cast<unsigned int>(std::max(_line, 0));
+    _v.name     = _name;
+    _v.location = (_file) ? _file : "";
+    return _v;
+}
+
+std::vector<tim::unwind::processed_entry>
+merge(std::vector<tim::unwind::processed_entry>&& _native,
+      std::vector<tim::unwind::processed_entry>&& _python)
+{
+    if(_python.empty()) return std::move(_native);
+
+    auto _first = std::find_if(_native.begin(), _native.end(), is_eval_frame);
+    if(_first == _native.end())
+    {
+        // the interpreter loop could not be resolved (e.g. stripped libpython) so
+        // the Python frames are placed beneath the native frames
+        _native.insert(_native.end(), std::make_move_iterator(_python.begin()),
+                       std::make_move_iterator(_python.end()));
+        return std::move(_native);
+    }
+
+    auto _last = std::find_if(_native.rbegin(), _native.rend(), is_eval_frame).base();
+
+    auto _v = std::vector<tim::unwind::processed_entry>{};
+    _v.reserve(_native.size() + _python.size());
+    _v.insert(_v.end(), std::make_move_iterator(_native.begin()),
+              std::make_move_iterator(_first));
+    _v.insert(_v.end(), std::make_move_iterator(_python.begin()),
+              std::make_move_iterator(_python.end()));
+    _v.insert(_v.end(), std::make_move_iterator(_last),
+              std::make_move_iterator(_native.end()));
+    return _v;
+}
+}  // namespace python_stack
+}  // namespace omnitrace
+
+//--------------------------------------------------------------------------------------//
+
+extern "C" void
+omnitrace_register_python_sampler_hidden(
+    size_t (*stack_func)(uintptr_t*, size_t),
+    int (*frame_func)(uintptr_t, const char**, const char**, int*))
+{
+    omnitrace::python_stack::register_provider(stack_func, frame_func);
+}
@@ -0,0 +1,80 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/unwind/processed_entry.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace omnitrace
+{
+namespace python_stack
+{
+// records the Python frames of the calling thread, innermost frame first. Invoked
+// from within the sampling signal handler so it must be async-signal-safe
+using stack_func_t = size_t (*)(uintptr_t*, size_t);
+// resolves a recorded frame into the function name, the file, and the line.
+// Returns zero on success
+using frame_func_t = int (*)(uintptr_t, const char**, const char**, int*);
+
+// the recorded Python frames are stored in the calling-context tree alongside the
+// return addresses of the native frames. User-space addresses never have the high
+// bit set so it distinguishes the Python frames
+constexpr uintptr_t frame_tag = (uintptr_t{ 1 } << 63);
+
+inline bool
+is_frame(uintptr_t _v)
+{
+    return (_v & frame_tag) == frame_tag;
+}
+
+// installed by the Python bindings
+void
+register_provider(stack_func_t, frame_func_t);
+
+// reads the configuration. Must be called before the first sample
+void
+configure();
+
+// whether the timer samples record the Python call-stack
+bool
+enabled();
+
+// appends the Python frames of the calling thread, outermost frame first, and tags
+// them with frame_tag. Returns the number of frames. Async-signal-safe
+size_t
+sample(uintptr_t* _addrs, size_t _capacity);
+
+std::optional<tim::unwind::processed_entry>
+resolve(uintptr_t);
+
+// replaces the frames of the interpreter loop in the native call-stack with the
+// Python call-stack. Both call-stacks are ordered outermost frame first
+std::vector<tim::unwind::processed_entry>
+merge(std::vector<tim::unwind::processed_entry>&& _native,
+      std::vector<tim::unwind::processed_entry>&& _python);
+}  // namespace python_stack
+}  // namespace omnitrace
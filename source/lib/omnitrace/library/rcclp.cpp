@@ -73,6 +73,12 @@ setup()
         trait::runtime_enabled<component::comm_data_tracker_t>::set(_use_data);
     }
 
+    auto _use_bandwidth = tim::get_env("OMNITRACE_RCCLP_BANDWIDTH", true);
+    trait::runtime_enabled<component::rccl_bandwidth>::set(_use_bandwidth);
+    trait::runtime_enabled<component::rccl_bandwidth_tracker_t>::set(
+        _use_bandwidth && get_use_timemory());
+    component::rccl_bandwidth::preinit();
+
     component::configure_rcclp();
     global_id = component::activate_rcclp();
 }
@@ -83,5 +89,12 @@ shutdown()
     if(global_id < std::numeric_limits<uint64_t>::max())
         component::deactivate_rcclp(global_id);
 }
+
+void
+post_process()
+{
+    if(trait::runtime_enabled<component::rccl_bandwidth>::get())
+        component::rccl_bandwidth::post_process();
+}
 }  // namespace rcclp
 }  // namespace omnitrace
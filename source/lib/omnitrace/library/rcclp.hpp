@@ -39,6 +39,10 @@ setup();
 void
 shutdown();
 
+// computes the bandwidth of the RCCL collectives once the GPU activity is flushed
+void
+post_process();
+
 #if !defined(OMNITRACE_USE_RCCL) ||                                                      \
     (defined(OMNITRACE_USE_RCCL) && OMNITRACE_USE_RCCL == 0)
 inline void
@@ -52,6 +56,10 @@ setup()
 inline void
 shutdown()
 {}
+
+inline void
+post_process()
+{}
 #endif
 }  // namespace rcclp
 }  // namespace omnitrace
@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/hash/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// the innermost active user, python, kokkos, MPI and roctx region of each thread.
+// The entry into and exit from these regions only store the hash of the region so
+// that the samplers can tag each sample with the region it was taken in without any
+// lookup in the signal handler. Regions nested deeper than the stack are tracked by
+// the depth only, i.e. their samples are attributed to the deepest stored region
+namespace region_context
+{
+static constexpr size_t max_depth = 64;
+
+struct data
+{
+    size_t            depth               = 0;
+    tim::hash_value_t current             = 0;
+    tim::hash_value_t parents[max_depth] = {};
+};
+
+inline data&
+get()
+{
+    static thread_local auto _v = data{};
+    return _v;
+}
+
+inline tim::hash_value_t
+current()
+{
+    return get().current;
+}
+
+inline void
+push(tim::hash_value_t _hash)
+{
+    auto& _v = get();
+    if(_v.depth < max_depth)
+    {
+        _v.parents[_v.depth] = _v.current;
+        _v.current           = _hash;
+    }
+    ++_v.depth;
+}
+
+inline void
+pop()
+{
+    auto& _v = get();
+    if(_v.depth == 0) return;
+    if(--_v.depth < max_depth) _v.current = _v.parents[_v.depth];
+}
+}  // namespace region_context
+}  // namespace omnitrace
@@ -0,0 +1,86 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/region_intervals.hpp"
+#include "core/common.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace region_intervals
+{
+namespace
+{
+struct region_timeline
+{
+    std::vector<std::pair<tim::hash_value_t, uint64_t>> stack     = {};
+    std::vector<interval>                               intervals = {};
+};
+
+auto&
+get_region_timeline(int64_t _tid = threading::get_id())
+{
+    using thread_data_t = thread_data<region_timeline>;
+    return thread_data_t::instance(construct_on_thread{ _tid });
+}
+}  // namespace
+
+void
+push(tim::hash_value_t _hash)
+{
+    static thread_local auto& _timeline = get_region_timeline();
+    _timeline->stack.emplace_back(_hash, tracing::now());
+}
+
+void
+pop()
+{
+    static thread_local auto& _timeline = get_region_timeline();
+    if(_timeline->stack.empty()) return;
+
+    auto _entry = _timeline->stack.back();
+    _timeline->stack.pop_back();
+    _timeline->intervals.emplace_back(
+        interval{ _entry.first, _entry.second, tracing::now() });
+}
+
+void
+for_each(const std::function<void(const interval&)>& _func)
+{
+    auto* _data = thread_data<region_timeline>::get();
+    if(!_data) return;
+
+    for(const auto& titr : *_data)
+    {
+        if(!titr) continue;
+        for(const auto& itr : titr->intervals)
+            _func(itr);
+    }
+}
+}  // namespace region_intervals
+}  // namespace omnitrace
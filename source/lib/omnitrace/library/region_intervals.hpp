@@ -0,0 +1,81 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/hash/types.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace omnitrace
+{
+// the entry and exit times of the regions of every thread for the post-processing which
+// attributes the sampled metrics (e.g. the CPU and GPU energy) to the regions. The
+// intervals are only recorded while at least one of the users is enabled
+namespace region_intervals
+{
+struct interval
+{
+    tim::hash_value_t hash = 0;
+    uint64_t          beg  = 0;
+    uint64_t          end  = 0;
+};
+
+inline std::atomic<uint32_t>&
+get_users()
+{
+    static auto _v = std::atomic<uint32_t>{ 0 };
+    return _v;
+}
+
+inline bool
+is_enabled()
+{
+    return get_users().load(std::memory_order_relaxed) > 0;
+}
+
+inline void
+enable()
+{
+    ++get_users();
+}
+
+inline void
+disable()
+{
+    --get_users();
+}
+
+// the regions of the calling thread
+void
+push(tim::hash_value_t _hash);
+
+void
+pop();
+
+// invokes the function with the recorded intervals of every thread
+void
+for_each(const std::function<void(const interval&)>& _func);
+}  // namespace region_intervals
+}  // namespace omnitrace
@@ -0,0 +1,298 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/region_sampling.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/string_arena.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/manager.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/delimit.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace region_sampling
+{
+namespace
+{
+// interval over which the frequency of a region with an adaptive rate is measured
+constexpr uint64_t adaptive_window = units::sec / 10;
+
+struct entry
+{
+    uint64_t              count        = 0;  // total number of instances
+    uint64_t              recorded     = 0;  // number of recorded instances
+    uint64_t              rate         = 1;  // current N
+    uint64_t              skip         = 0;  // instances to skip before the next record
+    uint64_t              window_count = 0;  // instances since the beginning of window
+    uint64_t              window_begin = 0;
+    uint64_t              sum          = 0;  // duration of the recorded instances
+    std::vector<uint64_t> stack        = {};  // begin timestamp or zero if skipped
+};
+
+struct region_sampling_data
+{};
+
+using sample_map_t         = std::unordered_map<tim::hash_value_t, entry>;
+using sample_thread_data_t = thread_data<sample_map_t, region_sampling_data>;
+
+auto&
+get_sample_map(int64_t _tid = tim::threading::get_id())
+{
+    return sample_thread_data_t::instance(construct_on_thread{ _tid });
+}
+
+// rate of zero is adaptive
+auto
+get_configured_rates()
+{
+    auto _data = std::unordered_map<tim::hash_value_t, size_t>{};
+    for(const auto& itr : tim::delimit(config::get_region_sample_rates(), ",;"))
+    {
+        auto _pos = itr.find_last_of('=');
+        if(_pos == std::string::npos || _pos == 0 || _pos + 1 == itr.length())
+        {
+            OMNITRACE_WARNING_F(0,
+                                "Ignoring invalid OMNITRACE_REGION_SAMPLE_RATES entry "
+                                "'%s'. Expected <NAME>=<N>\n",
+                                itr.c_str());
+            continue;
+        }
+
+        auto _name = itr.substr(0, _pos);
+        auto _rate = itr.substr(_pos + 1);
+        try
+        {
+            _data[tim::hash::get_hash_id(_name)] =
+                (_rate == "auto") ? 0 : std::max<size_t>(std::stoul(_rate), 1);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0,
+                                "Ignoring invalid OMNITRACE_REGION_SAMPLE_RATES entry "
+                                "'%s': %s\n",
+                                itr.c_str(), _e.what());
+        }
+    }
+    return _data;
+}
+
+const auto&
+get_rates()
+{
+    static const auto _v = get_configured_rates();
+    return _v;
+}
+
+void
+update_rate(entry& _v, uint64_t _now)
+{
+    static const auto _target = config::get_region_sample_target();
+
+    auto _elapsed = _now - _v.window_begin;
+    if(_v.window_begin > 0 && _elapsed < adaptive_window) return;
+
+    if(_v.window_begin > 0 && _target > 0.0)
+    {
+        auto _freq = _v.window_count / (static_cast<double>(_elapsed) / units::sec);
+        _v.rate    = std::max<uint64_t>(std::ceil(_freq / _target), 1);
+    }
+    _v.window_begin = _now;
+    _v.window_count = 0;
+}
+}  // namespace
+
+size_t
+push(tim::hash_value_t _hash, std::string_view _name, size_t _rate)
+{
+    // the settings are not read until the tooling is initialized
+    if(get_state() != State::Active) return 1;
+
+    auto& _data = get_sample_map();
+    if(!_data) return 1;
+
+    auto& _v = (*_data)[_hash];
+    ++_v.count;
+    ++_v.window_count;
+    if(_rate > 0) _v.rate = _rate;
+
+    if(_v.skip > 0)
+    {
+        --_v.skip;
+        _v.stack.emplace_back(0);
+        return 0;
+    }
+
+    // the clock is only read for the recorded instances
+    auto _now = tracing::now();
+    if(_rate == 0) update_rate(_v, _now);
+
+    OMNITRACE_VERBOSE(3, "[region_sampling] recording '%s' (1 in %zu) on thread %li...\n",
+                      _name.data(), static_cast<size_t>(_v.rate),
+                      tim::threading::get_id());
+
+    ++_v.recorded;
+    _v.skip = _v.rate - 1;
+    _v.stack.emplace_back(_now);
+    return _v.rate;
+}
+
+size_t
+push(tim::hash_value_t _hash, std::string_view _name)
+{
+    if(get_state() != State::Active) return 1;
+
+    const auto& _rates = get_rates();
+    if(_rates.empty()) return 1;
+
+    auto itr = _rates.find(_hash);
+    if(itr == _rates.end()) return 1;
+
+    return push(_hash, _name, itr->second);
+}
+
+size_t
+push(std::string_view _name)
+{
+    if(get_state() != State::Active || get_rates().empty()) return 1;
+    return push(tim::hash::get_hash_id(_name), _name);
+}
+
+bool
+pop(tim::hash_value_t _hash)
+{
+    if(get_state() != State::Active) return false;
+
+    auto& _data = get_sample_map();
+    if(!_data) return false;
+
+    auto itr = _data->find(_hash);
+    if(itr == _data->end() || itr->second.stack.empty()) return false;
+
+    auto& _v     = itr->second;
+    auto  _begin = _v.stack.back();
+    _v.stack.pop_back();
+    if(_begin == 0) return true;
+
+    _v.sum += tracing::now() - _begin;
+    return false;
+}
+
+bool
+pop(std::string_view _name)
+{
+    if(get_state() != State::Active) return false;
+
+    auto& _data = get_sample_map();
+    if(!_data || _data->empty()) return false;
+
+    return pop(tim::hash::get_hash_id(_name));
+}
+
+void
+post_process()
+{
+    struct summary
+    {
+        uint64_t count    = 0;
+        uint64_t recorded = 0;
+        uint64_t sum      = 0;
+    };
+
+    auto _summary = std::map<std::string, summary>{};
+    for(size_t i = 0; i < sample_thread_data_t::size(); ++i)
+    {
+        const auto& _data = sample_thread_data_t::get()->at(i);
+        if(!_data) continue;
+
+        for(const auto& itr : *_data)
+        {
+            if(itr.second.recorded == 0) continue;
+            auto _name = tim::get_hash_identifier_fast(itr.first);
+            if(_name.empty()) continue;
+            auto& _v = _summary[std::string{ _name }];
+            _v.count += itr.second.count;
+            _v.recorded += itr.second.recorded;
+            _v.sum += itr.second.sum;
+        }
+    }
+
+    if(_summary.empty()) return;
+
+    auto _count     = std::map<std::string, uint64_t>{};
+    auto _recorded  = std::map<std::string, uint64_t>{};
+    auto _mean      = std::map<std::string, double>{};
+    auto _estimated = std::map<std::string, double>{};
+    for(const auto& itr : _summary)
+    {
+        const auto& _v     = itr.second;
+        auto        _scale = static_cast<double>(_v.count) / _v.recorded;
+        auto        _avg   = static_cast<double>(_v.sum) / _v.recorded / units::sec;
+        auto        _total = _v.sum * _scale / units::sec;
+        _count[itr.first]     = _v.count;
+        _recorded[itr.first]  = _v.recorded;
+        _mean[itr.first]      = _avg;
+        _estimated[itr.first] = _total;
+
+        OMNITRACE_VERBOSE(0,
+                          "[region_sampling] %-50s :: %zu of %zu instances were "
+                          "recorded. mean = %.3e sec, estimated total = %.3e sec\n",
+                          itr.first.c_str(), static_cast<size_t>(_v.recorded),
+                          static_cast<size_t>(_v.count), _avg, _total);
+
+        if(get_use_perfetto())
+            tracing::mark_perfetto_track(
+                category::user{},
+                intern_string(JOIN("", "sampled region: ", itr.first)),
+                ::perfetto::ProcessTrack::Current(), tracing::now(),
+                [&](::perfetto::EventContext ctx) {
+                    tracing::add_perfetto_annotation(ctx, "count", _v.count);
+                    tracing::add_perfetto_annotation(ctx, "recorded", _v.recorded);
+                    tracing::add_perfetto_annotation(ctx, "scale", _scale);
+                });
+    }
+
+    tim::manager::instance()->add_metadata(
+        [_count, _recorded, _mean, _estimated](auto& ar) {
+            ar(tim::cereal::make_nvp("sampled_regions_count", _count));
+            ar(tim::cereal::make_nvp("sampled_regions_recorded", _recorded));
+            ar(tim::cereal::make_nvp("sampled_regions_mean_sec", _mean));
+            ar(tim::cereal::make_nvp("sampled_regions_estimated_total_sec", _estimated));
+        });
+}
+}  // namespace region_sampling
+}  // namespace omnitrace
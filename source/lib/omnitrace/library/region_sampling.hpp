@@ -0,0 +1,67 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <timemory/hash/types.hpp>
+
+#include <cstddef>
+#include <string_view>
+
+namespace omnitrace
+{
+// sampled user regions: only one in N instances of the region is traced and profiled
+// on each thread. Every instance is counted and the statistics of the recorded
+// instances are scaled by the ratio of the counts during finalization. N is either
+// fixed or, when zero, re-evaluated such that the region is recorded approximately
+// OMNITRACE_REGION_SAMPLE_TARGET times per second per thread
+namespace region_sampling
+{
+// returns zero when the entry into the region should be skipped. Otherwise, returns
+// the number of instances represented by the recorded instance (the current N)
+size_t
+push(tim::hash_value_t _hash, std::string_view _name, size_t _rate);
+
+// same as above with the rate of the region in OMNITRACE_REGION_SAMPLE_RATES.
+// Returns one when the region is not listed
+size_t
+push(tim::hash_value_t _hash, std::string_view _name);
+
+// same as above but the name is only hashed when OMNITRACE_REGION_SAMPLE_RATES is set
+size_t
+push(std::string_view _name);
+
+// returns true when the exit from the region should be skipped, i.e. the matching
+// entry was skipped
+bool
+pop(tim::hash_value_t _hash);
+
+// same as above but the name is only hashed when a region was sampled on this thread
+bool
+pop(std::string_view _name);
+
+// records the exact number of instances and the scaled statistics of every sampled
+// region
+void
+post_process();
+}  // namespace region_sampling
+}  // namespace omnitrace
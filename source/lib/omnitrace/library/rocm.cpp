@@ -189,6 +189,16 @@ extern "C"
 
         comp::roctracer::setup(static_cast<void*>(table), rocm::on_load_trace);
 
+        // the register and LDS usage of the kernels are read when the code objects
+        // are loaded
+        if(config::get_roctracer_kernel_occupancy())
+        {
+            using ::rocprofiler::util::HsaRsrcFactory;
+
+            HsaRsrcFactory::InitHsaApiTable(table);
+            HsaRsrcFactory::EnableExecutableTracking(table);
+        }
+
 #if defined(OMNITRACE_USE_ROCPROFILER) && OMNITRACE_USE_ROCPROFILER > 0
         bool _force_rocprofiler_init =
             tim::get_env("OMNITRACE_FORCE_ROCPROFILER_INIT", false, false);
@@ -233,7 +243,8 @@ extern "C"
         {
             using ::rocprofiler::util::HsaRsrcFactory;
 
-            HsaRsrcFactory::Instance().PrintGpuAgents("ROCm");
+            // the resource factory is created on demand (e.g. for the kernel occupancy)
+            HsaRsrcFactory::AddGpuAgentsMetadata();
         }
 
         gpu::add_hip_device_metadata();
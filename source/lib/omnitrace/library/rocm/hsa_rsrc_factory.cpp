@@ -818,6 +818,34 @@ HsaRsrcFactory::LoadAndFinalize(const AgentInfo* agent_info, const char* brig_pa
     return true;
 }
 
+// Serialize the various fields of Hsa Gpu Agents
+template <typename ArchiveT>
+static void
+SerializeGpuAgents(ArchiveT& ar, const std::vector<AgentInfo>& _agents)
+{
+    namespace cereal = ::tim::cereal;
+
+    ar.setNextName("rocm_agents");
+    ar.startNode();
+    ar.makeArray();
+    for(auto itr : _agents)
+    {
+        ar.startNode();
+        ar(cereal::make_nvp("name", std::string{ itr.name }),
+           cereal::make_nvp("is_apu", itr.is_apu),
+           cereal::make_nvp("hsa_profile", itr.profile),
+           cereal::make_nvp("max_wave_size", itr.max_wave_size),
+           cereal::make_nvp("max_queue_size", itr.max_queue_size),
+           cereal::make_nvp("cu_number", itr.cu_num),
+           cereal::make_nvp("waves_per_cu", itr.waves_per_cu),
+           cereal::make_nvp("simds_per_cu", itr.simds_per_cu),
+           cereal::make_nvp("se_num", itr.se_num),
+           cereal::make_nvp("shader_arrays_per_se", itr.shader_arrays_per_se));
+        ar.finishNode();
+    }
+    ar.finishNode();
+}
+
 // Print the various fields of Hsa Gpu Agents
 bool
 HsaRsrcFactory::PrintGpuAgents(const std::string&)
@@ -828,31 +856,27 @@ HsaRsrcFactory::PrintGpuAgents(const std::string&)
         if(itr) _agents.emplace_back(*itr);
     }
 
-    OMNITRACE_METADATA([_agents](auto& ar) {
-        namespace cereal = ::tim::cereal;
+    OMNITRACE_METADATA([_agents](auto& ar) { SerializeGpuAgents(ar, _agents); });
 
-        ar.setNextName("rocm_agents");
-        ar.startNode();
-        ar.makeArray();
-        for(auto itr : _agents)
+    return true;
+}
+
+// Print the various fields of Hsa Gpu Agents when the metadata is written if the
+// factory was created by then. The factory enumerates the agents and correlates the
+// clocks so it is not created only to record the agents
+void
+HsaRsrcFactory::AddGpuAgentsMetadata()
+{
+    OMNITRACE_METADATA([](auto& ar) {
+        if(instance_.load(std::memory_order_acquire) == nullptr) return;
+
+        std::vector<AgentInfo> _agents = {};
+        for(const auto* itr : Instance().gpu_list_)
         {
-            ar.startNode();
-            ar(cereal::make_nvp("name", std::string{ itr.name }),
-               cereal::make_nvp("is_apu", itr.is_apu),
-               cereal::make_nvp("hsa_profile", itr.profile),
-               cereal::make_nvp("max_wave_size", itr.max_wave_size),
-               cereal::make_nvp("max_queue_size", itr.max_queue_size),
-               cereal::make_nvp("cu_number", itr.cu_num),
-               cereal::make_nvp("waves_per_cu", itr.waves_per_cu),
-               cereal::make_nvp("simds_per_cu", itr.simds_per_cu),
-               cereal::make_nvp("se_num", itr.se_num),
-               cereal::make_nvp("shader_arrays_per_se", itr.shader_arrays_per_se));
-            ar.finishNode();
+            if(itr) _agents.emplace_back(*itr);
         }
-        ar.finishNode();
+        SerializeGpuAgents(ar, _agents);
     });
-
-    return true;
 }
 
 void*
@@ -939,6 +963,69 @@ HsaRsrcFactory::GetKernelNameRef(uint64_t addr)
     return it->second;
 }
 
+bool
+HsaRsrcFactory::GetKernelResources(const char* name, KernelResources* resources)
+{
+    if(name == nullptr || resources == nullptr) return false;
+
+    std::lock_guard<mutex_t> lck(mutex_);
+    if(kernel_resources_map_ == nullptr) return false;
+    const auto it = kernel_resources_map_->find(name);
+    if(it == kernel_resources_map_->end()) return false;
+    *resources = it->second;
+    return true;
+}
+
+void
+HsaRsrcFactory::AddKernelResources(hsa_executable_symbol_t symbol, const char* symname,
+                                   uint64_t kernel_object)
+{
+    if(kernel_resources_map_ == nullptr)
+        kernel_resources_map_ = new kernel_resources_map_t;
+
+    KernelResources resources = {};
+    hsa_api_.hsa_executable_symbol_get_info(symbol, HSA_EXECUTABLE_SYMBOL_INFO_AGENT,
+                                            &resources.agent);
+    hsa_api_.hsa_executable_symbol_get_info(
+        symbol, HSA_EXECUTABLE_SYMBOL_INFO_KERNEL_GROUP_SEGMENT_SIZE,
+        &resources.group_segment_size);
+    hsa_api_.hsa_executable_symbol_get_info(
+        symbol, HSA_EXECUTABLE_SYMBOL_INFO_KERNEL_PRIVATE_SEGMENT_SIZE,
+        &resources.private_segment_size);
+
+    // The register usage is only available from the kernel descriptor
+    static hsa_ven_amd_loader_1_00_pfn_t loader_api = {};
+    if(loader_api.hsa_ven_amd_loader_query_host_address == nullptr)
+        hsa_api_.hsa_system_get_major_extension_table(HSA_EXTENSION_AMD_LOADER, 1,
+                                                      sizeof(loader_api), &loader_api);
+
+    const void* host_addr = nullptr;
+    if(loader_api.hsa_ven_amd_loader_query_host_address != nullptr &&
+       loader_api.hsa_ven_amd_loader_query_host_address(
+           reinterpret_cast<const void*>(kernel_object), &host_addr) ==
+           HSA_STATUS_SUCCESS &&
+       host_addr != nullptr)
+    {
+        // kernel_descriptor_t: COMPUTE_PGM_RSRC1 at byte 48 and the kernel code
+        // properties at byte 56 (ENABLE_WAVEFRONT_SIZE32 is bit 10)
+        const uint8_t* desc  = static_cast<const uint8_t*>(host_addr);
+        uint32_t       rsrc1 = 0;
+        uint16_t       props = 0;
+        memcpy(&rsrc1, desc + 48, sizeof(rsrc1));
+        memcpy(&props, desc + 56, sizeof(props));
+        resources.vgpr_granules  = (rsrc1 & 0x3f);
+        resources.sgpr_granules  = ((rsrc1 >> 6) & 0xf);
+        resources.wave32         = ((props >> 10) & 0x1) != 0;
+        resources.has_descriptor = true;
+    }
+
+    // Code object v3+ kernel symbols may carry the descriptor suffix
+    std::string name = symname;
+    if(name.length() > 3 && name.compare(name.length() - 3, 3, ".kd") == 0)
+        name = name.substr(0, name.length() - 3);
+    (*kernel_resources_map_)[name] = resources;
+}
+
 void
 HsaRsrcFactory::EnableExecutableTracking(HsaApiTable* table)
 {
@@ -980,6 +1067,7 @@ HsaRsrcFactory::executable_symbols_cb(hsa_executable_t /*exec*/,
                 delete[] ret.first->second;
                 ret.first->second = name;
             }
+            AddKernelResources(symbol, symname, addr);
         }
         else
         {
@@ -1023,5 +1111,7 @@ bool                           HsaRsrcFactory::executable_tracking_on_ = false;
 HsaRsrcFactory::symbols_map_t* HsaRsrcFactory::symbols_map_            = nullptr;
 void*                          HsaRsrcFactory::to_dump_code_obj_       = nullptr;
 
+HsaRsrcFactory::kernel_resources_map_t* HsaRsrcFactory::kernel_resources_map_ = nullptr;
+
 }  // namespace util
 }  // namespace rocprofiler
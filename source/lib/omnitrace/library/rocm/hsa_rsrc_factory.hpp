@@ -194,6 +194,28 @@ struct AgentInfo
     static const uint32_t lds_block_size = 128 * 4;
 };
 
+// Resource usage of a kernel read from the executable symbol and the kernel
+// descriptor (code object v3+) when the executable is frozen
+struct KernelResources
+{
+    // Agent the executable was loaded for
+    hsa_agent_t agent;
+
+    // Static LDS and scratch usage per work-item in bytes
+    uint32_t group_segment_size;
+    uint32_t private_segment_size;
+
+    // Granulated VGPR/SGPR counts of COMPUTE_PGM_RSRC1 (valid if has_descriptor)
+    uint32_t vgpr_granules;
+    uint32_t sgpr_granules;
+
+    // Kernel is compiled for wave32
+    bool wave32;
+
+    // Kernel descriptor was readable from the host
+    bool has_descriptor;
+};
+
 // HSA timer class
 // Provides current HSA timestampa and system-clock/ns conversion API
 class HsaTimer
@@ -435,6 +457,10 @@ public:
     // Print the various fields of Hsa Gpu Agents
     bool PrintGpuAgents(const std::string& header);
 
+    // Print the various fields of Hsa Gpu Agents if the factory exists when the
+    // metadata is written
+    static void AddGpuAgentsMetadata();
+
     // Utils for submitting AQL packet to a given queue
     static void*    GetSlotPointer(hsa_queue_t* queue, const uint64_t& idx);
     static void*    GetReadPointer(hsa_queue_t* queue);
@@ -446,6 +472,10 @@ public:
     static void        EnableExecutableTracking(HsaApiTable* table);
     static const char* GetKernelNameRef(uint64_t addr);
 
+    // Resource usage of a kernel by its (mangled) symbol name, requires the
+    // executables loading tracking
+    static bool GetKernelResources(const char* name, KernelResources* resources);
+
     // Initialize HSA API table
     void static InitHsaApiTable(HsaApiTable* table);
     static const hsa_pfn_t* HsaApi() { return &hsa_api_; }
@@ -542,15 +572,19 @@ private:
     std::map<hsa_agent_handle_t, const AgentInfo*> agent_map_;
 
     // Executables loading tracking
-    typedef std::map<uint64_t, const char*> symbols_map_t;
-    static symbols_map_t*                   symbols_map_;
-    static bool                             executable_tracking_on_;
-    static void*                            to_dump_code_obj_;
+    typedef std::map<uint64_t, const char*>        symbols_map_t;
+    typedef std::map<std::string, KernelResources> kernel_resources_map_t;
+    static symbols_map_t*                          symbols_map_;
+    static kernel_resources_map_t*                 kernel_resources_map_;
+    static bool                                    executable_tracking_on_;
+    static void*                                   to_dump_code_obj_;
     static hsa_status_t hsa_executable_freeze_interceptor(hsa_executable_t executable,
                                                           const char*      options);
     static hsa_status_t hsa_executable_destroy_interceptor(hsa_executable_t executable);
     static hsa_status_t executable_symbols_cb(hsa_executable_t        exec,
                                               hsa_executable_symbol_t symbol, void* data);
+    static void         AddKernelResources(hsa_executable_symbol_t symbol,
+                                           const char* symname, uint64_t kernel_object);
 
     // HSA runtime API table
     static hsa_pfn_t hsa_api_;
@@ -38,6 +38,7 @@
 #include "core/gpu.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
+#include "library/gpu_energy.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_info.hpp"
 
@@ -50,14 +51,20 @@
 
 #include <rocm_smi/rocm_smi.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <ios>
+#include <mutex>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <sys/resource.h>
 #include <thread>
+#include <vector>
 
 #define OMNITRACE_ROCM_SMI_CALL(...)                                                     \
     ::omnitrace::rocm_smi::check_error(__FILE__, __LINE__, __VA_ARGS__)
@@ -66,7 +73,112 @@ namespace omnitrace
 {
 namespace rocm_smi
 {
-using bundle_t          = std::deque<data>;
+namespace
+{
+// structure-of-arrays storage of the samples of a device. The samples are stored in
+// fixed-size blocks so that sampling never copies the previous samples and only
+// allocates once per block. When OMNITRACE_ROCM_SMI_BUFFER_SIZE is non-zero, all the
+// blocks are allocated up front and the oldest samples are overwritten once it is full
+struct sample_buffer
+{
+    static constexpr size_t block_size = 4096;
+
+    template <typename Tp>
+    using array_t = std::array<Tp, block_size>;
+
+    struct block
+    {
+        array_t<data::timestamp_t> ts           = {};
+        array_t<data::timestamp_t> busy_ts      = {};
+        array_t<data::timestamp_t> temp_ts      = {};
+        array_t<data::timestamp_t> power_ts     = {};
+        array_t<data::timestamp_t> mem_usage_ts = {};
+        array_t<data::busy_perc_t> busy_perc    = {};
+        array_t<data::temp_t>      temp         = {};
+        array_t<data::power_t>     power        = {};
+        array_t<data::mem_usage_t> mem_usage    = {};
+    };
+
+    sample_buffer(uint32_t _dev_id, size_t _capacity)
+    : m_dev_id{ _dev_id }
+    , m_capacity{ (_capacity == 0) ? std::numeric_limits<size_t>::max() : _capacity }
+    {
+        if(_capacity == 0) return;
+        m_blocks.resize((_capacity + block_size - 1) / block_size);
+        for(auto& itr : m_blocks)
+            itr = std::make_unique<block>();
+    }
+
+    size_t size() const { return m_size; }
+    size_t overwritten() const { return m_overwritten; }
+
+    void push(const data& _v)
+    {
+        auto _idx = m_size;
+        if(m_size < m_capacity)
+        {
+            ++m_size;
+        }
+        else
+        {
+            _idx   = m_head;
+            m_head = (m_head + 1) % m_capacity;
+            ++m_overwritten;
+        }
+
+        auto _blk = _idx / block_size;
+        auto _off = _idx % block_size;
+        if(_blk >= m_blocks.size()) m_blocks.emplace_back(std::make_unique<block>());
+
+        auto& _b = *m_blocks[_blk];
+
+        _b.ts[_off]           = _v.m_ts;
+        _b.busy_ts[_off]      = _v.m_busy_ts;
+        _b.temp_ts[_off]      = _v.m_temp_ts;
+        _b.power_ts[_off]     = _v.m_power_ts;
+        _b.mem_usage_ts[_off] = _v.m_mem_usage_ts;
+        _b.busy_perc[_off]    = _v.m_busy_perc;
+        _b.temp[_off]         = _v.m_temp;
+        _b.power[_off]        = _v.m_power;
+        _b.mem_usage[_off]    = _v.m_mem_usage;
+    }
+
+    // the samples in the order they were taken, i.e. index zero is the oldest sample
+    data at(size_t _i) const
+    {
+        auto _idx = (m_size < m_capacity) ? _i : (m_head + _i) % m_capacity;
+        auto _blk = _idx / block_size;
+        auto _off = _idx % block_size;
+
+        const auto& _b = *m_blocks.at(_blk);
+        auto        _v = data{};
+
+        _v.m_dev_id       = m_dev_id;
+        _v.m_ts           = _b.ts[_off];
+        _v.m_busy_ts      = _b.busy_ts[_off];
+        _v.m_temp_ts      = _b.temp_ts[_off];
+        _v.m_power_ts     = _b.power_ts[_off];
+        _v.m_mem_usage_ts = _b.mem_usage_ts[_off];
+        _v.m_busy_perc    = _b.busy_perc[_off];
+        _v.m_temp         = _b.temp[_off];
+        _v.m_power        = _b.power[_off];
+        _v.m_mem_usage    = _b.mem_usage[_off];
+        return _v;
+    }
+
+    data back() const { return at(m_size - 1); }
+
+private:
+    uint32_t                            m_dev_id      = 0;
+    size_t                              m_capacity    = 0;
+    size_t                              m_size        = 0;
+    size_t                              m_head        = 0;  // oldest sample once full
+    size_t                              m_overwritten = 0;
+    std::vector<std::unique_ptr<block>> m_blocks      = {};
+};
+}  // namespace
+
+using bundle_t          = sample_buffer;
 using sampler_instances = thread_data<bundle_t, category::rocm_smi>;
 
 namespace
@@ -135,12 +247,13 @@ data::sample(uint32_t _dev_id)
     m_dev_id = _dev_id;
     m_ts     = _ts;
 
-#define OMNITRACE_RSMI_GET(OPTION, FUNCTION, ...)                                        \
+#define OMNITRACE_RSMI_GET(OPTION, TIMESTAMP, FUNCTION, ...)                             \
     if(OPTION)                                                                           \
     {                                                                                    \
         try                                                                              \
         {                                                                                \
             OMNITRACE_ROCM_SMI_CALL(FUNCTION(__VA_ARGS__), &OPTION);                     \
+            TIMESTAMP = tim::get_clock_real_now<size_t, std::nano>();                    \
         } catch(std::runtime_error & _e)                                                 \
         {                                                                                \
             OMNITRACE_VERBOSE_F(                                                         \
@@ -150,13 +263,17 @@ data::sample(uint32_t _dev_id)
         }                                                                                \
     }
 
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).busy, rsmi_dev_busy_percent_get, _dev_id,
+    // each metric is timestamped when the query returns since, on nodes with many
+    // devices, the individual rocm-smi queries can take a significant fraction of the
+    // sampling interval
+    auto& _settings = get_settings(m_dev_id);
+    OMNITRACE_RSMI_GET(_settings.busy, m_busy_ts, rsmi_dev_busy_percent_get, _dev_id,
                        &m_busy_perc);
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).temp, rsmi_dev_temp_metric_get, _dev_id,
+    OMNITRACE_RSMI_GET(_settings.temp, m_temp_ts, rsmi_dev_temp_metric_get, _dev_id,
                        RSMI_TEMP_TYPE_EDGE, RSMI_TEMP_CURRENT, &m_temp);
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).power, rsmi_dev_power_ave_get, _dev_id, 0,
+    OMNITRACE_RSMI_GET(_settings.power, m_power_ts, rsmi_dev_power_ave_get, _dev_id, 0,
                        &m_power);
-    OMNITRACE_RSMI_GET(get_settings(m_dev_id).mem_usage, rsmi_dev_memory_usage_get,
+    OMNITRACE_RSMI_GET(_settings.mem_usage, m_mem_usage_ts, rsmi_dev_memory_usage_get,
                        _dev_id, RSMI_MEM_TYPE_VRAM, &m_mem_usage);
 
 #undef OMNITRACE_RSMI_GET
@@ -173,8 +290,162 @@ data::print(std::ostream& _os) const
 
 namespace
 {
-std::vector<unique_ptr_t<bundle_t>*> _bundle_data{};
+using poller_clock_t = std::chrono::steady_clock;
+
+struct poller_stats
+{
+    uint64_t count     = 0;  // number of samples
+    uint64_t overruns  = 0;  // number of samples which finished after the next deadline
+    uint64_t drift_sum = 0;  // wake-up latency relative to the deadline (nsec)
+    uint64_t drift_max = 0;
+    uint64_t query_sum = 0;  // time spent in the rocm-smi queries (nsec)
+    uint64_t query_max = 0;
+};
+
+struct device_poller
+{
+    uint32_t                     dev_id = 0;
+    std::unique_ptr<std::thread> thread = {};
+    poller_stats                 stats  = {};
+};
+
+std::vector<unique_ptr_t<bundle_t>*>        _bundle_data{};
+std::vector<std::unique_ptr<device_poller>> _device_pollers{};
+std::mutex                                  _device_pollers_mutex{};
+std::atomic<bool>                           _use_device_pollers{ false };
+
+bool
+is_polling_state()
+{
+    return rocm_smi::get_state() == State::Active &&
+           ::omnitrace::get_state() == State::Active;
+}
+
+bool
+is_finished_state()
+{
+    return rocm_smi::get_state() >= State::Finalized ||
+           ::omnitrace::get_state() >= State::Finalized;
+}
+
+// samples a single device at a fixed rate. Deadlines are advanced by the interval
+// instead of from the time the sample finished so that slow queries do not
+// accumulate drift. When a sample finishes after the next deadline, the missed
+// ticks are dropped and counted as an overrun.
+void
+poll_device(device_poller* _poller, std::chrono::nanoseconds _interval, double _duration)
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name(JOIN('.', "omni.rsmi", _poller->dev_id).c_str());
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto  _dev_id = _poller->dev_id;
+    auto& _data   = *_bundle_data.at(_dev_id);
+    auto& _stats  = _poller->stats;
+
+    bool _has_duration = (_duration > 0.0);
+    auto _next         = poller_clock_t::now();
+    auto _end =
+        _next + std::chrono::nanoseconds{ static_cast<uint64_t>(_duration * units::sec) };
+
+    while(!is_finished_state())
+    {
+        std::this_thread::sleep_until(_next);
+        auto _wake = poller_clock_t::now();
+
+        if(is_finished_state()) break;
+        if(!is_polling_state() || !_data)
+        {
+            _next = _wake + _interval;
+            continue;
+        }
+
+        _data->push(data{ _dev_id });
+
+        auto _done  = poller_clock_t::now();
+        auto _nsec  = [](auto _v) -> uint64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(_v).count();
+        };
+        auto _drift = _nsec(_wake - _next);
+        auto _query = _nsec(_done - _wake);
+
+        _stats.count += 1;
+        _stats.drift_sum += _drift;
+        _stats.query_sum += _query;
+        _stats.drift_max = std::max(_stats.drift_max, _drift);
+        _stats.query_max = std::max(_stats.query_max, _query);
+
+        _next += _interval;
+        if(_next <= _done)
+        {
+            _stats.overruns += 1;
+            _next += ((_done - _next) / _interval + 1) * _interval;
+        }
+
+        if(_has_duration && _done >= _end) break;
+    }
+}
+
+void
+start_device_pollers(const std::set<uint32_t>& _devices)
+{
+    std::unique_lock<std::mutex> _lk{ _device_pollers_mutex };
+
+    if(!_device_pollers.empty() || is_finished_state()) return;
+
+    auto _freq     = get_process_sampling_freq();
+    auto _duration = config::get_process_sampling_duration();
+    if(_duration < 0.0) _duration = config::get_sampling_duration();
+    auto _interval =
+        std::chrono::nanoseconds{ static_cast<uint64_t>((1.0 / _freq) * units::sec) };
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+
+    for(auto itr : _devices)
+    {
+        if(!_bundle_data.at(itr)) continue;
+        auto& _poller   = _device_pollers.emplace_back(std::make_unique<device_poller>());
+        _poller->dev_id = itr;
+        _poller->thread = std::make_unique<std::thread>(&poll_device, _poller.get(),
+                                                        _interval, _duration);
+    }
+
+    OMNITRACE_VERBOSE(1, "rocm-smi is polling %zu device(s) from dedicated threads...\n",
+                      _device_pollers.size());
+
+    _use_device_pollers.store(!_device_pollers.empty());
+}
+
+void
+stop_device_pollers()
+{
+    std::unique_lock<std::mutex> _lk{ _device_pollers_mutex };
+
+    for(auto& itr : _device_pollers)
+    {
+        if(itr->thread) itr->thread->join();
+
+        const auto& _stats   = itr->stats;
+        auto        _count   = std::max<uint64_t>(_stats.count, 1);
+        auto        _to_usec = [](uint64_t _v) {
+            return static_cast<double>(_v) / units::usec;
+        };
+        OMNITRACE_VERBOSE(1,
+                          "rocm-smi device %u :: %lu samples, %lu overruns, drift (avg "
+                          "/ max) = %.3f / %.3f usec, query (avg / max) = %.3f / %.3f "
+                          "usec\n",
+                          itr->dev_id, _stats.count, _stats.overruns,
+                          _to_usec(_stats.drift_sum / _count),
+                          _to_usec(_stats.drift_max),
+                          _to_usec(_stats.query_sum / _count),
+                          _to_usec(_stats.query_max));
+    }
+
+    _device_pollers.clear();
+    _use_device_pollers.store(false);
 }
+}  // namespace
 
 void
 config()
@@ -186,25 +457,31 @@ config()
         {
             _bundle_data.at(i) = &sampler_instances::get()->at(i);
             if(!*_bundle_data.at(i))
-                *_bundle_data.at(i) = unique_ptr_t<bundle_t>{ new bundle_t{} };
+                *_bundle_data.at(i) = unique_ptr_t<bundle_t>{ new bundle_t{
+                    static_cast<uint32_t>(i), config::get_rocm_smi_buffer_size() } };
         }
     }
 
     data::get_initial().resize(data::device_count);
     for(auto itr : data::device_list)
         data::get_initial().at(itr).sample(itr);
+
+    if(get_rocm_smi_per_device_polling()) start_device_pollers(data::device_list);
 }
 
 void
 sample()
 {
+    // devices are sampled by their dedicated threads
+    if(_use_device_pollers.load()) return;
+
     for(auto itr : data::device_list)
     {
         if(rocm_smi::get_state() != State::Active) continue;
         OMNITRACE_DEBUG_F("Polling rocm-smi for device %u...\n", itr);
         auto& _data = *_bundle_data.at(itr);
         if(!_data) continue;
-        _data->emplace_back(data{ itr });
+        _data->push(data{ itr });
         OMNITRACE_DEBUG_F("    %s\n", TIMEMORY_JOIN("", _data->back()).c_str());
     }
 }
@@ -259,12 +536,15 @@ data::post_process(uint32_t _dev_id)
 
     if(device_count < _dev_id) return;
 
-    auto&       _rocm_smi_v = sampler_instances::get()->at(_dev_id);
-    auto        _rocm_smi   = (_rocm_smi_v) ? *_rocm_smi_v : std::deque<rocm_smi::data>{};
+    auto&       _rocm_smi    = sampler_instances::get()->at(_dev_id);
     const auto& _thread_info = thread_info::get(0, InternalTID);
 
-    OMNITRACE_VERBOSE(1, "Post-processing %zu rocm-smi samples from device %u\n",
-                      _rocm_smi.size(), _dev_id);
+    if(!_rocm_smi) return;
+
+    OMNITRACE_VERBOSE(1,
+                      "Post-processing %zu rocm-smi samples from device %u (%zu "
+                      "overwritten)\n",
+                      _rocm_smi->size(), _dev_id, _rocm_smi->overwritten());
 
     OMNITRACE_CI_THROW(!_thread_info, "Missing thread info for thread 0");
     if(!_thread_info) return;
@@ -272,6 +552,8 @@ data::post_process(uint32_t _dev_id)
     auto _settings = get_settings(_dev_id);
 
     auto _process_perfetto = [&]() {
+        using counter_track = perfetto_counter_track<data>;
+
         auto _idx = std::array<uint64_t, 4>{};
         {
             _idx.fill(_idx.size());
@@ -282,45 +564,102 @@ data::post_process(uint32_t _dev_id)
             if(_settings.mem_usage) _idx.at(3) = nidx++;
         }
 
-        for(auto& itr : _rocm_smi)
+        if(!counter_track::exists(_dev_id))
         {
-            using counter_track = perfetto_counter_track<data>;
-            if(itr.m_dev_id != _dev_id) continue;
-            if(!counter_track::exists(_dev_id))
+            auto addendum = [&](const char* _v) {
+                return JOIN(" ", "GPU", _v, JOIN("", '[', _dev_id, ']'), "(S)");
+            };
+
+            if(_settings.busy) counter_track::emplace(_dev_id, addendum("Busy"), "%");
+            if(_settings.temp)
+                counter_track::emplace(_dev_id, addendum("Temperature"), "deg C");
+            if(_settings.power)
+                counter_track::emplace(_dev_id, addendum("Power"), "watts");
+            if(_settings.mem_usage)
+                counter_track::emplace(_dev_id, addendum("Memory Usage"), "megabytes");
+        }
+
+        // use the time the metric was acquired when available
+        auto _get_ts = [](data::timestamp_t _ts, const data& _v) -> uint64_t {
+            return (_ts > 0) ? _ts : _v.m_ts;
+        };
+
+        // when more than OMNITRACE_ROCM_SMI_MAX_OUTPUT_SAMPLES samples were taken, only
+        // the minimum and maximum of each metric within each interval are written
+        auto _size   = _rocm_smi->size();
+        auto _limit  = config::get_rocm_smi_max_output_samples();
+        auto _stride = (_limit > 0 && _size > _limit) ? ((_size + _limit - 1) / _limit)
+                                                      : size_t{ 1 };
+
+        using sample_t = std::pair<uint64_t, double>;
+        auto _write    = [&](auto&& _get, auto&& _emit) {
+            for(size_t i = 0; i < _size; i += _stride)
             {
-                auto addendum = [&](const char* _v) {
-                    return JOIN(" ", "GPU", _v, JOIN("", '[', _dev_id, ']'), "(S)");
-                };
+                auto _min = std::optional<sample_t>{};
+                auto _max = std::optional<sample_t>{};
+                for(size_t j = i; j < std::min(i + _stride, _size); ++j)
+                {
+                    auto _v = _rocm_smi->at(j);
+                    if(!_thread_info->is_valid_time(_v.m_ts)) continue;
+                    auto _sample = _get(_v);
+                    if(!_min || _sample.second < _min->second) _min = _sample;
+                    if(!_max || _sample.second > _max->second) _max = _sample;
+                }
 
-                if(_settings.busy) counter_track::emplace(_dev_id, addendum("Busy"), "%");
-                if(_settings.temp)
-                    counter_track::emplace(_dev_id, addendum("Temperature"), "deg C");
-                if(_settings.power)
-                    counter_track::emplace(_dev_id, addendum("Power"), "watts");
-                if(_settings.mem_usage)
-                    counter_track::emplace(_dev_id, addendum("Memory Usage"),
-                                           "megabytes");
+                if(!_min) continue;
+                if(_max->first < _min->first) std::swap(_min, _max);
+                _emit(_min->first, _min->second);
+                if(_max->first != _min->first) _emit(_max->first, _max->second);
             }
-            uint64_t _ts = itr.m_ts;
-            if(!_thread_info->is_valid_time(_ts)) continue;
+        };
 
-            double _busy  = itr.m_busy_perc;
-            double _temp  = itr.m_temp / 1.0e3;
-            double _power = itr.m_power / 1.0e6;
-            double _usage = itr.m_mem_usage / static_cast<double>(units::megabyte);
+        if(_settings.busy)
+        {
+            _write(
+                [&](const data& _v) {
+                    return sample_t{ _get_ts(_v.m_busy_ts, _v), _v.m_busy_perc };
+                },
+                [&](uint64_t _ts, double _v) {
+                    TRACE_COUNTER("device_busy", counter_track::at(_dev_id, _idx.at(0)),
+                                  _ts, _v);
+                });
+        }
 
-            if(_settings.busy)
-                TRACE_COUNTER("device_busy", counter_track::at(_dev_id, _idx.at(0)), _ts,
-                              _busy);
-            if(_settings.temp)
-                TRACE_COUNTER("device_temp", counter_track::at(_dev_id, _idx.at(1)), _ts,
-                              _temp);
-            if(_settings.power)
-                TRACE_COUNTER("device_power", counter_track::at(_dev_id, _idx.at(2)), _ts,
-                              _power);
-            if(_settings.mem_usage)
-                TRACE_COUNTER("device_memory_usage",
-                              counter_track::at(_dev_id, _idx.at(3)), _ts, _usage);
+        if(_settings.temp)
+        {
+            _write(
+                [&](const data& _v) {
+                    return sample_t{ _get_ts(_v.m_temp_ts, _v), _v.m_temp / 1.0e3 };
+                },
+                [&](uint64_t _ts, double _v) {
+                    TRACE_COUNTER("device_temp", counter_track::at(_dev_id, _idx.at(1)),
+                                  _ts, _v);
+                });
+        }
+
+        if(_settings.power)
+        {
+            _write(
+                [&](const data& _v) {
+                    return sample_t{ _get_ts(_v.m_power_ts, _v), _v.m_power / 1.0e6 };
+                },
+                [&](uint64_t _ts, double _v) {
+                    TRACE_COUNTER("device_power", counter_track::at(_dev_id, _idx.at(2)),
+                                  _ts, _v);
+                });
+        }
+
+        if(_settings.mem_usage)
+        {
+            _write(
+                [&](const data& _v) {
+                    auto _usage = _v.m_mem_usage / static_cast<double>(units::megabyte);
+                    return sample_t{ _get_ts(_v.m_mem_usage_ts, _v), _usage };
+                },
+                [&](uint64_t _ts, double _v) {
+                    TRACE_COUNTER("device_memory_usage",
+                                  counter_track::at(_dev_id, _idx.at(3)), _ts, _v);
+                });
         }
     };
 
@@ -406,13 +745,13 @@ setup()
             {
                 using key_pair_t     = std::pair<std::string_view, bool&>;
                 const auto supported = std::unordered_map<std::string_view, bool&>{
-                    key_pair_t{ "busy", get_settings(dev_id).busy },
-                    key_pair_t{ "temp", get_settings(dev_id).temp },
-                    key_pair_t{ "power", get_settings(dev_id).power },
-                    key_pair_t{ "mem_usage", get_settings(dev_id).mem_usage },
+                    key_pair_t{ "busy", get_settings(itr).busy },
+                    key_pair_t{ "temp", get_settings(itr).temp },
+                    key_pair_t{ "power", get_settings(itr).power },
+                    key_pair_t{ "mem_usage", get_settings(itr).mem_usage },
                 };
 
-                get_settings(dev_id) = { false, false, false, false };
+                get_settings(itr) = { false, false, false, false };
                 for(const auto& metric : tim::delimit(*_metrics, ",;:\t\n "))
                 {
                     auto iitr = supported.find(metric);
@@ -430,6 +769,10 @@ setup()
         is_initialized() = true;
 
         data::setup();
+
+        if(std::any_of(_devices.begin(), _devices.end(),
+                       [](auto itr) { return get_settings(itr).power; }))
+            gpu_energy::setup();
     } catch(std::runtime_error& _e)
     {
         OMNITRACE_VERBOSE(0, "Exception thrown when initializing rocm-smi: %s\n",
@@ -449,6 +792,7 @@ shutdown()
     {
         if(data::shutdown())
         {
+            stop_device_pollers();
             OMNITRACE_ROCM_SMI_CALL(rsmi_shut_down());
         }
     } catch(std::runtime_error& _e)
@@ -460,9 +804,41 @@ shutdown()
     is_initialized() = false;
 }
 
+namespace
+{
+// the average power [watts] at the time it was acquired
+gpu_energy::power_samples_t
+get_power_samples(uint32_t _dev_id)
+{
+    auto        _v           = gpu_energy::power_samples_t{};
+    const auto& _rocm_smi    = sampler_instances::get()->at(_dev_id);
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+
+    if(!_rocm_smi || !_thread_info || !get_settings(_dev_id).power) return _v;
+
+    _v.reserve(_rocm_smi->size());
+    for(size_t i = 0; i < _rocm_smi->size(); ++i)
+    {
+        auto _sample = _rocm_smi->at(i);
+        if(!_thread_info->is_valid_time(_sample.m_ts)) continue;
+        auto _ts = (_sample.m_power_ts > 0) ? _sample.m_power_ts : _sample.m_ts;
+        _v.emplace_back(_ts, _sample.m_power / 1.0e6);
+    }
+    return _v;
+}
+}  // namespace
+
 void
 post_process()
 {
+    if(gpu_energy::is_enabled())
+    {
+        auto _power = gpu_energy::power_data_t{};
+        for(auto itr : data::device_list)
+            _power.emplace(itr, get_power_samples(itr));
+        gpu_energy::post_process(_power);
+    }
+
     for(auto itr : data::device_list)
         data::post_process(itr);
 }
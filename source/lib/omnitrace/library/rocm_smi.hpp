@@ -99,12 +99,16 @@ struct data
 
     static void post_process(uint32_t _dev_id);
 
-    uint32_t    m_dev_id    = std::numeric_limits<uint32_t>::max();
-    timestamp_t m_ts        = 0;
-    busy_perc_t m_busy_perc = 0;
-    temp_t      m_temp      = 0;
-    power_t     m_power     = 0;
-    mem_usage_t m_mem_usage = 0;
+    uint32_t    m_dev_id       = std::numeric_limits<uint32_t>::max();
+    timestamp_t m_ts           = 0;
+    timestamp_t m_busy_ts      = 0;  // acquisition time of each metric
+    timestamp_t m_temp_ts      = 0;
+    timestamp_t m_power_ts     = 0;
+    timestamp_t m_mem_usage_ts = 0;
+    busy_perc_t m_busy_perc    = 0;
+    temp_t      m_temp         = 0;
+    power_t     m_power        = 0;
+    mem_usage_t m_mem_usage    = 0;
 
     friend std::ostream& operator<<(std::ostream& _os, const data& _v)
     {
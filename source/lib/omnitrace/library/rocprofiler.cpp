@@ -26,8 +26,12 @@
 #include "core/debug.hpp"
 #include "core/gpu.hpp"
 #include "core/perfetto.hpp"
+#include "core/state.hpp"
+#include "core/string_arena.hpp"
 #include "library/rocm.hpp"
 #include "library/rocm/hsa_rsrc_factory.hpp"
+#include "library/runtime.hpp"
+#include "library/tracing.hpp"
 
 #include <timemory/backends/hardware_counters.hpp>
 #include <timemory/manager.hpp>
@@ -37,17 +41,30 @@
 
 #include <rocprofiler.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <cerrno>
+#include <cmath>
 #include <cstdlib>
 #include <dlfcn.h>
 #include <hsa.h>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <regex>
+#include <semaphore.h>
+#include <set>
 #include <sstream>
 #include <string.h>
 #include <string_view>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 namespace omnitrace
@@ -65,6 +82,110 @@ get_event_names()
     static auto _v = std::map<uint32_t, std::vector<rocprofiler_feature_t>>{};
     return _v;
 }
+
+// the number of dispatches of a kernel vs. the number of dispatches which the
+// hardware counters were collected for
+struct kernel_dispatch_info
+{
+    bool   eligible  = true;
+    size_t total     = 0;
+    size_t collected = 0;
+};
+
+using kernel_dispatch_key_t = std::pair<uint32_t, std::string>;
+using kernel_dispatch_map_t = std::map<kernel_dispatch_key_t, kernel_dispatch_info>;
+
+auto&
+get_kernel_dispatch_mutex()
+{
+    static auto _v = std::mutex{};
+    return _v;
+}
+
+auto&
+get_kernel_dispatch_info()
+{
+    static auto _v = kernel_dispatch_map_t{};
+    return _v;
+}
+
+bool
+is_kernel_dispatch_policy_active()
+{
+    static bool _v = !config::get_rocm_events_kernel_include().empty() ||
+                     !config::get_rocm_events_kernel_exclude().empty() ||
+                     config::get_rocm_events_dispatch_interval() > 1 ||
+                     config::get_rocm_events_dispatch_limit() > 0;
+    return _v;
+}
+
+std::string
+get_kernel_name(const char* _name)
+{
+    auto _kernel_name = std::string{ _name };
+    auto _pos         = _kernel_name.find_last_of(')');
+    if(_pos != std::string::npos) _kernel_name = _kernel_name.substr(0, _pos + 1);
+    return _kernel_name;
+}
+
+// returns the number of previously collected dispatches of the kernel on the device
+// (used to rotate the counter groups) or nothing if the hardware counters are not
+// collected for this dispatch according to the kernel include/exclude regexes, the
+// dispatch interval, and the dispatch limit
+std::optional<size_t>
+get_kernel_dispatch_ordinal(uint32_t _dev_id, const std::string& _name)
+{
+    static auto _get_regex = [](const std::string& _expr) {
+        return (_expr.empty()) ? std::optional<std::regex>{}
+                               : std::optional<std::regex>{ std::regex{
+                                     _expr, std::regex_constants::optimize } };
+    };
+
+    static const auto _include  = _get_regex(config::get_rocm_events_kernel_include());
+    static const auto _exclude  = _get_regex(config::get_rocm_events_kernel_exclude());
+    static const auto _interval = config::get_rocm_events_dispatch_interval();
+    static const auto _limit    = config::get_rocm_events_dispatch_limit();
+
+    auto  _lk   = std::unique_lock<std::mutex>{ get_kernel_dispatch_mutex() };
+    auto& _data = get_kernel_dispatch_info();
+    auto  _key  = kernel_dispatch_key_t{ _dev_id, _name };
+    auto  _itr  = _data.find(_key);
+    if(_itr == _data.end())
+    {
+        // regexes are only evaluated the first time a kernel is dispatched
+        auto _eligible = (!_include || std::regex_search(_name, *_include)) &&
+                         (!_exclude || !std::regex_search(_name, *_exclude));
+        _itr = _data.emplace(_key, kernel_dispatch_info{ _eligible, 0, 0 }).first;
+    }
+
+    auto& _info = _itr->second;
+    auto  _idx  = _info.total++;
+    if(!_info.eligible) return std::optional<size_t>{};
+    if(_limit > 0 && _info.collected >= _limit) return std::optional<size_t>{};
+    if(_idx % _interval != 0) return std::optional<size_t>{};
+
+    return std::optional<size_t>{ _info.collected++ };
+}
+
+// whether the dispatches were sampled according to the dispatch policy or rotated
+// through multiple counter groups
+bool
+has_kernel_dispatch_info()
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_kernel_dispatch_mutex() };
+    return !get_kernel_dispatch_info().empty();
+}
+
+// total number of dispatches of a kernel on a device if the dispatches were tracked
+std::optional<size_t>
+get_kernel_dispatch_total(uint32_t _dev_id, const std::string& _name)
+{
+    auto  _lk   = std::unique_lock<std::mutex>{ get_kernel_dispatch_mutex() };
+    auto& _data = get_kernel_dispatch_info();
+    auto  _itr  = _data.find(kernel_dispatch_key_t{ _dev_id, _name });
+    if(_itr == _data.end()) return std::optional<size_t>{};
+    return std::optional<size_t>{ _itr->second.total };
+}
 }  // namespace
 
 // Error handler
@@ -112,7 +233,8 @@ struct context_entry_t
 // Context callback arg
 struct callbacks_arg_t
 {
-    rocprofiler_pool_t** pools;
+    rocprofiler_pool_t**   pools;
+    std::atomic<uint32_t>* group_counts;  // zero until the first dispatch on the GPU
 };
 
 // Handler callback arg
@@ -142,6 +264,266 @@ get_data_labels()
     return _v;
 }
 
+// raw counter payload of a completed dispatch which is copied out of the profiling
+// context so that the context can be released before the payload is decoded
+struct raw_dispatch
+{
+    static constexpr size_t max_features = OMNITRACE_ROCM_MAX_COUNTERS;
+
+    uint32_t                                     device_id     = 0;
+    uint32_t                                     thread_id     = 0;
+    uint32_t                                     queue_id      = 0;
+    uint32_t                                     feature_count = 0;
+    component::rocm_metric_type                  begin         = 0;
+    component::rocm_metric_type                  end           = 0;
+    char*                                        kernel_name   = nullptr;
+    std::array<uint32_t, max_features>           feature_index = {};
+    std::array<rocprofiler_data_t, max_features> feature_data  = {};
+};
+
+void
+rocm_decode_dispatch(raw_dispatch& _raw)
+{
+    // copies of the device features whose data is replaced by the payload so that the
+    // rocm_event can be constructed the same way as from the profiling context
+    static thread_local auto _scratch =
+        std::map<uint32_t, std::vector<rocprofiler_feature_t>>{};
+
+    using feature_array_t =
+        std::array<rocprofiler_feature_t*, raw_dispatch::max_features>;
+
+    auto                   _group = feature_array_t{};
+    rocprofiler_feature_t* _base  = nullptr;
+    if(_raw.feature_count > 0)
+    {
+        auto _sitr = _scratch.find(_raw.device_id);
+        if(_sitr == _scratch.end())
+            _sitr = _scratch.emplace(_raw.device_id, get_event_names().at(_raw.device_id))
+                        .first;
+
+        _base = _sitr->second.data();
+        for(uint32_t i = 0; i < _raw.feature_count; ++i)
+        {
+            auto* _feature = &_sitr->second.at(_raw.feature_index.at(i));
+            _feature->data = _raw.feature_data.at(i);
+            _group.at(i)   = _feature;
+        }
+    }
+
+    auto _evt = component::rocm_event{ _raw.device_id,
+                                       _raw.thread_id,
+                                       _raw.queue_id,
+                                       get_kernel_name(_raw.kernel_name),
+                                       _raw.begin,
+                                       _raw.end,
+                                       _raw.feature_count,
+                                       reinterpret_cast<void**>(_group.data()),
+                                       _base };
+
+    component::rocm_data()->emplace_back(std::move(_evt));
+
+    ::free(_raw.kernel_name);
+    _raw.kernel_name = nullptr;
+}
+
+// the completion handler copies the counters of each dispatch into a pre-allocated
+// slot of this bounded multi-producer/single-consumer queue and returns immediately.
+// The background thread decodes the payloads into rocm_event instances. When the
+// queue is full (or the decoder is stopped) the handler decodes the payload itself so
+// that no dispatches are lost.
+struct dispatch_decoder
+{
+    struct slot
+    {
+        std::atomic<size_t> sequence = { 0 };
+        raw_dispatch        payload  = {};
+    };
+
+    explicit dispatch_decoder(size_t _capacity);
+
+    slot* acquire();
+    void  publish(slot*);
+    void  shutdown();
+
+private:
+    void run();
+    bool decode();
+    bool is_ready() const;
+
+    size_t                       m_mask     = 0;
+    size_t                       m_dequeue  = 0;
+    size_t                       m_decoded  = 0;
+    std::unique_ptr<slot[]>      m_slots    = {};
+    std::atomic<size_t>          m_enqueue  = { 0 };
+    std::atomic<size_t>          m_active   = { 0 };
+    std::atomic<size_t>          m_overflow = { 0 };
+    std::atomic<bool>            m_running  = { true };
+    std::atomic<bool>            m_sleeping = { false };
+    sem_t                        m_sem      = {};
+    std::unique_ptr<std::thread> m_thread   = {};
+};
+
+dispatch_decoder::dispatch_decoder(size_t _capacity)
+{
+    // capacity is rounded up to a power of two so the position can be masked
+    size_t _size = 2;
+    while(_size < _capacity)
+        _size <<= 1;
+
+    m_mask  = _size - 1;
+    m_slots = std::make_unique<slot[]>(_size);
+    for(size_t i = 0; i < _size; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+
+    sem_init(&m_sem, 0, 0);
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    m_thread = std::make_unique<std::thread>([this]() { run(); });
+}
+
+dispatch_decoder::slot*
+dispatch_decoder::acquire()
+{
+    // the active count lets the decoder know a producer may still publish a payload
+    // after the decoder has been stopped
+    m_active.fetch_add(1, std::memory_order_seq_cst);
+    if(!m_running.load(std::memory_order_seq_cst))
+    {
+        m_active.fetch_sub(1, std::memory_order_release);
+        return nullptr;
+    }
+
+    auto _pos = m_enqueue.load(std::memory_order_relaxed);
+    while(true)
+    {
+        auto& _slot = m_slots[_pos & m_mask];
+        auto  _seq  = _slot.sequence.load(std::memory_order_acquire);
+        auto  _diff = static_cast<int64_t>(_seq) - static_cast<int64_t>(_pos);
+        if(_diff == 0)
+        {
+            if(m_enqueue.compare_exchange_weak(_pos, _pos + 1, std::memory_order_relaxed))
+                return &_slot;
+        }
+        else if(_diff < 0)
+        {
+            // queue is full
+            m_overflow.fetch_add(1, std::memory_order_relaxed);
+            m_active.fetch_sub(1, std::memory_order_release);
+            return nullptr;
+        }
+        else
+        {
+            _pos = m_enqueue.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void
+dispatch_decoder::publish(slot* _slot)
+{
+    _slot->sequence.fetch_add(1, std::memory_order_release);
+    m_active.fetch_sub(1, std::memory_order_release);
+
+    if(m_sleeping.exchange(false, std::memory_order_seq_cst)) sem_post(&m_sem);
+}
+
+bool
+dispatch_decoder::is_ready() const
+{
+    return m_slots[m_dequeue & m_mask].sequence.load(std::memory_order_acquire) ==
+           m_dequeue + 1;
+}
+
+bool
+dispatch_decoder::decode()
+{
+    if(!is_ready()) return false;
+
+    auto& _slot = m_slots[m_dequeue & m_mask];
+    rocm_decode_dispatch(_slot.payload);
+    _slot.sequence.store(m_dequeue + m_mask + 1, std::memory_order_release);
+
+    ++m_dequeue;
+    ++m_decoded;
+    return true;
+}
+
+void
+dispatch_decoder::run()
+{
+    threading::set_thread_name("omni.rocprof");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    // pre-allocate the storage of the decoded events
+    component::rocm_data()->reserve(m_mask + 1);
+
+    while(true)
+    {
+        while(decode())
+        {}
+
+        if(!m_running.load(std::memory_order_seq_cst))
+        {
+            if(m_active.load(std::memory_order_seq_cst) == 0 && !is_ready()) break;
+            std::this_thread::yield();
+            continue;
+        }
+
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        if(is_ready())
+        {
+            m_sleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        while(sem_wait(&m_sem) != 0 && errno == EINTR)
+        {}
+    }
+}
+
+void
+dispatch_decoder::shutdown()
+{
+    if(!m_running.exchange(false)) return;
+
+    sem_post(&m_sem);
+    if(m_thread) m_thread->join();
+    m_thread.reset();
+
+    OMNITRACE_VERBOSE_F(2,
+                        "rocprofiler decoder thread decoded %zu dispatches (%zu "
+                        "dispatches were decoded by the completion handler because the "
+                        "queue was full)\n",
+                        m_decoded, m_overflow.load());
+}
+
+auto&
+get_dispatch_decoder()
+{
+    static auto* _v = new std::unique_ptr<dispatch_decoder>{};
+    return *_v;
+}
+
+void
+rocm_start_dispatch_decoder()
+{
+    if(get_dispatch_decoder()) return;
+
+    auto _capacity =
+        tim::get_env<size_t>("OMNITRACE_ROCPROFILER_DECODE_QUEUE_SIZE", 4096);
+    if(_capacity == 0) return;
+
+    get_dispatch_decoder() = std::make_unique<dispatch_decoder>(_capacity);
+}
+
+void
+rocm_stop_dispatch_decoder()
+{
+    // the decoder is not destroyed since completion handlers may still be running
+    if(get_dispatch_decoder()) get_dispatch_decoder()->shutdown();
+}
+
 // Dump stored context entry
 void
 rocm_dump_context_entry(context_entry_t* entry, rocprofiler_feature_t* features,
@@ -153,15 +535,13 @@ rocm_dump_context_entry(context_entry_t* entry, rocprofiler_feature_t* features,
         sched_yield();
 
     const rocprofiler_dispatch_record_t* record = entry->data.record;
+    char* _kernel_name = const_cast<char*>(entry->data.kernel_name);
 
-    if(!record) return;  // there is nothing to do here.
-
-    auto _queue_id    = entry->data.queue_id;
-    auto _thread_id   = entry->data.thread_id;
-    auto _dev_id      = HsaRsrcFactory::Instance().GetAgentInfo(entry->agent)->dev_index;
-    auto _kernel_name = std::string{ entry->data.kernel_name };
-    auto _pos         = _kernel_name.find_last_of(')');
-    if(_pos != std::string::npos) _kernel_name = _kernel_name.substr(0, _pos + 1);
+    if(!record)
+    {
+        ::free(_kernel_name);
+        return;  // there is nothing to do here.
+    }
 
     rocprofiler_group_t& group = entry->group;
     if(group.context == nullptr)
@@ -175,11 +555,43 @@ rocm_dump_context_entry(context_entry_t* entry, rocprofiler_feature_t* features,
         rocm_check_status(rocprofiler_get_metrics(group.context));
     }
 
-    auto _evt =
-        component::rocm_event{ _dev_id,       _thread_id,  _queue_id,     _kernel_name,
-                               record->begin, record->end, feature_count, features };
+    // only the features in the group which was collected for this dispatch are valid
+    auto _dev_id      = HsaRsrcFactory::Instance().GetAgentInfo(entry->agent)->dev_index;
+    auto _group_count = (feature_count > 0) ? group.feature_count : 0;
+    if(_group_count > raw_dispatch::max_features)
+    {
+        component::rocm_data()->emplace_back(component::rocm_event{
+            _dev_id, entry->data.thread_id, entry->data.queue_id,
+            get_kernel_name(_kernel_name), record->begin, record->end, _group_count,
+            reinterpret_cast<void**>(group.features), features });
+        ::free(_kernel_name);
+        return;
+    }
+
+    // copy the counters and let the decoder thread construct the rocm_event
+    auto& _decoder = get_dispatch_decoder();
+    auto* _slot    = (_decoder) ? _decoder->acquire() : nullptr;
+    auto  _local   = raw_dispatch{};
+    auto& _payload = (_slot) ? _slot->payload : _local;
+
+    _payload.device_id     = _dev_id;
+    _payload.thread_id     = entry->data.thread_id;
+    _payload.queue_id      = entry->data.queue_id;
+    _payload.feature_count = _group_count;
+    _payload.begin         = record->begin;
+    _payload.end           = record->end;
+    _payload.kernel_name   = _kernel_name;
+    for(uint32_t i = 0; i < _group_count; ++i)
+    {
+        _payload.feature_index.at(i) =
+            static_cast<uint32_t>(std::distance(features, group.features[i]));
+        _payload.feature_data.at(i) = group.features[i]->data;
+    }
 
-    component::rocm_data()->emplace_back(_evt);
+    if(_slot)
+        _decoder->publish(_slot);
+    else
+        rocm_decode_dispatch(_local);
 }
 
 // Profiling completion handler
@@ -208,18 +620,47 @@ rocm_dispatch_callback(const rocprofiler_callback_data_t* callback_data, void* a
     // Passed tool data
     hsa_agent_t agent = callback_data->agent;
 
-    // Open profiling context
     const unsigned   gpu_id = HsaRsrcFactory::Instance().GetAgentInfo(agent)->dev_index;
     callbacks_arg_t* callbacks_arg = reinterpret_cast<callbacks_arg_t*>(arg);
-    rocprofiler_pool_t*      pool  = callbacks_arg->pools[gpu_id];
+    uint32_t         group_count   = callbacks_arg->group_counts[gpu_id].load();
+
+    // when the requested events do not fit in a single pass, the counter groups are
+    // rotated across the successive dispatches of each kernel instead of replaying the
+    // dispatch. Leaving the group context as nullptr skips collection for this dispatch
+    size_t ordinal = 0;
+    if(is_kernel_dispatch_policy_active() || group_count != 1)
+    {
+        auto _ordinal = get_kernel_dispatch_ordinal(
+            gpu_id, get_kernel_name(callback_data->kernel_name));
+        if(!_ordinal) return HSA_STATUS_SUCCESS;
+        ordinal = *_ordinal;
+    }
+
+    // Open profiling context
+    rocprofiler_pool_t*      pool = callbacks_arg->pools[gpu_id];
     rocprofiler_pool_entry_t pool_entry{};
     rocm_check_status(rocprofiler_pool_fetch(pool, &pool_entry));
     // Profiling context entry
     rocprofiler_t*   context = pool_entry.context;
     context_entry_t* entry   = reinterpret_cast<context_entry_t*>(pool_entry.payload);
 
-    // Get group[0]
-    rocm_check_status(rocprofiler_get_group(context, 0, group));
+    if(group_count == 0)
+    {
+        rocm_check_status(rocprofiler_group_count(context, &group_count));
+        group_count = std::max<uint32_t>(group_count, 1);
+        callbacks_arg->group_counts[gpu_id].store(group_count);
+        if(group_count > 1)
+        {
+            OMNITRACE_VERBOSE_F(1,
+                                "ROCm events on device %u require %u counter groups. "
+                                "Groups are rotated across the dispatches of each "
+                                "kernel...\n",
+                                gpu_id, group_count);
+        }
+    }
+
+    // Get the counter group for this dispatch
+    rocm_check_status(rocprofiler_get_group(context, ordinal % group_count, group));
 
     // Fill profiling context entry
     entry->agent            = agent;
@@ -423,8 +864,11 @@ rocm_initialize()
     // Adding dispatch observer
     callbacks_arg_t* callbacks_arg = new callbacks_arg_t{};
     callbacks_arg->pools           = new rocprofiler_pool_t*[gpu_count];
+    callbacks_arg->group_counts    = new std::atomic<uint32_t>[gpu_count];
     for(unsigned gpu_id = 0; gpu_id < gpu_count; gpu_id++)
     {
+        callbacks_arg->group_counts[gpu_id].store(0);
+
         // Getting profiling features
         rocprofiler_feature_t* features      = nullptr;
         unsigned               feature_count = metrics_input(gpu_id, &features);
@@ -459,12 +903,14 @@ rocm_initialize()
 
         // Open profiling pool
         rocprofiler_pool_t* pool = nullptr;
-        uint32_t            mode = 0;  // ROCPROFILER_MODE_SINGLEGROUP
+        uint32_t            mode = 0;  // not ROCPROFILER_MODE_SINGLEGROUP
         rocm_check_status(rocprofiler_pool_open(agent_info->dev_id, features,
                                                 feature_count, &pool, mode, &properties));
         callbacks_arg->pools[gpu_id] = pool;
     }
 
+    rocm_start_dispatch_decoder();
+
     rocprofiler_queue_callbacks_t callbacks_ptrs{};
     callbacks_ptrs.dispatch = rocm_dispatch_callback;
     int err = rocprofiler_set_queue_callbacks(callbacks_ptrs, callbacks_arg);
@@ -478,6 +924,8 @@ rocm_cleanup()
 {
     // Unregister dispatch callback
     rocm_check_status(rocprofiler_remove_queue_callbacks());
+    // decode the remaining payloads
+    rocm_stop_dispatch_decoder();
     // close profiling pool
     // rocm_check_status(rocprofiler_pool_flush(pool));
     // rocm_check_status(rocprofiler_pool_close(pool));
@@ -491,6 +939,235 @@ using rocm_metric_type   = component::rocm_metric_type;
 using rocm_feature_value = component::rocm_feature_value;
 using rocm_data_tracker  = component::rocm_data_tracker;
 
+void
+scale_feature_value(rocm_feature_value& _value, double _weight)
+{
+    auto _scale = [_weight](auto& _v) {
+        using value_type = std::decay_t<decltype(_v)>;
+        if constexpr(std::is_integral<value_type>::value)
+            _v = static_cast<value_type>(std::llround(static_cast<double>(_v) * _weight));
+        else
+            _v = static_cast<value_type>(static_cast<double>(_v) * _weight);
+    };
+    std::visit(_scale, _value);
+}
+
+// scales the values of each kernel by the ratio of the total dispatches to the number
+// of dispatches the feature was collected for (which differs from the number of
+// collected dispatches when the counter groups are rotated). Returns true if any of the
+// values were extrapolated
+bool
+extrapolate_kernel_dispatches(rocm_data_t& _data)
+{
+    using feature_key_t = std::pair<kernel_dispatch_key_t, size_t>;
+
+    auto _counts = std::map<feature_key_t, size_t>{};
+    for(const auto& itr : _data)
+    {
+        for(auto nitr : itr.feature_names)
+            ++_counts[feature_key_t{ kernel_dispatch_key_t{ itr.device_id, itr.name },
+                                     nitr }];
+    }
+
+    bool _extrapolated = false;
+    auto _weights      = std::map<feature_key_t, double>{};
+    for(const auto& itr : _counts)
+    {
+        const auto& _kernel = itr.first.first;
+        auto        _total  = get_kernel_dispatch_total(_kernel.first, _kernel.second);
+        if(!_total || *_total == itr.second) continue;
+        _weights.emplace(itr.first,
+                         static_cast<double>(*_total) / static_cast<double>(itr.second));
+    }
+
+    if(_weights.empty()) return false;
+
+    for(auto& itr : _data)
+    {
+        for(size_t i = 0; i < itr.feature_names.size(); ++i)
+        {
+            auto _key  = kernel_dispatch_key_t{ itr.device_id, itr.name };
+            auto _witr = _weights.find(feature_key_t{ _key, itr.feature_names.at(i) });
+            if(_witr == _weights.end()) continue;
+
+            _extrapolated = true;
+            scale_feature_value(itr.feature_values.at(i), _witr->second);
+        }
+    }
+    return _extrapolated;
+}
+
+void
+report_kernel_dispatches()
+{
+    auto _lk = std::unique_lock<std::mutex>{ get_kernel_dispatch_mutex() };
+    for(const auto& itr : get_kernel_dispatch_info())
+    {
+        OMNITRACE_VERBOSE_F(2,
+                            "Collected hardware counters for %zu of %zu dispatches of "
+                            "%s on device %u\n",
+                            itr.second.collected, itr.second.total,
+                            itr.first.second.c_str(), itr.first.first);
+    }
+}
+
+// how a feature contributes to the roofline metrics of a kernel
+enum roofline_role : uint8_t
+{
+    ROOFLINE_NONE = 0,
+    ROOFLINE_FLOPS,        // FLOPs per unit of the counter
+    ROOFLINE_BYTES_SIZE,   // FETCH_SIZE and WRITE_SIZE [KB]
+    ROOFLINE_BYTES_SUM,    // TCC_EA_RDREQ_sum and TCC_EA_WRREQ_sum
+    ROOFLINE_BYTES_BLOCK,  // TCC_EA_RDREQ[N] and TCC_EA_WRREQ[N]
+    ROOFLINE_BYTES_LAST = ROOFLINE_BYTES_BLOCK,
+};
+
+struct roofline_feature
+{
+    roofline_role role   = ROOFLINE_NONE;
+    double        weight = 0.0;
+};
+
+// the VALU instructions operate on the 64 lanes of a wavefront (an FMA is 2 FLOPs),
+// the MFMA counters are in units of 512 FLOPs and a memory request is approximated by
+// a 64B cache line
+roofline_feature
+get_roofline_feature(std::string_view _label)
+{
+    static const auto _valu  = std::regex{ "SQ_INSTS_VALU_(ADD|MUL|TRANS)_F(16|32|64)" };
+    static const auto _fma   = std::regex{ "SQ_INSTS_VALU_FMA_F(16|32|64)" };
+    static const auto _mfma  = std::regex{ "SQ_INSTS_VALU_MFMA_MOPS_(F16|BF16|F32|F64)" };
+    static const auto _size  = std::regex{ "(FETCH|WRITE)_SIZE" };
+    static const auto _sum   = std::regex{ "TCC_EA_(RDREQ|WRREQ)_sum" };
+    static const auto _block = std::regex{ "TCC_EA_(RDREQ|WRREQ)\\[[0-9]+\\]" };
+
+    auto _name = std::string{ _label };
+    if(std::regex_match(_name, _valu)) return { ROOFLINE_FLOPS, 64.0 };
+    if(std::regex_match(_name, _fma)) return { ROOFLINE_FLOPS, 128.0 };
+    if(std::regex_match(_name, _mfma)) return { ROOFLINE_FLOPS, 512.0 };
+    if(std::regex_match(_name, _size)) return { ROOFLINE_BYTES_SIZE, 1024.0 };
+    if(std::regex_match(_name, _sum)) return { ROOFLINE_BYTES_SUM, 64.0 };
+    if(std::regex_match(_name, _block)) return { ROOFLINE_BYTES_BLOCK, 64.0 };
+    return {};
+}
+
+// the roofline metrics of a kernel on a device aggregated across its dispatches. The
+// FLOPs and bytes are per dispatch since, when the counter groups are rotated, each
+// feature is only collected for a subset of the dispatches
+struct kernel_roofline
+{
+    uint64_t dispatches = 0;
+    uint64_t duration   = 0;  // sum of the dispatch durations [nsec]
+    double   flops      = 0.0;
+    double   bytes      = 0.0;
+    double   peak_flops = 0.0;  // [FLOP/s]
+    double   peak_bytes = 0.0;  // [bytes/s]
+
+    double average() const { return static_cast<double>(duration) / dispatches; }
+    double intensity() const { return (bytes > 0.0) ? (flops / bytes) : 0.0; }
+    double gflops() const { return flops / average(); }
+    double gbytes() const { return bytes / average(); }
+    double flops_peak_pct() const { return percent(gflops() * 1.0e9, peak_flops); }
+    double bytes_peak_pct() const { return percent(gbytes() * 1.0e9, peak_bytes); }
+
+    static double percent(double _v, double _peak)
+    {
+        return (_peak > 0.0) ? (100.0 * _v / _peak) : 0.0;
+    }
+};
+
+using kernel_roofline_map_t = std::map<kernel_dispatch_key_t, kernel_roofline>;
+
+// computed once from the collected values (before they are extrapolated)
+const kernel_roofline_map_t&
+get_kernel_roofline()
+{
+    static auto _v = []() {
+        auto _data = kernel_roofline_map_t{};
+        if(!config::get_rocm_events_roofline()) return _data;
+
+        auto _features = std::map<uint32_t, std::vector<roofline_feature>>{};
+        for(const auto& itr : get_data_labels())
+        {
+            auto& _dev_features = _features[itr.first];
+            for(auto nitr : itr.second)
+                _dev_features.emplace_back(get_roofline_feature(nitr));
+        }
+
+        // sum and number of dispatches of every feature of every kernel
+        using feature_sum_t = std::map<size_t, std::pair<double, uint64_t>>;
+        auto _sums          = std::map<kernel_dispatch_key_t, feature_sum_t>{};
+        for(size_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
+        {
+            auto& _thr_data = component::rocm_data(i);
+            if(!_thr_data) continue;
+            for(const auto& itr : *_thr_data)
+            {
+                auto  _key     = kernel_dispatch_key_t{ itr.device_id, itr.name };
+                auto& _kernel  = _data[_key];
+                auto& _ksums   = _sums[_key];
+                auto& _dev_ftr = _features[itr.device_id];
+                _kernel.dispatches += 1;
+                _kernel.duration += (itr.exit > itr.entry) ? (itr.exit - itr.entry) : 0;
+                for(size_t j = 0; j < itr.feature_names.size(); ++j)
+                {
+                    auto _idx = itr.feature_names.at(j);
+                    if(_idx >= _dev_ftr.size() || _dev_ftr.at(_idx).role == ROOFLINE_NONE)
+                        continue;
+                    auto& _sum = _ksums[_idx];
+                    _sum.first += std::visit(
+                        [](auto _val) { return static_cast<double>(_val); },
+                        itr.feature_values.at(j));
+                    _sum.second += 1;
+                }
+            }
+        }
+
+        for(auto itr = _data.begin(); itr != _data.end();)
+        {
+            const auto& _dev_ftr = _features[itr->first.first];
+            auto&       _kernel  = itr->second;
+
+            // the bytes are taken from the first kind of memory counters collected
+            auto _bytes = std::array<double, ROOFLINE_BYTES_LAST + 1>{};
+            for(const auto& sitr : _sums[itr->first])
+            {
+                const auto& _ftr = _dev_ftr.at(sitr.first);
+                auto _value = _ftr.weight * sitr.second.first / sitr.second.second;
+                if(_ftr.role == ROOFLINE_FLOPS)
+                    _kernel.flops += _value;
+                else
+                    _bytes.at(_ftr.role) += _value;
+            }
+            for(size_t i = ROOFLINE_BYTES_SIZE; i <= ROOFLINE_BYTES_LAST; ++i)
+            {
+                if(_bytes.at(i) <= 0.0) continue;
+                _kernel.bytes = _bytes.at(i);
+                break;
+            }
+
+            if(_kernel.duration == 0 || (_kernel.flops <= 0.0 && _kernel.bytes <= 0.0))
+            {
+                itr = _data.erase(itr);
+                continue;
+            }
+
+            auto _peak   = gpu::get_device_peak(itr->first.first);
+            auto _gflops = config::get_rocm_events_peak_gflops();
+            auto _gbps   = config::get_rocm_events_peak_gbps();
+
+            _kernel.peak_flops = (_gflops > 0.0) ? (_gflops * 1.0e9) : _peak.flops;
+            _kernel.peak_bytes = (_gbps > 0.0) ? (_gbps * 1.0e9) : _peak.bytes;
+            ++itr;
+        }
+
+        OMNITRACE_VERBOSE_F(1, "Computed the roofline metrics of %zu kernels\n",
+                            _data.size());
+        return _data;
+    }();
+    return _v;
+}
+
 void
 post_process_perfetto()
 {
@@ -520,6 +1197,8 @@ post_process_perfetto()
 
     std::sort(_data.begin(), _data.end());
 
+    auto _sampled = has_kernel_dispatch_info();
+
     auto _get_events = [](std::vector<rocm_event*>& _inp, rocm_metric_type _ts) {
         auto _v = std::vector<rocm_event*>{};
         for(const auto& itr : _inp)
@@ -540,14 +1219,17 @@ post_process_perfetto()
             auto _dev_id = itr.device_id;
             if(get_use_perfetto() && !counter_track::exists(_dev_id))
             {
+                // values of the sampled dispatches are not extrapolated in the
+                // trace since they are a time-series of the collected dispatches
                 auto addendum = [&](auto&& _v) {
-                    return JOIN(" ", "Device", _v, JOIN("", '[', _dev_id, ']'));
+                    return JOIN(" ", "Device", _v, JOIN("", '[', _dev_id, ']'),
+                                (_sampled) ? "(sampled)" : "");
                 };
-                for(auto nitr : itr.feature_names)
-                {
-                    auto _name = get_data_labels().at(itr.device_id).at(nitr);
-                    counter_track::emplace(_dev_id, addendum(_name));
-                }
+                // the track index is the feature index since each dispatch may only
+                // have the features of one counter group
+                auto _labels = get_data_labels().at(itr.device_id);
+                for(auto nitr : _labels)
+                    counter_track::emplace(_dev_id, addendum(nitr));
             }
         }
 
@@ -565,7 +1247,8 @@ post_process_perfetto()
     for(auto& ditr : _device_range)
     {
         auto _dev_id         = ditr.first;
-        auto _values         = std::vector<rocm_feature_value>{};
+        auto _values         = std::vector<std::optional<rocm_feature_value>>(
+            get_data_labels().at(_dev_id).size());
         auto _ts_sorted_data = _device_data[_dev_id];
         std::sort(_ts_sorted_data.begin(), _ts_sorted_data.end(),
                   [](auto* _l, auto* _r) { return _l->exit < _r->exit; });
@@ -575,25 +1258,21 @@ post_process_perfetto()
             uint64_t _ts = itr;
             for(auto* vitr : _v)
             {
-                size_t _n = vitr->feature_values.size();
-                if(_values.empty())
+                for(size_t i = 0; i < vitr->feature_names.size(); ++i)
                 {
-                    _values.reserve(_n);
-                    for(size_t i = 0; i < _n; ++i)
+                    auto& _value = _values.at(vitr->feature_names.at(i));
+                    if(!_value)
                     {
-                        _values.emplace_back(vitr->feature_values.at(i));
+                        _value = vitr->feature_values.at(i);
                     }
-                }
-                else
-                {
-                    for(size_t i = 0; i < _n; ++i)
+                    else
                     {
 #ifdef __GNUC__
 #    pragma GCC diagnostic push
 #    pragma GCC diagnostic ignored "-Wdouble-promotion"
 #endif
                         auto _plus = [](auto& _lhs, auto&& _rhs) { _lhs += _rhs; };
-                        std::visit(_plus, _values.at(i), vitr->feature_values.at(i));
+                        std::visit(_plus, *_value, vitr->feature_values.at(i));
 #ifdef __GNUC__
 #    pragma GCC diagnostic pop
 #endif
@@ -603,12 +1282,109 @@ post_process_perfetto()
 
             for(size_t i = 0; i < _values.size(); ++i)
             {
+                if(!_values.at(i)) continue;
                 auto _trace_counter = [_dev_id, i, _ts](auto&& _val) {
                     TRACE_COUNTER("kernel_hardware_counter",
                                   counter_track::at(_dev_id, i), _ts, _val);
                 };
-                std::visit(_trace_counter, _values.at(i));
+                std::visit(_trace_counter, *_values.at(i));
+            }
+        }
+    }
+
+    // the roofline metrics of the kernel are annotated on a slice of every dispatch
+    const auto& _roofline = get_kernel_roofline();
+    if(_roofline.empty()) return;
+
+    auto _track_desc = [](uint32_t _dev_id, uint32_t _queue_id) {
+        return JOIN("", "Roofline Device [", _dev_id, "] Queue [", _queue_id, "]");
+    };
+
+    for(const auto& itr : _data)
+    {
+        auto ritr = _roofline.find(kernel_dispatch_key_t{ itr.device_id, itr.name });
+        if(ritr == _roofline.end()) continue;
+
+        const auto& _kernel = ritr->second;
+        auto        _track  = tracing::get_perfetto_track(
+            category::rocprofiler{}, _track_desc, itr.device_id, itr.queue_id);
+
+        tracing::push_perfetto_track(
+            category::rocprofiler{}, intern_string(itr.name), _track, itr.entry,
+            [&](::perfetto::EventContext ctx) {
+                tracing::add_perfetto_annotation(ctx, "flops", _kernel.flops);
+                tracing::add_perfetto_annotation(ctx, "bytes", _kernel.bytes);
+                tracing::add_perfetto_annotation(ctx, "intensity", _kernel.intensity());
+                tracing::add_perfetto_annotation(ctx, "gflops", _kernel.gflops());
+                tracing::add_perfetto_annotation(ctx, "gbytes_per_sec", _kernel.gbytes());
+                tracing::add_perfetto_annotation(ctx, "flops_peak_pct",
+                                                 _kernel.flops_peak_pct());
+                tracing::add_perfetto_annotation(ctx, "bytes_peak_pct",
+                                                 _kernel.bytes_peak_pct());
+            });
+        tracing::pop_perfetto_track(category::rocprofiler{}, "", _track, itr.exit);
+    }
+}
+
+// one storage per roofline metric and device with an entry for every kernel
+void
+post_process_roofline_timemory()
+{
+    using storage_type  = typename rocm_data_tracker::storage_type;
+    using bundle_type   = tim::lightweight_tuple<rocm_data_tracker>;
+    using metric_func_t = double (*)(const kernel_roofline&);
+    using metric_t      = std::tuple<const char*, const char*, metric_func_t>;
+
+    const auto& _roofline = get_kernel_roofline();
+    if(_roofline.empty()) return;
+
+    static const auto _metrics = std::array<metric_t, 7>{
+        metric_t{ "roofline-flops", "FLOPs per dispatch",
+                  [](const kernel_roofline& _v) { return _v.flops; } },
+        metric_t{ "roofline-bytes", "Bytes moved from/to memory per dispatch",
+                  [](const kernel_roofline& _v) { return _v.bytes; } },
+        metric_t{ "roofline-intensity", "Arithmetic intensity [FLOP/byte]",
+                  [](const kernel_roofline& _v) { return _v.intensity(); } },
+        metric_t{ "roofline-gflops", "Achieved GFLOP/s",
+                  [](const kernel_roofline& _v) { return _v.gflops(); } },
+        metric_t{ "roofline-gbytes-per-sec", "Achieved memory bandwidth [GB/s]",
+                  [](const kernel_roofline& _v) { return _v.gbytes(); } },
+        metric_t{ "roofline-flops-peak", "Achieved percent of the peak FLOP/s",
+                  [](const kernel_roofline& _v) { return _v.flops_peak_pct(); } },
+        metric_t{ "roofline-bytes-peak", "Achieved percent of the peak memory bandwidth",
+                  [](const kernel_roofline& _v) { return _v.bytes_peak_pct(); } },
+    };
+
+    auto _devices = std::set<uint32_t>{};
+    for(const auto& itr : _roofline)
+        _devices.emplace(itr.first.first);
+
+    auto _labels = get_data_labels();
+    auto _scope  = scope::get_default();
+    for(auto _dev_id : _devices)
+    {
+        // the storage indexes follow the indexes of the device features
+        auto _offset = _labels[_dev_id].size();
+        for(size_t i = 0; i < _metrics.size(); ++i)
+        {
+            const auto& [_name, _desc, _func] = _metrics.at(i);
+
+            auto _storage = std::make_unique<storage_type>(
+                tim::standalone_storage{}, static_cast<int64_t>(_offset + i),
+                JOIN('-', "rocprof", "device", _dev_id, _name));
+            operation::set_storage<rocm_data_tracker>{}(_storage.get());
+
+            for(const auto& itr : _roofline)
+            {
+                if(itr.first.first != _dev_id) continue;
+                bundle_type _bundle{ itr.first.second, _scope };
+                _bundle.push(0).start().store(rocm_feature_value{ _func(itr.second) });
+                _bundle.stop().pop(0);
             }
+
+            rocm_data_tracker::label()       = _name;
+            rocm_data_tracker::description() = _desc;
+            _storage->write();
         }
     }
 }
@@ -640,6 +1416,8 @@ post_process_timemory()
 
     std::sort(_data.begin(), _data.end());
 
+    static bool _extrapolated = extrapolate_kernel_dispatches(_data);
+
     for(auto& itr : _data)
     {
         _device_data[itr.device_id].emplace_back(&itr);
@@ -700,12 +1478,22 @@ post_process_timemory()
         void operator()(int64_t _index, scope::config _scope) const
         {
             if(!parent) return;
-            bundle_type _bundle{ parent->name, _scope };
-            _bundle.push(parent->queue_id)
-                .start()
-                .store(parent->feature_values.at(_index));
 
             std::sort(children.begin(), children.end());
+
+            // the feature was in a counter group which was not collected for this
+            // dispatch
+            const auto* _value = parent->find(_index);
+            if(!_value)
+            {
+                for(const auto& itr : children)
+                    itr(_index, _scope);
+                return;
+            }
+
+            bundle_type _bundle{ parent->name, _scope };
+            _bundle.push(parent->queue_id).start().store(*_value);
+
             for(const auto& itr : children)
                 itr(_index, _scope);
 
@@ -725,6 +1513,8 @@ post_process_timemory()
         , metric_name{ _name }
         , metric_description{ _get_description(metric_name) }
         {
+            if(_extrapolated)
+                metric_description += " (extrapolated from the sampled dispatches)";
             auto _metric_name = std::string{ _name };
             _metric_name      = std::regex_replace(
                 _metric_name, std::regex{ "(.*)\\[([0-9]+)\\]" }, "$1_$2");
@@ -754,19 +1544,13 @@ post_process_timemory()
     {
         OMNITRACE_VERBOSE_F(1, "Post-processing %zu entries for device %u...\n",
                             ditr.second.size(), ditr.first);
+        // one storage per device feature since each dispatch may only have the
+        // features of one counter group
         auto _storage = std::vector<local_storage>{};
-        for(auto& itr : ditr.second)
-        {
-            auto _n = itr->feature_names.size();
-            if(_n > _storage.size())
-            {
-                _storage.reserve(_n);
-                for(size_t i = _storage.size(); i < _n; ++i)
-                    _storage.emplace_back(
-                        ditr.first, i,
-                        get_data_labels().at(ditr.first).at(itr->feature_names.at(i)));
-            }
-        }
+        auto _labels  = get_data_labels().at(ditr.first);
+        _storage.reserve(_labels.size());
+        for(size_t i = 0; i < _labels.size(); ++i)
+            _storage.emplace_back(ditr.first, i, _labels.at(i));
 
         auto& _local = _local_data[ditr.first];
         _local.reserve(ditr.second.size());
@@ -808,6 +1592,8 @@ post_process_timemory()
             itr.write();
     }
 
+    post_process_roofline_timemory();
+
     tim::trait::runtime_enabled<omnitrace::rocprofiler::rocm_data_tracker>::set(false);
 }
 }  // namespace
@@ -815,6 +1601,9 @@ post_process_timemory()
 void
 post_process()
 {
+    rocm_stop_dispatch_decoder();
+    report_kernel_dispatches();
+
     if(get_use_perfetto()) post_process_perfetto();
 
     if(get_use_timemory())
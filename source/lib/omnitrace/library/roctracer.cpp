@@ -27,7 +27,14 @@
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/locking.hpp"
+#include "core/string_arena.hpp"
+#include "library/causal/device.hpp"
 #include "library/components/category_region.hpp"
+#include "library/components/rccl_bandwidth.hpp"
+#include "library/critical_path.hpp"
+#include "library/gpu_energy.hpp"
+#include "library/gpu_memory.hpp"
+#include "library/rocm/hsa_rsrc_factory.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
@@ -37,12 +44,31 @@
 #include <timemory/backends/cpu.hpp>
 #include <timemory/backends/threading.hpp>
 #include <timemory/hash/types.hpp>
+#include <timemory/manager.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/tpls/cereal/types.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 
 #include <roctracer_ext.h>
 #include <roctracer_hip.h>
@@ -62,19 +88,18 @@
 #    define OMNITRACE_HIP_API_ARGS 0
 #endif
 
+// the HIP graphs and the stream capture are traced with ROCm 5.2 and newer
+#if OMNITRACE_HIP_VERSION >= 50200
+#    define OMNITRACE_HIP_GRAPHS 1
+#else
+#    define OMNITRACE_HIP_GRAPHS 0
+#endif
+
 TIMEMORY_DEFINE_API(roctracer)
 namespace omnitrace
 {
 namespace
 {
-template <typename Tp>
-auto&
-roctracer_type_mutex()
-{
-    return tim::type_mutex<Tp, category::roctracer, max_supported_threads,
-                           locking::atomic_mutex>();
-}
-
 std::string
 hip_api_string(hip_api_id_t id, const hip_api_data_t* data)
 {
@@ -114,20 +139,854 @@ get_roctracer_hip_data(int64_t _tid = threading::get_id())
     return thread_data_t::instance(construct_on_thread{ _tid });
 }
 
-std::unordered_map<uint64_t, const char*>&
-get_roctracer_key_data()
+// kernel name, launching thread, and launch time of the HIP API calls for the activity
+// records.
+// The correlation ids are monotonic so the entries are stored in a ring indexed by
+// the correlation id and the slot is tagged with the full correlation id to detect
+// entries which were overwritten. The HIP API callbacks and the activity callback
+// never lock: the slot is written like a seqlock (invalidate the tag, write the
+// data, publish the tag) and the reader re-checks the tag after reading the data.
+// An activity record which arrives after more than "size" subsequent kernel
+// launches is not found, i.e. it is treated like an untraced kernel
+struct correlation_table
+{
+    static constexpr uint64_t size       = (1 << 16);
+    static constexpr uint64_t invalid_id = std::numeric_limits<uint64_t>::max();
+
+    void emplace(uint64_t _cid, const char* _name, int64_t _tid, int64_t _launch_ns)
+    {
+        auto& _slot = m_slots[_cid % size];
+        _slot.cid.store(invalid_id, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _slot.name.store(_name, std::memory_order_relaxed);
+        _slot.tid.store(_tid, std::memory_order_relaxed);
+        _slot.launch_ns.store(_launch_ns, std::memory_order_relaxed);
+        _slot.cid.store(_cid, std::memory_order_release);
+    }
+
+    bool find(uint64_t _cid, const char*& _name, int64_t& _tid, int64_t& _launch_ns) const
+    {
+        const auto& _slot = m_slots[_cid % size];
+        if(_slot.cid.load(std::memory_order_acquire) != _cid) return false;
+        auto _name_v   = _slot.name.load(std::memory_order_relaxed);
+        auto _tid_v    = _slot.tid.load(std::memory_order_relaxed);
+        auto _launch_v = _slot.launch_ns.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(_slot.cid.load(std::memory_order_relaxed) != _cid) return false;
+        _name      = _name_v;
+        _tid       = _tid_v;
+        _launch_ns = _launch_v;
+        return true;
+    }
+
+private:
+    struct slot
+    {
+        std::atomic<uint64_t>    cid       = { invalid_id };
+        std::atomic<const char*> name      = { nullptr };
+        std::atomic<int64_t>     tid       = { 0 };
+        std::atomic<int64_t>     launch_ns = { 0 };
+    };
+
+    std::array<slot, size> m_slots = {};
+};
+
+correlation_table&
+get_roctracer_correlation_table()
+{
+    static auto* _v = new correlation_table{};
+    return *_v;
+}
+
+// launch configuration of a kernel launch (OMNITRACE_ROCTRACER_KERNEL_OCCUPANCY)
+struct launch_config
+{
+    std::array<uint32_t, 3> grid   = { 0, 0, 0 };  /// number of blocks
+    std::array<uint32_t, 3> block  = { 0, 0, 0 };  /// number of threads per block
+    uint32_t                shared = 0;            /// dynamic shared memory in bytes
+
+    uint64_t blocks() const { return uint64_t{ grid[0] } * grid[1] * grid[2]; }
+    uint64_t threads() const { return uint64_t{ block[0] } * block[1] * block[2]; }
+};
+
+// the launch configurations keyed by the correlation id, written and read with the
+// same protocol as the correlation table
+struct launch_config_table
+{
+    static constexpr uint64_t size       = correlation_table::size;
+    static constexpr uint64_t invalid_id = correlation_table::invalid_id;
+
+    void emplace(uint64_t _cid, const launch_config& _cfg)
+    {
+        auto& _slot = m_slots[_cid % size];
+        _slot.cid.store(invalid_id, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _slot.grid_xy.store(pack(_cfg.grid[0], _cfg.grid[1]), std::memory_order_relaxed);
+        _slot.grid_z.store(pack(_cfg.grid[2], _cfg.shared), std::memory_order_relaxed);
+        _slot.block_xy.store(pack(_cfg.block[0], _cfg.block[1]),
+                             std::memory_order_relaxed);
+        _slot.block_z.store(_cfg.block[2], std::memory_order_relaxed);
+        _slot.cid.store(_cid, std::memory_order_release);
+    }
+
+    bool find(uint64_t _cid, launch_config& _cfg) const
+    {
+        const auto& _slot = m_slots[_cid % size];
+        if(_slot.cid.load(std::memory_order_acquire) != _cid) return false;
+        auto _grid_xy  = _slot.grid_xy.load(std::memory_order_relaxed);
+        auto _grid_z   = _slot.grid_z.load(std::memory_order_relaxed);
+        auto _block_xy = _slot.block_xy.load(std::memory_order_relaxed);
+        auto _block_z  = _slot.block_z.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(_slot.cid.load(std::memory_order_relaxed) != _cid) return false;
+        _cfg.grid   = { lo(_grid_xy), hi(_grid_xy), lo(_grid_z) };
+        _cfg.block  = { lo(_block_xy), hi(_block_xy), _block_z };
+        _cfg.shared = hi(_grid_z);
+        return true;
+    }
+
+private:
+    static uint64_t pack(uint32_t _lo, uint32_t _hi)
+    {
+        return (uint64_t{ _hi } << 32) | uint64_t{ _lo };
+    }
+    static uint32_t lo(uint64_t _v) { return static_cast<uint32_t>(_v); }
+    static uint32_t hi(uint64_t _v) { return static_cast<uint32_t>(_v >> 32); }
+
+    struct slot
+    {
+        std::atomic<uint64_t> cid      = { invalid_id };
+        std::atomic<uint64_t> grid_xy  = { 0 };
+        std::atomic<uint64_t> grid_z   = { 0 };  /// grid z and the shared memory
+        std::atomic<uint64_t> block_xy = { 0 };
+        std::atomic<uint32_t> block_z  = { 0 };
+    };
+
+    std::array<slot, size> m_slots = {};
+};
+
+launch_config_table&
+get_roctracer_launch_config_table()
+{
+    static auto* _v = new launch_config_table{};
+    return *_v;
+}
+
+bool
+get_kernel_occupancy_enabled()
+{
+    static auto _v = config::get_roctracer_kernel_occupancy();
+    return _v;
+}
+
+// theoretical occupancy of a kernel dispatch: the number of waves resident on a
+// compute unit relative to the wave slots given the register, LDS and wave slot
+// limits of the device and the number of blocks in the grid
+struct occupancy_info
+{
+    uint32_t    vgprs         = 0;
+    uint32_t    sgprs         = 0;
+    uint32_t    lds_bytes     = 0;  /// static + dynamic LDS per block
+    uint32_t    scratch_bytes = 0;  /// per work-item
+    uint32_t    waves_per_cu  = 0;  /// resident waves per compute unit
+    uint32_t    max_waves     = 0;  /// wave slots per compute unit
+    double      occupancy     = 0.0;
+    const char* limiter       = "waves";
+};
+
+std::optional<occupancy_info>
+compute_kernel_occupancy(const char* _name, const launch_config& _cfg)
+{
+    using ::rocprofiler::util::AgentInfo;
+    using ::rocprofiler::util::HsaRsrcFactory;
+    using ::rocprofiler::util::KernelResources;
+
+    if(_cfg.threads() == 0 || _cfg.blocks() == 0)
+        return std::optional<occupancy_info>{};
+
+    auto _res = KernelResources{};
+    if(!HsaRsrcFactory::IsExecutableTracking() ||
+       !HsaRsrcFactory::GetKernelResources(_name, &_res))
+        return std::optional<occupancy_info>{};
+
+    const AgentInfo* _agent = HsaRsrcFactory::Instance().GetAgentInfo(_res.agent);
+    if(!_agent || _agent->simds_per_cu == 0 || _agent->cu_num == 0)
+        return std::optional<occupancy_info>{};
+
+    auto _arch     = std::string_view{ _agent->name };
+    bool _gfx9     = (_arch.find("gfx9") == 0);
+    bool _unified  = (_arch.find("gfx90a") == 0 || _arch.find("gfx94") == 0);
+    auto _simds    = _agent->simds_per_cu;
+    auto _max_simd = _agent->waves_per_cu / _simds;
+
+    auto _v          = occupancy_info{};
+    _v.max_waves     = _max_simd * _simds;
+    _v.lds_bytes     = _res.group_segment_size + _cfg.shared;
+    _v.scratch_bytes = _res.private_segment_size;
+
+    // the waves which fit in a SIMD given the registers allocated per wave. The VGPRs
+    // are allocated in granules of 8 for wave32 and for the unified VGPR/AGPR file of
+    // gfx90a/gfx94x, otherwise in granules of 4. The SGPRs only limit gfx9
+    auto _waves_simd = _max_simd;
+    if(_res.has_descriptor)
+    {
+        uint32_t _vgpr_file = (_unified || !_gfx9) ? 512 : 256;
+        if(_res.wave32) _vgpr_file *= 2;
+        _v.vgprs = (_res.vgpr_granules + 1) * ((_res.wave32 || _unified) ? 8 : 4);
+        if(_v.vgprs > 0 && _vgpr_file / _v.vgprs < _waves_simd)
+        {
+            _waves_simd = _vgpr_file / _v.vgprs;
+            _v.limiter  = "vgpr";
+        }
+        if(_gfx9)
+        {
+            constexpr uint32_t _sgpr_file = 800;
+            _v.sgprs = (_res.sgpr_granules + 1) * 16;
+            if(_sgpr_file / _v.sgprs < _waves_simd)
+            {
+                _waves_simd = _sgpr_file / _v.sgprs;
+                _v.limiter  = "sgpr";
+            }
+        }
+    }
+
+    uint64_t _wave_size  = (_res.wave32) ? 32 : 64;
+    uint64_t _block_wave = (_cfg.threads() + _wave_size - 1) / _wave_size;
+    uint64_t _blocks_cu  = (_waves_simd * _simds) / _block_wave;
+
+    // the LDS available to the blocks of a compute unit
+    constexpr uint64_t _lds_cu = 65536;
+    if(_v.lds_bytes > 0 && _lds_cu / _v.lds_bytes < _blocks_cu)
+    {
+        _blocks_cu = _lds_cu / _v.lds_bytes;
+        _v.limiter = "lds";
+    }
+
+    // the grid does not have enough blocks to fill every compute unit
+    uint64_t _grid_cu = (_cfg.blocks() + _agent->cu_num - 1) / _agent->cu_num;
+    if(_grid_cu < _blocks_cu)
+    {
+        _blocks_cu = _grid_cu;
+        _v.limiter = "grid";
+    }
+
+    _v.waves_per_cu = static_cast<uint32_t>(
+        std::min<uint64_t>(_blocks_cu * _block_wave, _v.max_waves));
+    _v.occupancy = (_v.max_waves > 0) ? static_cast<double>(_v.waves_per_cu) /
+                                            static_cast<double>(_v.max_waves)
+                                      : 0.0;
+    return _v;
+}
+
+// reads the launch configuration from the arguments of the kernel launch APIs
+std::optional<launch_config>
+get_launch_config(uint32_t cid, const hip_api_data_t* data)
 {
-    static auto _v = std::unordered_map<uint64_t, const char*>{};
+    auto _dim3 = [](const dim3& _v) {
+        return std::array<uint32_t, 3>{ _v.x, _v.y, _v.z };
+    };
+    auto _div  = [](uint32_t _global, uint32_t _local) {
+        return (_local > 0) ? ((_global + _local - 1) / _local) : 0;
+    };
+
+    auto _v = launch_config{};
+    switch(cid)
+    {
+        case HIP_API_ID_hipLaunchKernel:
+        {
+            const auto& _args = data->args.hipLaunchKernel;
+            _v = { _dim3(_args.numBlocks), _dim3(_args.dimBlocks),
+                   static_cast<uint32_t>(_args.sharedMemBytes) };
+            break;
+        }
+        case HIP_API_ID_hipLaunchCooperativeKernel:
+        {
+            const auto& _args = data->args.hipLaunchCooperativeKernel;
+            _v = { _dim3(_args.gridDim), _dim3(_args.blockDimX), _args.sharedMemBytes };
+            break;
+        }
+        case HIP_API_ID_hipExtLaunchKernel:
+        {
+            const auto& _args = data->args.hipExtLaunchKernel;
+            _v = { _dim3(_args.numBlocks), _dim3(_args.dimBlocks),
+                   static_cast<uint32_t>(_args.sharedMemBytes) };
+            break;
+        }
+        case HIP_API_ID_hipModuleLaunchKernel:
+        {
+            const auto& _args = data->args.hipModuleLaunchKernel;
+            _v = { { _args.gridDimX, _args.gridDimY, _args.gridDimZ },
+                   { _args.blockDimX, _args.blockDimY, _args.blockDimZ },
+                   _args.sharedMemBytes };
+            break;
+        }
+        case HIP_API_ID_hipHccModuleLaunchKernel:
+        {
+            // the grid is the total number of work-items
+            const auto& _args = data->args.hipHccModuleLaunchKernel;
+            _v = { { _div(_args.globalWorkSizeX, _args.blockDimX),
+                     _div(_args.globalWorkSizeY, _args.blockDimY),
+                     _div(_args.globalWorkSizeZ, _args.blockDimZ) },
+                   { _args.blockDimX, _args.blockDimY, _args.blockDimZ },
+                   static_cast<uint32_t>(_args.sharedMemBytes) };
+            break;
+        }
+        case HIP_API_ID_hipExtModuleLaunchKernel:
+        {
+            // the grid is the total number of work-items
+            const auto& _args = data->args.hipExtModuleLaunchKernel;
+            _v = { { _div(_args.globalWorkSizeX, _args.localWorkSizeX),
+                     _div(_args.globalWorkSizeY, _args.localWorkSizeY),
+                     _div(_args.globalWorkSizeZ, _args.localWorkSizeZ) },
+                   { _args.localWorkSizeX, _args.localWorkSizeY, _args.localWorkSizeZ },
+                   static_cast<uint32_t>(_args.sharedMemBytes) };
+            break;
+        }
+        default: return std::optional<launch_config>{};
+    }
+    return _v;
+}
+
+// HIP graph tracing (OMNITRACE_ROCTRACER_GRAPH_TRACING): the kernels of a graph
+// launch share the correlation id of the hipGraphLaunch call so the n-th kernel
+// dispatch of a launch is attributed to the n-th kernel node of the graph in
+// dependency order
+struct hip_graph_node
+{
+    const char*         name         = nullptr;  /// kernel name (nullptr if not a kernel)
+    int                 type         = 0;
+    std::vector<size_t> dependencies = {};
+};
+
+struct hip_graph_info
+{
+    uint64_t                    id        = 0;   /// sequential id of the instantiation
+    uintptr_t                   stream    = 0;   /// capturing stream (0 == not captured)
+    bool                        captured  = false;
+    std::vector<hip_graph_node> nodes     = {};
+    std::vector<size_t>         kernels   = {};  /// kernel nodes in dependency order
+    const char*                 label     = nullptr;
+    uint64_t                    launches  = 0;
+    uint64_t                    completed = 0;   /// launches with every kernel traced
+    uint64_t                    overhead  = 0;   /// launch call to first kernel begin
+    uint64_t                    span_ns   = 0;   /// first kernel begin to last kernel end
+    uint64_t                    span_min  = std::numeric_limits<uint64_t>::max();
+    uint64_t                    span_max  = 0;
+    uint64_t                    kernel_ns = 0;   /// sum of the kernel durations
+    std::vector<uint64_t>       node_ns   = {};  /// per kernel node durations
+};
+
+struct hip_graph_launch
+{
+    hip_graph_info* graph     = nullptr;
+    int64_t         tid       = 0;
+    int64_t         launch_ns = 0;
+    int32_t         device_id = 0;
+    size_t          kernels   = 0;
+    uint64_t        beg_ns    = std::numeric_limits<uint64_t>::max();
+    uint64_t        end_ns    = 0;
+    uint64_t        busy_ns   = 0;
+};
+
+struct hip_graph_registry
+{
+    locking::atomic_mutex                                          mutex    = {};
+    uint64_t                                                       count    = 0;
+    std::unordered_map<uintptr_t, uintptr_t>                       captured = {};
+    std::unordered_map<uintptr_t, std::unique_ptr<hip_graph_info>> execs    = {};
+    std::unordered_map<uint64_t, hip_graph_launch>                 launches = {};
+    std::vector<std::unique_ptr<hip_graph_info>>                   retired  = {};
+};
+
+hip_graph_registry&
+get_hip_graph_registry()
+{
+    static auto* _v = new hip_graph_registry{};
+    return *_v;
+}
+
+bool
+get_hip_graph_tracing()
+{
+    static auto _v = config::get_roctracer_graph_tracing();
     return _v;
 }
 
+// the HIP API calls which inspect the graph invoke the HIP API callback
+thread_local bool hip_graph_query = false;
+
+#if OMNITRACE_HIP_GRAPHS > 0
+// reads the nodes and the dependencies of a graph after it is instantiated
+std::unique_ptr<hip_graph_info>
+make_hip_graph_info(hipGraph_t _graph)
+{
+    auto _info = std::make_unique<hip_graph_info>();
+
+    hip_graph_query = true;
+    scope::destructor _dtor{ []() { hip_graph_query = false; } };
+
+    size_t _n = 0;
+    if(hipGraphGetNodes(_graph, nullptr, &_n) != hipSuccess || _n == 0) return _info;
+
+    auto _nodes = std::vector<hipGraphNode_t>(_n);
+    if(hipGraphGetNodes(_graph, _nodes.data(), &_n) != hipSuccess) return _info;
+    _nodes.resize(_n);
+
+    auto _index = std::unordered_map<hipGraphNode_t, size_t>{};
+    for(size_t i = 0; i < _nodes.size(); ++i)
+        _index.emplace(_nodes.at(i), i);
+
+    _info->nodes.resize(_nodes.size());
+    for(size_t i = 0; i < _nodes.size(); ++i)
+    {
+        auto& _node = _info->nodes.at(i);
+        auto  _type = hipGraphNodeTypeEmpty;
+        if(hipGraphNodeGetType(_nodes.at(i), &_type) == hipSuccess)
+            _node.type = static_cast<int>(_type);
+
+        if(_type == hipGraphNodeTypeKernel)
+        {
+            auto _params = hipKernelNodeParams{};
+            if(hipGraphKernelNodeGetParams(_nodes.at(i), &_params) == hipSuccess)
+                _node.name = hipKernelNameRefByPtr(_params.func, nullptr);
+            if(!_node.name) _node.name = "unknown-kernel";
+        }
+
+        size_t _ndeps = 0;
+        if(hipGraphNodeGetDependencies(_nodes.at(i), nullptr, &_ndeps) == hipSuccess &&
+           _ndeps > 0)
+        {
+            auto _deps = std::vector<hipGraphNode_t>(_ndeps);
+            if(hipGraphNodeGetDependencies(_nodes.at(i), _deps.data(), &_ndeps) ==
+               hipSuccess)
+            {
+                for(size_t j = 0; j < _ndeps; ++j)
+                {
+                    auto ditr = _index.find(_deps.at(j));
+                    if(ditr != _index.end())
+                        _node.dependencies.emplace_back(ditr->second);
+                }
+            }
+        }
+    }
+
+    // the kernel nodes in dependency order (the order of the nodes breaks the ties)
+    auto _indegree = std::vector<size_t>(_info->nodes.size(), 0);
+    auto _children = std::vector<std::vector<size_t>>(_info->nodes.size());
+    for(size_t i = 0; i < _info->nodes.size(); ++i)
+    {
+        for(auto ditr : _info->nodes.at(i).dependencies)
+        {
+            ++_indegree.at(i);
+            _children.at(ditr).emplace_back(i);
+        }
+    }
+
+    auto _ready = std::set<size_t>{};
+    for(size_t i = 0; i < _indegree.size(); ++i)
+        if(_indegree.at(i) == 0) _ready.emplace(i);
+
+    while(!_ready.empty())
+    {
+        auto _idx = *_ready.begin();
+        _ready.erase(_ready.begin());
+        if(_info->nodes.at(_idx).name) _info->kernels.emplace_back(_idx);
+        for(auto citr : _children.at(_idx))
+            if(--_indegree.at(citr) == 0) _ready.emplace(citr);
+    }
+
+    _info->node_ns.resize(_info->kernels.size(), 0);
+    return _info;
+}
+#endif
+
+// the graph node of a kernel dispatch of a graph launch
+struct hip_graph_kernel
+{
+    uint64_t    graph_id  = 0;
+    size_t      node      = 0;
+    const char* name      = nullptr;
+    int64_t     tid       = 0;
+    int64_t     launch_ns = 0;
+};
+
+void
+complete_hip_graph_launch(hip_graph_launch& _launch);
+
+std::optional<hip_graph_kernel>
+attribute_hip_graph_kernel(uint64_t _cid, int32_t _device_id, uint64_t _beg_ns,
+                           uint64_t _end_ns)
+{
+    if(_end_ns < _beg_ns) std::swap(_beg_ns, _end_ns);
+
+    auto& _registry = get_hip_graph_registry();
+    auto  _lk       = locking::atomic_lock{ _registry.mutex };
+
+    auto itr = _registry.launches.find(_cid);
+    if(itr == _registry.launches.end()) return std::optional<hip_graph_kernel>{};
+
+    auto& _launch = itr->second;
+    auto* _graph  = _launch.graph;
+    if(_launch.kernels >= _graph->kernels.size())
+        return std::optional<hip_graph_kernel>{};
+
+    auto _idx         = _launch.kernels++;
+    auto _node        = _graph->kernels.at(_idx);
+    _launch.device_id = _device_id;
+    _launch.beg_ns    = std::min(_launch.beg_ns, _beg_ns);
+    _launch.end_ns    = std::max(_launch.end_ns, _end_ns);
+    _launch.busy_ns += (_end_ns - _beg_ns);
+    _graph->node_ns.at(_idx) += (_end_ns - _beg_ns);
+
+    auto _v = hip_graph_kernel{ _graph->id, _node, _graph->nodes.at(_node).name,
+                                _launch.tid, _launch.launch_ns };
+
+    if(_launch.kernels == _graph->kernels.size())
+    {
+        complete_hip_graph_launch(_launch);
+        _registry.launches.erase(itr);
+    }
+
+    return _v;
+}
+
+// accumulates the timing of a launch once every kernel of it was traced and emits a
+// slice spanning the kernels of the launch
+void
+complete_hip_graph_launch(hip_graph_launch& _launch)
+{
+    auto* _graph = _launch.graph;
+    auto  _span  = _launch.end_ns - _launch.beg_ns;
+
+    ++_graph->completed;
+    _graph->span_ns += _span;
+    _graph->span_min = std::min(_graph->span_min, _span);
+    _graph->span_max = std::max(_graph->span_max, _span);
+    _graph->kernel_ns += _launch.busy_ns;
+    auto _launch_ns = static_cast<uint64_t>(std::max<int64_t>(_launch.launch_ns, 0));
+    if(_launch_ns > 0 && _launch.beg_ns >= _launch_ns)
+        _graph->overhead += _launch.beg_ns - _launch_ns;
+
+    if(!get_use_perfetto()) return;
+
+    auto _track_desc = [](int32_t _device_id) {
+        return JOIN("", "HIP Graph Launches Device ", _device_id);
+    };
+
+    const auto _track = tracing::get_perfetto_track(category::device_hip{}, _track_desc,
+                                                    _launch.device_id);
+
+    tracing::push_perfetto_track(
+        category::device_hip{}, _graph->label, _track, _launch.beg_ns,
+        [&](::perfetto::EventContext ctx) {
+            if(config::get_snapshot().perfetto_annotations)
+            {
+                tracing::add_perfetto_annotation(ctx, "graph", _graph->id);
+                tracing::add_perfetto_annotation(ctx, "kernels", _launch.kernels);
+                tracing::add_perfetto_annotation(ctx, "busy_ns", _launch.busy_ns);
+                tracing::add_perfetto_annotation(ctx, "launch_ns", _launch.launch_ns);
+                tracing::add_perfetto_annotation(ctx, "tid", _launch.tid);
+            }
+        });
+    tracing::pop_perfetto_track(category::device_hip{}, "", _track, _launch.end_ns);
+}
+
+// start time of the HIP API calls of the thread for causal experiments
 std::unordered_map<uint64_t, int64_t>&
-get_roctracer_tid_data()
+get_causal_hip_api_begin()
+{
+    static thread_local auto _v = std::unordered_map<uint64_t, int64_t>{};
+    return _v;
+}
+
+// the HIP API calls which block the host until the device completes the prior work
+bool
+is_device_synchronization(uint32_t _cid)
+{
+    switch(_cid)
+    {
+        case HIP_API_ID_hipDeviceSynchronize:
+        case HIP_API_ID_hipStreamSynchronize:
+        case HIP_API_ID_hipEventSynchronize:
+        case HIP_API_ID_hipMemcpy: return true;
+        default: break;
+    }
+    return false;
+}
+
+// start time of the device synchronization of the thread for the critical path
+int64_t&
+get_critical_path_sync_begin()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
+// summary of the calls to one HIP API function on one thread within the current
+// aggregation window (OMNITRACE_ROCTRACER_HIP_API_AGGREGATE)
+struct hip_api_summary
+{
+    const char* name     = nullptr;
+    uint64_t    count    = 0;
+    int64_t     beg_ns   = 0;
+    int64_t     end_ns   = 0;
+    int64_t     total_ns = 0;
+    int64_t     min_ns   = std::numeric_limits<int64_t>::max();
+    int64_t     max_ns   = 0;
+
+    void add(const char* _name, int64_t _beg, int64_t _end)
+    {
+        auto _elapsed = _end - _beg;
+        if(count++ == 0)
+        {
+            name   = _name;
+            beg_ns = _beg;
+        }
+        end_ns = _end;
+        total_ns += _elapsed;
+        min_ns = std::min(min_ns, _elapsed);
+        max_ns = std::max(max_ns, _elapsed);
+    }
+};
+
+struct hip_api_aggregate
+{
+    std::unordered_map<uint64_t, int64_t>         begin   = {};  // correlation id
+    std::unordered_map<uint32_t, hip_api_summary> summary = {};  // HIP API id
+};
+
+auto&
+get_hip_api_aggregate(int64_t _tid = threading::get_id())
 {
-    static auto _v = std::unordered_map<uint64_t, int64_t>{};
+    using thread_data_t = thread_data<hip_api_aggregate, category::roctracer>;
+    return thread_data_t::instance(construct_on_thread{ _tid });
+}
+
+bool
+get_hip_api_aggregate_enabled()
+{
+    static auto _v = get_use_perfetto() && config::get_roctracer_hip_api_aggregate();
+    return _v;
+}
+
+// length of the aggregation window in nanoseconds
+int64_t
+get_hip_api_aggregate_window()
+{
+    static auto _v = std::max<int64_t>(
+        static_cast<int64_t>(config::get_roctracer_hip_api_aggregate_window() *
+                             units::msec),
+        1);
+    return _v;
+}
+
+// minimum duration in nanoseconds of the HIP API calls which are traced individually
+int64_t
+get_hip_api_aggregate_threshold()
+{
+    static auto _v = [] {
+        auto _thres = config::get_roctracer_hip_api_aggregate_threshold();
+        return (_thres > 0.0) ? static_cast<int64_t>(_thres * units::usec)
+                              : std::numeric_limits<int64_t>::max();
+    }();
     return _v;
 }
 
+// emits one slice spanning the calls in the window on a per-thread, per-function
+// track and resets the summary
+void
+emit_hip_api_summary(int64_t _tid, uint32_t _api_id, hip_api_summary& _summary)
+{
+    if(_summary.count == 0 || _summary.name == nullptr) return;
+
+    auto _track_desc = [&_summary](int64_t _tid_v, uint32_t) {
+        return JOIN("", "HIP API Summary [", _tid_v, "] ", _summary.name);
+    };
+
+    const auto _track =
+        tracing::get_perfetto_track(category::rocm_hip{}, _track_desc, _tid, _api_id);
+
+    tracing::push_perfetto_track(
+        category::rocm_hip{}, _summary.name, _track, _summary.beg_ns,
+        [&](::perfetto::EventContext ctx) {
+            auto _count = static_cast<int64_t>(_summary.count);
+            tracing::add_perfetto_annotation(ctx, "calls", _summary.count);
+            tracing::add_perfetto_annotation(ctx, "total_ns", _summary.total_ns);
+            tracing::add_perfetto_annotation(ctx, "mean_ns", _summary.total_ns / _count);
+            tracing::add_perfetto_annotation(ctx, "min_ns", _summary.min_ns);
+            tracing::add_perfetto_annotation(ctx, "max_ns", _summary.max_ns);
+            tracing::add_perfetto_annotation(ctx, "tid", _tid);
+        });
+    tracing::pop_perfetto_track(category::rocm_hip{}, "", _track, _summary.end_ns);
+
+    _summary = hip_api_summary{};
+}
+
+// records the allocations and releases of the HIP memory API on exit of the call
+// (OMNITRACE_ROCTRACER_MEMORY_TRACKING)
+void
+hip_memory_callback(uint32_t cid, const hip_api_data_t* data, int32_t _device,
+                    uint64_t _ts)
+{
+    using gpu_memory::allocation_kind;
+
+    auto _allocate = [_device, _ts](allocation_kind _kind, void** _ptr, size_t _bytes) {
+        if(_ptr) gpu_memory::allocate(_kind, _device, *_ptr, _bytes, _ts);
+    };
+
+    switch(cid)
+    {
+        case HIP_API_ID_hipMalloc:
+        {
+            _allocate(allocation_kind::device, data->args.hipMalloc.ptr,
+                      data->args.hipMalloc.size);
+            break;
+        }
+        case HIP_API_ID_hipExtMallocWithFlags:
+        {
+            _allocate(allocation_kind::device, data->args.hipExtMallocWithFlags.ptr,
+                      data->args.hipExtMallocWithFlags.sizeBytes);
+            break;
+        }
+        case HIP_API_ID_hipMallocPitch:
+        {
+            const auto& _args = data->args.hipMallocPitch;
+            if(_args.pitch)
+                _allocate(allocation_kind::device, _args.ptr,
+                          *_args.pitch * _args.height);
+            break;
+        }
+        case HIP_API_ID_hipMallocManaged:
+        {
+            _allocate(allocation_kind::managed, data->args.hipMallocManaged.dev_ptr,
+                      data->args.hipMallocManaged.size);
+            break;
+        }
+        case HIP_API_ID_hipHostMalloc:
+        {
+            _allocate(allocation_kind::host, data->args.hipHostMalloc.ptr,
+                      data->args.hipHostMalloc.size);
+            break;
+        }
+#if OMNITRACE_HIP_VERSION_MAJOR > 5 ||                                                   \
+    (OMNITRACE_HIP_VERSION_MAJOR == 5 && OMNITRACE_HIP_VERSION_MINOR >= 3)
+        case HIP_API_ID_hipMallocAsync:
+        {
+            _allocate(allocation_kind::device, data->args.hipMallocAsync.dev_ptr,
+                      data->args.hipMallocAsync.size);
+            break;
+        }
+        case HIP_API_ID_hipFreeAsync:
+        {
+            gpu_memory::deallocate(data->args.hipFreeAsync.dev_ptr, _ts);
+            break;
+        }
+#endif
+        case HIP_API_ID_hipFree:
+        {
+            gpu_memory::deallocate(data->args.hipFree.ptr, _ts);
+            break;
+        }
+        case HIP_API_ID_hipHostFree:
+        {
+            gpu_memory::deallocate(data->args.hipHostFree.ptr, _ts);
+            break;
+        }
+        default: break;
+    }
+}
+
+// records the graphs created by the stream capture, the nodes of the instantiated
+// graphs and the correlation id of the graph launches
+// (OMNITRACE_ROCTRACER_GRAPH_TRACING)
+void
+hip_graph_callback(uint32_t cid, const hip_api_data_t* data, uint32_t _phase,
+                   uint64_t _roct_cid, int64_t _tid, int64_t _ts)
+{
+#if OMNITRACE_HIP_GRAPHS > 0
+    auto& _registry = get_hip_graph_registry();
+
+    auto _instantiate = [&_registry](hipGraphExec_t* _exec, hipGraph_t _graph) {
+        if(!_exec || !*_exec || !_graph) return;
+
+        auto _info = make_hip_graph_info(_graph);
+        auto _lk   = locking::atomic_lock{ _registry.mutex };
+        auto itr   = _registry.captured.find(reinterpret_cast<uintptr_t>(_graph));
+        if(itr != _registry.captured.end())
+        {
+            _info->captured = true;
+            _info->stream   = itr->second;
+        }
+        _info->id    = _registry.count++;
+        _info->label = intern_string(JOIN("", "HIP Graph ", _info->id));
+
+        auto& _entry = _registry.execs[reinterpret_cast<uintptr_t>(*_exec)];
+        if(_entry) _registry.retired.emplace_back(std::move(_entry));
+        _entry = std::move(_info);
+    };
+
+    if(_phase == ACTIVITY_API_PHASE_ENTER)
+    {
+        if(cid != HIP_API_ID_hipGraphLaunch) return;
+
+        auto _lk = locking::atomic_lock{ _registry.mutex };
+        auto itr = _registry.execs.find(
+            reinterpret_cast<uintptr_t>(data->args.hipGraphLaunch.graphExec));
+        if(itr == _registry.execs.end() || itr->second->kernels.empty()) return;
+
+        ++itr->second->launches;
+        _registry.launches[_roct_cid] = hip_graph_launch{ itr->second.get(), _tid, _ts };
+        return;
+    }
+
+    switch(cid)
+    {
+        case HIP_API_ID_hipStreamEndCapture:
+        {
+            const auto& _args = data->args.hipStreamEndCapture;
+            if(!_args.pGraph || !*_args.pGraph) break;
+            auto _lk = locking::atomic_lock{ _registry.mutex };
+            _registry.captured[reinterpret_cast<uintptr_t>(*_args.pGraph)] =
+                reinterpret_cast<uintptr_t>(_args.stream);
+            break;
+        }
+        case HIP_API_ID_hipGraphInstantiate:
+        {
+            _instantiate(data->args.hipGraphInstantiate.pGraphExec,
+                         data->args.hipGraphInstantiate.graph);
+            break;
+        }
+        case HIP_API_ID_hipGraphInstantiateWithFlags:
+        {
+            _instantiate(data->args.hipGraphInstantiateWithFlags.pGraphExec,
+                         data->args.hipGraphInstantiateWithFlags.graph);
+            break;
+        }
+        case HIP_API_ID_hipGraphDestroy:
+        {
+            auto _lk = locking::atomic_lock{ _registry.mutex };
+            _registry.captured.erase(
+                reinterpret_cast<uintptr_t>(data->args.hipGraphDestroy.graph));
+            break;
+        }
+        case HIP_API_ID_hipGraphExecDestroy:
+        {
+            // launches in flight may still reference the info
+            auto _lk = locking::atomic_lock{ _registry.mutex };
+            auto itr = _registry.execs.find(
+                reinterpret_cast<uintptr_t>(data->args.hipGraphExecDestroy.pGraphExec));
+            if(itr == _registry.execs.end()) break;
+            _registry.retired.emplace_back(std::move(itr->second));
+            _registry.execs.erase(itr);
+            break;
+        }
+        default: break;
+    }
+#else
+    tim::consume_parameters(cid, data, _phase, _roct_cid, _tid, _ts);
+#endif
+}
+
 auto&
 get_hip_activity_callbacks(int64_t _tid = threading::get_id())
 {
@@ -145,7 +1004,6 @@ get_hip_activity_callbacks_size()
 }
 
 using hip_activity_mutex_t = std::decay_t<decltype(get_hip_activity_callbacks())>;
-using key_data_mutex_t     = std::decay_t<decltype(get_roctracer_key_data())>;
 
 auto&
 get_hip_activity_mutex(int64_t _tid = threading::get_id())
@@ -156,67 +1014,194 @@ get_hip_activity_mutex(int64_t _tid = threading::get_id())
 }
 }  // namespace
 
+namespace
+{
+// a synchronization point of the piecewise-linear model of the offset between the
+// CPU clock and the roctracer (GPU) clock
+struct clock_skew_point
+{
+    uint64_t gpu_ns = 0;  /// roctracer timestamp of the synchronization
+    int64_t  offset = 0;  /// CPU timestamp - roctracer timestamp
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        ar(tim::cereal::make_nvp("gpu_ns", gpu_ns),
+           tim::cereal::make_nvp("offset", offset));
+    }
+};
+
+// the model is halved (every other point is dropped) when it reaches this size
+constexpr size_t max_clock_skew_points = (1 << 14);
+
+bool
+use_clock_skew()
+{
+    static auto _v = tim::get_env("OMNITRACE_USE_ROCTRACER_CLOCK_SKEW", true);
+    return _v;
+}
+
+auto&
+get_clock_skew_mutex()
+{
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+auto&
+get_clock_skew_model()
+{
+    static auto* _v = new std::vector<clock_skew_point>{};
+    return *_v;
+}
+
+// We'll take a CPU timestamp before and after taking a GPU timestamp, then take the
+// average of those two, hoping that it's roughly at the same time as the GPU
+// timestamp. Returns the average offset and the average GPU timestamp of the samples
+clock_skew_point
+measure_clock_skew(int64_t _n = 10)
+{
+    namespace cpu = tim::cpu;
+
+    auto _cpu_now = []() {
+        cpu::fence();
+        return comp::wall_clock::record();
+    };
+
+    auto _gpu_now = []() {
+        cpu::fence();
+        uint64_t _ts = 0;
+        OMNITRACE_ROCTRACER_CALL(roctracer_get_timestamp(&_ts));
+        return _ts;
+    };
+
+    do
+    {
+        // warm up cache and allow for any static initialization
+        (void) _cpu_now();
+        (void) _gpu_now();
+    } while(false);
+
+    auto _compute = [&](volatile uint64_t& _cpu_ts, volatile uint64_t& _gpu_ts) {
+        _cpu_ts = 0;
+        _gpu_ts = 0;
+        _cpu_ts += _cpu_now() / 2;
+        _gpu_ts += _gpu_now() / 1;
+        _cpu_ts += _cpu_now() / 2;
+        return static_cast<int64_t>(_cpu_ts) - static_cast<int64_t>(_gpu_ts);
+    };
+
+    int64_t _cpu_ave = 0;
+    int64_t _gpu_ave = 0;
+    int64_t _diff    = 0;
+    for(int64_t i = 0; i < _n; ++i)
+    {
+        volatile uint64_t _cpu_ts = 0;
+        volatile uint64_t _gpu_ts = 0;
+        _diff += _compute(_cpu_ts, _gpu_ts);
+        _cpu_ave += _cpu_ts / _n;
+        _gpu_ave += _gpu_ts / _n;
+    }
+
+    OMNITRACE_BASIC_VERBOSE(3, "CPU timestamp: %li\n", _cpu_ave);
+    OMNITRACE_BASIC_VERBOSE(3, "HIP timestamp: %li\n", _gpu_ave);
+
+    return clock_skew_point{ static_cast<uint64_t>(_gpu_ave), _diff / _n };
+}
+}  // namespace
+
 //
 int64_t
 get_clock_skew()
 {
-    static auto _use = tim::get_env("OMNITRACE_USE_ROCTRACER_CLOCK_SKEW", true);
-    if(!_use) return 0;
+    if(!use_clock_skew()) return 0;
     static auto _v = []() {
-        namespace cpu = tim::cpu;
-        // synchronize timestamps
-        // We'll take a CPU timestamp before and after taking a GPU timestmp, then
-        // take the average of those two, hoping that it's roughly at the same time
-        // as the GPU timestamp.
-        static auto _cpu_now = []() {
-            cpu::fence();
-            return comp::wall_clock::record();
-        };
-
-        static auto _gpu_now = []() {
-            cpu::fence();
-            uint64_t _ts = 0;
-            OMNITRACE_ROCTRACER_CALL(roctracer_get_timestamp(&_ts));
-            return _ts;
-        };
+        auto _point = measure_clock_skew();
+        OMNITRACE_BASIC_VERBOSE(1, "CPU/HIP timestamp skew: %li (used: %s)\n",
+                                _point.offset, use_clock_skew() ? "yes" : "no");
 
-        do
         {
-            // warm up cache and allow for any static initialization
-            (void) _cpu_now();
-            (void) _gpu_now();
-        } while(false);
+            auto _lk = locking::atomic_lock{ get_clock_skew_mutex() };
+            get_clock_skew_model().emplace_back(_point);
+        }
 
-        auto _compute = [](volatile uint64_t& _cpu_ts, volatile uint64_t& _gpu_ts) {
-            _cpu_ts = 0;
-            _gpu_ts = 0;
-            _cpu_ts += _cpu_now() / 2;
-            _gpu_ts += _gpu_now() / 1;
-            _cpu_ts += _cpu_now() / 2;
-            return static_cast<int64_t>(_cpu_ts) - static_cast<int64_t>(_gpu_ts);
-        };
-        constexpr int64_t _n       = 10;
-        int64_t           _cpu_ave = 0;
-        int64_t           _gpu_ave = 0;
-        int64_t           _diff    = 0;
-        for(int64_t i = 0; i < _n; ++i)
-        {
-            volatile uint64_t _cpu_ts = 0;
-            volatile uint64_t _gpu_ts = 0;
-            _diff += _compute(_cpu_ts, _gpu_ts);
-            _cpu_ave += _cpu_ts / _n;
-            _gpu_ave += _gpu_ts / _n;
-        }
-        OMNITRACE_BASIC_VERBOSE(2, "CPU timestamp: %li\n", _cpu_ave);
-        OMNITRACE_BASIC_VERBOSE(2, "HIP timestamp: %li\n", _gpu_ave);
-        OMNITRACE_BASIC_VERBOSE(1, "CPU/HIP timestamp skew: %li (used: %s)\n", _diff,
-                                _use ? "yes" : "no");
-        _diff /= _n;
-        return _diff;
+        tim::manager::instance()->add_metadata([](auto& ar) {
+            auto _lk = locking::atomic_lock{ get_clock_skew_mutex() };
+            ar(tim::cereal::make_nvp("roctracer_clock_skew", get_clock_skew_model()));
+        });
+
+        return _point.offset;
     }();
     return _v;
 }
 
+int64_t
+get_clock_skew(uint64_t _gpu_ns)
+{
+    if(!use_clock_skew()) return 0;
+
+    auto _init = get_clock_skew();
+    auto _lk   = locking::atomic_lock{ get_clock_skew_mutex() };
+
+    const auto& _model = get_clock_skew_model();
+    if(_model.size() < 2) return _init;
+
+    auto _interpolate = [_gpu_ns](const clock_skew_point& _lhs,
+                                  const clock_skew_point& _rhs) {
+        if(_rhs.gpu_ns <= _lhs.gpu_ns) return _rhs.offset;
+        auto _drift = static_cast<double>(_rhs.offset - _lhs.offset) /
+                      static_cast<double>(_rhs.gpu_ns - _lhs.gpu_ns);
+        auto _delta = static_cast<double>(_gpu_ns) - static_cast<double>(_lhs.gpu_ns);
+        return _lhs.offset + static_cast<int64_t>(std::llround(_drift * _delta));
+    };
+
+    // first synchronization point after the timestamp
+    auto itr = std::upper_bound(
+        _model.begin(), _model.end(), _gpu_ns,
+        [](uint64_t _lhs, const clock_skew_point& _rhs) { return _lhs < _rhs.gpu_ns; });
+
+    if(itr == _model.begin()) return itr->offset;
+    // after the last synchronization: extrapolate the drift of the last segment
+    if(itr == _model.end()) return _interpolate(*(itr - 2), *(itr - 1));
+    return _interpolate(*(itr - 1), *itr);
+}
+
+void
+update_clock_skew()
+{
+    if(!use_clock_skew()) return;
+
+    static auto _interval =
+        tim::get_env<double>("OMNITRACE_ROCTRACER_CLOCK_SKEW_INTERVAL", 1.0);
+    static auto _last = uint64_t{ 0 };
+
+    if(_interval <= 0.0) return;
+
+    auto _now = tracing::now();
+    if(_last > 0 && _now < _last + static_cast<uint64_t>(_interval * units::sec))
+        return;
+    _last = _now;
+
+    (void) get_clock_skew();
+    auto _point = measure_clock_skew();
+
+    auto  _lk    = locking::atomic_lock{ get_clock_skew_mutex() };
+    auto& _model = get_clock_skew_model();
+    if(_model.empty() || _point.gpu_ns <= _model.back().gpu_ns) return;
+
+    OMNITRACE_BASIC_VERBOSE(3, "CPU/HIP timestamp skew: %li (drift: %li)\n",
+                            _point.offset, _point.offset - _model.back().offset);
+
+    if(_model.size() >= max_clock_skew_points)
+    {
+        size_t _n = 0;
+        for(size_t i = 0; i < _model.size(); i += 2)
+            _model.at(_n++) = _model.at(i);
+        _model.resize(_n);
+    }
+    _model.emplace_back(_point);
+}
+
 // HSA API callback function
 void
 hsa_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void* arg)
@@ -293,29 +1278,16 @@ hsa_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
 
                 if(begin_timestamp > end_timestamp) return;
 
-                if(get_use_perfetto())
+                if(config::get_snapshot().use_perfetto)
                 {
                     uint64_t _beg_ts = begin_timestamp;
                     uint64_t _end_ts = end_timestamp;
-                    tracing::push_perfetto_ts(category::rocm_hsa{}, _name, _beg_ts,
-                                              [&](::perfetto::EventContext ctx) {
-                                                  if(config::get_perfetto_annotations())
-                                                  {
-                                                      tracing::add_perfetto_annotation(
-                                                          ctx, "begin_ns", _beg_ts);
-                                                  }
-                                              });
+                    tracing::push_perfetto_ts(category::rocm_hsa{}, _name, _beg_ts);
                     tracing::pop_perfetto_ts(category::rocm_hsa{}, _name, _end_ts,
-                                             [&](::perfetto::EventContext ctx) {
-                                                 if(config::get_perfetto_annotations())
-                                                 {
-                                                     tracing::add_perfetto_annotation(
-                                                         ctx, "end_ns", _end_ts);
-                                                 }
-                                             });
+                                             [](::perfetto::EventContext) {});
                 }
 
-                if(get_use_timemory())
+                if(config::get_snapshot().use_timemory)
                 {
                     auto _beg_ns = begin_timestamp;
                     auto _end_ns = end_timestamp;
@@ -336,29 +1308,126 @@ hsa_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
     }
 }
 
+namespace
+{
+// GPU activity (kernel or copy) retained for the timeline analysis
+struct timeline_record
+{
+    int32_t  device_id = 0;
+    uint32_t op        = 0;
+    int64_t  queue_id  = 0;
+    int64_t  launch_ns = 0;  /// CPU timestamp of the HIP API call (0 == unknown)
+    uint64_t beg_ns    = 0;
+    uint64_t end_ns    = 0;
+};
+
+auto&
+get_timeline_mutex()
+{
+    static auto _v = locking::atomic_mutex{};
+    return _v;
+}
+
+auto&
+get_timeline_records()
+{
+    static auto* _v = new std::vector<timeline_record>{};
+    return *_v;
+}
+
+// the timemory aggregation of the records of an activity buffer. The records are
+// collected while the buffer is converted and then handed off as one task (HSA)
+// or one callback per launching thread (HIP) instead of one per record
+struct activity_batch
+{
+    struct entry
+    {
+        const char* name      = nullptr;
+        uint64_t    beg_ns    = 0;
+        uint64_t    end_ns    = 0;
+        double      occupancy = -1.0;  /// theoretical occupancy (< 0 == unknown)
+    };
+
+    std::vector<entry>                              hsa      = {};
+    std::unordered_map<int64_t, std::vector<entry>> hip      = {};
+    std::vector<timeline_record>                    timeline = {};
+
+    void flush();
+};
+
 void
-hsa_activity_callback(uint32_t op, const void* vrecord, void* arg)
+activity_batch::flush()
 {
-    const auto* record = static_cast<const activity_record_t*>(vrecord);
+    if(!hsa.empty() && tasking::roctracer::get_task_group().pool())
+    {
+        tasking::roctracer::get_task_group().exec([_data = std::move(hsa)]() {
+            if(!config::get_snapshot().use_timemory) return;
+            for(const auto& itr : _data)
+            {
+                auto                   _dur = itr.end_ns - itr.beg_ns;
+                roctracer_hsa_bundle_t _bundle{ itr.name };
+                _bundle.start()
+                    .store(std::plus<double>{}, static_cast<double>(_dur))
+                    .stop();
+            }
+        });
+    }
+    hsa.clear();
 
-    if(get_state() != State::Active || !trait::runtime_enabled<comp::roctracer>::get())
-        return;
+    for(auto& titr : hip)
+    {
+        if(titr.second.empty()) continue;
+        auto _func = [_data = std::move(titr.second)]() {
+            for(const auto& itr : _data)
+            {
+                auto                   _dur = itr.end_ns - itr.beg_ns;
+                roctracer_hip_bundle_t _bundle{ itr.name };
+                _bundle.start()
+                    .store(std::plus<double>{}, static_cast<double>(_dur))
+                    .stop()
+                    .get<comp::wall_clock>([&](comp::wall_clock* wc) {
+                        wc->set_value(_dur);
+                        wc->set_accum(_dur);
+                        return wc;
+                    });
+                _bundle.pop();
 
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+                if(itr.occupancy >= 0.0)
+                {
+                    tim::auto_tuple<comp::kernel_occupancy> _occ{ itr.name };
+                    _occ.store(std::plus<double>{}, 100.0 * itr.occupancy);
+                }
+            }
+        };
 
-    auto&& _protect = comp::roctracer::protect_flush_activity();
-    (void) _protect;
+        auto&                _async_ops = get_hip_activity_callbacks(titr.first);
+        locking::atomic_lock _lk{ get_hip_activity_mutex(titr.first) };
+        _async_ops->emplace_back(std::move(_func));
+    }
+    hip.clear();
+
+    if(!timeline.empty())
+    {
+        auto  _lk      = locking::atomic_lock{ get_timeline_mutex() };
+        auto& _records = get_timeline_records();
+        _records.insert(_records.end(), timeline.begin(), timeline.end());
+    }
+    timeline.clear();
+}
 
+void
+hsa_activity_record(uint32_t op, const activity_record_t* record, activity_batch& _batch)
+{
     static const char* copy_op_name     = "hsa_async_copy";
     static const char* dispatch_op_name = "hsa_dispatch";
     static const char* barrier_op_name  = "hsa_barrier";
-    const char**       _name            = nullptr;
+    const char*        _name            = nullptr;
 
     switch(op)
     {
-        case HSA_OP_ID_DISPATCH: _name = &dispatch_op_name; break;
-        case HSA_OP_ID_COPY: _name = &copy_op_name; break;
-        case HSA_OP_ID_BARRIER: _name = &barrier_op_name; break;
+        case HSA_OP_ID_DISPATCH: _name = dispatch_op_name; break;
+        case HSA_OP_ID_COPY: _name = copy_op_name; break;
+        case HSA_OP_ID_BARRIER: _name = barrier_op_name; break;
         default: break;
     }
 
@@ -367,44 +1436,42 @@ hsa_activity_callback(uint32_t op, const void* vrecord, void* arg)
 
     if(!_name) return;
 
-    auto _beg_ns = record->begin_ns + get_clock_skew();
-    auto _end_ns = record->end_ns + get_clock_skew();
+    auto _beg_ns = record->begin_ns + get_clock_skew(record->begin_ns);
+    auto _end_ns = record->end_ns + get_clock_skew(record->end_ns);
 
-    if(get_use_perfetto())
+    if(config::get_snapshot().use_perfetto)
     {
         uint64_t _beg = _beg_ns;
         uint64_t _end = _end_ns;
-        tracing::push_perfetto_ts(
-            category::device_hsa{}, *_name, _beg, [&](::perfetto::EventContext ctx) {
-                if(config::get_perfetto_annotations())
-                {
-                    tracing::add_perfetto_annotation(ctx, "begin_ns", _beg);
-                }
-            });
-        tracing::pop_perfetto_ts(
-            category::device_hsa{}, *_name, _end, [&](::perfetto::EventContext ctx) {
-                if(config::get_perfetto_annotations())
-                {
-                    tracing::add_perfetto_annotation(ctx, "end_ns", _end);
-                }
-            });
+        tracing::push_perfetto_ts(category::device_hsa{}, _name, _beg);
+        tracing::pop_perfetto_ts(category::device_hsa{}, _name, _end,
+                                 [](::perfetto::EventContext) {});
     }
 
-    auto _func = [_beg_ns, _end_ns, _name]() {
-        if(get_use_timemory())
-        {
-            roctracer_hsa_bundle_t _bundle{ *_name };
-            _bundle.start()
-                .store(std::plus<double>{}, static_cast<double>(_end_ns - _beg_ns))
-                .stop();
-        }
-    };
+    // timemory is disabled in this callback because collecting data in this thread
+    // causes strange segmentation faults so the records are aggregated in a task
+    if(config::get_snapshot().use_timemory)
+        _batch.hsa.emplace_back(activity_batch::entry{ _name, _beg_ns, _end_ns });
+}
+}  // namespace
+
+void
+hsa_activity_callback(uint32_t op, const void* vrecord, void* arg)
+{
+    const auto* record = static_cast<const activity_record_t*>(vrecord);
+
+    if(get_state() != State::Active || !trait::runtime_enabled<comp::roctracer>::get())
+        return;
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto&& _protect = comp::roctracer::protect_flush_activity();
+    (void) _protect;
 
-    if(tasking::roctracer::get_task_group().pool())
-        tasking::roctracer::get_task_group().exec(_func);
+    auto _batch = activity_batch{};
+    hsa_activity_record(op, record, _batch);
+    _batch.flush();
 
-    // timemory is disabled in this callback because collecting data in this thread
-    // causes strange segmentation faults
     tim::consume_parameters(arg);
 }
 
@@ -428,7 +1495,81 @@ hip_exec_activity_callbacks(int64_t _tid)
 namespace
 {
 thread_local std::unordered_map<size_t, size_t> gpu_crit_cids = {};
-}
+
+// lock-free table of the (interned) messages of the roctxRangeStart/roctxRangeStop
+// ranges indexed by the range id. The range ids are increasing so the ranges which are
+// open at the same time rarely collide: collisions are resolved with a bounded linear
+// probe and the ranges which do not fit are stored in a locked map. The slots are never
+// reset to empty so a lookup can stop at the first empty slot
+struct roctx_range_table
+{
+    static constexpr size_t   table_size = 4096;
+    static constexpr size_t   max_probe  = 16;
+    static constexpr uint64_t empty_key  = 0;
+    static constexpr uint64_t erased_key = std::numeric_limits<uint64_t>::max();
+
+    struct slot
+    {
+        std::atomic<uint64_t>    key     = { empty_key };
+        std::atomic<const char*> message = { nullptr };
+    };
+
+    void insert(roctx_range_id_t _id, const char* _message)
+    {
+        const auto _key = key(_id);
+        for(size_t i = 0; i < max_probe; ++i)
+        {
+            auto& itr  = m_slots[(_id + i) % table_size];
+            auto  _cur = itr.key.load(std::memory_order_relaxed);
+            if(_cur != empty_key && _cur != erased_key) continue;
+            if(!itr.key.compare_exchange_strong(_cur, _key, std::memory_order_acq_rel))
+                continue;
+            // the range cannot be stopped before roctxRangeStart returns its id
+            itr.message.store(_message, std::memory_order_release);
+            return;
+        }
+
+        locking::atomic_lock _lk{ m_overflow_lock };
+        m_overflow.emplace(_id, _message);
+        m_overflow_size.store(m_overflow.size(), std::memory_order_release);
+    }
+
+    // returns nullptr if the range id is unknown
+    const char* erase(roctx_range_id_t _id)
+    {
+        const auto _key = key(_id);
+        for(size_t i = 0; i < max_probe; ++i)
+        {
+            auto& itr  = m_slots[(_id + i) % table_size];
+            auto  _cur = itr.key.load(std::memory_order_acquire);
+            if(_cur == empty_key) break;
+            if(_cur != _key) continue;
+            const auto* _message = itr.message.load(std::memory_order_acquire);
+            itr.key.store(erased_key, std::memory_order_release);
+            return _message;
+        }
+
+        if(m_overflow_size.load(std::memory_order_acquire) == 0) return nullptr;
+
+        locking::atomic_lock _lk{ m_overflow_lock };
+        auto                 itr = m_overflow.find(_id);
+        if(itr == m_overflow.end()) return nullptr;
+        const auto* _message = itr->second;
+        m_overflow.erase(itr);
+        m_overflow_size.store(m_overflow.size(), std::memory_order_release);
+        return _message;
+    }
+
+private:
+    // zero marks an empty slot
+    static uint64_t key(roctx_range_id_t _id) { return static_cast<uint64_t>(_id) + 1; }
+
+    std::array<slot, table_size>                      m_slots         = {};
+    std::atomic<size_t>                               m_overflow_size = { 0 };
+    locking::atomic_mutex                             m_overflow_lock = {};
+    std::unordered_map<roctx_range_id_t, const char*> m_overflow      = {};
+};
+}  // namespace
 
 void
 roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
@@ -441,10 +1582,10 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
 
     if(domain != ACTIVITY_DOMAIN_ROCTX) return;
 
-    static auto _range_map  = std::unordered_map<roctx_range_id_t, std::string>{};
-    static auto _range_lock = locking::atomic_mutex{};
-    const auto* _data       = reinterpret_cast<const roctx_api_data_t*>(callback_data);
-    static thread_local auto _range_stack = std::vector<std::string>{};
+    // the messages are interned so the ranges only store the pointers
+    static auto*             _range_table = new roctx_range_table{};
+    static thread_local auto _range_stack = std::vector<const char*>{};
+    const auto* _data = reinterpret_cast<const roctx_api_data_t*>(callback_data);
 
     switch(cid)
     {
@@ -452,8 +1593,8 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
         {
             if(_data->args.message)
             {
-                auto& itr = _range_stack.emplace_back(std::string{ _data->args.message });
-                component::category_region<category::rocm_roctx>::start(itr.c_str());
+                auto* itr = _range_stack.emplace_back(intern_string(_data->args.message));
+                component::category_region<category::rocm_roctx>::start(itr);
             }
             break;
         }
@@ -461,8 +1602,8 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
         {
             if(!_range_stack.empty())
             {
-                auto& itr = _range_stack.back();
-                component::category_region<category::rocm_roctx>::stop(itr.c_str());
+                auto* itr = _range_stack.back();
+                component::category_region<category::rocm_roctx>::stop(itr);
                 _range_stack.pop_back();
             }
             else
@@ -474,41 +1615,31 @@ roctx_api_callback(uint32_t domain, uint32_t cid, const void* callback_data,
         }
         case ROCTX_API_ID_roctxRangeStartA:
         {
-            {
-                locking::atomic_lock _lk{ _range_lock, std::defer_lock };
-                if(!_lk.owns_lock()) _lk.lock();
-                _range_map.emplace(roctx_range_id_t{ _data->args.id },
-                                   std::string{ _data->args.message });
-            }
+            const auto* _message =
+                (_data->args.message) ? intern_string(_data->args.message) : "";
+            _range_table->insert(roctx_range_id_t{ _data->args.id }, _message);
 
-            component::category_region<category::rocm_roctx>::start(_data->args.message);
+            if(_message[0] != '\0')
+                component::category_region<category::rocm_roctx>::start(_message);
             break;
         }
         case ROCTX_API_ID_roctxRangeStop:
         {
-            std::string_view _message = {};
+            const auto* _message =
+                _range_table->erase(roctx_range_id_t{ _data->args.id });
+            OMNITRACE_CI_THROW(_message == nullptr,
+                               "Error! could not find range with id %lu\n",
+                               _data->args.id);
+            if(_message == nullptr)
             {
-                locking::atomic_lock _lk{ _range_lock, std::defer_lock };
-                if(!_lk.owns_lock()) _lk.lock();
-                auto itr = _range_map.find(roctx_range_id_t{ _data->args.id });
-                OMNITRACE_CI_THROW(itr == _range_map.end(),
-                                   "Error! could not find range with id %lu\n",
-                                   _data->args.id);
-                if(itr == _range_map.end())
-                {
-                    OMNITRACE_VERBOSE(0, "Warning! could not find range with id %lu\n",
-                                      _data->args.id);
-                    return;
-                }
-                else
-                {
-                    _message = itr->second;
-                }
+                OMNITRACE_VERBOSE(0, "Warning! could not find range with id %lu\n",
+                                  _data->args.id);
+                return;
             }
 
-            if(!_message.empty())
+            if(_message[0] != '\0')
             {
-                component::category_region<category::rocm_roctx>::stop(_message.data());
+                component::category_region<category::rocm_roctx>::stop(_message);
             }
 
             break;
@@ -555,6 +1686,9 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
         default: break;
     }
 
+    // the HIP API calls which inspect a graph for the graph tracing
+    if(hip_graph_query) return;
+
     const hip_api_data_t* data = reinterpret_cast<const hip_api_data_t*>(callback_data);
     OMNITRACE_CONDITIONAL_PRINT_F(
         get_debug() && get_verbose() >= 2, "<%-30s id(%u)\tcorrelation_id(%lu) %s>\n",
@@ -625,17 +1759,30 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
 
         if(_name != nullptr)
         {
-            if(get_use_perfetto() || get_use_timemory() || get_use_rocm_smi())
+            const auto& _cfg = config::get_snapshot();
+            if(_cfg.use_perfetto || _cfg.use_timemory || get_use_rocm_smi() ||
+               causal::device::is_enabled() || _cfg.roctracer_timeline_analysis)
+            {
+                get_roctracer_correlation_table().emplace(_roct_cid, _name, _tid, _ts);
+            }
+
+            // joins the kernels launched by RCCL with the collective in progress
+            comp::rccl_bandwidth::register_kernel_launch(_roct_cid);
+
+            if(get_kernel_occupancy_enabled())
             {
-                locking::atomic_lock _lk{ roctracer_type_mutex<key_data_mutex_t>() };
-                get_roctracer_key_data().emplace(_roct_cid, _name);
-                get_roctracer_tid_data().emplace(_roct_cid, _tid);
+                if(auto _cfg = get_launch_config(cid, data))
+                    get_roctracer_launch_config_table().emplace(_roct_cid, *_cfg);
             }
         }
 
         std::tie(_crit_cid, _parent_crit_cid, _depth) = create_cpu_cid_entry();
 
-        if(get_use_perfetto())
+        if(get_hip_api_aggregate_enabled())
+        {
+            get_hip_api_aggregate(_tid)->begin.emplace(_roct_cid, _ts);
+        }
+        else if(config::get_snapshot().use_perfetto)
         {
             static auto _compact_annotations =
                 config::get_setting_value<bool>(
@@ -652,7 +1799,7 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
 
             using backtrace_entry_vec_t = std::vector<tim::unwind::processed_entry>;
             auto _bt_data               = std::optional<backtrace_entry_vec_t>{};
-            if(_enable_backtraces && config::get_perfetto_annotations())
+            if(_enable_backtraces && config::get_snapshot().perfetto_annotations)
             {
                 auto _backtrace = tim::get_unw_stack<bt_stack_depth, bt_ignore_depth,
                                                      bt_with_signal_frame>();
@@ -676,9 +1823,8 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
                 category::rocm_hip{}, op_name, _ts,
                 ::perfetto::Flow::ProcessScoped(_roct_cid),
                 [&](::perfetto::EventContext ctx) {
-                    if(config::get_perfetto_annotations())
+                    if(config::get_snapshot().perfetto_annotations)
                     {
-                        tracing::add_perfetto_annotation(ctx, "begin_ns", _ts);
                         tracing::add_perfetto_annotation(ctx, "cid", _crit_cid);
                         tracing::add_perfetto_annotation(ctx, "pcid", _parent_crit_cid);
                         tracing::add_perfetto_annotation(ctx, "device", _device_id);
@@ -743,7 +1889,7 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
                     }
                 });
         }
-        if(get_use_timemory())
+        if(config::get_snapshot().use_timemory)
         {
             auto itr = get_roctracer_hip_data()->emplace(
                 _roct_cid, roctracer_hip_bundle_t{ op_name });
@@ -758,23 +1904,93 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
             }
         }
 
+        if(causal::device::is_enabled())
+            get_causal_hip_api_begin().emplace(_roct_cid, _ts);
+
+        if(critical_path::is_enabled() && is_device_synchronization(cid))
+            get_critical_path_sync_begin() = _ts;
+
+        if(get_hip_graph_tracing())
+            hip_graph_callback(cid, data, data->phase, _roct_cid, _tid, _ts);
+
         hip_exec_activity_callbacks(_tid);
     }
     else if(data->phase == ACTIVITY_API_PHASE_EXIT)
     {
         hip_exec_activity_callbacks(_tid);
 
-        if(get_use_perfetto())
+        static auto _memory_tracking = config::get_roctracer_memory_tracking();
+        if(_memory_tracking) hip_memory_callback(cid, data, _device_id - 1, _ts);
+
+        if(get_hip_graph_tracing())
+            hip_graph_callback(cid, data, data->phase, _roct_cid, _tid, _ts);
+
+        if(causal::device::is_enabled())
         {
-            tracing::pop_perfetto_ts(
-                category::rocm_hip{}, op_name, _ts, [&](::perfetto::EventContext ctx) {
-                    if(config::get_perfetto_annotations())
-                    {
-                        tracing::add_perfetto_annotation(ctx, "end_ns", _ts);
-                    }
-                });
+            auto& _begin = get_causal_hip_api_begin();
+            auto  itr    = _begin.find(_roct_cid);
+            if(itr != _begin.end())
+            {
+                causal::device::record(op_name, _tid, itr->second, _ts);
+                _begin.erase(itr);
+            }
+        }
+
+        // the synchronization is released by the last kernel completed on the device
+        if(critical_path::is_enabled() && is_device_synchronization(cid) &&
+           get_critical_path_sync_begin() > 0)
+        {
+            critical_path::wait(
+                critical_path::get_key(critical_path::SYNC_DEVICE, _device_id - 1),
+                get_critical_path_sync_begin(), _ts);
+            get_critical_path_sync_begin() = 0;
+        }
+
+        if(get_hip_api_aggregate_enabled())
+        {
+            auto& _aggregate = get_hip_api_aggregate(_tid);
+            auto  itr        = _aggregate->begin.find(_roct_cid);
+            if(itr != _aggregate->begin.end())
+            {
+                auto _beg_ts = itr->second;
+                _aggregate->begin.erase(itr);
+
+                // calls above the latency threshold are still traced individually
+                if(_ts - _beg_ts >= get_hip_api_aggregate_threshold())
+                {
+                    auto _api_id = static_cast<hip_api_id_t>(cid);
+                    tracing::push_perfetto_ts(
+                        category::rocm_hip{}, op_name, _beg_ts,
+                        ::perfetto::Flow::ProcessScoped(_roct_cid),
+                        [&](::perfetto::EventContext ctx) {
+                            if(config::get_snapshot().perfetto_annotations)
+                            {
+                                tracing::add_perfetto_annotation(ctx, "end_ns", _ts);
+                                tracing::add_perfetto_annotation(ctx, "device",
+                                                                 _device_id);
+                                tracing::add_perfetto_annotation(ctx, "tid", _tid);
+                                tracing::add_perfetto_annotation(ctx, "corr_id",
+                                                                 _roct_cid);
+                                tracing::add_perfetto_annotation(
+                                    ctx, "args", hip_api_string(_api_id, data));
+                            }
+                        });
+                    tracing::pop_perfetto_ts(category::rocm_hip{}, op_name, _ts);
+                }
+
+                auto& _summary = _aggregate->summary[cid];
+                if(_summary.count > 0 &&
+                   _ts - _summary.beg_ns >= get_hip_api_aggregate_window())
+                    emit_hip_api_summary(_tid, cid, _summary);
+                _summary.add(op_name, _beg_ts, _ts);
+            }
         }
-        if(get_use_timemory())
+        else if(config::get_snapshot().use_perfetto)
+        {
+            tracing::pop_perfetto_ts(category::rocm_hip{}, op_name, _ts,
+                                     [](::perfetto::EventContext) {});
+        }
+        if(config::get_snapshot().use_timemory)
         {
             auto _stop = [&_roct_cid](int64_t _tid_v) {
                 auto& _data = get_roctracer_hip_data(_tid_v);
@@ -812,11 +2028,16 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
     (void) _protect;
 
     if(!trait::runtime_enabled<comp::roctracer>::get()) return;
-    static auto _kernel_names = std::unordered_map<const char*, std::string>{};
+    static auto _kernel_names = std::unordered_map<const char*, const char*>{};
     static auto _indexes      = std::unordered_map<uint64_t, int>{};
     static auto _skip_barrier_packets =
         config::get_setting_value<bool>("OMNITRACE_ROCTRACER_DISCARD_BARRIERS")
             .value_or(false);
+    static auto _timeline_analysis = config::get_roctracer_timeline_analysis();
+    static auto _graph_tracing     = get_hip_graph_tracing();
+    static auto _kernel_occupancy  = get_kernel_occupancy_enabled();
+    auto        _batch             = activity_batch{};
+
     const roctracer_record_t* record = reinterpret_cast<const roctracer_record_t*>(begin);
     const roctracer_record_t* end_record =
         reinterpret_cast<const roctracer_record_t*>(end);
@@ -838,7 +2059,7 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
 
         if(record->domain == ACTIVITY_DOMAIN_HSA_OPS)
         {
-            hsa_activity_callback(record->op, record, arg);
+            hsa_activity_record(record->op, record, _batch);
             continue;
         }
         if(record->domain != ACTIVITY_DOMAIN_HIP_OPS) continue;
@@ -847,35 +2068,45 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
 
         const char* op_name =
             roctracer_op_string(record->domain, record->op, record->kind);
-        auto     _ns_skew  = get_clock_skew();
-        uint64_t _beg_ns   = record->begin_ns + _ns_skew;
-        uint64_t _end_ns   = record->end_ns + _ns_skew;
+        uint64_t _beg_ns   = record->begin_ns + get_clock_skew(record->begin_ns);
+        uint64_t _end_ns   = record->end_ns + get_clock_skew(record->end_ns);
         auto     _roct_cid = record->correlation_id;
 
-        auto& _keys = get_roctracer_key_data();
-        auto& _tids = get_roctracer_tid_data();
+        int64_t     _tid    = 0;                  // thread id
+        int32_t     _devid  = record->device_id;  // device id
+        int64_t     _queid  = record->queue_id;   // queue id
+        uintptr_t   _queue  = 0;                  // Host queue (stream)
+        int64_t     _launch = 0;                  // HIP API call timestamp
+        const char* _name   = nullptr;
 
-        int64_t     _tid   = 0;                  // thread id
-        int32_t     _devid = record->device_id;  // device id
-        int64_t     _queid = record->queue_id;   // queue id
-        uintptr_t   _queue = 0;                  // Host queue (stream)
-        const char* _name  = nullptr;
-        bool        _found = false;
+        bool _found =
+            get_roctracer_correlation_table().find(_roct_cid, _name, _tid, _launch);
 
+        // the kernels of a graph launch are attributed to the nodes of the graph
+        auto _graph_kernel = std::optional<hip_graph_kernel>{};
+        if(!_found && _graph_tracing && record->op == HIP_OP_ID_DISPATCH)
         {
-            locking::atomic_lock _lk{ roctracer_type_mutex<key_data_mutex_t>() };
-            if(_tids.find(_roct_cid) != _tids.end())
+            _graph_kernel =
+                attribute_hip_graph_kernel(_roct_cid, _devid, _beg_ns, _end_ns);
+            if(_graph_kernel)
             {
-                _found   = true;
-                _tid     = _tids.at(_roct_cid);
-                auto itr = _keys.find(_roct_cid);
-                if(itr != _keys.end()) _name = itr->second;
+                _found  = true;
+                _name   = _graph_kernel->name;
+                _tid    = _graph_kernel->tid;
+                _launch = _graph_kernel->launch_ns;
             }
         }
 
         if(_name == nullptr && op_name == nullptr) continue;
         if(_name == nullptr) _name = op_name;
 
+        // the launch configuration and the theoretical occupancy of the kernel
+        auto _launch_cfg = launch_config{};
+        auto _occupancy  = std::optional<occupancy_info>{};
+        if(_found && _kernel_occupancy && record->op == HIP_OP_ID_DISPATCH &&
+           get_roctracer_launch_config_table().find(_roct_cid, _launch_cfg))
+            _occupancy = compute_kernel_occupancy(_name, _launch_cfg);
+
         static auto _op_id_names =
             std::array<const char*, 3>{ "DISPATCH", "COPY", "BARRIER" };
 
@@ -908,14 +2139,29 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
             }
         }
 
+        comp::rccl_bandwidth::record_kernel_activity(_roct_cid, _beg_ns, _end_ns);
+
+        if(_found && causal::device::is_enabled())
+            causal::device::record(_name, _tid, _beg_ns, _end_ns);
+
+        if(_found && critical_path::is_enabled() && record->op != HIP_OP_ID_BARRIER)
+            critical_path::kernel(_devid, _queid, _name, _tid, _launch, _beg_ns, _end_ns);
+
+        if(_found && gpu_energy::is_enabled() && record->op == HIP_OP_ID_DISPATCH)
+            gpu_energy::kernel(static_cast<uint32_t>(_devid), _name, _beg_ns, _end_ns);
+
         // execute this on this thread bc of how perfetto visualization works
-        if(get_use_perfetto())
+        if(config::get_snapshot().use_perfetto)
         {
-            if(_kernel_names.find(_name) == _kernel_names.end())
-                _kernel_names.emplace(_name, tim::demangle(_name));
+            // the kernel names are demangled once and the interned name is reused
+            auto _kitr = _kernel_names.find(_name);
+            if(_kitr == _kernel_names.end())
+                _kitr = _kernel_names
+                            .emplace(_name, intern_string(tim::demangle(_name)))
+                            .first;
 
             auto _track_desc = [](int32_t _device_id, int64_t _queue_id) {
-                if(config::get_perfetto_roctracer_per_stream())
+                if(config::get_snapshot().perfetto_roctracer_per_stream)
                     return JOIN("", "HIP Activity Device ", _device_id, ", Queue ",
                                 _queue_id);
                 return JOIN("", "HIP Activity Device ", _device_id);
@@ -923,16 +2169,15 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
 
             const auto _track = tracing::get_perfetto_track(
                 category::device_hip{}, _track_desc, _devid,
-                (get_perfetto_roctracer_per_stream()) ? _queid : 0);
+                (config::get_snapshot().perfetto_roctracer_per_stream) ? _queid : 0);
 
             assert(_end_ns >= _beg_ns);
             tracing::push_perfetto_track(
-                category::device_hip{}, _kernel_names.at(_name).c_str(), _track, _beg_ns,
+                category::device_hip{}, _kitr->second, _track, _beg_ns,
                 ::perfetto::Flow::ProcessScoped(_roct_cid),
                 [&](::perfetto::EventContext ctx) {
-                    if(config::get_perfetto_annotations())
+                    if(config::get_snapshot().perfetto_annotations)
                     {
-                        tracing::add_perfetto_annotation(ctx, "begin_ns", _beg_ns);
                         tracing::add_perfetto_annotation(ctx, "end_ns", _end_ns);
                         tracing::add_perfetto_annotation(ctx, "corr_id", _roct_cid);
                         tracing::add_perfetto_annotation(ctx, "device", _devid);
@@ -942,36 +2187,658 @@ hip_activity_callback(const char* begin, const char* end, void* arg)
                             ctx, "stream", JOIN("", "0x", std::hex, _queue));
                         tracing::add_perfetto_annotation(ctx, "op",
                                                          _op_id_names.at(record->op));
+                        if(_graph_kernel)
+                        {
+                            tracing::add_perfetto_annotation(ctx, "graph",
+                                                             _graph_kernel->graph_id);
+                            tracing::add_perfetto_annotation(ctx, "graph_node",
+                                                             _graph_kernel->node);
+                        }
+                        if(_launch_cfg.threads() > 0)
+                        {
+                            auto _dims = [](const std::array<uint32_t, 3>& _v) {
+                                return JOIN('x', _v[0], _v[1], _v[2]);
+                            };
+                            tracing::add_perfetto_annotation(ctx, "grid",
+                                                             _dims(_launch_cfg.grid));
+                            tracing::add_perfetto_annotation(ctx, "block",
+                                                             _dims(_launch_cfg.block));
+                            tracing::add_perfetto_annotation(ctx, "dynamic_lds",
+                                                             _launch_cfg.shared);
+                        }
+                        if(_occupancy)
+                        {
+                            tracing::add_perfetto_annotation(ctx, "vgprs",
+                                                             _occupancy->vgprs);
+                            tracing::add_perfetto_annotation(ctx, "sgprs",
+                                                             _occupancy->sgprs);
+                            tracing::add_perfetto_annotation(ctx, "lds",
+                                                             _occupancy->lds_bytes);
+                            tracing::add_perfetto_annotation(ctx, "scratch",
+                                                             _occupancy->scratch_bytes);
+                            tracing::add_perfetto_annotation(ctx, "waves_per_cu",
+                                                             _occupancy->waves_per_cu);
+                            tracing::add_perfetto_annotation(ctx, "occupancy",
+                                                             _occupancy->occupancy);
+                            tracing::add_perfetto_annotation(ctx, "occupancy_limiter",
+                                                             _occupancy->limiter);
+                        }
                     }
                 });
             tracing::pop_perfetto_track(category::device_hip{}, "", _track, _end_ns);
         }
 
-        if(_found && _name != nullptr && get_use_timemory())
+        if(_found && _name != nullptr && config::get_snapshot().use_timemory)
+            _batch.hip[_tid].emplace_back(activity_batch::entry{
+                _name, _beg_ns, _end_ns, (_occupancy) ? _occupancy->occupancy : -1.0 });
+
+        if(_timeline_analysis && record->op != HIP_OP_ID_BARRIER)
+            _batch.timeline.emplace_back(timeline_record{
+                _devid, record->op, _queid, (_found) ? _launch : 0, _beg_ns, _end_ns });
+    }
+
+    _batch.flush();
+
+    // ensures that all the updates are written
+    if(config::get_snapshot().use_perfetto) ::perfetto::TrackEvent::Flush();
+}
+
+namespace
+{
+// summary of the GPU activity of a device computed by the timeline analysis
+struct timeline_summary
+{
+    int32_t                     device_id                = 0;
+    uint64_t                    kernels                  = 0;
+    uint64_t                    copies                   = 0;
+    uint64_t                    span_ns                  = 0;
+    uint64_t                    busy_ns                  = 0;
+    uint64_t                    overlap_ns               = 0;
+    uint64_t                    copy_ns                  = 0;
+    uint64_t                    max_concurrency          = 0;
+    uint64_t                    idle_gaps                = 0;
+    uint64_t                    idle_ns                  = 0;
+    uint64_t                    idle_max_ns              = 0;
+    uint64_t                    host_bound_idle_ns       = 0;
+    uint64_t                    launches                 = 0;
+    uint64_t                    launch_latency_sum_ns    = 0;
+    uint64_t                    launch_latency_median_ns = 0;
+    uint64_t                    launch_latency_max_ns    = 0;
+    std::map<int64_t, uint64_t> queue_busy_ns            = {};
+
+    double fraction(uint64_t _v) const
+    {
+        return (span_ns > 0) ? static_cast<double>(_v) / static_cast<double>(span_ns)
+                             : 0.0;
+    }
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("device_id", device_id), cereal::make_nvp("kernels", kernels),
+           cereal::make_nvp("copies", copies), cereal::make_nvp("span_ns", span_ns),
+           cereal::make_nvp("busy_ns", busy_ns),
+           cereal::make_nvp("busy_fraction", fraction(busy_ns)),
+           cereal::make_nvp("overlap_ns", overlap_ns),
+           cereal::make_nvp("copy_ns", copy_ns),
+           cereal::make_nvp("max_concurrency", max_concurrency),
+           cereal::make_nvp("idle_gaps", idle_gaps), cereal::make_nvp("idle_ns", idle_ns),
+           cereal::make_nvp("idle_max_ns", idle_max_ns),
+           cereal::make_nvp("host_bound_idle_ns", host_bound_idle_ns),
+           cereal::make_nvp("launches", launches),
+           cereal::make_nvp("launch_latency_sum_ns", launch_latency_sum_ns),
+           cereal::make_nvp("launch_latency_median_ns", launch_latency_median_ns),
+           cereal::make_nvp("launch_latency_max_ns", launch_latency_max_ns),
+           cereal::make_nvp("queue_busy_ns", queue_busy_ns));
+    }
+};
+
+using interval_t = std::pair<uint64_t, uint64_t>;
+
+// sorts and merges the intervals and returns the total length of the union
+uint64_t
+merge_intervals(std::vector<interval_t>& _v)
+{
+    if(_v.empty()) return 0;
+
+    std::sort(_v.begin(), _v.end());
+    size_t _n = 0;
+    for(size_t i = 1; i < _v.size(); ++i)
+    {
+        if(_v.at(i).first <= _v.at(_n).second)
+            _v.at(_n).second = std::max(_v.at(_n).second, _v.at(i).second);
+        else
+            _v.at(++_n) = _v.at(i);
+    }
+    _v.resize(_n + 1);
+
+    uint64_t _sum = 0;
+    for(const auto& itr : _v)
+        _sum += (itr.second - itr.first);
+    return _sum;
+}
+
+// sweeps over the begin/end of the kernels of a device to compute the time with at
+// least one (busy) and at least two (overlap) kernels executing and the idle gaps
+// between the kernels. An idle gap is "host-bound" until the HIP API call which
+// launched the kernel at the end of the gap, i.e. the device was idle because the
+// host had not launched the next kernel yet (vs. the launch latency)
+timeline_summary
+analyze_timeline(int32_t _dev, const std::vector<timeline_record>& _records)
+{
+    using counter_track = perfetto_counter_track<timeline_summary>;
+
+    struct sweep_event
+    {
+        uint64_t ts    = 0;
+        int64_t  delta = 0;
+        size_t   index = 0;
+
+        bool operator<(const sweep_event& _v) const
         {
-            auto _func = [_beg_ns, _end_ns, _name]() {
-                roctracer_hip_bundle_t _bundle{ _name };
-                _bundle.start()
-                    .store(std::plus<double>{}, static_cast<double>(_end_ns - _beg_ns))
-                    .stop()
-                    .get<comp::wall_clock>([&](comp::wall_clock* wc) {
-                        wc->set_value(_end_ns - _beg_ns);
-                        wc->set_accum(_end_ns - _beg_ns);
-                        return wc;
-                    });
-                _bundle.pop();
-            };
+            return std::tie(ts, delta) < std::tie(_v.ts, _v.delta);
+        }
+    };
 
-            auto&                _async_ops = get_hip_activity_callbacks(_tid);
-            locking::atomic_lock _lk{ get_hip_activity_mutex(_tid) };
-            _async_ops->emplace_back(std::move(_func));
+    auto _summary   = timeline_summary{};
+    auto _events    = std::vector<sweep_event>{};
+    auto _copies    = std::vector<interval_t>{};
+    auto _queues    = std::map<int64_t, std::vector<interval_t>>{};
+    auto _latencies = std::vector<uint64_t>{};
+    auto _span      = interval_t{ std::numeric_limits<uint64_t>::max(), 0 };
+    bool _perfetto  = get_use_perfetto();
+
+    _summary.device_id = _dev;
+    _events.reserve(2 * _records.size());
+    for(size_t i = 0; i < _records.size(); ++i)
+    {
+        const auto& itr = _records.at(i);
+        _span.first     = std::min(_span.first, itr.beg_ns);
+        _span.second    = std::max(_span.second, itr.end_ns);
+        if(itr.op != HIP_OP_ID_DISPATCH)
+        {
+            ++_summary.copies;
+            _copies.emplace_back(itr.beg_ns, itr.end_ns);
+            continue;
         }
+
+        ++_summary.kernels;
+        _events.emplace_back(sweep_event{ itr.beg_ns, 1, i });
+        _events.emplace_back(sweep_event{ itr.end_ns, -1, i });
+        _queues[itr.queue_id].emplace_back(itr.beg_ns, itr.end_ns);
+
+        auto _launch = static_cast<uint64_t>(itr.launch_ns);
+        if(itr.launch_ns > 0 && itr.beg_ns >= _launch)
+            _latencies.emplace_back(itr.beg_ns - _launch);
+    }
+
+    _summary.span_ns = (_span.second > _span.first) ? (_span.second - _span.first) : 0;
+    _summary.copy_ns = merge_intervals(_copies);
+    for(auto& itr : _queues)
+        _summary.queue_busy_ns[itr.first] = merge_intervals(itr.second);
+
+    if(_perfetto)
+    {
+        auto _addendum = [_dev](const char* _v) {
+            return JOIN(" ", "GPU", _v, "Device", _dev);
+        };
+        counter_track::emplace(_dev, _addendum("Concurrent Kernels"));
+        counter_track::emplace(_dev, _addendum("Launch Latency"), "usec");
+        counter_track::emplace(_dev, _addendum("Busy"), "%");
+    }
+
+    // the kernels ending at the same time another begins do not overlap
+    std::sort(_events.begin(), _events.end());
+
+    auto     _busy     = std::vector<interval_t>{};
+    int64_t  _level    = 0;
+    uint64_t _prev     = 0;
+    uint64_t _idle_beg = 0;
+    for(const auto& itr : _events)
+    {
+        if(itr.ts > _prev && _level > 0)
+        {
+            auto _dt = itr.ts - _prev;
+            _summary.busy_ns += _dt;
+            if(_level > 1) _summary.overlap_ns += _dt;
+        }
+
+        if(itr.delta > 0 && _level == 0)
+        {
+            if(!_busy.empty() && itr.ts > _idle_beg)
+            {
+                auto _gap = itr.ts - _idle_beg;
+                ++_summary.idle_gaps;
+                _summary.idle_ns += _gap;
+                _summary.idle_max_ns = std::max(_summary.idle_max_ns, _gap);
+
+                auto _launch = _records.at(itr.index).launch_ns;
+                if(_launch > 0 && static_cast<uint64_t>(_launch) > _idle_beg)
+                    _summary.host_bound_idle_ns +=
+                        std::min(static_cast<uint64_t>(_launch) - _idle_beg, _gap);
+            }
+            _busy.emplace_back(itr.ts, itr.ts);
+        }
+
+        _level += itr.delta;
+        _prev = itr.ts;
+        _summary.max_concurrency =
+            std::max(_summary.max_concurrency, static_cast<uint64_t>(_level));
+
+        if(_level == 0)
+        {
+            _idle_beg           = itr.ts;
+            _busy.back().second = itr.ts;
+        }
+
+        if(_perfetto)
+            TRACE_COUNTER("device_hip", counter_track::at(_dev, 0), itr.ts, _level);
+
+        if(_perfetto && itr.delta > 0)
+        {
+            const auto& _record = _records.at(itr.index);
+            auto        _launch = static_cast<uint64_t>(_record.launch_ns);
+            if(_record.launch_ns > 0 && _record.beg_ns >= _launch)
+                TRACE_COUNTER("device_hip", counter_track::at(_dev, 1), itr.ts,
+                              static_cast<double>(_record.beg_ns - _launch) /
+                                  units::usec);
+        }
+    }
+
+    // busy fraction of each window of the span
+    static auto _window = static_cast<uint64_t>(
+        tim::get_env<double>("OMNITRACE_ROCTRACER_TIMELINE_WINDOW", 1.0) * units::msec);
+    if(_perfetto && _window > 0 && !_busy.empty())
+    {
+        auto _itr = _busy.begin();
+        for(uint64_t _beg = _busy.front().first; _beg < _busy.back().second;
+            _beg += _window)
+        {
+            uint64_t _end = _beg + _window;
+            uint64_t _sum = 0;
+            while(_itr != _busy.end() && _itr->second <= _beg)
+                ++_itr;
+            for(auto bitr = _itr; bitr != _busy.end() && bitr->first < _end; ++bitr)
+                _sum += std::min(bitr->second, _end) - std::max(bitr->first, _beg);
+            auto _frac = static_cast<double>(_sum) / static_cast<double>(_window);
+            TRACE_COUNTER("device_hip", counter_track::at(_dev, 2), _beg, 100.0 * _frac);
+        }
+        TRACE_COUNTER("device_hip", counter_track::at(_dev, 2), _busy.back().second,
+                      0.0);
+    }
+
+    if(!_latencies.empty())
+    {
+        auto _mid = _latencies.begin() + (_latencies.size() / 2);
+        std::nth_element(_latencies.begin(), _mid, _latencies.end());
+        _summary.launches                 = _latencies.size();
+        _summary.launch_latency_median_ns = *_mid;
+        _summary.launch_latency_max_ns =
+            *std::max_element(_latencies.begin(), _latencies.end());
+        for(auto itr : _latencies)
+            _summary.launch_latency_sum_ns += itr;
+    }
+
+    return _summary;
+}
+
+void
+write_timeline_summary(const std::vector<timeline_summary>& _data)
+{
+    auto _get_setting = [](const std::string& _v) {
+        return config::get_setting_value<bool>(_v).value_or(true);
+    };
+
+    auto _msec = [](uint64_t _v) { return static_cast<double>(_v) / units::msec; };
+    auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+    auto _perc = [](double _v) { return 100.0 * _v; };
+
+    for(const auto& itr : _data)
+    {
+        OMNITRACE_VERBOSE(
+            0,
+            "roctracer timeline :: device %i :: %lu kernels, busy %.1f%%, overlap "
+            "%.1f%%, %lu idle gaps (%.1f%% of idle is host-bound), median launch "
+            "latency %.3f usec\n",
+            itr.device_id, itr.kernels, _perc(itr.fraction(itr.busy_ns)),
+            _perc(itr.fraction(itr.overlap_ns)), itr.idle_gaps,
+            (itr.idle_ns > 0) ? _perc(static_cast<double>(itr.host_bound_idle_ns) /
+                                      static_cast<double>(itr.idle_ns))
+                              : 0.0,
+            _usec(itr.launch_latency_median_ns));
+    }
+
+    if(_get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        auto _fname =
+            tim::settings::compose_output_filename("roctracer-timeline", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<timeline_summary>{}(
+                    _fname, std::string{ "roctracer_timeline" });
+
+            ofs << std::fixed << std::setprecision(3);
+            for(const auto& itr : _data)
+            {
+                auto _launch_mean =
+                    (itr.launches > 0) ? (itr.launch_latency_sum_ns / itr.launches) : 0;
+                ofs << "device " << itr.device_id << "\n"
+                    << "    kernels                    : " << itr.kernels << "\n"
+                    << "    copies                     : " << itr.copies << "\n"
+                    << "    span                 [msec]: " << _msec(itr.span_ns) << "\n"
+                    << "    busy                    [%]: "
+                    << _perc(itr.fraction(itr.busy_ns)) << "\n"
+                    << "    kernel overlap          [%]: "
+                    << _perc(itr.fraction(itr.overlap_ns)) << "\n"
+                    << "    copy                    [%]: "
+                    << _perc(itr.fraction(itr.copy_ns)) << "\n"
+                    << "    max concurrent kernels     : " << itr.max_concurrency
+                    << "\n"
+                    << "    idle gaps                  : " << itr.idle_gaps << "\n"
+                    << "    idle                 [msec]: " << _msec(itr.idle_ns) << "\n"
+                    << "    max idle gap         [msec]: " << _msec(itr.idle_max_ns)
+                    << "\n"
+                    << "    host-bound idle      [msec]: "
+                    << _msec(itr.host_bound_idle_ns) << "\n"
+                    << "    launch latency mean  [usec]: " << _usec(_launch_mean) << "\n"
+                    << "    launch latency median[usec]: "
+                    << _usec(itr.launch_latency_median_ns) << "\n"
+                    << "    launch latency max   [usec]: "
+                    << _usec(itr.launch_latency_max_ns) << "\n";
+                for(const auto& qitr : itr.queue_busy_ns)
+                    ofs << "    queue " << std::setw(4) << qitr.first
+                        << " busy          [%]: " << _perc(itr.fraction(qitr.second))
+                        << "\n";
+            }
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening roctracer timeline output file: %s",
+                            _fname.c_str());
+        }
+    }
+
+    if(_get_setting("OMNITRACE_JSON_OUTPUT"))
+    {
+        std::stringstream oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+            ar->setNextName("omnitrace");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("roctracer_timeline", _data));
+            ar->finishNode();
+        }
+        auto _fname =
+            tim::settings::compose_output_filename("roctracer-timeline", ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<timeline_summary>{}(
+                    _fname, std::string{ "roctracer_timeline" });
+            ofs << oss.str() << "\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening roctracer timeline output file: %s",
+                            _fname.c_str());
+        }
+    }
+}
+
+// per graph summary of the launches traced by the graph tracing
+struct graph_summary
+{
+    struct node
+    {
+        size_t      index   = 0;
+        std::string name    = {};
+        uint64_t    busy_ns = 0;
+
+        template <typename ArchiveT>
+        void serialize(ArchiveT& ar, const unsigned)
+        {
+            namespace cereal = tim::cereal;
+            ar(cereal::make_nvp("index", index), cereal::make_nvp("name", name),
+               cereal::make_nvp("busy_ns", busy_ns));
+        }
+    };
+
+    uint64_t          graph_id     = 0;
+    bool              captured     = false;
+    uintptr_t         stream       = 0;
+    size_t            nodes        = 0;
+    uint64_t          launches     = 0;
+    uint64_t          completed    = 0;
+    uint64_t          overhead_ns  = 0;
+    uint64_t          span_ns      = 0;
+    uint64_t          span_min_ns  = 0;
+    uint64_t          span_max_ns  = 0;
+    uint64_t          busy_ns      = 0;
+    std::vector<node> kernel_nodes = {};
+
+    uint64_t mean(uint64_t _v) const { return (completed > 0) ? (_v / completed) : 0; }
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        namespace cereal = tim::cereal;
+        ar(cereal::make_nvp("graph_id", graph_id), cereal::make_nvp("captured", captured),
+           cereal::make_nvp("stream", stream), cereal::make_nvp("nodes", nodes),
+           cereal::make_nvp("launches", launches),
+           cereal::make_nvp("completed", completed),
+           cereal::make_nvp("launch_overhead_mean_ns", mean(overhead_ns)),
+           cereal::make_nvp("span_mean_ns", mean(span_ns)),
+           cereal::make_nvp("span_min_ns", span_min_ns),
+           cereal::make_nvp("span_max_ns", span_max_ns),
+           cereal::make_nvp("busy_mean_ns", mean(busy_ns)),
+           cereal::make_nvp("kernel_nodes", kernel_nodes));
+    }
+};
+
+void
+write_graph_summary(const std::vector<graph_summary>& _data)
+{
+    auto _get_setting = [](const std::string& _v) {
+        return config::get_setting_value<bool>(_v).value_or(true);
+    };
+
+    auto _usec = [](uint64_t _v) { return static_cast<double>(_v) / units::usec; };
+
+    for(const auto& itr : _data)
+    {
+        OMNITRACE_VERBOSE(0,
+                          "roctracer graphs :: graph %lu :: %zu kernel nodes, %lu "
+                          "launches, mean span %.3f usec, mean launch overhead %.3f "
+                          "usec\n",
+                          itr.graph_id, itr.kernel_nodes.size(), itr.launches,
+                          _usec(itr.mean(itr.span_ns)), _usec(itr.mean(itr.overhead_ns)));
+    }
+
+    if(_get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        auto _fname = tim::settings::compose_output_filename("roctracer-graphs", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<graph_summary>{}(
+                    _fname, std::string{ "roctracer_graphs" });
+
+            ofs << std::fixed << std::setprecision(3);
+            for(const auto& itr : _data)
+            {
+                ofs << "graph " << itr.graph_id << "\n"
+                    << "    captured from stream       : "
+                    << ((itr.captured) ? JOIN("", "0x", std::hex, itr.stream)
+                                       : std::string{ "no" })
+                    << "\n"
+                    << "    nodes                      : " << itr.nodes << "\n"
+                    << "    kernel nodes               : " << itr.kernel_nodes.size()
+                    << "\n"
+                    << "    launches                   : " << itr.launches << "\n"
+                    << "    completed launches         : " << itr.completed << "\n"
+                    << "    launch overhead mean [usec]: "
+                    << _usec(itr.mean(itr.overhead_ns)) << "\n"
+                    << "    span mean            [usec]: " << _usec(itr.mean(itr.span_ns))
+                    << "\n"
+                    << "    span min             [usec]: " << _usec(itr.span_min_ns)
+                    << "\n"
+                    << "    span max             [usec]: " << _usec(itr.span_max_ns)
+                    << "\n"
+                    << "    busy mean            [usec]: " << _usec(itr.mean(itr.busy_ns))
+                    << "\n";
+                for(const auto& nitr : itr.kernel_nodes)
+                    ofs << "    node " << std::setw(4) << nitr.index
+                        << " mean     [usec]: " << _usec(itr.mean(nitr.busy_ns)) << " :: "
+                        << nitr.name << "\n";
+            }
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening roctracer graphs output file: %s",
+                            _fname.c_str());
+        }
+    }
+
+    if(_get_setting("OMNITRACE_JSON_OUTPUT"))
+    {
+        std::stringstream oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(oss);
+
+            ar->setNextName("omnitrace");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("roctracer_graphs", _data));
+            ar->finishNode();
+        }
+        auto _fname = tim::settings::compose_output_filename("roctracer-graphs", ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            if(get_verbose() >= 0)
+                operation::file_output_message<graph_summary>{}(
+                    _fname, std::string{ "roctracer_graphs" });
+            ofs << oss.str() << "\n";
+        }
+        else
+        {
+            OMNITRACE_THROW("Error opening roctracer graphs output file: %s",
+                            _fname.c_str());
+        }
+    }
+}
+}  // namespace
+
+void
+roctracer_hip_api_post_process()
+{
+    if(!get_hip_api_aggregate_enabled()) return;
+
+    using thread_data_t = thread_data<hip_api_aggregate, category::roctracer>;
+
+    // the HIP API callbacks are disabled at this point so the remaining partial
+    // windows of every thread can be emitted from this thread
+    auto* _data = thread_data_t::get();
+    if(!_data) return;
+
+    for(size_t i = 0; i < _data->size(); ++i)
+    {
+        auto& _aggregate = _data->at(i);
+        if(!_aggregate) continue;
+        for(auto& itr : _aggregate->summary)
+            emit_hip_api_summary(static_cast<int64_t>(i), itr.first, itr.second);
+        _aggregate->begin.clear();
     }
 
-    // ensures that all the updates are written
     if(get_use_perfetto()) ::perfetto::TrackEvent::Flush();
 }
 
+void
+roctracer_timeline_post_process()
+{
+    if(!config::get_roctracer_timeline_analysis()) return;
+
+    auto _records = std::vector<timeline_record>{};
+    {
+        auto _lk = locking::atomic_lock{ get_timeline_mutex() };
+        std::swap(_records, get_timeline_records());
+    }
+
+    if(_records.empty()) return;
+
+    auto _devices = std::map<int32_t, std::vector<timeline_record>>{};
+    for(const auto& itr : _records)
+        _devices[itr.device_id].emplace_back(itr);
+
+    auto _data = std::vector<timeline_summary>{};
+    _data.reserve(_devices.size());
+    for(const auto& itr : _devices)
+        _data.emplace_back(analyze_timeline(itr.first, itr.second));
+
+    write_timeline_summary(_data);
+}
+
+void
+roctracer_graph_post_process()
+{
+    if(!get_hip_graph_tracing()) return;
+
+    auto& _registry = get_hip_graph_registry();
+    auto  _lk       = locking::atomic_lock{ _registry.mutex };
+
+    // launches which did not have every kernel traced are not included in the timing
+    _registry.launches.clear();
+
+    auto _graphs = std::vector<const hip_graph_info*>{};
+    for(const auto& itr : _registry.execs)
+        _graphs.emplace_back(itr.second.get());
+    for(const auto& itr : _registry.retired)
+        _graphs.emplace_back(itr.get());
+
+    auto _data = std::vector<graph_summary>{};
+    for(const auto* itr : _graphs)
+    {
+        if(itr->launches == 0) continue;
+
+        auto _summary        = graph_summary{};
+        _summary.graph_id    = itr->id;
+        _summary.captured    = itr->captured;
+        _summary.stream      = itr->stream;
+        _summary.nodes       = itr->nodes.size();
+        _summary.launches    = itr->launches;
+        _summary.completed   = itr->completed;
+        _summary.overhead_ns = itr->overhead;
+        _summary.span_ns     = itr->span_ns;
+        _summary.span_min_ns = (itr->completed > 0) ? itr->span_min : 0;
+        _summary.span_max_ns = itr->span_max;
+        _summary.busy_ns     = itr->kernel_ns;
+        for(size_t i = 0; i < itr->kernels.size(); ++i)
+        {
+            auto _idx = itr->kernels.at(i);
+            _summary.kernel_nodes.emplace_back(graph_summary::node{
+                _idx, tim::demangle(itr->nodes.at(_idx).name), itr->node_ns.at(i) });
+        }
+        _data.emplace_back(std::move(_summary));
+    }
+
+    if(_data.empty()) return;
+
+    std::sort(_data.begin(), _data.end(), [](const auto& _lhs, const auto& _rhs) {
+        return _lhs.graph_id < _rhs.graph_id;
+    });
+
+    write_graph_summary(_data);
+}
+
 bool&
 roctracer_is_init()
 {
@@ -78,9 +78,36 @@ roctracer_is_init();
 bool&
 roctracer_is_setup();
 
+// offset between the CPU clock and the roctracer clock from the initial
+// synchronization
 int64_t
 get_clock_skew();
 
+// offset between the CPU clock and the roctracer clock at the given roctracer
+// timestamp: piecewise-linear interpolation between the periodic synchronizations
+int64_t
+get_clock_skew(uint64_t);
+
+// re-synchronizes the CPU and roctracer clocks if the resynchronization interval
+// (OMNITRACE_ROCTRACER_CLOCK_SKEW_INTERVAL seconds) has elapsed
+void
+update_clock_skew();
+
+// emits the partial HIP API summary windows of every thread when
+// OMNITRACE_ROCTRACER_HIP_API_AGGREGATE is enabled
+void
+roctracer_hip_api_post_process();
+
+// analyzes the GPU activity (busy fraction, kernel overlap, launch latency, idle
+// gaps) when OMNITRACE_ROCTRACER_TIMELINE_ANALYSIS is enabled
+void
+roctracer_timeline_post_process();
+
+// writes the per graph launch timing and the kernel node attribution when
+// OMNITRACE_ROCTRACER_GRAPH_TRACING is enabled
+void
+roctracer_graph_post_process();
+
 roctracer_functions_t&
 roctracer_setup_routines();
 
@@ -30,9 +30,13 @@
 #include "library/causal/components/causal_gotcha.hpp"
 #include "library/components/exit_gotcha.hpp"
 #include "library/components/fork_gotcha.hpp"
+#include "library/components/heap_profiler.hpp"
+#include "library/components/io_gotcha.hpp"
+#include "library/components/memory_access.hpp"
 #include "library/components/mpi_gotcha.hpp"
 #include "library/components/numa_gotcha.hpp"
 #include "library/components/pthread_gotcha.hpp"
+#include "library/components/python_gil_gotcha.hpp"
 #include "library/components/roctracer.hpp"
 #include "library/thread_data.hpp"
 
@@ -52,8 +56,11 @@ using preinit_bundle_t =
     tim::lightweight_tuple<exit_gotcha_t, fork_gotcha_t, mpi_gotcha_t>;
 
 // started during init phase
-using init_bundle_t = tim::lightweight_tuple<causal::component::causal_gotcha,
-                                             pthread_gotcha, component::numa_gotcha>;
+using init_bundle_t =
+    tim::lightweight_tuple<causal::component::causal_gotcha, pthread_gotcha,
+                           component::numa_gotcha, component::memory_access,
+                           component::heap_profiler, component::io_gotcha,
+                           component::python_gil_gotcha>;
 
 // bundle of components around omnitrace_init and omnitrace_finalize
 using main_bundle_t =
@@ -21,19 +21,27 @@
 // SOFTWARE.
 
 #include "library/sampling.hpp"
+#include "binary/analysis.hpp"
 #include "core/common.hpp"
 #include "core/components/fwd.hpp"
 #include "core/config.hpp"
 #include "core/debug.hpp"
 #include "core/locking.hpp"
 #include "core/perf.hpp"
+#include "core/raw_data.hpp"
 #include "core/state.hpp"
+#include "core/string_arena.hpp"
 #include "core/utility.hpp"
+#include "library/calling_context.hpp"
 #include "library/components/backtrace.hpp"
 #include "library/components/backtrace_metrics.hpp"
 #include "library/components/backtrace_timestamp.hpp"
 #include "library/components/callchain.hpp"
+#include "library/components/memory_access.hpp"
+#include "library/folded_output.hpp"
+#include "library/parquet_output.hpp"
 #include "library/perf.hpp"
+#include "library/perf_sampler.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/thread_data.hpp"
@@ -56,6 +64,7 @@
 #include <timemory/mpl/quirks.hpp>
 #include <timemory/mpl/type_traits.hpp>
 #include <timemory/operations.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
 #include <timemory/sampling/allocator.hpp>
 #include <timemory/sampling/overflow.hpp>
 #include <timemory/sampling/sampler.hpp>
@@ -69,21 +78,37 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <condition_variable>
 #include <csignal>
 #include <cstring>
 #include <ctime>
+#include <exception>
+#include <fstream>
 #include <initializer_list>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 #include <pthread.h>
+#include <semaphore.h>
 #include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace tim
 {
@@ -109,7 +134,7 @@ using ::tim::sampling::timer;
 
 using hw_counters               = typename component::backtrace_metrics::hw_counters;
 using signal_type_instances     = thread_data<std::set<int>, category::sampling>;
-using sampler_running_instances = thread_data<bool, category::sampling>;
+using sampler_running_instances = thread_data<identity<bool>, category::sampling>;
 using bundle_t =
     tim::lightweight_tuple<component::backtrace_timestamp, component::backtrace,
                            component::backtrace_metrics, component::callchain>;
@@ -129,6 +154,7 @@ using component::sampling_gpu_busy;
 using component::sampling_gpu_memory;
 using component::sampling_gpu_power;
 using component::sampling_gpu_temp;
+using component::sampling_off_cpu;
 using component::sampling_percent;
 using component::sampling_wall_clock;
 }  // namespace sampling
@@ -159,6 +185,65 @@ get_sampler_allocators()
 std::set<int>
 configure(bool _setup, int64_t _tid = threading::get_id());
 
+struct overflow_event
+{
+    std::string name  = {};
+    std::string label = {};  // name without the perf:: and PERF_COUNT_ prefixes
+    double      freq  = 0.0;
+};
+
+// OMNITRACE_SAMPLING_OVERFLOW_EVENT is a list of events which are sampled concurrently
+// as a perf event group, e.g. "PERF_COUNT_HW_CPU_CYCLES PERF_COUNT_HW_CACHE_MISSES@1000".
+// An event without an "@<freq>" suffix uses OMNITRACE_SAMPLING_OVERFLOW_FREQ
+const std::vector<overflow_event>&
+get_overflow_events()
+{
+    static auto _v = []() {
+        auto _events = std::vector<overflow_event>{};
+        for(const auto& itr :
+            tim::delimit(config::get_snapshot().sampling_overflow_event, " ,;\t"))
+        {
+            auto _event = overflow_event{ itr, itr, get_sampling_overflow_freq() };
+            if(auto _pos = itr.find('@'); _pos != std::string::npos)
+            {
+                _event.name = _event.label = itr.substr(0, _pos);
+                _event.freq                = std::stod(itr.substr(_pos + 1));
+            }
+            for(std::string_view _prefix : { "perf::", "PERF_COUNT_" })
+            {
+                if(auto _pos = _event.label.find(_prefix); _pos != std::string::npos)
+                    _event.label = _event.label.substr(_pos + _prefix.length());
+            }
+            _events.emplace_back(std::move(_event));
+        }
+
+        if(_events.size() > perf::max_group_size)
+        {
+            OMNITRACE_WARNING(0,
+                              "[sampling] only the first %zu of the %zu overflow events "
+                              "are sampled\n",
+                              perf::max_group_size, _events.size());
+            _events.resize(perf::max_group_size);
+        }
+        return _events;
+    }();
+    return _v;
+}
+
+// applies the function to the leader and the members of the group of overflow events
+template <typename FuncT>
+bool
+for_each_overflow_instance(int64_t _tid, FuncT&& _func)
+{
+    bool _ret = true;
+    for(size_t i = 0; i < perf::max_group_size; ++i)
+    {
+        auto& itr = perf::get_instance(_tid, i);
+        if(itr) _ret = std::forward<FuncT>(_func)(itr) && _ret;
+    }
+    return _ret;
+}
+
 void
 configure_sampler_allocator(std::shared_ptr<sampler_allocator_t>& _v)
 {
@@ -261,12 +346,26 @@ get_sampler_init(int64_t _tid = threading::get_id())
     return sampler_init_instances::instance(construct_on_thread{ _tid });
 }
 
-unique_ptr_t<bool>&
+bool&
 get_sampler_running(int64_t _tid)
 {
     return sampler_running_instances::instance(construct_on_thread{ _tid }, false);
 }
 
+// the samplers are stopped while outside of the trace windows
+struct pause_state
+{
+    std::mutex mutex  = {};
+    bool       paused = false;
+};
+
+auto&
+get_pause_state()
+{
+    static auto* _v = new pause_state{};
+    return *_v;
+}
+
 auto&
 get_duration_disabled()
 {
@@ -416,13 +515,321 @@ using pos_type         = typename std::fstream::pos_type;
 
 auto offload_seq_data = std::unordered_map<int64_t, std::set<pos_type>>{};
 
+bool
+use_offload_segments()
+{
+    static auto _v =
+        get_use_tmp_files() && config::get_sampling_offload_mode() == "thread";
+    return _v;
+}
+
+// compact, versioned encoding of the sample bundles written to the offload files.
+// The bundles consist of fixed-size, trivially copyable data so each bundle is viewed
+// as an array of 64-bit words and encoded against the previous bundle in the block:
+//
+//      repeat until every word is covered:
+//          varint  number of words equal to the previous bundle
+//          varint  number of words which differ
+//          varint  zigzag(word - previous word) for each differing word
+//
+// Consecutive samples of a thread typically share most of their call-stack and
+// metric words and the timestamps grow monotonically, so most samples reduce to the
+// timestamp delta and the few frames or counters which changed. Each block starts
+// from a zero bundle so that blocks are decoded independently.
+namespace offload_codec
+{
+constexpr uint32_t magic     = 0x4f4d5350;  // "OMSP"
+constexpr uint16_t version   = 1;
+constexpr size_t   num_words = (sizeof(sampler_bundle_t) + 7) / 8;
+
+struct block_header
+{
+    uint32_t magic       = offload_codec::magic;
+    uint16_t version     = offload_codec::version;
+    uint16_t reserved    = 0;
+    uint32_t bundle_size = sizeof(sampler_bundle_t);
+    uint32_t padding     = 0;
+    int64_t  seq         = 0;
+    uint64_t count       = 0;  // number of samples
+    uint64_t nbytes      = 0;  // size of the encoded samples following the header
+
+    bool is_valid() const
+    {
+        return (magic == offload_codec::magic && version == offload_codec::version &&
+                bundle_size == sizeof(sampler_bundle_t));
+    }
+};
+
+using word_array_t = std::array<uint64_t, num_words>;
+
 void
-offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
+put_varint(std::string& _out, uint64_t _v)
+{
+    while(_v >= 0x80)
+    {
+        _out.push_back(static_cast<char>((_v & 0x7f) | 0x80));
+        _v >>= 7;
+    }
+    _out.push_back(static_cast<char>(_v));
+}
+
+bool
+get_varint(const char*& _beg, const char* _end, uint64_t& _v)
+{
+    _v = 0;
+    for(int _shift = 0; _beg < _end && _shift < 64; _shift += 7)
+    {
+        auto _byte = static_cast<uint8_t>(*_beg++);
+        _v |= static_cast<uint64_t>(_byte & 0x7f) << _shift;
+        if((_byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+uint64_t
+zigzag(uint64_t _v)
+{
+    return (_v << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(_v) >> 63);
+}
+
+uint64_t
+unzigzag(uint64_t _v)
+{
+    return (_v >> 1) ^ (~(_v & 1) + 1);
+}
+
+// drains the ring buffer and returns the header and the encoded samples
+std::pair<block_header, std::string>
+encode(int64_t _seq, sampler_buffer_t& _buf)
+{
+    auto _header = block_header{};
+    auto _data   = std::string{};
+    auto _prev   = word_array_t{};
+    auto _curr   = word_array_t{};
+    auto _v      = sampler_bundle_t{};
+
+    _header.seq = _seq;
+    _data.reserve(_buf.count() * 16);
+    while(!_buf.is_empty())
+    {
+        _buf.read(&_v);
+        memcpy(_curr.data(), &_v, sizeof(sampler_bundle_t));
+
+        for(size_t i = 0; i < num_words;)
+        {
+            size_t j = i;
+            while(j < num_words && _curr[j] == _prev[j])
+                ++j;
+            put_varint(_data, j - i);
+            if(j == num_words) break;
+
+            size_t k = j;
+            while(k < num_words && _curr[k] != _prev[k])
+                ++k;
+            put_varint(_data, k - j);
+            for(size_t m = j; m < k; ++m)
+                put_varint(_data, zigzag(_curr[m] - _prev[m]));
+            i = k;
+        }
+
+        std::swap(_prev, _curr);
+        ++_header.count;
+    }
+
+    _header.nbytes = _data.size();
+    return std::make_pair(_header, std::move(_data));
+}
+
+// decodes the samples of a block and appends them to the output
+template <typename ContainerT>
+bool
+decode(const block_header& _header, const char* _beg, ContainerT& _out)
+{
+    const auto* _end  = _beg + _header.nbytes;
+    auto        _prev = word_array_t{};
+    auto        _v    = sampler_bundle_t{};
+
+    for(uint64_t n = 0; n < _header.count; ++n)
+    {
+        for(size_t i = 0; i < num_words;)
+        {
+            uint64_t _same = 0;
+            uint64_t _diff = 0;
+            if(!get_varint(_beg, _end, _same)) return false;
+            i += _same;
+            if(i >= num_words) break;
+            if(!get_varint(_beg, _end, _diff) || i + _diff > num_words) return false;
+            for(uint64_t m = 0; m < _diff; ++m, ++i)
+            {
+                uint64_t _delta = 0;
+                if(!get_varint(_beg, _end, _delta)) return false;
+                _prev[i] += unzigzag(_delta);
+            }
+        }
+
+        memcpy(&_v, _prev.data(), sizeof(sampler_bundle_t));
+        _out.emplace_back(_v);
+    }
+
+    return (_beg == _end);
+}
+}  // namespace offload_codec
+
+// append-only, memory-mapped temporary file holding the encoded sample blocks of a
+// single thread. Each sampled thread is serviced by exactly one allocator so the
+// appends do not need to be synchronized with any other thread
+struct offload_segment
+{
+    explicit offload_segment(int64_t _seq);
+    ~offload_segment();
+
+    offload_segment(const offload_segment&) = delete;
+    offload_segment(offload_segment&&)      = delete;
+
+    offload_segment& operator=(const offload_segment&) = delete;
+    offload_segment& operator=(offload_segment&&) = delete;
+
+    bool append(sampler_buffer_t&);
+
+    template <typename ContainerT>
+    bool load(ContainerT&) const;
+
+    size_t size() const { return m_count; }
+    bool   empty() const { return (m_count == 0); }
+
+    explicit operator bool() const { return (m_file && m_file->fd > 0); }
+
+private:
+    bool reserve(size_t);
+
+    int64_t                   m_seq      = 0;
+    size_t                    m_count    = 0;
+    size_t                    m_size     = 0;
+    size_t                    m_capacity = 0;
+    char*                     m_data     = nullptr;
+    std::shared_ptr<tmp_file> m_file     = {};
+};
+
+using offload_segment_instances = thread_data<offload_segment, category::sampling>;
+
+offload_segment::offload_segment(int64_t _seq)
+: m_seq{ _seq }
+, m_file{ config::get_tmp_file(JOIN('-', "sampling", _seq)) }
+{
+    if(m_file && !m_file->fopen("w+"))
+    {
+        OMNITRACE_WARNING_F(0, "Error opening sampling offload segment '%s'\n",
+                            m_file->filename.c_str());
+        m_file.reset();
+    }
+}
+
+offload_segment::~offload_segment()
+{
+    if(m_data) munmap(m_data, m_capacity);
+    if(m_file)
+    {
+        m_file->close();
+        m_file->remove();
+    }
+}
+
+bool
+offload_segment::reserve(size_t _bytes)
+{
+    if(_bytes <= m_capacity) return true;
+    if(!*this) return false;
+
+    // grow geometrically in multiples of the page size
+    static const size_t _page_size = sysconf(_SC_PAGESIZE);
+    auto _capacity = std::max<size_t>(_bytes, 2 * m_capacity);
+    _capacity      = ((_capacity + _page_size - 1) / _page_size) * _page_size;
+
+    if(ftruncate(m_file->fd, _capacity) != 0) return false;
+
+    void* _data = (m_data)
+                      ? mremap(m_data, m_capacity, _capacity, MREMAP_MAYMOVE)
+                      : mmap(nullptr, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED,
+                             m_file->fd, 0);
+
+    if(_data == MAP_FAILED)
+    {
+        OMNITRACE_WARNING_F(0,
+                            "Error mapping %zu bytes of sampling offload segment for "
+                            "thread %li: %s\n",
+                            _capacity, m_seq, strerror(errno));
+        return false;
+    }
+
+    m_data     = static_cast<char*>(_data);
+    m_capacity = _capacity;
+    return true;
+}
+
+bool
+offload_segment::append(sampler_buffer_t& _buf)
+{
+    auto [_header, _data] = offload_codec::encode(m_seq, _buf);
+    auto _nbytes          = sizeof(_header) + _data.size();
+    if(!reserve(m_size + _nbytes)) return false;
+
+    memcpy(m_data + m_size, &_header, sizeof(_header));
+    memcpy(m_data + m_size + sizeof(_header), _data.data(), _data.size());
+    m_size += _nbytes;
+    m_count += _header.count;
+
+    return true;
+}
+
+template <typename ContainerT>
+bool
+offload_segment::load(ContainerT& _out) const
+{
+    for(size_t _pos = 0; _pos + sizeof(offload_codec::block_header) <= m_size;)
+    {
+        auto _header = offload_codec::block_header{};
+        memcpy(&_header, m_data + _pos, sizeof(_header));
+        _pos += sizeof(_header);
+
+        if(!_header.is_valid() || _header.seq != m_seq ||
+           _pos + _header.nbytes > m_size ||
+           !offload_codec::decode(_header, m_data + _pos, _out))
+        {
+            OMNITRACE_WARNING_F(0,
+                                "[sampling] invalid sample block at offset %zu of the "
+                                "offload segment for thread %li\n",
+                                _pos - sizeof(_header), m_seq);
+            return false;
+        }
+        _pos += _header.nbytes;
+    }
+    return true;
+}
+
+void
+write_offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
 {
     OMNITRACE_REQUIRE(get_use_tmp_files())
         << "Error! sampling allocator tries to offload buffer of samples but "
            "omnitrace was configured to not use temporary files\n";
 
+    if(use_offload_segments())
+    {
+        auto& _segment =
+            offload_segment_instances::instance(construct_on_thread{ _seq }, _seq);
+
+        OMNITRACE_VERBOSE_F(2, "Offloading %zu samples for thread %li to %s...\n",
+                            _buf.count(), _seq,
+                            (_segment && *_segment) ? "segment" : "shared file");
+
+        if(_segment && *_segment && _segment->append(_buf))
+        {
+            _buf.destroy();
+            return;
+        }
+        // fall back to the shared file
+    }
+
     // use homemade atomic_mutex/atomic_lock since contention will be low
     // and using pthread_lock might trigger our wrappers
     auto  _lk   = locking::atomic_lock{ get_offload_mutex() };
@@ -440,18 +847,302 @@ offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
                                      "an invalid state during offload for thread "
                                   << _seq << "\n";
 
-    offload_seq_data[_seq].emplace(_fs.tellg());
-    _fs.write(reinterpret_cast<char*>(&_seq), sizeof(_seq));
-    auto _data = std::move(_buf);
-    _data.save(_fs);
+    auto _data              = std::move(_buf);
+    auto [_header, _encoded] = offload_codec::encode(_seq, _data);
     _data.destroy();
     _buf.destroy();
+
+    offload_seq_data[_seq].emplace(_fs.tellp());
+    _fs.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    _fs.write(_encoded.data(), _encoded.size());
+}
+
+// writes the full sample buffers on a background thread. The sampler allocators push
+// the buffers onto a lock-free list and return immediately so the allocators (and
+// therefore the samplers) do not wait on file I/O. When the number of queued buffers
+// reaches OMNITRACE_SAMPLING_OFFLOAD_QUEUE_DEPTH, the allocator blocks on a semaphore
+// of free slots until the writer catches up (backpressure) so that the buffers of a
+// thread are always written in the order they were filled. The submitters in flight
+// are counted so that shutdown() only drains the queue for the last time once no
+// submitter can still push a job.
+struct offload_writer
+{
+    struct job
+    {
+        int64_t          seq    = 0;
+        sampler_buffer_t buffer = {};
+        job*             next   = nullptr;
+    };
+
+    explicit offload_writer(size_t _depth);
+
+    bool submit(int64_t _seq, sampler_buffer_t&& _buf);
+    void shutdown();
+
+private:
+    void run();
+    job* take_jobs();
+    void write_jobs(job*);
+
+    size_t                       m_depth       = 0;
+    std::atomic<bool>            m_running     = { true };
+    std::atomic<size_t>          m_submitters  = { 0 };
+    std::atomic<job*>            m_head        = { nullptr };
+    std::atomic<size_t>          m_pending     = { 0 };
+    std::atomic<size_t>          m_max_pending = { 0 };
+    std::atomic<size_t>          m_stalls      = { 0 };
+    std::atomic<uint64_t>        m_stall_nsec  = { 0 };
+    size_t                       m_buffers     = 0;
+    size_t                       m_samples     = 0;
+    uint64_t                     m_write_nsec  = 0;
+    sem_t                        m_sem         = {};  // queued jobs
+    sem_t                        m_slots       = {};  // free slots in the queue
+    std::unique_ptr<std::thread> m_thread      = {};
+};
+
+offload_writer::offload_writer(size_t _depth)
+: m_depth{ _depth }
+{
+    sem_init(&m_sem, 0, 0);
+    sem_init(&m_slots, 0, static_cast<unsigned int>(m_depth));
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    m_thread = std::make_unique<std::thread>([this]() { run(); });
+}
+
+bool
+offload_writer::submit(int64_t _seq, sampler_buffer_t&& _buf)
+{
+    // sequentially consistent with the store in shutdown(): either shutdown() sees this
+    // submitter or this submitter sees that the writer is shutting down
+    m_submitters.fetch_add(1);
+    if(!m_running.load())
+    {
+        m_submitters.fetch_sub(1);
+        return false;
+    }
+
+    // backpressure: wait for the writer when the queue is full. The writer keeps
+    // releasing slots until shutdown() has seen every submitter leave
+    if(sem_trywait(&m_slots) != 0)
+    {
+        auto _beg = tracing::now();
+        while(sem_wait(&m_slots) != 0 && errno == EINTR)
+        {}
+        m_stalls.fetch_add(1, std::memory_order_relaxed);
+        m_stall_nsec.fetch_add(tracing::now() - _beg, std::memory_order_relaxed);
+    }
+
+    auto* _job = new job{ _seq, std::move(_buf), nullptr };
+
+    auto _pending = m_pending.fetch_add(1, std::memory_order_acq_rel) + 1;
+    auto _max     = m_max_pending.load(std::memory_order_relaxed);
+    while(_pending > _max &&
+          !m_max_pending.compare_exchange_weak(_max, _pending, std::memory_order_relaxed))
+    {}
+
+    _job->next = m_head.load(std::memory_order_relaxed);
+    while(!m_head.compare_exchange_weak(_job->next, _job, std::memory_order_release,
+                                        std::memory_order_relaxed))
+    {}
+
+    sem_post(&m_sem);
+    m_submitters.fetch_sub(1);
+    return true;
+}
+
+void
+offload_writer::run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.samp.spill");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    while(true)
+    {
+        while(sem_wait(&m_sem) != 0 && errno == EINTR)
+        {}
+
+        // a submitter which is waiting for a slot depends on the writer so the writer
+        // only exits once every submitter has left
+        auto* _jobs = take_jobs();
+        if(!_jobs && !m_running.load() && m_submitters.load() == 0) break;
+        write_jobs(_jobs);
+    }
+}
+
+offload_writer::job*
+offload_writer::take_jobs()
+{
+    // take every queued job and reverse the list to restore the submission order
+    job* _jobs = nullptr;
+    for(auto* itr = m_head.exchange(nullptr, std::memory_order_acquire); itr;)
+    {
+        auto* _next = itr->next;
+        itr->next   = _jobs;
+        _jobs       = itr;
+        itr         = _next;
+    }
+    return _jobs;
+}
+
+void
+offload_writer::write_jobs(job* _jobs)
+{
+    while(_jobs)
+    {
+        auto* _job = _jobs;
+        _jobs      = _job->next;
+
+        auto _beg = tracing::now();
+        m_samples += _job->buffer.count();
+        m_buffers += 1;
+        write_offload_buffer(_job->seq, std::move(_job->buffer));
+        m_write_nsec += (tracing::now() - _beg);
+
+        delete _job;
+        m_pending.fetch_sub(1, std::memory_order_release);
+        sem_post(&m_slots);
+    }
+}
+
+void
+offload_writer::shutdown()
+{
+    if(!m_thread) return;
+
+    // the submitters which already passed the check of m_running may still push a job
+    // (or wait for a slot, which the writer keeps releasing) so the final drain waits
+    // for them
+    m_running.store(false);
+    while(m_submitters.load() > 0)
+        std::this_thread::yield();
+
+    // the writer exits after draining the queue
+    sem_post(&m_sem);
+    m_thread->join();
+    m_thread.reset();
+
+    // anything submitted while the writer was exiting
+    write_jobs(take_jobs());
+
+    sem_destroy(&m_sem);
+    sem_destroy(&m_slots);
+
+    auto _to_sec = [](uint64_t _v) { return _v / static_cast<double>(units::sec); };
+    OMNITRACE_VERBOSE(1 || get_debug_sampling(),
+                      "[sampling] offload writer wrote %zu samples in %zu buffers (%.3f "
+                      "sec). Max queue depth: %zu of %zu. Allocators waited on the "
+                      "writer %zu times (%.3f sec)\n",
+                      m_samples, m_buffers, _to_sec(m_write_nsec), m_max_pending.load(),
+                      m_depth, m_stalls.load(), _to_sec(m_stall_nsec.load()));
+}
+
+std::once_flag  offload_writer_once     = {};
+offload_writer* offload_writer_instance = nullptr;
+
+offload_writer*
+get_offload_writer()
+{
+    // leaked: the writer thread may still be referencing the instance during exit
+    std::call_once(offload_writer_once, []() {
+        auto _depth = config::get_sampling_offload_queue_depth();
+        if(_depth > 0) offload_writer_instance = new offload_writer{ _depth };
+    });
+    return offload_writer_instance;
+}
+
+// periodic flush of the samples (OMNITRACE_FLUSH_INTERVAL). The full sample buffers
+// handed off by the allocators are reduced to the raw samples (call-stack addresses
+// and timestamps) instead of being kept or offloaded and a background thread writes
+// the samples accumulated since the previous flush to a new raw-samples-flush file
+// every interval. The memory is therefore bounded by the samples of one interval and
+// a process which is killed only loses the samples since the last flush.
+struct flush_writer
+{
+    explicit flush_writer(double _interval);
+
+    // the buffer is drained
+    void append(int64_t _tid, sampler_buffer_t& _buf);
+
+    // the remaining samples of a thread after sampling has stopped
+    void append(raw_data::thread&& _thread);
+
+    // writes the pending samples and returns the number of samples written
+    size_t flush();
+
+    // stops the background thread. Does not flush
+    void shutdown();
+
+    size_t num_files() const { return m_files; }
+    size_t num_samples() const { return m_samples; }
+    size_t num_threads() const { return m_last.size(); }
+
+private:
+    struct thread_chunk
+    {
+        raw_data::thread                                         data   = {};
+        std::unordered_map<calling_context::node_id_t, uint32_t> stacks = {};
+    };
+
+    void run();
+
+    std::chrono::nanoseconds              m_interval      = {};
+    bool                                  m_running       = true;
+    size_t                                m_files         = 0;
+    size_t                                m_samples       = 0;
+    std::mutex                            m_mutex         = {};
+    std::condition_variable               m_cv            = {};
+    locking::atomic_mutex                 m_pending_mutex = {};
+    std::map<int64_t, thread_chunk>       m_pending       = {};
+    std::unordered_map<int64_t, uint64_t> m_last          = {};  // end of last sample
+    std::unique_ptr<std::thread>          m_thread        = {};
+};
+
+std::once_flag flush_writer_once     = {};
+flush_writer*  flush_writer_instance = nullptr;
+
+flush_writer*
+get_flush_writer()
+{
+    // leaked: the allocators may still be handing off buffers during exit
+    std::call_once(flush_writer_once, []() {
+        auto _interval = config::get_flush_interval();
+        if(_interval > 0.0) flush_writer_instance = new flush_writer{ _interval };
+    });
+    return flush_writer_instance;
+}
+
+void
+offload_buffer(int64_t _seq, sampler_buffer_t&& _buf)
+{
+    // the samples are written by the periodic flush instead
+    if(auto* _flush = get_flush_writer(); _flush)
+    {
+        _flush->append(_seq, _buf);
+        _buf.destroy();
+        return;
+    }
+
+    auto* _writer = get_offload_writer();
+    if(_writer && _writer->submit(_seq, std::move(_buf))) return;
+
+    write_offload_buffer(_seq, std::move(_buf));
+}
+
+void
+shutdown_offload_writer()
+{
+    // prevent the writer from being created if nothing has been offloaded yet
+    std::call_once(offload_writer_once, []() {});
+    if(offload_writer_instance) offload_writer_instance->shutdown();
 }
 
 auto
 load_offload_buffer(int64_t _thread_idx)
 {
-    auto _data = std::vector<sampler_buffer_t>{};
+    auto _data = std::vector<sampler_bundle_t>{};
     if(!get_use_tmp_files())
     {
         OMNITRACE_WARNING_F(
@@ -482,32 +1173,37 @@ load_offload_buffer(int64_t _thread_idx)
 
     if(offload_seq_data.count(_thread_idx) == 0) return _data;
 
-    size_t _count = 0;
+    auto _encoded = std::string{};
     for(auto itr : offload_seq_data.at(_thread_idx))
     {
         _fs.seekg(itr);  // set to the absolute position
 
-        int64_t _seq = 0;
-        _fs.read(reinterpret_cast<char*>(&_seq), sizeof(_seq));
+        auto _header = offload_codec::block_header{};
+        _fs.read(reinterpret_cast<char*>(&_header), sizeof(_header));
         if(_fs.eof()) break;
 
-        sampler_buffer_t _buffer{};
-        _buffer.load(_fs);
+        if(!_header.is_valid() || _header.seq != _thread_idx)
+        {
+            OMNITRACE_WARNING_F(0,
+                                "[sampling] file position %zu returned an invalid sample "
+                                "block (seq %zi, expected %zi)\n",
+                                static_cast<uintptr_t>(itr), _header.seq, _thread_idx);
+            continue;
+        }
 
-        if(_seq != _thread_idx)
+        _encoded.resize(_header.nbytes);
+        _fs.read(_encoded.data(), _encoded.size());
+        if(!_fs || !offload_codec::decode(_header, _encoded.data(), _data))
         {
             OMNITRACE_WARNING_F(
-                0,
-                "[sampling] file position %zu returned %zi instead of (expected) %zi\n",
-                static_cast<uintptr_t>(itr), _seq, _thread_idx);
-            continue;
+                0, "[sampling] file position %zu contains a truncated sample block\n",
+                static_cast<uintptr_t>(itr));
+            break;
         }
-        _count += _buffer.count();
-        _data.emplace_back(std::move(_buffer));
     }
 
-    OMNITRACE_VERBOSE_F(2, "[sampling] Loaded %zu samples for thread %li...\n", _count,
-                        _thread_idx);
+    OMNITRACE_VERBOSE_F(2, "[sampling] Loaded %zu samples for thread %li...\n",
+                        _data.size(), _thread_idx);
 
     _file->close();
 
@@ -519,9 +1215,8 @@ configure(bool _setup, int64_t _tid)
 {
     const auto& _info         = thread_info::get(_tid, SequentTID);
     auto&       _sampler      = sampling::get_sampler(_tid);
-    auto&       _perf_sampler = perf::get_instance(_tid);
     auto&       _running      = get_sampler_running(_tid);
-    bool        _is_running   = (!_running) ? false : *_running;
+    bool        _is_running   = _running;
     auto&       _signal_types = sampling::get_signal_types(_tid);
 
     OMNITRACE_CONDITIONAL_THROW(get_use_causal(),
@@ -575,6 +1270,11 @@ configure(bool _setup, int64_t _tid)
         auto _verbose = std::min<int>(get_verbose() - 2, 2);
         if(get_debug_sampling()) _verbose = 2;
 
+        // the call-stacks are interned from the signal handlers so the tree must
+        // be allocated before any samples are taken
+        calling_context::configure(_tid);
+        backtrace::configure(_setup, _tid);
+
         OMNITRACE_DEBUG("Requesting allocator for sampler on thread %lu...\n", _tid);
         auto _alloc = get_sampler_allocator();
 
@@ -593,7 +1293,39 @@ configure(bool _setup, int64_t _tid)
                                        threading::get_sys_tid() });
         }
 
-        if(_signal_types->count(get_sampling_cputime_signal()) > 0)
+        // the CPU-time samples of the perf backend are recorded by the kernel and
+        // drained off-thread so no timer (or signal) is configured for them
+        bool _use_perf_cputime = false;
+        if(_signal_types->count(get_sampling_cputime_signal()) > 0 &&
+           get_sampling_backend() == "perf")
+        {
+            auto _perf_error = perf_sampler::start(
+                _tid, _info->index_data->system_value, get_sampling_cputime_freq(),
+                get_sampling_cputime_delay());
+            _use_perf_cputime = !_perf_error;
+            if(_perf_error)
+            {
+                OMNITRACE_WARNING(0,
+                                  "perf backend for CPU-time sampling failed to "
+                                  "activate on thread %li (using timer): %s\n",
+                                  _tid, _perf_error->c_str());
+            }
+        }
+
+        if(get_sampling_off_cpu())
+        {
+            auto _off_cpu_error =
+                perf_sampler::start_off_cpu(_tid, _info->index_data->system_value);
+            if(_off_cpu_error)
+            {
+                OMNITRACE_WARNING(0,
+                                  "off-CPU tracing failed to activate on thread %li: "
+                                  "%s\n",
+                                  _tid, _off_cpu_error->c_str());
+            }
+        }
+
+        if(_signal_types->count(get_sampling_cputime_signal()) > 0 && !_use_perf_cputime)
         {
             _sampler->configure(
                 timer{ get_sampling_cputime_signal(), CLOCK_THREAD_CPUTIME_ID,
@@ -606,61 +1338,108 @@ configure(bool _setup, int64_t _tid)
             if(_signal_types->size() == 1)
                 trait::runtime_enabled<backtrace_metrics>::set(false);
 
-            _perf_sampler = std::make_unique<perf::perf_event>();
+            const auto& _events = get_overflow_events();
+            OMNITRACE_REQUIRE(!_events.empty()) << "no overflow sampling events";
+
+            for(size_t i = 0; i < _events.size(); ++i)
+            {
+                const auto& _event = _events.at(i);
+                auto&       _perf  = perf::get_instance(_tid, i);
 
-            struct perf_event_attr _pe;
-            memset(&_pe, 0, sizeof(_pe));
+                _perf = std::make_unique<perf::perf_event>();
 
-            auto _freq = get_sampling_overflow_freq();
-            auto _overflow_event =
-                get_setting_value<std::string>("OMNITRACE_SAMPLING_OVERFLOW_EVENT")
-                    .value_or("perf::PERF_COUNT_HW_CACHE_REFERENCES");
+                struct perf_event_attr _pe;
+                memset(&_pe, 0, sizeof(_pe));
 
-            perf::config_overflow_sampling(_pe, _overflow_event, _freq);
+                perf::config_overflow_sampling(_pe, _event.name, _event.freq);
 
-            _pe.sample_type = PERF_SAMPLE_TIME | PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
+                _pe.sample_type =
+                    PERF_SAMPLE_TIME | PERF_SAMPLE_IP | PERF_SAMPLE_CALLCHAIN;
 
-            _pe.wakeup_events            = 10;
-            _pe.exclude_idle             = 1;
-            _pe.exclude_kernel           = 1;
-            _pe.exclude_hv               = 1;
-            _pe.exclude_callchain_kernel = 1;
-            _pe.disabled                 = 1;
-            _pe.inherit                  = 0;
+                // the data address and the CPU of the loads identify the remote
+                // accesses. Only the leader of the group samples them
+                if(i == 0 && config::get_numa_locality())
+                {
+                    perf::config_raw_event(_pe, config::get_numa_locality_event());
+                    _pe.sample_type |= PERF_SAMPLE_ADDR | PERF_SAMPLE_CPU;
+                }
 
-            if(_pe.type == PERF_TYPE_SOFTWARE)
-            {
-                _pe.use_clockid = 1;
-                _pe.clockid     = CLOCK_REALTIME;
-            }
+                // the data address, latency and data source of the sampled accesses
+                auto _memory_event = std::string{};
+                if(i == 0 && config::get_sampling_memory())
+                {
+                    _memory_event = component::memory_access::get_event();
+                    perf::config_raw_event(_pe, _memory_event);
+                    _pe.sample_type |=
+                        PERF_SAMPLE_ADDR | PERF_SAMPLE_WEIGHT | PERF_SAMPLE_DATA_SRC;
+                }
+
+                _pe.wakeup_events            = 10;
+                _pe.exclude_idle             = 1;
+                _pe.exclude_kernel           = 1;
+                _pe.exclude_hv               = 1;
+                _pe.exclude_callchain_kernel = 1;
+                _pe.disabled                 = 1;
+                _pe.inherit                  = 0;
+
+                // IBS cannot filter the privilege levels so the kernel samples are
+                // dropped by memory_access::record_sample
+                if(_memory_event.find("ibs_op/") == 0)
+                {
+                    _pe.exclude_idle   = 0;
+                    _pe.exclude_kernel = 0;
+                    _pe.exclude_hv     = 0;
+                }
+
+                if(_pe.type == PERF_TYPE_SOFTWARE)
+                {
+                    _pe.use_clockid = 1;
+                    _pe.clockid     = CLOCK_REALTIME;
+                }
+
+                // the members of the group are scheduled onto the PMU together with
+                // the leader so all of the events are sampled over the same intervals
+                auto _group_fd = -1;
+                if(i > 0) _group_fd = perf::get_instance(_tid)->get_fileno();
+                auto _perf_open_error =
+                    _perf->open(_pe, _info->index_data->system_value, -1, _group_fd);
 
-            auto _perf_open_error =
-                _perf_sampler->open(_pe, _info->index_data->system_value);
+                OMNITRACE_REQUIRE(!_perf_open_error)
+                    << "perf backend for overflow event '" << _event.name
+                    << "' failed to activate: " << *_perf_open_error;
 
-            OMNITRACE_REQUIRE(!_perf_open_error)
-                << "perf backend for overflow failed to activate: " << *_perf_open_error;
+                _perf->set_ready_signal(get_sampling_overflow_signal());
+            }
 
-            _perf_sampler->set_ready_signal(get_sampling_overflow_signal());
             _sampler->configure(overflow{
                 get_sampling_overflow_signal(),
                 [](int _sig, pid_t, long, int64_t _idx) {
-                    perf::get_instance(_idx)->set_ready_signal(_sig);
-                    return true;
-                },
+                    return for_each_overflow_instance(_idx, [_sig](auto& _perf) {
+                        _perf->set_ready_signal(_sig);
+                        return true;
+                    });
+                },
                 [](int, pid_t, long, int64_t _idx) {
-                    return perf::get_instance(_idx)->start();
+                    return for_each_overflow_instance(
+                        _idx, [](auto& _perf) { return _perf->start(); });
                 },
                 [](int, pid_t, long, int64_t _idx) {
-                    if(!perf::get_instance(_idx) || !perf::get_instance(_idx)->is_open())
-                        return true;
-                    auto _stopped = perf::get_instance(_idx)->stop();
-                    if(_stopped) perf::get_instance(_idx)->close();
-                    return _stopped;
+                    return for_each_overflow_instance(_idx, [](auto& _perf) {
+                        if(!_perf->is_open()) return true;
+                        auto _stopped = _perf->stop();
+                        // the perf_event is restarted when the trace window opens
+                        if(_stopped && !get_pause_state().paused) _perf->close();
+                        return _stopped;
+                    });
                 },
                 _tid, threading::get_sys_tid() });
         }
 
-        if(get_use_tmp_files())
+        if(get_flush_writer())
+        {
+            _sampler->set_offload(&offload_buffer);
+        }
+        else if(get_use_tmp_files())
         {
             auto _file = get_offload_file();
             if(_file && *_file) _sampler->set_offload(&offload_buffer);
@@ -686,14 +1465,18 @@ configure(bool _setup, int64_t _tid)
         {
             if(itr == get_sampling_overflow_signal())
             {
-                auto _freq = get_sampling_overflow_freq();
-                auto _overflow_event =
-                    get_setting_value<std::string>("OMNITRACE_SAMPLING_OVERFLOW_EVENT")
-                        .value_or("perf::PERF_COUNT_HW_CACHE_REFERENCES");
+                for(const auto& eitr : get_overflow_events())
+                    OMNITRACE_VERBOSE(2,
+                                      "[SIG%i] Sampler for thread %lu will be triggered "
+                                      "every %.1f %s events...\n",
+                                      itr, _tid, eitr.freq, eitr.name.c_str());
+            }
+            else if(itr == get_sampling_cputime_signal() && _use_perf_cputime)
+            {
                 OMNITRACE_VERBOSE(2,
-                                  "[SIG%i] Sampler for thread %lu will be triggered "
-                                  "every %.1f %s events...\n",
-                                  itr, _tid, _freq, _overflow_event.c_str());
+                                  "[perf] Sampler for thread %lu will be triggered "
+                                  "%.1fx per second of CPU-time...\n",
+                                  _tid, get_sampling_cputime_freq());
             }
             else
             {
@@ -713,15 +1496,18 @@ configure(bool _setup, int64_t _tid)
             }
         }
 
-        *_running = true;
+        _running = true;
         sampling::get_sampler_init(_tid)->sample();
         start_duration_thread();
-        _sampler->start();
+
+        auto& _pause = get_pause_state();
+        auto  _lk    = std::unique_lock<std::mutex>{ _pause.mutex };
+        if(!_pause.paused) _sampler->start();
     }
     else if(!_setup && _sampler && _is_running)
     {
         OMNITRACE_DEBUG("Stopping sampler for thread %lu...\n", _tid);
-        *_running = false;
+        _running = false;
 
         if(_tid == threading::get_id() && !_signal_types->empty())
         {
@@ -739,23 +1525,28 @@ configure(bool _setup, int64_t _tid)
 
         _sampler->stop();
         _sampler->reset();
-        *_running = false;
-        if(_perf_sampler) _perf_sampler->stop();
+        _running = false;
+        for_each_overflow_instance(_tid, [](auto& _perf) { return _perf->stop(); });
+        perf_sampler::stop(_tid);
 
         if(_tid == 0)
         {
             for(int64_t i = 1; i < OMNITRACE_MAX_THREADS; ++i)
             {
                 if(sampling::get_sampler(i)) sampling::get_sampler(i)->stop();
-                if(perf::get_instance(i)) perf::get_instance(i)->stop();
+                for_each_overflow_instance(i,
+                                           [](auto& _perf) { return _perf->stop(); });
+                perf_sampler::stop(i);
             }
 
+            perf_sampler::stop_cpus();
+
             for(int64_t i = 1; i < OMNITRACE_MAX_THREADS; ++i)
             {
                 if(sampling::get_sampler(i))
                 {
                     sampling::get_sampler(i)->reset();
-                    *get_sampler_running(i) = false;
+                    get_sampler_running(i) = false;
                 }
             }
 
@@ -775,11 +1566,21 @@ configure(bool _setup, int64_t _tid)
     return (_signal_types) ? *_signal_types : std::set<int>{};
 }
 
+// perfetto counter track of the effective timer sampling rate of each thread
+struct sampling_rate_track
+{};
+
+// perfetto counter track of the CPU each thread was sampled on
+struct cpu_residency_track
+{};
+
 struct timer_sampling_data
 {
     int64_t                                   m_tid     = -1;
     uint64_t                                  m_beg     = 0;
     uint64_t                                  m_end     = 0;
+    tim::hash_value_t                         m_region  = 0;
+    int32_t                                   m_cpu     = -1;
     std::vector<tim::unwind::processed_entry> m_stack   = {};
     backtrace_metrics                         m_metrics = {};
 };
@@ -787,26 +1588,307 @@ struct timer_sampling_data
 struct overflow_sampling_data
 {
     int64_t                                   m_tid   = -1;
+    size_t                                    m_event = 0;  // index of the overflow event
     uint64_t                                  m_beg   = 0;
     uint64_t                                  m_end   = 0;
     std::vector<tim::unwind::processed_entry> m_stack = {};
 };
 
+// interval in which the thread was not running and the call-stack where it stopped
+struct off_cpu_sampling_data
+{
+    int64_t                                   m_tid       = -1;
+    uint64_t                                  m_beg       = 0;
+    uint64_t                                  m_end       = 0;
+    bool                                      m_preempted = false;
+    std::vector<tim::unwind::processed_entry> m_stack     = {};
+};
+
+// decoded samples for a single thread, produced by the (possibly parallel) decoding
+// phase and consumed in thread order by the perfetto and timemory phases
+struct thread_sampling_data
+{
+    size_t                              m_num_valid     = 0;
+    std::vector<timer_sampling_data>    m_timer_data    = {};
+    std::vector<overflow_sampling_data> m_overflow_data = {};
+    std::vector<off_cpu_sampling_data>  m_off_cpu_data  = {};
+};
+
+// samples of a thread which were buffered by the sampler or offloaded. The mapped
+// segment holds the oldest samples
+struct thread_samples
+{
+    using data_type = decltype(std::declval<sampler_t&>().get_data());
+
+    data_type mapped = {};
+    data_type raw    = {};
+};
+
+thread_samples
+load_thread_samples(int64_t);
+
+void
+post_process_thread_data(int64_t, thread_sampling_data&);
+
+// the raw samples of a thread for OMNITRACE_DEFER_POST_PROCESSING
+raw_data::thread
+get_raw_thread_data(int64_t);
+
+// fills in the process info and the loaded objects and writes the container to the
+// output file with the given name. Returns the name of the file
+std::string
+write_raw_file(const std::string&, raw_data::container&);
+
+// returns the number of samples and the number of threads with samples
+std::pair<size_t, size_t>
+write_raw_data(size_t _num_threads);
+
 std::vector<timer_sampling_data>
 post_process_timer_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
 
 std::vector<overflow_sampling_data>
 post_process_overflow_data(int64_t, const bundle_t*, const std::vector<bundle_t*>&);
 
+std::vector<timer_sampling_data>
+post_process_perf_data(int64_t);
+
+std::vector<off_cpu_sampling_data>
+post_process_off_cpu_data(int64_t);
+
+void
+post_process_perfetto(int64_t, const std::vector<off_cpu_sampling_data>&);
+
+void
+post_process_cpu_data();
+
+void
+post_process_parquet(int64_t, const thread_sampling_data&);
+
+void
+post_process_folded(int64_t, const thread_sampling_data&);
+
+void
+start_system_wide();
+
 void
 post_process_perfetto(int64_t, const std::vector<timer_sampling_data>&,
                       const std::vector<overflow_sampling_data>&);
 
+// symbolization of a single call-stack frame: every string needed by the perfetto
+// and timemory post-processing is demangled, formatted, and interned exactly once
+struct sampling_frame
+{
+    struct inlined
+    {
+        const char* name    = nullptr;  // demangled function name
+        const char* label   = nullptr;  // lineinfo-<N>
+        const char* summary = nullptr;  // <name>@<file>:<line>
+
+        tracing::source_location source = {};
+    };
+
+    const char*              name         = nullptr;
+    const char*              location     = nullptr;
+    const char*              pc           = nullptr;
+    const char*              line_address = nullptr;
+    tracing::source_location source       = {};
+    std::vector<inlined>     lines        = {};  // outermost inlined function first
+};
+
+template <typename CategoryT>
+const sampling_frame&
+get_sampling_frame(CategoryT, const tim::unwind::processed_entry&);
+
+// calling-context tree of the samples of a thread. Each node is a frame (keyed by its
+// interned name) below its parent frame and holds the number of samples in that
+// calling-context and their summed metrics, so each unique calling-context is
+// inserted into the timemory call-graph once instead of once per sample
+template <typename DataT>
+struct sampling_cct
+{
+    struct node
+    {
+        const char*                             name     = nullptr;
+        int64_t                                 count    = 0;
+        DataT                                   data     = {};
+        std::vector<size_t>                     children = {};  // in first-seen order
+        std::unordered_map<const char*, size_t> lookup   = {};
+    };
+
+    sampling_cct() { nodes.emplace_back(); }
+
+    // returns the index of the child of the given node and adds to its count
+    size_t child(size_t _parent, const char* _name, int64_t _count = 1);
+
+    // adds the nodes of the given tree, matching the children of a node by name
+    void merge(const sampling_cct& _rhs, size_t _lhs_idx = 0, size_t _rhs_idx = 0);
+
+    // pushes and starts a bundle for every node, with the bundles of the children
+    // nested inside, and invokes the function with the stopped bundle and the node
+    // before the bundle is popped
+    template <typename BundleT, typename FuncT>
+    void insert(int64_t _tid, FuncT&& _func, size_t _idx = 0) const;
+
+    std::vector<node> nodes = {};
+};
+
+template <typename DataT>
+size_t
+sampling_cct<DataT>::child(size_t _parent, const char* _name, int64_t _count)
+{
+    auto _idx = nodes.size();
+    auto itr  = nodes.at(_parent).lookup.emplace(_name, _idx);
+    if(itr.second)
+    {
+        nodes.at(_parent).children.emplace_back(_idx);
+        nodes.emplace_back();
+        nodes.back().name = _name;
+    }
+    else
+    {
+        _idx = itr.first->second;
+    }
+    nodes.at(_idx).count += _count;
+    return _idx;
+}
+
+template <typename DataT>
 void
-post_process_timemory(int64_t, const std::vector<timer_sampling_data>&,
-                      const std::vector<overflow_sampling_data>&);
+sampling_cct<DataT>::merge(const sampling_cct& _rhs, size_t _lhs_idx, size_t _rhs_idx)
+{
+    for(auto citr : _rhs.nodes.at(_rhs_idx).children)
+    {
+        const auto& _node = _rhs.nodes.at(citr);
+
+        auto _idx = child(_lhs_idx, _node.name, _node.count);
+        nodes.at(_idx).data += _node.data;
+        merge(_rhs, _idx, citr);
+    }
+}
+
+template <typename DataT>
+template <typename BundleT, typename FuncT>
+void
+sampling_cct<DataT>::insert(int64_t _tid, FuncT&& _func, size_t _idx) const
+{
+    for(auto citr : nodes.at(_idx).children)
+    {
+        const auto& _node = nodes.at(citr);
+
+        auto _bundle = BundleT{ tim::string_view_t{ _node.name } };
+        _bundle.push(_tid);
+        _bundle.start();
+        insert<BundleT>(_tid, _func, citr);
+        _bundle.stop();
+        // the laps (and the trip count) reflect the number of samples
+        for(int64_t i = 1; i < _node.count; ++i)
+        {
+            _bundle.start();
+            _bundle.stop();
+        }
+        _func(_bundle, _node);
+        _bundle.pop();
+    }
+}
+
+struct overflow_cct_data
+{
+    double wall    = 0.0;
+    double percent = 0.0;
+
+    overflow_cct_data& operator+=(const overflow_cct_data& _rhs)
+    {
+        wall += _rhs.wall;
+        percent += _rhs.percent;
+        return *this;
+    }
+};
+
+struct timer_cct_data
+{
+    using hw_counter_data_t = typename backtrace_metrics::hw_counter_data_t;
+
+    bool              has_cpu = false;
+    bool              has_hw  = false;
+    double            wall    = 0.0;
+    double            cpu     = 0.0;
+    double            percent = 0.0;
+    hw_counter_data_t hw      = {};
+
+    timer_cct_data& operator+=(const timer_cct_data& _rhs)
+    {
+        has_cpu = (has_cpu || _rhs.has_cpu);
+        has_hw  = (has_hw || _rhs.has_hw);
+        wall += _rhs.wall;
+        cpu += _rhs.cpu;
+        percent += _rhs.percent;
+        for(size_t i = 0; i < hw.size(); ++i)
+            hw[i] += _rhs.hw[i];
+        return *this;
+    }
+};
 
-auto static_strings = std::set<std::string>{};
+// the calling-context trees of the samples of a thread (or of every thread when
+// OMNITRACE_COLLAPSE_THREADS is enabled) before they are inserted into timemory
+struct thread_sampling_cct
+{
+    sampling_cct<double>            off_cpu  = {};
+    sampling_cct<overflow_cct_data> overflow = {};
+    sampling_cct<timer_cct_data>    timer    = {};
+
+    thread_sampling_cct& operator+=(const thread_sampling_cct& _rhs)
+    {
+        off_cpu.merge(_rhs.off_cpu);
+        overflow.merge(_rhs.overflow);
+        timer.merge(_rhs.timer);
+        return *this;
+    }
+};
+
+void
+build_sampling_cct(const std::vector<off_cpu_sampling_data>&, thread_sampling_cct&);
+
+void
+build_sampling_cct(int64_t, const std::vector<timer_sampling_data>&,
+                   const std::vector<overflow_sampling_data>&, thread_sampling_cct&);
+
+thread_sampling_cct
+reduce_sampling_cct(std::vector<thread_sampling_cct>&);
+
+void
+post_process_timemory(int64_t, const thread_sampling_cct&);
+
+// number of timer samples of each leaf function per region, accumulated over the
+// threads when OMNITRACE_SAMPLING_REGION_CONTEXT is enabled
+using region_hotspots_t =
+    std::unordered_map<tim::hash_value_t, std::unordered_map<const char*, size_t>>;
+
+void
+build_region_hotspots(const std::vector<timer_sampling_data>&, region_hotspots_t&);
+
+void
+write_region_hotspots(const region_hotspots_t&);
+
+// CPU residency of the timer samples of a thread when OMNITRACE_SAMPLING_CPU_RESIDENCY
+// is enabled. A migration is a change of the CPU between consecutive samples so the
+// migrations in between samples are not counted
+struct thread_cpu_residency
+{
+    int64_t                   tid        = -1;
+    size_t                    samples    = 0;
+    size_t                    migrations = 0;
+    uint64_t                  beg        = 0;
+    uint64_t                  end        = 0;
+    std::map<int32_t, size_t> cpus       = {};  // number of samples on each CPU
+};
+
+using cpu_residency_t = std::vector<thread_cpu_residency>;
+
+void
+build_cpu_residency(int64_t, const std::vector<timer_sampling_data>&, cpu_residency_t&);
+
+void
+write_cpu_residency(const cpu_residency_t&);
 
 }  // namespace
 
@@ -821,6 +1903,7 @@ std::set<int>
 setup()
 {
     if(!get_use_sampling()) return std::set<int>{};
+    if(get_sampling_system_wide()) start_system_wide();
     return configure(true);
 }
 
@@ -851,6 +1934,42 @@ unblock_samples()
     trait::runtime_enabled<sampler_t>::set(true);
 }
 
+void
+pause()
+{
+    auto& _pause = get_pause_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _pause.mutex };
+    if(_pause.paused) return;
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(), "Pausing the samplers...\n");
+
+    _pause.paused = true;
+    for(int64_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
+    {
+        if(get_sampler_running(i) && sampling::get_sampler(i))
+            sampling::get_sampler(i)->stop();
+    }
+    perf_sampler::pause();
+}
+
+void
+resume()
+{
+    auto& _pause = get_pause_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _pause.mutex };
+    if(!_pause.paused) return;
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(), "Resuming the samplers...\n");
+
+    _pause.paused = false;
+    perf_sampler::resume();
+    for(int64_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
+    {
+        if(get_sampler_running(i) && sampling::get_sampler(i))
+            sampling::get_sampler(i)->start();
+    }
+}
+
 void
 block_signals(std::set<int> _signals)
 {
@@ -885,6 +2004,95 @@ unblock_signals(std::set<int> _signals)
     thread_sigmask(SIG_UNBLOCK, &_v, nullptr);
 }
 
+namespace
+{
+enum idle_mode : uint8_t
+{
+    IDLE_SAMPLE = 0,
+    IDLE_SUSPEND,
+    IDLE_DOWNSAMPLE,
+};
+
+idle_mode
+get_idle_mode()
+{
+    static auto _v = []() {
+        auto _mode = config::get_sampling_idle();
+        if(_mode == "suspend") return IDLE_SUSPEND;
+        if(_mode == "downsample") return IDLE_DOWNSAMPLE;
+        return IDLE_SAMPLE;
+    }();
+    return _v;
+}
+
+struct idle_state
+{
+    uint32_t depth   = 0;
+    sigset_t blocked = {};  // the timer signals which were blocked by suspend_idle
+};
+
+idle_state&
+get_idle_state()
+{
+    static thread_local auto _v = idle_state{};
+    return _v;
+}
+}  // namespace
+
+void
+suspend_idle()
+{
+    if(get_idle_mode() == IDLE_SAMPLE) return;
+
+    auto& _state = get_idle_state();
+    if(_state.depth++ > 0) return;
+
+    sigemptyset(&_state.blocked);
+
+    auto        _tid     = threading::get_id();
+    if(!get_sampler_running(_tid)) return;
+
+    // the overflow samples are only generated while the thread is running
+    auto _signals = sigset_t{};
+    sigemptyset(&_signals);
+    for(auto itr : *get_signal_types(_tid))
+    {
+        if(itr == get_sampling_realtime_signal() || itr == get_sampling_cputime_signal())
+            sigaddset(&_signals, itr);
+    }
+
+    // the signals which are already blocked by the thread must not be unblocked on wake
+    auto _prev = sigset_t{};
+    thread_sigmask(SIG_BLOCK, &_signals, &_prev);
+    for(auto itr : *get_signal_types(_tid))
+    {
+        if(sigismember(&_signals, itr) == 1 && sigismember(&_prev, itr) == 0)
+            sigaddset(&_state.blocked, itr);
+    }
+}
+
+void
+resume_idle()
+{
+    if(get_idle_mode() == IDLE_SAMPLE) return;
+
+    auto& _state = get_idle_state();
+    if(_state.depth == 0 || --_state.depth > 0) return;
+    if(sigisemptyset(&_state.blocked) == 1) return;
+
+    // the timers only queue one signal while blocked so this consumes at most one per
+    // timer
+    if(get_idle_mode() == IDLE_SUSPEND)
+    {
+        auto _timeout = timespec{ 0, 0 };
+        while(sigtimedwait(&_state.blocked, nullptr, &_timeout) > 0)
+        {}
+    }
+
+    thread_sigmask(SIG_UNBLOCK, &_state.blocked, nullptr);
+    sigemptyset(&_state.blocked);
+}
+
 void
 post_process()
 {
@@ -903,102 +2111,156 @@ post_process()
     for(auto& itr : get_sampler_allocators())
         if(itr) itr->flush();
 
-    for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
-    {
-        auto& _sampler = get_sampler(i);
+    // wait for the queued buffers to be written before reading them back
+    shutdown_offload_writer();
 
-        if(!_sampler)
-        {
-            // this should be relatively common
-            OMNITRACE_CONDITIONAL_PRINT(
-                get_debug() && get_verbose() >= 2,
-                "Post-processing sampling entries for thread %lu skipped (no sampler)\n",
-                i);
-            continue;
-        }
+    // drain the remaining records of the perf backend and stop its thread
+    perf_sampler::shutdown();
+
+    // prevent the flush writer from being created if sampling was never configured
+    std::call_once(flush_writer_once, []() {});
 
-        auto* _init = get_sampler_init(i).get();
+    auto  _num_threads = thread_info::get_peak_num_threads();
+    auto* _flush       = flush_writer_instance;
+    auto  _deferred    = config::get_defer_post_processing() || _flush != nullptr;
 
-        if(!_init)
+    // the raw samples are written for omnitrace-post instead of being decoded
+    if(_flush)
+    {
+        _flush->shutdown();
+        for(size_t i = 0; i < _num_threads; ++i)
         {
-            // this is not common
-            OMNITRACE_PRINT("Post-processing sampling entries for thread %lu skipped "
-                            "(not initialized)\n",
-                            i);
-            continue;
+            auto _thread = get_raw_thread_data(i);
+            if(!_thread.samples.empty()) _flush->append(std::move(_thread));
         }
+        _flush->flush();
+
+        _total_data    = _flush->num_samples();
+        _total_threads = _flush->num_threads();
+        OMNITRACE_VERBOSE(1 || get_debug_sampling(),
+                          "Flushed %zu samples from %zu threads to %zu files. Run "
+                          "omnitrace-post on the raw-samples-flush files to generate "
+                          "the output\n",
+                          _total_data, _total_threads, _flush->num_files());
+    }
+    else if(_deferred)
+    {
+        std::tie(_total_data, _total_threads) = write_raw_data(_num_threads);
+    }
 
-        const auto& _thread_info = thread_info::get(i, SequentTID);
-
-        OMNITRACE_VERBOSE(3 || get_debug_sampling(),
-                          "Getting sampler data for thread %lu...\n", i);
+    auto _thread_data = std::vector<thread_sampling_data>((_deferred) ? 0 : _num_threads);
+    auto _parquet =
+        !_deferred && config::get_sampling_parquet_output() && parquet_output::setup();
+    auto _folded = !_deferred && config::get_folded_output() && folded_output::setup();
 
-        auto _raw_data    = _sampler->get_data();
-        auto _loaded_data = load_offload_buffer(i);
-        for(auto litr : _loaded_data)
+    // decoding the samples (unwinding, symbol resolution, filtering, etc.) for one
+    // thread is independent of every other thread so it is sharded across the
+    // thread-pool. The perfetto and timemory output is generated afterwards in
+    // thread order so the results do not depend on the task scheduling.
+    {
+        auto _num_workers =
+            std::min<size_t>(config::get_thread_pool_size(), _thread_data.size());
+        if(_num_workers > 1)
         {
-            while(!litr.is_empty())
+            OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                              "Decoding sampling data for %zu threads with %zu "
+                              "workers...\n",
+                              _num_threads, _num_workers);
+
+            auto& _task_group = tasking::general::get_task_group();
+            for(size_t i = 0; i < _thread_data.size(); ++i)
             {
-                auto _v = sampler_bundle_t{};
-                litr.read(&_v);
-                _raw_data.emplace_back(std::move(_v));
+                _task_group.exec([i, &_thread_data]() {
+                    post_process_thread_data(i, _thread_data.at(i));
+                });
             }
-            litr.destroy();
+            _task_group.join();
         }
-
-        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
-                          "Sampler data for thread %lu has %zu initial entries...\n", i,
-                          _raw_data.size());
-
-        OMNITRACE_CI_THROW(
-            _sampler->get_sample_count() != _raw_data.size(),
-            "Error! sampler recorded %zu samples but %zu samples were returned\n",
-            _sampler->get_sample_count(), _raw_data.size());
-        // single sample that is useless (backtrace to unblocking signals)
-        if(_raw_data.size() == 1 && _raw_data.front().size() <= 1) _raw_data.clear();
-
-        std::vector<sampling::bundle_t*> _data{};
-        for(auto& itr : _raw_data)
+        else
         {
-            auto* _bt = itr.get<backtrace>();
-            auto* _cc = itr.get<callchain>();
-            auto* _ts = itr.get<backtrace_timestamp>();
-            if(_thread_info && ((_bt && !_bt->empty()) || (_cc && !_cc->empty())) &&
-               _ts && _thread_info->is_valid_time(_ts->get_timestamp()))
-            {
-                _data.emplace_back(&itr);
-            }
+            for(size_t i = 0; i < _thread_data.size(); ++i)
+                post_process_thread_data(i, _thread_data.at(i));
         }
+    }
 
-        _total_data += _data.size();
-        _total_threads += (!_data.empty()) ? 1 : 0;
+    // with OMNITRACE_COLLAPSE_THREADS, the calling-context trees of the threads are
+    // reduced in parallel and inserted into the storage of the main thread once instead
+    // of timemory merging the call-graph of every thread serially
+    auto _collapse =
+        get_use_timemory() &&
+        config::get_setting_value<bool>("OMNITRACE_COLLAPSE_THREADS").value_or(false);
+    auto _cct_data =
+        std::vector<thread_sampling_cct>((_collapse) ? _thread_data.size() : 0);
+    auto _region_hotspots = region_hotspots_t{};
+    auto _cpu_residency   = cpu_residency_t{};
+
+    for(size_t i = 0; i < _thread_data.size(); ++i)
+    {
+        auto& _data = _thread_data.at(i);
+        auto  _cct  = thread_sampling_cct{};
+
+        _total_data += _data.m_num_valid;
+        _total_threads += (_data.m_num_valid > 0) ? 1 : 0;
 
-        if(!_data.empty())
+        if(!_data.m_off_cpu_data.empty())
         {
-            OMNITRACE_VERBOSE(2 || get_debug_sampling(),
-                              "Sampler data for thread %lu has %zu valid entries...\n", i,
-                              _data.size());
+            if(config::get_snapshot().use_perfetto)
+                post_process_perfetto(i, _data.m_off_cpu_data);
+            if(config::get_snapshot().use_timemory)
+                build_sampling_cct(_data.m_off_cpu_data, _cct);
+        }
 
-            auto _timer_data    = post_process_timer_data(i, _init, _data);
-            auto _overflow_data = post_process_overflow_data(i, _init, _data);
+        if(_parquet) post_process_parquet(i, _data);
+        if(_folded) post_process_folded(i, _data);
 
-            if(get_use_perfetto()) post_process_perfetto(i, _timer_data, _overflow_data);
-            if(get_use_timemory()) post_process_timemory(i, _timer_data, _overflow_data);
-        }
-        else
+        if(!_data.m_timer_data.empty() || !_data.m_overflow_data.empty())
         {
-            OMNITRACE_VERBOSE(2 || get_debug_sampling(),
-                              "Sampler data for thread %lu has zero valid entries out of "
-                              "%zu... (skipped)\n",
-                              i, _raw_data.size());
+            if(get_use_perfetto())
+                post_process_perfetto(i, _data.m_timer_data, _data.m_overflow_data);
+            if(get_use_timemory())
+                build_sampling_cct(i, _data.m_timer_data, _data.m_overflow_data, _cct);
+            if(config::get_sampling_region_context())
+                build_region_hotspots(_data.m_timer_data, _region_hotspots);
+            if(config::get_sampling_cpu_residency())
+                build_cpu_residency(i, _data.m_timer_data, _cpu_residency);
         }
+
+        if(_collapse)
+            _cct_data.at(i) = std::move(_cct);
+        else if(get_use_timemory())
+            post_process_timemory(i, _cct);
+
+        // release the memory as soon as possible
+        _data = thread_sampling_data{};
+    }
+
+    if(_collapse)
+    {
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Reducing the sampling call-graphs of %zu threads...\n",
+                          _cct_data.size());
+        post_process_timemory(0, reduce_sampling_cct(_cct_data));
     }
 
+    if(!_region_hotspots.empty()) write_region_hotspots(_region_hotspots);
+    if(!_cpu_residency.empty()) write_cpu_residency(_cpu_residency);
+
+    if(get_use_perfetto() && !_deferred) post_process_cpu_data();
+    if(_parquet) parquet_output::shutdown();
+    if(_folded) folded_output::shutdown();
+
     OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                       "Destroying samplers and allocators...\n");
 
     get_offload_file().reset();  // remove the temporary file
 
+    // unmap and remove the per-thread offload segments
+    if(offload_segment_instances::get())
+    {
+        for(auto& itr : *offload_segment_instances::get())
+            itr.reset();
+    }
+
     for(size_t i = 0; i < thread_info::get_peak_num_threads(); ++i)
         get_sampler(i).reset();
 
@@ -1022,51 +2284,847 @@ post_process()
 
 namespace
 {
-std::vector<timer_sampling_data>
-post_process_timer_data(int64_t _tid, const bundle_t* _init,
-                        const std::vector<bundle_t*>& _data)
+void
+post_process_thread_data(int64_t _tid, thread_sampling_data& _result)
 {
-    auto _results = std::vector<timer_sampling_data>{};
+    // the off-CPU intervals are independent of the sampler
+    _result.m_off_cpu_data = post_process_off_cpu_data(_tid);
 
-    const auto* _last = _init;
-    for(const auto& itr : _data)
+    auto& _sampler = get_sampler(_tid);
+
+    if(!_sampler)
     {
-        auto*       _bt_data      = itr->get<backtrace>();
-        auto*       _bt_time      = itr->get<backtrace_timestamp>();
-        auto*       _bt_metrics   = itr->get<backtrace_metrics>();
-        const auto* _last_metrics = _last->get<backtrace_metrics>();
+        // this should be relatively common
+        OMNITRACE_CONDITIONAL_PRINT(
+            get_debug() && get_verbose() >= 2,
+            "Post-processing sampling entries for thread %li skipped (no sampler)\n",
+            _tid);
+        return;
+    }
 
-        if(!_bt_data || !_bt_time || _bt_data->empty() || _bt_time->get_tid() != _tid)
-            continue;
+    auto* _init = get_sampler_init(_tid).get();
 
-        auto _ret    = timer_sampling_data{};
-        _ret.m_tid   = _bt_time->get_tid();
-        _ret.m_beg   = _last->get<backtrace_timestamp>()->get_timestamp();
-        _ret.m_end   = _bt_time->get_timestamp();
-        _ret.m_stack = backtrace::filter_and_patch(_bt_data->get());
-        if constexpr(tim::trait::is_available<hw_counters>::value)
-        {
-            auto _hw_counters_enabled = [](const auto* _bt_v) {
-                return (_bt_v != nullptr) &&
-                       (*_bt_v)(type_list<backtrace_metrics::hw_counters>{}) &&
-                       (*_bt_v)(category::thread_hardware_counter{});
-            };
+    if(!_init)
+    {
+        // this is not common
+        OMNITRACE_PRINT("Post-processing sampling entries for thread %li skipped "
+                        "(not initialized)\n",
+                        _tid);
+        return;
+    }
 
-            if(_bt_metrics && _last_metrics && _hw_counters_enabled(_bt_metrics) &&
-               _hw_counters_enabled(_last_metrics))
-            {
-                _ret.m_metrics = (*_bt_metrics) - (*_last_metrics);
-            }
-        }
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
 
-        _results.emplace_back(std::move(_ret));
-        _last = itr;
-    }
+    OMNITRACE_VERBOSE(3 || get_debug_sampling(),
+                      "Getting sampler data for thread %li...\n", _tid);
+
+    auto  _samples     = load_thread_samples(_tid);
+    auto& _raw_data    = _samples.raw;
+    auto& _mapped_data = _samples.mapped;
+    auto  _num_mapped  = _mapped_data.size();
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "Sampler data for thread %li has %zu initial entries (%zu "
+                      "mapped)...\n",
+                      _tid, _raw_data.size() + _num_mapped, _num_mapped);
+
+    if(const auto* _tree = calling_context::get(_tid); _tree)
+    {
+        OMNITRACE_VERBOSE(2 || get_debug_sampling() || _tree->truncated() > 0,
+                          "Calling-context tree for thread %li has %zu of %zu nodes "
+                          "(%zu truncated call-stacks, %zu dropped call-stacks)...\n",
+                          _tid, _tree->size(), _tree->capacity(), _tree->truncated(),
+                          _tree->dropped());
+    }
+
+    OMNITRACE_CI_THROW(
+        _sampler->get_sample_count() != _raw_data.size() + _num_mapped,
+        "Error! sampler recorded %zu samples but %zu samples were returned\n",
+        _sampler->get_sample_count(), _raw_data.size() + _num_mapped);
+    // single sample that is useless (backtrace to unblocking signals)
+    if(_num_mapped == 0 && _raw_data.size() == 1 && _raw_data.front().size() <= 1)
+        _raw_data.clear();
+
+    std::vector<sampling::bundle_t*> _data{};
+    auto _add_data = [&_data, &_thread_info](sampler_bundle_t& itr) {
+        auto* _bt = itr.get<backtrace>();
+        auto* _cc = itr.get<callchain>();
+        auto* _ts = itr.get<backtrace_timestamp>();
+        if(_thread_info && ((_bt && !_bt->empty()) || (_cc && !_cc->empty())) && _ts &&
+           _thread_info->is_valid_time(_ts->get_timestamp()))
+        {
+            _data.emplace_back(&itr);
+        }
+    };
+
+    // the segment holds the oldest samples
+    for(auto& itr : _mapped_data)
+        _add_data(itr);
+
+    for(auto& itr : _raw_data)
+        _add_data(itr);
+
+    _result.m_num_valid = _data.size();
+
+    if(!_data.empty())
+    {
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Sampler data for thread %li has %zu valid entries...\n", _tid,
+                          _data.size());
+
+        _result.m_timer_data    = post_process_timer_data(_tid, _init, _data);
+        _result.m_overflow_data = post_process_overflow_data(_tid, _init, _data);
+    }
+    else
+    {
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Sampler data for thread %li has zero valid entries out of "
+                          "%zu... (skipped)\n",
+                          _tid, _raw_data.size());
+    }
+
+    if(perf_sampler::is_active(_tid))
+    {
+        auto _perf_data = post_process_perf_data(_tid);
+
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "perf sampler data for thread %li has %zu valid entries...\n",
+                          _tid, _perf_data.size());
+
+        _result.m_num_valid += _perf_data.size();
+        for(auto& itr : _perf_data)
+            _result.m_timer_data.emplace_back(std::move(itr));
+
+        std::sort(
+            _result.m_timer_data.begin(), _result.m_timer_data.end(),
+            [](const auto& _lhs, const auto& _rhs) { return _lhs.m_beg < _rhs.m_beg; });
+    }
+}
+
+thread_samples
+load_thread_samples(int64_t _tid)
+{
+    auto  _v           = thread_samples{};
+    auto  _loaded_data = load_offload_buffer(_tid);
+    auto* _segments    = offload_segment_instances::get();
+    auto* _segment     = (_segments) ? _segments->at(_tid).get() : nullptr;
+
+    _v.raw = get_sampler(_tid)->get_data();
+    if(_segment)
+    {
+        _v.mapped.reserve(_segment->size());
+        _segment->load(_v.mapped);
+    }
+    _v.raw.reserve(_v.raw.size() + _loaded_data.size());
+    for(auto& itr : _loaded_data)
+        _v.raw.emplace_back(std::move(itr));
+    return _v;
+}
+
+raw_data::thread
+get_raw_thread_data(int64_t _tid)
+{
+    auto        _v           = raw_data::thread{};
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    if(!_thread_info || !_thread_info->index_data) return _v;
+
+    _v.index      = _tid;
+    _v.system_tid = _thread_info->index_data->system_value;
+    _v.start      = _thread_info->get_start();
+    _v.stop       = _thread_info->get_stop();
+
+    // the signal and the perf samples are recorded in different calling-context trees
+    enum stack_source : uint8_t
+    {
+        SIGNAL_STACK = 0,
+        PERF_STACK,
+    };
+
+    auto _stacks    = std::map<std::pair<stack_source, calling_context::node_id_t>,
+                             uint32_t>{};
+    auto _get_stack = [&_v, &_stacks](stack_source _src, calling_context::node_id_t _node,
+                                      auto&& _get_addresses) {
+        auto itr = _stacks.find({ _src, _node });
+        if(itr == _stacks.end())
+        {
+            itr = _stacks.emplace(std::make_pair(_src, _node), _v.stacks.size()).first;
+            _v.stacks.emplace_back(_get_addresses());
+        }
+        return itr->second;
+    };
+
+    const auto* _init = (get_sampler(_tid)) ? get_sampler_init(_tid).get() : nullptr;
+    const auto* _tree = calling_context::get(_tid);
+    if(_init && _tree)
+    {
+        auto _samples = load_thread_samples(_tid);
+        auto _last    = _init->get<backtrace_timestamp>()->get_timestamp();
+        auto _add     = [&](const sampler_bundle_t& itr) {
+            const auto* _bt = itr.get<backtrace>();
+            const auto* _ts = itr.get<backtrace_timestamp>();
+            if(!_bt || !_ts || _bt->empty() || _ts->get_tid() != _tid ||
+               !_thread_info->is_valid_time(_ts->get_timestamp()))
+                return;
+
+            auto _node  = _bt->get_data();
+            auto _stack = _get_stack(SIGNAL_STACK, _node,
+                                     [&]() { return _tree->get_addresses(_node); });
+            _v.samples.emplace_back(
+                raw_data::sample{ _last, _ts->get_timestamp(), _stack });
+            _last = _ts->get_timestamp();
+        };
+
+        for(const auto& itr : _samples.mapped)
+            _add(itr);
+        for(const auto& itr : _samples.raw)
+            _add(itr);
+    }
+
+    if(perf_sampler::is_active(_tid))
+    {
+        auto _period = perf_sampler::get_period(_tid);
+        auto _last   = uint64_t{ 0 };
+        for(const auto& itr : perf_sampler::get_records(_tid))
+        {
+            auto _beg = (_last > 0) ? _last : (itr.timestamp - _period);
+            _last     = itr.timestamp;
+            if(!_thread_info->is_valid_time(itr.timestamp)) continue;
+
+            auto _stack = _get_stack(PERF_STACK, itr.node, [&]() {
+                return perf_sampler::get_addresses(_tid, itr.node);
+            });
+            _v.samples.emplace_back(raw_data::sample{ _beg, itr.timestamp, _stack });
+        }
+    }
+
+    std::sort(_v.samples.begin(), _v.samples.end(),
+              [](const auto& _lhs, const auto& _rhs) { return _lhs.begin < _rhs.begin; });
+
+    return _v;
+}
+
+std::string
+write_raw_file(const std::string& _name, raw_data::container& _data)
+{
+    _data.pid     = process::get_id();
+    _data.rank    = dmp::rank();
+    _data.command = config::get_exe_name();
+    _data.objects = raw_data::get_loaded_objects();
+
+    auto _fname = tim::settings::compose_output_filename(_name, ".bin");
+    auto _ofs   = std::ofstream{};
+    if(tim::filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+    {
+        if(get_verbose() >= 0)
+            operation::file_output_message<raw_data::container>{}(
+                _fname, std::string{ "raw_samples" });
+        raw_data::write(_ofs, _data);
+    }
+    else
+    {
+        OMNITRACE_THROW("Error opening raw samples output file: %s", _fname.c_str());
+    }
+
+    return _fname;
+}
+
+std::pair<size_t, size_t>
+write_raw_data(size_t _num_threads)
+{
+    auto   _data        = raw_data::container{};
+    size_t _num_samples = 0;
+    for(size_t i = 0; i < _num_threads; ++i)
+    {
+        auto _thread = get_raw_thread_data(i);
+        if(_thread.samples.empty()) continue;
+        _num_samples += _thread.samples.size();
+        _data.threads.emplace_back(std::move(_thread));
+    }
+
+    auto _fname = write_raw_file("raw-samples", _data);
+
+    OMNITRACE_VERBOSE(1 || get_debug_sampling(),
+                      "Deferred the post-processing of %zu samples from %zu threads. "
+                      "Run omnitrace-post on %s to generate the output\n",
+                      _num_samples, _data.threads.size(), _fname.c_str());
+
+    return { _num_samples, _data.threads.size() };
+}
+
+flush_writer::flush_writer(double _interval)
+: m_interval{ static_cast<int64_t>(_interval * units::sec) }
+{
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    m_thread = std::make_unique<std::thread>([this]() { run(); });
+}
+
+void
+flush_writer::append(int64_t _tid, sampler_buffer_t& _buf)
+{
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    const auto* _tree        = calling_context::get(_tid);
+    if(!_thread_info || !_thread_info->index_data || !_tree) return;
+
+    // the stop of the thread is not known while it is running
+    auto _is_valid = [&_thread_info](uint64_t _ts) {
+        auto _stop = _thread_info->get_stop();
+        return (_ts >= _thread_info->get_start() && (_stop == 0 || _ts <= _stop));
+    };
+
+    auto  _lk    = locking::atomic_lock{ m_pending_mutex };
+    auto& _chunk = m_pending[_tid];
+    auto& _data  = _chunk.data;
+    auto  litr   = m_last.find(_tid);
+    if(litr == m_last.end())
+    {
+        const auto* _init = (get_sampler(_tid)) ? get_sampler_init(_tid).get() : nullptr;
+        auto        _beg  = (_init) ? _init->get<backtrace_timestamp>()->get_timestamp()
+                                    : _thread_info->get_start();
+        litr              = m_last.emplace(_tid, _beg).first;
+    }
+
+    _data.index      = _tid;
+    _data.system_tid = _thread_info->index_data->system_value;
+    _data.start      = _thread_info->get_start();
+    _data.stop       = _thread_info->get_stop();
+
+    // nodes of the calling-context tree are immutable once published so the
+    // call-stacks of the buffered samples are read while the thread is sampled
+    auto _v = sampler_bundle_t{};
+    while(!_buf.is_empty())
+    {
+        _buf.read(&_v);
+        const auto* _bt = _v.get<backtrace>();
+        const auto* _ts = _v.get<backtrace_timestamp>();
+        if(!_bt || !_ts || _bt->empty() || _ts->get_tid() != _tid) continue;
+
+        auto _beg    = litr->second;
+        litr->second = _ts->get_timestamp();
+        if(!_is_valid(_ts->get_timestamp())) continue;
+
+        auto _node = _bt->get_data();
+        auto sitr  = _chunk.stacks.find(_node);
+        if(sitr == _chunk.stacks.end())
+        {
+            sitr = _chunk.stacks.emplace(_node, _data.stacks.size()).first;
+            _data.stacks.emplace_back(_tree->get_addresses(_node));
+        }
+        _data.samples.emplace_back(
+            raw_data::sample{ _beg, _ts->get_timestamp(), sitr->second });
+    }
+}
+
+void
+flush_writer::append(raw_data::thread&& _thread)
+{
+    auto  _lk    = locking::atomic_lock{ m_pending_mutex };
+    auto& _data  = m_pending[_thread.index].data;
+    auto  litr   = m_last.find(_thread.index);
+    auto  _first = _data.stacks.empty() && _data.samples.empty();
+
+    // the first of the remaining samples started at the end of the last flushed sample
+    if(litr != m_last.end())
+    {
+        for(auto& itr : _thread.samples)
+        {
+            if(itr.begin < litr->second && itr.end > litr->second)
+                itr.begin = litr->second;
+        }
+    }
+    else
+    {
+        m_last.emplace(_thread.index, 0);
+    }
+
+    if(_first)
+    {
+        _data = std::move(_thread);
+        return;
+    }
+
+    auto _offset = _data.stacks.size();
+    for(auto& itr : _thread.stacks)
+        _data.stacks.emplace_back(std::move(itr));
+    for(auto itr : _thread.samples)
+    {
+        itr.stack += _offset;
+        _data.samples.emplace_back(itr);
+    }
+    _data.stop = _thread.stop;
+}
+
+size_t
+flush_writer::flush()
+{
+    auto _pending = std::map<int64_t, thread_chunk>{};
+    {
+        auto _lk = locking::atomic_lock{ m_pending_mutex };
+        std::swap(_pending, m_pending);
+    }
+
+    auto   _data        = raw_data::container{};
+    size_t _num_samples = 0;
+    for(auto& itr : _pending)
+    {
+        auto& _thread = itr.second.data;
+        if(_thread.samples.empty()) continue;
+        std::sort(_thread.samples.begin(), _thread.samples.end(),
+                  [](const auto& _lhs, const auto& _rhs) {
+                      return _lhs.begin < _rhs.begin;
+                  });
+        _num_samples += _thread.samples.size();
+        _data.threads.emplace_back(std::move(_thread));
+    }
+
+    if(_data.threads.empty()) return 0;
+
+    auto _name = std::stringstream{};
+    _name << "raw-samples-flush-" << std::setw(4) << std::setfill('0') << m_files++;
+    auto _fname = write_raw_file(_name.str(), _data);
+    m_samples += _num_samples;
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "[sampling] flushed %zu samples from %zu threads to %s\n",
+                      _num_samples, _data.threads.size(), _fname.c_str());
+
+    return _num_samples;
+}
+
+void
+flush_writer::run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.samp.flush");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    while(m_running)
+    {
+        m_cv.wait_for(_lk, m_interval, [this]() { return !m_running; });
+        if(!m_running) break;
+
+        _lk.unlock();
+        try
+        {
+            flush();
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "[sampling] periodic flush failed: %s\n", _e.what());
+        }
+        _lk.lock();
+    }
+}
+
+void
+flush_writer::shutdown()
+{
+    if(!m_thread) return;
+
+    {
+        auto _lk  = std::unique_lock<std::mutex>{ m_mutex };
+        m_running = false;
+    }
+    m_cv.notify_all();
+    m_thread->join();
+    m_thread.reset();
+}
+
+std::vector<timer_sampling_data>
+post_process_timer_data(int64_t _tid, const bundle_t* _init,
+                        const std::vector<bundle_t*>& _data)
+{
+    auto _results = std::vector<timer_sampling_data>{};
+    auto _stacks  = std::unordered_map<calling_context::node_id_t,
+                                       std::vector<backtrace::entry_type>>{};
+
+    const auto* _last = _init;
+    for(const auto& itr : _data)
+    {
+        auto*       _bt_data      = itr->get<backtrace>();
+        auto*       _bt_time      = itr->get<backtrace_timestamp>();
+        auto*       _bt_metrics   = itr->get<backtrace_metrics>();
+        const auto* _last_metrics = _last->get<backtrace_metrics>();
+
+        if(!_bt_data || !_bt_time || _bt_data->empty() || _bt_time->get_tid() != _tid)
+            continue;
+
+        auto _ret     = timer_sampling_data{};
+        _ret.m_tid    = _bt_time->get_tid();
+        _ret.m_beg    = _last->get<backtrace_timestamp>()->get_timestamp();
+        _ret.m_end    = _bt_time->get_timestamp();
+        _ret.m_region = _bt_time->get_region();
+        _ret.m_cpu    = _bt_time->get_cpu();
+
+        // samples with the same calling-context share the filtered call-stack
+        auto sitr = _stacks.find(_bt_data->get_data());
+        if(sitr == _stacks.end())
+            sitr = _stacks
+                       .emplace(_bt_data->get_data(),
+                                backtrace::filter_and_patch(_bt_data->get()))
+                       .first;
+        _ret.m_stack = sitr->second;
+
+        if constexpr(tim::trait::is_available<hw_counters>::value)
+        {
+            auto _hw_counters_enabled = [](const auto* _bt_v) {
+                return (_bt_v != nullptr) &&
+                       (*_bt_v)(type_list<backtrace_metrics::hw_counters>{}) &&
+                       (*_bt_v)(category::thread_hardware_counter{});
+            };
+
+            if(_bt_metrics && _last_metrics && _hw_counters_enabled(_bt_metrics) &&
+               _hw_counters_enabled(_last_metrics))
+            {
+                _ret.m_metrics = (*_bt_metrics) - (*_last_metrics);
+            }
+        }
+
+        _results.emplace_back(std::move(_ret));
+        _last = itr;
+    }
 
     std::sort(_results.begin(), _results.end(),
               [](const auto& _lhs, const auto& _rhs) { return _lhs.m_beg < _rhs.m_beg; });
 
-    return _results;
+    return _results;
+}
+
+using call_stack_map_t =
+    std::unordered_map<calling_context::node_id_t, std::vector<backtrace::entry_type>>;
+
+// resolves the addresses of the call-stacks of all the calling-contexts in a single
+// sweep over the unique addresses and returns the filtered and patched call-stack of
+// each calling-context
+template <typename FuncT>
+call_stack_map_t
+resolve_call_stacks(const std::set<calling_context::node_id_t>& _nodes,
+                    FuncT&&                                     _get_addresses)
+{
+    auto _node_addrs = std::vector<std::vector<uintptr_t>>{};
+    auto _addrs      = std::vector<uintptr_t>{};
+    _node_addrs.reserve(_nodes.size());
+    for(auto itr : _nodes)
+    {
+        const auto& _v = _node_addrs.emplace_back(_get_addresses(itr));
+        _addrs.insert(_addrs.end(), _v.begin(), _v.end());
+    }
+
+    std::sort(_addrs.begin(), _addrs.end());
+    _addrs.erase(std::unique(_addrs.begin(), _addrs.end()), _addrs.end());
+
+    auto _table  = binary::lookup_ipaddr_entries<true>(_addrs);
+    auto _stacks = call_stack_map_t{};
+    auto nitr    = _node_addrs.begin();
+    for(auto itr : _nodes)
+    {
+        auto _entries = std::vector<backtrace::entry_type>{};
+        // addresses are ordered such that the bottom of the call-stack is on top
+        for(auto aitr : *nitr++)
+        {
+            auto _idx = std::lower_bound(_addrs.begin(), _addrs.end(), aitr) -
+                        _addrs.begin();
+            if(_table.at(_idx)) _entries.emplace_back(*_table.at(_idx));
+        }
+        _stacks.emplace(itr, backtrace::filter_and_patch(_entries));
+    }
+
+    return _stacks;
+}
+
+std::vector<timer_sampling_data>
+post_process_perf_data(int64_t _tid)
+{
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+
+    auto _results = std::vector<timer_sampling_data>{};
+    auto _period  = perf_sampler::get_period(_tid);
+    auto _last    = uint64_t{ 0 };
+    auto _records = perf_sampler::get_records(_tid);
+
+    auto _is_valid = [&_thread_info](const auto& itr) {
+        return (_thread_info && _thread_info->is_valid_time(itr.timestamp));
+    };
+
+    // samples with the same calling-context share the filtered call-stack
+    auto _nodes = std::set<calling_context::node_id_t>{};
+    for(const auto& itr : _records)
+        if(_is_valid(itr)) _nodes.emplace(itr.node);
+
+    auto _stacks = resolve_call_stacks(_nodes, [_tid](auto _node) {
+        return perf_sampler::get_addresses(_tid, _node);
+    });
+
+    for(const auto& itr : _records)
+    {
+        // the first sample covers a single period of CPU-time
+        auto _beg = (_last > 0) ? _last : (itr.timestamp - _period);
+        _last     = itr.timestamp;
+
+        if(!_is_valid(itr)) continue;
+
+        auto sitr = _stacks.find(itr.node);
+        if(sitr == _stacks.end() || sitr->second.empty()) continue;
+
+        auto _ret    = timer_sampling_data{};
+        _ret.m_tid   = _tid;
+        _ret.m_beg   = _beg;
+        _ret.m_end   = itr.timestamp;
+        _ret.m_cpu   = static_cast<int32_t>(itr.cpu);
+        _ret.m_stack = sitr->second;
+        _results.emplace_back(std::move(_ret));
+    }
+
+    return _results;
+}
+
+std::vector<off_cpu_sampling_data>
+post_process_off_cpu_data(int64_t _tid)
+{
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+
+    auto _results = std::vector<off_cpu_sampling_data>{};
+
+    if(!_thread_info) return _results;
+
+    auto _records  = perf_sampler::get_off_cpu_records(_tid);
+    auto _is_valid = [&_thread_info](const auto& itr) {
+        return _thread_info->is_valid_lifetime({ itr.begin, itr.end });
+    };
+
+    auto _nodes = std::set<calling_context::node_id_t>{};
+    for(const auto& itr : _records)
+        if(_is_valid(itr)) _nodes.emplace(itr.node);
+
+    auto _stacks = resolve_call_stacks(_nodes, [_tid](auto _node) {
+        return (_node != 0) ? perf_sampler::get_off_cpu_addresses(_tid, _node)
+                            : std::vector<uintptr_t>{};
+    });
+
+    for(const auto& itr : _records)
+    {
+        if(!_is_valid(itr)) continue;
+
+        auto _ret        = off_cpu_sampling_data{};
+        _ret.m_tid       = _tid;
+        _ret.m_beg       = itr.begin;
+        _ret.m_end       = itr.end;
+        _ret.m_preempted = itr.preempted;
+        _ret.m_stack     = _stacks.at(itr.node);
+        _results.emplace_back(std::move(_ret));
+    }
+
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "Off-CPU data for thread %li has %zu intervals...\n", _tid,
+                      _results.size());
+
+    return _results;
+}
+
+// a track per thread with a slice for every interval in which the thread was not
+// running. The call-stack where the thread stopped is nested below the slice
+void
+post_process_perfetto(int64_t _tid, const std::vector<off_cpu_sampling_data>& _data)
+{
+    const auto& _thread_info = thread_info::get(_tid, SequentTID);
+    if(!_thread_info) return;
+
+    auto _track = tracing::get_perfetto_track(
+        category::off_cpu{},
+        [](auto _seq_id, auto _sys_id) {
+            return TIMEMORY_JOIN(" ", "Thread", _seq_id, "Off-CPU", "(S)", _sys_id);
+        },
+        _thread_info->index_data->sequent_value, _thread_info->index_data->system_value);
+
+    for(const auto& itr : _data)
+    {
+        const auto* _name = (itr.m_preempted) ? "preempted" : "blocked";
+        tracing::push_perfetto_track(category::off_cpu{}, _name, _track, itr.m_beg,
+                                     [&](::perfetto::EventContext ctx) {
+                                         if(config::get_snapshot().perfetto_annotations)
+                                         {
+                                             tracing::add_perfetto_annotation(
+                                                 ctx, "end_ns", itr.m_end);
+                                         }
+                                     });
+
+        for(const auto& iitr : itr.m_stack)
+        {
+            const auto& _frame = get_sampling_frame(category::off_cpu{}, iitr);
+            tracing::push_perfetto_track(
+                category::off_cpu{}, _frame.name, _track, itr.m_beg,
+                [&](::perfetto::EventContext ctx) {
+                    if(config::get_snapshot().perfetto_annotations)
+                    {
+                        tracing::add_perfetto_source_location(ctx, _frame.source);
+                        tracing::add_perfetto_annotation(ctx, "pc", _frame.pc);
+                    }
+                });
+            tracing::pop_perfetto_track(category::off_cpu{}, _frame.name, _track,
+                                        itr.m_end);
+        }
+
+        tracing::pop_perfetto_track(category::off_cpu{}, _name, _track, itr.m_end);
+    }
+}
+
+// the off-CPU time of each call-stack below a "[blocked]" or "[preempted]" root
+void
+build_sampling_cct(const std::vector<off_cpu_sampling_data>& _data,
+                   thread_sampling_cct&                      _cct)
+{
+    auto& _off_cpu = _cct.off_cpu;
+    for(const auto& itr : _data)
+    {
+        auto _value = static_cast<double>(itr.m_end - itr.m_beg);
+        auto _idx   = _off_cpu.child(0, (itr.m_preempted) ? "[preempted]" : "[blocked]");
+        _off_cpu.nodes.at(_idx).data += _value;
+        for(const auto& iitr : itr.m_stack)
+        {
+            const auto& _frame = get_sampling_frame(category::off_cpu{}, iitr);
+            _idx               = _off_cpu.child(_idx, _frame.name);
+            _off_cpu.nodes.at(_idx).data += _value;
+        }
+    }
+}
+
+void
+start_system_wide()
+{
+    static std::once_flag _once{};
+    std::call_once(_once, []() {
+        auto _cpus_val = get_sampling_cpus();
+        for(auto& itr : _cpus_val)
+            itr = tolower(itr);
+        if(_cpus_val == "none" || _cpus_val == "off") return;
+
+        auto _cpus = std::set<int64_t>{};
+        if(_cpus_val.empty() || _cpus_val == "all" || _cpus_val == "on")
+        {
+            auto _ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+            for(long i = 0; i < _ncpu; ++i)
+                _cpus.emplace(i);
+        }
+        else
+        {
+            _cpus = utility::parse_numeric_range<>(_cpus_val, "CPUs", 1L);
+        }
+
+        auto _err = perf_sampler::start_cpus(_cpus, get_sampling_system_wide_freq());
+        if(_err)
+        {
+            OMNITRACE_WARNING(0, "system-wide sampling failed to activate: %s\n",
+                              _err->c_str());
+        }
+        else
+        {
+            OMNITRACE_VERBOSE(1, "System-wide sampling of %zu CPUs at %.1f Hz...\n",
+                              perf_sampler::get_cpus().size(),
+                              get_sampling_system_wide_freq());
+        }
+    });
+}
+
+// a track per CPU with the process (and the thread in the annotations) sampled on the
+// CPU. The call-stacks of this process are resolved, the other processes only report
+// the address of the innermost frame since their address space is unknown
+void
+post_process_cpu_data()
+{
+    auto _period = perf_sampler::get_cpu_period();
+    auto _self   = static_cast<uint32_t>(process::get_id());
+
+    for(auto _cpu : perf_sampler::get_cpus())
+    {
+        auto _data = perf_sampler::get_cpu_records(_cpu);
+        if(_data.empty()) continue;
+
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Post-processing %zu system-wide samples of CPU %li...\n",
+                          _data.size(), _cpu);
+
+        auto _track = tracing::get_perfetto_track(
+            category::cpu_sampling{},
+            [](auto _v) { return JOIN(" ", "CPU", _v, "Samples", "(S)"); }, _cpu);
+
+        // only the call-stacks of this process are resolved
+        auto _nodes = std::set<calling_context::node_id_t>{};
+        for(const auto& itr : _data)
+            if(itr.pid == _self) _nodes.emplace(itr.node);
+
+        auto _stacks = resolve_call_stacks(_nodes, [_cpu](auto _node) {
+            return perf_sampler::get_cpu_addresses(_cpu, _node);
+        });
+        auto _counts = std::map<std::string_view, size_t>{};
+        auto _last   = uint64_t{ 0 };
+        for(const auto& itr : _data)
+        {
+            // back-to-back samples are contiguous, otherwise the sample spans a period
+            auto _end = itr.timestamp;
+            auto _beg =
+                (_last > 0 && _end - _last <= 2 * _period) ? _last : (_end - _period);
+            _last = _end;
+
+            const auto* _name = string_arena::instance().intern(
+                JOIN("", perf_sampler::get_command(itr.pid), " [", itr.pid, "]"));
+            ++_counts[_name];
+
+            auto _addrs = perf_sampler::get_cpu_addresses(_cpu, itr.node);
+            tracing::push_perfetto_track(
+                category::cpu_sampling{}, _name, _track, _beg,
+                [&](::perfetto::EventContext ctx) {
+                    if(config::get_snapshot().perfetto_annotations)
+                    {
+                        tracing::add_perfetto_annotation(ctx, "pid", itr.pid);
+                        tracing::add_perfetto_annotation(ctx, "tid", itr.tid);
+                        if(!_addrs.empty())
+                            tracing::add_perfetto_annotation(ctx, "ip",
+                                                             as_hex(_addrs.back()));
+                    }
+                });
+
+            if(auto sitr = _stacks.find(itr.node);
+               itr.pid == _self && sitr != _stacks.end())
+            {
+                for(const auto& iitr : sitr->second)
+                {
+                    const auto& _frame =
+                        get_sampling_frame(category::cpu_sampling{}, iitr);
+                    tracing::push_perfetto_track(
+                        category::cpu_sampling{}, _frame.name, _track, _beg,
+                        [&](::perfetto::EventContext ctx) {
+                            if(config::get_snapshot().perfetto_annotations)
+                            {
+                                tracing::add_perfetto_source_location(ctx,
+                                                                      _frame.source);
+                                tracing::add_perfetto_annotation(ctx, "pc", _frame.pc);
+                            }
+                        });
+                    tracing::pop_perfetto_track(category::cpu_sampling{}, _frame.name,
+                                                _track, _end);
+                }
+            }
+
+            tracing::pop_perfetto_track(category::cpu_sampling{}, _name, _track, _end);
+        }
+
+        if(get_verbose() >= 1)
+        {
+            auto _sorted = std::vector<std::pair<std::string_view, size_t>>{
+                _counts.begin(), _counts.end()
+            };
+            std::sort(_sorted.begin(), _sorted.end(),
+                      [](const auto& _lhs, const auto& _rhs) {
+                          return _lhs.second > _rhs.second;
+                      });
+
+            auto _ss = std::stringstream{};
+            for(size_t i = 0; i < std::min<size_t>(_sorted.size(), 5); ++i)
+                _ss << ", " << _sorted.at(i).first << ": "
+                    << (100.0 * _sorted.at(i).second) / _data.size() << "%";
+            OMNITRACE_VERBOSE(1, "CPU %li samples%s\n", _cpu, _ss.str().c_str());
+        }
+    }
 }
 
 std::vector<overflow_sampling_data>
@@ -1075,32 +3133,39 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
 {
     auto _results = std::vector<overflow_sampling_data>{};
 
-    uint64_t _last_call_ts   = 0;
-    uint64_t _perf_ts_offset = 0;
-    for(const auto& itr : _data)
+    // each event has its own period so the interval of a sample is measured from the
+    // previous sample of the same event
+    for(size_t _event = 0; _event < get_overflow_events().size(); ++_event)
     {
-        auto* _bt_call = itr->get<callchain>();
-        auto* _bt_time = itr->get<backtrace_timestamp>();
+        uint64_t _last_call_ts   = 0;
+        uint64_t _perf_ts_offset = 0;
+        for(const auto& itr : _data)
+        {
+            auto* _bt_call = itr->get<callchain>();
+            auto* _bt_time = itr->get<backtrace_timestamp>();
 
-        if(!_bt_call || !_bt_time || _bt_call->empty() || _bt_time->get_tid() != _tid)
-            continue;
+            if(!_bt_call || !_bt_time || _bt_call->empty() ||
+               _bt_time->get_tid() != _tid)
+                continue;
 
-        for(const auto& pitr : callchain::filter_and_patch(_bt_call->get()))
-        {
-            if(_last_call_ts == 0)
+            for(const auto& pitr : callchain::filter_and_patch(_bt_call->get(_event)))
             {
-                _last_call_ts   = pitr.first;
-                _perf_ts_offset = (_bt_time->get_timestamp() - pitr.first);
-                continue;
-            }
+                if(_last_call_ts == 0)
+                {
+                    _last_call_ts   = pitr.first;
+                    _perf_ts_offset = (_bt_time->get_timestamp() - pitr.first);
+                    continue;
+                }
 
-            auto _ret     = overflow_sampling_data{};
-            _ret.m_tid    = _bt_time->get_tid();
-            _ret.m_beg    = _last_call_ts + _perf_ts_offset;
-            _ret.m_end    = pitr.first + _perf_ts_offset;
-            _ret.m_stack  = pitr.second;
-            _last_call_ts = pitr.first;
-            _results.emplace_back(std::move(_ret));
+                auto _ret     = overflow_sampling_data{};
+                _ret.m_tid    = _bt_time->get_tid();
+                _ret.m_event  = _event;
+                _ret.m_beg    = _last_call_ts + _perf_ts_offset;
+                _ret.m_end    = pitr.first + _perf_ts_offset;
+                _ret.m_stack  = pitr.second;
+                _last_call_ts = pitr.first;
+                _results.emplace_back(std::move(_ret));
+            }
         }
     }
 
@@ -1110,6 +3175,115 @@ post_process_overflow_data(int64_t                       _tid, const bundle_t*,
     return _results;
 }
 
+// consecutive timer samples are contiguous so the frames which a sample has in common
+// with the previous sample (starting from the outermost frame) extend the open slices
+// and only the frames which differ are closed and opened
+void
+post_process_perfetto_merged(::perfetto::Track _track, const thread_info& _thread_info,
+                             const std::vector<timer_sampling_data>& _timer_data)
+{
+    struct merged_slice
+    {
+        const sampling_frame* frame   = nullptr;
+        size_t                line    = 0;  // one plus the index of the inlined line
+        uint64_t              beg     = 0;
+        uint64_t              end     = 0;
+        uint64_t              samples = 0;
+    };
+
+    const auto _include_inlines = config::get_snapshot().sampling_include_inlines;
+
+    auto     _slices   = std::vector<merged_slice>{};  // in the order they were opened
+    auto     _open     = std::vector<size_t>{};        // indexes of the open slices
+    auto     _keys     = std::vector<std::pair<const sampling_frame*, size_t>>{};
+    uint64_t _last_end = 0;
+
+    auto _close = [&_slices, &_open](size_t _depth, uint64_t _ts) {
+        while(_open.size() > _depth)
+        {
+            _slices.at(_open.back()).end = _ts;
+            _open.pop_back();
+        }
+    };
+
+    for(const auto& itr : _timer_data)
+    {
+        if(!_thread_info.is_valid_lifetime({ itr.m_beg, itr.m_end })) continue;
+
+        // a dropped or skipped sample leaves a gap which closes every frame
+        if(itr.m_beg != _last_end) _close(0, _last_end);
+
+        _keys.clear();
+        for(const auto& iitr : itr.m_stack)
+        {
+            const auto& _frame = get_sampling_frame(category::timer_sampling{}, iitr);
+            if(_include_inlines && !_frame.lines.empty())
+            {
+                for(size_t i = 0; i < _frame.lines.size(); ++i)
+                    _keys.emplace_back(&_frame, i + 1);
+            }
+            else
+            {
+                _keys.emplace_back(&_frame, 0);
+            }
+        }
+
+        size_t _depth = 0;
+        for(; _depth < std::min(_open.size(), _keys.size()); ++_depth)
+        {
+            const auto& _slice = _slices.at(_open.at(_depth));
+            if(_keys.at(_depth) != std::make_pair(_slice.frame, _slice.line)) break;
+            ++_slices.at(_open.at(_depth)).samples;
+        }
+
+        _close(_depth, itr.m_beg);
+        for(size_t i = _depth; i < _keys.size(); ++i)
+        {
+            _open.emplace_back(_slices.size());
+            _slices.emplace_back(
+                merged_slice{ _keys.at(i).first, _keys.at(i).second, itr.m_beg, 0, 1 });
+        }
+        _last_end = itr.m_end;
+    }
+    _close(0, _last_end);
+
+    // the begin and end of each slice are emitted together (like the unmerged slices)
+    // and the slices are in the order they were opened so the nesting is preserved
+    // when the events are sorted by their timestamp
+    for(const auto& itr : _slices)
+    {
+        const auto& _frame = *itr.frame;
+        const auto* _line  = (itr.line > 0) ? &_frame.lines.at(itr.line - 1) : nullptr;
+        const auto* _name  = (_line) ? _line->name : _frame.name;
+
+        tracing::push_perfetto_track(
+            category::timer_sampling{}, _name, _track, itr.beg,
+            [&](::perfetto::EventContext ctx) {
+                if(config::get_snapshot().perfetto_annotations)
+                {
+                    tracing::add_perfetto_annotation(ctx, "end_ns", itr.end);
+                    tracing::add_perfetto_annotation(ctx, "samples", itr.samples);
+                    if(_line)
+                    {
+                        tracing::add_perfetto_source_location(ctx, _line->source);
+                        tracing::add_perfetto_annotation(ctx, "inlined", (itr.line > 1));
+                    }
+                    else
+                    {
+                        tracing::add_perfetto_source_location(ctx, _frame.source);
+                        tracing::add_perfetto_annotation(ctx, "pc", _frame.pc);
+                        tracing::add_perfetto_annotation(ctx, "line_address",
+                                                         _frame.line_address);
+                        for(const auto& litr : _frame.lines)
+                            tracing::add_perfetto_annotation(ctx, litr.label,
+                                                             litr.summary);
+                    }
+                }
+            });
+        tracing::pop_perfetto_track(category::timer_sampling{}, _name, _track, itr.end);
+    }
+}
+
 void
 post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
                       const std::vector<overflow_sampling_data>& _overflow_data)
@@ -1131,6 +3305,47 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         backtrace_metrics::fini_perfetto(_tid, _valid_metrics);
     }
 
+    // when the rate is adapted to the overhead budget, each sample spans the time
+    // since the previously recorded sample instead of the timer period
+    if(config::get_sampling_overhead_budget() > 0.0 && !_timer_data.empty())
+    {
+        using rate_track = perfetto_counter_track<sampling_rate_track>;
+
+        if(!rate_track::exists(_tid))
+            rate_track::emplace(
+                _tid, JOIN(' ', "Thread Sampling Rate", JOIN("", '[', _tid, ']'), "(S)"),
+                "Hz");
+
+        for(const auto& itr : _timer_data)
+        {
+            if(itr.m_end <= itr.m_beg) continue;
+            TRACE_COUNTER(trait::name<category::timer_sampling>::value,
+                          rate_track::at(_tid, 0), itr.m_beg,
+                          static_cast<double>(units::sec) / (itr.m_end - itr.m_beg));
+        }
+        TRACE_COUNTER(trait::name<category::timer_sampling>::value,
+                      rate_track::at(_tid, 0), _timer_data.back().m_end, 0.0);
+    }
+
+    // the counter only changes when the thread is sampled on a different CPU
+    if(config::get_sampling_cpu_residency() && !_timer_data.empty())
+    {
+        using cpu_track = perfetto_counter_track<cpu_residency_track>;
+
+        if(!cpu_track::exists(_tid))
+            cpu_track::emplace(
+                _tid, JOIN(' ', "Thread CPU", JOIN("", '[', _tid, ']'), "(S)"));
+
+        int32_t _last_cpu = -1;
+        for(const auto& itr : _timer_data)
+        {
+            if(itr.m_cpu < 0 || itr.m_cpu == _last_cpu) continue;
+            TRACE_COUNTER(trait::name<category::timer_sampling>::value,
+                          cpu_track::at(_tid, 0), itr.m_end, itr.m_cpu);
+            _last_cpu = itr.m_cpu;
+        }
+    }
+
     OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                       "[%li] Post-processing backtraces for perfetto...\n", _tid);
 
@@ -1139,43 +3354,56 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
 
     if(!_thread_info) return;
 
-    auto _overflow_event =
-        get_setting_value<std::string>("OMNITRACE_SAMPLING_OVERFLOW_EVENT").value_or("");
-
-    if(!_overflow_event.empty() && !_overflow_data.empty())
+    // one track per overflow event. With a single event, the track keeps the name it
+    // had before multiple events could be sampled
+    const auto& _events = get_overflow_events();
+    for(size_t _event = 0; _event < _events.size(); ++_event)
     {
-        auto _beg_ns = std::max(_overflow_data.front().m_beg, _thread_info->get_start());
-        auto _end_ns = std::min(_overflow_data.back().m_end, _thread_info->get_stop());
-
-        const auto _overflow_prefix = std::string_view{ "PERF_COUNT_" };
-        const auto _overflow_pos    = _overflow_event.find(_overflow_prefix);
-        if(_overflow_pos != std::string::npos)
-            _overflow_event =
-                _overflow_event.substr(_overflow_pos + _overflow_prefix.length());
-
-        const auto* _main_name =
-            static_strings.emplace(join(" ", _overflow_event, "samples [omnitrace]"))
-                .first->c_str();
+        auto _beg_ns = std::numeric_limits<uint64_t>::max();
+        auto _end_ns = uint64_t{ 0 };
+        for(const auto& itr : _overflow_data)
+        {
+            if(itr.m_event != _event) continue;
+            _beg_ns = std::min(_beg_ns, itr.m_beg);
+            _end_ns = std::max(_end_ns, itr.m_end);
+        }
 
-        auto _track = tracing::get_perfetto_track(
-            category::overflow_sampling{},
-            [](auto _seq_id, auto _sys_id) {
-                return TIMEMORY_JOIN(" ", "Thread", _seq_id, "Overflow", "(S)", _sys_id);
-            },
-            _thread_info->index_data->sequent_value,
-            _thread_info->index_data->system_value);
+        if(_end_ns == 0) continue;
+
+        _beg_ns = std::max(_beg_ns, _thread_info->get_start());
+        _end_ns = std::min(_end_ns, _thread_info->get_stop());
+
+        const auto& _overflow_event = _events.at(_event).label;
+
+        const auto* _main_name = string_arena::instance().intern(
+            join(" ", _overflow_event, "samples [omnitrace]"));
+
+        auto _track =
+            (_events.size() == 1)
+                ? tracing::get_perfetto_track(
+                      category::overflow_sampling{},
+                      [](auto _seq_id, auto _sys_id) {
+                          return TIMEMORY_JOIN(" ", "Thread", _seq_id, "Overflow", "(S)",
+                                               _sys_id);
+                      },
+                      _thread_info->index_data->sequent_value,
+                      _thread_info->index_data->system_value)
+                : tracing::get_perfetto_track(
+                      category::overflow_sampling{},
+                      [&_overflow_event](auto _seq_id, auto _sys_id, size_t) {
+                          return TIMEMORY_JOIN(" ", "Thread", _seq_id, "Overflow",
+                                               _overflow_event, "(S)", _sys_id);
+                      },
+                      _thread_info->index_data->sequent_value,
+                      _thread_info->index_data->system_value, _event);
 
         tracing::push_perfetto_track(category::overflow_sampling{}, _main_name, _track,
-                                     _beg_ns, [&](::perfetto::EventContext ctx) {
-                                         if(config::get_perfetto_annotations())
-                                         {
-                                             tracing::add_perfetto_annotation(
-                                                 ctx, "begin_ns", _beg_ns);
-                                         }
-                                     });
+                                     _beg_ns);
 
         for(const auto& itr : _overflow_data)
         {
+            if(itr.m_event != _event) continue;
+
             auto _beg = itr.m_beg;
             auto _end = itr.m_end;
 
@@ -1183,32 +3411,21 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
 
             for(const auto& iitr : itr.m_stack)
             {
-                const auto* _name =
-                    static_strings.emplace(demangle(iitr.name)).first->c_str();
+                const auto& _frame =
+                    get_sampling_frame(category::overflow_sampling{}, iitr);
+                const auto* _name = _frame.name;
                 tracing::push_perfetto_track(
                     category::overflow_sampling{}, _name, _track, _beg,
                     [&](::perfetto::EventContext ctx) {
-                        if(config::get_perfetto_annotations())
+                        if(config::get_snapshot().perfetto_annotations)
                         {
-                            tracing::add_perfetto_annotation(ctx, "file", iitr.location);
-                            tracing::add_perfetto_annotation(ctx, "pc",
-                                                             as_hex(iitr.address));
+                            tracing::add_perfetto_source_location(ctx, _frame.source);
+                            tracing::add_perfetto_annotation(ctx, "pc", _frame.pc);
                             tracing::add_perfetto_annotation(ctx, "line_address",
-                                                             as_hex(iitr.line_address));
-                            if(iitr.lineinfo)
-                            {
-                                auto _lines = iitr.lineinfo.lines;
-                                std::reverse(_lines.begin(), _lines.end());
-                                size_t _n = 0;
-                                for(const auto& litr : _lines)
-                                {
-                                    auto _label = JOIN('-', "lineinfo", _n++);
-                                    tracing::add_perfetto_annotation(
-                                        ctx, _label.c_str(),
-                                        JOIN('@', demangle(litr.name),
-                                             JOIN(':', litr.location, litr.line)));
-                                }
-                            }
+                                                             _frame.line_address);
+                            for(const auto& litr : _frame.lines)
+                                tracing::add_perfetto_annotation(ctx, litr.label,
+                                                                 litr.summary);
                         }
                     });
                 tracing::pop_perfetto_track(category::overflow_sampling{}, _name, _track,
@@ -1217,13 +3434,7 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         }
 
         tracing::pop_perfetto_track(category::overflow_sampling{}, _main_name, _track,
-                                    _end_ns, [&](::perfetto::EventContext ctx) {
-                                        if(config::get_perfetto_annotations())
-                                        {
-                                            tracing::add_perfetto_annotation(
-                                                ctx, "end_ns", _end_ns);
-                                        }
-                                    });
+                                    _end_ns);
     }
 
     if(!_timer_data.empty())
@@ -1240,25 +3451,26 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
             _thread_info->index_data->system_value);
 
         tracing::push_perfetto_track(category::timer_sampling{}, "samples [omnitrace]",
-                                     _track, _beg_ns, [&](::perfetto::EventContext ctx) {
-                                         if(config::get_perfetto_annotations())
-                                         {
-                                             tracing::add_perfetto_annotation(
-                                                 ctx, "begin_ns", _beg_ns);
-                                         }
-                                     });
+                                     _track, _beg_ns);
 
-        auto _labels = backtrace_metrics::get_hw_counter_labels(_tid);
+        auto _merge = config::get_sampling_merge_stacks();
+        if(_merge) post_process_perfetto_merged(_track, *_thread_info, _timer_data);
+
+        auto _labels      = backtrace_metrics::get_hw_counter_labels(_tid);
+        auto _multiplexed = backtrace_metrics::get_hw_counter_multiplexed(_tid);
+        auto _hw_scaling  = backtrace_metrics::get_hw_counter_scaling(_tid);
         for(const auto& itr : _timer_data)
         {
             size_t   _ncount = 0;
             uint64_t _beg    = itr.m_beg;
             uint64_t _end    = itr.m_end;
-            if(!_thread_info->is_valid_lifetime({ _beg, _end })) continue;
+            // the merged slices of the samples were emitted above
+            if(_merge || !_thread_info->is_valid_lifetime({ _beg, _end })) continue;
 
             for(const auto& iitr : itr.m_stack)
             {
-                auto _ncur = _ncount++;
+                const auto& _frame = get_sampling_frame(category::timer_sampling{}, iitr);
+                auto        _ncur  = _ncount++;
                 // the begin/end + HW counters will be same for entire call-stack so only
                 // annotate the top and the bottom functons to keep the data consumption
                 // low
@@ -1274,43 +3486,45 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
                                             bool                      _is_last) {
                     if(_include_common && _is_last)
                     {
-                        tracing::add_perfetto_annotation(ctx, "begin_ns", _beg);
+                        // the begin is the timestamp of the event
                         tracing::add_perfetto_annotation(ctx, "end_ns", _end);
                     }
 
                     if(_include_hw)
                     {
-                        // current values when read
-                        auto _hw_cnt_vals = itr.m_metrics.get_hw_counters();
+                        // current values when read, scaled when multiplexed
+                        auto _hw_cnt_vals = itr.m_metrics.get_hw_counters(_hw_scaling);
                         for(size_t i = 0; i < _labels.size(); ++i)
+                        {
                             tracing::add_perfetto_annotation(ctx, _labels.at(i),
                                                              _hw_cnt_vals.at(i));
+                            if(_multiplexed)
+                                tracing::add_perfetto_annotation(
+                                    ctx, JOIN(' ', _labels.at(i), "scaling"),
+                                    _hw_scaling.at(i));
+                        }
                     }
                 };
 
-                if(get_sampling_include_inlines() && iitr.lineinfo)
+                if(config::get_snapshot().sampling_include_inlines &&
+                   !_frame.lines.empty())
                 {
-                    auto _lines = iitr.lineinfo.lines;
-                    std::reverse(_lines.begin(), _lines.end());
-                    size_t _n = 0;
-                    for(const auto& litr : _lines)
+                    const auto& _lines = _frame.lines;
+                    for(size_t _n = 0; _n < _lines.size(); ++_n)
                     {
-                        const auto* _name =
-                            static_strings.emplace(demangle(litr.name)).first->c_str();
-                        auto _info = JOIN(':', litr.location, litr.line);
+                        const auto& litr  = _lines.at(_n);
+                        const auto* _name = litr.name;
                         tracing::push_perfetto_track(
                             category::timer_sampling{}, _name, _track, _beg,
                             [&](::perfetto::EventContext ctx) {
-                                if(config::get_perfetto_annotations())
+                                if(config::get_snapshot().perfetto_annotations)
                                 {
                                     _common_annotate(ctx, (_n == 0 && _ncur == 0) ||
                                                               (_n + 1 == _lines.size()));
-                                    tracing::add_perfetto_annotation(ctx, "file",
-                                                                     iitr.location);
-                                    tracing::add_perfetto_annotation(ctx, "lineinfo",
-                                                                     _info);
+                                    tracing::add_perfetto_source_location(ctx,
+                                                                          litr.source);
                                     tracing::add_perfetto_annotation(ctx, "inlined",
-                                                                     (_n++ > 0));
+                                                                     (_n > 0));
                                 }
                             });
                         tracing::pop_perfetto_track(category::timer_sampling{}, _name,
@@ -1319,33 +3533,21 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
                 }
                 else
                 {
-                    const auto* _name = static_strings.emplace(iitr.name).first->c_str();
+                    const auto* _name = _frame.name;
                     tracing::push_perfetto_track(
                         category::timer_sampling{}, _name, _track, _beg,
                         [&](::perfetto::EventContext ctx) {
-                            if(config::get_perfetto_annotations())
+                            if(config::get_snapshot().perfetto_annotations)
                             {
                                 _common_annotate(ctx, true);
-                                tracing::add_perfetto_annotation(ctx, "file",
-                                                                 iitr.location);
-                                tracing::add_perfetto_annotation(ctx, "pc",
-                                                                 as_hex(iitr.address));
-                                tracing::add_perfetto_annotation(
-                                    ctx, "line_address", as_hex(iitr.line_address));
-                                if(iitr.lineinfo)
-                                {
-                                    auto _lines = iitr.lineinfo.lines;
-                                    std::reverse(_lines.begin(), _lines.end());
-                                    size_t _n = 0;
-                                    for(const auto& litr : _lines)
-                                    {
-                                        auto _label = JOIN('-', "lineinfo", _n++);
-                                        tracing::add_perfetto_annotation(
-                                            ctx, _label.c_str(),
-                                            JOIN('@', demangle(litr.name),
-                                                 JOIN(':', litr.location, litr.line)));
-                                    }
-                                }
+                                tracing::add_perfetto_source_location(ctx,
+                                                                      _frame.source);
+                                tracing::add_perfetto_annotation(ctx, "pc", _frame.pc);
+                                tracing::add_perfetto_annotation(ctx, "line_address",
+                                                                 _frame.line_address);
+                                for(const auto& litr : _frame.lines)
+                                    tracing::add_perfetto_annotation(ctx, litr.label,
+                                                                     litr.summary);
                             }
                         });
 
@@ -1356,22 +3558,15 @@ post_process_perfetto(int64_t _tid, const std::vector<timer_sampling_data>& _tim
         }
 
         tracing::pop_perfetto_track(category::timer_sampling{}, "samples [omnitrace]",
-                                    _track, _end_ns, [&](::perfetto::EventContext ctx) {
-                                        if(config::get_perfetto_annotations())
-                                        {
-                                            tracing::add_perfetto_annotation(
-                                                ctx, "end_ns", _end_ns);
-                                        }
-                                    });
+                                    _track, _end_ns);
     }
 }
 
 void
-post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
-                      const std::vector<overflow_sampling_data>& _overflow_data)
+build_sampling_cct(int64_t _tid, const std::vector<timer_sampling_data>& _timer_data,
+                   const std::vector<overflow_sampling_data>& _overflow_data,
+                   thread_sampling_cct&                       _cct)
 {
-    OMNITRACE_VERBOSE(3 || get_debug_sampling(),
-                      "[%li] Post-processing data for timemory...\n", _tid);
 
     // compute the total number of entries
     int64_t _sum = 0;
@@ -1380,159 +3575,508 @@ post_process_timemory(int64_t _tid, const std::vector<timer_sampling_data>& _tim
     for(const auto& itr : _timer_data)
         _sum += itr.m_stack.size();
 
+    // with multiple overflow events, the call-stacks of each event are nested under a
+    // region named after the event and the percentages are relative to the entries of
+    // that event so that each event has its own hot-spot table
+    const auto& _events       = get_overflow_events();
+    auto        _event_names  = std::vector<const char*>{};
+    auto        _event_sums   = std::vector<int64_t>(_events.size(), 0);
+    const bool  _split_events = (_events.size() > 1);
+    for(const auto& itr : _events)
+        _event_names.emplace_back(
+            string_arena::instance().intern(JOIN("", "[", itr.label, "]")));
     for(const auto& itr : _overflow_data)
+        _event_sums.at(itr.m_event) += itr.m_stack.size() + 1;
+
+    // the HW counters of each sample are scaled by the ratio of the time enabled to the
+    // time running of their group over the lifetime of the thread
+    auto _hw_scaling = backtrace_metrics::get_hw_counter_scaling(_tid);
+    if(backtrace_metrics::get_hw_counter_multiplexed(_tid))
     {
-        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock>;
+        auto _labels = backtrace_metrics::get_hw_counter_labels(_tid);
+        for(size_t i = 0; i < _labels.size(); ++i)
+            OMNITRACE_VERBOSE(1, "[%li] %s was multiplexed (scaling factor: %.3f)\n",
+                              _tid, _labels.at(i).c_str(), _hw_scaling.at(i));
+    }
+
+    // aggregate the samples into a calling-context tree per sampling type
+    auto& _overflow_cct = _cct.overflow;
+    for(const auto& itr : _overflow_data)
+    {
+        auto _total = (_split_events) ? _event_sums.at(itr.m_event) : _sum;
+        auto _wall  = static_cast<double>(itr.m_end - itr.m_beg);
+        auto _pct   = (1.0 / _total) * 100.0;
+        auto _idx   = size_t{ 0 };
+
+        auto _add = [&](const char* _name) {
+            _idx        = _overflow_cct.child(_idx, _name);
+            auto& _node = _overflow_cct.nodes.at(_idx).data;
+            _node.wall += _wall;
+            _node.percent += _pct;
+        };
+
+        if(_split_events) _add(_event_names.at(itr.m_event));
+        for(const auto& iitr : itr.m_stack)
+            _add(get_sampling_frame(category::overflow_sampling{}, iitr).name);
+    }
+
+    // with OMNITRACE_SAMPLING_REGION_CONTEXT, the call-stacks of the samples taken
+    // within a region are nested under a pseudo-frame named after the innermost region
+    auto _region_context = config::get_sampling_region_context();
+    auto _region_names   = std::unordered_map<tim::hash_value_t, const char*>{};
+    auto _get_region     = [&_region_names](tim::hash_value_t _hash) {
+        auto ritr = _region_names.find(_hash);
+        if(ritr == _region_names.end())
+        {
+            auto _name = tim::get_hash_identifier_fast(_hash);
+            ritr       = _region_names
+                       .emplace(_hash, string_arena::instance().intern(
+                                           JOIN("", "[", _name, "]")))
+                       .first;
+        }
+        return ritr->second;
+    };
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+    auto& _timer_cct = _cct.timer;
+    for(const auto& itr : _timer_data)
+    {
+        const auto& _metrics = itr.m_metrics;
+
+        auto _wall    = static_cast<double>(itr.m_end - itr.m_beg);
+        auto _pct     = (1.0 / _sum) * 100.0;
+        auto _has_cpu = (_metrics && _metrics(category::thread_cpu_time{}));
+        auto _has_hw  = (_metrics &&
+                        _metrics(type_list<backtrace_metrics::hw_counters>{}) &&
+                        _metrics(category::thread_hardware_counter{}));
+        auto _hw      = typename timer_cct_data::hw_counter_data_t{};
+        if(_has_hw) _hw = _metrics.get_hw_counters(_hw_scaling);
+
+        auto _add = [&](size_t _idx, const char* _name) {
+            _idx        = _timer_cct.child(_idx, _name);
+            auto& _node = _timer_cct.nodes.at(_idx).data;
+            _node.wall += _wall;
+            _node.percent += _pct;
+            if(_has_cpu)
+            {
+                _node.has_cpu = true;
+                _node.cpu += _metrics.get_cpu_timestamp();
+            }
+            if(_has_hw)
+            {
+                _node.has_hw = true;
+                for(size_t i = 0; i < _node.hw.size(); ++i)
+                    _node.hw[i] += _hw[i];
+            }
+            return _idx;
+        };
 
+        auto _idx = size_t{ 0 };
+        if(_region_context && itr.m_region != 0)
+            _idx = _add(_idx, _get_region(itr.m_region));
         for(const auto& iitr : itr.m_stack)
+            _idx = _add(_idx, get_sampling_frame(category::timer_sampling{}, iitr).name);
+    }
+}
+
+void
+build_region_hotspots(const std::vector<timer_sampling_data>& _data,
+                      region_hotspots_t&                      _hotspots)
+{
+    for(const auto& itr : _data)
+    {
+        if(itr.m_region == 0 || itr.m_stack.empty()) continue;
+        const auto& _leaf = itr.m_stack.back();
+        ++_hotspots[itr.m_region][get_sampling_frame(category::timer_sampling{}, _leaf)
+                                      .name];
+    }
+}
+
+void
+write_region_hotspots(const region_hotspots_t& _hotspots)
+{
+    constexpr size_t max_entries = 20;
+
+    // regions in the order of their number of samples
+    auto _regions = std::vector<std::pair<size_t, tim::hash_value_t>>{};
+    for(const auto& itr : _hotspots)
+    {
+        size_t _sum = 0;
+        for(const auto& iitr : itr.second)
+            _sum += iitr.second;
+        _regions.emplace_back(_sum, itr.first);
+    }
+    std::sort(_regions.begin(), _regions.end(), std::greater<>{});
+
+    auto _fname = tim::settings::compose_output_filename("sampling-region-hotspots",
+                                                         ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening region hot-spots output file: %s",
+                        _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<sampling_wall_clock>{}(
+            _fname, std::string{ "sampling_region_hotspots" });
+
+    for(const auto& ritr : _regions)
+    {
+        auto _funcs = std::vector<std::pair<size_t, const char*>>{};
+        for(const auto& itr : _hotspots.at(ritr.second))
+            _funcs.emplace_back(itr.second, itr.first);
+        std::sort(_funcs.begin(), _funcs.end(), std::greater<>{});
+
+        _ofs << tim::get_hash_identifier_fast(ritr.second) << " (" << ritr.first
+             << " samples)\n";
+        for(size_t i = 0; i < std::min(_funcs.size(), max_entries); ++i)
+        {
+            auto _pct = (100.0 * _funcs.at(i).first) / ritr.first;
+            _ofs << std::setw(12) << _funcs.at(i).first << std::setw(9) << std::fixed
+                 << std::setprecision(2) << _pct << "%  " << _funcs.at(i).second
+                 << "\n";
+        }
+        _ofs << "\n";
+    }
+}
+
+void
+build_cpu_residency(int64_t _tid, const std::vector<timer_sampling_data>& _data,
+                    cpu_residency_t& _residency)
+{
+    auto    _ret      = thread_cpu_residency{};
+    int32_t _last_cpu = -1;
+
+    _ret.tid = _tid;
+    for(const auto& itr : _data)
+    {
+        if(itr.m_cpu < 0) continue;
+        if(_ret.samples == 0) _ret.beg = itr.m_end;
+        if(_last_cpu >= 0 && itr.m_cpu != _last_cpu) ++_ret.migrations;
+        ++_ret.samples;
+        ++_ret.cpus[itr.m_cpu];
+        _ret.end  = itr.m_end;
+        _last_cpu = itr.m_cpu;
+    }
+
+    if(_ret.samples > 0) _residency.emplace_back(std::move(_ret));
+}
+
+void
+write_cpu_residency(const cpu_residency_t& _residency)
+{
+    auto _fname = tim::settings::compose_output_filename("cpu-residency", ".txt");
+    auto _ofs   = std::ofstream{};
+    if(!tim::filepath::open(_ofs, _fname))
+    {
+        OMNITRACE_THROW("Error opening CPU residency output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<sampling_wall_clock>{}(
+            _fname, std::string{ "sampling_cpu_residency" });
+
+    for(const auto& itr : _residency)
+    {
+        auto _secs = static_cast<double>(itr.end - itr.beg) / units::sec;
+        auto _rate = (_secs > 0.0) ? (itr.migrations / _secs) : 0.0;
+
+        _ofs << "Thread " << itr.tid << " : " << itr.samples << " samples, "
+             << itr.cpus.size() << " CPUs, " << itr.migrations << " migrations ("
+             << std::fixed << std::setprecision(2) << _rate << "/sec)\n";
+        _ofs << std::setw(12) << "CPU" << std::setw(12) << "samples" << std::setw(10)
+             << "%"
+             << "\n";
+
+        // CPUs in the order of their number of samples
+        auto _cpus = std::vector<std::pair<size_t, int32_t>>{};
+        for(const auto& citr : itr.cpus)
+            _cpus.emplace_back(citr.second, citr.first);
+        std::sort(_cpus.begin(), _cpus.end(), std::greater<>{});
+
+        for(const auto& citr : _cpus)
         {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
+            auto _pct = (100.0 * citr.first) / itr.samples;
+            _ofs << std::setw(12) << citr.second << std::setw(12) << citr.first
+                 << std::setw(9) << std::fixed << std::setprecision(2) << _pct << "%\n";
         }
+        _ofs << "\n";
+    }
+}
+
+// pairwise tree-reduction of the calling-context trees of the threads on the
+// thread-pool. The children of a node keep the order in which they were first seen
+// in thread order so the result does not depend on the task scheduling
+thread_sampling_cct
+reduce_sampling_cct(std::vector<thread_sampling_cct>& _data)
+{
+    if(_data.empty()) return thread_sampling_cct{};
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
+    auto  _parallel   = (config::get_thread_pool_size() > 1 && _data.size() > 2);
+    auto& _task_group = tasking::general::get_task_group();
+    for(size_t _stride = 1; _stride < _data.size(); _stride *= 2)
+    {
+        for(size_t i = 0; i + _stride < _data.size(); i += 2 * _stride)
         {
-            auto& iitr = _data.at(_data.size() - i - 1);
-            iitr.stop();
+            auto _func = [&_data, i, _stride]() {
+                _data.at(i) += _data.at(i + _stride);
+                _data.at(i + _stride) = thread_sampling_cct{};
+            };
+
+            if(_parallel)
+                _task_group.exec(_func);
+            else
+                _func();
+        }
+        if(_parallel) _task_group.join();
+    }
+
+    return std::move(_data.front());
+}
+
+void
+post_process_timemory(int64_t _tid, const thread_sampling_cct& _cct)
+{
+    OMNITRACE_VERBOSE(3 || get_debug_sampling(),
+                      "[%li] Post-processing data for timemory...\n", _tid);
+
+    {
+        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_off_cpu>;
+
+        _cct.off_cpu.insert<bundle_t>(_tid, [](bundle_t& _bundle, const auto& _node) {
+            if constexpr(tim::trait::is_available<sampling_off_cpu>::value)
+            {
+                auto* _oc = _bundle.template get<sampling_off_cpu>();
+                if(_oc)
+                {
+                    auto _value = _node.data / sampling_off_cpu::get_unit();
+                    _oc->set_value(_value);
+                    _oc->set_accum(_value);
+                }
+            }
+        });
+    }
+
+    {
+        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock>;
+
+        _cct.overflow.insert<bundle_t>(_tid, [](bundle_t& _bundle, const auto& _node) {
             if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
             {
-                auto* _sc = iitr.get<sampling_wall_clock>();
+                auto* _sc = _bundle.template get<sampling_wall_clock>();
                 if(_sc)
                 {
-                    auto _value = static_cast<double>(itr.m_end - itr.m_beg) /
-                                  sampling_wall_clock::get_unit();
+                    auto _value = _node.data.wall / sampling_wall_clock::get_unit();
                     _sc->set_value(_value);
                     _sc->set_accum(_value);
                 }
             }
-            iitr.pop();
-        }
+        });
     }
 
-    for(const auto& itr : _timer_data)
     {
         using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock,
                                                 sampling_cpu_clock, hw_counters>;
 
-        double _elapsed_wc = (itr.m_end - itr.m_beg);
-
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
-
-        // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
-        {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
-        }
-
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
-        {
-            auto& iitr = _data.at(_data.size() - i - 1);
-            iitr.stop();
-
+        _cct.timer.insert<bundle_t>(_tid, [](bundle_t& _bundle, const auto& _node) {
+            const auto& _data = _node.data;
             if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
             {
-                auto* _sc = iitr.get<sampling_wall_clock>();
+                auto* _sc = _bundle.template get<sampling_wall_clock>();
                 if(_sc)
                 {
-                    auto _value = _elapsed_wc / sampling_wall_clock::get_unit();
+                    auto _value = _data.wall / sampling_wall_clock::get_unit();
                     _sc->set_value(_value);
                     _sc->set_accum(_value);
                 }
             }
 
-            const auto& _metrics = itr.m_metrics;
             if constexpr(tim::trait::is_available<sampling_cpu_clock>::value)
             {
-                auto* _cc = iitr.get<sampling_cpu_clock>();
-
-                if(_cc && _metrics && _metrics(category::thread_cpu_time{}))
+                auto* _cc = _bundle.template get<sampling_cpu_clock>();
+                if(_cc && _data.has_cpu)
                 {
-                    double _elapsed_cc = _metrics.get_cpu_timestamp();
-
-                    _cc->set_value(_elapsed_cc / sampling_cpu_clock::get_unit());
-                    _cc->set_accum(_elapsed_cc / sampling_cpu_clock::get_unit());
+                    _cc->set_value(_data.cpu / sampling_cpu_clock::get_unit());
+                    _cc->set_accum(_data.cpu / sampling_cpu_clock::get_unit());
                 }
             }
 
             if constexpr(tim::trait::is_available<hw_counters>::value)
             {
-                auto* _hw_counter = iitr.get<hw_counters>();
-
-                if(_hw_counter && _metrics &&
-                   _metrics(type_list<backtrace_metrics::hw_counters>{}) &&
-                   _metrics(category::thread_hardware_counter{}))
+                auto* _hw_counter = _bundle.template get<hw_counters>();
+                if(_hw_counter && _data.has_hw)
                 {
-                    _hw_counter->set_value(_metrics.get_hw_counters());
-                    _hw_counter->set_accum(_metrics.get_hw_counters());
+                    _hw_counter->set_value(_data.hw);
+                    _hw_counter->set_accum(_data.hw);
                 }
             }
-
-            iitr.pop();
-        }
+        });
     }
 
-    for(auto&& itr : _overflow_data)
     {
         using bundle_t =
             tim::lightweight_tuple<sampling_percent, quirk::config<quirk::flat_scope>>;
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+        auto _store = [](bundle_t& _bundle, const auto& _node) {
+            _bundle.store(std::plus<double>{}, _node.data.percent);
+        };
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
-        {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
-        }
+        _cct.overflow.insert<bundle_t>(_tid, _store);
+        _cct.timer.insert<bundle_t>(_tid, _store);
+    }
+}
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
+void
+post_process_parquet(int64_t _tid, const thread_sampling_data& _data)
+{
+    OMNITRACE_VERBOSE(3 || get_debug_sampling(),
+                      "[%li] Post-processing samples for parquet...\n", _tid);
+
+    auto _frames = parquet_output::stack_t{};
+    auto _append = [&_frames, _tid](auto _category, const char* _kind, const auto& _v,
+                                    const backtrace_metrics* _metrics) {
+        _frames.clear();
+        for(const auto& itr : _v.m_stack)
+            _frames.emplace_back(get_sampling_frame(_category, itr).name);
+
+        auto _sample     = parquet_output::sample_record{};
+        _sample.tid      = _tid;
+        _sample.kind     = _kind;
+        _sample.start    = _v.m_beg;
+        _sample.end      = _v.m_end;
+        _sample.stack_id = parquet_output::get_stack_id(_frames);
+        if(_metrics)
         {
-            auto&  iitr   = _data.at(_data.size() - i - 1);
-            double _value = (1.0 / _sum) * 100.0;
-            iitr.store(std::plus<double>{}, _value);
-            iitr.stop();
-            iitr.pop();
+            if((*_metrics)(category::thread_cpu_time{}))
+                _sample.cpu_time = _metrics->get_cpu_timestamp();
+            if((*_metrics)(category::thread_peak_memory{}))
+                _sample.peak_memory = _metrics->get_peak_memory();
+            if((*_metrics)(category::thread_context_switch{}))
+                _sample.context_switches = _metrics->get_context_switches();
+            if((*_metrics)(category::thread_page_fault{}))
+                _sample.page_faults = _metrics->get_page_faults();
         }
-    }
+        parquet_output::append(_sample);
+    };
+
+    for(const auto& itr : _data.m_timer_data)
+        _append(category::timer_sampling{}, "timer", itr, &itr.m_metrics);
+    const auto& _events = get_overflow_events();
+    for(const auto& itr : _data.m_overflow_data)
+        _append(category::overflow_sampling{},
+                (_events.size() > 1) ? _events.at(itr.m_event).label.c_str() : "overflow",
+                itr, nullptr);
+    for(const auto& itr : _data.m_off_cpu_data)
+        _append(category::off_cpu{}, "off_cpu", itr, nullptr);
+
+    // one row-group per thread
+    parquet_output::flush();
+}
+
+void
+post_process_folded(int64_t _tid, const thread_sampling_data& _data)
+{
+    OMNITRACE_VERBOSE(3 || get_debug_sampling(),
+                      "[%li] Post-processing samples for folded stacks...\n", _tid);
+
+    using weight_type = folded_output::weight_type;
+
+    const auto _weight_type = folded_output::get_weight_type();
+
+    auto _stack  = folded_output::stack_t{};
+    auto _append = [&_stack, _weight_type](auto _category, const char* _root,
+                                           const auto& _v,
+                                           const backtrace_metrics* _metrics) {
+        _stack.clear();
+        if(_root) _stack.emplace_back(_root);
+        for(const auto& itr : _v.m_stack)
+            _stack.emplace_back(get_sampling_frame(_category, itr).name);
+
+        auto _wall   = (_v.m_end > _v.m_beg) ? (_v.m_end - _v.m_beg) : uint64_t{ 0 };
+        auto _weight = uint64_t{ 1 };
+        if(_weight_type == weight_type::wall_clock)
+            _weight = _wall;
+        else if(_weight_type == weight_type::cpu_clock)
+            _weight = (_metrics && (*_metrics)(category::thread_cpu_time{}))
+                          ? static_cast<uint64_t>(_metrics->get_cpu_timestamp())
+                          : _wall;
+
+        folded_output::append(_stack, _weight);
+    };
+
+    // the overflow and off-CPU call-stacks are rooted at a frame named after the event
+    // (or kind) so they are not merged with the timer call-stacks
+    static auto _overflow_roots = []() {
+        auto _v = std::vector<const char*>{};
+        for(const auto& itr : get_overflow_events())
+            _v.emplace_back(
+                string_arena::instance().intern(JOIN("", "[", itr.label, "]")));
+        return _v;
+    }();
+
+    for(const auto& itr : _data.m_timer_data)
+        _append(category::timer_sampling{}, nullptr, itr, &itr.m_metrics);
+    for(const auto& itr : _data.m_overflow_data)
+        _append(category::overflow_sampling{}, _overflow_roots.at(itr.m_event), itr,
+                nullptr);
+    for(const auto& itr : _data.m_off_cpu_data)
+        _append(category::off_cpu{}, "[off_cpu]", itr, nullptr);
+
+    folded_output::flush(_tid);
+}
 
-    for(auto&& itr : _timer_data)
+// the timer and overflow call-stacks are unwound through different caches so the
+// frames are cached separately for each category. Only accessed by the thread
+// finalizing the sampling data.
+template <typename CategoryT>
+const sampling_frame&
+get_sampling_frame(CategoryT, const tim::unwind::processed_entry& _entry)
+{
+    static auto _cache = std::unordered_map<uintptr_t, sampling_frame>{};
+    // frames without an address cannot be keyed by the pc
+    static auto _unknown_cache = std::unordered_map<std::string, sampling_frame>{};
+
+    auto _address = static_cast<uintptr_t>(_entry.address);
+    if(_address > 0)
     {
-        using bundle_t =
-            tim::lightweight_tuple<sampling_percent, quirk::config<quirk::flat_scope>>;
+        if(auto itr = _cache.find(_address); itr != _cache.end()) return itr->second;
+    }
+    else
+    {
+        if(auto itr = _unknown_cache.find(_entry.name); itr != _unknown_cache.end())
+            return itr->second;
+    }
 
-        auto _data = std::vector<bundle_t>{};
-        _data.reserve(itr.m_stack.size());
+    auto& _arena = string_arena::instance();
+    auto  _frame = sampling_frame{};
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& iitr : itr.m_stack)
-        {
-            _data.emplace_back(tim::string_view_t{ iitr.name });
-            _data.back().push(itr.m_tid);
-            _data.back().start();
-        }
+    _frame.name         = _arena.intern(demangle(_entry.name));
+    _frame.location     = _arena.intern(_entry.location);
+    _frame.pc           = _arena.intern(as_hex(_entry.address));
+    _frame.line_address = _arena.intern(as_hex(_entry.line_address));
+    _frame.source       = { _frame.name, _frame.location, _entry.lineno };
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _data.size(); ++i)
+    if(_entry.lineinfo)
+    {
+        auto _lines = _entry.lineinfo.lines;
+        std::reverse(_lines.begin(), _lines.end());
+        _frame.lines.reserve(_lines.size());
+        for(const auto& litr : _lines)
         {
-            auto&  iitr   = _data.at(_data.size() - i - 1);
-            double _value = (1.0 / _sum) * 100.0;
-            iitr.store(std::plus<double>{}, _value);
-            iitr.stop();
-            iitr.pop();
+            auto _name = demangle(litr.name);
+            auto _info = JOIN(':', litr.location, litr.line);
+            auto _v    = sampling_frame::inlined{};
+            _v.name    = _arena.intern(_name);
+            _v.label   = _arena.intern(JOIN('-', "lineinfo", _frame.lines.size()));
+            _v.summary = _arena.intern(JOIN('@', _name, _info));
+            _v.source  = { _v.name, _arena.intern(litr.location),
+                          static_cast<uint32_t>(litr.line) };
+            _frame.lines.emplace_back(_v);
         }
     }
+
+    if(_address > 0) return _cache.emplace(_address, std::move(_frame)).first->second;
+    return _unknown_cache.emplace(_entry.name, std::move(_frame)).first->second;
 }
 
 struct sampling_initialization
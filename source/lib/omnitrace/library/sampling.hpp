@@ -59,10 +59,29 @@ block_samples();
 void
 unblock_samples();
 
+// stops the timers and perf_events of the samplers of all the threads while outside of
+// the trace windows (OMNITRACE_TRACE_DELAY, OMNITRACE_TRACE_DURATION,
+// OMNITRACE_TRACE_PERIODS) so that no signals are delivered. The samplers of the
+// threads which start while paused are started by resume()
+void
+pause();
+
+void
+resume();
+
 void block_signals(std::set<int> = {});
 
 void unblock_signals(std::set<int> = {});
 
+// the calling thread is entering a wait point where it is parked (OMPT barrier waits,
+// blocking lock acquisitions). Depending on OMNITRACE_SAMPLING_IDLE, the timer signals
+// of the thread are blocked until the outermost wait ends
+void
+suspend_idle();
+
+void
+resume_idle();
+
 void
 post_process();
 }  // namespace sampling
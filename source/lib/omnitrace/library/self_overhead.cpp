@@ -0,0 +1,161 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/self_overhead.hpp"
+#include "core/categories.hpp"
+#include "core/components/fwd.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_info.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/manager.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/units.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace omnitrace
+{
+namespace self_overhead
+{
+namespace
+{
+// wall-clock timestamp and the total self-overhead of the process in nanoseconds
+std::deque<std::pair<uint64_t, uint64_t>> samples = {};
+
+void
+write_perfetto_counter_track()
+{
+    using track = perfetto_counter_track<category::self_overhead>;
+
+    if(samples.size() < 2) return;
+
+    const auto& _thread_info = thread_info::get(0, InternalTID);
+    if(!_thread_info) return;
+
+    if(!track::exists(0)) track::emplace(0, "Self-Overhead (S)", "%");
+
+    // the percent of the interval between samples which was spent inside omnitrace,
+    // summed over the threads
+    for(size_t i = 1; i < samples.size(); ++i)
+    {
+        const auto& _prev = samples.at(i - 1);
+        const auto& _curr = samples.at(i);
+        if(_curr.first <= _prev.first || !_thread_info->is_valid_time(_curr.first))
+            continue;
+        auto _value = 100.0 * (_curr.second - _prev.second) / (_curr.first - _prev.first);
+        TRACE_COUNTER(trait::name<category::self_overhead>::value, track::at(0, 0),
+                      _curr.first, _value);
+    }
+
+    TRACE_COUNTER(trait::name<category::self_overhead>::value, track::at(0, 0),
+                  _thread_info->get_stop(), 0.0);
+}
+}  // namespace
+
+void
+sample()
+{
+    if(!is_enabled()) return;
+
+    uint64_t _total = 0;
+    for(const auto& itr : get_thread_overheads())
+        _total += itr.nsec;
+    samples.emplace_back(tracing::now(), _total);
+}
+
+void
+post_process()
+{
+    if(!is_enabled()) return;
+
+    using tracker_t = tim::auto_tuple<component::self_overhead_tracker>;
+
+    component::self_overhead_tracker::label()       = "self_overhead";
+    component::self_overhead_tracker::description() = "Time spent inside omnitrace";
+
+    auto _overheads = get_thread_overheads();
+    auto _app_nsec  = uint64_t{ 0 };
+    auto _int_nsec  = uint64_t{ 0 };
+    auto _count     = uint64_t{ 0 };
+    auto _threads   = std::map<std::string, double>{};
+    for(const auto& itr : _overheads)
+    {
+        if(itr.count == 0) continue;
+
+        // the threads created by omnitrace are internal for their entire lifetime
+        const auto& _info     = thread_info::get(itr.tid, SequentTID);
+        bool        _internal = (_info && _info->is_offset);
+        auto        _label    = JOIN("", (_internal) ? "internal thread " : "thread ",
+                                     itr.tid);
+
+        if(_internal)
+            _int_nsec += itr.nsec;
+        else
+            _app_nsec += itr.nsec;
+        _count += itr.count;
+
+        _threads[_label] = static_cast<double>(itr.nsec) / units::sec;
+
+        if(get_use_timemory())
+        {
+            tracker_t _t{ JOIN('/', "self_overhead", _label) };
+            _t.store(std::plus<double>{},
+                     static_cast<double>(itr.nsec) /
+                         component::self_overhead_tracker::get_unit());
+        }
+
+        OMNITRACE_VERBOSE(1, "[self_overhead] %-24s :: %12.6f sec in %zu regions\n",
+                          _label.c_str(), _threads[_label],
+                          static_cast<size_t>(itr.count));
+    }
+
+    OMNITRACE_VERBOSE(0,
+                      "[self_overhead] %.6f sec on the application threads, %.6f sec on "
+                      "the internal threads (%zu regions, probe cost of %.1f nsec)\n",
+                      static_cast<double>(_app_nsec) / units::sec,
+                      static_cast<double>(_int_nsec) / units::sec,
+                      static_cast<size_t>(_count), get_probe_nsec());
+
+    if(get_use_perfetto()) write_perfetto_counter_track();
+    samples.clear();
+
+    auto _app_sec = static_cast<double>(_app_nsec) / units::sec;
+    auto _int_sec = static_cast<double>(_int_nsec) / units::sec;
+    auto _probe   = get_probe_nsec();
+    tim::manager::instance()->add_metadata([=](auto& ar) {
+        ar(tim::cereal::make_nvp("self_overhead_application_sec", _app_sec),
+           tim::cereal::make_nvp("self_overhead_internal_sec", _int_sec),
+           tim::cereal::make_nvp("self_overhead_probe_nsec", _probe),
+           tim::cereal::make_nvp("self_overhead_threads_sec", _threads));
+    });
+}
+}  // namespace self_overhead
+}  // namespace omnitrace
@@ -0,0 +1,242 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/snapshot.hpp"
+#include "api.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/perfetto_fwd.hpp"
+#include "core/state.hpp"
+#include "library/runtime.hpp"
+#include "library/tracing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace omnitrace
+{
+namespace snapshot
+{
+namespace
+{
+constexpr char trigger_byte  = 't';
+constexpr char shutdown_byte = 'q';
+
+std::atomic<bool> active        = { false };
+std::atomic<bool> pending       = { false };
+bool              use_latency   = false;
+uint64_t          threshold_ns  = 0;
+int               signal_num    = 0;
+int               pipe_fds[2]   = { -1, -1 };
+struct sigaction  former_action = {};
+
+auto&
+get_thread()
+{
+    static auto _v = std::unique_ptr<std::thread>{};
+    return _v;
+}
+
+auto&
+get_stack()
+{
+    static thread_local auto _v = std::vector<uint64_t>{};
+    return _v;
+}
+
+void
+write_byte(char _v)
+{
+    auto _errno = errno;  // preserve errno for the interrupted code
+    while(::write(pipe_fds[1], &_v, 1) < 0 && errno == EINTR)
+    {}
+    errno = _errno;
+}
+
+void
+signal_handler(int)
+{
+    trigger();
+}
+
+void
+run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.snapshot");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto _limit = config::get_perfetto_snapshot_limit();
+    auto _count = size_t{ 0 };
+    char _v     = 0;
+    while(true)
+    {
+        auto _n = ::read(pipe_fds[0], &_v, 1);
+        if(_n < 0 && errno == EINTR) continue;
+        if(_n <= 0 || _v == shutdown_byte) break;
+
+        // triggers after this point are not covered by the snapshot
+        pending.store(false, std::memory_order_release);
+
+        if(_count >= _limit)
+        {
+            OMNITRACE_VERBOSE(1, "[snapshot] ignoring trigger: limit of %zu reached\n",
+                              _limit);
+            continue;
+        }
+
+        if(perfetto::snapshot(_count) > 0) ++_count;
+    }
+}
+}  // namespace
+
+bool
+is_active()
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+bool
+use_threshold()
+{
+    return use_latency && is_active();
+}
+
+void
+setup()
+{
+    if(!config::get_perfetto_snapshot() || get_thread()) return;
+
+    if(config::get_perfetto_backend() != "inprocess")
+    {
+        OMNITRACE_VERBOSE(0, "[snapshot] OMNITRACE_PERFETTO_SNAPSHOT requires "
+                             "OMNITRACE_PERFETTO_BACKEND=inprocess\n");
+        return;
+    }
+
+    if(::pipe(pipe_fds) != 0)
+    {
+        OMNITRACE_VERBOSE(0, "[snapshot] pipe failed: %s\n", strerror(errno));
+        return;
+    }
+
+    auto _threshold = config::get_perfetto_snapshot_threshold();
+    threshold_ns    = static_cast<uint64_t>(std::max(_threshold, 0.0) * units::sec);
+    use_latency     = (threshold_ns > 0);
+
+    {
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        get_thread() = std::make_unique<std::thread>(&run);
+    }
+
+    signal_num = config::get_perfetto_snapshot_signal();
+    if(signal_num > 0)
+    {
+        struct sigaction _action = {};
+        sigemptyset(&_action.sa_mask);
+        _action.sa_flags   = SA_RESTART;
+        _action.sa_handler = &signal_handler;
+        if(sigaction(signal_num, &_action, &former_action) != 0)
+        {
+            OMNITRACE_VERBOSE(0, "[snapshot] sigaction(%i) failed: %s\n", signal_num,
+                              strerror(errno));
+            signal_num = 0;
+        }
+    }
+
+    OMNITRACE_VERBOSE(1,
+                      "[snapshot] flight-recorder mode enabled (signal: %i, threshold: "
+                      "%.3f sec)...\n",
+                      signal_num, _threshold);
+
+    active.store(true, std::memory_order_release);
+}
+
+void
+shutdown()
+{
+    if(!get_thread()) return;
+
+    active.store(false, std::memory_order_release);
+    if(signal_num > 0) sigaction(signal_num, &former_action, nullptr);
+
+    write_byte(shutdown_byte);
+    get_thread()->join();
+    get_thread().reset();
+
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+    pipe_fds[0] = pipe_fds[1] = -1;
+}
+
+void
+trigger()
+{
+    if(!is_active()) return;
+    if(pending.exchange(true, std::memory_order_acq_rel)) return;
+    write_byte(trigger_byte);
+}
+
+void
+begin()
+{
+    get_stack().emplace_back(tracing::now());
+}
+
+void
+end(std::string_view _name)
+{
+    auto& _stack = get_stack();
+    if(_stack.empty()) return;
+
+    auto _elapsed = tracing::now() - _stack.back();
+    _stack.pop_back();
+
+    if(_elapsed > threshold_ns && !pending.load(std::memory_order_relaxed))
+    {
+        OMNITRACE_VERBOSE(1, "[snapshot] '%s' took %.3f msec...\n", _name.data(),
+                          static_cast<double>(_elapsed) / units::msec);
+        trigger();
+    }
+}
+}  // namespace snapshot
+}  // namespace omnitrace
+
+extern "C" void
+omnitrace_trigger_snapshot_hidden(void)
+{
+    if(!omnitrace::snapshot::is_active())
+    {
+        OMNITRACE_VERBOSE_F(1, "ignored: OMNITRACE_PERFETTO_SNAPSHOT is not enabled\n");
+        return;
+    }
+    omnitrace::snapshot::trigger();
+}
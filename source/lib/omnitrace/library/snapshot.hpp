@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string_view>
+
+namespace omnitrace
+{
+// flight-recorder mode (OMNITRACE_PERFETTO_SNAPSHOT): the perfetto ring buffer is
+// cloned and written to a file whenever a snapshot is triggered by the user API, by
+// OMNITRACE_PERFETTO_SNAPSHOT_SIGNAL, or by a region exceeding
+// OMNITRACE_PERFETTO_SNAPSHOT_THRESHOLD. The triggers only write a byte into a pipe
+// (async-signal-safe) and a background thread performs the snapshot. Triggers which
+// arrive while a snapshot is pending are coalesced into that snapshot.
+namespace snapshot
+{
+bool
+is_active();
+
+// true when a latency threshold is set, i.e. the regions need to be timed
+bool
+use_threshold();
+
+void
+setup();
+
+void
+shutdown();
+
+// async-signal-safe
+void
+trigger();
+
+// invoked by category_region when a region is pushed and popped
+void
+begin();
+
+void
+end(std::string_view);
+}  // namespace snapshot
+}  // namespace omnitrace
@@ -0,0 +1,332 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/stream_output.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/timemory.hpp"
+#include "core/utility.hpp"
+#include "library/ptl.hpp"
+
+#include <timemory/components/rusage/components.hpp>
+#include <timemory/components/timing/components.hpp>
+#include <timemory/mpl/available.hpp>
+#include <timemory/operations/types/file_output_message.hpp>
+#include <timemory/storage/types.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace stream_output
+{
+namespace
+{
+// the components with a scalar value
+using component_types_t = tim::mpl::available_t<type_list<
+    comp::wall_clock, comp::cpu_clock, comp::cpu_util, comp::thread_cpu_clock,
+    comp::thread_cpu_util, comp::process_cpu_clock, comp::process_cpu_util,
+    comp::user_clock, comp::system_clock, comp::user_mode_time, comp::kernel_mode_time,
+    comp::peak_rss, comp::page_rss, comp::virtual_memory, comp::num_major_page_faults,
+    comp::num_minor_page_faults, comp::priority_context_switch,
+    comp::voluntary_context_switch>>;
+
+constexpr size_t stream_buffer_size = 1 << 20;
+
+struct node_record
+{
+    int64_t          tid   = 0;
+    int64_t          depth = 0;
+    uint64_t         laps  = 0;
+    double           value = 0.0;
+    std::string_view name  = {};  // the hash identifiers outlive the output
+};
+
+struct component_records
+{
+    std::string              label       = {};
+    std::string              description = {};
+    std::string              unit        = {};
+    std::vector<node_record> nodes       = {};
+};
+
+//--------------------------------------------------------------------------------------//
+//
+//      JSON
+//
+//--------------------------------------------------------------------------------------//
+
+void
+write_json(std::ostream& _os, const component_records& _data)
+{
+    _os << "{\"omnitrace\":{\"component\":\"" << utility::json_escape(_data.label)
+        << "\",\"description\":\"" << utility::json_escape(_data.description)
+        << "\",\"unit\":\"" << utility::json_escape(_data.unit) << "\",\"graph\":[";
+    _os.precision(std::numeric_limits<double>::max_digits10);
+    bool _first = true;
+    for(const auto& itr : _data.nodes)
+    {
+        _os << ((_first) ? "\n" : ",\n") << "{\"tid\":" << itr.tid
+            << ",\"depth\":" << itr.depth << ",\"name\":\""
+            << utility::json_escape(itr.name) << "\",\"laps\":" << itr.laps
+            << ",\"value\":" << itr.value << "}";
+        _first = false;
+    }
+    _os << "\n]}}\n";
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//      MessagePack
+//
+//--------------------------------------------------------------------------------------//
+
+template <typename Tp>
+void
+write_msgpack_be(std::ostream& _os, Tp _v)
+{
+    char _buf[sizeof(Tp)];
+    for(size_t i = 0; i < sizeof(Tp); ++i)
+        _buf[i] = static_cast<char>((_v >> (8 * (sizeof(Tp) - i - 1))) & 0xff);
+    _os.write(_buf, sizeof(Tp));
+}
+
+void
+write_msgpack_header(std::ostream& _os, uint8_t _fix, uint8_t _fixmax, uint8_t _tag16,
+                     uint8_t _tag32, uint32_t _n)
+{
+    if(_n <= _fixmax)
+    {
+        _os.put(static_cast<char>(_fix | _n));
+    }
+    else if(_n <= 0xffff)
+    {
+        _os.put(static_cast<char>(_tag16));
+        write_msgpack_be<uint16_t>(_os, _n);
+    }
+    else
+    {
+        _os.put(static_cast<char>(_tag32));
+        write_msgpack_be<uint32_t>(_os, _n);
+    }
+}
+
+void
+write_msgpack_map(std::ostream& _os, uint32_t _n)
+{
+    write_msgpack_header(_os, 0x80, 0x0f, 0xde, 0xdf, _n);
+}
+
+void
+write_msgpack_array(std::ostream& _os, uint32_t _n)
+{
+    write_msgpack_header(_os, 0x90, 0x0f, 0xdc, 0xdd, _n);
+}
+
+void
+write_msgpack(std::ostream& _os, std::string_view _v)
+{
+    auto _n = static_cast<uint32_t>(_v.length());
+    if(_n <= 0x1f)
+    {
+        _os.put(static_cast<char>(0xa0 | _n));
+    }
+    else if(_n <= 0xff)
+    {
+        _os.put(static_cast<char>(0xd9));
+        _os.put(static_cast<char>(_n));
+    }
+    else
+    {
+        write_msgpack_header(_os, 0, 0, 0xda, 0xdb, _n);
+    }
+    _os.write(_v.data(), _n);
+}
+
+void
+write_msgpack(std::ostream& _os, int64_t _v)
+{
+    if(_v >= 0 && _v <= 0x7f)
+    {
+        _os.put(static_cast<char>(_v));
+    }
+    else
+    {
+        _os.put(static_cast<char>(0xd3));
+        write_msgpack_be<uint64_t>(_os, static_cast<uint64_t>(_v));
+    }
+}
+
+void
+write_msgpack(std::ostream& _os, uint64_t _v)
+{
+    if(_v <= 0x7f)
+    {
+        _os.put(static_cast<char>(_v));
+    }
+    else
+    {
+        _os.put(static_cast<char>(0xcf));
+        write_msgpack_be<uint64_t>(_os, _v);
+    }
+}
+
+void
+write_msgpack(std::ostream& _os, double _v)
+{
+    uint64_t _bits = 0;
+    std::memcpy(&_bits, &_v, sizeof(_bits));
+    _os.put(static_cast<char>(0xcb));
+    write_msgpack_be<uint64_t>(_os, _bits);
+}
+
+// a map of the metadata and the nodes as rows of a table, i.e. the keys of the
+// columns are not repeated for every node
+void
+write_msgpack(std::ostream& _os, const component_records& _data)
+{
+    write_msgpack_map(_os, 5);
+    write_msgpack(_os, std::string_view{ "component" });
+    write_msgpack(_os, std::string_view{ _data.label });
+    write_msgpack(_os, std::string_view{ "description" });
+    write_msgpack(_os, std::string_view{ _data.description });
+    write_msgpack(_os, std::string_view{ "unit" });
+    write_msgpack(_os, std::string_view{ _data.unit });
+    write_msgpack(_os, std::string_view{ "columns" });
+    write_msgpack_array(_os, 5);
+    for(const auto* itr : { "tid", "depth", "name", "laps", "value" })
+        write_msgpack(_os, std::string_view{ itr });
+    write_msgpack(_os, std::string_view{ "graph" });
+    write_msgpack_array(_os, _data.nodes.size());
+    for(const auto& itr : _data.nodes)
+    {
+        write_msgpack_array(_os, 5);
+        write_msgpack(_os, itr.tid);
+        write_msgpack(_os, itr.depth);
+        write_msgpack(_os, itr.name);
+        write_msgpack(_os, itr.laps);
+        write_msgpack(_os, itr.value);
+    }
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename Tp>
+void
+write(const component_records& _data, bool _msgpack)
+{
+    auto _fname = tim::settings::compose_output_filename(
+        JOIN('-', _data.label, "stream"), (_msgpack) ? ".msgpack" : ".json");
+
+    auto _buffer = std::vector<char>(stream_buffer_size);
+    auto _ofs    = std::ofstream{};
+    _ofs.rdbuf()->pubsetbuf(_buffer.data(), _buffer.size());
+
+    auto _mode = (_msgpack) ? (std::ios::out | std::ios::binary) : std::ios::out;
+    if(!tim::filepath::open(_ofs, _fname, _mode))
+    {
+        OMNITRACE_THROW("Error opening streaming output file: %s", _fname.c_str());
+    }
+
+    if(get_verbose() >= 0)
+        operation::file_output_message<Tp>{}(_fname, std::string{ "stream_output" });
+
+    if(_msgpack)
+        write_msgpack(_ofs, _data);
+    else
+        write_json(_ofs, _data);
+}
+
+template <typename Tp>
+void
+post_process(bool _msgpack)
+{
+    auto* _storage = tim::storage<Tp>::instance();
+    if(!_storage || _storage->empty()) return;
+
+    auto _data         = std::make_shared<component_records>();
+    _data->label       = Tp::label();
+    _data->description = Tp::description();
+    _data->unit        = Tp::get_display_unit();
+
+    for(const auto& itr : _storage->get())
+    {
+        using value_type = std::decay_t<decltype(itr.data().get())>;
+        if constexpr(std::is_arithmetic<value_type>::value)
+        {
+            auto _name = tim::get_hash_identifier_fast(itr.hash());
+            if(std::string_view{ _name }.empty()) continue;
+            _data->nodes.emplace_back(node_record{
+                static_cast<int64_t>(itr.tid()), static_cast<int64_t>(itr.depth()),
+                static_cast<uint64_t>(itr.data().get_laps()),
+                static_cast<double>(itr.data().get()), _name });
+        }
+    }
+
+    if(_data->nodes.empty()) return;
+
+    tasking::finalize::get_task_group().exec([_data, _msgpack]() {
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        try
+        {
+            write<Tp>(*_data, _msgpack);
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "%s\n", _e.what());
+        }
+    });
+}
+
+template <typename... Tp>
+void
+post_process(bool _msgpack, type_list<Tp...>)
+{
+    (post_process<Tp>(_msgpack), ...);
+}
+}  // namespace
+
+void
+post_process()
+{
+    auto _msgpack = (config::get_stream_output_format() == "msgpack");
+    post_process(_msgpack, component_types_t{});
+}
+
+void
+disable_timemory_output()
+{
+    config::set_setting_value("OMNITRACE_JSON_OUTPUT", false);
+    config::set_setting_value("OMNITRACE_TREE_OUTPUT", false);
+}
+}  // namespace stream_output
+}  // namespace omnitrace
@@ -0,0 +1,42 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace omnitrace
+{
+namespace stream_output
+{
+// OMNITRACE_STREAM_OUTPUT: the call-graph of each timing and resource-usage component
+// is read from the timemory storage on the finalizing thread and the nodes are then
+// serialized (as JSON or MessagePack) directly into a buffered file on the
+// thread-pool, one task per component, instead of via the cereal JSON and tree
+// archives of timemory which build the whole document in memory sequentially
+void
+post_process();
+
+// disables the JSON and tree output of timemory which are replaced by the streamed
+// output. Invoked after the post-processing stages since they also query the settings
+void
+disable_timemory_output();
+}  // namespace stream_output
+}  // namespace omnitrace
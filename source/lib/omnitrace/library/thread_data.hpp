@@ -25,6 +25,7 @@
 #include "core/common.hpp"
 #include "core/concepts.hpp"
 #include "core/config.hpp"
+#include "core/containers/concurrent_stable_vector.hpp"
 #include "core/containers/stable_vector.hpp"
 #include "core/debug.hpp"
 #include "core/defines.hpp"
@@ -37,6 +38,7 @@
 #include <timemory/utility/types.hpp>
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
@@ -56,10 +58,12 @@ using bundle_allocator_t = tim::data::ring_buffer_allocator<instrumentation_bund
 
 using grow_functor_t = int64_t (*)(int64_t);
 
+// the thread data singletons register their functor when they are constructed, which
+// may happen on any thread
 inline auto&
 grow_functors()
 {
-    static auto _v = container::stable_vector<grow_functor_t>{};
+    static auto _v = container::concurrent_stable_vector<grow_functor_t>{};
     return _v;
 }
 
@@ -72,7 +76,7 @@ struct base_thread_data
             decltype(auto) _v = Tp::private_instance();
             if(_v && _v->capacity() < static_cast<size_t>(_sz + 1))
             {
-                _v->reserve(_v->capacity() + 1);
+                _v->reserve(static_cast<size_t>(_sz + 1));
                 _v->resize(_v->capacity());
             }
             return (_v) ? _v->capacity() : 0;
@@ -377,7 +381,7 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::construct(construct_on_thread&&
         grow_functors().emplace_back([](int64_t _n) -> int64_t {
             if(static_cast<size_t>(_n) >= _constructed.size())
             {
-                _constructed.reserve(_constructed.capacity() + 1);
+                _constructed.reserve(static_cast<size_t>(_n + 1));
                 container::resize(_constructed, _constructed.capacity(), false);
             }
             return _constructed.size();
@@ -545,7 +549,7 @@ thread_data<identity<Tp>, Tag, MaxThreads>::construct(construct_on_thread&& _t,
         grow_functors().emplace_back([](int64_t _n) -> int64_t {
             if(static_cast<size_t>(_n) >= _constructed.size())
             {
-                _constructed.reserve(_constructed.capacity() + 1);
+                _constructed.reserve(static_cast<size_t>(_n + 1));
                 container::resize(_constructed, _constructed.capacity(), false);
             }
             return _constructed.size();
@@ -573,6 +577,77 @@ thread_data<identity<Tp>, Tag, MaxThreads>::instance(construct_on_thread&& _t,
     return instance()->at(_t.index);
 }
 
+//--------------------------------------------------------------------------------------//
+//
+//          per-thread counters in cache-line aligned slots
+//
+//--------------------------------------------------------------------------------------//
+
+// counter which is updated by every thread in the hot paths. Each thread only updates
+// its own slot so the updates never contend on a cache line and the value is the sum of
+// the slots. The slots are stored inline so nothing is allocated and the counter is
+// constant-initialized. The threads beyond MaxThreads share the slots
+template <typename Tp, size_t MaxThreads = max_supported_threads>
+struct thread_counter
+{
+    static_assert(std::is_integral<Tp>::value, "thread_counter requires an integer");
+
+    using value_type = Tp;
+
+    thread_counter& operator++()
+    {
+        local().fetch_add(1, std::memory_order_relaxed);
+        return *this;
+    }
+
+    thread_counter& operator--()
+    {
+        local().fetch_sub(1, std::memory_order_relaxed);
+        return *this;
+    }
+
+    thread_counter& operator+=(value_type _v)
+    {
+        local().fetch_add(_v, std::memory_order_relaxed);
+        return *this;
+    }
+
+    thread_counter& operator-=(value_type _v)
+    {
+        local().fetch_sub(_v, std::memory_order_relaxed);
+        return *this;
+    }
+
+    // not a snapshot when the other threads are updating the counter
+    value_type load() const
+    {
+        auto _v = value_type{ 0 };
+        for(const auto& itr : m_slots)
+            _v += itr.value.load(std::memory_order_relaxed);
+        return _v;
+    }
+
+    void reset()
+    {
+        for(auto& itr : m_slots)
+            itr.value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct slot
+    {
+        alignas(container::cacheline_align_v) std::atomic<value_type> value = { 0 };
+    };
+
+    std::atomic<value_type>& local()
+    {
+        static thread_local auto _idx = threading::get_id() % MaxThreads;
+        return m_slots[_idx].value;
+    }
+
+    std::array<slot, MaxThreads> m_slots = {};
+};
+
 //--------------------------------------------------------------------------------------//
 
 // there are currently some strange things that happen with
@@ -35,7 +35,12 @@
 #include <timemory/components/timing/backends.hpp>
 #include <timemory/process/threading.hpp>
 
+#include <array>
+#include <atomic>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <type_traits>
 
 namespace omnitrace
 {
@@ -109,7 +114,153 @@ init_index_data(int64_t _tid, bool _offset = false)
 
 thread_local int64_t offset_causal_count = 0;
 const auto           unknown_thread      = std::optional<thread_info>{};
-int64_t              peak_num_threads    = max_supported_threads;
+std::atomic<int64_t> peak_num_threads    = { max_supported_threads };
+
+// insert-only, open-addressing hash table which maps a thread identifier (system tid,
+// sequent tid, pthread handle) to the internal thread index. Lookups and inserts are
+// lock-free so they are safe to use from signal handlers. If the table fills up,
+// the lookups fall back to scanning the thread data.
+struct thread_index_table
+{
+    static constexpr size_t   capacity_bits = 13;
+    static constexpr size_t   capacity      = (1UL << capacity_bits);
+    static constexpr uint64_t empty_key     = std::numeric_limits<uint64_t>::max();
+
+    struct slot
+    {
+        std::atomic<uint64_t> key   = { empty_key };
+        std::atomic<int64_t>  value = { -1 };
+    };
+
+    void    insert(uint64_t _key, int64_t _value);
+    int64_t find(uint64_t _key) const;
+    bool    is_complete() const { return !m_overflow.load(std::memory_order_relaxed); }
+
+private:
+    static size_t hash(uint64_t _key)
+    {
+        // fibonacci hashing spreads sequential values (tids) across the table
+        return (_key * 0x9E3779B97F4A7C15ULL) >> (64 - capacity_bits);
+    }
+
+    std::atomic<bool>          m_overflow = { false };
+    std::array<slot, capacity> m_slots    = {};
+};
+
+void
+thread_index_table::insert(uint64_t _key, int64_t _value)
+{
+    if(_key == empty_key)
+    {
+        m_overflow.store(true, std::memory_order_relaxed);
+        return;
+    }
+
+    auto _hash = hash(_key);
+    for(size_t i = 0; i < capacity; ++i)
+    {
+        auto& _slot     = m_slots[(_hash + i) & (capacity - 1)];
+        auto  _expected = empty_key;
+        if(_slot.key.compare_exchange_strong(_expected, _key, std::memory_order_acq_rel))
+        {
+            _slot.value.store(_value, std::memory_order_release);
+            return;
+        }
+        // keep the first thread registered with this key
+        if(_expected == _key) return;
+    }
+
+    m_overflow.store(true, std::memory_order_relaxed);
+}
+
+int64_t
+thread_index_table::find(uint64_t _key) const
+{
+    auto _hash = hash(_key);
+    for(size_t i = 0; i < capacity; ++i)
+    {
+        const auto& _slot = m_slots[(_hash + i) & (capacity - 1)];
+        auto        _v    = _slot.key.load(std::memory_order_acquire);
+        if(_v == _key) return _slot.value.load(std::memory_order_acquire);
+        if(_v == empty_key) break;
+    }
+    return -1;
+}
+
+auto&
+get_system_index_table()
+{
+    static auto* _v = new thread_index_table{};
+    return *_v;
+}
+
+auto&
+get_sequent_index_table()
+{
+    static auto* _v = new thread_index_table{};
+    return *_v;
+}
+
+auto&
+get_pthread_index_table()
+{
+    static auto* _v = new thread_index_table{};
+    return *_v;
+}
+
+auto&
+get_stl_index_table()
+{
+    static auto* _v = new thread_index_table{};
+    return *_v;
+}
+
+template <typename Tp>
+uint64_t
+get_index_key(Tp _v)
+{
+    if constexpr(std::is_same<Tp, std::thread::id>::value)
+        return std::hash<std::thread::id>{}(_v);
+    else
+        return static_cast<uint64_t>(_v);
+}
+
+void
+add_index_data(const thread_index_data& _v)
+{
+    get_system_index_table().insert(get_index_key(_v.system_value), _v.internal_value);
+    get_sequent_index_table().insert(get_index_key(_v.sequent_value), _v.internal_value);
+    get_pthread_index_table().insert(get_index_key(_v.pthread_value), _v.internal_value);
+    get_stl_index_table().insert(get_index_key(_v.stl_value), _v.internal_value);
+}
+
+// find the thread info via the index table. The predicate validates the match (e.g.
+// against hash collisions for std::thread::id) and is used for a linear search when the
+// table could not hold every thread
+template <typename Tp, typename PredT>
+const std::optional<thread_info>&
+find_info_data(const thread_index_table& _table, Tp _key, PredT&& _pred)
+{
+    const auto& _info_data = get_info_data();
+    if(!_info_data) return unknown_thread;
+
+    auto _idx = _table.find(get_index_key(_key));
+    if(_idx >= 0 && _idx < static_cast<int64_t>(_info_data->size()))
+    {
+        const auto& itr = _info_data->at(_idx);
+        if(itr && itr->index_data && _pred(*itr->index_data)) return itr;
+    }
+
+    if(!_table.is_complete())
+    {
+        for(const auto& itr : *_info_data)
+        {
+            if(itr && itr->index_data && _pred(*itr->index_data)) return itr;
+        }
+    }
+
+    return unknown_thread;
+}
 }  // namespace
 
 std::string
@@ -127,34 +278,36 @@ grow_data(int64_t _tid)
     struct data_growth
     {};
 
-    if(_tid >= peak_num_threads)
+    if(_tid >= peak_num_threads.load(std::memory_order_acquire))
     {
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         auto_lock_t _lk{ type_mutex<data_growth>() };
 
         // check again after locking
-        if(_tid >= peak_num_threads)
+        auto _peak = peak_num_threads.load(std::memory_order_acquire);
+        if(_tid >= _peak)
         {
-            TIMEMORY_PRINTF_WARNING(
-                stderr, "[%li] Growing thread data from %li to %li...\n", _tid,
-                peak_num_threads, peak_num_threads + max_supported_threads);
+            TIMEMORY_PRINTF_WARNING(stderr, "[%li] Growing thread data from %li...\n",
+                                    _tid, _peak);
             fflush(stderr);
 
+            // thread data grows geometrically so the new peak is the smallest capacity
+            // of all the thread data instances
+            int64_t _new_peak = std::numeric_limits<int64_t>::max();
             for(auto itr : grow_functors())
             {
-                if(itr)
-                {
-                    int64_t _new_capacity = (*itr)(_tid + 1);
-                    TIMEMORY_PRINTF_WARNING(stderr,
-                                            "[%li] Grew thread data from %li to %li...\n",
-                                            _tid, peak_num_threads, _new_capacity);
-                }
+                if(itr) _new_peak = std::min<int64_t>(_new_peak, (*itr)(_tid + 1));
             }
-            peak_num_threads += max_supported_threads;
+            if(_new_peak == std::numeric_limits<int64_t>::max())
+                _new_peak = _peak + max_supported_threads;
+
+            TIMEMORY_PRINTF_WARNING(stderr, "[%li] Grew thread data from %li to %li...\n",
+                                    _tid, _peak, _new_peak);
+            peak_num_threads.store(_new_peak, std::memory_order_release);
         }
     }
 
-    return peak_num_threads;
+    return peak_num_threads.load(std::memory_order_acquire);
 }
 
 bool
@@ -166,7 +319,7 @@ thread_info::exists()
 size_t
 thread_info::get_peak_num_threads()
 {
-    return peak_num_threads;
+    return peak_num_threads.load(std::memory_order_acquire);
 }
 
 const std::optional<thread_info>&
@@ -192,6 +345,8 @@ thread_info::init(bool _offset)
         _info->index_data     = init_index_data(_tid, _info->is_offset);
         _info->lifetime.first = tim::get_clock_real_now<uint64_t, std::nano>();
 
+        add_index_data(*_info->index_data);
+
         const auto _sequent_tid = _info->index_data->sequent_value;
         _info->causal_count     = (!_info->is_offset && _sequent_tid < peak_num_threads)
                                       ? &causal::delay::get_local(_sequent_tid)
@@ -223,35 +378,24 @@ thread_info::get(native_handle_t& _tid)
 const std::optional<thread_info>&
 thread_info::get(native_handle_t&& _tid)
 {
-    const auto& _v = get_info_data();
-    if(_v)
-    {
-        for(const auto& itr : *_v)
-        {
-            if(itr && itr->index_data &&
-               pthread_equal(itr->index_data->pthread_value, _tid) == 0)
-                return itr;
-        }
-    }
+    const auto& _v = find_info_data(
+        get_pthread_index_table(), _tid, [_tid](const thread_index_data& _data) {
+            return pthread_equal(_data.pthread_value, _tid) != 0;
+        });
 
     OMNITRACE_CI_THROW(unknown_thread, "Unknown thread has been assigned a value");
-    return unknown_thread;
+    return _v;
 }
 
 const std::optional<thread_info>&
 thread_info::get(std::thread::id _tid)
 {
-    const auto& _v = get_info_data();
-    if(_v)
-    {
-        for(const auto& itr : *_v)
-        {
-            if(itr && itr->index_data && itr->index_data->stl_value == _tid) return itr;
-        }
-    }
+    const auto& _v = find_info_data(
+        get_stl_index_table(), _tid,
+        [_tid](const thread_index_data& _data) { return _data.stl_value == _tid; });
 
     OMNITRACE_CI_THROW(unknown_thread, "Unknown thread has been assigned a value");
-    return unknown_thread;
+    return _v;
 }
 
 const std::optional<thread_info>&
@@ -261,27 +405,17 @@ thread_info::get(int64_t _tid, ThreadIdType _type)
         return get_info_data(_tid);
     else if(_type == ThreadIdType::SystemTID)
     {
-        const auto& _v = get_info_data();
-        if(_v)
-        {
-            for(const auto& itr : *_v)
-            {
-                if(itr && itr->index_data && itr->index_data->system_value == _tid)
-                    return itr;
-            }
-        }
+        return find_info_data(get_system_index_table(), _tid,
+                              [_tid](const thread_index_data& _data) {
+                                  return _data.system_value == _tid;
+                              });
     }
     else if(_type == ThreadIdType::SequentTID)
     {
-        const auto& _v = get_info_data();
-        if(_v)
-        {
-            for(const auto& itr : *_v)
-            {
-                if(itr && itr->index_data && itr->index_data->sequent_value == _tid)
-                    return itr;
-            }
-        }
+        return find_info_data(get_sequent_index_table(), _tid,
+                              [_tid](const thread_index_data& _data) {
+                                  return _data.sequent_value == _tid;
+                              });
     }
     else if(_type == ThreadIdType::PthreadID)
     {
@@ -0,0 +1,209 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/throttle.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "core/string_arena.hpp"
+#include "core/timemory.hpp"
+#include "library/thread_data.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/manager.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace throttle
+{
+namespace
+{
+struct entry
+{
+    uint64_t calls     = 0;  // calls since the beginning of the interval
+    uint64_t begin     = 0;  // beginning of the interval
+    uint64_t dropped   = 0;  // total number of throttled calls
+    uint64_t last      = 0;  // number of throttled calls when last throttled
+    int64_t  active    = 0;  // outstanding entries which were not throttled
+    int64_t  pending   = 0;  // outstanding entries which were throttled
+    bool     throttled = false;
+};
+
+struct throttle_data
+{};
+
+using throttle_map_t         = std::unordered_map<tim::hash_value_t, entry>;
+using throttle_thread_data_t = thread_data<throttle_map_t, throttle_data>;
+
+auto&
+get_throttle_map(int64_t _tid = tim::threading::get_id())
+{
+    return throttle_thread_data_t::instance(construct_on_thread{ _tid });
+}
+
+// the throttle events are rare so the label is interned to provide a static string
+const char*
+get_label(std::string_view _prefix, std::string_view _name)
+{
+    return intern_string(JOIN("", _prefix, _name));
+}
+
+void
+mark(std::string_view _prefix, std::string_view _name, uint64_t _dropped)
+{
+    if(!get_use_perfetto()) return;
+
+    tracing::mark_perfetto(category::host{}, get_label(_prefix, _name),
+                           [_dropped](::perfetto::EventContext ctx) {
+                               tracing::add_perfetto_annotation(ctx, "dropped",
+                                                                _dropped);
+                           });
+}
+}  // namespace
+
+bool
+push(std::string_view _name)
+{
+    // the settings are not read until the tooling is initialized
+    if(get_state() != State::Active) return false;
+
+    static const auto _threshold = config::get_throttle_calls();
+    if(_threshold == 0) return false;
+
+    static const auto _interval =
+        static_cast<uint64_t>(config::get_throttle_interval() * units::sec);
+    static const auto _resume = (config::get_throttle_mode() == "count");
+
+    auto& _data = get_throttle_map();
+    if(!_data) return false;
+
+    auto& _v = (*_data)[tim::hash::get_hash_id(_name)];
+
+    // the clock is only read once every <threshold> calls
+    if(++_v.calls >= _threshold)
+    {
+        auto _now = tracing::now();
+        auto _hot = (_now - _v.begin) < _interval;
+        _v.calls  = 0;
+        _v.begin  = _now;
+
+        if(_hot && !_v.throttled)
+        {
+            _v.throttled = true;
+            _v.last      = _v.dropped;
+            OMNITRACE_VERBOSE(2, "[throttle] throttling '%s' on thread %li...\n",
+                              _name.data(), tim::threading::get_id());
+            mark("throttled: ", _name, _v.dropped);
+        }
+        else if(!_hot && _v.throttled && _resume && _v.pending == 0)
+        {
+            // only resume when no throttled entry is outstanding so that, for
+            // recursive functions, the exits are matched to the correct entries
+            _v.throttled = false;
+            mark("unthrottled: ", _name, _v.dropped - _v.last);
+        }
+    }
+
+    if(_v.throttled)
+    {
+        ++_v.dropped;
+        ++_v.pending;
+        return true;
+    }
+
+    ++_v.active;
+    return false;
+}
+
+bool
+pop(std::string_view _name)
+{
+    if(get_state() != State::Active) return false;
+
+    static const auto _threshold = config::get_throttle_calls();
+    if(_threshold == 0) return false;
+
+    auto& _data = get_throttle_map();
+    if(!_data) return false;
+
+    auto itr = _data->find(tim::hash::get_hash_id(_name));
+    if(itr == _data->end()) return false;
+
+    auto& _v = itr->second;
+    if(_v.pending > 0)
+    {
+        --_v.pending;
+        return true;
+    }
+
+    if(_v.active > 0) --_v.active;
+    return false;
+}
+
+void
+post_process()
+{
+    auto _dropped = std::map<std::string, uint64_t>{};
+    for(size_t i = 0; i < throttle_thread_data_t::size(); ++i)
+    {
+        const auto& _data = throttle_thread_data_t::get()->at(i);
+        if(!_data) continue;
+
+        for(const auto& itr : *_data)
+        {
+            if(itr.second.dropped == 0) continue;
+            auto _name = tim::get_hash_identifier_fast(itr.first);
+            if(_name.empty()) continue;
+            _dropped[std::string{ _name }] += itr.second.dropped;
+        }
+    }
+
+    if(_dropped.empty()) return;
+
+    for(const auto& itr : _dropped)
+    {
+        OMNITRACE_VERBOSE(0, "[throttle] %-60s :: %zu calls were not recorded\n",
+                          itr.first.c_str(), static_cast<size_t>(itr.second));
+        if(get_use_perfetto())
+            tracing::mark_perfetto_track(
+                category::host{}, get_label("throttled calls: ", itr.first),
+                ::perfetto::ProcessTrack::Current(), tracing::now(),
+                [&itr](::perfetto::EventContext ctx) {
+                    tracing::add_perfetto_annotation(ctx, "dropped", itr.second);
+                });
+    }
+
+    tim::manager::instance()->add_metadata([_dropped](auto& ar) {
+        ar(tim::cereal::make_nvp("throttled_functions", _dropped));
+    });
+}
+}  // namespace throttle
+}  // namespace omnitrace
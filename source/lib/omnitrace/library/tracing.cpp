@@ -23,7 +23,9 @@
 #include "library/tracing.hpp"
 #include "core/concepts.hpp"
 #include "core/config.hpp"
+#include "core/locking.hpp"
 #include "core/state.hpp"
+#include "library/components/pthread_create_gotcha.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
 
@@ -69,6 +71,24 @@ get_perfetto_track_uuids()
     return _v;
 }
 
+bool
+add_perfetto_track_uuid(hash_value_t _uuid, const std::string& _name)
+{
+    // only taken the first time a thread uses a track so contention is low
+    static auto _mutex = locking::atomic_mutex{};
+    static auto _v     = std::unordered_map<hash_value_t, std::string>{};
+
+    auto _lk  = locking::atomic_lock{ _mutex };
+    auto _ret = _v.emplace(_uuid, _name);
+
+    OMNITRACE_CI_THROW(!_ret.second && _ret.first->second != _name,
+                       "Error! UUID %zu was registered with different descriptions: "
+                       "\"%s\" and \"%s\"\n",
+                       _uuid, _ret.first->second.c_str(), _name.c_str());
+
+    return _ret.second;
+}
+
 void
 copy_timemory_hash_ids()
 {
@@ -179,6 +199,9 @@ thread_init()
             << "no timemory hash aliases pointer for thread " << _tidx;
 
         record_thread_start_time();
+
+        // the setup of the thread which was deferred by the pthread_create wrapper
+        component::pthread_create_gotcha::lazy_setup();
         return true;
     }();
 
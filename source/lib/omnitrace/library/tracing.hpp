@@ -29,14 +29,20 @@
 #include "core/debug.hpp"
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
+#include "core/self_overhead.hpp"
 #include "core/state.hpp"
+#include "core/string_arena.hpp"
 #include "core/timemory.hpp"
 #include "core/utility.hpp"
 #include "library/causal/sampling.hpp"
+#include "library/control.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
 #include "library/tracing/annotation.hpp"
+#include "library/tracing/batch.hpp"
+#include "library/tracing/event_log.hpp"
+#include "library/tracing/iteration.hpp"
 
 #include <timemory/components/io/components.hpp>
 #include <timemory/components/network/types.hpp>
@@ -82,9 +88,15 @@ extern OMNITRACE_HIDDEN_API bool debug_pop;
 extern OMNITRACE_HIDDEN_API bool debug_user;
 extern OMNITRACE_HIDDEN_API bool debug_mark;
 
+// per-thread cache of the tracks which have been registered
 std::unordered_map<hash_value_t, std::string>&
 get_perfetto_track_uuids();
 
+// process-wide registry of the tracks. Returns true if this call registered the track
+// and, thus, the caller is responsible for setting the track descriptor
+bool
+add_perfetto_track_uuid(hash_value_t, const std::string&);
+
 void
 copy_timemory_hash_ids();
 
@@ -145,9 +157,9 @@ template <typename CategoryT, typename... Args>
 auto
 get_perfetto_category_uuid(Args&&... _args)
 {
-    return tim::hash::get_hash_id(
-        tim::hash::get_hash_id(JOIN('_', "omnitrace", trait::name<CategoryT>::value)),
-        std::forward<Args>(_args)...);
+    static const auto _category_hash =
+        tim::hash::get_hash_id(JOIN('_', "omnitrace", trait::name<CategoryT>::value));
+    return tim::hash::get_hash_id(_category_hash, std::forward<Args>(_args)...);
 }
 
 template <typename CategoryT, typename TrackT = ::perfetto::Track, typename FuncT,
@@ -155,35 +167,48 @@ template <typename CategoryT, typename TrackT = ::perfetto::Track, typename Func
 auto
 get_perfetto_track(CategoryT, FuncT&& _desc_generator, Args&&... _args)
 {
-    auto  _uuid = get_perfetto_category_uuid<CategoryT>(std::forward<Args>(_args)...);
-    auto& _track_uuids = get_perfetto_track_uuids();
-    if(_track_uuids.find(_uuid) == _track_uuids.end())
-    {
-        const auto _track = TrackT(_uuid, ::perfetto::ProcessTrack::Current());
-        auto       _desc  = _track.Serialize();
-
+    auto _register = [&](auto _uuid) {
         auto _name = std::forward<FuncT>(_desc_generator)(std::forward<Args>(_args)...);
-        _desc.set_name(_name);
-        ::perfetto::TrackEvent::SetTrackDescriptor(_track, _desc);
-
-        OMNITRACE_VERBOSE_F(4, "[%s] Created %s(%zu) with description: \"%s\"\n",
-                            trait::name<CategoryT>::value, demangle<TrackT>().c_str(),
-                            _uuid, _name.c_str());
+        if(add_perfetto_track_uuid(_uuid, _name))
+        {
+            const auto _track = TrackT(_uuid, ::perfetto::ProcessTrack::Current());
+            auto       _desc  = _track.Serialize();
+            _desc.set_name(_name);
+            ::perfetto::TrackEvent::SetTrackDescriptor(_track, _desc);
+
+            OMNITRACE_VERBOSE_F(4, "[%s] Created %s(%zu) with description: \"%s\"\n",
+                                trait::name<CategoryT>::value,
+                                demangle<TrackT>().c_str(), _uuid, _name.c_str());
+        }
+        get_perfetto_track_uuids().emplace(_uuid, std::move(_name));
+    };
 
-        _track_uuids.emplace(_uuid, _name);
+    // tracks which only depend on the category are resolved once per thread
+    if constexpr(sizeof...(Args) == 0)
+    {
+        static const auto        _uuid       = get_perfetto_category_uuid<CategoryT>();
+        static thread_local bool _registered = (_register(_uuid), true);
+        (void) _registered;
+        return TrackT(_uuid, ::perfetto::ProcessTrack::Current());
     }
+    else
+    {
+        auto  _uuid = get_perfetto_category_uuid<CategoryT>(std::forward<Args>(_args)...);
+        auto& _track_uuids = get_perfetto_track_uuids();
+        if(_track_uuids.find(_uuid) == _track_uuids.end()) _register(_uuid);
 
-    // guard this with ppdefs in addition to runtime check to avoid
-    // overhead of generating string during releases
+        // guard this with ppdefs in addition to runtime check to avoid
+        // overhead of generating string during releases
 #if defined(OMNITRACE_CI) && OMNITRACE_CI > 0
-    auto _name = std::forward<FuncT>(_desc_generator)(std::forward<Args>(_args)...);
-    OMNITRACE_CI_THROW(_track_uuids.at(_uuid) != _name,
-                       "Error! Multiple invocations of UUID %zu produced different "
-                       "descriptions: \"%s\" and \"%s\"\n",
-                       _uuid, _track_uuids.at(_uuid).c_str(), _name.c_str());
+        auto _name = std::forward<FuncT>(_desc_generator)(std::forward<Args>(_args)...);
+        OMNITRACE_CI_THROW(_track_uuids.at(_uuid) != _name,
+                           "Error! Multiple invocations of UUID %zu produced different "
+                           "descriptions: \"%s\" and \"%s\"\n",
+                           _uuid, _track_uuids.at(_uuid).c_str(), _name.c_str());
 #endif
 
-    return TrackT(_uuid, ::perfetto::ProcessTrack::Current());
+        return TrackT(_uuid, ::perfetto::ProcessTrack::Current());
+    }
 }
 
 template <typename Tp = uint64_t>
@@ -199,17 +224,19 @@ get_instrumentation_bundles(int64_t _tid = threading::get_id())
     return instrumentation_bundles::instance(construct_on_thread{ _tid });
 }
 
+// incremented by every thread for every region so the threads increment their own
+// cache line
 inline auto&
 push_count()
 {
-    static std::atomic<size_t> _v{ 0 };
+    static auto _v = thread_counter<size_t>{};
     return _v;
 }
 
 inline auto&
 pop_count()
 {
-    static std::atomic<size_t> _v{ 0 };
+    static auto _v = thread_counter<size_t>{};
     return _v;
 }
 
@@ -241,47 +268,113 @@ get_profile_stack()
     return get_category_stack<CategoryT>().profile;
 }
 
+// an override from the control file (OMNITRACE_CONTROL_FILE) takes precedence over the
+// runtime state of the category
 template <typename CategoryT>
-auto
+bool
+category_enabled()
+{
+    switch(control::get_category_state(category_enum_id<CategoryT>::value))
+    {
+        case control_block::category_on: return true;
+        case control_block::category_off: return false;
+        default: break;
+    }
+    return trait::runtime_enabled<CategoryT>::get();
+}
+
+template <typename CategoryT>
+bool
 category_push_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get();
+    if constexpr(!categories::is_compiled<CategoryT>()) return true;
+    return !category_enabled<CategoryT>();
 }
 
 template <typename CategoryT>
-auto
+bool
 category_mark_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get();
+    if constexpr(!categories::is_compiled<CategoryT>()) return true;
+    return !category_enabled<CategoryT>();
 }
 
 template <typename CategoryT>
-auto
+bool
 category_pop_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get() &&
+    if constexpr(!categories::is_compiled<CategoryT>()) return true;
+    return !category_enabled<CategoryT>() &&
            (get_profile_stack<CategoryT>() + get_tracing_stack<CategoryT>()) <= 0;
 }
 
 template <typename CategoryT>
-auto
+bool
 tracing_pop_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get() &&
-           get_tracing_stack<CategoryT>() <= 0;
+    if constexpr(!categories::is_compiled<CategoryT>()) return true;
+    return !category_enabled<CategoryT>() && get_tracing_stack<CategoryT>() <= 0;
 }
 
 template <typename CategoryT>
-auto
+bool
 profile_pop_disabled()
 {
-    return !trait::runtime_enabled<CategoryT>::get() &&
-           get_profile_stack<CategoryT>() <= 0;
+    if constexpr(!categories::is_compiled<CategoryT>()) return true;
+    return !category_enabled<CategoryT>() && get_profile_stack<CategoryT>() <= 0;
+}
+
+// OMNITRACE_SELF_OVERHEAD_CORRECTION: the self-overhead of the thread when each bundle
+// was started. A bundle which was destroyed without being stopped leaves a stale entry
+// which is replaced if the allocator reuses the address
+inline auto&
+get_self_overhead_snapshots()
+{
+    using value_type = std::pair<instrumentation_bundle_t*, self_overhead::snapshot>;
+    static thread_local auto _v = std::vector<value_type>{};
+    return _v;
+}
+
+inline void
+record_self_overhead(instrumentation_bundle_t* _bundle)
+{
+    auto& _snapshots = get_self_overhead_snapshots();
+    for(auto& itr : _snapshots)
+    {
+        if(itr.first == _bundle)
+        {
+            itr.second = self_overhead::get_snapshot();
+            return;
+        }
+    }
+    _snapshots.emplace_back(_bundle, self_overhead::get_snapshot());
 }
 
+// the start of the wall-clock is moved forward by the time spent inside omnitrace
+// since the bundle was started so that it is excluded from the elapsed time
+inline void
+correct_self_overhead(instrumentation_bundle_t* _bundle)
+{
+    auto& _snapshots = get_self_overhead_snapshots();
+    for(auto itr = _snapshots.rbegin(); itr != _snapshots.rend(); ++itr)
+    {
+        if(itr->first != _bundle) continue;
+        auto* _wc = _bundle->get<comp::wall_clock>();
+        if(_wc)
+        {
+            auto _nsec = self_overhead::get_elapsed_nsec(itr->second);
+            _wc->set_value(_wc->get_value() + static_cast<int64_t>(_nsec));
+        }
+        _snapshots.erase(std::next(itr).base());
+        return;
+    }
+}
+
+// the hash_value_t overloads expect the hash to have already been added via
+// tim::add_hash_id
 template <typename CategoryT, typename... Args>
 inline void
-push_timemory(CategoryT, std::string_view name, Args&&... args)
+push_timemory(CategoryT, hash_value_t _hash, Args&&... args)
 {
     // skip if category is disabled
     if(category_push_disabled<CategoryT>()) return;
@@ -289,28 +382,39 @@ push_timemory(CategoryT, std::string_view name, Args&&... args)
     auto& _data = tracing::get_instrumentation_bundles();
     if(OMNITRACE_LIKELY(_data != nullptr))
     {
-        // this generates a hash for the raw string array
-        auto _hash = tim::add_hash_id(name);
-        _data->construct(_hash)->start(std::forward<Args>(args)...);
+        auto* _bundle = _data->construct(_hash);
+        _bundle->start(std::forward<Args>(args)...);
+        if(OMNITRACE_UNLIKELY(self_overhead::is_correction_enabled()))
+            record_self_overhead(_bundle);
         // increment the profile stack
         ++get_profile_stack<CategoryT>();
     }
 }
 
+template <typename CategoryT, typename... Args>
+inline void
+push_timemory(CategoryT, std::string_view name, Args&&... args)
+{
+    // skip if category is disabled
+    if(category_push_disabled<CategoryT>()) return;
+
+    // this generates a hash for the raw string array
+    push_timemory(CategoryT{}, tim::add_hash_id(name), std::forward<Args>(args)...);
+}
+
 template <typename CategoryT>
 inline std::pair<instrumentation_bundle_t*, size_t>
-get_timemory(CategoryT, std::string_view name)
+get_timemory(CategoryT, hash_value_t _hash)
 {
     using return_type = std::pair<instrumentation_bundle_t*, size_t>;
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
 
-    auto  _hash = tim::hash::get_hash_id(name);
     auto& _data = tracing::get_instrumentation_bundles();
     if(OMNITRACE_UNLIKELY(_data == nullptr || _data->empty()))
     {
         OMNITRACE_DEBUG("[%s] skipped %s :: empty bundle stack\n", "omnitrace_pop_trace",
-                        name.data());
+                        tim::get_hash_identifier_fast(_hash));
         return return_type{ nullptr, -1 };
     }
 
@@ -334,18 +438,31 @@ get_timemory(CategoryT, std::string_view name)
     return return_type{ nullptr, -1 };
 }
 
-template <typename CategoryT, typename... Args>
+template <typename CategoryT>
+inline std::pair<instrumentation_bundle_t*, size_t>
+get_timemory(CategoryT, std::string_view name)
+{
+    using return_type = std::pair<instrumentation_bundle_t*, size_t>;
+    // skip if category is disabled and not pushed on this thread
+    if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
+
+    return get_timemory(CategoryT{}, tim::hash::get_hash_id(name));
+}
+
+template <typename CategoryT, typename NameT, typename... Args>
 inline auto
-stop_timemory(CategoryT, std::string_view name, Args&&... args)
+stop_timemory(CategoryT, NameT&& name, Args&&... args)
 {
     using return_type = std::pair<instrumentation_bundle_t*, size_t>;
 
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return return_type{ nullptr, -1 };
 
-    auto&& _data = get_timemory(CategoryT{}, name);
+    auto&& _data = get_timemory(CategoryT{}, std::forward<NameT>(name));
     if(_data.first)
     {
+        if(OMNITRACE_UNLIKELY(self_overhead::is_correction_enabled()))
+            correct_self_overhead(_data.first);
         _data.first->stop(std::forward<Args>(args)...);
     }
     return _data;
@@ -362,14 +479,15 @@ destroy_timemory(std::pair<instrumentation_bundle_t*, size_t> _data)
     }
 }
 
-template <typename CategoryT, typename... Args>
+template <typename CategoryT, typename NameT, typename... Args>
 inline void
-pop_timemory(CategoryT, std::string_view name, Args&&... args)
+pop_timemory(CategoryT, NameT&& name, Args&&... args)
 {
     // skip if category is disabled and not pushed on this thread
     if(profile_pop_disabled<CategoryT>()) return;
 
-    auto _data = stop_timemory(CategoryT{}, name, std::forward<Args>(args)...);
+    auto _data = stop_timemory(CategoryT{}, std::forward<NameT>(name),
+                               std::forward<Args>(args)...);
     if(_data.first) destroy_timemory(std::move(_data));
 }
 
@@ -384,19 +502,12 @@ push_perfetto(CategoryT, const char* name, Args&&... args)
                  std::is_invocable<Args..., ::perfetto::EventContext>::value)
     {
         ++get_tracing_stack<CategoryT>();
-        uint64_t _ts = now();
-        if(config::get_perfetto_annotations())
-        {
-            TRACE_EVENT_BEGIN(trait::name<CategoryT>::value,
-                              ::perfetto::StaticString(name), _ts, "begin_ns", _ts,
-                              std::forward<Args>(args)...);
-        }
-        else
-        {
-            TRACE_EVENT_BEGIN(trait::name<CategoryT>::value,
-                              ::perfetto::StaticString(name), _ts,
-                              std::forward<Args>(args)...);
-        }
+        auto _ts = now();
+        if(OMNITRACE_UNLIKELY(iteration::is_enabled()) &&
+           iteration::push<CategoryT>(name, _ts))
+            return;
+        TRACE_EVENT_BEGIN(trait::name<CategoryT>::value, ::perfetto::StaticString(name),
+                          _ts, std::forward<Args>(args)...);
     }
     else
     {
@@ -416,15 +527,19 @@ push_perfetto(CategoryT, const char* name, Args&&... args)
         else
         {
             ++get_tracing_stack<CategoryT>();
-            uint64_t _ts = now();
-            TRACE_EVENT_BEGIN(
-                trait::name<CategoryT>::value, ::perfetto::StaticString(name), _ts,
-                std::forward<Args>(args)..., [&](::perfetto::EventContext ctx) {
-                    if(config::get_perfetto_annotations())
-                    {
-                        tracing::add_perfetto_annotation(ctx, "begin_ns", _ts);
-                    }
-                });
+            auto _ts = now();
+            if(OMNITRACE_UNLIKELY(iteration::is_enabled()) &&
+               iteration::push<CategoryT>(name, _ts))
+                return;
+            if constexpr(sizeof...(Args) == 0)
+            {
+                if(OMNITRACE_UNLIKELY(batch::is_enabled()) &&
+                   batch::push<CategoryT>(name, _ts))
+                    return;
+            }
+            TRACE_EVENT_BEGIN(trait::name<CategoryT>::value,
+                              ::perfetto::StaticString(name), _ts,
+                              std::forward<Args>(args)...);
         }
     }
 }
@@ -439,7 +554,7 @@ perfetto_annotate_timemory_data(CategoryT, const char* name, Arg&& arg)
     if constexpr(std::is_invocable<Arg, ::perfetto::EventContext>::value)
     {
         return [&arg, name](::perfetto::EventContext _ctx) {
-            if(config::get_perfetto_annotations())
+            if(config::get_snapshot().perfetto_annotations)
             {
                 auto _timemory_data = get_timemory(CategoryT{}, name);
                 if(_timemory_data.first)
@@ -471,18 +586,13 @@ pop_perfetto(CategoryT, const char* name, Args&&... args)
     {
         // decrement tracing stack
         --get_tracing_stack<CategoryT>();
-        uint64_t _ts = now();
-        if(config::get_perfetto_annotations())
-        {
-            TRACE_EVENT_END(trait::name<CategoryT>::value, _ts, "end_ns", _ts,
-                            perfetto_annotate_timemory_data(CategoryT{}, name,
-                                                            std::forward<Args>(args))...);
-        }
-        else
-        {
-            TRACE_EVENT_END(trait::name<CategoryT>::value, _ts,
-                            std::forward<Args>(args)...);
-        }
+        auto _ts = now();
+        if(OMNITRACE_UNLIKELY(iteration::is_enabled()) &&
+           iteration::pop<CategoryT>(name, _ts))
+            return;
+        TRACE_EVENT_END(trait::name<CategoryT>::value, _ts,
+                        perfetto_annotate_timemory_data(CategoryT{}, name,
+                                                        std::forward<Args>(args))...);
     }
     else
     {
@@ -503,16 +613,20 @@ pop_perfetto(CategoryT, const char* name, Args&&... args)
         {
             // decrement tracing stack
             --get_tracing_stack<CategoryT>();
-            uint64_t _ts = now();
-            TRACE_EVENT_END(
-                trait::name<CategoryT>::value, _ts, std::forward<Args>(args)...,
-                perfetto_annotate_timemory_data(
-                    CategoryT{}, name, [&](::perfetto::EventContext ctx) {
-                        if(config::get_perfetto_annotations())
-                        {
-                            tracing::add_perfetto_annotation(ctx, "end_ns", _ts);
-                        }
-                    }));
+            auto _ts = now();
+            if(OMNITRACE_UNLIKELY(iteration::is_enabled()) &&
+               iteration::pop<CategoryT>(name, _ts))
+                return;
+            if constexpr(sizeof...(Args) == 0)
+            {
+                if(OMNITRACE_UNLIKELY(batch::is_enabled()) &&
+                   batch::pop<CategoryT>(name, _ts))
+                    return;
+            }
+            TRACE_EVENT_END(trait::name<CategoryT>::value, _ts,
+                            std::forward<Args>(args)...,
+                            perfetto_annotate_timemory_data(
+                                CategoryT{}, name, [](::perfetto::EventContext) {}));
         }
     }
 
@@ -527,6 +641,14 @@ push_perfetto_ts(CategoryT, const char* name, uint64_t _ts, Args&&... args)
     if(category_push_disabled<CategoryT>()) return;
 
     ++get_tracing_stack<CategoryT>();
+    if(OMNITRACE_UNLIKELY(iteration::is_enabled()) &&
+       iteration::push<CategoryT>(name, _ts))
+        return;
+    if constexpr(sizeof...(Args) == 0)
+    {
+        if(OMNITRACE_UNLIKELY(batch::is_enabled()) && batch::push<CategoryT>(name, _ts))
+            return;
+    }
     TRACE_EVENT_BEGIN(trait::name<CategoryT>::value, ::perfetto::StaticString(name), _ts,
                       std::forward<Args>(args)...);
 }
@@ -541,6 +663,16 @@ pop_perfetto_ts(CategoryT, const char* name, uint64_t _ts, Args&&... args)
     // decrement tracing stack
     --get_tracing_stack<CategoryT>();
 
+    if(OMNITRACE_UNLIKELY(iteration::is_enabled()) &&
+       iteration::pop<CategoryT>(name, _ts))
+        return;
+
+    if constexpr(sizeof...(Args) == 0)
+    {
+        if(OMNITRACE_UNLIKELY(batch::is_enabled()) && batch::pop<CategoryT>(name, _ts))
+            return;
+    }
+
     TRACE_EVENT_END(
         trait::name<CategoryT>::value, _ts,
         perfetto_annotate_timemory_data(CategoryT{}, name, std::forward<Args>(args))...);
@@ -585,19 +717,8 @@ mark_perfetto(CategoryT, const char* name, Args&&... args)
     if constexpr(sizeof...(Args) == 1 &&
                  std::is_invocable<Args..., ::perfetto::EventContext>::value)
     {
-        uint64_t _ts = now();
-        if(config::get_perfetto_annotations())
-        {
-            TRACE_EVENT_INSTANT(trait::name<CategoryT>::value,
-                                ::perfetto::StaticString(name), _ts, "ns", _ts,
-                                std::forward<Args>(args)...);
-        }
-        else
-        {
-            TRACE_EVENT_INSTANT(trait::name<CategoryT>::value,
-                                ::perfetto::StaticString(name), _ts,
-                                std::forward<Args>(args)...);
-        }
+        TRACE_EVENT_INSTANT(trait::name<CategoryT>::value, ::perfetto::StaticString(name),
+                            now(), std::forward<Args>(args)...);
     }
     else
     {
@@ -616,15 +737,9 @@ mark_perfetto(CategoryT, const char* name, Args&&... args)
         }
         else
         {
-            uint64_t _ts = now();
-            TRACE_EVENT_INSTANT(
-                trait::name<CategoryT>::value, ::perfetto::StaticString(name), _ts,
-                std::forward<Args>(args)..., [&](::perfetto::EventContext ctx) {
-                    if(config::get_perfetto_annotations())
-                    {
-                        tracing::add_perfetto_annotation(ctx, "ns", _ts);
-                    }
-                });
+            TRACE_EVENT_INSTANT(trait::name<CategoryT>::value,
+                                ::perfetto::StaticString(name), now(),
+                                std::forward<Args>(args)...);
         }
     }
 }
@@ -648,8 +763,11 @@ mark_perfetto_track(CategoryT, const char* name, ::perfetto::Track _track, uint6
     // skip if category is disabled
     if(category_mark_disabled<CategoryT>()) return;
 
-    TRACE_EVENT_INSTANT(trait::name<CategoryT>::value, ::perfetto::DynamicString{ name },
-                        _track, _ts, std::forward<Args>(args)...);
+    // the name may be a temporary so it is mapped to the string_arena to have a stable
+    // pointer which perfetto can intern like the other event names
+    TRACE_EVENT_INSTANT(trait::name<CategoryT>::value,
+                        ::perfetto::StaticString{ intern_string(name) }, _track, _ts,
+                        std::forward<Args>(args)...);
 }
 }  // namespace tracing
 }  // namespace omnitrace
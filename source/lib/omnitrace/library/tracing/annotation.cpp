@@ -22,6 +22,9 @@
 
 #include "library/tracing/annotation.hpp"
 
+#include <array>
+#include <cstring>
+
 namespace omnitrace
 {
 namespace tracing
@@ -33,5 +36,120 @@ add_perfetto_annotation(perfetto_event_context_t&     ctx,
     add_perfetto_annotation(
         ctx, _annotation, utility::make_index_sequence_range<1, OMNITRACE_VALUE_LAST>{});
 }
+
+namespace
+{
+template <size_t Idx>
+auto
+read_annotation_field(const void* _data)
+{
+    // the packed value struct is not required to be aligned
+    auto _value = annotation_value_type_t<Idx>{};
+    std::memcpy(&_value, _data, sizeof(_value));
+    return _value;
+}
+
+template <size_t Idx>
+void
+emit_annotation_field(perfetto_event_context_t& ctx, const char* _name,
+                      const void* _data)
+{
+    using type = annotation_value_type_t<Idx>;
+
+    auto  _value = read_annotation_field<Idx>(_data);
+    auto* _dbg   = ctx.event()->add_debug_annotations();
+    // the name was interned when the schema was registered
+    _dbg->set_name_iid(
+        ::perfetto::internal::InternedDebugAnnotationName::Get(&ctx, _name));
+
+    if constexpr(std::is_same<type, const char*>::value)
+        _dbg->set_string_value((_value) ? _value : "");
+    else if constexpr(std::is_pointer<type>::value)
+        _dbg->set_pointer_value(reinterpret_cast<uint64_t>(_value));
+    else if constexpr(std::is_floating_point<type>::value)
+        _dbg->set_double_value(static_cast<double>(_value));
+    else if constexpr(std::is_unsigned<type>::value)
+        _dbg->set_uint_value(_value);
+    else
+        _dbg->set_int_value(_value);
+}
+
+template <size_t... Idx>
+auto
+get_annotation_field_emitters(std::index_sequence<Idx...>)
+{
+    auto _v = std::array<annotation_field::emit_func_t, OMNITRACE_VALUE_LAST>{};
+    ((_v[Idx] = &emit_annotation_field<Idx>), ...);
+    return _v;
+}
+
+template <size_t Idx, size_t... Tail>
+bool
+get_annotation_field_value(uintptr_t _type, const void* _data, double& _value,
+                           std::index_sequence<Idx, Tail...>)
+{
+    using type = annotation_value_type_t<Idx>;
+    if(_type == Idx)
+    {
+        if constexpr(std::is_arithmetic<type>::value)
+        {
+            _value = static_cast<double>(read_annotation_field<Idx>(_data));
+            return true;
+        }
+        return false;
+    }
+
+    if constexpr(sizeof...(Tail) > 0)
+        return get_annotation_field_value(_type, _data, _value,
+                                          std::index_sequence<Tail...>{});
+    return false;
+}
+}  // namespace
+
+annotation_field
+make_annotation_field(const omnitrace_annotation_field_t& _field)
+{
+    static const auto _emitters = get_annotation_field_emitters(
+        utility::make_index_sequence_range<1, OMNITRACE_VALUE_LAST>{});
+
+    OMNITRACE_CONDITIONAL_THROW(!_field.name || strlen(_field.name) == 0,
+                                "Error! annotation schema field without a name\n");
+
+    OMNITRACE_CONDITIONAL_THROW(
+        !(_field.type > OMNITRACE_VALUE_NONE && _field.type < OMNITRACE_VALUE_LAST),
+        "Error! annotation schema field '%s' has an invalid type designation %lu which "
+        "is outside of acceptable range [%i, %i]\n",
+        _field.name, static_cast<unsigned long>(_field.type), OMNITRACE_VALUE_NONE + 1,
+        OMNITRACE_VALUE_LAST - 1);
+
+    return annotation_field{ intern_string(_field.name), _field.type, _field.offset,
+                             _emitters.at(_field.type) };
+}
+
+bool
+get_annotation_field_value(const annotation_field& _field, const void* _values,
+                           double& _value)
+{
+    return get_annotation_field_value(
+        _field.type, static_cast<const char*>(_values) + _field.offset, _value,
+        utility::make_index_sequence_range<1, OMNITRACE_VALUE_LAST>{});
+}
+
+void
+source_location_index::Add(::perfetto::protos::pbzero::InternedData* _data, size_t _iid,
+                           const source_location& _v)
+{
+    auto* _loc = _data->add_source_locations();
+    _loc->set_iid(_iid);
+    if(_v.function) _loc->set_function_name(_v.function);
+    if(_v.file) _loc->set_file_name(_v.file);
+    if(_v.line > 0) _loc->set_line_number(_v.line);
+}
+
+void
+add_perfetto_source_location(perfetto_event_context_t& ctx, const source_location& _v)
+{
+    ctx.event()->set_source_location_iid(source_location_index::Get(&ctx, _v));
+}
 }  // namespace tracing
 }  // namespace omnitrace
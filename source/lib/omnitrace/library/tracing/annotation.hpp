@@ -28,13 +28,19 @@
 #include "core/defines.hpp"
 #include "core/perfetto.hpp"
 #include "core/state.hpp"
+#include "core/string_arena.hpp"
 #include "core/utility.hpp"
 #include "omnitrace/categories.h"  // in omnitrace-user
 
 #include <timemory/mpl/concepts.hpp>
 #include <timemory/operations/types/get.hpp>
 
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
 namespace omnitrace
 {
@@ -69,6 +75,70 @@ OMNITRACE_DEFINE_ANNOTATION_TYPE(OMNITRACE_VALUE_VOID_P, void*)
 
 #undef OMNITRACE_DEFINE_ANNOTATION_TYPE
 
+// function, file, and line of a call-stack frame. The strings must remain valid for the
+// life of the process (e.g. interned in the string_arena)
+struct source_location
+{
+    const char* function = nullptr;
+    const char* file     = nullptr;
+    uint32_t    line     = 0;
+
+    bool operator==(const source_location& _v) const
+    {
+        return std::tie(function, file, line) == std::tie(_v.function, _v.file, _v.line);
+    }
+
+    bool operator<(const source_location& _v) const
+    {
+        return std::tie(function, file, line) < std::tie(_v.function, _v.file, _v.line);
+    }
+};
+}  // namespace tracing
+}  // namespace omnitrace
+
+namespace std
+{
+template <>
+struct hash<::omnitrace::tracing::source_location>
+{
+    size_t operator()(const ::omnitrace::tracing::source_location& _v) const
+    {
+        auto _hash = hash<const void*>{};
+        return _hash(_v.function) ^ (_hash(_v.file) << 1) ^ (size_t{ _v.line } << 2);
+    }
+};
+}  // namespace std
+
+namespace omnitrace
+{
+namespace tracing
+{
+// the source locations are written to the interned data of the trace sequence once
+// and the events only reference them by id
+struct source_location_index
+: ::perfetto::TrackEventInternedDataIndex<
+      source_location_index,
+      ::perfetto::protos::pbzero::InternedData::kSourceLocationsFieldNumber,
+      source_location>
+{
+    static void Add(::perfetto::protos::pbzero::InternedData*, size_t,
+                    const source_location&);
+};
+
+void
+add_perfetto_source_location(perfetto_event_context_t&, const source_location&);
+
+// the debug annotation names are interned: the name is written to the trace sequence
+// once and every subsequent annotation only references it by id. Perfetto keys the
+// interned names by pointer so the name is first mapped to the string_arena, which
+// returns the same pointer for equal strings
+inline size_t
+get_perfetto_annotation_name_iid(perfetto_event_context_t& ctx, std::string_view _name)
+{
+    return ::perfetto::internal::InternedDebugAnnotationName::Get(&ctx,
+                                                                  intern_string(_name));
+}
+
 template <typename Np, typename Tp>
 auto
 add_perfetto_annotation(
@@ -89,11 +159,12 @@ add_perfetto_annotation(
         if(_idx >= 0)
         {
             auto _arg_name = JOIN("", "arg", _idx, "-", std::forward<Np>(_name));
-            _dbg->set_name(_arg_name);
+            _dbg->set_name_iid(get_perfetto_annotation_name_iid(ctx, _arg_name));
         }
         else
         {
-            _dbg->set_name(std::string_view{ std::forward<Np>(_name) }.data());
+            _dbg->set_name_iid(get_perfetto_annotation_name_iid(
+                ctx, std::string_view{ std::forward<Np>(_name) }));
         }
         return _dbg;
     };
@@ -205,6 +276,50 @@ add_perfetto_annotation(perfetto_event_context_t&     ctx,
 void
 add_perfetto_annotation(perfetto_event_context_t&     ctx,
                         const omnitrace_annotation_t& _annotation);
+
+// a field of a registered annotation schema. The type is resolved to the function
+// which writes the debug annotation when the schema is registered and the name is
+// interned so that the per-event cost is one call per field
+struct annotation_field
+{
+    using emit_func_t = void (*)(perfetto_event_context_t&, const char*, const void*);
+
+    const char* name   = nullptr;
+    uintptr_t   type   = OMNITRACE_VALUE_NONE;
+    size_t      offset = 0;
+    emit_func_t emit   = nullptr;
+};
+
+// returns the field with the emit function or throws if the type is invalid
+annotation_field
+make_annotation_field(const omnitrace_annotation_field_t&);
+
+// reads the value of the field from the packed value struct as a double for the
+// timemory data trackers. Returns false for strings and pointers
+bool
+get_annotation_field_value(const annotation_field&, const void*, double&);
+}  // namespace tracing
+}  // namespace omnitrace
+
+// definition of the opaque omnitrace_annotation_schema_t. Instances are created by
+// omnitrace_register_annotation_schema and are never destroyed
+struct omnitrace_annotation_schema
+{
+    std::vector<::omnitrace::tracing::annotation_field> fields = {};
+};
+
+namespace omnitrace
+{
+namespace tracing
+{
+inline void
+add_perfetto_annotation(perfetto_event_context_t&          ctx,
+                        const omnitrace_annotation_schema& _schema, const void* _values)
+{
+    const auto* _data = static_cast<const char*>(_values);
+    for(const auto& itr : _schema.fields)
+        (*itr.emit)(ctx, itr.name, _data + itr.offset);
+}
 }  // namespace tracing
 }  // namespace omnitrace
 
@@ -0,0 +1,262 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/tracing/batch.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/state.hpp"
+#include "library/runtime.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace tracing
+{
+namespace batch
+{
+namespace
+{
+// when this many full buffers are waiting for the background thread, the instrumented
+// threads write their own events so that the memory of the pending events is bounded
+constexpr size_t max_pending = 64;
+
+using event_buffer_t = std::vector<event>;
+
+struct thread_buffer
+{
+    std::mutex     mutex   = {};
+    int64_t        sys_tid = 0;
+    event_buffer_t events  = {};
+};
+
+struct batch_state
+{
+    std::mutex                                     mutex    = {};
+    std::condition_variable                        cv       = {};
+    bool                                           running  = false;
+    size_t                                         capacity = 0;
+    size_t                                         events   = 0;
+    size_t                                         batches  = 0;
+    size_t                                         inlined  = 0;
+    std::deque<std::pair<int64_t, event_buffer_t>> pending  = {};
+    std::vector<event_buffer_t>                    unused   = {};
+    std::vector<std::shared_ptr<thread_buffer>>    buffers  = {};
+    std::unique_ptr<std::thread>                   thread   = {};
+};
+
+auto&
+get_state()
+{
+    static auto* _v = new batch_state{};
+    return *_v;
+}
+
+thread_buffer&
+get_thread_buffer()
+{
+    static thread_local auto _v = []() {
+        auto& _state     = get_state();
+        auto  _buffer    = std::make_shared<thread_buffer>();
+        _buffer->sys_tid = threading::get_sys_tid();
+        _buffer->events.reserve(_state.capacity);
+        auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+        _state.buffers.emplace_back(_buffer);
+        return _buffer;
+    }();
+    return *_v;
+}
+
+void
+write(int64_t _sys_tid, const event_buffer_t& _events)
+{
+    auto _track = ::perfetto::ThreadTrack::ForThread(_sys_tid);
+    for(const auto& itr : _events)
+        itr.emit(itr, _track);
+}
+
+// invoked with the lock of the buffer held
+void
+submit(thread_buffer& _buffer)
+{
+    auto& _state = get_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+
+    _state.events += _buffer.events.size();
+    ++_state.batches;
+
+    if(!_state.running || _state.pending.size() >= max_pending)
+    {
+        ++_state.inlined;
+        _lk.unlock();
+        write(_buffer.sys_tid, _buffer.events);
+        _buffer.events.clear();
+        return;
+    }
+
+    // swap in a buffer which has been written by the background thread
+    auto _events = event_buffer_t{};
+    if(!_state.unused.empty())
+    {
+        _events = std::move(_state.unused.back());
+        _state.unused.pop_back();
+    }
+    else
+    {
+        _events.reserve(_state.capacity);
+    }
+
+    std::swap(_events, _buffer.events);
+    _state.pending.emplace_back(_buffer.sys_tid, std::move(_events));
+    _lk.unlock();
+    _state.cv.notify_one();
+}
+
+void
+run()
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.batch");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    auto& _state = get_state();
+    auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+    while(true)
+    {
+        _state.cv.wait(
+            _lk, [&_state]() { return !_state.running || !_state.pending.empty(); });
+
+        // the pending batches are always written before the thread exits
+        if(_state.pending.empty()) break;
+
+        auto _batch = std::move(_state.pending.front());
+        _state.pending.pop_front();
+
+        _lk.unlock();
+        write(_batch.first, _batch.second);
+        _batch.second.clear();
+        _lk.lock();
+
+        _state.unused.emplace_back(std::move(_batch.second));
+    }
+}
+}  // namespace
+
+std::atomic<bool>&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+void
+setup()
+{
+    auto _capacity = config::get_perfetto_batch_size();
+    if(_capacity == 0 || !get_use_perfetto()) return;
+
+    auto& _state    = get_state();
+    _state.capacity = _capacity;
+    _state.running  = true;
+
+    {
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        _state.thread = std::make_unique<std::thread>(&run);
+    }
+
+    OMNITRACE_VERBOSE(1, "[batch] buffering up to %zu perfetto events per thread...\n",
+                      _capacity);
+
+    get_enabled().store(true);
+}
+
+void
+shutdown()
+{
+    if(!is_enabled()) return;
+
+    // events appended after this point are written directly
+    get_enabled().store(false);
+
+    auto& _state = get_state();
+    {
+        auto _lk       = std::unique_lock<std::mutex>{ _state.mutex };
+        _state.running = false;
+    }
+    _state.cv.notify_all();
+
+    if(_state.thread)
+    {
+        _state.thread->join();
+        _state.thread.reset();
+    }
+
+    // the lock of a buffer is acquired before the lock of the state in append so the
+    // buffers are copied to avoid holding both in the opposite order
+    auto _buffers = std::vector<std::shared_ptr<thread_buffer>>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+        _buffers = _state.buffers;
+    }
+
+    size_t _remaining = 0;
+    for(auto& itr : _buffers)
+    {
+        auto _lk = std::unique_lock<std::mutex>{ itr->mutex };
+        write(itr->sys_tid, itr->events);
+        _remaining += itr->events.size();
+        itr->events.clear();
+    }
+
+    auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+    OMNITRACE_VERBOSE(1,
+                      "[batch] wrote %zu perfetto events in %zu batches (%zu written by "
+                      "the instrumented threads) and %zu events at finalization\n",
+                      _state.events, _state.batches, _state.inlined, _remaining);
+    _state.unused.clear();
+}
+
+bool
+append(event&& _ev)
+{
+    auto& _buffer = get_thread_buffer();
+    auto  _lk     = std::unique_lock<std::mutex>{ _buffer.mutex };
+
+    // batching was shut down after the caller checked is_enabled()
+    if(!is_enabled()) return false;
+
+    _buffer.events.emplace_back(_ev);
+    if(_buffer.events.size() >= get_state().capacity) submit(_buffer);
+    return true;
+}
+}  // namespace batch
+}  // namespace tracing
+}  // namespace omnitrace
@@ -0,0 +1,85 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/defines.hpp"
+#include "core/perfetto.hpp"
+#include "library/tracing/iteration.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace omnitrace
+{
+namespace tracing
+{
+// batched tracing (OMNITRACE_PERFETTO_BATCH_SIZE): the begin and end events of the
+// slices on the thread tracks which carry no caller-provided annotations are appended
+// to a per-thread buffer of (timestamp, name, type) entries instead of being encoded by
+// perfetto on the instrumented thread. When a buffer is full, it is handed to a
+// background thread which writes the events to the track of the thread. The partially
+// filled buffers are written at finalization. The debug annotations of the batched
+// events (including the timemory data of OMNITRACE_PERFETTO_ANNOTATIONS) are lost.
+namespace batch
+{
+using event = iteration::event;
+
+std::atomic<bool>&
+get_enabled();
+
+// true when OMNITRACE_PERFETTO_BATCH_SIZE is greater than zero
+inline bool
+is_enabled()
+{
+    return get_enabled().load(std::memory_order_relaxed);
+}
+
+void
+setup();
+
+void
+shutdown();
+
+// returns false if the event must be written because batching has been shut down
+bool
+append(event&&);
+
+// returns true if the begin event was buffered
+template <typename CategoryT>
+inline bool
+push(const char* _name, uint64_t _ts)
+{
+    return append(event{ &iteration::emit<CategoryT>, _name, _ts, true });
+}
+
+// returns true if the end event was buffered
+template <typename CategoryT>
+inline bool
+pop(const char* _name, uint64_t _ts)
+{
+    return append(event{ &iteration::emit<CategoryT>, _name, _ts, false });
+}
+}  // namespace batch
+}  // namespace tracing
+}  // namespace omnitrace
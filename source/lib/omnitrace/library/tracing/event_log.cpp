@@ -0,0 +1,290 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/tracing/event_log.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/self_overhead.hpp"
+#include "core/state.hpp"
+#include "core/string_arena.hpp"
+#include "library/tracing.hpp"
+#include "library/tracing/iteration.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+
+namespace omnitrace
+{
+namespace tracing
+{
+namespace event_log
+{
+namespace
+{
+// size of each mapping of a log, the pages are only committed when they are written
+constexpr size_t chunk_bytes = (64 << 20);
+constexpr size_t cache_size  = 512;
+
+struct chunk
+{
+    std::atomic<chunk*> next     = { nullptr };
+    std::atomic<size_t> size     = { 0 };
+    size_t              capacity = 0;
+
+    record* records() { return reinterpret_cast<record*>(this + 1); }
+};
+
+static_assert(sizeof(chunk) % sizeof(record) == 0,
+              "event log records should be aligned in the chunks");
+
+using cache_entry_t = std::pair<const char*, uint32_t>;
+
+// only the owning thread appends. The finalizing thread reads the sizes of the chunks
+// which are published after the records are written
+struct thread_log
+{
+    int64_t                               sys_tid = 0;
+    chunk*                                head    = nullptr;
+    chunk*                                tail    = nullptr;
+    std::array<cache_entry_t, cache_size> cache   = {};
+};
+
+struct log_state
+{
+    std::mutex                                mutex = {};
+    uint64_t                                  ticks = 0;  // at setup
+    uint64_t                                  nsec  = 0;  // at setup
+    std::vector<const char*>                  names = {};
+    std::unordered_map<const char*, uint32_t> ids   = {};
+    std::vector<thread_log*>                  logs  = {};
+};
+
+auto&
+get_state()
+{
+    static auto* _v = new log_state{};
+    return *_v;
+}
+
+chunk*
+allocate_chunk()
+{
+    void* _addr = mmap(nullptr, chunk_bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(_addr == MAP_FAILED)
+    {
+        OMNITRACE_WARNING_F(0, "[event_log] Error mapping %zu bytes: %s\n", chunk_bytes,
+                            strerror(errno));
+        return nullptr;
+    }
+
+    auto* _chunk     = new(_addr) chunk{};
+    _chunk->capacity = (chunk_bytes - sizeof(chunk)) / sizeof(record);
+    return _chunk;
+}
+
+// the logs are never destroyed since the threads may exit before finalization
+thread_log&
+get_thread_log()
+{
+    static thread_local auto* _v = []() {
+        auto* _log    = new thread_log{};
+        _log->sys_tid = threading::get_sys_tid();
+        _log->head    = allocate_chunk();
+        _log->tail    = _log->head;
+
+        auto& _state = get_state();
+        auto  _lk    = std::unique_lock<std::mutex>{ _state.mutex };
+        _state.logs.emplace_back(_log);
+        return _log;
+    }();
+    return *_v;
+}
+
+uint32_t
+get_function_id(const char* _name)
+{
+    auto* _interned = intern_string(_name);
+    auto& _state    = get_state();
+    auto  _lk       = std::unique_lock<std::mutex>{ _state.mutex };
+    auto  itr       = _state.ids.find(_interned);
+    if(itr != _state.ids.end()) return itr->second;
+
+    auto _id = static_cast<uint32_t>(_state.names.size());
+    _state.names.emplace_back(_interned);
+    _state.ids.emplace(_interned, _id);
+    return _id;
+}
+
+inline uint32_t
+get_function_id(thread_log& _log, const char* _name)
+{
+    auto  _idx   = (reinterpret_cast<uintptr_t>(_name) >> 3) & (cache_size - 1);
+    auto& _entry = _log.cache[_idx];
+    if(OMNITRACE_UNLIKELY(_entry.first != _name))
+        _entry = { _name, get_function_id(_name) };
+    return _entry.second;
+}
+
+inline void
+append(const char* _name, uint32_t _exit)
+{
+    if(!is_enabled() || get_thread_state() == ThreadState::Disabled) return;
+    if(category_push_disabled<category::host>()) return;
+
+    auto& _log   = get_thread_log();
+    auto* _chunk = _log.tail;
+    if(OMNITRACE_UNLIKELY(!_chunk)) return;
+
+    auto _size = _chunk->size.load(std::memory_order_relaxed);
+    if(OMNITRACE_UNLIKELY(_size == _chunk->capacity))
+    {
+        auto* _next = allocate_chunk();
+        if(!_next) return;
+        _chunk->next.store(_next, std::memory_order_release);
+        _chunk = _log.tail = _next;
+        _size              = 0;
+    }
+
+    _chunk->records()[_size] =
+        record{ self_overhead::read_ticks(), get_function_id(_log, _name), _exit };
+    _chunk->size.store(_size + 1, std::memory_order_release);
+}
+
+// writes the slices of a log. Exits without a matching entry (e.g. while the host
+// category was disabled) are dropped and the slices which are still open are closed
+// at the last timestamp of the log
+size_t
+write(const thread_log& _log, const std::vector<const char*>& _names, double _scale)
+{
+    const auto& _state = get_state();
+    auto        _track = ::perfetto::ThreadTrack::ForThread(_log.sys_tid);
+    auto        _emit  = &iteration::emit<category::host>;
+    auto        _depth = size_t{ 0 };
+    auto        _last  = uint64_t{ 0 };
+    auto        _count = size_t{ 0 };
+
+    for(auto* itr = _log.head; itr != nullptr; itr = itr->next.load())
+    {
+        auto  _size    = itr->size.load(std::memory_order_acquire);
+        auto* _records = itr->records();
+        for(size_t i = 0; i < _size; ++i)
+        {
+            const auto& _rec = _records[i];
+            if(_rec.exit != 0 && _depth == 0) continue;
+            if(_rec.id >= _names.size()) continue;
+
+            auto _ticks = static_cast<int64_t>(_rec.ticks - _state.ticks);
+            _last       = _state.nsec + static_cast<int64_t>(_ticks * _scale);
+
+            auto _ev = iteration::event{ _emit, _names[_rec.id], _last, _rec.exit == 0 };
+            _emit(_ev, _track);
+            _depth = (_rec.exit == 0) ? _depth + 1 : _depth - 1;
+            ++_count;
+        }
+    }
+
+    for(; _depth > 0; --_depth)
+        _emit(iteration::event{ _emit, nullptr, _last, false }, _track);
+
+    return _count;
+}
+}  // namespace
+
+std::atomic<bool>&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+void
+setup()
+{
+    if(!config::get_trace_event_log() || !get_use_perfetto()) return;
+
+    auto& _state = get_state();
+    _state.ticks = self_overhead::read_ticks();
+    _state.nsec  = tracing::now();
+
+    OMNITRACE_VERBOSE(1, "[event_log] recording the instrumented functions in the "
+                         "per-thread event logs...\n");
+
+    get_enabled().store(true);
+}
+
+void
+shutdown()
+{
+    if(!is_enabled()) return;
+
+    // records appended after this point are discarded
+    get_enabled().store(false);
+
+    auto& _state = get_state();
+    auto  _ticks = self_overhead::read_ticks() - _state.ticks;
+    auto  _nsec  = tracing::now() - _state.nsec;
+    auto  _scale = (_ticks > 0) ? (static_cast<double>(_nsec) / _ticks) : 1.0;
+
+    auto _names = std::vector<const char*>{};
+    auto _logs  = std::vector<thread_log*>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+        _names   = _state.names;
+        _logs    = _state.logs;
+    }
+
+    size_t _count = 0;
+    for(const auto* itr : _logs)
+        _count += write(*itr, _names, _scale);
+
+    OMNITRACE_VERBOSE(1,
+                      "[event_log] converted %zu records of %zu functions on %zu threads "
+                      "to perfetto (%.3f nsec per tick)\n",
+                      _count, _names.size(), _logs.size(), _scale);
+}
+
+void
+push(const char* _name)
+{
+    append(_name, 0);
+}
+
+void
+pop(const char* _name)
+{
+    append(_name, 1);
+}
+}  // namespace event_log
+}  // namespace tracing
+}  // namespace omnitrace
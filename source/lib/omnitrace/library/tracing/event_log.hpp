@@ -0,0 +1,78 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "core/defines.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace omnitrace
+{
+namespace tracing
+{
+// lightweight trace backend for the instrumented functions (OMNITRACE_TRACE_EVENT_LOG):
+// the entry and exit of omnitrace_push_trace/omnitrace_pop_trace append a 16-byte
+// record (time-stamp counter, function id, exit flag) to a per-thread log in
+// anonymous memory mappings instead of starting and stopping the timemory and perfetto
+// regions. The function ids are cached per thread by the address of the name, i.e.
+// the names must remain valid and unchanged (as the names of the instrumentation
+// do). The logs are converted to perfetto slices on the thread tracks at
+// finalization. The functions in the event log are not included in the timemory
+// profile.
+namespace event_log
+{
+struct record
+{
+    uint64_t ticks = 0;
+    uint32_t id    = 0;
+    uint32_t exit  = 0;
+};
+
+static_assert(sizeof(record) == 16, "event log records should be 16 bytes");
+
+std::atomic<bool>&
+get_enabled();
+
+inline bool
+is_enabled()
+{
+    return get_enabled().load(std::memory_order_relaxed);
+}
+
+void
+setup();
+
+// converts the logs to perfetto
+void
+shutdown();
+
+void
+push(const char*) OMNITRACE_HOT;
+
+void
+pop(const char*) OMNITRACE_HOT;
+}  // namespace event_log
+}  // namespace tracing
+}  // namespace omnitrace
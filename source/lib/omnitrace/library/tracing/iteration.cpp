@@ -0,0 +1,322 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/tracing/iteration.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/backends/threading.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace tracing
+{
+namespace iteration
+{
+namespace
+{
+// the percentile is always exceeded until this many iterations have been measured
+constexpr uint64_t min_iterations = 20;
+
+struct thread_buffer
+{
+    std::mutex           mutex     = {};
+    int64_t              sys_tid   = 0;
+    int64_t              depth     = 0;  // slices opened within the iteration
+    std::atomic<int64_t> discarded = { 0 };
+    std::vector<event>   events    = {};
+};
+
+// log-linear histogram of the iteration durations in nanoseconds with eight buckets
+// per power of two, i.e. the relative error of the percentile is below 12.5%
+struct duration_histogram
+{
+    static constexpr size_t sub_buckets = 8;
+    static constexpr size_t num_buckets = 64 * sub_buckets;
+
+    static size_t index(uint64_t _ns)
+    {
+        if(_ns < sub_buckets) return _ns;
+        auto _exp  = 63 - __builtin_clzll(_ns);
+        auto _mant = (_ns >> (_exp - 3)) & (sub_buckets - 1);
+        return (_exp - 2) * sub_buckets + _mant;
+    }
+
+    static uint64_t lower_bound(size_t _idx)
+    {
+        if(_idx < sub_buckets) return _idx;
+        auto _exp  = (_idx / sub_buckets) + 2;
+        auto _mant = _idx % sub_buckets;
+        return (sub_buckets + _mant) << (_exp - 3);
+    }
+
+    void add(uint64_t _ns)
+    {
+        ++counts.at(std::min(index(_ns), num_buckets - 1));
+        ++total;
+    }
+
+    uint64_t percentile(double _pct) const
+    {
+        auto _target = static_cast<uint64_t>(std::ceil(_pct / 100.0 * total));
+        auto _sum    = uint64_t{ 0 };
+        for(size_t i = 0; i < num_buckets; ++i)
+        {
+            _sum += counts[i];
+            if(_sum >= _target && _sum > 0) return lower_bound(i);
+        }
+        return lower_bound(num_buckets - 1);
+    }
+
+    uint64_t                          total  = 0;
+    std::array<uint64_t, num_buckets> counts = {};
+};
+
+struct iteration_state
+{
+    std::mutex                                  mutex     = {};
+    std::string                                 region    = {};
+    uint64_t                                    threshold = 0;  // nsec
+    double                                      pct       = 0.0;
+    uint64_t                                    beg_ns    = 0;
+    size_t                                      written   = 0;
+    size_t                                      dropped   = 0;
+    duration_histogram                          durations = {};
+    std::vector<std::shared_ptr<thread_buffer>> buffers   = {};
+};
+
+auto&
+get_state()
+{
+    static auto* _v = new iteration_state{};
+    return *_v;
+}
+
+// nesting of the iteration region on the thread which opened the iteration
+auto&
+get_owner_depth()
+{
+    static thread_local int64_t _v = 0;
+    return _v;
+}
+
+thread_buffer&
+get_thread_buffer()
+{
+    static thread_local auto _v = []() {
+        auto _buffer     = std::make_shared<thread_buffer>();
+        _buffer->sys_tid = threading::get_sys_tid();
+        auto& _state     = get_state();
+        auto  _lk        = std::unique_lock<std::mutex>{ _state.mutex };
+        _state.buffers.emplace_back(_buffer);
+        return _buffer;
+    }();
+    return *_v;
+}
+
+bool
+is_slow(iteration_state& _state, uint64_t _duration)
+{
+    if(_state.threshold > 0) return (_duration >= _state.threshold);
+
+    bool _slow = (_state.durations.total < min_iterations ||
+                  _duration >= _state.durations.percentile(_state.pct));
+    _state.durations.add(_duration);
+    return _slow;
+}
+}  // namespace
+
+std::atomic<bool>&
+get_enabled()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+std::atomic<bool>&
+get_buffering()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+void
+setup()
+{
+    auto _region = config::get_perfetto_iteration_region();
+    if(_region.empty() || !get_use_perfetto()) return;
+
+    auto& _state     = get_state();
+    _state.region    = _region;
+    _state.threshold = static_cast<uint64_t>(
+        std::max(config::get_perfetto_iteration_threshold(), 0.0) * units::sec);
+    _state.pct = std::clamp(config::get_perfetto_iteration_percentile(), 0.0, 100.0);
+
+    if(_state.threshold > 0)
+    {
+        OMNITRACE_VERBOSE(1,
+                          "[iteration] writing the perfetto events of the '%s' "
+                          "iterations which exceed %.3e seconds...\n",
+                          _region.c_str(), config::get_perfetto_iteration_threshold());
+    }
+    else
+    {
+        OMNITRACE_VERBOSE(1,
+                          "[iteration] writing the perfetto events of the '%s' "
+                          "iterations which exceed the %.1f percentile...\n",
+                          _region.c_str(), _state.pct);
+    }
+
+    get_enabled().store(true);
+}
+
+void
+shutdown()
+{
+    if(!is_enabled()) return;
+
+    // the events of an iteration which is still open are written
+    auto& _state = get_state();
+    if(is_buffering())
+    {
+        get_buffering().store(false);
+        auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+        for(auto& itr : _state.buffers)
+        {
+            auto _buf_lk = std::unique_lock<std::mutex>{ itr->mutex };
+            auto _track  = ::perfetto::ThreadTrack::ForThread(itr->sys_tid);
+            for(const auto& eitr : itr->events)
+                eitr.emit(eitr, _track);
+            itr->events.clear();
+            itr->depth = 0;
+        }
+    }
+
+    get_enabled().store(false);
+
+    OMNITRACE_VERBOSE(1,
+                      "[iteration] wrote the perfetto events of %zu of %zu '%s' "
+                      "iterations\n",
+                      _state.written, _state.written + _state.dropped,
+                      _state.region.c_str());
+}
+
+void
+begin(std::string_view _name)
+{
+    auto& _state = get_state();
+    if(_name != _state.region) return;
+
+    // nested within an iteration opened by this thread
+    if(get_owner_depth() > 0)
+    {
+        ++get_owner_depth();
+        return;
+    }
+
+    auto _lk = std::unique_lock<std::mutex>{ _state.mutex };
+    // another thread opened an iteration
+    if(is_buffering()) return;
+
+    get_owner_depth() = 1;
+    _state.beg_ns     = tracing::now();
+    get_buffering().store(true);
+}
+
+void
+end(std::string_view _name)
+{
+    auto& _state = get_state();
+    if(get_owner_depth() == 0 || _name != _state.region) return;
+    if(--get_owner_depth() > 0) return;
+
+    auto _end_ns = tracing::now();
+    auto _lk     = std::unique_lock<std::mutex>{ _state.mutex };
+
+    // events appended after this point are written directly
+    get_buffering().store(false);
+
+    auto _slow = is_slow(_state, _end_ns - _state.beg_ns);
+    if(_slow)
+        ++_state.written;
+    else
+        ++_state.dropped;
+
+    for(auto& itr : _state.buffers)
+    {
+        auto _buf_lk = std::unique_lock<std::mutex>{ itr->mutex };
+        if(_slow)
+        {
+            auto _track = ::perfetto::ThreadTrack::ForThread(itr->sys_tid);
+            for(const auto& eitr : itr->events)
+                eitr.emit(eitr, _track);
+        }
+        else if(itr->depth > 0)
+        {
+            // the end events of the slices which are still open are dropped
+            itr->discarded.fetch_add(itr->depth);
+        }
+        itr->events.clear();
+        itr->depth = 0;
+    }
+}
+
+bool
+append(event&& _ev)
+{
+    auto& _buffer = get_thread_buffer();
+    auto  _lk     = std::unique_lock<std::mutex>{ _buffer.mutex };
+
+    // the iteration closed after the caller checked is_buffering()
+    if(!is_buffering()) return false;
+
+    if(_ev.begin)
+        ++_buffer.depth;
+    else if(_buffer.depth == 0)
+        return false;  // the slice began before the iteration
+    else
+        --_buffer.depth;
+
+    _buffer.events.emplace_back(_ev);
+    return true;
+}
+
+bool
+discard_end()
+{
+    auto& _buffer = get_thread_buffer();
+    if(_buffer.discarded.load(std::memory_order_relaxed) == 0) return false;
+    _buffer.discarded.fetch_sub(1);
+    return true;
+}
+}  // namespace iteration
+}  // namespace tracing
+}  // namespace omnitrace
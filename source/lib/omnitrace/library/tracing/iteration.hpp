@@ -0,0 +1,136 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "core/categories.hpp"
+#include "core/defines.hpp"
+#include "core/perfetto.hpp"
+#include "core/timemory.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+namespace tracing
+{
+// region-triggered tracing (OMNITRACE_PERFETTO_ITERATION_REGION): while a region with
+// the configured name is open, the begin and end events of the slices on the thread
+// tracks of all the threads are buffered per thread instead of being written to
+// perfetto. When the region is closed, the buffered events are written if the
+// duration of the region exceeds OMNITRACE_PERFETTO_ITERATION_THRESHOLD (or the
+// online estimate of OMNITRACE_PERFETTO_ITERATION_PERCENTILE) and discarded otherwise.
+// Only the debug annotations of the buffered events are lost.
+namespace iteration
+{
+struct event
+{
+    using emit_func_t = void (*)(const event&, ::perfetto::Track);
+
+    emit_func_t emit      = nullptr;
+    const char* name      = nullptr;
+    uint64_t    timestamp = 0;
+    bool        begin     = false;
+};
+
+std::atomic<bool>&
+get_enabled();
+
+std::atomic<bool>&
+get_buffering();
+
+// true when OMNITRACE_PERFETTO_ITERATION_REGION is set
+inline bool
+is_enabled()
+{
+    return get_enabled().load(std::memory_order_relaxed);
+}
+
+// true while an iteration is open
+inline bool
+is_buffering()
+{
+    return get_buffering().load(std::memory_order_relaxed);
+}
+
+void
+setup();
+
+void
+shutdown();
+
+// invoked by category_region when a region is pushed and popped. Only the outermost
+// region with the configured name opens and closes an iteration
+void
+begin(std::string_view);
+
+void
+end(std::string_view);
+
+// returns false if the event must be written because the iteration has closed or, for
+// an end event, because the slice began before the iteration opened
+bool
+append(event&&);
+
+// returns true (once) for each of the end events of the slices which were open on the
+// calling thread when their begin events were discarded
+bool
+discard_end();
+
+template <typename CategoryT>
+void
+emit(const event& _ev, ::perfetto::Track _track)
+{
+    if(_ev.begin)
+    {
+        TRACE_EVENT_BEGIN(trait::name<CategoryT>::value,
+                          ::perfetto::StaticString(_ev.name), _track, _ev.timestamp);
+    }
+    else
+    {
+        TRACE_EVENT_END(trait::name<CategoryT>::value, _track, _ev.timestamp);
+    }
+}
+
+// returns true if the begin event was buffered
+template <typename CategoryT>
+inline bool
+push(const char* _name, uint64_t _ts)
+{
+    if(!is_buffering()) return false;
+    return append(event{ &emit<CategoryT>, _name, _ts, true });
+}
+
+// returns true if the end event was buffered or must be dropped
+template <typename CategoryT>
+inline bool
+pop(const char* _name, uint64_t _ts)
+{
+    if(is_buffering() && append(event{ &emit<CategoryT>, _name, _ts, false }))
+        return true;
+    return discard_end();
+}
+}  // namespace iteration
+}  // namespace tracing
+}  // namespace omnitrace
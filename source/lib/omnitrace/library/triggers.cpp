@@ -0,0 +1,334 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/triggers.hpp"
+#include "core/categories.hpp"
+#include "core/config.hpp"
+#include "core/debug.hpp"
+#include "core/locking.hpp"
+#include "core/state.hpp"
+#include "core/timemory.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+#include <timemory/hash/types.hpp>
+#include <timemory/utility/delimit.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ratio>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+namespace triggers
+{
+namespace
+{
+// tables larger than this are not considered when resolving the collisions
+constexpr size_t max_slots = (1 << 16);
+
+enum class action : uint8_t
+{
+    enable = 0,  // enable after the N-th instance
+    disable,     // disable after the N-th instance
+    within,      // enabled while the region is active on any thread
+};
+
+struct trigger
+{
+    action                type       = action::enable;
+    bool                  on_exit    = false;
+    bool                  sampling   = true;
+    bool                  applied    = false;
+    uint64_t              count      = 1;
+    uint64_t              after      = 0;  // nanoseconds after setup
+    std::string           spec       = {};
+    std::string           region     = {};
+    std::set<std::string> categories = {};
+    std::atomic<uint64_t> instances  = { 0 };
+    std::atomic<int64_t>  active     = { 0 };
+    locking::atomic_mutex mutex      = {};
+};
+
+// the triggers are never destroyed since regions may be popped during finalization
+auto&
+get_triggers()
+{
+    static auto* _v = new std::deque<trigger>{};
+    return *_v;
+}
+
+// triggers ordered by region, the slots refer to ranges of this list
+auto&
+get_ordered_triggers()
+{
+    static auto* _v = new std::vector<trigger*>{};
+    return *_v;
+}
+
+auto&
+get_slots()
+{
+    static auto* _v = new std::vector<slot>{};
+    return *_v;
+}
+
+uint64_t
+now()
+{
+    return tim::get_clock_real_now<uint64_t, std::nano>();
+}
+
+uint64_t&
+get_setup_time()
+{
+    static uint64_t _v = 0;
+    return _v;
+}
+
+bool
+parse_option(trigger& _v, const std::string& _key, const std::string& _val)
+{
+    if(_key == "count")
+        _v.count = std::max<uint64_t>(std::stoull(_val), 1);
+    else if(_key == "after")
+        _v.after = std::stod(_val) * std::nano::den;
+    else if(_key == "on" && (_val == "entry" || _val == "exit"))
+        _v.on_exit = (_val == "exit");
+    else if(_key == "sampling" && (_val == "true" || _val == "false"))
+        _v.sampling = (_val == "true");
+    else if(_key == "categories")
+    {
+        _v.categories.clear();
+        for(const auto& itr : tim::delimit(_val, ", "))
+            _v.categories.emplace(itr);
+    }
+    else
+        return false;
+    return true;
+}
+
+// <ACTION>:<REGION>[:<KEY>=<VALUE>]... where the options are parsed from the end so
+// that the region name may contain colons
+bool
+parse_trigger(trigger& _v, const std::string& _spec)
+{
+    auto _pos = _spec.find(':');
+    if(_pos == std::string::npos || _pos == 0) return false;
+
+    auto _action = _spec.substr(0, _pos);
+    if(_action == "enable")
+        _v.type = action::enable;
+    else if(_action == "disable")
+        _v.type = action::disable;
+    else if(_action == "within")
+        _v.type = action::within;
+    else
+        return false;
+
+    _v.spec       = _spec;
+    _v.categories = config::get_enabled_categories();
+
+    auto _region = _spec.substr(_pos + 1);
+    while((_pos = _region.find_last_of(':')) != std::string::npos)
+    {
+        auto _opt = _region.substr(_pos + 1);
+        auto _eq  = _opt.find('=');
+        if(_eq == std::string::npos || _eq == 0) break;
+        if(!parse_option(_v, _opt.substr(0, _eq), _opt.substr(_eq + 1))) return false;
+        _region = _region.substr(0, _pos);
+    }
+
+    _v.region = _region;
+    return !_v.region.empty();
+}
+
+void
+apply(trigger& _v, bool _enable)
+{
+    // only disable categories if not finalized since this might disable the output of
+    // data in those categories
+    if(get_state() >= State::Finalized) return;
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    OMNITRACE_VERBOSE(1, "[triggers] '%s' %s the data collection...\n", _v.spec.c_str(),
+                      (_enable) ? "enabled" : "disabled");
+
+    if(_enable)
+        categories::enable_categories(_v.categories);
+    else
+        categories::disable_categories(_v.categories);
+
+    if(_v.sampling) categories::set_window(_enable);
+}
+
+// within: the state is re-evaluated under the lock so that concurrent entries and
+// exits on different threads cannot leave it out of sync with the active count
+void
+update(trigger& _v)
+{
+    auto _lk     = locking::atomic_lock{ _v.mutex };
+    auto _enable = _v.active.load() > 0 && now() - get_setup_time() >= _v.after;
+    if(_enable == _v.applied) return;
+    _v.applied = _enable;
+    apply(_v, _enable);
+}
+
+// returns the mask of the smallest table in which the regions do not collide
+size_t
+get_collision_free_mask(const std::vector<tim::hash_value_t>& _hashes)
+{
+    size_t _size = 1;
+    while(_size < 2 * _hashes.size())
+        _size <<= 1;
+
+    for(; _size < max_slots; _size <<= 1)
+    {
+        auto _used = std::vector<bool>(_size, false);
+        auto _ok   = true;
+        for(auto itr : _hashes)
+        {
+            auto _idx = itr & (_size - 1);
+            if(_used.at(_idx))
+            {
+                _ok = false;
+                break;
+            }
+            _used.at(_idx) = true;
+        }
+        if(_ok) break;
+    }
+    return _size - 1;
+}
+}  // namespace
+
+void
+setup()
+{
+    auto& _triggers = get_triggers();
+    for(const auto& itr : tim::delimit(config::get_triggers(), ";\n"))
+    {
+        auto& _v = _triggers.emplace_back();
+        try
+        {
+            if(parse_trigger(_v, itr)) continue;
+            OMNITRACE_WARNING_F(0,
+                                "Ignoring invalid OMNITRACE_TRIGGERS entry '%s'. "
+                                "Expected <enable|disable|within>:<REGION>"
+                                "[:<KEY>=<VALUE>]...\n",
+                                itr.c_str());
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_WARNING_F(0, "Ignoring invalid OMNITRACE_TRIGGERS entry '%s': %s\n",
+                                itr.c_str(), _e.what());
+        }
+        _triggers.pop_back();
+    }
+
+    if(_triggers.empty()) return;
+
+    auto _regions = std::map<tim::hash_value_t, std::vector<trigger*>>{};
+    for(auto& itr : _triggers)
+        _regions[tim::add_hash_id(itr.region)].emplace_back(&itr);
+
+    auto _hashes = std::vector<tim::hash_value_t>{};
+    for(const auto& itr : _regions)
+        _hashes.emplace_back(itr.first);
+
+    auto  _mask    = get_collision_free_mask(_hashes);
+    auto& _slots   = get_slots();
+    auto& _ordered = get_ordered_triggers();
+    _slots.resize(_mask + 1);
+    for(const auto& itr : _regions)
+    {
+        auto& _slot = _slots.at(itr.first & _mask);
+        if(_slot.begin != _slot.end)
+        {
+            OMNITRACE_WARNING_F(0,
+                                "Ignoring OMNITRACE_TRIGGERS entries of region '%s': "
+                                "too many regions\n",
+                                itr.second.front()->region.c_str());
+            continue;
+        }
+
+        _slot.hash  = itr.first;
+        _slot.begin = _ordered.size();
+        for(auto* vitr : itr.second)
+        {
+            OMNITRACE_VERBOSE(1, "[triggers] '%s' :: slot %zu of %zu...\n",
+                              vitr->spec.c_str(), static_cast<size_t>(itr.first & _mask),
+                              _slots.size());
+            _ordered.emplace_back(vitr);
+        }
+        _slot.end = _ordered.size();
+    }
+
+    // the data collection starts disabled if the first trigger enables it
+    const auto& _first = _triggers.front();
+    if(_first.type != action::disable)
+    {
+        categories::disable_categories(_first.categories);
+        if(_first.sampling) categories::set_window(false);
+    }
+
+    get_setup_time() = now();
+
+    auto& _table = get_slot_table();
+    _table.mask  = _mask;
+    _table.data  = _slots.data();
+    _table.enabled.store(true, std::memory_order_release);
+}
+
+void
+evaluate(const slot& _slot, bool _entry)
+{
+    const auto& _ordered = get_ordered_triggers();
+    for(uint32_t i = _slot.begin; i < _slot.end; ++i)
+    {
+        auto& _v = *_ordered[i];
+        if(_v.type == action::within)
+        {
+            // exits without a matching entry (e.g. before the setup) are ignored
+            if(_entry)
+                ++_v.active;
+            else if(--_v.active < 0)
+            {
+                ++_v.active;
+                continue;
+            }
+            update(_v);
+            continue;
+        }
+
+        if(_v.on_exit == _entry) continue;
+        if(_v.after > 0 && now() - get_setup_time() < _v.after) continue;
+        if(++_v.instances == _v.count) apply(_v, _v.type == action::enable);
+    }
+}
+}  // namespace triggers
+}  // namespace omnitrace
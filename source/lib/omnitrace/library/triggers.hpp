@@ -0,0 +1,95 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <timemory/hash/types.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// region triggers (OMNITRACE_TRIGGERS): the entry into and/or exit from the listed
+// regions enables or disables the categories and the trace window (i.e. the samplers)
+// once a region was entered N times, once some time has elapsed, or while the region
+// is active on any thread. The triggers of each region are resolved into a slot of a
+// table whose size is chosen such that the regions do not collide, i.e. evaluating
+// the triggers of a region boundary is a single array access
+namespace triggers
+{
+struct slot
+{
+    tim::hash_value_t hash  = 0;
+    uint32_t          begin = 0;  // range of the triggers of the region
+    uint32_t          end   = 0;
+};
+
+struct slot_table
+{
+    std::atomic<bool> enabled = { false };
+    size_t            mask    = 0;
+    const slot*       data    = nullptr;
+};
+
+inline slot_table&
+get_slot_table()
+{
+    static auto _v = slot_table{};
+    return _v;
+}
+
+inline bool
+is_enabled()
+{
+    return get_slot_table().enabled.load(std::memory_order_acquire);
+}
+
+// parses OMNITRACE_TRIGGERS and disables the data collection if the first trigger
+// enables it
+void
+setup();
+
+// evaluates the triggers of the region in the slot
+void
+evaluate(const slot& _slot, bool _entry);
+
+// only call when is_enabled() returns true
+inline void
+push(tim::hash_value_t _hash)
+{
+    const auto& _table = get_slot_table();
+    const auto& _slot  = _table.data[_hash & _table.mask];
+    if(_slot.hash == _hash) evaluate(_slot, true);
+}
+
+inline void
+pop(tim::hash_value_t _hash)
+{
+    const auto& _table = get_slot_table();
+    const auto& _slot  = _table.data[_hash & _table.mask];
+    if(_slot.hash == _hash) evaluate(_slot, false);
+}
+}  // namespace triggers
+}  // namespace omnitrace
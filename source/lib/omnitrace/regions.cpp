@@ -24,7 +24,20 @@
 #include "core/categories.hpp"
 #include "core/config.hpp"
 #include "library/components/category_region.hpp"
+#include "core/locking.hpp"
+#include "library/control.hpp"
+#include "library/region_sampling.hpp"
+#include "library/throttle.hpp"
 #include "library/tracing.hpp"
+#include "library/tracing/annotation.hpp"
+#include "library/tracing/event_log.hpp"
+
+#include <timemory/components/data_tracker/components.hpp>
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #if defined(__GNUC__) && (__GNUC__ == 7)
 #    pragma GCC diagnostic push
@@ -52,7 +65,7 @@ invoke_category_region_start(omnitrace_category_t _category, const char* name,
         using category_type = category_type_id_t<Idx>;
 
         // skip if category is disabled
-        if(!trait::runtime_enabled<category_type>::get()) return;
+        if(tracing::category_push_disabled<category_type>()) return;
 
         component::category_region<category_type>::start(
             name, [&](::perfetto::EventContext ctx) {
@@ -87,7 +100,7 @@ invoke_category_region_stop(omnitrace_category_t _category, const char* name,
         using category_type = category_type_id_t<Idx>;
 
         // skip if category is disabled
-        if(!trait::runtime_enabled<category_type>::get()) return;
+        if(tracing::category_pop_disabled<category_type>()) return;
 
         component::category_region<category_type>::stop(
             name, [&](::perfetto::EventContext ctx) {
@@ -106,6 +119,46 @@ invoke_category_region_stop(omnitrace_category_t _category, const char* name,
                                         std::index_sequence<Tail...>{});
     }
 }
+
+// the perfetto slices of the sampled regions are annotated with the number of
+// instances represented by the recorded instance
+template <typename RegionT>
+void
+start_sampled_region(const RegionT& _region, size_t _scale)
+{
+    using category_region_t = component::category_region<category::user>;
+
+    if(_scale > 1 && config::get_perfetto_annotations())
+        category_region_t::start(_region, [_scale](::perfetto::EventContext ctx) {
+            tracing::add_perfetto_annotation(ctx, "sample_rate", _scale);
+        });
+    else
+        category_region_t::start(_region);
+}
+
+// the numeric fields of the schema values are stored in the data trackers named
+// <region>/<field> when OMNITRACE_TIMEMORY_ANNOTATIONS is enabled
+void
+record_annotation_data(std::string_view _name, const omnitrace_annotation_schema& _schema,
+                       const void* _values)
+{
+    using tracker_t = tim::auto_tuple<component::annotation_data_tracker>;
+
+    static auto _once = []() {
+        component::annotation_data_tracker::label()       = "annotation_data";
+        component::annotation_data_tracker::description() = "Annotation schema values";
+        return true;
+    }();
+    (void) _once;
+
+    for(const auto& itr : _schema.fields)
+    {
+        auto _value = 0.0;
+        if(!tracing::get_annotation_field_value(itr, _values, _value)) continue;
+        tracker_t _t{ JOIN('/', _name, itr.name) };
+        _t.store(std::plus<double>{}, _value);
+    }
+}
 }  // namespace
 }  // namespace impl
 }  // namespace omnitrace
@@ -115,12 +168,20 @@ invoke_category_region_stop(omnitrace_category_t _category, const char* name,
 extern "C" void
 omnitrace_push_trace_hidden(const char* name)
 {
+    if(omnitrace::control::push(name)) return;
+    if(omnitrace::tracing::event_log::is_enabled())
+        return omnitrace::tracing::event_log::push(name);
+    if(omnitrace::throttle::push(name)) return;
     omnitrace::component::category_region<omnitrace::category::host>::start(name);
 }
 
 extern "C" void
 omnitrace_pop_trace_hidden(const char* name)
 {
+    if(omnitrace::control::pop(name)) return;
+    if(omnitrace::tracing::event_log::is_enabled())
+        return omnitrace::tracing::event_log::pop(name);
+    if(omnitrace::throttle::pop(name)) return;
     omnitrace::component::category_region<omnitrace::category::host>::stop(name);
 }
 
@@ -133,12 +194,17 @@ omnitrace_pop_trace_hidden(const char* name)
 extern "C" void
 omnitrace_push_region_hidden(const char* name)
 {
-    omnitrace::component::category_region<omnitrace::category::user>::start(name);
+    if(omnitrace::control::push(name)) return;
+    auto _scale = omnitrace::region_sampling::push(name);
+    if(_scale == 0) return;
+    omnitrace::impl::start_sampled_region(std::string_view{ name }, _scale);
 }
 
 extern "C" void
 omnitrace_pop_region_hidden(const char* name)
 {
+    if(omnitrace::control::pop_region(name)) return;
+    if(omnitrace::region_sampling::pop(name)) return;
     omnitrace::component::category_region<omnitrace::category::user>::stop(name);
 }
 
@@ -148,6 +214,147 @@ omnitrace_pop_region_hidden(const char* name)
 ///
 //======================================================================================//
 
+extern "C" void
+omnitrace_push_sampled_region_hidden(const char* name, size_t rate)
+{
+    if(omnitrace::control::push(name)) return;
+    auto _scale =
+        omnitrace::region_sampling::push(tim::hash::get_hash_id(name), name, rate);
+    if(_scale == 0) return;
+    omnitrace::impl::start_sampled_region(std::string_view{ name }, _scale);
+}
+
+extern "C" void
+omnitrace_pop_sampled_region_hidden(const char* name)
+{
+    omnitrace_pop_region_hidden(name);
+}
+
+//======================================================================================//
+///
+///
+///
+//======================================================================================//
+
+extern "C" omnitrace_region_handle_t
+omnitrace_register_region_hidden(const char* name)
+{
+    if(!name || strlen(name) == 0) return nullptr;
+
+    using region_map_t =
+        std::unordered_map<tim::hash_value_t, std::unique_ptr<omnitrace_region>>;
+
+    // registration is infrequent. the regions are intentionally leaked so that
+    // the handles remain valid during finalization
+    static auto  _mutex   = omnitrace::locking::atomic_mutex{};
+    static auto* _regions = new region_map_t{};
+
+    auto  _hash = tim::add_hash_id(name);
+    auto  _lk   = omnitrace::locking::atomic_lock{ _mutex };
+    auto& _v    = (*_regions)[_hash];
+    if(!_v) _v = std::make_unique<omnitrace_region>(omnitrace_region{ _hash, name });
+    return _v.get();
+}
+
+extern "C" void
+omnitrace_push_region_handle_hidden(omnitrace_region_handle_t _region)
+{
+    if(!_region || omnitrace::control::push(_region->name.c_str())) return;
+    auto _scale = omnitrace::region_sampling::push(_region->hash, _region->name);
+    if(_scale == 0) return;
+    omnitrace::impl::start_sampled_region(*_region, _scale);
+}
+
+extern "C" void
+omnitrace_pop_region_handle_hidden(omnitrace_region_handle_t _region)
+{
+    using category_region_t =
+        omnitrace::component::category_region<omnitrace::category::user>;
+    if(!_region || omnitrace::control::pop_region(_region->name.c_str())) return;
+    if(omnitrace::region_sampling::pop(_region->hash)) return;
+    category_region_t::stop(*_region);
+}
+
+//======================================================================================//
+///
+///
+///
+//======================================================================================//
+
+extern "C" omnitrace_annotation_schema_t
+omnitrace_register_annotation_schema_hidden(const omnitrace_annotation_field_t* _fields,
+                                            size_t _num_fields)
+{
+    if(!_fields || _num_fields == 0) return nullptr;
+
+    using schema_vec_t = std::vector<std::unique_ptr<omnitrace_annotation_schema>>;
+
+    // the fields are validated before the schema is stored
+    auto _schema = std::make_unique<omnitrace_annotation_schema>();
+    _schema->fields.reserve(_num_fields);
+    for(size_t i = 0; i < _num_fields; ++i)
+        _schema->fields.emplace_back(
+            omnitrace::tracing::make_annotation_field(_fields[i]));
+
+    // the schemas are intentionally leaked so that the handles remain valid during
+    // finalization
+    static auto  _mutex   = omnitrace::locking::atomic_mutex{};
+    static auto* _schemas = new schema_vec_t{};
+
+    auto _lk = omnitrace::locking::atomic_lock{ _mutex };
+    return _schemas->emplace_back(std::move(_schema)).get();
+}
+
+extern "C" void
+omnitrace_push_schema_region_hidden(const char*                   name,
+                                    omnitrace_annotation_schema_t _schema,
+                                    const void*                   _values)
+{
+    using category_region_t =
+        omnitrace::component::category_region<omnitrace::category::user>;
+
+    if(!_schema || !_values)
+    {
+        category_region_t::start(name);
+        return;
+    }
+
+    category_region_t::start(name, [&](::perfetto::EventContext ctx) {
+        if(omnitrace::config::get_perfetto_annotations())
+            omnitrace::tracing::add_perfetto_annotation(ctx, *_schema, _values);
+    });
+
+    if(omnitrace::get_use_timemory() && omnitrace::config::get_timemory_annotations() &&
+       omnitrace::get_state() == omnitrace::State::Active)
+        omnitrace::impl::record_annotation_data(name, *_schema, _values);
+}
+
+extern "C" void
+omnitrace_pop_schema_region_hidden(const char*                   name,
+                                   omnitrace_annotation_schema_t _schema,
+                                   const void*                   _values)
+{
+    using category_region_t =
+        omnitrace::component::category_region<omnitrace::category::user>;
+
+    if(!_schema || !_values)
+    {
+        category_region_t::stop(name);
+        return;
+    }
+
+    category_region_t::stop(name, [&](::perfetto::EventContext ctx) {
+        if(omnitrace::config::get_perfetto_annotations())
+            omnitrace::tracing::add_perfetto_annotation(ctx, *_schema, _values);
+    });
+}
+
+//======================================================================================//
+///
+///
+///
+//======================================================================================//
+
 extern "C" void
 omnitrace_push_category_region_hidden(omnitrace_category_t _category, const char* name,
                                       omnitrace_annotation_t* _annotations,
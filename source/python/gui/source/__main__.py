@@ -38,7 +38,7 @@ import json
 from pathlib import Path
 
 from . import gui
-from .parser import parse_files, find_causal_files, set_num_stddev
+from .parser import parse_files, find_causal_files, merge_causal_logs, set_num_stddev
 from . import __version__
 
 
@@ -53,6 +53,11 @@ def causal(args):
     # unique
     input_files = list(set(input_files))
 
+    if args.merge:
+        merge_causal_logs([x for x in input_files if x.endswith(".jsonl")], args.merge)
+        print(f"Merged causal experiment logs into '{args.merge}'")
+        return
+
     set_num_stddev(args.stddev)
     num_speedups = len(args.speedups)
 
@@ -286,6 +291,14 @@ def main():
         default=[],
     )
 
+    my_parser.add_argument(
+        "--merge",
+        metavar="FILE",
+        type=str,
+        default=None,
+        help="Merge the causal experiment logs (*.jsonl) found in the workload paths into\na JSON file and exit",
+    )
+
     args = my_parser.parse_args()
 
     causal(args)
@@ -312,6 +312,9 @@ def process_data(data, _data, experiments, progress_points):
             _func = exp["selection"]["info"]["dfunc"]
             _sym_addr = exp["selection"]["symbol_address"]
             _selected = ":".join([_file, f"{_line}"]) if _sym_addr == 0 else _func
+            # GPU kernel or HIP API call
+            if exp.get("device_op", ""):
+                _selected = exp["device_op"]
             if not re.search(_selection_filter, _selected):
                 continue
             if _selected not in data:
@@ -573,6 +576,58 @@ def add_latency(df, experiment, value):
     return df
 
 
+def read_causal_logs(files):
+    """Merges the line-delimited experiment logs (OMNITRACE_CAUSAL_LOG=ON) into
+    the layout of the causal JSON output. Every line is a JSON object which
+    identifies the run (pid and startup time) and contains either one experiment
+    or the samples and runtime written when the run finished"""
+
+    records = {}
+    for file in files:
+        with open(file, "r") as f:
+            for line in f:
+                line = line.strip()
+                if not line:
+                    continue
+                try:
+                    entry = json.loads(line)
+                except json.JSONDecodeError:
+                    # the last line is incomplete if the run was killed while writing
+                    continue
+
+                key = (entry["pid"], entry["startup"])
+                if key not in records:
+                    records[key] = {
+                        "startup_time": entry["startup"],
+                        "runtime": None,
+                        "experiments": [],
+                        "samples": [],
+                    }
+                _record = records[key]
+                if "experiment" in entry:
+                    _record["experiments"].append(entry["experiment"])
+                if "samples" in entry:
+                    _record["samples"] += entry["samples"]
+                if "runtime" in entry:
+                    _record["runtime"] = entry["runtime"]
+
+    # runs which did not finish have no runtime
+    for _record in records.values():
+        if _record["runtime"] is None:
+            _beg = [x["start_time"] for x in _record["experiments"]]
+            _end = [x["end_time"] for x in _record["experiments"]]
+            _record["runtime"] = (max(_end) - min(_beg)) if _beg else 0
+
+    return {"omnitrace": {"causal": {"records": list(records.values())}}}
+
+
+def merge_causal_logs(files, output):
+    """Writes the experiment logs as a single causal JSON file"""
+
+    with open(output, "w") as f:
+        json.dump(read_causal_logs(files), f, indent=2)
+
+
 def parse_files(
     files,
     experiments=".*",
@@ -587,15 +642,16 @@ def parse_files(
     sample_df = pd.DataFrame()
 
     def name_wo_ext(x):
-        return x.replace(".json", "").replace(".coz", "")
+        return x.replace(".jsonl", "").replace(".json", "").replace(".coz", "")
 
+    log_files = [x for x in filter(lambda y: y.endswith(".jsonl"), files)]
     json_files = [x for x in filter(lambda y: y.endswith(".json"), files)]
     coz_files = [x for x in filter(lambda y: y.endswith(".coz"), files)]
     read_files = []
     file_names = []
 
-    # prefer JSON files first
-    files = json_files + coz_files
+    # prefer the experiment logs (which contain every run) and then JSON files
+    files = log_files + json_files + coz_files
     for file in files:
         if verbose >= 3:
             print(f"Potentially reading causal profile: '{file}'...")
@@ -608,42 +664,45 @@ def parse_files(
         if verbose >= 3 or (verbose >= 1 and not cli):
             print(f"Reading causal profile: '{file}'...")
 
-        if file.endswith(".json"):
-            with open(file, "r") as j:
-                _data = json.load(j)
-                dict_data = {}
-                # make sure the JSON is an omnitrace causal JSON
-                if "omnitrace" not in _data or "causal" not in _data["omnitrace"]:
-                    continue
-                dict_data[file] = process_data({}, _data, experiments, progress_points)
-                samps = process_samples({}, _data)
-                sample_df = pd.concat(
-                    [
-                        sample_df,
-                        pd.DataFrame(
-                            [
-                                {"location": loc, "count": count}
-                                for loc, count in sorted(samps.items())
-                            ]
-                        ),
-                    ]
-                )
-                result_df = pd.concat(
-                    [
-                        result_df,
-                        compute_sorts(
-                            compute_speedups(
-                                dict_data,
-                                speedups,
-                                num_points,
-                                validate,
-                                verbose >= 3 or cli,
-                            )
-                        ),
-                    ]
-                )
-                read_files.append(_base_name)
-                file_names.append(file)
+        if file.endswith(".json") or file.endswith(".jsonl"):
+            if file.endswith(".jsonl"):
+                _data = read_causal_logs([file])
+            else:
+                with open(file, "r") as j:
+                    _data = json.load(j)
+            dict_data = {}
+            # make sure the JSON is an omnitrace causal JSON
+            if "omnitrace" not in _data or "causal" not in _data["omnitrace"]:
+                continue
+            dict_data[file] = process_data({}, _data, experiments, progress_points)
+            samps = process_samples({}, _data)
+            sample_df = pd.concat(
+                [
+                    sample_df,
+                    pd.DataFrame(
+                        [
+                            {"location": loc, "count": count}
+                            for loc, count in sorted(samps.items())
+                        ]
+                    ),
+                ]
+            )
+            result_df = pd.concat(
+                [
+                    result_df,
+                    compute_sorts(
+                        compute_speedups(
+                            dict_data,
+                            speedups,
+                            num_points,
+                            validate,
+                            verbose >= 3 or cli,
+                        )
+                    ),
+                ]
+            )
+            read_files.append(_base_name)
+            file_names.append(file)
 
         elif file.endswith(".coz"):
             try:
@@ -838,7 +897,7 @@ def find_causal_files(workload_path, verbose, recursive):
                             print(f"{itr} is not a causal profile")
                             continue
                 _input_files_tmp += [itr]
-            elif os.path.isfile(itr) and itr.endswith(".coz"):
+            elif os.path.isfile(itr) and (itr.endswith(".coz") or itr.endswith(".jsonl")):
                 _input_files_tmp += [itr]
         return _input_files_tmp
 
@@ -44,9 +44,11 @@
 #include <pybind11/pybind11.h>
 #include <pyerrors.h>
 
+#include <array>
 #include <cctype>
 #include <cstdint>
 #include <exception>
+#include <limits>
 #include <locale>
 #include <regex>
 #include <set>
@@ -56,6 +58,13 @@
 #define OMNITRACE_PYTHON_VERSION                                                         \
     ((10000 * PY_MAJOR_VERSION) + (100 * PY_MINOR_VERSION) + PY_MICRO_VERSION)
 
+// the frames of the interpreter are only accessible via the internal API since 3.11
+#if OMNITRACE_PYTHON_VERSION >= 31100 && OMNITRACE_PYTHON_VERSION < 31400
+#    define Py_BUILD_CORE 1
+#    include <internal/pycore_frame.h>
+#    undef Py_BUILD_CORE
+#endif
+
 namespace pyomnitrace
 {
 namespace pyprofile
@@ -73,6 +82,14 @@ namespace pyuser
 py::module
 generate(py::module& _pymod);
 }
+namespace pysampler
+{
+void
+initialize();
+
+void
+finalize();
+}  // namespace pysampler
 }  // namespace pyomnitrace
 
 template <typename... Tp>
@@ -113,6 +130,7 @@ PYBIND11_MODULE(libpyomnitrace, omni)
                 throw std::runtime_error("Error! omnitrace is already initialized");
             _is_initialized = true;
             omnitrace_set_mpi(_get_use_mpi(), false);
+            pysampler::initialize();
             omnitrace_init("trace", false, _v.c_str());
         },
         "Initialize omnitrace");
@@ -126,6 +144,7 @@ PYBIND11_MODULE(libpyomnitrace, omni)
             omnitrace_set_instrumented(
                 static_cast<int>(omnitrace::dl::InstrumentMode::PythonProfile));
             omnitrace_set_mpi(_get_use_mpi(), false);
+            pysampler::initialize();
             std::string _cmd      = {};
             std::string _cmd_line = {};
             for(auto&& itr : _v)
@@ -148,6 +167,7 @@ PYBIND11_MODULE(libpyomnitrace, omni)
             if(_is_finalized)
                 throw std::runtime_error("Error! omnitrace is already finalized");
             _is_finalized = true;
+            pysampler::finalize();
             omnitrace_finalize();
         },
         "Finalize omnitrace");
@@ -180,13 +200,9 @@ namespace pyomnitrace
 namespace pyprofile
 {
 //
-using profiler_t           = std::function<void()>;
-using profiler_vec_t       = std::vector<profiler_t>;
-using profiler_label_map_t = std::unordered_map<std::string, profiler_vec_t>;
-using profiler_index_map_t = std::unordered_map<uint32_t, profiler_label_map_t>;
-using strset_t             = std::unordered_set<std::string>;
-using note_t               = omnitrace_annotation_t;
-using annotations_t        = std::array<note_t, 6>;
+using strset_t      = std::unordered_set<std::string>;
+using note_t        = omnitrace_annotation_t;
+using annotations_t = std::array<note_t, 6>;
 //
 namespace
 {
@@ -194,6 +210,46 @@ strset_t default_exclude_functions = { "^<.*>$" };
 strset_t default_exclude_filenames = { "(encoder|decoder|threading).py$", "^<.*>$" };
 }  // namespace
 //
+enum class code_decision : uint8_t
+{
+    unknown = 0,
+    skip,
+    skip_nested,  // skip the code object and every function it calls
+    profile,
+};
+//
+// the include/exclude decision and the label of a code object are derived once. The
+// reference keeps the code object alive so that its address is not reused
+struct code_entry
+{
+    code_decision      decision = code_decision::unknown;
+    py::object         code     = {};
+    std::string        func     = {};
+    std::string        file     = {};
+    std::string        full     = {};
+    const std::string* label    = nullptr;  // unless it depends on the frame
+};
+//
+using code_cache_t = std::unordered_map<PyObject*, code_entry>;
+//
+// the region pushed by a call event which is popped by the matching return event.
+// The label is interned for the lifetime of the thread
+struct region_record
+{
+    const char* label    = nullptr;
+    bool        annotate = false;
+};
+//
+using region_stack_t = std::vector<region_record>;
+//
+region_stack_t
+make_region_stack()
+{
+    auto _v = region_stack_t{};
+    _v.reserve(256);
+    return _v;
+}
+//
 auto&
 get_paused()
 {
@@ -222,7 +278,8 @@ struct config
     strset_t                include_filenames  = {};
     strset_t                exclude_functions  = default_exclude_functions;
     strset_t                exclude_filenames  = default_exclude_filenames;
-    std::vector<profiler_t> records            = {};
+    region_stack_t          records            = make_region_stack();
+    code_cache_t            code_cache         = {};
     annotations_t           annotations = { note_t{ "file", OMNITRACE_STRING, nullptr },
                                   note_t{ "line", OMNITRACE_INT32, nullptr },
                                   note_t{ "lasti", OMNITRACE_INT32, nullptr },
@@ -295,40 +352,29 @@ get_frame_code(PyFrameObject* frame)
 #endif
 }
 //
-void
-profiler_function(py::object pframe, const char* swhat, py::object arg)
+// processes a call or return event of the frame. Returns the decision for the code
+// object of the frame or code_decision::unknown when the event is ignored regardless
+// of the code object
+code_decision
+profiler_event(py::object pframe, int what, const char* swhat)
 {
-    if(get_paused() > 0) return;
+    if(get_paused() > 0) return code_decision::unknown;
 
     static thread_local auto& _config  = get_config();
     static thread_local auto  _disable = false;
 
-    if(_disable) return;
+    if(_disable) return code_decision::unknown;
 
     _disable = true;
     tim::scope::destructor _dtor{ []() { _disable= false; } };
     (void) _dtor;
 
-    if(pframe.is_none() || pframe.ptr() == nullptr) return;
+    if(pframe.is_none() || pframe.ptr() == nullptr) return code_decision::unknown;
 
     static auto _omnitrace_path = _config.base_module_path;
 
     auto* frame = reinterpret_cast<PyFrameObject*>(pframe.ptr());
 
-    int what = (strcmp(swhat, "call") == 0)       ? PyTrace_CALL
-               : (strcmp(swhat, "c_call") == 0)   ? PyTrace_C_CALL
-               : (strcmp(swhat, "return") == 0)   ? PyTrace_RETURN
-               : (strcmp(swhat, "c_return") == 0) ? PyTrace_C_RETURN
-                                                  : -1;
-    // only support PyTrace_{CALL,C_CALL,RETURN,C_RETURN}
-    if(what < 0)
-    {
-        if(_config.verbose > 2)
-            TIMEMORY_PRINT_HERE("%s :: %s",
-                                "Ignoring what != {CALL,C_CALL,RETURN,C_RETURN}", swhat);
-        return;
-    }
-
     auto _update_ignore_stack_depth = [what]() {
         switch(what)
         {
@@ -344,7 +390,7 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
             TIMEMORY_PRINT_HERE("%s :: %s :: %u", "Ignoring call/return", swhat,
                                 _config.ignore_stack_depth);
         _update_ignore_stack_depth();
-        return;
+        return code_decision::unknown;
     }
     else if(_config.ignore_stack_depth < 0)
     {
@@ -357,7 +403,7 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
     {
         if(_config.verbose > 2)
             TIMEMORY_PRINT_HERE("%s :: %s", "Ignoring C call/return", swhat);
-        return;
+        return code_decision::unknown;
     }
 
     // get the arguments
@@ -411,91 +457,137 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
         return false;
     };
 
-    bool  _force      = false;
-    auto& _only_funcs = _config.restrict_functions;
-    auto& _incl_funcs = _config.include_functions;
-    auto& _skip_funcs = _config.exclude_functions;
-    auto  _func       = py::cast<std::string>(get_frame_code(frame)->co_name);
+    auto _decide = [&](const std::string& _func, const std::string& _full) {
+        bool  _force      = false;
+        auto& _only_funcs = _config.restrict_functions;
+        auto& _incl_funcs = _config.include_functions;
+        auto& _skip_funcs = _config.exclude_functions;
+
+        if(!_only_funcs.empty())
+        {
+            _force = _find_matching(_only_funcs, _func);
+            if(!_force)
+            {
+                if(_config.verbose > 2)
+                    TIMEMORY_PRINT_HERE("Skipping non-restricted function: %s",
+                                        _func.c_str());
+                return code_decision::skip;
+            }
+        }
 
-    if(!_only_funcs.empty())
-    {
-        _force = _find_matching(_only_funcs, _func);
         if(!_force)
+        {
+            if(_find_matching(_incl_funcs, _func))
+            {
+                _force = true;
+            }
+            else if(_find_matching(_skip_funcs, _func))
+            {
+                if(_config.verbose > 1)
+                    TIMEMORY_PRINT_HERE("Skipping designated function: '%s'",
+                                        _func.c_str());
+                if(!_find_matching(default_exclude_functions, _func))
+                    return code_decision::skip_nested;
+                return code_decision::skip;
+            }
+        }
+
+        auto& _only_files = _config.restrict_filenames;
+        auto& _incl_files = _config.include_filenames;
+        auto& _skip_files = _config.exclude_filenames;
+
+        if(!_config.include_internal &&
+           strncmp(_full.c_str(), _omnitrace_path.c_str(), _omnitrace_path.length()) == 0)
         {
             if(_config.verbose > 2)
-                TIMEMORY_PRINT_HERE("Skipping non-restricted function: %s",
-                                    _func.c_str());
-            return;
+                TIMEMORY_PRINT_HERE("Skipping internal function: %s", _func.c_str());
+            return code_decision::skip;
         }
-    }
 
-    if(!_force)
-    {
-        if(_find_matching(_incl_funcs, _func))
+        if(!_force && !_only_files.empty())
         {
-            _force = true;
+            _force = _find_matching(_only_files, _full);
+            if(!_force)
+            {
+                if(_config.verbose > 2)
+                    TIMEMORY_PRINT_HERE("Skipping non-restricted file: %s",
+                                        _full.c_str());
+                return code_decision::skip;
+            }
         }
-        else if(_find_matching(_skip_funcs, _func))
+
+        if(!_force)
         {
-            if(_config.verbose > 1)
-                TIMEMORY_PRINT_HERE("Skipping designated function: '%s'", _func.c_str());
-            if(!_find_matching(default_exclude_functions, _func))
-                _update_ignore_stack_depth();
-            return;
+            if(_find_matching(_incl_files, _full))
+            {
+                _force = true;
+            }
+            else if(_find_matching(_skip_files, _full))
+            {
+                if(_config.verbose > 2)
+                    TIMEMORY_PRINT_HERE("Skipping non-included file: %s",
+                                        _full.c_str());
+                return code_decision::skip;
+            }
         }
-    }
 
-    auto& _only_files = _config.restrict_filenames;
-    auto& _incl_files = _config.include_filenames;
-    auto& _skip_files = _config.exclude_filenames;
-    auto  _full       = py::cast<std::string>(get_frame_code(frame)->co_filename);
-    auto  _file       = (_full.find('/') != std::string::npos)
-                            ? _full.substr(_full.find_last_of('/') + 1)
-                            : _full;
+        return code_decision::profile;
+    };
 
-    if(!_config.include_internal &&
-       strncmp(_full.c_str(), _omnitrace_path.c_str(), _omnitrace_path.length()) == 0)
-    {
-        if(_config.verbose > 2)
-            TIMEMORY_PRINT_HERE("Skipping internal function: %s", _func.c_str());
-        return;
-    }
+    static thread_local strset_t _labels{};
 
-    if(!_force && !_only_files.empty())
+    auto* _code  = get_frame_code(frame);
+    auto* _key   = reinterpret_cast<PyObject*>(_code);
+    auto& _entry = _config.code_cache[_key];
+    if(_entry.decision == code_decision::unknown)
     {
-        _force = _find_matching(_only_files, _full);
-        if(!_force)
+        _entry.code     = py::reinterpret_borrow<py::object>(_key);
+        _entry.func     = py::cast<std::string>(_code->co_name);
+        _entry.full     = py::cast<std::string>(_code->co_filename);
+        _entry.file     = (_entry.full.find('/') != std::string::npos)
+                              ? _entry.full.substr(_entry.full.find_last_of('/') + 1)
+                              : _entry.full;
+        _entry.decision = _decide(_entry.func, _entry.full);
+
+        // the arguments and the line number in the label are specific to the frame
+        if(_entry.decision == code_decision::profile && !_config.include_args &&
+           !_config.include_line)
         {
-            if(_config.verbose > 2)
-                TIMEMORY_PRINT_HERE("Skipping non-restricted file: %s", _full.c_str());
-            return;
+            auto _func  = _entry.func;
+            auto _file  = _entry.file;
+            auto _full  = _entry.full;
+            auto _label = _get_label(_func, _file, _full);
+            if(!_label.empty()) _entry.label = &*_labels.emplace(_label).first;
         }
     }
 
-    if(!_force)
+    switch(_entry.decision)
     {
-        if(_find_matching(_incl_files, _full))
-        {
-            _force = true;
-        }
-        else if(_find_matching(_skip_files, _full))
-        {
-            if(_config.verbose > 2)
-                TIMEMORY_PRINT_HERE("Skipping non-included file: %s", _full.c_str());
-            return;
-        }
+        case code_decision::skip_nested:
+            _update_ignore_stack_depth();
+            return _entry.decision;
+        case code_decision::profile: break;
+        default: return _entry.decision;
     }
 
     TIMEMORY_CONDITIONAL_PRINT_HERE(_config.verbose > 3, "%8s | %s%s | %s | %s", swhat,
-                                    _func.c_str(), _get_args().c_str(), _file.c_str(),
-                                    _full.c_str());
+                                    _entry.func.c_str(), _get_args().c_str(),
+                                    _entry.file.c_str(), _entry.full.c_str());
 
-    auto _label = _get_label(_func, _file, _full);
-    if(_label.empty()) return;
+    const auto* _label_ptr = _entry.label;
+    if(!_label_ptr)
+    {
+        auto _func  = _entry.func;
+        auto _file  = _entry.file;
+        auto _full  = _entry.full;
+        auto _label = _get_label(_func, _file, _full);
+        if(_label.empty()) return code_decision::unknown;
+        _label_ptr = &*_labels.emplace(_label).first;
+    }
 
-    static thread_local strset_t _labels{};
-    const auto&                  _label_ref = *_labels.emplace(_label).first;
-    auto                         _annotate  = _config.annotate_trace;
+    const auto& _label_ref = *_label_ptr;
+    const auto& _full      = _entry.full;
+    auto        _annotate  = _config.annotate_trace;
 
     // start function
     auto _profiler_call = [&]() {
@@ -508,17 +600,12 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
             _config.annotations.at(0).value = const_cast<char*>(_full.c_str());
             _config.annotations.at(1).value = &_lineno;
             _config.annotations.at(2).value = &_lasti;
-            _config.annotations.at(3).value = &get_frame_code(frame)->co_argcount;
-            _config.annotations.at(4).value = &get_frame_code(frame)->co_nlocals;
-            _config.annotations.at(5).value = &get_frame_code(frame)->co_stacksize;
+            _config.annotations.at(3).value = &_code->co_argcount;
+            _config.annotations.at(4).value = &_code->co_nlocals;
+            _config.annotations.at(5).value = &_code->co_stacksize;
         }
 
-        _config.records.emplace_back([&_label_ref, _annotate]() {
-            omnitrace_pop_category_region(OMNITRACE_CATEGORY_PYTHON, _label_ref.c_str(),
-                                          (_annotate) ? _config.annotations.data()
-                                                      : nullptr,
-                                          _config.annotations.size());
-        });
+        _config.records.emplace_back(region_record{ _label_ref.c_str(), _annotate });
         omnitrace_push_category_region(OMNITRACE_CATEGORY_PYTHON, _label_ref.c_str(),
                                        (_annotate) ? _config.annotations.data() : nullptr,
                                        _config.annotations.size());
@@ -528,8 +615,12 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
     auto _profiler_return = [&]() {
         if(!_config.records.empty())
         {
-            _config.records.back()();
+            auto _record = _config.records.back();
             _config.records.pop_back();
+            omnitrace_pop_category_region(
+                OMNITRACE_CATEGORY_PYTHON, _record.label,
+                (_record.annotate) ? _config.annotations.data() : nullptr,
+                _config.annotations.size());
         }
     };
 
@@ -543,10 +634,53 @@ profiler_function(py::object pframe, const char* swhat, py::object arg)
         default: break;
     }
 
+    return code_decision::profile;
+}
+//
+void
+profiler_function(py::object pframe, const char* swhat, py::object arg)
+{
+    int what = (strcmp(swhat, "call") == 0)       ? PyTrace_CALL
+               : (strcmp(swhat, "c_call") == 0)   ? PyTrace_C_CALL
+               : (strcmp(swhat, "return") == 0)   ? PyTrace_RETURN
+               : (strcmp(swhat, "c_return") == 0) ? PyTrace_C_RETURN
+                                                  : -1;
+    // only support PyTrace_{CALL,C_CALL,RETURN,C_RETURN}
+    if(what < 0)
+    {
+        if(get_config().verbose > 2)
+            TIMEMORY_PRINT_HERE("%s :: %s",
+                                "Ignoring what != {CALL,C_CALL,RETURN,C_RETURN}", swhat);
+        return;
+    }
+
+    profiler_event(std::move(pframe), what, swhat);
+
     // don't do anything with arg
     tim::consume_parameters(arg);
 }
 //
+// sys.monitoring (PEP 669) callbacks for Python 3.12+. The events are processed as the
+// equivalent sys.setprofile events of the executing frame and the events of the code
+// objects which are never profiled are disabled so they no longer invoke the callback
+py::object
+monitoring_event(int what, const char* swhat, bool _can_disable)
+{
+    // leaked because the interpreter is finalized before the static destructors
+    static auto* _disable = new py::object{
+        py::module::import("sys").attr("monitoring").attr("DISABLE")
+    };
+
+    auto* _frame = PyEval_GetFrame();
+    if(!_frame) return py::none();
+
+    auto _decision = profiler_event(
+        py::reinterpret_borrow<py::object>(reinterpret_cast<PyObject*>(_frame)), what,
+        swhat);
+    if(_can_disable && _decision == code_decision::skip) return *_disable;
+    return py::none();
+}
+//
 py::module
 generate(py::module& _pymod)
 {
@@ -575,12 +709,29 @@ generate(py::module& _pymod)
         get_config().is_running       = false;
         get_config().base_stack_depth = -1;
         get_config().records.clear();
+        get_config().code_cache.clear();
     };
 
     auto _sys        = py::module::import("sys");
     auto _setprofile = _sys.attr("setprofile");
 
     _prof.def("profiler_function", &profiler_function, "Profiling function");
+    _prof.def(
+        "monitoring_start",
+        [](py::object, int) { return monitoring_event(PyTrace_CALL, "call", true); },
+        "sys.monitoring callback for PY_START and PY_RESUME");
+    _prof.def(
+        "monitoring_return",
+        [](py::object, int, py::object) {
+            return monitoring_event(PyTrace_RETURN, "return", true);
+        },
+        "sys.monitoring callback for PY_RETURN and PY_YIELD");
+    _prof.def(
+        "monitoring_unwind",
+        [](py::object, int, py::object) {
+            return monitoring_event(PyTrace_RETURN, "return", false);
+        },
+        "sys.monitoring callback for PY_UNWIND (which cannot be disabled)");
     _prof.def("profiler_init", _init, "Initialize the profiler");
     _prof.def("profiler_finalize", _fini, "Finalize the profiler");
     _prof.def(
@@ -601,7 +752,11 @@ generate(py::module& _pymod)
 #define CONFIGURATION_PROPERTY(NAME, TYPE, DOC, ...)                                     \
     _pyconfig.def_property_static(                                                       \
         NAME, [](py::object&&) { return __VA_ARGS__; },                                  \
-        [](py::object&&, TYPE val) { __VA_ARGS__ = val; }, DOC);
+        [](py::object&&, TYPE val) {                                                     \
+            __VA_ARGS__ = val;                                                           \
+            get_config().code_cache.clear();                                             \
+        },                                                                               \
+        DOC);
 
     CONFIGURATION_PROPERTY("_is_running", bool, "Profiler is currently running",
                            get_config().is_running)
@@ -636,6 +791,7 @@ generate(py::module& _pymod)
     static auto _set_strset = [](const py::list& _inp, strset_t& _targ) {
         for(const auto& itr : _inp)
             _targ.insert(itr.cast<std::string>());
+        get_config().code_cache.clear();
     };
 
 #define CONFIGURATION_PROPERTY_LAMBDA(NAME, DOC, GET, SET)                               \
@@ -949,6 +1105,252 @@ generate(py::module& _pymod)
     return _pyuser;
 }
 }  // namespace pyuser
+
+namespace pysampler
+{
+namespace
+{
+// the code objects of the sampled frames are interned into a fixed-size open
+// addressing table from within the sampling signal handler, i.e. without the GIL,
+// locks, or allocations. A recorded frame is the slot of the code object (biased by
+// one) in the upper 32 bits and the line number in the lower 32 bits. The names of
+// the code objects are resolved with the GIL held when a code object is destroyed
+// (the slot is then retired so that a new code object at the same address gets a
+// new slot) and for the remaining code objects when omnitrace is finalized
+constexpr size_t    max_codes  = (1 << 16);
+constexpr size_t    max_probes = 64;
+constexpr size_t    npos       = std::numeric_limits<size_t>::max();
+constexpr uintptr_t retired    = 1;
+
+struct code_info
+{
+    std::string name = {};
+    std::string file = {};
+};
+
+struct code_table
+{
+    std::atomic<bool>                             frozen = { false };
+    std::array<std::atomic<uintptr_t>, max_codes> codes  = {};
+    std::unordered_map<size_t, code_info>         info   = {};  // requires the GIL
+};
+
+code_table&
+get_code_table()
+{
+    static auto* _v = new code_table{};
+    return *_v;
+}
+
+size_t
+get_code_index(uintptr_t _key)
+{
+    return (_key * 0x9e3779b97f4a7c15ULL) >> (64 - 16);
+}
+
+// async-signal-safe
+size_t
+intern_code(PyObject* _code)
+{
+    auto  _key   = reinterpret_cast<uintptr_t>(_code);
+    auto& _codes = get_code_table().codes;
+    auto  _idx   = get_code_index(_key);
+    for(size_t i = 0; i < max_probes; ++i, _idx = (_idx + 1) % max_codes)
+    {
+        auto _v = _codes[_idx].load(std::memory_order_acquire);
+        if(_v == _key) return _idx;
+        if(_v == 0)
+        {
+            if(_codes[_idx].compare_exchange_strong(_v, _key, std::memory_order_acq_rel))
+                return _idx;
+            if(_v == _key) return _idx;
+        }
+    }
+    return npos;
+}
+
+std::string
+get_code_string(PyObject* _v)
+{
+    const char* _str = (_v && PyUnicode_Check(_v)) ? PyUnicode_AsUTF8(_v) : nullptr;
+    if(!_str) PyErr_Clear();
+    return (_str) ? std::string{ _str } : std::string{ "<unknown>" };
+}
+
+// requires the GIL
+void
+resolve_code(size_t _idx, PyObject* _code)
+{
+    auto& _info = get_code_table().info;
+    if(_info.find(_idx) != _info.end()) return;
+
+    // the code object may be resolved while an exception is being handled
+    PyObject* _type  = nullptr;
+    PyObject* _value = nullptr;
+    PyObject* _trace = nullptr;
+    PyErr_Fetch(&_type, &_value, &_trace);
+    auto* _pycode = reinterpret_cast<PyCodeObject*>(_code);
+    _info.emplace(_idx, code_info{ get_code_string(_pycode->co_name),
+                                   get_code_string(_pycode->co_filename) });
+    PyErr_Restore(_type, _value, _trace);
+}
+
+// invoked with the GIL held before the code object is deallocated
+void
+retire_code(PyObject* _code)
+{
+    auto& _table = get_code_table();
+    if(_table.frozen.load()) return;
+
+    auto _key = reinterpret_cast<uintptr_t>(_code);
+    auto _idx = get_code_index(_key);
+    for(size_t i = 0; i < max_probes; ++i, _idx = (_idx + 1) % max_codes)
+    {
+        auto _v = _table.codes[_idx].load(std::memory_order_acquire);
+        if(_v == 0) return;
+        if(_v == _key)
+        {
+            resolve_code(_idx, _code);
+            _table.codes[_idx].store(retired, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+#if OMNITRACE_PYTHON_VERSION >= 31200
+int
+code_watcher(PyCodeEvent _event, PyCodeObject* _code)
+{
+    if(_event == PY_CODE_EVENT_DESTROY) retire_code(reinterpret_cast<PyObject*>(_code));
+    return 0;
+}
+#else
+destructor&
+get_code_dealloc()
+{
+    static destructor _v = nullptr;
+    return _v;
+}
+
+void
+code_dealloc(PyObject* _code)
+{
+    retire_code(_code);
+    get_code_dealloc()(_code);
+}
+#endif
+
+size_t
+record_frame(uintptr_t* _addr, PyObject* _code, int _line)
+{
+    auto _idx = intern_code(_code);
+    if(_idx == npos) return 0;
+    *_addr = ((_idx + 1) << 32) | static_cast<uint32_t>(_line);
+    return 1;
+}
+
+// walks the frames of the interrupted thread from within the sampling signal
+// handler. The thread state is read without the GIL: the frames of the thread
+// cannot change while the thread is interrupted
+size_t
+sample_stack(uintptr_t* _addrs, size_t _capacity)
+{
+    if(get_code_table().frozen.load(std::memory_order_relaxed)) return 0;
+
+    auto* _tstate = PyGILState_GetThisThreadState();
+    if(!_tstate) return 0;
+
+    size_t _n = 0;
+#if OMNITRACE_PYTHON_VERSION >= 31300
+    for(auto* _frame = _tstate->current_frame; _frame && _n < _capacity;
+        _frame       = _frame->previous)
+    {
+        if(_PyFrame_IsIncomplete(_frame) || !PyCode_Check(_frame->f_executable))
+            continue;
+        _n += record_frame(_addrs + _n, _frame->f_executable,
+                           PyUnstable_InterpreterFrame_GetLine(_frame));
+    }
+#elif OMNITRACE_PYTHON_VERSION >= 31100
+    auto* _cframe = _tstate->cframe;
+    for(auto* _frame = (_cframe) ? _cframe->current_frame : nullptr;
+        _frame && _n < _capacity; _frame = _frame->previous)
+    {
+        if(_PyFrame_IsIncomplete(_frame)) continue;
+#    if OMNITRACE_PYTHON_VERSION >= 31200
+        auto _line = PyUnstable_InterpreterFrame_GetLine(_frame);
+#    else
+        auto _line = PyCode_Addr2Line(
+            _frame->f_code, _PyInterpreterFrame_LASTI(_frame) * sizeof(_Py_CODEUNIT));
+#    endif
+        _n += record_frame(_addrs + _n, reinterpret_cast<PyObject*>(_frame->f_code),
+                           _line);
+    }
+#else
+    for(auto* _frame = _tstate->frame; _frame && _n < _capacity;
+        _frame       = _frame->f_back)
+    {
+        _n += record_frame(_addrs + _n, reinterpret_cast<PyObject*>(_frame->f_code),
+                           PyFrame_GetLineNumber(_frame));
+    }
+#endif
+    return _n;
+}
+
+// invoked during post-processing, i.e. after the table has been frozen
+int
+resolve_frame(uintptr_t _frame, const char** _name, const char** _file, int* _line)
+{
+    auto& _table = get_code_table();
+    auto  _idx   = static_cast<size_t>(_frame >> 32);
+    if(!_table.frozen.load() || _idx == 0 || _idx > max_codes) return -1;
+
+    auto itr = _table.info.find(_idx - 1);
+    if(itr == _table.info.end()) return -1;
+
+    *_name = itr->second.name.c_str();
+    *_file = itr->second.file.c_str();
+    *_line = static_cast<int32_t>(_frame & 0xffffffff);
+    return 0;
+}
+}  // namespace
+
+void
+initialize()
+{
+#if OMNITRACE_PYTHON_VERSION < 31400
+    static auto _once = []() {
+#    if OMNITRACE_PYTHON_VERSION >= 31200
+        if(PyCode_AddWatcher(code_watcher) < 0)
+        {
+            PyErr_Clear();
+            return false;
+        }
+#    else
+        get_code_dealloc()     = PyCode_Type.tp_dealloc;
+        PyCode_Type.tp_dealloc = code_dealloc;
+#    endif
+        omnitrace_register_python_sampler(sample_stack, resolve_frame);
+        return true;
+    }();
+    (void) _once;
+#endif
+}
+
+// resolves the names of the sampled code objects which are still alive. Subsequent
+// samples do not record any Python frames
+void
+finalize()
+{
+    auto& _table = get_code_table();
+    if(_table.frozen.exchange(true)) return;
+
+    for(size_t i = 0; i < max_codes; ++i)
+    {
+        auto _v = _table.codes[i].load(std::memory_order_acquire);
+        if(_v != 0 && _v != retired) resolve_code(i, reinterpret_cast<PyObject*>(_v));
+    }
+}
+}  // namespace pysampler
 }  // namespace pyomnitrace
 //
 //======================================================================================//
@@ -48,6 +48,9 @@ from .libpyomnitrace.profiler import profiler_init as _profiler_init
 from .libpyomnitrace.profiler import profiler_finalize as _profiler_fini
 from .libpyomnitrace.profiler import profiler_pause as _profiler_pause
 from .libpyomnitrace.profiler import profiler_resume as _profiler_resume
+from .libpyomnitrace.profiler import monitoring_start as _monitoring_start
+from .libpyomnitrace.profiler import monitoring_return as _monitoring_return
+from .libpyomnitrace.profiler import monitoring_unwind as _monitoring_unwind
 
 __all__ = [
     "profile",
@@ -67,6 +70,62 @@ def _default_functor():
     return True
 
 
+# sys.monitoring (PEP 669) is available in Python 3.12+
+_monitoring = getattr(sys, "monitoring", None)
+
+
+def _use_monitoring():
+    """Checks whether the sys.monitoring backend should be used. Tracing the C
+    functions requires sys.setprofile and setting OMNITRACE_PYTHON_MONITORING=OFF
+    forces sys.setprofile"""
+
+    if _monitoring is None or _profiler_config.trace_c:
+        return False
+    _env = os.environ.get("OMNITRACE_PYTHON_MONITORING", "ON")
+    return _env.lower() not in ("0", "n", "no", "off", "false")
+
+
+def _monitoring_callbacks():
+    _events = _monitoring.events
+    return {
+        _events.PY_START: _monitoring_start,
+        _events.PY_RESUME: _monitoring_start,
+        _events.PY_RETURN: _monitoring_return,
+        _events.PY_YIELD: _monitoring_return,
+        _events.PY_UNWIND: _monitoring_unwind,
+    }
+
+
+def _start_monitoring():
+    """Registers the callbacks under the profiler tool id of sys.monitoring. Returns
+    False if the tool id is already used by another profiler"""
+
+    _tool = _monitoring.PROFILER_ID
+    try:
+        _monitoring.use_tool_id(_tool, "omnitrace")
+    except ValueError:
+        return False
+
+    _mask = 0
+    for _event, _callback in _monitoring_callbacks().items():
+        _monitoring.register_callback(_tool, _event, _callback)
+        _mask |= _event
+    _monitoring.set_events(_tool, _mask)
+    # the events disabled with a previous configuration are re-enabled
+    _monitoring.restart_events()
+    return True
+
+
+def _stop_monitoring():
+    """Unregisters the callbacks and releases the profiler tool id"""
+
+    _tool = _monitoring.PROFILER_ID
+    _monitoring.set_events(_tool, 0)
+    for _event in _monitoring_callbacks().keys():
+        _monitoring.register_callback(_tool, _event, None)
+    _monitoring.free_tool_id(_tool)
+
+
 class Profiler:
     """Provides decorators and context-manager for the omnitrace profilers"""
 
@@ -97,6 +156,7 @@ class Profiler:
             sys.getprofile() if sys.getprofile() != _profiler_function else None
         )
         self._unset = 0
+        self._monitoring = False
         self._use = (
             not _profiler_config._is_running
             and Profiler.is_enabled() is True
@@ -147,8 +207,10 @@ class Profiler:
             if self.debug:
                 sys.stderr.write("Profiler starting...\n")
             self.configure()
-            sys.setprofile(_profiler_function)
-            threading.setprofile(_profiler_function)
+            self._monitoring = _use_monitoring() and _start_monitoring()
+            if not self._monitoring:
+                sys.setprofile(_profiler_function)
+                threading.setprofile(_profiler_function)
             if self.debug:
                 sys.stderr.write("Profiler started...\n")
 
@@ -162,6 +224,9 @@ class Profiler:
         if self._unset == 0:
             if self.debug:
                 sys.stderr.write("Profiler stopping...\n")
+            if self._monitoring:
+                _stop_monitoring()
+                self._monitoring = False
             sys.setprofile(self._original_function)
             _profiler_fini()
             if self.debug:
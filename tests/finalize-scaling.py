@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+
+"""
+Runs the finalize-scaling workload over a sweep of threads, regions, iterations,
+spin durations and MPI ranks and collects the OMNITRACE_FINALIZE_TIMINGS_FILE rows
+of every run into a single CSV with the workload parameters prepended, e.g.:
+
+    finalize-scaling.py -l ./bin/omnitrace-sample -w ./bin/finalize-scaling
+        -t 1 4 16 -r 100 1000 -o finalize-scaling.csv
+"""
+
+import os
+import csv
+import sys
+import shlex
+import argparse
+import itertools
+import subprocess
+import tempfile
+
+
+def run(args, params):
+    _threads, _regions, _iterations, _spin, _ranks = params
+    _cmd = []
+    if _ranks > 1:
+        if not args.mpiexec:
+            raise RuntimeError("--mpiexec is required for more than one rank")
+        _cmd += shlex.split(args.mpiexec) + ["-n", f"{_ranks}"]
+    _cmd += args.launcher + ["--", args.workload]
+    _cmd += ["--threads", f"{_threads}", "--regions", f"{_regions}"]
+    _cmd += ["--iterations", f"{_iterations}", "--spin-usec", f"{_spin}"]
+
+    with tempfile.TemporaryDirectory(prefix="omnitrace-finalize-scaling-") as _dir:
+        _fname = os.path.join(_dir, "timings.csv")
+        _env = dict(os.environ)
+        _env["OMNITRACE_FINALIZE_TIMINGS_FILE"] = _fname
+        _env.setdefault("OMNITRACE_OUTPUT_PATH", os.path.join(_dir, "output"))
+
+        print(f"[finalize-scaling] {' '.join(_cmd)}", flush=True)
+        _proc = subprocess.run(_cmd, env=_env, stdout=subprocess.DEVNULL)
+        if _proc.returncode != 0:
+            raise RuntimeError(f"'{' '.join(_cmd)}' exited with {_proc.returncode}")
+        if not os.path.exists(_fname):
+            raise RuntimeError(f"'{' '.join(_cmd)}' did not write {_fname}")
+
+        with open(_fname, "r") as f:
+            return [row for row in csv.DictReader(f)]
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    parser.add_argument(
+        "-l",
+        "--launcher",
+        nargs="+",
+        type=str,
+        required=True,
+        help="omnitrace-sample or omnitrace-run (and their arguments)",
+    )
+    parser.add_argument(
+        "-w", "--workload", type=str, required=True, help="finalize-scaling executable"
+    )
+    parser.add_argument("-t", "--threads", nargs="+", type=int, default=[1])
+    parser.add_argument("-r", "--regions", nargs="+", type=int, default=[100])
+    parser.add_argument("-i", "--iterations", nargs="+", type=int, default=[1000])
+    parser.add_argument("-s", "--spin-usec", nargs="+", type=int, default=[10])
+    parser.add_argument("-n", "--ranks", nargs="+", type=int, default=[1])
+    parser.add_argument(
+        "-m", "--mpiexec", type=str, default=None, help="MPI launcher (and its arguments)"
+    )
+    parser.add_argument("-R", "--repeat", type=int, default=1)
+    parser.add_argument("-o", "--output", type=str, default="finalize-scaling.csv")
+    args = parser.parse_args()
+
+    _params = ["threads", "regions", "iterations", "spin_usec", "ranks"]
+    _rows = []
+    for params in itertools.product(
+        args.threads, args.regions, args.iterations, args.spin_usec, args.ranks
+    ):
+        for _repeat in range(args.repeat):
+            for row in run(args, params):
+                _rows.append(dict(zip(_params + ["repeat"], list(params) + [_repeat])))
+                _rows[-1].update(row)
+
+    if not _rows:
+        sys.exit("[finalize-scaling] no timings were collected")
+
+    with open(args.output, "w") as f:
+        _writer = csv.DictWriter(f, fieldnames=list(_rows[0].keys()))
+        _writer.writeheader()
+        _writer.writerows(_rows)
+
+    print(f"[finalize-scaling] wrote {len(_rows)} rows to {args.output}")
@@ -0,0 +1,77 @@
+# -------------------------------------------------------------------------------------- #
+#
+# omnitrace-ctl tests
+#
+# -------------------------------------------------------------------------------------- #
+
+if(NOT TARGET omnitrace-ctl
+   OR NOT TARGET omnitrace-sample
+   OR NOT TARGET parallel-overhead)
+    return()
+endif()
+
+# turns off a category of the running process and verifies the override via the
+# listing of the control file
+add_test(
+    NAME parallel-overhead-ctl
+    COMMAND
+        ${CMAKE_CURRENT_LIST_DIR}/run-omnitrace-ctl.sh $<TARGET_FILE:omnitrace-ctl>
+        --disable pthread --list -- $<TARGET_FILE:omnitrace-sample> --
+        $<TARGET_FILE:parallel-overhead> 30 4 1000
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+set(_parallel_overhead_ctl_environ
+    "${_base_environment}" "OMNITRACE_CONTROL_FILE=ON"
+    "OMNITRACE_OUTPUT_PATH=omnitrace-tests-output"
+    "OMNITRACE_OUTPUT_PREFIX=parallel-overhead-ctl/")
+
+set_tests_properties(
+    parallel-overhead-ctl
+    PROPERTIES ENVIRONMENT
+               "${_parallel_overhead_ctl_environ}"
+               TIMEOUT
+               300
+               LABELS
+               "parallel-overhead;omnitrace-ctl"
+               PASS_REGULAR_EXPRESSION
+               "changes   : [1-9].*pthread +off"
+               FAIL_REGULAR_EXPRESSION
+               "Exiting with code: [^0]")
+
+# the exits from filtered user regions which are closed out of order and from the
+# recursive calls of a function whose filter is removed during the recursion are
+# matched to the correct entries. ctl-regions is built in tests/source
+add_test(
+    NAME ctl-regions
+    COMMAND $<TARGET_FILE:omnitrace-run> -- $<TARGET_FILE:ctl-regions>
+            $<TARGET_FILE:omnitrace-ctl> 10
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+set(_ctl_regions_environ
+    "${_base_environment}"
+    "OMNITRACE_CONTROL_FILE=ON"
+    "OMNITRACE_USE_SAMPLING=OFF"
+    "OMNITRACE_USE_PROCESS_SAMPLING=OFF"
+    "OMNITRACE_USE_PID=OFF"
+    "OMNITRACE_OUTPUT_PATH=${PROJECT_BINARY_DIR}/omnitrace-tests-output"
+    "OMNITRACE_OUTPUT_PREFIX=ctl-regions/")
+
+set_tests_properties(
+    ctl-regions
+    PROPERTIES ENVIRONMENT
+               "${_ctl_regions_environ}"
+               TIMEOUT
+               120
+               LABELS
+               "omnitrace-ctl"
+               PASS_REGULAR_EXPRESSION
+               "\\[ctl-regions\\] done"
+               FAIL_REGULAR_EXPRESSION
+               "(${OMNITRACE_ABORT_FAIL_REGEX})")
+
+omnitrace_add_validation_test(
+    NAME ctl-regions
+    TIMEMORY_METRIC "wall_clock"
+    TIMEMORY_FILE "wall_clock.json"
+    LABELS "omnitrace-ctl"
+    ARGS -l setup inner recurse recurse -c 1 10 1 1 -d 0 0 0 1 -p)
@@ -0,0 +1,94 @@
+# -------------------------------------------------------------------------------------- #
+#
+# omnitrace-diff tests
+#
+# -------------------------------------------------------------------------------------- #
+
+if(NOT TARGET omnitrace-diff OR NOT TARGET parallel-overhead)
+    return()
+endif()
+
+set(_diff_output ${PROJECT_BINARY_DIR}/omnitrace-tests-output/omnitrace-diff)
+
+# two runs of the same example are the baseline and the candidate. The comparisons
+# check the exit code so the output is only checked with a fail regex
+foreach(_RUN baseline candidate)
+    add_test(
+        NAME omnitrace-diff-${_RUN}
+        COMMAND $<TARGET_FILE:omnitrace-sample> -- $<TARGET_FILE:parallel-overhead> 30 2
+                200
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+    set_tests_properties(
+        omnitrace-diff-${_RUN}
+        PROPERTIES ENVIRONMENT
+                   "${_timemory_environment};OMNITRACE_OUTPUT_PATH=${_diff_output};OMNITRACE_OUTPUT_PREFIX=${_RUN}/"
+                   TIMEOUT
+                   120
+                   LABELS
+                   "omnitrace-diff"
+                   FIXTURES_SETUP
+                   omnitrace-diff-runs
+                   PASS_REGULAR_EXPRESSION
+                   "${_RUN}/sampling_wall_clock.json")
+endforeach()
+
+add_test(
+    NAME omnitrace-diff-runs
+    COMMAND
+        $<TARGET_FILE:omnitrace-diff> --monochrome -m sampling_wall_clock -b
+        ${_diff_output}/baseline/sampling_wall_clock.json -c
+        ${_diff_output}/candidate/sampling_wall_clock.json -o
+        ${_diff_output}/omnitrace-diff.csv
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+# a run compared with itself has no significant change so --fail-on-regression exits
+# with zero
+add_test(
+    NAME omnitrace-diff-identical
+    COMMAND
+        $<TARGET_FILE:omnitrace-diff> --monochrome -m sampling_wall_clock -b
+        ${_diff_output}/baseline/sampling_wall_clock.json -c
+        ${_diff_output}/baseline/sampling_wall_clock.json --fail-on-regression
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+add_test(
+    NAME omnitrace-diff-missing-input
+    COMMAND
+        $<TARGET_FILE:omnitrace-diff> --monochrome -b
+        ${_diff_output}/baseline/sampling_wall_clock.json -c
+        ${_diff_output}/missing/sampling_wall_clock.json
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+set_tests_properties(
+    omnitrace-diff-runs
+    PROPERTIES TIMEOUT
+               60
+               LABELS
+               "omnitrace-diff"
+               FIXTURES_REQUIRED
+               omnitrace-diff-runs
+               FAIL_REGULAR_EXPRESSION
+               "(^|[^0-9])0 regions compared")
+
+set_tests_properties(
+    omnitrace-diff-identical
+    PROPERTIES TIMEOUT
+               60
+               LABELS
+               "omnitrace-diff"
+               FIXTURES_REQUIRED
+               omnitrace-diff-runs
+               FAIL_REGULAR_EXPRESSION
+               "(^|[^0-9])0 regions compared|[1-9][0-9]* (regressions|improvements)")
+
+set_tests_properties(
+    omnitrace-diff-missing-input
+    PROPERTIES TIMEOUT
+               60
+               LABELS
+               "omnitrace-diff"
+               FIXTURES_REQUIRED
+               omnitrace-diff-runs
+               WILL_FAIL
+               ON)
@@ -0,0 +1,24 @@
+# -------------------------------------------------------------------------------------- #
+#
+# heap profile tests
+#
+# -------------------------------------------------------------------------------------- #
+
+# a small sampling interval so that the few allocations of the example are sampled
+set(_heap_profile_environment "${_base_environment}" "OMNITRACE_HEAP_PROFILE=ON"
+                              "OMNITRACE_HEAP_PROFILE_RATE=64")
+
+set(_heap_profile_pass_regex "Heap profile :: [1-9][0-9]* call-sites(.*)heap-profile.txt")
+
+omnitrace_add_test(
+    SKIP_BASELINE
+    NAME heap-profile
+    TARGET parallel-overhead
+    RUN_ARGS 30 2 200
+    REWRITE_ARGS -e -v 2
+    RUNTIME_ARGS -e -v 1
+    LABELS "heap-profile"
+    ENVIRONMENT "${_heap_profile_environment}"
+    SAMPLING_PASS_REGEX "${_heap_profile_pass_regex}"
+    RUNTIME_PASS_REGEX "${_heap_profile_pass_regex}"
+    REWRITE_RUN_PASS_REGEX "${_heap_profile_pass_regex}")
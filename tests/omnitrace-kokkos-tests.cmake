@@ -122,3 +122,16 @@ omnitrace_add_test(
     RUN_ARGS -i 10 -s 20 -p
     ENVIRONMENT "${_timemory_environment};OMNITRACE_USE_KOKKOSP=OFF"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
+
+omnitrace_add_test(
+    SKIP_RUNTIME SKIP_REWRITE
+    NAME lulesh-kokkosp-memory
+    TARGET lulesh
+    MPI ${LULESH_USE_MPI}
+    GPU ${LULESH_USE_GPU}
+    NUM_PROCS 8
+    LABELS "kokkos;kokkos-profile-library"
+    RUN_ARGS -i 10 -s 20 -p
+    ENVIRONMENT
+        "${_base_environment};OMNITRACE_USE_KOKKOSP=ON;OMNITRACE_KOKKOSP_DEEP_COPY=ON;OMNITRACE_KOKKOSP_MEMORY_TOP=5;KOKKOS_PROFILE_LIBRARY=libomnitrace-dl.so"
+    BASELINE_PASS_REGEX "Kokkos memory :: [a-zA-Z]+ :: [0-9]+ allocations")
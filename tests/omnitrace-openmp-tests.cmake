@@ -37,6 +37,17 @@ omnitrace_add_test(
     REWRITE_RUN_PASS_REGEX "${_OMPT_PASS_REGEX}"
     REWRITE_FAIL_REGEX "0 instrumented loops in procedure")
 
+if(OMNITRACE_OPENMP_USING_LIBOMP_LIBRARY AND OMNITRACE_USE_OMPT)
+    omnitrace_add_test(
+        SKIP_RUNTIME SKIP_REWRITE SKIP_SAMPLING
+        NAME openmp-cg-imbalance
+        TARGET openmp-cg
+        LABELS "openmp"
+        ENVIRONMENT
+            "${_ompt_environment};OMNITRACE_USE_SAMPLING=OFF;OMNITRACE_OMPT_IMBALANCE=ON;OMNITRACE_COUT_OUTPUT=ON"
+        BASELINE_PASS_REGEX "omp_imbalance(.*)omp_wait_fraction")
+endif()
+
 set(_ompt_sampling_environ
     "${_ompt_environment}"
     "OMNITRACE_VERBOSE=2"
@@ -0,0 +1,171 @@
+# -------------------------------------------------------------------------------------- #
+#
+# perfetto output tests
+#
+# -------------------------------------------------------------------------------------- #
+
+if(OMNITRACE_USE_ZLIB)
+    omnitrace_add_test(
+        SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+        NAME perfetto-gzip
+        TARGET trace-time-window
+        REWRITE_ARGS -e -v 2 --caller-include inner -i 4096
+        LABELS "perfetto;compression"
+        ENVIRONMENT "${_window_environment};OMNITRACE_PERFETTO_COMPRESSION=gzip"
+        REWRITE_RUN_PASS_REGEX "perfetto-trace.proto.gz(.*)gzip compressed to")
+
+    omnitrace_add_validation_test(
+        NAME perfetto-gzip-binary-rewrite
+        PERFETTO_METRIC "host"
+        PERFETTO_FILE "perfetto-trace.proto.gz"
+        LABELS "perfetto;compression"
+        ARGS -l
+             trace-time-window.inst
+             outer_a
+             outer_b
+             outer_c
+             outer_d
+             outer_e
+             -c
+             1
+             1
+             1
+             1
+             1
+             1
+             -d
+             0
+             1
+             1
+             1
+             1
+             1
+             -p)
+
+    # the ranks compress their traces separately and the gzip members are concatenated
+    # into the combined trace via MPI-IO
+    if(OMNITRACE_USE_MPI)
+        omnitrace_add_test(
+            SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+            NAME perfetto-gzip-mpi
+            TARGET mpi-example
+            MPI ON
+            NUM_PROCS 2
+            REWRITE_ARGS -e -v 2 --min-instructions 0
+            LABELS "perfetto;compression;mpi"
+            ENVIRONMENT "${_base_environment}" "OMNITRACE_PERFETTO_COMBINE_TRACES=ON"
+                        "OMNITRACE_PERFETTO_COMPRESSION=gzip"
+            REWRITE_RUN_PASS_REGEX "perfetto-trace-0.proto.gz")
+
+        omnitrace_add_validation_test(
+            NAME perfetto-gzip-mpi-binary-rewrite
+            PERFETTO_METRIC "host"
+            PERFETTO_FILE "perfetto-trace-0.proto.gz"
+            LABELS "perfetto;compression;mpi"
+            ARGS -p)
+    endif()
+endif()
+
+# the instrumented functions are recorded in the per-thread event logs and converted to
+# perfetto slices during finalization. Unpaired entries/exits would change the depths
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+    NAME perfetto-event-log
+    TARGET trace-time-window
+    REWRITE_ARGS -e -v 2 --caller-include inner -i 4096
+    LABELS "perfetto;event-log"
+    ENVIRONMENT "${_window_environment};OMNITRACE_TRACE_EVENT_LOG=ON"
+    REWRITE_RUN_PASS_REGEX
+        "\\[event_log\\] converted [1-9][0-9]* records(.*)perfetto-trace.proto")
+
+omnitrace_add_validation_test(
+    NAME perfetto-event-log-binary-rewrite
+    PERFETTO_METRIC "host"
+    PERFETTO_FILE "perfetto-trace.proto"
+    LABELS "perfetto;event-log"
+    ARGS -l
+         trace-time-window.inst
+         outer_a
+         outer_b
+         outer_c
+         outer_d
+         outer_e
+         -c
+         1
+         1
+         1
+         1
+         1
+         1
+         -d
+         0
+         1
+         1
+         1
+         1
+         1
+         -p)
+
+# the functions of trace-time-window take 0.5 seconds so the first one which returns
+# exceeds the threshold and triggers the only snapshot
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+    NAME perfetto-snapshot
+    TARGET trace-time-window
+    REWRITE_ARGS -e -v 2 --caller-include inner -i 4096
+    LABELS "perfetto;snapshot"
+    ENVIRONMENT
+        "${_window_environment}" "OMNITRACE_PERFETTO_SNAPSHOT=ON"
+        "OMNITRACE_PERFETTO_SNAPSHOT_THRESHOLD=0.25" "OMNITRACE_PERFETTO_SNAPSHOT_LIMIT=1"
+    REWRITE_RUN_PASS_REGEX "perfetto-trace-snapshot-0.proto"
+    REWRITE_RUN_FAIL_REGEX
+        "perfetto\\] snapshot [0-9]+ (timed out|failed)|OMNITRACE_ABORT_FAIL_REGEX")
+
+omnitrace_add_validation_test(
+    NAME perfetto-snapshot-binary-rewrite
+    PERFETTO_METRIC "host"
+    PERFETTO_FILE "perfetto-trace-snapshot-0.proto"
+    LABELS "perfetto;snapshot"
+    ARGS -p)
+
+# the events of the first 20 iterations are always written so every slice is expected
+set(_iteration_pass_regex
+    "\\[iteration\\] wrote the perfetto events of 3 of 3 'outer_b' iterations")
+
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING SKIP_RUNTIME
+    NAME perfetto-iteration
+    TARGET trace-time-window
+    RUN_ARGS 3
+    REWRITE_ARGS -e -v 2 --caller-include inner -i 4096
+    LABELS "perfetto;iteration"
+    ENVIRONMENT "${_window_environment};OMNITRACE_PERFETTO_ITERATION_REGION=outer_b"
+    REWRITE_RUN_PASS_REGEX "${_iteration_pass_regex}(.*)perfetto-trace.proto")
+
+omnitrace_add_validation_test(
+    NAME perfetto-iteration-binary-rewrite
+    PERFETTO_METRIC "host"
+    PERFETTO_FILE "perfetto-trace.proto"
+    LABELS "perfetto;iteration"
+    ARGS -l
+         trace-time-window.inst
+         outer_a
+         outer_b
+         outer_c
+         outer_d
+         outer_e
+         -c
+         1
+         3
+         3
+         3
+         3
+         3
+         -d
+         0
+         1
+         1
+         1
+         1
+         1
+         -p)
@@ -0,0 +1,64 @@
+# -------------------------------------------------------------------------------------- #
+#
+# omnitrace-post tests
+#
+# -------------------------------------------------------------------------------------- #
+
+if(NOT TARGET omnitrace-post
+   OR NOT TARGET omnitrace-sample
+   OR NOT TARGET parallel-overhead)
+    return()
+endif()
+
+set(_post_output ${PROJECT_BINARY_DIR}/omnitrace-tests-output/omnitrace-post-deferred)
+set(_post_environment
+    "${_base_environment}"
+    "OMNITRACE_DEFER_POST_PROCESSING=ON"
+    "OMNITRACE_USE_PID=OFF"
+    "OMNITRACE_OUTPUT_PATH=${PROJECT_BINARY_DIR}/omnitrace-tests-output"
+    "OMNITRACE_OUTPUT_PREFIX=omnitrace-post-deferred/")
+
+# the samples are written to raw-samples.bin (without the pid) instead of being
+# post-processed and omnitrace-post converts them into a trace and a flat profile
+add_test(
+    NAME omnitrace-post-deferred
+    COMMAND $<TARGET_FILE:omnitrace-sample> -- $<TARGET_FILE:parallel-overhead> 30 2 200
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+add_test(
+    NAME omnitrace-post-deferred-post
+    COMMAND $<TARGET_FILE:omnitrace-post> --monochrome -i ${_post_output}/raw-samples.bin
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR})
+
+set_tests_properties(
+    omnitrace-post-deferred
+    PROPERTIES
+        ENVIRONMENT
+        "${_post_environment}"
+        TIMEOUT
+        120
+        LABELS
+        "omnitrace-post"
+        FIXTURES_SETUP
+        omnitrace-post-deferred)
+
+set_tests_properties(
+    omnitrace-post-deferred-post
+    PROPERTIES TIMEOUT
+               120
+               LABELS
+               "omnitrace-post"
+               DEPENDS
+               omnitrace-post-deferred
+               FIXTURES_REQUIRED
+               omnitrace-post-deferred
+               REQUIRED_FILES
+               "${_post_output}/raw-samples.bin")
+
+omnitrace_add_validation_test(
+    NAME omnitrace-post-deferred
+    PERFETTO_METRIC "sampling"
+    PERFETTO_FILE "raw-samples-perfetto-trace.json"
+    LABELS "omnitrace-post"
+    DEPENDS omnitrace-post-deferred-post
+    ARGS -p)
@@ -112,3 +112,39 @@ omnitrace_add_validation_test(
          0
          0
          -p)
+
+# two windows: [0.25, 0.75) and [1.75, 2.25). Each one opens while a function entered
+# outside of it is running (outer_a, outer_d) and closes while a function entered inside
+# of it is running (outer_b, outer_e)
+omnitrace_add_test(
+    SKIP_BASELINE SKIP_SAMPLING ${_TRACE_WINDOW_SKIP}
+    NAME trace-time-window-periods
+    TARGET trace-time-window
+    REWRITE_ARGS -e -v 2 --caller-include inner -i 4096
+    RUNTIME_ARGS -e -v 1 --caller-include inner -i 4096
+    LABELS "time-window"
+    ENVIRONMENT "${_window_environment};OMNITRACE_TRACE_PERIODS=0.25:0.5 1.0:0.5"
+    REWRITE_RUN_FAIL_REGEX
+        "was called more times than|OMNITRACE_ABORT_FAIL_REGEX"
+    RUNTIME_FAIL_REGEX "was called more times than|OMNITRACE_ABORT_FAIL_REGEX")
+
+foreach(_TEST binary-rewrite runtime-instrument)
+    omnitrace_add_validation_test(
+        NAME trace-time-window-periods-${_TEST}
+        TIMEMORY_METRIC "wall_clock"
+        TIMEMORY_FILE "wall_clock.json"
+        PERFETTO_METRIC "host"
+        PERFETTO_FILE "perfetto-trace.proto"
+        LABELS "time-window"
+        FAIL_REGEX "outer_a|outer_c|outer_d|OMNITRACE_ABORT_FAIL_REGEX"
+        ARGS -l
+             outer_b
+             outer_e
+             -c
+             1
+             1
+             -d
+             0
+             0
+             -p)
+endforeach()
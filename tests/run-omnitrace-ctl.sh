@@ -0,0 +1,63 @@
+#!/bin/bash
+#
+#   usage: run-omnitrace-ctl.sh <omnitrace-ctl> [<args>...] -- <command> [<args>...]
+#
+#   runs the command in the background and applies the omnitrace-ctl arguments to the
+#   running process once its control file exists. The command must be run with
+#   OMNITRACE_CONTROL_FILE=ON
+#
+
+cleanup()
+{
+    kill -s 9 ${_PID}
+}
+
+trap cleanup SIGABRT SIGQUIT
+
+CTL_COMMAND=""
+
+while [[ $# -gt 0 ]]
+do
+    if [ "${1}" == "--" ]; then
+        shift
+        break
+    else
+        CTL_COMMAND="${CTL_COMMAND}${1} "
+        shift
+    fi
+done
+
+${@} &
+_PID=$!
+
+if [ "${_PID}" = "" ]; then
+    echo "Error! No PID for \"${@}\""
+    exit -1
+fi
+
+echo "PID: ${_PID}"
+echo ""
+
+# the control file is created during the initialization of omnitrace
+for i in $(seq 1 300)
+do
+    ${CTL_COMMAND%% *} -p ${_PID} --list &> /dev/null && break
+    if ! kill -0 ${_PID} &> /dev/null; then
+        echo "Error! \"${1}\" exited before the control file was created"
+        exit -1
+    fi
+    sleep 0.1
+done
+
+${CTL_COMMAND} -p ${_PID}
+RET=$?
+
+wait ${_PID}
+APP_RET=$?
+
+if [ ${RET} -eq 0 ]; then
+    RET=${APP_RET}
+fi
+
+echo "Exiting with code: ${RET}"
+exit ${RET}
@@ -0,0 +1,105 @@
+// exercises the matching of the exits to the entries which were filtered out by
+// omnitrace-ctl. The executable applies the filters to itself so the changes happen at
+// well-defined points:
+//
+//  - user regions which are closed out of order while one of them is excluded:
+//    push outer (excluded), push inner, pop outer, pop inner
+//  - a recursive function whose exclusion is removed in the middle of the recursion
+//
+//  usage: ctl-regions <omnitrace-ctl> [<iterations>]
+//
+// The executable must be launched via omnitrace-run with OMNITRACE_CONTROL_FILE=ON
+
+#include <omnitrace/user.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+extern "C"
+{
+    // exported by libomnitrace-dl. Weak so that the executable can be run without it
+    void omnitrace_push_trace(const char*) __attribute__((weak));
+    void omnitrace_pop_trace(const char*) __attribute__((weak));
+}
+
+namespace
+{
+std::string ctl_command = {};
+
+// the control functions are applied by a child process so it must not be instrumented
+int
+run_ctl(const std::string& _args)
+{
+    auto _cmd = std::string{ "env -u LD_PRELOAD " } + ctl_command + " -p " +
+                std::to_string(getpid()) + " " + _args;
+    printf("[ctl-regions] %s\n", _cmd.c_str());
+    fflush(stdout);
+    return std::system(_cmd.c_str());
+}
+
+void
+recurse(int _depth, int _clear_depth)
+{
+    omnitrace_push_trace("recurse");
+    if(_depth == _clear_depth) run_ctl("--clear");
+    if(_depth > 0) recurse(_depth - 1, _clear_depth);
+    omnitrace_pop_trace("recurse");
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        fprintf(stderr, "usage: %s <omnitrace-ctl> [<iterations>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(!omnitrace_push_trace || !omnitrace_pop_trace)
+    {
+        fprintf(stderr, "[ctl-regions] must be launched via omnitrace-run\n");
+        return EXIT_FAILURE;
+    }
+
+    ctl_command = argv[1];
+    int _nitr   = (argc > 2) ? atoi(argv[2]) : 10;
+
+    // the control file is created during the initialization of omnitrace
+    omnitrace_user_push_region("setup");
+    omnitrace_user_pop_region("setup");
+
+    int _ret = -1;
+    for(int i = 0; i < 100 && _ret != 0; ++i)
+    {
+        if(i > 0) std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+        _ret = run_ctl("--list > /dev/null 2>&1");
+    }
+
+    if(_ret != 0)
+    {
+        fprintf(stderr, "[ctl-regions] the control file was not created\n");
+        return EXIT_FAILURE;
+    }
+
+    // only inner is recorded. The exit from outer is skipped and inner is closed
+    if(run_ctl("--exclude outer") != 0) return EXIT_FAILURE;
+    for(int i = 0; i < _nitr; ++i)
+    {
+        omnitrace_user_push_region("outer");
+        omnitrace_user_push_region("inner");
+        omnitrace_user_pop_region("outer");
+        omnitrace_user_pop_region("inner");
+    }
+
+    // the three outermost calls are excluded and the two innermost calls are recorded
+    if(run_ctl("--clear --exclude recurse") != 0) return EXIT_FAILURE;
+    recurse(4, 2);
+
+    printf("[ctl-regions] done\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+
+// synthetic workload for measuring how the finalization of omnitrace scales. Every
+// thread enters the given number of distinct user regions in a round-robin until the
+// given number of iterations are complete. Each region spins for the given number of
+// microseconds so the number of samples is roughly controlled by the duration of the
+// spin and OMNITRACE_SAMPLING_FREQ.
+//
+//  usage: finalize-scaling [--threads N] [--regions N] [--iterations N]
+//                          [--spin-usec N]
+//
+// When built with MPI, every rank runs the same workload.
+
+#include <omnitrace/user.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(USE_MPI)
+#    include <mpi.h>
+#endif
+
+namespace
+{
+struct options
+{
+    size_t threads    = 4;
+    size_t regions    = 100;
+    size_t iterations = 1000;
+    size_t spin_usec  = 10;
+};
+
+std::atomic<uint64_t> total{ 0 };
+
+void
+spin(size_t _usec)
+{
+    auto     _end = std::chrono::steady_clock::now() + std::chrono::microseconds{ _usec };
+    uint64_t _v   = 0;
+    while(std::chrono::steady_clock::now() < _end)
+        _v = (_v << 7) ^ (_v >> 3) ^ (_v + 1);
+    total += _v;
+}
+
+void
+run(const options& _opts, const std::vector<std::string>& _names, size_t _tidx)
+{
+    for(size_t i = 0; i < _opts.iterations; ++i)
+    {
+        const auto& _name = _names.at((_tidx + i) % _names.size());
+        omnitrace_user_push_region(_name.c_str());
+        spin(_opts.spin_usec);
+        omnitrace_user_pop_region(_name.c_str());
+    }
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+#if defined(USE_MPI)
+    MPI_Init(&argc, &argv);
+#endif
+
+    auto _opts = options{};
+    for(int i = 1; i < argc; ++i)
+    {
+        auto _arg = std::string{ argv[i] };
+        if(i + 1 >= argc)
+        {
+            fprintf(stderr, "[finalize-scaling] missing value for %s\n", _arg.c_str());
+            return EXIT_FAILURE;
+        }
+
+        auto _val = std::stoul(argv[++i]);
+        if(_arg == "--threads")
+            _opts.threads = std::max<size_t>(_val, 1);
+        else if(_arg == "--regions")
+            _opts.regions = std::max<size_t>(_val, 1);
+        else if(_arg == "--iterations")
+            _opts.iterations = _val;
+        else if(_arg == "--spin-usec")
+            _opts.spin_usec = _val;
+        else
+        {
+            fprintf(stderr, "[finalize-scaling] unknown argument: %s\n", _arg.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto _names = std::vector<std::string>{};
+    _names.reserve(_opts.regions);
+    for(size_t i = 0; i < _opts.regions; ++i)
+        _names.emplace_back("region_" + std::to_string(i));
+
+    // the main thread is one of the workers
+    auto _threads = std::vector<std::thread>{};
+    for(size_t i = 1; i < _opts.threads; ++i)
+        _threads.emplace_back(run, std::cref(_opts), std::cref(_names), i);
+    run(_opts, _names, 0);
+    for(auto& itr : _threads)
+        itr.join();
+
+    printf("[finalize-scaling] threads=%zu regions=%zu iterations=%zu spin-usec=%zu "
+           "(%lu)\n",
+           _opts.threads, _opts.regions, _opts.iterations, _opts.spin_usec,
+           static_cast<unsigned long>(total.load() % 2));
+
+#if defined(USE_MPI)
+    MPI_Finalize();
+#endif
+    return EXIT_SUCCESS;
+}
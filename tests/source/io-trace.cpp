@@ -0,0 +1,71 @@
+// writes and reads back a file with the POSIX functions wrapped by OMNITRACE_IO_TRACE
+//
+//  usage: io-trace [<iterations>] [<kilobytes>]
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+bool
+write_file(const std::string& _path, const std::vector<char>& _data)
+{
+    int _fd = open(_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    if(_fd < 0) return false;
+
+    // half of the data with write and the other half with writev
+    auto _half = _data.size() / 2;
+    auto _iov  = iovec{ const_cast<char*>(_data.data() + _half), _data.size() - _half };
+    bool _ok   = write(_fd, _data.data(), _half) == static_cast<ssize_t>(_half);
+    _ok        = _ok && writev(_fd, &_iov, 1) == static_cast<ssize_t>(_iov.iov_len);
+    _ok        = _ok && fsync(_fd) == 0;
+    return (close(_fd) == 0) && _ok;
+}
+
+bool
+read_file(const std::string& _path, std::vector<char>& _data)
+{
+    int _fd = open(_path.c_str(), O_RDONLY);
+    if(_fd < 0) return false;
+
+    // the first half with read and the second half with pread
+    auto _half = _data.size() / 2;
+    auto _rest = _data.size() - _half;
+    bool _ok   = read(_fd, _data.data(), _half) == static_cast<ssize_t>(_half);
+    _ok        = _ok && pread(_fd, _data.data() + _half, _rest, _half) ==
+                            static_cast<ssize_t>(_rest);
+    return (close(_fd) == 0) && _ok;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    int    _nitr = (argc > 1) ? atoi(argv[1]) : 10;
+    size_t _nkb  = (argc > 2) ? atol(argv[2]) : 256;
+
+    auto _path = std::string{ "io-trace-" } + std::to_string(getpid()) + ".dat";
+    auto _data = std::vector<char>(_nkb * 1024);
+    auto _copy = std::vector<char>(_data.size());
+    for(size_t i = 0; i < _data.size(); ++i)
+        _data.at(i) = static_cast<char>(i % 127);
+
+    for(int i = 0; i < _nitr; ++i)
+    {
+        if(!write_file(_path, _data) || !read_file(_path, _copy) || _copy != _data)
+        {
+            fprintf(stderr, "[io-trace] I/O on '%s' failed\n", _path.c_str());
+            unlink(_path.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    unlink(_path.c_str());
+    printf("[io-trace] wrote and read %zu KB %i times\n", _nkb, _nitr);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,361 @@
+
+// microbenchmarks of the instrumentation hot paths. The benchmarks call the functions
+// which are exported by libomnitrace-dl so the executable must be launched via
+// omnitrace-run or omnitrace-sample. Benchmarks whose functions are not available are
+// skipped.
+//
+//  usage: omnitrace-bench [--filter REGEX] [--min-time SEC] [--repeat N]
+//                         [--baseline FILE] [--tolerance PCT] [--min-delta NSEC]
+//                         [--record FILE]
+//
+// When a baseline file is provided, the median time per operation of every benchmark
+// is compared against the baseline and the exit code is non-zero if any benchmark is
+// slower than the baseline by more than the tolerance. The baseline file is never
+// written: if it does not exist, the comparison is skipped (and reported as such) and
+// benchmarks missing from the baseline are not compared. A baseline for the current
+// machine is generated with --record.
+
+#include <omnitrace/user.h>
+#include <omnitrace/user_fast.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+    // exported by libomnitrace-dl. Weak so that the executable can be run without it
+    void omnitrace_push_trace(const char*) __attribute__((weak));
+    void omnitrace_pop_trace(const char*) __attribute__((weak));
+    int  omnitrace_push_category_region(omnitrace_category_t, const char*,
+                                        omnitrace_annotation_t*, size_t)
+        __attribute__((weak));
+    int omnitrace_pop_category_region(omnitrace_category_t, const char*,
+                                      omnitrace_annotation_t*, size_t)
+        __attribute__((weak));
+    void omnitrace_register_source(const char*, const char*, size_t, size_t,
+                                   const char*, size_t) __attribute__((weak));
+    void omnitrace_register_coverage(size_t) __attribute__((weak));
+}
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct benchmark
+{
+    std::string                 name      = {};
+    std::function<bool()>       available = {};
+    std::function<void(size_t)> func      = {};  // runs the given number of operations
+};
+
+struct options
+{
+    std::string filter    = ".*";
+    std::string baseline  = {};
+    std::string record    = {};
+    double      min_time  = 0.25;  // sec per repetition
+    size_t      repeat    = 5;
+    double      tolerance = 25.0;  // percent
+    double      min_delta = 2.0;   // nsec
+};
+
+// keeps the compiler from removing the benchmarked work
+volatile uint64_t sink = 0;
+
+double
+run(const benchmark& _bench, const options& _opts)
+{
+    auto _measure = [&_bench](size_t _n) {
+        auto _beg = clock_type::now();
+        _bench.func(_n);
+        return std::chrono::duration<double>(clock_type::now() - _beg).count();
+    };
+
+    // warm-up and calibration of the number of operations per repetition
+    size_t _n = 1;
+    while(true)
+    {
+        auto _elapsed = _measure(_n);
+        if(_elapsed >= 0.1 * _opts.min_time || _n >= (size_t{ 1 } << 30)) break;
+        _n *= 2;
+    }
+    _n = std::max<size_t>(_n * 10, 1);
+
+    auto _samples = std::vector<double>{};
+    for(size_t i = 0; i < _opts.repeat; ++i)
+        _samples.emplace_back(1.0e9 * _measure(_n) / _n);
+
+    std::sort(_samples.begin(), _samples.end());
+    return _samples.at(_samples.size() / 2);
+}
+
+std::map<std::string, double>
+read_baseline(const std::string& _fname)
+{
+    auto _data = std::map<std::string, double>{};
+    auto _ifs  = std::ifstream{ _fname };
+    auto _name = std::string{};
+    auto _val  = 0.0;
+    while(_ifs >> _name >> _val)
+        _data[_name] = _val;
+    return _data;
+}
+
+//--------------------------------------------------------------------------------------//
+//
+//      benchmarks
+//
+//--------------------------------------------------------------------------------------//
+
+void __attribute__((noinline)) spin(size_t _n)
+{
+    uint64_t _v = 0;
+    for(size_t i = 0; i < _n; ++i)
+        _v = (_v << 7) ^ (_v >> 3) ^ i;
+    sink = _v;
+}
+
+// the sampler records the call-stack so the cost of the signal handler grows with the
+// depth of the stack at the time of the sample
+size_t __attribute__((noinline)) recurse(size_t _depth, size_t _n)
+{
+    if(_depth == 0)
+    {
+        spin(_n);
+        return 0;
+    }
+    auto _v = recurse(_depth - 1, _n);
+    sink    = sink + _v;
+    return _v + 1;
+}
+
+std::vector<benchmark>
+get_benchmarks()
+{
+    auto _always = []() { return true; };
+    auto _v      = std::vector<benchmark>{};
+
+    _v.emplace_back(benchmark{ "dl/push_pop_trace",
+                               []() { return omnitrace_push_trace != nullptr; },
+                               [](size_t _n) {
+                                   for(size_t i = 0; i < _n; ++i)
+                                   {
+                                       omnitrace_push_trace("bench_trace");
+                                       omnitrace_pop_trace("bench_trace");
+                                   }
+                               } });
+
+    _v.emplace_back(benchmark{ "user/push_pop_region", _always, [](size_t _n) {
+                                  for(size_t i = 0; i < _n; ++i)
+                                  {
+                                      omnitrace_user_push_region("bench_region");
+                                      omnitrace_user_pop_region("bench_region");
+                                  }
+                              } });
+
+    _v.emplace_back(benchmark{ "user/push_pop_region_handle", _always, [](size_t _n) {
+                                  OMNITRACE_USER_DECLARE_REGION(_region, "bench_handle");
+                                  for(size_t i = 0; i < _n; ++i)
+                                  {
+                                      omnitrace_user_fast_push(&_region);
+                                      omnitrace_user_fast_pop(&_region);
+                                  }
+                              } });
+
+    _v.emplace_back(benchmark{ "user/push_pop_sampled_region", _always, [](size_t _n) {
+                                  for(size_t i = 0; i < _n; ++i)
+                                  {
+                                      omnitrace_user_push_sampled_region("bench_sampled",
+                                                                         100);
+                                      omnitrace_user_pop_sampled_region("bench_sampled");
+                                  }
+                              } });
+
+    _v.emplace_back(benchmark{ "user/push_pop_annotated_region", _always, [](size_t _n) {
+                                  auto                   _value = size_t{ 0 };
+                                  omnitrace_annotation_t _annotation[] = {
+                                      { "value", OMNITRACE_VALUE_SIZE_T, &_value }
+                                  };
+                                  for(size_t i = 0; i < _n; ++i)
+                                  {
+                                      _value = i;
+                                      omnitrace_user_push_annotated_region(
+                                          "bench_annotated", _annotation, 1);
+                                      omnitrace_user_pop_annotated_region(
+                                          "bench_annotated", nullptr, 0);
+                                  }
+                              } });
+
+    // the category_region<CategoryT>::start/stop of the categories which are not
+    // specific to a device or an external library
+    for(auto itr : { std::make_pair(OMNITRACE_CATEGORY_USER, "user"),
+                     std::make_pair(OMNITRACE_CATEGORY_HOST, "host"),
+                     std::make_pair(OMNITRACE_CATEGORY_PTHREAD, "pthread"),
+                     std::make_pair(OMNITRACE_CATEGORY_PYTHON, "python") })
+    {
+        auto _category = itr.first;
+        _v.emplace_back(benchmark{
+            std::string{ "category/" } + itr.second,
+            []() { return omnitrace_push_category_region != nullptr; },
+            [_category](size_t _n) {
+                for(size_t i = 0; i < _n; ++i)
+                {
+                    omnitrace_push_category_region(_category, "bench_category", nullptr,
+                                                   0);
+                    omnitrace_pop_category_region(_category, "bench_category", nullptr,
+                                                  0);
+                }
+            } });
+    }
+
+    // OMNITRACE_USE_CODE_COVERAGE must be enabled for the hits to be recorded
+    _v.emplace_back(
+        benchmark{ "coverage/hit",
+                   []() {
+                       if(!omnitrace_register_source || !omnitrace_register_coverage)
+                           return false;
+                       for(size_t i = 0; i < 16; ++i)
+                           omnitrace_register_source(__FILE__, "bench_coverage", i,
+                                                     0x1000 + i, "bench_coverage", i);
+                       return true;
+                   },
+                   [](size_t _n) {
+                       for(size_t i = 0; i < _n; ++i)
+                           omnitrace_register_coverage(i % 16);
+                   } });
+
+    // the time per unit of work while the sampler interrupts the thread
+    for(size_t _depth : { 1, 16, 64, 256 })
+    {
+        _v.emplace_back(benchmark{ "sampling/depth=" + std::to_string(_depth), _always,
+                                   [_depth](size_t _n) {
+                                       for(size_t i = 0; i < _n; ++i)
+                                           recurse(_depth, 1000);
+                                   } });
+    }
+
+    return _v;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    auto _opts = options{};
+    for(int i = 1; i < argc; ++i)
+    {
+        auto _arg  = std::string{ argv[i] };
+        auto _next = [&]() {
+            if(i + 1 >= argc)
+            {
+                fprintf(stderr, "[omnitrace-bench] missing value for %s\n",
+                        _arg.c_str());
+                exit(EXIT_FAILURE);
+            }
+            return std::string{ argv[++i] };
+        };
+
+        if(_arg == "--filter")
+            _opts.filter = _next();
+        else if(_arg == "--baseline")
+            _opts.baseline = _next();
+        else if(_arg == "--record")
+            _opts.record = _next();
+        else if(_arg == "--min-time")
+            _opts.min_time = std::stod(_next());
+        else if(_arg == "--repeat")
+            _opts.repeat = std::max<size_t>(std::stoul(_next()), 1);
+        else if(_arg == "--tolerance")
+            _opts.tolerance = std::stod(_next());
+        else if(_arg == "--min-delta")
+            _opts.min_delta = std::stod(_next());
+        else
+        {
+            fprintf(stderr, "[omnitrace-bench] unknown argument: %s\n", _arg.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+
+    auto _filter   = std::regex{ _opts.filter };
+    auto _baseline = std::map<std::string, double>{};
+    auto _skipped  = false;
+    if(!_opts.baseline.empty())
+    {
+        _skipped = !std::ifstream{ _opts.baseline }.good();
+        if(!_skipped) _baseline = read_baseline(_opts.baseline);
+    }
+
+    auto _measured = std::map<std::string, double>{};
+    auto _missing  = std::vector<std::string>{};
+    int  _failed   = 0;
+
+    printf("%-40s %14s %14s %10s\n", "benchmark", "ns/op", "baseline", "change");
+    for(const auto& itr : get_benchmarks())
+    {
+        if(!std::regex_search(itr.name, _filter)) continue;
+        if(!itr.available())
+        {
+            printf("%-40s %14s\n", itr.name.c_str(), "skipped");
+            continue;
+        }
+
+        auto _ns  = run(itr, _opts);
+        auto bitr = _baseline.find(itr.name);
+        _measured.emplace(itr.name, _ns);
+        if(bitr == _baseline.end())
+        {
+            printf("%-40s %14.2f %14s %10s\n", itr.name.c_str(), _ns, "-", "-");
+            _missing.emplace_back(itr.name);
+            continue;
+        }
+
+        auto _change = 100.0 * (_ns - bitr->second) / bitr->second;
+        auto _regressed =
+            (_change > _opts.tolerance && (_ns - bitr->second) > _opts.min_delta);
+        printf("%-40s %14.2f %14.2f %9.1f%%%s\n", itr.name.c_str(), _ns, bitr->second,
+               _change, (_regressed) ? "  <-- REGRESSION" : "");
+        if(_regressed) ++_failed;
+    }
+
+    if(!_opts.record.empty())
+    {
+        auto _ofs = std::ofstream{ _opts.record };
+        for(const auto& itr : _measured)
+            _ofs << itr.first << " " << itr.second << "\n";
+        printf("\n[omnitrace-bench] recorded %zu benchmarks in %s\n", _measured.size(),
+               _opts.record.c_str());
+    }
+
+    if(_skipped)
+    {
+        printf("\n[omnitrace-bench] baseline file %s does not exist. Comparison "
+               "skipped\n",
+               _opts.baseline.c_str());
+        return EXIT_SUCCESS;
+    }
+
+    if(!_opts.baseline.empty() && !_missing.empty())
+        printf("\n[omnitrace-bench] %zu benchmarks are not in %s and were not "
+               "compared\n",
+               _missing.size(), _opts.baseline.c_str());
+
+    if(_failed > 0)
+    {
+        fprintf(stderr,
+                "\n[omnitrace-bench] %i benchmarks regressed by more than %.1f%%\n",
+                _failed, _opts.tolerance);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
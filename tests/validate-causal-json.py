@@ -306,6 +306,9 @@ def process_data(data, _data, args):
             _func = exp["selection"]["info"]["dfunc"]
             _sym_addr = exp["selection"]["symbol_address"]
             _selected = ":".join([_file, f"{_line}"]) if _sym_addr == 0 else _func
+            # GPU kernel or HIP API call
+            if exp.get("device_op", ""):
+                _selected = exp["device_op"]
             if not re.search(_selection_filter, _selected):
                 continue
             if _selected not in data:
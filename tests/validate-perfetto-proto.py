@@ -42,6 +42,22 @@ def load_trace(inp, max_tries=5, retry_wait=1, bin_path=None):
     return tp
 
 
+def decompress_trace(inp):
+    """Decompresses a gzip-compressed trace (OMNITRACE_PERFETTO_COMPRESSION=gzip)
+    into a temporary file. Traces combined via MPI-IO are a sequence of gzip members
+    which are all read by the gzip module"""
+
+    import gzip
+    import shutil
+    import tempfile
+
+    with gzip.open(inp, "rb") as ifs:
+        with tempfile.NamedTemporaryFile(suffix=".proto", delete=False) as ofs:
+            shutil.copyfileobj(ifs, ofs)
+            print(f"{inp} decompressed to {ofs.name} ({ofs.tell()} bytes)")
+            return ofs.name
+
+
 def validate_perfetto(data, labels, counts, depths):
     expected = []
     for litr, citr, ditr in zip(labels, counts, depths):
@@ -109,7 +125,11 @@ if __name__ == "__main__":
             "The same number of labels, counts, and depths must be specified"
         )
 
-    tp = load_trace(args.input, bin_path=args.trace_processor_shell)
+    trace_input = args.input
+    if trace_input.endswith(".gz"):
+        trace_input = decompress_trace(trace_input)
+
+    tp = load_trace(trace_input, bin_path=args.trace_processor_shell)
 
     if tp is None:
         raise ValueError(f"trace {args.input} could not be loaded")
@@ -175,6 +195,9 @@ if __name__ == "__main__":
         if key_count != count:
             ret = 1
 
+    if trace_input != args.input:
+        os.remove(trace_input)
+
     if ret == 0:
         print(f"{args.input} validated")
     else: